@@ -0,0 +1,40 @@
+package com.blazingdb.calcite.application;
+
+import org.apache.calcite.sql.SqlAggFunction;
+import org.apache.calcite.sql.SqlFunctionCategory;
+import org.apache.calcite.sql.SqlKind;
+import org.apache.calcite.sql.SqlOperator;
+import org.apache.calcite.sql.SqlOperatorTable;
+import org.apache.calcite.sql.type.OperandTypes;
+import org.apache.calcite.sql.type.ReturnTypes;
+import org.apache.calcite.sql.type.SqlTypeTransforms;
+import org.apache.calcite.sql.util.ListSqlOperatorTable;
+import org.apache.calcite.util.Optionality;
+
+import java.util.Arrays;
+
+/**
+ * The functions that the engine has on top of the ones of Calcite.
+ */
+public final class BlazingSqlOperatorTable {
+	/**
+	 * APPROX_PERCENTILE(value, percentile) is the approximate value at the percentile, between 0 and 1, of the values
+	 * of a group. The percentile must be the same in every row.
+	 */
+	public static final SqlAggFunction APPROX_PERCENTILE = new SqlAggFunction("APPROX_PERCENTILE",
+		null,
+		SqlKind.OTHER_FUNCTION,
+		ReturnTypes.cascade(ReturnTypes.DOUBLE, SqlTypeTransforms.FORCE_NULLABLE),
+		null,
+		OperandTypes.NUMERIC_NUMERIC,
+		SqlFunctionCategory.NUMERIC,
+		false,
+		false,
+		Optionality.FORBIDDEN) {};
+
+	private BlazingSqlOperatorTable() {}
+
+	public static SqlOperatorTable instance() {
+		return new ListSqlOperatorTable(Arrays.<SqlOperator>asList(APPROX_PERCENTILE));
+	}
+}
@@ -0,0 +1,90 @@
+package com.blazingdb.calcite.application;
+
+import org.apache.calcite.rel.RelNode;
+import org.apache.calcite.rel.externalize.RelWriterImpl;
+import org.apache.calcite.sql.SqlExplainLevel;
+import org.apache.calcite.util.Pair;
+
+import java.io.PrintWriter;
+import java.io.StringWriter;
+import java.util.List;
+
+/**
+ * Writes a plan as the tree that the engine reads, a JSON object for every
+ * node with its relational algebra in expr and its inputs in children:
+ *
+ * <pre>{"expr": "LogicalProject(a=[$0])", "children": [{"expr": "...", "children": []}]}</pre>
+ *
+ * <p>The expr of a node is the same line that {@link RelWriterImpl} writes for
+ * it in the plan string, so the plan string is the expr of every node indented
+ * by its depth. The engine gets the inputs of every node as they are in the
+ * plan, instead of the tree being parsed back from the indentation of the
+ * plan string, which has to know how many inputs every kind of node has.
+ */
+public class JsonPlanWriter extends RelWriterImpl {
+	private final StringBuilder json = new StringBuilder();
+
+	public JsonPlanWriter() {
+		super(new PrintWriter(new StringWriter()), SqlExplainLevel.EXPPLAN_ATTRIBUTES, false);
+	}
+
+	@Override
+	protected void explain_(RelNode rel, List<Pair<String, Object>> values) {
+		final StringBuilder expr = new StringBuilder(rel.getRelTypeName());
+		int j = 0;
+		for(Pair<String, Object> value : values) {
+			if(value.right instanceof RelNode) {
+				continue;
+			}
+			expr.append(j++ == 0 ? "(" : ", ").append(value.left).append("=[").append(value.right).append("]");
+		}
+		if(j > 0) {
+			expr.append(")");
+		}
+
+		json.append("{\"expr\": ");
+		appendString(expr.toString());
+		json.append(", \"children\": [");
+		final List<RelNode> inputs = rel.getInputs();
+		for(int i = 0; i < inputs.size(); i++) {
+			if(i > 0) {
+				json.append(", ");
+			}
+			inputs.get(i).explain(this);
+		}
+		json.append("]}");
+	}
+
+	private void appendString(String value) {
+		json.append('"');
+		for(int i = 0; i < value.length(); i++) {
+			final char c = value.charAt(i);
+			switch(c) {
+				case '"': json.append("\\\""); break;
+				case '\\': json.append("\\\\"); break;
+				case '\n': json.append("\\n"); break;
+				case '\r': json.append("\\r"); break;
+				case '\t': json.append("\\t"); break;
+				default:
+					if(c < 0x20) {
+						json.append(String.format("\\u%04x", (int) c));
+					} else {
+						json.append(c);
+					}
+			}
+		}
+		json.append('"');
+	}
+
+	/** The JSON of the plan that was written. */
+	public String asString() {
+		return json.toString();
+	}
+
+	/** The JSON of a plan. */
+	public static String toJsonString(RelNode plan) {
+		final JsonPlanWriter writer = new JsonPlanWriter();
+		plan.explain(writer);
+		return writer.asString();
+	}
+}
@@ -2,8 +2,11 @@ package com.blazingdb.calcite.application;
 
 import com.blazingdb.calcite.rules.FilterTableScanRule;
 import com.blazingdb.calcite.rules.ProjectFilterTransposeRule;
+import com.blazingdb.calcite.rules.ProjectJoinTransposeRule;
 import com.blazingdb.calcite.rules.ProjectTableScanRule;
 import com.blazingdb.calcite.interpreter.BindableTableScan;
+import com.blazingdb.calcite.metadata.BlazingRelMdDistinctRowCount;
+import com.blazingdb.calcite.metadata.BlazingRelMdRowCount;
 import com.blazingdb.calcite.schema.BlazingSchema;
 import com.blazingdb.calcite.schema.BlazingTable;
 
@@ -26,6 +29,12 @@ import org.apache.calcite.plan.hep.HepProgramBuilder;
 import org.apache.calcite.plan.volcano.VolcanoPlanner;
 import org.apache.calcite.prepare.CalciteCatalogReader;
 import org.apache.calcite.rel.RelNode;
+import org.apache.calcite.rel.core.RelFactories;
+import org.apache.calcite.rel.metadata.ChainedRelMetadataProvider;
+import org.apache.calcite.rel.metadata.DefaultRelMetadataProvider;
+import org.apache.calcite.rel.metadata.JaninoRelMetadataProvider;
+import org.apache.calcite.rel.metadata.RelMetadataProvider;
+import org.apache.calcite.rel.metadata.RelMetadataQuery;
 import org.apache.calcite.rel.rules.*;
 import org.apache.calcite.rex.RexExecutorImpl;
 import org.apache.calcite.rel.type.RelDataTypeSystem;
@@ -38,11 +47,14 @@ import org.apache.calcite.sql.fun.SqlLibraryOperatorTableFactory;
 import org.apache.calcite.sql.parser.SqlParseException;
 import org.apache.calcite.sql.parser.SqlParser;
 import org.apache.calcite.sql.util.ChainedSqlOperatorTable;
+import org.apache.calcite.sql2rel.RelFieldTrimmer;
 import org.apache.calcite.tools.*;
 
 import org.slf4j.Logger;
 import org.slf4j.LoggerFactory;
 
+import com.google.common.collect.ImmutableList;
+
 import java.sql.Connection;
 import java.sql.DriverManager;
 
@@ -79,6 +91,9 @@ public class RelationalAlgebraGenerator {
 
 	private List<RelOptRule> rulesCBO;
 
+	private static final RelMetadataProvider METADATA_PROVIDER = ChainedRelMetadataProvider.of(ImmutableList.of(
+		BlazingRelMdRowCount.SOURCE, BlazingRelMdDistinctRowCount.SOURCE, DefaultRelMetadataProvider.INSTANCE));
+
 	/**
 	 * Constructor for the relational algebra generator class. It will take the
 	 * schema store it in the  {@link #config} and then set up the  {@link
@@ -111,6 +126,7 @@ public class RelationalAlgebraGenerator {
 			List<SqlOperatorTable> sqlOperatorTables = new ArrayList<>();
 			sqlOperatorTables.add(SqlLibraryOperatorTableFactory.INSTANCE.getOperatorTable(
 				EnumSet.of(SqlLibrary.STANDARD, SqlLibrary.ORACLE, SqlLibrary.MYSQL)));
+			sqlOperatorTables.add(BlazingSqlOperatorTable.instance());
 			sqlOperatorTables.add(new CalciteCatalogReader(CalciteSchema.from(schema.getSubSchema(newSchema.getName())),
 				defaultSchema,
 				new JavaTypeFactoryImpl(RelDataTypeSystem.DEFAULT),
@@ -176,18 +192,41 @@ public class RelationalAlgebraGenerator {
 		return planner.rel(validatedSqlNode).project();
 	}
 
+	/**
+	 * Drops the columns that no operator above uses, below the joins and the aggregations too, so that the scans
+	 * only read the columns that are needed and the joins don't shuffle the ones that are only carried through
+	 * them. The projections it adds are merged and pushed into the scans by the rules of the optimization.
+	 */
+	private RelNode
+	trimUnusedFields(RelNode plan) {
+		try {
+			final RelBuilder relBuilder = RelFactories.LOGICAL_BUILDER.create(plan.getCluster(), null);
+			return new RelFieldTrimmer(null, relBuilder).trim(plan);
+		} catch(RuntimeException e) {
+			LOGGER.warn("The unused columns of the plan could not be trimmed", e);
+			return plan;
+		}
+	}
+
 	public RelNode
 	getOptimizedRelationalAlgebra(RelNode nonOptimizedPlan) throws RelConversionException {
 		if(rules == null) {
+			nonOptimizedPlan = trimUnusedFields(nonOptimizedPlan);
 			// TODO: this is a temporal workaround due to the issue with ProjectToWindowRule
 			// with constant values like  LEAD($1, 5)
 			if (RelOptUtil.toString(nonOptimizedPlan).indexOf("OVER") != -1) {
 				program = new HepProgramBuilder()
 					      //.addRuleInstance(ProjectToWindowRule.PROJECT)
+						  .addRuleInstance(com.blazingdb.calcite.rules.AggregateCountDistinctRule.INSTANCE)
 						  .addRuleInstance(AggregateExpandDistinctAggregatesRule.JOIN)
 						  .addRuleInstance(FilterAggregateTransposeRule.INSTANCE)
 						  .addRuleInstance(FilterJoinRule.JoinConditionPushRule.FILTER_ON_JOIN)
 						  .addRuleInstance(FilterJoinRule.JoinConditionPushRule.JOIN)
+						  // the filters of the keys of a join are inferred for the other side, so its scan can skip data too
+						  .addRuleInstance(com.blazingdb.calcite.rules.JoinPushTransitivePredicatesRule.INSTANCE)
+						  // IN and EXISTS subqueries become joins with the distinct keys of the subquery, which the engine runs as semi joins
+						  .addRuleInstance(SemiJoinRule.PROJECT)
+						  .addRuleInstance(SemiJoinRule.JOIN)
 						  .addRuleInstance(ProjectMergeRule.INSTANCE)
 						  .addRuleInstance(FilterMergeRule.INSTANCE)
 						  //.addRuleInstance(ProjectJoinTransposeRule.INSTANCE)
@@ -205,10 +244,16 @@ public class RelationalAlgebraGenerator {
 			} else {
 				program = new HepProgramBuilder()
 						  //.addRuleInstance(ProjectToWindowRule.PROJECT)
+						  .addRuleInstance(com.blazingdb.calcite.rules.AggregateCountDistinctRule.INSTANCE)
 						  .addRuleInstance(AggregateExpandDistinctAggregatesRule.JOIN)
 						  .addRuleInstance(FilterAggregateTransposeRule.INSTANCE)
 						  .addRuleInstance(FilterJoinRule.JoinConditionPushRule.FILTER_ON_JOIN)
 						  .addRuleInstance(FilterJoinRule.JoinConditionPushRule.JOIN)
+						  // the filters of the keys of a join are inferred for the other side, so its scan can skip data too
+						  .addRuleInstance(com.blazingdb.calcite.rules.JoinPushTransitivePredicatesRule.INSTANCE)
+						  // IN and EXISTS subqueries become joins with the distinct keys of the subquery, which the engine runs as semi joins
+						  .addRuleInstance(SemiJoinRule.PROJECT)
+						  .addRuleInstance(SemiJoinRule.JOIN)
 						  .addRuleInstance(ProjectMergeRule.INSTANCE)
 						  .addRuleInstance(FilterMergeRule.INSTANCE)
 						  .addRuleInstance(ProjectJoinTransposeRule.INSTANCE)
@@ -247,13 +292,20 @@ public class RelationalAlgebraGenerator {
 		VolcanoPlanner volcanoPlanner = (VolcanoPlanner) rboOptimizedPlan.getCluster().getPlanner();
 		volcanoPlanner.clear();
 
+		// the costs of the join orders come from the row counts and distinct values of the tables
+		RelMetadataQuery.THREAD_PROVIDERS.set(JaninoRelMetadataProvider.of(METADATA_PROVIDER));
+		rboOptimizedPlan.getCluster().setMetadataProvider(METADATA_PROVIDER);
+		rboOptimizedPlan.getCluster().invalidateMetadataQuery();
+
 		if(rules == null){
+			rboOptimizedPlan = trimUnusedFields(rboOptimizedPlan);
 			if (RelOptUtil.toString(rboOptimizedPlan).indexOf("OVER") != -1) {
 				//RBO Rules
 				volcanoPlanner.addRule(AggregateExpandDistinctAggregatesRule.JOIN);
 				volcanoPlanner.addRule(FilterAggregateTransposeRule.INSTANCE);
 				volcanoPlanner.addRule(FilterJoinRule.JoinConditionPushRule.FILTER_ON_JOIN);
 				volcanoPlanner.addRule(FilterJoinRule.JoinConditionPushRule.JOIN);
+				volcanoPlanner.addRule(com.blazingdb.calcite.rules.JoinPushTransitivePredicatesRule.INSTANCE);
 				volcanoPlanner.addRule(ProjectMergeRule.INSTANCE);
 				volcanoPlanner.addRule(FilterMergeRule.INSTANCE);
 				//RBO BSQL Custom Rules
@@ -270,6 +322,7 @@ public class RelationalAlgebraGenerator {
 				volcanoPlanner.addRule(FilterAggregateTransposeRule.INSTANCE);
 				volcanoPlanner.addRule(FilterJoinRule.JoinConditionPushRule.FILTER_ON_JOIN);
 				volcanoPlanner.addRule(FilterJoinRule.JoinConditionPushRule.JOIN);
+				volcanoPlanner.addRule(com.blazingdb.calcite.rules.JoinPushTransitivePredicatesRule.INSTANCE);
 				volcanoPlanner.addRule(ProjectMergeRule.INSTANCE);
 				volcanoPlanner.addRule(FilterMergeRule.INSTANCE);
 				//RBO BSQL Custom Rules
@@ -389,6 +442,35 @@ public class RelationalAlgebraGenerator {
 		return response;
 	}
 
+	/**
+	 * Takes a sql statement and returns its optimized plan as the tree that the engine reads, written by
+	 * {@link JsonPlanWriter}, instead of the plan string that has to be parsed back into the tree.
+	 *
+	 * @param sql a string sql query
+	 * @param cbo whether the plan comes from the cost based optimizer, as in getRelationalAlgebraCBOString
+	 * @return the JSON of the plan, or the message of the error like the plan strings, which does not start with '{'
+	 * @throws SqlSyntaxException, SqlValidationException, RelConversionException
+	 */
+	public String
+	getRelationalAlgebraJsonString(String sql, boolean cbo)
+		throws SqlSyntaxException, SqlValidationException, RelConversionException {
+		try {
+			if(cbo) {
+				return JsonPlanWriter.toJsonString(getRelationalAlgebraCBO(sql))
+					.replaceAll("Bindable", "Logical")
+					.replaceAll("LogicalTableScan", "BindableTableScan");
+			}
+			return JsonPlanWriter.toJsonString(getRelationalAlgebra(sql));
+		} catch(SqlValidationException | SqlSyntaxException ex) {
+			throw ex;
+		} catch(Exception ex) {
+			ex.printStackTrace();
+
+			LOGGER.error(ex.getMessage());
+			return (cbo ? "cbo" : "rbo") + " fail: \n " + ex.getMessage();
+		}
+	}
+
 	public String
 	getRelationalAlgebraCBOString(String sql) throws SqlSyntaxException, SqlValidationException, RelConversionException {
 		String response = "";
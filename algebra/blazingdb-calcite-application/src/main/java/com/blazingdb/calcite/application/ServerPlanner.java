@@ -0,0 +1,63 @@
+package com.blazingdb.calcite.application;
+
+import com.blazingdb.calcite.catalog.domain.CatalogColumnDataType;
+import com.blazingdb.calcite.catalog.domain.CatalogColumnImpl;
+import com.blazingdb.calcite.catalog.domain.CatalogDatabaseImpl;
+import com.blazingdb.calcite.catalog.domain.CatalogTableImpl;
+import com.blazingdb.calcite.schema.BlazingSchema;
+
+import java.util.ArrayList;
+import java.util.List;
+
+/**
+ * <h1>Plans the queries of the blazingsql-server.</h1>
+ * The server embeds a single JVM and calls this class through JNI, so it only takes and returns strings and
+ * arrays of primitives. It does what the BlazingContext of pyblazing does with its generator: it keeps the tables
+ * in the "main" database and rebuilds the {@link RelationalAlgebraGenerator} when they change.
+ *
+ * The methods are synchronized since the server plans the queries of its clients from several threads.
+ */
+public class ServerPlanner {
+	private CatalogDatabaseImpl db;
+	private RelationalAlgebraGenerator generator;
+
+	public ServerPlanner() {
+		db = new CatalogDatabaseImpl("main");
+		generator = new RelationalAlgebraGenerator(new BlazingSchema(db));
+	}
+
+	/**
+	 * Adds a table, or replaces the table with the same name.
+	 *
+	 * @param name the name of the table
+	 * @param columnNames the names of its columns, in order
+	 * @param typeIds the cudf type_id of every column
+	 * @param rowCount the number of rows of the table, for the cost based optimizer
+	 */
+	public synchronized void
+	addTable(String name, String[] columnNames, int[] typeIds, int rowCount) {
+		db.removeTable(name);
+		List<CatalogColumnImpl> columns = new ArrayList<CatalogColumnImpl>();
+		for(int order = 0; order < columnNames.length; order++) {
+			columns.add(new CatalogColumnImpl(columnNames[order], CatalogColumnDataType.fromTypeId(typeIds[order]), order));
+		}
+		db.addTable(new CatalogTableImpl(name, db, columns, rowCount));
+		generator = new RelationalAlgebraGenerator(new BlazingSchema(db));
+	}
+
+	public synchronized void
+	removeTable(String name) {
+		db.removeTable(name);
+		generator = new RelationalAlgebraGenerator(new BlazingSchema(db));
+	}
+
+	/**
+	 * @param sql a string sql query
+	 * @return the JSON of its plan, see {@link RelationalAlgebraGenerator#getRelationalAlgebraJsonString}
+	 * @throws SqlSyntaxException, SqlValidationException, RelConversionException
+	 */
+	public synchronized String
+	getPlan(String sql) throws Exception {
+		return generator.getRelationalAlgebraJsonString(sql, false);
+	}
+}
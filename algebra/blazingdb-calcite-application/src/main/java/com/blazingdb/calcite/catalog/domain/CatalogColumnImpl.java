@@ -16,6 +16,7 @@ import javax.persistence.ManyToMany;
 import javax.persistence.ManyToOne;
 import javax.persistence.OneToOne;
 import javax.persistence.Table;
+import javax.persistence.Transient;
 
 /**
  * <h1>Representaion of a column in a table</h1> A {@link CatalogTableImpl} contains several columns. The point of this
@@ -72,6 +73,14 @@ public class CatalogColumnImpl implements CatalogColumn, Comparable {
 	 */
 	@ManyToOne(fetch = FetchType.EAGER) @JoinColumn(name = "table_id") private CatalogTableImpl table;
 
+	/**
+	 * The statistics of the column, taken from the metadata of the files of the table when it is created. They are not
+	 * persisted, as the tables are registered again in every session.
+	 */
+	@Transient private Double distinctCount;
+
+	@Transient private Double nullCount;
+
 	public Long
 	getId() {
 		return id;
@@ -120,6 +129,28 @@ public class CatalogColumnImpl implements CatalogColumn, Comparable {
 		this.dataType = CatalogColumnDataType.fromString(type);
 	}
 
+	@Override
+	public Double
+	getDistinctCount() {
+		return distinctCount;
+	}
+
+	public void
+	setDistinctCount(Double distinctCount) {
+		this.distinctCount = distinctCount;
+	}
+
+	@Override
+	public Double
+	getNullCount() {
+		return nullCount;
+	}
+
+	public void
+	setNullCount(Double nullCount) {
+		this.nullCount = nullCount;
+	}
+
 	public int
 	getOrderValue() {
 		return orderValue;
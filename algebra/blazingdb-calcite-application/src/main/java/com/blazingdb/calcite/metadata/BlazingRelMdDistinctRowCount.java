@@ -0,0 +1,58 @@
+package com.blazingdb.calcite.metadata;
+
+import com.blazingdb.calcite.interpreter.BindableTableScan;
+import com.blazingdb.calcite.schema.BlazingStatistic;
+import com.blazingdb.calcite.schema.BlazingTable;
+
+import org.apache.calcite.rel.RelNode;
+import org.apache.calcite.rel.core.TableScan;
+import org.apache.calcite.rel.metadata.ReflectiveRelMetadataProvider;
+import org.apache.calcite.rel.metadata.RelMdDistinctRowCount;
+import org.apache.calcite.rel.metadata.RelMdUtil;
+import org.apache.calcite.rel.metadata.RelMetadataProvider;
+import org.apache.calcite.rel.metadata.RelMetadataQuery;
+import org.apache.calcite.rex.RexNode;
+import org.apache.calcite.schema.Statistic;
+import org.apache.calcite.util.BuiltInMethod;
+import org.apache.calcite.util.ImmutableBitSet;
+
+/**
+ * Estimates the number of distinct values of the columns of the table scans from the statistics of the tables, which
+ * come from the metadata of their files. The other relational expressions keep the estimates of Calcite, which build on
+ * the ones of their inputs.
+ */
+public class BlazingRelMdDistinctRowCount extends RelMdDistinctRowCount {
+	public static final RelMetadataProvider SOURCE =
+		ReflectiveRelMetadataProvider.reflectiveSource(BuiltInMethod.DISTINCT_ROW_COUNT.method, new BlazingRelMdDistinctRowCount());
+
+	protected BlazingRelMdDistinctRowCount() {}
+
+	public Double
+	getDistinctRowCount(TableScan rel, RelMetadataQuery mq, ImmutableBitSet groupKey, RexNode predicate) {
+		BlazingTable table = rel.getTable().unwrap(BlazingTable.class);
+		Statistic statistic = table == null ? null : table.getStatistic();
+		if(!(statistic instanceof BlazingStatistic) || groupKey.isEmpty()) {
+			return super.getDistinctRowCount((RelNode) rel, mq, groupKey, predicate);
+		}
+		BlazingStatistic blazingStatistic = (BlazingStatistic) statistic;
+
+		// the distinct values of several columns are at most the product of the distinct values of each one
+		double distinctCount = 1d;
+		for(int field : groupKey) {
+			int column = rel instanceof BindableTableScan ? ((BindableTableScan) rel).projects.get(field) : field;
+			Double columnDistinctCount = blazingStatistic.getDistinctCount(column);
+			if(columnDistinctCount == null) {
+				return super.getDistinctRowCount((RelNode) rel, mq, groupKey, predicate);
+			}
+			distinctCount *= Math.max(columnDistinctCount, 1d);
+		}
+		distinctCount = Math.min(distinctCount, blazingStatistic.getRowCount());
+
+		// the filters pushed to the scan and the predicate keep only some of the rows, and so some of the values
+		double rowCount = mq.getRowCount(rel);
+		if(predicate != null) {
+			rowCount *= RelMdUtil.guessSelectivity(predicate);
+		}
+		return RelMdUtil.numDistinctVals(distinctCount, rowCount);
+	}
+}
@@ -0,0 +1,92 @@
+package com.blazingdb.calcite.rules;
+
+import org.apache.calcite.plan.RelOptRule;
+import org.apache.calcite.plan.RelOptRuleCall;
+import org.apache.calcite.rel.core.Aggregate;
+import org.apache.calcite.rel.core.AggregateCall;
+import org.apache.calcite.rel.core.RelFactories;
+import org.apache.calcite.rel.logical.LogicalAggregate;
+import org.apache.calcite.sql.SqlAggFunction;
+import org.apache.calcite.sql.SqlFunctionCategory;
+import org.apache.calcite.sql.SqlKind;
+import org.apache.calcite.sql.type.OperandTypes;
+import org.apache.calcite.sql.type.ReturnTypes;
+import org.apache.calcite.tools.RelBuilderFactory;
+import org.apache.calcite.util.Optionality;
+
+import java.util.ArrayList;
+import java.util.List;
+
+/**
+ * Planner rule that makes the distinct counts of one column of an
+ * {@link org.apache.calcite.rel.core.Aggregate} into calls to
+ * {@link #COUNT_DISTINCT}, or to {@link #APPROX_COUNT_DISTINCT} when they are
+ * approximate.
+ *
+ * <p>AggregateExpandDistinctAggregatesRule would expand them into a group by of
+ * the column and a count of its groups, which the engine would distribute twice.
+ * The engine computes them natively instead, keeping the distinct values of
+ * every group in its partial aggregations, so this rule has to run before that
+ * one. Calcite converts APPROX_COUNT_DISTINCT(x) into
+ * COUNT(APPROXIMATE DISTINCT x), which the engine computes with a sketch of
+ * every group.
+ */
+public class AggregateCountDistinctRule extends RelOptRule {
+	/** The exact distinct count that the engine computes natively. */
+	public static final SqlAggFunction COUNT_DISTINCT = makeCountFunction("COUNT_DISTINCT");
+
+	/** The distinct count that the engine computes with a sketch. */
+	public static final SqlAggFunction APPROX_COUNT_DISTINCT = makeCountFunction("APPROX_COUNT_DISTINCT");
+
+	public static final AggregateCountDistinctRule INSTANCE =
+		new AggregateCountDistinctRule(LogicalAggregate.class, RelFactories.LOGICAL_BUILDER);
+
+	public AggregateCountDistinctRule(Class<? extends Aggregate> clazz, RelBuilderFactory relBuilderFactory) {
+		super(operand(clazz, any()), relBuilderFactory, null);
+	}
+
+	private static SqlAggFunction makeCountFunction(String name) {
+		return new SqlAggFunction(name,
+			null,
+			SqlKind.OTHER_FUNCTION,
+			ReturnTypes.BIGINT,
+			null,
+			OperandTypes.ANY,
+			SqlFunctionCategory.NUMERIC,
+			false,
+			false,
+			Optionality.FORBIDDEN) {};
+	}
+
+	private static boolean isCountDistinct(AggregateCall aggCall) {
+		return aggCall.getAggregation().getKind() == SqlKind.COUNT && aggCall.isDistinct() && aggCall.getArgList().size() == 1;
+	}
+
+	@Override
+	public boolean matches(RelOptRuleCall call) {
+		final Aggregate aggregate = call.rel(0);
+		return aggregate.getAggCallList().stream().anyMatch(AggregateCountDistinctRule::isCountDistinct);
+	}
+
+	@Override
+	public void onMatch(RelOptRuleCall call) {
+		final Aggregate aggregate = call.rel(0);
+		final List<AggregateCall> newAggCalls = new ArrayList<>();
+		for(AggregateCall aggCall : aggregate.getAggCallList()) {
+			if(isCountDistinct(aggCall)) {
+				newAggCalls.add(AggregateCall.create(aggCall.isApproximate() ? APPROX_COUNT_DISTINCT : COUNT_DISTINCT,
+					false,
+					false,
+					aggCall.getArgList(),
+					aggCall.filterArg,
+					aggCall.getCollation(),
+					aggCall.getType(),
+					aggCall.getName()));
+			} else {
+				newAggCalls.add(aggCall);
+			}
+		}
+		call.transformTo(aggregate.copy(
+			aggregate.getTraitSet(), aggregate.getInput(), aggregate.getGroupSet(), aggregate.getGroupSets(), newAggCalls));
+	}
+}
@@ -0,0 +1,107 @@
+package com.blazingdb.calcite.rules;
+
+import org.apache.calcite.plan.RelOptPredicateList;
+import org.apache.calcite.plan.RelOptRule;
+import org.apache.calcite.plan.RelOptRuleCall;
+import org.apache.calcite.rel.RelNode;
+import org.apache.calcite.rel.core.Join;
+import org.apache.calcite.rel.core.RelFactories;
+import org.apache.calcite.rel.logical.LogicalJoin;
+import org.apache.calcite.rel.metadata.RelMetadataQuery;
+import org.apache.calcite.rex.RexCall;
+import org.apache.calcite.rex.RexInputRef;
+import org.apache.calcite.rex.RexLiteral;
+import org.apache.calcite.rex.RexNode;
+import org.apache.calcite.sql.SqlKind;
+import org.apache.calcite.tools.RelBuilder;
+import org.apache.calcite.tools.RelBuilderFactory;
+
+import java.util.ArrayList;
+import java.util.EnumSet;
+import java.util.List;
+import java.util.Set;
+
+/**
+ * Planner rule that infers the predicates of the inputs of a
+ * {@link org.apache.calcite.rel.core.Join} from the predicates of the other
+ * input, through the equalities of its keys, and puts them in a filter over the
+ * inputs. With {@code a JOIN b ON a.k = b.k WHERE a.k BETWEEN 10 AND 20}, the
+ * scan of {@code b} gets {@code b.k BETWEEN 10 AND 20} too.
+ *
+ * <p>Unlike {@link org.apache.calcite.rel.rules.JoinPushTransitivePredicatesRule},
+ * only the predicates that compare a column with literals are inferred, which
+ * are the ones the scans can skip the row groups and the stripes of the files
+ * with once {@link FilterTableScanRule} puts them in the scans. The other ones
+ * would only add the work of a filter. The rule has to run before the rules
+ * that push the filters and the projections into the scans.
+ */
+public class JoinPushTransitivePredicatesRule extends RelOptRule {
+	public static final JoinPushTransitivePredicatesRule INSTANCE =
+		new JoinPushTransitivePredicatesRule(LogicalJoin.class, RelFactories.LOGICAL_BUILDER);
+
+	private static final Set<SqlKind> COMPARISONS = EnumSet.of(SqlKind.EQUALS,
+		SqlKind.NOT_EQUALS,
+		SqlKind.LESS_THAN,
+		SqlKind.LESS_THAN_OR_EQUAL,
+		SqlKind.GREATER_THAN,
+		SqlKind.GREATER_THAN_OR_EQUAL);
+
+	public JoinPushTransitivePredicatesRule(Class<? extends Join> clazz, RelBuilderFactory relBuilderFactory) {
+		super(operand(clazz, any()), relBuilderFactory, null);
+	}
+
+	// a comparison of a column with a literal, or an OR of them, like the ones an IN list is made of
+	private static boolean isColumnRange(RexNode predicate) {
+		if(predicate.getKind() == SqlKind.OR) {
+			return ((RexCall) predicate).getOperands().stream().allMatch(JoinPushTransitivePredicatesRule::isColumnRange);
+		}
+		if(!COMPARISONS.contains(predicate.getKind())) {
+			return false;
+		}
+		final List<RexNode> operands = ((RexCall) predicate).getOperands();
+		return operands.size() == 2 &&
+			((operands.get(0) instanceof RexInputRef && operands.get(1) instanceof RexLiteral) ||
+				(operands.get(0) instanceof RexLiteral && operands.get(1) instanceof RexInputRef));
+	}
+
+	private static List<RexNode> getColumnRanges(List<RexNode> predicates) {
+		final List<RexNode> ranges = new ArrayList<>();
+		for(RexNode predicate : predicates) {
+			if(isColumnRange(predicate)) {
+				ranges.add(predicate);
+			}
+		}
+		return ranges;
+	}
+
+	private static RelNode filter(RelOptRuleCall call, RelBuilder relBuilder, RelNode input, List<RexNode> predicates) {
+		if(predicates.isEmpty()) {
+			return input;
+		}
+		final RelNode filtered = relBuilder.push(input).filter(predicates).build();
+		call.getPlanner().onCopy(input, filtered);
+		return filtered;
+	}
+
+	@Override
+	public void onMatch(RelOptRuleCall call) {
+		final Join join = call.rel(0);
+		final RelMetadataQuery mq = call.getMetadataQuery();
+		// the inferred predicates are only the ones that the input does not have already, so the rule stops once
+		// they are pushed
+		final RelOptPredicateList predicates = mq.getPulledUpPredicates(join);
+		final List<RexNode> leftRanges = getColumnRanges(predicates.leftInferredPredicates);
+		final List<RexNode> rightRanges = getColumnRanges(predicates.rightInferredPredicates);
+		if(leftRanges.isEmpty() && rightRanges.isEmpty()) {
+			return;
+		}
+
+		final RelBuilder relBuilder = call.builder();
+		final RelNode left = filter(call, relBuilder, join.getLeft(), leftRanges);
+		final RelNode right = filter(call, relBuilder, join.getRight(), rightRanges);
+		final RelNode newJoin =
+			join.copy(join.getTraitSet(), join.getCondition(), left, right, join.getJoinType(), join.isSemiJoinDone());
+		call.getPlanner().onCopy(join, newJoin);
+		call.transformTo(newJoin);
+	}
+}
@@ -9,4 +9,16 @@ public interface CatalogColumn {
 
 	public CatalogTable
 	getTable();
+
+	/**
+	 * The number of distinct values of the column, estimated from the metadata of its files, or null if it is unknown.
+	 */
+	public Double
+	getDistinctCount();
+
+	/**
+	 * The number of nulls of the column, or null if it is unknown.
+	 */
+	public Double
+	getNullCount();
 }
@@ -43,8 +43,11 @@ public enum CatalogColumnDataType {
 	DICTIONARY32(22, "DICTIONARY32"), ///< Dictionary type using int32 indices
 	STRING(23, "STRING"), ///< String elements
 	LIST(24, "LIST"), ///< List elements
+	DECIMAL32(25, "DECIMAL32"), ///< Fixed-point type with int32_t
+	DECIMAL64(26, "DECIMAL64"), ///< Fixed-point type with int64_t
+	STRUCT(27, "STRUCT"), ///< Struct elements
 	// `NUM_TYPE_IDS` must be last!
-	NUM_TYPE_IDS(25, "NUM_TYPE_IDS");  ///< Total number of type ids
+	NUM_TYPE_IDS(28, "NUM_TYPE_IDS");  ///< Total number of type ids
 
 	private final int type_id;
 	private final String type_id_name;
@@ -99,6 +102,9 @@ public enum CatalogColumnDataType {
 			case "DICTIONARY32": return DICTIONARY32;
 			case "STRING": return STRING;
 			case "LIST": return LIST;
+			case "DECIMAL32": return DECIMAL32;
+			case "DECIMAL64": return DECIMAL64;
+			case "STRUCT": return STRUCT;
 			case "NUM_TYPE_IDS": return NUM_TYPE_IDS;
 		}
 		return dataType;
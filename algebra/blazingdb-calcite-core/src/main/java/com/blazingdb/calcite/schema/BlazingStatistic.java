@@ -8,13 +8,21 @@ import org.apache.calcite.rel.RelReferentialConstraint;
 import org.apache.calcite.schema.Statistic;
 import org.apache.calcite.util.ImmutableBitSet;
 
+import java.util.ArrayList;
 import java.util.List;
 
 public class BlazingStatistic implements Statistic {
     private final Double rowCount;
+    // by column, null for the columns whose number of distinct values is unknown
+    private final List<Double> distinctCounts;
 
     public BlazingStatistic(Double rowCount) {
+        this(rowCount, ImmutableList.of());
+    }
+
+    public BlazingStatistic(Double rowCount, List<Double> distinctCounts) {
         this.rowCount = rowCount;
+        this.distinctCounts = distinctCounts;
     }
 
     @Override
@@ -22,14 +30,36 @@ public class BlazingStatistic implements Statistic {
         return (double) rowCount;
     }
 
+    /**
+     * @return the number of distinct values of the column, or null if it is unknown
+     */
+    public Double getDistinctCount(int column) {
+        return column < distinctCounts.size() ? distinctCounts.get(column) : null;
+    }
+
+    /**
+     * The columns are a key when one of them has as many distinct values as the table has rows, which lets the planner
+     * know that a join with them does not multiply the rows of the other side.
+     */
     @Override
     public boolean isKey(ImmutableBitSet columns) {
+        for (int column : columns) {
+            if (isUniqueColumn(column)) {
+                return true;
+            }
+        }
         return false;
     }
 
     @Override
     public List<ImmutableBitSet> getKeys() {
-        return ImmutableList.of();
+        List<ImmutableBitSet> keys = new ArrayList<>();
+        for (int column = 0; column < distinctCounts.size(); column++) {
+            if (isUniqueColumn(column)) {
+                keys.add(ImmutableBitSet.of(column));
+            }
+        }
+        return keys;
     }
 
     @Override
@@ -46,4 +76,9 @@ public class BlazingStatistic implements Statistic {
     public RelDistribution getDistribution() {
         return RelDistributionTraitDef.INSTANCE.getDefault();
     }
+
+    private boolean isUniqueColumn(int column) {
+        Double distinctCount = getDistinctCount(column);
+        return distinctCount != null && rowCount != null && rowCount > 0 && distinctCount >= rowCount;
+    }
 }
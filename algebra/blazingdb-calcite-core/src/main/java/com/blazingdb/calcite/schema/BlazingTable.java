@@ -33,6 +33,7 @@ import org.apache.calcite.util.ConversionUtil;
 import org.slf4j.Logger;
 import org.slf4j.LoggerFactory;
 
+import java.util.ArrayList;
 import java.util.Collection;
 import java.util.HashSet;
 import java.util.List;
@@ -74,7 +75,11 @@ public class BlazingTable implements ProjectableFilterableTable {
 	public Statistic
 	getStatistic() {
 //		return Statistics.UNKNOWN;
-		return new BlazingStatistic(catalogTable.getRowCount());
+		List<Double> distinctCounts = new ArrayList<>();
+		for(CatalogColumn column : catalogTable.getColumns()) {
+			distinctCounts.add(column.getDistinctCount());
+		}
+		return new BlazingStatistic(catalogTable.getRowCount(), distinctCounts);
 	}
 
 	@Override
@@ -125,6 +130,11 @@ public class BlazingTable implements ProjectableFilterableTable {
 			case STRING:
 				temp = typeFactory.createSqlType(SqlTypeName.VARCHAR);
 				break;
+			// the nested columns are carried as they are, they can be projected but not computed on
+			case LIST:
+			case STRUCT:
+				temp = typeFactory.createSqlType(SqlTypeName.ANY);
+				break;
 //			case STRING_CATEGORY:
 //				temp = typeFactory.createSqlType(SqlTypeName.VARCHAR);
 //				break;
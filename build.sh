@@ -18,7 +18,7 @@ ARGS=$*
 # script, and that this script resides in the repo dir!
 REPODIR=$(cd $(dirname $0); pwd)
 
-VALIDARGS="clean update thirdparty io libengine engine pyblazing algebra disable-aws-s3 disable-google-gs disable-mysql disable-sqlite disable-postgresql -t -v -g -n -h"
+VALIDARGS="clean update thirdparty io libengine engine pyblazing algebra disable-aws-s3 disable-google-gs disable-mysql disable-sqlite disable-postgresql disable-arrow-flight benchmarks -t -v -g -n -h"
 HELP="$0 [-v] [-g] [-n] [-h] [-t]
    clean                - remove all existing build artifacts and configuration (start
                           over) Use 'clean thirdparty' to delete thirdparty folder
@@ -34,6 +34,8 @@ HELP="$0 [-v] [-g] [-n] [-h] [-t]
    disable-mysql        - flag to enable MySQL support for libengine
    disable-sqlite       - flag to enable SQLite support for libengine
    disable-postgresql   - flag to enable PostgreSQL support for libengine
+   disable-arrow-flight - flag to disable Arrow Flight support for libengine
+   benchmarks           - flag to build the blazingsql-benchmarks target of libengine
    -t                   - skip tests
    -v                   - verbose build mode
    -g                   - build for debug
@@ -56,6 +58,7 @@ QUIET="--quiet"
 BUILD_TYPE=RelWithDebInfo
 INSTALL_TARGET=install
 TESTS="ON"
+BENCHMARKS="OFF"
 
 # Set defaults for vars that may not have been defined externally
 #  FIXME: if INSTALL_PREFIX is not set, check PREFIX, then check
@@ -110,6 +113,9 @@ fi
 if hasArg -t; then
     TESTS="OFF"
 fi
+if hasArg benchmarks; then
+    BENCHMARKS="ON"
+fi
 
 # If clean given, run it prior to any other steps
 if hasArg clean; then
@@ -232,12 +238,19 @@ if buildAll || hasArg libengine; then
         echo "PostgreSQL database support disabled for engine"
     fi
 
+    disable_arrow_flight_flag=""
+    if hasArg disable-arrow-flight; then
+        disable_arrow_flight_flag="-DARROW_FLIGHT_SUPPORT=OFF"
+        echo "Arrow Flight support disabled for engine"
+    fi
+
     echo "Building libengine"
     mkdir -p ${LIBENGINE_BUILD_DIR}
     cd ${LIBENGINE_BUILD_DIR}
     echo "cmake -DCMAKE_INSTALL_PREFIX=${INSTALL_PREFIX} -DBUILD_TESTING=${TESTS} -DCMAKE_BUILD_TYPE=${BUILD_TYPE} -DCMAKE_EXE_LINKER_FLAGS=$CXXFLAGS .."
     cmake -DCMAKE_INSTALL_PREFIX=${INSTALL_PREFIX} \
           -DBUILD_TESTING=${TESTS} \
+          -DBUILD_BENCHMARKS=${BENCHMARKS} \
           -DCMAKE_BUILD_TYPE=${BUILD_TYPE} \
           -DCMAKE_EXE_LINKER_FLAGS="$CXXFLAGS" \
           -DCMAKE_EXPORT_COMPILE_COMMANDS=ON \
@@ -245,7 +258,8 @@ if buildAll || hasArg libengine; then
           $disabled_google_gs_flag \
           $disable_mysql_flag \
           $disable_sqlite_flag \
-          $disable_postgresql_flag ..
+          $disable_postgresql_flag \
+          $disable_arrow_flight_flag ..
 
     echo "Building libengine: make step"
     if [[ ${TESTS} == "ON" ]]; then
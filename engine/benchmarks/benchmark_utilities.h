@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <cudf/io/parquet.hpp>
+#include <cudf_test/column_wrapper.hpp>
+
+#include "execution_graph/Context.h"
+#include "execution_kernels/LogicPrimitives.h"
+
+namespace ral {
+namespace benchmarks {
+
+using Context = blazingdb::manager::Context;
+
+/**
+* Creates a table of int64 columns named c0, c1, ... with values uniformly distributed in [0, cardinality).
+* The same seed always generates the same table, so that runs of different releases are comparable.
+*/
+inline std::unique_ptr<ral::frame::BlazingTable> make_random_table(cudf::size_type num_rows, int num_columns, int64_t cardinality, unsigned seed = 42) {
+	std::mt19937_64 generator(seed);
+	std::uniform_int_distribution<int64_t> distribution(0, cardinality - 1);
+
+	std::vector<std::unique_ptr<cudf::column>> columns;
+	std::vector<std::string> names;
+	for (int i = 0; i < num_columns; i++) {
+		std::vector<int64_t> values(num_rows);
+		for (auto & value : values) {
+			value = distribution(generator);
+		}
+		cudf::test::fixed_width_column_wrapper<int64_t> column(values.begin(), values.end());
+		columns.push_back(column.release());
+		names.push_back("c" + std::to_string(i));
+	}
+	return std::make_unique<ral::frame::BlazingTable>(std::make_unique<CudfTable>(std::move(columns)), names);
+}
+
+/**
+* Creates a table with an int64 column, a float64 column and a string column of up to max_string_length characters.
+*/
+inline std::unique_ptr<ral::frame::BlazingTable> make_mixed_table(cudf::size_type num_rows, int max_string_length = 16, unsigned seed = 42) {
+	std::mt19937_64 generator(seed);
+	std::uniform_int_distribution<int64_t> int_distribution(0, num_rows);
+	std::uniform_real_distribution<double> double_distribution(0, 1000);
+	std::uniform_int_distribution<int> length_distribution(0, max_string_length);
+
+	std::vector<int64_t> ints(num_rows);
+	std::vector<double> doubles(num_rows);
+	std::vector<std::string> strings(num_rows);
+	for (cudf::size_type i = 0; i < num_rows; i++) {
+		ints[i] = int_distribution(generator);
+		doubles[i] = double_distribution(generator);
+		strings[i] = std::string(length_distribution(generator), 'a' + (i % 26));
+	}
+
+	std::vector<std::unique_ptr<cudf::column>> columns;
+	columns.push_back(cudf::test::fixed_width_column_wrapper<int64_t>(ints.begin(), ints.end()).release());
+	columns.push_back(cudf::test::fixed_width_column_wrapper<double>(doubles.begin(), doubles.end()).release());
+	columns.push_back(cudf::test::strings_column_wrapper(strings.begin(), strings.end()).release());
+	return std::make_unique<ral::frame::BlazingTable>(std::make_unique<CudfTable>(std::move(columns)), std::vector<std::string>{"i", "d", "s"});
+}
+
+/**
+* Reads the columns of a TPC-H table from <BLAZINGSQL_BENCHMARK_TPCH_DIR>/<table_name>.parquet.
+* @return nullptr if BLAZINGSQL_BENCHMARK_TPCH_DIR is not set, so the caller can skip the benchmark.
+*/
+inline std::unique_ptr<ral::frame::BlazingTable> read_tpch_table(const std::string & table_name, const std::vector<std::string> & column_names) {
+	const char * tpch_dir = std::getenv("BLAZINGSQL_BENCHMARK_TPCH_DIR");
+	if (tpch_dir == nullptr) {
+		return nullptr;
+	}
+	cudf::io::parquet_reader_options options = cudf::io::parquet_reader_options::builder(
+		cudf::io::source_info{std::string(tpch_dir) + "/" + table_name + ".parquet"}).columns(column_names);
+	auto result = cudf::io::read_parquet(options);
+	return std::make_unique<ral::frame::BlazingTable>(std::move(result.tbl), column_names);
+}
+
+/**
+* Creates a Context for a single node query with no config options.
+*/
+inline std::shared_ptr<Context> make_context() {
+	std::vector<blazingdb::transport::Node> nodes;
+	blazingdb::transport::Node master_node;
+	std::string logicalPlan;
+	std::map<std::string, std::string> config_options;
+	std::string current_timestamp;
+	return std::make_shared<Context>(0, nodes, master_node, logicalPlan, config_options, current_timestamp);
+}
+
+/**
+* Sets the counters that every benchmark reports, so that the throughput can be compared between releases.
+*/
+inline void set_throughput(benchmark::State & state, std::size_t rows_per_iteration, std::size_t bytes_per_iteration) {
+	state.SetItemsProcessed(state.iterations() * rows_per_iteration);
+	state.SetBytesProcessed(state.iterations() * bytes_per_iteration);
+}
+
+}  // namespace benchmarks
+}  // namespace ral
@@ -0,0 +1,54 @@
+#include "benchmark_utilities.h"
+
+#include "cache_machine/CacheDataLocalFile.h"
+
+using namespace ral::benchmarks;
+
+namespace {
+
+std::string get_spill_directory() {
+	const char * directory = std::getenv("BLAZINGSQL_BENCHMARK_SPILL_DIR");
+	return directory != nullptr ? directory : "/tmp";
+}
+
+}  // namespace
+
+// Writes a batch into an ORC file, as the caches do when the GPU and host memory are full
+static void BM_CacheDataLocalFile_spill(benchmark::State & state) {
+	auto table = make_mixed_table(state.range(0));
+	std::string spill_directory = get_spill_directory();
+
+	for (auto _ : state) {
+		state.PauseTiming();
+		auto input = std::make_unique<ral::frame::BlazingTable>(table->view(), table->names());
+		state.ResumeTiming();
+
+		auto cache_data = std::make_unique<ral::cache::CacheDataLocalFile>(std::move(input), spill_directory, "benchmark");
+		benchmark::DoNotOptimize(cache_data);
+
+		state.PauseTiming();
+		cache_data.reset(); // removes the file
+		state.ResumeTiming();
+	}
+	set_throughput(state, table->num_rows(), table->sizeInBytes());
+}
+BENCHMARK(BM_CacheDataLocalFile_spill)->RangeMultiplier(10)->Range(100000, 10000000)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// Reads a spilled batch back into GPU memory
+static void BM_CacheDataLocalFile_restore(benchmark::State & state) {
+	auto table = make_mixed_table(state.range(0));
+	std::string spill_directory = get_spill_directory();
+
+	for (auto _ : state) {
+		state.PauseTiming();
+		auto cache_data = std::make_unique<ral::cache::CacheDataLocalFile>(
+			std::make_unique<ral::frame::BlazingTable>(table->view(), table->names()), spill_directory, "benchmark");
+		state.ResumeTiming();
+
+		auto result = cache_data->decache();
+		cudaDeviceSynchronize();
+		benchmark::DoNotOptimize(result);
+	}
+	set_throughput(state, table->num_rows(), table->sizeInBytes());
+}
+BENCHMARK(BM_CacheDataLocalFile_restore)->RangeMultiplier(10)->Range(100000, 10000000)->Unit(benchmark::kMillisecond)->UseRealTime();
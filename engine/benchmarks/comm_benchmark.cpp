@@ -0,0 +1,344 @@
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+
+#include <bmr/initializer.h>
+#include <bmr/BlazingMemoryResource.h>
+#include "bmr/BufferProvider.h"
+
+#include "benchmark_utilities.h"
+#include "cache_machine/CacheMachine.h"
+#include "communication/CommunicationInterface/messageListener.hpp"
+#include "communication/CommunicationInterface/messageSender.hpp"
+#include "communication/ucx_init.h"
+
+#include <Util/StringUtil.h>
+
+// Measures the transports between processes that run this benchmark, one per GPU or node, the same way the engine
+// sends the batches of a query: through the output cache of the message_sender and the input cache of the listener.
+//
+// blazingsql-comm-benchmark --rank 0 --nodes host0:port0,host1:port1 [--protocol tcp|ucx] [--rows 1000,1000000]
+//     [--columns 1,8] [--threads 1,4,20] [--messages 20] [--pings 100] [--device 0]
+//
+// All the processes get the same arguments but their rank, the index of their node in --nodes. With ucx the ports
+// of --nodes are only used to exchange the ucx addresses. For every number of send threads (MAX_SEND_MESSAGE_THREADS),
+// columns and rows, every process sends --messages tables to all the others, and prints the rate at which it received
+// theirs. The latency is measured from the round trips of --pings tables between the ranks 0 and 1, since the clocks
+// of the processes are not the same.
+
+using namespace ral::benchmarks;
+
+namespace {
+
+struct benchmark_options {
+	int rank = -1;
+	std::vector<std::pair<std::string, int>> nodes;
+	comm::blazing_protocol protocol = comm::blazing_protocol::tcp;
+	std::vector<cudf::size_type> rows = {1000, 100000, 1000000};
+	std::vector<int> columns = {1, 8};
+	std::vector<int> threads = {1, 4, 20};
+	int messages = 20;
+	int pings = 100;
+	int device = 0;
+};
+
+template <typename T>
+std::vector<T> parse_list(const std::string & value) {
+	std::vector<T> values;
+	for (const std::string & item : StringUtil::split(value, ",")) {
+		values.push_back(static_cast<T>(std::stoll(item)));
+	}
+	return values;
+}
+
+benchmark_options parse_options(int argc, char ** argv) {
+	benchmark_options options;
+	for (int i = 1; i + 1 < argc; i += 2) {
+		std::string name = argv[i];
+		std::string value = argv[i + 1];
+		if (name == "--rank") {
+			options.rank = std::stoi(value);
+		} else if (name == "--nodes") {
+			for (const std::string & node : StringUtil::split(value, ",")) {
+				std::size_t colon = node.rfind(':');
+				if (colon == std::string::npos) {
+					throw std::runtime_error("ERROR: the nodes must be host:port, not " + node);
+				}
+				options.nodes.emplace_back(node.substr(0, colon), std::stoi(node.substr(colon + 1)));
+			}
+		} else if (name == "--protocol") {
+			if (value != "tcp" && value != "ucx") {
+				throw std::runtime_error("ERROR: the protocol must be tcp or ucx, not " + value);
+			}
+			options.protocol = value == "ucx" ? comm::blazing_protocol::ucx : comm::blazing_protocol::tcp;
+		} else if (name == "--rows") {
+			options.rows = parse_list<cudf::size_type>(value);
+		} else if (name == "--columns") {
+			options.columns = parse_list<int>(value);
+		} else if (name == "--threads") {
+			options.threads = parse_list<int>(value);
+		} else if (name == "--messages") {
+			options.messages = std::stoi(value);
+		} else if (name == "--pings") {
+			options.pings = std::stoi(value);
+		} else if (name == "--device") {
+			options.device = std::stoi(value);
+		} else {
+			throw std::runtime_error("ERROR: unknown argument " + name);
+		}
+	}
+	if (options.nodes.size() < 2 || options.rank < 0 || options.rank >= static_cast<int>(options.nodes.size())) {
+		throw std::runtime_error("ERROR: the benchmark needs --rank and at least two --nodes");
+	}
+	return options;
+}
+
+void send_all(int fd, const void * data, std::size_t size, const std::string & what) {
+	int ret = send(fd, data, size, 0);
+	ral::communication::CheckError(static_cast<std::size_t>(ret) != size, "send " + what);
+}
+
+void recv_all(int fd, void * data, std::size_t size, const std::string & what) {
+	int ret = recv(fd, data, size, MSG_WAITALL);
+	ral::communication::CheckError(static_cast<std::size_t>(ret) != size, "recv " + what);
+}
+
+// The same exchange of the ucx addresses that the engine does when it is initialized: every process accepts the
+// addresses of the others on its port while it sends its own to theirs.
+std::map<std::string, comm::node> connect_ucx_nodes(const benchmark_options & options, ucp_worker_h worker) {
+	const std::string worker_id = std::to_string(options.rank);
+	ral::communication::UcpWorkerAddress address = ral::communication::GetUcpWorkerAddress(worker);
+
+	std::map<std::string, ral::communication::UcpWorkerAddress> peer_addresses;
+	std::thread accept_thread([&]() {
+		ral::communication::AddressExchangerForSender exchanger(options.nodes[options.rank].second);
+		for (std::size_t i = 1; i < options.nodes.size(); i++) {
+			if (exchanger.acceptConnection()) {
+				int peer_rank;
+				recv_all(exchanger.fd(), &peer_rank, sizeof(peer_rank), "rank");
+				std::size_t address_size;
+				recv_all(exchanger.fd(), &address_size, sizeof(address_size), "ucp_worker_address_size");
+				std::uint8_t * data = new std::uint8_t[address_size];
+				ral::communication::UcpWorkerAddress peer_address{reinterpret_cast<ucp_address_t *>(data), address_size};
+				recv_all(exchanger.fd(), peer_address.address, address_size, "ucp_worker_address");
+				peer_addresses.emplace(std::to_string(peer_rank), peer_address);
+				exchanger.closeCurrentConnection();
+			}
+		}
+	});
+
+	std::this_thread::sleep_for(std::chrono::seconds(1));
+	for (std::size_t i = 0; i < options.nodes.size(); i++) {
+		if (static_cast<int>(i) == options.rank) {
+			continue;
+		}
+		ral::communication::AddressExchangerForReceiver exchanger(options.nodes[i].second, options.nodes[i].first.c_str());
+		send_all(exchanger.fd(), &options.rank, sizeof(options.rank), "rank");
+		send_all(exchanger.fd(), &address.length, sizeof(address.length), "ucp_worker_address_size");
+		send_all(exchanger.fd(), address.address, address.length, "ucp_worker_address");
+	}
+	accept_thread.join();
+
+	std::map<std::string, comm::node> nodes;
+	for (auto & peer_address : peer_addresses) {
+		ucp_ep_h ucp_ep = ral::communication::CreateUcpEp(worker, peer_address.second);
+		nodes.emplace(peer_address.first, comm::node(options.rank, peer_address.first, ucp_ep, worker));
+	}
+	return nodes;
+}
+
+class comm_benchmark {
+public:
+	comm_benchmark(const benchmark_options & options) : options{options} {
+		for (std::size_t i = 0; i < options.nodes.size(); i++) {
+			if (static_cast<int>(i) != options.rank) {
+				peers.push_back(std::to_string(i));
+			}
+		}
+		start_transport();
+	}
+
+	void run() {
+		for (int num_threads : options.threads) {
+			comm::message_sender::get_instance()->set_num_threads(num_threads);
+			for (int num_columns : options.columns) {
+				for (cudf::size_type num_rows : options.rows) {
+					std::unique_ptr<ral::frame::BlazingTable> table = make_random_table(num_rows, num_columns, num_rows, options.rank);
+					barrier();
+					run_stream(*table, num_threads, num_columns, num_rows);
+					barrier();
+					if (num_threads == options.threads.front() && options.rank < 2) {
+						run_ping_pong(*table, num_columns, num_rows);
+					}
+				}
+			}
+		}
+		barrier();
+	}
+
+private:
+	void start_transport() {
+		std::map<std::string, comm::node> nodes;
+		ucp_context_h ucp_context = nullptr;
+		ucp_worker_h ucp_worker = nullptr;
+		if (options.protocol == comm::blazing_protocol::ucx) {
+			ucp_context = ral::communication::CreateUcpContext();
+			ucp_worker = ral::communication::CreatetUcpWorker(ucp_context);
+			nodes = connect_ucx_nodes(options, ucp_worker);
+		} else {
+			for (const std::string & peer : peers) {
+				const auto & host_port = options.nodes[std::stoi(peer)];
+				nodes.emplace(peer, comm::node(options.rank, peer, host_port.first, host_port.second));
+			}
+		}
+
+		ral::memory::set_allocation_pools(4000000, 10, 4000000, 10,
+			options.protocol == comm::blazing_protocol::ucx, ucp_context);
+
+		input_cache = std::make_shared<ral::cache::CacheMachine>(nullptr, "messages_in", false);
+		if (options.protocol == comm::blazing_protocol::ucx) {
+			comm::ucx_message_listener::initialize_message_listener(ucp_context, ucp_worker, nodes, 20, input_cache);
+			comm::ucx_message_listener::get_instance()->poll_begin_message_tag(true);
+			input_cache = comm::ucx_message_listener::get_instance()->get_input_cache();
+		} else {
+			comm::tcp_message_listener::initialize_message_listener(nodes, options.nodes[options.rank].second, 20, input_cache);
+			comm::tcp_message_listener::get_instance()->start_polling();
+			input_cache = comm::tcp_message_listener::get_instance()->get_input_cache();
+		}
+
+		output_cache = std::make_shared<ral::cache::CacheMachine>(nullptr, "messages_out", false, ral::cache::CACHE_LEVEL_CPU);
+		comm::message_sender::initialize_instance(output_cache, nodes, options.threads.front(), ucp_context, ucp_worker,
+			options.rank, options.protocol, false);
+		comm::message_sender::get_instance()->run_polling();
+		output_cache = comm::message_sender::get_instance()->get_output_cache();
+	}
+
+	void send(std::unique_ptr<ral::frame::BlazingTable> table, const std::string & message_id, const std::string & worker_ids) {
+		ral::cache::MetadataDictionary metadata;
+		metadata.add_value(ral::cache::RAL_ID_METADATA_LABEL, options.rank);
+		metadata.add_value(ral::cache::KERNEL_ID_METADATA_LABEL, 0);
+		metadata.add_value(ral::cache::QUERY_ID_METADATA_LABEL, 0);
+		metadata.add_value(ral::cache::ADD_TO_SPECIFIC_CACHE_METADATA_LABEL, "false");
+		metadata.add_value(ral::cache::CACHE_ID_METADATA_LABEL, "");
+		metadata.add_value(ral::cache::SENDER_WORKER_ID_METADATA_LABEL, std::to_string(options.rank));
+		metadata.add_value(ral::cache::WORKER_IDS_METADATA_LABEL, worker_ids);
+		metadata.add_value(ral::cache::UNIQUE_MESSAGE_ID, message_id);
+		metadata.add_value(ral::cache::MESSAGE_ID, message_id);
+		output_cache->addToCache(std::move(table), "", true, metadata, true);
+	}
+
+	void receive(const std::string & message_id) {
+		std::unique_ptr<ral::cache::CacheData> cache_data = input_cache->pullCacheData(message_id);
+		if (cache_data == nullptr) {
+			throw std::runtime_error("ERROR: the message " + message_id + " was not received");
+		}
+	}
+
+	// every process waits for a message from all the others
+	void barrier() {
+		std::string prefix = "barrier_" + std::to_string(num_barriers++) + "_";
+		send(make_random_table(1, 1, 1), prefix + std::to_string(options.rank), StringUtil::join(peers, ","));
+		for (const std::string & peer : peers) {
+			receive(prefix + peer);
+		}
+	}
+
+	void run_stream(const ral::frame::BlazingTable & table, int num_threads, int num_columns, cudf::size_type num_rows) {
+		std::string prefix = "stream_" + std::to_string(num_stream_runs++) + "_";
+		std::string worker_ids = StringUtil::join(peers, ",");
+
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < options.messages; i++) {
+			send(table.clone(), prefix + std::to_string(options.rank) + "_" + std::to_string(i), worker_ids);
+		}
+		for (const std::string & peer : peers) {
+			for (int i = 0; i < options.messages; i++) {
+				receive(prefix + peer + "_" + std::to_string(i));
+			}
+		}
+		double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+		// all the processes send the same shape of tables, so what is received is what this process sent to each of them
+		std::size_t num_messages = options.messages * peers.size();
+		double received_bytes = static_cast<double>(table.sizeInBytes()) * num_messages;
+		std::cout << std::fixed << std::setprecision(2)
+			<< "rank " << options.rank << " stream threads=" << num_threads << " columns=" << num_columns
+			<< " rows=" << num_rows << " bytes=" << table.sizeInBytes()
+			<< " bandwidth_MBps=" << received_bytes / seconds / 1e6
+			<< " messages_per_s=" << num_messages / seconds << std::endl;
+	}
+
+	// the ranks 0 and 1 send a table back and forth, the latency is half of a round trip
+	void run_ping_pong(const ral::frame::BlazingTable & table, int num_columns, cudf::size_type num_rows) {
+		std::string prefix = "ping_" + std::to_string(num_ping_pong_runs++) + "_";
+		std::string other = options.rank == 0 ? "1" : "0";
+
+		std::vector<double> latencies_us;
+		for (int i = 0; i < options.pings; i++) {
+			std::string ping_id = prefix + std::to_string(i) + "_0";
+			std::string pong_id = prefix + std::to_string(i) + "_1";
+			if (options.rank == 0) {
+				auto start = std::chrono::high_resolution_clock::now();
+				send(table.clone(), ping_id, other);
+				receive(pong_id);
+				latencies_us.push_back(std::chrono::duration<double, std::micro>(
+					std::chrono::high_resolution_clock::now() - start).count() / 2);
+			} else {
+				receive(ping_id);
+				send(table.clone(), pong_id, other);
+			}
+		}
+
+		if (options.rank == 0 && !latencies_us.empty()) {
+			std::sort(latencies_us.begin(), latencies_us.end());
+			auto percentile = [&latencies_us](double p) {
+				return latencies_us[std::min(latencies_us.size() - 1, static_cast<std::size_t>(p * latencies_us.size()))];
+			};
+			std::cout << std::fixed << std::setprecision(2)
+				<< "rank 0 latency columns=" << num_columns << " rows=" << num_rows << " bytes=" << table.sizeInBytes()
+				<< " p50_us=" << percentile(0.5) << " p90_us=" << percentile(0.9)
+				<< " p99_us=" << percentile(0.99) << std::endl;
+		}
+	}
+
+	benchmark_options options;
+	std::vector<std::string> peers;
+	std::shared_ptr<ral::cache::CacheMachine> output_cache;
+	std::shared_ptr<ral::cache::CacheMachine> input_cache;
+	int num_barriers = 0;
+	int num_stream_runs = 0;
+	int num_ping_pong_runs = 0;
+};
+
+}  // namespace
+
+int main(int argc, char ** argv) {
+	benchmark_options options;
+	try {
+		options = parse_options(argc, argv);
+	} catch (const std::exception & e) {
+		std::cerr << e.what() << std::endl;
+		std::cerr << "usage: blazingsql-comm-benchmark --rank <rank> --nodes <host:port,...> [--protocol tcp|ucx]"
+			" [--rows <rows,...>] [--columns <columns,...>] [--threads <threads,...>] [--messages <n>] [--pings <n>]"
+			" [--device <device>]" << std::endl;
+		return 2;
+	}
+
+	cudaSetDevice(options.device);
+	BlazingRMMInitialize("pool_memory_resource");
+	float host_memory_quota = 0.75; //default value
+	blazing_host_memory_resource::getInstance().initialize(host_memory_quota);
+
+	comm_benchmark(options).run();
+
+	// the listener and sender threads are never joined, as in the engine
+	std::quick_exit(0);
+}
@@ -0,0 +1,136 @@
+#include "benchmark_utilities.h"
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <mutex>
+
+#include "blazing_table/BlazingColumn.h"
+#include "bmr/BufferProvider.h"
+#include "cache_machine/CacheMachine.h"
+#include "cache_machine/GPUCacheData.h"
+#include "cache_machine/WaitingQueue.h"
+
+// Measures how the structures that all the threads of a query share scale with the number of threads, from 1 to 128,
+// to have a baseline for their lock-free or sharded replacements. Every thread puts an item and takes one in every
+// iteration, so the queues never run empty and no thread waits for another but on their locks. Besides the items per
+// second of all the threads, every benchmark reports the p50 and p99 of the latency of each call, the average over the
+// threads of the percentiles of every thread.
+
+using namespace ral::benchmarks;
+
+namespace {
+
+class latency_samples {
+public:
+	explicit latency_samples(const benchmark::State & state) {
+		samples.reserve(state.max_iterations);
+	}
+
+	void add(std::chrono::steady_clock::time_point start) {
+		samples.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+	}
+
+	void report(benchmark::State & state, const std::string & name) {
+		if (samples.empty()) {
+			return;
+		}
+		std::sort(samples.begin(), samples.end());
+		auto percentile = [this](double p) {
+			return samples[std::min(samples.size() - 1, static_cast<std::size_t>(p * samples.size()))];
+		};
+		state.counters[name + "_p50_us"] = benchmark::Counter(percentile(0.5), benchmark::Counter::kAvgThreads);
+		state.counters[name + "_p99_us"] = benchmark::Counter(percentile(0.99), benchmark::Counter::kAvgThreads);
+	}
+
+private:
+	std::vector<double> samples;
+};
+
+// a batch without columns, so that the items only cost their locks
+std::unique_ptr<ral::cache::CacheData> make_empty_cache_data() {
+	std::vector<std::unique_ptr<ral::frame::BlazingColumn>> columns;
+	return std::make_unique<ral::cache::GPUCacheData>(
+		std::make_unique<ral::frame::BlazingTable>(std::move(columns), std::vector<std::string>()));
+}
+
+// the pools are shared by the threads of a run, and kept between the runs, one for every thread cache size
+std::shared_ptr<ral::memory::allocation_pool> get_pool(std::size_t thread_cache_size) {
+	static std::mutex mutex;
+	static std::map<std::size_t, std::shared_ptr<ral::memory::allocation_pool>> pools;
+	std::lock_guard<std::mutex> lock(mutex);
+	auto & pool = pools[thread_cache_size];
+	if (pool == nullptr) {
+		pool = std::make_shared<ral::memory::allocation_pool>(
+			std::make_unique<ral::memory::host_allocator>(false), 1 << 20, 256, thread_cache_size);
+	}
+	return pool;
+}
+
+}  // namespace
+
+// WaitingQueue::put and pop_or_wait, which every CacheMachine is built on
+static void BM_WaitingQueue_put_pop(benchmark::State & state) {
+	static ral::cache::WaitingQueue<std::unique_ptr<ral::cache::message>> queue("benchmark");
+	auto message = std::make_unique<ral::cache::message>(make_empty_cache_data(), "benchmark");
+	latency_samples put_latencies(state);
+	latency_samples pop_latencies(state);
+
+	for (auto _ : state) {
+		auto start = std::chrono::steady_clock::now();
+		queue.put(std::move(message));
+		put_latencies.add(start);
+
+		start = std::chrono::steady_clock::now();
+		message = queue.pop_or_wait();
+		pop_latencies.add(start);
+	}
+	state.SetItemsProcessed(state.iterations());
+	put_latencies.report(state, "put");
+	pop_latencies.report(state, "pop");
+}
+BENCHMARK(BM_WaitingQueue_put_pop)->ThreadRange(1, 128)->UseRealTime();
+
+// CacheMachine::addCacheData and pullCacheData, as the kernels of a query add and take their batches
+static void BM_CacheMachine_add_pull(benchmark::State & state) {
+	static auto cache = std::make_shared<ral::cache::CacheMachine>(make_context(), "benchmark");
+	auto cache_data = make_empty_cache_data();
+	latency_samples add_latencies(state);
+	latency_samples pull_latencies(state);
+
+	for (auto _ : state) {
+		auto start = std::chrono::steady_clock::now();
+		cache->addCacheData(std::move(cache_data));
+		add_latencies.add(start);
+
+		start = std::chrono::steady_clock::now();
+		cache_data = cache->pullCacheData();
+		pull_latencies.add(start);
+	}
+	state.SetItemsProcessed(state.iterations());
+	add_latencies.report(state, "add");
+	pull_latencies.report(state, "pull");
+}
+BENCHMARK(BM_CacheMachine_add_pull)->ThreadRange(1, 128)->UseRealTime();
+
+// allocation_pool::get_chunk and free_chunk, with and without the thread caches, as the threads that spill and send
+// batches take and return their host buffers
+static void BM_allocation_pool_get_free(benchmark::State & state) {
+	auto pool = get_pool(state.range(0));
+	latency_samples get_latencies(state);
+	latency_samples free_latencies(state);
+
+	for (auto _ : state) {
+		auto start = std::chrono::steady_clock::now();
+		auto chunk = pool->get_chunk();
+		get_latencies.add(start);
+
+		start = std::chrono::steady_clock::now();
+		pool->free_chunk(std::move(chunk));
+		free_latencies.add(start);
+	}
+	state.SetItemsProcessed(state.iterations());
+	get_latencies.report(state, "get");
+	free_latencies.report(state, "free");
+}
+BENCHMARK(BM_allocation_pool_get_free)->Arg(0)->Arg(4)->ThreadRange(1, 128)->UseRealTime();
@@ -0,0 +1,495 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cudf/column/column_factories.hpp>
+#include <rmm/device_buffer.hpp>
+
+#include <bmr/BlazingMemoryResource.h>
+#include "bmr/MemoryMonitor.h"
+#include "cache_machine/CacheMachine.h"
+#include "engine/initialize.h"
+#include "execution_graph/Context.h"
+#include "execution_graph/PhysicalPlanGenerator.h"
+#include "execution_graph/executor.h"
+#include "execution_graph/kernel_run_pool.h"
+#include "execution_kernels/kernel.h"
+#include "utilities/RuntimeMetrics.h"
+
+#include <Util/StringUtil.h>
+
+// Replays the tasks of a query, as they were recorded in a task log (bsql_kernel_tasks.<ral_id>.log, written with
+// ENABLE_TASK_LOGS), through the executor, the CacheMachines and the MemoryMonitor of the engine, so that their
+// settings can be compared without running the query again on a cluster.
+//
+// blazingsql-executor-simulator (--trace <bsql_kernel_tasks.log> | --synthetic <num_tasks>) [--arrivals trace|burst]
+//     [--time-scale 1.0] [--sweep EXECUTOR_THREADS=4,10,20] [--option NAME=VALUE] [--memory-monitor true|false]
+//     [--allocator pool_memory_resource] [--initial-pool-size <bytes>] [--maximum-pool-size <bytes>] [--device 0]
+//
+// Every recorded kernel of every query is a mock kernel of the same kernel type, which gets a task for every task of
+// the log, at the time it started in the log (or all of them at once with --arrivals burst). Its input is a table of
+// input_num_bytes bytes that goes through the input cache of the kernel, so it is spilled and decached like the batches
+// of a query, and the task allocates the max_memory_used of the log and holds it for duration_execution, scaled by
+// --time-scale, and is retried if the allocation fails. The logs written before kernel_type and max_memory_used were
+// logged are replayed as ProjectKernels that need twice their input. --synthetic makes up the tasks instead, always the
+// same ones for the same --seed.
+//
+// Every configuration, the options of --option plus one value of every --sweep, is run in a process of its own, since
+// the executor and the memory resources are made once per process, and prints its throughput, the latency of the tasks
+// from their arrival to their end, and how much was spilled.
+
+namespace {
+
+using Context = blazingdb::manager::Context;
+
+struct trace_task {
+	int32_t query_id = 0;
+	int32_t kernel_id = 0;
+	ral::cache::kernel_type type = ral::cache::kernel_type::ProjectKernel;
+	int64_t start_ms = 0; // since the first task of the trace
+	int64_t duration_ms = 0;
+	std::size_t input_bytes = 0;
+	std::size_t memory_bytes = 0;
+};
+
+struct simulator_options {
+	std::string trace_path;
+	std::size_t synthetic_tasks = 0;
+	std::size_t synthetic_bytes = 32 << 20;
+	int synthetic_kernels = 4;
+	double synthetic_interarrival_ms = 2;
+	unsigned seed = 42;
+	bool burst = false;
+	double time_scale = 1.0;
+	bool memory_monitor = true;
+	std::map<std::string, std::string> config_options;
+	std::vector<std::pair<std::string, std::vector<std::string>>> sweeps;
+	std::string allocator = "cuda_memory_resource";
+	std::size_t initial_pool_size = 0;
+	std::size_t maximum_pool_size = 0;
+	int device = 0;
+};
+
+std::pair<std::string, std::string> parse_assignment(const std::string & value) {
+	std::size_t equals = value.find('=');
+	if (equals == std::string::npos || equals == 0) {
+		throw std::runtime_error("ERROR: the options must be NAME=VALUE, not " + value);
+	}
+	return {value.substr(0, equals), value.substr(equals + 1)};
+}
+
+simulator_options parse_options(int argc, char ** argv) {
+	simulator_options options;
+	for (int i = 1; i + 1 < argc; i += 2) {
+		std::string name = argv[i];
+		std::string value = argv[i + 1];
+		if (name == "--trace") {
+			options.trace_path = value;
+		} else if (name == "--synthetic") {
+			options.synthetic_tasks = std::stoull(value);
+		} else if (name == "--synthetic-bytes") {
+			options.synthetic_bytes = std::stoull(value);
+		} else if (name == "--synthetic-kernels") {
+			options.synthetic_kernels = std::stoi(value);
+		} else if (name == "--synthetic-interarrival-ms") {
+			options.synthetic_interarrival_ms = std::stod(value);
+		} else if (name == "--seed") {
+			options.seed = static_cast<unsigned>(std::stoul(value));
+		} else if (name == "--arrivals") {
+			if (value != "trace" && value != "burst") {
+				throw std::runtime_error("ERROR: the arrivals must be trace or burst, not " + value);
+			}
+			options.burst = value == "burst";
+		} else if (name == "--time-scale") {
+			options.time_scale = std::stod(value);
+		} else if (name == "--memory-monitor") {
+			options.memory_monitor = value == "true" || value == "True" || value == "1";
+		} else if (name == "--option") {
+			options.config_options.insert(parse_assignment(value));
+		} else if (name == "--sweep") {
+			auto assignment = parse_assignment(value);
+			options.sweeps.emplace_back(assignment.first, StringUtil::split(assignment.second, ","));
+		} else if (name == "--allocator") {
+			options.allocator = value;
+		} else if (name == "--initial-pool-size") {
+			options.initial_pool_size = std::stoull(value);
+		} else if (name == "--maximum-pool-size") {
+			options.maximum_pool_size = std::stoull(value);
+		} else if (name == "--device") {
+			options.device = std::stoi(value);
+		} else {
+			throw std::runtime_error("ERROR: unknown argument " + name);
+		}
+	}
+	if (options.trace_path.empty() == (options.synthetic_tasks == 0)) {
+		throw std::runtime_error("ERROR: the simulator needs either --trace or --synthetic");
+	}
+	if (options.time_scale <= 0 || options.synthetic_kernels <= 0) {
+		throw std::runtime_error("ERROR: --time-scale and --synthetic-kernels must be positive");
+	}
+	return options;
+}
+
+ral::cache::kernel_type parse_kernel_type(const std::string & name) {
+	for (int type = 0; type <= static_cast<int>(ral::cache::kernel_type::CachedTableScanKernel); type++) {
+		if (ral::cache::get_kernel_type_name(static_cast<ral::cache::kernel_type>(type)) == name) {
+			return static_cast<ral::cache::kernel_type>(type);
+		}
+	}
+	return ral::cache::kernel_type::ProjectKernel;
+}
+
+std::vector<trace_task> read_trace(const std::string & path) {
+	std::ifstream file(path);
+	if (!file) {
+		throw std::runtime_error("ERROR: could not open the trace " + path);
+	}
+	std::string line;
+	std::getline(file, line);
+	std::map<std::string, std::size_t> columns;
+	std::vector<std::string> header = StringUtil::split(line, "|");
+	for (std::size_t i = 0; i < header.size(); i++) {
+		columns[header[i]] = i;
+	}
+	for (const std::string column : {"time_started", "query_id", "kernel_id", "duration_execution", "input_num_bytes"}) {
+		if (columns.find(column) == columns.end()) {
+			throw std::runtime_error("ERROR: the trace " + path + " has no column " + column + ", it is not a task log");
+		}
+	}
+	bool has_types = columns.find("kernel_type") != columns.end();
+	bool has_memory = columns.find("max_memory_used") != columns.end();
+
+	std::vector<trace_task> tasks;
+	while (std::getline(file, line)) {
+		std::vector<std::string> fields = StringUtil::split(line, "|");
+		if (fields.size() < header.size()) {
+			continue; // a line that was cut short when the log was copied
+		}
+		trace_task task;
+		task.query_id = std::stoi(fields[columns["query_id"]]);
+		task.kernel_id = std::stoi(fields[columns["kernel_id"]]);
+		task.start_ms = std::stoll(fields[columns["time_started"]]);
+		task.duration_ms = std::stoll(fields[columns["duration_execution"]]);
+		task.input_bytes = std::stoull(fields[columns["input_num_bytes"]]);
+		if (has_types) {
+			task.type = parse_kernel_type(fields[columns["kernel_type"]]);
+		}
+		task.memory_bytes = has_memory ? std::stoull(fields[columns["max_memory_used"]]) : 2 * task.input_bytes;
+		tasks.push_back(task);
+	}
+	if (tasks.empty()) {
+		throw std::runtime_error("ERROR: the trace " + path + " has no tasks");
+	}
+
+	std::sort(tasks.begin(), tasks.end(), [](const trace_task & a, const trace_task & b) { return a.start_ms < b.start_ms; });
+	int64_t first_start_ms = tasks.front().start_ms;
+	for (auto & task : tasks) {
+		task.start_ms -= first_start_ms;
+	}
+	return tasks;
+}
+
+// the kernels of a query that runs over a table scan, with how much memory their tasks need for their input, and how
+// long they take per GB of it
+std::vector<trace_task> make_synthetic_trace(const simulator_options & options) {
+	struct synthetic_kernel {
+		ral::cache::kernel_type type;
+		double memory_per_input_byte;
+		double ms_per_gb;
+	};
+	const std::vector<synthetic_kernel> kernels = {
+		{ral::cache::kernel_type::TableScanKernel, 1.0, 100},
+		{ral::cache::kernel_type::FilterKernel, 1.5, 50},
+		{ral::cache::kernel_type::ProjectKernel, 2.0, 100},
+		{ral::cache::kernel_type::ComputeAggregateKernel, 2.5, 250},
+		{ral::cache::kernel_type::PartwiseJoinKernel, 4.0, 400},
+	};
+
+	std::mt19937_64 generator(options.seed);
+	std::lognormal_distribution<double> bytes_distribution(std::log(static_cast<double>(options.synthetic_bytes)), 0.5);
+	std::exponential_distribution<double> interarrival_distribution(1.0 / options.synthetic_interarrival_ms);
+
+	std::vector<trace_task> tasks;
+	double start_ms = 0;
+	for (std::size_t i = 0; i < options.synthetic_tasks; i++) {
+		trace_task task;
+		task.kernel_id = static_cast<int32_t>(i % options.synthetic_kernels);
+		const synthetic_kernel & kernel = kernels[task.kernel_id % kernels.size()];
+		task.type = kernel.type;
+		task.start_ms = static_cast<int64_t>(start_ms);
+		task.input_bytes = std::max<std::size_t>(1, static_cast<std::size_t>(bytes_distribution(generator)));
+		task.memory_bytes = static_cast<std::size_t>(task.input_bytes * kernel.memory_per_input_byte);
+		task.duration_ms = std::max<int64_t>(1, static_cast<int64_t>(task.input_bytes / 1e9 * kernel.ms_per_gb));
+		tasks.push_back(task);
+		start_ms += interarrival_distribution(generator);
+	}
+	return tasks;
+}
+
+// what the simulation of one configuration measured, the times are since it started
+struct simulation_state {
+	std::vector<trace_task> tasks;
+	std::vector<std::chrono::steady_clock::time_point> arrivals;
+	std::vector<std::chrono::steady_clock::time_point> completions;
+	double time_scale;
+};
+
+// the kernels that only own a cache: the source of the inputs of a mock kernel and the root of the tree of the
+// MemoryMonitor
+class cache_kernel : public ral::cache::kernel {
+public:
+	cache_kernel(std::size_t kernel_id, std::shared_ptr<Context> context, ral::cache::kernel_type type)
+		: kernel(kernel_id, "", context, type) {}
+
+	std::string kernel_name() override { return "SimulatedCache"; }
+
+	ral::cache::kstatus run() override { return ral::cache::kstatus::proceed; }
+};
+
+// a recorded kernel, whose tasks allocate the memory and take the time of the ones of the trace
+class replayed_kernel : public ral::cache::kernel {
+public:
+	replayed_kernel(std::size_t kernel_id, std::shared_ptr<Context> context, ral::cache::kernel_type type, simulation_state & state)
+		: kernel(kernel_id, "", context, type), state(state) {}
+
+	std::string kernel_name() override { return "ReplayedKernel"; }
+
+	ral::execution::task_result do_process(std::vector<std::unique_ptr<ral::frame::BlazingTable>> inputs,
+		std::shared_ptr<ral::cache::CacheMachine> /*output*/,
+		cudaStream_t stream, const std::map<std::string, std::string>& /*args*/) override {
+		// the column of an input is named after its task, so that it is known whichever order the tasks run in
+		std::size_t index = std::stoull(inputs[0]->names()[0].substr(5));
+		const trace_task & task = state.tasks[index];
+		try {
+			// the decached input counts for the memory of the task, as it did when it was recorded
+			std::size_t used = blazing_device_memory_resource::get_thread_max_memory_used();
+			rmm::device_buffer working_memory(task.memory_bytes > used ? task.memory_bytes - used : 0, stream);
+			std::this_thread::sleep_for(std::chrono::microseconds(static_cast<int64_t>(task.duration_ms * 1000 * state.time_scale)));
+		} catch (const rmm::bad_alloc & e) {
+			return {ral::execution::task_status::RETRY, std::string(e.what()), std::move(inputs)};
+		}
+		state.completions[index] = std::chrono::steady_clock::now();
+		return {ral::execution::task_status::SUCCESS, std::string(), std::vector<std::unique_ptr<ral::frame::BlazingTable>>()};
+	}
+
+	ral::cache::kstatus run() override {
+		std::unique_ptr<ral::cache::CacheData> cache_data = this->input_cache()->pullCacheData();
+		while (cache_data != nullptr) {
+			std::vector<std::unique_ptr<ral::cache::CacheData>> inputs;
+			inputs.push_back(std::move(cache_data));
+			ral::execution::executor::get_instance()->add_task(std::move(inputs), this->output_cache(), this);
+			cache_data = this->input_cache()->pullCacheData();
+		}
+
+		std::unique_lock<std::mutex> lock(kernel_mutex);
+		kernel_cv.wait(lock, [this] {
+			return this->tasks.empty() || ral::execution::executor::get_instance()->has_exception();
+		});
+		if (auto ep = ral::execution::executor::get_instance()->last_exception()) {
+			std::rethrow_exception(ep);
+		}
+		this->output_cache()->finish();
+		return ral::cache::kstatus::proceed;
+	}
+
+private:
+	simulation_state & state;
+};
+
+std::unique_ptr<ral::frame::BlazingTable> make_input(std::size_t index, std::size_t num_bytes) {
+	std::vector<std::unique_ptr<cudf::column>> columns;
+	columns.push_back(cudf::make_numeric_column(cudf::data_type{cudf::type_id::INT8},
+		static_cast<cudf::size_type>(std::min<std::size_t>(num_bytes, std::numeric_limits<cudf::size_type>::max()))));
+	return std::make_unique<ral::frame::BlazingTable>(std::make_unique<CudfTable>(std::move(columns)),
+		std::vector<std::string>{"task_" + std::to_string(index)});
+}
+
+void simulate(const simulator_options & options, const std::vector<trace_task> & tasks,
+		const std::map<std::string, std::string> & config_options, const std::string & description) {
+	cudaSetDevice(options.device);
+	std::map<std::string, std::string> engine_options = config_options;
+	engine_options.emplace("BLAZ_HOST_MEM_CONSUMPTION_THRESHOLD", "0.75"); // the default of the BlazingContext
+	initialize(0, "self", "lo", 0, {}, true, engine_options,
+		options.allocator, options.initial_pool_size, options.maximum_pool_size, false);
+
+	simulation_state state;
+	state.tasks = tasks;
+	state.arrivals.resize(tasks.size());
+	state.completions.resize(tasks.size());
+	state.time_scale = options.time_scale;
+
+	// a context for every query, and a source and a mock kernel for every kernel of a query
+	std::vector<blazingdb::transport::Node> nodes = {blazingdb::transport::Node("self")};
+	std::map<int32_t, std::shared_ptr<Context>> contexts;
+	std::map<std::pair<int32_t, int32_t>, std::shared_ptr<replayed_kernel>> kernels;
+	std::map<std::pair<int32_t, int32_t>, std::shared_ptr<cache_kernel>> sources;
+	std::map<std::pair<int32_t, int32_t>, std::size_t> last_tasks;
+	std::size_t next_kernel_id = 0;
+	auto root = std::make_shared<cache_kernel>(next_kernel_id++,
+		std::make_shared<Context>(0, nodes, nodes[0], "", config_options, ""), ral::cache::kernel_type::OutputKernel);
+	root->output_.register_cache(std::to_string(root->get_id()),
+		std::make_shared<ral::cache::CacheMachine>(root->get_context(), std::to_string(root->get_id())));
+	ral::batch::node root_node{"", 0, root, {}};
+	for (std::size_t i = 0; i < tasks.size(); i++) {
+		auto key = std::make_pair(tasks[i].query_id, tasks[i].kernel_id);
+		last_tasks[key] = i;
+		if (kernels.find(key) != kernels.end()) {
+			continue;
+		}
+		auto & context = contexts[tasks[i].query_id];
+		if (context == nullptr) {
+			context = std::make_shared<Context>(tasks[i].query_id, nodes, nodes[0], "", config_options, "");
+		}
+		auto source = std::make_shared<cache_kernel>(next_kernel_id++, context, ral::cache::kernel_type::TableScanKernel);
+		auto kernel = std::make_shared<replayed_kernel>(next_kernel_id++, context, tasks[i].type, state);
+		auto input_cache = std::make_shared<ral::cache::CacheMachine>(context, std::to_string(source->get_id()));
+		source->output_.register_cache(std::to_string(source->get_id()), input_cache);
+		kernel->input_.register_cache("1", input_cache);
+		kernel->output_.register_cache(std::to_string(kernel->get_id()),
+			std::make_shared<ral::cache::CacheMachine>(context, std::to_string(kernel->get_id())));
+		sources[key] = source;
+		kernels[key] = kernel;
+
+		// the MemoryMonitor downgrades the caches of the children of every node
+		auto kernel_node = std::make_shared<ral::batch::node>(ral::batch::node{"", 1, kernel, {}});
+		kernel_node->children.push_back(std::make_shared<ral::batch::node>(ral::batch::node{"", 2, source, {}}));
+		root_node.children.push_back(kernel_node);
+	}
+
+	std::unique_ptr<ral::MemoryMonitor> memory_monitor;
+	if (options.memory_monitor) {
+		auto tree = std::make_shared<ral::batch::tree_processor>(root_node, root->get_context(),
+			std::vector<ral::io::data_loader>(), std::vector<ral::io::Schema>(), std::vector<std::string>(),
+			std::vector<std::string>(), false);
+		memory_monitor = std::make_unique<ral::MemoryMonitor>(tree, engine_options);
+		memory_monitor->start();
+	}
+
+	ral::execution::kernel_run_pool run_pool(kernels.size());
+	std::vector<std::future<void>> runs;
+	for (auto & kernel : kernels) {
+		auto replayed = kernel.second;
+		runs.push_back(run_pool.push([replayed]() { replayed->run(); }));
+	}
+
+	// the inputs are added to the caches at the times their tasks started in the trace
+	auto start = std::chrono::steady_clock::now();
+	for (std::size_t i = 0; i < tasks.size(); i++) {
+		auto key = std::make_pair(tasks[i].query_id, tasks[i].kernel_id);
+		if (!options.burst) {
+			std::this_thread::sleep_until(start + std::chrono::microseconds(static_cast<int64_t>(tasks[i].start_ms * 1000 * options.time_scale)));
+		}
+		auto input_cache = sources[key]->output_cache();
+		state.arrivals[i] = std::chrono::steady_clock::now();
+		input_cache->addToCache(make_input(i, tasks[i].input_bytes), "", true);
+		if (last_tasks[key] == i) {
+			input_cache->finish();
+		}
+	}
+	for (auto & run : runs) {
+		run.get();
+	}
+	auto end = std::chrono::steady_clock::now();
+	if (memory_monitor != nullptr) {
+		memory_monitor->finalize();
+	}
+
+	std::vector<double> latencies_ms;
+	std::size_t input_bytes = 0;
+	for (std::size_t i = 0; i < tasks.size(); i++) {
+		latencies_ms.push_back(std::chrono::duration<double, std::milli>(state.completions[i] - state.arrivals[i]).count());
+		input_bytes += tasks[i].input_bytes;
+	}
+	std::sort(latencies_ms.begin(), latencies_ms.end());
+	auto percentile = [&latencies_ms](double p) {
+		return latencies_ms[std::min(latencies_ms.size() - 1, static_cast<std::size_t>(p * latencies_ms.size()))];
+	};
+	double seconds = std::chrono::duration<double>(end - start).count();
+	auto & metrics = ral::utilities::runtime_metrics::get_instance();
+	std::cout << std::fixed << std::setprecision(2) << description
+		<< " tasks=" << tasks.size() << " seconds=" << seconds
+		<< " tasks_per_s=" << tasks.size() / seconds
+		<< " input_MBps=" << input_bytes / seconds / 1e6
+		<< " p50_ms=" << percentile(0.5) << " p90_ms=" << percentile(0.9) << " p99_ms=" << percentile(0.99)
+		<< " retries=" << metrics.get_oom_retries()
+		<< " spilled_host_MB=" << metrics.get_spill_bytes(ral::utilities::spill_tier::host) / 1e6
+		<< " spilled_disk_MB=" << metrics.get_spill_bytes(ral::utilities::spill_tier::disk) / 1e6
+		<< " unspilled_MB=" << metrics.get_unspill_bytes() / 1e6
+		<< " max_gpu_MB=" << getMaxMemoryUsed() / 1e6 << std::endl;
+}
+
+// the cartesian product of the values of the sweeps, on top of the options that are always set
+std::vector<std::map<std::string, std::string>> make_configurations(const simulator_options & options) {
+	std::vector<std::map<std::string, std::string>> configurations = {options.config_options};
+	for (const auto & sweep : options.sweeps) {
+		std::vector<std::map<std::string, std::string>> swept;
+		for (const auto & configuration : configurations) {
+			for (const auto & value : sweep.second) {
+				swept.push_back(configuration);
+				swept.back()[sweep.first] = value;
+			}
+		}
+		configurations = std::move(swept);
+	}
+	return configurations;
+}
+
+}  // namespace
+
+int main(int argc, char ** argv) {
+	simulator_options options;
+	std::vector<trace_task> tasks;
+	try {
+		options = parse_options(argc, argv);
+		tasks = options.trace_path.empty() ? make_synthetic_trace(options) : read_trace(options.trace_path);
+	} catch (const std::exception & e) {
+		std::cerr << e.what() << std::endl;
+		std::cerr << "usage: blazingsql-executor-simulator (--trace <bsql_kernel_tasks.log> | --synthetic <num_tasks>)"
+			" [--synthetic-bytes <bytes>] [--synthetic-kernels <n>] [--synthetic-interarrival-ms <ms>] [--seed <seed>]"
+			" [--arrivals trace|burst] [--time-scale <scale>] [--sweep NAME=<value,...>] [--option NAME=VALUE]"
+			" [--memory-monitor true|false] [--allocator <allocation_mode>] [--initial-pool-size <bytes>]"
+			" [--maximum-pool-size <bytes>] [--device <device>]" << std::endl;
+		return 2;
+	}
+
+	// the parent never touches the GPU, so that every configuration starts from a fresh CUDA context in its child
+	int failures = 0;
+	for (const auto & configuration : make_configurations(options)) {
+		std::string description = "config";
+		for (const auto & sweep : options.sweeps) {
+			description += " " + sweep.first + "=" + configuration.at(sweep.first);
+		}
+		std::cout.flush();
+		pid_t pid = fork();
+		if (pid == 0) {
+			try {
+				simulate(options, tasks, configuration, description);
+			} catch (const std::exception & e) {
+				std::cerr << description << " failed: " << e.what() << std::endl;
+				std::quick_exit(1);
+			}
+			// the threads of the engine are never joined, as in the comm benchmark
+			std::quick_exit(0);
+		}
+		int status = 0;
+		if (pid < 0 || waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+			std::cerr << description << " did not finish" << std::endl;
+			failures++;
+		}
+	}
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,50 @@
+#include "benchmark_utilities.h"
+
+#include "operators/GroupBy.h"
+
+using namespace ral::benchmarks;
+
+// SUM, MIN and COUNT of a column grouped by a key. The second argument is the number of distinct keys.
+static void BM_compute_aggregations_with_groupby(benchmark::State & state) {
+	cudf::size_type num_rows = state.range(0);
+	auto table = make_random_table(num_rows, 2, state.range(1));
+
+	std::vector<std::string> aggregation_input_expressions{"1", "1", "1"};
+	std::vector<AggregateKind> aggregation_types{AggregateKind::SUM, AggregateKind::MIN, AggregateKind::COUNT_VALID};
+	std::vector<std::string> aggregation_column_assigned_aliases{"sum", "min", "count"};
+	std::vector<int> group_column_indices{0};
+
+	for (auto _ : state) {
+		auto result = ral::operators::compute_aggregations_with_groupby(table->toBlazingTableView(),
+			aggregation_input_expressions, aggregation_types, aggregation_column_assigned_aliases, group_column_indices);
+		cudaDeviceSynchronize();
+		benchmark::DoNotOptimize(result);
+	}
+	set_throughput(state, table->num_rows(), table->sizeInBytes());
+}
+BENCHMARK(BM_compute_aggregations_with_groupby)
+	->Args({1000000, 100})->Args({1000000, 100000})->Args({10000000, 100})->Args({10000000, 1000000})
+	->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// TPC-H Q1 like aggregation of lineitem grouped by l_returnflag and l_linestatus
+static void BM_compute_aggregations_with_groupby_tpch(benchmark::State & state) {
+	auto lineitem = read_tpch_table("lineitem", {"l_returnflag", "l_linestatus", "l_quantity", "l_extendedprice"});
+	if (lineitem == nullptr) {
+		state.SkipWithError("BLAZINGSQL_BENCHMARK_TPCH_DIR is not set");
+		return;
+	}
+
+	std::vector<std::string> aggregation_input_expressions{"2", "3", "2"};
+	std::vector<AggregateKind> aggregation_types{AggregateKind::SUM, AggregateKind::SUM, AggregateKind::MEAN};
+	std::vector<std::string> aggregation_column_assigned_aliases{"sum_qty", "sum_base_price", "avg_qty"};
+	std::vector<int> group_column_indices{0, 1};
+
+	for (auto _ : state) {
+		auto result = ral::operators::compute_aggregations_with_groupby(lineitem->toBlazingTableView(),
+			aggregation_input_expressions, aggregation_types, aggregation_column_assigned_aliases, group_column_indices);
+		cudaDeviceSynchronize();
+		benchmark::DoNotOptimize(result);
+	}
+	set_throughput(state, lineitem->num_rows(), lineitem->sizeInBytes());
+}
+BENCHMARK(BM_compute_aggregations_with_groupby_tpch)->Unit(benchmark::kMillisecond)->UseRealTime();
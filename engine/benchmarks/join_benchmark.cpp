@@ -0,0 +1,54 @@
+#include "benchmark_utilities.h"
+
+#include "execution_graph/graph.h"
+#include "execution_kernels/BatchJoinProcessing.h"
+
+using namespace ral::benchmarks;
+
+namespace {
+
+std::unique_ptr<ral::batch::PartwiseJoin> make_join_kernel(const std::string & condition,
+	const ral::frame::BlazingTableView & left, const ral::frame::BlazingTableView & right) {
+	auto context = make_context();
+	auto graph = std::make_shared<ral::cache::graph>();
+	auto join = std::make_unique<ral::batch::PartwiseJoin>(0, "LogicalJoin(condition=[" + condition + "], joinType=[inner])", context, graph);
+	join->setup_join_columns(left.names(), left.get_schema(), right.names(), right.get_schema());
+	return join;
+}
+
+}  // namespace
+
+// Joins a fact like table with a dimension like table ten times smaller, where every key of the left side has one match.
+static void BM_PartwiseJoin_join_set(benchmark::State & state) {
+	cudf::size_type num_rows = state.range(0);
+	auto left = make_random_table(num_rows, 2, num_rows / 10, 1);
+	auto right = make_random_table(num_rows / 10, 2, num_rows / 10, 2);
+	auto join = make_join_kernel("=($0, $2)", left->toBlazingTableView(), right->toBlazingTableView());
+
+	for (auto _ : state) {
+		auto result = join->join_set(left->toBlazingTableView(), right->toBlazingTableView());
+		cudaDeviceSynchronize();
+		benchmark::DoNotOptimize(result);
+	}
+	set_throughput(state, left->num_rows() + right->num_rows(), left->sizeInBytes() + right->sizeInBytes());
+}
+BENCHMARK(BM_PartwiseJoin_join_set)->RangeMultiplier(10)->Range(100000, 10000000)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// lineitem joined with orders on the order key, as in most TPC-H queries
+static void BM_PartwiseJoin_join_set_tpch(benchmark::State & state) {
+	auto lineitem = read_tpch_table("lineitem", {"l_orderkey", "l_quantity", "l_extendedprice"});
+	auto orders = read_tpch_table("orders", {"o_orderkey", "o_orderdate"});
+	if (lineitem == nullptr || orders == nullptr) {
+		state.SkipWithError("BLAZINGSQL_BENCHMARK_TPCH_DIR is not set");
+		return;
+	}
+	auto join = make_join_kernel("=($0, $3)", lineitem->toBlazingTableView(), orders->toBlazingTableView());
+
+	for (auto _ : state) {
+		auto result = join->join_set(lineitem->toBlazingTableView(), orders->toBlazingTableView());
+		cudaDeviceSynchronize();
+		benchmark::DoNotOptimize(result);
+	}
+	set_throughput(state, lineitem->num_rows() + orders->num_rows(), lineitem->sizeInBytes() + orders->sizeInBytes());
+}
+BENCHMARK(BM_PartwiseJoin_join_set_tpch)->Unit(benchmark::kMillisecond)->UseRealTime();
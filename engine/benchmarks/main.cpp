@@ -0,0 +1,25 @@
+#include <benchmark/benchmark.h>
+
+#include <bmr/initializer.h>
+#include <bmr/BlazingMemoryResource.h>
+#include "bmr/BufferProvider.h"
+
+// Initializes the memory resources the same way the unit tests do, and then runs the benchmarks.
+// Use --benchmark_out=<file> --benchmark_out_format=json to get the results in a machine-readable format.
+int main(int argc, char ** argv) {
+	benchmark::Initialize(&argc, argv);
+	if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+		return 1;
+	}
+
+	BlazingRMMInitialize("pool_memory_resource");
+	float host_memory_quota = 0.75; //default value
+	blazing_host_memory_resource::getInstance().initialize(host_memory_quota);
+	ral::memory::set_allocation_pools(4000000, 10, 4000000, 10, false, nullptr);
+
+	benchmark::RunSpecifiedBenchmarks();
+
+	ral::memory::empty_pools();
+	BlazingRMMFinalize();
+	return 0;
+}
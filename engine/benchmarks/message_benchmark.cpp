@@ -0,0 +1,55 @@
+#include "benchmark_utilities.h"
+
+#include "communication/messages/GPUComponentMessage.h"
+#include "communication/CommunicationInterface/serializer.hpp"
+
+using namespace ral::benchmarks;
+
+// Copies a batch into host buffers, as the message_sender does before sending it. The second argument indicates if pinned memory is used.
+static void BM_serialize_gpu_message_to_host_table(benchmark::State & state) {
+	auto table = make_mixed_table(state.range(0));
+	bool use_pinned = state.range(1) != 0;
+
+	for (auto _ : state) {
+		auto host_table = ral::communication::messages::serialize_gpu_message_to_host_table(table->toBlazingTableView(), use_pinned);
+		benchmark::DoNotOptimize(host_table);
+	}
+	set_throughput(state, table->num_rows(), table->sizeInBytes());
+}
+BENCHMARK(BM_serialize_gpu_message_to_host_table)
+	->Args({1000000, 0})->Args({1000000, 1})->Args({10000000, 0})->Args({10000000, 1})
+	->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// Copies the host buffers of a received batch back into GPU memory
+static void BM_deserialize_host_table_to_gpu(benchmark::State & state) {
+	auto table = make_mixed_table(state.range(0));
+	auto host_table = ral::communication::messages::serialize_gpu_message_to_host_table(table->toBlazingTableView(), state.range(1) != 0);
+
+	for (auto _ : state) {
+		auto result = host_table->get_gpu_table();
+		cudaDeviceSynchronize();
+		benchmark::DoNotOptimize(result);
+	}
+	set_throughput(state, table->num_rows(), table->sizeInBytes());
+}
+BENCHMARK(BM_deserialize_host_table_to_gpu)
+	->Args({1000000, 0})->Args({1000000, 1})->Args({10000000, 0})->Args({10000000, 1})
+	->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// Serializes into GPU buffers and deserializes them, which is the path of the messages that stay in the same node
+static void BM_gpu_raw_buffers_roundtrip(benchmark::State & state) {
+	auto table = make_mixed_table(state.range(0));
+
+	for (auto _ : state) {
+		auto containers = ral::communication::messages::serialize_gpu_message_to_gpu_containers(table->toBlazingTableView());
+		std::vector<rmm::device_buffer> raw_buffers;
+		for (auto & buffer : std::get<3>(containers)) {
+			raw_buffers.push_back(std::move(*buffer));
+		}
+		auto result = comm::deserialize_from_gpu_raw_buffers(std::get<2>(containers), raw_buffers);
+		cudaDeviceSynchronize();
+		benchmark::DoNotOptimize(result);
+	}
+	set_throughput(state, table->num_rows(), table->sizeInBytes());
+}
+BENCHMARK(BM_gpu_raw_buffers_roundtrip)->RangeMultiplier(10)->Range(100000, 10000000)->Unit(benchmark::kMillisecond)->UseRealTime();
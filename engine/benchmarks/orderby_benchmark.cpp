@@ -0,0 +1,44 @@
+#include "benchmark_utilities.h"
+
+#include "operators/OrderBy.h"
+
+using namespace ral::benchmarks;
+
+static void BM_OrderBy_sort(benchmark::State & state) {
+	cudf::size_type num_rows = state.range(0);
+	auto table = make_random_table(num_rows, 2, num_rows);
+	std::string query_part = "LogicalSort(sort0=[$0], sort1=[$1], dir0=[ASC], dir1=[DESC])";
+
+	for (auto _ : state) {
+		auto result = ral::operators::sort(table->toBlazingTableView(), query_part);
+		cudaDeviceSynchronize();
+		benchmark::DoNotOptimize(result);
+	}
+	set_throughput(state, table->num_rows(), table->sizeInBytes());
+}
+BENCHMARK(BM_OrderBy_sort)->RangeMultiplier(10)->Range(100000, 10000000)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// Merges already sorted partitions, as the MergeStreamKernel does. The second argument is the number of partitions.
+static void BM_OrderBy_merge(benchmark::State & state) {
+	cudf::size_type num_rows = state.range(0);
+	int num_partitions = state.range(1);
+	std::string query_part = "LogicalMerge(sort0=[$0], dir0=[ASC])";
+
+	std::vector<std::unique_ptr<ral::frame::BlazingTable>> partitions;
+	std::vector<ral::frame::BlazingTableView> partition_views;
+	std::size_t num_bytes = 0;
+	for (int i = 0; i < num_partitions; i++) {
+		auto partition = make_random_table(num_rows / num_partitions, 2, num_rows, i);
+		partitions.push_back(ral::operators::sort(partition->toBlazingTableView(), "LogicalSort(sort0=[$0], dir0=[ASC])"));
+		partition_views.push_back(partitions.back()->toBlazingTableView());
+		num_bytes += partitions.back()->sizeInBytes();
+	}
+
+	for (auto _ : state) {
+		auto result = ral::operators::merge(partition_views, query_part);
+		cudaDeviceSynchronize();
+		benchmark::DoNotOptimize(result);
+	}
+	set_throughput(state, num_rows, num_bytes);
+}
+BENCHMARK(BM_OrderBy_merge)->Args({1000000, 8})->Args({10000000, 8})->Args({10000000, 64})->Unit(benchmark::kMillisecond)->UseRealTime();
@@ -0,0 +1,40 @@
+#include "benchmark_utilities.h"
+
+#include "execution_kernels/LogicalProject.h"
+
+using namespace ral::benchmarks;
+
+// Simple arithmetic expressions, that are all evaluated in a single kernel call
+static void BM_evaluate_expressions(benchmark::State & state) {
+	cudf::size_type num_rows = state.range(0);
+	auto table = make_random_table(num_rows, 3, 1000000);
+	std::vector<std::string> expressions{"+($0, $1)", "*(-($0, $2), $1)", "+(*($0, 2), /($1, 3))"};
+
+	for (auto _ : state) {
+		auto result = ral::processor::evaluate_expressions(table->view(), expressions);
+		cudaDeviceSynchronize();
+		benchmark::DoNotOptimize(result);
+	}
+	set_throughput(state, table->num_rows(), table->sizeInBytes());
+}
+BENCHMARK(BM_evaluate_expressions)->RangeMultiplier(10)->Range(100000, 10000000)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// A whole projection, including the columns that are passed through and the string functions that are evaluated one by one
+static void BM_process_project(benchmark::State & state) {
+	cudf::size_type num_rows = state.range(0);
+	auto table = make_mixed_table(num_rows);
+	auto context = make_context();
+	std::string query_part = "LogicalProject(i=[$0], x=[*($0, $1)], s=[$2], u=[UPPER($2)])";
+
+	for (auto _ : state) {
+		state.PauseTiming();
+		auto input = std::make_unique<ral::frame::BlazingTable>(table->view(), table->names());
+		state.ResumeTiming();
+
+		auto result = ral::processor::process_project(std::move(input), query_part, context.get());
+		cudaDeviceSynchronize();
+		benchmark::DoNotOptimize(result);
+	}
+	set_throughput(state, table->num_rows(), table->sizeInBytes());
+}
+BENCHMARK(BM_process_project)->RangeMultiplier(10)->Range(100000, 10000000)->Unit(benchmark::kMillisecond)->UseRealTime();
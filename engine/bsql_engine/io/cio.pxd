@@ -19,6 +19,7 @@ from cudf._lib.table cimport table
 from libc.stdint cimport (  # noqa: E211
     uint8_t,
     uint32_t,
+    uint64_t,
     int64_t,
     int32_t,
     int16_t,
@@ -33,6 +34,8 @@ cdef extern from "../include/engine/errors.h":
     cdef void raiseGetFreeMemoryError()
     cdef void raiseResetMaxMemoryUsedError()
     cdef void raiseGetMaxMemoryUsedError()
+    cdef void raiseGetQueryMemoryUsageError()
+    cdef void raiseGetTransportMetricsError()
     cdef void raiseGetProductDetailsError()
     cdef void raisePerformPartitionError()
     cdef void raiseRunGenerateGraphError()
@@ -81,7 +84,8 @@ cdef extern from "../include/io/io.h" nogil:
         ARROW = 6,
         MYSQL = 7,
         POSTGRESQL = 8,
-        SQLITE = 9
+        SQLITE = 9,
+        ARROW_FLIGHT = 10
 
     cdef struct TableSchema:
         vector[BlazingTableView] blazingTableViews
@@ -129,6 +133,10 @@ cdef extern from "../include/io/io.h" nogil:
         set[string] values;
         type_id data_type;
 
+    cdef struct FileLocations:
+        long long size
+        map[string, long long] host_bytes
+
     pair[bool, string] registerFileSystemHDFS(HDFS hdfs, string root, string authority) except +raiseRegisterFileSystemHDFSError
     pair[bool, string] registerFileSystemGCS( GCS gcs, string root, string authority) except +raiseRegisterFileSystemGCSError
     pair[bool, string] registerFileSystemS3( S3 s3, string root, string authority) except +raiseRegisterFileSystemS3Error
@@ -136,6 +144,7 @@ cdef extern from "../include/io/io.h" nogil:
     TableSchema parseSchema(vector[string] files, string file_format_hint, vector[string] arg_keys, vector[string] arg_values, vector[pair[string,type_id]] types, bool ignore_missing_paths) except +raiseParseSchemaError
     unique_ptr[ResultSet] parseMetadata(vector[string] files, pair[int,int] offsets, TableSchema schema, string file_format_hint, vector[string] arg_keys, vector[string] arg_values) except +raiseParseSchemaError
     vector[FolderPartitionMetadata] inferFolderPartitionMetadata(string folder_path) except +raiseInferFolderPartitionMetadataError
+    vector[FileLocations] getFileLocations(vector[string] files) except +raiseParseSchemaError
 
 
 cdef extern from "../src/execution_kernels/LogicPrimitives.h" namespace "ral::frame":
@@ -161,11 +170,28 @@ cdef extern from "../src/execution_graph/graph.h" namespace "ral::cache":
             vector[bool] finished
             vector[int] batches_completed
 
+        cdef struct kernel_stats:
+            int32_t kernel_id
+            string kernel_name
+            vector[int32_t] input_kernel_ids
+            uint64_t wall_time_us
+            uint64_t task_time_us
+            uint64_t input_rows
+            uint64_t input_bytes
+            uint64_t output_rows
+            uint64_t output_bytes
+            uint64_t output_batches
+            uint64_t spill_bytes
+            uint64_t retries
+            uint64_t shuffle_bytes
+            bool finished
+
         cdef cppclass graph:
             shared_ptr[CacheMachine] get_kernel_output_cache(size_t kernel_id, string cache_id) except +
             void set_input_and_output_caches(shared_ptr[CacheMachine] input_cache, shared_ptr[CacheMachine] output_cache)
             bool query_is_complete()
             graph_progress get_progress()
+            vector[kernel_stats] get_kernel_stats()
 
 cdef extern from "../src/cache_machine/CacheMachine.h" namespace "ral::cache":
         cdef cppclass MetadataDictionary:
@@ -226,6 +252,12 @@ cdef extern from "../include/engine/engine.h" nogil:
         string runGeneratePhysicalGraph(uint32_t masterIndex, vector[string] worker_ids, int ctxToken, string query) except +raiseRunGenerateGraphError
         void startExecuteGraph(shared_ptr[graph], int ctx_token) nogil except +raiseRunExecuteGraphError
         unique_ptr[PartitionedResultSet] getExecuteGraphResult(shared_ptr[graph], int ctx_token) nogil except +raiseRunExecuteGraphError
+        unique_ptr[PartitionedResultSet] getExecuteGraphResultBatch(shared_ptr[graph], int ctx_token) nogil except +raiseRunExecuteGraphError
+        bool cancelQuery(int ctx_token) nogil except +raiseRunExecuteGraphError
+        int64_t openResultCursor(shared_ptr[graph], int ctx_token, int64_t ttl_ms) nogil except +raiseRunExecuteGraphError
+        unique_ptr[PartitionedResultSet] fetchResultCursor(int ctx_token, int64_t offset, int64_t num_rows) nogil except +raiseRunExecuteGraphError
+        bool closeResultCursor(int ctx_token) nogil except +raiseRunExecuteGraphError
+        void removeShuffleCheckpoint(string checkpoint_path) nogil except +raiseRunExecuteGraphError
 
         #unique_ptr[ResultSet] performPartition(int masterIndex, int ctxToken, BlazingTableView blazingTableView, vector[string] columnNames) except +raisePerformPartitionError
         unique_ptr[ResultSet] runSkipData(BlazingTableView metadata, vector[string] all_column_names, string query) nogil except +raiseRunSkipDataError
@@ -235,9 +267,18 @@ cdef extern from "../include/engine/engine.h" nogil:
 cdef extern from "../include/engine/initialize.h" nogil:
     cdef pair[pair[shared_ptr[CacheMachine], shared_ptr[CacheMachine] ], int] initialize(uint16_t ralId, string worker_id, string network_iface_name, int ralCommunicationPort, vector[NodeMetaDataUCP] workers_ucp_info, bool singleNode, map[string,string] config_options, string allocation_mode, size_t initial_pool_size, size_t maximum_pool_size,	bool enable_logging) nogil except +raiseInitializeError
     cdef void finalize(vector[int] ctx_tokens) nogil except +raiseFinalizeError
+    cdef void addNode(uint16_t ralId, string worker_id, string ip, int port) nogil except +raiseInitializeError
+    cdef void removeNode(string worker_id) nogil except +raiseInitializeError
+    cdef void uncacheTable(string table_name) nogil except +raiseInitializeError
     cdef size_t getFreeMemory() nogil except +raiseGetFreeMemoryError
     cdef void resetMaxMemoryUsed(int) nogil except +raiseResetMaxMemoryUsedError
     cdef size_t getMaxMemoryUsed() nogil except +raiseGetMaxMemoryUsedError
+    cdef pair[size_t, size_t] getQueryMemoryUsage(int ctx_token) nogil except +raiseGetQueryMemoryUsageError
+    cdef map[int, pair[size_t, size_t]] getKernelMemoryUsage(int ctx_token) nogil except +raiseGetQueryMemoryUsageError
+    cdef map[string, map[string, int64_t]] getTransportMetrics() nogil except +raiseGetTransportMetricsError
+    cdef map[string, vector[uint64_t]] getTransportSendLatencies() nogil except +raiseGetTransportMetricsError
+    cdef map[string, map[string, int64_t]] getAllocationPoolStats() nogil except +raiseGetFreeMemoryError
+    cdef string getRuntimeMetrics() nogil except +raiseGetTransportMetricsError
 
 cdef extern from "../include/engine/static.h" nogil:
     cdef map[string,string] getProductDetails() except +raiseGetProductDetailsError
@@ -94,6 +94,14 @@ class GetMaxMemoryUsedError(BlazingError):
     """GetMaxMemoryUsedError Error."""
 cdef public PyObject * GetMaxMemoryUsedError_ = <PyObject *>GetMaxMemoryUsedError
 
+class GetQueryMemoryUsageError(BlazingError):
+    """GetQueryMemoryUsageError Error."""
+cdef public PyObject * GetQueryMemoryUsageError_ = <PyObject *>GetQueryMemoryUsageError
+
+class GetTransportMetricsError(BlazingError):
+    """GetTransportMetricsError Error."""
+cdef public PyObject * GetTransportMetricsError_ = <PyObject *>GetTransportMetricsError
+
 class GetProductDetailsError(BlazingError):
     """GetProductDetails Error."""
 cdef public PyObject * GetProductDetailsError_ = <PyObject *>GetProductDetailsError
@@ -160,6 +168,14 @@ cdef unique_ptr[cio.PartitionedResultSet] getExecuteGraphResultPython(shared_ptr
     with nogil:
       return blaz_move(cio.getExecuteGraphResult(graph,ctx_token))
 
+cdef unique_ptr[cio.PartitionedResultSet] getExecuteGraphResultBatchPython(shared_ptr[cio.graph] graph, int ctx_token) except *:
+    with nogil:
+      return blaz_move(cio.getExecuteGraphResultBatch(graph,ctx_token))
+
+cdef unique_ptr[cio.PartitionedResultSet] fetchResultCursorPython(int ctx_token, int64_t offset, int64_t num_rows) except *:
+    with nogil:
+      return blaz_move(cio.fetchResultCursor(ctx_token, offset, num_rows))
+
 
 
 #cdef unique_ptr[cio.ResultSet] performPartitionPython(int masterIndex, int ctxToken, BlazingTableView blazingTableView, vector[string] column_names) nogil except +:
@@ -198,6 +214,30 @@ cdef void resetMaxMemoryUsedPython() nogil except *:
     with nogil:
         cio.resetMaxMemoryUsed(0)
 
+cdef pair[size_t, size_t] getQueryMemoryUsagePython(int ctx_token) nogil except *:
+    with nogil:
+        return cio.getQueryMemoryUsage(ctx_token)
+
+cdef map[int, pair[size_t, size_t]] getKernelMemoryUsagePython(int ctx_token) nogil except *:
+    with nogil:
+        return cio.getKernelMemoryUsage(ctx_token)
+
+cdef map[string, map[string, int64_t]] getTransportMetricsPython() nogil except *:
+    with nogil:
+        return cio.getTransportMetrics()
+
+cdef map[string, vector[uint64_t]] getTransportSendLatenciesPython() nogil except *:
+    with nogil:
+        return cio.getTransportSendLatencies()
+
+cdef map[string, map[string, int64_t]] getAllocationPoolStatsPython() nogil except *:
+    with nogil:
+        return cio.getAllocationPoolStats()
+
+cdef string getRuntimeMetricsPython() nogil except *:
+    with nogil:
+        return cio.getRuntimeMetrics()
+
 cdef map[string, string] getProductDetailsPython() nogil except *:
     with nogil:
         return cio.getProductDetails()
@@ -206,6 +246,10 @@ cdef vector[cio.FolderPartitionMetadata] inferFolderPartitionMetadataPython(stri
     with nogil:
         return cio.inferFolderPartitionMetadata(folder_path)
 
+cdef vector[cio.FileLocations] getFileLocationsPython(vector[string] files) nogil except *:
+    with nogil:
+        return cio.getFileLocations(files)
+
 cpdef pair[bool, string] registerFileSystemCaller(fs, root, authority):
     cdef HDFS hdfs
     cdef S3 s3
@@ -333,6 +377,22 @@ cpdef finalizeCaller(ctx_tokens: [int]):
         tks.push_back(ctx_token)
     finalizePython(tks)
 
+cpdef addNodeCaller(int ralId, worker_id, ip, int port):
+    cdef string c_worker_id = worker_id
+    cdef string c_ip = ip
+    with nogil:
+        cio.addNode(ralId, c_worker_id, c_ip, port)
+
+cpdef removeNodeCaller(worker_id):
+    cdef string c_worker_id = worker_id
+    with nogil:
+        cio.removeNode(c_worker_id)
+
+cpdef uncacheTableCaller(table_name):
+    cdef string c_table_name = table_name
+    with nogil:
+        cio.uncacheTable(c_table_name)
+
 cpdef getFreeMemoryCaller():
     return getFreeMemoryPython()
 
@@ -342,6 +402,42 @@ cpdef getMaxMemoryUsedCaller():
 cpdef resetMaxMemoryUsedCaller():
     resetMaxMemoryUsedPython()
 
+cpdef getQueryMemoryUsageCaller(int ctx_token):
+    cdef pair[size_t, size_t] usage = getQueryMemoryUsagePython(ctx_token)
+    return {"current": usage.first, "peak": usage.second}
+
+cpdef getKernelMemoryUsageCaller(int ctx_token):
+    cdef map[int, pair[size_t, size_t]] usages = getKernelMemoryUsagePython(ctx_token)
+    kernel_usages = {}
+    for kernel_usage in usages:
+        kernel_usages[kernel_usage.first] = {"current": kernel_usage.second.first, "peak": kernel_usage.second.second}
+    return kernel_usages
+
+cpdef getTransportMetricsCaller():
+    cdef map[string, map[string, int64_t]] metrics = getTransportMetricsPython()
+    cdef map[string, vector[uint64_t]] latencies = getTransportSendLatenciesPython()
+    peers_metrics = {}
+    for peer in metrics:
+        peer_metrics = {}
+        for metric in peer.second:
+            peer_metrics[metric.first.decode('utf-8')] = metric.second
+        peer_metrics["send_latency_histogram"] = list(latencies[peer.first])
+        peers_metrics[peer.first.decode('utf-8')] = peer_metrics
+    return peers_metrics
+
+cpdef getAllocationPoolStatsCaller():
+    cdef map[string, map[string, int64_t]] stats = getAllocationPoolStatsPython()
+    pools_stats = {}
+    for pool in stats:
+        pool_stats = {}
+        for stat in pool.second:
+            pool_stats[stat.first.decode('utf-8')] = stat.second
+        pools_stats[pool.first.decode('utf-8')] = pool_stats
+    return pools_stats
+
+cpdef getRuntimeMetricsCaller():
+    return getRuntimeMetricsPython().decode('utf-8')
+
 cpdef getProductDetailsCaller():
     my_map = getProductDetailsPython()
     cdef map[string,string].iterator it = my_map.begin()
@@ -456,6 +552,26 @@ cpdef inferFolderPartitionMetadataCaller(folder_path):
 
     return return_array
 
+cpdef getFileLocationsCaller(fileList):
+    """
+    Get the size of every file, and the bytes of it that every host has a
+    replica of (only known for HDFS, empty for the rest).
+    """
+    cdef vector[string] files
+    for file in fileList:
+        files.push_back(str.encode(file))
+
+    locations = getFileLocationsPython(files)
+
+    return_array = []
+    for location in locations:
+        host_bytes = {}
+        for item in location.host_bytes:
+            host_bytes[item.first.decode('utf-8')] = item.second
+        return_array.append({'size': location.size, 'host_bytes': host_bytes})
+
+    return return_array
+
 
 cdef class PyBlazingGraph:
     cdef shared_ptr[cio.graph] ptr
@@ -474,6 +590,9 @@ cdef class PyBlazingGraph:
     cpdef get_progress(self):
         return deref(self.ptr).get_progress()
 
+    cpdef get_kernel_stats(self):
+        return deref(self.ptr).get_kernel_stats()
+
 cpdef runGeneratePhysicalGraphCaller(uint32_t masterIndex, worker_ids, int ctxToken, queryPy):
     cdef string query
     query = str.encode(queryPy)
@@ -602,6 +721,12 @@ cpdef startExecuteGraphCaller(PyBlazingGraph graph, int ctx_token):
     cdef shared_ptr[cio.graph] ptr = graph.ptr
     startExecuteGraphPython(blaz_move(ptr),ctx_token)
 
+cpdef cancelQueryCaller(int ctx_token):
+    cdef bool cancelled
+    with nogil:
+        cancelled = cio.cancelQuery(ctx_token)
+    return cancelled
+
 cpdef getExecuteGraphResultCaller(PyBlazingGraph graph, int ctx_token, bool is_single_node):
 
     cdef shared_ptr[cio.graph] ptr = graph.ptr
@@ -621,6 +746,57 @@ cpdef getExecuteGraphResultCaller(PyBlazingGraph graph, int ctx_token, bool is_s
             dfs.append(cudf.DataFrame(CudfXxTable.from_unique_ptr(blaz_move(dereference(resultSet).cudfTables[i]), decoded_names)._data))
         return dfs
 
+cpdef getExecuteGraphResultBatchCaller(PyBlazingGraph graph, int ctx_token):
+    """
+    The next batch of the result of a query run with RETURN_ITERATOR as a
+    cudf.DataFrame, or None once the query is finished.
+    """
+    cdef shared_ptr[cio.graph] ptr = graph.ptr
+    resultSet = blaz_move(getExecuteGraphResultBatchPython(ptr,ctx_token))
+    if dereference(resultSet).cudfTables.size() == 0:
+        return None
+
+    names = dereference(resultSet).names
+    decoded_names = []
+    for i in range(names.size()):
+        decoded_names.append(names[i].decode('utf-8'))
+    return cudf.DataFrame(CudfXxTable.from_unique_ptr(blaz_move(dereference(resultSet).cudfTables[0]), decoded_names)._data)
+
+cpdef openResultCursorCaller(PyBlazingGraph graph, int ctx_token, int64_t ttl_ms):
+    """
+    Keeps the result of the query of this node as a cursor and returns its
+    number of rows.
+    """
+    cdef shared_ptr[cio.graph] ptr = graph.ptr
+    cdef int64_t num_rows
+    graph = None
+    with nogil:
+        num_rows = cio.openResultCursor(blaz_move(ptr), ctx_token, ttl_ms)
+    return num_rows
+
+cpdef fetchResultCursorCaller(int ctx_token, int64_t offset, int64_t num_rows):
+    """
+    The rows [offset, offset + num_rows) of the result that this node kept for
+    the cursor as a cudf.DataFrame.
+    """
+    resultSet = blaz_move(fetchResultCursorPython(ctx_token, offset, num_rows))
+    names = dereference(resultSet).names
+    decoded_names = []
+    for i in range(names.size()):
+        decoded_names.append(names[i].decode('utf-8'))
+    return cudf.DataFrame(CudfXxTable.from_unique_ptr(blaz_move(dereference(resultSet).cudfTables[0]), decoded_names)._data)
+
+cpdef closeResultCursorCaller(int ctx_token):
+    cdef bool closed
+    with nogil:
+        closed = cio.closeResultCursor(ctx_token)
+    return closed
+
+cpdef removeShuffleCheckpointCaller(checkpoint_path):
+    cdef string checkpoint_path_cpp = str.encode(checkpoint_path)
+    with nogil:
+        cio.removeShuffleCheckpoint(checkpoint_path_cpp)
+
 cpdef runSkipDataCaller(table, queryPy):
     cdef string query
     cdef BlazingTableView metadata
@@ -669,7 +845,14 @@ cpdef getTableScanInfoCaller(logicalPlan):
 
 
 cpdef np_to_cudf_types_int(dtype):
+    # the nested columns are not numpy types
+    if isinstance(dtype, cudf.ListDtype):
+        return <underlying_type_t_type_id> (type_id.LIST)
+    if isinstance(dtype, cudf.StructDtype):
+        return <underlying_type_t_type_id> (type_id.STRUCT)
     return <underlying_type_t_type_id> ( np_to_cudf_types[dtype])
 
 cpdef cudf_type_int_to_np_types(type_int):
+    if type_int == <underlying_type_t_type_id> (type_id.LIST) or type_int == <underlying_type_t_type_id> (type_id.STRUCT):
+        return np.dtype("object")
     return cudf_to_np_types[<underlying_type_t_type_id> (type_int)]
@@ -33,6 +33,41 @@ std::shared_ptr<ral::cache::graph> runGenerateGraph(uint32_t masterIndex,
 void startExecuteGraph(std::shared_ptr<ral::cache::graph> graph, int ctx_token);
 std::unique_ptr<PartitionedResultSet> getExecuteGraphResult(std::shared_ptr<ral::cache::graph> graph, int ctx_token);
 
+/**
+ * @brief Takes the next batch of the result of a query run with RETURN_ITERATOR, waiting for it, see OutputKernel::next_batch.
+ * @return a single table, or no tables once all of them were taken and the query is finished. It throws the errors of the query then.
+ */
+std::unique_ptr<PartitionedResultSet> getExecuteGraphResultBatch(std::shared_ptr<ral::cache::graph> graph, int ctx_token);
+
+/**
+ * @brief Keeps the result of the query of this node as a cursor, see ral::cache::result_cursors, and finishes the query.
+ * @return the number of rows of the result of this node
+ */
+int64_t openResultCursor(std::shared_ptr<ral::cache::graph> graph, int32_t ctx_token, int64_t ttl_ms);
+
+/**
+ * @brief Takes the rows [offset, offset + num_rows) of the result that this node kept for the cursor of the query.
+ */
+std::unique_ptr<PartitionedResultSet> fetchResultCursor(int32_t ctx_token, int64_t offset, int64_t num_rows);
+
+/**
+ * @brief Releases the result that this node kept for the cursor of the query.
+ * @return false if this node did not have it, because it expired
+ */
+bool closeResultCursor(int32_t ctx_token);
+
+/**
+ * @brief Cancels the query of this node, see graph::cancel. Its getExecuteGraphResult throws once its kernels finish.
+ * @return false if the query is not running in this node
+ */
+bool cancelQuery(int ctx_token);
+
+/**
+ * @brief Removes the shuffle checkpoint of a query once it succeeded, see ral::distribution::shuffle_checkpoint. Any
+ * node can remove it, since it is in a folder that all of them see.
+ */
+void removeShuffleCheckpoint(std::string checkpoint_path);
+
 TableScanInfo getTableScanInfo(std::string logicalPlan);
 
 std::unique_ptr<ResultSet> runSkipData(
@@ -7,6 +7,8 @@ void raiseRunExecuteGraphError();
 void raiseGetFreeMemoryError();
 void raiseResetMaxMemoryUsedError();
 void raiseGetMaxMemoryUsedError();
+void raiseGetQueryMemoryUsageError();
+void raiseGetTransportMetricsError();
 void raiseRunSkipDataError();
 void raiseParseSchemaError();
 void raiseRegisterFileSystemHDFSError();
@@ -22,9 +22,31 @@ std::pair<std::pair<std::shared_ptr<ral::cache::CacheMachine>,std::shared_ptr<ra
 
 void finalize(std::vector<int32_t> ctx_tokens);
 
+/**
+ * @brief Lets this node send messages to and receive them from a node that joined the cluster after it was initialized.
+ * The queries that start after this can include the node. Only supported with the tcp protocol.
+ */
+void addNode(uint16_t ralId, std::string worker_id, std::string ip, int port);
+
+/**
+ * @brief Forgets a node that left the cluster, and closes the connections to it.
+ */
+void removeNode(std::string worker_id);
+
+/**
+ * @brief Drops the batches of a table given to cache_table from the table_cache of this node.
+ */
+void uncacheTable(std::string table_name);
+
 size_t getFreeMemory();
 void resetMaxMemoryUsed(int to = 0);
 size_t getMaxMemoryUsed();
+std::pair<size_t, size_t> getQueryMemoryUsage(int32_t ctx_token);
+std::map<int32_t, std::pair<size_t, size_t>> getKernelMemoryUsage(int32_t ctx_token);
+std::map<std::string, std::map<std::string, int64_t>> getTransportMetrics();
+std::map<std::string, std::vector<uint64_t>> getTransportSendLatencies();
+std::map<std::string, std::map<std::string, int64_t>> getAllocationPoolStats();
+std::string getRuntimeMetrics();
 
 extern "C" {
 
@@ -82,6 +82,11 @@ struct FolderPartitionMetadata {
 	cudf::type_id data_type;
 };
 
+struct FileLocations {
+	long long size;
+	std::map<std::string, long long> host_bytes; // the bytes of the file that each host has, empty if not known
+};
+
 TableSchema parseSchema(std::vector<std::string> files,
 	std::string file_format_hint,
 	std::vector<std::string> arg_keys,
@@ -103,6 +108,8 @@ std::pair<bool, std::string> registerFileSystemLocal(std::string root, std::stri
 
 std::vector<FolderPartitionMetadata> inferFolderPartitionMetadata(std::string folder_path);
 
+std::vector<FileLocations> getFileLocations(std::vector<std::string> files);
+
 extern "C" {
 
 std::pair<TableSchema, error_code_t> parseSchema_C(std::vector<std::string> files,
@@ -3,27 +3,39 @@
 #include <cudf/scalar/scalar_device_view.cuh>
 #include <cudf/table/table_view.hpp>
 #include <cudf/table/table_device_view.cuh>
+#include <atomic>
 #include <stack>
 #include <map>
+#include <mutex>
+#include <set>
 #include <regex>
-#include <random>
 
 #include "interpreter_ops.cuh"
+#include "interpreter_plan_cache.h"
+#include "bmr/ScratchArena.h"
 #include "parser/CalciteExpressionParsing.h"
+#include "utilities/RandomGenerator.h"
 #include "utilities/error.hpp"
 #include <curand_kernel.h>
 
 namespace interops {
 namespace detail {
 
+// copies the vector to a buffer in the device, for the arrays of the operation
+template <typename T>
+rmm::device_buffer to_device_buffer(const std::vector<T> & values, cudaStream_t stream, rmm::mr::device_memory_resource * mr) {
+	return rmm::device_buffer(values.data(), values.size() * sizeof(T), rmm::cuda_stream_view{stream}, mr);
+}
+
 struct allocate_device_scalar {
 
 	template <typename T, std::enable_if_t<not cudf::is_compound<T>()> * = nullptr>
-	rmm::device_buffer operator()(cudf::scalar & s, cudaStream_t stream = 0) {
+	rmm::device_buffer operator()(cudf::scalar & s, cudaStream_t stream = 0,
+		rmm::mr::device_memory_resource * mr = rmm::mr::get_current_device_resource()) {
 		using ScalarType = cudf::scalar_type_t<T>;
 		using ScalarDeviceType = cudf::scalar_device_type_t<T>;
 
-		rmm::device_buffer ret(sizeof(ScalarDeviceType), stream);
+		rmm::device_buffer ret(sizeof(ScalarDeviceType), stream, mr);
 
 		auto typed_scalar_ptr = static_cast<ScalarType *>(&s);
 		ScalarDeviceType h_scalar{typed_scalar_ptr->type(), typed_scalar_ptr->data(), typed_scalar_ptr->validity_data()};
@@ -34,11 +46,12 @@ struct allocate_device_scalar {
 	}
 
 	template <typename T, std::enable_if_t<std::is_same<T, cudf::string_view>::value> * = nullptr>
-	rmm::device_buffer operator()(cudf::scalar & s, cudaStream_t stream = 0) {
+	rmm::device_buffer operator()(cudf::scalar & s, cudaStream_t stream = 0,
+		rmm::mr::device_memory_resource * mr = rmm::mr::get_current_device_resource()) {
 		using ScalarType = cudf::scalar_type_t<T>;
 		using ScalarDeviceType = cudf::scalar_device_type_t<T>;
 
-		rmm::device_buffer ret(sizeof(ScalarDeviceType), stream);
+		rmm::device_buffer ret(sizeof(ScalarDeviceType), stream, mr);
 
 		auto typed_scalar_ptr = static_cast<ScalarType *>(&s);
 		ScalarDeviceType h_scalar{typed_scalar_ptr->type(), typed_scalar_ptr->data(), typed_scalar_ptr->validity_data(), typed_scalar_ptr->size()};
@@ -49,224 +62,356 @@ struct allocate_device_scalar {
 	}
 
 	template <typename T, std::enable_if_t<std::is_same<T, cudf::dictionary32>::value> * = nullptr>
-	rmm::device_buffer operator()(cudf::scalar & s, cudaStream_t stream = 0) {
+	rmm::device_buffer operator()(cudf::scalar & s, cudaStream_t stream = 0,
+		rmm::mr::device_memory_resource * mr = rmm::mr::get_current_device_resource()) {
 		RAL_FAIL("Dictionary not yet supported");
 		return rmm::device_buffer{};
 	}
 
 	template <typename T, std::enable_if_t<std::is_same<T, cudf::list_view>::value> * = nullptr>
-	rmm::device_buffer operator()(cudf::scalar & s, cudaStream_t stream = 0) {
+	rmm::device_buffer operator()(cudf::scalar & s, cudaStream_t stream = 0,
+		rmm::mr::device_memory_resource * mr = rmm::mr::get_current_device_resource()) {
 		RAL_FAIL("List not yet supported");
 		return rmm::device_buffer{};
 	}
 
 	template <typename T, std::enable_if_t<std::is_same<T, cudf::struct_view>::value> * = nullptr>
-	rmm::device_buffer operator()(cudf::scalar & s, cudaStream_t stream = 0) {
+	rmm::device_buffer operator()(cudf::scalar & s, cudaStream_t stream = 0,
+		rmm::mr::device_memory_resource * mr = rmm::mr::get_current_device_resource()) {
 		RAL_FAIL("Struct not yet supported");
 		return rmm::device_buffer{};
 	}
 };
 
-template <int SIZE, int REGISTER_SIZE>
-int calculated_shared_memory(int num_threads_per_block) {
-	return SIZE * num_threads_per_block * REGISTER_SIZE;
+// the positions of the plan are kept for every thread of a block in the shared memory of the kernel
+std::size_t shared_memory_per_block(int num_positions, int block_size) {
+	return static_cast<std::size_t>(num_positions) * block_size * sizeof(int64_t);
+}
+
+/**
+ * @brief How the kernel is launched for a plan with a number of positions, from the occupancy model of CUDA: the block
+ * size that gets the most threads running on an SM with the shared memory the positions of every thread take.
+ */
+struct launch_config {
+	int grid_size = 0;
+	int block_size = 0;
+	std::size_t shared_memory_bytes = 0;
+	double occupancy = 0; ///< The fraction of the threads an SM can run that it runs with this config
+};
+
+std::mutex launch_configs_mutex;
+std::map<std::pair<int, int>, launch_config> launch_configs; // by device and number of positions
+std::atomic<double> min_occupancy{0.25};
+
+launch_config get_launch_config(int num_positions) {
+	int device_id = 0;
+	CUDA_TRY(cudaGetDevice(&device_id));
+	std::lock_guard<std::mutex> lock(launch_configs_mutex);
+	auto it = launch_configs.find({device_id, num_positions});
+	if (it != launch_configs.end()) {
+		return it->second;
+	}
+
+	launch_config config;
+	CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(&config.grid_size, &config.block_size, transformKernel,
+		[num_positions](int block_size) { return shared_memory_per_block(num_positions, block_size); }, 0));
+	config.shared_memory_bytes = shared_memory_per_block(num_positions, config.block_size);
+	int active_blocks = 0;
+	CUDA_TRY(cudaOccupancyMaxActiveBlocksPerMultiprocessor(&active_blocks, transformKernel, config.block_size, config.shared_memory_bytes));
+	int max_threads_per_sm = 0;
+	CUDA_TRY(cudaDeviceGetAttribute(&max_threads_per_sm, cudaDevAttrMaxThreadsPerMultiProcessor, device_id));
+	config.occupancy = max_threads_per_sm > 0 ? static_cast<double>(active_blocks * config.block_size) / max_threads_per_sm : 1.0;
+	launch_configs[{device_id, num_positions}] = config;
+	return config;
+}
+
+// the most positions a launch can have and still run with the minimum occupancy
+int get_max_positions_for_occupancy(double occupancy) {
+	for (int num_positions = 64; num_positions > 1; num_positions--) {
+		if (get_launch_config(num_positions).occupancy >= occupancy) {
+			return num_positions;
+		}
+	}
+	return 1;
+}
+
+/**
+ * @brief A launch of the kernel with some of the outputs of a plan, the operations they need and the columns they
+ * read, with their positions renumbered from 0 so that it takes as few of them as it can.
+ */
+struct interpreter_launch {
+	std::vector<cudf::size_type> input_columns;
+	std::vector<cudf::size_type> output_columns;
+	std::vector<std::size_t> operations;
+	std::vector<column_index_type> left_inputs;
+	std::vector<column_index_type> right_inputs;
+	std::vector<column_index_type> outputs;
+	std::vector<column_index_type> final_output_positions;
+	std::vector<operator_type> operators;
+	int num_positions = 0;
+};
+
+/**
+ * @brief How a plan is launched: in one launch, or in several ones when it has so many positions that the kernel
+ * would run with less than the minimum occupancy. It only depends on the encoded plan, so it is cached by it.
+ */
+struct interpreter_launch_plan {
+	int num_positions = 0;
+	std::vector<interpreter_launch> launches; ///< Empty when the whole plan is launched at once
+};
+
+class interpreter_launch_plan_cache : public expression_cache<interpreter_launch_plan> {
+public:
+	static interpreter_launch_plan_cache & get_instance() {
+		static interpreter_launch_plan_cache instance;
+		return instance;
+	}
+
+private:
+	interpreter_launch_plan_cache() = default;
+};
+
+template <typename T>
+void append_to_key(std::string & key, const std::vector<T> & values) {
+	key += "|";
+	for (const T & value : values) {
+		key += std::to_string(static_cast<int64_t>(value)) + ",";
+	}
+}
+
+interpreter_launch make_launch(cudf::size_type num_columns,
+	const std::vector<column_index_type> & left_inputs,
+	const std::vector<column_index_type> & right_inputs,
+	const std::vector<column_index_type> & outputs,
+	const std::vector<column_index_type> & final_output_positions,
+	const std::vector<operator_type> & operators,
+	const std::vector<cudf::size_type> & output_columns) {
+	interpreter_launch launch;
+	launch.output_columns = output_columns;
+
+	// the positions are reused by the operations of the next expressions, so the operations that the outputs need are
+	// found from the last one, with the positions that are read before they are written
+	std::set<column_index_type> live_positions;
+	for (cudf::size_type output_column : output_columns) {
+		live_positions.insert(final_output_positions[output_column]);
+	}
+	std::vector<bool> needed(operators.size(), false);
+	for (std::size_t i = operators.size(); i-- > 0;) {
+		if (live_positions.erase(outputs[i]) > 0) {
+			needed[i] = true;
+			for (column_index_type input : {left_inputs[i], right_inputs[i]}) {
+				if (input >= 0) {
+					live_positions.insert(input);
+				}
+			}
+		}
+	}
+
+	std::map<column_index_type, column_index_type> positions;
+	for (column_index_type position : live_positions) {
+		if (position < num_columns) {
+			positions[position] = launch.input_columns.size();
+			launch.input_columns.push_back(position);
+		}
+	}
+	auto map_position = [&](column_index_type position) {
+		if (position < 0) {
+			return position;
+		}
+		auto it = positions.find(position);
+		if (it == positions.end()) {
+			it = positions.emplace(position, static_cast<column_index_type>(positions.size())).first;
+		}
+		return it->second;
+	};
+	for (std::size_t i = 0; i < operators.size(); i++) {
+		if (needed[i]) {
+			launch.operations.push_back(i);
+			launch.left_inputs.push_back(map_position(left_inputs[i]));
+			launch.right_inputs.push_back(map_position(right_inputs[i]));
+			launch.outputs.push_back(map_position(outputs[i]));
+			launch.operators.push_back(operators[i]);
+		}
+	}
+	for (cudf::size_type output_column : output_columns) {
+		launch.final_output_positions.push_back(map_position(final_output_positions[output_column]));
+	}
+	launch.num_positions = std::max<int>(positions.size(), 1);
+	return launch;
 }
 
-// TODO: we dont know if this is fast or not we coudl store this in a pre computed map
-void calculate_grid(int * min_grid_size, int * block_size, column_index_type max_output) {
-	if(max_output == 1) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<1, 8>, 0));
-	} else if(max_output == 2) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<2, 8>, 0));
-	} else if(max_output == 3) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<3, 8>, 0));
-	} else if(max_output == 4) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<4, 8>, 0));
-	} else if(max_output == 5) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<5, 8>, 0));
-	} else if(max_output == 6) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<6, 8>, 0));
-	} else if(max_output == 7) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<7, 8>, 0));
-	} else if(max_output == 8) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<8, 8>, 0));
-	} else if(max_output == 9) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<9, 8>, 0));
-	} else if(max_output == 10) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<10, 8>, 0));
-	} else if(max_output == 11) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<11, 8>, 0));
-	} else if(max_output == 12) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<12, 8>, 0));
-	} else if(max_output == 13) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<13, 8>, 0));
-	} else if(max_output == 14) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<14, 8>, 0));
-	} else if(max_output == 15) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<15, 8>, 0));
-	} else if(max_output == 16) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<16, 8>, 0));
-	} else if(max_output == 17) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<17, 8>, 0));
-	} else if(max_output == 18) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<18, 8>, 0));
-	} else if(max_output == 19) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<19, 8>, 0));
-	} else if(max_output == 20) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<20, 8>, 0));
-	} else if(max_output == 21) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<21, 8>, 0));
-	} else if(max_output == 22) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<22, 8>, 0));
-	} else if(max_output == 23) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<23, 8>, 0));
-	} else if(max_output == 24) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<24, 8>, 0));
-	} else if(max_output == 25) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<25, 8>, 0));
-	} else if(max_output == 26) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<26, 8>, 0));
-	} else if(max_output == 27) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<27, 8>, 0));
-	} else if(max_output == 28) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<28, 8>, 0));
-	} else if(max_output == 29) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<29, 8>, 0));
-	} else if(max_output == 30) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<30, 8>, 0));
-	} else if(max_output == 31) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<31, 8>, 0));
-	} else if(max_output == 32) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<32, 8>, 0));
-	} else if(max_output == 33) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<33, 8>, 0));
-	} else if(max_output == 34) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<34, 8>, 0));
-	} else if(max_output == 35) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<35, 8>, 0));
-	} else if(max_output == 36) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<36, 8>, 0));
-	} else if(max_output == 37) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<37, 8>, 0));
-	} else if(max_output == 38) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<38, 8>, 0));
-	} else if(max_output == 39) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<39, 8>, 0));
-	} else if(max_output == 40) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<40, 8>, 0));
-	} else if(max_output == 41) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<41, 8>, 0));
-	} else if(max_output == 42) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<42, 8>, 0));
-	} else if(max_output == 43) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<43, 8>, 0));
-	} else if(max_output == 44) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<44, 8>, 0));
-	} else if(max_output == 45) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<45, 8>, 0));
-	} else if(max_output == 46) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<46, 8>, 0));
-	} else if(max_output == 47) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<47, 8>, 0));
-	} else if(max_output == 48) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<48, 8>, 0));
-	} else if(max_output == 49) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<49, 8>, 0));
-	} else if(max_output == 50) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<50, 8>, 0));
-	} else if(max_output == 51) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<51, 8>, 0));
-	} else if(max_output == 52) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<52, 8>, 0));
-	} else if(max_output == 53) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<53, 8>, 0));
-	} else if(max_output == 54) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<54, 8>, 0));
-	} else if(max_output == 55) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<55, 8>, 0));
-	} else if(max_output == 56) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<56, 8>, 0));
-	} else if(max_output == 57) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<57, 8>, 0));
-	} else if(max_output == 58) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<58, 8>, 0));
-	} else if(max_output == 59) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<59, 8>, 0));
-	} else if(max_output == 60) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<60, 8>, 0));
-	} else if(max_output == 61) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<61, 8>, 0));
-	} else if(max_output == 62) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<62, 8>, 0));
-	} else if(max_output == 63) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<63, 8>, 0));
-	} else if(max_output == 64) {
-		CUDA_TRY(cudaOccupancyMaxPotentialBlockSizeVariableSMem(
-			min_grid_size, block_size, transformKernel, calculated_shared_memory<64, 8>, 0));
+std::shared_ptr<const interpreter_launch_plan> get_launch_plan(cudf::size_type num_columns,
+	const std::vector<column_index_type> & left_inputs,
+	const std::vector<column_index_type> & right_inputs,
+	const std::vector<column_index_type> & outputs,
+	const std::vector<column_index_type> & final_output_positions,
+	const std::vector<operator_type> & operators,
+	int num_positions) {
+	double occupancy = min_occupancy.load();
+	std::string key = std::to_string(num_columns) + "|" + std::to_string(occupancy);
+	append_to_key(key, left_inputs);
+	append_to_key(key, right_inputs);
+	append_to_key(key, outputs);
+	append_to_key(key, final_output_positions);
+	append_to_key(key, operators);
+	if (std::shared_ptr<const interpreter_launch_plan> cached_plan = interpreter_launch_plan_cache::get_instance().get(key)) {
+		return cached_plan;
+	}
+
+	auto plan = std::make_shared<interpreter_launch_plan>();
+	plan->num_positions = num_positions;
+	if (occupancy > 0 && final_output_positions.size() > 1 && get_launch_config(num_positions).occupancy < occupancy) {
+		// the outputs are added to a launch until it would have more positions than the budget of the minimum occupancy
+		int max_positions = get_max_positions_for_occupancy(occupancy);
+		std::vector<cudf::size_type> output_columns;
+		for (cudf::size_type output_column = 0; output_column < static_cast<cudf::size_type>(final_output_positions.size()); output_column++) {
+			std::vector<cudf::size_type> candidate_columns = output_columns;
+			candidate_columns.push_back(output_column);
+			interpreter_launch candidate = make_launch(num_columns, left_inputs, right_inputs, outputs, final_output_positions, operators, candidate_columns);
+			if (!output_columns.empty() && candidate.num_positions > max_positions) {
+				plan->launches.push_back(make_launch(num_columns, left_inputs, right_inputs, outputs, final_output_positions, operators, output_columns));
+				output_columns = {output_column};
+			} else {
+				output_columns = std::move(candidate_columns);
+			}
+		}
+		if (!plan->launches.empty()) {
+			plan->launches.push_back(make_launch(num_columns, left_inputs, right_inputs, outputs, final_output_positions, operators, output_columns));
+		}
 	}
+	interpreter_launch_plan_cache::get_instance().put(key, plan);
+	return plan;
+}
+
+void launch_interpreter(cudf::mutable_table_view & out_table,
+	const cudf::table_view & table,
+	const std::vector<column_index_type> & left_inputs,
+	const std::vector<column_index_type> & right_inputs,
+	const std::vector<column_index_type> & outputs,
+	const std::vector<column_index_type> & final_output_positions,
+	const std::vector<operator_type> & operators,
+	const std::vector<cudf::scalar *> & left_scalars,
+	const std::vector<cudf::scalar *> & right_scalars,
+	cudf::size_type operation_num_rows,
+	const launch_config & config) {
+	cudaStream_t stream = 0;
+	int min_grid_size = config.grid_size;
+	int block_size = config.block_size;
+
+	// the buffers of the operation only live until it is done, so they come from the scratch arena of the task
+	rmm::mr::device_memory_resource * scratch_mr = ral::memory::get_task_scratch_resource();
+
+	size_t temp_valids_in_size = min_grid_size * block_size * table.num_columns() * sizeof(cudf::bitmask_type);
+	size_t temp_valids_out_size = min_grid_size * block_size * final_output_positions.size() * sizeof(cudf::bitmask_type);
+	rmm::device_buffer temp_device_valids_in_buffer(temp_valids_in_size, stream, scratch_mr);
+	rmm::device_buffer temp_device_valids_out_buffer(temp_valids_out_size, stream, scratch_mr);
+
+	// device table views
+	auto device_table_view = cudf::table_device_view::create(table, stream);
+	auto device_out_table_view = cudf::mutable_table_device_view::create(out_table, stream);
+
+	// device scalar views
+	std::vector<rmm::device_buffer> left_device_scalars_ptrs;
+	std::vector<cudf::detail::scalar_device_view_base *> left_device_scalars_raw;
+	std::vector<rmm::device_buffer> right_device_scalars_ptrs;
+	std::vector<cudf::detail::scalar_device_view_base *> right_device_scalars_raw;
+	for (size_t i = 0; i < left_scalars.size(); i++) {
+		left_device_scalars_ptrs.push_back(left_scalars[i] ? std::move(cudf::type_dispatcher(left_scalars[i]->type(), allocate_device_scalar{}, *(left_scalars[i]), stream, scratch_mr)) : rmm::device_buffer{});
+		left_device_scalars_raw.push_back(static_cast<cudf::detail::scalar_device_view_base *>(left_device_scalars_ptrs.back().data()));
+
+		right_device_scalars_ptrs.push_back(right_scalars[i] ? std::move(cudf::type_dispatcher(right_scalars[i]->type(), allocate_device_scalar{}, *(right_scalars[i]), stream, scratch_mr)) : rmm::device_buffer{});
+		right_device_scalars_raw.push_back(static_cast<cudf::detail::scalar_device_view_base *>(right_device_scalars_ptrs.back().data()));
+	}
+	rmm::device_buffer left_device_scalars = to_device_buffer(left_device_scalars_raw, stream, scratch_mr);
+	rmm::device_buffer right_device_scalars = to_device_buffer(right_device_scalars_raw, stream, scratch_mr);
+
+
+
+	// device left, right and output types
+	size_t num_operations = left_inputs.size();
+	std::vector<cudf::type_id> left_input_types_vec(num_operations);
+	std::vector<cudf::type_id> right_input_types_vec(num_operations);
+	std::vector<cudf::type_id> output_types_vec(num_operations);
+	std::map<column_index_type, cudf::type_id> output_map_type;
+	for(size_t i = 0; i < num_operations; i++) {
+		column_index_type left_index = left_inputs[i];
+		column_index_type right_index = right_inputs[i];
+		column_index_type output_index = outputs[i];
+
+		if(left_index >= 0 && left_index < table.num_columns()) {
+			left_input_types_vec[i] = table.column(left_index).type().id();
+		} else if(left_index == SCALAR_NULL_INDEX) {
+			left_input_types_vec[i] = cudf::type_id::EMPTY;
+		} else if(left_index == SCALAR_INDEX) {
+			left_input_types_vec[i] = left_scalars[i]->type().id();
+		} else if(left_index == UNARY_INDEX) {
+			// not possible
+			assert(false);
+		} else {
+			// have to get it from the output that generated it
+			left_input_types_vec[i] = output_map_type[left_index];
+		}
+
+		if(right_index >= 0 && right_index < table.num_columns()) {
+			right_input_types_vec[i] = table.column(right_index).type().id();
+		} else if(right_index == SCALAR_NULL_INDEX) {
+			right_input_types_vec[i] = cudf::type_id::EMPTY;
+		} else if(right_index == SCALAR_INDEX) {
+			right_input_types_vec[i] = right_scalars[i]->type().id();
+		} else if(right_index == UNARY_INDEX) {
+			// wont be used its a unary operation
+			right_input_types_vec[i] = cudf::type_id::EMPTY;
+		} else {
+			// have to get it from the output that generated it
+			right_input_types_vec[i] = output_map_type[right_index];
+		}
+
+		if(right_index == UNARY_INDEX){
+			output_types_vec[i] =  get_output_type(operators[i], left_input_types_vec[i]);
+		}else if(right_index == NULLARY_INDEX){
+			output_types_vec[i] = get_output_type(operators[i]);
+		}else{
+			output_types_vec[i] = get_output_type(operators[i], left_input_types_vec[i], right_input_types_vec[i]);
+		}
+
+
+		output_map_type[output_index] = output_types_vec[i];
+	}
+	rmm::device_buffer left_device_input_types = to_device_buffer(left_input_types_vec, stream, scratch_mr);
+	rmm::device_buffer right_device_input_types = to_device_buffer(right_input_types_vec, stream, scratch_mr);
+
+	rmm::device_buffer left_device_inputs = to_device_buffer(left_inputs, stream, scratch_mr);
+	rmm::device_buffer right_device_inputs = to_device_buffer(right_inputs, stream, scratch_mr);
+	rmm::device_buffer device_outputs = to_device_buffer(outputs, stream, scratch_mr);
+	rmm::device_buffer final_device_output_positions = to_device_buffer(final_output_positions, stream, scratch_mr);
+	rmm::device_buffer device_operators = to_device_buffer(operators, stream, scratch_mr);
+
+	// every operation can take 4 values of the Philox subsequence of every row, for RAND()
+	ral::utilities::random_generator::philox_offset rand_values = ral::utilities::random_generator::get_instance().reserve(4 * num_operations);
+
+
+	InterpreterFunctor op(*device_out_table_view,
+												*device_table_view,
+												static_cast<cudf::size_type>(left_inputs.size()),
+												static_cast<const column_index_type *>(left_device_inputs.data()),
+												static_cast<const column_index_type *>(right_device_inputs.data()),
+												static_cast<const column_index_type *>(device_outputs.data()),
+												static_cast<const column_index_type *>(final_device_output_positions.data()),
+												static_cast<const cudf::type_id *>(left_device_input_types.data()),
+												static_cast<const cudf::type_id *>(right_device_input_types.data()),
+												static_cast<const operator_type *>(device_operators.data()),
+												static_cast<cudf::detail::scalar_device_view_base **>(left_device_scalars.data()),
+												static_cast<cudf::detail::scalar_device_view_base **>(right_device_scalars.data()),
+												temp_device_valids_in_buffer.data(),
+												temp_device_valids_out_buffer.data(),
+												rand_values.seed,
+												rand_values.offset);
+
+	transformKernel<<<min_grid_size,
+		block_size,
+		config.shared_memory_bytes,
+		stream>>>(op, operation_num_rows);
+	CUDA_TRY(cudaStreamSynchronize(stream));
 }
 
 }  // namespace detail
@@ -409,6 +554,70 @@ private:
 	std::vector<std::unique_ptr<cudf::scalar>> & right_scalars;
 };
 
+// The key of a subexpression, the literals have their types since the same value can be of more than one
+std::string subexpression_key(const ral::parser::node & node) {
+	if (node.type == ral::parser::node_type::LITERAL) {
+		return node.value + ":" + std::to_string(static_cast<int32_t>(static_cast<const ral::parser::literal_node &>(node).type().id()));
+	} else if (node.type != ral::parser::node_type::OPERATOR) {
+		return node.value;
+	}
+
+	std::string key = node.value + "(";
+	for (auto && child : node.children) {
+		key += subexpression_key(*child) + ",";
+	}
+	return key + ")";
+}
+
+struct subexpression_count {
+	std::size_t occurrences = 0;
+	std::size_t size = 0;
+};
+
+/**
+ * Counts the operator subexpressions below the root of a tree, and returns the size of the node. The ones with a
+ * nullary operator, like RAND, have a different value every time they are evaluated and are not counted.
+ */
+std::size_t count_subexpressions(const ral::parser::node & node, bool is_root, bool & deterministic,
+	std::map<std::string, subexpression_count> & counts) {
+	deterministic = node.type != ral::parser::node_type::OPERATOR || !node.children.empty();
+	std::size_t size = 1;
+	for (auto && child : node.children) {
+		bool child_deterministic;
+		size += count_subexpressions(*child, false, child_deterministic, counts);
+		deterministic = deterministic && child_deterministic;
+	}
+
+	if (node.type == ral::parser::node_type::OPERATOR && !is_root && deterministic) {
+		subexpression_count & count = counts[subexpression_key(node)];
+		count.occurrences++;
+		count.size = size;
+	}
+	return size;
+}
+
+// Replaces a subexpression below the root of a tree by a variable, and keeps a copy of it
+struct subexpression_replacer : public ral::parser::node_transformer {
+	subexpression_replacer(const std::string & key, const std::string & variable) : key{key}, variable{variable} {}
+
+	ral::parser::node * transform(ral::parser::operad_node & node) override { return &node; }
+
+	ral::parser::node * transform(ral::parser::operator_node & node) override {
+		if (&node == root || subexpression_key(node) != key) {
+			return &node;
+		}
+		if (!subexpression) {
+			subexpression.reset(node.clone());
+		}
+		return new ral::parser::variable_node(variable);
+	}
+
+	const ral::parser::node * root = nullptr;
+	std::string key;
+	std::string variable;
+	std::unique_ptr<ral::parser::node> subexpression;
+};
+
 /**
  * Creates a physical plan for the expression that can be added to the total plan
  */
@@ -437,6 +646,48 @@ void add_expression_to_interpreter_plan(const ral::parser::parse_tree & expr_tre
 	outputs.back() = final_output_position;
 }
 
+std::vector<ral::parser::parse_tree> extract_common_subexpressions(std::vector<ral::parser::parse_tree> & expr_trees,
+	column_index_type first_variable_index) {
+	std::vector<ral::parser::parse_tree> subexpression_trees;
+
+	// The largest subexpression that is in more than one place is extracted first, so the ones inside it are only
+	// extracted if they are also somewhere else
+	while (true) {
+		std::map<std::string, subexpression_count> counts;
+		for (auto && trees : {&expr_trees, &subexpression_trees}) {
+			for (auto && tree : *trees) {
+				bool deterministic;
+				count_subexpressions(tree.root(), true, deterministic, counts);
+			}
+		}
+
+		auto shared_it = counts.end();
+		for (auto it = counts.begin(); it != counts.end(); ++it) {
+			if (it->second.occurrences > 1 && (shared_it == counts.end() || it->second.size > shared_it->second.size)) {
+				shared_it = it;
+			}
+		}
+		if (shared_it == counts.end()) {
+			break;
+		}
+
+		subexpression_replacer replacer{shared_it->first, "$" + std::to_string(first_variable_index + subexpression_trees.size())};
+		for (auto && trees : {&expr_trees, &subexpression_trees}) {
+			for (auto && tree : *trees) {
+				replacer.root = &tree.root();
+				tree.transform(replacer);
+			}
+		}
+		subexpression_trees.emplace_back(std::move(replacer.subexpression));
+	}
+
+	return subexpression_trees;
+}
+
+void set_interpreter_min_occupancy(double occupancy) {
+	detail::min_occupancy = occupancy;
+}
+
 void perform_interpreter_operation(cudf::mutable_table_view & out_table,
 	const cudf::table_view & table,
 	const std::vector<column_index_type> & left_inputs,
@@ -448,7 +699,6 @@ void perform_interpreter_operation(cudf::mutable_table_view & out_table,
 	const std::vector<std::unique_ptr<cudf::scalar>> & right_scalars,
 	cudf::size_type operation_num_rows) {
 	using namespace detail;
-	cudaStream_t stream = 0;
 
 	if (final_output_positions.empty())	{
 		return;
@@ -465,132 +715,44 @@ void perform_interpreter_operation(cudf::mutable_table_view & out_table,
 
 	RAL_EXPECTS(std::max(std::max(*max_left_it, *max_right_it), *max_out_it) < 64, "Interops does not support plans with an input or output index greater than 63");
 
-	column_index_type max_output = *max_out_it;
-
-	size_t shared_memory_per_thread = (max_output + 1) * sizeof(int64_t);
-
-	int min_grid_size, block_size;
-	calculate_grid(&min_grid_size, &block_size, max_output + 1);
-
-	size_t temp_valids_in_size = min_grid_size * block_size * table.num_columns() * sizeof(cudf::bitmask_type);
-	size_t temp_valids_out_size = min_grid_size * block_size * final_output_positions.size() * sizeof(cudf::bitmask_type);
-	rmm::device_buffer temp_device_valids_in_buffer(temp_valids_in_size, stream);
-	rmm::device_buffer temp_device_valids_out_buffer(temp_valids_out_size, stream);
-
-	// device table views
-	auto device_table_view = cudf::table_device_view::create(table, stream);
-	auto device_out_table_view = cudf::mutable_table_device_view::create(out_table, stream);
-
-	// device scalar views
-	std::vector<rmm::device_buffer> left_device_scalars_ptrs;
-	std::vector<cudf::detail::scalar_device_view_base *> left_device_scalars_raw;
-	std::vector<rmm::device_buffer> right_device_scalars_ptrs;
-	std::vector<cudf::detail::scalar_device_view_base *> right_device_scalars_raw;
-	for (size_t i = 0; i < left_scalars.size(); i++) {
-		left_device_scalars_ptrs.push_back(left_scalars[i] ? std::move(cudf::type_dispatcher(left_scalars[i]->type(), allocate_device_scalar{}, *(left_scalars[i]))) : rmm::device_buffer{});
-		left_device_scalars_raw.push_back(static_cast<cudf::detail::scalar_device_view_base *>(left_device_scalars_ptrs.back().data()));
-
-		right_device_scalars_ptrs.push_back(right_scalars[i] ? std::move(cudf::type_dispatcher(right_scalars[i]->type(), allocate_device_scalar{}, *(right_scalars[i]))) : rmm::device_buffer{});
-		right_device_scalars_raw.push_back(static_cast<cudf::detail::scalar_device_view_base *>(right_device_scalars_ptrs.back().data()));
+	if (operation_num_rows == 0){
+		operation_num_rows = table.num_rows();
 	}
-	rmm::device_vector<cudf::detail::scalar_device_view_base *> left_device_scalars(left_device_scalars_raw);
-	rmm::device_vector<cudf::detail::scalar_device_view_base *> right_device_scalars(right_device_scalars_raw);
 
+	// the input columns are loaded into the first positions of every thread
+	int num_positions = std::max<int>(*max_out_it + 1, table.num_columns());
+	std::shared_ptr<const interpreter_launch_plan> launch_plan = get_launch_plan(
+		table.num_columns(), left_inputs, right_inputs, outputs, final_output_positions, operators, num_positions);
 
+	std::vector<cudf::scalar *> left_scalars_raw(left_scalars.size());
+	std::vector<cudf::scalar *> right_scalars_raw(right_scalars.size());
+	for (std::size_t i = 0; i < left_scalars.size(); i++) {
+		left_scalars_raw[i] = left_scalars[i].get();
+		right_scalars_raw[i] = right_scalars[i].get();
+	}
+	if (launch_plan->launches.empty()) {
+		launch_interpreter(out_table, table, left_inputs, right_inputs, outputs, final_output_positions, operators,
+			left_scalars_raw, right_scalars_raw, operation_num_rows, get_launch_config(num_positions));
+		return;
+	}
 
-	// device left, right and output types
-	size_t num_operations = left_inputs.size();
-	std::vector<cudf::type_id> left_input_types_vec(num_operations);
-	std::vector<cudf::type_id> right_input_types_vec(num_operations);
-	std::vector<cudf::type_id> output_types_vec(num_operations);
-	std::map<column_index_type, cudf::type_id> output_map_type;
-	for(size_t i = 0; i < num_operations; i++) {
-		column_index_type left_index = left_inputs[i];
-		column_index_type right_index = right_inputs[i];
-		column_index_type output_index = outputs[i];
-
-		if(left_index >= 0 && left_index < table.num_columns()) {
-			left_input_types_vec[i] = table.column(left_index).type().id();
-		} else if(left_index == SCALAR_NULL_INDEX) {
-			left_input_types_vec[i] = cudf::type_id::EMPTY;
-		} else if(left_index == SCALAR_INDEX) {
-			left_input_types_vec[i] = left_scalars[i]->type().id();
-		} else if(left_index == UNARY_INDEX) {
-			// not possible
-			assert(false);
-		} else {
-			// have to get it from the output that generated it
-			left_input_types_vec[i] = output_map_type[left_index];
+	// every launch reads only the columns its outputs need, and writes only those outputs
+	for (const interpreter_launch & launch : launch_plan->launches) {
+		std::vector<cudf::mutable_column_view> launch_out_columns;
+		for (cudf::size_type output_column : launch.output_columns) {
+			launch_out_columns.push_back(out_table.column(output_column));
 		}
-
-		if(right_index >= 0 && right_index < table.num_columns()) {
-			right_input_types_vec[i] = table.column(right_index).type().id();
-		} else if(right_index == SCALAR_NULL_INDEX) {
-			right_input_types_vec[i] = cudf::type_id::EMPTY;
-		} else if(right_index == SCALAR_INDEX) {
-			right_input_types_vec[i] = right_scalars[i]->type().id();
-		} else if(right_index == UNARY_INDEX) {
-			// wont be used its a unary operation
-			right_input_types_vec[i] = cudf::type_id::EMPTY;
-		} else {
-			// have to get it from the output that generated it
-			right_input_types_vec[i] = output_map_type[right_index];
-		}
-
-		if(right_index == UNARY_INDEX){
-			output_types_vec[i] =  get_output_type(operators[i], left_input_types_vec[i]);
-		}else if(right_index == NULLARY_INDEX){
-			output_types_vec[i] = get_output_type(operators[i]);
-		}else{
-			output_types_vec[i] = get_output_type(operators[i], left_input_types_vec[i], right_input_types_vec[i]);
+		cudf::mutable_table_view launch_out_table(launch_out_columns);
+		std::vector<cudf::scalar *> launch_left_scalars;
+		std::vector<cudf::scalar *> launch_right_scalars;
+		for (std::size_t operation : launch.operations) {
+			launch_left_scalars.push_back(left_scalars_raw[operation]);
+			launch_right_scalars.push_back(right_scalars_raw[operation]);
 		}
-
-
-		output_map_type[output_index] = output_types_vec[i];
+		launch_interpreter(launch_out_table, table.select(launch.input_columns), launch.left_inputs, launch.right_inputs,
+			launch.outputs, launch.final_output_positions, launch.operators, launch_left_scalars, launch_right_scalars,
+			operation_num_rows, get_launch_config(launch.num_positions));
 	}
-	rmm::device_vector<cudf::type_id> left_device_input_types(left_input_types_vec);
-	rmm::device_vector<cudf::type_id> right_device_input_types(right_input_types_vec);
-
-	rmm::device_vector<column_index_type> left_device_inputs(left_inputs);
-	rmm::device_vector<column_index_type> right_device_inputs(right_inputs);
-	rmm::device_vector<column_index_type> device_outputs(outputs);
-	rmm::device_vector<column_index_type> final_device_output_positions(final_output_positions);
-	rmm::device_vector<operator_type> device_operators(operators);
-
-
-
-	InterpreterFunctor op(*device_out_table_view,
-												*device_table_view,
-												static_cast<cudf::size_type>(left_device_inputs.size()),
-												left_device_inputs.data().get(),
-												right_device_inputs.data().get(),
-												device_outputs.data().get(),
-												final_device_output_positions.data().get(),
-												left_device_input_types.data().get(),
-												right_device_input_types.data().get(),
-												device_operators.data().get(),
-												left_device_scalars.data().get(),
-												right_device_scalars.data().get(),
-												temp_device_valids_in_buffer.data(),
-												temp_device_valids_out_buffer.data());
-
-rmm::device_vector<curandState> states(min_grid_size * block_size);
-	 std::random_device rd;
-	  std::default_random_engine generator(rd());
-  std::uniform_int_distribution<long long unsigned> distribution(0,0xFFFFFFFFFFFFFFFF);
-	unsigned long long seed = distribution(generator);
-	setup_rand_kernel<<<min_grid_size,
-		block_size,
-		shared_memory_per_thread * block_size,
-		stream>>>(states.data().get(),seed);
-	if (operation_num_rows == 0){
-		operation_num_rows = table.num_rows();
-	}
-	transformKernel<<<min_grid_size,
-		block_size,
-		shared_memory_per_thread * block_size,
-		stream>>>(op, operation_num_rows, states.data().get());
-	CUDA_TRY(cudaStreamSynchronize(stream));
 }
 
 }  // namespace interops
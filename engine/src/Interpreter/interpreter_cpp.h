@@ -58,9 +58,37 @@ void add_expression_to_interpreter_plan(const ral::parser::parse_tree & expr_tre
 	std::vector<std::unique_ptr<cudf::scalar>> & left_scalars,
 	std::vector<std::unique_ptr<cudf::scalar>> & right_scalars);
 
+/**
+ * @brief Moves the operator subexpressions that are in more than one of the expression trees, or more than once in the
+ * same one, into trees of their own, so that the interpreter computes each of them once per row
+ *
+ * Every occurrence below the root of a tree is replaced by the variable of its subexpression tree, the i-th returned
+ * tree is the variable first_variable_index + i. A tree only uses the variables of the trees returned after it, so
+ * they are added to the plan from the last one, each with a final output position that no other expression uses.
+ *
+ * @param expr_trees The expression trees, which are left with the variables of the subexpressions
+ * @param first_variable_index The variable index of the first subexpression, past the ones of the input columns
+ * @return The trees of the subexpressions
+ */
+std::vector<ral::parser::parse_tree> extract_common_subexpressions(std::vector<ral::parser::parse_tree> & expr_trees,
+	column_index_type first_variable_index);
+
+/**
+ * @brief Sets the fraction of the threads of an SM that the kernel of the interpreter has to keep running
+ * (INTERPRETER_MIN_OCCUPANCY). The plans with so many positions that their kernel would run fewer threads are split
+ * into several launches, each of them with some of the outputs and only the operations and columns they need. 0 never
+ * splits them.
+ */
+void set_interpreter_min_occupancy(double occupancy);
+
 /**
  * @brief Evaluates multiple operations encoded in a GPU friendly format in a
- * single GPU kernel call
+ * single GPU kernel call, or in a few of them if it has too many positions for
+ * the minimum occupancy (see set_interpreter_min_occupancy)
+ *
+ * The block size and the shared memory of every launch are chosen by the
+ * occupancy model of CUDA for its number of positions, and how the plan is
+ * split is cached by the plan.
  *
  * @param out_table The output table to store the results
  * @param table The input table
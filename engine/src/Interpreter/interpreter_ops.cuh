@@ -47,14 +47,6 @@ CUDA_DEVICE_CALLABLE double getMagicNumber<double>() {
 	return 1.7976931348623123e+308;
 }
 
-__global__ void setup_rand_kernel(curandState *state, unsigned long long seed )
-{
-    int id = threadIdx.x + blockIdx.x * blockDim.x;
-    /* Each thread gets same seed, a different sequence
-       number, no offset */
-    curand_init(seed, id, 0, &state[id]);
-}
-
 enum class datetime_component {
   INVALID = 0,
   YEAR,
@@ -165,7 +157,9 @@ public:
 		cudf::detail::scalar_device_view_base ** scalars_left,
 		cudf::detail::scalar_device_view_base ** scalars_right,
 		void * temp_valids_in_buffer,
-		void * temp_valids_out_buffer)
+		void * temp_valids_out_buffer,
+		uint64_t rand_seed = 0,
+		uint64_t rand_offset = 0)
 		: out_table{out_table},
 			table{table},
 			num_operations{num_operations},
@@ -179,12 +173,14 @@ public:
 			scalars_left{scalars_left},
 			scalars_right{scalars_right},
 		  temp_valids_in_buffer{static_cast<cudf::bitmask_type *>(temp_valids_in_buffer)},
-		  temp_valids_out_buffer{static_cast<cudf::bitmask_type *>(temp_valids_out_buffer)} {
+		  temp_valids_out_buffer{static_cast<cudf::bitmask_type *>(temp_valids_out_buffer)},
+			rand_seed{rand_seed},
+			rand_offset{rand_offset} {
 
 	}
 
 	CUDA_DEVICE_CALLABLE void operator()(
-		cudf::size_type row_index, int64_t total_buffer[], cudf::size_type size, curandState & state) {
+		cudf::size_type row_index, int64_t total_buffer[], cudf::size_type size) {
 		cudf::bitmask_type * valids_in_buffer =
 			temp_valids_in_buffer + (blockIdx.x * blockDim.x + threadIdx.x) * table.num_columns();
 		cudf::bitmask_type * valids_out_buffer =
@@ -205,7 +201,7 @@ public:
 			}
 
 			for(int16_t op_index = 0; op_index < num_operations; op_index++) {
-				process_operator(op_index, total_buffer, row_index + row, cur_row_valids,state );
+				process_operator(op_index, total_buffer, row_index + row, cur_row_valids);
 			}
 
 			// copy data and row valids into buffer
@@ -260,8 +256,8 @@ private:
 																					cudf::size_type col_index,
 																					cudf::size_type row,
 																					int64_t * buffer) {
-			//TODO: implement fixed point
-			//*(buffer + (col_index * blockDim.x + threadIdx.x)) = static_cast<int64_t>(table.column(col_index).element<ColType>(row));
+			// the decimals are computed as their unscaled values, the scales of the outputs are found when the expressions are planned
+			*(buffer + (col_index * blockDim.x + threadIdx.x)) = static_cast<int64_t>(table.column(col_index).data<typename ColType::rep>()[row]);
 		}
 
 		template <typename ColType, std::enable_if_t<std::is_floating_point<ColType>::value> * = nullptr>
@@ -317,8 +313,7 @@ private:
 																					cudf::size_type row,
 																					int64_t * buffer,
 																					int position) {
-			//TODO: implement fixed point
-			//out_table.column(col_index).element<ColType>(row) =	static_cast<ColType>(*(buffer + (position * blockDim.x + threadIdx.x)));
+			out_table.column(col_index).data<typename ColType::rep>()[row] = static_cast<typename ColType::rep>(*(buffer + (position * blockDim.x + threadIdx.x)));
 		}
 
 
@@ -432,29 +427,29 @@ private:
 	}
 
 	CUDA_DEVICE_CALLABLE void process_operator(
-		size_t op_index, int64_t * buffer, cudf::size_type row_index, uint64_t & row_valids, curandState & state) {
+		size_t op_index, int64_t * buffer, cudf::size_type row_index, uint64_t & row_valids) {
 		cudf::type_id type = input_types_left[op_index];
 		if(is_float_type(type)) {
-			process_operator_1<double>(op_index, buffer, row_index, row_valids,state);
+			process_operator_1<double>(op_index, buffer, row_index, row_valids);
 		} else {
-			process_operator_1<int64_t>(op_index, buffer, row_index, row_valids,state);
+			process_operator_1<int64_t>(op_index, buffer, row_index, row_valids);
 		}
 	}
 
 	template <typename LeftType>
 	CUDA_DEVICE_CALLABLE void process_operator_1(
-		size_t op_index, int64_t * buffer, cudf::size_type row_index, uint64_t & row_valids, curandState & state) {
+		size_t op_index, int64_t * buffer, cudf::size_type row_index, uint64_t & row_valids) {
 		cudf::type_id type = input_types_right[op_index];
 		if(is_float_type(type)) {
-			process_operator_2<LeftType, double>(op_index, buffer, row_index, row_valids,state);
+			process_operator_2<LeftType, double>(op_index, buffer, row_index, row_valids);
 		} else {
-			process_operator_2<LeftType, int64_t>(op_index, buffer, row_index, row_valids,state);
+			process_operator_2<LeftType, int64_t>(op_index, buffer, row_index, row_valids);
 		}
 	}
 
 	template <typename LeftType, typename RightType>
 	CUDA_DEVICE_CALLABLE void process_operator_2(
-		size_t op_index, int64_t * buffer, cudf::size_type row_index, uint64_t & row_valids, curandState & state) {
+		size_t op_index, int64_t * buffer, cudf::size_type row_index, uint64_t & row_valids) {
 		column_index_type left_position = left_input_positions[op_index];
 		column_index_type right_position = right_input_positions[op_index];
 		column_index_type output_position = output_positions[op_index];
@@ -848,6 +843,9 @@ private:
 			setColumnValid(row_valids, output_position, out_valid);
 		}else{
 			if(oper == operator_type::BLZ_RAND) {
+				// a Philox generator only needs its counter set, the row picks the subsequence and the operation its values
+				curandStatePhilox4_32_10_t state;
+				curand_init(rand_seed, row_index, rand_offset + 4 * op_index, &state);
 				double out = curand_uniform_double(&state);
 				store_data_in_buffer(out, buffer, output_position);
 			}
@@ -876,22 +874,18 @@ private:
 
 	cudf::bitmask_type * temp_valids_in_buffer;
 	cudf::bitmask_type * temp_valids_out_buffer;
+
+	uint64_t rand_seed;
+	uint64_t rand_offset; /**< The values of every row that RAND() uses start here, 4 for every operation. */
 };
 
 
-__global__ void transformKernel(InterpreterFunctor op, cudf::size_type size, curandState *state) {
+__global__ void transformKernel(InterpreterFunctor op, cudf::size_type size) {
 	extern __shared__ int64_t total_buffer[];
 
-    int id = threadIdx.x + blockIdx.x * blockDim.x;
-    
-
-    curandState localState = state[id];
- 
-
 	for(cudf::size_type i = (blockIdx.x * blockDim.x + threadIdx.x) * 32; i < size; i += blockDim.x * gridDim.x * 32) {
-		op(i, total_buffer, size, localState);
+		op(i, total_buffer, size);
 	}
-	state[id] = localState;
 }
 
 } // namespace interops
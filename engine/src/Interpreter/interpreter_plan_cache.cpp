@@ -0,0 +1,18 @@
+#include "interpreter_plan_cache.h"
+#include "jit_expressions.h"
+
+namespace interops {
+
+std::string get_interpreter_plan_key(const cudf::table_view & table, const std::vector<std::string> & expressions) {
+	std::string key = jit::is_enabled() ? "jit|" : "interpreter|";
+	for (cudf::size_type i = 0; i < table.num_columns(); i++) {
+		const cudf::column_view & column = table.column(i);
+		key += std::to_string(static_cast<int32_t>(column.type().id())) + ":" + std::to_string(column.type().scale()) + (column.nullable() ? "n" : "") + ",";
+	}
+	for (const std::string & expression : expressions) {
+		key += "|" + expression;
+	}
+	return key;
+}
+
+} // namespace interops
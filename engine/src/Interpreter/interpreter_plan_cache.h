@@ -0,0 +1,168 @@
+#pragma once
+
+#include <cudf/scalar/scalar.hpp>
+#include <cudf/table/table_view.hpp>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "interpreter_cpp.h"
+
+namespace interops {
+
+/**
+ * @brief Everything evaluate_expressions makes from a list of expressions before it runs them on a batch: what every
+ * expression outputs, and the encoded plan of the interpreter, or the source of the JIT kernel, for the ones it computes.
+ *
+ * It only depends on the expressions and on the schema of the input table, so it is reused by every batch and every
+ * query with the same ones. The expressions with functions that are evaluated on their own, like the ones on strings,
+ * have columns computed for every batch, so they are not kept.
+ */
+struct interpreter_plan {
+	enum class output_kind {
+		LITERAL,      ///< A column made from a scalar
+		INPUT_COLUMN, ///< A copy of a column of the input table
+		INTERPRETED   ///< A column computed by the interpreter, or by the JIT kernel
+	};
+
+	struct expression_output {
+		output_kind kind;
+		cudf::size_type input_index = 0;
+		cudf::data_type type;
+		std::unique_ptr<cudf::scalar> literal;
+	};
+
+	std::vector<expression_output> expression_outputs;
+	std::vector<cudf::size_type> input_col_indices; ///< The columns of the input table the interpreter takes
+
+	std::vector<column_index_type> left_inputs;
+	std::vector<column_index_type> right_inputs;
+	std::vector<column_index_type> outputs;
+	std::vector<column_index_type> final_output_positions;
+	std::vector<operator_type> operators;
+	std::vector<std::unique_ptr<cudf::scalar>> left_scalars;
+	std::vector<std::unique_ptr<cudf::scalar>> right_scalars;
+
+	std::string jit_kernel_source; ///< Not empty when the JIT kernel computes the expressions, see interops::jit
+};
+
+/**
+ * @brief Returns the key of the plan of these expressions for this input table. It has the expressions, the types of
+ * the columns and whether they have null masks, and whether the JIT backend is enabled.
+ */
+std::string get_interpreter_plan_key(const cudf::table_view & table, const std::vector<std::string> & expressions);
+
+/**
+ * @brief How a LIKE matches its pattern. The patterns that are a literal string with at most a '%' at their start, one
+ * at their end, or a single one in the middle, are matched without a regex.
+ */
+struct like_pattern {
+	enum class match_kind {
+		EXACT,             ///< The whole string is the literal
+		PREFIX,            ///< The string starts with the prefix
+		SUFFIX,            ///< The string ends with the suffix
+		CONTAINS,          ///< The string has the literal anywhere
+		PREFIX_AND_SUFFIX, ///< The string starts with the prefix and ends with the suffix, without them overlapping
+		REGEX              ///< Anything else, matched with the regex
+	};
+
+	match_kind kind = match_kind::REGEX;
+	std::string literal;
+	std::string prefix;
+	std::string suffix;
+	std::string regex;
+};
+
+/**
+ * @brief A process wide LRU cache of what is made from the expressions before they are evaluated, by their key.
+ */
+template <typename T>
+class expression_cache {
+public:
+	/**
+	 * @brief Sets the number of entries that are kept, the least recently used ones are dropped beyond it. 0 turns the cache off.
+	 */
+	void set_max_size(std::size_t max_size) {
+		std::lock_guard<std::mutex> lock(cache_mutex);
+		this->max_size = max_size;
+		while (entries.size() > max_size) {
+			entries_by_key.erase(entries.back().first);
+			entries.pop_back();
+		}
+	}
+
+	/**
+	 * @brief Returns the entry with this key, or nullptr if there is none.
+	 */
+	std::shared_ptr<const T> get(const std::string & key) {
+		std::lock_guard<std::mutex> lock(cache_mutex);
+		auto it = entries_by_key.find(key);
+		if (it == entries_by_key.end()) {
+			return nullptr;
+		}
+		entries.splice(entries.begin(), entries, it->second);
+		return it->second->second;
+	}
+
+	void put(const std::string & key, std::shared_ptr<const T> value) {
+		std::lock_guard<std::mutex> lock(cache_mutex);
+		if (max_size == 0 || entries_by_key.count(key) > 0) {
+			return;
+		}
+		entries.emplace_front(key, std::move(value));
+		entries_by_key[key] = entries.begin();
+		if (entries.size() > max_size) {
+			entries_by_key.erase(entries.back().first);
+			entries.pop_back();
+		}
+	}
+
+protected:
+	expression_cache() = default;
+	expression_cache(expression_cache &&) = delete;
+	expression_cache(const expression_cache &) = delete;
+	expression_cache & operator=(expression_cache &&) = delete;
+	expression_cache & operator=(const expression_cache &) = delete;
+
+private:
+	using entry = std::pair<std::string, std::shared_ptr<const T>>;
+
+	std::mutex cache_mutex;
+	std::size_t max_size = 1024;
+	std::list<entry> entries; // the most recently used first
+	std::unordered_map<std::string, typename std::list<entry>::iterator> entries_by_key;
+};
+
+/**
+ * @brief The cache of the plans of the expressions, so that the filters and the projections that keep being run don't
+ * parse and encode their expressions again for every batch and every query.
+ */
+class interpreter_plan_cache : public expression_cache<interpreter_plan> {
+public:
+	static interpreter_plan_cache & get_instance() {
+		static interpreter_plan_cache instance;
+		return instance;
+	}
+
+private:
+	interpreter_plan_cache() = default;
+};
+
+/**
+ * @brief The cache of the parsed patterns of the LIKEs by their pattern, so that the LIKE of every batch doesn't look
+ * for its wildcards and convert it to a regex again.
+ */
+class like_pattern_cache : public expression_cache<like_pattern> {
+public:
+	static like_pattern_cache & get_instance() {
+		static like_pattern_cache instance;
+		return instance;
+	}
+
+private:
+	like_pattern_cache() = default;
+};
+
+} // namespace interops
@@ -0,0 +1,422 @@
+#include "jit_expressions.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+
+#include <cuda.h>
+#include <cuda_runtime.h>
+#include <nvrtc.h>
+
+#include <cudf/types.hpp>
+#include "utilities/error.hpp"
+
+namespace interops {
+namespace jit {
+
+namespace {
+
+std::atomic<bool> jit_enabled{false};
+
+const std::string kernel_name = "blazing_jit_expressions";
+constexpr int block_size = 256;
+constexpr int max_grid_size = 65535;
+
+// The type the values of a column are stored as in the kernel, nullptr for the types it does not support
+const char * get_storage_type(cudf::type_id type) {
+	switch (type) {
+		case cudf::type_id::INT8: return "signed char";
+		case cudf::type_id::INT16: return "short";
+		case cudf::type_id::INT32: return "int";
+		case cudf::type_id::INT64: return "long long";
+		case cudf::type_id::UINT8: return "unsigned char";
+		case cudf::type_id::UINT16: return "unsigned short";
+		case cudf::type_id::UINT32: return "unsigned int";
+		case cudf::type_id::UINT64: return "unsigned long long";
+		case cudf::type_id::FLOAT32: return "float";
+		case cudf::type_id::FLOAT64: return "double";
+		case cudf::type_id::BOOL8: return "unsigned char";
+		default: return nullptr;
+	}
+}
+
+bool is_float(cudf::type_id type) {
+	return type == cudf::type_id::FLOAT32 || type == cudf::type_id::FLOAT64;
+}
+
+// The type of the intermediate values, like in the buffer of the interpreter
+const char * get_value_type(cudf::type_id type) {
+	return is_float(type) ? "double" : "long long";
+}
+
+struct generated_value {
+	std::string value;
+	std::string valid;
+	std::string magic = "false"; // the CASE without a match, see BLZ_MAGIC_IF_NOT
+	cudf::type_id type;
+};
+
+/**
+ * Generates the statements that compute the expressions of one row. The code has no branches, every operator is a
+ * ternary on the validity of its inputs, so the loads of the columns are emitted where they are first used.
+ */
+class kernel_source_generator {
+public:
+	kernel_source_generator(const std::map<int16_t, int16_t> & expr_idx_to_col_idx_map, const cudf::table_view & table)
+		: expr_idx_to_col_idx_map{expr_idx_to_col_idx_map}, table{table} {}
+
+	bool add_expression(const ral::parser::node & root, cudf::size_type out_index, cudf::type_id out_type) {
+		const char * out_storage_type = get_storage_type(out_type);
+		generated_value result;
+		if (out_storage_type == nullptr || !generate(root, result)) {
+			return false;
+		}
+		outputs << "\t\tif (in_range && " << result.valid << ") {\n"
+			<< "\t\t\tout" << out_index << "[row] = static_cast<" << out_storage_type << ">(" << result.value << ");\n"
+			<< "\t\t}\n"
+			<< "\t\tunsigned int ballot" << out_index << " = __ballot_sync(0xffffffffu, in_range && " << result.valid << ");\n"
+			<< "\t\tif ((threadIdx.x % 32) == 0) {\n"
+			<< "\t\t\tout_mask" << out_index << "[(base + threadIdx.x) / 32] = ballot" << out_index << ";\n"
+			<< "\t\t}\n";
+		out_types.push_back(out_storage_type);
+		return true;
+	}
+
+	std::string source() const {
+		std::ostringstream source;
+		source << "extern \"C\" __global__ void " << kernel_name << "(int num_rows";
+		for (cudf::size_type i = 0; i < table.num_columns(); i++) {
+			source << ",\n\tconst " << get_storage_type(table.column(i).type().id()) << " * in" << i
+				<< ", const unsigned int * mask" << i << ", int offset" << i;
+		}
+		for (std::size_t i = 0; i < out_types.size(); i++) {
+			source << ",\n\t" << out_types[i] << " * out" << i << ", unsigned int * out_mask" << i;
+		}
+		source << ") {\n"
+			<< "\tfor (int base = blockIdx.x * blockDim.x; base < num_rows; base += blockDim.x * gridDim.x) {\n"
+			<< "\t\tconst int row = base + threadIdx.x;\n"
+			<< "\t\tconst bool in_range = row < num_rows;\n"
+			<< "\t\tconst int r = in_range ? row : 0;\n"
+			<< statements.str()
+			<< outputs.str()
+			<< "\t}\n"
+			<< "}\n";
+		return source.str();
+	}
+
+private:
+	std::string new_name() { return "v" + std::to_string(num_values++); }
+
+	bool generate_variable(const ral::parser::variable_node & node, generated_value & out) {
+		auto it = expr_idx_to_col_idx_map.find(node.index());
+		if (it == expr_idx_to_col_idx_map.end()) {
+			return false;
+		}
+		int col = it->second;
+		cudf::type_id type = table.column(col).type().id();
+		if (get_storage_type(type) == nullptr) {
+			return false;
+		}
+		std::string name = "c" + std::to_string(col);
+		if (loaded_columns.count(col) == 0) {
+			statements << "\t\tconst " << get_value_type(type) << " " << name << " = static_cast<" << get_value_type(type) << ">(in" << col << "[r]);\n";
+			if (table.column(col).nullable()) {
+				statements << "\t\tconst bool " << name << "_valid = (mask" << col << "[(r + offset" << col << ") / 32] >> ((r + offset" << col << ") % 32)) & 1u;\n";
+			} else {
+				statements << "\t\tconst bool " << name << "_valid = true;\n";
+			}
+			loaded_columns[col] = true;
+		}
+		out.value = name;
+		out.valid = name + "_valid";
+		out.type = type;
+		return true;
+	}
+
+	bool generate_literal(const ral::parser::literal_node & node, generated_value & out) {
+		cudf::type_id type = node.type().id();
+		if (is_null(node.value) || get_storage_type(type) == nullptr) {
+			return false;
+		}
+		try {
+			if (type == cudf::type_id::BOOL8) {
+				out.value = (node.value == "true" || node.value == "1") ? "1LL" : "0LL";
+			} else if (is_float(type)) {
+				char buffer[64];
+				std::snprintf(buffer, sizeof(buffer), "%.17g", std::stod(node.value));
+				out.value = std::string("(static_cast<double>(") + buffer + "))";
+			} else {
+				out.value = "(" + std::to_string(std::stoll(node.value)) + "LL)";
+			}
+		} catch (const std::exception &) {
+			return false;
+		}
+		out.valid = "true";
+		out.type = type;
+		return true;
+	}
+
+	bool generate_unary(operator_type op, const generated_value & a, generated_value & out) {
+		std::string expr;
+		std::string valid = a.valid;
+		switch (op) {
+			case operator_type::BLZ_NOT: expr = "!" + a.value; break;
+			case operator_type::BLZ_ABS: expr = is_float(a.type) ? "fabs(" + a.value + ")" : "llabs(" + a.value + ")"; break;
+			case operator_type::BLZ_FLOOR: expr = "floor(static_cast<double>(" + a.value + "))"; break;
+			case operator_type::BLZ_CEIL: expr = "ceil(static_cast<double>(" + a.value + "))"; break;
+			case operator_type::BLZ_SIN: expr = "sin(static_cast<double>(" + a.value + "))"; break;
+			case operator_type::BLZ_COS: expr = "cos(static_cast<double>(" + a.value + "))"; break;
+			case operator_type::BLZ_ASIN: expr = "asin(static_cast<double>(" + a.value + "))"; break;
+			case operator_type::BLZ_ACOS: expr = "acos(static_cast<double>(" + a.value + "))"; break;
+			case operator_type::BLZ_TAN: expr = "tan(static_cast<double>(" + a.value + "))"; break;
+			case operator_type::BLZ_ATAN: expr = "atan(static_cast<double>(" + a.value + "))"; break;
+			case operator_type::BLZ_LN: expr = "log(static_cast<double>(" + a.value + "))"; break;
+			case operator_type::BLZ_LOG: expr = "log10(static_cast<double>(" + a.value + "))"; break;
+			case operator_type::BLZ_IS_TRUE: expr = a.value; break;
+			case operator_type::BLZ_IS_NULL: expr = "!" + a.valid; valid = "true"; break;
+			case operator_type::BLZ_IS_NOT_NULL: expr = a.valid; valid = "true"; break;
+			case operator_type::BLZ_IS_NOT_TRUE: expr = "!(" + a.valid + " && " + a.value + ")"; valid = "true"; break;
+			case operator_type::BLZ_IS_NOT_FALSE: expr = "!(" + a.valid + " && !" + a.value + ")"; valid = "true"; break;
+			case operator_type::BLZ_CAST_TINYINT:
+			case operator_type::BLZ_CAST_SMALLINT:
+			case operator_type::BLZ_CAST_INTEGER:
+			case operator_type::BLZ_CAST_BIGINT: expr = "static_cast<long long>(" + a.value + ")"; break;
+			case operator_type::BLZ_CAST_FLOAT:
+			case operator_type::BLZ_CAST_DOUBLE: expr = "static_cast<double>(" + a.value + ")"; break;
+			default: return false;
+		}
+		out.type = get_output_type(op, a.type);
+		if (get_storage_type(out.type) == nullptr) {
+			return false;
+		}
+		std::string name = new_name();
+		statements << "\t\tconst bool " << name << "_valid = " << valid << ";\n"
+			<< "\t\tconst " << get_value_type(out.type) << " " << name << " = " << name << "_valid ? static_cast<"
+			<< get_value_type(out.type) << ">(" << expr << ") : 0;\n";
+		out.value = name;
+		out.valid = name + "_valid";
+		return true;
+	}
+
+	bool generate_binary(operator_type op, const generated_value & a, const generated_value & b, generated_value & out) {
+		out.type = get_output_type(op, a.type, b.type);
+		if (get_storage_type(out.type) == nullptr) {
+			return false;
+		}
+		std::string name = new_name();
+		std::string value_type = get_value_type(out.type);
+		std::string both_valid = "(" + a.valid + " && " + b.valid + ")";
+		std::string expr;
+		std::string valid = both_valid;
+		switch (op) {
+			case operator_type::BLZ_ADD: expr = a.value + " + " + b.value; break;
+			case operator_type::BLZ_SUB: expr = a.value + " - " + b.value; break;
+			case operator_type::BLZ_MUL: expr = a.value + " * " + b.value; break;
+			case operator_type::BLZ_DIV: expr = a.value + " / " + b.value; valid = "(" + both_valid + " && " + b.value + " != 0)"; break;
+			case operator_type::BLZ_MOD:
+				if (is_float(a.type) || is_float(b.type)) {
+					expr = "fmod(static_cast<double>(" + a.value + "), static_cast<double>(" + b.value + "))";
+				} else {
+					expr = a.value + " % " + b.value;
+					valid = "(" + both_valid + " && " + b.value + " != 0)";
+				}
+				break;
+			case operator_type::BLZ_POW: expr = "pow(static_cast<double>(" + a.value + "), static_cast<double>(" + b.value + "))"; break;
+			case operator_type::BLZ_EQUAL: expr = a.value + " == " + b.value; break;
+			case operator_type::BLZ_NOT_EQUAL: expr = a.value + " != " + b.value; break;
+			case operator_type::BLZ_LESS: expr = a.value + " < " + b.value; break;
+			case operator_type::BLZ_GREATER: expr = a.value + " > " + b.value; break;
+			case operator_type::BLZ_LESS_EQUAL: expr = a.value + " <= " + b.value; break;
+			case operator_type::BLZ_GREATER_EQUAL: expr = a.value + " >= " + b.value; break;
+			case operator_type::BLZ_LOGICAL_AND: expr = a.value + " && " + b.value; break;
+			case operator_type::BLZ_LOGICAL_OR:
+				// a valid true is enough, like in the interpreter
+				expr = "(" + a.valid + " && " + a.value + ") || (" + b.valid + " && " + b.value + ")";
+				valid = "(" + both_valid + " || (" + a.valid + " && " + a.value + ") || (" + b.valid + " && " + b.value + "))";
+				break;
+			case operator_type::BLZ_IS_NOT_DISTINCT_FROM:
+				expr = "(!" + a.valid + " && !" + b.valid + ") || (" + both_valid + " && " + a.value + " == " + b.value + ")";
+				valid = "true";
+				break;
+			case operator_type::BLZ_MAGIC_IF_NOT:
+				statements << "\t\tconst bool " << name << "_magic = !(" << a.valid << " && " << a.value << ");\n";
+				expr = b.value;
+				valid = b.valid;
+				out.magic = name + "_magic";
+				break;
+			case operator_type::BLZ_FIRST_NON_MAGIC:
+				statements << "\t\tconst bool " << name << "_magic = " << a.magic << " && " << b.magic << ";\n";
+				expr = a.magic + " ? static_cast<" + value_type + ">(" + b.value + ") : static_cast<" + value_type + ">(" + a.value + ")";
+				valid = "(" + a.magic + " ? " + b.valid + " : " + a.valid + ")";
+				out.magic = name + "_magic";
+				break;
+			default: return false;
+		}
+		statements << "\t\tconst bool " << name << "_valid = " << valid << ";\n"
+			<< "\t\tconst " << value_type << " " << name << " = " << name << "_valid ? static_cast<"
+			<< value_type << ">(" << expr << ") : 0;\n";
+		out.value = name;
+		out.valid = name + "_valid";
+		return true;
+	}
+
+	bool generate(const ral::parser::node & node, generated_value & out) {
+		if (node.type == ral::parser::node_type::VARIABLE) {
+			return generate_variable(static_cast<const ral::parser::variable_node &>(node), out);
+		} else if (node.type == ral::parser::node_type::LITERAL) {
+			return generate_literal(static_cast<const ral::parser::literal_node &>(node), out);
+		} else if (node.type != ral::parser::node_type::OPERATOR) {
+			return false;
+		}
+
+		operator_type op = map_to_operator_type(node.value);
+		if (is_unary_operator(op) && node.children.size() == 1) {
+			generated_value a;
+			return generate(*node.children[0], a) && generate_unary(op, a, out);
+		} else if (is_binary_operator(op) && node.children.size() == 2) {
+			generated_value a, b;
+			return generate(*node.children[0], a) && generate(*node.children[1], b) && generate_binary(op, a, b, out);
+		}
+		return false;
+	}
+
+	const std::map<int16_t, int16_t> & expr_idx_to_col_idx_map;
+	const cudf::table_view & table;
+	std::ostringstream statements;
+	std::ostringstream outputs;
+	std::vector<std::string> out_types;
+	std::map<int, bool> loaded_columns;
+	int num_values = 0;
+};
+
+void check_cu(CUresult result, const std::string & what) {
+	if (result != CUDA_SUCCESS) {
+		const char * message = nullptr;
+		cuGetErrorString(result, &message);
+		RAL_FAIL("In JIT expressions: " + what + " failed: " + (message != nullptr ? message : "unknown error"));
+	}
+}
+
+CUfunction compile_kernel(const std::string & source) {
+	nvrtcProgram program;
+	RAL_EXPECTS(nvrtcCreateProgram(&program, source.c_str(), "blazing_jit_expressions.cu", 0, nullptr, nullptr) == NVRTC_SUCCESS,
+		"In JIT expressions: could not create the NVRTC program");
+
+	int device = 0;
+	cudaGetDevice(&device);
+	cudaDeviceProp properties;
+	cudaGetDeviceProperties(&properties, device);
+	std::string architecture = "--gpu-architecture=compute_" + std::to_string(properties.major) + std::to_string(properties.minor);
+	std::vector<const char *> options = {architecture.c_str(), "--std=c++14"};
+
+	nvrtcResult result = nvrtcCompileProgram(program, options.size(), options.data());
+	if (result != NVRTC_SUCCESS) {
+		std::size_t log_size = 0;
+		nvrtcGetProgramLogSize(program, &log_size);
+		std::string log(log_size, '\0');
+		nvrtcGetProgramLog(program, &log[0]);
+		nvrtcDestroyProgram(&program);
+		RAL_FAIL("In JIT expressions: the kernel did not compile: " + log + "\n" + source);
+	}
+
+	std::size_t ptx_size = 0;
+	nvrtcGetPTXSize(program, &ptx_size);
+	std::string ptx(ptx_size, '\0');
+	nvrtcGetPTX(program, &ptx[0]);
+	nvrtcDestroyProgram(&program);
+
+	// the modules are kept for as long as the engine runs, like the cache of their functions
+	CUmodule module;
+	check_cu(cuModuleLoadDataEx(&module, ptx.c_str(), 0, nullptr, nullptr), "cuModuleLoadDataEx");
+	CUfunction function;
+	check_cu(cuModuleGetFunction(&function, module, kernel_name.c_str()), "cuModuleGetFunction");
+	return function;
+}
+
+CUfunction get_kernel(const std::string & source) {
+	static std::mutex cache_mutex;
+	static std::unordered_map<std::string, CUfunction> compiled_kernels;
+
+	std::lock_guard<std::mutex> lock(cache_mutex);
+	auto it = compiled_kernels.find(source);
+	if (it != compiled_kernels.end()) {
+		return it->second;
+	}
+	CUfunction function = compile_kernel(source);
+	compiled_kernels.emplace(source, function);
+	return function;
+}
+
+} // namespace
+
+void set_enabled(bool enabled) {
+	jit_enabled = enabled;
+}
+
+bool is_enabled() {
+	return jit_enabled;
+}
+
+std::string generate_kernel_source(const std::vector<ral::parser::parse_tree> & expr_trees,
+	const std::map<int16_t, int16_t> & expr_idx_to_col_idx_map,
+	const cudf::table_view & table,
+	const cudf::mutable_table_view & out_table) {
+
+	for (cudf::size_type i = 0; i < table.num_columns(); i++) {
+		if (get_storage_type(table.column(i).type().id()) == nullptr) {
+			return "";
+		}
+	}
+
+	kernel_source_generator generator{expr_idx_to_col_idx_map, table};
+	for (std::size_t i = 0; i < expr_trees.size(); i++) {
+		if (!generator.add_expression(expr_trees[i].root(), i, out_table.column(i).type().id())) {
+			return "";
+		}
+	}
+	return generator.source();
+}
+
+void evaluate(const std::string & source, const cudf::table_view & table, cudf::mutable_table_view & out_table) {
+	cudf::size_type num_rows = out_table.num_rows();
+	if (num_rows == 0) {
+		return;
+	}
+	CUfunction function = get_kernel(source);
+
+	// the arguments point to these, so they must not grow once they are taken
+	std::vector<const void *> input_data(table.num_columns());
+	std::vector<const cudf::bitmask_type *> input_masks(table.num_columns());
+	std::vector<int> input_offsets(table.num_columns());
+	std::vector<void *> output_data(out_table.num_columns());
+	std::vector<cudf::bitmask_type *> output_masks(out_table.num_columns());
+
+	std::vector<void *> args;
+	args.push_back(&num_rows);
+	for (cudf::size_type i = 0; i < table.num_columns(); i++) {
+		const cudf::column_view & column = table.column(i);
+		input_data[i] = static_cast<const char *>(column.head()) + column.offset() * cudf::size_of(column.type());
+		input_masks[i] = column.null_mask();
+		input_offsets[i] = column.offset();
+		args.push_back(&input_data[i]);
+		args.push_back(&input_masks[i]);
+		args.push_back(&input_offsets[i]);
+	}
+	for (cudf::size_type i = 0; i < out_table.num_columns(); i++) {
+		cudf::mutable_column_view column = out_table.column(i);
+		RAL_EXPECTS(column.nullable() && column.offset() == 0, "In JIT expressions: the output columns must have null masks and no offsets");
+		output_data[i] = column.head();
+		output_masks[i] = column.null_mask();
+		args.push_back(&output_data[i]);
+		args.push_back(&output_masks[i]);
+	}
+
+	int grid_size = std::min((num_rows + block_size - 1) / block_size, max_grid_size);
+	check_cu(cuLaunchKernel(function, grid_size, 1, 1, block_size, 1, 1, 0, CU_STREAM_PER_THREAD, args.data(), nullptr), "cuLaunchKernel");
+}
+
+} // namespace jit
+} // namespace interops
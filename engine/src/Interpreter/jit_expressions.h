@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cudf/table/table_view.hpp>
+#include <map>
+#include <string>
+#include <vector>
+#include "parser/expression_tree.hpp"
+
+namespace interops {
+namespace jit {
+
+/**
+ * @brief Turns the JIT backend of the expressions on or off for the whole engine. It is set by ENABLE_JIT_EXPRESSIONS
+ * when the engine is initialized, and it is off by default.
+ */
+void set_enabled(bool enabled);
+
+bool is_enabled();
+
+/**
+ * @brief Returns the CUDA source of a kernel that evaluates these expressions, or an empty string if any of them has an
+ * operator or a type the JIT backend does not support, in which case they are evaluated by the interpreter.
+ *
+ * The kernel computes every expression of a row at once, in registers, with every operator and type known when it is
+ * compiled. The values and the null semantics are the ones of the interpreter: the intermediate values are int64 or
+ * double, and they are cast to the types of the output columns at the end.
+ *
+ * @param expr_trees The expression trees, which only have the operators of the interpreter left
+ * @param expr_idx_to_col_idx_map A map from the indices of the variables of the trees to the columns of the input table
+ * @param table The input table
+ * @param out_table The output columns, one for each expression
+ */
+std::string generate_kernel_source(const std::vector<ral::parser::parse_tree> & expr_trees,
+	const std::map<int16_t, int16_t> & expr_idx_to_col_idx_map,
+	const cudf::table_view & table,
+	const cudf::mutable_table_view & out_table);
+
+/**
+ * @brief Evaluates the expressions with a kernel generated by generate_kernel_source.
+ *
+ * The kernel is compiled with NVRTC the first time it is needed, and it is kept in a cache by its source, which has the
+ * expressions, the types of the columns and whether they have nulls, so the same filters and projections are only
+ * compiled once while the engine runs.
+ *
+ * @param source The source of the kernel
+ * @param table The input table, with the columns the source was made for
+ * @param out_table The output columns, every one of them with a null mask
+ */
+void evaluate(const std::string & source, const cudf::table_view & table, cudf::mutable_table_view & out_table);
+
+} // namespace jit
+} // namespace interops
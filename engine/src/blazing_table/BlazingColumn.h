@@ -18,7 +18,8 @@ namespace frame {
 
 enum class blazing_column_type {
 	OWNER,
-	VIEW
+	VIEW,
+	EXTERNAL_VIEW // a view of the buffers of a table registered from a dataframe, which outlive the queries on it
 };
 
 
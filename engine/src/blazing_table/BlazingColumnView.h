@@ -2,6 +2,7 @@
 
 #include "execution_kernels/LogicPrimitives.h"
 #include "blazing_table/BlazingColumn.h"
+#include <rmm/device_buffer.hpp>
 
 namespace ral {
 
@@ -25,6 +26,33 @@ class BlazingColumnView : public BlazingColumn {
 		CudfColumnView column;
 };
 
+/**
+ * A view of a column of a table registered from a dataframe, whose buffers are kept by the dataframe as long as the
+ * table is registered. Unlike the other views it is kept as it is in the caches, since the buffers outlive the query,
+ * so it is only copied when a kernel releases it to own its data or when it is spilled.
+ */
+class BlazingColumnExternalView : public BlazingColumnView {
+	public:
+		BlazingColumnExternalView(const CudfColumnView & column) : BlazingColumnView(column) {};
+		~BlazingColumnExternalView() = default;
+		blazing_column_type type() { return blazing_column_type::EXTERNAL_VIEW; }
+};
+
+/**
+ * A view of a column unpacked from the buffer of a packed table, see comm::deserialize_from_gpu_raw_buffers, which it
+ * shares with the other columns of that table. The buffer is kept until all of them are freed, so they are kept as they
+ * are in the caches like the external views.
+ */
+class BlazingColumnPackedView : public BlazingColumnExternalView {
+	public:
+		BlazingColumnPackedView(const CudfColumnView & column, std::shared_ptr<rmm::device_buffer> packed_buffer)
+			: BlazingColumnExternalView(column), packed_buffer(std::move(packed_buffer)) {};
+		~BlazingColumnPackedView() = default;
+
+	private:
+		std::shared_ptr<rmm::device_buffer> packed_buffer;
+};
+
 }  // namespace frame
 
 }  // namespace ral
\ No newline at end of file
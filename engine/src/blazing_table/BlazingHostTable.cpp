@@ -1,7 +1,11 @@
 #include "BlazingHostTable.h"
 #include "bmr/BlazingMemoryResource.h"
 #include "bmr/BufferProvider.h"
+#include "communication/CommunicationInterface/compression.hpp"
 #include "communication/CommunicationInterface/serializer.hpp"
+#include "utilities/nvtx.h"
+#include <map>
+#include <numeric>
 
 using namespace fmt::literals;
 
@@ -12,19 +16,24 @@ BlazingHostTable::BlazingHostTable(const std::vector<ColumnTransport> &columns_o
             std::vector<ral::memory::blazing_chunked_column_info> && chunked_column_infos,
             std::vector<std::unique_ptr<ral::memory::blazing_allocation_chunk>> && allocations)
         : columns_offsets{columns_offsets}, chunked_column_infos{std::move(chunked_column_infos)}, allocations{std::move(allocations)} {
-
-    auto size = sizeInBytes();
-    blazing_host_memory_resource::getInstance().allocate(size); // this only increments the memory usage counter for the host memory. This does not actually allocate
-
+    // the chunks come from the host memory pools, which blazing_host_memory_resource accounts, so they are not counted here
 }
 
 BlazingHostTable::~BlazingHostTable() {
-    auto size = sizeInBytes();
-    blazing_host_memory_resource::getInstance().deallocate(size); // this only decrements the memory usage counter for the host memory. This does not actually allocate
     for(auto i = 0; i < allocations.size(); i++){
+        if (allocations[i] == nullptr) {
+            continue; // it is compressed
+        }
         auto pool = allocations[i]->allocation->pool;
         pool->free_chunk(std::move(allocations[i]));
     }
+    std::size_t compressed_bytes = 0;
+    for (auto & compressed : compressed_chunks) {
+        compressed_bytes += compressed.data.size();
+    }
+    if (compressed_bytes > 0 && ral::memory::blazing_host_memory_resource::getInstance().isInitialized()) {
+        ral::memory::blazing_host_memory_resource::getInstance().deallocate(compressed_bytes);
+    }
 }
 
 std::vector<cudf::data_type> BlazingHostTable::get_schema() const {
@@ -78,24 +87,47 @@ const std::vector<ColumnTransport> &BlazingHostTable::get_columns_offsets() cons
 }
 
 std::unique_ptr<BlazingTable> BlazingHostTable::get_gpu_table() const {
-    std::vector<rmm::device_buffer> gpu_raw_buffers(chunked_column_infos.size());
+    std::vector<int> column_indices(columns_offsets.size());
+    std::iota(column_indices.begin(), column_indices.end(), 0);
+    return get_gpu_table(column_indices);
+}
+
+std::unique_ptr<BlazingTable> BlazingHostTable::get_gpu_table(const std::vector<int> & column_indices) const {
+    BLAZING_NVTX_RANGE("deserialize to gpu", serialization);
+    std::vector<int> buffer_indices;
+    std::vector<ColumnTransport> selected_columns_offsets = comm::select_column_transports(columns_offsets, column_indices, buffer_indices);
+    std::vector<rmm::device_buffer> gpu_raw_buffers(buffer_indices.size());
+    // the compressed chunks are decompressed once each, into chunks that are given back after the copies
+    std::map<size_t, std::unique_ptr<ral::memory::blazing_allocation_chunk>> decompressed_chunks;
 
     try{
-        int buffer_index = 0;
-        for(auto & chunked_column_info : chunked_column_infos){
+        for(size_t buffer_index = 0; buffer_index < buffer_indices.size(); buffer_index++){
+            auto & chunked_column_info = chunked_column_infos[buffer_indices[buffer_index]];
             gpu_raw_buffers[buffer_index].resize(chunked_column_info.use_size);
             size_t position = 0;
             for(size_t i = 0; i < chunked_column_info.chunk_index.size(); i++){
                 size_t chunk_index = chunked_column_info.chunk_index[i];
                 size_t offset = chunked_column_info.offset[i];
                 size_t chunk_size = chunked_column_info.size[i];
-                cudaMemcpyAsync((void *) (gpu_raw_buffers[buffer_index].data() + position), allocations[chunk_index]->data + offset, chunk_size, cudaMemcpyHostToDevice,0);
+                if (allocations[chunk_index] == nullptr && decompressed_chunks.count(chunk_index) == 0) {
+                    decompressed_chunks[chunk_index] = decompress_chunk(chunk_index);
+                }
+                const char * chunk_data = allocations[chunk_index] != nullptr ? allocations[chunk_index]->data : decompressed_chunks[chunk_index]->data;
+                cudaMemcpyAsync((void *) (gpu_raw_buffers[buffer_index].data() + position), chunk_data + offset, chunk_size, cudaMemcpyHostToDevice,0);
                 position += chunk_size;
             }
-            buffer_index++;
         }
         cudaStreamSynchronize(0);
+        for (auto & decompressed : decompressed_chunks) {
+            compressed_chunks[decompressed.first].pool->free_chunk(std::move(decompressed.second));
+        }
     }catch(std::exception & e){
+        cudaStreamSynchronize(0);
+        for (auto & decompressed : decompressed_chunks) {
+            if (decompressed.second != nullptr) {
+                compressed_chunks[decompressed.first].pool->free_chunk(std::move(decompressed.second));
+            }
+        }
         auto logger = spdlog::get("batch_logger");
         if (logger){
             logger->error("|||{info}|||||",
@@ -104,11 +136,14 @@ std::unique_ptr<BlazingTable> BlazingHostTable::get_gpu_table() const {
         throw;
     }
 
-    return std::move(comm::deserialize_from_gpu_raw_buffers(columns_offsets,
+    return std::move(comm::deserialize_from_gpu_raw_buffers(selected_columns_offsets,
                                     gpu_raw_buffers));
 }
 
 std::vector<ral::memory::blazing_allocation_chunk> BlazingHostTable::get_raw_buffers() const {
+    if (is_compressed()) {
+        throw std::runtime_error("ERROR: BlazingHostTable::get_raw_buffers() of a table that is compressed");
+    }
     std::vector<ral::memory::blazing_allocation_chunk> chunks;
     for(auto & chunk : allocations){
         ral::memory::blazing_allocation_chunk new_chunk;
@@ -125,5 +160,93 @@ const std::vector<ral::memory::blazing_chunked_column_info> & BlazingHostTable::
     return this->chunked_column_infos;
 }
 
+std::size_t BlazingHostTable::compress() {
+    if (is_compressed()) {
+        return 0;
+    }
+    // the columns may use only the start of the last chunk
+    std::vector<std::size_t> used_sizes(allocations.size(), 0);
+    for (auto & chunked_column_info : chunked_column_infos) {
+        for (size_t i = 0; i < chunked_column_info.chunk_index.size(); i++) {
+            size_t chunk_index = chunked_column_info.chunk_index[i];
+            used_sizes[chunk_index] = std::max(used_sizes[chunk_index], chunked_column_info.offset[i] + chunked_column_info.size[i]);
+        }
+    }
+
+    compressed_chunks.resize(allocations.size());
+    std::size_t freed_bytes = 0;
+    std::size_t compressed_bytes = 0;
+    for (size_t i = 0; i < allocations.size(); i++) {
+        if (used_sizes[i] == 0) {
+            continue;
+        }
+        std::vector<char> compressed(used_sizes[i]);
+        std::size_t compressed_size = comm::compress_buffer(allocations[i]->data, used_sizes[i], compressed.data(), compressed.size());
+        if (compressed_size == 0) {
+            continue;
+        }
+        compressed.resize(compressed_size);
+        compressed.shrink_to_fit();
+        compressed_bytes += compressed_size;
+        freed_bytes += allocations[i]->size;
+
+        compressed_chunks[i].data = std::move(compressed);
+        compressed_chunks[i].uncompressed_size = used_sizes[i];
+        compressed_chunks[i].pool = allocations[i]->allocation->pool;
+        compressed_chunks[i].pool->free_chunk(std::move(allocations[i]));
+        allocations[i] = nullptr;
+    }
+
+    if (compressed_bytes == 0) {
+        compressed_chunks.clear();
+        return 0;
+    }
+    if (ral::memory::blazing_host_memory_resource::getInstance().isInitialized()) {
+        ral::memory::blazing_host_memory_resource::getInstance().allocate(compressed_bytes);
+    }
+    return freed_bytes > compressed_bytes ? freed_bytes - compressed_bytes : 0;
+}
+
+void BlazingHostTable::decompress() {
+    if (!is_compressed()) {
+        return;
+    }
+    std::size_t compressed_bytes = 0;
+    for (size_t i = 0; i < compressed_chunks.size(); i++) {
+        if (allocations[i] == nullptr) {
+            allocations[i] = decompress_chunk(i);
+            compressed_bytes += compressed_chunks[i].data.size();
+        }
+    }
+    compressed_chunks.clear();
+    if (ral::memory::blazing_host_memory_resource::getInstance().isInitialized()) {
+        ral::memory::blazing_host_memory_resource::getInstance().deallocate(compressed_bytes);
+    }
+}
+
+std::unique_ptr<ral::memory::blazing_allocation_chunk> BlazingHostTable::decompress_chunk(std::size_t chunk_index) const {
+    const compressed_chunk & compressed = compressed_chunks[chunk_index];
+    std::unique_ptr<ral::memory::blazing_allocation_chunk> chunk = compressed.pool->get_chunk(compressed.uncompressed_size);
+    try {
+        comm::decompress_buffer(compressed.data.data(), compressed.data.size(), chunk->data, compressed.uncompressed_size);
+    } catch (...) {
+        compressed.pool->free_chunk(std::move(chunk));
+        throw;
+    }
+    return chunk;
+}
+
+bool BlazingHostTable::is_compressed() const {
+    return !compressed_chunks.empty();
+}
+
+std::size_t BlazingHostTable::get_host_bytes() const {
+    std::size_t host_bytes = 0;
+    for (size_t i = 0; i < allocations.size(); i++) {
+        host_bytes += allocations[i] != nullptr ? allocations[i]->size : compressed_chunks[i].data.size();
+    }
+    return host_bytes;
+}
+
 }  // namespace frame
 }  // namespace ral
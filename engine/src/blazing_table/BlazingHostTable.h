@@ -49,14 +49,50 @@ public:
 
     std::unique_ptr<BlazingTable> get_gpu_table() const;
 
+    /**
+    * Copies only some of the columns of this table into GPU memory. The buffers of the other columns are not copied.
+    * @param column_indices the indices of the columns to copy, in the order they will have in the BlazingTable.
+    */
+    std::unique_ptr<BlazingTable> get_gpu_table(const std::vector<int> & column_indices) const;
+
     std::vector<ral::memory::blazing_allocation_chunk> get_raw_buffers() const;
 
     const std::vector<ral::memory::blazing_chunked_column_info> &  get_blazing_chunked_column_infos() const;
 
+    /**
+    * Compresses the bytes that the columns use of every chunk with lz4 into host memory of its own, which
+    * blazing_host_memory_resource accounts, and gives the chunk back to its pool. The chunks that don't get smaller stay
+    * as they are. get_gpu_table decompresses them, and get_raw_buffers needs them decompressed.
+    * @return the bytes of host memory that were given back.
+    */
+    std::size_t compress();
+
+    /**
+    * Decompresses the compressed chunks into chunks of the pools they came from.
+    */
+    void decompress();
+
+    bool is_compressed() const;
+
+    // the host memory that the buffers take, which is less than sizeInBytes() once they are compressed
+    std::size_t get_host_bytes() const;
+
+private:
+    struct compressed_chunk {
+        std::vector<char> data;
+        std::size_t uncompressed_size = 0; // the bytes of the chunk that the columns use
+        ral::memory::allocation_pool * pool = nullptr; // the pool that gives the chunk to decompress it into
+    };
+
+    // a chunk of the pool of the compressed chunk with its bytes decompressed, to give back to the pool after their use
+    std::unique_ptr<ral::memory::blazing_allocation_chunk> decompress_chunk(std::size_t chunk_index) const;
+
 private:
     std::vector<ColumnTransport> columns_offsets;
     std::vector<ral::memory::blazing_chunked_column_info> chunked_column_infos;
     std::vector<std::unique_ptr<ral::memory::blazing_allocation_chunk>> allocations;
+    // by the index of the chunk, empty when the table is not compressed. The chunks that are compressed have no allocation
+    std::vector<compressed_chunk> compressed_chunks;
 
     
     size_t part_id;
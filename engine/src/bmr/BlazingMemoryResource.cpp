@@ -1,4 +1,122 @@
 #include "BlazingMemoryResource.h"
+#include "QueryMemoryTracker.h"
+#include "MemoryTimeline.h"
+#include "MemoryPressure.h"
+#include "BufferProvider.h"
+#include "PoolFragmentation.h"
+#include <fstream>
+#include <thread>
+#include <algorithm>
+#include <limits>
+#include <rmm/detail/error.hpp>
+#include <sys/stat.h>
+
+namespace {
+// reads a number of bytes from a file of the cgroup filesystem, "max" means there is no limit
+bool read_cgroup_bytes(const std::string & path, std::size_t & bytes) {
+    std::ifstream file(path);
+    std::string value;
+    if (!(file >> value)) {
+        return false;
+    }
+    if (value == "max") {
+        bytes = std::numeric_limits<std::size_t>::max();
+        return true;
+    }
+    try {
+        bytes = std::stoull(value);
+    } catch (const std::exception & e) {
+        return false;
+    }
+    return true;
+}
+
+// the memory that the cgroup of the process can still use, or the max size_t when it has no limit
+std::size_t get_cgroup_available_memory() {
+    std::size_t limit, usage;
+    if ((read_cgroup_bytes("/sys/fs/cgroup/memory.max", limit) && read_cgroup_bytes("/sys/fs/cgroup/memory.current", usage)) ||
+        (read_cgroup_bytes("/sys/fs/cgroup/memory/memory.limit_in_bytes", limit) && read_cgroup_bytes("/sys/fs/cgroup/memory/memory.usage_in_bytes", usage))) {
+        return limit > usage ? limit - usage : 0;
+    }
+    return std::numeric_limits<std::size_t>::max();
+}
+
+// the usage of the host, pinned and upload pools
+ral::memory::allocation_pool::usage_stats get_host_pools_usage() {
+    ral::memory::allocation_pool::usage_stats usage;
+    for (auto pool : {ral::memory::buffer_providers::get_host_buffer_provider(),
+            ral::memory::buffer_providers::get_pinned_buffer_provider(),
+            ral::memory::buffer_providers::get_upload_buffer_provider()}) {
+        if (pool != nullptr) {
+            ral::memory::allocation_pool::usage_stats pool_usage = pool->get_usage_stats();
+            usage.total_bytes += pool_usage.total_bytes;
+            usage.free_bytes += pool_usage.free_bytes;
+        }
+    }
+    return usage;
+}
+
+// bytes allocated minus bytes deallocated by the current thread since the last reset, and its peak.
+// Used for measuring the peak memory consumption of the task that is running on this thread.
+thread_local std::int64_t thread_memory_used = 0;
+thread_local std::int64_t thread_max_memory_used = 0;
+
+/**
+	@brief A device memory resource that uses the stream-ordered allocator of the CUDA driver (cudaMallocAsync),
+	which keeps the freed memory in the pool of the device and reuses it for the allocations of the same stream
+	without synchronizing.
+*/
+class stream_ordered_memory_resource : public rmm::mr::device_memory_resource {
+public:
+    // release_threshold is how much memory the pool keeps reserved when it is synchronized, 0 means all of it
+    stream_ordered_memory_resource(std::size_t release_threshold) {
+#if CUDART_VERSION >= 11020
+        int device_id;
+        RMM_CUDA_TRY(cudaGetDevice(&device_id));
+        int supported = 0;
+        RMM_CUDA_TRY(cudaDeviceGetAttribute(&supported, cudaDevAttrMemoryPoolsSupported, device_id));
+        if (!supported) {
+            throw std::runtime_error("ERROR creating stream_ordered_memory_resource: the device does not support memory pools.");
+        }
+        RMM_CUDA_TRY(cudaDeviceGetDefaultMemPool(&pool, device_id));
+        uint64_t threshold = release_threshold == 0 ? std::numeric_limits<uint64_t>::max() : release_threshold;
+        RMM_CUDA_TRY(cudaMemPoolSetAttribute(pool, cudaMemPoolAttrReleaseThreshold, &threshold));
+#else
+        throw std::runtime_error("ERROR creating stream_ordered_memory_resource: it requires CUDA 11.2 or newer.");
+#endif
+    }
+
+    bool supports_streams() const noexcept override { return true; }
+    bool supports_get_mem_info() const noexcept override { return false; }
+
+private:
+    void* do_allocate(size_t bytes, rmm::cuda_stream_view stream) override {
+        void* p = nullptr;
+#if CUDART_VERSION >= 11020
+        RMM_CUDA_TRY(cudaMallocFromPoolAsync(&p, bytes, pool, stream.value()), rmm::bad_alloc);
+#endif
+        return p;
+    }
+
+    void do_deallocate(void* p, size_t bytes, rmm::cuda_stream_view stream) override {
+#if CUDART_VERSION >= 11020
+        cudaFreeAsync(p, stream.value());
+#endif
+    }
+
+    bool do_is_equal(device_memory_resource const& other) const noexcept override {
+        return dynamic_cast<stream_ordered_memory_resource const*>(&other) != nullptr;
+    }
+
+    std::pair<size_t, size_t> do_get_mem_info(rmm::cuda_stream_view stream) const override {
+        return std::make_pair(0, 0);
+    }
+
+#if CUDART_VERSION >= 11020
+    cudaMemPool_t pool;
+#endif
+};
+}
 
 // BEGIN internal_blazing_device_memory_resource
 
@@ -12,6 +130,7 @@ internal_blazing_device_memory_resource::internal_blazing_device_memory_resource
     total_memory_size = ral::config::gpuTotalMemory();
     used_memory = 0;
     memory_limit = (double)custom_threshold * total_memory_size;
+    track_owners = false;
 
     initial_pool_size = initial_pool_size - initial_pool_size % 256; //initial_pool_size required to be a multiple of 256 bytes 
 
@@ -25,29 +144,17 @@ internal_blazing_device_memory_resource::internal_blazing_device_memory_resource
     } else if (allocation_mode == "managed_memory_resource"){
         memory_resource_owner = std::make_shared<rmm::mr::managed_memory_resource>();
         memory_resource = memory_resource_owner.get();
-    } else if (allocation_mode == "pool_memory_resource") {
-        if (initial_pool_size == 0){
-            memory_resource_owner = rmm::mr::make_owning_wrapper<rmm::mr::pool_memory_resource>(
-                std::make_shared<rmm::mr::cuda_memory_resource>());
-        } else if (maximum_pool_size == 0) {
-            memory_resource_owner = rmm::mr::make_owning_wrapper<rmm::mr::pool_memory_resource>(
-                std::make_shared<rmm::mr::cuda_memory_resource>(), initial_pool_size);
-        } else {
-            memory_resource_owner = rmm::mr::make_owning_wrapper<rmm::mr::pool_memory_resource>(
-                std::make_shared<rmm::mr::cuda_memory_resource>(), initial_pool_size, maximum_pool_size);
-        }
+    } else if (allocation_mode == "pool_memory_resource" || allocation_mode == "binning_pool_memory_resource") {
+        auto pool = std::make_shared<ral::memory::tracked_pool_memory_resource>(std::make_shared<rmm::mr::cuda_memory_resource>(),
+            initial_pool_size, maximum_pool_size, allocation_mode == "binning_pool_memory_resource");
+        tracked_pool = pool.get();
+        memory_resource_owner = pool;
         memory_resource = memory_resource_owner.get();
     } else if (allocation_mode == "managed_pool_memory_resource") {
-        if (initial_pool_size == 0){
-            memory_resource_owner = rmm::mr::make_owning_wrapper<rmm::mr::pool_memory_resource>(
-                std::make_shared<rmm::mr::managed_memory_resource>());
-        } else if (maximum_pool_size == 0) {
-            memory_resource_owner = rmm::mr::make_owning_wrapper<rmm::mr::pool_memory_resource>(
-                std::make_shared<rmm::mr::managed_memory_resource>(), initial_pool_size);
-        } else {
-            memory_resource_owner = rmm::mr::make_owning_wrapper<rmm::mr::pool_memory_resource>(
-                std::make_shared<rmm::mr::managed_memory_resource>(), initial_pool_size, maximum_pool_size);
-        }            
+        auto pool = std::make_shared<ral::memory::tracked_pool_memory_resource>(std::make_shared<rmm::mr::managed_memory_resource>(),
+            initial_pool_size, maximum_pool_size, false);
+        tracked_pool = pool.get();
+        memory_resource_owner = pool;
         memory_resource = memory_resource_owner.get();
     } else if (allocation_mode == "arena_memory_resource") {
         if (initial_pool_size == 0){
@@ -62,6 +169,10 @@ internal_blazing_device_memory_resource::internal_blazing_device_memory_resource
         }         
         
         memory_resource = memory_resource_owner.get();
+    } else if (allocation_mode == "async_memory_resource") {
+        memory_resource_owner = std::make_shared<stream_ordered_memory_resource>(maximum_pool_size);
+        memory_resource = memory_resource_owner.get();
+        track_owners = true;
     } else if (allocation_mode == "existing"){
         memory_resource = rmm::mr::get_current_device_resource();
     } else {
@@ -112,9 +223,21 @@ std::string internal_blazing_device_memory_resource::get_full_memory_summary() {
     summary += " | Available Memory from driver: " + std::to_string(this->get_from_driver_used_memory());
     summary += " | Total Memory: " + std::to_string(this->total_memory_size);
     summary += " | Memory Limit: " + std::to_string(this->memory_limit);
+    if (tracked_pool != nullptr) {
+        summary += " | " + tracked_pool->get_fragmentation_report().to_string();
+        summary += " | Compactions: " + std::to_string(tracked_pool->get_num_compactions());
+    }
     return summary;
 }
 
+bool internal_blazing_device_memory_resource::compact_pool(double min_fragmentation) {
+    // nothing can be allocated from the pool while it is replaced, which is only the case between queries
+    if (tracked_pool == nullptr || used_memory > 0) {
+        return false;
+    }
+    return tracked_pool->compact(min_fragmentation);
+}
+
 void internal_blazing_device_memory_resource::reset_max_memory_used(size_t to) noexcept {
     this->max_used_memory = to;
 }
@@ -123,12 +246,46 @@ void* internal_blazing_device_memory_resource::do_allocate(size_t bytes, rmm::cu
     if (bytes <= 0) { 
         return nullptr;
     }
-    used_memory += bytes;
+    size_t previous_used_memory = used_memory.fetch_add(bytes);
     if (max_used_memory < used_memory){
         max_used_memory += bytes;
     }
+    thread_memory_used += bytes;
+    if (thread_max_memory_used < thread_memory_used){
+        thread_max_memory_used = thread_memory_used;
+    }
+    // the monitors are told right away, so that short bursts don't get between their checks
+    if (previous_used_memory <= memory_limit && previous_used_memory + bytes > memory_limit) {
+        ral::memory::memory_pressure::get_instance().signal();
+    }
 
-    return memory_resource->allocate(bytes, stream);
+    void* p = nullptr;
+    try {
+        p = memory_resource->allocate(bytes, stream);
+    } catch (const rmm::bad_alloc &) {
+        // the monitors may make room for it by moving the data of the caches out of the GPU, so it waits for them once
+        bool waited = ral::memory::memory_pressure::get_instance().wait_for_eviction(bytes);
+        try {
+            if (!waited) {
+                throw;
+            }
+            p = memory_resource->allocate(bytes, stream);
+        } catch (...) {
+            used_memory -= bytes;
+            thread_memory_used -= bytes;
+            if (ral::memory::memory_timeline::get_instance().is_recording()) {
+                ral::memory::memory_timeline::get_instance().record_out_of_memory(bytes, used_memory);
+            }
+            throw;
+        }
+    }
+    if (track_owners) {
+        ral::memory::query_memory_tracker::get_instance().record_allocation(p, bytes);
+    }
+    if (ral::memory::memory_timeline::get_instance().is_recording()) {
+        ral::memory::memory_timeline::get_instance().record_allocation(p, bytes, used_memory);
+    }
+    return p;
 }
 
 void internal_blazing_device_memory_resource::do_deallocate(void* p, size_t bytes, rmm::cuda_stream_view stream) {
@@ -139,6 +296,13 @@ void internal_blazing_device_memory_resource::do_deallocate(void* p, size_t byte
     } else {
         used_memory -= bytes;
     }
+    thread_memory_used -= bytes;
+    if (track_owners) {
+        ral::memory::query_memory_tracker::get_instance().record_deallocation(p);
+    }
+    if (ral::memory::memory_timeline::get_instance().is_recording()) {
+        ral::memory::memory_timeline::get_instance().record_deallocation(p, bytes, used_memory);
+    }
 
     return memory_resource->deallocate(p, bytes, stream);
 }
@@ -178,14 +342,70 @@ std::string blazing_device_memory_resource::get_type() {
     return initialized_resource->get_type() ;
 }
 
+bool blazing_device_memory_resource::is_managed() {
+    if (initialized_resource == nullptr) {
+        return false;
+    }
+    std::string type = initialized_resource->get_type();
+    return type == "managed_memory_resource" || type == "managed_pool_memory_resource";
+}
+
 std::string blazing_device_memory_resource::get_full_memory_summary() {
     return initialized_resource->get_full_memory_summary() ;
 }
 
+bool blazing_device_memory_resource::compact_pool(double min_fragmentation) {
+    std::lock_guard<std::mutex> guard(manager_mutex);
+    if (!isInitialized()) {
+        return false;
+    }
+    return initialized_resource->compact_pool(min_fragmentation);
+}
+
+void blazing_device_memory_resource::set_compaction_policy(std::chrono::milliseconds interval, double min_fragmentation) {
+    static std::atomic<long long> compaction_interval_ms{0};
+    static std::atomic<double> compaction_min_fragmentation{0};
+    static std::atomic<bool> compactor_started{false};
+
+    compaction_interval_ms = interval.count();
+    compaction_min_fragmentation = min_fragmentation;
+    if (interval.count() <= 0 || compactor_started.exchange(true)) {
+        return;
+    }
+    // the pool can only be compacted when nothing is allocated from it, so the thread just tries from time to time
+    std::thread([]() {
+        while (true) {
+            long long interval_ms = compaction_interval_ms.load();
+            std::this_thread::sleep_for(std::chrono::milliseconds(std::max(interval_ms, 100LL)));
+            if (interval_ms > 0) {
+                getInstance().compact_pool(compaction_min_fragmentation.load());
+            }
+        }
+    }).detach();
+}
+
 void blazing_device_memory_resource::reset_max_memory_used(size_t to) {
     initialized_resource->reset_max_memory_used(to);
 }
 
+size_t blazing_device_memory_resource::get_thread_max_memory_used() {
+    return thread_max_memory_used > 0 ? static_cast<size_t>(thread_max_memory_used) : 0;
+}
+
+void blazing_device_memory_resource::reset_thread_max_memory_used() {
+    thread_memory_used = 0;
+    thread_max_memory_used = 0;
+}
+
+int64_t blazing_device_memory_resource::get_thread_memory_used() {
+    return thread_memory_used;
+}
+
+void blazing_device_memory_resource::add_thread_memory_used(int64_t bytes, size_t peak_bytes) {
+    thread_max_memory_used = std::max<std::int64_t>(thread_max_memory_used, thread_memory_used + static_cast<std::int64_t>(peak_bytes));
+    thread_memory_used += bytes;
+}
+
 void blazing_device_memory_resource::initialize(std::string allocation_mode,
                 std::size_t initial_pool_size,
                 std::size_t maximum_pool_size,
@@ -232,7 +452,7 @@ internal_blazing_host_memory_resource::internal_blazing_host_memory_resource(flo
     if (sysinfo(&si) < 0) {
         std::cerr << "@@ error sysinfo host "<< std::endl;
     } 
-    total_memory_size = (size_t)si.freeram;
+    total_memory_size = std::min((size_t)si.freeram, get_cgroup_available_memory());
     used_memory_size = 0;
     memory_limit = custom_threshold * total_memory_size;
 }
@@ -255,7 +475,17 @@ size_t internal_blazing_host_memory_resource::get_from_driver_used_memory()  {
 }
 
 size_t internal_blazing_host_memory_resource::get_memory_used() {
-    return used_memory_size;
+    return used_memory_size + get_host_pools_usage().total_bytes;
+}
+
+bool internal_blazing_host_memory_resource::can_hold(std::size_t bytes) {
+    ral::memory::allocation_pool::usage_stats pools_usage = get_host_pools_usage();
+    std::size_t new_bytes = bytes > pools_usage.free_bytes ? bytes - pools_usage.free_bytes : 0;
+    return used_memory_size + pools_usage.total_bytes + new_bytes < memory_limit;
+}
+
+bool internal_blazing_host_memory_resource::is_over_limit() {
+    return get_memory_used() > memory_limit;
 }
 
 size_t internal_blazing_host_memory_resource::get_total_memory() {
@@ -294,6 +524,14 @@ size_t internal_blazing_host_memory_resource::get_memory_limit() {
         initialized_resource->deallocate(bytes);
     }
 
+    bool blazing_host_memory_resource::can_hold(std::size_t bytes) {
+        return initialized_resource->can_hold(bytes);
+    }
+
+    bool blazing_host_memory_resource::is_over_limit() {
+        return is_initialized && initialized_resource->is_over_limit();
+    }
+
     void blazing_host_memory_resource::initialize(float host_mem_resouce_consumption_thresh) {
         
         std::lock_guard<std::mutex> guard(manager_mutex);
@@ -325,7 +563,7 @@ size_t internal_blazing_host_memory_resource::get_memory_limit() {
 // BEGIN blazing_disk_memory_resource
 
 // TODO: percy, cordova.Improve the design of get memory in real time 
-blazing_disk_memory_resource::blazing_disk_memory_resource(float custom_threshold) {
+blazing_disk_memory_resource::blazing_disk_memory_resource(float custom_threshold) : threshold(custom_threshold) {
     struct statvfs stat_disk;
     statvfs("/", &stat_disk);
 
@@ -345,6 +583,63 @@ size_t blazing_disk_memory_resource::get_from_driver_used_memory() {
     return used_memory_size;
 }
 
+void blazing_disk_memory_resource::initialize(const std::vector<std::string> & directories, size_t capacity_per_directory) {
+    std::lock_guard<std::mutex> lock(directories_mutex);
+    this->directories.clear();
+    this->next_directory = 0;
+    total_memory_size = 0;
+    memory_limit = 0;
+    for (auto & path : directories) {
+        mkdir(path.c_str(), 0777); // fails harmlessly if it already exists
+
+        struct statvfs stat_disk;
+        size_t filesystem_size = 0;
+        if (statvfs(path.c_str(), &stat_disk) == 0) {
+            filesystem_size = (size_t)(stat_disk.f_blocks * stat_disk.f_frsize);
+        }
+        size_t capacity = capacity_per_directory > 0 ? capacity_per_directory : (size_t)(threshold * filesystem_size);
+        this->directories.push_back({path, capacity, 0});
+        total_memory_size += filesystem_size;
+        memory_limit += capacity;
+    }
+    used_memory_size = 0;
+}
+
+std::string blazing_disk_memory_resource::reserve_spill_directory(size_t bytes) {
+    std::lock_guard<std::mutex> lock(directories_mutex);
+    for (size_t i = 0; i < directories.size(); i++) {
+        auto & directory = directories[(next_directory + i) % directories.size()];
+        if (directory.used + bytes <= directory.capacity) {
+            directory.used += bytes;
+            used_memory_size += bytes;
+            next_directory = (next_directory + i + 1) % directories.size();
+            return directory.path;
+        }
+    }
+    return std::string();
+}
+
+void blazing_disk_memory_resource::release_spill_directory(const std::string & path, size_t bytes) {
+    std::lock_guard<std::mutex> lock(directories_mutex);
+    for (auto & directory : directories) {
+        if (directory.path == path) {
+            bytes = std::min(bytes, directory.used);
+            directory.used -= bytes;
+            used_memory_size -= bytes;
+            return;
+        }
+    }
+}
+
+std::vector<std::string> blazing_disk_memory_resource::get_spill_directories() {
+    std::lock_guard<std::mutex> lock(directories_mutex);
+    std::vector<std::string> paths;
+    for (auto & directory : directories) {
+        paths.push_back(directory.path);
+    }
+    return paths;
+}
+
 size_t blazing_disk_memory_resource::get_memory_limit() {
     return memory_limit;
 }
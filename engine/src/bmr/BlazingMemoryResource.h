@@ -2,7 +2,11 @@
 
 #include <cassert>
 #include <atomic>
+#include <chrono>
+#include <mutex>
 #include <set>
+#include <string>
+#include <vector>
 
 #include <cuda_runtime_api.h>
 
@@ -19,6 +23,7 @@
 #pragma GCC diagnostic pop
 
 #include "config/GPUManager.cuh"
+#include "PoolFragmentation.h"
 
 #include <sys/sysinfo.h>
 #include <sys/statvfs.h>
@@ -63,6 +68,13 @@ public:
     std::string get_full_memory_summary();
     void reset_max_memory_used(size_t to = 0) noexcept;
 
+    /**
+     * @brief Replaces the pool of the pool allocators by one made of a single chunk, when nothing is allocated from it
+     * and it is at least min_fragmentation fragmented, see ral::memory::fragmentation_report.
+     * @return whether it was compacted.
+     */
+    bool compact_pool(double min_fragmentation);
+
 private:
     void* do_allocate(size_t bytes, rmm::cuda_stream_view stream) override;
     void do_deallocate(void* p, size_t bytes, rmm::cuda_stream_view stream) override;
@@ -77,6 +89,8 @@ private:
     rmm::mr::device_memory_resource * memory_resource;
     std::unique_ptr<rmm::mr::logging_resource_adaptor<rmm::mr::device_memory_resource>> logging_adaptor;
     std::string type;
+    bool track_owners; // whether the allocations are attributed to the query and kernel that make them
+    ral::memory::tracked_pool_memory_resource * tracked_pool = nullptr; // the pool of the pool allocators, owned by memory_resource_owner
 };
 
 // forward declaration
@@ -114,10 +128,52 @@ public:
 
     std::string get_type();
 
+    /** -----------------------------------------------------------------------*
+     * @brief Whether the memory comes from Unified Virtual Memory, which can be oversubscribed and take hints of where to live.
+     * ----------------------------------------------------------------------**/
+    bool is_managed();
+
     std::string get_full_memory_summary();
+
+    /** -----------------------------------------------------------------------*
+     * @brief Compacts the pool of the pool allocators when nothing is allocated from it, see
+     * internal_blazing_device_memory_resource::compact_pool.
+     * ----------------------------------------------------------------------**/
+    bool compact_pool(double min_fragmentation);
+
+    /** -----------------------------------------------------------------------*
+     * @brief Tries to compact the pool every interval, so that a long running worker gets its pool back in one piece
+     * between queries. It is set by DEVICE_POOL_COMPACTION_INTERVAL_MS when the engine is initialized, 0 turns it off.
+     * ----------------------------------------------------------------------**/
+    void set_compaction_policy(std::chrono::milliseconds interval, double min_fragmentation);
     
     void reset_max_memory_used(size_t to = 0);
 
+    /** -----------------------------------------------------------------------*
+     * @brief Get the peak of the memory allocated by the calling thread since the last call to reset_thread_max_memory_used.
+     * Memory allocated by the thread and deallocated by another one is still counted as used.
+     * ----------------------------------------------------------------------**/
+    static size_t get_thread_max_memory_used();
+
+    /** -----------------------------------------------------------------------*
+     * @brief Starts measuring the memory allocated by the calling thread from zero.
+     * ----------------------------------------------------------------------**/
+    static void reset_thread_max_memory_used();
+
+    /** -----------------------------------------------------------------------*
+     * @brief Get the memory allocated minus the memory deallocated by the calling thread since the last call to
+     * reset_thread_max_memory_used.
+     * ----------------------------------------------------------------------**/
+    static int64_t get_thread_memory_used();
+
+    /** -----------------------------------------------------------------------*
+     * @brief Counts for the calling thread the memory that other threads allocated for it, like the branches of a
+     * stream_fork_join, so that it is part of the peak of the task that the thread is running.
+     * @param bytes the memory the other threads still have allocated, which the calling thread deallocates later.
+     * @param peak_bytes the peak of the memory the other threads allocated, on top of what the calling thread uses.
+     * ----------------------------------------------------------------------**/
+    static void add_thread_memory_used(int64_t bytes, size_t peak_bytes);
+
   /** -----------------------------------------------------------------------*
    * @brief Initialize RMM options
    * 
@@ -169,6 +225,11 @@ private:
 
 /**
     @brief This class represents a custom host memory resource used in the cache system.
+    It accounts the host memory the engine owns: the memory of the host, pinned and upload pools, which hold the
+    BlazingHostTables and the messages, whether their chunks are in use or not, plus the host buffers outside of the
+    pools that are counted with allocate and deallocate. The limit is a fraction of the memory that was free when it was
+    created, and of the memory that the cgroup of the process could still use, so that containers spill before they are
+    killed.
 */
 class internal_blazing_host_memory_resource{
 public:
@@ -189,6 +250,11 @@ public:
 
     size_t get_memory_limit();
 
+    // whether the bytes fit in the limit, besides the ones the free chunks of the pools can take
+    bool can_hold(std::size_t bytes);
+
+    bool is_over_limit();
+
 private:
     size_t memory_limit;
     size_t total_memory_size;
@@ -226,6 +292,11 @@ public:
 
     void deallocate(std::size_t bytes);
 
+    bool can_hold(std::size_t bytes);
+
+    // the MemoryMonitor moves the data of the caches from host memory to disk while this is true
+    bool is_over_limit();
+
    /** -----------------------------------------------------------------------*
    * @brief Initialize
    * 
@@ -265,6 +336,12 @@ private:
 /**
 	@brief This class represents a custom disk memory resource used in the cache system.
 */
+/**
+    @brief The disk tier of the caches.
+    The spill files can be spread over several directories (i.e. one per drive) to add up their bandwidth.
+    Every file goes to the next directory, round robin, that has room for it, and the bytes used by the files
+    of every directory are tracked against the capacity of that directory.
+*/
 class blazing_disk_memory_resource : public  BlazingMemoryResource {
 public:
     static blazing_disk_memory_resource& getInstance() {
@@ -278,6 +355,31 @@ public:
 
     virtual ~blazing_disk_memory_resource() = default;
 
+    /**
+    * Sets the directories where the spill files are written. The directories that do not exist are created.
+    * @param directories the directories.
+    * @param capacity_per_directory the bytes that the files of a directory can use. If it is 0, the capacity of a
+    * directory is the threshold times the size of the filesystem it is in.
+    */
+    void initialize(const std::vector<std::string> & directories, size_t capacity_per_directory);
+
+    /**
+    * Picks the directory where a spill file goes and accounts its bytes.
+    * @param bytes the bytes of the file.
+    * @return the directory, or an empty string if no directory has room for the file.
+    */
+    std::string reserve_spill_directory(size_t bytes);
+
+    /**
+    * Gives back the bytes of a spill file that was removed. Directories that are not spill directories are ignored.
+    */
+    void release_spill_directory(const std::string & directory, size_t bytes);
+
+    /**
+    * Get the directories where the spill files are written.
+    */
+    std::vector<std::string> get_spill_directories();
+
     virtual size_t get_from_driver_used_memory();
 
     size_t get_memory_limit();
@@ -287,7 +389,18 @@ public:
     size_t get_total_memory();
 
 private:
+    struct spill_directory {
+        std::string path;
+        size_t capacity;
+        size_t used;
+    };
+
+    float threshold;
     size_t total_memory_size;
     size_t memory_limit;
     std::atomic<size_t> used_memory_size;
+
+    std::mutex directories_mutex;
+    std::vector<spill_directory> directories;
+    size_t next_directory = 0;
 };
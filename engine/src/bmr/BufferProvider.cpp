@@ -1,8 +1,14 @@
 #include "BufferProvider.h"
 
 #include <iostream>
+#include <fstream>
+#include <sstream>
 #include <mutex>
 #include <cstring>
+#include <algorithm>
+#include <thread>
+#include <sched.h>
+#include <unistd.h>
 #include <cuda.h>
 #include <cuda_runtime.h>
 
@@ -13,9 +19,78 @@
 #include <spdlog/sinks/basic_file_sink.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
 
+#include <blazingdb/io/FileSystem/ObjectUploadConfig.h>
+
 namespace ral{
 namespace memory{
 
+int get_device_numa_node(int device_id) {
+  char pci_bus_id[32];
+  if (cudaDeviceGetPCIBusId(pci_bus_id, sizeof(pci_bus_id), device_id) != cudaSuccess) {
+    return -1;
+  }
+  // sysfs uses lowercase hexadecimal digits in the pci addresses
+  std::string bus_id(pci_bus_id);
+  std::transform(bus_id.begin(), bus_id.end(), bus_id.begin(), ::tolower);
+  std::ifstream numa_node_file("/sys/bus/pci/devices/" + bus_id + "/numa_node");
+  int numa_node = -1;
+  if (!(numa_node_file >> numa_node)) {
+    return -1;
+  }
+  return numa_node; // the kernel reports -1 when the machine has a single node
+}
+
+std::vector<int> parse_cpu_list(const std::string & cpu_list) {
+  std::vector<int> cpus;
+  std::stringstream ranges(cpu_list);
+  std::string range;
+  while (std::getline(ranges, range, ',')) {
+    if (range.find_first_not_of(" \n") == std::string::npos) {
+      continue;
+    }
+    std::size_t dash = range.find('-');
+    int first = std::stoi(range.substr(0, dash));
+    int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+    for (int cpu = first; cpu <= last; cpu++) {
+      cpus.push_back(cpu);
+    }
+  }
+  return cpus;
+}
+
+numa_affinity_scope::numa_affinity_scope(int numa_node) : bound{false} {
+  if (numa_node < 0) {
+    return;
+  }
+  std::ifstream cpu_list_file("/sys/devices/system/node/node" + std::to_string(numa_node) + "/cpulist");
+  std::string cpu_list;
+  if (!std::getline(cpu_list_file, cpu_list)) {
+    return;
+  }
+  std::vector<int> cpus;
+  try {
+    cpus = parse_cpu_list(cpu_list);
+  } catch (const std::exception & e) {
+    return;
+  }
+  if (cpus.empty() || pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t), &previous_affinity) != 0) {
+    return;
+  }
+
+  cpu_set_t node_affinity;
+  CPU_ZERO(&node_affinity);
+  for (int cpu : cpus) {
+    CPU_SET(cpu, &node_affinity);
+  }
+  bound = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &node_affinity) == 0;
+}
+
+numa_affinity_scope::~numa_affinity_scope() {
+  if (bound) {
+    pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &previous_affinity);
+  }
+}
+
 pinned_allocator::pinned_allocator() :
 use_ucx{false} {
 }
@@ -27,6 +102,7 @@ void pinned_allocator::setUcpContext(ucp_context_h _context)
     }
 
 void base_allocator::allocate(void ** ptr, std::size_t size){
+  numa_affinity_scope affinity(this->numa_node);
   do_allocate(ptr,size);
 }
 
@@ -37,14 +113,22 @@ void base_allocator::deallocate(void * ptr){
 void host_allocator::do_allocate(void ** ptr, std::size_t size){
   
   *ptr = aligned_alloc( BLAZING_ALIGNMENT, size );
-  if (!ptr) {
+  if (!*ptr) {
     throw std::runtime_error("Couldn't perform host allocation.");
   }
+  if (this->numa_node >= 0) {
+    // the pages are placed when they are first touched, so we touch them now that the thread is bound to the node
+    std::size_t page_size = sysconf(_SC_PAGESIZE);
+    for (std::size_t offset = 0; offset < size; offset += page_size) {
+      static_cast<char *>(*ptr)[offset] = 0;
+    }
+  }
 }
 
 void pinned_allocator::do_allocate(void ** ptr, std::size_t size){
 
   // do we really want to do a host allocation instead of a device one? (have to try zero-copy later)
+  // cudaMallocHost touches the pages to pin them, so they are placed on the node the calling thread is bound to
   cudaError_t err = cudaMallocHost(ptr, size);
   if (err != cudaSuccess) {
     throw std::runtime_error("Couldn't perform pinned allocation.");
@@ -60,11 +144,16 @@ void pinned_allocator::do_allocate(void ** ptr, std::size_t size){
     mem_map_params.length = size;
     mem_map_params.flags = 0; // try UCP_MEM_MAP_NONBLOCK
 
-    ucs_status_t status = ucp_mem_map(context, &mem_map_params, &mem_handle);
+    ucp_mem_h allocation_handle;
+    ucs_status_t status = ucp_mem_map(context, &mem_map_params, &allocation_handle);
     if (status != UCS_OK)
         {
         throw std::runtime_error("Error on ucp_mem_map");
         }
+    if (mem_handles.empty()) {
+      mem_handle = allocation_handle;
+    }
+    mem_handles[*ptr] = allocation_handle;
   }
 }
 
@@ -73,9 +162,11 @@ void host_allocator::do_deallocate(void * ptr){
 }
 
 void pinned_allocator::do_deallocate(void * ptr){
-  if (use_ucx)
+  auto handle = mem_handles.find(ptr);
+  if (use_ucx && handle != mem_handles.end())
      {
-     ucs_status_t status = ucp_mem_unmap(context, mem_handle);
+     ucs_status_t status = ucp_mem_unmap(context, handle->second);
+     mem_handles.erase(handle);
      if (status != UCS_OK)
         {
         throw std::runtime_error("Error on ucp_mem_map");
@@ -88,25 +179,135 @@ void pinned_allocator::do_deallocate(void * ptr){
 }
 
 
-allocation_pool::allocation_pool(std::unique_ptr<base_allocator> allocator, std::size_t size_buffers, std::size_t num_buffers) :
-num_buffers (num_buffers), buffer_size(size_buffers), allocator(std::move(allocator)) {
+struct allocation_pool::thread_chunk_cache {
+  std::weak_ptr<allocation_pool> pool;
+  std::size_t generation;
+  std::vector<std::unique_ptr<blazing_allocation_chunk>> chunks;
+
+  ~thread_chunk_cache() {
+    // when the thread exits its chunks go back to the pool, unless the pool is gone or was emptied since
+    auto owner = pool.lock();
+    if (owner && owner->generation.load() == generation) {
+      std::unique_lock<std::mutex> lock(owner->in_use_mutex);
+      for (auto & chunk : chunks) {
+        owner->return_chunk(std::move(chunk));
+      }
+    }
+  }
+};
+
+allocation_pool::allocation_pool(std::unique_ptr<base_allocator> allocator, std::size_t size_buffers, std::size_t num_buffers, std::size_t thread_cache_size,
+  bool lazy) :
+thread_cache_size(thread_cache_size), generation{0}, num_buffers (num_buffers), buffer_size(size_buffers), allocator(std::move(allocator)) {
   this->buffer_counter = 0; // this will get incremented by grow()
   this->allocation_counter = 0;
-  this->grow();
-  
+  this->high_water_counter = 0;
+  this->grow_counter = 0;
+  this->shrink_counter = 0;
+  this->shrink_idle_time = std::chrono::milliseconds(0);
+  if (!lazy) {
+    this->grow();
+  }
 }
 
 allocation_pool::~allocation_pool(){
   free_all();
 }
 
+allocation_pool::thread_chunk_cache * allocation_pool::get_thread_cache() {
+  if (this->thread_cache_size == 0) {
+    return nullptr;
+  }
+  std::weak_ptr<allocation_pool> self = weak_from_this();
+  if (self.expired()) {
+    return nullptr;
+  }
+
+  static thread_local std::vector<std::unique_ptr<thread_chunk_cache>> thread_caches;
+  thread_chunk_cache * unused_cache = nullptr;
+  for (auto & cache : thread_caches) {
+    if (!cache->pool.owner_before(self) && !self.owner_before(cache->pool)) {
+      if (cache->generation != this->generation.load()) {
+        cache->chunks.clear(); // their memory was released by free_all()
+        cache->generation = this->generation.load();
+      }
+      return cache.get();
+    }
+    if (cache->pool.expired()) {
+      unused_cache = cache.get();
+    }
+  }
+
+  if (unused_cache == nullptr) {
+    thread_caches.push_back(std::make_unique<thread_chunk_cache>());
+    unused_cache = thread_caches.back().get();
+  }
+  unused_cache->chunks.clear();
+  unused_cache->pool = self;
+  unused_cache->generation = this->generation.load();
+  return unused_cache;
+}
+
 // TODO: consider adding some kind of priority
 // based on when the request was made
 
 std::unique_ptr<blazing_allocation_chunk> allocation_pool::get_chunk() {
+  thread_chunk_cache * cache = get_thread_cache();
+  if (cache == nullptr) {
+    std::unique_lock<std::mutex> lock(in_use_mutex);
+    auto chunk = take_chunk();
+    this->allocation_counter++;
+    update_high_water();
+    return std::move(chunk);
+  }
+
+  if (cache->chunks.empty()) {
+    // we refill half of the cache at once, so that the next calls don't need the lock
+    std::unique_lock<std::mutex> lock(in_use_mutex);
+    for (std::size_t i = 0; i < (this->thread_cache_size + 1) / 2; i++) {
+      cache->chunks.push_back(take_chunk());
+    }
+  }
+  auto chunk = std::move(cache->chunks.back());
+  cache->chunks.pop_back();
+  this->allocation_counter++;
+  update_high_water();
+  return std::move(chunk);
+}
+
+std::unique_ptr<blazing_allocation_chunk> allocation_pool::get_chunk(std::size_t min_bytes) {
+  for (auto it = this->size_classes.rbegin(); it != this->size_classes.rend(); ++it) {
+    if ((*it)->size_buffers() >= min_bytes) {
+      return (*it)->get_chunk();
+    }
+  }
+  return get_chunk();
+}
+
+void allocation_pool::update_high_water() {
+  int allocated = this->allocation_counter.load();
+  int high_water = this->high_water_counter.load();
+  while (allocated > high_water && !this->high_water_counter.compare_exchange_weak(high_water, allocated)) {
+  }
+}
+
+void allocation_pool::add_size_class(std::shared_ptr<allocation_pool> size_class) {
   std::unique_lock<std::mutex> lock(in_use_mutex);
-  
+  size_class->set_shrink_idle_time(this->shrink_idle_time);
+  this->size_classes.push_back(size_class);
+}
 
+void allocation_pool::set_shrink_idle_time(std::chrono::milliseconds idle_time) {
+  {
+    std::unique_lock<std::mutex> lock(in_use_mutex);
+    this->shrink_idle_time = idle_time;
+  }
+  for (auto & size_class : this->size_classes) {
+    size_class->set_shrink_idle_time(idle_time);
+  }
+}
+
+std::unique_ptr<blazing_allocation_chunk> allocation_pool::take_chunk() {
   bool found_mem = false;
   for(auto & allocation : allocations){
     if(!allocation->allocation_chunks.empty()){
@@ -120,7 +321,6 @@ std::unique_ptr<blazing_allocation_chunk> allocation_pool::get_chunk() {
   }
   for(auto & allocation : allocations){
     if(!allocation->allocation_chunks.empty()){
-        this->allocation_counter++;
         auto temp = std::move(allocation->allocation_chunks.top());
         allocation->allocation_chunks.pop();
         
@@ -137,6 +337,9 @@ std::unique_ptr<blazing_allocation_chunk> allocation_pool::get_chunk() {
 void allocation_pool::grow() {
   // if this is the first growth (initializaton) then we want num_buffers, else we will just grow by half that.
   std::size_t num_new_buffers = this->buffer_counter == 0 ? this->num_buffers : this->num_buffers/2;
+  if (this->buffer_counter != 0) {
+    this->grow_counter++;
+  }
   allocations.push_back(std::make_unique<blazing_allocation>());
   allocations.back()->index = this->allocations.size() - 1;
   auto last_index = allocations.size() -1;
@@ -159,8 +362,32 @@ void allocation_pool::grow() {
 }
 
 void allocation_pool::free_chunk(std::unique_ptr<blazing_allocation_chunk> buffer) {
-  std::unique_lock<std::mutex> lock(in_use_mutex);
+  if (buffer->allocation != nullptr && buffer->allocation->pool != this) {
+    buffer->allocation->pool->free_chunk(std::move(buffer)); // it comes from one of the size classes
+    return;
+  }
+  this->allocation_counter--;
+  thread_chunk_cache * cache = get_thread_cache();
+  if (cache == nullptr) {
+    std::unique_lock<std::mutex> lock(in_use_mutex);
+    return_chunk(std::move(buffer));
+    return;
+  }
+
+  if (cache->chunks.size() >= this->thread_cache_size) {
+    // we give back half of the cache at once, so that the next calls don't need the lock
+    std::unique_lock<std::mutex> lock(in_use_mutex);
+    while (cache->chunks.size() > this->thread_cache_size / 2) {
+      return_chunk(std::move(cache->chunks.back()));
+      cache->chunks.pop_back();
+    }
+  }
+  cache->chunks.push_back(std::move(buffer));
+}
+
+void allocation_pool::return_chunk(std::unique_ptr<blazing_allocation_chunk> buffer) {
   const std::size_t idx = buffer->allocation->index;
+  blazing_allocation * allocation = buffer->allocation;
 
   if (idx+1 > this->allocations.size()) {
     std::shared_ptr<spdlog::logger> logger = spdlog::get("batch_logger");
@@ -170,32 +397,90 @@ void allocation_pool::free_chunk(std::unique_ptr<blazing_allocation_chunk> buffe
     assert(("free_chunk cannot delete an invalid allocation.", idx < this->allocations.size()));
   }
 
-  buffer->allocation->allocation_chunks.push(std::move(buffer));
+  allocation->allocation_chunks.push(std::move(buffer));
 
-  if (idx > 0) {
-    if (this->allocations.at(idx)->total_number_of_chunks == this->allocations.at(idx)->allocation_chunks.size()) {
-      auto it = this->allocations.begin();
-      std::advance(it, idx);
-      if ((*it)->data != nullptr) {
-        this->allocator->deallocate((*it)->data);
-        this->allocations.erase(it);
+  if (allocation->total_number_of_chunks == allocation->allocation_chunks.size()) {
+    allocation->idle_since = std::chrono::steady_clock::now();
+    if (idx > 0 && this->shrink_idle_time.count() == 0) {
+      release_allocation(idx);
+    }
+  }
+}
 
-        // for all allocations after the pos at idx
-        // we need to update the allocation.index after we deleted one
-        for (std::size_t i = idx; i < this->allocations.size(); ++i) {
-          this->allocations[i]->index = this->allocations[i]->index - 1;
+void allocation_pool::release_allocation(std::size_t idx) {
+  auto it = this->allocations.begin();
+  std::advance(it, idx);
+  if ((*it)->data != nullptr) {
+    this->allocator->deallocate((*it)->data);
+    this->buffer_counter -= (*it)->total_number_of_chunks;
+    this->shrink_counter++;
+    this->allocations.erase(it);
+
+    // for all allocations after the pos at idx
+    // we need to update the allocation.index after we deleted one
+    for (std::size_t i = idx; i < this->allocations.size(); ++i) {
+      this->allocations[i]->index = this->allocations[i]->index - 1;
+    }
+  }
+}
+
+std::size_t allocation_pool::shrink() {
+  std::size_t released_bytes = 0;
+  {
+    std::unique_lock<std::mutex> lock(in_use_mutex);
+    if (this->shrink_idle_time.count() > 0) {
+      auto now = std::chrono::steady_clock::now();
+      // from the last one, so that releasing an allocation doesn't move the ones that are still to be checked
+      for (std::size_t idx = this->allocations.size(); idx-- > 1;) {
+        auto & allocation = this->allocations[idx];
+        if (allocation->total_number_of_chunks == allocation->allocation_chunks.size() &&
+            now - allocation->idle_since >= this->shrink_idle_time) {
+          released_bytes += allocation->size;
+          release_allocation(idx);
         }
       }
     }
   }
+  for (auto & size_class : this->size_classes) {
+    released_bytes += size_class->shrink();
+  }
+  return released_bytes;
+}
 
-  this->allocation_counter--;
+allocation_pool::usage_stats allocation_pool::get_usage_stats() {
+  usage_stats stats;
+  {
+    std::unique_lock<std::mutex> lock(in_use_mutex);
+    for (auto & allocation : this->allocations) {
+      stats.total_bytes += allocation->size;
+    }
+    stats.grows = this->grow_counter;
+    stats.shrinks = this->shrink_counter;
+  }
+  stats.allocated_bytes = std::max(this->allocation_counter.load(), 0) * this->buffer_size;
+  stats.free_bytes = stats.total_bytes > stats.allocated_bytes ? stats.total_bytes - stats.allocated_bytes : 0;
+  stats.high_water_bytes = this->high_water_counter.load() * this->buffer_size;
+
+  for (auto & size_class : this->size_classes) {
+    usage_stats class_stats = size_class->get_usage_stats();
+    stats.total_bytes += class_stats.total_bytes;
+    stats.allocated_bytes += class_stats.allocated_bytes;
+    stats.free_bytes += class_stats.free_bytes;
+    stats.high_water_bytes += class_stats.high_water_bytes;
+    stats.grows += class_stats.grows;
+    stats.shrinks += class_stats.shrinks;
+  }
+  return stats;
 }
 
 
 void allocation_pool::free_all() {
+  for (auto & size_class : this->size_classes) {
+    size_class->free_all();
+  }
   std::unique_lock<std::mutex> lock(in_use_mutex);
   if (this->buffer_counter > 0){
+    this->generation++;
     this->buffer_counter = 0;
     for(auto & allocation : allocations){
       while (false == allocation->allocation_chunks.empty()) {
@@ -211,34 +496,123 @@ void allocation_pool::free_all() {
 
 std::size_t allocation_pool::size_buffers() { return this->buffer_size; }
 
+// the size classes are not worth it for chunks smaller than this
+const std::size_t min_size_class_bytes = 64 * 1024;
 
 void set_allocation_pools(std::size_t size_buffers_host, std::size_t num_buffers_host,
 std::size_t size_buffers_pinned, std::size_t num_buffers_pinned, bool map_ucx,
-    ucp_context_h context) {
-
-  if (buffer_providers::get_host_buffer_provider() == nullptr || buffer_providers::get_host_buffer_provider()->get_total_buffers() == 0) { // not initialized
+    ucp_context_h context, int numa_node, std::size_t thread_cache_size, bool lazy, std::size_t num_size_classes) {
 
+  auto make_host_allocator = [numa_node]() {
     auto host_alloc = std::make_unique<host_allocator>(false);
+    host_alloc->set_numa_node(numa_node);
+    return host_alloc;
+  };
+  auto make_pinned_allocator = [numa_node, map_ucx, context]() {
+    auto pinned_alloc = std::make_unique<pinned_allocator>();
+    pinned_alloc->set_numa_node(numa_node);
+    if (map_ucx) {
+      pinned_alloc->setUcpContext(context);
+    }
+    return pinned_alloc;
+  };
+
+  // the size classes are always lazy, since most of them are only used for the last chunk of the tables
+  auto add_size_classes = [&](std::shared_ptr<allocation_pool> & pool, bool pinned) {
+    for (std::size_t i = 1; i <= num_size_classes; i++) {
+      std::size_t class_size_buffers = (size_buffers_host >> (2 * i)) / BLAZING_ALIGNMENT * BLAZING_ALIGNMENT;
+      if (class_size_buffers < min_size_class_bytes) {
+        break;
+      }
+      std::unique_ptr<base_allocator> class_alloc;
+      if (pinned) {
+        class_alloc = make_pinned_allocator();
+      } else {
+        class_alloc = make_host_allocator();
+      }
+      pool->add_size_class(std::make_shared<allocation_pool>(std::move(class_alloc),
+        class_size_buffers, num_buffers_host, thread_cache_size, true));
+    }
+  };
 
+  if (buffer_providers::get_host_buffer_provider() == nullptr || buffer_providers::get_host_buffer_provider()->get_total_buffers() == 0) { // not initialized
     buffer_providers::get_host_buffer_provider() = std::make_shared<allocation_pool>(
-    std::move(host_alloc) ,size_buffers_host,num_buffers_host);
+    make_host_allocator() ,size_buffers_host,num_buffers_host, thread_cache_size, lazy);
+    add_size_classes(buffer_providers::get_host_buffer_provider(), false);
   }
 
   if (buffer_providers::get_pinned_buffer_provider() == nullptr || buffer_providers::get_pinned_buffer_provider()->get_total_buffers() == 0) { // not initialized
-    auto pinned_alloc = std::make_unique<pinned_allocator>();
+    buffer_providers::get_pinned_buffer_provider() = std::make_shared<allocation_pool>(make_pinned_allocator(),
+      size_buffers_host,num_buffers_host, thread_cache_size, lazy);
+    add_size_classes(buffer_providers::get_pinned_buffer_provider(), true);
+  }
+}
 
-    if (map_ucx) {
-      pinned_alloc->setUcpContext(context);
+void set_pool_shrink_policy(std::chrono::milliseconds idle_time) {
+  static std::atomic<long long> shrink_idle_ms{0};
+  static std::atomic<bool> shrinker_started{false};
+
+  shrink_idle_ms = idle_time.count();
+  for (auto pool : {buffer_providers::get_host_buffer_provider(), buffer_providers::get_pinned_buffer_provider()}) {
+    if (pool != nullptr) {
+      pool->set_shrink_idle_time(idle_time);
     }
+  }
 
-    buffer_providers::get_pinned_buffer_provider() = std::make_shared<allocation_pool>(std::move(pinned_alloc),
-      size_buffers_host,num_buffers_host);
+  if (idle_time.count() <= 0 || shrinker_started.exchange(true)) {
+    return;
   }
+  // the pools are only replaced when the engine is initialized, so the thread just checks them from time to time
+  std::thread([]() {
+    while (true) {
+      long long idle_ms = shrink_idle_ms.load();
+      std::this_thread::sleep_for(std::chrono::milliseconds(std::max(idle_ms / 2, 100LL)));
+      if (idle_ms <= 0) {
+        continue;
+      }
+      for (auto pool : {buffer_providers::get_host_buffer_provider(), buffer_providers::get_pinned_buffer_provider()}) {
+        if (pool != nullptr) {
+          pool->shrink();
+        }
+      }
+    }
+  }).detach();
+}
+
+void set_upload_allocation_pool(std::size_t size_buffers, std::size_t num_buffers, int numa_node) {
+  if (buffer_providers::get_upload_buffer_provider() == nullptr || buffer_providers::get_upload_buffer_provider()->get_total_buffers() == 0) { // not initialized
+    auto pinned_alloc = std::make_unique<pinned_allocator>();
+    pinned_alloc->set_numa_node(numa_node);
+
+    // the parts are filled and uploaded by different threads, so the chunks are not kept by thread caches
+    buffer_providers::get_upload_buffer_provider() = std::make_shared<allocation_pool>(std::move(pinned_alloc),
+      size_buffers, num_buffers, 0);
+  }
+
+  std::weak_ptr<allocation_pool> weak_pool = buffer_providers::get_upload_buffer_provider();
+  ObjectUploadConfig::getInstance().setAllocator([weak_pool](int64_t nbytes) -> std::shared_ptr<char> {
+    std::shared_ptr<allocation_pool> pool = weak_pool.lock();
+    if (pool == nullptr || static_cast<std::size_t>(nbytes) > pool->size_buffers()) {
+      return std::shared_ptr<char>(new char[nbytes], std::default_delete<char[]>());
+    }
+    blazing_allocation_chunk * chunk = pool->get_chunk().release();
+    return std::shared_ptr<char>(chunk->data, [weak_pool, chunk](char *) {
+      std::unique_ptr<blazing_allocation_chunk> owned_chunk(chunk);
+      std::shared_ptr<allocation_pool> pool = weak_pool.lock();
+      if (pool != nullptr) {
+        pool->free_chunk(std::move(owned_chunk));
+      }
+    });
+  });
 }
 
 void empty_pools(){
   buffer_providers::get_host_buffer_provider()->free_all();
   buffer_providers::get_pinned_buffer_provider()->free_all();
+  if (buffer_providers::get_upload_buffer_provider() != nullptr) {
+    ObjectUploadConfig::getInstance().setAllocator(nullptr);
+    buffer_providers::get_upload_buffer_provider()->free_all();
+  }
 }
 std::size_t allocation_pool::get_allocated_buffers(){
   return allocation_counter;
@@ -261,7 +635,13 @@ std::pair< std::vector<ral::memory::blazing_chunked_column_info>, std::vector<st
   
   std::vector<std::unique_ptr<ral::memory::blazing_allocation_chunk> > allocations;
   std::vector<ral::memory::blazing_chunked_column_info> chunked_column_infos; 
-  std::unique_ptr<ral::memory::blazing_allocation_chunk> current_allocation = pool->get_chunk();
+
+  // every chunk is taken from the smallest size class that fits the bytes that are left, so the last one is no larger than needed
+  size_t bytes_left = 0;
+  for (size_t buffer_size : buffer_sizes) {
+    bytes_left += buffer_size;
+  }
+  std::unique_ptr<ral::memory::blazing_allocation_chunk> current_allocation = pool->get_chunk(bytes_left);
   
   while(buffer_index < buffer_sizes.size()){
     ral::memory::blazing_chunked_column_info chunked_column_info;
@@ -272,7 +652,7 @@ std::pair< std::vector<ral::memory::blazing_chunked_column_info>, std::vector<st
       if(allocation_position == current_allocation->size){
         allocation_position = 0;
         allocations.push_back(std::move(current_allocation));
-        current_allocation = pool->get_chunk();
+        current_allocation = pool->get_chunk(bytes_left);
       }
       size_t chunk_index = allocations.size();
       size_t offset = allocation_position;
@@ -288,6 +668,7 @@ std::pair< std::vector<ral::memory::blazing_chunked_column_info>, std::vector<st
         buffer_position += size;
         allocation_position += size;
       }
+      bytes_left -= size;
       chunked_column_info.chunk_index.push_back(chunk_index);
       chunked_column_info.offset.push_back(offset);
       chunked_column_info.size.push_back(size);
@@ -5,6 +5,11 @@
 #include <stack>
 #include <mutex>
 #include <memory>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <pthread.h>
+#include <sched.h>
 
 #include <ucp/api/ucp.h>
 
@@ -34,6 +39,7 @@ struct blazing_allocation{
     char *data;    // the pointer to the allocated memory
     std::stack< std::unique_ptr<blazing_allocation_chunk> > allocation_chunks; // These are the available chunks that are part of the allocation. 
     allocation_pool * pool;  // this is the pool that was used to make this allocation, and therefore this is what we would use to free it
+    std::chrono::steady_clock::time_point idle_since; // when all of its chunks were last given back to the pool
 };
 
 struct blazing_allocation_chunk{
@@ -53,12 +59,44 @@ struct blazing_chunked_column_info {
 
 #define BLAZING_ALIGNMENT 64u
 
+/**
+ * Get the NUMA node the PCI bus of a GPU is attached to.
+ * @param device_id the CUDA device.
+ * @return the NUMA node or -1 if it is not known, for example on machines with a single node.
+ */
+int get_device_numa_node(int device_id);
+
+/**
+ * Parses a list of cpus in the format used by /sys/devices/system/node/node<N>/cpulist, i.e. "0-15,32-47".
+ */
+std::vector<int> parse_cpu_list(const std::string & cpu_list);
+
+/**
+ * Binds the calling thread to the cpus of a NUMA node while it is in scope, and restores its previous affinity afterwards.
+ * Since Linux places a page on the node of the thread that first touches it, the memory that is allocated and touched
+ * in this scope is local to that node. It does nothing if the node is -1 or its cpus are not known.
+ */
+class numa_affinity_scope {
+public:
+    numa_affinity_scope(int numa_node);
+    ~numa_affinity_scope();
+
+private:
+    bool bound;
+    cpu_set_t previous_affinity;
+};
+
 class base_allocator{
 public:
-    base_allocator() {}
+    base_allocator() : numa_node{-1} {}
     void allocate(void ** ptr, std::size_t size);
     void deallocate(void * ptr);
 
+    /**
+     * Sets the NUMA node where the memory of the following allocations is placed. -1 lets the OS decide.
+     */
+    void set_numa_node(int numa_node) { this->numa_node = numa_node; }
+
     virtual ucp_mem_h getUcpMemoryHandle() const
         {
         throw std::runtime_error("getUcpMemoryHandle not implemented in base class");
@@ -67,6 +105,7 @@ public:
 protected:
     virtual void do_allocate(void ** ptr, std::size_t size) = 0;
     virtual void do_deallocate(void * ptr) = 0;
+    int numa_node;
 };
 
 class host_allocator : public base_allocator {
@@ -93,17 +132,74 @@ protected:
     void do_deallocate(void * ptr);
     bool use_ucx;
     ucp_context_h context;
-    ucp_mem_h mem_handle;
+    ucp_mem_h mem_handle; // the one of the first allocation
+    std::map<void *, ucp_mem_h> mem_handles; // by the allocation, so that every one is unmapped when it is released
 };
 
-class allocation_pool {
+/**
+ * A pool of fixed size chunks of host memory.
+ * Every thread keeps a small cache of the chunks it freed, so that most calls to get_chunk() and free_chunk()
+ * don't need the mutex of the pool. The cache of a thread is refilled and emptied in batches.
+ * This is only done when the pool is owned by a shared_ptr, since the caches keep a weak_ptr to it.
+ * A pool can have smaller size classes, pools of smaller chunks that get_chunk(min_bytes) takes the small buffers from,
+ * so that they don't hold a whole chunk. The allocations made by growing the pool are released when all of their
+ * chunks have been free for the shrink idle time, see shrink().
+ */
+class allocation_pool : public std::enable_shared_from_this<allocation_pool> {
 public:
-  allocation_pool(std::unique_ptr<base_allocator> allocator, std::size_t size_buffers, std::size_t num_buffers);
+  /**
+   * Constructor
+   * @param allocator the allocator used to grow the pool.
+   * @param size_buffers the size in bytes of every chunk.
+   * @param num_buffers the number of chunks allocated at first. The pool grows by half of this when it runs out of chunks.
+   * @param thread_cache_size the max number of free chunks every thread keeps. 0 disables the thread caches.
+   * @param lazy when true, the first num_buffers chunks are allocated when the first chunk is taken instead of here.
+   */
+  allocation_pool(std::unique_ptr<base_allocator> allocator, std::size_t size_buffers, std::size_t num_buffers, std::size_t thread_cache_size = 4,
+    bool lazy = false);
 
   ~allocation_pool();
 
   std::unique_ptr<blazing_allocation_chunk> get_chunk();
 
+  /**
+   * Gets a chunk of at least min_bytes from the smallest size class that fits them, or from this pool when none does.
+   * The chunk can be given back with the free_chunk() of this pool or with the one of the pool of its allocation.
+   */
+  std::unique_ptr<blazing_allocation_chunk> get_chunk(std::size_t min_bytes);
+
+  /**
+   * Adds a size class, a pool of chunks smaller than the ones of this pool. It is owned by this pool.
+   */
+  void add_size_class(std::shared_ptr<allocation_pool> size_class);
+
+  /**
+   * Sets how long the allocations made by growing the pool, and the ones of its size classes, are kept once all of
+   * their chunks are free. With 0 they are released as soon as that happens, otherwise shrink() releases them.
+   */
+  void set_shrink_idle_time(std::chrono::milliseconds idle_time);
+
+  /**
+   * Releases the allocations made by growing this pool and its size classes whose chunks have all been free for the
+   * shrink idle time. The first allocation of every pool is kept. The chunks kept by the thread caches are not free.
+   * @return the bytes that were released
+   */
+  std::size_t shrink();
+
+  struct usage_stats {
+    std::size_t total_bytes = 0; // the memory of the allocations of the pool
+    std::size_t allocated_bytes = 0; // the memory of the chunks that are in use, without the ones kept by the thread caches
+    std::size_t free_bytes = 0;
+    std::size_t high_water_bytes = 0; // the most memory that the chunks in use had at once, summed over the size classes
+    std::size_t grows = 0; // the times the pool grew after its first allocation
+    std::size_t shrinks = 0; // the allocations that were released once their chunks were free
+  };
+
+  /**
+   * The usage of the memory of the pool, including its size classes.
+   */
+  usage_stats get_usage_stats();
+
   ucp_mem_h getUcpMemoryHandle() const
     {
     return allocator->getUcpMemoryHandle();
@@ -121,8 +217,26 @@ private:
   // Its not threadsafe and the lock needs to be applied before calling it
   void grow();
 
+  // Its not threadsafe and the lock needs to be applied before calling it
+  std::unique_ptr<blazing_allocation_chunk> take_chunk();
+
+  // Its not threadsafe and the lock needs to be applied before calling it
+  void return_chunk(std::unique_ptr<blazing_allocation_chunk> buffer);
+
+  // Its not threadsafe and the lock needs to be applied before calling it
+  void release_allocation(std::size_t idx);
+
+  void update_high_water();
+
+  struct thread_chunk_cache;
+  thread_chunk_cache * get_thread_cache();
+
   std::mutex in_use_mutex;
 
+  std::size_t thread_cache_size;
+
+  std::atomic<std::size_t> generation; // incremented by free_all(), so that the chunks kept by the threads before it are dropped
+
   bool use_ucx;
 
   std::size_t buffer_size;
@@ -131,8 +245,18 @@ private:
 
   int buffer_counter;
 
-  int allocation_counter;
-    
+  std::atomic<int> allocation_counter; // the chunks kept by the thread caches are not counted as allocated
+
+  std::atomic<int> high_water_counter; // the most chunks that were allocated at once
+
+  std::size_t grow_counter;
+
+  std::size_t shrink_counter;
+
+  std::chrono::milliseconds shrink_idle_time;
+
+  std::vector<std::shared_ptr<allocation_pool> > size_classes; // from the largest chunks to the smallest
+
   std::vector<std::unique_ptr<blazing_allocation> > allocations;
 
   std::unique_ptr<base_allocator> allocator;
@@ -156,12 +280,27 @@ public:
     static std::shared_ptr<allocation_pool> pinned_buffer_instance{};
     return pinned_buffer_instance;
   }
+
+  // the pinned buffers of the parts that the object store output streams upload, which are larger than the chunks of the other pools
+  static std::shared_ptr<allocation_pool > & get_upload_buffer_provider(){
+    static std::shared_ptr<allocation_pool> upload_buffer_instance{};
+    return upload_buffer_instance;
+  }
 };
 
 // this function is what originally initialized the pinned memory and host memory allocation pools
+// numa_node is the NUMA node where the memory of both pools is placed, -1 lets the OS decide
+// with lazy, the memory of the pools is allocated by the first query that needs it, see allocation_pool
+// num_size_classes is the number of size classes of both pools, each one with chunks 4 times smaller than the previous one
 void set_allocation_pools(std::size_t size_buffers_host, std::size_t num_buffers_host,
     std::size_t size_buffers_pinned, std::size_t num_buffers_pinned, bool map_ucx,
-    ucp_context_h context);
+    ucp_context_h context, int numa_node = -1, std::size_t thread_cache_size = 4, bool lazy = false,
+    std::size_t num_size_classes = 0);
+// makes the host and pinned pools keep the allocations they grew by for idle_time once they are free, and starts the
+// thread that releases them afterwards. With 0 they are released as soon as they are free and there is no thread.
+void set_pool_shrink_policy(std::chrono::milliseconds idle_time);
+// initializes the pinned pool of the upload parts, and makes the object store output streams take their part buffers from it
+void set_upload_allocation_pool(std::size_t size_buffers, std::size_t num_buffers, int numa_node = -1);
 void empty_pools();
 } //namespace memory
 
@@ -0,0 +1,30 @@
+#include "EvictionPolicy.h"
+#include <algorithm>
+#include <numeric>
+
+namespace ral {
+namespace memory {
+
+double keep_value(const eviction_candidate & candidate) {
+	// the time until the data is consumed is measured in the work that has to happen before: the batches ahead of it and the kernels being waited on
+	double time_until_consumed = 1.0 + candidate.distance + candidate.batches_ahead;
+	return candidate.reload_cost_per_byte * candidate.reuses / time_until_consumed;
+}
+
+std::vector<std::size_t> eviction_order(const std::vector<eviction_candidate> & candidates) {
+	std::vector<double> values(candidates.size());
+	std::transform(candidates.begin(), candidates.end(), values.begin(), keep_value);
+
+	std::vector<std::size_t> order(candidates.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+		if (values[a] != values[b]) {
+			return values[a] < values[b];
+		}
+		return candidates[a].bytes > candidates[b].bytes;
+	});
+	return order;
+}
+
+}  // namespace memory
+}  // namespace ral
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace ral {
+namespace memory {
+
+/**
+* The relative cost of bringing back a byte from each tier a GPU cache can be downgraded to.
+*/
+const double host_reload_cost_per_byte = 1.0;
+const double disk_reload_cost_per_byte = 10.0;
+
+/**
+* What the eviction policy knows about the GPU data of a cache that could be downgraded.
+*/
+struct eviction_candidate {
+	std::size_t bytes = 0; /**< GPU bytes that downgrading the data frees. */
+	int distance = 0; /**< Unfinished kernels that the consumer of the data is still waiting on, besides the producer of the data. */
+	double batches_ahead = 0; /**< Batches that the consumer will take before it gets to the data. */
+	double reload_cost_per_byte = host_reload_cost_per_byte; /**< Cost of bringing a byte back from the tier the data would go to. */
+	double reuses = 1; /**< How many times the consumer is expected to read the data. */
+};
+
+/**
+* Gets the value per byte of keeping some data in GPU memory.
+* Data that is expensive to bring back, is read more than once, or will be consumed soon is worth more.
+*/
+double keep_value(const eviction_candidate & candidate);
+
+/**
+* Orders the candidates in the order they should be downgraded: the least valuable first, and the biggest first for the same value.
+* @return the indices of the candidates in eviction order.
+*/
+std::vector<std::size_t> eviction_order(const std::vector<eviction_candidate> & candidates);
+
+}  // namespace memory
+}  // namespace ral
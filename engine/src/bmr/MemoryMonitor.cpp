@@ -1,23 +1,80 @@
 #include "MemoryMonitor.h"
 #include "BlazingMemoryResource.h"
+#include "MemoryPressure.h"
+#include "MemoryTimeline.h"
 #include "execution_graph/PhysicalPlanGenerator.h"
 #include "execution_graph/executor.h"
+#include "cache_machine/HostCopyStream.h"
+#include "cache_machine/ManagedMemoryHints.h"
+#include "cache_machine/CPUCacheData.h"
+#include "cache_machine/GPUCacheData.h"
+#include "cache_machine/TableCache.h"
+#include <algorithm>
+#include <numeric>
 
 namespace ral {
 
     MemoryMonitor::MemoryMonitor(std::shared_ptr<ral::batch::tree_processor> tree,
                                  std::map<std::string, std::string> config_options)
-    : finished(false), tree(tree), resource(&blazing_device_memory_resource::getInstance()) {
+    : finished(false), tree(tree), bytes_freed(0), resource(&blazing_device_memory_resource::getInstance()) {
 
         period = std::chrono::milliseconds(50);
         auto it = config_options.find("MEMORY_MONITOR_PERIOD");
         if (it != config_options.end()) {
             period = std::chrono::milliseconds(std::stoull(config_options["MEMORY_MONITOR_PERIOD"]));
         }
+
+        it = config_options.find("RESOURCE_GROUP");
+        if (it != config_options.end() && !it->second.empty()) {
+            double memory_fraction = 1.0;
+            int max_threads = 0;
+            auto fraction_it = config_options.find("RESOURCE_GROUP_MEMORY_FRACTION");
+            if (fraction_it != config_options.end()) {
+                memory_fraction = std::stod(fraction_it->second);
+            }
+            auto threads_it = config_options.find("RESOURCE_GROUP_EXECUTOR_THREADS");
+            if (threads_it != config_options.end()) {
+                max_threads = std::stoi(threads_it->second);
+            }
+            group = ral::execution::executor::get_instance()->get_resource_group(it->second, memory_fraction, max_threads);
+        }
     }
 
     bool MemoryMonitor::need_to_free_memory(){
-        return resource->get_memory_used() > resource->get_memory_limit();
+        // the allocations that failed need room, even if the memory used is within the limit
+        if (ral::memory::memory_pressure::get_instance().get_waiting_bytes() > bytes_freed){
+            return true;
+        }
+        // the memory of the tables being copied to host is already on its way to be freed
+        std::size_t pending_bytes = ral::cache::host_copy_stream::get_instance().get_pending_bytes();
+        // and so is the managed memory that was advised to live in the host
+        pending_bytes += ral::cache::managed_memory_hints::get_instance().get_host_advised_bytes();
+        if (resource->get_memory_used() <= resource->get_memory_limit() + pending_bytes){
+            return false;
+        }
+        // when some resource groups are over their budget, only the queries of those groups free memory
+        if (ral::execution::executor::get_instance()->has_resource_group_over_budget()){
+            return group != nullptr && group->is_over_budget();
+        }
+        return true;
+    }
+
+    void MemoryMonitor::report_group_cache_bytes(){
+        if (group != nullptr){
+            group->set_query_cache_bytes(tree->context->getContextToken(), get_gpu_cache_bytes(&tree->root));
+        }
+    }
+
+    std::size_t MemoryMonitor::get_gpu_cache_bytes(ral::batch::node* starting_node){
+        std::size_t gpu_bytes = 0;
+        for (auto iter = starting_node->kernel_unit->output_.cache_machines_.begin();
+                iter != starting_node->kernel_unit->output_.cache_machines_.end(); iter++) {
+            gpu_bytes += iter->second->get_gpu_bytes();
+        }
+        for (auto & child : starting_node->children){
+            gpu_bytes += get_gpu_cache_bytes(child.get());
+        }
+        return gpu_bytes;
     }
 
     void MemoryMonitor::finalize(){
@@ -26,15 +83,34 @@ namespace ral {
         lock.unlock();
         condition.notify_all();
         this->monitor_thread.join();
+        ral::memory::memory_pressure::get_instance().remove_monitor(&condition);
+        if (group != nullptr){
+            group->remove_query(tree->context->getContextToken());
+        }
     }
 
     void MemoryMonitor::start(){
 
+        // besides every period, the monitor wakes up when the GPU memory goes over its limit or an allocation fails
+        ral::memory::memory_pressure::get_instance().add_monitor(&condition);
         this->monitor_thread = BlazingThread([this](){
+            auto & pressure = ral::memory::memory_pressure::get_instance();
+            pressure.set_monitor_thread();
             std::unique_lock<std::mutex> lock(finished_lock);
-            while(!condition.wait_for(lock, period, [this] { return this->finished; })){
+            while(true){
+                pressure.wait_for_signal(lock, condition, period, [this] { return this->finished; });
+                if (this->finished){
+                    break;
+                }
+                bytes_freed = 0;
+                ral::cache::host_copy_stream::get_instance().release_finished();
+                // the caches of the groups are only accounted while we are over the limit, since that is when they matter
+                if (group != nullptr && resource->get_memory_used() > resource->get_memory_limit()){
+                    report_group_cache_bytes();
+                }
                 if (need_to_free_memory()){
                     downgradeCaches(&tree->root);
+                    downgradeTableCache();
 
                     std::shared_ptr<spdlog::logger> logger = spdlog::get("batch_logger");
 
@@ -51,9 +127,16 @@ namespace ral {
                                     "info"_a="MemoryMonitor about to free memory from tasks");
                             }
                             std::vector<std::unique_ptr<ral::cache::CacheData > > inputs = task->release_inputs();
+                            std::size_t task_bytes_freed = 0;
                             for (std::size_t i = 0; i < inputs.size(); i++){
+                                if (inputs[i]->get_type() == ral::cache::CacheDataType::GPU &&
+                                        !static_cast<ral::cache::GPUCacheData *>(inputs[i].get())->is_host_advised()){
+                                    task_bytes_freed += inputs[i]->sizeInBytes();
+                                }
                                 inputs[i] = std::move(inputs[i]->downgradeCacheData(std::move(inputs[i]), "", tree->context));
                             }
+                            bytes_freed += task_bytes_freed;
+                            record_spill(task_bytes_freed, "inputs of task " + std::to_string(task->get_id()));
                             task->set_inputs(std::move(inputs));
                             tasks.push_back(std::move(task));
                         } else {
@@ -76,34 +159,120 @@ namespace ral {
                         }
                     }
                 }
+                // the allocations waiting for room retry now, whether it was freed or not
+                pressure.notify_evicted();
+                // the host tier is checked by itself, since it can fill up while there is plenty of GPU memory
+                if (blazing_host_memory_resource::getInstance().is_over_limit()){
+                    downgradeHostCaches(&tree->root);
+                }
             }
         });
     }
 
+    void MemoryMonitor::downgradeTableCache(){
+        // the tables of cache_table are spilled after the caches of the query, which the query is about to consume,
+        // and before the inputs of its tasks
+        auto & table_cache = ral::cache::table_cache::get_instance();
+        ral::cache::SpillFormat spill_format = ral::cache::get_spill_format(tree->context->getConfig());
+        while (need_to_free_memory()){
+            std::size_t memory_used = resource->get_memory_used();
+            std::size_t memory_limit = resource->get_memory_limit();
+            std::size_t waiting_bytes = ral::memory::memory_pressure::get_instance().get_waiting_bytes();
+            std::size_t bytes_wanted = std::max({memory_used > memory_limit ? memory_used - memory_limit : 0,
+                waiting_bytes > bytes_freed ? waiting_bytes - bytes_freed : 0, std::size_t(1)});
+            std::size_t table_bytes_freed = table_cache.downgrade(bytes_wanted, tree->context, spill_format);
+            if (table_bytes_freed == 0){
+                break;
+            }
+            bytes_freed += table_bytes_freed;
+            record_spill(table_bytes_freed, "cache_table");
+        }
+    }
+
     void MemoryMonitor::downgradeCaches(ral::batch::node* starting_node){
-        if (starting_node->kernel_unit->get_id() != 0) { // we want to skip the output node
-            for (auto iter = starting_node->kernel_unit->output_.cache_machines_.begin(); 
-                    iter != starting_node->kernel_unit->output_.cache_machines_.end(); iter++) {
-                size_t amount_downgraded = 0;
-                do {
-                    amount_downgraded = iter->second->downgradeCacheData();
-                } while (amount_downgraded > 0 && need_to_free_memory()); // if amount_downgraded is 0 then there is was nothing left to downgrade
+        // every cache is scored on how much it is worth keeping its data in GPU, and the least valuable ones are downgraded first
+        std::vector<std::shared_ptr<ral::cache::CacheMachine>> caches;
+        std::vector<ral::memory::eviction_candidate> candidates;
+        collect_eviction_candidates(starting_node, caches, candidates);
+
+        for (auto index : ral::memory::eviction_order(candidates)){
+            if (!need_to_free_memory()){
+                break;
+            }
+            std::size_t cache_bytes_freed = caches[index]->downgradeCacheData();
+            bytes_freed += cache_bytes_freed;
+            record_spill(cache_bytes_freed, "cache " + std::to_string(caches[index]->get_id()));
+        }
+    }
+
+    void MemoryMonitor::downgradeHostCaches(ral::batch::node* starting_node){
+        std::vector<std::shared_ptr<ral::cache::CacheMachine>> caches;
+        std::vector<ral::memory::eviction_candidate> candidates;
+        collect_eviction_candidates(starting_node, caches, candidates, true);
+
+        for (auto index : ral::memory::eviction_order(candidates)){
+            if (!blazing_host_memory_resource::getInstance().is_over_limit()){
+                break;
             }
+            caches[index]->downgradeHostCacheData();
         }
-        if (need_to_free_memory()){
-            if (starting_node->children.size() == 1){
-                downgradeCaches(starting_node->children[0].get());
-            } else if (starting_node->children.size() > 1){
-                std::vector<BlazingThread> threads;
-                for (auto node : starting_node->children){
-                    threads.push_back(BlazingThread([this, node](){
-                        this->downgradeCaches(node.get());
-                    }));
+    }
+
+    void MemoryMonitor::collect_eviction_candidates(ral::batch::node* consumer_node,
+            std::vector<std::shared_ptr<ral::cache::CacheMachine>> & caches,
+            std::vector<ral::memory::eviction_candidate> & candidates, bool host_tier){
+        std::vector<int> unfinished_kernels;
+        std::vector<uint64_t> batches_added;
+        for (auto & child : consumer_node->children){
+            unfinished_kernels.push_back(count_unfinished_kernels(child.get()));
+            batches_added.push_back(child->kernel_unit->output_.total_batches_added());
+        }
+        int total_unfinished_kernels = std::accumulate(unfinished_kernels.begin(), unfinished_kernels.end(), 0);
+
+        std::size_t host_bytes_available = blazing_host_memory_resource::getInstance().get_memory_limit() -
+            std::min(blazing_host_memory_resource::getInstance().get_memory_used(), blazing_host_memory_resource::getInstance().get_memory_limit());
+        // the host tier compresses what it takes with ENABLE_HOST_CACHE_COMPRESSION, so it fits more
+        bool host_compression = tree->context->getConfig().enable_host_cache_compression.value_or(false);
+
+        for (std::size_t i = 0; i < consumer_node->children.size(); i++){
+            auto producer = consumer_node->children[i]->kernel_unit;
+            for (auto iter = producer->output_.cache_machines_.begin(); iter != producer->output_.cache_machines_.end(); iter++){
+                ral::memory::eviction_candidate candidate;
+                candidate.bytes = host_tier ? iter->second->get_cpu_bytes() : iter->second->get_gpu_bytes();
+                if (candidate.bytes == 0){
+                    continue;
                 }
-                for(auto & thread : threads) {
-                    thread.join();
+                // the consumer can be held back by the other kernels feeding it
+                candidate.distance = total_unfinished_kernels - unfinished_kernels[i];
+                // the data of a cache is spread over its batches, which the consumer takes in order
+                candidate.batches_ahead = iter->second->get_num_batches() / 2.0;
+                std::size_t host_bytes = host_compression ?
+                    ral::cache::host_compression_stats::get_instance().expected_host_bytes(candidate.bytes) : candidate.bytes;
+                candidate.reload_cost_per_byte = !host_tier && host_bytes < host_bytes_available ?
+                    ral::memory::host_reload_cost_per_byte : ral::memory::disk_reload_cost_per_byte;
+                // a join pairs every batch of one side with every batch of the other, so every batch is read once per batch of the other side
+                if (consumer_node->kernel_unit->get_type_id() == ral::cache::kernel_type::PartwiseJoinKernel && consumer_node->children.size() == 2){
+                    candidate.reuses = std::max<uint64_t>(1, batches_added[1 - i]);
                 }
+                caches.push_back(iter->second);
+                candidates.push_back(candidate);
             }
+            collect_eviction_candidates(consumer_node->children[i].get(), caches, candidates, host_tier);
+        }
+    }
+
+    void MemoryMonitor::record_spill(std::size_t bytes, const std::string & description){
+        auto & timeline = ral::memory::memory_timeline::get_instance();
+        if (bytes > 0 && timeline.is_recording()){
+            timeline.record_spill(tree->context->getContextToken(), -1, bytes, resource->get_memory_used(), description);
+        }
+    }
+
+    int MemoryMonitor::count_unfinished_kernels(ral::batch::node* starting_node){
+        int unfinished_kernels = starting_node->kernel_unit->output_.all_finished() ? 0 : 1;
+        for (auto & child : starting_node->children){
+            unfinished_kernels += count_unfinished_kernels(child.get());
         }
+        return unfinished_kernels;
     }
 }  // namespace ral
@@ -1,10 +1,14 @@
 #pragma once
 
 #include <condition_variable>
+#include <string>
 #include <mutex>
 #include <chrono>
 #include "ExceptionHandling/BlazingThread.h"
 #include <map>
+#include <memory>
+#include <vector>
+#include "bmr/EvictionPolicy.h"
 
 class BlazingMemoryResource;
 namespace ral {
@@ -12,6 +16,12 @@ namespace  batch{
     class tree_processor;
     class node;
 } //namespace batch
+namespace execution {
+    class resource_group;
+} //namespace execution
+namespace cache {
+    class CacheMachine;
+} //namespace cache
 
 class MemoryMonitor {
 
@@ -25,11 +35,27 @@ class MemoryMonitor {
         std::condition_variable condition;
         std::shared_ptr<ral::batch::tree_processor> tree;
         std::chrono::milliseconds period;
+        std::size_t bytes_freed; // the GPU bytes downgraded in the current check
         BlazingMemoryResource* resource;
         BlazingThread monitor_thread;
 
+        std::shared_ptr<ral::execution::resource_group> group; /**< Resource group of the query, nullptr if it has none. */
+
         bool need_to_free_memory();
         void downgradeCaches(ral::batch::node* starting_node);
+        // spills the GPU batches of the tables in the table_cache, the least recently used ones first
+        void downgradeTableCache();
+        // moves the host data of the caches to disk while the host tier is over its limit
+        void downgradeHostCaches(ral::batch::node* starting_node);
+        // with host_tier, the candidates are the data of the caches in host memory, which would go to disk
+        void collect_eviction_candidates(ral::batch::node* consumer_node,
+            std::vector<std::shared_ptr<ral::cache::CacheMachine>> & caches,
+            std::vector<ral::memory::eviction_candidate> & candidates, bool host_tier = false);
+        int count_unfinished_kernels(ral::batch::node* starting_node);
+        // logs the bytes moved out of the GPU into the memory_timeline, when it is recording
+        void record_spill(std::size_t bytes, const std::string & description);
+        void report_group_cache_bytes();
+        std::size_t get_gpu_cache_bytes(ral::batch::node* starting_node);
 };
 
 }  // namespace ral
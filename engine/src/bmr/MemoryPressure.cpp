@@ -0,0 +1,70 @@
+#include "MemoryPressure.h"
+
+#include <algorithm>
+
+namespace ral {
+namespace memory {
+
+namespace {
+thread_local bool is_monitor_thread = false;
+}  // namespace
+
+void memory_pressure::configure(std::chrono::milliseconds allocation_wait_time) {
+	allocation_wait_ms = allocation_wait_time.count();
+}
+
+void memory_pressure::add_monitor(std::condition_variable * condition) {
+	std::lock_guard<std::mutex> lock(monitors_mutex);
+	monitor_conditions.push_back(condition);
+}
+
+void memory_pressure::remove_monitor(std::condition_variable * condition) {
+	std::lock_guard<std::mutex> lock(monitors_mutex);
+	monitor_conditions.erase(std::remove(monitor_conditions.begin(), monitor_conditions.end(), condition), monitor_conditions.end());
+}
+
+void memory_pressure::signal() {
+	signals++;
+	std::lock_guard<std::mutex> lock(monitors_mutex);
+	for (std::condition_variable * condition : monitor_conditions) {
+		condition->notify_all();
+	}
+}
+
+void memory_pressure::notify_evicted() {
+	{
+		std::lock_guard<std::mutex> lock(eviction_mutex);
+		evictions++;
+	}
+	eviction_condition.notify_all();
+}
+
+bool memory_pressure::wait_for_eviction(std::size_t bytes) {
+	std::chrono::milliseconds wait_time(allocation_wait_ms.load());
+	if (wait_time.count() <= 0 || is_monitor_thread) {
+		return false;
+	}
+	{
+		std::lock_guard<std::mutex> lock(monitors_mutex);
+		if (monitor_conditions.empty()) {
+			return false;
+		}
+	}
+
+	std::unique_lock<std::mutex> lock(eviction_mutex);
+	uint64_t last_evictions = evictions;
+	waiting_bytes += bytes;
+	lock.unlock();
+	signal();
+	lock.lock();
+	eviction_condition.wait_for(lock, wait_time, [&]{ return evictions != last_evictions; });
+	waiting_bytes -= bytes;
+	return true;
+}
+
+void memory_pressure::set_monitor_thread() {
+	is_monitor_thread = true;
+}
+
+}  // namespace memory
+}  // namespace ral
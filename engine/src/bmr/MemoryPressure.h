@@ -0,0 +1,93 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace ral {
+namespace memory {
+
+/**
+* Lets the GPU memory resource wake up the MemoryMonitors as soon as the memory goes over its limit, instead of waiting
+* for their next check, and lets an allocation that failed wait a little while they evict data to make room for it.
+* The monitors that are running register their condition variables, and an allocation only waits when there is one.
+* @note Myers' singleton.
+*/
+class memory_pressure {
+public:
+	static memory_pressure & get_instance() {
+		static memory_pressure instance;
+		return instance;
+	}
+
+	/**
+	* Sets how long an allocation that failed waits for the monitors to evict before it fails. 0 makes it fail at once.
+	* It is set by ALLOCATION_EVICTION_WAIT_MS when the engine is initialized.
+	*/
+	void configure(std::chrono::milliseconds allocation_wait_time);
+
+	void add_monitor(std::condition_variable * condition);
+	void remove_monitor(std::condition_variable * condition);
+
+	/**
+	* Called when the memory used goes over the limit or an allocation fails. It wakes up the monitors.
+	*/
+	void signal();
+
+	/**
+	* Waits on the condition variable of a monitor until the period is over, finished returns true or there is a signal.
+	* The monitor is not woken up by a signal that comes right before it waits, but then it waits just one period.
+	*/
+	template <typename Predicate>
+	void wait_for_signal(std::unique_lock<std::mutex> & lock, std::condition_variable & condition,
+			std::chrono::milliseconds period, Predicate finished) {
+		uint64_t last_signal = signals.load();
+		condition.wait_for(lock, period, [&]{ return finished() || signals.load() != last_signal; });
+	}
+
+	/**
+	* Called by a monitor after it evicted, it wakes up the allocations that are waiting for room.
+	*/
+	void notify_evicted();
+
+	/**
+	* Waits for the monitors to evict after an allocation failed, until one of them evicted or the wait time is over.
+	* @param bytes the size of the allocation, the monitors free at least as much while it waits.
+	* @return false if it did not wait, because there are no monitors, the wait time is 0 or the calling thread is a monitor.
+	*/
+	bool wait_for_eviction(std::size_t bytes);
+
+	/**
+	* The bytes of the allocations that are waiting for the monitors to evict.
+	*/
+	std::size_t get_waiting_bytes() const { return waiting_bytes.load(); }
+
+	/**
+	* Marks the calling thread as a monitor. Its allocations never wait, since it is the one that would free memory.
+	*/
+	static void set_monitor_thread();
+
+private:
+	memory_pressure() = default;
+	memory_pressure(memory_pressure &&) = delete;
+	memory_pressure(const memory_pressure &) = delete;
+	memory_pressure & operator=(memory_pressure &&) = delete;
+	memory_pressure & operator=(const memory_pressure &) = delete;
+
+	std::atomic<int64_t> allocation_wait_ms{50};
+	std::atomic<uint64_t> signals{0};
+	std::atomic<std::size_t> waiting_bytes{0};
+
+	std::mutex monitors_mutex;
+	std::vector<std::condition_variable *> monitor_conditions;
+
+	std::mutex eviction_mutex;
+	std::condition_variable eviction_condition;
+	uint64_t evictions = 0;
+};
+
+}  // namespace memory
+}  // namespace ral
@@ -0,0 +1,51 @@
+#include "MemoryTimeline.h"
+#include "QueryMemoryTracker.h"
+#include "utilities/EventLog.h"
+#include "utilities/Tracer.h"
+
+namespace ral {
+namespace memory {
+
+void memory_timeline::start(std::shared_ptr<spdlog::logger> logger) {
+	this->logger = logger;
+	recording.store(this->logger != nullptr, std::memory_order_release);
+}
+
+void memory_timeline::stop() {
+	recording.store(false, std::memory_order_relaxed);
+}
+
+void memory_timeline::record(const char * event, void * ptr, std::size_t bytes, int32_t ctx_token, int32_t kernel_id,
+		std::size_t used_memory, const std::string & description) {
+	ral::utilities::log_event(logger,
+		ral::utilities::tracer::getInstance().now(),
+		event,
+		reinterpret_cast<uintptr_t>(ptr),
+		bytes,
+		ctx_token,
+		kernel_id,
+		used_memory,
+		description);
+}
+
+void memory_timeline::record_allocation(void * ptr, std::size_t bytes, std::size_t used_memory) {
+	allocation_owner owner = query_memory_tracker::get_thread_owner();
+	record("allocate", ptr, bytes, owner.ctx_token, owner.kernel_id, used_memory, "");
+}
+
+void memory_timeline::record_deallocation(void * ptr, std::size_t bytes, std::size_t used_memory) {
+	allocation_owner owner = query_memory_tracker::get_thread_owner();
+	record("free", ptr, bytes, owner.ctx_token, owner.kernel_id, used_memory, "");
+}
+
+void memory_timeline::record_out_of_memory(std::size_t bytes, std::size_t used_memory) {
+	allocation_owner owner = query_memory_tracker::get_thread_owner();
+	record("oom", nullptr, bytes, owner.ctx_token, owner.kernel_id, used_memory, "");
+}
+
+void memory_timeline::record_spill(int32_t ctx_token, int32_t kernel_id, std::size_t bytes, std::size_t used_memory, const std::string & description) {
+	record("spill", nullptr, bytes, ctx_token, kernel_id, used_memory, description);
+}
+
+}  // namespace memory
+}  // namespace ral
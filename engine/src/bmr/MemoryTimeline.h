@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <spdlog/spdlog.h>
+
+namespace ral {
+namespace memory {
+
+/**
+* Records the GPU allocations and deallocations of the blazing_device_memory_resource, with the query and kernel that
+* owns the thread that makes them (see scoped_allocation_owner), together with the out of memory errors and the spills
+* of the MemoryMonitor, as lines of the memory_timeline_logger:
+* timestamp|event|address|bytes|query_id|kernel_id|used_memory|description. The timestamps are those of the tracer, so
+* the timeline lines up with the Chrome traces of the queries. A deallocation is logged with the owner of the thread
+* that makes it, the owner of the memory is the one of the allocation with the same address.
+* Recording is only done while the logger is set, so it costs an atomic load otherwise. The lines are written by the
+* event_log.
+* @note Myers' singleton.
+*/
+class memory_timeline {
+public:
+	static memory_timeline & get_instance() {
+		static memory_timeline instance;
+		return instance;
+	}
+
+	memory_timeline(memory_timeline &&) = delete;
+	memory_timeline(const memory_timeline &) = delete;
+	memory_timeline & operator=(memory_timeline &&) = delete;
+	memory_timeline & operator=(const memory_timeline &) = delete;
+
+	/**
+	* Starts recording into a logger. It is only called when the engine is initialized, before any query runs, since the
+	* logger is not guarded against the threads that are recording.
+	*/
+	void start(std::shared_ptr<spdlog::logger> logger);
+
+	/**
+	* Stops recording.
+	*/
+	void stop();
+
+	bool is_recording() const {
+		return recording.load(std::memory_order_relaxed);
+	}
+
+	void record_allocation(void * ptr, std::size_t bytes, std::size_t used_memory);
+
+	void record_deallocation(void * ptr, std::size_t bytes, std::size_t used_memory);
+
+	/**
+	* Records an allocation that failed even after waiting for the MemoryMonitor to make room.
+	*/
+	void record_out_of_memory(std::size_t bytes, std::size_t used_memory);
+
+	/**
+	* Records the bytes that the MemoryMonitor of a query moved out of the GPU.
+	* @param description what was spilled, like the name of the cache.
+	*/
+	void record_spill(int32_t ctx_token, int32_t kernel_id, std::size_t bytes, std::size_t used_memory, const std::string & description);
+
+private:
+	memory_timeline() : recording{false} {}
+
+	void record(const char * event, void * ptr, std::size_t bytes, int32_t ctx_token, int32_t kernel_id,
+		std::size_t used_memory, const std::string & description);
+
+	std::atomic<bool> recording;
+	std::shared_ptr<spdlog::logger> logger;
+};
+
+}  // namespace memory
+}  // namespace ral
@@ -0,0 +1,269 @@
+#include "PoolFragmentation.h"
+
+#include <algorithm>
+
+namespace ral {
+namespace memory {
+
+namespace {
+
+// the pool hands out blocks in multiples of its alignment
+constexpr std::size_t pool_alignment = 256;
+
+// the bins of binning take the allocations from 2^10 up to 2^20 bytes
+constexpr int8_t min_bin_exponent = 10;
+constexpr int8_t max_bin_exponent = 20;
+
+std::size_t align_up(std::size_t bytes) {
+	return (bytes + pool_alignment - 1) / pool_alignment * pool_alignment;
+}
+
+std::size_t floor_power_of_2(std::size_t bytes) {
+	std::size_t power = 1;
+	while (power <= bytes / 2) {
+		power *= 2;
+	}
+	return power;
+}
+
+} // namespace
+
+// BEGIN fragmentation_report
+
+double fragmentation_report::fragmentation() const {
+	if (free_bytes == 0) {
+		return 0;
+	}
+	return 1.0 - (double)largest_free_block / free_bytes;
+}
+
+std::string fragmentation_report::to_string() const {
+	std::string summary = "Pool Size: " + std::to_string(pool_bytes);
+	summary += " | Pool Chunks: " + std::to_string(num_chunks);
+	summary += " | Pool Allocated: " + std::to_string(allocated_bytes);
+	summary += " | Pool Free: " + std::to_string(free_bytes);
+	summary += " | Largest Free Block: " + std::to_string(largest_free_block);
+	summary += " | Fragmentation: " + std::to_string(fragmentation());
+	summary += " | Free Blocks: " + std::to_string(num_free_blocks) + " {";
+	bool first = true;
+	for (auto & bucket : free_block_histogram) {
+		summary += (first ? "" : ", ") + std::to_string(bucket.first) + ": " + std::to_string(bucket.second);
+		first = false;
+	}
+	summary += "}";
+	return summary;
+}
+
+// END fragmentation_report
+
+// BEGIN fragmentation_tracker
+
+void fragmentation_tracker::add_chunk(void * p, std::size_t bytes) {
+	std::lock_guard<std::mutex> lock(mutex);
+	chunks[reinterpret_cast<std::uintptr_t>(p)] = bytes;
+}
+
+void fragmentation_tracker::remove_chunk(void * p) {
+	std::lock_guard<std::mutex> lock(mutex);
+	chunks.erase(reinterpret_cast<std::uintptr_t>(p));
+}
+
+void fragmentation_tracker::add_block(void * p, std::size_t bytes) {
+	std::lock_guard<std::mutex> lock(mutex);
+	blocks[reinterpret_cast<std::uintptr_t>(p)] = bytes;
+}
+
+void fragmentation_tracker::remove_block(void * p) {
+	std::lock_guard<std::mutex> lock(mutex);
+	blocks.erase(reinterpret_cast<std::uintptr_t>(p));
+}
+
+void fragmentation_tracker::clear() {
+	std::lock_guard<std::mutex> lock(mutex);
+	chunks.clear();
+	blocks.clear();
+}
+
+fragmentation_report fragmentation_tracker::get_report() const {
+	fragmentation_report report;
+	std::lock_guard<std::mutex> lock(mutex);
+	report.num_chunks = chunks.size();
+
+	auto add_free_block = [&report](std::size_t bytes) {
+		if (bytes == 0) {
+			return;
+		}
+		report.free_bytes += bytes;
+		report.largest_free_block = std::max(report.largest_free_block, bytes);
+		report.num_free_blocks++;
+		report.free_block_histogram[floor_power_of_2(bytes)]++;
+	};
+
+	for (auto & chunk : chunks) {
+		std::uintptr_t chunk_end = chunk.first + chunk.second;
+		report.pool_bytes += chunk.second;
+
+		std::uintptr_t free_start = chunk.first;
+		for (auto block = blocks.lower_bound(chunk.first); block != blocks.end() && block->first < chunk_end; ++block) {
+			std::uintptr_t block_end = std::min<std::uintptr_t>(block->first + block->second, chunk_end);
+			add_free_block(block->first - free_start);
+			report.allocated_bytes += block_end - block->first;
+			free_start = block_end;
+		}
+		add_free_block(chunk_end - free_start);
+	}
+	return report;
+}
+
+// END fragmentation_tracker
+
+// BEGIN tracked_pool_memory_resource
+
+// passes the allocations of the pool to its upstream resource, recording the chunks it gets
+class tracked_pool_memory_resource::chunk_recorder : public rmm::mr::device_memory_resource {
+public:
+	chunk_recorder(rmm::mr::device_memory_resource * upstream, fragmentation_tracker & tracker)
+		: upstream(upstream), tracker(tracker) {}
+
+	bool supports_streams() const noexcept override { return upstream->supports_streams(); }
+	bool supports_get_mem_info() const noexcept override { return upstream->supports_get_mem_info(); }
+
+private:
+	void * do_allocate(std::size_t bytes, rmm::cuda_stream_view stream) override {
+		void * p = upstream->allocate(bytes, stream);
+		tracker.add_chunk(p, bytes);
+		return p;
+	}
+
+	void do_deallocate(void * p, std::size_t bytes, rmm::cuda_stream_view stream) override {
+		tracker.remove_chunk(p);
+		upstream->deallocate(p, bytes, stream);
+	}
+
+	std::pair<std::size_t, std::size_t> do_get_mem_info(rmm::cuda_stream_view stream) const override {
+		return upstream->get_mem_info(stream);
+	}
+
+	rmm::mr::device_memory_resource * upstream;
+	fragmentation_tracker & tracker;
+};
+
+// passes the allocations to the pool, recording the blocks it hands out
+class tracked_pool_memory_resource::block_recorder : public rmm::mr::device_memory_resource {
+public:
+	block_recorder(rmm::mr::device_memory_resource * pool, fragmentation_tracker & tracker)
+		: pool(pool), tracker(tracker) {}
+
+	bool supports_streams() const noexcept override { return true; }
+	bool supports_get_mem_info() const noexcept override { return false; }
+
+private:
+	void * do_allocate(std::size_t bytes, rmm::cuda_stream_view stream) override {
+		void * p = pool->allocate(bytes, stream);
+		tracker.add_block(p, align_up(bytes));
+		return p;
+	}
+
+	void do_deallocate(void * p, std::size_t bytes, rmm::cuda_stream_view stream) override {
+		tracker.remove_block(p);
+		pool->deallocate(p, bytes, stream);
+	}
+
+	std::pair<std::size_t, std::size_t> do_get_mem_info(rmm::cuda_stream_view stream) const override {
+		return std::make_pair(0, 0);
+	}
+
+	rmm::mr::device_memory_resource * pool;
+	fragmentation_tracker & tracker;
+};
+
+tracked_pool_memory_resource::tracked_pool_memory_resource(std::shared_ptr<rmm::mr::device_memory_resource> upstream,
+	std::size_t initial_pool_size, std::size_t maximum_pool_size, bool binning)
+	: upstream(upstream), initial_pool_size(initial_pool_size), maximum_pool_size(maximum_pool_size), binning(binning) {
+	build_pool(initial_pool_size, maximum_pool_size);
+}
+
+tracked_pool_memory_resource::~tracked_pool_memory_resource() {
+	release_pool();
+}
+
+void tracked_pool_memory_resource::build_pool(std::size_t initial_pool_size, std::size_t maximum_pool_size) {
+	using pool_type = rmm::mr::pool_memory_resource<rmm::mr::device_memory_resource>;
+	chunks = std::make_unique<chunk_recorder>(upstream.get(), tracker);
+	if (initial_pool_size == 0) {
+		pool = std::make_unique<pool_type>(chunks.get());
+	} else if (maximum_pool_size == 0) {
+		pool = std::make_unique<pool_type>(chunks.get(), initial_pool_size);
+	} else {
+		pool = std::make_unique<pool_type>(chunks.get(), initial_pool_size, maximum_pool_size);
+	}
+	blocks = std::make_unique<block_recorder>(pool.get(), tracker);
+	top = blocks.get();
+	if (binning) {
+		bins = std::make_unique<rmm::mr::binning_memory_resource<rmm::mr::device_memory_resource>>(
+			blocks.get(), min_bin_exponent, max_bin_exponent);
+		top = bins.get();
+	}
+}
+
+// the bins give their chunks back to the pool and the pool gives its chunks back to the upstream resource
+void tracked_pool_memory_resource::release_pool() {
+	bins.reset();
+	blocks.reset();
+	pool.reset();
+	chunks.reset();
+	top = nullptr;
+	tracker.clear();
+}
+
+fragmentation_report tracked_pool_memory_resource::get_fragmentation_report() const {
+	return tracker.get_report();
+}
+
+bool tracked_pool_memory_resource::compact(double min_fragmentation) {
+	std::unique_lock<std::shared_mutex> lock(pool_mutex, std::try_to_lock);
+	if (!lock.owns_lock() || allocated_bytes.load() > 0) {
+		return false;
+	}
+	fragmentation_report report = tracker.get_report();
+	if (report.num_chunks <= 1 || report.fragmentation() < min_fragmentation) {
+		return false;
+	}
+
+	std::size_t compacted_size = align_up(report.pool_bytes);
+	if (maximum_pool_size > 0) {
+		compacted_size = std::min(compacted_size, maximum_pool_size);
+	}
+	release_pool();
+	try {
+		build_pool(compacted_size, maximum_pool_size);
+	} catch (const std::exception & e) {
+		// the memory of the old chunks may not be back in the driver yet, so it starts over at the initial size
+		release_pool();
+		build_pool(initial_pool_size, maximum_pool_size);
+	}
+	num_compactions++;
+	return true;
+}
+
+void * tracked_pool_memory_resource::do_allocate(std::size_t bytes, rmm::cuda_stream_view stream) {
+	std::shared_lock<std::shared_mutex> lock(pool_mutex);
+	void * p = top->allocate(bytes, stream);
+	allocated_bytes += bytes;
+	return p;
+}
+
+void tracked_pool_memory_resource::do_deallocate(void * p, std::size_t bytes, rmm::cuda_stream_view stream) {
+	std::shared_lock<std::shared_mutex> lock(pool_mutex);
+	top->deallocate(p, bytes, stream);
+	allocated_bytes -= std::min(bytes, allocated_bytes.load());
+}
+
+std::pair<std::size_t, std::size_t> tracked_pool_memory_resource::do_get_mem_info(rmm::cuda_stream_view stream) const {
+	return std::make_pair(0, 0);
+}
+
+// END tracked_pool_memory_resource
+
+}  // namespace memory
+}  // namespace ral
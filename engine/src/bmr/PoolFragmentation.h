@@ -0,0 +1,125 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+
+#pragma GCC diagnostic ignored "-Wreorder"
+#include <rmm/cuda_stream_view.hpp>
+#include <rmm/mr/device/device_memory_resource.hpp>
+#include <rmm/mr/device/pool_memory_resource.hpp>
+#include <rmm/mr/device/binning_memory_resource.hpp>
+#pragma GCC diagnostic pop
+
+namespace ral {
+namespace memory {
+
+/**
+* How the memory of a pool is split between the blocks that are allocated and the ones that are free. The free blocks
+* are the gaps between the allocated blocks of each chunk the pool got from its upstream resource. An allocation can
+* only be served by a single free block, so a pool with plenty of free memory and a small largest_free_block is
+* fragmented.
+*/
+struct fragmentation_report {
+	std::size_t pool_bytes = 0;
+	std::size_t allocated_bytes = 0;
+	std::size_t free_bytes = 0;
+	std::size_t largest_free_block = 0;
+	std::size_t num_chunks = 0;
+	std::size_t num_free_blocks = 0;
+	std::map<std::size_t, std::size_t> free_block_histogram; // the number of free blocks by their size rounded down to a power of 2
+
+	/**
+	* The fraction of the free memory that is not in the largest free block, 0 when all of it could be allocated at once.
+	*/
+	double fragmentation() const;
+
+	std::string to_string() const;
+};
+
+/**
+* Keeps the chunks a pool got from its upstream resource and the blocks allocated from them, to tell how fragmented it
+* is. It is thread safe.
+*/
+class fragmentation_tracker {
+public:
+	void add_chunk(void * p, std::size_t bytes);
+	void remove_chunk(void * p);
+	void add_block(void * p, std::size_t bytes);
+	void remove_block(void * p);
+	void clear();
+
+	fragmentation_report get_report() const;
+
+private:
+	mutable std::mutex mutex;
+	std::map<std::uintptr_t, std::size_t> chunks; // by their address
+	std::map<std::uintptr_t, std::size_t> blocks; // by their address
+};
+
+/**
+* A pool memory resource that keeps track of its fragmentation, see fragmentation_report, and that can be compacted
+* when nothing is allocated from it, by replacing it with a new pool made of a single chunk of the size it grew to.
+* With binning, the allocations of up to 1 MiB are served by bins of fixed size blocks, in chunks of their own, so that
+* the small and short lived allocations do not split the free blocks the large ones need.
+*/
+class tracked_pool_memory_resource : public rmm::mr::device_memory_resource {
+public:
+	/**
+	* @param upstream where the chunks of the pool come from, the CUDA or the managed memory resource.
+	* @param initial_pool_size the size of the first chunk, 0 for the default of the pool.
+	* @param maximum_pool_size 0 for no maximum.
+	* @param binning whether the small allocations are served by bins.
+	*/
+	tracked_pool_memory_resource(std::shared_ptr<rmm::mr::device_memory_resource> upstream,
+		std::size_t initial_pool_size, std::size_t maximum_pool_size, bool binning);
+
+	~tracked_pool_memory_resource();
+
+	bool supports_streams() const noexcept override { return true; }
+	bool supports_get_mem_info() const noexcept override { return false; }
+
+	fragmentation_report get_fragmentation_report() const;
+
+	/**
+	* Replaces the pool by one made of a single chunk when there is nothing allocated from it and it is at least
+	* min_fragmentation fragmented. It does not wait for the allocations that are in progress.
+	* @return whether it was compacted.
+	*/
+	bool compact(double min_fragmentation);
+
+	std::size_t get_num_compactions() const { return num_compactions.load(); }
+
+private:
+	class chunk_recorder;
+	class block_recorder;
+
+	void build_pool(std::size_t initial_pool_size, std::size_t maximum_pool_size);
+	void release_pool();
+
+	void * do_allocate(std::size_t bytes, rmm::cuda_stream_view stream) override;
+	void do_deallocate(void * p, std::size_t bytes, rmm::cuda_stream_view stream) override;
+	std::pair<std::size_t, std::size_t> do_get_mem_info(rmm::cuda_stream_view stream) const override;
+
+	std::shared_ptr<rmm::mr::device_memory_resource> upstream;
+	std::size_t initial_pool_size;
+	std::size_t maximum_pool_size;
+	bool binning;
+
+	std::shared_mutex pool_mutex; // shared by the allocations, exclusive while the pool is replaced
+	fragmentation_tracker tracker;
+	std::unique_ptr<chunk_recorder> chunks;
+	std::unique_ptr<rmm::mr::pool_memory_resource<rmm::mr::device_memory_resource>> pool;
+	std::unique_ptr<block_recorder> blocks;
+	std::unique_ptr<rmm::mr::binning_memory_resource<rmm::mr::device_memory_resource>> bins;
+	rmm::mr::device_memory_resource * top;
+	std::atomic<std::size_t> allocated_bytes{0};
+	std::atomic<std::size_t> num_compactions{0};
+};
+
+}  // namespace memory
+}  // namespace ral
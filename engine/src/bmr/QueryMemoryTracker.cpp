@@ -0,0 +1,94 @@
+#include "QueryMemoryTracker.h"
+
+#include <algorithm>
+#include <functional>
+
+namespace ral {
+namespace memory {
+
+namespace {
+thread_local allocation_owner thread_owner;
+}
+
+allocation_owner query_memory_tracker::get_thread_owner() {
+	return thread_owner;
+}
+
+void query_memory_tracker::set_thread_owner(allocation_owner owner) {
+	thread_owner = owner;
+}
+
+query_memory_tracker::allocation_shard & query_memory_tracker::get_shard(void * ptr) {
+	// the low bits of the addresses are mostly the same because of the alignment of the allocations
+	return shards[(std::hash<void *>()(ptr) >> 8) % num_shards];
+}
+
+void query_memory_tracker::record_allocation(void * ptr, std::size_t bytes) {
+	allocation_owner owner = thread_owner;
+	if (ptr == nullptr || owner.ctx_token < 0) {
+		return;
+	}
+	{
+		auto & shard = get_shard(ptr);
+		std::lock_guard<std::mutex> lock(shard.mutex_);
+		shard.allocations[ptr] = tracked_allocation{owner, bytes};
+	}
+
+	std::lock_guard<std::mutex> lock(usage_mutex);
+	auto & usage = usages[owner.ctx_token];
+	usage.total.current += bytes;
+	usage.total.peak = std::max(usage.total.peak, usage.total.current);
+	auto & kernel_usage = usage.kernels[owner.kernel_id];
+	kernel_usage.current += bytes;
+	kernel_usage.peak = std::max(kernel_usage.peak, kernel_usage.current);
+}
+
+void query_memory_tracker::record_deallocation(void * ptr) {
+	tracked_allocation allocation;
+	{
+		auto & shard = get_shard(ptr);
+		std::lock_guard<std::mutex> lock(shard.mutex_);
+		auto it = shard.allocations.find(ptr);
+		if (it == shard.allocations.end()) {
+			return;
+		}
+		allocation = it->second;
+		shard.allocations.erase(it);
+	}
+
+	std::lock_guard<std::mutex> lock(usage_mutex);
+	auto usage = usages.find(allocation.owner.ctx_token);
+	if (usage == usages.end()) {
+		return; // the query was already forgotten
+	}
+	usage->second.total.current -= std::min(usage->second.total.current, allocation.bytes);
+	auto & kernel_usage = usage->second.kernels[allocation.owner.kernel_id];
+	kernel_usage.current -= std::min(kernel_usage.current, allocation.bytes);
+}
+
+memory_usage query_memory_tracker::get_query_usage(int32_t ctx_token) {
+	std::lock_guard<std::mutex> lock(usage_mutex);
+	auto usage = usages.find(ctx_token);
+	return usage != usages.end() ? usage->second.total : memory_usage{};
+}
+
+std::map<int32_t, memory_usage> query_memory_tracker::get_kernel_usages(int32_t ctx_token) {
+	std::lock_guard<std::mutex> lock(usage_mutex);
+	auto usage = usages.find(ctx_token);
+	return usage != usages.end() ? usage->second.kernels : std::map<int32_t, memory_usage>{};
+}
+
+void query_memory_tracker::finish_query(int32_t ctx_token) {
+	std::lock_guard<std::mutex> lock(usage_mutex);
+	if (std::find(finished_queries.begin(), finished_queries.end(), ctx_token) != finished_queries.end()) {
+		return;
+	}
+	finished_queries.push_back(ctx_token);
+	while (finished_queries.size() > max_finished_queries) {
+		usages.erase(finished_queries.front());
+		finished_queries.pop_front();
+	}
+}
+
+}  // namespace memory
+}  // namespace ral
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace ral {
+namespace memory {
+
+/**
+* The query and kernel on whose behalf a GPU allocation is made.
+*/
+struct allocation_owner {
+	int32_t ctx_token = -1;
+	int32_t kernel_id = -1;
+};
+
+struct memory_usage {
+	std::size_t current = 0; /**< bytes currently allocated. */
+	std::size_t peak = 0; /**< the most bytes that were allocated at the same time. */
+};
+
+/**
+* Keeps track of how much GPU memory every query, and every kernel of a query, has allocated.
+* The allocations are attributed to the owner set on the thread that makes them (see scoped_allocation_owner),
+* and a deallocation is attributed to the owner of the allocation, no matter which thread makes it.
+* The usage of a query is kept after it finishes, so that its peak can be asked for, but only for the
+* last queries that finished.
+* @note Myers' singleton.
+*/
+class query_memory_tracker {
+public:
+	static query_memory_tracker & get_instance() {
+		static query_memory_tracker instance;
+		return instance;
+	}
+
+	query_memory_tracker(query_memory_tracker &&) = delete;
+	query_memory_tracker(const query_memory_tracker &) = delete;
+	query_memory_tracker & operator=(query_memory_tracker &&) = delete;
+	query_memory_tracker & operator=(const query_memory_tracker &) = delete;
+
+	/**
+	* Get the owner of the allocations that the calling thread makes.
+	*/
+	static allocation_owner get_thread_owner();
+
+	/**
+	* Sets the owner of the allocations that the calling thread makes. A ctx_token of -1 means that they are not tracked.
+	*/
+	static void set_thread_owner(allocation_owner owner);
+
+	/**
+	* Attributes an allocation to the owner of the calling thread.
+	*/
+	void record_allocation(void * ptr, std::size_t bytes);
+
+	/**
+	* Removes an allocation from the usage of its owner. It does nothing if the allocation was not tracked.
+	*/
+	void record_deallocation(void * ptr);
+
+	/**
+	* Get the memory usage of a query. It is zero if the query is not known.
+	*/
+	memory_usage get_query_usage(int32_t ctx_token);
+
+	/**
+	* Get the memory usage of every kernel of a query, by kernel id.
+	*/
+	std::map<int32_t, memory_usage> get_kernel_usages(int32_t ctx_token);
+
+	/**
+	* Lets the tracker know that a query finished, so that its usage can be forgotten once enough other queries finish.
+	*/
+	void finish_query(int32_t ctx_token);
+
+private:
+	query_memory_tracker() = default;
+
+	struct tracked_allocation {
+		allocation_owner owner;
+		std::size_t bytes;
+	};
+
+	struct query_usage {
+		memory_usage total;
+		std::map<int32_t, memory_usage> kernels;
+	};
+
+	static constexpr std::size_t num_shards = 16;
+	static constexpr std::size_t max_finished_queries = 64;
+
+	struct allocation_shard {
+		std::mutex mutex_;
+		std::unordered_map<void *, tracked_allocation> allocations;
+	};
+
+	allocation_shard & get_shard(void * ptr);
+
+	std::array<allocation_shard, num_shards> shards; /**< The allocations are sharded by address so that they don't share a single lock. */
+	std::mutex usage_mutex;
+	std::map<int32_t, query_usage> usages;
+	std::deque<int32_t> finished_queries; /**< The queries that finished, from the oldest one. */
+};
+
+/**
+* Sets the owner of the allocations of the calling thread while it is in scope, and restores the previous one afterwards.
+*/
+class scoped_allocation_owner {
+public:
+	scoped_allocation_owner(int32_t ctx_token, int32_t kernel_id) : previous_owner(query_memory_tracker::get_thread_owner()) {
+		query_memory_tracker::set_thread_owner(allocation_owner{ctx_token, kernel_id});
+	}
+
+	~scoped_allocation_owner() {
+		query_memory_tracker::set_thread_owner(previous_owner);
+	}
+
+private:
+	allocation_owner previous_owner;
+};
+
+}  // namespace memory
+}  // namespace ral
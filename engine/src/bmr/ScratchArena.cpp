@@ -0,0 +1,110 @@
+#include "ScratchArena.h"
+
+#include <algorithm>
+
+namespace ral {
+namespace memory {
+
+namespace {
+
+// the alignment of the allocations of rmm
+constexpr std::size_t ALIGNMENT = 256;
+
+// the block is not grown for less than this, so that it does not grow a little at every task
+constexpr std::size_t MIN_BLOCK_BYTES = 1 << 20;
+
+std::size_t align_up(std::size_t bytes) {
+	return (bytes + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+}
+
+thread_local scratch_arena_memory_resource * task_scratch_arena = nullptr;
+
+}  // namespace
+
+rmm::mr::device_memory_resource * get_task_scratch_resource() {
+	return task_scratch_arena != nullptr ? task_scratch_arena : rmm::mr::get_current_device_resource();
+}
+
+void set_task_scratch_arena(scratch_arena_memory_resource * arena) {
+	task_scratch_arena = arena;
+}
+
+scratch_arena_memory_resource::scratch_arena_memory_resource(std::size_t max_bytes) : max_bytes(align_up(max_bytes)) {}
+
+scratch_arena_memory_resource::~scratch_arena_memory_resource() {
+	std::lock_guard<std::mutex> lock(mutex);
+	release_block();
+}
+
+bool scratch_arena_memory_resource::owns(void * p) const {
+	return block != nullptr && static_cast<char *>(p) >= block && static_cast<char *>(p) < block + capacity;
+}
+
+void * scratch_arena_memory_resource::do_allocate(std::size_t bytes, rmm::cuda_stream_view stream) {
+	std::size_t aligned_bytes = align_up(std::max<std::size_t>(bytes, 1));
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		wanted_bytes += aligned_bytes;
+		if (block == nullptr && aligned_bytes <= max_bytes) {
+			block_resource = rmm::mr::get_current_device_resource();
+			capacity = std::min(std::max({MIN_BLOCK_BYTES, next_capacity, aligned_bytes}), max_bytes);
+			block = static_cast<char *>(block_resource->allocate(capacity, stream));
+		}
+		if (block != nullptr && offset + aligned_bytes <= capacity) {
+			void * p = block + offset;
+			offset += aligned_bytes;
+			num_live_allocations++;
+			used_streams.insert(stream.value());
+			return p;
+		}
+	}
+	return rmm::mr::get_current_device_resource()->allocate(bytes, stream);
+}
+
+void scratch_arena_memory_resource::do_deallocate(void * p, std::size_t bytes, rmm::cuda_stream_view stream) {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (owns(p)) {
+			num_live_allocations--;
+			return;
+		}
+	}
+	rmm::mr::get_current_device_resource()->deallocate(p, bytes, stream);
+}
+
+std::pair<std::size_t, std::size_t> scratch_arena_memory_resource::do_get_mem_info(rmm::cuda_stream_view stream) const {
+	return std::make_pair(0, 0);
+}
+
+void scratch_arena_memory_resource::reset(bool release) {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (num_live_allocations > 0) {
+		return; // something outlived its task, so the block can't be reused yet
+	}
+	// a kernel of the task may still be reading what it freed
+	for (cudaStream_t stream : used_streams) {
+		cudaStreamSynchronize(stream);
+	}
+	used_streams.clear();
+	offset = 0;
+
+	// the grown block is allocated by the next allocation, which can handle running out of memory
+	if (release || (wanted_bytes > capacity && capacity < max_bytes)) {
+		next_capacity = release ? 0 : std::min(wanted_bytes, max_bytes);
+		release_block();
+	}
+	wanted_bytes = 0;
+}
+
+void scratch_arena_memory_resource::release_block() {
+	if (block != nullptr) {
+		block_resource->deallocate(block, capacity);
+		block = nullptr;
+		block_resource = nullptr;
+		capacity = 0;
+	}
+	offset = 0;
+}
+
+}  // namespace memory
+}  // namespace ral
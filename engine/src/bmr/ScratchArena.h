@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <set>
+
+#pragma GCC diagnostic ignored "-Wreorder"
+#include <cuda_runtime_api.h>
+#include <rmm/cuda_stream_view.hpp>
+#include <rmm/mr/device/device_memory_resource.hpp>
+#include <rmm/mr/device/per_device_resource.hpp>
+#pragma GCC diagnostic pop
+
+namespace ral {
+namespace memory {
+
+/**
+* A bump allocator for the temporaries of the task that a thread of the executor runs, like the buffers of the
+* interpreter, so that the many small allocations of a small batch don't go through the pool and the accounting of the
+* device memory resource. It hands out consecutive pieces of a single block, which it gets from the current device
+* resource the first time it is used, and freeing them does nothing until reset, when the task is done. What does not
+* fit in the block comes from the current device resource as usual, and the block grows to what the task wanted, up to
+* max_bytes, at the next reset.
+*
+* Only what does not outlive the task can come from it, since reset reuses the whole block. It is meant to be used by
+* the thread of its task, the mutex only protects it from a deallocation made by another thread.
+*/
+class scratch_arena_memory_resource : public rmm::mr::device_memory_resource {
+public:
+	/**
+	* @param max_bytes the largest the block can grow to.
+	*/
+	explicit scratch_arena_memory_resource(std::size_t max_bytes);
+
+	~scratch_arena_memory_resource();
+
+	bool supports_streams() const noexcept override { return true; }
+	bool supports_get_mem_info() const noexcept override { return false; }
+
+	/**
+	* Makes the whole block available again once nothing allocated from it is alive, after the work of the streams that
+	* used it is done. The next block is larger when the task wanted more than this one had.
+	* @param release whether the block goes back to the device resource, for when the executor has no more tasks.
+	*/
+	void reset(bool release);
+
+	std::size_t get_capacity() const { return capacity; }
+
+private:
+	void * do_allocate(std::size_t bytes, rmm::cuda_stream_view stream) override;
+	void do_deallocate(void * p, std::size_t bytes, rmm::cuda_stream_view stream) override;
+	std::pair<std::size_t, std::size_t> do_get_mem_info(rmm::cuda_stream_view stream) const override;
+
+	bool owns(void * p) const;
+	void release_block();
+
+	std::mutex mutex;
+	std::size_t max_bytes;
+	rmm::mr::device_memory_resource * block_resource = nullptr; // the resource that gave the block
+	char * block = nullptr;
+	std::size_t capacity = 0;
+	std::size_t offset = 0; // where the next allocation starts
+	std::size_t wanted_bytes = 0; // what the allocations since the last reset would have taken of the block
+	std::size_t next_capacity = 0; // the size of the next block
+	std::size_t num_live_allocations = 0; // the allocations from the block that were not freed
+	std::set<cudaStream_t> used_streams; // the streams that may still use the block
+};
+
+/**
+* Get the resource for the temporaries of the task that the calling thread runs, the ones that are freed before the
+* task is done. It is the scratch arena of the thread of the executor, or the current device resource outside of the
+* executor or when there are no arenas.
+*/
+rmm::mr::device_memory_resource * get_task_scratch_resource();
+
+/**
+* Sets the scratch arena of the task that the calling thread runs, nullptr when it is done.
+*/
+void set_task_scratch_arena(scratch_arena_memory_resource * arena);
+
+}  // namespace memory
+}  // namespace ral
@@ -1,15 +1,175 @@
 #include "ArrowCacheData.h"
+#include <algorithm>
+#include <cstring>
 #include <cudf/interop.hpp>
+#include <cudf/null_mask.hpp>
+#include <cuda_runtime.h>
+#include "bmr/BufferProvider.h"
 
 namespace ral {
 namespace cache {
 
+namespace {
+
+// the cudf type of the arrow types whose values are copied as they are, the same one that cudf::from_arrow gives them
+bool get_fixed_width_type(const arrow::DataType & type, cudf::data_type & cudf_type) {
+    switch (type.id()) {
+        case arrow::Type::INT8: cudf_type = cudf::data_type{cudf::type_id::INT8}; return true;
+        case arrow::Type::INT16: cudf_type = cudf::data_type{cudf::type_id::INT16}; return true;
+        case arrow::Type::INT32: cudf_type = cudf::data_type{cudf::type_id::INT32}; return true;
+        case arrow::Type::INT64: cudf_type = cudf::data_type{cudf::type_id::INT64}; return true;
+        case arrow::Type::UINT8: cudf_type = cudf::data_type{cudf::type_id::UINT8}; return true;
+        case arrow::Type::UINT16: cudf_type = cudf::data_type{cudf::type_id::UINT16}; return true;
+        case arrow::Type::UINT32: cudf_type = cudf::data_type{cudf::type_id::UINT32}; return true;
+        case arrow::Type::UINT64: cudf_type = cudf::data_type{cudf::type_id::UINT64}; return true;
+        case arrow::Type::FLOAT: cudf_type = cudf::data_type{cudf::type_id::FLOAT32}; return true;
+        case arrow::Type::DOUBLE: cudf_type = cudf::data_type{cudf::type_id::FLOAT64}; return true;
+        case arrow::Type::DATE32: cudf_type = cudf::data_type{cudf::type_id::TIMESTAMP_DAYS}; return true;
+        case arrow::Type::DATE64: cudf_type = cudf::data_type{cudf::type_id::TIMESTAMP_MILLISECONDS}; return true;
+        case arrow::Type::TIMESTAMP: {
+            switch (static_cast<const arrow::TimestampType &>(type).unit()) {
+                case arrow::TimeUnit::SECOND: cudf_type = cudf::data_type{cudf::type_id::TIMESTAMP_SECONDS}; return true;
+                case arrow::TimeUnit::MILLI: cudf_type = cudf::data_type{cudf::type_id::TIMESTAMP_MILLISECONDS}; return true;
+                case arrow::TimeUnit::MICRO: cudf_type = cudf::data_type{cudf::type_id::TIMESTAMP_MICROSECONDS}; return true;
+                case arrow::TimeUnit::NANO: cudf_type = cudf::data_type{cudf::type_id::TIMESTAMP_NANOSECONDS}; return true;
+            }
+            return false;
+        }
+        default: return false;
+    }
+}
+
+// the null mask of a column can only be copied as it is when it starts at a byte
+bool can_copy_column(const arrow::ChunkedArray & column, cudf::data_type & cudf_type) {
+    if (!get_fixed_width_type(*column.type(), cudf_type)) {
+        return false;
+    }
+    return column.null_count() == 0 || (column.num_chunks() == 1 && column.chunk(0)->offset() % 8 == 0);
+}
+
+// Copies host memory to the GPU through two pinned chunks, filling one while the other one is being copied
+class pinned_staging_copier {
+public:
+    explicit pinned_staging_copier(std::shared_ptr<ral::memory::allocation_pool> pool) : pool(pool) {
+        for (int i = 0; i < 2; i++) {
+            chunks[i] = pool->get_chunk();
+            cudaEventCreateWithFlags(&events[i], cudaEventDisableTiming);
+        }
+    }
+
+    ~pinned_staging_copier() {
+        cudaStreamSynchronize(0);
+        for (int i = 0; i < 2; i++) {
+            cudaEventDestroy(events[i]);
+            pool->free_chunk(std::move(chunks[i]));
+        }
+    }
+
+    void copy(void * dst, const uint8_t * src, std::size_t bytes) {
+        std::size_t position = 0;
+        while (position < bytes) {
+            // the chunk is only filled again once its last copy is done
+            cudaEventSynchronize(events[current]);
+            std::size_t size = std::min(bytes - position, chunks[current]->size);
+            std::memcpy(chunks[current]->data, src + position, size);
+            cudaMemcpyAsync(static_cast<char *>(dst) + position, chunks[current]->data, size, cudaMemcpyHostToDevice, 0);
+            cudaEventRecord(events[current], 0);
+            position += size;
+            current = 1 - current;
+        }
+    }
+
+    void finish() {
+        cudaError_t status = cudaStreamSynchronize(0);
+        if (status != cudaSuccess) {
+            throw std::runtime_error(std::string("ERROR: Copying an Arrow table to the GPU failed: ") + cudaGetErrorString(status));
+        }
+    }
+
+private:
+    std::shared_ptr<ral::memory::allocation_pool> pool;
+    std::unique_ptr<ral::memory::blazing_allocation_chunk> chunks[2];
+    cudaEvent_t events[2];
+    int current = 0;
+};
+
+std::unique_ptr<cudf::column> copy_column(const arrow::ChunkedArray & column, cudf::data_type cudf_type, pinned_staging_copier & copier) {
+    std::size_t width = cudf::size_of(cudf_type);
+    rmm::device_buffer data(column.length() * width);
+    std::size_t position = 0;
+    for (const auto & chunk : column.chunks()) {
+        std::size_t bytes = chunk->length() * width;
+        if (bytes == 0) {
+            continue;
+        }
+        copier.copy(static_cast<char *>(data.data()) + position, chunk->data()->buffers[1]->data() + chunk->offset() * width, bytes);
+        position += bytes;
+    }
+
+    rmm::device_buffer null_mask;
+    if (column.null_count() > 0) {
+        const auto & chunk = column.chunk(0);
+        null_mask = rmm::device_buffer(cudf::bitmask_allocation_size_bytes(column.length()));
+        copier.copy(null_mask.data(), chunk->null_bitmap_data() + chunk->offset() / 8, (column.length() + 7) / 8);
+    }
+    return std::make_unique<cudf::column>(cudf_type, column.length(), std::move(data), std::move(null_mask), column.null_count());
+}
+
+std::size_t get_buffers_size(const arrow::ArrayData & data) {
+    std::size_t size = 0;
+    for (const auto & buffer : data.buffers) {
+        if (buffer != nullptr) {
+            size += buffer->size();
+        }
+    }
+    for (const auto & child : data.child_data) {
+        size += get_buffers_size(*child);
+    }
+    return size;
+}
+
+} // namespace
+
 ArrowCacheData::ArrowCacheData(std::shared_ptr<arrow::Table> table, ral::io::Schema schema)
     : CacheData(CacheDataType::ARROW, schema.get_names(), schema.get_data_types(), table->num_rows()), data{std::move(table)} {}
 
 std::unique_ptr<ral::frame::BlazingTable> ArrowCacheData::decache() {
-    auto result = std::make_unique<ral::frame::BlazingTable>(std::move(cudf::from_arrow(*data)), data->ColumnNames());
-    return std::move(result);
+    std::shared_ptr<ral::memory::allocation_pool> pinned_pool = ral::memory::buffer_providers::get_pinned_buffer_provider();
+    if (pinned_pool == nullptr || data->num_columns() == 0) {
+        auto result = std::make_unique<ral::frame::BlazingTable>(std::move(cudf::from_arrow(*data)), data->ColumnNames());
+        return std::move(result);
+    }
+
+    std::vector<std::unique_ptr<cudf::column>> columns(data->num_columns());
+    std::vector<int> other_columns;
+    {
+        pinned_staging_copier copier(pinned_pool);
+        for (int i = 0; i < data->num_columns(); i++) {
+            cudf::data_type cudf_type;
+            if (can_copy_column(*data->column(i), cudf_type)) {
+                columns[i] = copy_column(*data->column(i), cudf_type, copier);
+            } else {
+                other_columns.push_back(i);
+            }
+        }
+        copier.finish();
+    }
+
+    if (!other_columns.empty()) {
+        std::vector<std::shared_ptr<arrow::Field>> fields;
+        std::vector<std::shared_ptr<arrow::ChunkedArray>> other_arrays;
+        for (int i : other_columns) {
+            fields.push_back(data->schema()->field(i));
+            other_arrays.push_back(data->column(i));
+        }
+        auto other_table = arrow::Table::Make(arrow::schema(fields), other_arrays, data->num_rows());
+        std::vector<std::unique_ptr<cudf::column>> converted = cudf::from_arrow(*other_table)->release();
+        for (std::size_t j = 0; j < other_columns.size(); j++) {
+            columns[other_columns[j]] = std::move(converted[j]);
+        }
+    }
+
+    return std::make_unique<ral::frame::BlazingTable>(std::make_unique<cudf::table>(std::move(columns)), data->ColumnNames());
 }
 
 size_t ArrowCacheData::sizeInBytes() const {
@@ -22,5 +182,27 @@ void ArrowCacheData::set_names(const std::vector<std::string> & names) {
 
 ArrowCacheData::~ArrowCacheData() {}
 
+std::vector<std::shared_ptr<arrow::Table>> split_arrow_table(const std::shared_ptr<arrow::Table> & table, std::size_t max_bytes) {
+    int64_t num_rows = table->num_rows();
+    std::size_t table_bytes = 0;
+    for (const auto & column : table->columns()) {
+        for (const auto & chunk : column->chunks()) {
+            table_bytes += get_buffers_size(*chunk->data());
+        }
+    }
+    if (max_bytes == 0 || table_bytes <= max_bytes || num_rows == 0) {
+        return {table};
+    }
+
+    // the buffers of the slices of an array are the ones of the whole array, so the size is taken per row
+    int64_t slice_rows = std::max<int64_t>(static_cast<double>(max_bytes) / table_bytes * num_rows, 1);
+    slice_rows = (slice_rows + 63) / 64 * 64;
+    std::vector<std::shared_ptr<arrow::Table>> slices;
+    for (int64_t start = 0; start < num_rows; start += slice_rows) {
+        slices.push_back(table->Slice(start, std::min(slice_rows, num_rows - start)));
+    }
+    return slices;
+}
+
 } // namespace cache
-} // namespace ral
\ No newline at end of file
+} // namespace ral
@@ -7,6 +7,8 @@ namespace cache {
 /**
 * A CacheData that keeps its dataframe as an Arrow table.
 * This is a CacheData representation that wraps a arrow::Table.
+* A large table is split by split_arrow_table into several of them, so that the scan processes its first slice while
+* the next ones are still in host memory.
 */
 class ArrowCacheData : public CacheData {
 public:
@@ -30,6 +32,9 @@ public:
 	* Move the arrow::Table out of this Cache
 	* This function only exists so that we can interact with all cache data by
 	* calling decache on them.
+	* The values and null masks of the fixed width columns are staged through two chunks of the pinned buffer provider,
+	* so that copying a chunk to the GPU overlaps with filling the other one. The other columns, and all of them when
+	* there are no pinned buffers, are converted by cudf::from_arrow.
 	* @return The BlazingTable that was used to construct this CacheData.
 	*/
 	std::unique_ptr<ral::frame::BlazingTable> decache() override;
@@ -71,5 +76,12 @@ protected:
 	std::shared_ptr<arrow::Table> data; /**< Stores the data to be returned in decache */
 };
 
+/**
+* Splits an Arrow table into slices of about max_bytes of its buffers, without copying it.
+* The slices have a multiple of 64 rows, so that the null masks of their columns start at a byte.
+* @param max_bytes 0 keeps the table whole.
+*/
+std::vector<std::shared_ptr<arrow::Table>> split_arrow_table(const std::shared_ptr<arrow::Table> & table, std::size_t max_bytes);
+
 } // namespace cache
 } // namespace ral
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "CPUCacheData.h"
+#include "execution_graph/executor.h"
 
 namespace ral {
 namespace cache {
@@ -6,16 +7,46 @@ namespace cache {
 CPUCacheData::CPUCacheData(std::unique_ptr<ral::frame::BlazingTable> gpu_table, bool use_pinned)
 	: CacheData(CacheDataType::CPU, gpu_table->names(), gpu_table->get_schema(), gpu_table->num_rows())
 {
-	this->host_table = ral::communication::messages::serialize_gpu_message_to_host_table(gpu_table->toBlazingTableView(), use_pinned);
+	this->host_table = ral::communication::messages::serialize_gpu_message_to_host_table(gpu_table->toBlazingTableView(), use_pinned, ral::execution::executor::get_task_stream());
 }
 
 CPUCacheData::CPUCacheData(std::unique_ptr<ral::frame::BlazingTable> gpu_table,const MetadataDictionary & metadata, bool use_pinned)
 	: CacheData(CacheDataType::CPU, gpu_table->names(), gpu_table->get_schema(), gpu_table->num_rows())
 {
-	this->host_table = ral::communication::messages::serialize_gpu_message_to_host_table(gpu_table->toBlazingTableView(), use_pinned);
+	this->host_table = ral::communication::messages::serialize_gpu_message_to_host_table(gpu_table->toBlazingTableView(), use_pinned, ral::execution::executor::get_task_stream());
 	this->metadata = metadata;
 }
 
+CPUCacheData::CPUCacheData(std::unique_ptr<ral::frame::BlazingTable> gpu_table, host_copy_stream & copy_stream)
+	: CacheData(CacheDataType::CPU, gpu_table->names(), gpu_table->get_schema(), gpu_table->num_rows())
+{
+	std::vector<std::size_t> buffer_sizes;
+	std::vector<const char *> raw_buffers;
+	std::vector<blazingdb::transport::ColumnTransport> column_offset;
+	std::vector<std::unique_ptr<rmm::device_buffer>> temp_scope_holder;
+	std::tie(buffer_sizes, raw_buffers, column_offset, temp_scope_holder) =
+		ral::communication::messages::serialize_gpu_message_to_gpu_containers(gpu_table->toBlazingTableView());
+
+	auto buffers_and_allocations = ral::memory::convert_gpu_buffers_to_chunks(buffer_sizes, true);
+	auto & allocations = buffers_and_allocations.second;
+
+	// the copies have to start after the work already issued on the default stream, which made the table and its temporary buffers
+	cudaStream_t stream = copy_stream.get_stream();
+	this->copy_event = copy_stream.make_event();
+	cudaEventRecord(this->copy_event.get(), 0);
+	cudaStreamWaitEvent(stream, this->copy_event.get(), 0);
+
+	std::unique_ptr<rmm::device_buffer> staging = ral::communication::messages::copy_gpu_buffers_to_chunks(
+		raw_buffers, buffers_and_allocations.first, allocations, stream);
+	if (staging != nullptr) {
+		temp_scope_holder.push_back(std::move(staging));
+	}
+	cudaEventRecord(this->copy_event.get(), stream);
+
+	this->host_table = std::make_unique<ral::frame::BlazingHostTable>(column_offset, std::move(buffers_and_allocations.first), std::move(buffers_and_allocations.second));
+	copy_stream.release_after(this->copy_event, std::move(gpu_table), std::move(temp_scope_holder));
+}
+
 CPUCacheData::CPUCacheData(const std::vector<blazingdb::transport::ColumnTransport> & column_transports,
 			std::vector<ral::memory::blazing_chunked_column_info> && chunked_column_infos,
 			std::vector<std::unique_ptr<ral::memory::blazing_allocation_chunk>> && allocations,
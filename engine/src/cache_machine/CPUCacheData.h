@@ -1,8 +1,46 @@
+#include <algorithm>
+#include <atomic>
 #include "CacheData.h"
+#include "HostCopyStream.h"
 
 namespace ral {
 namespace cache {
 
+/**
+* The ratio of the sizes of the CPUCacheData that were compressed, over all the queries, so that the host tier can tell
+* how much of its memory a table would take before it compresses it.
+*/
+class host_compression_stats {
+public:
+	static host_compression_stats & get_instance() {
+		static host_compression_stats instance;
+		return instance;
+	}
+
+	void record(std::size_t uncompressed_bytes, std::size_t compressed_bytes) {
+		this->uncompressed_bytes += uncompressed_bytes;
+		this->compressed_bytes += compressed_bytes;
+	}
+
+	/**
+	* The compressed size divided by the uncompressed size, 1 until something was compressed.
+	*/
+	double get_ratio() const {
+		std::size_t uncompressed = this->uncompressed_bytes;
+		return uncompressed == 0 ? 1.0 : std::min(1.0, static_cast<double>(this->compressed_bytes) / uncompressed);
+	}
+
+	std::size_t expected_host_bytes(std::size_t bytes) const {
+		return static_cast<std::size_t>(bytes * get_ratio());
+	}
+
+private:
+	host_compression_stats() = default;
+
+	std::atomic<std::size_t> uncompressed_bytes{0};
+	std::atomic<std::size_t> compressed_bytes{0};
+};
+
 /**
 * A CacheData that keeps its dataframe in CPU memory.
 * This is a CacheData representation that wraps a ral::frame::BlazingHostTable.
@@ -22,6 +60,15 @@ public:
 
 	CPUCacheData(std::unique_ptr<ral::frame::BlazingTable> gpu_table,const MetadataDictionary & metadata, bool use_pinned = false);
 
+	/**
+	* Constructor
+	* Takes a GPU based ral::frame::BlazingTable and starts copying it into pinned host memory on the stream of a
+	* host_copy_stream, without waiting for the copies. The GPU table is freed by the host_copy_stream once the copies are done.
+	* @param table The BlazingTable that is copied into a BlazingHostTable.
+	* @param copy_stream The host_copy_stream where the copies are issued.
+	*/
+	CPUCacheData(std::unique_ptr<ral::frame::BlazingTable> gpu_table, host_copy_stream & copy_stream);
+
 	CPUCacheData(const std::vector<blazingdb::transport::ColumnTransport> & column_transports,
 				std::vector<ral::memory::blazing_chunked_column_info> && chunked_column_infos,
 				std::vector<std::unique_ptr<ral::memory::blazing_allocation_chunk>> && allocations,
@@ -40,9 +87,20 @@ public:
 	* @return A unique_ptr to a BlazingTable
 	*/
 	std::unique_ptr<ral::frame::BlazingTable> decache() override {
+		wait_for_copies();
 		return std::move(host_table->get_gpu_table());
 	}
 
+	/**
+	* Decache only some of the columns of the BlazingHostTable. The buffers of the other columns stay in CPU memory.
+	* @param column_indices the indices of the columns wanted.
+	* @return A unique_ptr to a BlazingTable with only the wanted columns
+	*/
+	std::unique_ptr<ral::frame::BlazingTable> decache(const std::vector<int> & column_indices) override {
+		wait_for_copies();
+		return std::move(host_table->get_gpu_table(column_indices));
+	}
+
 	/**
 	* Release this BlazingHostTable from this CacheData
 	* If you want to allow this CacheData to be destroyed but want to keep the
@@ -52,9 +110,26 @@ public:
 	* BlazingTable.
 	*/
 	std::unique_ptr<ral::frame::BlazingHostTable> releaseHostTable() {
+		wait_for_copies();
+		host_table->decompress();
 		return std::move(host_table);
 	}
 
+	/**
+	* Compresses the buffers of the BlazingHostTable with lz4, with ENABLE_HOST_CACHE_COMPRESSION, so that the host tier
+	* holds more before it spills to disk. They are decompressed by decache and releaseHostTable.
+	* @return The bytes of host memory that were given back.
+	*/
+	std::size_t compress() {
+		wait_for_copies();
+		std::size_t host_bytes = host_table->get_host_bytes();
+		std::size_t freed_bytes = host_table->compress();
+		host_compression_stats::get_instance().record(host_bytes, host_bytes - freed_bytes);
+		return freed_bytes;
+	}
+
+	bool is_compressed() const { return host_table->is_compressed(); }
+
 	/**
 	* Get the amount of CPU memory consumed by this CacheData
 	* Having this function allows us to have one api for seeing the consumption
@@ -75,10 +150,24 @@ public:
 	/**
 	* Destructor
 	*/
-	virtual ~CPUCacheData() {}
+	virtual ~CPUCacheData() {
+		// the host buffers can not go back to their pool while a copy is still writing into them
+		wait_for_copies();
+	}
 
 protected:
+	/**
+	* Waits until the copies into the BlazingHostTable are done, if it was created asynchronously.
+	*/
+	void wait_for_copies() {
+		if (copy_event != nullptr) {
+			cudaEventSynchronize(copy_event.get());
+			copy_event.reset();
+		}
+	}
+
 	std::unique_ptr<ral::frame::BlazingHostTable> host_table; /**< The CPU representation of a DataFrame  */ 	
+	copy_event_ptr copy_event; /**< Recorded after the copies into the BlazingHostTable when it is created asynchronously. */
 };
 
 } // namespace cache
@@ -1,28 +1,314 @@
 #include "CacheMachine.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
 #include "CacheDataLocalFile.h"
 #include "CPUCacheData.h"
+#include "GPUCacheData.h"
+#include "ManagedMemoryHints.h"
 #include "communication/CommunicationData.h"
+#include "utilities/nvtx.h"
+#include "utilities/RuntimeMetrics.h"
+#include "utilities/EventLog.h"
 
 namespace ral {
 namespace cache {
 
-std::string MetadataDictionary::get_value(std::string key) {
-	if (!this->has_value(key)) {
-		return std::string();
+namespace {
+
+const std::string & header_field_label(header_field field) {
+	static const std::string labels[] = {QUERY_ID_METADATA_LABEL, KERNEL_ID_METADATA_LABEL, RAL_ID_METADATA_LABEL,
+		UNIQUE_MESSAGE_ID, TOTAL_TABLE_ROWS_METADATA_LABEL, AVG_BYTES_PER_ROW_METADATA_LABEL, PARTITION_COUNT,
+		ADD_TO_SPECIFIC_CACHE_METADATA_LABEL, CACHE_ID_METADATA_LABEL, SENDER_WORKER_ID_METADATA_LABEL,
+		WORKER_IDS_METADATA_LABEL, MESSAGE_ID};
+	return labels[static_cast<int>(field)];
+}
+
+// the header field of a label, or num_fields if it is an extension
+header_field find_header_field(const std::string & key) {
+	static const std::map<std::string, header_field> fields = [] {
+		std::map<std::string, header_field> fields;
+		for (int i = 0; i < static_cast<int>(header_field::num_fields); i++) {
+			fields[header_field_label(static_cast<header_field>(i))] = static_cast<header_field>(i);
+		}
+		return fields;
+	}();
+	auto it = fields.find(key);
+	return it == fields.end() ? header_field::num_fields : it->second;
+}
+
+// only the numbers that are written back the same way are kept as numbers, so that every value reads back as it was set
+bool parse_number(const std::string & value, int64_t & result) {
+	if (value.empty() || value.size() > 19) {
+		return false;
+	}
+	char * end = nullptr;
+	errno = 0;
+	long long parsed = std::strtoll(value.c_str(), &end, 10);
+	if (*end != '\0' || errno == ERANGE || std::to_string(parsed) != value) {
+		return false;
+	}
+	result = parsed;
+	return true;
+}
+
+// the member of the header of a field, const or not as the header is
+template <typename Header>
+auto number_field(Header & header, header_field field) -> decltype(&header.unique_message_id) {
+	switch (field) {
+	case header_field::unique_message_id: return &header.unique_message_id;
+	case header_field::total_table_rows: return &header.total_table_rows;
+	case header_field::avg_bytes_per_row: return &header.avg_bytes_per_row;
+	case header_field::partition_count: return &header.partition_count;
+	default: return nullptr;
+	}
+}
+
+template <typename Header>
+auto small_number_field(Header & header, header_field field) -> decltype(&header.query_id) {
+	switch (field) {
+	case header_field::query_id: return &header.query_id;
+	case header_field::kernel_id: return &header.kernel_id;
+	case header_field::ral_id: return &header.ral_id;
+	default: return nullptr;
 	}
-	return this->values.at(key);
 }
 
+template <typename Header>
+auto string_field(Header & header, header_field field) -> decltype(&header.cache_id) {
+	switch (field) {
+	case header_field::cache_id: return &header.cache_id;
+	case header_field::sender_worker_id: return &header.sender_worker_id;
+	case header_field::worker_ids: return &header.worker_ids;
+	case header_field::message_id: return &header.message_id;
+	default: return nullptr;
+	}
+}
+
+// the value of a field of the header that is set
+std::string header_value(const message_header & header, header_field field) {
+	if (auto number = small_number_field(header, field)) {
+		return std::to_string(*number);
+	}
+	if (auto number = number_field(header, field)) {
+		return std::to_string(*number);
+	}
+	if (field == header_field::add_to_specific_cache) {
+		return header.add_to_specific_cache ? "true" : "false";
+	}
+	return *string_field(header, field);
+}
+
+template <typename T>
+void append_bytes(std::vector<char> & buffer, const T & value) {
+	const char * bytes = reinterpret_cast<const char *>(&value);
+	buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+}
+
+void append_string(std::vector<char> & buffer, const std::string & value) {
+	append_bytes(buffer, static_cast<uint32_t>(value.size()));
+	buffer.insert(buffer.end(), value.begin(), value.end());
+}
+
+struct byte_reader {
+	const char * data;
+	std::size_t size;
+	std::size_t offset = 0;
+
+	void check(std::size_t bytes) {
+		if (offset + bytes > size) {
+			throw std::runtime_error("ERROR: the metadata of a message is truncated");
+		}
+	}
+
+	template <typename T>
+	T read() {
+		check(sizeof(T));
+		T value;
+		std::memcpy(&value, data + offset, sizeof(T));
+		offset += sizeof(T);
+		return value;
+	}
+
+	std::string read_string() {
+		uint32_t length = read<uint32_t>();
+		check(length);
+		std::string value(data + offset, length);
+		offset += length;
+		return value;
+	}
+};
+
+}  // namespace
+
 void MetadataDictionary::set_value(std::string key, std::string value) {
-	this->values[key] = value;
+	header_field field = find_header_field(key);
+	if (field != header_field::num_fields) {
+		uint16_t bit = uint16_t{1} << static_cast<int>(field);
+		bool is_set = true;
+		int64_t number;
+		if (int32_t * small_number = small_number_field(this->header, field)) {
+			is_set = parse_number(value, number) && number >= INT32_MIN && number <= INT32_MAX;
+			if (is_set) {
+				*small_number = static_cast<int32_t>(number);
+			}
+		} else if (int64_t * large_number = number_field(this->header, field)) {
+			is_set = parse_number(value, number);
+			if (is_set) {
+				*large_number = number;
+			}
+		} else if (field == header_field::add_to_specific_cache) {
+			is_set = value == "true" || value == "false";
+			this->header.add_to_specific_cache = value == "true";
+		} else {
+			*string_field(this->header, field) = std::move(value);
+		}
+
+		if (is_set) {
+			this->header.fields |= bit;
+			this->extensions.erase(key);
+			return;
+		}
+		// a value that is not a number is kept as it is, as an extension
+		this->header.fields &= ~bit;
+	}
+	this->extensions[std::move(key)] = std::move(value);
+}
+
+void MetadataDictionary::add_values(const MetadataDictionary & other) {
+	for (int i = 0; i < static_cast<int>(header_field::num_fields); i++) {
+		header_field field = static_cast<header_field>(i);
+		if (other.header.has(field)) {
+			this->set_value(header_field_label(field), header_value(other.header, field));
+		}
+	}
+	for (auto & extension : other.extensions) {
+		this->set_value(extension.first, extension.second);
+	}
+}
+
+std::string MetadataDictionary::get_value(const std::string & key) const {
+	header_field field = find_header_field(key);
+	if (field != header_field::num_fields && this->header.has(field)) {
+		return header_value(this->header, field);
+	}
+	auto it = this->extensions.find(key);
+	if (it == this->extensions.end()) {
+		return std::string();
+	}
+	return it->second;
 }
 
-std::unique_ptr<CacheData> CacheData::downgradeCacheData(std::unique_ptr<CacheData> cacheData, std::string id, std::shared_ptr<Context> ctx) {
+bool MetadataDictionary::has_value(const std::string & key) const {
+	header_field field = find_header_field(key);
+	if (field != header_field::num_fields && this->header.has(field)) {
+		return true;
+	}
+	return this->extensions.find(key) != this->extensions.end();
+}
+
+std::map<std::string,std::string> MetadataDictionary::get_values() const {
+	std::map<std::string,std::string> values = this->extensions;
+	for (int i = 0; i < static_cast<int>(header_field::num_fields); i++) {
+		header_field field = static_cast<header_field>(i);
+		if (this->header.has(field)) {
+			values[header_field_label(field)] = header_value(this->header, field);
+		}
+	}
+	return values;
+}
+
+void MetadataDictionary::set_values(const std::map<std::string,std::string> & new_values) {
+	this->header = message_header{};
+	this->extensions.clear();
+	for (auto & value : new_values) {
+		this->set_value(value.first, value.second);
+	}
+}
+
+void MetadataDictionary::serialize(std::vector<char> & buffer) const {
+	append_bytes(buffer, this->header.fields);
+	append_bytes(buffer, this->header.query_id);
+	append_bytes(buffer, this->header.kernel_id);
+	append_bytes(buffer, this->header.ral_id);
+	append_bytes(buffer, this->header.unique_message_id);
+	append_bytes(buffer, this->header.total_table_rows);
+	append_bytes(buffer, this->header.avg_bytes_per_row);
+	append_bytes(buffer, this->header.partition_count);
+	append_bytes(buffer, static_cast<uint8_t>(this->header.add_to_specific_cache));
+	for (header_field field : {header_field::cache_id, header_field::sender_worker_id, header_field::worker_ids, header_field::message_id}) {
+		if (this->header.has(field)) {
+			append_string(buffer, *string_field(this->header, field));
+		}
+	}
+
+	append_bytes(buffer, static_cast<uint32_t>(this->extensions.size()));
+	for (auto & extension : this->extensions) {
+		append_string(buffer, extension.first);
+		append_string(buffer, extension.second);
+	}
+}
+
+MetadataDictionary MetadataDictionary::deserialize(const char * data, std::size_t size) {
+	byte_reader reader{data, size};
+	MetadataDictionary metadata;
+	message_header & header = metadata.header;
+	header.fields = reader.read<uint16_t>();
+	header.query_id = reader.read<int32_t>();
+	header.kernel_id = reader.read<int32_t>();
+	header.ral_id = reader.read<int32_t>();
+	header.unique_message_id = reader.read<int64_t>();
+	header.total_table_rows = reader.read<int64_t>();
+	header.avg_bytes_per_row = reader.read<int64_t>();
+	header.partition_count = reader.read<int64_t>();
+	header.add_to_specific_cache = reader.read<uint8_t>() != 0;
+	for (header_field field : {header_field::cache_id, header_field::sender_worker_id, header_field::worker_ids, header_field::message_id}) {
+		if (header.has(field)) {
+			*string_field(header, field) = reader.read_string();
+		}
+	}
+
+	uint32_t num_extensions = reader.read<uint32_t>();
+	for (uint32_t i = 0; i < num_extensions; i++) {
+		std::string key = reader.read_string();
+		metadata.extensions[std::move(key)] = reader.read_string();
+	}
+	return metadata;
+}
+
+std::unique_ptr<ral::frame::BlazingTable> CacheData::decache(const std::vector<int> & column_indices) {
+	return select_columns(this->decache(), column_indices);
+}
+
+std::unique_ptr<ral::frame::BlazingTable> CacheData::select_columns(std::unique_ptr<ral::frame::BlazingTable> table, const std::vector<int> & column_indices) {
+	std::vector<std::string> names = table->names();
+	std::vector<std::unique_ptr<ral::frame::BlazingColumn>> columns = table->releaseBlazingColumns();
+
+	std::vector<std::unique_ptr<ral::frame::BlazingColumn>> selected_columns;
+	std::vector<std::string> selected_names;
+	for (int column_index : column_indices) {
+		selected_columns.push_back(std::move(columns[column_index]));
+		selected_names.push_back(names[column_index]);
+	}
+	return std::make_unique<ral::frame::BlazingTable>(std::move(selected_columns), selected_names);
+}
+
+std::unique_ptr<CacheData> CacheData::downgradeCacheData(std::unique_ptr<CacheData> cacheData, std::string id, std::shared_ptr<Context> ctx,
+		SpillFormat spill_format) {
 	
 	// if its not a GPU cacheData, then we can't downgrade it, so we can just return it
 	if (cacheData->get_type() != ral::cache::CacheDataType::GPU){
 		return cacheData;
+	} else if (managed_memory_hints::get_instance().is_host_advice_enabled()) {
+		// with managed memory the driver moves the pages of the table to the host, without a copy of our own that
+		// would need the GPU memory it is freeing
+		static_cast<GPUCacheData *>(cacheData.get())->advise_host_placement();
+		return cacheData;
 	} else {
+		BLAZING_NVTX_RANGE("downgrade " + id, spill);
 		CodeTimer cacheEventTimer(false);
 		cacheEventTimer.start();
 
@@ -31,47 +317,63 @@ std::unique_ptr<CacheData> CacheData::downgradeCacheData(std::unique_ptr<CacheDa
 		std::shared_ptr<spdlog::logger> cache_events_logger = spdlog::get("cache_events_logger");
 
 		// lets first try to put it into CPU
-		if (blazing_host_memory_resource::getInstance().get_memory_used() + table->sizeInBytes() <
-				blazing_host_memory_resource::getInstance().get_memory_limit()){
+		bool host_compression = ctx && ctx->getConfig().enable_host_cache_compression.value_or(false);
+		std::size_t host_bytes = host_compression ? host_compression_stats::get_instance().expected_host_bytes(table->sizeInBytes()) : table->sizeInBytes();
+		if (blazing_host_memory_resource::getInstance().can_hold(host_bytes)){
 
-			auto CPUCache = std::make_unique<CPUCacheData>(std::move(table));
+			// when there are pinned buffers the copies are only issued, so that whoever is downgrading does not wait for them
+			bool async_downgrade = ral::memory::buffer_providers::get_pinned_buffer_provider() != nullptr;
+			if (ctx) {
+				async_downgrade = async_downgrade && ctx->getConfig().async_cache_downgrade.value_or(true);
+			}
+			ral::utilities::runtime_metrics::get_instance().record_spill(ral::utilities::spill_tier::host, table->sizeInBytes());
+			auto CPUCache = async_downgrade ? std::make_unique<CPUCacheData>(std::move(table), host_copy_stream::get_instance())
+				: std::make_unique<CPUCacheData>(std::move(table));
+			if (host_compression) {
+				// it waits for the copies of an async downgrade, since it compresses the host buffers
+				CPUCache->compress();
+			}
 
 			cacheEventTimer.stop();
 			if(cache_events_logger) {
-						cache_events_logger->info("{ral_id}|{query_id}|{message_id}|{cache_id}|{num_rows}|{num_bytes}|{event_type}|{timestamp_begin}|{timestamp_end}|{description}",
-						"ral_id"_a=(ctx ? ctx->getNodeIndex(ral::communication::CommunicationData::getInstance().getSelfNode()) : -1),
-						"query_id"_a=(ctx ? ctx->getContextToken() : -1),
-						"message_id"_a="",
-						"cache_id"_a=id,
-						"num_rows"_a=(CPUCache ? CPUCache->num_rows() : -1),
-						"num_bytes"_a=(CPUCache ? CPUCache->sizeInBytes() : -1),
-						"event_type"_a="DowngradeCacheData",
-						"timestamp_begin"_a=cacheEventTimer.start_time(),
-						"timestamp_end"_a=cacheEventTimer.end_time(),
-						"description"_a="Downgraded CacheData to CPU cache");
+						ral::utilities::log_event(cache_events_logger,
+						(ctx ? ctx->getNodeIndex(ral::communication::CommunicationData::getInstance().getSelfNode()) : -1),
+						(ctx ? ctx->getContextToken() : -1),
+						"",
+						id,
+						(CPUCache ? CPUCache->num_rows() : -1),
+						(CPUCache ? CPUCache->sizeInBytes() : -1),
+						"DowngradeCacheData",
+						cacheEventTimer.start_time(),
+						cacheEventTimer.end_time(),
+						"Downgraded CacheData to CPU cache");
 					}
 			return CPUCache;
 		} else {
-			// want to get only cache directory where orc files should be saved
-			std::string orc_files_path = ral::communication::CommunicationData::getInstance().get_cache_directory();
+			std::string orc_files_path = reserve_spill_directory(table->sizeInBytes());
+			if (orc_files_path.empty()) {
+				// there is no room left in the disk tier either, so the data stays in GPU
+				return std::make_unique<GPUCacheData>(std::move(table), cacheData->getMetadata());
+			}
 
+			ral::utilities::runtime_metrics::get_instance().record_spill(ral::utilities::spill_tier::disk, table->sizeInBytes());
 			auto localCache = std::make_unique<CacheDataLocalFile>(std::move(table), orc_files_path,
 																(ctx ? std::to_string(ctx->getContextToken())
-																		: "none"));
+																		: "none"), spill_format);
 
 			cacheEventTimer.stop();
 			if(cache_events_logger) {
-				cache_events_logger->info("{ral_id}|{query_id}|{message_id}|{cache_id}|{num_rows}|{num_bytes}|{event_type}|{timestamp_begin}|{timestamp_end}|{description}",
-										"ral_id"_a=(ctx ? ctx->getNodeIndex(ral::communication::CommunicationData::getInstance().getSelfNode()) : -1),
-										"query_id"_a=(ctx ? ctx->getContextToken() : -1),
-										"message_id"_a="",
-										"cache_id"_a=id,
-										"num_rows"_a=(localCache ? localCache->num_rows() : -1),
-										"num_bytes"_a=(localCache ? localCache->sizeInBytes() : -1),
-										"event_type"_a="DowngradeCacheData",
-										"timestamp_begin"_a=cacheEventTimer.start_time(),
-										"timestamp_end"_a=cacheEventTimer.end_time(),
-										"description"_a="Downgraded CacheData to Disk cache to path: " + orc_files_path);
+				ral::utilities::log_event(cache_events_logger,
+										(ctx ? ctx->getNodeIndex(ral::communication::CommunicationData::getInstance().getSelfNode()) : -1),
+										(ctx ? ctx->getContextToken() : -1),
+										"",
+										id,
+										(localCache ? localCache->num_rows() : -1),
+										(localCache ? localCache->sizeInBytes() : -1),
+										"DowngradeCacheData",
+										cacheEventTimer.start_time(),
+										cacheEventTimer.end_time(),
+										"Downgraded CacheData to Disk cache to path: " + orc_files_path);
 			}
 
 			return localCache;
@@ -37,6 +37,20 @@ using namespace fmt::literals;
 */
 enum class CacheDataType { GPU, CPU, LOCAL_FILE, IO_FILE, CONCATENATING, PINNED, ARROW };
 
+/**
+* The format of the files that a CacheDataLocalFile writes when the caches spill to disk.
+* ORC compresses the data, which costs encoding and decoding time but uses less disk bandwidth and space.
+* RAW writes the column buffers just as they are in GPU memory, which avoids the codec cost for data that only lives a few seconds.
+*/
+enum class SpillFormat { ORC, RAW };
+
+/**
+* Gets the spill format from the CACHE_SPILL_FORMAT config option ("ORC" or "RAW"). Defaults to ORC.
+*/
+inline SpillFormat get_spill_format(const blazingdb::manager::QueryConfig & config) {
+	return config.cache_spill_raw ? SpillFormat::RAW : SpillFormat::ORC;
+}
+
 const std::string KERNEL_ID_METADATA_LABEL = "kernel_id"; /**< A message metadata field that indicates which kernel owns this message. */
 const std::string RAL_ID_METADATA_LABEL = "ral_id"; /**< A message metadata field that indicates RAL ran this. */
 const std::string QUERY_ID_METADATA_LABEL = "query_id"; /**< A message metadata field that indicates which query owns this message. */
@@ -52,6 +66,12 @@ const std::string AVG_BYTES_PER_ROW_METADATA_LABEL = "avg_bytes_per_row"; /** <
 const std::string MESSAGE_ID = "message_id"; /**< A message metadata field that indicates the id of a message. Not all messages have an id. Any message that has add_to_specific_cache == false MUST have a message id. */
 const std::string PARTITION_COUNT = "partition_count"; /**< A message metadata field that indicates the number of partitions a kernel processed.  */
 const std::string UNIQUE_MESSAGE_ID = "unique_message_id"; /**< A message metadata field that indicates the unique id of a message. */
+const std::string BROADCAST_SUBTREE_METADATA_LABEL = "broadcast_subtree"; /**< A message metadata field with the nodes that the receiver of a broadcast has to forward it to, see ral::distribution::serialize_broadcast_groups. Empty if it does not have to forward it. */
+const std::string RUNTIME_FILTER_RANGE_METADATA_LABEL = "runtime_filter_range"; /**< A message metadata field with the comma separated min and max of the keys of a runtime filter. Empty if the filter has no keys. */
+const std::string SCAN_STEAL_WANTS_FILES_METADATA_LABEL = "scan_steal_wants_files"; /**< A message metadata field of a request of the scan work stealing, "false" when the node only tells that it will not ask for files anymore, see ral::batch::scan_work_stealing. */
+const std::string SCAN_STOLEN_FILES_METADATA_LABEL = "scan_stolen_files"; /**< A message metadata field with the files that a reply of the scan work stealing gives, see ral::batch::serialize_scan_files. Empty if it gives none. */
+const std::string HASH_PARTITION_METADATA_LABEL = "hash_partition"; /**< A message metadata field with the index of the hash partition of its node that a partition of a shuffle is, with HASH_PARTITIONS_PER_NODE, see ral::cache::distributing_kernel::scatter_hash_partitions. Not set with one partition per node. */
+const std::string SHUFFLE_CHECKPOINT_RESTORABLE_METADATA_LABEL = "shuffle_checkpoint_restorable"; /**< A message metadata field with the comma separated ids of the kernels that can be restored from their shuffle checkpoint, as a node tells the master or the master tells all the nodes, see ral::cache::graph::plan_shuffle_checkpoint_restore. */
 
 // fields for window functions
 const std::string OVERLAP_STATUS = "overlap_status"; /**< A message metadata field that indicates the status of this overlap data. */
@@ -62,85 +82,192 @@ const std::string OVERLAP_TARGET_NODE_INDEX = "overlap_target_node_index"; /**<
 const std::string OVERLAP_TARGET_BATCH_INDEX = "overlap_target_batch_index"; /**< A message metadata field that contains an integer indicating the batch index for the node to whom it will be sent*/
 
 /**
-* Lightweight wrapper for a map that will one day be used for compile time checks.
-* Currently it is just a wrapper for map but in the future the intention is for
-* us to manage the Metadata in a struct as opposed to a map of string to string.
+* The well known fields of the metadata of a message, the ones that (almost) every message has.
+*/
+enum class header_field : uint8_t {
+	query_id,
+	kernel_id,
+	ral_id,
+	unique_message_id,
+	total_table_rows,
+	avg_bytes_per_row,
+	partition_count,
+	add_to_specific_cache,
+	cache_id,
+	sender_worker_id,
+	worker_ids,
+	message_id,
+	num_fields
+};
+
+/**
+* The well known fields of the metadata of a message, in a fixed layout so that they are not kept, copied and parsed
+* as strings for every batch. The numbers are kept parsed, and fields says which of the fields were set.
+*/
+struct message_header {
+	int32_t query_id = -1;
+	int32_t kernel_id = -1;
+	int32_t ral_id = -1;
+	int64_t unique_message_id = -1;
+	int64_t total_table_rows = -1;
+	int64_t avg_bytes_per_row = -1;
+	int64_t partition_count = -1;
+	bool add_to_specific_cache = false;
+	std::string cache_id;
+	std::string sender_worker_id;
+	std::string worker_ids;
+	std::string message_id;
+	uint16_t fields = 0; /**< A bit per header_field that was set */
+
+	bool has(header_field field) const {
+		return (fields >> static_cast<int>(field)) & 1;
+	}
+};
+
+/**
+* The metadata of a message, which is routed and planned with. The well known fields are kept in a message_header,
+* and the rest (like the ones of the window functions and the compression of the comms) in a small map of
+* extensions. The labels of the fields, like KERNEL_ID_METADATA_LABEL, work for both.
+* It is sent over the network as a binary header followed by the extensions (see serialize).
 */
 class MetadataDictionary{
 public:
 
 	/**
-	* Gets the type of CacheData that was used to construct this CacheData
-	* @param key The key in the map that we will be modifying.
+	* Sets a field of the metadata.
+	* @param key The label of the field that we will be modifying.
 	* @param value The value that we will set the key to.
 	*/
 	void add_value(std::string key, std::string value){
-		this->values[key] = value;
+		this->set_value(std::move(key), std::move(value));
 	}
 
 	/**
-	* Gets the type of CacheData that was used to construct this CacheData
-	* @param key The key in the map that we will be modifying.
+	* Sets a field of the metadata.
+	* @param key The label of the field that we will be modifying.
 	* @param value The value that we will set the key to.
 	*/
 	void add_value(std::string key, int value){
-		this->values[key] = std::to_string(value);
+		this->set_value(std::move(key), std::to_string(value));
 	}
 
+	/**
+	* Sets all the fields that the other metadata has, over the ones of this one.
+	*/
+	void add_values(const MetadataDictionary & other);
+
 	/**
 	* Gets id of creating kernel.
 	* @return Get the id of the kernel that created this message.
 	*/
-	int get_kernel_id(){
-		if( this->values.find(KERNEL_ID_METADATA_LABEL) == this->values.end()){
+	int get_kernel_id() const {
+		if (!this->header.has(header_field::kernel_id)) {
 			throw BlazingMissingMetadataException(KERNEL_ID_METADATA_LABEL);
 		}
-		return std::stoi(values[KERNEL_ID_METADATA_LABEL]);
+		return this->header.kernel_id;
+	}
+
+	/**
+	* Gets id of the query of the message.
+	*/
+	int32_t get_query_id() const {
+		if (!this->header.has(header_field::query_id)) {
+			throw BlazingMissingMetadataException(QUERY_ID_METADATA_LABEL);
+		}
+		return this->header.query_id;
+	}
+
+	/**
+	* Gets the rows of the table that the message is about (TOTAL_TABLE_ROWS_METADATA_LABEL).
+	*/
+	int64_t get_total_table_rows() const {
+		if (!this->header.has(header_field::total_table_rows)) {
+			throw BlazingMissingMetadataException(TOTAL_TABLE_ROWS_METADATA_LABEL);
+		}
+		return this->header.total_table_rows;
+	}
+
+	/**
+	* Gets the average bytes per row of the table that the message is about (AVG_BYTES_PER_ROW_METADATA_LABEL).
+	*/
+	int64_t get_avg_bytes_per_row() const {
+		if (!this->header.has(header_field::avg_bytes_per_row)) {
+			throw BlazingMissingMetadataException(AVG_BYTES_PER_ROW_METADATA_LABEL);
+		}
+		return this->header.avg_bytes_per_row;
+	}
+
+	/**
+	* Gets the number of partitions that a kernel sent (PARTITION_COUNT).
+	*/
+	int64_t get_partition_count() const {
+		if (!this->header.has(header_field::partition_count)) {
+			throw BlazingMissingMetadataException(PARTITION_COUNT);
+		}
+		return this->header.partition_count;
+	}
+
+	const message_header & get_header() const {
+		return this->header;
 	}
 
 	/**
 	* Print every key => value pair in the map.
 	* Only used for debugging purposes.
 	*/
-	void print(){
-		for(auto elem : this->values)
+	void print() const {
+		for(auto elem : this->get_values())
 		{
 		   std::cout << elem.first << " " << elem.second<< "\n";
 		}
 	}
+
 	/**
-	* Gets the map storing the metadata.
-	* @return the map storing all of the metadata.
+	* Builds a map with all the fields of the metadata, by their labels.
+	* Not meant for the hot paths, they read the fields they need with get_header or get_value.
+	* @return a map with all of the metadata.
 	*/
-
-	std::map<std::string,std::string> get_values() const {
-		return this->values;
-	}
+	std::map<std::string,std::string> get_values() const;
 
 	/**
 	* Erases all current metadata and sets new values.
-	* @param new_values A map to copy into this->values .
+	* @param new_values A map with the fields to set, by their labels.
 	*/
-	void set_values(std::map<std::string,std::string> new_values){
-		this->values= new_values;
-	}
+	void set_values(const std::map<std::string,std::string> & new_values);
 
 	/**
 	* Checks if metadata has a specific key
 	* @param key The key to check if is in the metadata
 	* @return true if the key is in the metadata, otherwise return false
 	*/
-	bool has_value(std::string key){
-		auto it = this->values.find(key);
-		return it != this->values.end();
-	}
+	bool has_value(const std::string & key) const;
 
-    std::string get_value(std::string key);
+	/**
+	* Gets the value of a key, or an empty string if it is not in the metadata.
+	*/
+	std::string get_value(const std::string & key) const;
 
-    void set_value(std::string key, std::string value);
+	void set_value(std::string key, std::string value);
+
+	/**
+	* Appends the metadata to a buffer: the fields bitmask, the numbers of the header, the length and bytes of each
+	* of its strings that was set, and the number of extensions followed by the length and bytes of each key and value.
+	*/
+	void serialize(std::vector<char> & buffer) const;
+
+	/**
+	* Reads the metadata that serialize wrote.
+	* @throws std::runtime_error if the bytes end before the metadata does.
+	*/
+	static MetadataDictionary deserialize(const char * data, std::size_t size);
+
+	bool operator==(const MetadataDictionary & other) const {
+		return this->get_values() == other.get_values();
+	}
 
 private:
-	std::map<std::string,std::string> values; /**< Stores the mapping of metdata label to metadata value */
+	message_header header; /**< The well known fields */
+	std::map<std::string,std::string> extensions; /**< The rest of the fields, by their labels */
 };
 
 /**
@@ -178,6 +305,15 @@ public:
 	*/
 	virtual std::unique_ptr<ral::frame::BlazingTable> decache() = 0;
 
+	/**
+	* Remove the payload from this CacheData, keeping only some of its columns.
+	* CacheData that are not in GPU memory override this so that the columns that are not wanted are never brought
+	* back into the GPU. By default the whole table is decached and the other columns are dropped.
+	* @param column_indices the indices of the columns wanted, in the order they will have in the BlazingTable. They must be unique.
+	* @return a BlazingTable with only the wanted columns
+	*/
+	virtual std::unique_ptr<ral::frame::BlazingTable> decache(const std::vector<int> & column_indices);
+
 	/**
 	* . A pure virtual function.
 	* This removes the payload for the CacheData. After this the CacheData will
@@ -186,6 +322,12 @@ public:
 	*/
 	virtual size_t sizeInBytes() const = 0;
 
+	/**
+	* Get the GPU memory that the table of a CacheData that is not loaded yet is estimated to take once it is decached,
+	* like the columns an IO_FILE CacheData decodes from its file. It is 0 for the ones that sizeInBytes tells.
+	*/
+	virtual size_t estimatedDecachedBytes() const { return 0; }
+
 	/**
 	* Set the names of the columns.
 	* @param names a vector of the column names.
@@ -246,7 +388,7 @@ public:
 	* Get the MetadataDictionary
 	* @return The MetadataDictionary which is used in routing and planning.
 	*/
-	MetadataDictionary getMetadata(){
+	const MetadataDictionary & getMetadata() const {
 		return this->metadata;
 	}
 
@@ -254,9 +396,17 @@ public:
 	 * Utility function which can take a CacheData and if its a standard GPU cache data, it will downgrade it to CPU or Disk
 	 * @return If the input CacheData is not of a type that can be downgraded, it will just return the original input, otherwise it will return the downgraded CacheData.
 	 */
-	static std::unique_ptr<CacheData> downgradeCacheData(std::unique_ptr<CacheData> cacheData, std::string id, std::shared_ptr<Context> ctx);
+	static std::unique_ptr<CacheData> downgradeCacheData(std::unique_ptr<CacheData> cacheData, std::string id, std::shared_ptr<Context> ctx,
+		SpillFormat spill_format = SpillFormat::ORC);
 
 protected:
+	/**
+	* Keeps only some of the columns of a table, dropping the others.
+	* @param table the table whose columns are taken.
+	* @param column_indices the indices of the columns to keep, in the order they will have. They must be unique.
+	*/
+	static std::unique_ptr<ral::frame::BlazingTable> select_columns(std::unique_ptr<ral::frame::BlazingTable> table, const std::vector<int> & column_indices);
+
 	CacheDataType cache_type; /**< The CacheDataType that is used to store the dataframe representation. */
 	std::vector<std::string> col_names; /**< A vector storing the names of the columns in the dataframe representation. */
 	std::vector<cudf::data_type> schema; /**< A vector storing the cudf::data_type of the columns in the dataframe representation. */
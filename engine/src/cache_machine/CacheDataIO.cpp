@@ -1,5 +1,6 @@
 #include "CacheDataIO.h"
 #include "parser/CalciteExpressionParsing.h"
+#include "io/data_provider/shared_scan.h"
 
 namespace ral {
 namespace cache {
@@ -15,16 +16,80 @@ CacheDataIO::CacheDataIO(ral::io::data_handle handle,
 	file_schema(file_schema), row_group_ids(row_group_ids),
 	projections(projections)
 	{
+		// the bytes the parser reads are read ahead while the tasks before this one run
+		std::vector<int> column_indices_in_file;
+		for (auto projection_idx : projections){
+			if(schema.all_in_file() || schema.get_in_file()[projection_idx]) {
+				column_indices_in_file.push_back(projection_idx);
+			}
+		}
+		this->handle.prefetched = parser->prefetch(handle, file_schema, column_indices_in_file, row_group_ids);
 
+		// a file whose metadata can't be read fails when it is parsed, not here
+		try {
+			if (column_indices_in_file.empty() ||
+					!parser->estimate_decoded_bytes(handle, file_schema, column_indices_in_file, row_group_ids, decoded_bytes_estimate)) {
+				decoded_bytes_estimate = 0;
+			}
+		} catch (const std::exception & e) {
+			decoded_bytes_estimate = 0;
+		}
 	}
 
 size_t CacheDataIO::sizeInBytes() const{
 	return 0;
 }
 
+size_t CacheDataIO::estimatedDecachedBytes() const{
+	return decoded_bytes_estimate;
+}
+
 std::unique_ptr<ral::frame::BlazingTable> CacheDataIO::decache(){
+	return load_columns(this->projections, this->row_group_ids);
+}
+
+std::unique_ptr<ral::frame::BlazingTable> CacheDataIO::decache(const std::vector<int> & column_indices){
+	std::vector<int> selected_projections;
+	for (int column_index : column_indices){
+		selected_projections.push_back(this->projections[column_index]);
+	}
+	return load_columns(selected_projections, this->row_group_ids);
+}
+
+std::unique_ptr<ral::frame::BlazingTable> CacheDataIO::decache(const std::vector<int> & column_indices, const std::vector<int> & row_group_ids){
+	std::vector<int> selected_projections;
+	for (int column_index : column_indices){
+		selected_projections.push_back(this->projections[column_index]);
+	}
+	return load_columns(selected_projections, row_group_ids);
+}
+
+bool CacheDataIO::get_row_group_num_rows(std::vector<int> & row_group_ids, std::vector<cudf::size_type> & num_rows){
+	// a slice of a row group is not a row group the parser can be asked for
+	if (handle.num_rows >= 0) {
+		return false;
+	}
+	row_group_ids = this->row_group_ids;
+	return parser->get_row_group_num_rows(handle, row_group_ids, num_rows);
+}
+
+std::unique_ptr<ral::frame::BlazingTable> CacheDataIO::parse_batch(const std::vector<int> & column_indices_in_file, const std::vector<int> & row_group_ids){
+	// the concurrent queries that read the same row groups of a parquet or orc file share the read
+	bool shareable = (parser->type() == ral::io::DataType::PARQUET || parser->type() == ral::io::DataType::ORC) &&
+		handle.file_handle != nullptr && handle.uri.isValid() && handle.num_rows < 0;
+	if (!shareable) {
+		return parser->parse_batch(handle, file_schema, column_indices_in_file, row_group_ids);
+	}
+	std::string file_key = ral::io::shared_scan::make_file_key(handle.uri.toString(), schema.get_names(), schema.get_dtypes());
+	return ral::io::shared_scan::get_instance().read(file_key, column_indices_in_file, row_group_ids,
+		[this, &row_group_ids](const std::vector<int> & column_indices) {
+			return parser->parse_batch(handle, file_schema, column_indices, row_group_ids);
+		});
+}
+
+std::unique_ptr<ral::frame::BlazingTable> CacheDataIO::load_columns(const std::vector<int> & projections, const std::vector<int> & row_group_ids){
 	if (schema.all_in_file()){
-		std::unique_ptr<ral::frame::BlazingTable> loaded_table = parser->parse_batch(handle, file_schema, projections, row_group_ids);
+		std::unique_ptr<ral::frame::BlazingTable> loaded_table = parse_batch(projections, row_group_ids);
 		return loaded_table;
 	} else {
 		std::vector<int> column_indices_in_file;  // column indices that are from files
@@ -39,7 +104,7 @@ std::unique_ptr<ral::frame::BlazingTable> CacheDataIO::decache(){
 		std::vector<std::string> names;
 		cudf::size_type num_rows;
 		if (column_indices_in_file.size() > 0){
-			std::unique_ptr<ral::frame::BlazingTable> current_blazing_table = parser->parse_batch(handle, file_schema, column_indices_in_file, row_group_ids);
+			std::unique_ptr<ral::frame::BlazingTable> current_blazing_table = parse_batch(column_indices_in_file, row_group_ids);
 			names = current_blazing_table->names();
 			std::unique_ptr<CudfTable> current_table = current_blazing_table->releaseCudfTable();
 			num_rows = current_table->num_rows();
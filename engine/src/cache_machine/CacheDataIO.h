@@ -33,6 +33,25 @@ public:
 	*/
 	std::unique_ptr<ral::frame::BlazingTable> decache() override;
 
+	/**
+	* Loads only some of the projected columns, so the parser does not read the others.
+	* @param column_indices the indices of the wanted columns among the projected columns.
+	*/
+	std::unique_ptr<ral::frame::BlazingTable> decache(const std::vector<int> & column_indices) override;
+
+	/**
+	* Loads only some of the projected columns of only some of the row groups, so the parser does not decode the others.
+	* @param column_indices the indices of the wanted columns among the projected columns.
+	* @param row_group_ids the wanted row groups, among the ones given by get_row_group_num_rows. It can't be empty.
+	*/
+	std::unique_ptr<ral::frame::BlazingTable> decache(const std::vector<int> & column_indices, const std::vector<int> & row_group_ids);
+
+	/**
+	* Gets the row groups that are loaded and their number of rows, in the order their rows are loaded.
+	* @return false if the parser can't tell them.
+	*/
+	bool get_row_group_num_rows(std::vector<int> & row_group_ids, std::vector<cudf::size_type> & num_rows);
+
 	/**
 	* Get the amount of GPU memory that the decached BlazingTable WOULD consume.
 	* Having this function allows us to have one api for seeing how much GPU
@@ -42,6 +61,12 @@ public:
 	*/
 	size_t sizeInBytes() const override;
 
+	/**
+	* Get the GPU memory the projected columns are estimated to take once they are decoded, from the metadata of the file.
+	* It is computed once, when the CacheData is made.
+	*/
+	size_t estimatedDecachedBytes() const override;
+
 	/**
 	* Set the names of the columns from the schema.
 	* @param names a vector of the column names.
@@ -54,12 +79,18 @@ public:
 	virtual ~CacheDataIO() {}
 
 private:
+	// reads the columns from the file, sharing the read with the other queries that read them at the same time
+	std::unique_ptr<ral::frame::BlazingTable> parse_batch(const std::vector<int> & column_indices_in_file, const std::vector<int> & row_group_ids);
+
+	std::unique_ptr<ral::frame::BlazingTable> load_columns(const std::vector<int> & projections, const std::vector<int> & row_group_ids);
+
 	ral::io::data_handle handle;
 	std::shared_ptr<ral::io::data_parser> parser;
 	ral::io::Schema schema;
 	ral::io::Schema file_schema;
 	std::vector<int> row_group_ids;
 	std::vector<int> projections;
+	size_t decoded_bytes_estimate = 0;
 };
 
 } // namespace cache
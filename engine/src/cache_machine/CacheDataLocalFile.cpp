@@ -1,11 +1,156 @@
 #include "CacheDataLocalFile.h"
+#include <algorithm>
+#include <cstdio>
+#include <fcntl.h>
+#include <functional>
+#include <numeric>
 #include <random>
+#include <unistd.h>
 #include "cudf/types.hpp" //cudf::io::metadata
 #include <cudf/io/orc.hpp>
+#include "communication/CommunicationInterface/serializer.hpp"
+#include "communication/CommunicationData.h"
+#include "blazing_table/BlazingHostTable.h"
+#include "utilities/CommonOperations.h"
+#include "utilities/nvtx.h"
 
 namespace ral {
 namespace cache {
 
+namespace {
+
+using ColumnTransport = blazingdb::transport::ColumnTransport;
+
+const std::uint64_t raw_file_magic = 0x4c495053515a4c42; // "BLZQSPIL"
+
+struct raw_file_header {
+	std::uint64_t magic;
+	std::uint64_t num_column_transports;
+	std::uint64_t num_buffers;
+};
+
+/**
+* The two host chunks used to stage the buffers between the GPU and a RAW file, and the events that tell when their copies are done.
+* The chunks come from the pinned buffer provider so the copies can be asynchronous. If there is no pinned buffer provider, they are pageable.
+*/
+class staging_chunks {
+public:
+	staging_chunks() : pool(ral::memory::buffer_providers::get_pinned_buffer_provider()) {
+		for (int i = 0; i < 2; i++) {
+			if (pool != nullptr) {
+				chunks[i] = pool->get_chunk();
+				chunk_size = pool->size_buffers();
+			} else {
+				pageable_chunks[i].resize(default_chunk_size);
+				chunk_size = default_chunk_size;
+			}
+			cudaEventCreateWithFlags(&events[i], cudaEventDisableTiming);
+		}
+	}
+
+	~staging_chunks() {
+		for (int i = 0; i < 2; i++) {
+			if (pool != nullptr) {
+				pool->free_chunk(std::move(chunks[i]));
+			}
+			cudaEventDestroy(events[i]);
+		}
+	}
+
+	char * data(int i) { return pool != nullptr ? chunks[i]->data : pageable_chunks[i].data(); }
+
+	cudaEvent_t event(int i) { return events[i]; }
+
+	std::size_t size() const { return chunk_size; }
+
+private:
+	static constexpr std::size_t default_chunk_size = 4 * 1024 * 1024;
+
+	std::shared_ptr<ral::memory::allocation_pool> pool;
+	std::unique_ptr<ral::memory::blazing_allocation_chunk> chunks[2];
+	std::vector<char> pageable_chunks[2];
+	cudaEvent_t events[2];
+	std::size_t chunk_size;
+};
+
+/**
+* Writes or reads a spill from its position in a file: the file of the spill, or the segment of its extent, which other
+* spills use too, so it is only written and read with pwrite and pread.
+*/
+class spill_io {
+public:
+	spill_io(int fd, std::size_t position, bool owned, const std::string & path) : fd(fd), position(position), owned(owned), path(path) {}
+
+	spill_io(const spill_io &) = delete;
+	spill_io & operator=(const spill_io &) = delete;
+
+	~spill_io() {
+		if (owned) {
+			close(fd);
+		}
+	}
+
+	void write(const void * data, std::size_t size) {
+		const char * bytes = static_cast<const char *>(data);
+		std::size_t written = 0;
+		while (written < size) {
+			ssize_t result = pwrite(fd, bytes + written, size - written, position + written);
+			if (result <= 0) {
+				throw std::runtime_error("Failed to write " + std::to_string(size) + " bytes to " + path);
+			}
+			written += result;
+		}
+		position += size;
+	}
+
+	void read(void * data, std::size_t size) {
+		char * bytes = static_cast<char *>(data);
+		std::size_t read_bytes = 0;
+		while (read_bytes < size) {
+			ssize_t result = pread(fd, bytes + read_bytes, size - read_bytes, position + read_bytes);
+			if (result <= 0) {
+				throw std::runtime_error("Failed to read " + std::to_string(size) + " bytes from " + path);
+			}
+			read_bytes += result;
+		}
+		position += size;
+	}
+
+	void skip(std::size_t size) { position += size; }
+
+private:
+	int fd;
+	std::size_t position;
+	bool owned;
+	std::string path;
+};
+
+spill_io open_spill(const ral::cache::spill_extent & extent, const std::string & path, bool write) {
+	if (extent.segment != nullptr) {
+		return spill_io(extent.segment->fd, extent.offset, false, path);
+	}
+	int fd = write ? open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644) : open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		throw std::runtime_error("Failed to open " + path);
+	}
+	return spill_io(fd, 0, true, path);
+}
+
+std::size_t get_raw_file_size(const std::vector<ColumnTransport> & column_transports, const std::vector<std::size_t> & buffer_sizes) {
+	return sizeof(raw_file_header) + column_transports.size() * sizeof(ColumnTransport) + buffer_sizes.size() * sizeof(std::size_t) +
+		std::accumulate(buffer_sizes.begin(), buffer_sizes.end(), std::size_t{0});
+}
+
+}  // namespace
+
+std::string reserve_spill_directory(size_t bytes) {
+	auto & disk_resource = blazing_disk_memory_resource::getInstance();
+	if (disk_resource.get_spill_directories().empty()) {
+		return ral::communication::CommunicationData::getInstance().get_cache_directory();
+	}
+	return disk_resource.reserve_spill_directory(bytes);
+}
+
 //TODO: Rommel Use randomeString from StringUtil
 std::string randomString(std::size_t length) {
 	const std::string characters = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
@@ -23,38 +168,64 @@ std::string randomString(std::size_t length) {
 	return random_string;
 }
 
-CacheDataLocalFile::CacheDataLocalFile(std::unique_ptr<ral::frame::BlazingTable> table, std::string orc_files_path, std::string ctx_token)
-	: CacheData(CacheDataType::LOCAL_FILE, table->names(), table->get_schema(), table->num_rows())
+CacheDataLocalFile::CacheDataLocalFile(std::unique_ptr<ral::frame::BlazingTable> table, std::string orc_files_path, std::string ctx_token,
+	SpillFormat spill_format)
+	: CacheData(CacheDataType::LOCAL_FILE, table->names(), table->get_schema(), table->num_rows()),
+	  spill_format(ral::utilities::has_nested_columns(table->view()) ? SpillFormat::RAW : spill_format)
 {
+	BLAZING_NVTX_RANGE("spill to disk", spill);
 	this->size_in_bytes = table->sizeInBytes();
-	this->filePath_ = orc_files_path + "/.blazing-temp-" + ctx_token + "-" + randomString(64) + ".orc";
+	this->directory = orc_files_path;
+	this->ctx_token = ctx_token;
+	this->filePath_ = orc_files_path + "/.blazing-temp-" + ctx_token + "-" + randomString(64) + (this->spill_format == SpillFormat::RAW ? ".raw" : ".orc");
 
 	// filling this->col_names
 	for(auto name : table->names()) {
 		this->col_names.push_back(name);
 	}
 
+	write_with_retries([&]() {
+		if (this->spill_format == SpillFormat::RAW) {
+			write_raw_file(table->toBlazingTableView());
+		} else {
+			write_orc_file(*table);
+		}
+	}, table->num_rows());
+}
+
+CacheDataLocalFile::CacheDataLocalFile(std::unique_ptr<ral::frame::BlazingHostTable> host_table, std::string orc_files_path, std::string ctx_token)
+	: CacheData(CacheDataType::LOCAL_FILE, host_table->names(), host_table->get_schema(), host_table->num_rows()), spill_format(SpillFormat::RAW)
+{
+	BLAZING_NVTX_RANGE("spill to disk", spill);
+	this->size_in_bytes = host_table->sizeInBytes();
+	this->directory = orc_files_path;
+	this->ctx_token = ctx_token;
+	this->filePath_ = orc_files_path + "/.blazing-temp-" + ctx_token + "-" + randomString(64) + ".raw";
+	this->col_names = host_table->names();
+
+	write_with_retries([&]() { write_raw_file(*host_table); }, host_table->num_rows());
+}
+
+void CacheDataLocalFile::write_with_retries(const std::function<void()> & write, cudf::size_type num_rows) {
 	int attempts = 0;
 	int attempts_limit = 10;
 	while(attempts <= attempts_limit){
 		try {
-			cudf::io::table_metadata metadata;
-			for(auto name : table->names()) {
-				metadata.column_names.emplace_back(name);
-			}
-
-			cudf::io::orc_writer_options out_opts = cudf::io::orc_writer_options::builder(cudf::io::sink_info{this->filePath_}, table->view())
-				.metadata(&metadata);
-
-			cudf::io::write_orc(out_opts);
-		} catch (cudf::logic_error & err){
+			write();
+			break;
+		} catch (std::exception & err){
 			std::shared_ptr<spdlog::logger> logger = spdlog::get("batch_logger");
 			if(logger) {
 				logger->error("|||{info}||||rows|{rows}",
 					"info"_a="Failed to create CacheDataLocalFile in path: " + this->filePath_ + " attempt " + std::to_string(attempts),
-					"rows"_a=table->num_rows());
+					"rows"_a=num_rows);
 			}	
 			attempts++;
+			// the next attempt takes another extent
+			if (this->extent.segment != nullptr) {
+				spill_manager::get_instance().release(std::move(this->extent));
+				this->extent = spill_extent();
+			}
 			if (attempts == attempts_limit){
 				throw;
 			}
@@ -63,7 +234,192 @@ CacheDataLocalFile::CacheDataLocalFile(std::unique_ptr<ral::frame::BlazingTable>
 	}
 }
 
+void CacheDataLocalFile::reserve_space(std::size_t bytes) {
+	auto & manager = spill_manager::get_instance();
+	// the caches without a query spill under "none", which never finishes, so their segments would never be unlinked
+	if (manager.is_enabled() && this->ctx_token != "none") {
+		this->extent = manager.allocate(this->directory, this->ctx_token, bytes);
+		this->filePath_ = this->extent.segment->path;
+	}
+	this->spill_bytes = bytes;
+}
+
+void CacheDataLocalFile::remove_file() {
+	if (this->extent.segment != nullptr) {
+		spill_manager::get_instance().release(std::move(this->extent));
+		this->extent = spill_extent();
+	} else {
+		remove(this->filePath_.c_str());
+	}
+}
+
+void CacheDataLocalFile::write_orc_file(const ral::frame::BlazingTable & table) {
+	cudf::io::table_metadata metadata;
+	for(cudf::size_type i = 0; i < table.num_columns(); i++) {
+		metadata.column_names.emplace_back(std::to_string(i));
+	}
+
+	// the size of an ORC file is only known once it is written, so it gets a file of its own instead of an extent of a
+	// segment, which would need the whole file in host memory first, when the host tier is already full
+	cudf::io::orc_writer_options out_opts = cudf::io::orc_writer_options::builder(cudf::io::sink_info{this->filePath_}, table.view())
+		.metadata(&metadata);
+
+	cudf::io::write_orc(out_opts);
+}
+
+void CacheDataLocalFile::write_raw_file(const ral::frame::BlazingTableView & table) {
+	std::vector<std::size_t> buffer_sizes;
+	std::vector<const char *> raw_buffers;
+	std::vector<ColumnTransport> column_transports;
+	std::vector<std::unique_ptr<rmm::device_buffer>> temp_scope_holder;
+	std::tie(buffer_sizes, raw_buffers, column_transports, temp_scope_holder) =
+		ral::communication::messages::serialize_gpu_message_to_gpu_containers(table);
+
+	reserve_space(get_raw_file_size(column_transports, buffer_sizes));
+	spill_io file = open_spill(this->extent, this->filePath_, true);
+
+	raw_file_header header{raw_file_magic, column_transports.size(), buffer_sizes.size()};
+	file.write(&header, sizeof(header));
+	file.write(column_transports.data(), column_transports.size() * sizeof(ColumnTransport));
+	file.write(buffer_sizes.data(), buffer_sizes.size() * sizeof(std::size_t));
+
+	// while a piece of a buffer is being copied into one chunk, the previous piece is written from the other chunk
+	staging_chunks staging;
+	int slot = 0;
+	int pending_slot = -1;
+	std::size_t pending_size = 0;
+	for (std::size_t i = 0; i < raw_buffers.size(); i++) {
+		for (std::size_t offset = 0; offset < buffer_sizes[i]; offset += staging.size()) {
+			std::size_t piece_size = std::min(staging.size(), buffer_sizes[i] - offset);
+			cudaMemcpyAsync(staging.data(slot), raw_buffers[i] + offset, piece_size, cudaMemcpyDeviceToHost, 0);
+			cudaEventRecord(staging.event(slot), 0);
+			if (pending_slot >= 0) {
+				cudaEventSynchronize(staging.event(pending_slot));
+				file.write(staging.data(pending_slot), pending_size);
+			}
+			pending_slot = slot;
+			pending_size = piece_size;
+			slot = 1 - slot;
+		}
+	}
+	if (pending_slot >= 0) {
+		cudaEventSynchronize(staging.event(pending_slot));
+		file.write(staging.data(pending_slot), pending_size);
+	}
+}
+
+void CacheDataLocalFile::write_raw_file(const ral::frame::BlazingHostTable & host_table) {
+	// the buffers of a BlazingHostTable are the ones serialize_gpu_message_to_gpu_containers makes, split in chunks,
+	// so they are written as they are and the file reads back like the ones written from the GPU
+	const std::vector<ColumnTransport> & column_transports = host_table.get_columns_offsets();
+	const std::vector<ral::memory::blazing_chunked_column_info> & chunked_column_infos = host_table.get_blazing_chunked_column_infos();
+	std::vector<ral::memory::blazing_allocation_chunk> chunks = host_table.get_raw_buffers();
+	std::vector<std::size_t> buffer_sizes;
+	for (auto & chunked_column_info : chunked_column_infos) {
+		buffer_sizes.push_back(chunked_column_info.use_size);
+	}
+
+	reserve_space(get_raw_file_size(column_transports, buffer_sizes));
+	spill_io file = open_spill(this->extent, this->filePath_, true);
+
+	raw_file_header header{raw_file_magic, column_transports.size(), buffer_sizes.size()};
+	file.write(&header, sizeof(header));
+	file.write(column_transports.data(), column_transports.size() * sizeof(ColumnTransport));
+	file.write(buffer_sizes.data(), buffer_sizes.size() * sizeof(std::size_t));
+	for (auto & chunked_column_info : chunked_column_infos) {
+		for (std::size_t i = 0; i < chunked_column_info.chunk_index.size(); i++) {
+			file.write(chunks[chunked_column_info.chunk_index[i]].data + chunked_column_info.offset[i], chunked_column_info.size[i]);
+		}
+	}
+}
+
+std::unique_ptr<ral::frame::BlazingTable> CacheDataLocalFile::read_orc_file(const std::vector<int> & column_indices) {
+	std::vector<std::string> file_column_names;
+	std::vector<std::string> names;
+	for (int column_index : column_indices) {
+		file_column_names.push_back(std::to_string(column_index));
+		names.push_back(this->col_names[column_index]);
+	}
+
+	cudf::io::orc_reader_options read_opts = cudf::io::orc_reader_options::builder(cudf::io::source_info{this->filePath_});
+	if (column_indices.size() < this->col_names.size()) {
+		read_opts.set_columns(file_column_names);
+	}
+	auto result = cudf::io::read_orc(read_opts);
+
+	// the reader may not return the columns in the order they were asked for, so they are put in that order by their names
+	std::vector<int> order;
+	for (auto & file_column_name : file_column_names) {
+		auto it = std::find(result.metadata.column_names.begin(), result.metadata.column_names.end(), file_column_name);
+		RAL_EXPECTS(it != result.metadata.column_names.end(), "Column " + file_column_name + " not found in " + this->filePath_);
+		order.push_back(std::distance(result.metadata.column_names.begin(), it));
+	}
+	auto table = select_columns(std::make_unique<ral::frame::BlazingTable>(std::move(result.tbl), result.metadata.column_names), order);
+	table->setNames(names);
+	return table;
+}
+
+std::unique_ptr<ral::frame::BlazingTable> CacheDataLocalFile::read_raw_file(const std::vector<int> & column_indices) {
+	spill_io file = open_spill(this->extent, this->filePath_, false);
+
+	raw_file_header header;
+	file.read(&header, sizeof(header));
+	if (header.magic != raw_file_magic) {
+		throw std::runtime_error(this->filePath_ + " is not a RAW spill file");
+	}
+	std::vector<ColumnTransport> column_transports(header.num_column_transports);
+	std::vector<std::size_t> buffer_sizes(header.num_buffers);
+	file.read(column_transports.data(), column_transports.size() * sizeof(ColumnTransport));
+	file.read(buffer_sizes.data(), buffer_sizes.size() * sizeof(std::size_t));
+
+	// only the buffers of the wanted columns are read, the others are skipped
+	std::vector<int> buffer_indices;
+	std::vector<ColumnTransport> selected_column_transports = comm::select_column_transports(column_transports, column_indices, buffer_indices);
+	std::vector<int> new_buffer_positions(buffer_sizes.size(), -1);
+	for (std::size_t i = 0; i < buffer_indices.size(); i++) {
+		new_buffer_positions[buffer_indices[i]] = i;
+	}
+
+	// while a piece of a buffer is being copied from one chunk into the GPU, the next piece is read into the other chunk
+	staging_chunks staging;
+	bool chunk_in_use[2] = {false, false};
+	int slot = 0;
+	std::vector<rmm::device_buffer> raw_buffers(buffer_indices.size());
+	for (std::size_t i = 0; i < buffer_sizes.size(); i++) {
+		if (new_buffer_positions[i] == -1) {
+			file.skip(buffer_sizes[i]);
+			continue;
+		}
+		auto & raw_buffer = raw_buffers[new_buffer_positions[i]];
+		raw_buffer.resize(buffer_sizes[i]);
+		char * buffer_data = static_cast<char *>(raw_buffer.data());
+		for (std::size_t offset = 0; offset < buffer_sizes[i]; offset += staging.size()) {
+			std::size_t piece_size = std::min(staging.size(), buffer_sizes[i] - offset);
+			if (chunk_in_use[slot]) {
+				cudaEventSynchronize(staging.event(slot));
+			}
+			file.read(staging.data(slot), piece_size);
+			cudaMemcpyAsync(buffer_data + offset, staging.data(slot), piece_size, cudaMemcpyHostToDevice, 0);
+			cudaEventRecord(staging.event(slot), 0);
+			chunk_in_use[slot] = true;
+			slot = 1 - slot;
+		}
+	}
+	cudaStreamSynchronize(0);
+
+	std::vector<std::string> names;
+	for (int column_index : column_indices) {
+		names.push_back(this->col_names[column_index]);
+	}
+	auto table = comm::deserialize_from_gpu_raw_buffers(selected_column_transports, raw_buffers);
+	table->setNames(names);
+	return table;
+}
+
 size_t CacheDataLocalFile::fileSizeInBytes() const {
+	if (this->extent.segment != nullptr) {
+		return this->spill_bytes;
+	}
 	struct stat st;
 
 	if(stat(this->filePath_.c_str(), &st) == 0)
@@ -77,14 +433,35 @@ size_t CacheDataLocalFile::sizeInBytes() const {
 }
 
 std::unique_ptr<ral::frame::BlazingTable> CacheDataLocalFile::decache() {
+	std::vector<int> column_indices(this->col_names.size());
+	std::iota(column_indices.begin(), column_indices.end(), 0);
+	return decache(column_indices);
+}
 
-	cudf::io::orc_reader_options read_opts = cudf::io::orc_reader_options::builder(cudf::io::source_info{this->filePath_});
-	auto result = cudf::io::read_orc(read_opts);
+std::unique_ptr<ral::frame::BlazingTable> CacheDataLocalFile::decache(const std::vector<int> & column_indices) {
+	BLAZING_NVTX_RANGE("read spill from disk", decache);
+	std::unique_ptr<ral::frame::BlazingTable> table;
+	if (spill_format == SpillFormat::RAW) {
+		table = read_raw_file(column_indices);
+	} else {
+		table = read_orc_file(column_indices);
+	}
+
+	// Remove temp files
+	remove_file();
+	if (!released) {
+		blazing_disk_memory_resource::getInstance().release_spill_directory(this->directory, this->size_in_bytes);
+		released = true;
+	}
+	return table;
+}
 
-	// Remove temp orc files
-	const char *orc_path_file = this->filePath_.c_str();
-	remove(orc_path_file);
-	return std::make_unique<ral::frame::BlazingTable>(std::move(result.tbl), this->col_names );
+CacheDataLocalFile::~CacheDataLocalFile() {
+	if (!released) {
+		// it was never decached, as when its query was cancelled
+		remove_file();
+		blazing_disk_memory_resource::getInstance().release_spill_directory(this->directory, this->size_in_bytes);
+	}
 }
 
 } // namespace cache
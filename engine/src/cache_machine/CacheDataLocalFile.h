@@ -1,12 +1,32 @@
 #include "CacheData.h"
+#include "SpillManager.h"
+#include <functional>
 
 namespace ral {
 namespace cache {
 
 /**
-* A CacheData that stores is data in an ORC file.
+* Picks the directory where a new spill file goes, out of the directories of the disk tier, and accounts its bytes there.
+* When the disk tier has no directories, the cache directory is used.
+* @param bytes the size of the table that is spilled.
+* @return the directory, or an empty string if no directory has room for the file.
+*/
+std::string reserve_spill_directory(size_t bytes);
+
+/**
+* A CacheData that stores is data in a file, either ORC or RAW (see SpillFormat).
 * This allows us to cache onto filesystems to allow larger queries to run on
 * limited resources. This is the least performant cache in most instances.
+*
+* The columns of an ORC file are named after their position, so that they can be read by themselves even if the
+* table has repeated names or is renamed with set_names.
+*
+* A RAW file has a header with the ColumnTransports and the sizes of the buffers of the table, followed by the buffers.
+* The buffers are copied between the GPU and the file through two pinned host chunks, so that the copy of one chunk
+* overlaps with the write (or read) of the other.
+*
+* When the spill_manager is enabled, the RAW file of a query is an extent of one of its segments instead of a file of
+* its own, which goes back to the spill_manager when the data is decached.
 */
 class CacheDataLocalFile : public CacheData {
 public:
@@ -17,8 +37,20 @@ public:
 	* on disk.
 	* @ param orc_files_path The path where the file should be stored.
 	* @ param ctx_id The context token to identify the query that generated the file.
+	* @ param spill_format The format of the file.
+	*/
+	CacheDataLocalFile(std::unique_ptr<ral::frame::BlazingTable> table, std::string orc_files_path, std::string ctx_token,
+		SpillFormat spill_format = SpillFormat::ORC);
+
+	/**
+	* Constructor
+	* Writes the buffers of a BlazingHostTable to a RAW file straight from host memory, so that data can leave the
+	* host tier without going through the GPU.
+	* @param host_table The BlazingHostTable that is stored on disk. Its chunks go back to their pools afterwards.
+	* @ param orc_files_path The path where the file should be stored.
+	* @ param ctx_id The context token to identify the query that generated the file.
 	*/
-	CacheDataLocalFile(std::unique_ptr<ral::frame::BlazingTable> table, std::string orc_files_path, std::string ctx_token);
+	CacheDataLocalFile(std::unique_ptr<ral::frame::BlazingHostTable> host_table, std::string orc_files_path, std::string ctx_token);
 
 	/**
 	* Constructor
@@ -28,6 +60,12 @@ public:
 	*/
 	std::unique_ptr<ral::frame::BlazingTable> decache() override;
 
+	/**
+	* Reads only some of the columns from the file and removes it.
+	* @param column_indices the indices of the columns wanted.
+	*/
+	std::unique_ptr<ral::frame::BlazingTable> decache(const std::vector<int> & column_indices) override;
+
 	/**
  	* Get the amount of GPU memory that the decached BlazingTable WOULD consume.
  	* Having this function allows us to have one api for seeing how much GPU
@@ -55,18 +93,40 @@ public:
 	/**
 	* Destructor
 	*/
-	virtual ~CacheDataLocalFile() {}
+	virtual ~CacheDataLocalFile();
 
 	/**
 	* Get the file path of the ORC file.
-	* @return The path to the ORC file.
+	* @return The path to the ORC file, or to the segment of its extent.
 	*/
 	std::string filePath() const { return filePath_; }
 
+	/**
+	* Get the format of the file.
+	*/
+	SpillFormat get_spill_format() const { return spill_format; }
+
 private:
+	void write_orc_file(const ral::frame::BlazingTable & table);
+	void write_raw_file(const ral::frame::BlazingTableView & table);
+	void write_raw_file(const ral::frame::BlazingHostTable & host_table);
+	void write_with_retries(const std::function<void()> & write, cudf::size_type num_rows);
+	// takes the extent of a RAW spill from the spill_manager, when it is enabled, before it is written
+	void reserve_space(std::size_t bytes);
+	// gives the file or the extent back
+	void remove_file();
+	std::unique_ptr<ral::frame::BlazingTable> read_orc_file(const std::vector<int> & column_indices);
+	std::unique_ptr<ral::frame::BlazingTable> read_raw_file(const std::vector<int> & column_indices);
+
 	std::vector<std::string> col_names; /**< The names of the columns, extracted from the ORC file. */
 	std::string filePath_; /**< The path to the ORC file. Is usually generated randomly. */
+	std::string directory; /**< The directory of the file, whose bytes are given back to the disk tier when the file is removed. */
+	std::string ctx_token; /**< The query of the spill, whose segments the extent is taken from. */
+	spill_extent extent; /**< The extent of a segment where a RAW spill is, when it is not in a file of its own. */
+	size_t spill_bytes = 0; /**< The bytes that were written. */
+	bool released = false; /**< Whether the bytes were given back. */
 	size_t size_in_bytes; /**< The size of the file being stored. */
+	SpillFormat spill_format; /**< The format of the file. */
 };
 
 } // namespace cache
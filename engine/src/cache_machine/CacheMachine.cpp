@@ -7,6 +7,7 @@
 #include <sys/stat.h>
 #include <random>
 #include <utilities/CommonOperations.h>
+#include "utilities/Tracer.h"
 #include <cudf/io/orc.hpp>
 #include "parser/CalciteExpressionParsing.h"
 #include "communication/CommunicationData.h"
@@ -15,6 +16,9 @@
 
 #include "Util/StringUtil.h"
 #include <src/utilities/DebuggingUtils.h>
+#include "utilities/nvtx.h"
+#include "utilities/RuntimeMetrics.h"
+#include "utilities/EventLog.h"
 
 namespace ral {
 namespace cache {
@@ -29,6 +33,10 @@ CacheMachine::CacheMachine(std::shared_ptr<Context> context, std::string cache_m
         global_index(-1)
 {
 	CacheMachine::cache_count++;
+	if (ctx) {
+		spill_format = ral::cache::get_spill_format(ctx->getConfig());
+		host_compression = ctx->getConfig().enable_host_cache_compression.value_or(false);
+	}
 
 	waitingCache = std::make_unique<WaitingQueue <std::unique_ptr <message> > >(cache_machine_name, 60000, log_timeout);
 	this->memory_resources.push_back( &blazing_device_memory_resource::getInstance() );
@@ -67,17 +75,17 @@ void CacheMachine::finish() {
 
 	cacheEventTimer.stop();
     if(cache_events_logger) {
-        cache_events_logger->info("{ral_id}|{query_id}|{message_id}|{cache_id}|{num_rows}|{num_bytes}|{event_type}|{timestamp_begin}|{timestamp_end}|{description}",
-                                  "ral_id"_a=(ctx ? ctx->getNodeIndex(ral::communication::CommunicationData::getInstance().getSelfNode()) : -1),
-                                  "query_id"_a=(ctx ? ctx->getContextToken() : -1),
-                                  "message_id"_a=cache_machine_name,
-                                  "cache_id"_a=cache_id,
-                                  "num_rows"_a=num_rows_added,
-                                  "num_bytes"_a=num_bytes_added,
-                                  "event_type"_a="Finish",
-                                  "timestamp_begin"_a=cacheEventTimer.start_time(),
-                                  "timestamp_end"_a=cacheEventTimer.end_time(),
-                                  "description"_a="CacheMachine finish()");
+        ral::utilities::log_event(cache_events_logger,
+                                  (ctx ? ctx->getNodeIndex(ral::communication::CommunicationData::getInstance().getSelfNode()) : -1),
+                                  (ctx ? ctx->getContextToken() : -1),
+                                  cache_machine_name,
+                                  cache_id,
+                                  num_rows_added,
+                                  num_bytes_added,
+                                  "Finish",
+                                  cacheEventTimer.start_time(),
+                                  cacheEventTimer.end_time(),
+                                  "CacheMachine finish()");
     }
 }
 
@@ -85,10 +93,24 @@ bool CacheMachine::is_finished() {
 	return this->waitingCache->is_finished();
 }
 
+void CacheMachine::clear() {
+	this->waitingCache->finish();
+	// the messages are dropped here, out of the lock of the queue
+	std::vector<std::unique_ptr<message>> messages = this->waitingCache->get_all();
+}
+
+void CacheMachine::notify_waiters() {
+	this->waitingCache->notify_waiters();
+}
+
 uint64_t CacheMachine::get_num_bytes_added(){
 	return num_bytes_added.load();
 }
 
+uint64_t CacheMachine::get_num_bytes_spilled(){
+	return num_bytes_spilled.load();
+}
+
 uint64_t CacheMachine::get_num_rows_added(){
 	return num_rows_added.load();
 }
@@ -118,17 +140,17 @@ bool CacheMachine::addHostFrameToCache(std::unique_ptr<ral::frame::BlazingHostTa
 
         cacheEventTimer.stop();
         if(cache_events_logger) {
-            cache_events_logger->info("{ral_id}|{query_id}|{message_id}|{cache_id}|{num_rows}|{num_bytes}|{event_type}|{timestamp_begin}|{timestamp_end}|{description}",
-                                      "ral_id"_a=(ctx ? ctx->getNodeIndex(ral::communication::CommunicationData::getInstance().getSelfNode()) : -1),
-                                      "query_id"_a=(ctx ? ctx->getContextToken() : -1),
-                                      "message_id"_a=cache_machine_name,
-                                      "cache_id"_a=cache_id,
-                                      "num_rows"_a=num_rows_added,
-                                      "num_bytes"_a=num_bytes_added,
-                                      "event_type"_a="AddHostFrameToCache",
-                                      "timestamp_begin"_a=cacheEventTimer.start_time(),
-                                      "timestamp_end"_a=cacheEventTimer.end_time(),
-                                      "description"_a="Add to CacheMachine");
+            ral::utilities::log_event(cache_events_logger,
+                                      (ctx ? ctx->getNodeIndex(ral::communication::CommunicationData::getInstance().getSelfNode()) : -1),
+                                      (ctx ? ctx->getContextToken() : -1),
+                                      cache_machine_name,
+                                      cache_id,
+                                      num_rows_added,
+                                      num_bytes_added,
+                                      "AddHostFrameToCache",
+                                      cacheEventTimer.start_time(),
+                                      cacheEventTimer.end_time(),
+                                      "Add to CacheMachine");
         }
 
 		return true;
@@ -154,17 +176,17 @@ void CacheMachine::clear() {
 
     cacheEventTimer.stop();
     if(cache_events_logger) {
-        cache_events_logger->info("{ral_id}|{query_id}|{message_id}|{cache_id}|{num_rows}|{num_bytes}|{event_type}|{timestamp_begin}|{timestamp_end}|{description}",
-                                  "ral_id"_a=(ctx ? ctx->getNodeIndex(ral::communication::CommunicationData::getInstance().getSelfNode()) : -1),
-                                  "query_id"_a=(ctx ? ctx->getContextToken() : -1),
-                                  "message_id"_a=cache_machine_name,
-                                  "cache_id"_a=cache_id,
-                                  "num_rows"_a=num_rows_added,
-                                  "num_bytes"_a=num_bytes_added,
-                                  "event_type"_a="Clear",
-                                  "timestamp_begin"_a=cacheEventTimer.start_time(),
-                                  "timestamp_end"_a=cacheEventTimer.end_time(),
-                                  "description"_a="Clear CacheMachine");
+        ral::utilities::log_event(cache_events_logger,
+                                  (ctx ? ctx->getNodeIndex(ral::communication::CommunicationData::getInstance().getSelfNode()) : -1),
+                                  (ctx ? ctx->getContextToken() : -1),
+                                  cache_machine_name,
+                                  cache_id,
+                                  num_rows_added,
+                                  num_bytes_added,
+                                  "Clear",
+                                  cacheEventTimer.start_time(),
+                                  cacheEventTimer.end_time(),
+                                  "Clear CacheMachine");
     }
 }
 
@@ -183,17 +205,17 @@ std::vector<std::unique_ptr<ral::cache::CacheData> > CacheMachine::pull_all_cach
 
     cacheEventTimer.stop();
     if(cache_events_logger) {
-        cache_events_logger->info("{ral_id}|{query_id}|{message_id}|{cache_id}|{num_rows}|{num_bytes}|{event_type}|{timestamp_begin}|{timestamp_end}|{description}",
-                                  "ral_id"_a=(ctx ? ctx->getNodeIndex(ral::communication::CommunicationData::getInstance().getSelfNode()) : -1),
-                                  "query_id"_a=(ctx ? ctx->getContextToken() : -1),
-                                  "message_id"_a=cache_machine_name,
-                                  "cache_id"_a=cache_id,
-                                  "num_rows"_a=num_rows_added,
-                                  "num_bytes"_a=num_bytes_added,
-                                  "event_type"_a="PullAllCacheData",
-                                  "timestamp_begin"_a=cacheEventTimer.start_time(),
-                                  "timestamp_end"_a=cacheEventTimer.end_time(),
-                                  "description"_a="Pull all cache data");
+        ral::utilities::log_event(cache_events_logger,
+                                  (ctx ? ctx->getNodeIndex(ral::communication::CommunicationData::getInstance().getSelfNode()) : -1),
+                                  (ctx ? ctx->getContextToken() : -1),
+                                  cache_machine_name,
+                                  cache_id,
+                                  num_rows_added,
+                                  num_bytes_added,
+                                  "PullAllCacheData",
+                                  cacheEventTimer.start_time(),
+                                  cacheEventTimer.end_time(),
+                                  "Pull all cache data");
     }
 
 	return new_messages;
@@ -214,6 +236,7 @@ std::vector<size_t> CacheMachine::get_all_indexes() {
 bool CacheMachine::addCacheData(std::unique_ptr<ral::cache::CacheData> cache_data, std::string message_id, bool always_add){
     CodeTimer cacheEventTimer;
     cacheEventTimer.start();
+    ral::utilities::trace_scope trace("AddCacheData", "cache", (ctx ? ctx->getContextToken() : -1), cache_id);
 
 	// we dont want to add empty tables to a cache, unless we have never added anything
 	if ((!this->something_added || cache_data->num_rows() > 0) || always_add){
@@ -239,17 +262,17 @@ bool CacheMachine::addCacheData(std::unique_ptr<ral::cache::CacheData> cache_dat
 
             cacheEventTimer.stop();
             if(cache_events_logger) {
-                cache_events_logger->info("{ral_id}|{query_id}|{message_id}|{cache_id}|{num_rows}|{num_bytes}|{event_type}|{timestamp_begin}|{timestamp_end}|{description}",
-                                          "ral_id"_a=(ctx ? ctx->getNodeIndex(ral::communication::CommunicationData::getInstance().getSelfNode()) : -1),
-                                          "query_id"_a=(ctx ? ctx->getContextToken() : -1),
-                                          "message_id"_a=message_id,
-                                          "cache_id"_a=cache_id,
-                                          "num_rows"_a=num_rows_added,
-                                          "num_bytes"_a=num_bytes_added,
-                                          "event_type"_a="AddCacheData",
-                                          "timestamp_begin"_a=cacheEventTimer.start_time(),
-                                          "timestamp_end"_a=cacheEventTimer.end_time(),
-                                          "description"_a="Add to CacheMachine general CacheData object into GPU cache");
+                ral::utilities::log_event(cache_events_logger,
+                                          (ctx ? ctx->getNodeIndex(ral::communication::CommunicationData::getInstance().getSelfNode()) : -1),
+                                          (ctx ? ctx->getContextToken() : -1),
+                                          message_id,
+                                          cache_id,
+                                          num_rows_added,
+                                          num_bytes_added,
+                                          "AddCacheData",
+                                          cacheEventTimer.start_time(),
+                                          cacheEventTimer.end_time(),
+                                          "Add to CacheMachine general CacheData object into GPU cache");
             }
 		} else if(cacheIndex == 1) {
 			auto item = std::make_unique<message>(std::move(cache_data), message_id);
@@ -257,17 +280,17 @@ bool CacheMachine::addCacheData(std::unique_ptr<ral::cache::CacheData> cache_dat
 
             cacheEventTimer.stop();
             if(cache_events_logger) {
-                cache_events_logger->info("{ral_id}|{query_id}|{message_id}|{cache_id}|{num_rows}|{num_bytes}|{event_type}|{timestamp_begin}|{timestamp_end}|{description}",
-                                          "ral_id"_a=(ctx ? ctx->getNodeIndex(ral::communication::CommunicationData::getInstance().getSelfNode()) : -1),
-                                          "query_id"_a=(ctx ? ctx->getContextToken() : -1),
-                                          "message_id"_a=message_id,
-                                          "cache_id"_a=cache_id,
-                                          "num_rows"_a=num_rows_added,
-                                          "num_bytes"_a=num_bytes_added,
-                                          "event_type"_a="AddCacheData",
-                                          "timestamp_begin"_a=cacheEventTimer.start_time(),
-                                          "timestamp_end"_a=cacheEventTimer.end_time(),
-                                          "description"_a="Add to CacheMachine general CacheData object into CPU cache");
+                ral::utilities::log_event(cache_events_logger,
+                                          (ctx ? ctx->getNodeIndex(ral::communication::CommunicationData::getInstance().getSelfNode()) : -1),
+                                          (ctx ? ctx->getContextToken() : -1),
+                                          message_id,
+                                          cache_id,
+                                          num_rows_added,
+                                          num_bytes_added,
+                                          "AddCacheData",
+                                          cacheEventTimer.start_time(),
+                                          cacheEventTimer.end_time(),
+                                          "Add to CacheMachine general CacheData object into CPU cache");
             }
 		} else if(cacheIndex == 2) {
 			// BlazingMutableThread t([cache_data = std::move(cache_data), this, cacheIndex, message_id]() mutable {
@@ -278,17 +301,17 @@ bool CacheMachine::addCacheData(std::unique_ptr<ral::cache::CacheData> cache_dat
 
             cacheEventTimer.stop();
             if(cache_events_logger) {
-                cache_events_logger->info("{ral_id}|{query_id}|{message_id}|{cache_id}|{num_rows}|{num_bytes}|{event_type}|{timestamp_begin}|{timestamp_end}|{description}",
-                                          "ral_id"_a=(ctx ? ctx->getNodeIndex(ral::communication::CommunicationData::getInstance().getSelfNode()) : -1),
-                                          "query_id"_a=(ctx ? ctx->getContextToken() : -1),
-                                          "message_id"_a=message_id,
-                                          "cache_id"_a=cache_id,
-                                          "num_rows"_a=num_rows_added,
-                                          "num_bytes"_a=num_bytes_added,
-                                          "event_type"_a="AddCacheData",
-                                          "timestamp_begin"_a=cacheEventTimer.start_time(),
-                                          "timestamp_end"_a=cacheEventTimer.end_time(),
-                                          "description"_a="Add to CacheMachine general CacheData object into Disk cache");
+                ral::utilities::log_event(cache_events_logger,
+                                          (ctx ? ctx->getNodeIndex(ral::communication::CommunicationData::getInstance().getSelfNode()) : -1),
+                                          (ctx ? ctx->getContextToken() : -1),
+                                          message_id,
+                                          cache_id,
+                                          num_rows_added,
+                                          num_bytes_added,
+                                          "AddCacheData",
+                                          cacheEventTimer.start_time(),
+                                          cacheEventTimer.end_time(),
+                                          "Add to CacheMachine general CacheData object into Disk cache");
             }
 		}
 		this->something_added = true;
@@ -302,6 +325,7 @@ bool CacheMachine::addCacheData(std::unique_ptr<ral::cache::CacheData> cache_dat
 bool CacheMachine::addToCache(std::unique_ptr<ral::frame::BlazingTable> table, std::string message_id, bool always_add,const MetadataDictionary & metadata , bool use_pinned) {
     CodeTimer cacheEventTimer;
     cacheEventTimer.start();
+    ral::utilities::trace_scope trace("AddToCache", "cache", (ctx ? ctx->getContextToken() : -1), cache_id);
 
     // we dont want to add empty tables to a cache, unless we have never added anything
 	if (!this->something_added || table->num_rows() > 0 || always_add){
@@ -323,8 +347,12 @@ bool CacheMachine::addToCache(std::unique_ptr<ral::frame::BlazingTable> table, s
 		while(cacheIndex < memory_resources.size()) {
 
 			auto memory_to_use = (this->memory_resources[cacheIndex]->get_memory_used() + table->sizeInBytes());
+			// the host tier can reuse the free chunks of its pools
+			std::size_t host_bytes = host_compression ? host_compression_stats::get_instance().expected_host_bytes(table->sizeInBytes()) : table->sizeInBytes();
+			bool fits = cacheIndex == 1 ? blazing_host_memory_resource::getInstance().can_hold(host_bytes) :
+				memory_to_use < this->memory_resources[cacheIndex]->get_memory_limit();
 
-			if( memory_to_use < this->memory_resources[cacheIndex]->get_memory_limit() || 
+			if( fits || 
 			 	cache_level_override != -1) {
 				
 				if(cache_level_override != -1){
@@ -340,48 +368,63 @@ bool CacheMachine::addToCache(std::unique_ptr<ral::frame::BlazingTable> table, s
 
                     cacheEventTimer.stop();
                     if(cache_events_logger) {
-                        cache_events_logger->info("{ral_id}|{query_id}|{message_id}|{cache_id}|{num_rows}|{num_bytes}|{event_type}|{timestamp_begin}|{timestamp_end}|{description}",
-                                                  "ral_id"_a=(ctx ? ctx->getNodeIndex(ral::communication::CommunicationData::getInstance().getSelfNode()) : -1),
-                                                  "query_id"_a=(ctx ? ctx->getContextToken() : -1),
-                                                  "message_id"_a=message_id,
-                                                  "cache_id"_a=cache_id,
-                                                  "num_rows"_a=num_rows_added,
-                                                  "num_bytes"_a=num_bytes_added,
-                                                  "event_type"_a="AddToCache",
-                                                  "timestamp_begin"_a=cacheEventTimer.start_time(),
-                                                  "timestamp_end"_a=cacheEventTimer.end_time(),
-                                                  "description"_a="Add to CacheMachine into GPU cache");
+                        ral::utilities::log_event(cache_events_logger,
+                                                  (ctx ? ctx->getNodeIndex(ral::communication::CommunicationData::getInstance().getSelfNode()) : -1),
+                                                  (ctx ? ctx->getContextToken() : -1),
+                                                  message_id,
+                                                  cache_id,
+                                                  num_rows_added,
+                                                  num_bytes_added,
+                                                  "AddToCache",
+                                                  cacheEventTimer.start_time(),
+                                                  cacheEventTimer.end_time(),
+                                                  "Add to CacheMachine into GPU cache");
                     }
 
 				} else {
 					if(cacheIndex == 1) {
+						BLAZING_NVTX_RANGE("spill to host", spill);
+						num_bytes_spilled += table->sizeInBytes();
+						ral::utilities::runtime_metrics::get_instance().record_spill(ral::utilities::spill_tier::host, table->sizeInBytes());
 						std::unique_ptr<CacheData> cache_data;
-						cache_data = std::make_unique<CPUCacheData>(std::move(table), metadata, use_pinned);
+						auto cpu_cache_data = std::make_unique<CPUCacheData>(std::move(table), metadata, use_pinned);
+						if (host_compression) {
+							cpu_cache_data->compress();
+						}
+						cache_data = std::move(cpu_cache_data);
 							
 						auto item =	std::make_unique<message>(std::move(cache_data), message_id);
 						this->waitingCache->put(std::move(item));
 
                         cacheEventTimer.stop();
                         if(cache_events_logger) {
-                            cache_events_logger->info("{ral_id}|{query_id}|{message_id}|{cache_id}|{num_rows}|{num_bytes}|{event_type}|{timestamp_begin}|{timestamp_end}|{description}",
-                                                      "ral_id"_a=(ctx ? ctx->getNodeIndex(ral::communication::CommunicationData::getInstance().getSelfNode()) : -1),
-                                                      "query_id"_a=(ctx ? ctx->getContextToken() : -1),
-                                                      "message_id"_a=message_id,
-                                                      "cache_id"_a=cache_id,
-                                                      "num_rows"_a=num_rows_added,
-                                                      "num_bytes"_a=num_bytes_added,
-                                                      "event_type"_a="AddToCache",
-                                                      "timestamp_begin"_a=cacheEventTimer.start_time(),
-                                                      "timestamp_end"_a=cacheEventTimer.end_time(),
-                                                      "description"_a="Add to CacheMachine into CPU cache");
+                            ral::utilities::log_event(cache_events_logger,
+                                                      (ctx ? ctx->getNodeIndex(ral::communication::CommunicationData::getInstance().getSelfNode()) : -1),
+                                                      (ctx ? ctx->getContextToken() : -1),
+                                                      message_id,
+                                                      cache_id,
+                                                      num_rows_added,
+                                                      num_bytes_added,
+                                                      "AddToCache",
+                                                      cacheEventTimer.start_time(),
+                                                      cacheEventTimer.end_time(),
+                                                      "Add to CacheMachine into CPU cache");
                         }
 
 					} else if(cacheIndex == 2) {
 						// BlazingMutableThread t([table = std::move(table), this, cacheIndex, message_id]() mutable {
-						// want to get only cache directory where orc files should be saved
-						std::string orc_files_path = ral::communication::CommunicationData::getInstance().get_cache_directory();
-						// WSM TODO add metadata to CacheDataLocalFile
-						auto cache_data = std::make_unique<CacheDataLocalFile>(std::move(table), orc_files_path, (ctx ? std::to_string(ctx->getContextToken()) : "none"));
+						std::string orc_files_path = reserve_spill_directory(table->sizeInBytes());
+						std::unique_ptr<CacheData> cache_data;
+						if (orc_files_path.empty()) {
+							// there is no room left in the disk tier, so the data stays in GPU
+							table->ensureOwnership();
+							cache_data = std::make_unique<GPUCacheData>(std::move(table), metadata);
+						} else {
+							num_bytes_spilled += table->sizeInBytes();
+							ral::utilities::runtime_metrics::get_instance().record_spill(ral::utilities::spill_tier::disk, table->sizeInBytes());
+							// WSM TODO add metadata to CacheDataLocalFile
+							cache_data = std::make_unique<CacheDataLocalFile>(std::move(table), orc_files_path, (ctx ? std::to_string(ctx->getContextToken()) : "none"), spill_format);
+						}
 						auto item =	std::make_unique<message>(std::move(cache_data), message_id);
 						this->waitingCache->put(std::move(item));
 						// NOTE: Wait don't kill the main process until the last thread is finished!
@@ -389,17 +432,17 @@ bool CacheMachine::addToCache(std::unique_ptr<ral::frame::BlazingTable> table, s
 
                         cacheEventTimer.stop();
                         if(cache_events_logger) {
-                            cache_events_logger->info("{ral_id}|{query_id}|{message_id}|{cache_id}|{num_rows}|{num_bytes}|{event_type}|{timestamp_begin}|{timestamp_end}|{description}",
-                                                      "ral_id"_a=(ctx ? ctx->getNodeIndex(ral::communication::CommunicationData::getInstance().getSelfNode()) : -1),
-                                                      "query_id"_a=(ctx ? ctx->getContextToken() : -1),
-                                                      "message_id"_a=message_id,
-                                                      "cache_id"_a=cache_id,
-                                                      "num_rows"_a=num_rows_added,
-                                                      "num_bytes"_a=num_bytes_added,
-                                                      "event_type"_a="AddToCache",
-                                                      "timestamp_begin"_a=cacheEventTimer.start_time(),
-                                                      "timestamp_end"_a=cacheEventTimer.end_time(),
-                                                      "description"_a="Add to CacheMachine into Disk cache");
+                            ral::utilities::log_event(cache_events_logger,
+                                                      (ctx ? ctx->getNodeIndex(ral::communication::CommunicationData::getInstance().getSelfNode()) : -1),
+                                                      (ctx ? ctx->getContextToken() : -1),
+                                                      message_id,
+                                                      cache_id,
+                                                      num_rows_added,
+                                                      num_bytes_added,
+                                                      "AddToCache",
+                                                      cacheEventTimer.start_time(),
+                                                      cacheEventTimer.end_time(),
+                                                      "Add to CacheMachine into Disk cache");
                         }
 					}
 				}
@@ -435,17 +478,17 @@ std::unique_ptr<ral::frame::BlazingTable> CacheMachine::get_or_wait(size_t index
 
     cacheEventTimer.stop();
     if(cache_events_logger) {
-        cache_events_logger->info("{ral_id}|{query_id}|{message_id}|{cache_id}|{num_rows}|{num_bytes}|{event_type}|{timestamp_begin}|{timestamp_end}|{description}",
-                                  "ral_id"_a=(ctx ? ctx->getNodeIndex(ral::communication::CommunicationData::getInstance().getSelfNode()) : -1),
-                                  "query_id"_a=(ctx ? ctx->getContextToken() : -1),
-                                  "message_id"_a=message_id,
-                                  "cache_id"_a=cache_id,
-                                  "num_rows"_a=num_rows,
-                                  "num_bytes"_a=num_bytes,
-                                  "event_type"_a="GetOrWait",
-                                  "timestamp_begin"_a=cacheEventTimer.start_time(),
-                                  "timestamp_end"_a=cacheEventTimer.end_time(),
-                                  "description"_a="CacheMachine::get_or_wait pulling from cache ");
+        ral::utilities::log_event(cache_events_logger,
+                                  (ctx ? ctx->getNodeIndex(ral::communication::CommunicationData::getInstance().getSelfNode()) : -1),
+                                  (ctx ? ctx->getContextToken() : -1),
+                                  message_id,
+                                  cache_id,
+                                  num_rows,
+                                  num_bytes,
+                                  "GetOrWait",
+                                  cacheEventTimer.start_time(),
+                                  cacheEventTimer.end_time(),
+                                  "CacheMachine::get_or_wait pulling from cache ");
     }
 
 	return output;
@@ -466,17 +509,17 @@ std::unique_ptr<ral::cache::CacheData>  CacheMachine::get_or_wait_CacheData(size
 
     cacheEventTimer.stop();
     if(cache_events_logger) {
-        cache_events_logger->info("{ral_id}|{query_id}|{message_id}|{cache_id}|{num_rows}|{num_bytes}|{event_type}|{timestamp_begin}|{timestamp_end}|{description}",
-                                  "ral_id"_a=(ctx ? ctx->getNodeIndex(ral::communication::CommunicationData::getInstance().getSelfNode()) : -1),
-                                  "query_id"_a=(ctx ? ctx->getContextToken() : -1),
-                                  "message_id"_a=message_id,
-                                  "cache_id"_a=cache_id,
-                                  "num_rows"_a=num_rows,
-                                  "num_bytes"_a=num_bytes,
-                                  "event_type"_a="GetOrWaitCacheData",
-                                  "timestamp_begin"_a=cacheEventTimer.start_time(),
-                                  "timestamp_end"_a=cacheEventTimer.end_time(),
-                                  "description"_a="CacheMachine::get_or_wait pulling CacheData from cache");
+        ral::utilities::log_event(cache_events_logger,
+                                  (ctx ? ctx->getNodeIndex(ral::communication::CommunicationData::getInstance().getSelfNode()) : -1),
+                                  (ctx ? ctx->getContextToken() : -1),
+                                  message_id,
+                                  cache_id,
+                                  num_rows,
+                                  num_bytes,
+                                  "GetOrWaitCacheData",
+                                  cacheEventTimer.start_time(),
+                                  cacheEventTimer.end_time(),
+                                  "CacheMachine::get_or_wait pulling CacheData from cache");
     }
 
 	return output;
@@ -485,6 +528,7 @@ std::unique_ptr<ral::cache::CacheData>  CacheMachine::get_or_wait_CacheData(size
 std::unique_ptr<ral::frame::BlazingTable> CacheMachine::pullFromCache() {
     CodeTimer cacheEventTimer;
     cacheEventTimer.start();
+    ral::utilities::trace_scope trace("PullFromCache", "cache", (ctx ? ctx->getContextToken() : -1), cache_id);
 
     std::string message_id;
 
@@ -508,28 +552,29 @@ std::unique_ptr<ral::frame::BlazingTable> CacheMachine::pullFromCache() {
 
     cacheEventTimer.stop();
     if(cache_events_logger) {
-        cache_events_logger->info("{ral_id}|{query_id}|{message_id}|{cache_id}|{num_rows}|{num_bytes}|{event_type}|{timestamp_begin}|{timestamp_end}|{description}",
-                                  "ral_id"_a=(ctx ? ctx->getNodeIndex(ral::communication::CommunicationData::getInstance().getSelfNode()) : -1),
-                                  "query_id"_a=(ctx ? ctx->getContextToken() : -1),
-                                  "message_id"_a=message_id,
-                                  "cache_id"_a=cache_id,
-                                  "num_rows"_a=num_rows,
-                                  "num_bytes"_a=num_bytes,
-                                  "event_type"_a="PullFromCache",
-                                  "timestamp_begin"_a=cacheEventTimer.start_time(),
-                                  "timestamp_end"_a=cacheEventTimer.end_time(),
-                                  "description"_a="Pull from CacheMachine type {}"_format(dataType));
+        ral::utilities::log_event(cache_events_logger,
+                                  (ctx ? ctx->getNodeIndex(ral::communication::CommunicationData::getInstance().getSelfNode()) : -1),
+                                  (ctx ? ctx->getContextToken() : -1),
+                                  message_id,
+                                  cache_id,
+                                  num_rows,
+                                  num_bytes,
+                                  "PullFromCache",
+                                  cacheEventTimer.start_time(),
+                                  cacheEventTimer.end_time(),
+                                  "Pull from CacheMachine type {}"_format(dataType));
     }
 
 	return output;
 }
 
 
-std::unique_ptr<ral::cache::CacheData> CacheMachine::pullCacheData(std::string message_id) {
+std::unique_ptr<ral::cache::CacheData> CacheMachine::pullCacheData(std::string message_id, std::function<bool()> stop) {
     CodeTimer cacheEventTimer;
     cacheEventTimer.start();
+    ral::utilities::trace_scope trace("PullCacheData", "cache", (ctx ? ctx->getContextToken() : -1), cache_id);
 
-	std::unique_ptr<message> message_data = waitingCache->get_or_wait(message_id);
+	std::unique_ptr<message> message_data = waitingCache->get_or_wait(message_id, stop);
 	if (message_data == nullptr) {
 		return nullptr;
 	}
@@ -540,17 +585,17 @@ std::unique_ptr<ral::cache::CacheData> CacheMachine::pullCacheData(std::string m
 
     cacheEventTimer.stop();
     if(cache_events_logger) {
-        cache_events_logger->info("{ral_id}|{query_id}|{message_id}|{cache_id}|{num_rows}|{num_bytes}|{event_type}|{timestamp_begin}|{timestamp_end}|{description}",
-                                  "ral_id"_a=(ctx ? ctx->getNodeIndex(ral::communication::CommunicationData::getInstance().getSelfNode()) : -1),
-                                  "query_id"_a=(ctx ? ctx->getContextToken() : -1),
-                                  "message_id"_a=message_id,
-                                  "cache_id"_a=cache_id,
-                                  "num_rows"_a=num_rows,
-                                  "num_bytes"_a=num_bytes,
-                                  "event_type"_a="PullCacheData",
-                                  "timestamp_begin"_a=cacheEventTimer.start_time(),
-                                  "timestamp_end"_a=cacheEventTimer.end_time(),
-                                  "description"_a="Pull from CacheMachine CacheData object type {}"_format(dataType));
+        ral::utilities::log_event(cache_events_logger,
+                                  (ctx ? ctx->getNodeIndex(ral::communication::CommunicationData::getInstance().getSelfNode()) : -1),
+                                  (ctx ? ctx->getContextToken() : -1),
+                                  message_id,
+                                  cache_id,
+                                  num_rows,
+                                  num_bytes,
+                                  "PullCacheData",
+                                  cacheEventTimer.start_time(),
+                                  cacheEventTimer.end_time(),
+                                  "Pull from CacheMachine CacheData object type {}"_format(dataType));
     }
 	return output;
 }
@@ -586,17 +631,17 @@ std::unique_ptr<ral::frame::BlazingTable> CacheMachine::pullUnorderedFromCache()
 
         cacheEventTimer.stop();
         if(cache_events_logger) {
-            cache_events_logger->info("{ral_id}|{query_id}|{message_id}|{cache_id}|{num_rows}|{num_bytes}|{event_type}|{timestamp_begin}|{timestamp_end}|{description}",
-                                      "ral_id"_a=(ctx ? ctx->getNodeIndex(ral::communication::CommunicationData::getInstance().getSelfNode()) : -1),
-                                      "query_id"_a=(ctx ? ctx->getContextToken() : -1),
-                                      "message_id"_a=message_id,
-                                      "cache_id"_a=cache_id,
-                                      "num_rows"_a=num_rows,
-                                      "num_bytes"_a=num_bytes,
-                                      "event_type"_a="PullUnorderedFromCache",
-                                      "timestamp_begin"_a=cacheEventTimer.start_time(),
-                                      "timestamp_end"_a=cacheEventTimer.end_time(),
-                                      "description"_a="Pull Unordered from CacheMachine type {}"_format(dataType));
+            ral::utilities::log_event(cache_events_logger,
+                                      (ctx ? ctx->getNodeIndex(ral::communication::CommunicationData::getInstance().getSelfNode()) : -1),
+                                      (ctx ? ctx->getContextToken() : -1),
+                                      message_id,
+                                      cache_id,
+                                      num_rows,
+                                      num_bytes,
+                                      "PullUnorderedFromCache",
+                                      cacheEventTimer.start_time(),
+                                      cacheEventTimer.end_time(),
+                                      "Pull Unordered from CacheMachine type {}"_format(dataType));
         }
 
 		return output;
@@ -630,17 +675,17 @@ std::unique_ptr<ral::cache::CacheData> CacheMachine::pullCacheData() {
 
     cacheEventTimer.stop();
     if(cache_events_logger) {
-        cache_events_logger->info("{ral_id}|{query_id}|{message_id}|{cache_id}|{num_rows}|{num_bytes}|{event_type}|{timestamp_begin}|{timestamp_end}|{description}",
-                                  "ral_id"_a=(ctx ? ctx->getNodeIndex(ral::communication::CommunicationData::getInstance().getSelfNode()) : -1),
-                                  "query_id"_a=(ctx ? ctx->getContextToken() : -1),
-                                  "message_id"_a=message_id,
-                                  "cache_id"_a=cache_id,
-                                  "num_rows"_a=num_rows,
-                                  "num_bytes"_a=num_bytes,
-                                  "event_type"_a="PullCacheData",
-                                  "timestamp_begin"_a=cacheEventTimer.start_time(),
-                                  "timestamp_end"_a=cacheEventTimer.end_time(),
-                                  "description"_a="Pull from CacheMachine CacheData object type {}"_format(dataType));
+        ral::utilities::log_event(cache_events_logger,
+                                  (ctx ? ctx->getNodeIndex(ral::communication::CommunicationData::getInstance().getSelfNode()) : -1),
+                                  (ctx ? ctx->getContextToken() : -1),
+                                  message_id,
+                                  cache_id,
+                                  num_rows,
+                                  num_bytes,
+                                  "PullCacheData",
+                                  cacheEventTimer.start_time(),
+                                  cacheEventTimer.end_time(),
+                                  "Pull from CacheMachine CacheData object type {}"_format(dataType));
     }
 
 	return output;
@@ -654,12 +699,13 @@ size_t CacheMachine::downgradeCacheData() {
 	std::unique_lock<std::mutex> lock = this->waitingCache->lock();
 	std::vector<std::unique_ptr<message>> all_messages = this->waitingCache->get_all_unsafe();
 	for(int i = all_messages.size() - 1; i >= 0; i--) {
-		if (all_messages[i]->get_data().get_type() == CacheDataType::GPU){
+		if (all_messages[i]->get_data().get_type() == CacheDataType::GPU &&
+				!static_cast<GPUCacheData &>(all_messages[i]->get_data()).is_host_advised()){
 
 			std::string message_id = all_messages[i]->get_message_id();
 			auto current_cache_data = all_messages[i]->release_data();
 			bytes_downgraded += current_cache_data->sizeInBytes();
-			auto new_cache_data = CacheData::downgradeCacheData(std::move(current_cache_data), message_id, ctx);
+			auto new_cache_data = CacheData::downgradeCacheData(std::move(current_cache_data), message_id, ctx, spill_format);
 
 			auto new_message =	std::make_unique<message>(std::move(new_cache_data), message_id);
 			all_messages[i] = std::move(new_message);
@@ -670,22 +716,75 @@ size_t CacheMachine::downgradeCacheData() {
 	return bytes_downgraded;
 }
 
-bool CacheMachine::has_messages_now(std::vector<std::string> messages){
-
-	std::vector<std::string> current_messages = this->waitingCache->get_all_message_ids();
-	for (auto & message : messages){
-		bool found = false;
-		for (auto & cur_message : current_messages){
-			if (message == cur_message)	{
-				found = true;
-				break;
+size_t CacheMachine::downgradeHostCacheData() {
+	size_t bytes_downgraded = 0;
+	std::unique_lock<std::mutex> lock = this->waitingCache->lock();
+	std::vector<std::unique_ptr<message>> all_messages = this->waitingCache->get_all_unsafe();
+	for(int i = all_messages.size() - 1; i >= 0 && blazing_host_memory_resource::getInstance().is_over_limit(); i--) {
+		if (all_messages[i]->get_data().get_type() != CacheDataType::CPU){
+			continue;
+		}
+		// compressing it in place is cheaper than the disk, the ones that are already compressed go to disk
+		auto & cpu_cache_data = static_cast<CPUCacheData &>(all_messages[i]->get_data());
+		if (host_compression && !cpu_cache_data.is_compressed()) {
+			bytes_downgraded += cpu_cache_data.compress();
+			if (cpu_cache_data.is_compressed()) {
+				continue;
 			}
 		}
-		if (!found){
-			return false;
+		size_t bytes = all_messages[i]->get_data().sizeInBytes();
+		std::string orc_files_path = reserve_spill_directory(bytes);
+		if (orc_files_path.empty()) {
+			break; // there is no room left in the disk tier
 		}
+
+		std::string message_id = all_messages[i]->get_message_id();
+		auto current_cache_data = all_messages[i]->release_data();
+		MetadataDictionary metadata = current_cache_data->getMetadata();
+		auto host_table = static_cast<CPUCacheData *>(current_cache_data.get())->releaseHostTable();
+		auto new_cache_data = std::make_unique<CacheDataLocalFile>(std::move(host_table), orc_files_path,
+			(ctx ? std::to_string(ctx->getContextToken()) : "none"));
+		new_cache_data->setMetadata(metadata);
+		bytes_downgraded += bytes;
+		num_bytes_spilled += bytes;
+		ral::utilities::runtime_metrics::get_instance().record_spill(ral::utilities::spill_tier::disk, bytes);
+
+		all_messages[i] = std::make_unique<message>(std::move(new_cache_data), message_id);
 	}
-	return true;
+
+	this->waitingCache->put_all_unsafe(std::move(all_messages));
+	return bytes_downgraded;
+}
+
+size_t CacheMachine::get_cpu_bytes() {
+	size_t cpu_bytes = 0;
+	std::unique_lock<std::mutex> lock = this->waitingCache->lock();
+	std::vector<std::unique_ptr<message>> all_messages = this->waitingCache->get_all_unsafe();
+	for(auto & message : all_messages) {
+		if (message->get_data().get_type() == CacheDataType::CPU){
+			cpu_bytes += message->get_data().sizeInBytes();
+		}
+	}
+	this->waitingCache->put_all_unsafe(std::move(all_messages));
+	return cpu_bytes;
+}
+
+size_t CacheMachine::get_gpu_bytes() {
+	size_t gpu_bytes = 0;
+	std::unique_lock<std::mutex> lock = this->waitingCache->lock();
+	std::vector<std::unique_ptr<message>> all_messages = this->waitingCache->get_all_unsafe();
+	for(auto & message : all_messages) {
+		if (message->get_data().get_type() == CacheDataType::GPU &&
+				!static_cast<GPUCacheData &>(message->get_data()).is_host_advised()){
+			gpu_bytes += message->get_data().sizeInBytes();
+		}
+	}
+	this->waitingCache->put_all_unsafe(std::move(all_messages));
+	return gpu_bytes;
+}
+
+bool CacheMachine::has_messages_now(std::vector<std::string> messages){
+	return this->waitingCache->has_messages_now(messages);
 }
 
 std::unique_ptr<ral::cache::CacheData> CacheMachine::pullAnyCacheData(const std::vector<std::string> & messages) {
@@ -707,17 +806,17 @@ std::unique_ptr<ral::cache::CacheData> CacheMachine::pullAnyCacheData(const std:
 
     cacheEventTimer.stop();
     if(cache_events_logger) {
-        cache_events_logger->info("{ral_id}|{query_id}|{message_id}|{cache_id}|{num_rows}|{num_bytes}|{event_type}|{timestamp_begin}|{timestamp_end}|{description}",
-                                  "ral_id"_a=(ctx ? ctx->getNodeIndex(ral::communication::CommunicationData::getInstance().getSelfNode()) : -1),
-                                  "query_id"_a=(ctx ? ctx->getContextToken() : -1),
-                                  "message_id"_a=message_id,
-                                  "cache_id"_a=cache_id,
-                                  "num_rows"_a=num_rows,
-                                  "num_bytes"_a=num_bytes,
-                                  "event_type"_a="pullAnyCacheData",
-                                  "timestamp_begin"_a=cacheEventTimer.start_time(),
-                                  "timestamp_end"_a=cacheEventTimer.end_time(),
-                                  "description"_a="Pull from CacheMachine CacheData object type {}"_format(dataType));
+        ral::utilities::log_event(cache_events_logger,
+                                  (ctx ? ctx->getNodeIndex(ral::communication::CommunicationData::getInstance().getSelfNode()) : -1),
+                                  (ctx ? ctx->getContextToken() : -1),
+                                  message_id,
+                                  cache_id,
+                                  num_rows,
+                                  num_bytes,
+                                  "pullAnyCacheData",
+                                  cacheEventTimer.start_time(),
+                                  cacheEventTimer.end_time(),
+                                  "Pull from CacheMachine CacheData object type {}"_format(dataType));
     }
 
 	return output;
@@ -725,15 +824,7 @@ std::unique_ptr<ral::cache::CacheData> CacheMachine::pullAnyCacheData(const std:
 
 bool CacheMachine::has_data_in_index_now(size_t index){
     std::string message = this->cache_machine_name + "_" + std::to_string(index);
-    std::vector<std::string> current_messages = this->waitingCache->get_all_message_ids();
-    bool found = false;
-    for (auto & cur_message : current_messages){
-        if (message == cur_message)	{
-            found = true;
-            break;
-        }
-    }
-    return found;
+    return this->waitingCache->has_messages_now({message});
 }
 
 
@@ -741,20 +832,72 @@ ConcatenatingCacheMachine::ConcatenatingCacheMachine(std::shared_ptr<Context> co
 	: CacheMachine(context, cache_machine_name) {}
 
 ConcatenatingCacheMachine::ConcatenatingCacheMachine(std::shared_ptr<Context> context,
-			std::size_t concat_cache_num_bytes, int num_bytes_timeout, bool concat_all, std::string cache_machine_name)
-	: CacheMachine(context, cache_machine_name), concat_cache_num_bytes(concat_cache_num_bytes), num_bytes_timeout(num_bytes_timeout), concat_all(concat_all) {
+			std::size_t concat_cache_num_bytes, int num_bytes_timeout, bool concat_all, std::string cache_machine_name,
+			std::shared_ptr<kernel_throughput> consumer_throughput)
+	: CacheMachine(context, cache_machine_name), concat_cache_num_bytes(concat_cache_num_bytes), num_bytes_timeout(num_bytes_timeout), concat_all(concat_all),
+	consumer_throughput(consumer_throughput) {
+
+	}
+
+DirectCacheMachine::DirectCacheMachine(std::shared_ptr<Context> context, std::string cache_machine_name, bool log_timeout)
+	: CacheMachine(context, cache_machine_name, log_timeout) {}
+
+bool DirectCacheMachine::addToCache(std::unique_ptr<ral::frame::BlazingTable> table, std::string message_id, bool always_add, const MetadataDictionary & metadata, bool use_pinned) {
+	// we dont want to add empty tables to a cache, unless we have never added anything
+	if (!this->something_added || table->num_rows() > 0 || always_add){
+		// before we put into a cache, we need to make sure we fully own the table
+		table->ensureOwnership();
+		std::size_t table_bytes = table->sizeInBytes();
+		if (this->memory_resources[0]->get_memory_used() + table_bytes >= this->memory_resources[0]->get_memory_limit()) {
+			return CacheMachine::addToCache(std::move(table), message_id, always_add, metadata, use_pinned);
+		}
+
+		if (message_id == ""){
+			message_id = this->cache_machine_name;
+		}
+
+		num_rows_added += table->num_rows();
+		num_bytes_added += table_bytes;
+
+		auto cache_data = std::make_unique<GPUCacheData>(std::move(table), metadata, table_bytes);
+		this->waitingCache->put(std::make_unique<message>(std::move(cache_data), message_id));
+		this->something_added = true;
+		return true;
+	}
+
+	return false;
+}
 
+std::unique_ptr<ral::frame::BlazingTable> DirectCacheMachine::pullFromCache() {
+	std::unique_ptr<message> message_data = waitingCache->pop_or_wait();
+	if (message_data == nullptr) {
+		return nullptr;
 	}
+	return message_data->get_data().decache();
+}
+
+std::size_t ConcatenatingCacheMachine::get_concat_target_bytes() {
+	if (consumer_throughput == nullptr) {
+		return this->concat_cache_num_bytes;
+	}
+	auto target = consumer_throughput->get_target_batch_bytes();
+	if (target.first && target.second < this->concat_cache_num_bytes) {
+		return target.second;
+	}
+	return this->concat_cache_num_bytes;
+}
 
 // This method does not guarantee the relative order of the messages to be preserved
 std::unique_ptr<ral::frame::BlazingTable> ConcatenatingCacheMachine::pullFromCache() {
     CodeTimer cacheEventTimerGeneral;
     cacheEventTimerGeneral.start();
+    ral::utilities::trace_scope trace("ConcatenatingPullFromCache", "cache", (ctx ? ctx->getContextToken() : -1), cache_id);
 
+	std::size_t concat_target_bytes = get_concat_target_bytes();
 	if (concat_all){
 		waitingCache->wait_until_finished();
 	} else {
-		waitingCache->wait_until_num_bytes(this->concat_cache_num_bytes, this->num_bytes_timeout);
+		waitingCache->wait_until_num_bytes(concat_target_bytes, this->num_bytes_timeout);
 	}
 
 	size_t total_bytes = 0;
@@ -776,7 +919,7 @@ std::unique_ptr<ral::frame::BlazingTable> ConcatenatingCacheMachine::pullFromCac
 		message_id = message_data->get_message_id();
 		collected_messages.push_back(std::move(message_data));
 
-	} while (concat_all || (total_bytes + waitingCache->get_next_size_in_bytes() <= this->concat_cache_num_bytes));
+	} while (concat_all || (total_bytes + waitingCache->get_next_size_in_bytes() <= concat_target_bytes));
 
 	std::unique_ptr<ral::frame::BlazingTable> output;
 	size_t num_rows = 0;
@@ -789,38 +932,36 @@ std::unique_ptr<ral::frame::BlazingTable> ConcatenatingCacheMachine::pullFromCac
 	}	else {
 		std::vector<std::unique_ptr<ral::frame::BlazingTable>> tables;
 		for (size_t i = 0; i < collected_messages.size(); i++){
-            CodeTimer cacheEventTimer;
-		    cacheEventTimer.start();
-
 			auto data = collected_messages[i]->release_data();
 			tables.push_back(data->decache());
+		}
 
-			// if we dont have to concatenate all, lets make sure we are not overflowing, and if we are, lets put one back
-			if (!concat_all && ral::utilities::checkIfConcatenatingStringsWillOverflow(tables)){
-				auto cache_data = std::make_unique<GPUCacheData>(std::move(tables.back()));
-				tables.pop_back();
-				collected_messages[i] =	std::make_unique<message>(std::move(cache_data), collected_messages[i]->get_message_id());
-				for (; i < collected_messages.size(); i++){
-					this->waitingCache->put(std::move(collected_messages[i]));
-				}
-
-                cacheEventTimer.stop();
-                if(cache_events_logger) {
-                    cache_events_logger->warn("{ral_id}|{query_id}|{message_id}|{cache_id}|{num_rows}|{num_bytes}|{event_type}|{timestamp_begin}|{timestamp_end}|{description}",
-                                              "ral_id"_a=(ctx ? ctx->getNodeIndex(ral::communication::CommunicationData::getInstance().getSelfNode()) : -1),
-                                              "query_id"_a=(ctx ? ctx->getContextToken() : -1),
-                                              "message_id"_a=message_id,
-                                              "cache_id"_a=cache_id,
-                                              "num_rows"_a=num_rows,
-                                              "num_bytes"_a=total_bytes,
-                                              "event_type"_a="PullFromCache",
-                                              "timestamp_begin"_a=cacheEventTimer.start_time(),
-                                              "timestamp_end"_a=cacheEventTimer.end_time(),
-                                              "description"_a="In ConcatenatingCacheMachine::pullFromCache Concatenating could have caused overflow strings length. Adding cache data back");
-                }
+		// if we dont have to concatenate all, the tables that would overflow the strings length go back as batches of their own
+		if (!concat_all && ral::utilities::checkIfConcatenatingStringsWillOverflow(tables)){
+            CodeTimer cacheEventTimer;
+		    cacheEventTimer.start();
 
-				break;
+			std::vector<std::unique_ptr<ral::frame::BlazingTable>> batches = ral::utilities::concatTablesInBatches(tables);
+			for (size_t i = 1; i < batches.size(); i++){
+				auto cache_data = std::make_unique<GPUCacheData>(std::move(batches[i]));
+				this->waitingCache->put(std::make_unique<message>(std::move(cache_data), message_id));
 			}
+			output = std::move(batches[0]);
+
+            cacheEventTimer.stop();
+            if(cache_events_logger) {
+                cache_events_logger->warn("{ral_id}|{query_id}|{message_id}|{cache_id}|{num_rows}|{num_bytes}|{event_type}|{timestamp_begin}|{timestamp_end}|{description}",
+                                          "ral_id"_a=(ctx ? ctx->getNodeIndex(ral::communication::CommunicationData::getInstance().getSelfNode()) : -1),
+                                          "query_id"_a=(ctx ? ctx->getContextToken() : -1),
+                                          "message_id"_a=message_id,
+                                          "cache_id"_a=cache_id,
+                                          "num_rows"_a=num_rows,
+                                          "num_bytes"_a=total_bytes,
+                                          "event_type"_a="PullFromCache",
+                                          "timestamp_begin"_a=cacheEventTimer.start_time(),
+                                          "timestamp_end"_a=cacheEventTimer.end_time(),
+                                          "description"_a="In ConcatenatingCacheMachine::pullFromCache Concatenating could have caused overflow strings length. Adding {} batches back"_format(batches.size() - 1));
+            }
 		}
 
 		if( concat_all && ral::utilities::checkIfConcatenatingStringsWillOverflow(tables) ) { // if we have to concatenate all, then lets throw a warning if it will overflow strings
@@ -841,7 +982,9 @@ std::unique_ptr<ral::frame::BlazingTable> ConcatenatingCacheMachine::pullFromCac
                                           "description"_a="In ConcatenatingCacheMachine::pullFromCache Concatenating will overflow strings length");
             }
 		}
-		output = ral::utilities::concatTables(std::move(tables));
+		if (output == nullptr) {
+			output = ral::utilities::concatTables(std::move(tables));
+		}
 		num_rows = output->num_rows();
 	}
 
@@ -866,11 +1009,13 @@ std::unique_ptr<ral::frame::BlazingTable> ConcatenatingCacheMachine::pullFromCac
 std::unique_ptr<ral::cache::CacheData> ConcatenatingCacheMachine::pullCacheData() {
     CodeTimer cacheEventTimer;
     cacheEventTimer.start();
+    ral::utilities::trace_scope trace("ConcatenatingPullCacheData", "cache", (ctx ? ctx->getContextToken() : -1), cache_id);
 
+	std::size_t concat_target_bytes = get_concat_target_bytes();
 	if (concat_all){
 		waitingCache->wait_until_finished();
 	} else {
-		waitingCache->wait_until_num_bytes(this->concat_cache_num_bytes, this->num_bytes_timeout);		
+		waitingCache->wait_until_num_bytes(concat_target_bytes, this->num_bytes_timeout);		
 	}
 
 	size_t total_bytes = 0;
@@ -891,7 +1036,7 @@ std::unique_ptr<ral::cache::CacheData> ConcatenatingCacheMachine::pullCacheData(
 		total_bytes += cache_data.sizeInBytes();
 		message_id = message_data->get_message_id();
 		collected_messages.push_back(std::move(message_data));
-	} while (concat_all || (total_bytes + waitingCache->get_next_size_in_bytes() <= this->concat_cache_num_bytes));
+	} while (concat_all || (total_bytes + waitingCache->get_next_size_in_bytes() <= concat_target_bytes));
 
 	std::unique_ptr<ral::cache::CacheData> output;
 	size_t num_rows = 0;
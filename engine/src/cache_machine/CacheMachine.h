@@ -14,6 +14,7 @@
 #include "utilities/error.hpp"
 #include "utilities/CodeTimer.h"
 #include "execution_kernels/LogicPrimitives.h"
+#include "execution_kernels/kernel_throughput.h"
 #include "execution_graph/Context.h"
 #include <bmr/BlazingMemoryResource.h>
 #include "communication/CommunicationData.h"
@@ -67,8 +68,20 @@ public:
 
 	virtual bool is_finished();
 
+	/**
+	* Finishes this cache and drops all of its data, freeing its GPU and host memory and removing its spill files.
+	* It is used to cancel a query.
+	*/
+	void clear();
+
+	// wakes up the threads that wait for this cache, see WaitingQueue::notify_waiters
+	void notify_waiters();
+
 	uint64_t get_num_bytes_added();
 
+	// the bytes of the tables that were added to the host or disk tiers because they did not fit in the GPU one
+	uint64_t get_num_bytes_spilled();
+
 	uint64_t get_num_rows_added();
 
 	uint64_t get_num_batches_added();
@@ -89,6 +102,12 @@ public:
 
 	bool has_messages_now(std::vector<std::string> messages);
 
+	// waits until this CacheMachine holds at most num_bytes or stop is true, it returns false if it gave up after max_wait_ms.
+	// whoever makes stop true has to call notify_waiters
+	bool wait_until_num_bytes_below(size_t num_bytes, int max_wait_ms, std::function<bool()> stop = nullptr) {
+		return this->waitingCache->wait_until_num_bytes_below(num_bytes, max_wait_ms, stop);
+	}
+
 	std::unique_ptr<ral::cache::CacheData> pullAnyCacheData(const std::vector<std::string> & messages);
 
 	std::size_t get_num_batches(){
@@ -101,7 +120,8 @@ public:
 
 	std::vector<std::unique_ptr<ral::cache::CacheData> > pull_all_cache_data();
 
-	virtual std::unique_ptr<ral::cache::CacheData> pullCacheData(std::string message_id);
+	// the wait for the message also ends with a nullptr when stop returns true, see WaitingQueue::get_or_wait
+	virtual std::unique_ptr<ral::cache::CacheData> pullCacheData(std::string message_id, std::function<bool()> stop = nullptr);
 
 	virtual std::unique_ptr<ral::cache::CacheData> pullCacheData();
 
@@ -114,6 +134,21 @@ public:
 	// this function does not change the order of the caches
 	virtual size_t downgradeCacheData();
 
+	// take the CacheData in this CacheMachine that is in CPU memory (looking in reverse order) and put it on Disk, until the
+	// host tier is back within its limit. This does not go through the GPU and it does not change the order of the caches
+	virtual size_t downgradeHostCacheData();
+
+	// the number of bytes of the CacheData in this CacheMachine that is in the GPU
+	size_t get_gpu_bytes();
+
+	// the number of bytes of the CacheData in this CacheMachine that is in CPU memory
+	size_t get_cpu_bytes();
+
+	// the format of the files this CacheMachine writes when it spills to disk. It defaults to the CACHE_SPILL_FORMAT of the query
+	void set_spill_format(SpillFormat format) { this->spill_format = format; }
+
+	SpillFormat get_spill_format() const { return this->spill_format; }
+
     bool has_data_in_index_now(size_t index);
 
 protected:
@@ -126,11 +161,14 @@ protected:
 	std::vector<BlazingMemoryResource*> memory_resources;
 	std::atomic<std::size_t> num_bytes_added;
 	std::atomic<uint64_t> num_rows_added;
+	std::atomic<std::size_t> num_bytes_spilled{0};
 	/// This variable is to keep track of if anything has been added to the cache. Its useful to keep from adding empty tables to the cache, where we might want an empty table at least to know the schema
 	bool something_added;
 	std::shared_ptr<Context> ctx;
 	const std::size_t cache_id;
 	int cache_level_override;
+	SpillFormat spill_format = SpillFormat::ORC;
+	bool host_compression = false; /**< ENABLE_HOST_CACHE_COMPRESSION */
 	std::string cache_machine_name;
 	std::shared_ptr<spdlog::logger> cache_events_logger;
     bool is_array_access;
@@ -151,7 +189,8 @@ public:
 	ConcatenatingCacheMachine(std::shared_ptr<Context> context, std::string cache_machine_name);
 
 	ConcatenatingCacheMachine(std::shared_ptr<Context> context,
-			std::size_t concat_cache_num_bytes, int num_bytes_timeout, bool concat_all, std::string cache_machine_name);
+			std::size_t concat_cache_num_bytes, int num_bytes_timeout, bool concat_all, std::string cache_machine_name,
+			std::shared_ptr<kernel_throughput> consumer_throughput = nullptr);
 
 	~ConcatenatingCacheMachine() = default;
 
@@ -167,11 +206,39 @@ public:
 		return 0;
 	}
 
+	size_t downgradeHostCacheData() override {
+		return 0;
+	}
+
   private:
+	/**
+	* Get how many bytes we want to concatenate in a batch. It is concat_cache_num_bytes unless the kernel that consumes
+	* this cache suggests smaller batches, because its tasks already amortize their fixed overhead with them.
+	*/
+	std::size_t get_concat_target_bytes();
+
   	std::size_t concat_cache_num_bytes;
 	int num_bytes_timeout;
 	bool concat_all;
+	std::shared_ptr<kernel_throughput> consumer_throughput; /**< Throughput model of the kernel that consumes this cache, if adaptive batch coalescing is enabled. */
+
+};
 
+/**
+	@brief A Cache Machine for the edges between a single producer kernel and a single consumer kernel, for example Filter to Project.
+	While the table fits in the GPU tier it is handed off to the consumer as it is, the size of the table is computed only once
+	and the batches are not logged one by one, only the totals of the cache when it finishes.
+	When the table does not fit it falls back to the spilling of the CacheMachine.
+*/
+class DirectCacheMachine : public CacheMachine {
+public:
+	DirectCacheMachine(std::shared_ptr<Context> context, std::string cache_machine_name, bool log_timeout = true);
+
+	~DirectCacheMachine() = default;
+
+	bool addToCache(std::unique_ptr<ral::frame::BlazingTable> table, std::string message_id = "", bool always_add = false, const MetadataDictionary & metadata = {}, bool use_pinned = false ) override;
+
+	std::unique_ptr<ral::frame::BlazingTable> pullFromCache() override;
 };
 
 
@@ -1,5 +1,6 @@
 #include "ConcatCacheData.h"
 #include "utilities/CommonOperations.h"
+#include <algorithm>
 
 namespace ral {
 namespace cache {
@@ -12,6 +13,15 @@ ConcatCacheData::ConcatCacheData(std::vector<std::unique_ptr<CacheData>> cache_d
 		RAL_EXPECTS(std::equal(schema.begin(), schema.end(), cache_schema.begin()), "Cache data has a different schema");
 		n_rows += cache_data->num_rows();
 	}
+
+	// the batches of the same hash partition are still in it once they are concatenated
+	std::string hash_partition = _cache_datas.empty() ? "" : _cache_datas[0]->getMetadata().get_value(HASH_PARTITION_METADATA_LABEL);
+	bool same_hash_partition = !hash_partition.empty() && std::all_of(_cache_datas.begin(), _cache_datas.end(), [&hash_partition](const std::unique_ptr<CacheData> & cache_data) {
+		return cache_data->getMetadata().get_value(HASH_PARTITION_METADATA_LABEL) == hash_partition;
+	});
+	if (same_hash_partition) {
+		this->metadata.add_value(HASH_PARTITION_METADATA_LABEL, hash_partition);
+	}
 }
 
 std::unique_ptr<ral::frame::BlazingTable> ConcatCacheData::decache() {
@@ -40,6 +50,14 @@ size_t ConcatCacheData::sizeInBytes() const {
 	return total_size;
 };
 
+size_t ConcatCacheData::estimatedDecachedBytes() const {
+	size_t total_size = 0;
+	for (auto && cache_data : _cache_datas) {
+		total_size += cache_data->estimatedDecachedBytes();
+	}
+	return total_size;
+}
+
 void ConcatCacheData::set_names(const std::vector<std::string> & names) {
 	for (size_t i = 0; i < _cache_datas.size(); ++i) {
 		_cache_datas[i]->set_names(names);
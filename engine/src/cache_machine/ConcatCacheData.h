@@ -27,6 +27,11 @@ public:
 	*/
 	size_t sizeInBytes() const override;
 
+	/**
+	* Get the estimated decached size of the cache datas that are not loaded yet.
+	*/
+	size_t estimatedDecachedBytes() const override;
+
 	/**
 	* Set the names of the columns.
 	* @param names a vector of the column names.
@@ -1,4 +1,5 @@
 #include "GPUCacheData.h"
+#include "ManagedMemoryHints.h"
 
 namespace ral {
 namespace cache {
@@ -12,11 +13,21 @@ GPUCacheData::GPUCacheData(std::unique_ptr<ral::frame::BlazingTable> table, cons
     this->metadata = metadata;
 }
 
+GPUCacheData::GPUCacheData(std::unique_ptr<ral::frame::BlazingTable> table, const MetadataDictionary & metadata, std::size_t size_in_bytes)
+: CacheData(CacheDataType::GPU,table->names(), table->get_schema(), table->num_rows()),  data{std::move(table)},
+    size_known{true}, known_size_in_bytes{size_in_bytes} {
+    this->metadata = metadata;
+}
+
 std::unique_ptr<ral::frame::BlazingTable> GPUCacheData::decache() {
+    remove_host_advice();
     return std::move(data);
 }
 
 size_t GPUCacheData::sizeInBytes() const {
+    if (size_known) {
+        return known_size_in_bytes;
+    }
     return data->sizeInBytes();
 }
 
@@ -29,10 +40,33 @@ ral::frame::BlazingTableView GPUCacheData::getTableView() {
 }
 
 void GPUCacheData::set_data(std::unique_ptr<ral::frame::BlazingTable> table ) {
+    remove_host_advice();
     this->data = std::move(table);
+    this->size_known = false;
+}
+
+void GPUCacheData::advise_host_placement() {
+    if (host_advised || data == nullptr) {
+        return;
+    }
+    host_advised_bytes = sizeInBytes();
+    managed_memory_hints::get_instance().advise_host(data->toBlazingTableView(), host_advised_bytes);
+    host_advised = true;
+}
+
+void GPUCacheData::remove_host_advice() {
+    if (!host_advised) {
+        return;
+    }
+    if (data != nullptr) {
+        managed_memory_hints::get_instance().unadvise_host(data->toBlazingTableView(), host_advised_bytes);
+    }
+    host_advised = false;
 }
 
-GPUCacheData::~GPUCacheData() {}
+GPUCacheData::~GPUCacheData() {
+    remove_host_advice();
+}
 
 } // namespace cache
 } // namespace ral
\ No newline at end of file
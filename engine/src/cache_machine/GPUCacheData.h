@@ -24,6 +24,14 @@ public:
 	*/
 	GPUCacheData(std::unique_ptr<ral::frame::BlazingTable> table, const MetadataDictionary & metadata);
 
+	/**
+	* Constructor
+	* @param table The BlazingTable that is moved into the CacheData.
+	* @param metadata The metadata that will be used in transport and planning.
+	* @param size_in_bytes The size of the table, when the caller already computed it, so that sizeInBytes() does not walk the columns again.
+	*/
+	GPUCacheData(std::unique_ptr<ral::frame::BlazingTable> table, const MetadataDictionary & metadata, std::size_t size_in_bytes);
+
 	/**
 	* Move the BlazingTable out of this Cache
 	* This function only exists so that we can interact with all cache data by
@@ -60,8 +68,22 @@ public:
 
 	void set_data(std::unique_ptr<ral::frame::BlazingTable> table);
 
+	/**
+	* With managed memory, makes the host the preferred location of the table, see managed_memory_hints. The advice is
+	* removed when the table is decached.
+	*/
+	void advise_host_placement();
+
+	bool is_host_advised() const { return host_advised; }
+
 protected:
+	void remove_host_advice();
+
 	std::unique_ptr<ral::frame::BlazingTable> data; /**< Stores the data to be returned in decache */
+	bool size_known = false; /**< Whether known_size_in_bytes is the size of data */
+	std::size_t known_size_in_bytes = 0;
+	bool host_advised = false; /**< Whether the driver was told to keep data in host memory */
+	std::size_t host_advised_bytes = 0;
 };
 
 } // namespace cache
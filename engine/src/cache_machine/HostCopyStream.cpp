@@ -0,0 +1,71 @@
+#include "HostCopyStream.h"
+
+namespace ral {
+namespace cache {
+
+host_copy_stream::~host_copy_stream() {
+	// the tables are not freed here, since the CUDA context may already be gone when static objects are destroyed
+	for (auto & pending : pending_copies) {
+		pending.table.release();
+		for (auto & buffer : pending.temp_buffers) {
+			buffer.release();
+		}
+	}
+}
+
+cudaStream_t host_copy_stream::get_stream() {
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (stream == nullptr) {
+		int least_priority, greatest_priority;
+		cudaDeviceGetStreamPriorityRange(&least_priority, &greatest_priority);
+		cudaStreamCreateWithPriority(&stream, cudaStreamNonBlocking, least_priority);
+	}
+	return stream;
+}
+
+copy_event_ptr host_copy_stream::make_event() {
+	cudaEvent_t event;
+	cudaEventCreateWithFlags(&event, cudaEventDisableTiming);
+	return copy_event_ptr(event, [](cudaEvent_t event) { cudaEventDestroy(event); });
+}
+
+void host_copy_stream::release_after(copy_event_ptr event, std::unique_ptr<ral::frame::BlazingTable> table,
+	std::vector<std::unique_ptr<rmm::device_buffer>> temp_buffers) {
+	std::size_t bytes = table->sizeInBytes();
+	for (auto & buffer : temp_buffers) {
+		bytes += buffer->size();
+	}
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		pending_copies.push_back({std::move(event), std::move(table), std::move(temp_buffers), bytes});
+		pending_bytes += bytes;
+	}
+	release_finished();
+}
+
+std::size_t host_copy_stream::release_finished() {
+	std::vector<pending_copy> finished_copies;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		// the copies finish in the order they were issued, since they all are on the same stream
+		while (!pending_copies.empty() && cudaEventQuery(pending_copies.front().event.get()) != cudaErrorNotReady) {
+			pending_bytes -= pending_copies.front().bytes;
+			finished_copies.push_back(std::move(pending_copies.front()));
+			pending_copies.pop_front();
+		}
+	}
+
+	std::size_t bytes_freed = 0;
+	for (auto & finished : finished_copies) {
+		bytes_freed += finished.bytes;
+	}
+	return bytes_freed; // the tables are freed here, outside of the lock
+}
+
+std::size_t host_copy_stream::get_pending_bytes() {
+	std::lock_guard<std::mutex> lock(mutex_);
+	return pending_bytes;
+}
+
+}  // namespace cache
+}  // namespace ral
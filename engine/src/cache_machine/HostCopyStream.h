@@ -0,0 +1,84 @@
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+#include <cuda_runtime_api.h>
+#include <rmm/device_buffer.hpp>
+#include "execution_kernels/LogicPrimitives.h"
+
+namespace ral {
+namespace cache {
+
+using copy_event_ptr = std::shared_ptr<std::remove_pointer<cudaEvent_t>::type>;
+
+/**
+* The stream used to copy GPU tables into host memory when they are downgraded, and the tables whose copies are still in flight.
+* The copies are issued on a low priority stream so that downgrading does not wait for them nor delays the kernels.
+* A table handed to this class is kept alive until the copies recorded before its event are done, and then it is
+* freed by release_finished(), which only checks the events without waiting on them.
+* @note Myers' singleton.
+*/
+class host_copy_stream {
+public:
+	static host_copy_stream & get_instance() {
+		static host_copy_stream instance;
+		return instance;
+	}
+
+	host_copy_stream(host_copy_stream &&) = delete;
+	host_copy_stream(const host_copy_stream &) = delete;
+	host_copy_stream & operator=(host_copy_stream &&) = delete;
+	host_copy_stream & operator=(const host_copy_stream &) = delete;
+
+	/**
+	* Get the low priority stream where the copies are issued.
+	*/
+	cudaStream_t get_stream();
+
+	/**
+	* Creates an event to record on the stream after the copies of a table.
+	*/
+	copy_event_ptr make_event();
+
+	/**
+	* Keeps a table, and the buffers that were created to serialize it, until the event completes.
+	* @param event the event recorded after the copies that read from the table.
+	* @param table the table being copied.
+	* @param temp_buffers the buffers created while serializing the table, which the copies also read from.
+	*/
+	void release_after(copy_event_ptr event, std::unique_ptr<ral::frame::BlazingTable> table,
+		std::vector<std::unique_ptr<rmm::device_buffer>> temp_buffers);
+
+	/**
+	* Frees the tables whose copies are done, without waiting for the others.
+	* @return the number of bytes freed.
+	*/
+	std::size_t release_finished();
+
+	/**
+	* Get the number of GPU bytes that will be freed once the copies in flight are done.
+	*/
+	std::size_t get_pending_bytes();
+
+private:
+	host_copy_stream() = default;
+	~host_copy_stream();
+
+	struct pending_copy {
+		copy_event_ptr event;
+		std::unique_ptr<ral::frame::BlazingTable> table;
+		std::vector<std::unique_ptr<rmm::device_buffer>> temp_buffers;
+		std::size_t bytes;
+	};
+
+	std::mutex mutex_;
+	cudaStream_t stream = nullptr;
+	std::deque<pending_copy> pending_copies;
+	std::size_t pending_bytes = 0;
+};
+
+}  // namespace cache
+}  // namespace ral
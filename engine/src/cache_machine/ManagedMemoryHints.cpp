@@ -0,0 +1,70 @@
+#include "ManagedMemoryHints.h"
+
+#include <algorithm>
+#include <cudf/column/column_view.hpp>
+#include <cudf/null_mask.hpp>
+#include <cudf/utilities/traits.hpp>
+#include <cudf/utilities/type_dispatcher.hpp>
+
+namespace ral {
+namespace cache {
+
+namespace {
+
+// calls visit with the pointer and size of every buffer of a column and its children
+template <typename Visitor>
+void for_each_buffer(const cudf::column_view & column, Visitor visit) {
+	cudf::size_type rows = column.offset() + column.size();
+	if (column.head() != nullptr && cudf::is_fixed_width(column.type())) {
+		visit(column.head(), cudf::size_of(column.type()) * rows);
+	}
+	if (column.nullable()) {
+		visit(column.null_mask(), cudf::bitmask_allocation_size_bytes(rows));
+	}
+	for (auto child = column.child_begin(); child != column.child_end(); ++child) {
+		for_each_buffer(*child, visit);
+	}
+}
+
+template <typename Visitor>
+void for_each_buffer(const ral::frame::BlazingTableView & table, Visitor visit) {
+	for (cudf::size_type i = 0; i < table.num_columns(); i++) {
+		for_each_buffer(table.view().column(i), visit);
+	}
+}
+
+}  // namespace
+
+void managed_memory_hints::configure(bool managed, bool prefetch_inputs, bool advise_host) {
+	this->prefetch_inputs = managed && prefetch_inputs;
+	this->host_advice = managed && advise_host;
+}
+
+void managed_memory_hints::prefetch_to_device(const ral::frame::BlazingTableView & table, cudaStream_t stream) {
+	int device = 0;
+	cudaGetDevice(&device);
+	for_each_buffer(table, [device, stream](const void * data, std::size_t size) {
+		cudaMemPrefetchAsync(data, size, device, stream);
+	});
+	cudaGetLastError(); // the hints can fail for buffers that are not managed, which is not an error
+}
+
+void managed_memory_hints::advise_host(const ral::frame::BlazingTableView & table, std::size_t size_in_bytes) {
+	for_each_buffer(table, [](const void * data, std::size_t size) {
+		cudaMemAdvise(data, size, cudaMemAdviseSetPreferredLocation, cudaCpuDeviceId);
+		cudaMemPrefetchAsync(data, size, cudaCpuDeviceId, 0);
+	});
+	cudaGetLastError();
+	host_advised_bytes += size_in_bytes;
+}
+
+void managed_memory_hints::unadvise_host(const ral::frame::BlazingTableView & table, std::size_t size_in_bytes) {
+	for_each_buffer(table, [](const void * data, std::size_t size) {
+		cudaMemAdvise(data, size, cudaMemAdviseUnsetPreferredLocation, cudaCpuDeviceId);
+	});
+	cudaGetLastError();
+	host_advised_bytes -= std::min(size_in_bytes, host_advised_bytes.load());
+}
+
+} // namespace cache
+} // namespace ral
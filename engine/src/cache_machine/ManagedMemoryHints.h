@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <cuda_runtime_api.h>
+#include "execution_kernels/LogicPrimitives.h"
+
+namespace ral {
+namespace cache {
+
+/**
+* The hints given to the CUDA driver about where the buffers of the tables should be when the GPU memory is managed,
+* so that oversubscribed queries don't fault their pages in one by one.
+* The inputs of a task are prefetched to the device before it processes them, and when the caches are told to free GPU
+* memory, their tables can be advised to prefer the host instead of being copied there, so that the driver moves them
+* out and back at full bandwidth. The hints are only given with the managed allocators.
+* @note Myers' singleton.
+*/
+class managed_memory_hints {
+public:
+	static managed_memory_hints & get_instance() {
+		static managed_memory_hints instance;
+		return instance;
+	}
+
+	managed_memory_hints(managed_memory_hints &&) = delete;
+	managed_memory_hints(const managed_memory_hints &) = delete;
+	managed_memory_hints & operator=(managed_memory_hints &&) = delete;
+	managed_memory_hints & operator=(const managed_memory_hints &) = delete;
+
+	/**
+	* It is set by MANAGED_MEMORY_PREFETCH and MANAGED_MEMORY_HOST_ADVICE when the engine is initialized.
+	* @param managed whether the GPU memory resource allocates managed memory.
+	*/
+	void configure(bool managed, bool prefetch_inputs, bool advise_host);
+
+	bool is_prefetch_enabled() const { return prefetch_inputs; }
+	bool is_host_advice_enabled() const { return host_advice; }
+
+	/**
+	* Prefetches the buffers of the columns of a table to the current device on a stream.
+	*/
+	void prefetch_to_device(const ral::frame::BlazingTableView & table, cudaStream_t stream);
+
+	/**
+	* Makes the host the preferred location of the buffers of a table, and moves them there.
+	* @param size_in_bytes the size of the table, which is no longer counted as GPU memory used while it is advised.
+	*/
+	void advise_host(const ral::frame::BlazingTableView & table, std::size_t size_in_bytes);
+
+	/**
+	* Removes the advice of advise_host, when the table is going to be used again or it is freed.
+	*/
+	void unadvise_host(const ral::frame::BlazingTableView & table, std::size_t size_in_bytes);
+
+	/**
+	* The bytes of the tables that are advised to prefer the host. They are allocated from the GPU memory resource,
+	* but the driver keeps them in host memory, so the MemoryMonitors don't count them.
+	*/
+	std::size_t get_host_advised_bytes() const { return host_advised_bytes.load(); }
+
+private:
+	managed_memory_hints() = default;
+
+	std::atomic<bool> prefetch_inputs{false};
+	std::atomic<bool> host_advice{false};
+	std::atomic<std::size_t> host_advised_bytes{0};
+};
+
+} // namespace cache
+} // namespace ral
@@ -0,0 +1,64 @@
+#include "MaterializationCache.h"
+
+namespace ral {
+namespace cache {
+
+std::shared_ptr<const materialized_result> materialization_cache::get(const std::string & fingerprint) {
+	std::lock_guard<std::mutex> lock(mutex_);
+	auto it = entries.find(fingerprint);
+	if (it == entries.end()) {
+		return nullptr;
+	}
+	lru_order.splice(lru_order.begin(), lru_order, it->second.lru_position);
+	return it->second.result;
+}
+
+bool materialization_cache::put(const std::string & fingerprint, std::shared_ptr<const materialized_result> result, std::size_t max_bytes) {
+	if (result == nullptr || result->bytes > max_bytes) {
+		return false;
+	}
+
+	// the evicted results are freed outside of the lock. Queries that are reading them keep them alive until they are done
+	std::vector<std::shared_ptr<const materialized_result>> evicted_results;
+	std::lock_guard<std::mutex> lock(mutex_);
+	auto it = entries.find(fingerprint);
+	if (it != entries.end()) {
+		total_bytes -= it->second.result->bytes;
+		lru_order.erase(it->second.lru_position);
+		evicted_results.push_back(std::move(it->second.result));
+		entries.erase(it);
+	}
+	while (!lru_order.empty() && total_bytes + result->bytes > max_bytes) {
+		auto least_recently_used = entries.find(lru_order.back());
+		total_bytes -= least_recently_used->second.result->bytes;
+		evicted_results.push_back(std::move(least_recently_used->second.result));
+		entries.erase(least_recently_used);
+		lru_order.pop_back();
+	}
+
+	lru_order.push_front(fingerprint);
+	total_bytes += result->bytes;
+	entries[fingerprint] = entry{std::move(result), lru_order.begin()};
+	return true;
+}
+
+void materialization_cache::clear() {
+	std::map<std::string, entry> evicted_entries;
+	std::lock_guard<std::mutex> lock(mutex_);
+	evicted_entries.swap(entries);
+	lru_order.clear();
+	total_bytes = 0;
+}
+
+std::size_t materialization_cache::get_total_bytes() {
+	std::lock_guard<std::mutex> lock(mutex_);
+	return total_bytes;
+}
+
+std::size_t materialization_cache::size() {
+	std::lock_guard<std::mutex> lock(mutex_);
+	return entries.size();
+}
+
+}  // namespace cache
+}  // namespace ral
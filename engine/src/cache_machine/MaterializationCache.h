@@ -0,0 +1,88 @@
+#pragma once
+
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "blazing_table/BlazingHostTable.h"
+
+namespace ral {
+namespace cache {
+
+/**
+* The batches produced by a subplan, kept in host memory so that they can be given again to later queries.
+*/
+struct materialized_result {
+	std::vector<std::unique_ptr<ral::frame::BlazingHostTable>> tables;
+	std::size_t bytes = 0;
+};
+
+/**
+* A cache of the results of subplans that lives across queries.
+* Every result is keyed by the fingerprint of the subplan that produced it, which is made of its relational algebra
+* and the version (uri, modification time and size) of every file it reads, so that a result is not found anymore
+* once its inputs change. The results are kept in host memory and the least recently used ones are evicted when the
+* cache grows beyond its size limit.
+* @note Myers' singleton.
+*/
+class materialization_cache {
+public:
+	static materialization_cache & get_instance() {
+		static materialization_cache instance;
+		return instance;
+	}
+
+	materialization_cache(materialization_cache &&) = delete;
+	materialization_cache(const materialization_cache &) = delete;
+	materialization_cache & operator=(materialization_cache &&) = delete;
+	materialization_cache & operator=(const materialization_cache &) = delete;
+
+	/**
+	* Get the result of a subplan, which becomes the most recently used one.
+	* @param fingerprint the fingerprint of the subplan.
+	* @return the result or nullptr if it is not cached.
+	*/
+	std::shared_ptr<const materialized_result> get(const std::string & fingerprint);
+
+	/**
+	* Adds the result of a subplan, evicting the least recently used results until it fits.
+	* @param fingerprint the fingerprint of the subplan.
+	* @param result the result to add.
+	* @param max_bytes the size limit of the whole cache. A result bigger than this is not added.
+	* @return true if the result was added.
+	*/
+	bool put(const std::string & fingerprint, std::shared_ptr<const materialized_result> result, std::size_t max_bytes);
+
+	/**
+	* Removes all the results.
+	*/
+	void clear();
+
+	/**
+	* Get the number of bytes of all the results.
+	*/
+	std::size_t get_total_bytes();
+
+	/**
+	* Get the number of results.
+	*/
+	std::size_t size();
+
+private:
+	materialization_cache() = default;
+
+	struct entry {
+		std::shared_ptr<const materialized_result> result;
+		std::list<std::string>::iterator lru_position;
+	};
+
+	std::mutex mutex_;
+	std::map<std::string, entry> entries;
+	std::list<std::string> lru_order; /**< The fingerprints from the most to the least recently used. */
+	std::size_t total_bytes = 0;
+};
+
+}  // namespace cache
+}  // namespace ral
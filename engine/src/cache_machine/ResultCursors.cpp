@@ -0,0 +1,158 @@
+#include "ResultCursors.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <cudf/copying.hpp>
+
+#include "utilities/CommonOperations.h"
+
+namespace ral {
+namespace cache {
+
+namespace {
+
+// a page brings the whole chunks it spans to the GPU, so they are kept small compared to the batches of a query
+const int64_t CURSOR_CHUNK_ROWS = 65536;
+
+}  // namespace
+
+result_cursors & result_cursors::get_instance() {
+	static result_cursors instance;
+	return instance;
+}
+
+result_cursors::~result_cursors() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	expiry_cv.notify_all();
+	if (expiry_thread.joinable()) {
+		expiry_thread.join();
+	}
+}
+
+int64_t result_cursors::open(int32_t cursor_id, std::vector<std::unique_ptr<ral::frame::BlazingTable>> batches, std::chrono::milliseconds ttl) {
+	auto new_cursor = std::make_shared<cursor>();
+	// the host tier, so that the cursor does not hold GPU memory while nobody is paging through it
+	new_cursor->cache = std::make_shared<CacheMachine>(nullptr, "cursor_" + std::to_string(cursor_id), false, 1, true);
+	new_cursor->ttl = ttl;
+	if (!batches.empty()) {
+		new_cursor->names = batches[0]->names();
+		new_cursor->types = batches[0]->get_schema();
+	}
+
+	int64_t num_rows = 0;
+	std::size_t chunk_index = 0;
+	for (auto & batch : batches) {
+		if (batch->num_rows() == 0) {
+			continue;
+		}
+		if (batch->num_rows() <= CURSOR_CHUNK_ROWS) {
+			new_cursor->chunk_offsets.push_back(num_rows);
+			num_rows += batch->num_rows();
+			new_cursor->cache->put(chunk_index++, std::move(batch));
+			continue;
+		}
+		for (cudf::size_type start = 0; start < batch->num_rows(); start += CURSOR_CHUNK_ROWS) {
+			cudf::size_type end = std::min<int64_t>(start + CURSOR_CHUNK_ROWS, batch->num_rows());
+			auto chunk = ral::frame::BlazingTableView(cudf::slice(batch->view(), {start, end})[0], new_cursor->names).clone();
+			new_cursor->chunk_offsets.push_back(num_rows);
+			num_rows += chunk->num_rows();
+			new_cursor->cache->put(chunk_index++, std::move(chunk));
+		}
+		batch.reset();
+	}
+	new_cursor->chunk_offsets.push_back(num_rows);
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		new_cursor->expires_at = std::chrono::steady_clock::now() + ttl;
+		cursors[cursor_id] = new_cursor;
+		if (!expiry_thread.joinable()) {
+			expiry_thread = std::thread([this] { release_expired(); });
+		}
+	}
+	expiry_cv.notify_all();
+	return num_rows;
+}
+
+std::unique_ptr<ral::frame::BlazingTable> result_cursors::fetch(int32_t cursor_id, int64_t offset, int64_t num_rows) {
+	std::shared_ptr<cursor> fetched_cursor;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		auto it = cursors.find(cursor_id);
+		if (it == cursors.end()) {
+			throw std::runtime_error("ERROR: The cursor " + std::to_string(cursor_id) + " does not exist, it was closed or it expired");
+		}
+		fetched_cursor = it->second;
+		fetched_cursor->expires_at = std::chrono::steady_clock::now() + fetched_cursor->ttl;
+	}
+
+	std::lock_guard<std::mutex> cursor_lock(fetched_cursor->mutex);
+	const std::vector<int64_t> & chunk_offsets = fetched_cursor->chunk_offsets;
+	int64_t total_rows = chunk_offsets.back();
+	int64_t start = std::min(std::max(offset, int64_t{0}), total_rows);
+	int64_t end = std::min(start + std::max(num_rows, int64_t{0}), total_rows);
+	if (start >= end) {
+		return ral::frame::createEmptyBlazingTable(fetched_cursor->types, fetched_cursor->names);
+	}
+
+	std::vector<std::unique_ptr<ral::frame::BlazingTable>> pieces;
+	std::size_t first_chunk = std::upper_bound(chunk_offsets.begin(), chunk_offsets.end(), start) - chunk_offsets.begin() - 1;
+	for (std::size_t i = first_chunk; i + 1 < chunk_offsets.size() && chunk_offsets[i] < end; i++) {
+		std::unique_ptr<ral::frame::BlazingTable> chunk = fetched_cursor->cache->get_or_wait(i);
+		cudf::size_type chunk_start = std::max(start - chunk_offsets[i], int64_t{0});
+		cudf::size_type chunk_end = std::min(end, chunk_offsets[i + 1]) - chunk_offsets[i];
+		try {
+			pieces.push_back(ral::frame::BlazingTableView(cudf::slice(chunk->view(), {chunk_start, chunk_end})[0], fetched_cursor->names).clone());
+		} catch (...) {
+			// the chunk goes back even if the page could not be made, like when the GPU is out of memory
+			fetched_cursor->cache->put(i, std::move(chunk));
+			throw;
+		}
+		fetched_cursor->cache->put(i, std::move(chunk));
+	}
+	return pieces.size() == 1 ? std::move(pieces[0]) : concatTables(std::move(pieces));
+}
+
+bool result_cursors::close(int32_t cursor_id) {
+	std::shared_ptr<cursor> closed_cursor;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		auto it = cursors.find(cursor_id);
+		if (it == cursors.end()) {
+			return false;
+		}
+		closed_cursor = it->second;
+		cursors.erase(it);
+	}
+	// its chunks are freed once the fetches that are using it are done
+	return true;
+}
+
+std::size_t result_cursors::get_num_cursors() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return cursors.size();
+}
+
+void result_cursors::release_expired() {
+	std::unique_lock<std::mutex> lock(mutex);
+	while (!stopping) {
+		auto now = std::chrono::steady_clock::now();
+		auto next_expiry = now + std::chrono::hours(1);
+		for (auto it = cursors.begin(); it != cursors.end();) {
+			if (it->second->expires_at <= now) {
+				it = cursors.erase(it);
+			} else {
+				next_expiry = std::min(next_expiry, it->second->expires_at);
+				++it;
+			}
+		}
+		expiry_cv.wait_until(lock, next_expiry);
+	}
+}
+
+}  // namespace cache
+}  // namespace ral
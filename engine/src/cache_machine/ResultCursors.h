@@ -0,0 +1,78 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "CacheMachine.h"
+#include "execution_kernels/LogicPrimitives.h"
+
+namespace ral {
+namespace cache {
+
+/**
+* The results of the queries that were run as cursors, kept by every node after the query finished so that the pages
+* of a sorted result are taken from them, instead of running the whole sort again with a larger OFFSET for every page.
+*
+* The part of the result of a node is kept in the order the OutputKernel had it, in chunks of at most 65536 rows, in
+* a CacheMachine of the host tier, so it does not hold GPU memory between the pages. A
+* page only brings the chunks it spans to the GPU. The range partitions of a distributed sort are in the order of
+* the nodes, so the client takes a page from the nodes whose parts it spans, at their offsets.
+*
+* A cursor is released when it is closed, or when it was not used for its time to live.
+*/
+class result_cursors {
+public:
+	static result_cursors & get_instance();
+
+	~result_cursors();
+
+	/**
+	* Keeps the part of the result of a query of this node.
+	* @param cursor_id the ctx token of the query.
+	* @param ttl how long the cursor is kept after it was last opened or fetched from.
+	* @return the number of rows of the part.
+	*/
+	int64_t open(int32_t cursor_id, std::vector<std::unique_ptr<ral::frame::BlazingTable>> batches, std::chrono::milliseconds ttl);
+
+	/**
+	* @return the rows [offset, offset + num_rows) of the part of the result of this node, fewer if it has less rows.
+	* @throws std::runtime_error if the cursor is not known, because it was closed or it expired.
+	*/
+	std::unique_ptr<ral::frame::BlazingTable> fetch(int32_t cursor_id, int64_t offset, int64_t num_rows);
+
+	/**
+	* @return false if the cursor was not known.
+	*/
+	bool close(int32_t cursor_id);
+
+	std::size_t get_num_cursors();
+
+private:
+	result_cursors() = default;
+
+	struct cursor {
+		std::mutex mutex; // the chunks are taken out of the cache while a page is made from them
+		std::shared_ptr<CacheMachine> cache;
+		std::vector<int64_t> chunk_offsets; // the first row of every chunk, and the number of rows at the end
+		std::vector<std::string> names;
+		std::vector<cudf::data_type> types;
+		std::chrono::milliseconds ttl;
+		std::chrono::steady_clock::time_point expires_at;
+	};
+
+	void release_expired();
+
+	std::mutex mutex;
+	std::condition_variable expiry_cv;
+	std::map<int32_t, std::shared_ptr<cursor>> cursors;
+	std::thread expiry_thread; // started with the first cursor
+	bool stopping = false;
+};
+
+}  // namespace cache
+}  // namespace ral
@@ -0,0 +1,237 @@
+#include "SpillManager.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <dirent.h>
+#include <regex>
+#include <signal.h>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace ral {
+namespace cache {
+
+namespace {
+
+// the extents are aligned to the pages of the filesystem
+const std::size_t EXTENT_ALIGNMENT = 4096;
+
+}  // namespace
+
+spill_segment::~spill_segment() {
+	if (fd >= 0) {
+		close(fd);
+	}
+}
+
+spill_manager & spill_manager::get_instance() {
+	static spill_manager instance;
+	return instance;
+}
+
+spill_manager::~spill_manager() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	reclaim_cv.notify_all();
+	if (reclaim_thread.joinable()) {
+		reclaim_thread.join();
+	}
+	for (auto & query_segments : segments) {
+		for (auto & segment : query_segments.second) {
+			unlink(segment->path.c_str());
+		}
+	}
+}
+
+void spill_manager::configure(std::size_t segment_bytes) {
+	std::lock_guard<std::mutex> lock(mutex);
+	this->segment_bytes = segment_bytes;
+}
+
+bool spill_manager::is_enabled() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return segment_bytes > 0;
+}
+
+bool spill_manager::take_extent(const std::shared_ptr<spill_segment> & segment, std::size_t bytes, spill_extent & extent) {
+	for (auto it = segment->free_extents.begin(); it != segment->free_extents.end(); ++it) {
+		if (it->second < bytes) {
+			continue;
+		}
+		std::size_t offset = it->first;
+		std::size_t free_size = it->second;
+		segment->free_extents.erase(it);
+		if (free_size > bytes) {
+			segment->free_extents[offset + bytes] = free_size - bytes;
+		}
+		segment->allocated_bytes += bytes;
+		extent.segment = segment;
+		extent.offset = offset;
+		extent.size = bytes;
+		return true;
+	}
+	return false;
+}
+
+std::shared_ptr<spill_segment> spill_manager::create_segment(const std::string & directory, const std::string & ctx_token, std::size_t size) {
+	std::size_t segment_id;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		segment_id = next_segment_id++;
+	}
+	auto segment = std::make_shared<spill_segment>();
+	segment->directory = directory;
+	segment->ctx_token = ctx_token;
+	segment->size = size;
+	segment->path = directory + "/.blazing-temp-" + ctx_token + "-segment-" + std::to_string(getpid()) + "-" + std::to_string(segment_id);
+	segment->fd = open(segment->path.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+	if (segment->fd < 0) {
+		throw std::runtime_error("ERROR: Could not create the spill segment " + segment->path + ": " + std::strerror(errno));
+	}
+
+	// the blocks are allocated once, instead of by every spill that writes into them
+	int error = posix_fallocate(segment->fd, 0, size);
+	if (error == EOPNOTSUPP || error == EINVAL) {
+		// the filesystem can not preallocate, so the segment is only sized
+		error = ftruncate(segment->fd, size) == 0 ? 0 : errno;
+	}
+	if (error != 0) {
+		unlink(segment->path.c_str());
+		throw std::runtime_error("ERROR: Could not preallocate the spill segment " + segment->path + ": " + std::strerror(error));
+	}
+	segment->free_extents[0] = size;
+	return segment;
+}
+
+spill_extent spill_manager::allocate(const std::string & directory, const std::string & ctx_token, std::size_t bytes) {
+	std::size_t size = std::max((bytes + EXTENT_ALIGNMENT - 1) / EXTENT_ALIGNMENT * EXTENT_ALIGNMENT, EXTENT_ALIGNMENT);
+	spill_extent extent;
+	std::size_t new_segment_size;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for (auto & segment : segments[{directory, ctx_token}]) {
+			if (take_extent(segment, size, extent)) {
+				return extent;
+			}
+		}
+		new_segment_size = std::max(segment_bytes, size);
+	}
+
+	// preallocating the segment takes a while, so the other spills don't wait for it
+	std::shared_ptr<spill_segment> segment = create_segment(directory, ctx_token, new_segment_size);
+	std::lock_guard<std::mutex> lock(mutex);
+	take_extent(segment, size, extent);
+	segments[{directory, ctx_token}].push_back(segment);
+	if (!reclaim_thread.joinable()) {
+		reclaim_thread = std::thread([this] { reclaim(); });
+	}
+	return extent;
+}
+
+void spill_manager::release(spill_extent extent) {
+	if (extent.segment == nullptr) {
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		released_extents.push_back(std::move(extent));
+	}
+	reclaim_cv.notify_all();
+}
+
+void spill_manager::finish_query(const std::string & ctx_token) {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for (auto it = segments.begin(); it != segments.end();) {
+			if (it->first.second != ctx_token) {
+				++it;
+				continue;
+			}
+			for (auto & segment : it->second) {
+				segment->unlinked = true;
+				segments_to_unlink.push_back(segment);
+			}
+			it = segments.erase(it);
+		}
+	}
+	reclaim_cv.notify_all();
+}
+
+void spill_manager::reclaim() {
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true) {
+		reclaim_cv.wait(lock, [this] { return stopping || !released_extents.empty() || !segments_to_unlink.empty(); });
+		if (stopping) {
+			return;
+		}
+
+		std::deque<spill_extent> extents = std::move(released_extents);
+		released_extents.clear();
+		for (auto & extent : extents) {
+			auto & segment = extent.segment;
+			segment->allocated_bytes -= extent.size;
+			if (segment->unlinked) {
+				// its file goes away with the last extent that uses it
+				continue;
+			}
+			// merged with the free extents next to it, so that larger spills fit again
+			auto & free_extents = segment->free_extents;
+			std::size_t offset = extent.offset;
+			std::size_t size = extent.size;
+			auto next = free_extents.lower_bound(offset);
+			if (next != free_extents.begin()) {
+				auto previous = std::prev(next);
+				if (previous->first + previous->second == offset) {
+					offset = previous->first;
+					size += previous->second;
+					free_extents.erase(previous);
+				}
+			}
+			if (next != free_extents.end() && extent.offset + extent.size == next->first) {
+				size += next->second;
+				free_extents.erase(next);
+			}
+			free_extents[offset] = size;
+		}
+		std::deque<std::shared_ptr<spill_segment>> to_unlink = std::move(segments_to_unlink);
+		segments_to_unlink.clear();
+
+		// the metadata operations of the filesystem and the closes of the files are done without the lock
+		lock.unlock();
+		for (auto & segment : to_unlink) {
+			unlink(segment->path.c_str());
+		}
+		to_unlink.clear();
+		extents.clear();
+		lock.lock();
+	}
+}
+
+void spill_manager::remove_orphan_segments(const std::vector<std::string> & directories) {
+	std::regex segment_name("\\.blazing-temp-.*-segment-([0-9]+)-[0-9]+");
+	for (const auto & directory : directories) {
+		DIR * dir = opendir(directory.c_str());
+		if (dir == nullptr) {
+			continue;
+		}
+		while (struct dirent * entry = readdir(dir)) {
+			std::string name = entry->d_name;
+			std::smatch match;
+			if (!std::regex_match(name, match, segment_name)) {
+				continue;
+			}
+			pid_t pid = std::stoi(match[1].str());
+			if (pid != getpid() && kill(pid, 0) == -1 && errno == ESRCH) {
+				unlink((directory + "/" + name).c_str());
+			}
+		}
+		closedir(dir);
+	}
+}
+
+} // namespace cache
+} // namespace ral
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ral {
+namespace cache {
+
+/**
+* A preallocated file of the spill_manager, whose extents hold the spills of a query in a directory of the disk tier.
+* The file is closed once the segment is destroyed, which is after the last of its extents was released. A segment
+* whose query finished is unlinked before that, so its file is only reachable by the extents that still use it.
+*/
+struct spill_segment {
+	~spill_segment();
+
+	int fd = -1;
+	std::string path;
+	std::string directory;
+	std::string ctx_token;
+	std::size_t size = 0;
+	std::size_t allocated_bytes = 0; // the bytes of the extents in use, guarded by the mutex of the spill_manager
+	std::map<std::size_t, std::size_t> free_extents; // the size of the free extents by their offset, guarded likewise
+	bool unlinked = false;
+};
+
+/**
+* The space of a spill, size bytes at offset in the file of its segment.
+*/
+struct spill_extent {
+	std::shared_ptr<spill_segment> segment;
+	std::size_t offset = 0;
+	std::size_t size = 0;
+};
+
+/**
+* Gives the spills of the disk tier their space out of large segment files, instead of a file of their own each, so
+* that queries that spill a lot do not create and remove a file for every spill, which on shared filesystems stalls
+* on their metadata. The segments are preallocated with posix_fallocate when they are made, and belong to a
+* directory and a query. The spills of the query take the first free extent that fits them, and a new segment of
+* SPILL_SEGMENT_BYTES (or of the spill when it is larger) is made when none does.
+*
+* The extents that are released go back to the free extents of their segments on a thread of its own, so that decache
+* does not wait for it, and the segments of a query are unlinked by that thread too once the query finished.
+* The segments are named .blazing-temp-<ctx_token>-segment-<pid>-<n>, so that the ones of a process that crashed are
+* removed by remove_orphan_segments when the next one starts, as well as by remove_orc_files_from_disk in pyblazing.
+*/
+class spill_manager {
+public:
+	static spill_manager & get_instance();
+
+	~spill_manager();
+
+	/**
+	* @param segment_bytes the size of the segments, 0 makes every spill write a file of its own.
+	*/
+	void configure(std::size_t segment_bytes);
+
+	bool is_enabled();
+
+	/**
+	* @return an extent of at least bytes in a segment of the query in the directory.
+	* @throws std::runtime_error if a new segment was needed and could not be made, like when the disk is full.
+	*/
+	spill_extent allocate(const std::string & directory, const std::string & ctx_token, std::size_t bytes);
+
+	/**
+	* Gives the extent back. It can be taken again once the reclaim thread got to it.
+	*/
+	void release(spill_extent extent);
+
+	/**
+	* Unlinks the segments of the query, the ones whose extents are still in use once they are released.
+	*/
+	void finish_query(const std::string & ctx_token);
+
+	/**
+	* Removes the segment files of the processes that are not running anymore.
+	*/
+	void remove_orphan_segments(const std::vector<std::string> & directories);
+
+private:
+	spill_manager() = default;
+
+	// takes an extent of bytes from the free extents of the segment, or returns false if none is large enough
+	bool take_extent(const std::shared_ptr<spill_segment> & segment, std::size_t bytes, spill_extent & extent);
+
+	std::shared_ptr<spill_segment> create_segment(const std::string & directory, const std::string & ctx_token, std::size_t size);
+
+	void reclaim();
+
+	std::mutex mutex;
+	std::condition_variable reclaim_cv;
+	std::size_t segment_bytes = 0;
+	std::size_t next_segment_id = 0;
+	std::map<std::pair<std::string, std::string>, std::vector<std::shared_ptr<spill_segment>>> segments; // by directory and query
+	std::deque<spill_extent> released_extents;
+	std::deque<std::shared_ptr<spill_segment>> segments_to_unlink;
+	std::thread reclaim_thread; // started with the first segment
+	bool stopping = false;
+};
+
+} // namespace cache
+} // namespace ral
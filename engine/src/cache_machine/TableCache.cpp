@@ -0,0 +1,351 @@
+#include "TableCache.h"
+#include "GPUCacheData.h"
+#include "parser/CalciteExpressionParsing.h"
+
+#include <algorithm>
+#include <cudf/copying.hpp>
+#include <cudf/utilities/traits.hpp>
+
+namespace ral {
+namespace cache {
+
+// BEGIN cached_table
+
+namespace {
+
+// whether a literal of this type can be made a scalar of the type of the keys without changing what it compares with
+bool is_comparable_literal(cudf::data_type literal_type, cudf::data_type key_type) {
+	if (literal_type == key_type) {
+		return true;
+	}
+	if (cudf::is_integral(key_type) && cudf::is_integral(literal_type)) {
+		return true;
+	}
+	if (cudf::is_floating_point(key_type) && (cudf::is_integral(literal_type) || cudf::is_floating_point(literal_type))) {
+		return true;
+	}
+	return cudf::is_timestamp(key_type) && cudf::is_timestamp(literal_type);
+}
+
+void build_indexes(const ral::frame::BlazingTableView & batch, const std::vector<int> & column_indices,
+	const std::vector<int> & index_column_indices, std::map<int, std::unique_ptr<sorted_key_index>> & indexes) {
+	for (int index_column_index : index_column_indices) {
+		auto it = std::find(column_indices.begin(), column_indices.end(), index_column_index);
+		if (it != column_indices.end()) {
+			indexes[index_column_index] = std::make_unique<sorted_key_index>(batch.view().column(std::distance(column_indices.begin(), it)));
+		}
+	}
+}
+
+std::size_t get_indexes_bytes(const std::map<int, std::unique_ptr<sorted_key_index>> & indexes) {
+	std::size_t indexes_bytes = 0;
+	for (auto & index : indexes) {
+		indexes_bytes += index.second->sizeInBytes();
+	}
+	return indexes_bytes;
+}
+
+} // namespace
+
+cached_table::cached_table(const std::string & table_name, const std::vector<int> & column_indices, const std::vector<int> & index_column_indices)
+	: table_name(table_name), column_indices(column_indices), index_column_indices(index_column_indices) {}
+
+void cached_table::add_batch(std::unique_ptr<ral::frame::BlazingTable> table) {
+	// the indexes are kept up to date as the batches are added
+	std::map<int, std::unique_ptr<sorted_key_index>> indexes;
+	build_indexes(table->toBlazingTableView(), column_indices, index_column_indices, indexes);
+	std::size_t table_bytes = table->sizeInBytes() + get_indexes_bytes(indexes);
+	std::size_t table_rows = table->num_rows();
+	auto batch = std::make_unique<GPUCacheData>(std::move(table), MetadataDictionary(), table_bytes);
+	std::lock_guard<std::mutex> lock(mutex_);
+	batches.push_back(std::move(batch));
+	batch_indexes.push_back(std::move(indexes));
+	bytes += table_bytes;
+	rows += table_rows;
+}
+
+std::vector<cudf::size_type> cached_table::get_positions(const std::vector<int> & wanted_column_indices) const {
+	std::vector<cudf::size_type> positions;
+	for (int column_index : wanted_column_indices) {
+		auto it = std::find(column_indices.begin(), column_indices.end(), column_index);
+		RAL_EXPECTS(it != column_indices.end(), "ERROR: cached_table::get_batch the column is not cached");
+		positions.push_back(std::distance(column_indices.begin(), it));
+	}
+	return positions;
+}
+
+void cached_table::load_batch(std::size_t index) {
+	RAL_EXPECTS(index < batches.size(), "ERROR: cached_table::get_batch the batch does not exist");
+	if (batches[index]->get_type() != CacheDataType::GPU) {
+		std::unique_ptr<ral::frame::BlazingTable> table = batches[index]->decache();
+		build_indexes(table->toBlazingTableView(), column_indices, index_column_indices, batch_indexes[index]);
+		std::size_t table_bytes = table->sizeInBytes() + get_indexes_bytes(batch_indexes[index]);
+		batches[index] = std::make_unique<GPUCacheData>(std::move(table), MetadataDictionary(), table_bytes);
+	}
+}
+
+std::unique_ptr<ral::frame::BlazingTable> cached_table::get_batch(std::size_t index, const std::vector<int> & wanted_column_indices) {
+	std::vector<cudf::size_type> positions = get_positions(wanted_column_indices);
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	load_batch(index);
+	ral::frame::BlazingTableView view = static_cast<GPUCacheData &>(*batches[index]).getTableView();
+	std::vector<std::string> names;
+	std::vector<std::string> cached_names = view.names();
+	for (cudf::size_type position : positions) {
+		names.push_back(cached_names[position]);
+	}
+	return ral::frame::BlazingTableView(view.view().select(positions), names).clone();
+}
+
+std::unique_ptr<ral::frame::BlazingTable> cached_table::get_batch(std::size_t index, const std::vector<int> & wanted_column_indices,
+	int key_column_index, const std::vector<literal_range> & ranges) {
+	std::vector<cudf::size_type> positions = get_positions(wanted_column_indices);
+
+	std::unique_lock<std::mutex> lock(mutex_);
+	load_batch(index);
+	auto index_it = batch_indexes[index].find(key_column_index);
+	if (index_it == batch_indexes[index].end()) {
+		lock.unlock();
+		return get_batch(index, wanted_column_indices);
+	}
+	const sorted_key_index & key_index = *index_it->second;
+
+	std::vector<key_range> key_ranges;
+	try {
+		for (const literal_range & range : ranges) {
+			if (!is_comparable_literal(range.type, key_index.key_type())) {
+				lock.unlock();
+				return get_batch(index, wanted_column_indices);
+			}
+			key_range key_range;
+			if (range.has_lower) {
+				key_range.lower = get_scalar_from_string(range.lower, key_index.key_type());
+				key_range.lower_inclusive = range.lower_inclusive;
+			}
+			if (range.has_upper) {
+				key_range.upper = get_scalar_from_string(range.upper, key_index.key_type());
+				key_range.upper_inclusive = range.upper_inclusive;
+			}
+			key_ranges.push_back(std::move(key_range));
+		}
+	} catch (const std::exception &) {
+		// a literal that does not fit in the type of the keys is left to the filter
+		lock.unlock();
+		return get_batch(index, wanted_column_indices);
+	}
+
+	std::unique_ptr<cudf::column> rows = key_index.lookup(key_ranges);
+	ral::frame::BlazingTableView view = static_cast<GPUCacheData &>(*batches[index]).getTableView();
+	std::vector<std::string> names;
+	std::vector<std::string> cached_names = view.names();
+	for (cudf::size_type position : positions) {
+		names.push_back(cached_names[position]);
+	}
+	return std::make_unique<ral::frame::BlazingTable>(cudf::gather(view.view().select(positions), rows->view()), names);
+}
+
+bool cached_table::has_columns(const std::vector<int> & wanted_column_indices) const {
+	return std::all_of(wanted_column_indices.begin(), wanted_column_indices.end(), [this](int column_index) {
+		return std::find(column_indices.begin(), column_indices.end(), column_index) != column_indices.end();
+	});
+}
+
+bool cached_table::has_index(int column_index) const {
+	return std::find(index_column_indices.begin(), index_column_indices.end(), column_index) != index_column_indices.end() &&
+		std::find(column_indices.begin(), column_indices.end(), column_index) != column_indices.end();
+}
+
+std::size_t cached_table::downgrade(std::size_t bytes_wanted, std::shared_ptr<Context> context, SpillFormat spill_format) {
+	std::size_t bytes_downgraded = 0;
+	std::lock_guard<std::mutex> lock(mutex_);
+	for (int i = batches.size() - 1; i >= 0 && bytes_downgraded < bytes_wanted; i--) {
+		if (batches[i]->get_type() == CacheDataType::GPU && !static_cast<GPUCacheData &>(*batches[i]).is_host_advised()) {
+			// the indexes are rebuilt when the batch is read again
+			bytes_downgraded += batches[i]->sizeInBytes();
+			batch_indexes[i].clear();
+			batches[i] = CacheData::downgradeCacheData(std::move(batches[i]), "", context, spill_format);
+		}
+	}
+	return bytes_downgraded;
+}
+
+std::size_t cached_table::num_batches() {
+	std::lock_guard<std::mutex> lock(mutex_);
+	return batches.size();
+}
+
+std::size_t cached_table::num_rows() {
+	std::lock_guard<std::mutex> lock(mutex_);
+	return rows;
+}
+
+std::size_t cached_table::get_bytes() {
+	std::lock_guard<std::mutex> lock(mutex_);
+	return bytes;
+}
+
+std::size_t cached_table::get_gpu_bytes() {
+	std::size_t gpu_bytes = 0;
+	std::lock_guard<std::mutex> lock(mutex_);
+	for (auto & batch : batches) {
+		if (batch->get_type() == CacheDataType::GPU && !static_cast<GPUCacheData &>(*batch).is_host_advised()) {
+			gpu_bytes += batch->sizeInBytes();
+		}
+	}
+	return gpu_bytes;
+}
+
+// END cached_table
+
+// BEGIN table_cache_fill
+
+table_cache_fill::table_cache_fill(const std::string & key, std::shared_ptr<cached_table> table, const std::vector<int> & positions,
+	std::size_t max_bytes)
+	: key(key), table(table), positions(positions.begin(), positions.end()), max_bytes(max_bytes) {}
+
+void table_cache_fill::add(const ral::frame::BlazingTableView & batch) {
+	std::shared_ptr<cached_table> filling_table;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (abandoned) {
+			return;
+		}
+		filling_table = table;
+	}
+	std::vector<std::string> names;
+	std::vector<std::string> batch_names = batch.names();
+	for (cudf::size_type position : positions) {
+		names.push_back(batch_names[position]);
+	}
+	filling_table->add_batch(ral::frame::BlazingTableView(batch.view().select(positions), names).clone());
+	// a table that will not fit is not kept growing
+	if (filling_table->get_bytes() > max_bytes) {
+		abandon();
+	}
+}
+
+void table_cache_fill::abandon() {
+	std::lock_guard<std::mutex> lock(mutex_);
+	abandoned = true;
+	table = nullptr;
+}
+
+bool table_cache_fill::finish() {
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (abandoned || table->num_batches() == 0) {
+		return false;
+	}
+	abandoned = true; // it is only put once
+	return table_cache::get_instance().put(key, table, max_bytes);
+}
+
+// END table_cache_fill
+
+// BEGIN table_cache
+
+std::shared_ptr<cached_table> table_cache::get(const std::string & key) {
+	std::lock_guard<std::mutex> lock(mutex_);
+	auto it = entries.find(key);
+	if (it == entries.end()) {
+		return nullptr;
+	}
+	lru_order.splice(lru_order.begin(), lru_order, it->second.lru_position);
+	return it->second.table;
+}
+
+bool table_cache::put(const std::string & key, std::shared_ptr<cached_table> table, std::size_t max_bytes) {
+	if (table == nullptr || table->get_bytes() > max_bytes) {
+		return false;
+	}
+
+	// the dropped tables are freed outside of the lock. Queries that are reading them keep them alive until they are done
+	std::vector<std::shared_ptr<cached_table>> dropped_tables;
+	std::lock_guard<std::mutex> lock(mutex_);
+	auto it = entries.find(key);
+	if (it != entries.end()) {
+		total_bytes -= it->second.table->get_bytes();
+		lru_order.erase(it->second.lru_position);
+		dropped_tables.push_back(std::move(it->second.table));
+		entries.erase(it);
+	}
+	while (!lru_order.empty() && total_bytes + table->get_bytes() > max_bytes) {
+		auto least_recently_used = entries.find(lru_order.back());
+		total_bytes -= least_recently_used->second.table->get_bytes();
+		dropped_tables.push_back(std::move(least_recently_used->second.table));
+		entries.erase(least_recently_used);
+		lru_order.pop_back();
+	}
+
+	lru_order.push_front(key);
+	total_bytes += table->get_bytes();
+	entries[key] = entry{std::move(table), lru_order.begin()};
+	return true;
+}
+
+void table_cache::remove_table(const std::string & table_name) {
+	std::vector<std::shared_ptr<cached_table>> dropped_tables;
+	std::lock_guard<std::mutex> lock(mutex_);
+	for (auto it = entries.begin(); it != entries.end();) {
+		if (it->second.table->get_table_name() == table_name) {
+			total_bytes -= it->second.table->get_bytes();
+			lru_order.erase(it->second.lru_position);
+			dropped_tables.push_back(std::move(it->second.table));
+			it = entries.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
+
+std::size_t table_cache::downgrade(std::size_t bytes_wanted, std::shared_ptr<Context> context, SpillFormat spill_format) {
+	std::vector<std::shared_ptr<cached_table>> tables;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		for (auto it = lru_order.rbegin(); it != lru_order.rend(); ++it) {
+			tables.push_back(entries[*it].table);
+		}
+	}
+
+	// the batches are spilled outside of the lock, so that the scans can keep finding the tables
+	std::size_t bytes_downgraded = 0;
+	for (auto & table : tables) {
+		if (bytes_downgraded >= bytes_wanted) {
+			break;
+		}
+		bytes_downgraded += table->downgrade(bytes_wanted - bytes_downgraded, context, spill_format);
+	}
+	return bytes_downgraded;
+}
+
+void table_cache::clear() {
+	std::map<std::string, entry> dropped_entries;
+	std::lock_guard<std::mutex> lock(mutex_);
+	dropped_entries.swap(entries);
+	lru_order.clear();
+	total_bytes = 0;
+}
+
+std::size_t table_cache::get_total_bytes() {
+	std::lock_guard<std::mutex> lock(mutex_);
+	return total_bytes;
+}
+
+std::size_t table_cache::get_gpu_bytes() {
+	std::size_t gpu_bytes = 0;
+	std::lock_guard<std::mutex> lock(mutex_);
+	for (auto & key_entry : entries) {
+		gpu_bytes += key_entry.second.table->get_gpu_bytes();
+	}
+	return gpu_bytes;
+}
+
+std::size_t table_cache::size() {
+	std::lock_guard<std::mutex> lock(mutex_);
+	return entries.size();
+}
+
+// END table_cache
+
+}  // namespace cache
+}  // namespace ral
@@ -0,0 +1,205 @@
+#pragma once
+
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "CacheData.h"
+#include "TableIndex.h"
+#include "parser/expression_utils.hpp"
+
+namespace ral {
+namespace cache {
+
+/**
+* The batches of a table that was decoded once, kept for the scans of the next queries. Every batch has the cached
+* columns of the table, in the order of get_column_indices(). The batches start in GPU memory and are spilled to host
+* memory or to disk like the data of the caches of a query, see table_cache::downgrade. Every batch can have a
+* sorted_key_index of some of the cached columns, which is built when the batch is added and dropped while the batch is
+* spilled.
+*/
+class cached_table {
+public:
+	/**
+	* @param table_name the name the table was created with, see table_cache::remove_table.
+	* @param column_indices the calcite indices of the cached columns.
+	* @param index_column_indices the calcite indices of the cached columns that are indexed.
+	*/
+	cached_table(const std::string & table_name, const std::vector<int> & column_indices,
+		const std::vector<int> & index_column_indices = std::vector<int>());
+
+	/**
+	* Adds a batch with the cached columns. Only the scan that decodes the table adds batches, before it is put into
+	* the table_cache.
+	*/
+	void add_batch(std::unique_ptr<ral::frame::BlazingTable> table);
+
+	/**
+	* Get a copy of some of the columns of a batch. A batch that was spilled is brought back into GPU memory, since the
+	* table is being read again.
+	* @param index the index of the batch.
+	* @param column_indices the calcite indices of the wanted columns, all of them have to be cached.
+	*/
+	std::unique_ptr<ral::frame::BlazingTable> get_batch(std::size_t index, const std::vector<int> & column_indices);
+
+	/**
+	* Get a copy of some of the columns of the rows of a batch whose key is in any of some ranges, found with the index
+	* of the key column. All the rows are given when the key column is not indexed or the literals of the ranges can't be
+	* compared with its keys.
+	* @param key_column_index the calcite index of the key column.
+	* @param ranges the ranges of the keys.
+	*/
+	std::unique_ptr<ral::frame::BlazingTable> get_batch(std::size_t index, const std::vector<int> & column_indices,
+		int key_column_index, const std::vector<literal_range> & ranges);
+
+	/**
+	* Whether all these columns are cached.
+	*/
+	bool has_columns(const std::vector<int> & column_indices) const;
+
+	/**
+	* Whether the batches have an index of this column.
+	*/
+	bool has_index(int column_index) const;
+
+	/**
+	* Moves the batches in GPU memory to host memory, or to disk when the host tier is full, the last batches first.
+	* @param bytes_wanted it stops once it moved this many bytes.
+	* @return the number of GPU bytes that were moved.
+	*/
+	std::size_t downgrade(std::size_t bytes_wanted, std::shared_ptr<Context> context, SpillFormat spill_format);
+
+	std::string get_table_name() const { return table_name; }
+	std::vector<int> get_column_indices() const { return column_indices; }
+	std::size_t num_batches();
+	std::size_t num_rows();
+	std::size_t get_bytes();
+	std::size_t get_gpu_bytes();
+
+private:
+	/**
+	* Brings a batch back into GPU memory and rebuilds its indexes, when it was spilled. The mutex has to be locked.
+	*/
+	void load_batch(std::size_t index);
+
+	/**
+	* The positions of some cached columns in the batches.
+	*/
+	std::vector<cudf::size_type> get_positions(const std::vector<int> & wanted_column_indices) const;
+
+	std::string table_name;
+	std::vector<int> column_indices;
+	std::vector<int> index_column_indices;
+	std::mutex mutex_;
+	std::vector<std::unique_ptr<CacheData>> batches;
+	std::vector<std::map<int, std::unique_ptr<sorted_key_index>>> batch_indexes; /**< The indexes of every batch, by calcite index. */
+	std::size_t bytes = 0; /**< The size of all the batches and their indexes when they are in GPU memory. */
+	std::size_t rows = 0;
+};
+
+/**
+* Fills a cached_table with the batches a scan reads, and puts it into the table_cache once the scan read all of them.
+* It is thread safe, the tasks of the scan add their batches concurrently.
+*/
+class table_cache_fill {
+public:
+	/**
+	* @param key the key of the table in the table_cache.
+	* @param table the table to fill.
+	* @param positions the positions of the cached columns in the batches of the scan.
+	* @param max_bytes the size limit of the table_cache.
+	*/
+	table_cache_fill(const std::string & key, std::shared_ptr<cached_table> table, const std::vector<int> & positions, std::size_t max_bytes);
+
+	/**
+	* Copies the cached columns of a batch of the scan.
+	*/
+	void add(const ral::frame::BlazingTableView & batch);
+
+	/**
+	* Drops what was copied so far, when the scan does not read all the data of the table.
+	*/
+	void abandon();
+
+	/**
+	* Puts the table into the table_cache, unless it was abandoned.
+	* @return true if the table was added.
+	*/
+	bool finish();
+
+private:
+	std::string key;
+	std::shared_ptr<cached_table> table;
+	std::vector<cudf::size_type> positions;
+	std::size_t max_bytes;
+	std::mutex mutex_;
+	bool abandoned = false;
+};
+
+/**
+* The tables that were cached with cache_table, kept across queries. Every table is keyed by its name, the version of
+* its files, the types of its columns and the columns that are cached, so that it is not found anymore once its files
+* change. When the GPU memory goes over its limit the cached tables are spilled after the caches of the queries that are
+* running, since those are about to be consumed, see MemoryMonitor. The least recently used tables are dropped when
+* the cache grows beyond its size limit.
+* @note Myers' singleton.
+*/
+class table_cache {
+public:
+	static table_cache & get_instance() {
+		static table_cache instance;
+		return instance;
+	}
+
+	table_cache(table_cache &&) = delete;
+	table_cache(const table_cache &) = delete;
+	table_cache & operator=(table_cache &&) = delete;
+	table_cache & operator=(const table_cache &) = delete;
+
+	/**
+	* Get a cached table, which becomes the most recently used one.
+	* @return the table or nullptr if it is not cached.
+	*/
+	std::shared_ptr<cached_table> get(const std::string & key);
+
+	/**
+	* Adds a table, dropping the least recently used tables until it fits.
+	* @param max_bytes the size limit of the whole cache. A table bigger than this is not added.
+	* @return true if the table was added.
+	*/
+	bool put(const std::string & key, std::shared_ptr<cached_table> table, std::size_t max_bytes);
+
+	/**
+	* Drops all the cached versions of a table.
+	*/
+	void remove_table(const std::string & table_name);
+
+	/**
+	* Spills the GPU batches of the least recently used tables first.
+	* @return the number of GPU bytes that were moved.
+	*/
+	std::size_t downgrade(std::size_t bytes_wanted, std::shared_ptr<Context> context, SpillFormat spill_format);
+
+	void clear();
+	std::size_t get_total_bytes();
+	std::size_t get_gpu_bytes();
+	std::size_t size();
+
+private:
+	table_cache() = default;
+
+	struct entry {
+		std::shared_ptr<cached_table> table;
+		std::list<std::string>::iterator lru_position;
+	};
+
+	std::mutex mutex_;
+	std::map<std::string, entry> entries;
+	std::list<std::string> lru_order; /**< The keys from the most to the least recently used. */
+	std::size_t total_bytes = 0;
+};
+
+}  // namespace cache
+}  // namespace ral
@@ -0,0 +1,73 @@
+#include "TableIndex.h"
+
+#include <set>
+#include <utility>
+#include <cudf/column/column_factories.hpp>
+#include <cudf/concatenate.hpp>
+#include <cudf/copying.hpp>
+#include <cudf/search.hpp>
+#include <cudf/sorting.hpp>
+#include <cudf/table/table_view.hpp>
+#include "execution_kernels/LogicPrimitives.h"
+#include "utilities/CommonOperations.h"
+
+namespace ral {
+namespace cache {
+
+namespace {
+
+// the position that a search of one bound gives
+cudf::size_type get_bound_position(const cudf::table_view & sorted_keys, const cudf::scalar & bound, bool is_lower) {
+	std::unique_ptr<cudf::column> bound_column = cudf::make_column_from_scalar(bound, 1);
+	cudf::table_view bound_view{{bound_column->view()}};
+	std::unique_ptr<cudf::column> position = is_lower ?
+		cudf::lower_bound(sorted_keys, bound_view, {cudf::order::ASCENDING}, {cudf::null_order::AFTER}) :
+		cudf::upper_bound(sorted_keys, bound_view, {cudf::order::ASCENDING}, {cudf::null_order::AFTER});
+	return ral::utilities::column_to_vector<cudf::size_type>(position->view())[0];
+}
+
+} // namespace
+
+sorted_key_index::sorted_key_index(const cudf::column_view & keys) {
+	cudf::table_view keys_view{{keys}};
+	sorted_order = cudf::sorted_order(keys_view, {cudf::order::ASCENDING}, {cudf::null_order::AFTER});
+	sorted_keys = std::move(cudf::gather(keys_view, sorted_order->view())->release()[0]);
+	num_valid_keys = keys.size() - keys.null_count();
+}
+
+std::unique_ptr<cudf::column> sorted_key_index::lookup(const std::vector<key_range> & ranges) const {
+	cudf::table_view sorted_keys_view{{sorted_keys->view()}};
+
+	// the ranges of equalities of the same value find the same rows, so the positions are only taken once
+	std::set<std::pair<cudf::size_type, cudf::size_type>> spans;
+	for (const key_range & range : ranges) {
+		// the lower bound is the first key above it, and the upper bound the first key after the last one below it
+		cudf::size_type start = range.lower ? get_bound_position(sorted_keys_view, *range.lower, range.lower_inclusive) : 0;
+		cudf::size_type end = range.upper ? get_bound_position(sorted_keys_view, *range.upper, !range.upper_inclusive) : num_valid_keys;
+		end = std::min(end, num_valid_keys);
+		if (start < end) {
+			spans.emplace(start, end);
+		}
+	}
+	if (spans.empty()) {
+		return cudf::make_empty_column(cudf::data_type{cudf::type_to_id<cudf::size_type>()});
+	}
+
+	std::vector<cudf::size_type> slice_indices;
+	for (auto & span : spans) {
+		slice_indices.push_back(span.first);
+		slice_indices.push_back(span.second);
+	}
+	std::vector<cudf::column_view> row_slices = cudf::slice(sorted_order->view(), slice_indices);
+	std::unique_ptr<cudf::column> rows = row_slices.size() == 1 ? std::make_unique<cudf::column>(row_slices[0]) : cudf::concatenate(row_slices);
+	// the rows are given in the order they have in the batch
+	return std::move(cudf::sort(cudf::table_view{{rows->view()}})->release()[0]);
+}
+
+std::size_t sorted_key_index::sizeInBytes() const {
+	ral::frame::BlazingTableView keys_view(cudf::table_view{{sorted_keys->view()}}, {"key"});
+	return keys_view.sizeInBytes() + sorted_order->size() * sizeof(cudf::size_type);
+}
+
+}  // namespace cache
+}  // namespace ral
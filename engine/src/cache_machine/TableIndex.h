@@ -0,0 +1,49 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <cudf/column/column.hpp>
+#include <cudf/scalar/scalar.hpp>
+
+namespace ral {
+namespace cache {
+
+/**
+* The keys a lookup in a sorted_key_index reads. A side without a bound is open.
+*/
+struct key_range {
+	std::unique_ptr<cudf::scalar> lower; /**< Has the type of the keys, nullptr when the lower side is open. */
+	bool lower_inclusive = true;
+	std::unique_ptr<cudf::scalar> upper; /**< Has the type of the keys, nullptr when the upper side is open. */
+	bool upper_inclusive = true;
+};
+
+/**
+* An index of a column of a batch in GPU memory: its keys in ascending order, and the row of every one of them. The
+* rows whose keys are in a range are found with a binary search of its bounds, instead of evaluating a filter on every
+* row. The null keys are last and are never in a range.
+*/
+class sorted_key_index {
+public:
+	/**
+	* @param keys the column that is indexed.
+	*/
+	sorted_key_index(const cudf::column_view & keys);
+
+	/**
+	* Get the rows whose keys are in any of the ranges.
+	* @return the indices of the rows, in ascending order and without repeated rows.
+	*/
+	std::unique_ptr<cudf::column> lookup(const std::vector<key_range> & ranges) const;
+
+	cudf::data_type key_type() const { return sorted_keys->type(); }
+	std::size_t sizeInBytes() const;
+
+private:
+	std::unique_ptr<cudf::column> sorted_keys;
+	std::unique_ptr<cudf::column> sorted_order; /**< The row of every one of the sorted keys. */
+	cudf::size_type num_valid_keys;
+};
+
+}  // namespace cache
+}  // namespace ral
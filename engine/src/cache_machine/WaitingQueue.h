@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <atomic>
 #include <deque>
 #include <memory>
@@ -8,9 +9,13 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <unordered_map>
 
 #include <spdlog/spdlog.h>
 #include <exception>
+#include <functional>
+
+#include "execution_graph/kernel_run_pool.h"
 
 using namespace std::chrono_literals;
 
@@ -28,6 +33,8 @@ using namespace fmt::literals;
 * queue when they exist and wait for things when they don't without consuming
 * many compute resources.This is accomplished through the use of a
 * condition_variable and mutex locks.
+* The ids of the messages in the queue are indexed, so that checking if a
+* message exists does not need to scan the whole queue.
 */
 template <typename message_ptr>
 class WaitingQueue {
@@ -84,6 +91,14 @@ public:
 		condition_variable_.notify_all();
 	}
 
+	/**
+	* Wakes up the threads waiting for this queue, so that they check again the stop conditions of their waits.
+	*/
+	void notify_waiters() {
+		std::unique_lock<std::mutex> lock(mutex_);
+		condition_variable_.notify_all();
+	}
+
 	/**
 	* Lets us know if a WaitingQueue has finished running messages.
 	* @return A bool indicating whether or not this WaitingQueue is finished.
@@ -105,7 +120,8 @@ public:
 		CodeTimer blazing_timer;
 		std::unique_lock<std::mutex> lock(mutex_);
 		while(!condition_variable_.wait_for(lock, timeout*1ms, [&, this] {
-				bool done_waiting = count == this->processed;
+				// the wait also ends when the queue is finished, as when its query is cancelled
+				bool done_waiting = count == this->processed || this->finished.load(std::memory_order_seq_cst);
 				if (!done_waiting && blazing_timer.elapsed_time() > 59000 && this->log_timeout){
                     std::shared_ptr<spdlog::logger> logger = spdlog::get("batch_logger");
 					if(logger) {
@@ -157,12 +173,7 @@ public:
 		// condition_variable_.wait(lock,[&, this] {
 		// 		return this->finished.load(std::memory_order_seq_cst) or !this->empty();
 		// });
-		if(this->message_queue_.size() == 0) {
-			return nullptr;
-		}
-		auto data = std::move(this->message_queue_.front());
-		this->message_queue_.pop_front();
-		return std::move(data);
+		return pop_unsafe();
 	}
 
 	/**
@@ -177,6 +188,8 @@ public:
 		}
 		auto data = std::move(this->message_queue_.back());
 		this->message_queue_.pop_back();
+		unindex_message(data);
+		condition_variable_.notify_all();
 		return std::move(data);
 	}
 
@@ -277,6 +290,31 @@ public:
 			})){}
 	}
 
+	/**
+	* Waits until the messages in the WaitingQueue add up to at most a certain number of bytes.
+	* Producers use it for flow control, so that they do not get too far ahead of
+	* the consumers of the WaitingQueue. It returns right away if the WaitingQueue is finished.
+	* @param num_bytes The number of bytes that the WaitingQueue can hold before it stops waiting.
+	* @param max_wait_ms The max time to wait in ms.
+	* @return false if it stopped waiting because max_wait_ms expired.
+	*/
+	bool wait_until_num_bytes_below(size_t num_bytes, int max_wait_ms, std::function<bool()> stop = nullptr) {
+		std::unique_lock<std::mutex> lock(mutex_);
+		return condition_variable_.wait_for(lock, max_wait_ms*1ms, [num_bytes, &stop, this] {
+				if (this->finished.load(std::memory_order_seq_cst) || (stop && stop())) {
+					return true;
+				}
+				size_t total_bytes = 0;
+				for (auto & message : message_queue_){
+					total_bytes += message->get_data().sizeInBytes();
+					if (total_bytes > num_bytes) {
+						return false;
+					}
+				}
+				return true;
+			});
+	}
+
 	/**
 	* Let's us know the size of the next CacheData to be pulled.
 	* Sometimes it is useful to know how much data we will be pulling in each
@@ -301,18 +339,15 @@ public:
 	* finished. If WaitingQueue is finished and there are no messages we get
 	* a nullptr.
 	* @param message_id The id of the message that we want to get or wait for.
+	* @param stop If given, the wait also ends with a nullptr when it returns true. It is checked when notify_waiters is called.
 	* @return The message that has this id or nullptr if that message will  never
 	* be able to arrive because the WaitingQueue is finished.
 	*/
-	message_ptr get_or_wait(std::string message_id) {
+	message_ptr get_or_wait(std::string message_id, std::function<bool()> stop = nullptr) {
 		CodeTimer blazing_timer;
 		std::unique_lock<std::mutex> lock(mutex_);
-		while(!condition_variable_.wait_for(lock, timeout*1ms, [message_id, &blazing_timer, this] {
-				auto result = std::any_of(this->message_queue_.cbegin(),
-							this->message_queue_.cend(), [&](auto &e) {
-								return e->get_message_id() == message_id;
-							});
-				bool done_waiting = this->finished.load(std::memory_order_seq_cst) or result;
+		while(!condition_variable_.wait_for(lock, timeout*1ms, [&message_id, &blazing_timer, &stop, this] {
+				bool done_waiting = this->finished.load(std::memory_order_seq_cst) or this->has_message_unsafe(message_id) or (stop && stop());
 				if (!done_waiting && blazing_timer.elapsed_time() > 59000 && this->log_timeout){
                     std::shared_ptr<spdlog::logger> logger = spdlog::get("batch_logger");
 					if(logger) {
@@ -326,17 +361,12 @@ public:
 			})){
 
 			}
-		if(this->message_queue_.size() == 0) {
+		if(!this->has_message_unsafe(message_id)) {
 			return nullptr;
 		}
-		while (true){
-			auto data = this->pop_unsafe();
-			if (data->get_message_id() == message_id){
-				return std::move(data);
-			} else {
-				putWaitingQueue(std::move(data));
-			}
-		}
+		return remove_first_unsafe([&message_id](const message_ptr & e) {
+			return e->get_message_id() == message_id;
+		});
 	}
 
 	/**
@@ -356,12 +386,9 @@ public:
 		while(!condition_variable_.wait_for(lock, timeout*1ms, [messages, &blazing_timer, this] {
 				bool found = false;
 				std::string message_id;
-				for (int i = 0; i < messages.size(); i++){
+				for (size_t i = 0; i < messages.size(); i++){
 					message_id = messages[i];
-					found = std::any_of(this->message_queue_.cbegin(),
-								this->message_queue_.cend(), [&](auto &e) {
-									return e->get_message_id() == message_id;
-								});
+					found = this->has_message_unsafe(message_id);
 					if (found){
 						break;
 					}
@@ -381,17 +408,24 @@ public:
 			})){
 
 			}
-		if(this->message_queue_.size() == 0) {
+		if(std::none_of(messages.begin(), messages.end(), [this](const std::string & message_id) { return this->has_message_unsafe(message_id); })) {
 			return nullptr;
 		}
-		while (true){
-			auto data = this->pop_unsafe();
-			if (std::find(messages.begin(), messages.end(), data->get_message_id()) != messages.end()){
-				return std::move(data);
-			} else {
-				putWaitingQueue(std::move(data));
-			}
-		}
+		return remove_first_unsafe([&messages](const message_ptr & e) {
+			return std::find(messages.begin(), messages.end(), e->get_message_id()) != messages.end();
+		});
+	}
+
+	/**
+	* Indicates if all of a set of messages are in the WaitingQueue at this point in time.
+	* @param messages A vector of the ids of the messages we are looking for.
+	* @return A bool which is true if there is a message for every id.
+	*/
+	bool has_messages_now(const std::vector<std::string> & messages) {
+		std::unique_lock<std::mutex> lock(mutex_);
+		return std::all_of(messages.begin(), messages.end(), [this](const std::string & message_id) {
+			return this->has_message_unsafe(message_id);
+		});
 	}
 
 	/**
@@ -406,6 +440,8 @@ public:
 		}
 		auto data = std::move(this->message_queue_.front());
 		this->message_queue_.pop_front();
+		unindex_message(data);
+		condition_variable_.notify_all(); // for the producers waiting in wait_until_num_bytes_below
 		return std::move(data);
 	}
 
@@ -474,6 +510,8 @@ public:
 			messages.emplace_back(std::move(it));
 		}
 		message_queue_.clear();
+		message_id_counts_.clear();
+		condition_variable_.notify_all();
 		return messages;
 	}
 
@@ -507,14 +545,52 @@ private:
 	* @param item The message to add to the WaitingQueue.
 	*/
 
-	void putWaitingQueue(message_ptr item) { message_queue_.emplace_back(std::move(item)); }
+	void putWaitingQueue(message_ptr item) {
+		message_id_counts_[item->get_message_id()]++;
+		message_queue_.emplace_back(std::move(item));
+	}
+
+	/**
+	* Removes a message that is leaving the WaitingQueue from the index of message ids.
+	* @param item The message that was removed from message_queue_.
+	*/
+	void unindex_message(const message_ptr & item) {
+		auto it = message_id_counts_.find(item->get_message_id());
+		if (it != message_id_counts_.end() && --(it->second) == 0) {
+			message_id_counts_.erase(it);
+		}
+	}
+
+	/**
+	* Checks if there is a message with a given id without locking.
+	* @param message_id The id of the message.
+	*/
+	bool has_message_unsafe(const std::string & message_id) {
+		return message_id_counts_.find(message_id) != message_id_counts_.end();
+	}
+
+	/**
+	* Removes the first message that satisfies a predicate without locking, keeping the order of the rest of the messages.
+	* @param pred The predicate. There must be a message that satisfies it.
+	* @return The removed message.
+	*/
+	template <typename predicate>
+	message_ptr remove_first_unsafe(predicate pred) {
+		auto it = std::find_if(message_queue_.begin(), message_queue_.end(), pred);
+		auto data = std::move(*it);
+		message_queue_.erase(it);
+		unindex_message(data);
+		condition_variable_.notify_all();
+		return std::move(data);
+	}
 
 private:
 	std::mutex mutex_; /**< This mutex is used for making access to the
 											WaitingQueue thread-safe. */
 	std::deque<message_ptr> message_queue_; /**< */
+	std::unordered_map<std::string, std::size_t> message_id_counts_; /**< Number of messages in message_queue_ for every message id. */
 	std::atomic<bool> finished; /**< Indicates if this WaitingQueue is finished. */
-	std::condition_variable condition_variable_; /**< Used to notify waiting
+	ral::execution::blocking_condition_variable condition_variable_; /**< Used to notify waiting
 																								functions*/
 	int processed = 0; /**< Count of messages added to the WaitingQueue. */
 
@@ -19,5 +19,9 @@ const blazingdb::transport::Node & CommunicationData::getSelfNode() { return _se
 
 std::string CommunicationData::get_cache_directory() { return _cache_directory; }
 
+void CommunicationData::set_worker_hosts(const std::map<std::string, std::string> & worker_hosts) { _worker_hosts = worker_hosts; }
+
+const std::map<std::string, std::string> & CommunicationData::get_worker_hosts() { return _worker_hosts; }
+
 }  // namespace communication
 }  // namespace ral
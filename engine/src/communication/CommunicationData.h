@@ -19,6 +19,13 @@ public:
 
 	std::string get_cache_directory();
 
+	/**
+	 * @brief Sets the host that every worker runs in, so that the broadcasts can tell which workers share a machine.
+	 */
+	void set_worker_hosts(const std::map<std::string, std::string> & worker_hosts);
+
+	const std::map<std::string, std::string> & get_worker_hosts();
+
 	CommunicationData(CommunicationData &&) = delete;
 	CommunicationData(const CommunicationData &) = delete;
 	CommunicationData & operator=(CommunicationData &&) = delete;
@@ -29,6 +36,7 @@ private:
 
 	blazingdb::transport::Node _selfNode;
 	std::string _cache_directory;
+	std::map<std::string, std::string> _worker_hosts; /**< The ip of the host of every worker, by worker id */
 };
 
 }  // namespace communication
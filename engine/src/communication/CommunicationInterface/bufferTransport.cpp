@@ -14,10 +14,8 @@ std::vector<char> serialize_metadata_and_transports_and_buffer_sizes(const ral::
                                                     const std::vector<size_t> buffer_sizes) {
 	// builds the cpu host buffer that we are going to send
 	// first lets serialize and send metadata
-	std::string metadata_buffer;
-	for(auto it : metadata.get_values()) {
-		metadata_buffer += it.first + "%==%" + it.second + "\n";
-	}
+	std::vector<char> metadata_buffer;
+	metadata.serialize(metadata_buffer);
 
 	std::vector<char> buffer, tmp_buffer;
 	tmp_buffer = detail::to_byte_vector(metadata_buffer.size());
@@ -81,24 +79,9 @@ std::tuple<ral::cache::MetadataDictionary, std::vector<blazingdb::transport::Col
 	size_t metadata_buffer_size = from_byte_vector<size_t>(data.data());
 	ptr_offset += sizeof(size_t);
 
-	std::string metadata_buffer(
-		data.data() + ptr_offset,
-		data.data() + ptr_offset + metadata_buffer_size);
-
+	ral::cache::MetadataDictionary dictionary = ral::cache::MetadataDictionary::deserialize(
+		data.data() + ptr_offset, metadata_buffer_size);
 	ptr_offset += metadata_buffer_size;
-	ral::cache::MetadataDictionary dictionary;
-	for(auto metadata_item : StringUtil::split(metadata_buffer,"\n")){
-		if (metadata_item.empty()) {
-			continue;
-		}
-
-		std::vector<std::string> key_value = StringUtil::split(metadata_item,"%==%");
-		if(key_value.size() == 1){
-			dictionary.add_value(key_value[0],"");
-		}else{
-			dictionary.add_value(key_value[0],key_value[1]);
-		}
-	}
 
 	// next lets deserialize column_transports
 	size_t column_transports_size = from_byte_vector<size_t>(data.data() + ptr_offset);
@@ -12,6 +12,8 @@
 
 namespace comm {
 
+const std::string GPU_DIRECT_METADATA_LABEL = "gpu_direct"; /**< A message metadata field that indicates that the buffers of a message are sent from and received into device memory. */
+
 namespace detail {
 
 template <typename T>
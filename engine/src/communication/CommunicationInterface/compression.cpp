@@ -0,0 +1,87 @@
+#include "compression.hpp"
+
+#include <algorithm>
+#include <lz4.h>
+#include <limits>
+#include <stdexcept>
+
+namespace comm {
+
+compression_mode parse_compression_mode(const std::string & value) {
+	std::string upper = value;
+	std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
+	if (upper == "LZ4") {
+		return compression_mode::lz4;
+	} else if (upper == "AUTO") {
+		return compression_mode::automatic;
+	} else if (upper == "NONE" || upper.empty()) {
+		return compression_mode::none;
+	}
+	throw std::runtime_error("Unknown COMMUNICATION_COMPRESSION value: " + value + ". It must be NONE, LZ4 or AUTO");
+}
+
+std::size_t compress_buffer(const char * src, std::size_t src_size, char * dst, std::size_t dst_capacity) {
+	if (src_size == 0 || src_size > static_cast<std::size_t>(LZ4_MAX_INPUT_SIZE)) {
+		return 0;
+	}
+	// anything that is not smaller than the original is useless, so lz4 is not allowed to write that much
+	int capacity = static_cast<int>(std::min(dst_capacity, src_size - 1));
+	int compressed_size = LZ4_compress_default(src, dst, static_cast<int>(src_size), capacity);
+	return compressed_size > 0 ? static_cast<std::size_t>(compressed_size) : 0;
+}
+
+void decompress_buffer(const char * src, std::size_t src_size, char * dst, std::size_t uncompressed_size) {
+	int decompressed_size = LZ4_decompress_safe(src, dst, static_cast<int>(src_size), static_cast<int>(uncompressed_size));
+	if (decompressed_size < 0 || static_cast<std::size_t>(decompressed_size) != uncompressed_size) {
+		throw std::runtime_error("ERROR in decompress_buffer: the buffer is corrupted, expected " + std::to_string(uncompressed_size) +
+			" bytes but got " + std::to_string(decompressed_size));
+	}
+}
+
+void compression_policy::set_mode(compression_mode mode) {
+	std::lock_guard<std::mutex> lock(mutex_);
+	this->mode = mode;
+}
+
+bool compression_policy::should_compress() {
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (mode != compression_mode::automatic) {
+		return mode == compression_mode::lz4;
+	}
+
+	bool probe = num_decisions++ % probe_interval == 0;
+	if (link_bandwidth == 0 || compression_throughput == 0) {
+		return probe;
+	}
+	// sending n bytes takes n / bw and compressing them takes n / ct, plus about as much to decompress them
+	double time_saved = (1 - compression_ratio) / link_bandwidth;
+	double time_spent = 2 / compression_throughput;
+	return time_saved > time_spent || probe;
+}
+
+void compression_policy::record_send(std::size_t bytes, double seconds) {
+	if (bytes == 0 || seconds <= 0) {
+		return;
+	}
+	std::lock_guard<std::mutex> lock(mutex_);
+	double bandwidth = bytes / seconds;
+	link_bandwidth = link_bandwidth == 0 ? bandwidth : (1 - smoothing) * link_bandwidth + smoothing * bandwidth;
+}
+
+void compression_policy::record_compression(std::size_t uncompressed_bytes, std::size_t compressed_bytes, double seconds) {
+	if (uncompressed_bytes == 0) {
+		return;
+	}
+	std::lock_guard<std::mutex> lock(mutex_);
+	double throughput = seconds > 0 ? uncompressed_bytes / seconds : std::numeric_limits<double>::max();
+	double ratio = std::min(1.0, static_cast<double>(compressed_bytes) / uncompressed_bytes);
+	if (compression_throughput == 0) {
+		compression_throughput = throughput;
+		compression_ratio = ratio;
+	} else {
+		compression_throughput = (1 - smoothing) * compression_throughput + smoothing * throughput;
+		compression_ratio = (1 - smoothing) * compression_ratio + smoothing * ratio;
+	}
+}
+
+}  // namespace comm
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <string>
+
+namespace comm {
+
+const std::string COMPRESSION_CODEC_METADATA_LABEL = "compression_codec"; /**< A message metadata field that indicates which codec the buffers of a message were compressed with. Empty if they were not compressed. */
+const std::string UNCOMPRESSED_BUFFER_SIZES_METADATA_LABEL = "uncompressed_buffer_sizes"; /**< A message metadata field with the comma separated sizes of the buffers of a message before they were compressed. */
+const std::string LZ4_CODEC = "lz4";
+
+enum class compression_mode {
+	none, /**< The messages are never compressed. */
+	lz4, /**< The messages are always compressed. */
+	automatic /**< The messages are compressed when the link is slower than the compression. */
+};
+
+/**
+ * @brief Parses the value of the COMMUNICATION_COMPRESSION config option, which can be NONE, LZ4 or AUTO.
+ */
+compression_mode parse_compression_mode(const std::string & value);
+
+/**
+ * @brief Compresses a buffer with lz4.
+ *
+ * @param src The buffer to compress
+ * @param src_size The size in bytes of the buffer to compress
+ * @param dst Where to write the compressed buffer
+ * @param dst_capacity The size in bytes of dst
+ * @return The size of the compressed buffer, or 0 if it would not be smaller than the original one.
+ */
+std::size_t compress_buffer(const char * src, std::size_t src_size, char * dst, std::size_t dst_capacity);
+
+/**
+ * @brief Decompresses a buffer that was compressed with compress_buffer.
+ *
+ * @param src The compressed buffer
+ * @param src_size The size in bytes of the compressed buffer
+ * @param dst Where to write the decompressed buffer
+ * @param uncompressed_size The size in bytes of the buffer before it was compressed
+ */
+void decompress_buffer(const char * src, std::size_t src_size, char * dst, std::size_t uncompressed_size);
+
+/**
+ * @brief Decides whether the messages are worth compressing.
+ *
+ * It keeps moving averages of the bandwidth of the link, of the throughput of the compression and of the ratio it gets.
+ * Compressing is worth it when the time it saves sending the message is more than the time it takes to compress and
+ * decompress it. Until there is an estimate of the compression every few messages are compressed to get one.
+ */
+class compression_policy {
+public:
+	compression_policy(compression_mode mode = compression_mode::none) : mode{mode} {}
+
+	void set_mode(compression_mode mode);
+
+	bool should_compress();
+
+	/**
+	 * @brief Records how long it took to send a message.
+	 *
+	 * @param bytes The bytes that were sent over the link
+	 * @param seconds How long it took to send them
+	 */
+	void record_send(std::size_t bytes, double seconds);
+
+	/**
+	 * @brief Records how long it took to compress a message.
+	 *
+	 * @param uncompressed_bytes The size of the message before compression
+	 * @param compressed_bytes The size of the message after compression
+	 * @param seconds How long it took to compress it
+	 */
+	void record_compression(std::size_t uncompressed_bytes, std::size_t compressed_bytes, double seconds);
+
+private:
+	static constexpr double smoothing = 0.2; /**< The weight of a new sample in the moving averages. */
+	static constexpr std::size_t probe_interval = 16; /**< How often a message is compressed when the policy would not do so, to keep the estimates fresh. */
+
+	std::mutex mutex_;
+	compression_mode mode;
+	double link_bandwidth = 0; /**< bytes per second, 0 if unknown */
+	double compression_throughput = 0; /**< uncompressed bytes per second, 0 if unknown */
+	double compression_ratio = 1; /**< compressed size divided by uncompressed size */
+	std::size_t num_decisions = 0;
+};
+
+}  // namespace comm
@@ -2,6 +2,7 @@
 #include <sys/socket.h>
 
 #include "utilities/CodeTimer.h"
+#include "utilities/ThreadAffinity.h"
 #include <mutex>
 
 namespace comm {
@@ -13,9 +14,21 @@ ctpl::thread_pool<BlazingThread> & message_listener::get_pool(){
 }
 
 std::map<std::string, comm::node> message_listener::get_node_map(){
+	std::lock_guard<std::mutex> lock(nodes_mutex);
 	return _nodes_info_map;
 }
 
+void message_listener::add_node(const comm::node & node){
+	std::lock_guard<std::mutex> lock(nodes_mutex);
+	_nodes_info_map.erase(node.id());
+	_nodes_info_map.emplace(node.id(), node);
+}
+
+void message_listener::remove_node(const std::string & worker_id){
+	std::lock_guard<std::mutex> lock(nodes_mutex);
+	_nodes_info_map.erase(worker_id);
+}
+
 void poll_for_frames(std::shared_ptr<message_receiver> receiver,
 		                 ucp_tag_t tag,
                      ucp_worker_h ucp_worker,
@@ -86,8 +99,9 @@ void recv_begin_callback_c(std::shared_ptr<ucp_tag_recv_info_t> info, std::share
 	auto message_listener = ucx_message_listener::get_instance();
 
    auto fwd = message_listener->get_pool().push([&message_listener, info, data_buffer, request_size, input_cache](int /*thread_id*/) {
+   ral::utilities::thread_affinity::get_instance().pin_current_thread(ral::utilities::thread_group::COMMS);
 
-   auto receiver = std::make_shared<message_receiver>(message_listener->get_node_map(), *data_buffer, input_cache);
+   auto receiver = std::make_shared<message_receiver>(message_listener->get_node_map(), *data_buffer, input_cache, message_listener->get_device_placement());
 
 		message_listener->add_receiver(info->sender_tag, receiver);
 
@@ -102,6 +116,40 @@ void recv_begin_callback_c(std::shared_ptr<ucp_tag_recv_info_t> info, std::share
 }
 
 
+void tcp_message_listener::receive_messages(int connection_fd) {
+	try{
+		cudaStream_t stream = 0;
+		size_t message_size;
+		// the sender closes the connection when it does not need it anymore, which can only happen between messages
+		while(io::try_read_from_socket(connection_fd, &message_size, sizeof(message_size))) {
+			std::vector<char> data(message_size);
+			io::read_from_socket(connection_fd, data.data(), message_size);
+
+			auto receiver = std::make_shared<message_receiver>(get_node_map(), data, input_cache);
+			size_t buffer_position = 0;
+			while(buffer_position < receiver->num_buffers()) {
+				receiver->allocate_buffer(buffer_position, stream);
+				void * buffer = receiver->get_buffer(buffer_position);
+				size_t buffer_size = receiver->buffer_size(buffer_position);
+				io::read_from_socket(connection_fd, buffer, buffer_size);
+
+				buffer_position++;
+			}
+			receiver->finish(stream);
+			cudaStreamSynchronize(stream);
+		}
+		close(connection_fd);
+	}catch(std::exception & e){
+		close(connection_fd);
+		std::shared_ptr<spdlog::logger> logger = spdlog::get("batch_logger");
+
+		if (logger){
+			logger->error("|||{info}|||||",
+					"info"_a="ERROR in message_listener::run_polling(). What: {}"_format(e.what()));
+		}
+	}
+}
+
 void tcp_message_listener::start_polling() {
 	if(!polling_started) {
 		polling_started = true;
@@ -131,7 +179,8 @@ void tcp_message_listener::start_polling() {
 			throw std::runtime_error("Could not listen on socket.");
 		}
 		auto thread = std::thread([this, socket_fd] {
-			
+			ral::utilities::thread_affinity::get_instance().pin_current_thread(ral::utilities::thread_group::COMMS);
+
 			struct sockaddr_in client_address;
 			socklen_t len;
 			int connection_fd;
@@ -147,57 +196,13 @@ void tcp_message_listener::start_polling() {
 						std::this_thread::sleep_for(std::chrono::milliseconds(10));
 					continue;
 				}
-				pool.push([this, connection_fd](int /*thread_num*/) {
-					try{
-						CodeTimer timer;
-						cudaStream_t stream = 0;
-				
-						size_t message_size;
-						io::read_from_socket(connection_fd, &message_size, sizeof(message_size));
-						std::vector<char> data(message_size);
-						io::read_from_socket(connection_fd, data.data(), message_size);
-						// auto meta_read_time = timer.elapsed_time();
-						// status_code success = status_code::OK;
-						// io::write_to_socket(connection_fd, &success, sizeof(success));
-						{
-							auto receiver = std::make_shared<message_receiver>(_nodes_info_map, data, input_cache);
-
-							//   auto receiver_time = timer.elapsed_time() - meta_read_time;
-					
-							size_t buffer_position = 0;
-					
-							//   size_t total_allocate_time = 0 ;
-							//   size_t total_read_time = 0 ;
-							//   size_t total_sync_time = 0;
-							while(buffer_position < receiver->num_buffers()) {
-								receiver->allocate_buffer(buffer_position, stream);
-								void * buffer = receiver->get_buffer(buffer_position);
-								size_t buffer_size = receiver->buffer_size(buffer_position);
-								io::read_from_socket(connection_fd, buffer, buffer_size);
-
-								buffer_position++;
-							}
-							close(connection_fd);
-							//   auto duration = timer.elapsed_time();
-							//   std::cout<<"Transfer duration before finish "<<duration <<" Throughput was "<<
-							//   (( (float) total_size) / 1000000.0)/(((float) duration)/1000.0)<<" MB/s"<<std::endl;
-
-							receiver->finish(stream);
-						}
-						cudaStreamSynchronize(stream);
-						//	cudaStreamDestroy(stream);
-					}catch(std::exception & e){
-						close(connection_fd);
-						std::shared_ptr<spdlog::logger> logger = spdlog::get("batch_logger");
-
-						if (logger){
-							logger->error("|||{info}|||||",
-									"info"_a="ERROR in message_listener::run_polling(). What: {}"_format(e.what()));
-						}
-						
-					}
-
-				});
+				// the connections are kept open by the senders and carry one message after the other, so every
+				// connection gets its own thread instead of taking one of the pool for as long as it is open
+				std::thread([this, connection_fd] {
+					cudaSetDevice(0);
+					ral::utilities::thread_affinity::get_instance().pin_current_thread(ral::utilities::thread_group::COMMS);
+					receive_messages(connection_fd);
+				}).detach();
 			}
 		});
 		thread.detach();
@@ -211,6 +216,7 @@ void ucx_message_listener::poll_begin_message_tag(bool running_from_unit_test){
 		auto thread = std::thread([running_from_unit_test, this]{
 			try {
 				cudaSetDevice(0);
+				ral::utilities::thread_affinity::get_instance().pin_current_thread(ral::utilities::thread_group::COMMS);
 
 				for(;;){
 					std::shared_ptr<ucp_tag_recv_info_t> info_tag = std::make_shared<ucp_tag_recv_info_t>();
@@ -218,7 +224,10 @@ void ucx_message_listener::poll_begin_message_tag(bool running_from_unit_test){
 					do {
 						message_tag = ucp_tag_probe_nb(
 							ucp_worker, 0ull, begin_tag_mask, 0, info_tag.get());
-
+						if (message_tag == nullptr) {
+							// new messages can only show up after the worker makes progress
+							ucp_progress_manager::get_instance()->wait_for_progress(std::chrono::microseconds(200));
+						}
 					}while(message_tag == nullptr);
 
 						char * request = new char[_request_size];
@@ -351,6 +360,11 @@ void ucx_message_listener::initialize_message_listener(ucp_context_h context, uc
 void tcp_message_listener::initialize_message_listener(const std::map<std::string, comm::node>& nodes, int port, int num_threads, std::shared_ptr<ral::cache::CacheMachine> input_cache){
 	if(instance == NULL){
 		instance = new tcp_message_listener(nodes,port,num_threads,input_cache);
+	} else {
+		// the engine is initialized again with the current nodes of the cluster
+		for (auto & node : nodes) {
+			instance->add_node(node.second);
+		}
 	}
 }
 
@@ -8,6 +8,7 @@
 #include <ucp/api/ucp.h>
 #include <ucp/api/ucp_def.h>
 #include "messageReceiver.hpp"
+#include <atomic>
 #include <mutex>
 
 namespace comm {
@@ -21,12 +22,23 @@ public:
     virtual void start_polling() = 0;
     ctpl::thread_pool<BlazingThread> & get_pool();
     std::map<std::string, comm::node> get_node_map();
+
+    /**
+     * @brief Adds a node that joined the cluster, or replaces the one with the same id, so that its messages are received.
+     */
+    void add_node(const comm::node & node);
+
+    /**
+     * @brief Removes a node that left the cluster.
+     */
+    void remove_node(const std::string & worker_id);
     std::shared_ptr<ral::cache::CacheMachine> get_input_cache(){
 		return input_cache;
 	}
 
 protected:
     ctpl::thread_pool<BlazingThread> pool;
+    std::mutex nodes_mutex;
     std::map<std::string, comm::node> _nodes_info_map;
     bool polling_started{false};
     std::shared_ptr<ral::cache::CacheMachine> input_cache;
@@ -46,6 +58,10 @@ public:
     }
 private:
     tcp_message_listener(const std::map<std::string, comm::node>& nodes, int port, int num_threads, std::shared_ptr<ral::cache::CacheMachine> input_cache);
+    /**
+     * @brief Receives the messages sent over a connection until the sender closes it
+     */
+    void receive_messages(int connection_fd);
     int _port;
     static tcp_message_listener * instance;
 };
@@ -63,6 +79,16 @@ public:
     void remove_receiver(ucp_tag_t tag);
     ucp_worker_h get_worker();
     void start_polling() override;
+
+    /**
+     * @brief Sets if the messages are received straight into device memory when there is enough of it. UCX has to support cuda memory.
+     */
+    void set_device_placement(bool device_placement) {
+        this->device_placement = device_placement;
+    }
+    bool get_device_placement() {
+        return device_placement;
+    }
 private:
     ucx_message_listener(ucp_context_h context, ucp_worker_h worker, const std::map<std::string, comm::node>& nodes, int num_threads, std::shared_ptr<ral::cache::CacheMachine> input_cache);
 	virtual ~ucx_message_listener(){
@@ -74,6 +100,7 @@ private:
     std::map<ucp_tag_t,std::shared_ptr<message_receiver> > tag_to_receiver;
 	static ucx_message_listener * instance;
     std::mutex receiver_mutex;
+    std::atomic<bool> device_placement{false};
 };
 
 } // namespace comm
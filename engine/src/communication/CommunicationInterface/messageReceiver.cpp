@@ -1,13 +1,28 @@
 #include "messageReceiver.hpp"
+#include "messageSender.hpp"
 #include "protocols.hpp"
+#include "compression.hpp"
+#include "transportMetrics.hpp"
+#include <Util/StringUtil.h>
 #include <spdlog/spdlog.h>
 #include "cache_machine/CPUCacheData.h"
+#include "cache_machine/GPUCacheData.h"
+#include "serializer.hpp"
+#include "communication/CommunicationData.h"
+#include "distribution_utils/broadcast_tree.h"
+#include "utilities/Tracer.h"
+#include "utilities/nvtx.h"
+#include "utilities/EventLog.h"
+#include "bmr/BlazingMemoryResource.h"
+#include <algorithm>
+#include <cstring>
+#include <numeric>
 
 
 namespace comm {
 using namespace fmt::literals;
-message_receiver::message_receiver(const std::map<std::string, comm::node>& nodes, const std::vector<char>& buffer, std::shared_ptr<ral::cache::CacheMachine> input_cache) 
-: _buffer_counter{0}, input_cache{input_cache}
+message_receiver::message_receiver(const std::map<std::string, comm::node>& nodes, const std::vector<char>& buffer, std::shared_ptr<ral::cache::CacheMachine> input_cache, bool allow_device_placement) 
+: _buffer_counter{0}, input_cache{input_cache}, _trace_start{ral::utilities::tracer::getInstance().now()}
 {
 
   try {
@@ -17,32 +32,47 @@ message_receiver::message_receiver(const std::map<std::string, comm::node>& node
     _column_transports = std::get<1>(metadata_and_transports);
     _chunked_column_infos = std::get<2>(metadata_and_transports);
     _buffer_sizes = std::get<3>(metadata_and_transports);
-    int32_t ctx_token = std::stoi(_metadata.get_values()[ral::cache::QUERY_ID_METADATA_LABEL]);
+    int32_t ctx_token = _metadata.get_query_id();
+    _query_id = ctx_token;
 
     auto graph = graphs_info::getInstance().get_graph(ctx_token);
-    size_t kernel_id = std::stoull(_metadata.get_values()[ral::cache::KERNEL_ID_METADATA_LABEL]);
-    std::string cache_id = _metadata.get_values()[ral::cache::CACHE_ID_METADATA_LABEL];
-    _output_cache = _metadata.get_values()[ral::cache::ADD_TO_SPECIFIC_CACHE_METADATA_LABEL] == "true" ?
+    size_t kernel_id = _metadata.get_kernel_id();
+    std::string cache_id = _metadata.get_value(ral::cache::CACHE_ID_METADATA_LABEL);
+    _output_cache = _metadata.get_header().add_to_specific_cache ?
                         graph->get_kernel_output_cache(kernel_id, cache_id) : input_cache;
   //_metadata.print();
 
-  _raw_buffers.resize(_buffer_sizes.size());
+  _gpu_direct = _metadata.get_value(GPU_DIRECT_METADATA_LABEL) == "true";
+  if (_gpu_direct) {
+    _gpu_buffers.resize(_buffer_sizes.size());
+  } else {
+    _raw_buffers.resize(_buffer_sizes.size());
+    // compressed buffers have to be decompressed in the host, so they can't skip it
+    bool compressed = !_metadata.get_value(COMPRESSION_CODEC_METADATA_LABEL).empty();
+    if (allow_device_placement && !compressed && !_buffer_sizes.empty()) {
+      size_t message_size = std::accumulate(_buffer_sizes.begin(), _buffer_sizes.end(), size_t{0});
+      auto & device_memory = blazing_device_memory_resource::getInstance();
+      if (device_memory.get_memory_used() + message_size < device_memory.get_memory_limit()) {
+        _device_placement = true;
+        _gpu_buffers.resize(_buffer_sizes.size());
+      }
+    }
+  }
     std::shared_ptr<spdlog::logger> comms_logger;
     comms_logger = spdlog::get("input_comms");
-    auto destinations = _metadata.get_values()[ral::cache::WORKER_IDS_METADATA_LABEL];
+    auto destinations = _metadata.get_value(ral::cache::WORKER_IDS_METADATA_LABEL);
 
     if(comms_logger) {
-        comms_logger->info(
-                "{unique_id}|{ral_id}|{query_id}|{kernel_id}|{dest_ral_id}|{dest_ral_count}|{dest_cache_id}|{message_id}|{phase}",
-                "unique_id"_a = _metadata.get_values()[ral::cache::UNIQUE_MESSAGE_ID],
-                "ral_id"_a = _metadata.get_values()[ral::cache::RAL_ID_METADATA_LABEL],
-                "query_id"_a = _metadata.get_values()[ral::cache::QUERY_ID_METADATA_LABEL],
-                "kernel_id"_a = _metadata.get_values()[ral::cache::KERNEL_ID_METADATA_LABEL],
-                "dest_ral_id"_a = destinations, //false
-                "dest_ral_count"_a = std::count(destinations.begin(), destinations.end(), ',') + 1,
-                "dest_cache_id"_a = _metadata.get_values()[ral::cache::CACHE_ID_METADATA_LABEL],
-                "message_id"_a = _metadata.get_values()[ral::cache::MESSAGE_ID],
-                "phase"_a = "begin");
+        ral::utilities::log_event(comms_logger,
+                _metadata.get_value(ral::cache::UNIQUE_MESSAGE_ID),
+                _metadata.get_value(ral::cache::RAL_ID_METADATA_LABEL),
+                _metadata.get_value(ral::cache::QUERY_ID_METADATA_LABEL),
+                _metadata.get_value(ral::cache::KERNEL_ID_METADATA_LABEL),
+                destinations, //false
+                std::count(destinations.begin(), destinations.end(), ',') + 1,
+                _metadata.get_value(ral::cache::CACHE_ID_METADATA_LABEL),
+                _metadata.get_value(ral::cache::MESSAGE_ID),
+                "begin");
     }
   } catch(const std::exception & e) {
     std::shared_ptr<spdlog::logger> logger = spdlog::get("batch_logger");
@@ -59,14 +89,28 @@ size_t message_receiver::buffer_size(u_int16_t index){
 }
 
 void message_receiver::allocate_buffer(uint16_t index, cudaStream_t stream){
-  if (index >= _raw_buffers.size()) {
+  if (index >= _buffer_sizes.size()) {
     throw std::runtime_error("Invalid access to raw buffer");
   }
-  _raw_buffers[index] = ral::memory::buffer_providers::get_pinned_buffer_provider()->get_chunk();
+  if (_gpu_direct) {
+    _gpu_buffers[index] = rmm::device_buffer(_buffer_sizes[index], stream);
+    cudaStreamSynchronize(stream); // the buffer has to be allocated before ucx writes into it
+    return;
+  }
+  if (_device_placement) {
+    try {
+      _gpu_buffers[index] = rmm::device_buffer(_buffer_sizes[index], stream);
+      cudaStreamSynchronize(stream);
+      return;
+    } catch(const rmm::bad_alloc &) {
+      // the memory ran out since the message started arriving, so the rest of its buffers go to the host
+    }
+  }
+  _raw_buffers[index] = ral::memory::buffer_providers::get_pinned_buffer_provider()->get_chunk(_buffer_sizes[index]);
 }
 
 node message_receiver::get_sender_node(){
-  return _nodes_info_map.at(_metadata.get_values()[ral::cache::SENDER_WORKER_ID_METADATA_LABEL]);
+  return _nodes_info_map.at(_metadata.get_value(ral::cache::SENDER_WORKER_ID_METADATA_LABEL));
 }
 
 
@@ -75,13 +119,13 @@ size_t message_receiver::num_buffers(){
 }
 
 void message_receiver::confirm_transmission(){
-  if (++_buffer_counter == _raw_buffers.size()) {
+  if (++_buffer_counter == _buffer_sizes.size()) {
     finish();
   }
 }
 
 void * message_receiver::get_buffer(uint16_t index){
-    return _raw_buffers[index]->data;
+    return _raw_buffers.empty() || _raw_buffers[index] == nullptr ? _gpu_buffers[index].data() : _raw_buffers[index]->data;
 }
 
 bool message_receiver::is_finished(){
@@ -89,35 +133,145 @@ bool message_receiver::is_finished(){
   return _finished_called;
 }
 
+void message_receiver::decompress_buffers() {
+  std::string codec = _metadata.get_value(COMPRESSION_CODEC_METADATA_LABEL);
+  if (codec.empty()) {
+    return;
+  }
+  if (codec != LZ4_CODEC) {
+    throw std::runtime_error("ERROR in message_receiver::decompress_buffers: unknown compression codec " + codec);
+  }
+
+  auto uncompressed_sizes = StringUtil::split(_metadata.get_value(UNCOMPRESSED_BUFFER_SIZES_METADATA_LABEL), ",");
+  if (uncompressed_sizes.size() != _raw_buffers.size()) {
+    throw std::runtime_error("ERROR in message_receiver::decompress_buffers: the message has " + std::to_string(_raw_buffers.size()) +
+      " buffers but " + std::to_string(uncompressed_sizes.size()) + " uncompressed sizes");
+  }
+  for (size_t i = 0; i < _raw_buffers.size(); i++) {
+    size_t uncompressed_size = std::stoull(uncompressed_sizes[i]);
+    if (_buffer_sizes[i] == uncompressed_size) {
+      continue; // this buffer did not compress, so it was sent as it was
+    }
+    auto chunk = ral::memory::buffer_providers::get_pinned_buffer_provider()->get_chunk(uncompressed_size);
+    decompress_buffer(_raw_buffers[i]->data, _buffer_sizes[i], chunk->data, uncompressed_size);
+    _raw_buffers[i]->allocation->pool->free_chunk(std::move(_raw_buffers[i]));
+    _raw_buffers[i] = std::move(chunk);
+    _buffer_sizes[i] = uncompressed_size;
+  }
+  // the table is not compressed anymore, in case it is forwarded
+  _metadata.add_value(COMPRESSION_CODEC_METADATA_LABEL, std::string());
+}
+
+std::unique_ptr<ral::frame::BlazingTable> message_receiver::make_table_from_placed_buffers(cudaStream_t stream) {
+  // the columns are laid out in the buffers like in the pinned buffers of a BlazingHostTable, but every buffer can be
+  // either in the device or, if there was no memory left for it, in the host
+  std::vector<rmm::device_buffer> column_buffers(_chunked_column_infos.size());
+  for (size_t buffer_index = 0; buffer_index < _chunked_column_infos.size(); buffer_index++) {
+    auto & chunked_column_info = _chunked_column_infos[buffer_index];
+    column_buffers[buffer_index] = rmm::device_buffer(chunked_column_info.use_size, stream);
+    size_t position = 0;
+    for (size_t i = 0; i < chunked_column_info.chunk_index.size(); i++) {
+      size_t chunk_index = chunked_column_info.chunk_index[i];
+      const char * chunk = static_cast<const char *>(get_buffer(chunk_index));
+      cudaMemcpyAsync(static_cast<char *>(column_buffers[buffer_index].data()) + position, chunk + chunked_column_info.offset[i],
+        chunked_column_info.size[i], cudaMemcpyDefault, stream);
+      position += chunked_column_info.size[i];
+    }
+  }
+  cudaStreamSynchronize(stream);
+  return deserialize_from_gpu_raw_buffers(_column_transports, column_buffers, stream);
+}
+
+void message_receiver::forward_broadcast(const ral::frame::BlazingTableView * gpu_table) {
+  auto children = ral::distribution::get_broadcast_children(
+    ral::distribution::deserialize_broadcast_groups(_metadata.get_value(ral::cache::BROADCAST_SUBTREE_METADATA_LABEL)));
+  if (children.empty()) {
+    return;
+  }
+
+  auto output_cache = message_sender::get_instance()->get_output_cache();
+  for (auto & child : children) {
+    ral::cache::MetadataDictionary metadata = _metadata;
+    metadata.add_value(ral::cache::SENDER_WORKER_ID_METADATA_LABEL, ral::communication::CommunicationData::getInstance().getSelfNode().id());
+    metadata.add_value(ral::cache::WORKER_IDS_METADATA_LABEL, child.worker_id);
+    metadata.add_value(ral::cache::BROADCAST_SUBTREE_METADATA_LABEL, ral::distribution::serialize_broadcast_groups(child.subtree));
+
+    std::unique_ptr<ral::cache::CacheData> table;
+    if (gpu_table != nullptr) {
+      table = std::make_unique<ral::cache::GPUCacheData>(gpu_table->clone(), metadata);
+    } else {
+      std::vector<std::unique_ptr<ral::memory::blazing_allocation_chunk>> buffers;
+      for (size_t i = 0; i < _raw_buffers.size(); i++) {
+        buffers.push_back(ral::memory::buffer_providers::get_pinned_buffer_provider()->get_chunk(_buffer_sizes[i]));
+        std::memcpy(buffers.back()->data, _raw_buffers[i]->data, _buffer_sizes[i]);
+      }
+      auto chunked_column_infos = _chunked_column_infos;
+      table = std::make_unique<ral::cache::CPUCacheData>(_column_transports, std::move(chunked_column_infos), std::move(buffers), metadata);
+    }
+    output_cache->addCacheData(std::move(table), "", true);
+  }
+}
+
 void message_receiver::finish(cudaStream_t stream) {
 
   std::lock_guard<std::mutex> lock(_finish_mutex);
   if(!_finished_called){
+    BLAZING_NVTX_RANGE("receive " + _metadata.get_value(ral::cache::MESSAGE_ID), comms);
     std::shared_ptr<spdlog::logger> comms_logger;
     comms_logger = spdlog::get("input_comms");
-    auto destinations = _metadata.get_values()[ral::cache::WORKER_IDS_METADATA_LABEL];
+    auto destinations = _metadata.get_value(ral::cache::WORKER_IDS_METADATA_LABEL);
 
 
     if (comms_logger){
-      comms_logger->info("{ral_id}|{query_id}|{kernel_id}|{dest_ral_id}|{dest_ral_count}|{dest_cache_id}|{message_id}|{phase}",
-                          "ral_id"_a=_metadata.get_values()[ral::cache::RAL_ID_METADATA_LABEL],
-                          "query_id"_a=_metadata.get_values()[ral::cache::QUERY_ID_METADATA_LABEL],
-                          "kernel_id"_a=_metadata.get_values()[ral::cache::KERNEL_ID_METADATA_LABEL],
-                          "dest_ral_id"_a=destinations, //false
-                          "dest_ral_count"_a=std::count(destinations.begin(), destinations.end(), ',') + 1,
-                          "dest_cache_id"_a=_metadata.get_values()[ral::cache::CACHE_ID_METADATA_LABEL],
-                          "message_id"_a=_metadata.get_values()[ral::cache::MESSAGE_ID],
-                          "phase"_a="end");
+      ral::utilities::log_event(comms_logger,
+                          _metadata.get_value(ral::cache::RAL_ID_METADATA_LABEL),
+                          _metadata.get_value(ral::cache::QUERY_ID_METADATA_LABEL),
+                          _metadata.get_value(ral::cache::KERNEL_ID_METADATA_LABEL),
+                          destinations, //false
+                          std::count(destinations.begin(), destinations.end(), ',') + 1,
+                          _metadata.get_value(ral::cache::CACHE_ID_METADATA_LABEL),
+                          _metadata.get_value(ral::cache::MESSAGE_ID),
+                          "end");
 
 
     }
     
-    std::unique_ptr<ral::cache::CacheData> table = 
-        std::make_unique<ral::cache::CPUCacheData>(_column_transports, std::move(_chunked_column_infos), std::move(_raw_buffers), _metadata);
+    std::unique_ptr<ral::cache::CacheData> table;
+    if (_gpu_direct) {
+      _metadata.add_value(GPU_DIRECT_METADATA_LABEL, std::string()); // in case it is forwarded from the host
+      table = std::make_unique<ral::cache::GPUCacheData>(deserialize_from_gpu_raw_buffers(_column_transports, _gpu_buffers, stream), _metadata);
+      _gpu_buffers.clear();
+      auto table_view = static_cast<ral::cache::GPUCacheData *>(table.get())->getTableView();
+      forward_broadcast(&table_view);
+    } else if (_device_placement && std::any_of(_raw_buffers.begin(), _raw_buffers.end(), [](auto & buffer) { return buffer == nullptr; })) {
+      table = std::make_unique<ral::cache::GPUCacheData>(make_table_from_placed_buffers(stream), _metadata);
+      _gpu_buffers.clear();
+      auto table_view = static_cast<ral::cache::GPUCacheData *>(table.get())->getTableView();
+      forward_broadcast(&table_view);
+      for (auto & buffer : _raw_buffers) {
+        if (buffer != nullptr) {
+          buffer->allocation->pool->free_chunk(std::move(buffer));
+        }
+      }
+      _raw_buffers.clear();
+    } else {
+      decompress_buffers();
+      forward_broadcast(nullptr);
+      table = std::make_unique<ral::cache::CPUCacheData>(_column_transports, std::move(_chunked_column_infos), std::move(_raw_buffers), _metadata);
+    }
         
     _output_cache->addCacheData(
-                std::move(table), _metadata.get_values()[ral::cache::MESSAGE_ID], true);  
+                std::move(table), _metadata.get_value(ral::cache::MESSAGE_ID), true);  
     _finished_called = true;
+
+    transport_metrics::get_instance().record_receive(_metadata.get_value(ral::cache::SENDER_WORKER_ID_METADATA_LABEL),
+                    std::accumulate(_buffer_sizes.begin(), _buffer_sizes.end(), size_t{0}));
+
+    auto & tracer = ral::utilities::tracer::getInstance();
+    if (tracer.is_tracing()){
+      tracer.record("MessageReceive", "comms", _query_id, _metadata.get_kernel_id(),
+                    _trace_start, tracer.now() - _trace_start);
+    }
   }
 
 
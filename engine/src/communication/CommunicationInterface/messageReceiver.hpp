@@ -56,8 +56,11 @@ public:
   *                 execution, planning, or physical optimizations. E.G. num rows in table, num partitions to be processed
   * @param output_cache The destination for the message being received. It is either a specific cache inbetween
   *                     two kernels or it is intended for the general input cache using a mesage_id
+  * @param allow_device_placement If the buffers can be received straight into device memory, when there is enough of it.
+  *                     The protocol has to be able to write into device memory.
   */
-  message_receiver(const std::map<std::string, comm::node>& nodes, const std::vector<char>& buffer, std::shared_ptr<ral::cache::CacheMachine> input_cache);
+  message_receiver(const std::map<std::string, comm::node>& nodes, const std::vector<char>& buffer, std::shared_ptr<ral::cache::CacheMachine> input_cache,
+    bool allow_device_placement = false);
   virtual ~message_receiver(){}
 
   size_t buffer_size(u_int16_t index);
@@ -69,7 +72,22 @@ public:
   bool is_finished();
   void finish(cudaStream_t stream = 0);
 private:
+  /**
+  * @brief Replaces the buffers that the sender compressed with their decompressed contents
+  */
+  void decompress_buffers();
+
+  /**
+  * @brief Makes the table of a message whose buffers were received, at least partly, into device memory
+  */
+  std::unique_ptr<ral::frame::BlazingTable> make_table_from_placed_buffers(cudaStream_t stream);
 
+  /**
+  * @brief Sends a copy of the table of a broadcast on to the nodes that this node has to forward it to, if there are any
+  *
+  * @param gpu_table The table, when it was received into device memory. If it is null the received pinned buffers are copied.
+  */
+  void forward_broadcast(const ral::frame::BlazingTableView * gpu_table);
 
   std::vector<ColumnTransport> _column_transports;
   std::vector<ral::memory::blazing_chunked_column_info> _chunked_column_infos;
@@ -77,11 +95,16 @@ private:
   ral::cache::MetadataDictionary _metadata;
   std::vector<size_t> _buffer_sizes;
   std::vector<std::unique_ptr<ral::memory::blazing_allocation_chunk> > _raw_buffers;
+  bool _gpu_direct = false; /**< The buffers are received into device memory, see GPU_DIRECT_METADATA_LABEL */
+  bool _device_placement = false; /**< The buffers are received into device memory when there is enough of it, and into pinned buffers otherwise */
+  std::vector<rmm::device_buffer> _gpu_buffers;
   std::map<std::string, comm::node> _nodes_info_map;
   std::atomic<int> _buffer_counter;
   std::mutex _finish_mutex;
   bool _finished_called = false;
   std::shared_ptr<ral::cache::CacheMachine> input_cache;
+  int32_t _query_id = -1;
+  int64_t _trace_start = 0; // when the begin message was received, used to trace the whole receive path
 };
 
 } // namespace comm
@@ -1,6 +1,15 @@
 #include "messageSender.hpp"
+#include "transportMetrics.hpp"
 #include <algorithm>
+#include <chrono>
+#include <numeric>
+#include "bmr/BufferProvider.h"
 #include "cache_machine/CPUCacheData.h"
+#include "communication/messages/GPUComponentMessage.h"
+#include "utilities/ThreadAffinity.h"
+#include "utilities/Tracer.h"
+#include "utilities/nvtx.h"
+#include "utilities/EventLog.h"
 
 using namespace fmt::literals;
 
@@ -27,7 +36,37 @@ void message_sender::initialize_instance(std::shared_ptr<ral::cache::CacheMachin
 	if(instance == NULL) {
 		message_sender::instance = new message_sender(
 				output_cache,node_address_map,num_threads,context,origin_node,ral_id,protocol,require_acknowledge);
+	} else {
+		// the engine is initialized again with the current nodes of the cluster
+		for (auto & node : node_address_map) {
+			instance->add_node(node.second);
+		}
+	}
+}
+
+void message_sender::add_node(const node & node) {
+	std::lock_guard<std::mutex> lock(nodes_mutex);
+	auto it = node_address_map.find(node.id());
+	if (it != node_address_map.end()) {
+		if (protocol == blazing_protocol::tcp && (it->second.ip() != node.ip() || it->second.port() != node.port())) {
+			tcp_connection_pool::get_instance().close_connections(node.id());
+		}
+		node_address_map.erase(it);
 	}
+	node_address_map.emplace(node.id(), node);
+}
+
+void message_sender::remove_node(const std::string & worker_id) {
+	std::lock_guard<std::mutex> lock(nodes_mutex);
+	node_address_map.erase(worker_id);
+	if (protocol == blazing_protocol::tcp) {
+		tcp_connection_pool::get_instance().close_connections(worker_id);
+	}
+}
+
+std::map<std::string, node> message_sender::get_node_map() {
+	std::lock_guard<std::mutex> lock(nodes_mutex);
+	return node_address_map;
 }
 
 message_sender::message_sender(std::shared_ptr<ral::cache::CacheMachine> output_cache,
@@ -67,55 +106,105 @@ void message_sender::run_polling() {
 		comms_logger = spdlog::get("output_comms");
 
 		cudaSetDevice(0);
+		ral::utilities::thread_affinity::get_instance().pin_current_thread(ral::utilities::thread_group::COMMS);
 
 		while(true) {
 			std::vector<std::unique_ptr<ral::cache::CacheData> > cache_datas = output_cache->pull_all_cache_data();
 			for(auto & cache_data : cache_datas){
+				// the message is queued to its destinations until a thread of the pool sends it
+				queued_message_guard queued_message(StringUtil::split(
+					cache_data->getMetadata().get_value(ral::cache::WORKER_IDS_METADATA_LABEL), ","));
 
 				pool.push([cache_data{std::move(cache_data)},
-						node_address_map = node_address_map,
+						queued_message{std::move(queued_message)},
+						node_address_map = get_node_map(),
 						output_cache = output_cache,
 							protocol=this->protocol,
 							this,
 							comms_logger](int /*thread_id*/) {
 					
 					try {
+						ral::utilities::thread_affinity::get_instance().pin_current_thread(ral::utilities::thread_group::COMMS);
+						auto & tracer = ral::utilities::tracer::getInstance();
+						int64_t send_start = tracer.now();
 
-						auto * cpu_cache_data = static_cast<ral::cache::CPUCacheData *>(cache_data.get());
-						auto table = cpu_cache_data->releaseHostTable();
-						auto metadata = cpu_cache_data->getMetadata();
+						auto metadata = cache_data->getMetadata();
+						BLAZING_NVTX_RANGE("send " + metadata.get_value(ral::cache::MESSAGE_ID), comms);
 
-						auto destinations_str = metadata.get_values()[ral::cache::WORKER_IDS_METADATA_LABEL];
+						auto destinations_str = metadata.get_value(ral::cache::WORKER_IDS_METADATA_LABEL);
 						if(comms_logger)
                         {
-                            comms_logger->info("{unique_id}|{ral_id}|{query_id}|{kernel_id}|{dest_ral_id}|{dest_ral_count}|{dest_cache_id}|{message_id}|{phase}",
-                                "unique_id"_a=metadata.get_values()[ral::cache::UNIQUE_MESSAGE_ID],
-                                "ral_id"_a=ral_id,
-                                "query_id"_a=metadata.get_values()[ral::cache::QUERY_ID_METADATA_LABEL],
-                                "kernel_id"_a=metadata.get_values()[ral::cache::KERNEL_ID_METADATA_LABEL],
-                                "dest_ral_id"_a=destinations_str, //false
-                                "dest_ral_count"_a=std::count(destinations_str.begin(), destinations_str.end(), ',') + 1,
-                                "dest_cache_id"_a=metadata.get_values()[ral::cache::CACHE_ID_METADATA_LABEL],
-                                "message_id"_a=metadata.get_values()[ral::cache::MESSAGE_ID],
-                                "phase"_a="begin");
+                            ral::utilities::log_event(comms_logger,
+                                metadata.get_value(ral::cache::UNIQUE_MESSAGE_ID),
+                                ral_id,
+                                metadata.get_value(ral::cache::QUERY_ID_METADATA_LABEL),
+                                metadata.get_value(ral::cache::KERNEL_ID_METADATA_LABEL),
+                                destinations_str, //false
+                                std::count(destinations_str.begin(), destinations_str.end(), ',') + 1,
+                                metadata.get_value(ral::cache::CACHE_ID_METADATA_LABEL),
+                                metadata.get_value(ral::cache::MESSAGE_ID),
+                                "begin");
                         }
 
 						std::vector<std::size_t> buffer_sizes;
 						std::vector<const char *> raw_buffers;
-						for(auto & buffer : table->get_raw_buffers()){
-							raw_buffers.push_back(buffer.data);
-							buffer_sizes.push_back(buffer.size);
+						std::vector<blazingdb::transport::ColumnTransport> column_transports;
+						std::vector<ral::memory::blazing_chunked_column_info> chunked_column_infos;
+						std::unique_ptr<ral::frame::BlazingHostTable> table;
+						std::unique_ptr<ral::frame::BlazingTable> gpu_table;
+						std::vector<std::unique_ptr<rmm::device_buffer>> gpu_temp_buffers;
+						std::vector<std::unique_ptr<ral::memory::blazing_allocation_chunk>> compressed_buffers;
+						if(cache_data->get_type() == ral::cache::CacheDataType::GPU){
+							// with gpu direct sends the device buffers are sent as they are, so they have to outlive the transport
+							gpu_table = cache_data->decache();
+							std::tie(buffer_sizes, raw_buffers, column_transports, gpu_temp_buffers) =
+								ral::communication::messages::serialize_gpu_message_to_gpu_containers(gpu_table->toBlazingTableView());
+							cudaStreamSynchronize(0); // ucx reads the buffers outside of any stream
+							metadata.add_value(GPU_DIRECT_METADATA_LABEL, "true");
+						} else {
+							table = static_cast<ral::cache::CPUCacheData *>(cache_data.get())->releaseHostTable();
+							for(auto & buffer : table->get_raw_buffers()){
+								raw_buffers.push_back(buffer.data);
+								buffer_sizes.push_back(buffer.size);
+							}
+
+							// the compressed buffers are sent in place of the original ones, and the sizes
+							// of the original ones go in the metadata so that the receiver can decompress them
+							if(!raw_buffers.empty() && compression.should_compress()){
+								auto compress_start = std::chrono::steady_clock::now();
+								std::size_t uncompressed_bytes = 0, compressed_bytes = 0;
+								std::string uncompressed_sizes;
+								for(size_t i = 0; i < raw_buffers.size(); i++) {
+									uncompressed_bytes += buffer_sizes[i];
+									uncompressed_sizes += (i == 0 ? "" : ",") + std::to_string(buffer_sizes[i]);
+
+									auto chunk = ral::memory::buffer_providers::get_pinned_buffer_provider()->get_chunk(buffer_sizes[i]);
+									std::size_t compressed_size = compress_buffer(raw_buffers[i], buffer_sizes[i], chunk->data, chunk->size);
+									if(compressed_size > 0){
+										raw_buffers[i] = chunk->data;
+										buffer_sizes[i] = compressed_size;
+										compressed_buffers.push_back(std::move(chunk));
+									} else {
+										chunk->allocation->pool->free_chunk(std::move(chunk));
+									}
+									compressed_bytes += buffer_sizes[i];
+								}
+								std::chrono::duration<double> compress_time = std::chrono::steady_clock::now() - compress_start;
+								compression.record_compression(uncompressed_bytes, compressed_bytes, compress_time.count());
+								if(!compressed_buffers.empty()){
+									metadata.add_value(COMPRESSION_CODEC_METADATA_LABEL, LZ4_CODEC);
+									metadata.add_value(UNCOMPRESSED_BUFFER_SIZES_METADATA_LABEL, uncompressed_sizes);
+								}
+							}
+
+							column_transports = table->get_columns_offsets();
+							chunked_column_infos = table->get_blazing_chunked_column_infos();
 						}
-						
-						std::vector<blazingdb::transport::ColumnTransport> column_transports = table->get_columns_offsets();
-						const std::vector<ral::memory::blazing_chunked_column_info> & chunked_column_infos = table->get_blazing_chunked_column_infos();
 					
 						// tcp / ucp
-						auto metadata_map = metadata.get_values();
-
 						std::vector<node> destinations;
 
-						auto worker_ids = StringUtil::split(metadata_map.at(ral::cache::WORKER_IDS_METADATA_LABEL), ",");
+						auto worker_ids = StringUtil::split(metadata.get_header().worker_ids, ",");
 						for(auto worker_id : worker_ids) {
 
 							if(node_address_map.find(worker_id) == node_address_map.end()) {
@@ -157,23 +246,37 @@ void message_sender::run_polling() {
 							throw std::runtime_error("Unknown protocol");
 						}
 
+						auto transmission_start = std::chrono::steady_clock::now();
 						transport->send_begin_transmission();
 						transport->wait_for_begin_transmission();
 						for(size_t i = 0; i < raw_buffers.size(); i++) {
 							transport->send(raw_buffers[i], buffer_sizes[i]);
 						}
 						transport->wait_until_complete();  // ensures that the message has been sent before returning the thread to the pool
+						std::chrono::duration<double> transmission_time = std::chrono::steady_clock::now() - transmission_start;
+						std::size_t message_bytes = std::accumulate(buffer_sizes.begin(), buffer_sizes.end(), std::size_t{0});
+						compression.record_send(message_bytes * destinations.size(), transmission_time.count());
+						for(auto & worker_id : worker_ids) {
+							transport_metrics::get_instance().record_send(worker_id, message_bytes, transmission_time.count());
+						}
+						for(auto & chunk : compressed_buffers){
+							chunk->allocation->pool->free_chunk(std::move(chunk));
+						}
+						if(tracer.is_tracing()){
+							tracer.record("MessageSend", "comms", metadata.get_query_id(),
+								metadata.get_kernel_id(), send_start, tracer.now() - send_start);
+						}
 						if(comms_logger){
-                            comms_logger->info("{unique_id}|{ral_id}|{query_id}|{kernel_id}|{dest_ral_id}|{dest_ral_count}|{dest_cache_id}|{message_id}|{phase}",
-                                "unique_id"_a=metadata.get_values()[ral::cache::UNIQUE_MESSAGE_ID],
-                                "ral_id"_a=ral_id,
-                                "query_id"_a=metadata.get_values()[ral::cache::QUERY_ID_METADATA_LABEL],
-                                "kernel_id"_a=metadata.get_values()[ral::cache::KERNEL_ID_METADATA_LABEL],
-                                "dest_ral_id"_a=destinations_str, //false
-                                "dest_ral_count"_a=std::count(destinations_str.begin(), destinations_str.end(), ',') + 1,
-                                "dest_cache_id"_a=metadata.get_values()[ral::cache::CACHE_ID_METADATA_LABEL],
-                                "message_id"_a=metadata.get_values()[ral::cache::MESSAGE_ID],
-                                "phase"_a="end");
+                            ral::utilities::log_event(comms_logger,
+                                metadata.get_value(ral::cache::UNIQUE_MESSAGE_ID),
+                                ral_id,
+                                metadata.get_value(ral::cache::QUERY_ID_METADATA_LABEL),
+                                metadata.get_value(ral::cache::KERNEL_ID_METADATA_LABEL),
+                                destinations_str, //false
+                                std::count(destinations_str.begin(), destinations_str.end(), ',') + 1,
+                                metadata.get_value(ral::cache::CACHE_ID_METADATA_LABEL),
+                                metadata.get_value(ral::cache::MESSAGE_ID),
+                                "end");
                         }
 					} catch(const std::exception & e) {
                         std::shared_ptr<spdlog::logger> logger = spdlog::get("batch_logger");
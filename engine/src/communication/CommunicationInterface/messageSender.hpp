@@ -1,7 +1,9 @@
 #pragma once
 
 #include <transport/ColumnTransport.h>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <rmm/device_buffer.hpp>
 #include <utility>
 #include <Util/StringUtil.h>
@@ -11,6 +13,7 @@
 #include "cache_machine/CacheMachine.h"
 #include "utilities/ctpl_stl.h"
 #include "protocols.hpp"
+#include "compression.hpp"
 
 namespace comm {
 
@@ -58,11 +61,40 @@ public:
 	 * @brief A polling function that listens on a cache for data and send it off via some protocol
 	 */
 	void run_polling();
+
+	/**
+	 * @brief Adds a node that joined the cluster, or replaces the one with the same id. The messages that are
+	 * queued after this can be sent to it.
+	 */
+	void add_node(const node & node);
+
+	/**
+	 * @brief Removes a node that left the cluster, and closes the connections to it.
+	 */
+	void remove_node(const std::string & worker_id);
+
+	std::map<std::string, node> get_node_map();
+
+	/**
+	 * @brief Sets whether the buffers of the messages are compressed before they are sent
+	 */
+	void set_compression_mode(compression_mode mode){
+		compression.set_mode(mode);
+	}
+
+	/**
+	 * @brief Changes how many messages are sent concurrently, as the num_threads of the constructor. The threads
+	 * that are removed finish the message they are sending first.
+	 */
+	void set_num_threads(int num_threads){
+		pool.resize(num_threads);
+	}
 private:
 	static message_sender * instance;
 
 	ctpl::thread_pool<BlazingThread> pool;
 	std::shared_ptr<ral::cache::CacheMachine> output_cache;
+	std::mutex nodes_mutex;
 	std::map<std::string, node> node_address_map;
 	blazing_protocol protocol;
 	ucp_worker_h origin;
@@ -70,6 +102,7 @@ private:
 	int ral_id;
 	bool polling_started{false};
 	bool require_acknowledge;
+	compression_policy compression;
 };
 
 }  // namespace comm
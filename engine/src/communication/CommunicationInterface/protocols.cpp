@@ -1,4 +1,5 @@
 
+#include <algorithm>
 #include <map>
 #include <vector>
 
@@ -9,6 +10,10 @@
 #include <ucp/api/ucp.h>
 #include <ucp/api/ucp_def.h>
 #include <thread>
+#include <cstring>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 
 
 #include "cache_machine/CacheMachine.h"
@@ -23,14 +28,19 @@ constexpr size_t FILE_RETRY_DELAY = 20;
 namespace io{
 
 
-	void read_from_socket(int socket_fd, void * data, size_t read_size){
+	bool try_read_from_socket(int socket_fd, void * data, size_t read_size){
         try {
             size_t amount_read = 0;
             int bytes_read = 0;
             size_t count_invalids = 0;
             while (amount_read < read_size && count_invalids < NUMBER_RETRIES) {
                 bytes_read = read(socket_fd, data + amount_read, read_size - amount_read); 
-                if (bytes_read != -1) {
+                if (bytes_read == 0) {
+                    if (amount_read == 0) {
+                        return false; // the other side closed the connection
+                    }
+                    throw std::runtime_error("The connection was closed in the middle of a message");
+                } else if (bytes_read != -1) {
                     amount_read += bytes_read;
                     count_invalids = 0;
                 } else {
@@ -46,6 +56,7 @@ namespace io{
             if(amount_read < read_size){
                 throw std::runtime_error("Could not read complete message from socket with errno "  + std::to_string(errno));
             }
+            return true;
         } catch(std::exception & e){
             std::shared_ptr<spdlog::logger> logger = spdlog::get("batch_logger");
             if (logger){
@@ -56,6 +67,12 @@ namespace io{
 	    }
     }
 
+	void read_from_socket(int socket_fd, void * data, size_t read_size){
+        if (!try_read_from_socket(socket_fd, data, read_size)) {
+            throw std::runtime_error("Could not read from socket, the connection was closed");
+        }
+    }
+
     void write_to_socket(int socket_fd, const void * data, size_t write_size){
 		try {
             size_t amount_written = 0;
@@ -126,10 +143,44 @@ ucp_progress_manager * ucp_progress_manager::get_instance() {
 	return instance;
 }
 
+int ucp_progress_manager::progress_thread_core = -1;
+
+void ucp_progress_manager::set_progress_thread_core(int core) {
+    progress_thread_core = core;
+}
+
 ucp_progress_manager::ucp_progress_manager(ucp_worker_h ucp_worker, size_t request_size) :
  _request_size{request_size}, ucp_worker{ucp_worker} {
+    // when ucx can tell us that the worker has events we sleep on its file descriptor instead of polling it,
+    // which needs the worker to be made with UCP_FEATURE_WAKEUP
+    if (ucp_worker_get_efd(ucp_worker, &worker_fd) != UCS_OK) {
+        worker_fd = -1;
+    }
+    wakeup_fd = eventfd(0, EFD_NONBLOCK);
+    epoll_fd = epoll_create1(0);
+    if (worker_fd >= 0 && wakeup_fd >= 0 && epoll_fd >= 0) {
+        struct epoll_event event;
+        std::memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN;
+        event.data.fd = worker_fd;
+        bool added = epoll_ctl(epoll_fd, EPOLL_CTL_ADD, worker_fd, &event) == 0;
+        event.data.fd = wakeup_fd;
+        added = added && epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wakeup_fd, &event) == 0;
+        if (!added) {
+            worker_fd = -1;
+        }
+    } else {
+        worker_fd = -1;
+    }
+
     std::thread t([this]{
         cudaSetDevice(0);
+        if (progress_thread_core >= 0) {
+            cpu_set_t cpu_set;
+            CPU_ZERO(&cpu_set);
+            CPU_SET(progress_thread_core, &cpu_set);
+            pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpu_set);
+        }
         this->check_progress();
     });
     t.detach();
@@ -140,76 +191,111 @@ void ucp_progress_manager::add_recv_request(char * request, std::function<void()
         delete request;
         callback();
     }else{
-        std::lock_guard<std::mutex> lock(request_mutex);
-        recv_requests.insert({request, callback});
-        cv.notify_all(); 
+        submit_request(new pending_request{{request, callback}, nullptr});
     }
-           
 }
 
 
 void ucp_progress_manager::add_send_request(char * request, std::function<void()> callback, ucs_status_t status){
-    // if(status == UCS_OK){
-    //     delete request;
-    //     callback();
-    // }else{
-        std::lock_guard<std::mutex> lock(request_mutex);
-        send_requests.insert({request, callback});
-        cv.notify_all();
-    // }
+    submit_request(new pending_request{{request, callback}, nullptr});
+}
+
+void ucp_progress_manager::submit_request(pending_request * pending) {
+    // the default sequentially consistent ordering is needed here and in sleep_until_events: either the progress
+    // thread sees this request before it sleeps, or we see that it sleeps and wake it up
+    pending->next = submitted_requests.load();
+    while(!submitted_requests.compare_exchange_weak(pending->next, pending)) {}
 
+    if (sleeping.load()) {
+        uint64_t one = 1;
+        ssize_t written = write(wakeup_fd, &one, sizeof(one));
+        (void) written; // if the counter is full the progress thread is already going to wake up
+    }
+}
+
+void ucp_progress_manager::wait_for_progress(std::chrono::microseconds max_wait) {
+    std::unique_lock<std::mutex> lock(progress_mutex);
+    size_t current_generation = progress_generation;
+    progress_cv.wait_for(lock, max_wait, [this, current_generation] { return progress_generation != current_generation; });
+}
+
+void ucp_progress_manager::take_submitted_requests() {
+    pending_request * pending = submitted_requests.exchange(nullptr);
+    // the submissions are a stack, so they are reversed to keep the order in which they came
+    std::vector<pending_request *> taken;
+    for(; pending != nullptr; pending = pending->next) {
+        taken.push_back(pending);
+    }
+    for(auto it = taken.rbegin(); it != taken.rend(); ++it) {
+        active_requests.push_back(std::move((*it)->request));
+        delete *it;
+    }
+}
+
+void ucp_progress_manager::sleep_until_events(bool has_active_requests) {
+    if (worker_fd < 0) {
+        if (!has_active_requests) {
+            std::this_thread::sleep_for(idle_poll_interval);
+        }
+        return;
+    }
+
+    sleeping.store(true);
+    // a request submitted before sleeping was set true would not wake us up, so they are checked again
+    if (submitted_requests.load() == nullptr && ucp_worker_arm(ucp_worker) == UCS_OK) {
+        struct epoll_event events[2];
+        // some transports don't signal the file descriptor, so the active requests are checked once in a while anyway
+        int timeout_ms = has_active_requests ? 1 : 100;
+        int num_events = epoll_wait(epoll_fd, events, 2, timeout_ms);
+        for (int i = 0; i < num_events; i++) {
+            if (events[i].data.fd == wakeup_fd) {
+                uint64_t count;
+                ssize_t read_bytes = read(wakeup_fd, &count, sizeof(count));
+                (void) read_bytes;
+            }
+        }
+    }
+    sleeping.store(false);
 }
 
 void ucp_progress_manager::check_progress(){
     try {
         while(true){
-            std::set<request_struct> cur_send_requests;
-            std::set<request_struct> cur_recv_requests;
-            {
-                CodeTimer blazing_timer;
-                std::unique_lock<std::mutex> lock(request_mutex);
-                
-                cv.wait_for(lock,5ms,[this]{
-                    return (send_requests.size() + recv_requests.size()) > 0;
-                });
-
-                cur_send_requests = send_requests;
-                cur_recv_requests = recv_requests;
-            }
+            take_submitted_requests();
 
-            ucp_worker_progress(ucp_worker);
+            bool made_progress = false;
+            while(ucp_worker_progress(ucp_worker) != 0) {
+                made_progress = true;
+            }
+            if (made_progress) {
+                std::lock_guard<std::mutex> lock(progress_mutex);
+                progress_generation++;
+                progress_cv.notify_all();
+            }
 
-            for(const auto & req_struct : cur_send_requests){
+            // only this thread touches the active requests, so the callbacks run without holding any lock
+            size_t num_remaining = 0;
+            for(size_t i = 0; i < active_requests.size(); i++){
+                auto & req_struct = active_requests[i];
                 auto status = ucp_request_check_status(req_struct.request + _request_size);
-
                 if (status == UCS_OK){
-
                     req_struct.callback();
-                    {
-                        std::lock_guard<std::mutex> lock(request_mutex);
-                        this->send_requests.erase(req_struct);
-                    }
                     delete req_struct.request;
                 } else if (status != UCS_INPROGRESS){
-                    throw std::runtime_error("Communication error in check_progress for send_requests.");
-                }
-            }
-
-            for(const auto & req_struct : cur_recv_requests){
-                auto status = ucp_request_check_status(req_struct.request + _request_size);
-                if (status == UCS_OK){
-
-                    req_struct.callback();
-                    {
-                        std::lock_guard<std::mutex> lock(request_mutex);
-                        this->recv_requests.erase(req_struct);
+                    throw std::runtime_error("Communication error in check_progress.");
+                } else {
+                    if (num_remaining != i) {
+                        active_requests[num_remaining] = std::move(req_struct);
                     }
-                    delete req_struct.request;
-                }else if (status != UCS_INPROGRESS){
-                    throw std::runtime_error("Communication error in check_progress for recv_requests.");
+                    num_remaining++;
                 }
             }
+            bool completed_requests = num_remaining != active_requests.size();
+            active_requests.resize(num_remaining);
 
+            if (!made_progress && !completed_requests) {
+                sleep_until_events(!active_requests.empty());
+            }
         }
     } catch(std::exception & e){
         std::shared_ptr<spdlog::logger> logger = spdlog::get("batch_logger");
@@ -224,10 +310,13 @@ void ucp_progress_manager::check_progress(){
 
 
 void graphs_info::register_graph(int32_t ctx_token, std::shared_ptr<ral::cache::graph> graph){
+	std::lock_guard<std::mutex> lock(_graphs_mutex);
 	_ctx_token_to_graph_map.insert({ctx_token, graph});
 }
 
 void graphs_info::deregister_graph(int32_t ctx_token){
+	// the kernels are cleared with the lock held, so that get_progress never sees them half cleared
+	std::lock_guard<std::mutex> lock(_graphs_mutex);
 	if(_ctx_token_to_graph_map.find(ctx_token) != _ctx_token_to_graph_map.end()){
         _ctx_token_to_graph_map[ctx_token]->clear_kernels();
 		_ctx_token_to_graph_map.erase(ctx_token);
@@ -236,12 +325,22 @@ void graphs_info::deregister_graph(int32_t ctx_token){
     }
 }
 std::shared_ptr<ral::cache::graph> graphs_info::get_graph(int32_t ctx_token) {
+	std::lock_guard<std::mutex> lock(_graphs_mutex);
 	if(_ctx_token_to_graph_map.find(ctx_token) == _ctx_token_to_graph_map.end()){
 		return nullptr;
 	}
     return _ctx_token_to_graph_map.at(ctx_token);
 }
 
+std::map<int32_t, ral::cache::graph_progress> graphs_info::get_progress() {
+	std::lock_guard<std::mutex> lock(_graphs_mutex);
+	std::map<int32_t, ral::cache::graph_progress> progress;
+	for (auto & graph : _ctx_token_to_graph_map) {
+		progress[graph.first] = graph.second->get_progress();
+	}
+	return progress;
+}
+
 
 ucx_buffer_transport::ucx_buffer_transport(size_t request_size,
     ucp_worker_h origin_node,
@@ -388,40 +487,126 @@ tcp_buffer_transport::tcp_buffer_transport(
         : buffer_transport(metadata, buffer_sizes, column_transports, chunked_column_infos, destinations,require_acknowledge),
         ral_id{ral_id}, allocate_copy_buffer_pool{allocate_copy_buffer_pool} {
 
-        //Initialize connection to get
-    
-    //metadata.print();
-    for(auto destination : destinations){
-        int socket_fd;
-        struct sockaddr_in address;
-
-        if ((socket_fd = socket(AF_INET, SOCK_STREAM, 0)) < 0)
-        {
-            throw std::runtime_error("Could not open communication socket");
+    // the connections are taken in the same order by every transport, so that two transports
+    // can't wait on each other for the last connection to a node that the other one holds
+    std::vector<node> sorted_destinations = destinations;
+    std::sort(sorted_destinations.begin(), sorted_destinations.end(), [](const node & a, const node & b) { return a.id() < b.id(); });
+    try {
+        for(auto destination : sorted_destinations){
+            socket_fds.push_back(tcp_connection_pool::get_instance().get_connection(destination));
+            socket_destinations.push_back(destination);
         }
-        address.sin_family = AF_INET;
-        address.sin_port = htons(destination.port());
-
-        int error_code = inet_pton(AF_INET, destination.ip().c_str(), &address.sin_addr);
-        if(error_code <=0) // inet_pton returns 1 on success, 0 or -1 on fail
-        {
-            std::string node_info = "Index: " + std::to_string(destination.index()) + " Id: " + destination.id() + " IP: " + destination.ip() + " Port: " + std::to_string(destination.port());
-            throw std::runtime_error("Invalid Communication Address. Errno: " + std::to_string(errno) + " Could not get address of node " + node_info);
+    } catch(...) {
+        for(size_t i = 0; i < socket_fds.size(); i++){
+            tcp_connection_pool::get_instance().release_connection(socket_destinations[i], socket_fds[i], true);
         }
-        error_code = connect(socket_fd, (struct sockaddr *)&address, sizeof(address));
-        if (error_code < 0) // connect returns 0 on success, -1 on fail
-        {
-            std::string node_info = "Index: " + std::to_string(destination.index()) + " Id: " + destination.id() + " IP: " + destination.ip() + " Port: " + std::to_string(destination.port());
-            throw std::runtime_error("Invalid Communication Address could not connect to node. Errno: " + std::to_string(errno) + " Node is: " + node_info);
+        throw;
+    }
+}
+
+tcp_connection_pool & tcp_connection_pool::get_instance() {
+    static tcp_connection_pool instance;
+    return instance;
+}
+
+void tcp_connection_pool::set_max_connections_per_node(std::size_t max_connections_per_node) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    this->max_connections_per_node = std::max(max_connections_per_node, (std::size_t)1);
+    cv.notify_all();
+}
+
+int tcp_connection_pool::get_connection(const node & destination) {
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto & node_connections = connections[destination.id()];
+        cv.wait(lock, [this, &node_connections] {
+            return !node_connections.idle.empty() || node_connections.num_connections < max_connections_per_node;
+        });
+        if (!node_connections.idle.empty()) {
+            int socket_fd = node_connections.idle.back();
+            node_connections.idle.pop_back();
+            return socket_fd;
         }
-        socket_fds.push_back(socket_fd);
+        node_connections.num_connections++;
+    }
+
+    try {
+        return connect_to_node(destination);
+    } catch(...) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        connections[destination.id()].num_connections--;
+        cv.notify_all();
+        throw;
+    }
+}
+
+void tcp_connection_pool::release_connection(const node & destination, int socket_fd, bool reusable) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto & node_connections = connections[destination.id()];
+    if (node_connections.num_closing > 0) {
+        // it was made before the node left or moved
+        node_connections.num_closing--;
+        reusable = false;
+    }
+    if (reusable) {
+        node_connections.idle.push_back(socket_fd);
+    } else {
+        close(socket_fd);
+        node_connections.num_connections--;
+    }
+    cv.notify_all();
+}
+
+void tcp_connection_pool::close_connections(const std::string & node_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = connections.find(node_id);
+    if (it == connections.end()) {
+        return;
+    }
+    auto & node_connections = it->second;
+    for (int socket_fd : node_connections.idle) {
+        close(socket_fd);
+    }
+    node_connections.num_connections -= node_connections.idle.size();
+    node_connections.idle.clear();
+    node_connections.num_closing = node_connections.num_connections;
+    cv.notify_all();
+}
+
+int tcp_connection_pool::connect_to_node(const node & destination) {
+    int socket_fd;
+    struct sockaddr_in address;
+
+    if ((socket_fd = socket(AF_INET, SOCK_STREAM, 0)) < 0)
+    {
+        throw std::runtime_error("Could not open communication socket");
+    }
+    address.sin_family = AF_INET;
+    address.sin_port = htons(destination.port());
+
+    int error_code = inet_pton(AF_INET, destination.ip().c_str(), &address.sin_addr);
+    if(error_code <=0) // inet_pton returns 1 on success, 0 or -1 on fail
+    {
+        close(socket_fd);
+        std::string node_info = "Index: " + std::to_string(destination.index()) + " Id: " + destination.id() + " IP: " + destination.ip() + " Port: " + std::to_string(destination.port());
+        throw std::runtime_error("Invalid Communication Address. Errno: " + std::to_string(errno) + " Could not get address of node " + node_info);
     }
+    error_code = connect(socket_fd, (struct sockaddr *)&address, sizeof(address));
+    if (error_code < 0) // connect returns 0 on success, -1 on fail
+    {
+        close(socket_fd);
+        std::string node_info = "Index: " + std::to_string(destination.index()) + " Id: " + destination.id() + " IP: " + destination.ip() + " Port: " + std::to_string(destination.port());
+        throw std::runtime_error("Invalid Communication Address could not connect to node. Errno: " + std::to_string(errno) + " Node is: " + node_info);
+    }
+    return socket_fd;
 }
 
 void tcp_buffer_transport::send_begin_transmission(){
     std::vector<char> buffer_to_send = detail::serialize_metadata_and_transports_and_buffer_sizes(metadata, column_transports, chunked_column_infos, buffer_sizes);
 	auto size_to_send = buffer_to_send.size();
 
+    // a connection that failed in the middle of a message can't be used for another one
+    connections_reusable = false;
     for (auto socket_fd : socket_fds){
         //write out begin_message_size
         io::write_to_socket(socket_fd, &size_to_send ,sizeof(size_to_send));
@@ -432,7 +617,7 @@ void tcp_buffer_transport::send_begin_transmission(){
         //}
         increment_begin_transmission();
     }
-
+    connections_reusable = buffer_sizes.empty();
 }
 void tcp_buffer_transport::receive_acknowledge(){
     for(auto & elem : transmitted_acknowledgements){
@@ -446,7 +631,9 @@ void tcp_buffer_transport::send_impl(const char * buffer, size_t buffer_size){
             io::write_to_socket(socket_fd, buffer,buffer_size);
             increment_frame_transmission();
         }
-        
+        if (++buffers_written == buffer_sizes.size()) {
+            connections_reusable = true;
+        }
     }catch(const std::exception & e ){
         std::shared_ptr<spdlog::logger> logger = spdlog::get("batch_logger");
         if (logger){
@@ -459,8 +646,8 @@ void tcp_buffer_transport::send_impl(const char * buffer, size_t buffer_size){
 }
 
 tcp_buffer_transport::~tcp_buffer_transport(){
-    for (auto socket_fd : socket_fds){
-        close(socket_fd);
+    for(size_t i = 0; i < socket_fds.size(); i++){
+        tcp_connection_pool::get_instance().release_connection(socket_destinations[i], socket_fds[i], connections_reusable);
     }
 }
 
@@ -2,6 +2,9 @@
 
 #include <transport/ColumnTransport.h>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
 
 #include "bufferTransport.hpp"
 #include "messageReceiver.hpp"
@@ -12,6 +15,10 @@
 
 namespace io{
     void read_from_socket(int socket_fd, void * data, size_t read_size);
+    /**
+     * @brief Like read_from_socket, but it returns false instead of throwing if the connection was closed before anything was read
+     */
+    bool try_read_from_socket(int socket_fd, void * data, size_t read_size);
     void write_to_socket(int socket_fd, const void * data, size_t read_size);
 }
 
@@ -20,14 +27,31 @@ namespace comm {
 
 
 
+/**
+ * Progresses the ucp worker and calls back the requests that completed, from a thread of its own.
+ * The requests are submitted through a lock free stack that only the progress thread empties, so submitting
+ * one does not wait on the progress thread. When nothing happens the progress thread arms the worker and
+ * sleeps on its file descriptor until ucx has events for it or a new request is submitted.
+ */
 class ucp_progress_manager{
 
 public:
 
    	static ucp_progress_manager * get_instance(ucp_worker_h ucp_worker, size_t request_size);
     static ucp_progress_manager * get_instance();
+
+    /**
+     * @brief Pins the progress thread to a cpu core. It has to be called before the first get_instance. -1 does not pin it.
+     */
+    static void set_progress_thread_core(int core);
+
     void add_recv_request(char * request, std::function<void()> callback, ucs_status_t status);
     void add_send_request(char * request, std::function<void()> callback, ucs_status_t status);
+
+    /**
+     * @brief Waits until the worker makes some progress, or for max_wait at most
+     */
+    void wait_for_progress(std::chrono::microseconds max_wait);
 private:
    struct request_struct{
         char * request;
@@ -36,16 +60,33 @@ private:
             return request < other.request;
         }
     };
+    struct pending_request {
+        request_struct request;
+        pending_request * next;
+    };
     ucp_progress_manager(ucp_worker_h ucp_worker,size_t request_size);
    	ucp_progress_manager(ucp_progress_manager &&) = delete;
 	ucp_progress_manager(const ucp_progress_manager &) = delete;
 	ucp_progress_manager & operator=(ucp_progress_manager &&) = delete;
 	ucp_progress_manager & operator=(const ucp_progress_manager &) = delete;
+
+    void submit_request(pending_request * pending);
+    void take_submitted_requests();
+    void sleep_until_events(bool has_active_requests);
+
+    static int progress_thread_core;
+    static constexpr std::chrono::microseconds idle_poll_interval{100}; /**< How long the progress thread sleeps when it can't wait on the worker file descriptor */
+
     size_t _request_size;
-    std::mutex request_mutex;
-    std::condition_variable cv;
-    std::set<request_struct> send_requests;
-    std::set<request_struct> recv_requests;
+    std::atomic<pending_request *> submitted_requests{nullptr};
+    std::vector<request_struct> active_requests; /**< only used by the progress thread */
+    std::atomic<bool> sleeping{false};
+    int worker_fd = -1;
+    int wakeup_fd = -1;
+    int epoll_fd = -1;
+    std::mutex progress_mutex;
+    std::condition_variable progress_cv;
+    size_t progress_generation = 0;
     ucp_worker_h ucp_worker;
     void check_progress();
 };
@@ -75,6 +116,11 @@ public:
 
     std::shared_ptr<ral::cache::graph> get_graph(int32_t ctx_token);
 
+    /**
+     * @brief Get the progress of the kernels of every query that is registered, by ctx_token.
+     */
+    std::map<int32_t, ral::cache::graph_progress> get_progress();
+
 private:
     graphs_info() = default;
 	graphs_info(graphs_info &&) = delete;
@@ -82,6 +128,7 @@ private:
 	graphs_info & operator=(graphs_info &&) = delete;
 	graphs_info & operator=(const graphs_info &) = delete;
 
+    std::mutex _graphs_mutex;
     std::map<int32_t, std::shared_ptr<ral::cache::graph>> _ctx_token_to_graph_map;
 };
 
@@ -130,6 +177,57 @@ private:
 };
 
 
+/**
+ * Keeps the tcp connections to the other nodes open between messages, so that a message does not have to wait for a
+ * new connection to be made. A connection carries one message at a time, so the number of connections to a node is
+ * the number of messages that can be in flight to it, and get_connection waits while they are all in use.
+ * @note Myers' singleton.
+ */
+class tcp_connection_pool {
+public:
+    static tcp_connection_pool & get_instance();
+
+    void set_max_connections_per_node(std::size_t max_connections_per_node);
+
+    /**
+     * @brief Gets an idle connection to a node, or makes a new one if all of them are in use and there can be more
+     */
+    int get_connection(const node & destination);
+
+    /**
+     * @brief Gives back a connection once a message was sent over it
+     *
+     * @param reusable False if the connection was left in the middle of a message, and has to be closed
+     */
+    void release_connection(const node & destination, int socket_fd, bool reusable);
+
+    /**
+     * @brief Closes the idle connections to a node that left the cluster or moved. The ones in use are closed when
+     * they are released.
+     */
+    void close_connections(const std::string & node_id);
+
+private:
+    tcp_connection_pool() = default;
+    tcp_connection_pool(tcp_connection_pool &&) = delete;
+    tcp_connection_pool(const tcp_connection_pool &) = delete;
+    tcp_connection_pool & operator=(tcp_connection_pool &&) = delete;
+    tcp_connection_pool & operator=(const tcp_connection_pool &) = delete;
+
+    int connect_to_node(const node & destination);
+
+    struct node_connections {
+        std::vector<int> idle;
+        std::size_t num_connections = 0; /**< the idle ones and the ones in use */
+        std::size_t num_closing = 0; /**< the ones in use that are closed when they are released */
+    };
+
+    std::mutex mutex_;
+    std::condition_variable cv;
+    std::map<std::string, node_connections> connections; /**< by node id */
+    std::size_t max_connections_per_node = 4;
+};
+
 class tcp_buffer_transport : public buffer_transport {
 public:
 
@@ -154,6 +252,9 @@ private:
     int ral_id;
     int message_id;
     std::vector<int> socket_fds;
+    std::vector<node> socket_destinations; /**< the node every socket in socket_fds is connected to */
+    bool connections_reusable = true;
+    size_t buffers_written = 0;
     ctpl::thread_pool<BlazingThread> * allocate_copy_buffer_pool;
 
 };
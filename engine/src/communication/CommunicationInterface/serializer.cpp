@@ -1,16 +1,51 @@
 #include <cudf/null_mask.hpp>
 #include <cudf/column/column_factories.hpp>
+#include <cudf/copying.hpp>
+#include <cudf/dictionary/dictionary_factories.hpp>
+#include <cudf/dictionary/encode.hpp>
+#include <algorithm>
 #include <cstring>
 
 #include "serializer.hpp"
 #include "communication/messages/MessageUtil.cuh"
+#include "blazing_table/BlazingColumnView.h"
 
 namespace comm {
 
+namespace {
+
+// the columns of a packed table are views of its buffer, which they keep
+std::unique_ptr<ral::frame::BlazingTable> deserialize_packed_table(
+	const std::vector<blazingdb::transport::ColumnTransport> & columns_offsets,
+	std::vector<rmm::device_buffer> & raw_buffers,
+	cudaStream_t stream) {
+	const rmm::device_buffer & metadata_buffer = raw_buffers[columns_offsets[0].packed_metadata];
+	std::vector<uint8_t> metadata(metadata_buffer.size());
+	cudaMemcpyAsync(metadata.data(), metadata_buffer.data(), metadata.size(), cudaMemcpyDeviceToHost, stream);
+	cudaStreamSynchronize(stream);
+
+	auto packed_buffer = std::make_shared<rmm::device_buffer>(std::move(raw_buffers[columns_offsets[0].packed_data]));
+	cudf::table_view packed_view = cudf::unpack(metadata.data(), static_cast<const uint8_t *>(packed_buffer->data()));
+
+	std::vector<std::unique_ptr<ral::frame::BlazingColumn>> columns;
+	std::vector<std::string> column_names;
+	for(auto & column_offset : columns_offsets) {
+		columns.push_back(std::make_unique<ral::frame::BlazingColumnPackedView>(packed_view.column(column_offset.packed_column), packed_buffer));
+		column_names.push_back(std::string{column_offset.metadata.col_name});
+	}
+	return std::make_unique<ral::frame::BlazingTable>(std::move(columns), column_names);
+}
+
+}  // namespace
+
 std::unique_ptr<ral::frame::BlazingTable> deserialize_from_gpu_raw_buffers(
 	const std::vector<blazingdb::transport::ColumnTransport> & columns_offsets,
-	const std::vector<rmm::device_buffer> & raw_buffers,
+	std::vector<rmm::device_buffer> & raw_buffers,
 	cudaStream_t stream) {
+	if(!columns_offsets.empty() && columns_offsets[0].packed_data != -1) {
+		return deserialize_packed_table(columns_offsets, raw_buffers, stream);
+	}
+
 	size_t num_columns = columns_offsets.size();
 	std::vector<std::unique_ptr<cudf::column>> received_samples(num_columns);
 	std::vector<std::string> column_names(num_columns);
@@ -21,7 +56,34 @@ std::unique_ptr<ral::frame::BlazingTable> deserialize_from_gpu_raw_buffers(
 	for(size_t i = 0; i < num_columns; ++i) {
 		auto data_offset = columns_offsets[i].data;
 		auto string_offset = columns_offsets[i].strings_data;
-		if(string_offset != -1) {
+		if(columns_offsets[i].dictionary_indices != -1) {
+			// the distinct values of the column and the index of the value of every row, which are decoded into the column
+			cudf::size_type num_keys = columns_offsets[i].dictionary_keys_size;
+			std::unique_ptr<cudf::column> offsets_column =
+				std::make_unique<cudf::column>(cudf::data_type{cudf::type_id::INT32},
+					num_keys + 1,
+					std::move(raw_buffers[columns_offsets[i].strings_offsets]));
+			std::unique_ptr<cudf::column> chars_column =
+				std::make_unique<cudf::column>(cudf::data_type{cudf::type_id::INT8},
+					columns_offsets[i].strings_data_size,
+					std::move(raw_buffers[columns_offsets[i].strings_data]));
+			auto keys_column = cudf::make_strings_column(
+				num_keys, std::move(offsets_column), std::move(chars_column), 0, rmm::device_buffer{}, stream);
+
+			cudf::size_type num_rows = columns_offsets[i].metadata.size;
+			std::unique_ptr<cudf::column> indices_column =
+				std::make_unique<cudf::column>(cudf::data_type{cudf::type_id::UINT32},
+					num_rows,
+					std::move(raw_buffers[columns_offsets[i].dictionary_indices]));
+			rmm::device_buffer null_mask;
+			if(columns_offsets[i].strings_nullmask != -1)
+				null_mask = rmm::device_buffer(std::move(raw_buffers[columns_offsets[i].strings_nullmask]));
+
+			auto dictionary_column = cudf::make_dictionary_column(std::move(keys_column), std::move(indices_column),
+				std::move(null_mask), columns_offsets[i].metadata.null_count);
+			received_samples[i] = cudf::dictionary::decode(cudf::dictionary_column_view{dictionary_column->view()});
+
+		} else if(string_offset != -1) {
 			cudf::size_type num_strings = columns_offsets[i].metadata.size;
 			std::unique_ptr<cudf::column> offsets_column =
 				std::make_unique<cudf::column>(cudf::data_type{cudf::type_id::INT32},
@@ -69,4 +131,39 @@ std::unique_ptr<ral::frame::BlazingTable> deserialize_from_gpu_raw_buffers(
 	return std::make_unique<ral::frame::BlazingTable>(std::move(unique_table), column_names);
 }
 
+std::vector<blazingdb::transport::ColumnTransport> select_column_transports(
+	const std::vector<blazingdb::transport::ColumnTransport> & columns_offsets,
+	const std::vector<int> & column_indices,
+	std::vector<int> & buffer_indices) {
+	buffer_indices.clear();
+	// the buffers of a packed table are shared by all of its columns, so they are listed once
+	auto renumber = [&buffer_indices](int buffer_index) {
+		if(buffer_index == -1) {
+			return -1;
+		}
+		auto it = std::find(buffer_indices.begin(), buffer_indices.end(), buffer_index);
+		if(it != buffer_indices.end()) {
+			return static_cast<int>(std::distance(buffer_indices.begin(), it));
+		}
+		buffer_indices.push_back(buffer_index);
+		return static_cast<int>(buffer_indices.size()) - 1;
+	};
+
+	std::vector<blazingdb::transport::ColumnTransport> selected_columns_offsets;
+	selected_columns_offsets.reserve(column_indices.size());
+	for(int column_index : column_indices) {
+		blazingdb::transport::ColumnTransport column = columns_offsets[column_index];
+		column.data = renumber(column.data);
+		column.valid = renumber(column.valid);
+		column.strings_data = renumber(column.strings_data);
+		column.strings_offsets = renumber(column.strings_offsets);
+		column.strings_nullmask = renumber(column.strings_nullmask);
+		column.dictionary_indices = renumber(column.dictionary_indices);
+		column.packed_data = renumber(column.packed_data);
+		column.packed_metadata = renumber(column.packed_metadata);
+		selected_columns_offsets.push_back(column);
+	}
+	return selected_columns_offsets;
+}
+
 }  // namespace comm
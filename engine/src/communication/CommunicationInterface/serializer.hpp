@@ -15,14 +15,31 @@ namespace comm {
  * @brief Deserializes column data and metadata into a BlazingTable
  *
  * @param columns_offsets A vector of ColumnTransport containing column metadata
- * @param raw_buffers A vector of device_buffer containing column data
+ * @param raw_buffers A vector of device_buffer containing column data, which are moved into the columns of the table
  *
  * @returns A unique_ptr to BlazingTable created with data from the columns_offsets
- * and raw_buffers vectors.
+ * and raw_buffers vectors. The columns of a packed table are views of its buffer, see
+ * ral::frame::BlazingColumnPackedView.
  */
 std::unique_ptr<ral::frame::BlazingTable> deserialize_from_gpu_raw_buffers(
   const std::vector<blazingdb::transport::ColumnTransport> & columns_offsets,
-  const std::vector<rmm::device_buffer> & raw_buffers,
+  std::vector<rmm::device_buffer> & raw_buffers,
   cudaStream_t stream = 0);
 
+/**
+ * @brief Gets the ColumnTransports of some of the columns of a serialized table, with the positions of their buffers renumbered
+ *
+ * @param columns_offsets A vector of ColumnTransport containing the metadata of all the columns
+ * @param column_indices The indices of the columns to keep, in the order they will have
+ * @param buffer_indices Output. For each buffer position referenced by the returned ColumnTransports, the position
+ * of that buffer among the buffers of the whole table.
+ *
+ * @returns The ColumnTransports of the selected columns, which can be used with deserialize_from_gpu_raw_buffers
+ * together with the buffers listed in buffer_indices.
+ */
+std::vector<blazingdb::transport::ColumnTransport> select_column_transports(
+  const std::vector<blazingdb::transport::ColumnTransport> & columns_offsets,
+  const std::vector<int> & column_indices,
+  std::vector<int> & buffer_indices);
+
 } // namespace comm
@@ -0,0 +1,70 @@
+#include "transportMetrics.hpp"
+
+namespace comm {
+
+const std::string transport_metrics::unknown_peer_id = "unknown";
+
+transport_metrics::transport_metrics() {
+	peers[unknown_peer_id] = std::make_unique<peer_metrics>();
+}
+
+void transport_metrics::register_peers(const std::vector<std::string> & worker_ids) {
+	for (auto & worker_id : worker_ids) {
+		if (peers.find(worker_id) == peers.end()) {
+			peers[worker_id] = std::make_unique<peer_metrics>();
+		}
+	}
+}
+
+peer_metrics & transport_metrics::get_peer(const std::string & worker_id) {
+	auto it = peers.find(worker_id);
+	return it != peers.end() ? *it->second : *peers.at(unknown_peer_id);
+}
+
+std::size_t transport_metrics::latency_bucket(double seconds) {
+	double microseconds = seconds * 1e6;
+	std::size_t bucket = 0;
+	while (bucket < peer_metrics::num_latency_buckets - 1 && microseconds >= static_cast<double>(uint64_t{1} << bucket)) {
+		bucket++;
+	}
+	return bucket;
+}
+
+void transport_metrics::record_send(const std::string & worker_id, std::size_t bytes, double seconds) {
+	auto & peer = get_peer(worker_id);
+	peer.bytes_sent.fetch_add(bytes, std::memory_order_relaxed);
+	peer.messages_sent.fetch_add(1, std::memory_order_relaxed);
+	peer.send_latency_histogram[latency_bucket(seconds)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void transport_metrics::record_receive(const std::string & worker_id, std::size_t bytes) {
+	auto & peer = get_peer(worker_id);
+	peer.bytes_received.fetch_add(bytes, std::memory_order_relaxed);
+	peer.messages_received.fetch_add(1, std::memory_order_relaxed);
+}
+
+void transport_metrics::message_queued(const std::string & worker_id) {
+	get_peer(worker_id).queued_messages.fetch_add(1, std::memory_order_relaxed);
+}
+
+void transport_metrics::message_dequeued(const std::string & worker_id) {
+	get_peer(worker_id).queued_messages.fetch_sub(1, std::memory_order_relaxed);
+}
+
+std::map<std::string, peer_metrics_snapshot> transport_metrics::get_snapshot() const {
+	std::map<std::string, peer_metrics_snapshot> snapshot;
+	for (auto & peer : peers) {
+		peer_metrics_snapshot & peer_snapshot = snapshot[peer.first];
+		peer_snapshot.bytes_sent = peer.second->bytes_sent.load(std::memory_order_relaxed);
+		peer_snapshot.messages_sent = peer.second->messages_sent.load(std::memory_order_relaxed);
+		peer_snapshot.bytes_received = peer.second->bytes_received.load(std::memory_order_relaxed);
+		peer_snapshot.messages_received = peer.second->messages_received.load(std::memory_order_relaxed);
+		peer_snapshot.queued_messages = peer.second->queued_messages.load(std::memory_order_relaxed);
+		for (auto & bucket : peer.second->send_latency_histogram) {
+			peer_snapshot.send_latency_histogram.push_back(bucket.load(std::memory_order_relaxed));
+		}
+	}
+	return snapshot;
+}
+
+}  // namespace comm
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace comm {
+
+/**
+ * @brief The counters of the messages sent to and received from one node.
+ *
+ * All of them are atomics, so the senders and the receivers update them without taking any lock.
+ */
+struct peer_metrics {
+	static constexpr std::size_t num_latency_buckets = 24; /**< Bucket i counts the sends that took less than 2^i microseconds, the last one counts all the slower ones. */
+
+	std::atomic<uint64_t> bytes_sent{0};
+	std::atomic<uint64_t> messages_sent{0};
+	std::atomic<uint64_t> bytes_received{0};
+	std::atomic<uint64_t> messages_received{0};
+	std::atomic<int64_t> queued_messages{0}; /**< Messages to this node that were taken from the output cache and are not sent yet. */
+	std::array<std::atomic<uint64_t>, num_latency_buckets> send_latency_histogram{};
+};
+
+/**
+ * @brief A copy of the counters of a node at some point in time.
+ */
+struct peer_metrics_snapshot {
+	uint64_t bytes_sent = 0;
+	uint64_t messages_sent = 0;
+	uint64_t bytes_received = 0;
+	uint64_t messages_received = 0;
+	int64_t queued_messages = 0;
+	std::vector<uint64_t> send_latency_histogram;
+};
+
+/**
+ * @brief The metrics of the messages between this node and every other node, cheap enough to be always on.
+ *
+ * The counters of the nodes are made by register_peers before any message is sent, and they are never removed,
+ * so finding them does not need any lock either. The messages of the nodes that were not registered are counted
+ * under unknown_peer_id.
+ */
+class transport_metrics {
+public:
+	static transport_metrics & get_instance() {
+		static transport_metrics instance;
+		return instance;
+	}
+
+	static const std::string unknown_peer_id;
+
+	/**
+	 * @brief Makes the counters of these nodes. It must not be called while messages are being sent or received.
+	 */
+	void register_peers(const std::vector<std::string> & worker_ids);
+
+	/**
+	 * @brief Records a message that was sent to a node.
+	 *
+	 * @param worker_id The node the message was sent to
+	 * @param bytes The bytes of its buffers
+	 * @param seconds How long the transport took to send it
+	 */
+	void record_send(const std::string & worker_id, std::size_t bytes, double seconds);
+
+	/**
+	 * @brief Records a message that was received from a node.
+	 *
+	 * @param worker_id The node that sent the message
+	 * @param bytes The bytes of its buffers as they were received
+	 */
+	void record_receive(const std::string & worker_id, std::size_t bytes);
+
+	/**
+	 * @brief Records that a message to a node is waiting to be sent.
+	 */
+	void message_queued(const std::string & worker_id);
+
+	/**
+	 * @brief Records that a message to a node was sent, or failed to.
+	 */
+	void message_dequeued(const std::string & worker_id);
+
+	/**
+	 * @brief Returns the counters of every node, by worker id.
+	 */
+	std::map<std::string, peer_metrics_snapshot> get_snapshot() const;
+
+	/**
+	 * @brief Returns the bucket of the send latency histogram a send that took these seconds goes to.
+	 */
+	static std::size_t latency_bucket(double seconds);
+
+private:
+	transport_metrics();
+	transport_metrics(transport_metrics &&) = delete;
+	transport_metrics(const transport_metrics &) = delete;
+	transport_metrics & operator=(transport_metrics &&) = delete;
+	transport_metrics & operator=(const transport_metrics &) = delete;
+
+	peer_metrics & get_peer(const std::string & worker_id);
+
+	std::map<std::string, std::unique_ptr<peer_metrics>> peers;
+};
+
+/**
+ * @brief Counts a message as queued to some nodes for as long as it lives, see transport_metrics::message_queued.
+ */
+class queued_message_guard {
+public:
+	queued_message_guard(std::vector<std::string> worker_ids) : worker_ids{std::move(worker_ids)} {
+		for (auto & worker_id : this->worker_ids) {
+			transport_metrics::get_instance().message_queued(worker_id);
+		}
+	}
+	queued_message_guard(queued_message_guard && other) : worker_ids{std::move(other.worker_ids)} {
+		other.worker_ids.clear();
+	}
+	queued_message_guard(const queued_message_guard &) = delete;
+	queued_message_guard & operator=(const queued_message_guard &) = delete;
+	~queued_message_guard() {
+		for (auto & worker_id : worker_ids) {
+			transport_metrics::get_instance().message_dequeued(worker_id);
+		}
+	}
+
+private:
+	std::vector<std::string> worker_ids;
+};
+
+}  // namespace comm
@@ -1,4 +1,8 @@
 #include "GPUComponentMessage.h"
+#include "utilities/CommonOperations.h"
+#include "utilities/nvtx.h"
+#include "utilities/StreamForkJoin.h"
+#include <atomic>
 
 using namespace fmt::literals;
 
@@ -6,116 +10,280 @@ namespace ral {
 namespace communication {
 namespace messages {
 
-gpu_raw_buffer_container serialize_gpu_message_to_gpu_containers(ral::frame::BlazingTableView table_view){
-	std::vector<std::size_t> buffer_sizes;
-	std::vector<const char *> raw_buffers;
+namespace {
+
+std::atomic<bool> dictionary_encoding_enabled{false};
+std::atomic<int> packed_transport_min_columns{32};
+
+/**
+ * @brief Serializes the table with cudf::pack, as the buffer with the data of all of its columns and the buffer with
+ * the metadata that describes them, which is copied to the device so that both are copied and sent like the others.
+ */
+gpu_raw_buffer_container serialize_packed_table(ral::frame::BlazingTableView table_view) {
+	cudf::packed_columns packed = cudf::pack(table_view.view());
+	auto metadata = std::make_unique<rmm::device_buffer>(packed.metadata_->data(), packed.metadata_->size());
+
+	std::vector<std::size_t> buffer_sizes{packed.gpu_data->size(), metadata->size()};
+	std::vector<const char *> raw_buffers{(const char *)packed.gpu_data->data(), (const char *)metadata->data()};
 	std::vector<ColumnTransport> column_offset;
-	std::vector<std::unique_ptr<rmm::device_buffer>> temp_scope_holder;
 	for(int i = 0; i < table_view.num_columns(); ++i) {
-		const cudf::column_view&column = table_view.column(i);
-		ColumnTransport col_transport = ColumnTransport{ColumnTransport::MetaData{
-															.dtype = (int32_t)column.type().id(),
-															.size = column.size(),
-															.null_count = column.null_count(),
-															.col_name = {},
-														},
-			.data = -1,
-			.valid = -1,
-			.strings_data = -1,
-			.strings_offsets = -1,
-			.strings_nullmask = -1,
-			.strings_data_size = 0,
-			.strings_offsets_size = 0,
-			.size_in_bytes = 0};
+		const cudf::column_view & column = table_view.column(i);
+		ColumnTransport col_transport;
+		col_transport.metadata.dtype = (int32_t)column.type().id();
+		col_transport.metadata.size = column.size();
+		col_transport.metadata.null_count = column.null_count();
 		strcpy(col_transport.metadata.col_name, table_view.names().at(i).c_str());
+		col_transport.data = -1;
+		col_transport.valid = -1;
+		col_transport.strings_data = -1;
+		col_transport.strings_offsets = -1;
+		col_transport.strings_nullmask = -1;
+		col_transport.packed_data = 0;
+		col_transport.packed_metadata = 1;
+		col_transport.packed_column = i;
+		// the bytes of the buffers are not split by column, so they all count for the first one
+		col_transport.size_in_bytes = i == 0 ? buffer_sizes[0] + buffer_sizes[1] : 0;
+		column_offset.push_back(col_transport);
+	}
+
+	std::vector<std::unique_ptr<rmm::device_buffer>> temp_scope_holder;
+	temp_scope_holder.push_back(std::move(packed.gpu_data));
+	temp_scope_holder.push_back(std::move(metadata));
+	return std::make_tuple(buffer_sizes, raw_buffers, column_offset, std::move(temp_scope_holder));
+}
+
+/**
+ * @brief Adds a strings column as a dictionary, its distinct values and the index of the value of every row, when that
+ * is less than half of its bytes. Returns false, having added nothing, when it is not.
+ */
+bool serialize_strings_as_dictionary(const cudf::strings_column_view & str_col_view,
+	ColumnTransport & col_transport,
+	std::vector<std::size_t> & buffer_sizes,
+	std::vector<const char *> & raw_buffers,
+	std::vector<std::unique_ptr<rmm::device_buffer>> & temp_scope_holder) {
+	std::pair<int32_t, int32_t> char_col_start_end = getCharsColumnStartAndEnd(str_col_view);
+	std::size_t plain_size = (std::size_t) (char_col_start_end.second - char_col_start_end.first) + (str_col_view.size() + 1) * sizeof(int32_t);
+	// every row takes an index of four bytes, so the strings have to be longer than that on average for it to pay off
+	if (plain_size < (std::size_t) str_col_view.size() * sizeof(uint32_t) * 2) {
+		return false;
+	}
 
-		if (column.size() == 0) {
-			// do nothing
-		} else if(column.type().id() == cudf::type_id::STRING) {
-				cudf::strings_column_view str_col_view{column};
-
-				auto offsets_column = str_col_view.offsets();
-				auto chars_column = str_col_view.chars();
-
-				if (str_col_view.size() + 1 == offsets_column.size()){
-					// this column does not come from a buffer than had been zero-copy partitioned
-
-					col_transport.strings_data = raw_buffers.size();
-					buffer_sizes.push_back(chars_column.size());
-					col_transport.size_in_bytes += chars_column.size();
-					raw_buffers.push_back(chars_column.head<char>());
-					col_transport.strings_data_size = chars_column.size();
-
-					col_transport.strings_offsets = raw_buffers.size();
-					col_transport.strings_offsets_size = offsets_column.size() * sizeof(int32_t);
-					buffer_sizes.push_back(col_transport.strings_offsets_size);
-					col_transport.size_in_bytes += col_transport.strings_offsets_size;
-					raw_buffers.push_back(offsets_column.head<char>());
-
-					if(str_col_view.has_nulls()) {
-						col_transport.strings_nullmask = raw_buffers.size();
-						buffer_sizes.push_back(cudf::bitmask_allocation_size_bytes(str_col_view.size()));
-						col_transport.size_in_bytes += cudf::bitmask_allocation_size_bytes(str_col_view.size());
-						raw_buffers.push_back((const char *)str_col_view.null_mask());
-					}
-				} else {
-					// this column comes from a column that was zero-copy partitioned
-
-					std::pair<int32_t, int32_t> char_col_start_end = getCharsColumnStartAndEnd(str_col_view);
-
-					std::unique_ptr<CudfColumn> new_offsets = getRebasedStringOffsets(str_col_view, char_col_start_end.first);
-
-					col_transport.strings_data = raw_buffers.size();
-					col_transport.strings_data_size = char_col_start_end.second - char_col_start_end.first;
-					buffer_sizes.push_back(col_transport.strings_data_size);
-					col_transport.size_in_bytes += col_transport.strings_data_size;
-
-					raw_buffers.push_back(chars_column.head<char>() + char_col_start_end.first);
-					
-					col_transport.strings_offsets = raw_buffers.size();
-					col_transport.strings_offsets_size = new_offsets->size() * sizeof(int32_t);
-					buffer_sizes.push_back(col_transport.strings_offsets_size);
-					col_transport.size_in_bytes += col_transport.strings_offsets_size;
-
-					raw_buffers.push_back(new_offsets->view().head<char>());
-
-					cudf::column::contents new_offsets_contents = new_offsets->release();
-					temp_scope_holder.emplace_back(std::move(new_offsets_contents.data));
-
-					if(str_col_view.has_nulls()) {
-						col_transport.strings_nullmask = raw_buffers.size();
-						buffer_sizes.push_back(cudf::bitmask_allocation_size_bytes(str_col_view.size()));
-						col_transport.size_in_bytes += cudf::bitmask_allocation_size_bytes(str_col_view.size());
-						temp_scope_holder.emplace_back(std::make_unique<rmm::device_buffer>(
-							cudf::copy_bitmask(str_col_view.null_mask(), str_col_view.offset(), str_col_view.offset() + str_col_view.size())));
-						raw_buffers.push_back((const char *)temp_scope_holder.back()->data());
-					}
+	std::unique_ptr<cudf::column> dictionary = cudf::dictionary::encode(str_col_view.parent(), cudf::data_type{cudf::type_id::UINT32});
+	cudf::column_view keys = dictionary->view().child(cudf::dictionary_column_view::keys_column_index);
+	cudf::strings_column_view keys_view{keys};
+	std::size_t dictionary_size = (std::size_t) keys_view.chars_size() + (keys.size() + 1) * sizeof(int32_t) + str_col_view.size() * sizeof(uint32_t);
+	if (dictionary_size * 2 > plain_size) {
+		return false;
+	}
+
+	col_transport.dictionary_keys_size = keys.size();
+	cudf::column::contents dictionary_contents = dictionary->release();
+	cudf::column::contents indices_contents = dictionary_contents.children[cudf::dictionary_column_view::indices_column_index]->release();
+	cudf::column::contents keys_contents = dictionary_contents.children[cudf::dictionary_column_view::keys_column_index]->release();
+	cudf::column::contents offsets_contents = keys_contents.children[cudf::strings_column_view::offsets_column_index]->release();
+	cudf::column::contents chars_contents = keys_contents.children[cudf::strings_column_view::chars_column_index]->release();
+
+	auto add_buffer = [&](std::unique_ptr<rmm::device_buffer> && buffer) {
+		int index = raw_buffers.size();
+		buffer_sizes.push_back(buffer->size());
+		col_transport.size_in_bytes += buffer->size();
+		raw_buffers.push_back((const char *)buffer->data());
+		temp_scope_holder.emplace_back(std::move(buffer));
+		return index;
+	};
+	col_transport.strings_data_size = chars_contents.data->size();
+	col_transport.strings_data = add_buffer(std::move(chars_contents.data));
+	col_transport.strings_offsets_size = offsets_contents.data->size();
+	col_transport.strings_offsets = add_buffer(std::move(offsets_contents.data));
+	col_transport.dictionary_indices = add_buffer(std::move(indices_contents.data));
+	if(str_col_view.has_nulls()) {
+		col_transport.strings_nullmask = add_buffer(std::move(dictionary_contents.null_mask));
+	}
+	return true;
+}
+
+/**
+ * @brief Adds the buffers of a column to a container of its own, with the indices of its buffers in that container.
+ */
+void serialize_column(const cudf::column_view & column, const std::string & name, gpu_raw_buffer_container & container) {
+	std::vector<std::size_t> & buffer_sizes = std::get<0>(container);
+	std::vector<const char *> & raw_buffers = std::get<1>(container);
+	std::vector<ColumnTransport> & column_offset = std::get<2>(container);
+	std::vector<std::unique_ptr<rmm::device_buffer>> & temp_scope_holder = std::get<3>(container);
+	ColumnTransport col_transport = ColumnTransport{ColumnTransport::MetaData{
+														.dtype = (int32_t)column.type().id(),
+														.size = column.size(),
+														.null_count = column.null_count(),
+														.col_name = {},
+													},
+		.data = -1,
+		.valid = -1,
+		.strings_data = -1,
+		.strings_offsets = -1,
+		.strings_nullmask = -1,
+		.strings_data_size = 0,
+		.strings_offsets_size = 0,
+		.dictionary_indices = -1,
+		.dictionary_keys_size = 0,
+		.size_in_bytes = 0};
+	strcpy(col_transport.metadata.col_name, name.c_str());
+
+	if (column.size() == 0) {
+		// do nothing
+	} else if(column.type().id() == cudf::type_id::STRING && dictionary_encoding_enabled &&
+		serialize_strings_as_dictionary(cudf::strings_column_view{column}, col_transport, buffer_sizes, raw_buffers, temp_scope_holder)) {
+		// the column is sent as a dictionary
+	} else if(column.type().id() == cudf::type_id::STRING) {
+			cudf::strings_column_view str_col_view{column};
+
+			auto offsets_column = str_col_view.offsets();
+			auto chars_column = str_col_view.chars();
+
+			if (str_col_view.size() + 1 == offsets_column.size()){
+				// this column does not come from a buffer than had been zero-copy partitioned
+
+				col_transport.strings_data = raw_buffers.size();
+				buffer_sizes.push_back(chars_column.size());
+				col_transport.size_in_bytes += chars_column.size();
+				raw_buffers.push_back(chars_column.head<char>());
+				col_transport.strings_data_size = chars_column.size();
+
+				col_transport.strings_offsets = raw_buffers.size();
+				col_transport.strings_offsets_size = offsets_column.size() * sizeof(int32_t);
+				buffer_sizes.push_back(col_transport.strings_offsets_size);
+				col_transport.size_in_bytes += col_transport.strings_offsets_size;
+				raw_buffers.push_back(offsets_column.head<char>());
+
+				if(str_col_view.has_nulls()) {
+					col_transport.strings_nullmask = raw_buffers.size();
+					buffer_sizes.push_back(cudf::bitmask_allocation_size_bytes(str_col_view.size()));
+					col_transport.size_in_bytes += cudf::bitmask_allocation_size_bytes(str_col_view.size());
+					raw_buffers.push_back((const char *)str_col_view.null_mask());
 				}
-		} else {
-			col_transport.data = raw_buffers.size();
-			buffer_sizes.push_back((std::size_t) column.size() * cudf::size_of(column.type()));
-			col_transport.size_in_bytes += (std::size_t) column.size() * cudf::size_of(column.type());
-
-			raw_buffers.push_back(column.head<char>() + column.offset() * cudf::size_of(column.type())); // here we are getting the beginning of the buffer and manually calculating the offset.
-			if(column.has_nulls()) {
-				col_transport.valid = raw_buffers.size();
-				buffer_sizes.push_back(cudf::bitmask_allocation_size_bytes(column.size()));
-				col_transport.size_in_bytes += cudf::bitmask_allocation_size_bytes(column.size());
-				if (column.offset() == 0){
-					raw_buffers.push_back((const char *)column.null_mask());
-				} else {
+			} else {
+				// this column comes from a column that was zero-copy partitioned
+
+				std::pair<int32_t, int32_t> char_col_start_end = getCharsColumnStartAndEnd(str_col_view);
+
+				std::unique_ptr<CudfColumn> new_offsets = getRebasedStringOffsets(str_col_view, char_col_start_end.first);
+
+				col_transport.strings_data = raw_buffers.size();
+				col_transport.strings_data_size = char_col_start_end.second - char_col_start_end.first;
+				buffer_sizes.push_back(col_transport.strings_data_size);
+				col_transport.size_in_bytes += col_transport.strings_data_size;
+
+				raw_buffers.push_back(chars_column.head<char>() + char_col_start_end.first);
+				
+				col_transport.strings_offsets = raw_buffers.size();
+				col_transport.strings_offsets_size = new_offsets->size() * sizeof(int32_t);
+				buffer_sizes.push_back(col_transport.strings_offsets_size);
+				col_transport.size_in_bytes += col_transport.strings_offsets_size;
+
+				raw_buffers.push_back(new_offsets->view().head<char>());
+
+				cudf::column::contents new_offsets_contents = new_offsets->release();
+				temp_scope_holder.emplace_back(std::move(new_offsets_contents.data));
+
+				if(str_col_view.has_nulls()) {
+					col_transport.strings_nullmask = raw_buffers.size();
+					buffer_sizes.push_back(cudf::bitmask_allocation_size_bytes(str_col_view.size()));
+					col_transport.size_in_bytes += cudf::bitmask_allocation_size_bytes(str_col_view.size());
 					temp_scope_holder.emplace_back(std::make_unique<rmm::device_buffer>(
-						cudf::copy_bitmask(column)));
+						cudf::copy_bitmask(str_col_view.null_mask(), str_col_view.offset(), str_col_view.offset() + str_col_view.size())));
 					raw_buffers.push_back((const char *)temp_scope_holder.back()->data());
 				}
 			}
+	} else {
+		col_transport.data = raw_buffers.size();
+		buffer_sizes.push_back((std::size_t) column.size() * cudf::size_of(column.type()));
+		col_transport.size_in_bytes += (std::size_t) column.size() * cudf::size_of(column.type());
+
+		raw_buffers.push_back(column.head<char>() + column.offset() * cudf::size_of(column.type())); // here we are getting the beginning of the buffer and manually calculating the offset.
+		if(column.has_nulls()) {
+			col_transport.valid = raw_buffers.size();
+			buffer_sizes.push_back(cudf::bitmask_allocation_size_bytes(column.size()));
+			col_transport.size_in_bytes += cudf::bitmask_allocation_size_bytes(column.size());
+			if (column.offset() == 0){
+				raw_buffers.push_back((const char *)column.null_mask());
+			} else {
+				temp_scope_holder.emplace_back(std::make_unique<rmm::device_buffer>(
+					cudf::copy_bitmask(column)));
+				raw_buffers.push_back((const char *)temp_scope_holder.back()->data());
+			}
+		}
+	}
+	column_offset.push_back(col_transport);
+}
+
+// the strings columns, which may be encoded as dictionaries or have their offsets rebased, and the null masks that have
+// to be copied run kernels of their own
+bool serialize_column_runs_kernels(const cudf::column_view & column) {
+	return column.size() > 0 && (column.type().id() == cudf::type_id::STRING || (column.nullable() && column.offset() != 0));
+}
+
+}  // namespace
+
+void set_dictionary_encoding(bool enabled) {
+	dictionary_encoding_enabled = enabled;
+}
+
+void set_packed_transport_min_columns(int min_columns) {
+	packed_transport_min_columns = min_columns;
+}
+
+gpu_raw_buffer_container serialize_gpu_message_to_gpu_containers(ral::frame::BlazingTableView table_view){
+	// the tables with many columns are packed, since a buffer per column, offsets and null mask costs more to copy and
+	// send than their data. The tables with LIST and STRUCT columns are always packed, since cudf::pack keeps their children
+	if ((packed_transport_min_columns > 0 && table_view.num_columns() >= packed_transport_min_columns && table_view.num_rows() > 0) ||
+			ral::utilities::has_nested_columns(table_view.view())) {
+		return serialize_packed_table(table_view);
+	}
+
+	std::vector<std::size_t> buffer_sizes;
+	std::vector<const char *> raw_buffers;
+	std::vector<ColumnTransport> column_offset;
+	std::vector<std::unique_ptr<rmm::device_buffer>> temp_scope_holder;
+	// the columns are serialized at the same time on the streams of the stream_fork_join, when more than one of them
+	// runs kernels, and their buffers are put together in the order of the columns
+	std::vector<gpu_raw_buffer_container> column_containers(table_view.num_columns());
+	std::vector<std::function<void()>> branches;
+	int num_columns_with_kernels = 0;
+	for(int i = 0; i < table_view.num_columns(); ++i) {
+		num_columns_with_kernels += serialize_column_runs_kernels(table_view.column(i)) ? 1 : 0;
+		branches.push_back([&, i] {
+			serialize_column(table_view.column(i), table_view.names().at(i), column_containers[i]);
+		});
+	}
+	if (num_columns_with_kernels > 1) {
+		ral::utilities::stream_fork_join::get_instance().run(branches);
+	} else {
+		for (auto & branch : branches) {
+			branch();
+		}
+	}
+
+	for (auto & column_container : column_containers) {
+		int first_buffer = raw_buffers.size();
+		for (ColumnTransport col_transport : std::get<2>(column_container)) {
+			for (int * buffer_index : {&col_transport.data, &col_transport.valid, &col_transport.strings_data,
+					&col_transport.strings_offsets, &col_transport.strings_nullmask, &col_transport.dictionary_indices}) {
+				if (*buffer_index >= 0) {
+					*buffer_index += first_buffer;
+				}
+			}
+			column_offset.push_back(col_transport);
+		}
+		buffer_sizes.insert(buffer_sizes.end(), std::get<0>(column_container).begin(), std::get<0>(column_container).end());
+		raw_buffers.insert(raw_buffers.end(), std::get<1>(column_container).begin(), std::get<1>(column_container).end());
+		for (auto & buffer : std::get<3>(column_container)) {
+			temp_scope_holder.push_back(std::move(buffer));
 		}
-		column_offset.push_back(col_transport);
 	}
 	return std::make_tuple(buffer_sizes, raw_buffers, column_offset, std::move(temp_scope_holder));
 }
 
-std::unique_ptr<ral::frame::BlazingHostTable> serialize_gpu_message_to_host_table(ral::frame::BlazingTableView table_view, bool use_pinned) {
+std::unique_ptr<ral::frame::BlazingHostTable> serialize_gpu_message_to_host_table(ral::frame::BlazingTableView table_view, bool use_pinned, cudaStream_t stream) {
+	BLAZING_NVTX_RANGE("serialize to host", serialization);
 	std::vector<std::size_t> buffer_sizes;
 	std::vector<const char *> raw_buffers;
 	std::vector<ColumnTransport> column_offset;
@@ -128,21 +296,10 @@ std::unique_ptr<ral::frame::BlazingHostTable> serialize_gpu_message_to_host_tabl
 	typedef std::pair< std::vector<ral::memory::blazing_chunked_column_info>, std::vector<std::unique_ptr<ral::memory::blazing_allocation_chunk> >> buffer_alloc_type;
 	buffer_alloc_type buffers_and_allocations = ral::memory::convert_gpu_buffers_to_chunks(buffer_sizes,use_pinned);
 
-	
-	auto & allocations = buffers_and_allocations.second;
-	size_t buffer_index = 0;
-	for(auto & chunked_column_info : buffers_and_allocations.first){
-		size_t position = 0;
-		for(size_t i = 0; i < chunked_column_info.chunk_index.size(); i++){
-			size_t chunk_index = chunked_column_info.chunk_index[i];
-			size_t offset = chunked_column_info.offset[i];
-			size_t chunk_size = chunked_column_info.size[i];
-			cudaMemcpyAsync((void *) (allocations[chunk_index]->data + offset), raw_buffers[buffer_index] + position, chunk_size, cudaMemcpyDeviceToHost,0);
-			position += chunk_size;
-		}		
-		buffer_index++;
-	}
-	cudaStreamSynchronize(0);
+	// the streams of the tasks are blocking streams, so the copies still come after the work on the default stream
+	// that made the table, but they don't wait for the work of the other tasks
+	std::unique_ptr<rmm::device_buffer> staging = copy_gpu_buffers_to_chunks(raw_buffers, buffers_and_allocations.first, buffers_and_allocations.second, stream);
+	cudaStreamSynchronize(stream);
 
 
 	auto table = std::make_unique<ral::frame::BlazingHostTable>(column_offset, std::move(buffers_and_allocations.first),std::move(buffers_and_allocations.second));
@@ -22,6 +22,8 @@
 #include <cudf/column/column_factories.hpp>
 #include <cudf/types.hpp>
 #include <cudf/strings/strings_column_view.hpp>
+#include <cudf/dictionary/dictionary_column_view.hpp>
+#include <cudf/dictionary/encode.hpp>
 
 #include <execution_kernels/LogicPrimitives.h>
 #include <blazing_table/BlazingHostTable.h>
@@ -36,10 +38,30 @@ using ColumnTransport = blazingdb::transport::ColumnTransport;
 using gpu_raw_buffer_container = std::tuple<std::vector<std::size_t>, std::vector<const char *>,
 											std::vector<ColumnTransport>,
 											std::vector<std::unique_ptr<rmm::device_buffer>> >;
+
+/**
+ * @brief Sets whether the strings columns with few distinct values are serialized as dictionaries, which is set by
+ * ENABLE_DICTIONARY_ENCODED_TRANSPORT when the engine is initialized. They are decoded back into strings columns by
+ * comm::deserialize_from_gpu_raw_buffers, so it only changes what is sent between the nodes and kept in host memory or on disk.
+ */
+void set_dictionary_encoding(bool enabled);
+
+/**
+ * @brief Sets the number of columns from which the tables are serialized packed into a single buffer by cudf::pack,
+ * which is set by PACKED_TRANSPORT_MIN_COLUMNS when the engine is initialized. 0 never packs them. The packed tables
+ * are unpacked by comm::deserialize_from_gpu_raw_buffers without copying their data, and their strings columns are
+ * not dictionary encoded.
+ */
+void set_packed_transport_min_columns(int min_columns);
+
 gpu_raw_buffer_container serialize_gpu_message_to_gpu_containers(ral::frame::BlazingTableView table_view);
 
 
-std::unique_ptr<ral::frame::BlazingHostTable> serialize_gpu_message_to_host_table(ral::frame::BlazingTableView table_view, bool use_pinned = false);
+/**
+ * @brief Copies a table into host chunks, on the stream, which has to be the default stream or a stream that
+ * synchronizes with it, since the table can have been made on the default stream.
+ */
+std::unique_ptr<ral::frame::BlazingHostTable> serialize_gpu_message_to_host_table(ral::frame::BlazingTableView table_view, bool use_pinned = false, cudaStream_t stream = 0);
 
 
 
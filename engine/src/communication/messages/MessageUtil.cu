@@ -1,4 +1,7 @@
+#include <cstdint>
+
 #include <cudf/copying.hpp>
+#include <cudf/utilities/error.hpp>
 
 #include <rmm/exec_policy.hpp>
 #include <rmm/cuda_stream_view.hpp>
@@ -8,6 +11,37 @@ namespace ral {
 namespace communication {
 namespace messages {
 
+namespace {
+
+constexpr std::size_t BATCHED_COPY_MAX_PIECE_BYTES = 64 * 1024;
+constexpr int BATCHED_COPY_BLOCK_SIZE = 256;
+
+struct gather_piece {
+	const char * source;
+	std::size_t staging_offset;
+	std::size_t size;
+};
+
+// every block copies one piece into the staging buffer, eight bytes at a time when both sides are aligned for it
+__global__ void gather_pieces(const gather_piece * pieces, char * staging) {
+	const gather_piece piece = pieces[blockIdx.x];
+	const char * source = piece.source;
+	char * destination = staging + piece.staging_offset;
+	std::size_t copied = 0;
+	if ((reinterpret_cast<std::uintptr_t>(source) | reinterpret_cast<std::uintptr_t>(destination)) % sizeof(uint64_t) == 0) {
+		std::size_t num_words = piece.size / sizeof(uint64_t);
+		for (std::size_t i = threadIdx.x; i < num_words; i += blockDim.x) {
+			reinterpret_cast<uint64_t *>(destination)[i] = reinterpret_cast<const uint64_t *>(source)[i];
+		}
+		copied = num_words * sizeof(uint64_t);
+	}
+	for (std::size_t i = copied + threadIdx.x; i < piece.size; i += blockDim.x) {
+		destination[i] = source[i];
+	}
+}
+
+}  // namespace
+
 	std::pair<int32_t, int32_t> getCharsColumnStartAndEnd(const cudf::strings_column_view & column){
 		cudf::size_type offset = column.offset();
 		cudf::column_view offsets_column = column.offsets();
@@ -42,6 +76,66 @@ namespace messages {
 		return new_offsets;
 	}
 
+	std::unique_ptr<rmm::device_buffer> copy_gpu_buffers_to_chunks(const std::vector<const char *> & raw_buffers,
+		const std::vector<ral::memory::blazing_chunked_column_info> & chunked_column_infos,
+		const std::vector<std::unique_ptr<ral::memory::blazing_allocation_chunk>> & allocations,
+		cudaStream_t stream) {
+
+		struct host_copy {
+			char * destination;
+			const char * source;
+			std::size_t staging_offset; // where the copy starts in the staging buffer, when it is staged
+			std::size_t size;
+			bool staged;
+		};
+		std::vector<host_copy> copies;
+		std::vector<gather_piece> pieces;
+		std::size_t staging_bytes = 0;
+		for (std::size_t buffer_index = 0; buffer_index < chunked_column_infos.size(); buffer_index++) {
+			const auto & chunked_column_info = chunked_column_infos[buffer_index];
+			std::size_t position = 0;
+			for (std::size_t i = 0; i < chunked_column_info.chunk_index.size(); i++) {
+				char * destination = allocations[chunked_column_info.chunk_index[i]]->data + chunked_column_info.offset[i];
+				const char * source = raw_buffers[buffer_index] + position;
+				std::size_t size = chunked_column_info.size[i];
+				position += size;
+				if (size >= BATCHED_COPY_MAX_PIECE_BYTES) {
+					copies.push_back({destination, source, 0, size, false});
+					continue;
+				}
+				pieces.push_back({source, staging_bytes, size});
+				// the pieces that follow each other in the chunks are copied together, as they also do in the staging buffer
+				if (!copies.empty() && copies.back().staged && copies.back().destination + copies.back().size == destination) {
+					copies.back().size += size;
+				} else {
+					copies.push_back({destination, source, staging_bytes, size, true});
+				}
+				staging_bytes += size;
+			}
+		}
+
+		// a single small piece is not worth the kernel
+		if (pieces.size() <= 1) {
+			for (auto & copy : copies) {
+				CUDA_TRY(cudaMemcpyAsync(copy.destination, copy.source, copy.size, cudaMemcpyDeviceToHost, stream));
+			}
+			return nullptr;
+		}
+
+		auto staging = std::make_unique<rmm::device_buffer>(staging_bytes, rmm::cuda_stream_view{stream});
+		rmm::device_buffer device_pieces(pieces.data(), pieces.size() * sizeof(gather_piece), rmm::cuda_stream_view{stream});
+		gather_pieces<<<pieces.size(), BATCHED_COPY_BLOCK_SIZE, 0, stream>>>(
+			static_cast<const gather_piece *>(device_pieces.data()), static_cast<char *>(staging->data()));
+		CUDA_TRY(cudaGetLastError());
+
+		for (auto & copy : copies) {
+			const char * source = copy.staged ? static_cast<const char *>(staging->data()) + copy.staging_offset : copy.source;
+			CUDA_TRY(cudaMemcpyAsync(copy.destination, source, copy.size, cudaMemcpyDeviceToHost, stream));
+		}
+		// the descriptors of the pieces are freed on the stream, after the kernel that reads them
+		return staging;
+	}
+
 }  // namespace messages
 }  // namespace communication
 }  // namespace ral
@@ -3,8 +3,12 @@
 #include <cudf/column/column.hpp>
 #include <cudf/column/column_view.hpp>
 #include <cudf/strings/strings_column_view.hpp>
+#include <rmm/device_buffer.hpp>
 #include <utility>
 #include <memory>
+#include <vector>
+
+#include "bmr/BufferProvider.h"
 
 namespace ral {
 namespace communication {
@@ -14,6 +18,19 @@ namespace messages {
 	
 	std::unique_ptr<cudf::column> getRebasedStringOffsets(const cudf::strings_column_view & column, int32_t chars_column_start);
 
+	/**
+	 * @brief Copies the device buffers into the host chunks where convert_gpu_buffers_to_chunks placed them, on the stream.
+	 *
+	 * The pieces of the buffers smaller than BATCHED_COPY_MAX_PIECE_BYTES are gathered into one device staging buffer by a
+	 * single kernel, so that the tables with many small columns don't make a copy per column, and each run of them that
+	 * is contiguous in the chunks is copied with one copy. The other pieces are copied as they are.
+	 * @return the staging buffer, which has to be kept until the copies are done, or nullptr when there is none.
+	 */
+	std::unique_ptr<rmm::device_buffer> copy_gpu_buffers_to_chunks(const std::vector<const char *> & raw_buffers,
+		const std::vector<ral::memory::blazing_chunked_column_info> & chunked_column_infos,
+		const std::vector<std::unique_ptr<ral::memory::blazing_allocation_chunk>> & allocations,
+		cudaStream_t stream);
+
 }  // namespace messages
 }  // namespace communication
 }  // namespace ral
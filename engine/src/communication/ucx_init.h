@@ -278,11 +278,26 @@ static void request_init(void *request)
 
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
-ucp_context_h CreateUcpContext() {
+// net_devices is in the format of UCX_NET_DEVICES, an empty one keeps the devices that ucx picks. The
+// rendezvous messages, the large ones, are striped over up to max_rails of them.
+ucp_context_h CreateUcpContext(const std::string &net_devices = "",
+                               const std::size_t max_rails = 0) {
   ucp_config_t *config;
   ucs_status_t status = ucp_config_read(NULL, NULL, &config);
   CheckError(status != UCS_OK, "ucp_config_read");
 
+  if (!net_devices.empty()) {
+    status = ucp_config_modify(config, "NET_DEVICES", net_devices.c_str());
+    CheckError(status != UCS_OK, "ucp_config_modify NET_DEVICES",
+               [&config]() { ucp_config_release(config); });
+  }
+  if (max_rails > 0) {
+    status = ucp_config_modify(config, "MAX_RNDV_RAILS",
+                               std::to_string(max_rails).c_str());
+    CheckError(status != UCS_OK, "ucp_config_modify MAX_RNDV_RAILS",
+               [&config]() { ucp_config_release(config); });
+  }
+
   ucp_params_t ucp_params;
   std::memset(&ucp_params, 0, sizeof(ucp_params));
   ucp_params.field_mask = UCP_PARAM_FIELD_FEATURES |
@@ -0,0 +1,147 @@
+#include "ucx_net_devices.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <fstream>
+#include <dirent.h>
+#include <cuda_runtime.h>
+
+#include <blazingdb/io/Util/StringUtil.h>
+
+namespace ral {
+namespace communication {
+
+namespace {
+
+std::string get_real_path(const std::string & path) {
+	char real_path[PATH_MAX];
+	if (realpath(path.c_str(), real_path) == nullptr) {
+		return "";
+	}
+	return std::string(real_path);
+}
+
+std::vector<std::string> list_directory(const std::string & path) {
+	std::vector<std::string> entries;
+	DIR * dir = opendir(path.c_str());
+	if (dir == nullptr) {
+		return entries;
+	}
+	while (struct dirent * entry = readdir(dir)) {
+		std::string name(entry->d_name);
+		if (name != "." && name != "..") {
+			entries.push_back(name);
+		}
+	}
+	closedir(dir);
+	std::sort(entries.begin(), entries.end());
+	return entries;
+}
+
+// the first port of the device that is up, i.e. "mlx5_0:1", or an empty string if none is
+std::string get_active_port(const std::string & ib_device) {
+	std::string ports_path = "/sys/class/infiniband/" + ib_device + "/ports";
+	for (const std::string & port : list_directory(ports_path)) {
+		std::ifstream state_file(ports_path + "/" + port + "/state");
+		std::string state;
+		if (std::getline(state_file, state) && state.find("ACTIVE") != std::string::npos) {
+			return ib_device + ":" + port;
+		}
+	}
+	return "";
+}
+
+}  // namespace
+
+std::size_t get_common_pci_depth(const std::string & pci_path, const std::string & other_pci_path) {
+	std::vector<std::string> components = StringUtil::split(pci_path, "/");
+	std::vector<std::string> other_components = StringUtil::split(other_pci_path, "/");
+	std::size_t depth = 0;
+	while (depth < components.size() && depth < other_components.size() && components[depth] == other_components[depth]) {
+		depth++;
+	}
+	return depth;
+}
+
+int get_physical_device_index(int device_id) {
+	const char * visible_devices = std::getenv("CUDA_VISIBLE_DEVICES");
+	if (visible_devices == nullptr) {
+		return device_id;
+	}
+	std::vector<std::string> devices = StringUtil::split(visible_devices, ",");
+	if (device_id < 0 || static_cast<std::size_t>(device_id) >= devices.size()) {
+		return device_id;
+	}
+	std::string device = devices[device_id];
+	StringUtil::trim(device);
+	// the devices can also be listed by their uuid, those don't have an index
+	if (device.empty() || device.find_first_not_of("0123456789") != std::string::npos) {
+		return device_id;
+	}
+	return std::stoi(device);
+}
+
+std::vector<std::string> get_device_net_devices(int device_id, std::size_t max_devices) {
+	std::vector<std::string> net_devices;
+	char pci_bus_id[32];
+	if (cudaDeviceGetPCIBusId(pci_bus_id, sizeof(pci_bus_id), device_id) != cudaSuccess) {
+		return net_devices;
+	}
+	// sysfs uses lowercase hexadecimal digits in the pci addresses
+	std::string bus_id(pci_bus_id);
+	std::transform(bus_id.begin(), bus_id.end(), bus_id.begin(), ::tolower);
+	std::string gpu_path = get_real_path("/sys/bus/pci/devices/" + bus_id);
+	if (gpu_path.empty()) {
+		return net_devices;
+	}
+
+	std::size_t best_depth = 0;
+	for (const std::string & ib_device : list_directory("/sys/class/infiniband")) {
+		std::string port = get_active_port(ib_device);
+		std::string nic_path = get_real_path("/sys/class/infiniband/" + ib_device + "/device");
+		if (port.empty() || nic_path.empty()) {
+			continue;
+		}
+		std::size_t depth = get_common_pci_depth(gpu_path, nic_path);
+		if (depth > best_depth) {
+			best_depth = depth;
+			net_devices.clear();
+		}
+		if (depth == best_depth && net_devices.size() < max_devices) {
+			net_devices.push_back(port);
+		}
+	}
+	return net_devices;
+}
+
+std::string select_ucx_net_devices(const std::string & setting, int device_id, std::size_t max_rails) {
+	std::string devices = setting;
+	StringUtil::trim(devices);
+	if (devices.empty()) {
+		return "";
+	}
+	if (devices == "AUTO" || devices == "auto") {
+		return StringUtil::join(get_device_net_devices(device_id, max_rails), ",");
+	}
+	if (devices.find('=') == std::string::npos) {
+		return devices;
+	}
+
+	std::string physical_device = std::to_string(get_physical_device_index(device_id));
+	for (const std::string & device_devices : StringUtil::split(devices, ";")) {
+		std::size_t equals = device_devices.find('=');
+		if (equals == std::string::npos) {
+			continue;
+		}
+		std::string device = device_devices.substr(0, equals);
+		if (StringUtil::trim(device) == physical_device) {
+			std::string net_devices = device_devices.substr(equals + 1);
+			return StringUtil::trim(net_devices);
+		}
+	}
+	return "";
+}
+
+}  // namespace communication
+}  // namespace ral
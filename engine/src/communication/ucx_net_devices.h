@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace ral {
+namespace communication {
+
+/**
+ * @brief The number of components at the start of two sysfs paths of pci devices that are the same, i.e. how close
+ * the devices are in the PCIe tree. The devices under the same PCIe switch have more common components than the ones
+ * that only share the root complex.
+ */
+std::size_t get_common_pci_depth(const std::string & pci_path, const std::string & other_pci_path);
+
+/**
+ * @brief Get the index of a GPU among all the GPUs of the machine, from CUDA_VISIBLE_DEVICES when it is set.
+ *
+ * @param device_id The CUDA device, as the process sees it.
+ */
+int get_physical_device_index(int device_id);
+
+/**
+ * @brief Get the network devices that are closest to a GPU in the PCIe topology, the active ports of the InfiniBand
+ * and RoCE NICs, in the format of UCX_NET_DEVICES (i.e. "mlx5_0:1").
+ *
+ * @param device_id The CUDA device.
+ * @param max_devices The most devices that are returned, all of them are at the same distance from the GPU.
+ * @return the devices, or none if the topology is not known.
+ */
+std::vector<std::string> get_device_net_devices(int device_id, std::size_t max_devices);
+
+/**
+ * @brief Chooses the UCX network devices of the engine of a GPU.
+ *
+ * @param setting An empty string for the devices UCX picks, "AUTO" for the ones closest to the GPU, a list of devices
+ * for every GPU like "0=mlx5_0:1,mlx5_1:1;1=mlx5_2:1" where the GPUs are numbered like get_physical_device_index, or a
+ * list of devices for all of them.
+ * @param max_rails The most devices that are picked with "AUTO".
+ * @return the devices in the format of UCX_NET_DEVICES, or an empty string for the devices UCX picks.
+ */
+std::string select_ucx_net_devices(const std::string & setting, int device_id, std::size_t max_rails);
+
+}  // namespace communication
+}  // namespace ral
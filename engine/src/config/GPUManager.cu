@@ -1,11 +1,101 @@
 #include <cuda.h>
 #include <cuda_runtime.h>
 #include <cudf/utilities/error.hpp>
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <regex>
+#include <unistd.h>
 #include "GPUManager.cuh"
 
 namespace ral {
 namespace config {
 
+namespace {
+
+std::string get_env(const char * name) {
+	const char * value = std::getenv(name);
+	return value != nullptr ? value : "";
+}
+
+// a size like 4G, 512M or 1073741824
+size_t parse_memory_size(const std::string & value) {
+	std::smatch match;
+	if (!std::regex_match(value, match, std::regex("\\s*([0-9]+)\\s*([KkMmGgTt]?)[Bb]?\\s*"))) {
+		return 0;
+	}
+	size_t size = std::stoull(match[1].str());
+	switch (match[2].str().empty() ? ' ' : std::toupper(match[2].str()[0])) {
+		case 'T': size *= 1024; [[fallthrough]];
+		case 'G': size *= 1024; [[fallthrough]];
+		case 'M': size *= 1024; [[fallthrough]];
+		case 'K': size *= 1024;
+	}
+	return size;
+}
+
+// CUDA_MPS_PINNED_DEVICE_MEM_LIMIT is a list like 0=4G,1=8G of the limits of the devices by their ordinal
+size_t get_mps_memory_limit(int device_id) {
+	std::string limits = get_env("CUDA_MPS_PINNED_DEVICE_MEM_LIMIT");
+	std::regex entry("([0-9]+)\\s*=\\s*([^,]+)");
+	for (auto it = std::sregex_iterator(limits.begin(), limits.end(), entry); it != std::sregex_iterator(); ++it) {
+		if (std::stoi((*it)[1].str()) == device_id) {
+			return parse_memory_size((*it)[2].str());
+		}
+	}
+	return 0;
+}
+
+gpu_partition detect_gpu_partition() {
+	gpu_partition partition;
+	int device_id = 0;
+	cudaGetDevice(&device_id);
+	struct cudaDeviceProp props;
+	cudaGetDeviceProperties(&props, device_id);
+	std::string name = props.name;
+	partition.multiprocessors = props.multiProcessorCount;
+	partition.description = name + ", " + std::to_string(props.multiProcessorCount) + " SMs";
+
+	partition.mig = name.find("MIG") != std::string::npos || get_env("CUDA_VISIBLE_DEVICES").rfind("MIG-", 0) == 0;
+	if (partition.mig) {
+		std::smatch match;
+		if (std::regex_search(name, match, std::regex("([0-9]+)g\\.[0-9]+gb"))) {
+			// the A30 has 4 compute slices, the A100 and the H100 have 7
+			int total_slices = name.find("A30") != std::string::npos ? 4 : 7;
+			partition.compute_fraction = std::min(std::stod(match[1].str()) / total_slices, 1.0);
+		}
+		partition.description += ", MIG instance with " + std::to_string(partition.compute_fraction) + " of the compute";
+	}
+
+	std::string pipe_directory = get_env("CUDA_MPS_PIPE_DIRECTORY");
+	if (pipe_directory.empty()) {
+		pipe_directory = "/tmp/nvidia-mps";
+	}
+	partition.mps = access((pipe_directory + "/control").c_str(), F_OK) == 0;
+	if (partition.mps) {
+		std::string active_thread_percentage = get_env("CUDA_MPS_ACTIVE_THREAD_PERCENTAGE");
+		if (!active_thread_percentage.empty()) {
+			double percentage = std::atof(active_thread_percentage.c_str());
+			if (percentage > 0 && percentage < 100) {
+				partition.compute_fraction *= percentage / 100;
+			}
+		}
+		partition.memory_limit = get_mps_memory_limit(device_id);
+		partition.description += ", MPS client with " + std::to_string(partition.compute_fraction) + " of the compute";
+		if (partition.memory_limit > 0) {
+			partition.description += " and " + std::to_string(partition.memory_limit) + " bytes of memory";
+		}
+	}
+	return partition;
+}
+
+} // namespace
+
+const gpu_partition & get_gpu_partition() {
+	static gpu_partition partition = detect_gpu_partition();
+	return partition;
+}
+
 size_t gpuFreeMemory() {
 	int currentDeviceId = 0;
 	struct cudaDeviceProp props;
@@ -25,6 +115,10 @@ size_t gpuTotalMemory() {
 	size_t free, total;
 	cudaMemGetInfo(&free, &total);
 
+	size_t memory_limit = get_gpu_partition().memory_limit;
+	if (memory_limit > 0) {
+		return std::min(total, memory_limit);
+	}
 	return total;
 }
 
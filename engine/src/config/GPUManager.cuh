@@ -7,7 +7,33 @@
 namespace ral {
 namespace config {
 
+/**
+* The part of the GPU that the engine has when it runs on a MIG instance, or as a client of MPS with a limit of its
+* threads or of its memory. The executor and the memory resources are sized by it.
+*/
+struct gpu_partition {
+	bool mig = false;
+	bool mps = false;
+	int multiprocessors = 0; // the ones of the instance, which under MIG are only those of its slices
+	double compute_fraction = 1.0; // the part of the compute of the whole GPU
+	size_t memory_limit = 0; // the memory that MPS lets this client pin, 0 when only the memory of the GPU limits it
+	std::string description;
+};
+
+/**
+* Detects the partition of the current device, once. MIG is told by the name of the device (like
+* A100-SXM4-40GB MIG 3g.20gb, whose 3 of 7 compute slices are the fraction) or by a MIG- uuid in CUDA_VISIBLE_DEVICES,
+* and MPS by its pipe directory. The limits of an MPS client are the ones of CUDA_MPS_ACTIVE_THREAD_PERCENTAGE and
+* CUDA_MPS_PINNED_DEVICE_MEM_LIMIT.
+*/
+const gpu_partition & get_gpu_partition();
+
 size_t gpuFreeMemory();
+
+/**
+* The memory of the device, or of the MPS limit of this client when it is smaller. Under MIG it is already the one of
+* the instance.
+*/
 size_t gpuTotalMemory();
 size_t gpuUsedMemory();
 
@@ -12,14 +12,20 @@
 #include "../io/data_provider/UriDataProvider.h"
 #include "../skip_data/SkipDataProcessor.h"
 #include "../execution_kernels/LogicalFilter.h"
+#include "../execution_kernels/BatchProcessing.h"
+#include "../cache_machine/ResultCursors.h"
+#include "../cache_machine/SpillManager.h"
+#include "../distribution_utils/shuffle_checkpoint.h"
 
 #include <numeric>
+#include <blazingdb/io/Util/StringUtil.h>
 #include <map>
 #include "communication/CommunicationData.h"
 #include <spdlog/spdlog.h>
 #include "utilities/CodeTimer.h"
 #include "communication/CommunicationInterface/protocols.hpp"
 #include "utilities/error.hpp"
+#include "bmr/QueryMemoryTracker.h"
 
 #ifdef MYSQL_SUPPORT
 #include "../io/data_parser/sql/MySQLParser.h"
@@ -36,6 +42,11 @@
 #include "../io/data_provider/sql/SQLiteDataProvider.h"
 #endif
 
+#ifdef ARROW_FLIGHT_SUPPORT
+#include "../io/data_parser/FlightParser.h"
+#include "../io/data_provider/FlightDataProvider.h"
+#endif
+
 using namespace fmt::literals;
 
 std::pair<std::vector<ral::io::data_loader>, std::vector<ral::io::Schema>> get_loaders_and_schemas(
@@ -69,6 +80,33 @@ std::pair<std::vector<ral::io::data_loader>, std::vector<ral::io::Schema>> get_l
 			tableSchema.in_file,
 			tableSchema.row_groups_ids);
 
+		// the files of a bucketed table were given to the workers by their bucket, see create_table
+		auto num_buckets_it = args_map.find("num_buckets");
+		auto bucket_column_it = args_map.find("bucket_column_index");
+		if (num_buckets_it != args_map.end() && bucket_column_it != args_map.end()) {
+			auto bucket_hash_it = args_map.find("bucket_hash");
+			std::string bucket_hash = bucket_hash_it != args_map.end() ? bucket_hash_it->second : "";
+			schema.set_bucketing(std::stoull(bucket_column_it->second), std::stoull(num_buckets_it->second), bucket_hash);
+		}
+
+		// the files that every worker can read, see ral::batch::scan_work_stealing
+		auto shareable_files_it = args_map.find("shareable_files");
+		schema.set_shareable_files(shareable_files_it != args_map.end() && shareable_files_it->second == "True");
+
+		// the columns of a table given to cache_table, and the ones it indexes, as their comma separated indices
+		auto get_column_indices_arg = [&args_map](const std::string & arg_name) {
+			std::vector<int> column_indices;
+			auto it = args_map.find(arg_name);
+			if (it != args_map.end() && !it->second.empty()) {
+				for (const std::string & column_index : StringUtil::split(it->second, ',')) {
+					column_indices.push_back(std::stoi(column_index));
+				}
+			}
+			return column_indices;
+		};
+		schema.set_cached_columns(get_column_indices_arg("cache_columns"));
+		schema.set_index_columns(get_column_indices_arg("index_columns"));
+
     bool isSqlProvider = false;
     std::shared_ptr<ral::io::data_provider> provider;
 
@@ -111,6 +149,14 @@ std::pair<std::vector<ral::io::data_loader>, std::vector<ral::io::Schema>> get_l
       isSqlProvider = true;
 #else
       throw std::runtime_error("ERROR: This BlazingSQL version doesn't support SQLite integration");
+#endif
+    } else if(fileType == ral::io::DataType::ARROW_FLIGHT) {
+#ifdef ARROW_FLIGHT_SUPPORT
+      parser = std::make_shared<ral::io::flight_parser>();
+      provider = std::make_shared<ral::io::flight_data_provider>(ral::io::getFlightInfo(args_map), total_number_of_nodes, self_node_idx);
+      isSqlProvider = true; // like the sql providers, it has no files
+#else
+      throw std::runtime_error("ERROR: This BlazingSQL version doesn't support Arrow Flight");
 #endif
     }
 		std::vector<Uri> uris;
@@ -171,6 +217,42 @@ void fix_column_names_duplicated(std::vector<std::string> & col_names){
 	}
 }
 
+namespace {
+
+// Releases what a query holds in this process once it ends, whether it succeeded, failed or was cancelled, so that
+// the graphs, the memory tracked for it and its spill segments don't outlive a query that threw
+struct query_end_guard {
+	explicit query_end_guard(int32_t ctx_token) : ctx_token(ctx_token) {}
+
+	~query_end_guard() {
+		if (active) {
+			finish();
+		}
+	}
+
+	void finish() {
+		active = false;
+		try {
+			comm::graphs_info::getInstance().deregister_graph(ctx_token);
+			ral::memory::query_memory_tracker::get_instance().finish_query(ctx_token);
+			ral::cache::spill_manager::get_instance().finish_query(std::to_string(ctx_token));
+		} catch (const std::exception & e) {
+			std::shared_ptr<spdlog::logger> logger = spdlog::get("batch_logger");
+			if (logger) {
+				logger->error("|||{info}|||||", "info"_a = "ERROR: Could not finish the query " + std::to_string(ctx_token) + ": " + e.what());
+			}
+		}
+	}
+
+	// the query is not over yet, as when getExecuteGraphResultBatch returns one of its batches
+	void dismiss() { active = false; }
+
+	int32_t ctx_token;
+	bool active = true;
+};
+
+}  // namespace
+
 std::string runGeneratePhysicalGraph(uint32_t masterIndex,
                                      std::vector<std::string> worker_ids,
                                      int32_t ctxToken,
@@ -233,6 +315,7 @@ void startExecuteGraph(std::shared_ptr<ral::cache::graph> graph, int32_t ctx_tok
 
 std::unique_ptr<PartitionedResultSet> getExecuteGraphResult(std::shared_ptr<ral::cache::graph> graph, int32_t ctx_token) {
 	// Execute query
+	query_end_guard query_end(ctx_token);
 
 	std::vector<std::unique_ptr<ral::frame::BlazingTable>> frames;
 	frames = get_execute_graph_results(graph);
@@ -250,10 +333,61 @@ std::unique_ptr<PartitionedResultSet> getExecuteGraphResult(std::shared_ptr<ral:
 	}
 
 	result->skipdata_analysis_fail = false;
+	return result;
+}
+
+std::unique_ptr<PartitionedResultSet> getExecuteGraphResultBatch(std::shared_ptr<ral::cache::graph> graph, int32_t ctx_token) {
+	query_end_guard query_end(ctx_token);
+	auto & output_kernel = static_cast<ral::batch::OutputKernel&>(*(graph->get_last_kernel()));
+	std::unique_ptr<ral::frame::BlazingTable> batch = output_kernel.next_batch();
+
+	std::unique_ptr<PartitionedResultSet> result = std::make_unique<PartitionedResultSet>();
+	result->skipdata_analysis_fail = false;
+	if (batch) {
+		result->names = batch->names();
+		fix_column_names_duplicated(result->names);
+		result->cudfTables.emplace_back(std::move(batch->releaseCudfTable()));
+		query_end.dismiss();
+		return result;
+	}
 
-	comm::graphs_info::getInstance().deregister_graph(ctx_token);
+	// all the batches were taken, so the query is finished like in getExecuteGraphResult, which throws its errors
+	get_execute_graph_results(graph);
 	return result;
 }
+
+int64_t openResultCursor(std::shared_ptr<ral::cache::graph> graph, int32_t ctx_token, int64_t ttl_ms) {
+	query_end_guard query_end(ctx_token);
+	std::vector<std::unique_ptr<ral::frame::BlazingTable>> frames = get_execute_graph_results(graph);
+	query_end.finish();
+
+	return ral::cache::result_cursors::get_instance().open(ctx_token, std::move(frames), std::chrono::milliseconds(ttl_ms));
+}
+
+std::unique_ptr<PartitionedResultSet> fetchResultCursor(int32_t ctx_token, int64_t offset, int64_t num_rows) {
+	std::unique_ptr<ral::frame::BlazingTable> page = ral::cache::result_cursors::get_instance().fetch(ctx_token, offset, num_rows);
+
+	std::unique_ptr<PartitionedResultSet> result = std::make_unique<PartitionedResultSet>();
+	result->names = page->names();
+	fix_column_names_duplicated(result->names);
+	result->cudfTables.emplace_back(std::move(page->releaseCudfTable()));
+	result->skipdata_analysis_fail = false;
+	return result;
+}
+
+bool closeResultCursor(int32_t ctx_token) {
+	return ral::cache::result_cursors::get_instance().close(ctx_token);
+}
+
+bool cancelQuery(int32_t ctx_token) {
+	std::shared_ptr<ral::cache::graph> graph = comm::graphs_info::getInstance().get_graph(ctx_token);
+	if (graph == nullptr) {
+		return false;
+	}
+	graph->cancel();
+	return true;
+}
+
 /*
 std::unique_ptr<ResultSet> performPartition(int32_t masterIndex,
 
@@ -343,6 +477,10 @@ std::unique_ptr<ResultSet> runSkipData(ral::frame::BlazingTableView metadata,
 }
 
 
+void removeShuffleCheckpoint(std::string checkpoint_path) {
+	ral::distribution::shuffle_checkpoint::remove(checkpoint_path);
+}
+
 TableScanInfo getTableScanInfo(std::string logicalPlan){
 
 	std::vector<std::string> relational_algebra_steps, table_names;
@@ -37,3 +37,5 @@ RAISE_ERROR(RegisterFileSystemLocal)
 RAISE_ERROR(InferFolderPartitionMetadata)
 RAISE_ERROR(ResetMaxMemoryUsed)
 RAISE_ERROR(GetMaxMemoryUsed)
+RAISE_ERROR(GetQueryMemoryUsage)
+RAISE_ERROR(GetTransportMetrics)
@@ -17,26 +17,36 @@
 #include <spdlog/sinks/rotating_file_sink.h>
 
 #include <algorithm>
+#include <cmath>
 #include <cuda_runtime.h>
 #include <memory>
 #include <chrono>
 #include <thread>         // std::this_thread::sleep_for
+#include <future>
 #include <fstream>
 #include <utility>
 #include <memory>
 
 #include <blazingdb/io/Config/BlazingContext.h>
+#include <blazingdb/io/FileSystem/HadoopReadConfig.h>
+#include <blazingdb/io/FileSystem/ObjectStoreConfig.h>
+#include <blazingdb/io/FileSystem/ObjectUploadConfig.h>
+#include <blazingdb/io/FileSystem/RemoteFileCache.h>
 #include <blazingdb/io/Library/Logging/CoutOutput.h>
 #include <blazingdb/io/Library/Logging/Logger.h>
 #include "blazingdb/io/Library/Logging/ServiceLogging.h"
 #include <blazingdb/io/Util/StringUtil.h>
 
 #include "communication/ucx_init.h"
+#include "communication/ucx_net_devices.h"
 #include "communication/CommunicationData.h"
 #include "communication/CommunicationInterface/protocols.hpp"
 
 #include <bmr/initializer.h>
 #include <bmr/BlazingMemoryResource.h>
+#include <bmr/QueryMemoryTracker.h>
+#include <bmr/MemoryPressure.h>
+#include <bmr/MemoryTimeline.h>
 
 #include "utilities/error.hpp"
 
@@ -45,12 +55,29 @@
 #include "communication/CommunicationInterface/protocols.hpp"
 #include "communication/CommunicationInterface/messageSender.hpp"
 #include "communication/CommunicationInterface/messageListener.hpp"
+#include "communication/CommunicationInterface/transportMetrics.hpp"
+#include "communication/messages/GPUComponentMessage.h"
 #include "execution_kernels/kernel.h"
 #include "execution_graph/executor.h"
+#include "utilities/RuntimeMetrics.h"
+#include "utilities/EventLog.h"
+#include "Interpreter/jit_expressions.h"
+#include "Interpreter/interpreter_cpp.h"
+#include "Interpreter/interpreter_plan_cache.h"
+#include "io/data_provider/DataPrefetcher.h"
+#include "io/data_parser/metadata/parquet_metadata_cache.h"
+#include "io/data_provider/folder_lister.h"
+#include "io/data_provider/shared_scan.h"
+#include "cache_machine/ManagedMemoryHints.h"
+#include "cache_machine/TableCache.h"
+#include "utilities/ThreadAffinity.h"
+#include "utilities/StreamForkJoin.h"
+#include "config/GPUManager.cuh"
 
 using namespace fmt::literals;
 
 #include "cache_machine/CacheMachine.h"
+#include "cache_machine/SpillManager.h"
 
 #include "engine/initialize.h"
 #include "engine/static.h" // this contains function call for getProductDetails
@@ -142,16 +169,19 @@ auto log_level_str_to_enum(std::string level) {
 }
 
 // simple_log: true (no timestamp or log level)
-void create_logger(std::string fileName,
+// synchronous: true for the loggers whose lines are written by the writer thread of the event_log, as only that thread
+// uses them
+std::shared_ptr<spdlog::logger> create_logger(std::string fileName,
 	std::string loggingName,
 	uint16_t ralId, std::string flush_level,
 	std::string logger_level_wanted,
 	std::size_t max_size_logging,
-	bool simple_log=true) {
+	bool simple_log=true,
+	bool synchronous=false) {
 
 	std::shared_ptr<spdlog::logger> existing_logger = spdlog::get(loggingName);
 	if (existing_logger){ // if logger already exists, dont initialize again
-		return;
+		return existing_logger;
 	}
 
 	auto stdout_sink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
@@ -171,7 +201,12 @@ void create_logger(std::string fileName,
 	// We want ALL levels of info to be registered. So using by default `trace` level
 	rotating_sink->set_level(spdlog::level::trace);
 	spdlog::sinks_init_list sink_list = {stdout_sink, rotating_sink};
-	auto logger = std::make_shared<spdlog::async_logger>(loggingName, sink_list, spdlog::thread_pool(), spdlog::async_overflow_policy::block);
+	std::shared_ptr<spdlog::logger> logger;
+	if (synchronous) {
+		logger = std::make_shared<spdlog::logger>(loggingName, sink_list);
+	} else {
+		logger = std::make_shared<spdlog::async_logger>(loggingName, sink_list, spdlog::thread_pool(), spdlog::async_overflow_policy::block);
+	}
 
 	// level of logs
 	logger->set_level(log_level_str_to_enum(logger_level_wanted));
@@ -180,6 +215,7 @@ void create_logger(std::string fileName,
 
 	spdlog::flush_on(log_level_str_to_enum(flush_level));
 	spdlog::flush_every(std::chrono::seconds(1));
+	return logger;
 }
 
 
@@ -195,11 +231,12 @@ void printLoggerHeader(const std::string pathLogger, const std::string nameLogge
         {"queries_logger",      "ral_id|query_id|start_time|plan|query"},
         {"kernels_logger",      "ral_id|query_id|kernel_id|is_kernel|kernel_type|description"},
         {"kernels_edges_logger","ral_id|query_id|source|sink"},
-        {"task_logger",         "time_started|ral_id|query_id|kernel_id|duration_decaching|duration_execution|input_num_rows|input_num_bytes"},
+        {"task_logger",         "time_started|ral_id|query_id|kernel_id|duration_decaching|duration_execution|input_num_rows|input_num_bytes|kernel_type|max_memory_used"},
         {"cache_events_logger", "ral_id|query_id|message_id|cache_id|num_rows|num_bytes|event_type|timestamp_begin|timestamp_end|description"},
         {"batch_logger",        "log_time|node_id|type|query_id|step|substep|info|duration|extra1|data1|extra2|data2"},
         {"input_comms",         "unique_id|ral_id|query_id|kernel_id|dest_ral_id|dest_ral_count|dest_cache_id|message_id|phase"},
-        {"output_comms",        "unique_id|ral_id|query_id|kernel_id|dest_ral_id|dest_ral_count|dest_cache_id|message_id|phase"}
+        {"output_comms",        "unique_id|ral_id|query_id|kernel_id|dest_ral_id|dest_ral_count|dest_cache_id|message_id|phase"},
+        {"memory_timeline_logger", "timestamp|event|address|bytes|query_id|kernel_id|used_memory|description"}
     };
 
     std::ifstream fileLogger(pathLogger);
@@ -218,6 +255,8 @@ void printLoggerHeader(const std::string pathLogger, const std::string nameLogge
 
 std::mutex initialize_lock;
 bool initialized = false;
+comm::blazing_protocol initialized_protocol = comm::blazing_protocol::tcp;
+bool initialized_single_node = true;
 
 /**
 * Initializes the engine and gives us shared pointers to both our transport out cache
@@ -263,6 +302,19 @@ std::pair<std::pair<std::shared_ptr<CacheMachine>,std::shared_ptr<CacheMachine>
 	}
 	BlazingRMMInitialize(allocation_mode, initial_pool_size, maximum_pool_size, allocator_logging_file, device_mem_resouce_consumption_thresh);
 
+	long long pool_compaction_interval_ms = 60000;
+	config_it = config_options.find("DEVICE_POOL_COMPACTION_INTERVAL_MS");
+	if (config_it != config_options.end()){
+		pool_compaction_interval_ms = std::stoll(config_options["DEVICE_POOL_COMPACTION_INTERVAL_MS"]);
+	}
+	double pool_compaction_min_fragmentation = 0.5;
+	config_it = config_options.find("DEVICE_POOL_COMPACTION_MIN_FRAGMENTATION");
+	if (config_it != config_options.end()){
+		pool_compaction_min_fragmentation = std::stod(config_options["DEVICE_POOL_COMPACTION_MIN_FRAGMENTATION"]);
+	}
+	blazing_device_memory_resource::getInstance().set_compaction_policy(
+		std::chrono::milliseconds(pool_compaction_interval_ms), pool_compaction_min_fragmentation);
+
 	// ---------------------------------------------------------------------------
 	// DISCLAIMER
 	// TODO: Support proper locale support for non-US cases (percy)
@@ -356,6 +408,18 @@ std::pair<std::pair<std::shared_ptr<CacheMachine>,std::shared_ptr<CacheMachine>
         enable_other_engine_logs = config_options["ENABLE_OTHER_ENGINE_LOGS"];
     }
 
+    std::string enable_memory_timeline_logs;
+    log_it = config_options.find("ENABLE_MEMORY_TIMELINE_LOGS");
+    if (log_it != config_options.end()){
+        enable_memory_timeline_logs = config_options["ENABLE_MEMORY_TIMELINE_LOGS"];
+    }
+
+	bool async_event_logs = true;
+	log_it = config_options.find("ASYNC_EVENT_LOGS");
+	if (log_it != config_options.end()){
+		async_event_logs = config_options["ASYNC_EVENT_LOGS"] == "True";
+	}
+
 	std::string logger_level_wanted = "trace";
 	auto log_level_it = config_options.find("LOGGING_LEVEL");
 	if (log_level_it != config_options.end()){
@@ -377,6 +441,8 @@ std::pair<std::pair<std::shared_ptr<CacheMachine>,std::shared_ptr<CacheMachine>
 	if (!initialized){
 
 		// spdlog batch logger
+		ral::memory::memory_timeline::get_instance().stop();
+		ral::utilities::event_log::get_instance().stop();
 		spdlog::shutdown();
 
 		spdlog::init_thread_pool(8192, 1);
@@ -387,13 +453,15 @@ std::pair<std::pair<std::shared_ptr<CacheMachine>,std::shared_ptr<CacheMachine>
 		    printLoggerHeader(batchLoggerFileName, "batch_logger");
         }
 
+        std::vector<std::shared_ptr<spdlog::logger>> event_loggers;
+
         if(enable_comms_logs=="True"){
             std::string outputCommunicationLoggerFileName = logging_dir + "/output_comms." + std::to_string(ralId) + ".log";
-            create_logger(outputCommunicationLoggerFileName, "output_comms", ralId, flush_level, logger_level_wanted, max_size_logging);
+            event_loggers.push_back(create_logger(outputCommunicationLoggerFileName, "output_comms", ralId, flush_level, logger_level_wanted, max_size_logging, true, async_event_logs));
             printLoggerHeader(outputCommunicationLoggerFileName, "output_comms");
 
             std::string inputCommunicationLoggerFileName = logging_dir + "/input_comms." + std::to_string(ralId) + ".log";
-            create_logger(inputCommunicationLoggerFileName, "input_comms", ralId, flush_level, logger_level_wanted, max_size_logging);
+            event_loggers.push_back(create_logger(inputCommunicationLoggerFileName, "input_comms", ralId, flush_level, logger_level_wanted, max_size_logging, true, async_event_logs));
             printLoggerHeader(inputCommunicationLoggerFileName, "input_comms");
         }
 
@@ -411,16 +479,28 @@ std::pair<std::pair<std::shared_ptr<CacheMachine>,std::shared_ptr<CacheMachine>
             printLoggerHeader(kernelsEdgesFileName, "kernels_edges_logger");
 
 			std::string cacheEventsFileName = logging_dir + "/bsql_cache_events." + std::to_string(ralId) + ".log";
-            create_logger(cacheEventsFileName, "cache_events_logger", ralId, flush_level, logger_level_wanted, max_size_logging);
+            event_loggers.push_back(create_logger(cacheEventsFileName, "cache_events_logger", ralId, flush_level, logger_level_wanted, max_size_logging, true, async_event_logs));
             printLoggerHeader(cacheEventsFileName, "cache_events_logger");
 
         }
 
         if(enable_task_logs=="True"){
             std::string tasksFileName = logging_dir + "/bsql_kernel_tasks." + std::to_string(ralId) + ".log";
-            create_logger(tasksFileName, "task_logger", ralId, flush_level, logger_level_wanted, max_size_logging);
+            event_loggers.push_back(create_logger(tasksFileName, "task_logger", ralId, flush_level, logger_level_wanted, max_size_logging, true, async_event_logs));
             printLoggerHeader(tasksFileName, "task_logger");
         }
+
+        if(enable_memory_timeline_logs=="True"){
+            std::string memoryTimelineFileName = logging_dir + "/bsql_memory_timeline." + std::to_string(ralId) + ".log";
+            std::shared_ptr<spdlog::logger> memory_timeline_logger = create_logger(memoryTimelineFileName, "memory_timeline_logger", ralId, flush_level, logger_level_wanted, max_size_logging, true, async_event_logs);
+            printLoggerHeader(memoryTimelineFileName, "memory_timeline_logger");
+            event_loggers.push_back(memory_timeline_logger);
+            ral::memory::memory_timeline::get_instance().start(memory_timeline_logger);
+        }
+
+        if(async_event_logs && !event_loggers.empty()){
+            ral::utilities::event_log::get_instance().start(event_loggers);
+        }
 	} 
 
 	std::shared_ptr<spdlog::logger> logger = spdlog::get("batch_logger");
@@ -469,18 +549,164 @@ std::pair<std::pair<std::shared_ptr<CacheMachine>,std::shared_ptr<CacheMachine>
 
 	auto & communicationData = ral::communication::CommunicationData::getInstance();
 	communicationData.initialize(worker_id, orc_files_path);
+	std::map<std::string, std::string> worker_hosts;
+	std::vector<std::string> worker_ids;
+	for (auto & worker_info : workers_ucp_info) {
+		worker_hosts[worker_info.worker_id] = worker_info.ip;
+		worker_ids.push_back(worker_info.worker_id);
+	}
+	communicationData.set_worker_hosts(worker_hosts);
+	comm::transport_metrics::get_instance().register_peers(worker_ids);
 
-	auto output_input_caches = std::make_pair(std::make_shared<CacheMachine>(nullptr, "messages_out", false,CACHE_LEVEL_CPU ),std::make_shared<CacheMachine>(nullptr, "messages_in", false));
+	// the disk tier spreads the spill files over BLAZING_CACHE_DIRECTORIES (i.e. one directory per drive), or only uses the cache directory
+	std::vector<std::string> spill_directories;
+	iter = config_options.find("BLAZING_CACHE_DIRECTORIES");
+	if (iter != config_options.end()) {
+		for (auto & directory : StringUtil::split(iter->second, ",")) {
+			directory = StringUtil::trim(directory);
+			if (!directory.empty()) {
+				spill_directories.push_back(singleNode ? directory : directory + "/" + std::to_string(ralId));
+			}
+		}
+	}
+	if (spill_directories.empty()) {
+		spill_directories.push_back(orc_files_path);
+	}
+	size_t spill_directory_capacity = 0;
+	iter = config_options.find("BLAZING_CACHE_DIRECTORY_CAPACITY");
+	if (iter != config_options.end()) {
+		spill_directory_capacity = std::stoull(iter->second);
+	}
+	blazing_disk_memory_resource::getInstance().initialize(spill_directories, spill_directory_capacity);
+
+	// the spills of a query go into preallocated segment files of SPILL_SEGMENT_BYTES, 0 gives every spill a file of its own
+	size_t spill_segment_bytes = 268435456;
+	config_it = config_options.find("SPILL_SEGMENT_BYTES");
+	if (config_it != config_options.end()){
+		spill_segment_bytes = std::stoull(config_it->second);
+	}
+	auto & spill_manager = ral::cache::spill_manager::get_instance();
+	spill_manager.configure(spill_segment_bytes);
+	std::vector<std::string> orphan_segment_directories = spill_directories;
+	orphan_segment_directories.push_back(orc_files_path);
+	spill_manager.remove_orphan_segments(orphan_segment_directories);
+
+	// with gpu direct sends the outgoing messages stay in device memory, and ucx sends them from there
+	bool gpu_direct_transport = false;
+	iter = config_options.find("ENABLE_GPU_DIRECT_TRANSPORT");
+	if (iter != config_options.end() && protocol == comm::blazing_protocol::ucx){
+		gpu_direct_transport = (iter->second == "True" || iter->second == "true");
+	}
+	int messages_out_cache_level = gpu_direct_transport ? CACHE_LEVEL_GPU : CACHE_LEVEL_CPU;
+	auto output_input_caches = std::make_pair(std::make_shared<CacheMachine>(nullptr, "messages_out", false, messages_out_cache_level),std::make_shared<CacheMachine>(nullptr, "messages_in", false));
 
 	ucp_context_h ucp_context = nullptr;
+	if(!singleNode && protocol == comm::blazing_protocol::ucx){
+		ucp_context = reinterpret_cast<ucp_context_h>(workers_ucp_info[0].context_handle);
+	}
+
+	// the host memory pools are placed on the NUMA node of the GPU, since copies from the other node are much slower
+	int numa_node = -1;
+	int current_device = 0;
+	cudaGetDevice(&current_device);
+	config_it = config_options.find("ENABLE_NUMA_AWARE_HOST_POOLS");
+	if (config_it == config_options.end() || config_it->second == "True" || config_it->second == "true"){
+		numa_node = ral::memory::get_device_numa_node(current_device);
+	}
+
+	// the cpus of the threads are set up before any of the pools of the executor and the comms start their threads
+	std::string thread_affinity_policy = "NONE";
+	config_it = config_options.find("THREAD_AFFINITY_POLICY");
+	if (config_it != config_options.end() && !config_it->second.empty()){
+		thread_affinity_policy = config_it->second;
+		std::transform(thread_affinity_policy.begin(), thread_affinity_policy.end(), thread_affinity_policy.begin(), ::toupper);
+	}
+	int thread_affinity_comms_cores = 2;
+	config_it = config_options.find("THREAD_AFFINITY_COMMS_CORES");
+	if (config_it != config_options.end()){
+		thread_affinity_comms_cores = std::stoi(config_it->second);
+	}
+	int ucx_progress_thread_core = -1;
+	config_it = config_options.find("UCX_PROGRESS_THREAD_CORE");
+	if (config_it != config_options.end()){
+		ucx_progress_thread_core = std::stoi(config_it->second);
+	}
+	auto & thread_affinity = ral::utilities::thread_affinity::get_instance();
+	thread_affinity.configure(thread_affinity_policy, current_device, thread_affinity_comms_cores, ucx_progress_thread_core);
+	if(logger){
+		logger->debug("|||{info}|||||","info"_a=thread_affinity.describe());
+	}
+
+	// the tasks and the serialization of the messages run their independent columns on this many streams
+	int task_fork_join_streams = 4;
+	config_it = config_options.find("TASK_FORK_JOIN_STREAMS");
+	if (config_it != config_options.end()){
+		task_fork_join_streams = std::stoi(config_it->second);
+	}
+	// on a MIG instance or as an MPS client with a part of the GPU, the threads and streams of a whole GPU are scaled to it
+	const ral::config::gpu_partition & gpu_partition = ral::config::get_gpu_partition();
+	config_it = config_options.find("ENABLE_GPU_PARTITION_SIZING");
+	bool gpu_partition_sizing = config_it == config_options.end() || config_it->second == "True" || config_it->second == "true";
+	if (gpu_partition_sizing && gpu_partition.compute_fraction < 1.0) {
+		executor_threads = std::max(1, static_cast<int>(std::lround(executor_threads * gpu_partition.compute_fraction)));
+		task_fork_join_streams = std::max(1, static_cast<int>(std::lround(task_fork_join_streams * gpu_partition.compute_fraction)));
+	}
+	if(logger && (gpu_partition.mig || gpu_partition.mps)){
+		logger->debug("|||{info}|||||","info"_a=gpu_partition.description + ", executor threads: " + std::to_string(executor_threads) +
+			", fork join streams: " + std::to_string(task_fork_join_streams));
+	}
+	ral::utilities::stream_fork_join::get_instance().initialize(task_fork_join_streams);
+	// when the network devices of the engine are chosen it makes its own ucx context with them, the one from python
+	// uses the devices that ucx picks for all the GPUs of the node
+	config_it = config_options.find("UCX_NET_DEVICES");
+	if (ucp_context != nullptr && config_it != config_options.end()){
+		std::size_t max_rails = 2;
+		auto rails_it = config_options.find("UCX_MAX_RAILS");
+		if (rails_it != config_options.end()){
+			max_rails = std::stoull(rails_it->second);
+		}
+		std::string net_devices = ral::communication::select_ucx_net_devices(config_it->second, current_device, max_rails);
+		if (!net_devices.empty()){
+			ucp_context = ral::communication::CreateUcpContext(net_devices, max_rails);
+			if(logger){
+				logger->debug("|||{info}|||||","info"_a="UCX network devices: " + net_devices + ", max rails: " + std::to_string(max_rails));
+			}
+		}
+	}
+	std::size_t thread_cache_size = 4;
+	config_it = config_options.find("HOST_CHUNK_THREAD_CACHE_SIZE");
+	if (config_it != config_options.end()){
+		thread_cache_size = std::stoull(config_options["HOST_CHUNK_THREAD_CACHE_SIZE"]);
+	}
+	config_it = config_options.find("ENABLE_LAZY_HOST_POOLS");
+	bool lazy_host_pools = config_it != config_options.end() && (config_it->second == "True" || config_it->second == "true");
+	std::size_t num_size_classes = 2;
+	config_it = config_options.find("HOST_POOL_SIZE_CLASSES");
+	if (config_it != config_options.end()){
+		num_size_classes = std::stoull(config_options["HOST_POOL_SIZE_CLASSES"]);
+	}
+	long long shrink_idle_ms = 30000;
+	config_it = config_options.find("HOST_POOL_SHRINK_IDLE_MS");
+	if (config_it != config_options.end()){
+		shrink_idle_ms = std::stoll(config_options["HOST_POOL_SHRINK_IDLE_MS"]);
+	}
+
+	// the pinned memory of the pools takes a while to allocate and register, so it is done while the connections
+	// to the other nodes are made. The listeners wait for it before they receive anything into the pools.
+	bool map_ucx = protocol == comm::blazing_protocol::ucx;
+	std::future<void> allocation_pools_ready = std::async(std::launch::async,
+		[buffers_size, num_buffers, map_ucx, ucp_context, numa_node, thread_cache_size, lazy_host_pools, num_size_classes, current_device](){
+			cudaSetDevice(current_device);
+			ral::memory::set_allocation_pools(buffers_size, num_buffers,
+				buffers_size, num_buffers, map_ucx, ucp_context, numa_node, thread_cache_size, lazy_host_pools, num_size_classes);
+		});
+
 	// start ucp servers
 	if(!singleNode){
 		std::map<std::string, comm::node> nodes_info_map;
 
 		ucp_worker_h self_worker = nullptr;
 		if(protocol == comm::blazing_protocol::ucx){
-			ucp_context = reinterpret_cast<ucp_context_h>(workers_ucp_info[0].context_handle);
-
 			self_worker = ral::communication::CreatetUcpWorker(ucp_context);
 
 			ral::communication::UcpWorkerAddress ucpWorkerAddress = ral::communication::GetUcpWorkerAddress(self_worker);
@@ -574,8 +800,17 @@ std::pair<std::pair<std::shared_ptr<CacheMachine>,std::shared_ptr<CacheMachine>
 				nodes_info_map.emplace(worker_info.worker_id, comm::node(ralId, worker_info.worker_id, ucp_ep, self_worker));
 			}
 
+			config_it = config_options.find("UCX_PROGRESS_THREAD_CORE");
+			if (config_it != config_options.end()){
+				comm::ucp_progress_manager::set_progress_thread_core(std::stoi(config_it->second));
+			}
+			allocation_pools_ready.wait();
 			comm::ucx_message_listener::initialize_message_listener(
 				ucp_context, self_worker,nodes_info_map,20, output_input_caches.second);
+			config_it = config_options.find("ENABLE_DEVICE_RECEIVE_PLACEMENT");
+			if (config_it != config_options.end()){
+				comm::ucx_message_listener::get_instance()->set_device_placement(config_it->second == "True" || config_it->second == "true");
+			}
 			comm::ucx_message_listener::get_instance()->poll_begin_message_tag(true);
 			output_input_caches.second = comm::ucx_message_listener::get_instance()->get_input_cache();
 
@@ -590,6 +825,11 @@ std::pair<std::pair<std::shared_ptr<CacheMachine>,std::shared_ptr<CacheMachine>
 				nodes_info_map.emplace(worker_info.worker_id, comm::node(ralId, worker_info.worker_id, worker_info.ip, worker_info.port));
 			}
 
+			config_it = config_options.find("TCP_MAX_CONNECTIONS_PER_NODE");
+			if (config_it != config_options.end()){
+				comm::tcp_connection_pool::get_instance().set_max_connections_per_node(std::stoull(config_it->second));
+			}
+			allocation_pools_ready.wait();
 			comm::tcp_message_listener::initialize_message_listener(nodes_info_map,ralCommunicationPort,num_comm_threads, output_input_caches.second);
 			comm::tcp_message_listener::get_instance()->start_polling();
 			ralCommunicationPort = comm::tcp_message_listener::get_instance()->get_port(); // if the listener was already initialized, we want to get the port that was originally set and send that back to python side
@@ -598,14 +838,130 @@ std::pair<std::pair<std::shared_ptr<CacheMachine>,std::shared_ptr<CacheMachine>
 		comm::message_sender::initialize_instance(output_input_caches.first,
 			nodes_info_map,
 			num_comm_threads, ucp_context, self_worker, ralId,protocol,require_acknowledge);
+		config_it = config_options.find("COMMUNICATION_COMPRESSION");
+		if (config_it != config_options.end()){
+			comm::message_sender::get_instance()->set_compression_mode(comm::parse_compression_mode(config_it->second));
+		}
 		comm::message_sender::get_instance()->run_polling();
 
 		output_input_caches.first = comm::message_sender::get_instance()->get_output_cache();
 	}
+	allocation_pools_ready.get(); // throws the errors of the allocation
+	ral::memory::set_pool_shrink_policy(std::chrono::milliseconds(shrink_idle_ms));
 
-	bool map_ucx = protocol == comm::blazing_protocol::ucx;
-	ral::memory::set_allocation_pools(buffers_size, num_buffers,
-										buffers_size, num_buffers, map_ucx, ucp_context);
+	config_it = config_options.find("ENABLE_JIT_EXPRESSIONS");
+	interops::jit::set_enabled(config_it != config_options.end() && (config_it->second == "True" || config_it->second == "true"));
+	config_it = config_options.find("INTERPRETER_MIN_OCCUPANCY");
+	interops::set_interpreter_min_occupancy(config_it != config_options.end() ? std::stod(config_it->second) : 0.25);
+
+	config_it = config_options.find("ENABLE_DICTIONARY_ENCODED_TRANSPORT");
+	ral::communication::messages::set_dictionary_encoding(config_it != config_options.end() && (config_it->second == "True" || config_it->second == "true"));
+	config_it = config_options.find("PACKED_TRANSPORT_MIN_COLUMNS");
+	ral::communication::messages::set_packed_transport_min_columns(config_it != config_options.end() ? std::stoi(config_it->second) : 32);
+
+	config_it = config_options.find("EXPRESSION_PLAN_CACHE_SIZE");
+	if (config_it != config_options.end()){
+		interops::interpreter_plan_cache::get_instance().set_max_size(std::stoull(config_it->second));
+		interops::like_pattern_cache::get_instance().set_max_size(std::stoull(config_it->second));
+	}
+
+	config_it = config_options.find("IO_PREFETCH_IN_FLIGHT");
+	if (config_it != config_options.end()){
+		ral::io::data_prefetcher::get_instance().set_max_in_flight(std::stoull(config_it->second));
+	}
+
+	config_it = config_options.find("REMOTE_FILE_CACHE_DIRECTORY");
+	if (config_it != config_options.end()){
+		int64_t remote_file_cache_max_bytes = 0;
+		auto max_bytes_it = config_options.find("REMOTE_FILE_CACHE_MAX_BYTES");
+		if (max_bytes_it != config_options.end()){
+			remote_file_cache_max_bytes = std::stoll(max_bytes_it->second);
+		}
+		RemoteFileCache::getInstance().configure(config_it->second, remote_file_cache_max_bytes);
+	}
+
+	int64_t object_upload_part_bytes = 16 * 1024 * 1024;
+	config_it = config_options.find("OBJECT_UPLOAD_PART_BYTES");
+	if (config_it != config_options.end()){
+		object_upload_part_bytes = std::stoll(config_it->second);
+	}
+	int object_upload_concurrency = 8;
+	config_it = config_options.find("OBJECT_UPLOAD_CONCURRENCY");
+	if (config_it != config_options.end()){
+		object_upload_concurrency = std::stoi(config_it->second);
+	}
+	ObjectUploadConfig::getInstance().configure(object_upload_part_bytes, object_upload_concurrency);
+	// the parts are filled from pinned memory, so that the writers copy their device buffers at full speed
+	ral::memory::set_upload_allocation_pool(ObjectUploadConfig::getInstance().getPartSize(),
+		ObjectUploadConfig::getInstance().getMaxConcurrentParts() + 1, numa_node);
+
+	int object_store_max_connections = 64;
+	config_it = config_options.find("OBJECT_STORE_MAX_CONNECTIONS");
+	if (config_it != config_options.end()){
+		object_store_max_connections = std::stoi(config_it->second);
+	}
+	int object_store_open_concurrency = 16;
+	config_it = config_options.find("OBJECT_STORE_OPEN_CONCURRENCY");
+	if (config_it != config_options.end()){
+		object_store_open_concurrency = std::stoi(config_it->second);
+	}
+	ObjectStoreConfig::getInstance().configure(object_store_max_connections, object_store_open_concurrency);
+
+	config_it = config_options.find("HDFS_SHORT_CIRCUIT_READS");
+	bool hdfs_short_circuit_reads = config_it == config_options.end() || config_it->second == "True" || config_it->second == "true";
+	std::string hdfs_domain_socket_path = "";
+	config_it = config_options.find("HDFS_DOMAIN_SOCKET_PATH");
+	if (config_it != config_options.end()){
+		hdfs_domain_socket_path = config_it->second;
+	}
+	int hdfs_read_handles = 4;
+	config_it = config_options.find("HDFS_READ_HANDLES");
+	if (config_it != config_options.end()){
+		hdfs_read_handles = std::stoi(config_it->second);
+	}
+	HadoopReadConfig::getInstance().configure(hdfs_short_circuit_reads, hdfs_domain_socket_path, hdfs_read_handles);
+
+	std::size_t parquet_metadata_cache_max_files = 10000;
+	config_it = config_options.find("PARQUET_METADATA_CACHE_MAX_FILES");
+	if (config_it != config_options.end()){
+		parquet_metadata_cache_max_files = std::stoull(config_it->second);
+	}
+	std::string parquet_metadata_cache_directory = "";
+	config_it = config_options.find("PARQUET_METADATA_CACHE_DIRECTORY");
+	if (config_it != config_options.end()){
+		parquet_metadata_cache_directory = config_it->second;
+	}
+	ral::io::parquet_metadata_cache::get_instance().configure(parquet_metadata_cache_max_files, parquet_metadata_cache_directory);
+
+	std::size_t folder_listing_threads = 16;
+	config_it = config_options.find("FOLDER_LISTING_THREADS");
+	if (config_it != config_options.end()){
+		folder_listing_threads = std::stoull(config_it->second);
+	}
+	std::size_t folder_listing_cache_ttl_ms = 60000;
+	config_it = config_options.find("FOLDER_LISTING_CACHE_TTL_MS");
+	if (config_it != config_options.end()){
+		folder_listing_cache_ttl_ms = std::stoull(config_it->second);
+	}
+	ral::io::folder_lister::get_instance().configure(folder_listing_threads, folder_listing_cache_ttl_ms);
+
+	config_it = config_options.find("ENABLE_SHARED_SCANS");
+	bool enable_shared_scans = config_it == config_options.end() || config_it->second == "True" || config_it->second == "true";
+	ral::io::shared_scan::get_instance().configure(enable_shared_scans);
+
+	int64_t allocation_eviction_wait_ms = 50;
+	config_it = config_options.find("ALLOCATION_EVICTION_WAIT_MS");
+	if (config_it != config_options.end()){
+		allocation_eviction_wait_ms = std::stoll(config_options["ALLOCATION_EVICTION_WAIT_MS"]);
+	}
+	ral::memory::memory_pressure::get_instance().configure(std::chrono::milliseconds(allocation_eviction_wait_ms));
+
+	config_it = config_options.find("MANAGED_MEMORY_PREFETCH");
+	bool managed_memory_prefetch = config_it == config_options.end() || config_it->second == "True" || config_it->second == "true";
+	config_it = config_options.find("MANAGED_MEMORY_HOST_ADVICE");
+	bool managed_memory_host_advice = config_it != config_options.end() && (config_it->second == "True" || config_it->second == "true");
+	ral::cache::managed_memory_hints::get_instance().configure(blazing_device_memory_resource::getInstance().is_managed(),
+		managed_memory_prefetch, managed_memory_host_advice);
 
 	double processing_memory_limit_threshold = 0.9;
 	config_it = config_options.find("BLAZING_PROCESSING_DEVICE_MEM_CONSUMPTION_THRESHOLD");
@@ -613,8 +969,19 @@ std::pair<std::pair<std::shared_ptr<CacheMachine>,std::shared_ptr<CacheMachine>
 		processing_memory_limit_threshold = std::stod(config_options["BLAZING_PROCESSING_DEVICE_MEM_CONSUMPTION_THRESHOLD"]);
 	}
 
-	ral::execution::executor::init_executor(executor_threads, processing_memory_limit_threshold);
+	std::size_t task_scratch_arena_bytes = 16 * 1024 * 1024;
+	config_it = config_options.find("TASK_SCRATCH_ARENA_BYTES");
+	if (config_it != config_options.end()){
+		task_scratch_arena_bytes = std::stoull(config_options["TASK_SCRATCH_ARENA_BYTES"]);
+	}
+
+	// the executor runs its tasks on the device this engine was initialized on
+	int device_id = 0;
+	cudaGetDevice(&device_id);
+	ral::execution::executor::init_executor(executor_threads, processing_memory_limit_threshold, device_id, task_scratch_arena_bytes);
 	initialized = true;
+	initialized_protocol = protocol;
+	initialized_single_node = singleNode;
   blazing_context_ref_counter::getInstance().increase();
 	return std::make_pair(output_input_caches, ralCommunicationPort);	
 }
@@ -655,6 +1022,8 @@ void finalize(std::vector<int32_t> ctx_tokens) {
 
     // BlazingRMMFinalize();
 
+    ral::memory::memory_timeline::get_instance().stop();
+    ral::utilities::event_log::get_instance().stop();
     spdlog::shutdown();
 
     //cudaDeviceReset();
@@ -703,6 +1072,10 @@ error_code_t finalize_C(std::vector<int32_t> ctx_tokens) {
 	}
 }
 
+void uncacheTable(std::string table_name) {
+	ral::cache::table_cache::get_instance().remove_table(table_name);
+}
+
 size_t getFreeMemory() {
 	BlazingMemoryResource* resource = &blazing_device_memory_resource::getInstance();
 	size_t total_free_memory = resource->get_memory_limit() - resource->get_memory_used();
@@ -718,3 +1091,94 @@ size_t getMaxMemoryUsed() {
     blazing_device_memory_resource* resource = &blazing_device_memory_resource::getInstance();
 	return resource->get_max_memory_used();
 }
+
+// returns the current and peak GPU memory usage of a query, they are only tracked by the async allocator
+std::pair<size_t, size_t> getQueryMemoryUsage(int32_t ctx_token) {
+	auto usage = ral::memory::query_memory_tracker::get_instance().get_query_usage(ctx_token);
+	return std::make_pair(usage.current, usage.peak);
+}
+
+std::map<int32_t, std::pair<size_t, size_t>> getKernelMemoryUsage(int32_t ctx_token) {
+	std::map<int32_t, std::pair<size_t, size_t>> kernel_usages;
+	for (auto & kernel_usage : ral::memory::query_memory_tracker::get_instance().get_kernel_usages(ctx_token)) {
+		kernel_usages[kernel_usage.first] = std::make_pair(kernel_usage.second.current, kernel_usage.second.peak);
+	}
+	return kernel_usages;
+}
+
+// the nodes can only join and leave at runtime with tcp, since with ucx the endpoints are made from the addresses exchanged when all of them start
+void check_dynamic_membership() {
+	if (!initialized || initialized_single_node) {
+		throw std::runtime_error("ERROR: nodes can only be added or removed once the engine is initialized in distributed mode");
+	}
+	if (initialized_protocol != comm::blazing_protocol::tcp) {
+		throw std::runtime_error("ERROR: nodes can only be added or removed at runtime with the tcp protocol");
+	}
+}
+
+void addNode(uint16_t ralId, std::string worker_id, std::string ip, int port) {
+	std::lock_guard<std::mutex> init_lock(initialize_lock);
+	check_dynamic_membership();
+	comm::node node(ralId, worker_id, ip, port);
+	comm::tcp_message_listener::get_instance()->add_node(node);
+	comm::message_sender::get_instance()->add_node(node);
+}
+
+void removeNode(std::string worker_id) {
+	std::lock_guard<std::mutex> init_lock(initialize_lock);
+	check_dynamic_membership();
+	comm::tcp_message_listener::get_instance()->remove_node(worker_id);
+	comm::message_sender::get_instance()->remove_node(worker_id);
+}
+
+// returns the bytes and messages sent to and received from every other node, and the messages waiting to be sent to them
+std::map<std::string, std::map<std::string, int64_t>> getTransportMetrics() {
+	std::map<std::string, std::map<std::string, int64_t>> metrics;
+	for (auto & peer : comm::transport_metrics::get_instance().get_snapshot()) {
+		auto & peer_metrics = metrics[peer.first];
+		peer_metrics["bytes_sent"] = peer.second.bytes_sent;
+		peer_metrics["messages_sent"] = peer.second.messages_sent;
+		peer_metrics["bytes_received"] = peer.second.bytes_received;
+		peer_metrics["messages_received"] = peer.second.messages_received;
+		peer_metrics["queued_messages"] = peer.second.queued_messages;
+	}
+	return metrics;
+}
+
+// returns the usage of the memory of the host, pinned and upload pools, with their size classes
+std::map<std::string, std::map<std::string, int64_t>> getAllocationPoolStats() {
+	std::map<std::string, std::map<std::string, int64_t>> stats;
+	std::map<std::string, std::shared_ptr<ral::memory::allocation_pool>> pools = {
+		{"host", ral::memory::buffer_providers::get_host_buffer_provider()},
+		{"pinned", ral::memory::buffer_providers::get_pinned_buffer_provider()},
+		{"upload", ral::memory::buffer_providers::get_upload_buffer_provider()}};
+	for (auto & pool : pools) {
+		if (pool.second == nullptr) {
+			continue;
+		}
+		ral::memory::allocation_pool::usage_stats usage = pool.second->get_usage_stats();
+		auto & pool_stats = stats[pool.first];
+		pool_stats["total_bytes"] = usage.total_bytes;
+		pool_stats["allocated_bytes"] = usage.allocated_bytes;
+		pool_stats["free_bytes"] = usage.free_bytes;
+		pool_stats["high_water_bytes"] = usage.high_water_bytes;
+		pool_stats["grows"] = usage.grows;
+		pool_stats["shrinks"] = usage.shrinks;
+	}
+	return stats;
+}
+
+// returns the metrics of the executors, memory tiers, spills, transports and running queries of this worker, in the
+// OpenMetrics text format
+std::string getRuntimeMetrics() {
+	return ral::utilities::runtime_metrics::get_instance().to_openmetrics();
+}
+
+// returns how many of the sends to every other node took less than 1, 2, 4, ... microseconds, the last bucket has the slower ones
+std::map<std::string, std::vector<uint64_t>> getTransportSendLatencies() {
+	std::map<std::string, std::vector<uint64_t>> latencies;
+	for (auto & peer : comm::transport_metrics::get_instance().get_snapshot()) {
+		latencies[peer.first] = peer.second.send_latency_histogram;
+	}
+	return latencies;
+}
@@ -6,6 +6,7 @@
 #include "../io/data_parser/OrcParser.h"
 #include "../io/data_parser/ParquetParser.h"
 #include "../io/data_provider/UriDataProvider.h"
+#include "../io/data_provider/folder_lister.h"
 
 #include "utilities/CommonOperations.h"
 #include "parser/expression_tree.hpp"
@@ -27,6 +28,11 @@
 #include "../io/data_provider/sql/SQLiteDataProvider.h"
 #endif
 
+#ifdef ARROW_FLIGHT_SUPPORT
+#include "../io/data_parser/FlightParser.h"
+#include "../io/data_provider/FlightDataProvider.h"
+#endif
+
 using namespace fmt::literals;
 
 // #include <blazingdb/io/Library/Logging/TcpOutput.h>
@@ -97,6 +103,14 @@ TableSchema parseSchema(std::vector<std::string> files,
     isSqlProvider = true;
 #else
       throw std::runtime_error("ERROR: This BlazingSQL version doesn't support SQLite integration");
+#endif
+  } else if(fileType == ral::io::DataType::ARROW_FLIGHT) {
+#ifdef ARROW_FLIGHT_SUPPORT
+    parser = std::make_shared<ral::io::flight_parser>();
+    provider = std::make_shared<ral::io::flight_data_provider>(ral::io::getFlightInfo(args_map), 0, 0);
+    isSqlProvider = true; // like the sql providers, it has no files
+#else
+      throw std::runtime_error("ERROR: This BlazingSQL version doesn't support Arrow Flight");
 #endif
   }
 
@@ -303,28 +317,16 @@ std::pair<bool, std::string> registerFileSystemLocal(std::string root, std::stri
 	return registerFileSystem(fileSystemConnection, root, authority);
 }
 
-void visitPartitionFolder(Uri folder_uri, std::vector<FolderPartitionMetadata>& metadata, int depth) {
+std::vector<FileLocations> getFileLocations(std::vector<std::string> files) {
 	auto fs = BlazingContext::getInstance()->getFileSystemManager();
 
-	auto matches = fs->list(folder_uri, "*=*");
-	for (auto &&uri : matches) {
-		auto status = fs->getFileStatus(uri);
-		if (!status.isDirectory()) {
-			continue;
-		}
-
-		std::string name = uri.getPath().getResourceName();
-		auto parts = StringUtil::split(name, '=');
-
-		if (metadata.size() < static_cast<size_t>(depth) + 1) {
-			metadata.resize(depth + 1);
-		}
-
-		metadata[depth].name = parts[0];
-		metadata[depth].values.insert(parts[1]);
-
-		visitPartitionFolder(uri, metadata, depth + 1);
+	std::vector<FileLocations> locations;
+	locations.reserve(files.size());
+	for (auto & file : files) {
+		Uri uri{file};
+		locations.push_back({static_cast<long long>(fs->getFileStatus(uri).getFileSize()), fs->getFileLocations(uri)});
 	}
+	return locations;
 }
 
 std::vector<FolderPartitionMetadata> inferFolderPartitionMetadata(std::string folder_path) {
@@ -341,7 +343,18 @@ std::vector<FolderPartitionMetadata> inferFolderPartitionMetadata(std::string fo
 	}
 
 	std::vector<FolderPartitionMetadata> metadata;
-	visitPartitionFolder(folder_uri, metadata, 0);
+	for (auto && partition_folder : ral::io::folder_lister::get_instance().find_partition_folders(folder_uri)) {
+		std::string name = partition_folder.first.getPath().getResourceName();
+		auto parts = StringUtil::split(name, '=');
+		int depth = partition_folder.second;
+
+		if (metadata.size() < static_cast<size_t>(depth) + 1) {
+			metadata.resize(depth + 1);
+		}
+
+		metadata[depth].name = parts[0];
+		metadata[depth].values.insert(parts[1]);
+	}
 
 	static std::regex boolean_regex{std::string(ral::parser::detail::lexer::BOOLEAN_REGEX_STR)};
   	static std::regex number_regex{std::string(ral::parser::detail::lexer::NUMBER_REGEX_STR)};
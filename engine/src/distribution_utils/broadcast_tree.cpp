@@ -0,0 +1,100 @@
+#include "broadcast_tree.h"
+
+#include <Util/StringUtil.h>
+
+namespace ral {
+namespace distribution {
+
+broadcast_groups group_broadcast_targets(const std::vector<std::string> & target_ids,
+	const std::string & self_id,
+	const std::map<std::string, std::string> & worker_hosts) {
+
+	auto self_host = worker_hosts.find(self_id);
+	std::vector<std::string> hosts;
+	broadcast_groups groups;
+	if (self_host != worker_hosts.end()) {
+		hosts.push_back(self_host->second);
+		groups.emplace_back();
+	}
+	for (auto & target_id : target_ids) {
+		auto host = worker_hosts.find(target_id);
+		if (host == worker_hosts.end()) {
+			groups.push_back({target_id});
+			hosts.emplace_back(); // an unknown host, that no other node shares
+			continue;
+		}
+		size_t i = 0;
+		while (i < hosts.size() && (hosts[i].empty() || hosts[i] != host->second)) {
+			i++;
+		}
+		if (i == hosts.size()) {
+			hosts.push_back(host->second);
+			groups.emplace_back();
+		}
+		groups[i].push_back(target_id);
+	}
+
+	// the targets in the same host as the sender are the first group, the one that the sender keeps until the end
+	if (!groups.empty() && groups.front().empty()) {
+		groups.erase(groups.begin());
+	}
+	return groups;
+}
+
+std::vector<broadcast_child> get_broadcast_children(broadcast_groups subtree) {
+	std::vector<broadcast_child> children;
+	while (!subtree.empty()) {
+		broadcast_groups second_half;
+		if (subtree.size() > 1) {
+			second_half.assign(subtree.begin() + subtree.size() / 2, subtree.end());
+			subtree.resize(subtree.size() / 2);
+		} else {
+			auto & group = subtree.front();
+			second_half.emplace_back(group.begin() + group.size() / 2, group.end());
+			group.resize(group.size() / 2);
+			if (group.empty()) {
+				subtree.clear();
+			}
+		}
+
+		broadcast_child child;
+		child.worker_id = second_half.front().front();
+		second_half.front().erase(second_half.front().begin());
+		if (second_half.front().empty()) {
+			second_half.erase(second_half.begin());
+		}
+		child.subtree = std::move(second_half);
+		children.push_back(std::move(child));
+	}
+	return children;
+}
+
+std::string serialize_broadcast_groups(const broadcast_groups & groups) {
+	std::string serialized;
+	for (size_t i = 0; i < groups.size(); i++) {
+		if (i > 0) {
+			serialized += ";";
+		}
+		for (size_t j = 0; j < groups[i].size(); j++) {
+			if (j > 0) {
+				serialized += ",";
+			}
+			serialized += groups[i][j];
+		}
+	}
+	return serialized;
+}
+
+broadcast_groups deserialize_broadcast_groups(const std::string & groups) {
+	broadcast_groups deserialized;
+	if (groups.empty()) {
+		return deserialized;
+	}
+	for (auto & group : StringUtil::split(groups, ";")) {
+		deserialized.push_back(StringUtil::split(group, ","));
+	}
+	return deserialized;
+}
+
+}  // namespace distribution
+}  // namespace ral
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace ral {
+namespace distribution {
+
+/**
+ * The nodes that a broadcast still has to get to, grouped by the host they run in. The nodes of a host can get the
+ * table from each other over NVLink or the local links of the machine, so the tree only crosses from one host to
+ * another once per host.
+ */
+typedef std::vector<std::vector<std::string>> broadcast_groups;
+
+struct broadcast_child {
+	std::string worker_id; /**< The node the table is sent to */
+	broadcast_groups subtree; /**< The nodes that this child has to forward the table to */
+};
+
+/**
+ * @brief Groups the targets of a broadcast by their host.
+ *
+ * The targets that run in the same host as the sender go in the first group, so that they get the table last and from
+ * the sender, and the other groups are in the order in which their first target appears.
+ *
+ * @param target_ids The nodes the table is broadcast to.
+ * @param self_id The node that broadcasts the table.
+ * @param worker_hosts The host of every node. The nodes that are not in it are thought to be in a host of their own.
+ */
+broadcast_groups group_broadcast_targets(const std::vector<std::string> & target_ids,
+	const std::string & self_id,
+	const std::map<std::string, std::string> & worker_hosts);
+
+/**
+ * @brief Gets the nodes that a node sends a broadcast table to, and the subtree that each of them forwards it to.
+ *
+ * It is a binomial tree: the subtree is split in halves, the first node of the second half gets the table and the rest
+ * of that half to forward it to, and the node keeps splitting the first half. The halves are split between hosts while
+ * there is more than one, so every host gets the table from another host only once and the depth of the tree is about
+ * log2 of the number of hosts plus log2 of the number of nodes in a host.
+ *
+ * @param subtree The nodes that this node has to get the table to, without itself.
+ * @return The children of this node, in the order in which they should be sent the table.
+ */
+std::vector<broadcast_child> get_broadcast_children(broadcast_groups subtree);
+
+/**
+ * @brief Writes a subtree as a string that can go in the metadata of a message, like "a,b;c".
+ */
+std::string serialize_broadcast_groups(const broadcast_groups & groups);
+
+broadcast_groups deserialize_broadcast_groups(const std::string & groups);
+
+}  // namespace distribution
+}  // namespace ral
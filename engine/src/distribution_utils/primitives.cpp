@@ -9,6 +9,11 @@
 #include "cudf/detail/gather.hpp"
 #include "cudf/copying.hpp"
 #include <cudf/merge.hpp>
+#include <cudf/concatenate.hpp>
+#include <cudf/join.hpp>
+#include <cudf/groupby.hpp>
+#include <cudf/binaryop.hpp>
+#include <cudf/stream_compaction.hpp>
 #include <cudf/utilities/traits.hpp>
 
 #include "utilities/CommonOperations.h"
@@ -72,7 +77,8 @@ std::vector<NodeColumnView> partitionData(Context * context,
 	const BlazingTableView & table,
 	const BlazingTableView & pivots,
 	const std::vector<int> & searchColIndices,
-	std::vector<cudf::order> sortOrderTypes) {
+	std::vector<cudf::order> sortOrderTypes,
+	bool split_duplicate_pivots) {
 
 	RAL_EXPECTS(static_cast<size_t>(pivots.view().num_columns()) == searchColIndices.size(), "Mismatched pivots num_columns and searchColIndices");
 
@@ -90,7 +96,7 @@ std::vector<NodeColumnView> partitionData(Context * context,
 		sortOrderTypes.assign(searchColIndices.size(), cudf::order::ASCENDING);
 	}
 
-	std::vector<CudfTableView> partitioned_data = ral::operators::partition_table(pivots, table, sortOrderTypes, searchColIndices);
+	std::vector<CudfTableView> partitioned_data = ral::operators::partition_table(pivots, table, sortOrderTypes, searchColIndices, split_duplicate_pivots);
 
 	std::vector<Node> all_nodes = context->getAllNodes();
 
@@ -106,6 +112,46 @@ std::vector<NodeColumnView> partitionData(Context * context,
 	return partitioned_node_column_views;
 }
 
+/* Returns the order the non empty tables have to be concatenated in when the ranges of their sort columns don't overlap,
+as it is for the batches of a dataset that was written sorted, or nothing when they have to be merged. The first rows
+of the tables are sorted, and the tables are in order if their first and last rows are still sorted in that order. */
+std::vector<std::size_t> get_concatenation_order(const std::vector<CudfTableView> & tables,
+	const std::vector<cudf::order> & sortOrderTypes, const std::vector<int> & sortColIndices,
+	const std::vector<cudf::null_order> & null_orders) {
+
+	std::vector<std::size_t> non_empty;
+	std::vector<CudfTableView> first_rows, last_rows;
+	for(std::size_t i = 0; i < tables.size(); i++) {
+		cudf::size_type num_rows = tables[i].num_rows();
+		if (num_rows > 0) {
+			CudfTableView sort_columns = tables[i].select(sortColIndices);
+			non_empty.push_back(i);
+			first_rows.push_back(cudf::slice(sort_columns, {0, 1})[0]);
+			last_rows.push_back(cudf::slice(sort_columns, {num_rows - 1, num_rows})[0]);
+		}
+	}
+	if (non_empty.size() < 2) {
+		return non_empty;
+	}
+
+	std::unique_ptr<CudfTable> firsts = cudf::concatenate(first_rows);
+	std::unique_ptr<cudf::column> first_rows_order = cudf::sorted_order(firsts->view(), sortOrderTypes, null_orders);
+	std::vector<int32_t> order = ral::utilities::column_to_vector<int32_t>(first_rows_order->view());
+
+	std::vector<CudfTableView> bounds;
+	std::vector<std::size_t> concatenation_order;
+	for (int32_t i : order) {
+		bounds.push_back(first_rows[i]);
+		bounds.push_back(last_rows[i]);
+		concatenation_order.push_back(non_empty[i]);
+	}
+	std::unique_ptr<CudfTable> bounds_table = cudf::concatenate(bounds);
+	if (!cudf::is_sorted(bounds_table->view(), sortOrderTypes, null_orders)) {
+		return {};
+	}
+	return concatenation_order;
+}
+
 std::unique_ptr<BlazingTable> sortedMerger(std::vector<BlazingTableView> & tables,
 	const std::vector<cudf::order> & sortOrderTypes,
 	const std::vector<int> & sortColIndices) {
@@ -117,7 +163,19 @@ std::unique_ptr<BlazingTable> sortedMerger(std::vector<BlazingTableView> & table
 	for(size_t i = 0; i < tables.size(); i++) {
 		cudf_table_views[i] = tables[i].view();
 	}
-	std::unique_ptr<CudfTable> merged_table = cudf::merge(cudf_table_views, sortColIndices, sortOrderTypes, null_orders);
+
+	// the tables that are one after the other are concatenated, which is cheaper than merging them
+	std::unique_ptr<CudfTable> merged_table;
+	std::vector<std::size_t> concatenation_order = get_concatenation_order(cudf_table_views, sortOrderTypes, sortColIndices, null_orders);
+	if (!concatenation_order.empty()) {
+		std::vector<CudfTableView> tables_in_order;
+		for (std::size_t i : concatenation_order) {
+			tables_in_order.push_back(cudf_table_views[i]);
+		}
+		merged_table = cudf::concatenate(tables_in_order);
+	} else {
+		merged_table = cudf::merge(cudf_table_views, sortColIndices, sortOrderTypes, null_orders);
+	}
 
 	// lets get names from a non-empty table
 	std::vector<std::string> names;
@@ -150,5 +208,44 @@ std::unique_ptr<BlazingTable> getPivotPointsTable(cudf::size_type number_partiti
 
 
 
+std::unique_ptr<BlazingTable> getHeavyHitterKeys(const BlazingTableView & sample,
+	const std::vector<cudf::size_type> & keyColIndices, double heavy_hitter_threshold) {
+
+	CudfTableView keys = sample.view().select(keyColIndices);
+	std::vector<std::string> key_names;
+	for (auto index : keyColIndices) {
+		key_names.push_back(sample.names()[index]);
+	}
+
+	std::vector<cudf::groupby::aggregation_request> requests(1);
+	requests[0].values = keys.column(0);
+	requests[0].aggregations.push_back(cudf::make_count_aggregation(cudf::null_policy::INCLUDE));
+	cudf::groupby::groupby group_by_obj(keys, cudf::null_policy::EXCLUDE);
+	auto result = group_by_obj.aggregate(requests);
+
+	auto & counts = result.second[0].results[0];
+	cudf::numeric_scalar<cudf::size_type> min_count(static_cast<cudf::size_type>(heavy_hitter_threshold * sample.num_rows()));
+	std::unique_ptr<cudf::column> is_heavy_hitter = cudf::binary_operation(counts->view(), min_count,
+		cudf::binary_operator::GREATER, cudf::data_type{cudf::type_id::BOOL8});
+	std::unique_ptr<CudfTable> heavy_hitter_keys = cudf::apply_boolean_mask(result.first->view(), is_heavy_hitter->view());
+
+	return std::make_unique<BlazingTable>(std::move(heavy_hitter_keys), key_names);
+}
+
+std::pair<std::unique_ptr<BlazingTable>, std::unique_ptr<BlazingTable>> splitHeavyHitters(const BlazingTableView & table,
+	const std::vector<cudf::size_type> & keyColIndices, const BlazingTableView & heavyHitterKeys) {
+
+	std::vector<cudf::size_type> heavy_hitter_key_indices(heavyHitterKeys.num_columns());
+	std::iota(heavy_hitter_key_indices.begin(), heavy_hitter_key_indices.end(), 0);
+
+	std::unique_ptr<CudfTable> heavy_hitters = cudf::left_semi_join(table.view(), heavyHitterKeys.view(),
+		keyColIndices, heavy_hitter_key_indices);
+	std::unique_ptr<CudfTable> rest = cudf::left_anti_join(table.view(), heavyHitterKeys.view(),
+		keyColIndices, heavy_hitter_key_indices);
+
+	return std::make_pair(std::make_unique<BlazingTable>(std::move(heavy_hitters), table.names()),
+		std::make_unique<BlazingTable>(std::move(rest), table.names()));
+}
+
 }  // namespace distribution
 }  // namespace ral
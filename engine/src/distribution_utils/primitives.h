@@ -30,11 +30,26 @@ namespace distribution {
 		const BlazingTableView & table,
 		const BlazingTableView & pivots,
 		const std::vector<int> & searchColIndices,
-		std::vector<cudf::order> sortOrderTypes);
+		std::vector<cudf::order> sortOrderTypes,
+		bool split_duplicate_pivots = false);
 
 	std::unique_ptr<BlazingTable> getPivotPointsTable(cudf::size_type number_pivots, const BlazingTableView & sortedSamples);
 
+// Returns the order the non empty tables can be concatenated in to be sorted, or nothing when their ranges overlap
+	std::vector<std::size_t> get_concatenation_order(const std::vector<CudfTableView> & tables,
+		const std::vector<cudf::order> & sortOrderTypes, const std::vector<int> & sortColIndices,
+		const std::vector<cudf::null_order> & null_orders);
+
 	std::unique_ptr<BlazingTable> sortedMerger(std::vector<BlazingTableView> & tables,
 		const std::vector<cudf::order> & sortOrderTypes, const std::vector<int> & sortColIndices);
+
+// Finds the keys that are in more than heavy_hitter_threshold of the rows of a sample. They are returned as a table with
+// only the key columns, one row per key. Null keys are never heavy hitters.
+	std::unique_ptr<BlazingTable> getHeavyHitterKeys(const BlazingTableView & sample,
+		const std::vector<cudf::size_type> & keyColIndices, double heavy_hitter_threshold);
+
+// Splits a table into the rows whose keys are in heavyHitterKeys and the rest of them, in that order.
+	std::pair<std::unique_ptr<BlazingTable>, std::unique_ptr<BlazingTable>> splitHeavyHitters(const BlazingTableView & table,
+		const std::vector<cudf::size_type> & keyColIndices, const BlazingTableView & heavyHitterKeys);
 }  // namespace distribution
 }  // namespace ral
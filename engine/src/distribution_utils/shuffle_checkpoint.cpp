@@ -0,0 +1,431 @@
+#include "shuffle_checkpoint.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+#include <arrow/io/interfaces.h>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <cuda_runtime.h>
+#include <spdlog/spdlog.h>
+
+#include <blazingdb/io/Config/BlazingContext.h>
+#include <FileSystem/Uri.h>
+#include "communication/CommunicationInterface/serializer.hpp"
+#include "communication/messages/GPUComponentMessage.h"
+
+using namespace fmt::literals;
+
+namespace ral {
+namespace distribution {
+
+namespace {
+
+using ColumnTransport = blazingdb::transport::ColumnTransport;
+
+const std::uint64_t partition_file_magic = 0x4b4843515a4c42; // "BLZQCHK"
+
+struct partition_file_header {
+	std::uint64_t magic;
+	std::uint64_t num_column_transports;
+	std::uint64_t num_buffers;
+};
+
+// the buffers are copied between the GPU and the files in pieces of this many bytes
+const std::size_t staging_bytes = 8 * 1024 * 1024;
+
+void log_checkpoint_error(const std::string & info) {
+	std::shared_ptr<spdlog::logger> logger = spdlog::get("batch_logger");
+	if (logger) {
+		logger->error("|||{info}|||||", "info"_a=info);
+	}
+}
+
+void check_status(const arrow::Status & status, const std::string & path) {
+	if (!status.ok()) {
+		throw std::runtime_error("ERROR: Writing the shuffle checkpoint " + path + " failed: " + status.ToString());
+	}
+}
+
+void read_or_throw(arrow::io::RandomAccessFile & file, int64_t & position, void * data, int64_t size, const std::string & path) {
+	if (size == 0) {
+		return;
+	}
+	auto result = file.ReadAt(position, size, data);
+	if (!result.ok() || result.ValueOrDie() != size) {
+		throw std::runtime_error("ERROR: Reading the shuffle checkpoint " + path + " failed");
+	}
+	position += size;
+}
+
+void make_folder(const std::string & path) {
+	// the object stores have no folders, so only the others need it to be made
+	Uri folder_uri(path);
+	if (folder_uri.getFileSystemType() == FileSystemType::LOCAL || folder_uri.getFileSystemType() == FileSystemType::HDFS) {
+		auto fs = BlazingContext::getInstance()->getFileSystemManager();
+		if (!fs->exists(folder_uri)) {
+			// the folder of the query is in SHUFFLE_CHECKPOINT_PATH, which may not be there yet either
+			std::size_t parent_end = path.find_last_of('/');
+			if (parent_end != std::string::npos && parent_end > 0 && path[parent_end - 1] != '/') {
+				make_folder(path.substr(0, parent_end));
+			}
+			fs->makeDirectory(folder_uri);
+		}
+	}
+}
+
+std::string read_file(const std::string & path) {
+	auto file = BlazingContext::getInstance()->getFileSystemManager()->openReadable(Uri(path));
+	if (file == nullptr) {
+		throw std::runtime_error("ERROR: Could not open the shuffle checkpoint " + path);
+	}
+	int64_t size = file->GetSize().ValueOrDie();
+	std::string content(size, '\0');
+	int64_t position = 0;
+	read_or_throw(*file, position, &content[0], size, path);
+	return content;
+}
+
+void write_partition_file(const std::string & path, const ral::frame::BlazingTableView & partition) {
+	std::vector<std::size_t> buffer_sizes;
+	std::vector<const char *> raw_buffers;
+	std::vector<ColumnTransport> column_transports;
+	std::vector<std::unique_ptr<rmm::device_buffer>> temp_scope_holder;
+	std::tie(buffer_sizes, raw_buffers, column_transports, temp_scope_holder) =
+		ral::communication::messages::serialize_gpu_message_to_gpu_containers(partition);
+
+	auto stream = BlazingContext::getInstance()->getFileSystemManager()->openWriteable(Uri(path));
+	if (stream == nullptr) {
+		throw std::runtime_error("ERROR: Could not open the shuffle checkpoint " + path);
+	}
+
+	partition_file_header header{partition_file_magic, column_transports.size(), buffer_sizes.size()};
+	check_status(stream->Write(&header, sizeof(header)), path);
+	check_status(stream->Write(column_transports.data(), column_transports.size() * sizeof(ColumnTransport)), path);
+	check_status(stream->Write(buffer_sizes.data(), buffer_sizes.size() * sizeof(std::size_t)), path);
+
+	std::vector<char> staging(staging_bytes);
+	for (std::size_t i = 0; i < raw_buffers.size(); i++) {
+		for (std::size_t offset = 0; offset < buffer_sizes[i]; offset += staging_bytes) {
+			std::size_t piece_size = std::min(staging_bytes, buffer_sizes[i] - offset);
+			cudaMemcpy(staging.data(), raw_buffers[i] + offset, piece_size, cudaMemcpyDeviceToHost);
+			check_status(stream->Write(staging.data(), piece_size), path);
+		}
+	}
+	check_status(stream->Close(), path);
+}
+
+std::unique_ptr<ral::frame::BlazingTable> read_partition_file(const std::string & path, const std::vector<std::string> & names) {
+	auto file = BlazingContext::getInstance()->getFileSystemManager()->openReadable(Uri(path));
+	if (file == nullptr) {
+		throw std::runtime_error("ERROR: Could not open the shuffle checkpoint " + path);
+	}
+
+	int64_t position = 0;
+	partition_file_header header;
+	read_or_throw(*file, position, &header, sizeof(header), path);
+	if (header.magic != partition_file_magic) {
+		throw std::runtime_error("ERROR: " + path + " is not a partition of a shuffle checkpoint");
+	}
+	std::vector<ColumnTransport> column_transports(header.num_column_transports);
+	std::vector<std::size_t> buffer_sizes(header.num_buffers);
+	read_or_throw(*file, position, column_transports.data(), column_transports.size() * sizeof(ColumnTransport), path);
+	read_or_throw(*file, position, buffer_sizes.data(), buffer_sizes.size() * sizeof(std::size_t), path);
+
+	std::vector<char> staging(staging_bytes);
+	std::vector<rmm::device_buffer> raw_buffers(buffer_sizes.size());
+	for (std::size_t i = 0; i < buffer_sizes.size(); i++) {
+		raw_buffers[i].resize(buffer_sizes[i]);
+		char * buffer_data = static_cast<char *>(raw_buffers[i].data());
+		for (std::size_t offset = 0; offset < buffer_sizes[i]; offset += staging_bytes) {
+			std::size_t piece_size = std::min(staging_bytes, buffer_sizes[i] - offset);
+			read_or_throw(*file, position, staging.data(), piece_size, path);
+			cudaMemcpy(buffer_data + offset, staging.data(), piece_size, cudaMemcpyHostToDevice);
+		}
+	}
+
+	auto table = comm::deserialize_from_gpu_raw_buffers(column_transports, raw_buffers);
+	table->setNames(names);
+	return table;
+}
+
+}  // namespace
+
+std::string make_checkpoint_fingerprint(const std::string & logical_plan,
+	const std::vector<std::string> & table_names,
+	const std::vector<std::string> & data_versions) {
+	if (std::any_of(data_versions.begin(), data_versions.end(), [](const std::string & version) { return version.empty(); })) {
+		return "";
+	}
+
+	// FNV-1a, since std::hash may differ between the builds of the nodes and between the attempts
+	std::uint64_t hash = 0xcbf29ce484222325ULL;
+	auto add = [&hash](const std::string & value) {
+		for (unsigned char c : value) {
+			hash = (hash ^ c) * 0x100000001b3ULL;
+		}
+		// the separator keeps "ab","c" apart from "a","bc"
+		hash = (hash ^ 0xff) * 0x100000001b3ULL;
+	};
+	add(logical_plan);
+	for (std::size_t i = 0; i < data_versions.size(); i++) {
+		add(i < table_names.size() ? table_names[i] : "");
+		add(data_versions[i]);
+	}
+
+	std::ostringstream out;
+	out << std::hex << std::setw(16) << std::setfill('0') << hash;
+	return out.str();
+}
+
+std::string serialize_checkpoint_manifest(const checkpoint_manifest & manifest) {
+	boost::property_tree::ptree root;
+	root.put("attempt", manifest.attempt);
+	root.put("kernel_name", manifest.kernel_name);
+	root.put("sender", manifest.sender);
+	root.put("num_nodes", manifest.num_nodes);
+	root.put("hash_partitions_per_node", manifest.hash_partitions_per_node);
+	root.put("fingerprint", manifest.fingerprint);
+
+	boost::property_tree::ptree partitions;
+	for (const auto & partition : manifest.partitions) {
+		boost::property_tree::ptree partition_node;
+		partition_node.put("file_name", partition.file_name);
+		partition_node.put("destination", partition.destination);
+		partition_node.put("cache_id", partition.cache_id);
+		partition_node.put("message_id_prefix", partition.message_id_prefix);
+
+		boost::property_tree::ptree column_names;
+		for (const auto & name : partition.column_names) {
+			boost::property_tree::ptree name_node;
+			name_node.put_value(name);
+			column_names.push_back(std::make_pair("", name_node));
+		}
+		partition_node.add_child("column_names", column_names);
+
+		// the keys of the metadata are values instead of paths, since they could have dots
+		boost::property_tree::ptree metadata;
+		for (const auto & value : partition.metadata) {
+			boost::property_tree::ptree value_node;
+			value_node.put("key", value.first);
+			value_node.put("value", value.second);
+			metadata.push_back(std::make_pair("", value_node));
+		}
+		partition_node.add_child("metadata", metadata);
+
+		partitions.push_back(std::make_pair("", partition_node));
+	}
+	root.add_child("partitions", partitions);
+
+	std::ostringstream out;
+	boost::property_tree::write_json(out, root, false);
+	return out.str();
+}
+
+checkpoint_manifest deserialize_checkpoint_manifest(const std::string & manifest) {
+	try {
+		boost::property_tree::ptree root;
+		std::istringstream in(manifest);
+		boost::property_tree::read_json(in, root);
+
+		checkpoint_manifest result;
+		result.attempt = root.get<int32_t>("attempt");
+		result.kernel_name = root.get<std::string>("kernel_name");
+		result.sender = root.get<std::size_t>("sender");
+		result.num_nodes = root.get<std::size_t>("num_nodes");
+		result.hash_partitions_per_node = root.get<std::size_t>("hash_partitions_per_node");
+		// the manifests written without one are never restored
+		result.fingerprint = root.get<std::string>("fingerprint", "");
+		for (const auto & partition_node : root.get_child("partitions")) {
+			checkpoint_partition partition;
+			partition.file_name = partition_node.second.get<std::string>("file_name");
+			partition.destination = partition_node.second.get<std::size_t>("destination");
+			partition.cache_id = partition_node.second.get<std::string>("cache_id");
+			partition.message_id_prefix = partition_node.second.get<std::string>("message_id_prefix");
+			for (const auto & name_node : partition_node.second.get_child("column_names")) {
+				partition.column_names.push_back(name_node.second.get_value<std::string>());
+			}
+			for (const auto & value_node : partition_node.second.get_child("metadata")) {
+				partition.metadata[value_node.second.get<std::string>("key")] = value_node.second.get<std::string>("value");
+			}
+			result.partitions.push_back(partition);
+		}
+		return result;
+	} catch (const boost::property_tree::ptree_error & e) {
+		throw std::runtime_error(std::string("ERROR: Invalid shuffle checkpoint manifest: ") + e.what());
+	}
+}
+
+bool is_complete_checkpoint(const std::vector<checkpoint_manifest> & manifests,
+	const std::string & kernel_name,
+	std::size_t num_nodes,
+	std::size_t hash_partitions_per_node,
+	std::size_t node_index,
+	const std::string & fingerprint) {
+	if (manifests.empty() || fingerprint.empty()) {
+		return false;
+	}
+	std::vector<bool> senders(num_nodes, false);
+	for (const auto & manifest : manifests) {
+		if (manifest.attempt != manifests[0].attempt || manifest.kernel_name != kernel_name || manifest.num_nodes != num_nodes ||
+			manifest.hash_partitions_per_node != hash_partitions_per_node || manifest.sender >= num_nodes || senders[manifest.sender]) {
+			return false;
+		}
+		if (manifest.sender == node_index && manifest.fingerprint != fingerprint) {
+			return false;
+		}
+		senders[manifest.sender] = true;
+	}
+	return std::all_of(senders.begin(), senders.end(), [](bool sender) { return sender; });
+}
+
+shuffle_checkpoint::shuffle_checkpoint(const std::string & checkpoint_path,
+	std::size_t kernel_id,
+	const std::string & kernel_name,
+	int32_t attempt,
+	std::size_t node_index,
+	std::size_t num_nodes,
+	std::size_t hash_partitions_per_node)
+	: kernel_path(checkpoint_path + "/kernel_" + std::to_string(kernel_id)), node_index(node_index) {
+	while (this->kernel_path.size() > 1 && this->kernel_path[this->kernel_path.size() - 1] == '/') {
+		this->kernel_path.pop_back();
+	}
+	manifest.attempt = attempt;
+	manifest.kernel_name = kernel_name;
+	manifest.sender = node_index;
+	manifest.num_nodes = num_nodes;
+	manifest.hash_partitions_per_node = hash_partitions_per_node;
+}
+
+void shuffle_checkpoint::write_partition(const ral::frame::BlazingTableView & partition,
+	std::size_t destination,
+	const std::string & cache_id,
+	const std::string & message_id_prefix,
+	const std::map<std::string, std::string> & metadata) {
+	checkpoint_partition written;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		scattered = true;
+		if (!valid || partition.num_rows() == 0) {
+			return;
+		}
+		if (manifest.partitions.empty()) {
+			make_folder(this->kernel_path);
+		}
+		written.file_name = "part-" + std::to_string(manifest.sender) + "-" + std::to_string(manifest.attempt) + "-" +
+			std::to_string(manifest.partitions.size()) + ".raw";
+		written.destination = destination;
+		written.cache_id = cache_id;
+		written.message_id_prefix = message_id_prefix;
+		written.column_names = partition.names();
+		written.metadata = metadata;
+		// the slot keeps the name of the file taken while it is written
+		manifest.partitions.push_back(written);
+	}
+
+	try {
+		write_partition_file(this->kernel_path + "/" + written.file_name, partition);
+	} catch (const std::exception & e) {
+		// the query goes on without its checkpoint
+		log_checkpoint_error("Failed to write the shuffle checkpoint " + this->kernel_path + ": " + e.what());
+		invalidate();
+	}
+}
+
+void shuffle_checkpoint::invalidate() {
+	std::lock_guard<std::mutex> lock(mutex);
+	valid = false;
+}
+
+void shuffle_checkpoint::set_fingerprint(const std::string & fingerprint) {
+	std::lock_guard<std::mutex> lock(mutex);
+	manifest.fingerprint = fingerprint;
+}
+
+void shuffle_checkpoint::commit() {
+	std::string content;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!valid || !scattered) {
+			return;
+		}
+		content = serialize_checkpoint_manifest(manifest);
+	}
+
+	std::string path = this->kernel_path + "/manifest-" + std::to_string(node_index) + ".json";
+	try {
+		make_folder(this->kernel_path);
+		auto stream = BlazingContext::getInstance()->getFileSystemManager()->openWriteable(Uri(path));
+		if (stream == nullptr) {
+			throw std::runtime_error("ERROR: Could not open the shuffle checkpoint " + path);
+		}
+		check_status(stream->Write(content.data(), content.size()), path);
+		check_status(stream->Close(), path);
+	} catch (const std::exception & e) {
+		log_checkpoint_error("Failed to write the shuffle checkpoint " + path + ": " + e.what());
+	}
+}
+
+std::vector<checkpoint_manifest> shuffle_checkpoint::read_manifests() {
+	std::vector<checkpoint_manifest> manifests;
+	auto fs = BlazingContext::getInstance()->getFileSystemManager();
+	Uri folder_uri(this->kernel_path);
+	if (!fs->exists(folder_uri)) {
+		return manifests;
+	}
+	for (const Uri & manifest_uri : fs->list(folder_uri, "manifest-*.json")) {
+		try {
+			manifests.push_back(deserialize_checkpoint_manifest(read_file(manifest_uri.toString(true))));
+		} catch (const std::exception & e) {
+			// a manifest that was cut short is the same as a missing one
+			log_checkpoint_error("Skipping the shuffle checkpoint " + manifest_uri.toString(true) + ": " + e.what());
+		}
+	}
+	return manifests;
+}
+
+bool shuffle_checkpoint::can_restore() {
+	std::vector<checkpoint_manifest> manifests;
+	try {
+		manifests = read_manifests();
+	} catch (const std::exception & e) {
+		log_checkpoint_error("Failed to read the shuffle checkpoint " + this->kernel_path + ": " + e.what());
+		return false;
+	}
+	if (!is_complete_checkpoint(manifests, manifest.kernel_name, manifest.num_nodes, manifest.hash_partitions_per_node,
+			node_index, manifest.fingerprint)) {
+		return false;
+	}
+	restorable = std::move(manifests);
+	return true;
+}
+
+void shuffle_checkpoint::restore(const std::function<void(std::unique_ptr<ral::frame::BlazingTable>, const checkpoint_partition &)> & add) {
+	for (const auto & sender_manifest : restorable) {
+		for (const auto & partition : sender_manifest.partitions) {
+			if (partition.destination == node_index) {
+				add(read_partition_file(this->kernel_path + "/" + partition.file_name, partition.column_names), partition);
+			}
+		}
+	}
+}
+
+void shuffle_checkpoint::remove(const std::string & checkpoint_path) {
+	auto fs = BlazingContext::getInstance()->getFileSystemManager();
+	Uri checkpoint_uri(checkpoint_path);
+	if (!fs->exists(checkpoint_uri)) {
+		return;
+	}
+	for (const Uri & kernel_uri : fs->list(checkpoint_uri)) {
+		for (const Uri & file_uri : fs->list(kernel_uri)) {
+			fs->remove(file_uri);
+		}
+		fs->remove(kernel_uri);
+	}
+	fs->remove(checkpoint_uri);
+}
+
+}  // namespace distribution
+}  // namespace ral
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "execution_kernels/LogicPrimitives.h"
+
+namespace ral {
+namespace distribution {
+
+/**
+ * A partition that a node scattered in a kernel, as it is kept in a shuffle checkpoint.
+ */
+struct checkpoint_partition {
+	std::string file_name; /**< The file of the partition, in the folder of the kernel */
+	std::size_t destination = 0; /**< The index of the node it was sent to */
+	std::string cache_id; /**< The output cache of the kernel it went to */
+	std::string message_id_prefix;
+	std::vector<std::string> column_names;
+	std::map<std::string, std::string> metadata; /**< The extra metadata it was scattered with */
+};
+
+/**
+ * What a node scattered in a kernel in one attempt of a query. It is only written once the kernel finished, so the
+ * node of a manifest that is missing, or that was cut short when its node died, did not finish the kernel.
+ */
+struct checkpoint_manifest {
+	int32_t attempt = 0; /**< The ctx token of the query that wrote it */
+	std::string kernel_name;
+	std::size_t sender = 0; /**< The index of the node that wrote it */
+	std::size_t num_nodes = 0;
+	std::size_t hash_partitions_per_node = 1;
+	std::string fingerprint; /**< Of the plan and the inputs of the node that wrote it, see make_checkpoint_fingerprint */
+	std::vector<checkpoint_partition> partitions;
+};
+
+/**
+ * @brief The fingerprint of a query in a node: a hash of its logical plan and of the name and version of the data of
+ * each of its tables, as the data providers give it. The same query over changed files has another one.
+ * @return the fingerprint, or an empty string if the version of the data of any table is not known, as with the tables
+ * in memory, so the checkpoints of the query are never restored.
+ */
+std::string make_checkpoint_fingerprint(const std::string & logical_plan,
+	const std::vector<std::string> & table_names,
+	const std::vector<std::string> & data_versions);
+
+std::string serialize_checkpoint_manifest(const checkpoint_manifest & manifest);
+
+/**
+ * @throws std::runtime_error if it is not a manifest.
+ */
+checkpoint_manifest deserialize_checkpoint_manifest(const std::string & manifest);
+
+/**
+ * @brief Tells if the manifests of a kernel make a complete checkpoint for a query of num_nodes nodes: one manifest of
+ * every node, all of the same attempt of that many nodes. The partitions of all the destinations are then there, and
+ * they come from the same run of the kernels before it, so no row is missing or repeated. The manifest of node_index
+ * also has to have the fingerprint of the query now, since each node only knows the version of its own inputs; the
+ * nodes agree on the kernels that all of them can restore, see ral::cache::graph::plan_shuffle_checkpoint_restore.
+ */
+bool is_complete_checkpoint(const std::vector<checkpoint_manifest> & manifests,
+	const std::string & kernel_name,
+	std::size_t num_nodes,
+	std::size_t hash_partitions_per_node,
+	std::size_t node_index,
+	const std::string & fingerprint);
+
+/**
+ * The shuffle checkpoint of a distributing kernel. While the kernel runs, the partitions it scatters are written to
+ * the folder kernel_<id> of SHUFFLE_CHECKPOINT_PATH, on any of the registered filesystems, in the RAW format of the
+ * spill files, and its manifest is written once it finished.
+ *
+ * A later attempt of the same query, as after a node died, finds the kernels that every node finished. Instead of
+ * running them, the nodes add the partitions that were sent to them to the output caches of the kernel, and the
+ * kernels that only feed them are not run at all, so the query starts again from its last complete shuffle. The
+ * folder has to be one that all the nodes see, a shared filesystem or an object store, since a replacement node reads
+ * the partitions that were sent to the node it replaces, and the query has to run in the same number of nodes, since
+ * the kernels after the shuffle rely on the rows being in the node their keys hash to.
+ *
+ * The kernels that send their output in any other way, like the broadcasts of the small tables of the joins or the
+ * batches they keep in their node, invalidate their checkpoint, and their manifest is never written.
+ */
+class shuffle_checkpoint {
+public:
+	shuffle_checkpoint(const std::string & checkpoint_path,
+		std::size_t kernel_id,
+		const std::string & kernel_name,
+		int32_t attempt,
+		std::size_t node_index,
+		std::size_t num_nodes,
+		std::size_t hash_partitions_per_node);
+
+	/**
+	 * @brief Writes a partition that is scattered to the node of index destination. The empty partitions are not
+	 * written, and it does nothing once the checkpoint was invalidated.
+	 */
+	void write_partition(const ral::frame::BlazingTableView & partition,
+		std::size_t destination,
+		const std::string & cache_id,
+		const std::string & message_id_prefix,
+		const std::map<std::string, std::string> & metadata);
+
+	/**
+	 * @brief The kernel sent some of its output without scattering it, so its checkpoint can't be restored.
+	 */
+	void invalidate();
+
+	/**
+	 * @brief Sets the fingerprint of the query, see make_checkpoint_fingerprint. It is written in the manifest, and
+	 * can_restore needs the manifest of this node to have it. It has to be set before the kernel runs.
+	 */
+	void set_fingerprint(const std::string & fingerprint);
+
+	/**
+	 * @brief Writes the manifest, once the kernel finished, if it scattered anything, even if only empty partitions.
+	 */
+	void commit();
+
+	/**
+	 * @return true if all the nodes finished the kernel in an earlier attempt of the query, and the plan and the inputs
+	 * of this node did not change since then.
+	 */
+	bool can_restore();
+
+	/**
+	 * @brief Reads the partitions that were sent to this node in the attempt that can_restore found, and gives each of
+	 * them to add.
+	 */
+	void restore(const std::function<void(std::unique_ptr<ral::frame::BlazingTable>, const checkpoint_partition &)> & add);
+
+	/**
+	 * @brief Removes the checkpoint of a query, once it succeeded.
+	 */
+	static void remove(const std::string & checkpoint_path);
+
+private:
+	std::vector<checkpoint_manifest> read_manifests();
+
+	std::string kernel_path;
+	std::mutex mutex;
+	checkpoint_manifest manifest;
+	bool valid = true;
+	bool scattered = false;
+	std::size_t node_index;
+	std::vector<checkpoint_manifest> restorable; /**< The manifests that can_restore found complete */
+};
+
+}  // namespace distribution
+}  // namespace ral
@@ -1,6 +1,9 @@
 #include "CalciteInterpreter.h"
 #include "utilities/CodeTimer.h"
+#include "utilities/Tracer.h"
+#include "communication/CommunicationData.h"
 #include "execution_graph/PhysicalPlanGenerator.h"
+#include "distribution_utils/shuffle_checkpoint.h"
 
 using namespace fmt::literals;
 
@@ -118,7 +121,10 @@ std::shared_ptr<ral::cache::graph> generate_graph(std::vector<ral::io::data_load
 
 		if (query_graph->num_nodes() > 0) {
 			ral::cache::cache_settings cache_machine_config;
-			cache_machine_config.type = queryContext.getTotalNodes() == 1 ? ral::cache::CacheType::CONCATENATING : ral::cache::CacheType::SIMPLE;
+			// the batches of a query with RETURN_ITERATOR are given to the client as they come, so they are not concatenated
+			auto return_iterator = config_options.find("RETURN_ITERATOR");
+			bool streaming = return_iterator != config_options.end() && (return_iterator->second == "True" || return_iterator->second == "true");
+			cache_machine_config.type = queryContext.getTotalNodes() == 1 && !streaming ? ral::cache::CacheType::CONCATENATING : ral::cache::CacheType::SIMPLE;
 			cache_machine_config.context = queryContext.clone();
 			cache_machine_config.concat_all = true;
 
@@ -130,6 +136,12 @@ std::shared_ptr<ral::cache::graph> generate_graph(std::vector<ral::io::data_load
 		}
 		query_graph->check_and_complete_work_flow();
 		query_graph->set_kernels_order();
+		std::vector<std::string> data_versions;
+		for (auto & input_loader : input_loaders) {
+			data_versions.push_back(input_loader.get_provider()->get_data_version());
+		}
+		query_graph->plan_shuffle_checkpoint_restore(
+			ral::distribution::make_checkpoint_fingerprint(logicalPlan, table_names, data_versions));
 
 		auto  mem_monitor = std::make_shared<ral::MemoryMonitor>(tree,config_options);
 		query_graph->set_memory_monitor(mem_monitor);
@@ -154,11 +166,15 @@ void start_execute_graph(std::shared_ptr<ral::cache::graph> graph) {
 
 	try {
 
-		size_t max_kernel_run_threads = 16; //default
-		std::map<std::string, std::string> config_options = graph->get_last_kernel()->get_context()->getConfigOptions();
-		auto it = config_options.find("MAX_KERNEL_RUN_THREADS");
-		if (it != config_options.end()){
-			max_kernel_run_threads = std::stoi(config_options["MAX_KERNEL_RUN_THREADS"]);
+		const blazingdb::manager::QueryConfig & config = graph->get_last_kernel()->get_context()->getConfig();
+		size_t max_kernel_run_threads = config.max_kernel_run_threads.value_or(16);
+		if (config.query_timeout_ms){
+			graph->set_deadline(std::chrono::milliseconds(*config.query_timeout_ms));
+		}
+		const std::map<std::string, std::string> & config_options = config.options;
+		auto it = config_options.find("ENABLE_TRACING");
+		if (it != config_options.end() && (it->second == "True" || it->second == "true")){
+			ral::utilities::tracer::getInstance().start_tracing(context_token);
 		}
 
 		graph->start_execute(max_kernel_run_threads);
@@ -176,6 +192,33 @@ void start_execute_graph(std::shared_ptr<ral::cache::graph> graph) {
 	}
 }
 
+/**
+* Writes the Chrome trace of a query that was traced (ENABLE_TRACING) into the logging directory, as trace.<ral_id>.<query_id>.json
+*/
+static void write_query_trace(Context * context) {
+	std::map<std::string, std::string> config_options = context->getConfigOptions();
+	std::string logging_dir = "blazing_log";
+	auto it = config_options.find("BLAZING_LOGGING_DIRECTORY");
+	if (it != config_options.end()){
+		logging_dir = it->second;
+	}
+	int ral_id = context->getNodeIndex(ral::communication::CommunicationData::getInstance().getSelfNode());
+	uint32_t context_token = context->getContextToken();
+	std::string trace_file_name = logging_dir + "/trace." + std::to_string(ral_id) + "." + std::to_string(context_token) + ".json";
+
+	if (!ral::utilities::tracer::getInstance().write_chrome_trace(context_token, ral_id, trace_file_name)){
+		std::shared_ptr<spdlog::logger> logger = spdlog::get("batch_logger");
+		if(logger){
+			logger->warn("{query_id}|{step}|{substep}|{info}|{duration}||||",
+										"query_id"_a=context_token,
+										"step"_a="",
+										"substep"_a="",
+										"info"_a="Could not write the trace of the query to {}"_format(trace_file_name),
+										"duration"_a="");
+		}
+	}
+}
+
 std::vector<std::unique_ptr<ral::frame::BlazingTable>> get_execute_graph_results(std::shared_ptr<ral::cache::graph> graph) {
 	CodeTimer blazing_timer;
     std::shared_ptr<spdlog::logger> logger = spdlog::get("batch_logger");
@@ -185,8 +228,15 @@ std::vector<std::unique_ptr<ral::frame::BlazingTable>> get_execute_graph_results
 
 		graph->finish_execute();
 
-		auto output_frame = static_cast<ral::batch::OutputKernel&>(*(graph->get_last_kernel())).release();
-		assert(!output_frame.empty());
+		auto & tracer = ral::utilities::tracer::getInstance();
+		if (tracer.is_tracing(context_token)){
+			tracer.stop_tracing(context_token);
+			write_query_trace(graph->get_last_kernel()->get_context());
+		}
+
+		auto & output_kernel = static_cast<ral::batch::OutputKernel&>(*(graph->get_last_kernel()));
+		auto output_frame = output_kernel.release();
+		assert(!output_frame.empty() || output_kernel.is_streaming());
 
 		if(logger){
             logger->info("{query_id}|{step}|{substep}|{info}|{duration}||||",
@@ -208,6 +258,7 @@ std::vector<std::unique_ptr<ral::frame::BlazingTable>> get_execute_graph_results
                                         "info"_a="In get_execute_graph_results. What: {}"_format(e.what()),
                                         "duration"_a="");
 	    }
+		ral::utilities::tracer::getInstance().stop_tracing(context_token);
 		throw;
 	}
 }
@@ -10,6 +10,14 @@ Context::Context(const uint32_t token,
                  const std::string &logicalPlan,
                  const std::map<std::string, std::string>& config_options,
                  const std::string current_timestamp)
+    : Context(token, taskNodes, masterNode, logicalPlan, std::make_shared<const QueryConfig>(config_options), current_timestamp) {}
+
+Context::Context(const uint32_t token,
+                 const std::vector<Node> &taskNodes,
+                 const Node &masterNode,
+                 const std::string &logicalPlan,
+                 std::shared_ptr<const QueryConfig> config,
+                 const std::string current_timestamp)
     : token_{token},
       query_step{0},
       query_substep{0},
@@ -17,11 +25,11 @@ Context::Context(const uint32_t token,
       masterNode_{masterNode},
       logicalPlan_{logicalPlan},
       kernel_id_{0},
-      config_options_{config_options},
+      config_{std::move(config)},
       current_timestamp_{current_timestamp} {}
 
 std::shared_ptr<Context> Context::clone() {
-  auto ptr = std::make_shared<Context>(this->token_, this->taskNodes_, this->masterNode_, this->logicalPlan_, this->config_options_, this->current_timestamp_);
+  std::shared_ptr<Context> ptr(new Context(this->token_, this->taskNodes_, this->masterNode_, this->logicalPlan_, this->config_, this->current_timestamp_));
   ptr->query_step = this->query_step;
   ptr->query_substep = this->query_substep;
   ptr->kernel_id_ = this->kernel_id_;
@@ -2,8 +2,10 @@
 
 #include <vector>
 #include <map>
+#include <memory>
 #include <mutex>
 #include "transport/Node.h"
+#include "QueryConfig.h"
 
 namespace blazingdb {
 namespace manager {
@@ -64,11 +66,23 @@ public:
   uint32_t getKernelId() const {
     return this->kernel_id_;
   }
-  std::map<std::string, std::string> getConfigOptions() const {
-    return config_options_;
+  const std::map<std::string, std::string> & getConfigOptions() const {
+    return config_->options;
+  }
+
+  /// The config options that are read while the query runs, parsed when the Context was created
+  const QueryConfig & getConfig() const {
+    return *config_;
   }
 
 private:
+  Context(const uint32_t token,
+          const std::vector<Node>& taskNodes,
+          const Node& masterNode,
+          const std::string& logicalPlan,
+          std::shared_ptr<const QueryConfig> config,
+          const std::string current_timestamp);
+
   const uint32_t token_;
   uint32_t query_step;
   uint32_t query_substep;
@@ -77,7 +91,7 @@ private:
   const std::string logicalPlan_;
   uint32_t kernel_id_;
   std::mutex increment_step_mutex;
-  std::map<std::string, std::string> config_options_;
+  std::shared_ptr<const QueryConfig> config_; /// shared by the clones, since it never changes
   std::string current_timestamp_;
 };
 
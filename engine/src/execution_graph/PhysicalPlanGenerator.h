@@ -12,6 +12,7 @@
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/json_parser.hpp>
 #include <Util/StringUtil.h>
+#include <numeric>
 
 using namespace fmt::literals;
 
@@ -39,6 +40,8 @@ struct tree_processor {
 	std::vector<std::string> table_names;
 	std::vector<std::string> table_scans;
 	const bool transform_operators_bigger_than_gpu = false;
+	std::map<std::string, std::shared_ptr<const ral::cache::materialized_result>> materialized_results; // the materialized results this query reads, by fingerprint
+	std::map<std::string, std::shared_ptr<kernel>> spool_kernels; // the SpoolKernels of this query, by spool_id
 
 	tree_processor(	node root,
 		std::shared_ptr<Context> context,
@@ -52,7 +55,11 @@ struct tree_processor {
 
 	}
 
-	std::shared_ptr<kernel> make_kernel(std::size_t kernel_id, std::string expr, std::shared_ptr<ral::cache::graph> query_graph) {
+	/**
+	* @param table_sample the Sample of the TABLESAMPLE over a scan, see transform_json_tree.
+	*/
+	std::shared_ptr<kernel> make_kernel(std::size_t kernel_id, std::string expr, std::shared_ptr<ral::cache::graph> query_graph,
+		const std::string & table_sample = "") {
 		std::shared_ptr<kernel> k;
 		auto kernel_context = this->context->clone();
 		this->context->incrementQueryStep();
@@ -63,7 +70,19 @@ struct tree_processor {
 
 		} else if ( is_logical_scan(expr) ) {
 			size_t table_index = get_table_index(table_scans, expr);
-			k = std::make_shared<TableScan>(kernel_id, expr, this->input_loaders[table_index].get_provider()->clone(),this->input_loaders[table_index].get_parser(), this->schemas[table_index], kernel_context, query_graph);
+			// a sampled scan reads the files, since the cached table is not sampled and the sample is not cached
+			if (table_sample.empty()) {
+				k = make_cached_table_scan(kernel_id, expr, table_index, kernel_context, query_graph);
+			}
+			if (k == nullptr) {
+				auto scan = std::make_shared<TableScan>(kernel_id, expr, this->input_loaders[table_index].get_provider()->clone(),this->input_loaders[table_index].get_parser(), this->schemas[table_index], kernel_context, query_graph);
+				if (table_sample.empty()) {
+					scan->set_table_cache_fill(make_table_cache_fill(expr, table_index));
+				} else {
+					scan->set_table_sample(ral::operators::parse_table_sample(table_sample));
+				}
+				k = scan;
+			}
 			// lets erase the input_loaders and corresponding table_name and table_scan so that if we have a repeated table_scan, we dont reuse it
 			input_loaders.erase(input_loaders.begin() + table_index);
 			table_names.erase(table_names.begin() + table_index);
@@ -72,7 +91,12 @@ struct tree_processor {
 
 		} else if (is_bindable_scan(expr)) {
 			size_t table_index = get_table_index(table_scans, expr);
-			k = std::make_shared<BindableTableScan>(kernel_id, expr, this->input_loaders[table_index].get_provider()->clone(),this->input_loaders[table_index].get_parser(), this->schemas[table_index], kernel_context, query_graph);
+			k = make_cached_table_scan(kernel_id, expr, table_index, kernel_context, query_graph);
+			if (k == nullptr) {
+				auto scan = std::make_shared<BindableTableScan>(kernel_id, expr, this->input_loaders[table_index].get_provider()->clone(),this->input_loaders[table_index].get_parser(), this->schemas[table_index], kernel_context, query_graph);
+				scan->set_table_cache_fill(make_table_cache_fill(expr, table_index));
+				k = scan;
+			}
 			// lets erase the input_loaders and corresponding table_name and table_scan so that if we have a repeated table_scan, we dont reuse it
 			input_loaders.erase(input_loaders.begin() + table_index);
 			table_names.erase(table_names.begin() + table_index);
@@ -103,6 +127,9 @@ struct tree_processor {
 		} else if (is_limit(expr)) {
 			k = std::make_shared<LimitKernel>(kernel_id,expr, kernel_context, query_graph);
 
+		} else if (is_top_k(expr)) {
+			k = std::make_shared<TopKKernel>(kernel_id,expr, kernel_context, query_graph);
+
 		}  else if (is_compute_aggregate(expr)) {
 			k = std::make_shared<ComputeAggregateKernel>(kernel_id,expr, kernel_context, query_graph);
 
@@ -112,15 +139,135 @@ struct tree_processor {
 		}  else if (is_merge_aggregate(expr)) {
 			k = std::make_shared<MergeAggregateKernel>(kernel_id,expr, kernel_context, query_graph);
 
+		}  else if (is_grouping_sets(expr)) {
+			k = std::make_shared<GroupingSetsKernel>(kernel_id,expr, kernel_context, query_graph);
+
 		}  else if (is_pairwise_join(expr)) {
 			k = std::make_shared<PartwiseJoin>(kernel_id,expr, kernel_context, query_graph);
 
 		} else if (is_join_partition(expr)) {
 			k = std::make_shared<JoinPartitionKernel>(kernel_id,expr, kernel_context, query_graph);
 
+		} else if (is_sort_merge_join(expr)) {
+			k = std::make_shared<SortMergeJoinKernel>(kernel_id,expr, kernel_context, query_graph);
+
+		} else if (is_star_join(expr)) {
+			k = std::make_shared<StarJoinKernel>(kernel_id,expr, kernel_context, query_graph);
+
+		} else if (is_set_operation(expr)) {
+			k = std::make_shared<SetOperationKernel>(kernel_id,expr, kernel_context, query_graph);
+
 		} else if (is_union(expr)) {
 			k = std::make_shared<UnionKernel>(kernel_id,expr, kernel_context, query_graph);
 
+		} else if (is_spool(expr)) {
+			k = std::make_shared<SpoolKernel>(kernel_id,expr, kernel_context, query_graph);
+
+		} else {
+			RAL_FAIL("Invalid or unsupported expression: '" + expr + "' in the logical plan");
+		}
+		return k;
+	}
+
+	/**
+	* Get the key of a table in the table_cache, made of its name, the version of its data, the types of its cached columns
+	* and its indexed columns.
+	* @return the key, or an empty string if the table is not cached or the version of its data is not known.
+	*/
+	std::string get_table_cache_key(size_t table_index) {
+		const ral::io::Schema & schema = this->schemas[table_index];
+		if (!schema.is_cached()) {
+			return "";
+		}
+		std::string data_version = this->input_loaders[table_index].get_provider()->get_data_version();
+		if (data_version.empty()) {
+			return "";
+		}
+		std::string key = this->table_names[table_index] + "{" + data_version + "|" + std::to_string(static_cast<int>(this->input_loaders[table_index].get_parser()->type()));
+		auto dtypes = schema.get_dtypes();
+		for (int column_index : schema.get_cached_columns()) {
+			if (column_index < 0 || column_index >= static_cast<int>(dtypes.size())) {
+				return "";
+			}
+			key += "," + std::to_string(column_index) + ":" + std::to_string(static_cast<int>(dtypes[column_index]));
+		}
+		// the same columns with other indexes are another entry
+		for (int column_index : schema.get_index_columns()) {
+			key += ",#" + std::to_string(column_index);
+		}
+		return key + "}";
+	}
+
+	// the calcite indices of the columns a scan reads
+	std::vector<int> get_scan_projections(const std::string & expr, size_t table_index) {
+		std::vector<int> projections;
+		if (is_bindable_scan(expr)) {
+			projections = get_projections(expr);
+		}
+		if (projections.empty()) {
+			projections.resize(this->schemas[table_index].get_num_columns());
+			std::iota(projections.begin(), projections.end(), 0);
+		}
+		return projections;
+	}
+
+	/**
+	* Makes a CachedTableScan when the columns a scan reads are in the table_cache.
+	* @return the kernel, or nullptr if the scan has to read the files of the table.
+	*/
+	std::shared_ptr<kernel> make_cached_table_scan(std::size_t kernel_id, const std::string & expr, size_t table_index,
+		std::shared_ptr<Context> kernel_context, std::shared_ptr<ral::cache::graph> query_graph) {
+		std::string key = get_table_cache_key(table_index);
+		if (key.empty()) {
+			return nullptr;
+		}
+		std::shared_ptr<ral::cache::cached_table> table = ral::cache::table_cache::get_instance().get(key);
+		std::vector<int> projections = get_scan_projections(expr, table_index);
+		if (table == nullptr || !table->has_columns(projections)) {
+			return nullptr;
+		}
+		return std::make_shared<CachedTableScan>(kernel_id, expr, table, projections, kernel_context, query_graph);
+	}
+
+	/**
+	* Makes the table_cache_fill of a scan of a cached table that is not in the table_cache yet. Only the scans without
+	* a filter that read all the cached columns fill it.
+	* @return the fill, or nullptr if the scan does not fill the table_cache.
+	*/
+	std::shared_ptr<ral::cache::table_cache_fill> make_table_cache_fill(const std::string & expr, size_t table_index) {
+		std::string key = get_table_cache_key(table_index);
+		if (key.empty() || is_filtered_bindable_scan(expr)) {
+			return nullptr;
+		}
+		std::vector<int> projections = get_scan_projections(expr, table_index);
+		std::vector<int> positions;
+		for (int column_index : this->schemas[table_index].get_cached_columns()) {
+			auto it = std::find(projections.begin(), projections.end(), column_index);
+			if (it == projections.end()) {
+				return nullptr;
+			}
+			positions.push_back(std::distance(projections.begin(), it));
+		}
+
+		std::size_t max_bytes = 4294967296; // 4 GB
+		std::map<std::string, std::string> config_options = this->context->getConfigOptions();
+		auto it = config_options.find("TABLE_CACHE_MAX_BYTES");
+		if (it != config_options.end()){
+			max_bytes = std::stoull(it->second);
+		}
+		auto table = std::make_shared<ral::cache::cached_table>(this->table_names[table_index], this->schemas[table_index].get_cached_columns(),
+			this->schemas[table_index].get_index_columns());
+		return std::make_shared<ral::cache::table_cache_fill>(key, table, positions, max_bytes);
+	}
+
+	std::shared_ptr<kernel> make_materialization_kernel(std::size_t kernel_id, std::string expr, std::string fingerprint, std::shared_ptr<ral::cache::graph> query_graph) {
+		std::shared_ptr<kernel> k;
+		auto kernel_context = this->context->clone();
+		this->context->incrementQueryStep();
+		if (is_materialized_result_scan(expr)) {
+			k = std::make_shared<MaterializedResultScan>(kernel_id, expr, this->materialized_results[fingerprint], kernel_context, query_graph);
+		} else if (is_materialize(expr)) {
+			k = std::make_shared<Materialize>(kernel_id, expr, fingerprint, kernel_context, query_graph);
 		} else {
 			RAL_FAIL("Invalid or unsupported expression: '" + expr + "' in the logical plan");
 		}
@@ -131,7 +278,45 @@ struct tree_processor {
 		auto expr = p_tree.get<std::string>("expr", "");
 		root_ptr->expr = expr;
 		root_ptr->level = level;
-		root_ptr->kernel_unit = make_kernel(kernel_id, expr, query_graph);
+		auto spool_id = p_tree.get_optional<std::string>("spool_id");
+		if (spool_id && this->spool_kernels.find(*spool_id) != this->spool_kernels.end()) {
+			// the subplan of the spool is under its first occurrence
+			root_ptr->kernel_unit = this->spool_kernels[*spool_id];
+			return kernel_id;
+		}
+		auto fingerprint = p_tree.get_optional<std::string>("fingerprint");
+		if (fingerprint) {
+			root_ptr->kernel_unit = make_materialization_kernel(kernel_id, expr, *fingerprint, query_graph);
+		} else {
+			root_ptr->kernel_unit = make_kernel(kernel_id, expr, query_graph, p_tree.get<std::string>("table_sample", ""));
+		}
+		if (spool_id) {
+			this->spool_kernels[*spool_id] = root_ptr->kernel_unit;
+		}
+		root_ptr->kernel_unit->set_priority_level(level);
+		auto fused_filters = p_tree.get_child_optional("fused_filters");
+		if (fused_filters) {
+			auto projection = std::static_pointer_cast<Projection>(root_ptr->kernel_unit);
+			for (auto &filter : *fused_filters) {
+				projection->add_fused_filter(filter.second.get_value<std::string>());
+			}
+		}
+		auto star_joins = p_tree.get_child_optional("star_joins");
+		if (star_joins) {
+			auto star_join = std::static_pointer_cast<StarJoinKernel>(root_ptr->kernel_unit);
+			for (auto &join : *star_joins) {
+				star_join->add_dimension_join(join.second.get_value<std::string>());
+			}
+		}
+		if (p_tree.get<std::string>("normalize_hashed_keys", "") == "true") {
+			std::static_pointer_cast<DistributeAggregateKernel>(root_ptr->kernel_unit)->set_normalize_hashed_keys(true);
+		}
+		if (is_join_partition(expr)) {
+			auto join_partition = std::static_pointer_cast<JoinPartitionKernel>(root_ptr->kernel_unit);
+			std::string partitioned_inputs = p_tree.get<std::string>("partitioned_inputs", "");
+			join_partition->set_partitioning(p_tree.get<std::string>("hash_partitioned", "") == "true",
+				partitioned_inputs == "left" || partitioned_inputs == "both", partitioned_inputs == "right" || partitioned_inputs == "both");
+		}
 		kernel_id++;
 		for (auto &child : p_tree.get_child("children")) {
 			auto child_node_ptr = std::make_shared<node>();
@@ -159,6 +344,12 @@ struct tree_processor {
 				StringUtil::findAndReplaceAll(limit_expr, LOGICAL_SORT_TEXT, LOGICAL_LIMIT_TEXT);
 
 				p_tree.put("expr", limit_expr);
+			} else if ( can_top_k(expr) ) {
+				// only the first rows of every node are kept, and the master node merges them
+				std::string top_k_expr = expr;
+				StringUtil::findAndReplaceAll(top_k_expr, LOGICAL_SORT_TEXT, LOGICAL_TOP_K_TEXT);
+
+				p_tree.put("expr", top_k_expr);
 			} else {
 				if (this->context->getTotalNodes() == 1) {
 					StringUtil::findAndReplaceAll(limit_expr, LOGICAL_SORT_TEXT, LOGICAL_LIMIT_TEXT);
@@ -189,12 +380,22 @@ struct tree_processor {
 				}
 			}
 		}
+		else if (is_aggregate(expr) && !ral::operators::get_grouping_sets(expr).empty()) {
+			transform_grouping_sets(p_tree);
+		}
 		else if (is_aggregate(expr)) {
 			std::string merge_aggregate_expr = expr;
 			std::string distribute_aggregate_expr = expr;
 			std::string compute_aggregate_expr = expr;
 
-			if (this->context->getTotalNodes() == 1) {
+			// the groups are all in one node already when the input is split between the nodes by some of the group columns,
+			// as a bucketed table grouped by its bucket column or the output of a join grouped by its keys
+			partitioning_info partitioning;
+			bool co_located = this->context->getTotalNodes() > 1 && is_co_located_aggregate(p_tree, partitioning);
+			if (co_located) {
+				force_hash_partitioning(partitioning);
+			}
+			if (this->context->getTotalNodes() == 1 || co_located) {
 				StringUtil::findAndReplaceAll(merge_aggregate_expr, LOGICAL_AGGREGATE_TEXT, LOGICAL_MERGE_AGGREGATE_TEXT);
 				StringUtil::findAndReplaceAll(compute_aggregate_expr, LOGICAL_AGGREGATE_TEXT, LOGICAL_COMPUTE_AGGREGATE_TEXT);
 
@@ -226,8 +427,15 @@ struct tree_processor {
 			}
 		}
 		else if (is_join(expr)) {
-			if (this->context->getTotalNodes() == 1) {
-				// PartwiseJoin
+			if (this->context->getTotalNodes() == 1 && star_join_enabled() && make_star_join(p_tree)) {
+				// StarJoin, the joins of the chain below this one are done by the same kernel
+			} else if (this->context->getTotalNodes() == 1 && sort_merge_join_enabled() && can_sort_merge_join(p_tree)) {
+				// SortMergeJoin, both inputs come out of a sort on the key
+				std::string sort_merge_expr = expr;
+				StringUtil::findAndReplaceAll(sort_merge_expr, LOGICAL_JOIN_TEXT, LOGICAL_SORT_MERGE_JOIN_TEXT);
+				p_tree.put("expr", sort_merge_expr);
+			} else if (this->context->getTotalNodes() == 1 || is_co_bucketed_join(p_tree)) {
+				// PartwiseJoin, without the JoinPartition when the rows that match are already in the same node
 				std::string pairwise_expr = expr;
 				StringUtil::findAndReplaceAll(pairwise_expr, LOGICAL_JOIN_TEXT, LOGICAL_PARTWISE_JOIN_TEXT);
 				p_tree.put("expr", pairwise_expr);
@@ -238,8 +446,18 @@ struct tree_processor {
 				StringUtil::findAndReplaceAll(pairwise_expr, LOGICAL_JOIN_TEXT, LOGICAL_PARTWISE_JOIN_TEXT);
 				StringUtil::findAndReplaceAll(join_partition_expr, LOGICAL_JOIN_TEXT, LOGICAL_JOIN_PARTITION_TEXT);
 
+				// the consumers that rely on the output being hashed by the keys marked the join, see force_hash_partitioning
+				std::string hash_partitioned = p_tree.get<std::string>("hash_partitioned", "");
+				std::string partitioned_inputs = get_partitioned_join_inputs(p_tree);
+
 				boost::property_tree::ptree join_partition_tree;
 				join_partition_tree.put("expr", join_partition_expr);
+				if (!hash_partitioned.empty()) {
+					join_partition_tree.put("hash_partitioned", hash_partitioned);
+				}
+				if (!partitioned_inputs.empty()) {
+					join_partition_tree.put("partitioned_inputs", partitioned_inputs);
+				}
 				join_partition_tree.add_child("children", p_tree.get_child("children"));
 
 				p_tree.clear();
@@ -248,48 +466,33 @@ struct tree_processor {
 				p_tree.put_child("children", create_array_tree(join_partition_tree));
 			}
 		}
-		// special case when the query contains UNION
-		else if (is_union(expr) && get_named_expression(expr, "all") == "false") {
-			expr = "LogicalUnion(all=[true])";
-
-			// when UNION, we want to do a group by on all columns without aggregations.
-			std::string merge_aggregate_expr = LOGICAL_MERGE_AGGREGATE_TEXT + "(group=[{*}])";
-			std::string compute_aggregate_expr = LOGICAL_COMPUTE_AGGREGATE_TEXT + "(group=[{*}])";
-			std::string distribute_aggregate_expr = LOGICAL_DISTRIBUTE_AGGREGATE_TEXT + "(group=[{*}])";
-
-			if (this->context->getTotalNodes() == 1) {
-
-				boost::property_tree::ptree root_union_tree;
-				root_union_tree.put("expr", expr);
-				root_union_tree.add_child("children", p_tree.get_child("children"));
-
-				boost::property_tree::ptree agg_union_tree;
-				agg_union_tree.put("expr", compute_aggregate_expr);
-				agg_union_tree.add_child("children", create_array_tree(root_union_tree));
-
-				p_tree.clear();
-
-				p_tree.put("expr", merge_aggregate_expr);
-				p_tree.put_child("children", create_array_tree(agg_union_tree));
-
-			} else {
-
-				boost::property_tree::ptree root_union_tree;
-				root_union_tree.put("expr", expr);
-				root_union_tree.add_child("children", p_tree.get_child("children"));
-
-				boost::property_tree::ptree compute_aggregate_tree;
-				compute_aggregate_tree.put("expr", compute_aggregate_expr);
-				compute_aggregate_tree.add_child("children", create_array_tree(root_union_tree));
-
-				boost::property_tree::ptree distribute_aggregate_tree;
-				distribute_aggregate_tree.put("expr", distribute_aggregate_expr);
-				distribute_aggregate_tree.add_child("children", create_array_tree(compute_aggregate_tree));
-
-				p_tree.clear();
+		// UNION, INTERSECT and EXCEPT without ALL are computed by the SetOperationKernel
+		else if (is_set_operation(expr)) {
+			if (get_named_expression(expr, "all") == "true") {
+				throw std::runtime_error("INTERSECT ALL and EXCEPT ALL are not supported currently. Expression found is: " + expr);
+			}
 
-				p_tree.put("expr", merge_aggregate_expr);
-				p_tree.put_child("children", create_array_tree(distribute_aggregate_tree));
+			if (this->context->getTotalNodes() > 1) {
+				// every input is hashed by all of its columns, so the same rows of both inputs end up in the same node.
+				// The columns of the inputs can have different types, that the SetOperationKernel casts to their common
+				// type, so the rows are hashed by their values in the widest type of their kind
+				std::string compute_aggregate_expr = LOGICAL_COMPUTE_AGGREGATE_TEXT + "(group=[{*}])";
+				std::string distribute_aggregate_expr = LOGICAL_DISTRIBUTE_AGGREGATE_TEXT + "(group=[{*}])";
+
+				boost::property_tree::ptree distributed_children;
+				for (auto &child : p_tree.get_child("children")) {
+					boost::property_tree::ptree compute_aggregate_tree;
+					compute_aggregate_tree.put("expr", compute_aggregate_expr);
+					compute_aggregate_tree.put_child("children", create_array_tree(child.second));
+
+					boost::property_tree::ptree distribute_aggregate_tree;
+					distribute_aggregate_tree.put("expr", distribute_aggregate_expr);
+					distribute_aggregate_tree.put("normalize_hashed_keys", "true");
+					distribute_aggregate_tree.put_child("children", create_array_tree(compute_aggregate_tree));
+
+					distributed_children.push_back(std::make_pair("", distribute_aggregate_tree));
+				}
+				p_tree.put_child("children", distributed_children);
 			}
 		}
 		else if (is_project(expr) && is_window_function(expr) && first_windowed_call) {
@@ -305,7 +508,8 @@ struct tree_processor {
                 throw std::runtime_error("In Window Function: RANGE is not currently supported. Expression found is: " + expr);
             }
 
-			if (window_expression_contains_partition_by(expr)) {
+			// the partitions that can be split are computed with overlaps, like the windows without partitions
+			if (window_expression_contains_partition_by(expr) && !window_expression_can_split_partitions(expr)) {
 				std::string sort_expr = expr;
 				std::string window_expr = expr;
 
@@ -400,11 +604,795 @@ struct tree_processor {
 			return;				
 		}
 
+		else if (is_table_sample(expr)) {
+			// the TableScan below the sample applies it, reading only the row groups or the rows that it keeps
+			if (p_tree.get_child("children").size() != 1 ||
+					!is_logical_scan(p_tree.get_child("children").front().second.get<std::string>("expr", ""))) {
+				throw std::runtime_error("ERROR: TABLESAMPLE is only supported directly over a table");
+			}
+			boost::property_tree::ptree child = p_tree.get_child("children").front().second;
+			child.put("table_sample", expr);
+			p_tree = child;
+			return;
+		}
+
+		else if (is_project(expr) && !is_window_function(expr) && kernel_fusion_enabled()) {
+			// the filters right below a projection are fused into it, so that both run in a single task on the same stream
+			boost::property_tree::ptree fused_filters;
+			while (p_tree.get_child("children").size() == 1) {
+				boost::property_tree::ptree child = p_tree.get_child("children").front().second;
+				std::string child_expr = child.get<std::string>("expr", "");
+				if (!is_filter(child_expr)) {
+					break;
+				}
+				// the filter closest to the data has to be applied first
+				boost::property_tree::ptree filter_tree;
+				filter_tree.put("", child_expr);
+				fused_filters.push_front(std::make_pair("", filter_tree));
+				p_tree.put_child("children", child.get_child("children"));
+			}
+			if (!fused_filters.empty()) {
+				p_tree.put_child("fused_filters", fused_filters);
+			}
+		}
+
 		for (auto &child : p_tree.get_child("children")) {
 			transform_json_tree(child.second);
 		}
 	}
 
+	/**
+	* Makes an aggregate of GROUPING SETS, ROLLUP or CUBE into a GroupingSets over the aggregate of all its group columns,
+	* so that its input is grouped once instead of once for every set. The aggregate of all the columns is distributed by
+	* the columns that are in every set, which keeps every group of every set in one node. When no column is in every set,
+	* as with ROLLUP and CUBE, the groups are all merged in the master node.
+	*/
+	void transform_grouping_sets(boost::property_tree::ptree &p_tree) {
+		std::string expr = p_tree.get<std::string>("expr", "");
+		std::vector<std::vector<int>> grouping_sets = ral::operators::get_grouping_sets(expr);
+		std::vector<int> group_column_indices = ral::operators::get_grouping_sets_group_columns(
+			ral::operators::get_group_columns(expr), grouping_sets);
+		std::vector<int> common_group_columns;
+		for (int column_index : group_column_indices) {
+			if (std::all_of(grouping_sets.begin(), grouping_sets.end(), [column_index](const std::vector<int> & grouping_set) {
+					return std::find(grouping_set.begin(), grouping_set.end(), column_index) != grouping_set.end(); })) {
+				common_group_columns.push_back(column_index);
+			}
+		}
+
+		std::string aggregate_expr = ral::operators::get_grouping_sets_aggregate_expression(expr, group_column_indices);
+		std::vector<AggregateKind> aggregation_types;
+		std::tie(std::ignore, std::ignore, aggregation_types, std::ignore) = ral::operators::parseGroupByExpression(aggregate_expr, 0);
+		if (!ral::operators::can_merge_aggregated_output(aggregation_types)) {
+			throw std::runtime_error("GROUPING SETS, ROLLUP and CUBE are only supported with SUM, MIN, MAX, COUNT and AVG currently. Expression found is: " + expr);
+		}
+
+		std::string compute_aggregate_expr = aggregate_expr;
+		std::string merge_aggregate_expr = aggregate_expr;
+		std::string grouping_sets_expr = expr;
+		StringUtil::findAndReplaceAll(compute_aggregate_expr, LOGICAL_AGGREGATE_TEXT, LOGICAL_COMPUTE_AGGREGATE_TEXT);
+		StringUtil::findAndReplaceAll(merge_aggregate_expr, LOGICAL_AGGREGATE_TEXT, LOGICAL_MERGE_AGGREGATE_TEXT);
+		StringUtil::findAndReplaceAll(grouping_sets_expr, LOGICAL_AGGREGATE_TEXT, LOGICAL_GROUPING_SETS_TEXT);
+
+		boost::property_tree::ptree aggregate_tree;
+		aggregate_tree.put("expr", compute_aggregate_expr);
+		aggregate_tree.add_child("children", p_tree.get_child("children"));
+
+		if (this->context->getTotalNodes() > 1) {
+			// the groups are hashed by the columns in every set, which are the first ones
+			std::string distribute_aggregate_expr = ral::operators::get_grouping_sets_aggregate_expression(expr, common_group_columns);
+			StringUtil::findAndReplaceAll(distribute_aggregate_expr, LOGICAL_AGGREGATE_TEXT, LOGICAL_DISTRIBUTE_AGGREGATE_TEXT);
+
+			boost::property_tree::ptree distribute_aggregate_tree;
+			distribute_aggregate_tree.put("expr", distribute_aggregate_expr);
+			distribute_aggregate_tree.put_child("children", create_array_tree(aggregate_tree));
+			aggregate_tree = distribute_aggregate_tree;
+		}
+
+		boost::property_tree::ptree merge_aggregate_tree;
+		merge_aggregate_tree.put("expr", merge_aggregate_expr);
+		merge_aggregate_tree.put_child("children", create_array_tree(aggregate_tree));
+
+		p_tree.clear();
+
+		p_tree.put("expr", grouping_sets_expr);
+		p_tree.put_child("children", create_array_tree(merge_aggregate_tree));
+	}
+
+	/**
+	* Replaces the subplans whose result was materialized by a previous query with a scan of that result, and
+	* makes the other subplans that can be reused materialize their result for the next queries.
+	* Only the subplans of a group by (MergeAggregate) are reused, since their results are small compared to what they read.
+	*/
+	void apply_materialization_cache(boost::property_tree::ptree &p_tree) {
+		std::string expr = p_tree.get<std::string>("expr", "");
+		if (is_merge_aggregate(expr)) {
+			std::string fingerprint = get_subplan_fingerprint(p_tree);
+			if (!fingerprint.empty()) {
+				auto result = ral::cache::materialization_cache::get_instance().get(fingerprint);
+				boost::property_tree::ptree materialization_tree;
+				if (result != nullptr) {
+					this->materialized_results[fingerprint] = result;
+					materialization_tree.put("expr", LOGICAL_MATERIALIZED_RESULT_SCAN_TEXT);
+					materialization_tree.put("fingerprint", fingerprint);
+					materialization_tree.put_child("children", boost::property_tree::ptree());
+				} else {
+					materialization_tree.put("expr", LOGICAL_MATERIALIZE_TEXT);
+					materialization_tree.put("fingerprint", fingerprint);
+					materialization_tree.put_child("children", create_array_tree(p_tree));
+				}
+				p_tree = materialization_tree;
+				return;
+			}
+		}
+
+		for (auto &child : p_tree.get_child("children")) {
+			apply_materialization_cache(child.second);
+		}
+	}
+
+	/**
+	* Get the fingerprint of a subplan, made of its relational algebra and the version of the data of every table it scans.
+	* @return the fingerprint, or an empty string if the result of the subplan can't be reused.
+	*/
+	std::string get_subplan_fingerprint(const boost::property_tree::ptree &p_tree) {
+		std::string expr = p_tree.get<std::string>("expr", "");
+		if (has_non_deterministic_function(expr)) {
+			return "";
+		}
+
+		std::string fingerprint = expr;
+		if (is_scan(expr)) {
+			size_t table_index = get_table_index(table_scans, expr);
+			std::string data_version = this->input_loaders[table_index].get_provider()->get_data_version();
+			if (data_version.empty()) {
+				return "";
+			}
+			fingerprint += "{" + data_version + "|" + std::to_string(static_cast<int>(this->input_loaders[table_index].get_parser()->type()));
+			auto dtypes = this->schemas[table_index].get_dtypes();
+			for (auto & dtype : dtypes) {
+				fingerprint += "," + std::to_string(static_cast<int>(dtype));
+			}
+			fingerprint += "}";
+		}
+		auto table_sample = p_tree.get_optional<std::string>("table_sample");
+		if (table_sample) {
+			// the rows of a sample without REPEATABLE change every time
+			if (get_named_expression(*table_sample, "repeatableSeed") == "-") {
+				return "";
+			}
+			fingerprint += "<" + *table_sample + ">";
+		}
+		auto fused_filters = p_tree.get_child_optional("fused_filters");
+		if (fused_filters) {
+			for (auto &filter : *fused_filters) {
+				fingerprint += "<" + filter.second.get_value<std::string>() + ">";
+			}
+		}
+		fingerprint += "(";
+		for (auto &child : p_tree.get_child("children")) {
+			std::string child_fingerprint = get_subplan_fingerprint(child.second);
+			if (child_fingerprint.empty()) {
+				return "";
+			}
+			fingerprint += child_fingerprint + ";";
+		}
+		return fingerprint + ")";
+	}
+
+	bool has_non_deterministic_function(const std::string & expr) {
+		for (const std::string & non_deterministic_function : {"RAND", "CURRENT_", "LOCALTIME", "NOW("}) {
+			if (expr.find(non_deterministic_function) != std::string::npos) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/**
+	* Makes the subplans that are used more than once in the query, as a CTE that is read twice or the sides of a self join, run only once.
+	* The first occurrence of such a subplan is put under a LogicalSpool, which gives every batch of it to all of its consumers,
+	* and the other occurrences are replaced by that same spool, without children.
+	*/
+	void apply_common_subplan_reuse(boost::property_tree::ptree &p_tree) {
+		std::map<std::string, int> occurrences;
+		get_subplan_key(p_tree, &occurrences);
+		std::map<std::string, std::string> spool_ids;
+		add_spools(p_tree, occurrences, spool_ids);
+
+		// the subplans that were only repeated inside another repeated subplan have a single consumer left
+		std::map<std::string, int> consumers;
+		count_spool_consumers(p_tree, consumers);
+		remove_single_consumer_spools(p_tree, consumers);
+	}
+
+	/**
+	* Get the key of a subplan, which is the same for the subplans that give the same result within a query.
+	* @param occurrences if not null, counts how many times every subplan that can be spooled is in the plan.
+	* @return the key, or an empty string if the subplan can give a different result every time.
+	*/
+	std::string get_subplan_key(const boost::property_tree::ptree &p_tree, std::map<std::string, int> * occurrences = nullptr) {
+		std::string expr = p_tree.get<std::string>("expr", "");
+		bool deterministic = !has_non_deterministic_function(expr);
+		std::string key = expr;
+		auto fingerprint = p_tree.get_optional<std::string>("fingerprint");
+		if (fingerprint) {
+			key += "#" + *fingerprint;
+		}
+		auto fused_filters = p_tree.get_child_optional("fused_filters");
+		if (fused_filters) {
+			for (auto &filter : *fused_filters) {
+				key += "<" + filter.second.get_value<std::string>() + ">";
+			}
+		}
+		// a join whose output has to stay hashed by its keys is not the same as one that can broadcast a small table
+		for (const std::string & partitioning : {"hash_partitioned", "partitioned_inputs", "normalize_hashed_keys"}) {
+			auto value = p_tree.get_optional<std::string>(partitioning);
+			if (value) {
+				key += "<" + partitioning + "=" + *value + ">";
+			}
+		}
+		key += "(";
+		for (auto &child : p_tree.get_child("children")) {
+			std::string child_key = get_subplan_key(child.second, occurrences);
+			deterministic = deterministic && !child_key.empty();
+			key += child_key + ";";
+		}
+		if (!deterministic) {
+			return "";
+		}
+		key += ")";
+		if (occurrences != nullptr && can_spool(expr)) {
+			(*occurrences)[key]++;
+		}
+		return key;
+	}
+
+	// the kernels whose outputs go to several ports of their consumer are not spooled, see visit
+	bool can_spool(const std::string & expr) {
+		return !is_join_partition(expr) && !is_sort_and_sample(expr) && !is_generate_overlaps(expr) &&
+			!is_partition(expr) && !is_single_node_partition(expr);
+	}
+
+	void add_spools(boost::property_tree::ptree &p_tree, std::map<std::string, int> & occurrences, std::map<std::string, std::string> & spool_ids) {
+		std::string key = get_subplan_key(p_tree);
+		auto occurrence = occurrences.find(key);
+		if (key.empty() || occurrence == occurrences.end() || occurrence->second < 2) {
+			for (auto &child : p_tree.get_child("children")) {
+				add_spools(child.second, occurrences, spool_ids);
+			}
+			return;
+		}
+
+		boost::property_tree::ptree spool_tree;
+		spool_tree.put("expr", LOGICAL_SPOOL_TEXT);
+		auto spool_id = spool_ids.find(key);
+		if (spool_id == spool_ids.end()) {
+			std::string new_spool_id = std::to_string(spool_ids.size());
+			spool_ids[key] = new_spool_id;
+			// the subplans repeated inside this one can also be repeated somewhere else
+			for (auto &child : p_tree.get_child("children")) {
+				add_spools(child.second, occurrences, spool_ids);
+			}
+			spool_tree.put("spool_id", new_spool_id);
+			spool_tree.put_child("children", create_array_tree(p_tree));
+		} else {
+			spool_tree.put("spool_id", spool_id->second);
+			spool_tree.put_child("children", boost::property_tree::ptree());
+		}
+		p_tree = spool_tree;
+	}
+
+	void count_spool_consumers(const boost::property_tree::ptree &p_tree, std::map<std::string, int> & consumers) {
+		auto spool_id = p_tree.get_optional<std::string>("spool_id");
+		if (spool_id) {
+			consumers[*spool_id]++;
+		}
+		for (auto &child : p_tree.get_child("children")) {
+			count_spool_consumers(child.second, consumers);
+		}
+	}
+
+	void remove_single_consumer_spools(boost::property_tree::ptree &p_tree, std::map<std::string, int> & consumers) {
+		auto spool_id = p_tree.get_optional<std::string>("spool_id");
+		if (spool_id && consumers[*spool_id] < 2) {
+			boost::property_tree::ptree subplan = p_tree.get_child("children").front().second;
+			p_tree = subplan;
+			remove_single_consumer_spools(p_tree, consumers);
+			return;
+		}
+		for (auto &child : p_tree.get_child("children")) {
+			remove_single_consumer_spools(child.second, consumers);
+		}
+	}
+
+	bool common_subplan_reuse_enabled() {
+		std::map<std::string, std::string> config_options = this->context->getConfigOptions();
+		auto it = config_options.find("ENABLE_COMMON_SUBPLAN_REUSE");
+		if (it != config_options.end()){
+			return it->second != "False" && it->second != "false";
+		}
+		return true;
+	}
+
+	bool metadata_aggregation_enabled() {
+		std::map<std::string, std::string> config_options = this->context->getConfigOptions();
+		auto it = config_options.find("ENABLE_METADATA_AGGREGATION");
+		if (it != config_options.end()){
+			return it->second != "False" && it->second != "false";
+		}
+		return true;
+	}
+
+	bool sql_pushdown_enabled() {
+		std::map<std::string, std::string> config_options = this->context->getConfigOptions();
+		auto it = config_options.find("ENABLE_SQL_PUSHDOWN");
+		if (it != config_options.end()){
+			return it->second != "False" && it->second != "false";
+		}
+		return true;
+	}
+
+	bool materialization_cache_enabled() {
+		if (this->context->getTotalNodes() != 1) {
+			// the other nodes would wait for the partitions of a subplan that this node did not run
+			return false;
+		}
+		std::map<std::string, std::string> config_options = this->context->getConfigOptions();
+		auto it = config_options.find("ENABLE_MATERIALIZATION_CACHE");
+		return it != config_options.end() && (it->second == "True" || it->second == "true");
+	}
+
+	bool sort_merge_join_enabled() {
+		std::map<std::string, std::string> config_options = this->context->getConfigOptions();
+		auto it = config_options.find("ENABLE_SORT_MERGE_JOIN");
+		if (it != config_options.end()){
+			return it->second != "False" && it->second != "false";
+		}
+		return true;
+	}
+
+	bool star_join_enabled() {
+		std::map<std::string, std::string> config_options = this->context->getConfigOptions();
+		auto it = config_options.find("ENABLE_STAR_JOIN");
+		return it != config_options.end() && (it->second == "True" || it->second == "true");
+	}
+
+	/**
+	* Makes a chain of at least two joins that can be done by a StarJoin, where every join is the left input of the next
+	* one, into a StarJoin. The left input of the first join of the chain is the fact input, the first child of the
+	* StarJoin, and the right inputs of the joins are the dimensions, the following children. The children are still
+	* the Calcite nodes, and the joins are kept in star_joins for the kernel.
+	* @return whether the join was made into a StarJoin.
+	*/
+	bool make_star_join(boost::property_tree::ptree & p_tree) {
+		// from the last join of the chain, every input but the first one is a port of the kernel, from input_b to input_z
+		const std::size_t max_dimensions = 25;
+		std::vector<std::string> join_exprs;
+		std::vector<const boost::property_tree::ptree *> dimensions;
+		const boost::property_tree::ptree * join_tree = &p_tree;
+		while (join_exprs.size() < max_dimensions) {
+			std::string join_expr = join_tree->get<std::string>("expr", "");
+			auto & children = join_tree->get_child("children");
+			// the output of a spool or a materialization has to stay the output of its join
+			bool shared = join_tree != &p_tree && (join_tree->get_optional<std::string>("spool_id") || join_tree->get_optional<std::string>("fingerprint"));
+			if (!is_join(join_expr) || children.size() != 2 || shared || !StarJoinKernel::can_join(join_expr)) {
+				break;
+			}
+			join_exprs.push_back(join_expr);
+			dimensions.push_back(&children.back().second);
+			join_tree = &children.front().second;
+		}
+		if (join_exprs.size() < 2) {
+			return false;
+		}
+
+		boost::property_tree::ptree children;
+		children.push_back(std::make_pair("", *join_tree));
+		boost::property_tree::ptree star_joins;
+		for (std::size_t i = join_exprs.size(); i-- > 0;) {
+			children.push_back(std::make_pair("", *dimensions[i]));
+			boost::property_tree::ptree join_expr_tree;
+			join_expr_tree.put("", join_exprs[i]);
+			star_joins.push_back(std::make_pair("", join_expr_tree));
+		}
+		p_tree.put("expr", LOGICAL_STAR_JOIN_TEXT + "(dimensions=[" + std::to_string(join_exprs.size()) + "])");
+		p_tree.put_child("children", children);
+		p_tree.put_child("star_joins", star_joins);
+		return true;
+	}
+
+	// a sort with a limit of at most TOP_K_MAX_ROWS rows is a TopKKernel, instead of sorting and partitioning all of its rows
+	bool can_top_k(const std::string & expr) {
+		if (is_window_function(expr)) {
+			return false;
+		}
+		int64_t top_k_max_rows = 10000;
+		std::map<std::string, std::string> config_options = this->context->getConfigOptions();
+		auto it = config_options.find("TOP_K_MAX_ROWS");
+		if (it != config_options.end()){
+			top_k_max_rows = std::stoll(it->second);
+		}
+		int64_t limit_rows = ral::operators::get_limit_rows_when_relational_alg_is_simple(expr);
+		return limit_rows > 0 && limit_rows <= top_k_max_rows;
+	}
+
+	// the children of a join are still the Calcite nodes when the join is transformed
+	bool can_sort_merge_join(const boost::property_tree::ptree & p_tree) {
+		auto & children = p_tree.get_child("children");
+		if (children.size() != 2) {
+			return false;
+		}
+		std::string left_expr = children.front().second.get<std::string>("expr", "");
+		std::string right_expr = children.back().second.get<std::string>("expr", "");
+		return SortMergeJoinKernel::can_join(p_tree.get<std::string>("expr", ""), left_expr, right_expr);
+	}
+
+	// where the bucket column of a bucketed table is in the output of a subplan
+	struct bucketing_info {
+		size_t column_index;
+		size_t num_columns;
+		size_t num_buckets;
+		std::string bucket_hash;
+		cudf::type_id type;
+	};
+
+	/**
+	* Follows the bucket column of a bucketed table through the scans, filters and projections of a subplan that is
+	* still made of Calcite nodes, as the children of a join or an aggregation when they are transformed.
+	* @return whether the output of the subplan still has the bucket column, so that its rows are split between the
+	* nodes by their bucket.
+	*/
+	bool get_bucketing(const boost::property_tree::ptree & p_tree, bucketing_info & bucketing) {
+		std::string expr = p_tree.get<std::string>("expr", "");
+		auto & children = p_tree.get_child("children");
+		if (is_scan(expr)) {
+			const ral::io::Schema & schema = this->schemas[get_table_index(table_scans, expr)];
+			if (!schema.is_bucketed()) {
+				return false;
+			}
+			bucketing.num_buckets = schema.get_num_buckets();
+			bucketing.bucket_hash = schema.get_bucket_hash();
+			bucketing.type = schema.get_dtype(schema.get_bucket_column_index());
+			if (expr.find("projects=[") == std::string::npos) {
+				bucketing.column_index = schema.get_bucket_column_index();
+				bucketing.num_columns = schema.get_num_columns();
+				return true;
+			}
+			std::vector<int> projections = get_projections(expr);
+			auto it = std::find(projections.begin(), projections.end(), static_cast<int>(schema.get_bucket_column_index()));
+			if (it == projections.end()) {
+				return false;
+			}
+			bucketing.column_index = std::distance(projections.begin(), it);
+			bucketing.num_columns = projections.size();
+			return true;
+		} else if (is_filter(expr) && children.size() == 1) {
+			return get_bucketing(children.front().second, bucketing);
+		} else if (is_project(expr) && !is_window_function(expr) && children.size() == 1) {
+			if (!get_bucketing(children.front().second, bucketing)) {
+				return false;
+			}
+			std::string combined_expression = get_query_part(expr);
+			std::vector<std::string> named_expressions = get_expressions_from_expression_list(combined_expression);
+			std::string bucket_expression = "$" + std::to_string(bucketing.column_index);
+			for (size_t i = 0; i < named_expressions.size(); i++) {
+				const std::string & named_expr = named_expressions[i];
+				std::string expression = named_expr.substr(named_expr.find("=[") + 2 , (named_expr.size() - named_expr.find("=[")) - 3);
+				if (expression == bucket_expression) {
+					bucketing.column_index = i;
+					bucketing.num_columns = named_expressions.size();
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	// both inputs of the join are bucketed the same way and one of the equalities of the join is on their bucket columns
+	bool is_co_bucketed_join(const boost::property_tree::ptree & p_tree) {
+		auto & children = p_tree.get_child("children");
+		bucketing_info left, right;
+		if (children.size() != 2 || !get_bucketing(children.front().second, left) || !get_bucketing(children.back().second, right)) {
+			return false;
+		}
+		if (left.num_buckets != right.num_buckets || left.bucket_hash != right.bucket_hash || left.type != right.type) {
+			return false;
+		}
+
+		std::string condition;
+		std::tie(std::ignore, condition, std::ignore, std::ignore) = parseExpressionToGetTypeAndCondition(p_tree.get<std::string>("expr", ""));
+		std::vector<int> column_indices;
+		try {
+			parseJoinConditionToColumnIndices(condition, column_indices);
+		} catch (const std::exception & e) {
+			// it is not an equijoin
+			return false;
+		}
+		for (size_t i = 0; i + 1 < column_indices.size(); i += 2) {
+			if (column_indices[i] == static_cast<int>(left.column_index) &&
+				column_indices[i + 1] == static_cast<int>(left.num_columns + right.column_index)) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool partitioning_reuse_enabled() {
+		std::map<std::string, std::string> config_options = this->context->getConfigOptions();
+		auto it = config_options.find("ENABLE_PARTITIONING_REUSE");
+		if (it != config_options.end()){
+			return it->second != "False" && it->second != "false";
+		}
+		return true;
+	}
+
+	// how the rows of the output of a subplan are split between the nodes
+	struct partitioning_info {
+		// the key columns the rows were hashed by, in the order they were hashed. Both columns of an equality of an inner
+		// join have the same values, so a key can be in several columns
+		std::vector<std::vector<int>> key_columns;
+		// by the buckets of a bucketed table, otherwise by the hash_partition of a DistributeAggregate or a JoinPartition
+		bool bucketed = false;
+		// the joins that have to hash both of their inputs, instead of scattering a small one, for the rows to be split
+		// this way, see force_hash_partitioning
+		std::vector<boost::property_tree::ptree *> joins;
+	};
+
+	/**
+	* Follows the keys that the rows of a subplan that is still made of Calcite nodes were split between the nodes by,
+	* through its filters, projections, joins and aggregations, like get_bucketing. A join that hashes its inputs splits
+	* its output by its keys, and a distributed aggregation by its group columns. Only the bucketed tables count when
+	* ENABLE_PARTITIONING_REUSE is false.
+	* @return whether the output of the subplan is split between the nodes by the hash of some of its columns.
+	*/
+	bool get_partitioning(boost::property_tree::ptree & p_tree, partitioning_info & partitioning) {
+		std::string expr = p_tree.get<std::string>("expr", "");
+		auto & children = p_tree.get_child("children");
+		if (is_scan(expr)) {
+			bucketing_info bucketing;
+			if (!get_bucketing(p_tree, bucketing)) {
+				return false;
+			}
+			partitioning.key_columns = {{static_cast<int>(bucketing.column_index)}};
+			partitioning.bucketed = true;
+			return true;
+		} else if (is_filter(expr) && children.size() == 1) {
+			return get_partitioning(children.front().second, partitioning);
+		} else if (is_project(expr) && !is_window_function(expr) && children.size() == 1) {
+			if (!get_partitioning(children.front().second, partitioning)) {
+				return false;
+			}
+			std::string combined_expression = get_query_part(expr);
+			std::vector<std::string> named_expressions = get_expressions_from_expression_list(combined_expression);
+			for (auto & key : partitioning.key_columns) {
+				std::vector<int> projected_key;
+				for (size_t i = 0; i < named_expressions.size(); i++) {
+					const std::string & named_expr = named_expressions[i];
+					std::string expression = named_expr.substr(named_expr.find("=[") + 2 , (named_expr.size() - named_expr.find("=[")) - 3);
+					for (int column_index : key) {
+						if (expression == "$" + std::to_string(column_index)) {
+							projected_key.push_back(i);
+						}
+					}
+				}
+				if (projected_key.empty()) {
+					return false;
+				}
+				key = projected_key;
+			}
+			return true;
+		} else if (is_join(expr) && children.size() == 2) {
+			return get_join_partitioning(p_tree, partitioning);
+		} else if (is_aggregate(expr) && ral::operators::get_grouping_sets(expr).empty() && children.size() == 1) {
+			std::vector<int> group_column_indices = ral::operators::get_group_columns(expr);
+			if (group_column_indices.empty()) {
+				return false;
+			}
+			partitioning_info input;
+			if (is_co_located_aggregate(p_tree, input)) {
+				// the group columns are the first ones of the output
+				partitioning = input;
+				for (auto & key : partitioning.key_columns) {
+					std::vector<int> grouped_key;
+					for (size_t i = 0; i < group_column_indices.size(); i++) {
+						if (std::find(key.begin(), key.end(), group_column_indices[i]) != key.end()) {
+							grouped_key.push_back(i);
+						}
+					}
+					key = grouped_key;
+				}
+				return true;
+			}
+			if (!partitioning_reuse_enabled()) {
+				return false;
+			}
+			// DistributeAggregate hashes the group columns
+			partitioning.key_columns.clear();
+			for (size_t i = 0; i < group_column_indices.size(); i++) {
+				partitioning.key_columns.push_back({static_cast<int>(i)});
+			}
+			partitioning.bucketed = false;
+			partitioning.joins.clear();
+			return true;
+		}
+		return false;
+	}
+
+	// the equalities of an equijoin, as the pairs of columns of the left and of the right input in its output
+	bool get_join_keys(const std::string & expr, std::vector<std::pair<int, int>> & keys) {
+		std::string condition;
+		std::tie(std::ignore, condition, std::ignore, std::ignore) = parseExpressionToGetTypeAndCondition(expr);
+		std::vector<int> column_indices;
+		try {
+			parseJoinConditionToColumnIndices(condition, column_indices);
+		} catch (const std::exception & e) {
+			// it is not an equijoin
+			return false;
+		}
+		keys.clear();
+		for (size_t i = 0; i + 1 < column_indices.size(); i += 2) {
+			// the columns of the right input come after all the columns of the left one
+			keys.emplace_back(std::min(column_indices[i], column_indices[i + 1]), std::max(column_indices[i], column_indices[i + 1]));
+		}
+		return !keys.empty();
+	}
+
+	// the columns of the output of a subplan of Calcite nodes, or -1 when they can't be told from its expressions
+	int get_num_columns(const boost::property_tree::ptree & p_tree) {
+		std::string expr = p_tree.get<std::string>("expr", "");
+		auto & children = p_tree.get_child("children");
+		if (is_scan(expr)) {
+			return get_scan_projections(expr, get_table_index(table_scans, expr)).size();
+		} else if (is_filter(expr) && children.size() == 1) {
+			return get_num_columns(children.front().second);
+		} else if (is_project(expr)) {
+			return get_expressions_from_expression_list(get_query_part(expr)).size();
+		} else if (is_join(expr) && children.size() == 2) {
+			std::string join_type;
+			std::tie(std::ignore, std::ignore, std::ignore, join_type) = parseExpressionToGetTypeAndCondition(expr);
+			int left_columns = get_num_columns(children.front().second);
+			if (join_type == SEMI_JOIN || join_type == ANTI_JOIN) {
+				return left_columns;
+			}
+			int right_columns = get_num_columns(children.back().second);
+			return left_columns < 0 || right_columns < 0 ? -1 : left_columns + right_columns;
+		} else if (is_aggregate(expr) && ral::operators::get_grouping_sets(expr).empty()) {
+			std::vector<int> group_column_indices;
+			std::vector<AggregateKind> aggregation_types;
+			std::tie(group_column_indices, std::ignore, aggregation_types, std::ignore) = ral::operators::parseGroupByExpression(expr, 0);
+			return group_column_indices.size() + aggregation_types.size();
+		}
+		return -1;
+	}
+
+	/**
+	* The output of a join in several nodes is split by its keys, since the rows that match are in the same node. It is
+	* split by the bucket columns of a co-bucketed join, and by all its equalities when its JoinPartition hashes them.
+	* The rows of the left or right input that have no match keep their key on their own side only, and the full outer
+	* joins mix both.
+	*/
+	bool get_join_partitioning(boost::property_tree::ptree & p_tree, partitioning_info & partitioning) {
+		std::string expr = p_tree.get<std::string>("expr", "");
+		std::string join_type;
+		std::tie(std::ignore, std::ignore, std::ignore, join_type) = parseExpressionToGetTypeAndCondition(expr);
+		if (join_type != INNER_JOIN && join_type != LEFT_JOIN && join_type != RIGHT_JOIN && join_type != SEMI_JOIN && join_type != ANTI_JOIN) {
+			return false;
+		}
+		std::vector<std::pair<int, int>> keys;
+		if (!get_join_keys(expr, keys)) {
+			return false;
+		}
+
+		if (is_co_bucketed_join(p_tree)) {
+			auto & children = p_tree.get_child("children");
+			bucketing_info left, right;
+			get_bucketing(children.front().second, left);
+			get_bucketing(children.back().second, right);
+			keys = {{static_cast<int>(left.column_index), static_cast<int>(left.num_columns + right.column_index)}};
+			partitioning.bucketed = true;
+			partitioning.joins.clear();
+		} else if (partitioning_reuse_enabled()) {
+			partitioning.bucketed = false;
+			partitioning.joins = {&p_tree};
+		} else {
+			return false;
+		}
+
+		partitioning.key_columns.clear();
+		for (auto & key : keys) {
+			if (join_type == INNER_JOIN) {
+				partitioning.key_columns.push_back({key.first, key.second});
+			} else if (join_type == RIGHT_JOIN) {
+				partitioning.key_columns.push_back({key.second});
+			} else {
+				partitioning.key_columns.push_back({key.first});
+			}
+		}
+		return true;
+	}
+
+	/**
+	* Makes the joins that a split of the rows relies on hash partition their inputs, skipping the scatter of a small
+	* table and the heavy hitters, which would leave the rows of a key in several nodes. It has to be called before the
+	* tree of the consumer is rearranged, since the joins are still the Calcite nodes under it.
+	*/
+	void force_hash_partitioning(const partitioning_info & partitioning) {
+		for (boost::property_tree::ptree * join : partitioning.joins) {
+			join->put("hash_partitioned", "true");
+		}
+	}
+
+	// the input of the aggregation is split between the nodes by keys that are all among its group columns
+	bool is_co_located_aggregate(boost::property_tree::ptree & p_tree, partitioning_info & partitioning) {
+		auto & children = p_tree.get_child("children");
+		if (children.size() != 1 || !get_partitioning(children.front().second, partitioning)) {
+			return false;
+		}
+		std::vector<int> group_column_indices = ral::operators::get_group_columns(p_tree.get<std::string>("expr", ""));
+		for (auto & key : partitioning.key_columns) {
+			if (std::none_of(key.begin(), key.end(), [&group_column_indices](int column_index) {
+					return std::find(group_column_indices.begin(), group_column_indices.end(), column_index) != group_column_indices.end(); })) {
+				return false;
+			}
+		}
+		return !group_column_indices.empty();
+	}
+
+	/**
+	* The inputs of a join that are already hashed by its keys, in the same order, by the JoinPartition or the
+	* DistributeAggregate that made them, so that the JoinPartition of the join only has to hash the other input the same
+	* way. The JoinPartitionKernel keeps them in their node, unless their keys have to be cast to be compared with the keys
+	* of the other input, which changes their hash.
+	* @return "left", "right", "both" or an empty string.
+	*/
+	std::string get_partitioned_join_inputs(boost::property_tree::ptree & p_tree) {
+		auto & children = p_tree.get_child("children");
+		std::vector<std::pair<int, int>> keys;
+		if (!partitioning_reuse_enabled() || children.size() != 2 || !get_join_keys(p_tree.get<std::string>("expr", ""), keys)) {
+			return "";
+		}
+
+		auto is_hashed_by = [&keys](const partitioning_info & partitioning, bool left_side, int left_columns) {
+			if (partitioning.bucketed || partitioning.key_columns.size() != keys.size()) {
+				return false;
+			}
+			for (size_t i = 0; i < keys.size(); i++) {
+				int column_index = left_side ? keys[i].first : keys[i].second - left_columns;
+				const std::vector<int> & key = partitioning.key_columns[i];
+				if (std::find(key.begin(), key.end(), column_index) == key.end()) {
+					return false;
+				}
+			}
+			return true;
+		};
+
+		partitioning_info left, right;
+		bool left_partitioned = get_partitioning(children.front().second, left) && is_hashed_by(left, true, 0);
+		int left_columns = get_num_columns(children.front().second);
+		bool right_partitioned = left_columns >= 0 && get_partitioning(children.back().second, right) &&
+			is_hashed_by(right, false, left_columns);
+		if (left_partitioned) {
+			force_hash_partitioning(left);
+		}
+		if (right_partitioned) {
+			force_hash_partitioning(right);
+		}
+		if (left_partitioned && right_partitioned) {
+			return "both";
+		}
+		return left_partitioned ? "left" : (right_partitioned ? "right" : "");
+	}
+
+	bool kernel_fusion_enabled() {
+		std::map<std::string, std::string> config_options = this->context->getConfigOptions();
+		auto it = config_options.find("ENABLE_KERNEL_FUSION");
+		if (it != config_options.end()){
+			return it->second != "False" && it->second != "false";
+		}
+		return true;
+	}
+
 	std::string to_string() {
 		return to_string(&this->root, 0);
 	}
@@ -446,6 +1434,12 @@ struct tree_processor {
 			boost::property_tree::ptree p_tree;
 			boost::property_tree::read_json(input, p_tree);
 			transform_json_tree(p_tree);
+			if (materialization_cache_enabled()) {
+				apply_materialization_cache(p_tree);
+			}
+			if (common_subplan_reuse_enabled()) {
+				apply_common_subplan_reuse(p_tree);
+			}
 			max_kernel_id = expr_tree_from_json(0, p_tree, &this->root, 0, query_graph);
 		} catch (std::exception & e) {
 			std::shared_ptr<spdlog::logger> logger = spdlog::get("batch_logger");
@@ -483,6 +1477,11 @@ struct tree_processor {
 			
 			auto child_kernel_type = child->kernel_unit->get_type_id();
 			auto parent_kernel_type = parent->kernel_unit->get_type_id();
+			// every consumer of a spool reads its own output port of it
+			std::string source_port = std::to_string(child->kernel_unit->get_id());
+			if (child_kernel_type == kernel_type::SpoolKernel) {
+				source_port = static_cast<SpoolKernel*>(child->kernel_unit.get())->add_consumer_port();
+			}
 			if (children.size() > 1) {
 				char index_char = 'a' + index;
 				port_name = std::string("input_");
@@ -492,17 +1491,18 @@ struct tree_processor {
 
 					auto join_type = static_cast<PartwiseJoin*>(parent->kernel_unit.get())->get_join_type();
 					bool left_concat_all = join_type == ral::batch::RIGHT_JOIN || join_type == ral::batch::OUTER_JOIN || join_type == ral::batch::CROSS_JOIN;
-					bool right_concat_all = join_type == ral::batch::LEFT_JOIN || join_type == ral::batch::OUTER_JOIN || join_type == ral::batch::CROSS_JOIN;
+					bool right_concat_all = join_type == ral::batch::LEFT_JOIN || join_type == ral::batch::OUTER_JOIN || join_type == ral::batch::CROSS_JOIN ||
+						join_type == ral::batch::SEMI_JOIN || join_type == ral::batch::ANTI_JOIN;
 					bool concat_all = index == 0 ? left_concat_all : right_concat_all;
 					cache_settings join_cache_machine_config = cache_settings{.type = CacheType::CONCATENATING, .num_partitions = 1, .context = context->clone(),
 						.concat_cache_num_bytes = join_partition_size_thresh, .num_bytes_timeout = concatenating_cache_num_bytes_timeout, .concat_all = concat_all};
-					query_graph.addPair(ral::cache::kpair(child->kernel_unit, parent->kernel_unit, port_name, join_cache_machine_config));					
+					query_graph.addPair(ral::cache::kpair(child->kernel_unit, source_port, parent->kernel_unit, port_name, join_cache_machine_config));					
 
 				} else {
 					cache_settings cache_machine_config;
 					cache_machine_config.context = context->clone();
 
-					query_graph.addPair(ral::cache::kpair(child->kernel_unit, parent->kernel_unit, port_name, cache_machine_config));
+					query_graph.addPair(ral::cache::kpair(child->kernel_unit, source_port, parent->kernel_unit, port_name, cache_machine_config));
 				}
 			} else {
 				
@@ -510,7 +1510,8 @@ struct tree_processor {
 
 					auto join_type = static_cast<PartwiseJoin*>(parent->kernel_unit.get())->get_join_type();
 					bool left_concat_all = join_type == ral::batch::RIGHT_JOIN || join_type == ral::batch::OUTER_JOIN || join_type == ral::batch::CROSS_JOIN;
-					bool right_concat_all = join_type == ral::batch::LEFT_JOIN || join_type == ral::batch::OUTER_JOIN || join_type == ral::batch::CROSS_JOIN;
+					bool right_concat_all = join_type == ral::batch::LEFT_JOIN || join_type == ral::batch::OUTER_JOIN || join_type == ral::batch::CROSS_JOIN ||
+						join_type == ral::batch::SEMI_JOIN || join_type == ral::batch::ANTI_JOIN;
 					cache_settings left_cache_machine_config = cache_settings{.type = CacheType::CONCATENATING, .num_partitions = 1, .context = context->clone(),
 						.concat_cache_num_bytes = join_partition_size_thresh, .num_bytes_timeout = concatenating_cache_num_bytes_timeout, .concat_all = left_concat_all};
 					cache_settings right_cache_machine_config = cache_settings{.type = CacheType::CONCATENATING, .num_partitions = 1, .context = context->clone(),
@@ -558,14 +1559,51 @@ struct tree_processor {
 					if (it != config_options.end()){
 						concat_cache_num_bytes = std::stoull(config_options["MAX_DATA_LOAD_CONCAT_CACHE_BYTE_SIZE"]);
 					}
+					std::shared_ptr<ral::cache::kernel_throughput> consumer_throughput = nullptr;
+					it = config_options.find("ENABLE_ADAPTIVE_BATCH_COALESCING");
+					if (it != config_options.end() && (it->second == "True" || it->second == "true")){
+						consumer_throughput = parent->kernel_unit->get_throughput();
+					}
 					
 					cache_settings cache_machine_config = cache_settings{.type = CacheType::CONCATENATING, .num_partitions = 1, .context = context->clone(),
-						.concat_cache_num_bytes = concat_cache_num_bytes, .num_bytes_timeout = concatenating_cache_num_bytes_timeout, .concat_all = false};
+						.concat_cache_num_bytes = concat_cache_num_bytes, .num_bytes_timeout = concatenating_cache_num_bytes_timeout, .concat_all = false,
+						.consumer_throughput = consumer_throughput};
 					query_graph.addPair(ral::cache::kpair(child->kernel_unit, parent->kernel_unit, cache_machine_config));
+
+					// the databases of the SQL tables compute the partial aggregations, and the first rows of the sorts
+					// with a limit, of the scans of their tables
+					bool aggregation_pushed_down = false;
+					if (sql_pushdown_enabled()) {
+						auto table_scan = std::dynamic_pointer_cast<TableScan>(child->kernel_unit);
+						auto bindable_table_scan = std::dynamic_pointer_cast<BindableTableScan>(child->kernel_unit);
+						if (parent_kernel_type == kernel_type::ComputeAggregateKernel && bindable_table_scan != nullptr &&
+								bindable_table_scan->set_aggregation_pushdown(parent->expr)) {
+							std::dynamic_pointer_cast<ComputeAggregateKernel>(parent->kernel_unit)->set_aggregation_pushed_down();
+							aggregation_pushed_down = true;
+						} else if (parent_kernel_type == kernel_type::LimitKernel || parent_kernel_type == kernel_type::TopKKernel ||
+								parent_kernel_type == kernel_type::SortAndSampleKernel) {
+							if (table_scan != nullptr) {
+								table_scan->set_limit_pushdown(parent->expr);
+							} else if (bindable_table_scan != nullptr) {
+								bindable_table_scan->set_limit_pushdown(parent->expr);
+							}
+						}
+					}
+
+					// the aggregations without groups answer what they can of the scan from the statistics of its files
+					if (parent_kernel_type == kernel_type::ComputeAggregateKernel && metadata_aggregation_enabled() && !aggregation_pushed_down) {
+						auto aggregation = std::make_shared<ral::operators::metadata_aggregation>(parent->expr);
+						if (child_kernel_type == kernel_type::TableScanKernel) {
+							std::dynamic_pointer_cast<TableScan>(child->kernel_unit)->set_metadata_aggregation(aggregation);
+						} else {
+							std::dynamic_pointer_cast<BindableTableScan>(child->kernel_unit)->set_metadata_aggregation(aggregation);
+						}
+						std::dynamic_pointer_cast<ComputeAggregateKernel>(parent->kernel_unit)->set_metadata_aggregation(aggregation);
+					}
 				} else {
 					cache_settings cache_machine_config;
 					cache_machine_config.context = context->clone();
-					query_graph.addPair(ral::cache::kpair(child->kernel_unit, parent->kernel_unit, cache_machine_config));
+					query_graph.addPair(ral::cache::kpair(child->kernel_unit, source_port, parent->kernel_unit, std::to_string(parent->kernel_unit->get_id()), cache_machine_config));
 				}
 			}
 		}
@@ -0,0 +1,162 @@
+#include "QueryConfig.h"
+
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <stdexcept>
+
+namespace blazingdb {
+namespace manager {
+
+namespace {
+
+[[noreturn]] void throw_invalid_option(const std::string & name, const std::string & value, const std::string & type) {
+	throw std::runtime_error("ERROR: the config option " + name + " has to be " + type + ", it was '" + value + "'");
+}
+
+// python writes the floats that have integer values, like 5e8, as 500000000.0
+bool parse_integral_double(const std::string & value, double & result) {
+	char * end = nullptr;
+	errno = 0;
+	result = value.empty() ? 0 : std::strtod(value.c_str(), &end);
+	return end != nullptr && *end == '\0' && errno != ERANGE && std::fabs(result) < 9e18 &&
+		result == static_cast<double>(static_cast<int64_t>(result));
+}
+
+// the whole value has to be the number, unlike std::stoull that stops at the first character that is not a digit
+void parse_value(const std::string & name, const std::string & value, uint64_t & result) {
+	char * end = nullptr;
+	errno = 0;
+	unsigned long long parsed = value.empty() || value[0] == '-' ? 0 : std::strtoull(value.c_str(), &end, 10);
+	if (end == nullptr || *end != '\0' || errno == ERANGE) {
+		double integral;
+		if (!parse_integral_double(value, integral) || integral < 0) {
+			throw_invalid_option(name, value, "a non negative integer");
+		}
+		parsed = static_cast<unsigned long long>(integral);
+	}
+	result = parsed;
+}
+
+void parse_value(const std::string & name, const std::string & value, int64_t & result) {
+	char * end = nullptr;
+	errno = 0;
+	long long parsed = value.empty() ? 0 : std::strtoll(value.c_str(), &end, 10);
+	if (end == nullptr || *end != '\0' || errno == ERANGE) {
+		double integral;
+		if (!parse_integral_double(value, integral)) {
+			throw_invalid_option(name, value, "an integer");
+		}
+		parsed = static_cast<long long>(integral);
+	}
+	result = parsed;
+}
+
+void parse_value(const std::string & name, const std::string & value, int & result) {
+	int64_t parsed;
+	parse_value(name, value, parsed);
+	if (parsed < std::numeric_limits<int>::min() || parsed > std::numeric_limits<int>::max()) {
+		throw_invalid_option(name, value, "a 32 bit integer");
+	}
+	result = static_cast<int>(parsed);
+}
+
+void parse_value(const std::string & name, const std::string & value, double & result) {
+	char * end = nullptr;
+	errno = 0;
+	double parsed = value.empty() ? 0 : std::strtod(value.c_str(), &end);
+	if (end == nullptr || *end != '\0' || errno == ERANGE) {
+		throw_invalid_option(name, value, "a number");
+	}
+	result = parsed;
+}
+
+void parse_value(const std::string & name, const std::string & value, bool & result) {
+	if (value == "True" || value == "true" || value == "1") {
+		result = true;
+	} else if (value == "False" || value == "false" || value == "0") {
+		result = false;
+	} else {
+		throw_invalid_option(name, value, "True or False");
+	}
+}
+
+void parse_value(const std::string & /*name*/, const std::string & value, std::string & result) {
+	result = value;
+}
+
+template <typename T>
+void parse_option(const std::map<std::string, std::string> & config_options, const std::string & name, std::optional<T> & option) {
+	auto it = config_options.find(name);
+	if (it != config_options.end()) {
+		T value;
+		parse_value(name, it->second, value);
+		option = value;
+	}
+}
+
+}  // namespace
+
+QueryConfig::QueryConfig(const std::map<std::string, std::string> & config_options) : options{config_options} {
+	parse_option(options, "QUERY_PRIORITY", query_priority);
+	parse_option(options, "RESOURCE_GROUP", resource_group);
+	parse_option(options, "RESOURCE_GROUP_MEMORY_FRACTION", resource_group_memory_fraction);
+	parse_option(options, "RESOURCE_GROUP_EXECUTOR_THREADS", resource_group_executor_threads);
+	parse_option(options, "FLOW_CONTROL_BYTES_THRESHOLD", flow_control_bytes_threshold);
+	parse_option(options, "FLOW_CONTROL_MAX_WAIT_MS", flow_control_max_wait_ms);
+	parse_option(options, "MAX_KERNEL_RUN_THREADS", max_kernel_run_threads);
+	parse_option(options, "QUERY_TIMEOUT_MS", query_timeout_ms);
+	parse_option(options, "PROJECT_FORK_JOIN_MAX_ROWS", project_fork_join_max_rows);
+
+	parse_option(options, "COALESCE_MESSAGES_BYTES_THRESHOLD", coalesce_messages_bytes_threshold);
+	parse_option(options, "COALESCE_MESSAGES_TIMEOUT_MS", coalesce_messages_timeout_ms);
+	parse_option(options, "ENABLE_TREE_BROADCAST", enable_tree_broadcast);
+	parse_option(options, "HASH_PARTITIONS_PER_NODE", hash_partitions_per_node);
+	parse_option(options, "SHUFFLE_CHECKPOINT_PATH", shuffle_checkpoint_path);
+
+	parse_option(options, "SCAN_TASK_TARGET_BYTES", scan_task_target_bytes);
+	parse_option(options, "ENABLE_SCAN_WORK_STEALING", enable_scan_work_stealing);
+	parse_option(options, "ENABLE_LATE_MATERIALIZATION", enable_late_materialization);
+	parse_option(options, "MATERIALIZATION_CACHE_MAX_BYTES", materialization_cache_max_bytes);
+	parse_option(options, "OUTPUT_PATH", output_path);
+	parse_option(options, "OUTPUT_FORMAT", output_format);
+	parse_option(options, "OUTPUT_FILE_MAX_BYTES", output_file_max_bytes);
+	parse_option(options, "RETURN_ITERATOR", return_iterator);
+	parse_option(options, "RESULT_ITERATOR_MAX_BATCHES", result_iterator_max_batches);
+
+	parse_option(options, "AGGREGATION_BYPASS_RATIO", aggregation_bypass_ratio);
+	parse_option(options, "AGGREGATION_ACCUMULATE_BYTES", aggregation_accumulate_bytes);
+	parse_option(options, "AGGREGATION_MERGE_BYTES", aggregation_merge_bytes);
+	parse_option(options, "INCREMENTAL_AGGREGATION_STATE_INPUT", incremental_aggregation_state_input);
+	parse_option(options, "INCREMENTAL_AGGREGATION_STATE_OUTPUT", incremental_aggregation_state_output);
+
+	parse_option(options, "JOIN_HASH_TABLE_CACHE_BYTES", join_hash_table_cache_bytes);
+	parse_option(options, "JOIN_HYBRID_HASH_PARTITION_BYTES", join_hybrid_hash_partition_bytes);
+	parse_option(options, "JOIN_OUTPUT_CHUNK_BYTES", join_output_chunk_bytes);
+	parse_option(options, "JOIN_SKEW_HEAVY_HITTER_THRESHOLD", join_skew_heavy_hitter_threshold);
+	parse_option(options, "ENABLE_JOIN_RUNTIME_FILTER", enable_join_runtime_filter);
+	parse_option(options, "ENABLE_JOIN_LATE_MATERIALIZATION", enable_join_late_materialization);
+	parse_option(options, "JOIN_ADAPTIVE_WAIT_MS", join_adaptive_wait_ms);
+	parse_option(options, "MAX_JOIN_SCATTER_MEM_OVERHEAD", max_join_scatter_mem_overhead);
+
+	parse_option(options, "MAX_ORDER_BY_SAMPLES_PER_NODE", max_order_by_samples_per_node);
+	parse_option(options, "MAX_NUM_ORDER_BY_PARTITIONS_PER_NODE", max_num_order_by_partitions_per_node);
+	parse_option(options, "NUM_BYTES_PER_ORDER_BY_PARTITION", num_bytes_per_order_by_partition);
+	parse_option(options, "ORDER_BY_MERGE_WINDOW_BYTES", order_by_merge_window_bytes);
+
+	std::optional<std::string> cache_spill_format;
+	parse_option(options, "CACHE_SPILL_FORMAT", cache_spill_format);
+	if (cache_spill_format) {
+		if (*cache_spill_format == "RAW" || *cache_spill_format == "raw") {
+			cache_spill_raw = true;
+		} else if (*cache_spill_format != "ORC" && *cache_spill_format != "orc" && !cache_spill_format->empty()) {
+			throw_invalid_option("CACHE_SPILL_FORMAT", *cache_spill_format, "ORC or RAW");
+		}
+	}
+	parse_option(options, "ASYNC_CACHE_DOWNGRADE", async_cache_downgrade);
+	parse_option(options, "ENABLE_HOST_CACHE_COMPRESSION", enable_host_cache_compression);
+}
+
+}  // namespace manager
+}  // namespace blazingdb
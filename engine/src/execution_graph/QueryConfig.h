@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+
+namespace blazingdb {
+namespace manager {
+
+/**
+* The config options of a query that the kernels, caches and comms read while the query runs, parsed and validated
+* once when its Context is created, so that they don't look up and parse strings of the options map on every batch.
+* An option that is not set is left empty, since some defaults depend on the memory of the node and are only known
+* by whoever reads the option (value_or). The options that are only read when the query is planned are still read
+* from the options map.
+*/
+struct QueryConfig {
+	/**
+	* Parses the options of a query.
+	* @throws std::runtime_error if an option does not have a value of its type.
+	*/
+	explicit QueryConfig(const std::map<std::string, std::string> & config_options);
+
+	std::map<std::string, std::string> options; /**< All the options, as they were given. */
+
+	// kernels
+	std::optional<uint64_t> query_priority;                   /**< QUERY_PRIORITY */
+	std::optional<std::string> resource_group;                /**< RESOURCE_GROUP */
+	std::optional<double> resource_group_memory_fraction;     /**< RESOURCE_GROUP_MEMORY_FRACTION */
+	std::optional<int> resource_group_executor_threads;       /**< RESOURCE_GROUP_EXECUTOR_THREADS */
+	std::optional<uint64_t> flow_control_bytes_threshold;     /**< FLOW_CONTROL_BYTES_THRESHOLD */
+	std::optional<int> flow_control_max_wait_ms;              /**< FLOW_CONTROL_MAX_WAIT_MS */
+	std::optional<int> max_kernel_run_threads;                /**< MAX_KERNEL_RUN_THREADS */
+	std::optional<int64_t> query_timeout_ms;                  /**< QUERY_TIMEOUT_MS */
+	std::optional<uint64_t> project_fork_join_max_rows;       /**< PROJECT_FORK_JOIN_MAX_ROWS */
+
+	// distribution
+	std::optional<uint64_t> coalesce_messages_bytes_threshold; /**< COALESCE_MESSAGES_BYTES_THRESHOLD */
+	std::optional<int> coalesce_messages_timeout_ms;           /**< COALESCE_MESSAGES_TIMEOUT_MS */
+	std::optional<bool> enable_tree_broadcast;                 /**< ENABLE_TREE_BROADCAST */
+	std::optional<uint64_t> hash_partitions_per_node;          /**< HASH_PARTITIONS_PER_NODE */
+	std::optional<std::string> shuffle_checkpoint_path;        /**< SHUFFLE_CHECKPOINT_PATH */
+
+	// scans and output
+	std::optional<uint64_t> scan_task_target_bytes;           /**< SCAN_TASK_TARGET_BYTES */
+	std::optional<bool> enable_scan_work_stealing;            /**< ENABLE_SCAN_WORK_STEALING */
+	std::optional<bool> enable_late_materialization;          /**< ENABLE_LATE_MATERIALIZATION */
+	std::optional<uint64_t> materialization_cache_max_bytes;  /**< MATERIALIZATION_CACHE_MAX_BYTES */
+	std::optional<std::string> output_path;                   /**< OUTPUT_PATH */
+	std::optional<std::string> output_format;                 /**< OUTPUT_FORMAT */
+	std::optional<uint64_t> output_file_max_bytes;            /**< OUTPUT_FILE_MAX_BYTES */
+	std::optional<bool> return_iterator;                      /**< RETURN_ITERATOR */
+	std::optional<uint64_t> result_iterator_max_batches;      /**< RESULT_ITERATOR_MAX_BATCHES */
+
+	// aggregations
+	std::optional<double> aggregation_bypass_ratio;               /**< AGGREGATION_BYPASS_RATIO */
+	std::optional<uint64_t> aggregation_accumulate_bytes;         /**< AGGREGATION_ACCUMULATE_BYTES */
+	std::optional<uint64_t> aggregation_merge_bytes;              /**< AGGREGATION_MERGE_BYTES */
+	std::optional<std::string> incremental_aggregation_state_input;  /**< INCREMENTAL_AGGREGATION_STATE_INPUT */
+	std::optional<std::string> incremental_aggregation_state_output; /**< INCREMENTAL_AGGREGATION_STATE_OUTPUT */
+
+	// joins
+	std::optional<uint64_t> join_hash_table_cache_bytes;      /**< JOIN_HASH_TABLE_CACHE_BYTES */
+	std::optional<uint64_t> join_hybrid_hash_partition_bytes; /**< JOIN_HYBRID_HASH_PARTITION_BYTES */
+	std::optional<uint64_t> join_output_chunk_bytes;          /**< JOIN_OUTPUT_CHUNK_BYTES */
+	std::optional<double> join_skew_heavy_hitter_threshold;   /**< JOIN_SKEW_HEAVY_HITTER_THRESHOLD */
+	std::optional<bool> enable_join_runtime_filter;           /**< ENABLE_JOIN_RUNTIME_FILTER */
+	std::optional<bool> enable_join_late_materialization;     /**< ENABLE_JOIN_LATE_MATERIALIZATION */
+	std::optional<int> join_adaptive_wait_ms;                 /**< JOIN_ADAPTIVE_WAIT_MS */
+	std::optional<uint64_t> max_join_scatter_mem_overhead;    /**< MAX_JOIN_SCATTER_MEM_OVERHEAD */
+
+	// order by
+	std::optional<uint64_t> max_order_by_samples_per_node;        /**< MAX_ORDER_BY_SAMPLES_PER_NODE */
+	std::optional<int> max_num_order_by_partitions_per_node;      /**< MAX_NUM_ORDER_BY_PARTITIONS_PER_NODE */
+	std::optional<uint64_t> num_bytes_per_order_by_partition;     /**< NUM_BYTES_PER_ORDER_BY_PARTITION */
+	std::optional<uint64_t> order_by_merge_window_bytes;          /**< ORDER_BY_MERGE_WINDOW_BYTES */
+
+	// caches
+	bool cache_spill_raw = false;              /**< CACHE_SPILL_FORMAT is RAW instead of ORC */
+	std::optional<bool> async_cache_downgrade; /**< ASYNC_CACHE_DOWNGRADE */
+	std::optional<bool> enable_host_cache_compression; /**< ENABLE_HOST_CACHE_COMPRESSION */
+};
+
+}  // namespace manager
+}  // namespace blazingdb
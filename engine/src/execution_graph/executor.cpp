@@ -1,5 +1,12 @@
 #include "executor.h"
 #include "cache_machine/GPUCacheData.h"
+#include "cache_machine/ManagedMemoryHints.h"
+#include "utilities/Tracer.h"
+#include "utilities/nvtx.h"
+#include "utilities/RuntimeMetrics.h"
+#include "utilities/EventLog.h"
+#include "utilities/ThreadAffinity.h"
+#include "bmr/QueryMemoryTracker.h"
 
 using namespace fmt::literals;
 
@@ -17,8 +24,10 @@ size_t executor::add_task(std::vector<std::unique_ptr<ral::cache::CacheData > >
     auto task_added = std::make_unique<task>(
         std::move(inputs),output,task_id, kernel, attempts_limit, args
     );
+    task_added->set_resource_group(get_resource_group(kernel));
 
-    task_queue.put(std::move(task_added));
+    auto task_priority = task_added->get_priority();
+    task_queue.put(std::move(task_added), task_priority);
     return task_id;
 }
 
@@ -32,15 +41,74 @@ void executor::add_task(std::vector<std::unique_ptr<ral::cache::CacheData > > in
     auto task_added = std::make_unique<task>(
         std::move(inputs),output,task_id, kernel, attempts_limit, args, attempts
     );
-    task_queue.put(std::move(task_added));
+    task_added->set_resource_group(get_resource_group(kernel));
+    auto task_priority = task_added->get_priority();
+    task_queue.put(std::move(task_added), task_priority);
 }
 
 void executor::add_task(std::unique_ptr<task> task) {
-    task_queue.put(std::move(task));
+    auto task_priority = task->get_priority();
+    task_queue.put(std::move(task), task_priority);
 }
 
 std::unique_ptr<task> executor::remove_task_from_back(){
-    return std::move(task_queue.pop_back());
+    return task_queue.pop_back();
+}
+
+void executor::cancel_tasks(int32_t ctx_token){
+    std::vector<std::unique_ptr<task>> cancelled_tasks = task_queue.remove_if([ctx_token](const std::unique_ptr<task> & queued_task){
+        return queued_task->is_cancelled() && queued_task->get_context_token() == ctx_token;
+    });
+    {
+        std::lock_guard<std::mutex> lock(memory_safety_mutex);
+        for (auto parked = parked_tasks.begin(); parked != parked_tasks.end();){
+            auto & group_tasks = parked->second;
+            for (auto it = group_tasks.begin(); it != group_tasks.end();){
+                if ((*it)->is_cancelled() && (*it)->get_context_token() == ctx_token){
+                    cancelled_tasks.push_back(std::move(*it));
+                    it = group_tasks.erase(it);
+                    num_parked_tasks--;
+                } else {
+                    ++it;
+                }
+            }
+            parked = group_tasks.empty() ? parked_tasks.erase(parked) : std::next(parked);
+        }
+    }
+    for (auto & cancelled_task : cancelled_tasks){
+        cancelled_task->fail();
+    }
+    cancelled_tasks.clear();
+    memory_safety_cv.notify_all();
+}
+
+std::shared_ptr<resource_group> executor::get_resource_group(ral::cache::kernel * kernel){
+    if (kernel->get_resource_group_name().empty()){
+        return nullptr;
+    }
+    return get_resource_group(kernel->get_resource_group_name(), kernel->get_resource_group_memory_fraction(), kernel->get_resource_group_threads());
+}
+
+std::shared_ptr<resource_group> executor::get_resource_group(const std::string & name, double memory_fraction, int max_threads){
+    std::lock_guard<std::mutex> lock(resource_groups_mutex);
+    auto it = resource_groups.find(name);
+    if (it == resource_groups.end()){
+        int num_threads = pool.size();
+        std::size_t memory_limit = processing_memory_limit * std::min(std::max(memory_fraction, 0.0), 1.0);
+        auto group = std::make_shared<resource_group>(name, memory_limit, max_threads > 0 ? std::min(max_threads, num_threads) : num_threads);
+        it = resource_groups.emplace(name, group).first;
+    }
+    return it->second;
+}
+
+bool executor::has_resource_group_over_budget(){
+    std::lock_guard<std::mutex> lock(resource_groups_mutex);
+    for (auto & group : resource_groups){
+        if (group.second->is_over_budget()){
+            return true;
+        }
+    }
+    return false;
 }
 
 task::task(
@@ -53,34 +121,82 @@ task::task(
     inputs(std::move(inputs)),
     output(output), task_id(task_id),
     kernel(kernel),attempts(attempts),
-    attempts_limit(attempts_limit), args(args) {
+    attempts_limit(attempts_limit), args(args),
+    task_priority(kernel->get_query_priority(), kernel->get_priority_level()) {
     
     task_logger = spdlog::get("task_logger");
 }
 
-std::size_t task::task_memory_needed() {
-    std::size_t bytes_to_decache = 0; // space needed to deache inputs which are currently not in GPU
+std::size_t task::inputs_size_in_bytes() {
+    std::size_t input_bytes = 0;
+    for (auto & input : inputs) {
+        // the files that are not read yet are counted by what they will decode into, so that the memory model
+        // tells the scans of small and large files apart
+        input_bytes += input->sizeInBytes() + input->estimatedDecachedBytes();
+    }
+    return input_bytes;
+}
 
+std::size_t task::inputs_size_to_decache() {
+    std::size_t bytes_to_decache = 0;
     for (auto & input : inputs) {
         if (input->get_type() == ral::cache::CacheDataType::CPU || input->get_type() == ral::cache::CacheDataType::LOCAL_FILE){
             bytes_to_decache += input->sizeInBytes();
-        } else if (input->get_type() == ral::cache::CacheDataType::IO_FILE){
-            // TODO! Need to figure out what we want to do to try to estimate consumption for this
         }
     }
+    return bytes_to_decache;
+}
+
+void task::prefetch_inputs() {
+    for (auto & input : inputs) {
+        if (input->get_type() == ral::cache::CacheDataType::CPU || input->get_type() == ral::cache::CacheDataType::LOCAL_FILE){
+            try {
+                auto metadata = input->getMetadata();
+                std::size_t bytes = input->sizeInBytes();
+                input = std::make_unique<ral::cache::GPUCacheData>(input->decache(), metadata);
+                ral::utilities::runtime_metrics::get_instance().record_unspill(bytes);
+            } catch(const rmm::bad_alloc& e) {
+                // decaching a CPU or disk CacheData that fails does not lose its data, the task will try again when it runs
+                break;
+            }
+        }
+    }
+}
+
+std::size_t task::task_memory_needed(task_memory_model & memory_model) {
+    auto predicted = memory_model.predict(kernel->get_type_id(), inputs_size_in_bytes());
+    if (predicted.first) {
+        return predicted.second;
+    }
+
+    std::size_t bytes_to_decache = inputs_size_to_decache(); // space needed to deache inputs which are currently not in GPU
+    // and to decode the files of the IO_FILE inputs, from their metadata
+    for (auto & input : inputs) {
+        bytes_to_decache += input->estimatedDecachedBytes();
+    }
     return bytes_to_decache + kernel->estimate_output_bytes(inputs) + kernel->estimate_operating_bytes(inputs);
 }
 
 
 void task::run(cudaStream_t stream, executor * executor){
+    BLAZING_NVTX_RANGE(kernel->kernel_name() + " " + std::to_string(kernel->get_id()) + " task " + std::to_string(task_id), kernel);
     std::vector< std::unique_ptr<ral::frame::BlazingTable> > input_gpu;
     CodeTimer decachingEventTimer;
+    auto & tracer = ral::utilities::tracer::getInstance();
+    int32_t query_id = kernel->get_context()->getContextToken();
+    // the GPU memory allocated while running the task is accounted to its query and kernel
+    ral::memory::scoped_allocation_owner allocation_owner(query_id, kernel->get_id());
+    int64_t decaching_start = tracer.now();
 
     int last_input_decached = 0;
+    std::size_t input_bytes = inputs_size_in_bytes();
+    // the peak memory allocated by this thread while running the task is what the memory model learns from
+    blazing_device_memory_resource::reset_thread_max_memory_used();
     ///////////////////////////////
     // Decaching inputs
     ///////////////////////////////
     try{
+        BLAZING_NVTX_RANGE("decache", decache);
         for(auto & input : inputs){
                     //if its in gpu this wont fail
                     //if its cpu and it fails the buffers arent deleted
@@ -94,7 +210,12 @@ void task::run(cudaStream_t stream, executor * executor){
                     }
                     
                     last_input_decached++;
-                    auto decached_input = input->decache();
+                    bool unspilled = input->get_type() != ral::cache::CacheDataType::GPU;
+                    std::size_t unspilled_bytes = unspilled ? input->sizeInBytes() : 0;
+                    auto decached_input = kernel->decache_input(*input);
+                    if (unspilled) {
+                        ral::utilities::runtime_metrics::get_instance().record_unspill(unspilled_bytes);
+                    }
                     executor->accumulate_rows(decached_input->num_rows());
                     input_gpu.push_back(std::move(decached_input));
             }
@@ -108,6 +229,8 @@ void task::run(cudaStream_t stream, executor * executor){
             i++;
         }
 
+        executor->get_task_memory_model().record_failure(kernel->get_type_id(), input_bytes, blazing_device_memory_resource::get_thread_max_memory_used());
+
         std::shared_ptr<spdlog::logger> logger = spdlog::get("batch_logger");
         if (logger){
             logger->error("|||{info}|||||",
@@ -116,6 +239,8 @@ void task::run(cudaStream_t stream, executor * executor){
 
         this->attempts++;
         if(this->attempts < this->attempts_limit){
+            kernel->notify_retry();
+            ral::utilities::runtime_metrics::get_instance().record_oom_retry();
             executor->add_task(std::move(inputs), output, kernel, attempts, task_id, args);
             return;
         }else{
@@ -131,6 +256,7 @@ void task::run(cudaStream_t stream, executor * executor){
         throw;
     }
     auto decaching_elapsed = decachingEventTimer.elapsed_time();
+    tracer.record("TaskDecache", "task", query_id, kernel->get_id(), decaching_start, tracer.now() - decaching_start);
 
     std::size_t log_input_rows = 0;
     std::size_t log_input_bytes = 0;
@@ -138,25 +264,47 @@ void task::run(cudaStream_t stream, executor * executor){
         log_input_rows += input_gpu.at(i)->num_rows();
         log_input_bytes += input_gpu.at(i)->sizeInBytes();
     }
+
+    // with managed memory the inputs are moved to the GPU on the stream of the task before the kernel touches them,
+    // instead of page faulting them in
+    auto & managed_hints = ral::cache::managed_memory_hints::get_instance();
+    if (managed_hints.is_prefetch_enabled()) {
+        for (auto & table : input_gpu) {
+            managed_hints.prefetch_to_device(table->toBlazingTableView(), stream);
+        }
+    }
     
     CodeTimer executionEventTimer;
-    auto task_result = kernel->process(std::move(input_gpu), output, stream, args);
+    int64_t execution_start = tracer.now();
+    ral::execution::task_result task_result;
+    {
+        BLAZING_NVTX_RANGE(kernel->kernel_name() + " " + std::to_string(kernel->get_id()) + " compute", kernel);
+        task_result = kernel->process(std::move(input_gpu), output, stream, args);
+    }
+    auto execution_elapsed = executionEventTimer.elapsed_time<std::chrono::microseconds>();
+    tracer.record("KernelCompute", "task", query_id, kernel->get_id(), execution_start, execution_elapsed);
+    ral::utilities::runtime_metrics::get_instance().record_task((tracer.now() - decaching_start) / 1e6);
 
     if(task_logger) {
-        task_logger->info("{time_started}|{ral_id}|{query_id}|{kernel_id}|{duration_decaching}|{duration_execution}|{input_num_rows}|{input_num_bytes}",
-                        "time_started"_a=decachingEventTimer.start_time(),
-                        "ral_id"_a=kernel->get_context()->getNodeIndex(ral::communication::CommunicationData::getInstance().getSelfNode()),
-                        "query_id"_a=kernel->get_context()->getContextToken(),
-                        "kernel_id"_a=kernel->get_id(),
-                        "duration_decaching"_a=decaching_elapsed,
-                        "duration_execution"_a=executionEventTimer.elapsed_time(),
-                        "input_num_rows"_a=log_input_rows,
-                        "input_num_bytes"_a=log_input_bytes);
+        ral::utilities::log_event(task_logger,
+                        decachingEventTimer.start_time(),
+                        kernel->get_context()->getNodeIndex(ral::communication::CommunicationData::getInstance().getSelfNode()),
+                        kernel->get_context()->getContextToken(),
+                        kernel->get_id(),
+                        decaching_elapsed,
+                        executionEventTimer.elapsed_time(),
+                        log_input_rows,
+                        log_input_bytes,
+                        ral::cache::get_kernel_type_name(kernel->get_type_id()),
+                        blazing_device_memory_resource::get_thread_max_memory_used());
     }
 
     if(task_result.status == ral::execution::task_status::SUCCESS){
+        executor->get_task_memory_model().record(kernel->get_type_id(), input_bytes, blazing_device_memory_resource::get_thread_max_memory_used());
+        kernel->get_throughput()->record(log_input_bytes, execution_elapsed);
         complete();
     }else if(task_result.status == ral::execution::task_status::RETRY){
+        executor->get_task_memory_model().record_failure(kernel->get_type_id(), input_bytes, blazing_device_memory_resource::get_thread_max_memory_used());
         std::size_t i = 0;
         for(auto & input : inputs){
             if(input != nullptr){
@@ -176,6 +324,8 @@ void task::run(cudaStream_t stream, executor * executor){
         }
         this->attempts++;
         if(this->attempts < this->attempts_limit){
+            kernel->notify_retry();
+            ral::utilities::runtime_metrics::get_instance().record_oom_retry();
             executor->add_task(std::move(inputs), output, kernel, attempts, task_id, args);
         }else{
             throw rmm::bad_alloc("Ran out of memory processing");
@@ -185,6 +335,10 @@ void task::run(cudaStream_t stream, executor * executor){
     }
 }
 
+int32_t task::get_context_token() const {
+    return kernel->get_context()->getContextToken();
+}
+
 void task::complete(){
     kernel->notify_complete(task_id);
 }
@@ -203,56 +357,228 @@ void task::set_inputs(std::vector<std::unique_ptr<ral::cache::CacheData > > inpu
 
 
 
-executor * executor::_instance;
+std::mutex executor::instances_mutex;
+std::map<int, executor *> executor::instances;
+thread_local cudaStream_t executor::task_stream = 0;
+thread_local executor * executor::thread_instance = nullptr;
 
-executor::executor(int num_threads, double processing_memory_limit_threshold) :
- pool(num_threads), task_id_counter(0), total_rows_accumulated(0), resource(&blazing_device_memory_resource::getInstance()), task_queue("executor_task_queue") {
+executor * executor::get_instance(){
+    // the executors are never destroyed, so the one of the device of the thread is kept once it was found
+    if(thread_instance != nullptr){
+        return thread_instance;
+    }
+    int device_id = 0;
+    cudaGetDevice(&device_id);
+    std::lock_guard<std::mutex> lock(instances_mutex);
+    if(instances.empty()){
+        throw std::runtime_error("Executor not initialized.");
+    }
+    auto it = instances.find(device_id);
+    if(it == instances.end()){
+        // not kept, as the executor of the device may be initialized later
+        return instances.begin()->second;
+    }
+    thread_instance = it->second;
+    return thread_instance;
+}
+
+executor * executor::get_instance(int device_id){
+    std::lock_guard<std::mutex> lock(instances_mutex);
+    if(instances.empty()){
+        throw std::runtime_error("Executor not initialized.");
+    }
+    auto it = instances.find(device_id);
+    if(it == instances.end()){
+        return instances.begin()->second;
+    }
+    return it->second;
+}
+
+std::map<int, executor *> executor::get_all_instances(){
+    std::lock_guard<std::mutex> lock(instances_mutex);
+    return instances;
+}
+
+void executor::init_executor(int num_threads, double processing_memory_limit_threshold, int device_id, std::size_t scratch_arena_bytes){
+    std::lock_guard<std::mutex> lock(instances_mutex);
+    // the memory admission of an executor uses blazing_device_memory_resource, which wraps the RMM resource of the
+    // device the engine was initialized on, so the executor of another device would admit its tasks by the wrong memory
+    if(!instances.empty() && instances.find(device_id) == instances.end()){
+        throw std::runtime_error("ERROR: the executor of device " + std::to_string(device_id) + " can't be initialized, the executor of device " +
+            std::to_string(instances.begin()->first) + " already is and all of them would share its device memory resource");
+    }
+    if(instances.find(device_id) == instances.end()){
+        executor * instance = new executor(num_threads, processing_memory_limit_threshold, device_id, scratch_arena_bytes);
+        instance->task_id_counter = 0;
+        instance->active_tasks_counter = 0;
+        instance->total_rows_accumulated = 0;
+        instances[device_id] = instance;
+        auto thread = std::thread([instance]{
+            cudaSetDevice(instance->get_device_id());
+            instance->execute();
+        });
+        thread.detach();
+    }
+}
+
+executor::executor(int num_threads, double processing_memory_limit_threshold, int device_id, std::size_t scratch_arena_bytes) :
+ device_id(device_id), pool(num_threads), task_queue(num_threads), prefetch_pool(num_threads), task_id_counter(0), total_rows_accumulated(0), resource(&blazing_device_memory_resource::getInstance()) {
      processing_memory_limit = resource->get_total_memory() * processing_memory_limit_threshold;
+
+     // the streams have to be created on the device of this executor
+     int previous_device_id = 0;
+     cudaGetDevice(&previous_device_id);
+     cudaSetDevice(device_id);
      for( int i = 0; i < num_threads; i++){
          cudaStream_t stream;
          cudaStreamCreate(&stream);
          streams.push_back(stream);
+         if (scratch_arena_bytes > 0){
+             scratch_arenas.push_back(std::make_unique<ral::memory::scratch_arena_memory_resource>(scratch_arena_bytes));
+         }
      }
+     cudaSetDevice(previous_device_id);
 }
 
 void executor::execute(){
-    while(shutdown == 0 && exception_holder.empty()){
-        //consider using get_all and calling in a loop.
-        auto cur_task = this->task_queue.pop_or_wait();
-        pool.push([cur_task{std::move(cur_task)}, this](int thread_id){
-            std::size_t memory_needed = cur_task->task_memory_needed();
-
-            // Here we want to wait until we make sure we have enough memory to operate, or if there are no tasks currently running, then we want to go ahead and run
-            std::unique_lock<std::mutex> lock(memory_safety_mutex);
-            memory_safety_cv.wait(lock, [this, memory_needed] { 
-                if (memory_needed < (processing_memory_limit - resource->get_memory_used())){
-                    return true;
-                } else if (active_tasks_counter.load() == 0){
-                    std::shared_ptr<spdlog::logger> logger = spdlog::get("batch_logger");
-                    if (logger){
-                        logger->warn("|||{info}|||||",
-                                "info"_a="WARNING: launching task even though over limit, because there are no tasks running. Memory used: {}"_format(std::to_string(resource->get_memory_used())));
+    // every thread of the pool runs its own loop, popping from its own deque of the task_queue and stealing from the others when it is empty
+    for (int i = 0; i < pool.size(); i++){
+        pool.push([this](int thread_id){
+            cudaSetDevice(this->device_id);
+            thread_instance = this;
+            ral::utilities::thread_affinity::get_instance().pin_current_thread(ral::utilities::thread_group::COMPUTE);
+            this->task_queue.register_worker(thread_id);
+
+            // every thread looks ahead one task, so that the inputs of its next task are decached while the current one runs
+            std::future<void> next_task_prefetch;
+            while(shutdown == 0 && exception_holder.empty()){
+                std::unique_ptr<task> cur_task = this->task_queue.pop_or_wait(thread_id);
+                if (cur_task != nullptr){
+                    // the next task is only taken off the queue when no thread is idle, as an idle one would run it instead,
+                    // and only while its inputs are decached, so that it can still be stolen, cancelled or overtaken
+                    bool last_prefetch_done = !next_task_prefetch.valid() ||
+                        next_task_prefetch.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+                    if (last_prefetch_done && this->task_queue.num_idle_workers() == 0){
+                        std::unique_ptr<task> next_task = this->task_queue.try_pop(thread_id);
+                        if (next_task != nullptr){
+                            next_task_prefetch = this->prefetch_pool.push([this, thread_id, next_task = std::move(next_task)](int /*prefetch_thread_id*/) mutable {
+                                ral::utilities::thread_affinity::get_instance().pin_current_thread(ral::utilities::thread_group::COMPUTE);
+                                this->prefetch_task_inputs(std::move(next_task), thread_id);
+                            });
+                        }
                     }
-                    return true;
-                } else {
-                    return false;
+                    run_task(std::move(cur_task), thread_id);
                 }
-                });
+            }
+            if (next_task_prefetch.valid()){
+                next_task_prefetch.wait();
+            }
+        });
+    }
+}
 
-            active_tasks_counter++;
+void executor::run_task(std::unique_ptr<task> cur_task, int thread_id){
+    if (cur_task->is_cancelled()){
+        cur_task->fail();
+        return;
+    }
 
-            try {
-                cur_task->run(this->streams[thread_id], this);
-            } catch(...) {
-                std::unique_lock<std::mutex> lock(exception_holder_mutex);
-                exception_holder.push(std::current_exception());
-                cur_task->fail();
+    std::size_t memory_needed = cur_task->task_memory_needed(memory_model);
+
+    // Here we want to wait until we make sure we have enough memory to operate, or if there are no tasks currently running, then we want to go ahead and run
+    std::unique_lock<std::mutex> lock(memory_safety_mutex);
+    memory_safety_cv.wait(lock, [this, memory_needed] { 
+        if (memory_needed < (processing_memory_limit - resource->get_memory_used())){
+            return true;
+        } else if (active_tasks_counter.load() == 0){
+            std::shared_ptr<spdlog::logger> logger = spdlog::get("batch_logger");
+            if (logger){
+                logger->warn("|||{info}|||||",
+                        "info"_a="WARNING: launching task even though over limit, because there are no tasks running. Memory used: {}"_format(std::to_string(resource->get_memory_used())));
             }
-
-            active_tasks_counter--;
-            memory_safety_cv.notify_all();
+            return true;
+        } else {
+            return false;
+        }
         });
+
+    // the resource group of the task also has to have room for it, otherwise the task waits for one of the tasks of
+    // its group to finish, and this thread runs the next one. A group only has no room while some of its tasks run
+    auto group = cur_task->get_resource_group();
+    if (group != nullptr && !group->can_run(memory_needed)){
+        parked_tasks[group->get_name()].push_back(std::move(cur_task));
+        num_parked_tasks++;
+        return;
+    }
+
+    active_tasks_counter++;
+    if (group != nullptr){
+        group->task_started(memory_needed);
+    }
+    lock.unlock();
+
+    task_stream = this->streams[thread_id];
+    ral::memory::scratch_arena_memory_resource * scratch_arena = this->scratch_arenas.empty() ? nullptr : this->scratch_arenas[thread_id].get();
+    ral::memory::set_task_scratch_arena(scratch_arena);
+    try {
+        cur_task->run(this->streams[thread_id], this);
+    } catch(...) {
+        // the tasks of a cancelled query can fail because their caches were cleared, which is not an error of the executor
+        if (!cur_task->is_cancelled()){
+            std::unique_lock<std::mutex> lock(exception_holder_mutex);
+            exception_holder.push(std::current_exception());
+        }
+        cur_task->fail();
+    }
+    task_stream = 0;
+    if (scratch_arena != nullptr){
+        ral::memory::set_task_scratch_arena(nullptr);
+        // the arena gives its block back when there is nothing left to run, so that the pool can be compacted between queries
+        scratch_arena->reset(this->task_queue.size() == 0);
+    }
+
+    std::unique_ptr<task> unparked_task;
+    lock.lock();
+    active_tasks_counter--;
+    if (group != nullptr){
+        group->task_finished(memory_needed);
+        auto parked = parked_tasks.find(group->get_name());
+        if (parked != parked_tasks.end()){
+            unparked_task = std::move(parked->second.front());
+            parked->second.pop_front();
+            num_parked_tasks--;
+            if (parked->second.empty()){
+                parked_tasks.erase(parked);
+            }
+        }
+    }
+    lock.unlock();
+    // the task that waited the longest for the slot is the next one that this thread runs
+    if (unparked_task != nullptr){
+        auto task_priority = unparked_task->get_priority();
+        task_queue.put_front(std::move(unparked_task), task_priority, thread_id);
+    }
+    memory_safety_cv.notify_all();
+}
+
+void executor::prefetch_task_inputs(std::unique_ptr<task> next_task, int thread_id){
+    cudaSetDevice(device_id);
+    thread_instance = this;
+
+    // we only prefetch if it would not take us over the memory limit, since the memory will be held until the task runs
+    std::size_t bytes_to_decache = next_task->inputs_size_to_decache();
+    if (!next_task->is_cancelled() && bytes_to_decache > 0 && bytes_to_decache + resource->get_memory_used() < processing_memory_limit){
+        next_task->prefetch_inputs();
+    }
+
+    // the query may have been cancelled while the task was out of the queue, where cancel_tasks could not see it
+    if (next_task->is_cancelled()){
+        next_task->fail();
+        memory_safety_cv.notify_all();
+        return;
     }
+    auto task_priority = next_task->get_priority();
+    task_queue.put_front(std::move(next_task), task_priority, thread_id);
 }
 
 std::exception_ptr executor::last_exception(){
@@ -4,17 +4,35 @@
 #include "cache_machine/CacheMachine.h"
 #include "ExceptionHandling/BlazingThread.h"
 #include "utilities/ctpl_stl.h"
+#include "work_stealing_queue.h"
+#include "task_memory_model.h"
+#include "resource_group.h"
+#include "bmr/ScratchArena.h"
 
 namespace ral {
 namespace execution{
 
 
+/**
+* The priority of a task. Smaller values are more urgent.
+* Tasks are first ordered by the priority of their query and then by the priority of their kernel.
+*/
 class priority {
 public:
+	priority(size_t priority_num_query = 0, size_t priority_num_kernel = 0) :
+		priority_num_query(priority_num_query), priority_num_kernel(priority_num_kernel) {}
+
+	bool operator<(const priority & other) const {
+		return priority_num_query < other.priority_num_query ||
+			(priority_num_query == other.priority_num_query && priority_num_kernel < other.priority_num_kernel);
+	}
+
+	size_t get_priority_num_query() const { return priority_num_query; }
+	size_t get_priority_num_kernel() const { return priority_num_kernel; }
 
 private:
 	size_t priority_num_query; //can be used to prioritize one query over another
-	size_t priority_num_kernel; //can be
+	size_t priority_num_kernel; //can be used to prioritize the kernels closer to the OutputKernel
 };
 
 class executor;
@@ -37,7 +55,40 @@ public:
 	void run(cudaStream_t stream, executor * executor);
 	void complete();
 	void fail();
-	std::size_t task_memory_needed();
+
+	/**
+	* Estimates the GPU memory needed to run this task. If the memory_model already learned how much memory tasks like this one
+	* need, that prediction is used. Otherwise it is estimated from the inputs that need to be decached and the kernel estimates.
+	*/
+	std::size_t task_memory_needed(task_memory_model & memory_model);
+
+	/**
+	* Returns the size in bytes of the inputs of this task, in whatever format they are stored in, with the estimated
+	* decoded size of the ones that are files that are not read yet.
+	*/
+	std::size_t inputs_size_in_bytes();
+
+	/**
+	* Returns the size in bytes of the inputs of this task that are in CPU memory or in local files and need to be decached.
+	*/
+	std::size_t inputs_size_to_decache();
+
+	/**
+	* Get the resource group of the query of this task, or nullptr if it does not belong to a group.
+	*/
+	std::shared_ptr<resource_group> get_resource_group() const {
+		return group;
+	}
+
+	void set_resource_group(std::shared_ptr<resource_group> group) {
+		this->group = group;
+	}
+
+	/**
+	* Decaches the inputs of this task that are in CPU memory or in local files, and keeps them as GPU CacheDatas, so that
+	* the task does not have to wait for them when it runs. If it runs out of memory, the remaining inputs are left as they are.
+	*/
+	void prefetch_inputs();
 
 	/**
 	 * This function releases the inputs of a task so that they can be manipulated. They then need to be set again with set_inputs
@@ -49,6 +100,21 @@ public:
 	 */
 	void set_inputs(std::vector<std::unique_ptr<ral::cache::CacheData > > inputs);
 
+	/**
+	 * Returns the priority of this task, which is given by the query and the position of its kernel in the graph
+	 */
+	priority get_priority() const { return task_priority; }
+
+	/**
+	 * Returns true if the kernel of this task was cancelled, and so the task must not run.
+	 */
+	bool is_cancelled() const { return kernel->is_cancelled(); }
+
+	/**
+	 * Returns the token of the query of this task.
+	 */
+	int32_t get_context_token() const;
+
 protected:
 	std::vector<std::unique_ptr<ral::cache::CacheData > > inputs;
 	std::shared_ptr<ral::cache::CacheMachine> output;
@@ -57,6 +123,8 @@ protected:
 	size_t attempts = 0;
 	size_t attempts_limit;
 	std::map<std::string, std::string> args;
+	priority task_priority;
+	std::shared_ptr<resource_group> group;
 
 public:
     std::shared_ptr<spdlog::logger> task_logger;
@@ -65,24 +133,52 @@ public:
 
 class executor{
 public:
-	static executor * get_instance(){
-		if(_instance == nullptr){
-			throw std::runtime_error("Executor not initialized.");
-		}
-		return _instance;
+	/**
+	* Get the executor of the device set for the calling thread.
+	* If that device has no executor, the executor of the lowest device that has one is returned, so that threads that
+	* never set their device keep working when there is a single executor.
+	* The executor of a thread is only looked up the first time, so a thread that changes its device after that has to
+	* use get_instance(device_id).
+	*/
+	static executor * get_instance();
+
+	/**
+	* Get the executor of a device.
+	* @param device_id the device whose executor we want. Falls back to the executor of the lowest device if it does not have one.
+	*/
+	static executor * get_instance(int device_id);
+
+	/**
+	* Initializes the executor of a device if it was not initialized already.
+	* Every device has its own executor, with its own threads and streams. Only one device can have one for now, since the memory
+	* admission of the executors uses blazing_device_memory_resource, which wraps the RMM resource of a single device.
+	* @param num_threads the number of threads of the executor.
+	* @param processing_memory_limit_threshold the percent of the total GPU memory that the executor tries to stay under for starting new tasks.
+	* @param device_id the device on which the threads of this executor run their tasks.
+	* @param scratch_arena_bytes the most that the scratch arena of every thread can hold, 0 for no arenas.
+	* @throws std::runtime_error if another device already has an executor.
+	*/
+	static void init_executor(int num_threads, double processing_memory_limit_threshold, int device_id = 0,
+		std::size_t scratch_arena_bytes = 0);
+
+	/**
+	* Get the executors of all the devices that have one, by device id.
+	*/
+	static std::map<int, executor *> get_all_instances();
+
+	/**
+	* Get the stream of the task that the calling thread runs, so that the work it does outside of its kernel, like
+	* downgrading its outputs, does not go to the default stream. It is the default stream outside of the executor.
+	*/
+	static cudaStream_t get_task_stream() {
+		return task_stream;
 	}
 
-	static void init_executor(int num_threads, double processing_memory_limit_threshold){
-		if(!_instance){
-			_instance = new executor(num_threads, processing_memory_limit_threshold);
-			_instance->task_id_counter = 0;
-			_instance->active_tasks_counter = 0;
-			_instance->total_rows_accumulated = 0;
-			auto thread = std::thread([/*_instance*/]{
-				_instance->execute();
-			});
-			thread.detach();
-		}
+	/**
+	* Get the device on which this executor runs its tasks.
+	*/
+	int get_device_id() const {
+		return device_id;
 	}
 
 	void execute();
@@ -103,6 +199,13 @@ public:
 
 	std::unique_ptr<task> remove_task_from_back();
 
+	/**
+	* Drops the queued tasks of the cancelled kernels of a query, with their inputs, and tells their kernels that they
+	* failed. The tasks of the query that are running finish, and the ones that are added later are dropped when they
+	* come up to run.
+	*/
+	void cancel_tasks(int32_t ctx_token);
+
 	void notify_memory_safety_cv(){
 		memory_safety_cv.notify_all();
 	}
@@ -115,13 +218,62 @@ public:
 		return this->total_rows_accumulated;
 	}
 
+	/**
+	* Get the number of tasks that are waiting to run, the ones that wait for a slot of their resource group too.
+	*/
+	std::size_t get_num_queued_tasks() {
+		return this->task_queue.size() + this->num_parked_tasks.load();
+	}
+
+	/**
+	* Get the number of tasks that are running.
+	*/
+	int get_num_active_tasks() const {
+		return this->active_tasks_counter.load();
+	}
+
+	/**
+	* Get the GPU memory that the executor tries to stay under for starting new tasks.
+	*/
+	std::size_t get_processing_memory_limit() const {
+		return this->processing_memory_limit;
+	}
+
+	task_memory_model & get_task_memory_model() {
+		return this->memory_model;
+	}
+
+	/**
+	* Get a resource group, creating it the first time it is used.
+	* The limits of a group are set by the first query that uses it.
+	* @param name the name of the group.
+	* @param memory_fraction the fraction of the processing memory limit that the group can use.
+	* @param max_threads the number of threads that the group can use. If it is not positive the group can use all of them.
+	*/
+	std::shared_ptr<resource_group> get_resource_group(const std::string & name, double memory_fraction, int max_threads);
+
+	/**
+	* Indicates if any resource group is using more memory than its budget.
+	*/
+	bool has_resource_group_over_budget();
+
 private:
-	executor(int num_threads, double processing_memory_limit_threshold);
+	executor(int num_threads, double processing_memory_limit_threshold, int device_id, std::size_t scratch_arena_bytes);
+	int device_id;
 	ctpl::thread_pool<BlazingThread> pool;
 	std::vector<cudaStream_t> streams; //one stream per thread
-	ral::cache::WaitingQueue< std::unique_ptr<task> > task_queue;
+	std::vector<std::unique_ptr<ral::memory::scratch_arena_memory_resource>> scratch_arenas; //one arena per thread, empty when they are disabled
+	work_stealing_queue< std::unique_ptr<task>, priority > task_queue; //one deque per thread
+	void run_task(std::unique_ptr<task> cur_task, int thread_id);
+	void prefetch_task_inputs(std::unique_ptr<task> next_task, int thread_id); //decaches the inputs of a task and puts it back at the front of the deque of the thread
+	ctpl::thread_pool<BlazingThread> prefetch_pool; //decaches the inputs of the next task of every thread while the current one runs
 	int shutdown = 0;
-	static executor * _instance;
+	std::map<std::string, std::deque<std::unique_ptr<task>>> parked_tasks; //the tasks whose resource group had no room, by group, until one of its tasks finishes. Guarded by memory_safety_mutex
+	std::atomic<std::size_t> num_parked_tasks{0};
+	static std::mutex instances_mutex;
+	static std::map<int, executor *> instances; /**< One executor per device, keyed by device id. */
+	static thread_local cudaStream_t task_stream; /**< The stream of the thread of the executor that runs the task. */
+	static thread_local executor * thread_instance; /**< The executor of the device of the thread, once it was looked up. */
 	std::atomic<int> task_id_counter;
 	std::atomic<int64_t> total_rows_accumulated;
 	size_t attempts_limit = 10;
@@ -139,9 +291,14 @@ private:
 
 	BlazingMemoryResource* resource;
 	std::size_t processing_memory_limit;
+	task_memory_model memory_model; /**< Learns the peak memory used by the tasks of every kind of kernel, for admitting new tasks. */
 	std::atomic<int> active_tasks_counter;
 	std::mutex memory_safety_mutex;
 	std::condition_variable memory_safety_cv;
+
+	std::shared_ptr<resource_group> get_resource_group(ral::cache::kernel * kernel);
+	std::mutex resource_groups_mutex;
+	std::map<std::string, std::shared_ptr<resource_group>> resource_groups; /**< Resource groups by name. */
 };
 
 
@@ -1,10 +1,32 @@
 #include "graph.h"
 #include "operators/OrderBy.h"
 #include "execution_kernels/BatchProcessing.h"
+#include "bmr/QueryMemoryTracker.h"
+#include "utilities/CodeTimer.h"
+#include "execution_graph/executor.h"
+#include "communication/CommunicationData.h"
+
+#include <sstream>
 
 namespace ral {
 namespace cache {
 
+namespace {
+// the SIMPLE edges that connect one kernel with another one can hand off the tables directly
+bool use_direct_cache_edge(const cache_settings & config) {
+	if (config.type != CacheType::SIMPLE || config.num_partitions > 1 || config.is_array_access
+		|| config.cache_level_override != -1 || config.context == nullptr) {
+		return false;
+	}
+	std::map<std::string, std::string> config_options = config.context->getConfigOptions();
+	auto it = config_options.find("ENABLE_DIRECT_CACHE_EDGES");
+	if (it != config_options.end()){
+		return it->second != "False" && it->second != "false";
+	}
+	return true;
+}
+}
+
 	int32_t graph::get_context_token() { return context_token;	}
 	void graph::set_context_token(int32_t token) { context_token = token; }
 
@@ -20,7 +42,19 @@ namespace cache {
 		}
 		this->add_edge(p.src, p.dst, source_port_name, target_port_name, p.cache_machine_config);
 	}
+	graph::~graph() {
+		{
+			std::lock_guard<std::mutex> lock(cancel_mutex);
+			execution_finished = true;
+			cancel_cv.notify_all();
+		}
+		if (deadline_thread.joinable()) {
+			deadline_thread.join();
+		}
+	}
+
 	void graph::clear_kernels(){
+		final_kernel_stats = get_kernel_stats();
 		container_.clear();
 		edges_.clear();
 		reverse_edges_.clear();
@@ -49,14 +83,39 @@ namespace cache {
 	void graph::start_execute(const std::size_t max_kernel_run_threads) {
 		mem_monitor->start();
 
-		pool.resize(max_kernel_run_threads);
+		pool.set_max_running_kernels(max_kernel_run_threads);
+		if (deadline.count() > 0) {
+			deadline_thread = BlazingThread([this] {
+				std::unique_lock<std::mutex> lock(cancel_mutex);
+				if (!cancel_cv.wait_for(lock, deadline, [this] { return cancelled || execution_finished; })) {
+					lock.unlock();
+					if (!query_is_complete()) {
+						cancel("it ran over its deadline of " + std::to_string(deadline.count()) + " ms");
+					}
+				}
+			});
+		}
+		agree_shuffle_checkpoint_restore();
 		for (auto source_id : ordered_kernel_ids){
 			auto source = get_node(source_id);
-			futures.push_back(pool.push([this, source, source_id] (int /*thread_id*/) {
+			futures.push_back(pool.push([this, source, source_id] () {
 				try	{
+					if (skipped_kernel_ids.count(source_id) > 0) {
+						source->output_.finish();
+						return;
+					}
 					auto edges = get_neighbours(source);
-					auto state = source->run();
+					ral::memory::scoped_allocation_owner allocation_owner(context_token, source->get_id());
+					CodeTimer run_timer;
+					auto state = restored_kernel_ids.count(source_id) > 0 ?
+						static_cast<distributing_kernel *>(source)->restore_checkpoint() : source->run();
+					source->record_run_time(run_timer.elapsed_time<std::chrono::microseconds>());
 					source->output_.finish();
+					auto checkpointed = dynamic_cast<distributing_kernel *>(source);
+					if (state == kstatus::proceed && checkpointed) {
+						checkpointed->commit_checkpoint();
+					}
+					notify_runtime_stats();
 					if (state != kstatus::proceed && source->get_type_id() != ral::cache::kernel_type::OutputKernel) {
                         std::shared_ptr<spdlog::logger> logger = spdlog::get("batch_logger");
 						std::string log_detail = "ERROR kernel " + std::to_string(source_id) + " did not finished successfully";
@@ -80,10 +139,68 @@ namespace cache {
 	void graph::finish_execute() {
 		// Lets iterate through the futures to check for exceptions
 		for(size_t i = 0; i < futures.size(); i++){
-			futures[i].get();
+			try {
+				futures[i].get();
+			} catch(...) {
+				// the kernels of a cancelled query can fail because their caches were cleared
+				if (!is_cancelled()) {
+					throw;
+				}
+			}
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(cancel_mutex);
+			execution_finished = true;
+			cancel_cv.notify_all();
+		}
+		if (deadline_thread.joinable()) {
+			deadline_thread.join();
 		}
 
 		mem_monitor->finalize();
+
+		std::lock_guard<std::mutex> lock(cancel_mutex);
+		if (cancelled) {
+			throw std::runtime_error("ERROR: the query " + std::to_string(context_token) + " was cancelled because " + cancel_reason);
+		}
+	}
+
+	void graph::cancel(const std::string & reason) {
+		// the lock keeps the kernels from being cleared while they are cancelled
+		std::lock_guard<std::mutex> lock(cancel_mutex);
+		if (cancelled || execution_finished) {
+			return;
+		}
+		cancelled = true;
+		cancel_reason = reason;
+		cancel_cv.notify_all();
+
+		std::shared_ptr<spdlog::logger> logger = spdlog::get("batch_logger");
+		if (logger) {
+			logger->warn("|||{info}|||||", "info"_a="Cancelling the query " + std::to_string(context_token) + " because " + reason);
+		}
+
+		// all the kernels are marked before their tasks are dropped, so that none of them is queued again
+		for (auto & node : container_) {
+			if (node.second) {
+				node.second->cancel();
+			}
+		}
+		ral::execution::executor::get_instance()->cancel_tasks(context_token);
+		if (input_cache_) {
+			input_cache_->notify_waiters(); // for the kernels that wait for the messages of the other nodes
+		}
+		notify_runtime_stats();
+	}
+
+	bool graph::is_cancelled() {
+		std::lock_guard<std::mutex> lock(cancel_mutex);
+		return cancelled;
+	}
+
+	void graph::set_deadline(std::chrono::milliseconds timeout) {
+		deadline = timeout;
 	}
 
 	void graph::show() {
@@ -187,6 +304,37 @@ namespace cache {
 		return std::make_pair(false, 0);
 	}
 
+	runtime_stats graph::get_runtime_stats(int32_t id) {
+		kernel * target_kernel = get_node(id);
+		runtime_stats stats;
+		stats.rows = target_kernel->output_.total_rows_added();
+		stats.bytes = target_kernel->output_.total_bytes_added();
+		stats.batches = target_kernel->output_.total_batches_added();
+		stats.finished = target_kernel->output_.all_finished();
+		return stats;
+	}
+
+	runtime_stats graph::get_input_runtime_stats(int32_t id, const std::string & port_name) {
+		auto & cache = get_node(id)->input_.get_cache(port_name);
+		runtime_stats stats;
+		stats.rows = cache->get_num_rows_added();
+		stats.bytes = cache->get_num_bytes_added();
+		stats.batches = cache->get_num_batches_added();
+		stats.finished = cache->is_finished();
+		return stats;
+	}
+
+	void graph::notify_runtime_stats() {
+		// the lock makes sure that a kernel that just checked the stats is already waiting
+		std::lock_guard<std::mutex> lock(runtime_stats_mutex);
+		runtime_stats_cv.notify_all();
+	}
+
+	bool graph::wait_for_runtime_stats(std::function<bool()> replan, std::chrono::milliseconds timeout) {
+		std::unique_lock<std::mutex> lock(runtime_stats_mutex);
+		return runtime_stats_cv.wait_for(lock, timeout, replan);
+	}
+
 	std::shared_ptr<kernel> graph::get_last_kernel() {
 		int32_t kernel_id = kernels_.at(kernels_.size() - 1)->get_id();
 		return container_[kernel_id];
@@ -219,7 +367,11 @@ namespace cache {
 
 		target->set_parent(source->get_id());
 		{
-			std::vector<std::shared_ptr<CacheMachine>> cache_machines = create_cache_machines(config, source_port, source->get_id());
+			cache_settings edge_config = config;
+			if (use_direct_cache_edge(config)) {
+				edge_config.type = CacheType::DIRECT;
+			}
+			std::vector<std::shared_ptr<CacheMachine>> cache_machines = create_cache_machines(edge_config, source_port, source->get_id());
 			if(config.type == CacheType::FOR_EACH) {
 				for(size_t index = 0; index < cache_machines.size(); index++) {
 
@@ -354,13 +506,17 @@ namespace cache {
 			Q.pop_front();
 			if (node_has_all_dependencies){
 				if(source) {
+					bool ordered = false; // a kernel with several consumers, like a SpoolKernel, is only run once
 					for(auto edge : get_neighbours(source)) {
 						auto target_id = edge.target;
 						auto edge_id = std::make_pair(source_id, target_id);
 						if(visited.find(edge_id) == visited.end()) {
 							visited.insert(edge_id);
 							Q.push_back(target_id);
-							ordered_kernel_ids.push_back(source_id);
+							if (!ordered) {
+								ordered_kernel_ids.push_back(source_id);
+								ordered = true;
+							}
 						} else {
 							// TODO: and circular graph is defined here. Report and error
 						}
@@ -372,6 +528,122 @@ namespace cache {
 		}
 	}
 
+	void graph::plan_shuffle_checkpoint_restore(const std::string & fingerprint) {
+		for (auto kernel_id : ordered_kernel_ids) {
+			auto checkpointed = dynamic_cast<distributing_kernel *>(get_node(kernel_id));
+			if (checkpointed && checkpointed->has_checkpoint()) {
+				if (checkpoint_coordinator_id == -1) {
+					checkpoint_coordinator_id = kernel_id;
+				}
+				checkpointed->set_checkpoint_fingerprint(fingerprint);
+				if (checkpointed->can_restore_checkpoint()) {
+					restorable_kernel_ids.insert(kernel_id);
+				}
+			}
+		}
+	}
+
+	namespace {
+	std::string serialize_kernel_ids(const std::set<int32_t> & kernel_ids) {
+		std::string serialized;
+		for (auto kernel_id : kernel_ids) {
+			serialized += (serialized.empty() ? "" : ",") + std::to_string(kernel_id);
+		}
+		return serialized;
+	}
+
+	std::set<int32_t> deserialize_kernel_ids(const std::string & serialized) {
+		std::set<int32_t> kernel_ids;
+		std::istringstream in(serialized);
+		std::string kernel_id;
+		while (std::getline(in, kernel_id, ',')) {
+			if (!kernel_id.empty()) {
+				kernel_ids.insert(std::stoi(kernel_id));
+			}
+		}
+		return kernel_ids;
+	}
+	}  // namespace
+
+	void graph::agree_shuffle_checkpoint_restore() {
+		if (checkpoint_coordinator_id == -1) {
+			return;
+		}
+
+		// a node restores a kernel only if all the others do, or the rows that they would send again are repeated
+		auto coordinator = static_cast<distributing_kernel *>(get_node(checkpoint_coordinator_id));
+		auto context = coordinator->get_context();
+		if (context->getTotalNodes() > 1) {
+			auto & self_node = ral::communication::CommunicationData::getInstance().getSelfNode();
+			const auto & master_node = context->getMasterNode();
+			const std::string message_id_suffix = std::to_string(context_token) + "_" + std::to_string(checkpoint_coordinator_id) + "_";
+			auto pull_restorable = [this, &message_id_suffix](const std::string & prefix, const std::string & sender_id) {
+				auto message = input_cache_->pullCacheData(prefix + message_id_suffix + sender_id, [this]{ return this->is_cancelled(); });
+				if (message == nullptr) {
+					// the query was cancelled, its kernels stop as soon as they start
+					return std::set<int32_t>();
+				}
+				return deserialize_kernel_ids(message->getMetadata().get_value(ral::cache::SHUFFLE_CHECKPOINT_RESTORABLE_METADATA_LABEL));
+			};
+			auto send_restorable = [coordinator](const std::string & prefix, const std::string & target_id, const std::set<int32_t> & kernel_ids) {
+				ral::cache::MetadataDictionary extra_metadata;
+				extra_metadata.add_value(ral::cache::SHUFFLE_CHECKPOINT_RESTORABLE_METADATA_LABEL, serialize_kernel_ids(kernel_ids));
+				coordinator->send_message(nullptr,
+					false, //specific_cache
+					"", //cache_id
+					{target_id}, //target_ids
+					prefix, //message_id_prefix
+					true, //always_add
+					false, //wait_for
+					0, //message_tracker_idx
+					extra_metadata);
+			};
+
+			if (context->isMasterNode(self_node)) {
+				for (auto & other_node : context->getAllNodes()) {
+					if (other_node == self_node) {
+						continue;
+					}
+					std::set<int32_t> other_restorable = pull_restorable("checkpoint_vote_", other_node.id());
+					for (auto it = restorable_kernel_ids.begin(); it != restorable_kernel_ids.end();) {
+						it = other_restorable.count(*it) > 0 ? std::next(it) : restorable_kernel_ids.erase(it);
+					}
+				}
+				for (auto & other_node : context->getAllNodes()) {
+					if (!(other_node == self_node)) {
+						send_restorable("checkpoint_decision_", other_node.id(), restorable_kernel_ids);
+					}
+				}
+			} else {
+				send_restorable("checkpoint_vote_", master_node.id(), restorable_kernel_ids);
+				restorable_kernel_ids = pull_restorable("checkpoint_decision_", master_node.id());
+			}
+		}
+		if (restorable_kernel_ids.empty()) {
+			return;
+		}
+
+		// from the end of the query, a kernel whose consumers are all restored or not run is not run either
+		for (auto it = ordered_kernel_ids.rbegin(); it != ordered_kernel_ids.rend(); ++it) {
+			auto edges = get_neighbours(*it);
+			bool only_feeds_restored = !edges.empty() && std::all_of(edges.begin(), edges.end(), [&](const Edge & edge) {
+				return edge.target != -1 && (restorable_kernel_ids.count(edge.target) > 0 || skipped_kernel_ids.count(edge.target) > 0);
+			});
+			if (only_feeds_restored) {
+				skipped_kernel_ids.insert(*it);
+			} else if (restorable_kernel_ids.count(*it) > 0) {
+				restored_kernel_ids.insert(*it);
+			}
+		}
+
+		std::shared_ptr<spdlog::logger> logger = spdlog::get("batch_logger");
+		if (logger) {
+			logger->info("{query_id}|||{info}|||||",
+				"query_id"_a=context_token,
+				"info"_a="Restoring {} kernels from the shuffle checkpoint, {} kernels are not run"_format(restored_kernel_ids.size(), skipped_kernel_ids.size()));
+		}
+	}
+
 	bool graph::query_is_complete(){
 		return static_cast<ral::batch::OutputKernel&>(*(this->get_last_kernel())).is_done();
 	}
@@ -388,5 +660,27 @@ namespace cache {
 		return progress;
 	}
 
+	std::vector<kernel_stats> graph::get_kernel_stats() {
+		if (container_.empty()) {
+			return final_kernel_stats;
+		}
+		std::vector<kernel_stats> stats;
+		for (auto kernel_id : ordered_kernel_ids) {
+			kernel * kernel = get_node(kernel_id);
+			if (kernel == nullptr) {
+				continue;
+			}
+			kernel_stats stat = kernel->get_stats();
+			for (auto edge : get_reverse_neighbours(kernel_id)) {
+				auto & inputs = stat.input_kernel_ids;
+				if (edge.source != head_id_ && std::find(inputs.begin(), inputs.end(), edge.source) == inputs.end()) {
+					inputs.push_back(edge.source);
+				}
+			}
+			stats.push_back(stat);
+		}
+		return stats;
+	}
+
 }  // namespace cache
 }  // namespace ral
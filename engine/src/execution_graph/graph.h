@@ -1,10 +1,15 @@
 #pragma once
 
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+
 #include "execution_kernels/kernel.h"
 #include "kpair.h"
 #include "cache_machine/CacheMachine.h"
 #include "bmr/MemoryMonitor.h"
-#include "utilities/ctpl_stl.h"
+#include "kernel_run_pool.h"
 namespace ral {
 namespace cache {
 
@@ -14,9 +19,11 @@ static std::shared_ptr<ral::cache::CacheMachine> create_cache_machine( const cac
 	std::shared_ptr<ral::cache::CacheMachine> machine;
 	if (config.type == CacheType::SIMPLE or config.type == CacheType::FOR_EACH) {
 		machine =  std::make_shared<ral::cache::CacheMachine>(config.context, cache_machine_name, config.log_timeout, config.cache_level_override, config.is_array_access);		
+	} else if (config.type == CacheType::DIRECT) {
+		machine =  std::make_shared<ral::cache::DirectCacheMachine>(config.context, cache_machine_name, config.log_timeout);
 	} else if (config.type == CacheType::CONCATENATING) {
 		machine =  std::make_shared<ral::cache::ConcatenatingCacheMachine>(config.context, 
-			config.concat_cache_num_bytes, config.num_bytes_timeout, config.concat_all, cache_machine_name);
+			config.concat_cache_num_bytes, config.num_bytes_timeout, config.concat_all, cache_machine_name, config.consumer_throughput);
 	}
 	return machine;
 }
@@ -35,12 +42,46 @@ static std::shared_ptr<ral::cache::CacheMachine> create_cache_machine( const cac
 	return machines;
 }
 
+/**
+	@brief The exact rows and bytes that have been added to a cache or output by a kernel so far, gathered as its batches
+	finish. They are final once it is finished.
+*/
+struct runtime_stats {
+	uint64_t rows = 0;
+	uint64_t bytes = 0;
+	uint64_t batches = 0;
+	bool finished = false;
+};
+
 struct graph_progress {
 	std::vector<std::string> kernel_descriptions;
     std::vector<bool> finished;
     std::vector<int> batches_completed;
 };
 
+/**
+	@brief What a kernel did in a query, for the explain analyze of BlazingContext.explain. The wall time is the one of
+	its run() loop and the task time the one its tasks spent processing their batches, both in microseconds. The input
+	ones are the rows and bytes that its tasks processed, and the spill bytes the ones of its output that were put in the
+	host or disk tiers of the caches.
+*/
+struct kernel_stats {
+	int32_t kernel_id = 0;
+	std::string kernel_name;
+	std::vector<int32_t> input_kernel_ids;
+	uint64_t wall_time_us = 0;
+	uint64_t task_time_us = 0;
+	uint64_t input_rows = 0;
+	uint64_t input_bytes = 0;
+	uint64_t output_rows = 0;
+	uint64_t output_bytes = 0;
+	uint64_t output_batches = 0;
+	uint64_t spill_bytes = 0;
+	uint64_t retries = 0;
+	uint64_t shuffle_bytes = 0;
+	bool finished = false;
+};
+
 /**
 	@brief A class that represents the execution graph in a taskflow scheme.
 	The taskflow scheme is basically implemeted by the execution graph and the kernels associated to each node in the graph.
@@ -66,7 +107,7 @@ public:
 		container_[head_id_] = nullptr;	 // sentinel node
 		kernels_edges_logger = spdlog::get("kernels_edges_logger");
 	}
-	~graph() {}
+	~graph();
 	graph(const graph &) = default;
 	graph & operator=(const graph &) = default;
 
@@ -81,8 +122,28 @@ public:
 	void check_and_complete_work_flow();
 
 	void start_execute(const std::size_t max_kernel_run_threads);
+
+	/**
+	 * @brief Waits for all the kernels to finish. It throws if the query was cancelled.
+	 */
 	void finish_execute();
 
+	/**
+	 * @brief Cancels the query. Its kernels stop creating tasks, its queued tasks are dropped and its caches are emptied,
+	 * which frees their GPU memory and removes their spill files right away, and then its kernels finish as they run out
+	 * of data. Only the tasks that are already running go on until they finish.
+	 * @param reason why the query was cancelled, for the error of finish_execute
+	 */
+	void cancel(const std::string & reason = "it was cancelled");
+
+	bool is_cancelled();
+
+	/**
+	 * @brief Cancels the query if it did not finish in the given time since it started, see QUERY_TIMEOUT_MS. It must
+	 * be set before start_execute, and a timeout of 0 means no deadline.
+	 */
+	void set_deadline(std::chrono::milliseconds timeout);
+
 	void show();
 
 	void show_from_kernel (int32_t id);
@@ -91,12 +152,41 @@ public:
 
 	std::pair<bool, uint64_t> get_estimated_input_rows_to_cache(int32_t id, const std::string & port_name);
 
+	/**
+	 * @brief The rows and bytes that the kernel has output so far.
+	 */
+	runtime_stats get_runtime_stats(int32_t id);
+
+	/**
+	 * @brief The rows and bytes that have arrived to an input of the kernel so far.
+	 */
+	runtime_stats get_input_runtime_stats(int32_t id, const std::string & port_name);
+
+	/**
+	 * @brief Wakes up the kernels that wait in wait_for_runtime_stats. It is called every time a kernel finishes a batch,
+	 * and when it finishes.
+	 */
+	void notify_runtime_stats();
+
+	/**
+	 * @brief The hook for a kernel to replan what it does from the runtime stats of the graph. The replan function is
+	 * called every time a batch of any kernel finishes, until it returns true or the timeout passes.
+	 * @return false if the timeout passed
+	 */
+	bool wait_for_runtime_stats(std::function<bool()> replan, std::chrono::milliseconds timeout);
+
 	std::shared_ptr<kernel> get_last_kernel();
 
 	bool query_is_complete();
 
 	graph_progress get_progress();
 
+	/**
+	 * @brief The stats of all the kernels, in the order in which they run, so the last one is the OutputKernel. They are
+	 * kept when the kernels are cleared at the end of the query.
+	 */
+	std::vector<kernel_stats> get_kernel_stats();
+
 	size_t num_nodes() const;
 
 	size_t add_node(std::shared_ptr<kernel> k);
@@ -121,6 +211,17 @@ public:
 
 	void set_kernels_order();
 
+	/**
+	 * @brief With SHUFFLE_CHECKPOINT_PATH, gives the fingerprint of the query to the checkpoints of the distributing
+	 * kernels and finds the ones that this node can restore from an earlier attempt of the query, see
+	 * ral::distribution::shuffle_checkpoint. It has to be called after set_kernels_order.
+	 *
+	 * The restore is only decided in start_execute, before any kernel starts: every node sends the kernels it can restore
+	 * to the master, which sends back the ones that all of them can. Those are restored from their shuffle checkpoint
+	 * instead of being run, and the kernels that only feed them are not run at all, in all the nodes alike.
+	 */
+	void plan_shuffle_checkpoint_restore(const std::string & fingerprint);
+
 	bool is_scan_with_limit(size_t min_index_valid);
 	bool is_bindablescan_with_limit_without_filter(size_t min_index_valid);
 	void check_for_simple_scan_with_limit_query();
@@ -128,11 +229,14 @@ public:
 	void clear_kernels(); 
 	
 private:
+	void agree_shuffle_checkpoint_restore();
+
 	const std::int32_t head_id_{-1};
 	std::vector<kernel *> kernels_;
 	std::map<std::int32_t, std::shared_ptr<kernel>> container_;
 	std::map<std::int32_t, std::set<Edge>> edges_;
 	std::map<std::int32_t, std::set<Edge>> reverse_edges_;
+	std::vector<kernel_stats> final_kernel_stats; // of the kernels that were cleared
 
 	std::shared_ptr<ral::cache::CacheMachine> input_cache_;
 	std::shared_ptr<ral::cache::CacheMachine> output_cache_;
@@ -140,9 +244,24 @@ private:
 	std::shared_ptr<spdlog::logger> kernels_edges_logger;
 	int32_t context_token;
 	std::shared_ptr<ral::MemoryMonitor> mem_monitor;
-	ctpl::thread_pool<BlazingThread> pool;
+	ral::execution::kernel_run_pool pool;
 	std::vector<std::future<void>> futures;
 	std::vector<int32_t> ordered_kernel_ids;  // ordered vector containing the kernel_ids in the order they will be started
+	int32_t checkpoint_coordinator_id = -1;  // the distributing kernel whose messages agree on the shuffle checkpoint restore
+	std::set<int32_t> restorable_kernel_ids;  // the kernels that this node can restore, before the nodes agreed
+	std::set<int32_t> restored_kernel_ids;  // the kernels that are restored from their shuffle checkpoint
+	std::set<int32_t> skipped_kernel_ids;  // the kernels that only feed restored ones, which are not run
+
+	std::mutex runtime_stats_mutex;
+	std::condition_variable runtime_stats_cv;
+
+	std::mutex cancel_mutex;
+	std::condition_variable cancel_cv; // wakes up the deadline thread when the query is cancelled or finishes
+	bool cancelled = false;
+	bool execution_finished = false;
+	std::string cancel_reason;
+	std::chrono::milliseconds deadline{0};
+	BlazingThread deadline_thread;
 };
 
 }  // namespace cache
@@ -0,0 +1,123 @@
+#include "kernel_run_pool.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include "utilities/ThreadAffinity.h"
+
+namespace ral {
+namespace execution {
+
+thread_local kernel_run_pool * kernel_run_pool::current_pool = nullptr;
+
+kernel_run_pool::kernel_run_pool(std::size_t max_running_kernels)
+	: max_running_kernels(std::max<std::size_t>(max_running_kernels, 1)) {}
+
+kernel_run_pool::~kernel_run_pool() {
+	std::vector<BlazingThread> stopped_threads;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+		condition.notify_all();
+	}
+	// the kernels that are still running can add threads until they finish
+	while (true) {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (threads.empty()) {
+				break;
+			}
+			std::move(threads.begin(), threads.end(), std::back_inserter(stopped_threads));
+			threads.clear();
+		}
+		for (auto & thread : stopped_threads) {
+			thread.join();
+		}
+		stopped_threads.clear();
+	}
+}
+
+void kernel_run_pool::set_max_running_kernels(std::size_t max_running_kernels) {
+	std::lock_guard<std::mutex> lock(mutex);
+	this->max_running_kernels = std::max<std::size_t>(max_running_kernels, 1);
+	start_pending_kernel();
+}
+
+std::future<void> kernel_run_pool::push(std::function<void()> run) {
+	std::packaged_task<void()> task(std::move(run));
+	std::future<void> future = task.get_future();
+	std::lock_guard<std::mutex> lock(mutex);
+	pending.push_back(std::move(task));
+	start_pending_kernel();
+	return future;
+}
+
+void kernel_run_pool::start_pending_kernel() {
+	if (pending.empty() || running_kernels >= max_running_kernels) {
+		return;
+	}
+	if (idle_threads > 0) {
+		condition.notify_one();
+	} else {
+		idle_threads++;
+		threads.push_back(BlazingThread(&kernel_run_pool::run_worker, this));
+	}
+}
+
+void kernel_run_pool::run_worker() {
+	current_pool = this;
+	ral::utilities::thread_affinity::get_instance().pin_current_thread(ral::utilities::thread_group::COMPUTE);
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true) {
+		condition.wait(lock, [this] {
+			return (!pending.empty() && running_kernels < max_running_kernels) || (stopping && pending.empty());
+		});
+		if (pending.empty()) {
+			break;
+		}
+		std::packaged_task<void()> task = std::move(pending.front());
+		pending.pop_front();
+		idle_threads--;
+		running_kernels++;
+		lock.unlock();
+
+		task();
+
+		lock.lock();
+		running_kernels--;
+		idle_threads++;
+		start_pending_kernel();
+	}
+	idle_threads--;
+	current_pool = nullptr;
+}
+
+void kernel_run_pool::begin_blocking() {
+	std::lock_guard<std::mutex> lock(mutex);
+	running_kernels--;
+	start_pending_kernel();
+}
+
+void kernel_run_pool::end_blocking() {
+	// the kernel goes on right away, even if it goes over max_running_kernels until one of them waits or finishes
+	std::lock_guard<std::mutex> lock(mutex);
+	running_kernels++;
+}
+
+kernel_run_pool::blocking_region::blocking_region() : pool(current_pool) {
+	if (pool != nullptr) {
+		// the waits inside this one are not counted again
+		current_pool = nullptr;
+		pool->begin_blocking();
+	}
+}
+
+kernel_run_pool::blocking_region::~blocking_region() {
+	if (pool != nullptr) {
+		pool->end_blocking();
+		current_pool = pool;
+	}
+}
+
+} // namespace execution
+} // namespace ral
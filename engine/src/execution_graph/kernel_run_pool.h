@@ -0,0 +1,107 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <vector>
+
+#include "ExceptionHandling/BlazingThread.h"
+
+namespace ral {
+namespace execution {
+
+/**
+* Runs the run() loops of the kernels of a graph, with at most max_running_kernels of them running at a time.
+* The loops spend most of their time waiting for their caches or their tasks, and a kernel that waits does not count
+* as running: its thread tells the pool with a blocking_region, and the pool starts another kernel meanwhile, on an idle
+* thread or on a new one. So any number of kernels can wait for each other without taking all the threads, which
+* deadlocked the plans with more kernels than threads, while only max_running_kernels of them use the CPU at once.
+*/
+class kernel_run_pool {
+public:
+	explicit kernel_run_pool(std::size_t max_running_kernels = 16);
+	~kernel_run_pool();
+
+	kernel_run_pool(const kernel_run_pool &) = delete;
+	kernel_run_pool & operator=(const kernel_run_pool &) = delete;
+
+	void set_max_running_kernels(std::size_t max_running_kernels);
+
+	/**
+	* Queues the run() loop of a kernel. The future has the exception that it throws, if any.
+	*/
+	std::future<void> push(std::function<void()> run);
+
+	/**
+	* Marks the calling thread as waiting while it lives, if it is a thread of a kernel_run_pool. It does nothing on the
+	* other threads, like the ones of the executor.
+	*/
+	class blocking_region {
+	public:
+		blocking_region();
+		~blocking_region();
+
+		blocking_region(const blocking_region &) = delete;
+		blocking_region & operator=(const blocking_region &) = delete;
+
+	private:
+		kernel_run_pool * pool;
+	};
+
+private:
+	void run_worker();
+
+	// starts one more kernel if there is room for it, with the mutex held
+	void start_pending_kernel();
+
+	void begin_blocking();
+	void end_blocking();
+
+	std::mutex mutex;
+	std::condition_variable condition;
+	std::deque<std::packaged_task<void()>> pending;
+	std::vector<BlazingThread> threads;
+	std::size_t max_running_kernels;
+	std::size_t running_kernels = 0; // that are not waiting
+	std::size_t idle_threads = 0; // that are not running any kernel
+	bool stopping = false;
+
+	static thread_local kernel_run_pool * current_pool;
+};
+
+/**
+* A condition variable whose waits are blocking regions of the kernel_run_pool, for the waits of the kernels for their
+* caches and tasks.
+*/
+class blocking_condition_variable {
+public:
+	void notify_one() noexcept { condition.notify_one(); }
+	void notify_all() noexcept { condition.notify_all(); }
+
+	template <class Predicate>
+	void wait(std::unique_lock<std::mutex> & lock, Predicate pred) {
+		if (pred()) {
+			return;
+		}
+		kernel_run_pool::blocking_region blocking;
+		condition.wait(lock, pred);
+	}
+
+	template <class Rep, class Period, class Predicate>
+	bool wait_for(std::unique_lock<std::mutex> & lock, const std::chrono::duration<Rep, Period> & timeout, Predicate pred) {
+		if (pred()) {
+			return true;
+		}
+		kernel_run_pool::blocking_region blocking;
+		return condition.wait_for(lock, timeout, pred);
+	}
+
+private:
+	std::condition_variable condition;
+};
+
+} // namespace execution
+} // namespace ral
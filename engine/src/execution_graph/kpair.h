@@ -11,7 +11,9 @@ namespace cache {
 /// `CONCATENATING` is used to identify a ConcatenatingCacheMachine class.
 /// `FOR_EACH` is used to identify a graph execution with kernels that need to send many partitions at once,
 /// for example for kernels PartitionSingleNodeKernel and MergeStreamKernel.
-enum class CacheType {SIMPLE, CONCATENATING, FOR_EACH };
+/// `DIRECT` is a `SIMPLE` cache that hands off the tables to the consumer kernel without logging every batch,
+/// graph::add_edge uses it instead of `SIMPLE` when ENABLE_DIRECT_CACHE_EDGES is set.
+enum class CacheType {SIMPLE, CONCATENATING, FOR_EACH, DIRECT };
 
 /// \brief An object that  represent a cache machine configuration (type and num_partitions)
 /// used in create_cache_machine and create_cache_machine functions.
@@ -22,6 +24,7 @@ struct cache_settings {
 	std::size_t concat_cache_num_bytes = 400000000;  ///< Applicable only for concatenating caches
 	int num_bytes_timeout = 100;  ///< Applicable only for concatenating caches
 	bool concat_all = false; ///< Applicable only for concatenating caches
+	std::shared_ptr<kernel_throughput> consumer_throughput; ///< Applicable only for concatenating caches. If set, it adapts how much data is concatenated
 	bool log_timeout = true;
 	int cache_level_override = -1;
 	bool is_array_access = false; // is it a cache designated for array access	
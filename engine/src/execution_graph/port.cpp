@@ -55,6 +55,12 @@ bool port::is_finished(const std::string & port_name){
 	return it->second->is_finished();
 }
 
+void port::clear(){
+	for (auto cache : cache_machines_){
+		cache.second->clear();
+	}
+}
+
 uint64_t port::total_bytes_added(){
 	uint64_t total = 0;
 	for (auto cache : cache_machines_){
@@ -79,6 +85,14 @@ uint64_t port::total_batches_added(){
 	return total;
 }
 
+uint64_t port::total_bytes_spilled(){
+	uint64_t total = 0;
+	for (auto cache : cache_machines_){
+		total += cache.second->get_num_bytes_spilled();
+	}
+	return total;
+}
+
 uint64_t port::get_num_rows_added(const std::string & port_name){
 	if(port_name.length() == 0) {
 		// NOTE: id is the `default` cache_machine name
@@ -69,6 +69,9 @@ public:
 
 	void finish();
 
+	// finishes all the caches and drops their data, see CacheMachine::clear
+	void clear();
+
 	std::shared_ptr<CacheMachine> & operator[](const std::string & port_name) { return cache_machines_[port_name]; }
 
 	bool all_finished();
@@ -81,6 +84,8 @@ public:
 
 	uint64_t total_batches_added();
 
+	uint64_t total_bytes_spilled();
+
 	uint64_t get_num_rows_added(const std::string & port_name);
 
 
@@ -0,0 +1,50 @@
+#include "resource_group.h"
+
+namespace ral {
+namespace execution {
+
+resource_group::resource_group(const std::string & name, std::size_t memory_limit, int max_threads) :
+	name(name), memory_limit(memory_limit), max_threads(max_threads > 0 ? max_threads : 1) {}
+
+bool resource_group::can_run(std::size_t memory_needed) const {
+	if (active_tasks.load() == 0) {
+		return true;
+	}
+	return active_tasks.load() < max_threads && memory_used.load() + memory_needed <= memory_limit;
+}
+
+void resource_group::task_started(std::size_t memory_needed) {
+	active_tasks++;
+	memory_used += memory_needed;
+}
+
+void resource_group::task_finished(std::size_t memory_needed) {
+	active_tasks--;
+	memory_used -= memory_needed;
+}
+
+void resource_group::set_query_cache_bytes(int32_t query_id, std::size_t bytes) {
+	std::lock_guard<std::mutex> lock(cache_bytes_mutex);
+	query_cache_bytes[query_id] = bytes;
+}
+
+void resource_group::remove_query(int32_t query_id) {
+	std::lock_guard<std::mutex> lock(cache_bytes_mutex);
+	query_cache_bytes.erase(query_id);
+}
+
+std::size_t resource_group::get_memory_used() {
+	std::size_t total = memory_used.load();
+	std::lock_guard<std::mutex> lock(cache_bytes_mutex);
+	for (auto & query_bytes : query_cache_bytes) {
+		total += query_bytes.second;
+	}
+	return total;
+}
+
+bool resource_group::is_over_budget() {
+	return get_memory_used() > memory_limit;
+}
+
+} // namespace execution
+} // namespace ral
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace ral {
+namespace execution {
+
+/**
+* A named group of queries that share a budget of GPU memory and of executor threads.
+* Queries are assigned to a group with the RESOURCE_GROUP config option, so that for example "interactive" queries
+* are not starved by big "batch" queries that run at the same time.
+* The memory used by a group is the memory that the executor estimated for the tasks of the group that are running, plus
+* the GPU memory held in the caches of the queries of the group, as reported by their MemoryMonitors.
+*/
+class resource_group {
+public:
+	/**
+	* Constructor
+	* @param name the name of the group.
+	* @param memory_limit the memory in bytes that the running tasks of this group can use.
+	* @param max_threads the maximum number of tasks of this group that can run concurrently.
+	*/
+	resource_group(const std::string & name, std::size_t memory_limit, int max_threads);
+
+	/**
+	* Indicates if a task of this group that needs a certain amount of memory can start now.
+	* A task can always start if there are no tasks of this group running, so that every group makes progress.
+	* @param memory_needed the memory that the task is estimated to need.
+	*/
+	bool can_run(std::size_t memory_needed) const;
+
+	/**
+	* Accounts for a task of this group that starts running.
+	* @param memory_needed the memory that the task is estimated to need.
+	*/
+	void task_started(std::size_t memory_needed);
+
+	/**
+	* Accounts for a task of this group that finished running.
+	* @param memory_needed the memory that the task was estimated to need when it started.
+	*/
+	void task_finished(std::size_t memory_needed);
+
+	/**
+	* Sets the GPU memory held in the caches of a query of this group.
+	* @param query_id the context token of the query.
+	* @param bytes the bytes of GPU CacheData in the caches of the query.
+	*/
+	void set_query_cache_bytes(int32_t query_id, std::size_t bytes);
+
+	/**
+	* Stops accounting for the caches of a query that finished.
+	* @param query_id the context token of the query.
+	*/
+	void remove_query(int32_t query_id);
+
+	/**
+	* Indicates if this group uses more memory than its memory limit.
+	*/
+	bool is_over_budget();
+
+	/**
+	* Get the memory used by the running tasks and the caches of this group.
+	*/
+	std::size_t get_memory_used();
+
+	const std::string & get_name() const { return name; }
+	std::size_t get_memory_limit() const { return memory_limit; }
+	int get_max_threads() const { return max_threads; }
+	int get_active_tasks() const { return active_tasks.load(); }
+
+private:
+	std::string name;
+	std::size_t memory_limit;
+	int max_threads;
+	std::atomic<std::size_t> memory_used{0}; /**< Sum of the memory estimated for the running tasks of this group. */
+	std::atomic<int> active_tasks{0}; /**< Number of tasks of this group that are running. */
+	std::mutex cache_bytes_mutex;
+	std::map<int32_t, std::size_t> query_cache_bytes; /**< GPU memory held in the caches of every query of this group. */
+};
+
+} // namespace execution
+} // namespace ral
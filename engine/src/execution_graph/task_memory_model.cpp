@@ -0,0 +1,58 @@
+#include "task_memory_model.h"
+#include <algorithm>
+
+namespace ral {
+namespace execution {
+
+namespace {
+const double GROWTH_WEIGHT = 0.5; // weight of a sample that is bigger than the current estimate
+const double SHRINK_WEIGHT = 0.1; // weight of a sample that is smaller than the current estimate
+const double FAILURE_GROWTH_FACTOR = 2.0;
+}
+
+task_memory_model::task_memory_model(std::size_t min_samples) : min_samples(min_samples) {}
+
+std::size_t task_memory_model::size_bucket(std::size_t input_bytes) {
+	std::size_t bucket = 0;
+	while (input_bytes > 1) {
+		input_bytes >>= 1;
+		bucket++;
+	}
+	return bucket;
+}
+
+void task_memory_model::record(ral::cache::kernel_type type, std::size_t input_bytes, std::size_t peak_bytes) {
+	double ratio = (double)peak_bytes / (double)std::max<std::size_t>(input_bytes, 1);
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	estimate & current = estimates[std::make_pair(type, size_bucket(input_bytes))];
+	if (current.num_samples == 0) {
+		current.peak_ratio = ratio;
+	} else {
+		double weight = ratio > current.peak_ratio ? GROWTH_WEIGHT : SHRINK_WEIGHT;
+		current.peak_ratio += weight * (ratio - current.peak_ratio);
+	}
+	current.num_samples++;
+}
+
+void task_memory_model::record_failure(ral::cache::kernel_type type, std::size_t input_bytes, std::size_t peak_bytes) {
+	double ratio = (double)peak_bytes / (double)std::max<std::size_t>(input_bytes, 1);
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	estimate & current = estimates[std::make_pair(type, size_bucket(input_bytes))];
+	// we know the task needed more than what it had when it failed, the prediction is used right away
+	current.peak_ratio = FAILURE_GROWTH_FACTOR * std::max(current.peak_ratio, ratio);
+	current.num_samples = std::max(current.num_samples + 1, min_samples);
+}
+
+std::pair<bool, std::size_t> task_memory_model::predict(ral::cache::kernel_type type, std::size_t input_bytes) {
+	std::lock_guard<std::mutex> lock(mutex_);
+	auto it = estimates.find(std::make_pair(type, size_bucket(input_bytes)));
+	if (it == estimates.end() || it->second.num_samples < min_samples || it->second.peak_ratio <= 0) {
+		return std::make_pair(false, 0);
+	}
+	return std::make_pair(true, (std::size_t)(it->second.peak_ratio * (double)std::max<std::size_t>(input_bytes, 1)));
+}
+
+} // namespace execution
+} // namespace ral
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <utility>
+#include "execution_kernels/kernel_type.h"
+
+namespace ral {
+namespace execution {
+
+/**
+* A model of the peak GPU memory that the tasks of each type of kernel need.
+* It learns from the actual peak memory used by the tasks that ran, keyed by the kernel type and the size of
+* the inputs of the task (rounded to a power of two). For every key it keeps an estimate of the ratio between
+* the peak memory used and the input bytes. The estimate grows fast and shrinks slowly, since running out of
+* memory is much more expensive than waiting a little bit more to start a task.
+*/
+class task_memory_model {
+public:
+	/**
+	* Constructor
+	* @param min_samples the number of tasks of a given key that need to have run before predictions are made for that key.
+	*/
+	task_memory_model(std::size_t min_samples = 3);
+
+	/**
+	* Records the peak memory used by a task that ran successfully.
+	* @param type the type of the kernel of the task.
+	* @param input_bytes the size in bytes of the inputs of the task.
+	* @param peak_bytes the peak memory that the task used.
+	*/
+	void record(ral::cache::kernel_type type, std::size_t input_bytes, std::size_t peak_bytes);
+
+	/**
+	* Records that a task ran out of memory, so that the next tasks like it get a bigger estimate.
+	* @param type the type of the kernel of the task.
+	* @param input_bytes the size in bytes of the inputs of the task.
+	* @param peak_bytes the memory that the task had used when it ran out of memory.
+	*/
+	void record_failure(ral::cache::kernel_type type, std::size_t input_bytes, std::size_t peak_bytes);
+
+	/**
+	* Predicts the peak memory that a task will need.
+	* @param type the type of the kernel of the task.
+	* @param input_bytes the size in bytes of the inputs of the task.
+	* @return a pair where the first value indicates if there is a prediction and the second one is the predicted amount of bytes.
+	*/
+	std::pair<bool, std::size_t> predict(ral::cache::kernel_type type, std::size_t input_bytes);
+
+private:
+	struct estimate {
+		double peak_ratio = 0; /**< Estimate of the peak bytes used per input byte. */
+		std::size_t num_samples = 0; /**< Number of tasks that contributed to this estimate. */
+	};
+
+	static std::size_t size_bucket(std::size_t input_bytes);
+
+	std::size_t min_samples;
+	std::mutex mutex_;
+	std::map<std::pair<ral::cache::kernel_type, std::size_t>, estimate> estimates;
+};
+
+} // namespace execution
+} // namespace ral
@@ -0,0 +1,283 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace ral {
+namespace execution {
+
+/**
+* A priority aware queue made of one deque per worker where idle workers steal from the others.
+* Every worker owns a set of buckets ordered by priority (the smallest priority value is the most urgent),
+* and each bucket is kept in FIFO order. Producers that are not workers spread their items round robin across
+* all the workers, while workers that produce an item (i.e. a task that is retried) keep it in their own deque.
+* A worker always takes its most urgent item first, and only when its own deque is empty it tries to steal
+* the most urgent item from the back of another worker's deque. This replaces the single mutex of a global
+* queue for a mutex per worker.
+*/
+template <typename item_ptr, typename priority_type>
+class work_stealing_queue {
+public:
+
+	/**
+	* Constructor
+	* @param num_workers the number of workers that will pop from this queue. Each one gets its own deque.
+	* @param timeout period in ms after which a waiting worker wakes up to check if it should stop waiting.
+	*/
+	work_stealing_queue(std::size_t num_workers, int timeout = 100) :
+		worker_deques(num_workers > 0 ? num_workers : 1), timeout(timeout) {}
+
+	~work_stealing_queue() = default;
+
+	work_stealing_queue(work_stealing_queue &&) = delete;
+	work_stealing_queue(const work_stealing_queue &) = delete;
+	work_stealing_queue & operator=(work_stealing_queue &&) = delete;
+	work_stealing_queue & operator=(const work_stealing_queue &) = delete;
+
+	/**
+	* Registers the calling thread as the worker with index worker_id, so that the items it puts go to its own deque.
+	* @param worker_id index of the worker. Must be smaller than the number of workers.
+	*/
+	void register_worker(int worker_id) {
+		current_worker_id() = worker_id;
+	}
+
+	/**
+	* Put an item onto the queue.
+	* If the calling thread is a registered worker, the item goes to its own deque, otherwise it is assigned round robin.
+	* @param item the item being added.
+	* @param priority the priority of the item. Items with smaller priorities are popped first.
+	*/
+	void put(item_ptr item, const priority_type & priority) {
+		std::size_t index = current_worker_id() >= 0 && static_cast<std::size_t>(current_worker_id()) < worker_deques.size() ?
+			current_worker_id() : next_worker.fetch_add(1, std::memory_order_relaxed) % worker_deques.size();
+		{
+			std::lock_guard<std::mutex> lock(worker_deques[index].mutex_);
+			worker_deques[index].buckets[priority].emplace_back(std::move(item));
+		}
+		num_items.fetch_add(1);
+
+		if (num_idle.load() > 0) {
+			std::lock_guard<std::mutex> lock(idle_mutex_);
+			idle_condition_variable_.notify_one();
+		}
+	}
+
+	/**
+	* Put an item back at the front of the items with its priority of a worker's deque, so that it is the next one
+	* of its priority that the worker pops.
+	* @param item the item being added.
+	* @param priority the priority of the item.
+	* @param worker_id index of the worker whose deque the item goes to.
+	*/
+	void put_front(item_ptr item, const priority_type & priority, int worker_id) {
+		std::size_t index = static_cast<std::size_t>(worker_id) % worker_deques.size();
+		{
+			std::lock_guard<std::mutex> lock(worker_deques[index].mutex_);
+			worker_deques[index].buckets[priority].emplace_front(std::move(item));
+		}
+		num_items.fetch_add(1);
+
+		if (num_idle.load() > 0) {
+			std::lock_guard<std::mutex> lock(idle_mutex_);
+			idle_condition_variable_.notify_one();
+		}
+	}
+
+	/**
+	* Get the most urgent item available for a worker, stealing from other workers if its deque is empty.
+	* If there is nothing to pop it waits until something is put, the queue is finished or the timeout expires.
+	* @param worker_id index of the worker that pops.
+	* @return the popped item or nullptr if there was nothing to pop before the timeout or the queue is finished.
+	*/
+	item_ptr pop_or_wait(int worker_id) {
+		item_ptr item = try_pop(worker_id);
+		if (item != nullptr) {
+			return item;
+		}
+
+		std::unique_lock<std::mutex> lock(idle_mutex_);
+		num_idle.fetch_add(1);
+		idle_condition_variable_.wait_for(lock, timeout * std::chrono::milliseconds(1), [this] {
+			return this->num_items.load() > 0 || this->finished.load();
+		});
+		num_idle.fetch_sub(1);
+		lock.unlock();
+
+		return try_pop(worker_id);
+	}
+
+	/**
+	* Get the most urgent item available for a worker without waiting.
+	* @param worker_id index of the worker that pops.
+	* @return the popped item or nullptr if all the deques are empty.
+	*/
+	item_ptr try_pop(int worker_id) {
+		if (num_items.load() == 0) {
+			return nullptr;
+		}
+		std::size_t own_index = static_cast<std::size_t>(worker_id) % worker_deques.size();
+		item_ptr item = pop_from(own_index, true);
+		for (std::size_t i = 1; item == nullptr && i < worker_deques.size(); i++) {
+			item = pop_from((own_index + i) % worker_deques.size(), false);
+		}
+		return item;
+	}
+
+	/**
+	* Get the least urgent and most recently added item of the whole queue.
+	* This is used when we want to take items that will not be operated on immediately.
+	* @return the least urgent item or nullptr if the queue is empty.
+	*/
+	item_ptr pop_back() {
+		item_ptr item = nullptr;
+		std::size_t victim_index = 0;
+		bool found = false;
+		priority_type least_urgent{};
+		for (std::size_t i = 0; i < worker_deques.size(); i++) {
+			std::lock_guard<std::mutex> lock(worker_deques[i].mutex_);
+			if (!worker_deques[i].buckets.empty()) {
+				auto & candidate = worker_deques[i].buckets.rbegin()->first;
+				if (!found || least_urgent < candidate) {
+					least_urgent = candidate;
+					victim_index = i;
+					found = true;
+				}
+			}
+		}
+		if (found) {
+			std::lock_guard<std::mutex> lock(worker_deques[victim_index].mutex_);
+			auto & buckets = worker_deques[victim_index].buckets;
+			if (!buckets.empty()) {
+				auto bucket = std::prev(buckets.end());
+				item = std::move(bucket->second.back());
+				bucket->second.pop_back();
+				if (bucket->second.empty()) {
+					buckets.erase(bucket);
+				}
+				num_items.fetch_sub(1);
+			}
+		}
+		return item;
+	}
+
+	/**
+	* Removes the items of all the deques that match a predicate.
+	* @param pred the predicate, called with each item while the deque of the item is locked.
+	* @return the removed items.
+	*/
+	template <typename Predicate>
+	std::vector<item_ptr> remove_if(Predicate pred) {
+		std::vector<item_ptr> removed;
+		for (auto & worker_deque : worker_deques) {
+			std::lock_guard<std::mutex> lock(worker_deque.mutex_);
+			for (auto bucket = worker_deque.buckets.begin(); bucket != worker_deque.buckets.end();) {
+				auto & items = bucket->second;
+				for (auto it = items.begin(); it != items.end();) {
+					if (pred(*it)) {
+						removed.push_back(std::move(*it));
+						it = items.erase(it);
+						num_items.fetch_sub(1);
+					} else {
+						++it;
+					}
+				}
+				bucket = items.empty() ? worker_deque.buckets.erase(bucket) : std::next(bucket);
+			}
+		}
+		return removed;
+	}
+
+	/**
+	* Lets the waiting workers know that no more items will be put.
+	*/
+	void finish() {
+		std::lock_guard<std::mutex> lock(idle_mutex_);
+		finished = true;
+		idle_condition_variable_.notify_all();
+	}
+
+	/**
+	* Lets us know if the queue was finished.
+	*/
+	bool is_finished() {
+		return finished.load();
+	}
+
+	/**
+	* Get the number of items in all the deques at this point in time.
+	*/
+	std::size_t size() {
+		return num_items.load();
+	}
+
+	/**
+	* Get the number of workers that are waiting for items at this point in time.
+	*/
+	int num_idle_workers() {
+		return num_idle.load();
+	}
+
+	/**
+	* Get the number of workers (deques) of this queue.
+	*/
+	std::size_t num_workers() const {
+		return worker_deques.size();
+	}
+
+private:
+	struct worker_deque {
+		std::mutex mutex_; /**< Protects the buckets of a single worker. */
+		std::map<priority_type, std::deque<item_ptr>> buckets; /**< Items of this worker grouped by priority, each group in FIFO order. */
+	};
+
+	/**
+	* Pop the most urgent item of a worker's deque.
+	* @param index the worker whose deque we are popping from.
+	* @param owner whether the caller is the owner of the deque. The owner pops from the front of the bucket, thieves from the back.
+	*/
+	item_ptr pop_from(std::size_t index, bool owner) {
+		std::lock_guard<std::mutex> lock(worker_deques[index].mutex_);
+		auto & buckets = worker_deques[index].buckets;
+		if (buckets.empty()) {
+			return nullptr;
+		}
+		auto bucket = buckets.begin();
+		item_ptr item;
+		if (owner) {
+			item = std::move(bucket->second.front());
+			bucket->second.pop_front();
+		} else {
+			item = std::move(bucket->second.back());
+			bucket->second.pop_back();
+		}
+		if (bucket->second.empty()) {
+			buckets.erase(bucket);
+		}
+		num_items.fetch_sub(1);
+		return item;
+	}
+
+	static int & current_worker_id() {
+		static thread_local int worker_id = -1;
+		return worker_id;
+	}
+
+	std::vector<worker_deque> worker_deques; /**< One deque per worker. */
+	std::atomic<std::size_t> next_worker{0}; /**< Used to assign round robin the items put by threads that are not workers. */
+	std::atomic<std::size_t> num_items{0}; /**< Total number of items in all the deques. */
+	std::atomic<int> num_idle{0}; /**< Number of workers that are waiting for items. */
+	std::atomic<bool> finished{false}; /**< Indicates if this queue is finished. */
+	std::mutex idle_mutex_; /**< Only used to let idle workers wait for new items. */
+	std::condition_variable idle_condition_variable_;
+	int timeout; /**< timeout period in ms used by pop_or_wait. */
+};
+
+} // namespace execution
+} // namespace ral
@@ -1,7 +1,16 @@
 #include "BatchAggregationProcessing.h"
 #include "execution_graph/executor.h"
 #include "utilities/CommonOperations.h"
+#include "parser/CalciteExpressionParsing.h"
+#include "blazing_table/BlazingColumnOwner.h"
+#include <cudf/column/column_factories.hpp>
+#include <cudf/scalar/scalar_factories.hpp>
+#include <cudf/copying.hpp>
 #include <cudf/partitioning.hpp>
+#include <cudf/io/parquet.hpp>
+#include <cudf/unary.hpp>
+#include <cudf/utilities/traits.hpp>
+#include <numeric>
 
 namespace ral {
 namespace batch {
@@ -11,6 +20,111 @@ namespace batch {
 ComputeAggregateKernel::ComputeAggregateKernel(std::size_t kernel_id, const std::string & queryString, std::shared_ptr<Context> context, std::shared_ptr<ral::cache::graph> query_graph)
     : kernel{kernel_id, queryString, context, kernel_type::ComputeAggregateKernel} {
     this->query_graph = query_graph;
+
+    const blazingdb::manager::QueryConfig & config = context->getConfig();
+    this->bypass_ratio = config.aggregation_bypass_ratio.value_or(0.9);
+    this->accumulate_bytes = config.aggregation_accumulate_bytes.value_or(
+        ral::execution::executor::get_instance()->get_processing_memory_limit() / 8);
+}
+
+void ComputeAggregateKernel::sample_reduction(std::size_t input_rows, const ral::frame::BlazingTable & aggregated) {
+    std::lock_guard<std::mutex> lock(mode_mutex);
+    if (this->mode != aggregation_mode::SAMPLING) {
+        return;
+    }
+    if (this->output_names.empty()) {
+        this->output_names = aggregated.names();
+        this->output_types = aggregated.get_schema();
+    }
+    this->sampled_batches++;
+    this->sampled_input_rows += input_rows;
+    this->sampled_output_rows += aggregated.num_rows();
+    if (this->sampled_batches < num_sample_batches) {
+        return;
+    }
+
+    double ratio = this->sampled_input_rows == 0 ? 0.0 : static_cast<double>(this->sampled_output_rows) / this->sampled_input_rows;
+    bool can_bypass = this->aggregation_types.empty() || ral::operators::can_compute_aggregations_per_row(this->aggregation_types);
+    if (this->bypass_ratio > 0 && ratio >= this->bypass_ratio && can_bypass) {
+        this->mode = aggregation_mode::BYPASS;
+    } else if (this->accumulate_bytes > 0 && ratio <= accumulate_ratio) {
+        this->mode = aggregation_mode::ACCUMULATE;
+    } else {
+        this->mode = aggregation_mode::AGGREGATE;
+    }
+
+    if(logger) {
+        logger->debug("{query_id}|{step}|{substep}|{info}|{duration}|kernel_id|{kernel_id}||",
+                                "query_id"_a=context->getContextToken(),
+                                "step"_a=context->getQueryStep(),
+                                "substep"_a=context->getQuerySubstep(),
+                                "info"_a="ComputeAggregate reduced its first batches to " + std::to_string(ratio) + " of their rows, " +
+                                    (this->mode == aggregation_mode::BYPASS ? "bypassing the aggregation" :
+                                    this->mode == aggregation_mode::ACCUMULATE ? "accumulating the aggregations" : "aggregating every batch"),
+                                "duration"_a="",
+                                "kernel_id"_a=this->get_id());
+    }
+}
+
+std::unique_ptr<ral::frame::BlazingTable> ComputeAggregateKernel::merge_aggregations(std::vector<std::unique_ptr<ral::frame::BlazingTable>> & aggregated) {
+    std::vector<ral::frame::BlazingTableView> tables_to_merge;
+    for (auto & table : aggregated) {
+        tables_to_merge.push_back(table->toBlazingTableView());
+    }
+    std::unique_ptr<ral::frame::BlazingTable> concatenated = ral::utilities::concatTables(tables_to_merge);
+
+    std::vector<int> mod_group_column_indices;
+    std::vector<std::string> mod_aggregation_input_expressions, mod_aggregation_column_assigned_aliases;
+    std::vector<AggregateKind> mod_aggregation_types;
+    std::tie(mod_group_column_indices, mod_aggregation_input_expressions, mod_aggregation_types,
+        mod_aggregation_column_assigned_aliases) = ral::operators::modGroupByParametersPostComputeAggregations(
+        this->group_column_indices, this->aggregation_types, concatenated->names());
+
+    if(this->aggregation_types.size() == 0) {
+        return ral::operators::compute_groupby_without_aggregations(concatenated->toBlazingTableView(), mod_group_column_indices);
+    }
+    if(ral::operators::has_distinct_aggregations(this->aggregation_types)) {
+        return ral::operators::compute_partial_aggregations_with_distinct(concatenated->toBlazingTableView(), mod_aggregation_input_expressions,
+            mod_aggregation_types, mod_aggregation_column_assigned_aliases, mod_group_column_indices);
+    }
+    return ral::operators::compute_aggregations_with_groupby(concatenated->toBlazingTableView(), mod_aggregation_input_expressions,
+        mod_aggregation_types, mod_aggregation_column_assigned_aliases, mod_group_column_indices);
+}
+
+void ComputeAggregateKernel::accumulate(std::unique_ptr<ral::frame::BlazingTable> aggregated) {
+    std::vector<std::unique_ptr<ral::frame::BlazingTable>> to_merge;
+    {
+        std::lock_guard<std::mutex> lock(accumulated_mutex);
+        this->accumulated_bytes += aggregated->sizeInBytes();
+        this->accumulated.push_back(std::move(aggregated));
+        if (this->accumulated_bytes < this->accumulate_bytes) {
+            return;
+        }
+        to_merge = std::move(this->accumulated);
+        this->accumulated.clear();
+        this->accumulated_bytes = 0;
+    }
+
+    std::unique_ptr<ral::frame::BlazingTable> merged;
+    try {
+        merged = merge_aggregations(to_merge);
+    } catch(const rmm::bad_alloc &) {
+        // the accumulated aggregations are already out of the retried input, so they are output as they are
+        for (auto & table : to_merge) {
+            this->output_cache()->addToCache(std::move(table));
+        }
+        return;
+    }
+
+    std::size_t merged_bytes = merged->sizeInBytes();
+    if (merged_bytes > this->accumulate_bytes / 2) {
+        // the groups hardly got fewer, merging them with the next batches again would not pay off
+        this->output_cache()->addToCache(std::move(merged));
+    } else {
+        std::lock_guard<std::mutex> lock(accumulated_mutex);
+        this->accumulated_bytes += merged_bytes;
+        this->accumulated.push_back(std::move(merged));
+    }
 }
 
 ral::execution::task_result ComputeAggregateKernel::do_process(std::vector< std::unique_ptr<ral::frame::BlazingTable> > inputs,
@@ -19,18 +133,55 @@ ral::execution::task_result ComputeAggregateKernel::do_process(std::vector< std:
 
     try{
         auto & input = inputs[0];
+        if (this->aggregation_pushed_down) {
+            output->addToCache(std::move(input));
+            return {ral::execution::task_status::SUCCESS, std::string(), std::vector< std::unique_ptr<ral::frame::BlazingTable> > ()};
+        }
+        aggregation_mode current_mode = this->group_column_indices.size() == 0 ? aggregation_mode::AGGREGATE : this->mode.load();
+        if (current_mode == aggregation_mode::BYPASS) {
+            if (this->aggregation_types.size() == 0) {
+                // the distinct rows of the batch would be about all of them, so its group columns are output as they are
+                std::vector<std::string> group_names;
+                for (int index : this->group_column_indices) {
+                    group_names.push_back(input->names()[index]);
+                }
+                output->addToCache(ral::frame::BlazingTableView(input->view().select(this->group_column_indices), group_names).clone());
+            } else {
+                output->addToCache(ral::operators::compute_aggregations_per_row(input->toBlazingTableView(), aggregation_input_expressions,
+                    this->aggregation_types, this->group_column_indices, this->output_names, this->output_types));
+            }
+            return {ral::execution::task_status::SUCCESS, std::string(), std::vector< std::unique_ptr<ral::frame::BlazingTable> > ()};
+        }
+
         std::unique_ptr<ral::frame::BlazingTable> columns;
         if(this->aggregation_types.size() == 0) {
             columns = ral::operators::compute_groupby_without_aggregations(
                     input->toBlazingTableView(), this->group_column_indices);
+        } else if (ral::operators::has_distinct_aggregations(this->aggregation_types)) {
+            columns = ral::operators::compute_partial_aggregations_with_distinct(
+                input->toBlazingTableView(), aggregation_input_expressions, this->aggregation_types, aggregation_column_assigned_aliases, group_column_indices);
         } else if (this->group_column_indices.size() == 0) {
             columns = ral::operators::compute_aggregations_without_groupby(
                     input->toBlazingTableView(), aggregation_input_expressions, this->aggregation_types, aggregation_column_assigned_aliases);
         } else {
+            // the batches that are sorted by the group columns are aggregated group after group, without a hash table
+            bool keys_are_sorted = this->check_sorted && ral::operators::are_groups_sorted(input->toBlazingTableView(), group_column_indices);
+            if (!keys_are_sorted) {
+                this->check_sorted = false;
+            }
             columns = ral::operators::compute_aggregations_with_groupby(
-                input->toBlazingTableView(), aggregation_input_expressions, this->aggregation_types, aggregation_column_assigned_aliases, group_column_indices);
+                input->toBlazingTableView(), aggregation_input_expressions, this->aggregation_types, aggregation_column_assigned_aliases,
+                group_column_indices, keys_are_sorted);
+        }
+
+        if (current_mode == aggregation_mode::SAMPLING) {
+            sample_reduction(input->num_rows(), *columns);
+        }
+        if (current_mode == aggregation_mode::ACCUMULATE) {
+            accumulate(std::move(columns));
+        } else {
+            output->addToCache(std::move(columns));
         }
-        output->addToCache(std::move(columns));
     }catch(const rmm::bad_alloc& e){
         return {ral::execution::task_status::RETRY, std::string(e.what()), std::move(inputs)};
     }catch(const std::exception& e){
@@ -80,6 +231,21 @@ kstatus ComputeAggregateKernel::run() {
         std::rethrow_exception(ep);
     }
 
+    // the aggregations that are still accumulated are merged downstream with the rest
+    for (auto & table : this->accumulated) {
+        this->add_to_output_cache(std::move(table));
+    }
+    this->accumulated.clear();
+
+    if (this->metadata_aggregation) {
+        for (auto & table : this->metadata_aggregation->release_partial_aggregations()) {
+            if (this->output_names.size() == static_cast<std::size_t>(table->num_columns())) {
+                table->setNames(this->output_names);
+            }
+            this->add_to_output_cache(std::move(table));
+        }
+    }
+
     if(logger) {
         logger->debug("{query_id}|{step}|{substep}|{info}|{duration}|kernel_id|{kernel_id}||",
                     "query_id"_a=context->getContextToken(),
@@ -126,10 +292,6 @@ ral::execution::task_result DistributeAggregateKernel::do_process(std::vector< s
     cudaStream_t /*stream*/, const std::map<std::string, std::string>& /*args*/) {
     auto & input = inputs[0];
 
-    // num_partitions = context->getTotalNodes() will do for now, but may want a function to determine this in the future.
-    // If we do partition into something other than the number of nodes, then we have to use part_ids and change up more of the logic
-    int num_partitions = this->context->getTotalNodes();
-
     // If its an aggregation without group by we want to send all the results to the master node
     auto& self_node = ral::communication::CommunicationData::getInstance().getSelfNode();
     if (group_column_indices.size() == 0) {
@@ -164,32 +326,42 @@ ral::execution::task_result DistributeAggregateKernel::do_process(std::vector< s
     } else {
 
         try{
-            CudfTableView batch_view = input->view();
-            std::vector<CudfTableView> partitioned;
-            std::unique_ptr<CudfTable> hashed_data; // Keep table alive in this scope
-            if (batch_view.num_rows() > 0) {
-                std::vector<cudf::size_type> hashed_data_offsets;
-                std::tie(hashed_data, hashed_data_offsets) = cudf::hash_partition(input->view(), columns_to_hash, num_partitions);
-                // the offsets returned by hash_partition will always start at 0, which is a value we want to ignore for cudf::split
-                std::vector<cudf::size_type> split_indexes(hashed_data_offsets.begin() + 1, hashed_data_offsets.end());
-                partitioned = cudf::split(hashed_data->view(), split_indexes);
-            } else {
-                //  copy empty view
-                for (auto i = 0; i < num_partitions; i++) {
-                    partitioned.push_back(batch_view);
+            if (this->normalize_hashed_keys) {
+                // the rows are hashed by copies of their keys in the widest type of their kind, which are not sent
+                std::vector<std::unique_ptr<cudf::column>> hashed_keys;
+                std::vector<CudfColumnView> columns(input->view().begin(), input->view().end());
+                std::vector<cudf::size_type> normalized_columns_to_hash;
+                for (cudf::size_type column_index : columns_to_hash) {
+                    CudfColumnView key = input->view().column(column_index);
+                    cudf::data_type hashed_type = key.type();
+                    if (cudf::is_numeric(key.type())) {
+                        hashed_type = cudf::data_type(cudf::type_id::FLOAT64);
+                    } else if (cudf::is_timestamp(key.type())) {
+                        hashed_type = cudf::data_type(cudf::type_id::TIMESTAMP_NANOSECONDS);
+                    }
+                    if (hashed_type == key.type()) {
+                        normalized_columns_to_hash.push_back(column_index);
+                    } else {
+                        hashed_keys.push_back(cudf::cast(key, hashed_type));
+                        columns.push_back(hashed_keys.back()->view());
+                        normalized_columns_to_hash.push_back(columns.size() - 1);
+                    }
                 }
+                std::vector<std::string> names = input->names();
+                names.resize(columns.size());
+                scatter_hash_partitions(ral::frame::BlazingTableView(CudfTableView(columns), names),
+                    normalized_columns_to_hash,
+                    output.get(),
+                    "", //cache_id
+                    0, //message_tracker_idx
+                    input->num_columns());
+            } else {
+                scatter_hash_partitions(input->toBlazingTableView(),
+                    columns_to_hash,
+                    output.get(),
+                    "" //cache_id
+                );
             }
-
-            std::vector<ral::frame::BlazingTableView> partitions;
-            for(auto partition : partitioned) {
-                partitions.push_back(ral::frame::BlazingTableView(partition, input->names()));
-            }
-
-            scatter(partitions,
-                output.get(),
-                "", //message_id_prefix
-                "" //cache_id
-            );
         }catch(const rmm::bad_alloc& e){
             return {ral::execution::task_status::RETRY, std::string(e.what()), std::move(inputs)};
         }catch(const std::exception& e){
@@ -272,13 +444,283 @@ kstatus DistributeAggregateKernel::run() {
 MergeAggregateKernel::MergeAggregateKernel(std::size_t kernel_id, const std::string & queryString, std::shared_ptr<Context> context, std::shared_ptr<ral::cache::graph> query_graph)
     : kernel{kernel_id, queryString, context, kernel_type::MergeAggregateKernel} {
     this->query_graph = query_graph;
+
+    const blazingdb::manager::QueryConfig & config = context->getConfig();
+    this->merge_bytes = config.aggregation_merge_bytes.value_or(
+        ral::execution::executor::get_instance()->get_processing_memory_limit() / 4);
+    this->incremental_state_input = config.incremental_aggregation_state_input.value_or("");
+    this->incremental_state_output = config.incremental_aggregation_state_output.value_or("");
+}
+
+std::unique_ptr<ral::frame::BlazingTable> MergeAggregateKernel::read_incremental_state() {
+    if (this->incremental_state_input.empty()) {
+        return nullptr;
+    }
+    cudf::io::parquet_reader_options options = cudf::io::parquet_reader_options::builder(cudf::io::source_info{this->incremental_state_input});
+    options.enable_use_pandas_metadata(false);
+    cudf::io::table_with_metadata state = cudf::io::read_parquet(options);
+    return std::make_unique<ral::frame::BlazingTable>(std::move(state.tbl), state.metadata.column_names);
+}
+
+void MergeAggregateKernel::write_incremental_state(const ral::frame::BlazingTableView & aggregated) {
+    cudf::io::table_metadata metadata;
+    metadata.column_names = aggregated.names();
+    cudf::io::parquet_writer_options options = cudf::io::parquet_writer_options::builder(
+        cudf::io::sink_info{this->incremental_state_output}, aggregated.view()).metadata(&metadata);
+    cudf::io::write_parquet(options);
+}
+
+void MergeAggregateKernel::add_merge_task(std::vector<std::unique_ptr<ral::cache::CacheData>> inputs, std::shared_ptr<ral::cache::CacheMachine> output) {
+    ral::execution::executor::get_instance()->add_task(
+            std::move(inputs),
+            output,
+            this);
+}
+
+void MergeAggregateKernel::wait_for_tasks() {
+    {
+        std::unique_lock<std::mutex> lock(kernel_mutex);
+        kernel_cv.wait(lock,[this]{
+            return this->tasks.empty() || ral::execution::executor::get_instance()->has_exception();
+        });
+    }
+    if(auto ep = ral::execution::executor::get_instance()->last_exception()){
+        std::rethrow_exception(ep);
+    }
+}
+
+void MergeAggregateKernel::merge_while_receiving(std::unique_ptr<ral::cache::CacheData> first_batch) {
+    ral::cache::cache_settings cache_machine_config;
+    cache_machine_config.type = ral::cache::CacheType::SIMPLE;
+    cache_machine_config.context = context->clone();
+    std::shared_ptr<ral::cache::CacheMachine> merged = ral::cache::create_cache_machine(cache_machine_config, std::to_string(this->get_id()) + "_merged");
+
+    // the batches are packed in groups of merge_bytes, and a batch that is as big as a group is kept as it is
+    std::vector<std::unique_ptr<ral::cache::CacheData>> group;
+    std::size_t group_bytes = 0;
+    auto add_to_group = [this, &group, &group_bytes, &merged](std::unique_ptr<ral::cache::CacheData> cache_data) {
+        std::size_t num_bytes = cache_data->sizeInBytes();
+        if (num_bytes >= this->merge_bytes) {
+            merged->addCacheData(std::move(cache_data));
+            return;
+        }
+        group_bytes += num_bytes;
+        group.push_back(std::move(cache_data));
+        if (group_bytes >= this->merge_bytes) {
+            add_merge_task(std::move(group), merged);
+            group = std::vector<std::unique_ptr<ral::cache::CacheData>>();
+            group_bytes = 0;
+        }
+    };
+    auto merge_last_group = [this, &group, &group_bytes, &merged]() {
+        if (!group.empty()) {
+            add_merge_task(std::move(group), merged);
+            group = std::vector<std::unique_ptr<ral::cache::CacheData>>();
+            group_bytes = 0;
+        }
+    };
+
+    // the batches are merged while the rest of them are still being received, the results go to a cache that spills them
+    std::size_t received_bytes = first_batch->sizeInBytes();
+    add_to_group(std::move(first_batch));
+    while (this->input_cache()->wait_for_next()) {
+        std::unique_ptr<ral::cache::CacheData> cache_data = this->input_cache()->pullCacheData();
+        if (cache_data != nullptr) {
+            received_bytes += cache_data->sizeInBytes();
+            add_to_group(std::move(cache_data));
+        }
+    }
+    merge_last_group();
+    wait_for_tasks();
+
+    // every round merges the results of the last one in groups of merge_bytes, until they all fit in one
+    std::size_t previous_bytes = received_bytes;
+    while (true) {
+        std::vector<std::unique_ptr<ral::cache::CacheData>> partials = merged->pull_all_cache_data();
+        std::size_t total_bytes = 0;
+        for (auto & partial : partials) {
+            total_bytes += partial->sizeInBytes();
+        }
+        if (total_bytes <= this->merge_bytes || partials.size() <= 1) {
+            add_merge_task(std::move(partials), this->output_cache());
+            return;
+        }
+        if (total_bytes > previous_bytes * min_merge_reduction) {
+            // the groups are too many to get any fewer by merging, so each bucket of them is merged on its own
+            merge_hash_partitions(std::move(partials), total_bytes);
+            return;
+        }
+        previous_bytes = total_bytes;
+
+        for (auto & partial : partials) {
+            add_to_group(std::move(partial));
+        }
+        merge_last_group();
+        wait_for_tasks();
+    }
+}
+
+void MergeAggregateKernel::merge_partitions_while_receiving(std::unique_ptr<ral::cache::CacheData> first_batch) {
+    struct partition_merge {
+        std::vector<std::unique_ptr<ral::cache::CacheData>> group;
+        std::size_t group_bytes = 0;
+        std::shared_ptr<ral::cache::CacheMachine> merged;
+    };
+    std::map<std::size_t, partition_merge> partitions;
+
+    ral::cache::cache_settings cache_machine_config;
+    cache_machine_config.type = ral::cache::CacheType::SIMPLE;
+    cache_machine_config.context = context->clone();
+    auto add_to_partition = [this, &partitions, &cache_machine_config](std::unique_ptr<ral::cache::CacheData> cache_data) {
+        const ral::cache::MetadataDictionary & metadata = cache_data->getMetadata();
+        RAL_EXPECTS(metadata.has_value(ral::cache::HASH_PARTITION_METADATA_LABEL), "In MergeAggregateKernel: a batch is not in a hash partition");
+        std::size_t index = std::stoull(metadata.get_value(ral::cache::HASH_PARTITION_METADATA_LABEL));
+        partition_merge & partition = partitions[index];
+        if (partition.merged == nullptr) {
+            std::string cache_name = std::to_string(this->get_id()) + "_merged_partition_" + std::to_string(index);
+            partition.merged = ral::cache::create_cache_machine(cache_machine_config, cache_name);
+        }
+
+        std::size_t num_bytes = cache_data->sizeInBytes();
+        if (num_bytes >= this->merge_bytes) {
+            partition.merged->addCacheData(std::move(cache_data));
+            return;
+        }
+        partition.group_bytes += num_bytes;
+        partition.group.push_back(std::move(cache_data));
+        if (partition.group_bytes >= this->merge_bytes) {
+            add_merge_task(std::move(partition.group), partition.merged);
+            partition.group = std::vector<std::unique_ptr<ral::cache::CacheData>>();
+            partition.group_bytes = 0;
+        }
+    };
+
+    add_to_partition(std::move(first_batch));
+    while (this->input_cache()->wait_for_next()) {
+        std::unique_ptr<ral::cache::CacheData> cache_data = this->input_cache()->pullCacheData();
+        if (cache_data != nullptr) {
+            add_to_partition(std::move(cache_data));
+        }
+    }
+    for (auto & partition : partitions) {
+        if (!partition.second.group.empty()) {
+            add_merge_task(std::move(partition.second.group), partition.second.merged);
+        }
+    }
+    wait_for_tasks();
+
+    for (auto & partition : partitions) {
+        std::vector<std::unique_ptr<ral::cache::CacheData>> inputs = partition.second.merged->pull_all_cache_data();
+        if (!inputs.empty()) {
+            add_merge_task(std::move(inputs), this->output_cache());
+        }
+    }
+}
+
+void MergeAggregateKernel::merge_hash_partitions(std::vector<std::unique_ptr<ral::cache::CacheData>> partials, std::size_t num_bytes) {
+    std::size_t num_partitions = (num_bytes + this->merge_bytes - 1) / this->merge_bytes;
+    num_partitions = std::min(std::max(num_partitions, std::size_t{2}), max_hash_partitions);
+
+    ral::cache::cache_settings cache_machine_config;
+    cache_machine_config.type = ral::cache::CacheType::SIMPLE;
+    cache_machine_config.context = context->clone();
+    for (std::size_t i = 0; i < num_partitions; i++) {
+        std::string cache_name = std::to_string(this->get_id()) + "_hash_partition_" + std::to_string(i);
+        this->hash_partitions.push_back(ral::cache::create_cache_machine(cache_machine_config, cache_name));
+    }
+
+    for (auto & partial : partials) {
+        std::vector<std::unique_ptr<ral::cache::CacheData>> inputs;
+        inputs.push_back(std::move(partial));
+        ral::execution::executor::get_instance()->add_task(
+                std::move(inputs),
+                this->output_cache(),
+                this,
+                {{"operation_type", "hash_partition"}});
+    }
+    wait_for_tasks();
+
+    // the same groups are in the same bucket, so the merge of every bucket is part of the final result
+    for (auto & partition : this->hash_partitions) {
+        std::vector<std::unique_ptr<ral::cache::CacheData>> inputs = partition->pull_all_cache_data();
+        if (!inputs.empty()) {
+            add_merge_task(std::move(inputs), this->output_cache());
+        }
+    }
+}
+
+ral::execution::task_result MergeAggregateKernel::hash_partition_batch(std::vector< std::unique_ptr<ral::frame::BlazingTable> > inputs) {
+    auto & batch = inputs[0];
+    try{
+        if (batch->num_rows() == 0) {
+            return {ral::execution::task_status::SUCCESS, std::string(), std::vector< std::unique_ptr<ral::frame::BlazingTable> > ()};
+        }
+
+        // the group columns go first in the merged aggregations
+        std::vector<cudf::size_type> columns_to_hash(this->num_group_columns);
+        std::iota(columns_to_hash.begin(), columns_to_hash.end(), 0);
+        std::unique_ptr<CudfTable> hashed_data;
+        std::vector<cudf::size_type> hashed_data_offsets;
+        std::tie(hashed_data, hashed_data_offsets) = cudf::hash_partition(batch->view(), columns_to_hash, this->hash_partitions.size());
+
+        // the offsets returned by hash_partition will always start at 0, which is a value we want to ignore for cudf::split
+        std::vector<cudf::size_type> split_indexes(hashed_data_offsets.begin() + 1, hashed_data_offsets.end());
+        std::vector<CudfTableView> partitioned = cudf::split(hashed_data->view(), split_indexes);
+        for (std::size_t i = 0; i < partitioned.size(); i++) {
+            if (partitioned[i].num_rows() > 0) {
+                this->hash_partitions[i]->addToCache(std::make_unique<ral::frame::BlazingTable>(std::make_unique<CudfTable>(partitioned[i]), batch->names()));
+            }
+        }
+    }catch(const rmm::bad_alloc& e){
+        return {ral::execution::task_status::RETRY, std::string(e.what()), std::move(inputs)};
+    }catch(const std::exception& e){
+        return {ral::execution::task_status::FAIL, std::string(e.what()), std::vector< std::unique_ptr<ral::frame::BlazingTable> > ()};
+    }
+    return {ral::execution::task_status::SUCCESS, std::string(), std::vector< std::unique_ptr<ral::frame::BlazingTable> > ()};
 }
 
 ral::execution::task_result MergeAggregateKernel::do_process(std::vector< std::unique_ptr<ral::frame::BlazingTable> > inputs,
     std::shared_ptr<ral::cache::CacheMachine> output,
-    cudaStream_t /*stream*/, const std::map<std::string, std::string>& /*args*/) {
+    cudaStream_t stream, const std::map<std::string, std::string>& args) {
+    auto it = args.find("operation_type");
+    if (it != args.end() && it->second == "hash_partition") {
+        return hash_partition_batch(std::move(inputs));
+    }
+
     try{
-        
+        if (!this->incremental_state_output.empty() && inputs.size() > 1) {
+            // the counts of the state were merged into sums, which can be wider than the counts of the new batches
+            bool strict = false;
+            std::vector<cudf::data_type> common_types = inputs[0]->get_schema();
+            for (std::size_t i = 1; i < inputs.size(); i++){
+                common_types = ral::utilities::get_common_types(common_types, inputs[i]->get_schema(), strict);
+            }
+            for (auto & input : inputs){
+                ral::utilities::normalize_types(input, common_types);
+            }
+        }
+
+        // the merges before the last one can output several partial merges, which the next round merges, so instead of
+        // overflowing the strings length the inputs are merged in the biggest batches that can be concatenated
+        if (output != this->output_cache() && inputs.size() > 1 && ral::utilities::checkIfConcatenatingStringsWillOverflow(inputs)) {
+            std::vector<std::unique_ptr<ral::frame::BlazingTable>> batches = ral::utilities::concatTablesInBatches(inputs);
+            for (std::size_t i = 0; i < batches.size(); i++) {
+                std::vector<std::unique_ptr<ral::frame::BlazingTable>> batch;
+                batch.push_back(std::move(batches[i]));
+                ral::execution::task_result result = do_process(std::move(batch), output, stream, args);
+                if (result.status != ral::execution::task_status::SUCCESS) {
+                    // a retry only has to merge the batches that were not merged yet
+                    if (result.status == ral::execution::task_status::RETRY) {
+                        for (std::size_t j = i + 1; j < batches.size(); j++) {
+                            result.inputs.push_back(std::move(batches[j]));
+                        }
+                    }
+                    return result;
+                }
+            }
+            return {ral::execution::task_status::SUCCESS, std::string(), std::vector< std::unique_ptr<ral::frame::BlazingTable> > ()};
+        }
+
         std::vector< ral::frame::BlazingTableView > tableViewsToConcat;
         for (std::size_t i = 0; i < inputs.size(); i++){
             tableViewsToConcat.emplace_back(inputs[i]->toBlazingTableView());
@@ -316,20 +758,45 @@ ral::execution::task_result MergeAggregateKernel::do_process(std::vector< std::u
         if(aggregation_types.size() == 0) {
             columns = ral::operators::compute_groupby_without_aggregations(
                     concatenated->toBlazingTableView(), mod_group_column_indices);
+        } else if (ral::operators::has_distinct_aggregations(aggregation_types) && group_column_indices.size() > 0 && output != this->output_cache()) {
+            // the distinct values are only counted by the last merge
+            columns = ral::operators::compute_partial_aggregations_with_distinct(
+                    concatenated->toBlazingTableView(), mod_aggregation_input_expressions, mod_aggregation_types,
+                    mod_aggregation_column_assigned_aliases, mod_group_column_indices);
         } else if (group_column_indices.size() == 0) {
             // aggregations without groupby are only merged on the master node
             if( context->isMasterNode(ral::communication::CommunicationData::getInstance().getSelfNode()) ) {
                 columns = ral::operators::compute_aggregations_without_groupby(
                         concatenated->toBlazingTableView(), mod_aggregation_input_expressions, mod_aggregation_types,
                         mod_aggregation_column_assigned_aliases);
+            } else if (ral::operators::has_distinct_aggregations(aggregation_types)) {
+                // the partial aggregations of the distinct values don't have the types of their counts
+                std::unique_ptr<ral::frame::BlazingTable> counted = ral::operators::compute_aggregations_without_groupby(
+                        concatenated->toBlazingTableView(), mod_aggregation_input_expressions, mod_aggregation_types,
+                        mod_aggregation_column_assigned_aliases);
+                columns = std::make_unique<ral::frame::BlazingTable>(cudf::empty_like(counted->view()), counted->names());
             } else {
                 // with aggregations without groupby the distribution phase should deposit an empty dataframe with the right schema into the cache, which is then output here
                 columns = std::move(concatenated);
             }
         } else {
+            // the partial aggregations of sorted batches are sorted too, and stay so when they are merged in order
+            bool keys_are_sorted = this->check_sorted && ral::operators::are_groups_sorted(concatenated->toBlazingTableView(), mod_group_column_indices);
+            if (!keys_are_sorted) {
+                this->check_sorted = false;
+            }
             columns = ral::operators::compute_aggregations_with_groupby(
                     concatenated->toBlazingTableView(), mod_aggregation_input_expressions, mod_aggregation_types,
-                    mod_aggregation_column_assigned_aliases, mod_group_column_indices);
+                    mod_aggregation_column_assigned_aliases, mod_group_column_indices, keys_are_sorted);
+        }
+        if (output == this->output_cache() && !this->incremental_state_output.empty()) {
+            RAL_EXPECTS(ral::operators::can_merge_aggregated_output(aggregation_types),
+                "In MergeAggregateKernel: only SUM, MIN, MAX and COUNT can be aggregated incrementally");
+            write_incremental_state(columns->toBlazingTableView());
+        }
+        if (output == this->output_cache()) {
+            // the sketches of the approximate aggregations are only merged until the last merge
+            columns = ral::operators::estimate_approx_aggregations(std::move(columns), aggregation_types, mod_group_column_indices.size());
         }
         eventTimer.stop();
 
@@ -349,26 +816,54 @@ ral::execution::task_result MergeAggregateKernel::do_process(std::vector< std::u
 kstatus MergeAggregateKernel::run() {
     CodeTimer timer;
 
-    // This Kernel needs all of the input before it can do any output. So lets wait until all the input is available
-    this->input_cache()->wait_until_finished();
-
     int batch_count=0;
     try {
-        std::vector<std::unique_ptr <ral::cache::CacheData> > inputs;
+        // the batches of a group by can be merged as they arrive, the aggregations without group by are merged at once
+        // the state of an incremental aggregation is merged with all of the batches at once
+        std::unique_ptr <ral::cache::CacheData> first_batch = nullptr;
+        if (this->merge_bytes > 0 && this->incremental_state_output.empty() && this->input_cache()->wait_for_next()) {
+            first_batch = this->input_cache()->pullCacheData();
+        }
+        if (first_batch != nullptr) {
+            std::vector<int> group_column_indices;
+            std::tie(group_column_indices, std::ignore, std::ignore, std::ignore) =
+                ral::operators::parseGroupByExpression(this->expression, first_batch->num_columns());
+            this->num_group_columns = group_column_indices.size();
+        }
 
-        while(this->input_cache()->wait_for_next()){
-            std::unique_ptr <ral::cache::CacheData> cache_data = this->input_cache()->pullCacheData();
+        if (first_batch != nullptr && this->num_group_columns > 0 &&
+            first_batch->getMetadata().has_value(ral::cache::HASH_PARTITION_METADATA_LABEL)) {
+            merge_partitions_while_receiving(std::move(first_batch));
+        } else if (first_batch != nullptr && this->num_group_columns > 0) {
+            merge_while_receiving(std::move(first_batch));
+        } else {
+            // This Kernel needs all of the input before it can do any output. So lets wait until all the input is available
+            this->input_cache()->wait_until_finished();
 
-            if(cache_data != nullptr){
-                inputs.push_back(std::move(cache_data));
+            std::vector<std::unique_ptr <ral::cache::CacheData> > inputs;
+            if (first_batch != nullptr) {
+                inputs.push_back(std::move(first_batch));
                 batch_count++;
             }
-        }
+            std::unique_ptr<ral::frame::BlazingTable> incremental_state = read_incremental_state();
+            if (incremental_state != nullptr) {
+                inputs.push_back(std::make_unique<ral::cache::GPUCacheData>(std::move(incremental_state)));
+                batch_count++;
+            }
+            while(this->input_cache()->wait_for_next()){
+                std::unique_ptr <ral::cache::CacheData> cache_data = this->input_cache()->pullCacheData();
 
-        ral::execution::executor::get_instance()->add_task(
-                std::move(inputs),
-                this->output_cache(),
-                this);
+                if(cache_data != nullptr){
+                    inputs.push_back(std::move(cache_data));
+                    batch_count++;
+                }
+            }
+
+            ral::execution::executor::get_instance()->add_task(
+                    std::move(inputs),
+                    this->output_cache(),
+                    this);
+        }
 
         if(logger){
             logger->debug("{query_id}|{step}|{substep}|{info}|{duration}|kernel_id|{kernel_id}||",
@@ -415,5 +910,191 @@ kstatus MergeAggregateKernel::run() {
 
 // END MergeAggregateKernel
 
+// BEGIN GroupingSetsKernel
+
+GroupingSetsKernel::GroupingSetsKernel(std::size_t kernel_id, const std::string & queryString, std::shared_ptr<Context> context, std::shared_ptr<ral::cache::graph> query_graph)
+    : kernel{kernel_id, queryString, context, kernel_type::GroupingSetsKernel} {
+    this->query_graph = query_graph;
+
+    this->group_column_indices = ral::operators::get_group_columns(this->expression);
+    this->grouping_sets = ral::operators::get_grouping_sets(this->expression);
+    this->input_group_column_indices = ral::operators::get_grouping_sets_group_columns(this->group_column_indices, this->grouping_sets);
+    for (const std::vector<int> & grouping_set : this->grouping_sets) {
+        // the columns of every set keep the order they have in the input
+        std::vector<int> positions;
+        for (std::size_t i = 0; i < this->input_group_column_indices.size(); i++) {
+            if (std::find(grouping_set.begin(), grouping_set.end(), this->input_group_column_indices[i]) != grouping_set.end()) {
+                positions.push_back(i);
+            }
+        }
+        this->set_positions.push_back(positions);
+    }
+    this->partials.resize(this->grouping_sets.size());
+
+    std::string aggregate_expression = ral::operators::get_grouping_sets_aggregate_expression(this->expression, this->input_group_column_indices);
+    std::tie(std::ignore, std::ignore, this->aggregation_types, std::ignore) = ral::operators::parseGroupByExpression(aggregate_expression, 0);
+    std::tie(this->grouping_call_arguments, this->grouping_call_aliases) = ral::operators::get_grouping_calls(this->expression);
+}
+
+std::unique_ptr<ral::frame::BlazingTable> GroupingSetsKernel::make_output(std::unique_ptr<ral::frame::BlazingTable> & grouped, std::size_t set_index) {
+    const std::vector<int> & positions = this->set_positions[set_index];
+    cudf::size_type num_rows = grouped->num_rows();
+
+    // the new columns are made before the columns of the groups are taken, so that the groups are still whole if it fails
+    std::vector<std::unique_ptr<cudf::column>> null_columns(this->input_group_column_indices.size());
+    for (std::size_t i = 0; i < null_columns.size(); i++) {
+        if (std::find(positions.begin(), positions.end(), static_cast<int>(i)) == positions.end()) {
+            // the columns that are not in the set are null
+            std::unique_ptr<cudf::scalar> null_scalar = cudf::make_default_constructed_scalar(this->input_types[i]);
+            null_columns[i] = cudf::make_column_from_scalar(*null_scalar, num_rows);
+        }
+    }
+    std::vector<std::unique_ptr<cudf::column>> grouping_columns(this->grouping_call_arguments.size());
+    for (std::size_t i = 0; i < grouping_columns.size(); i++) {
+        if (!this->grouping_call_arguments[i].empty()) {
+            int64_t value = ral::operators::get_grouping_value(this->grouping_call_arguments[i], this->grouping_sets[set_index]);
+            std::unique_ptr<cudf::scalar> scalar = get_scalar_from_string(std::to_string(value), cudf::data_type(cudf::type_id::INT64));
+            grouping_columns[i] = cudf::make_column_from_scalar(*scalar, num_rows);
+        }
+    }
+
+    std::vector<std::string> grouped_names = grouped->names();
+    std::vector<std::unique_ptr<ral::frame::BlazingColumn>> grouped_columns = grouped->releaseBlazingColumns();
+    std::vector<std::unique_ptr<ral::frame::BlazingColumn>> output_columns;
+    std::vector<std::string> output_names;
+    for (int column_index : this->group_column_indices) {
+        auto input_position = std::find(this->input_group_column_indices.begin(), this->input_group_column_indices.end(), column_index);
+        std::size_t i = std::distance(this->input_group_column_indices.begin(), input_position);
+        auto it = std::find(positions.begin(), positions.end(), static_cast<int>(i));
+        if (it == positions.end()) {
+            output_columns.push_back(std::make_unique<ral::frame::BlazingColumnOwner>(std::move(null_columns[i])));
+            output_names.push_back(this->input_names[i]);
+        } else {
+            std::size_t grouped_position = std::distance(positions.begin(), it);
+            output_columns.push_back(std::move(grouped_columns[grouped_position]));
+            output_names.push_back(grouped_names[grouped_position]);
+        }
+    }
+
+    std::size_t aggregation_position = positions.size();
+    for (std::size_t i = 0; i < this->grouping_call_arguments.size(); i++) {
+        if (this->grouping_call_arguments[i].empty()) {
+            output_columns.push_back(std::move(grouped_columns[aggregation_position]));
+            output_names.push_back(grouped_names[aggregation_position]);
+            aggregation_position++;
+        } else {
+            output_columns.push_back(std::make_unique<ral::frame::BlazingColumnOwner>(std::move(grouping_columns[i])));
+            output_names.push_back(this->grouping_call_aliases[i].empty() ? "GROUPING" : this->grouping_call_aliases[i]);
+        }
+    }
+    return std::make_unique<ral::frame::BlazingTable>(std::move(output_columns), output_names);
+}
+
+ral::execution::task_result GroupingSetsKernel::do_process(std::vector< std::unique_ptr<ral::frame::BlazingTable> > inputs,
+    std::shared_ptr<ral::cache::CacheMachine> output,
+    cudaStream_t /*stream*/, const std::map<std::string, std::string>& /*args*/) {
+
+    try{
+        auto & input = inputs[0];
+        std::size_t num_group_columns = this->input_group_column_indices.size();
+
+        // all the sets of the batch are computed before any of them is kept, so that a retry does not count the batch twice
+        std::vector<std::unique_ptr<ral::frame::BlazingTable>> set_groups(this->grouping_sets.size());
+        for (std::size_t i = 0; i < this->grouping_sets.size(); i++) {
+            if (this->set_positions[i].size() < num_group_columns) {
+                set_groups[i] = ral::operators::compute_grouping_set(input->toBlazingTableView(), num_group_columns,
+                    this->set_positions[i], this->aggregation_types);
+            }
+        }
+        // the input already has the groups of all the columns, so its columns are moved into their output
+        std::vector<std::unique_ptr<ral::frame::BlazingTable>> outputs;
+        for (std::size_t i = 0; i < this->grouping_sets.size(); i++) {
+            if (this->set_positions[i].size() == num_group_columns) {
+                outputs.push_back(make_output(input, i));
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(partials_mutex);
+            for (std::size_t i = 0; i < set_groups.size(); i++) {
+                if (set_groups[i] != nullptr) {
+                    this->partials[i].push_back(std::move(set_groups[i]));
+                }
+            }
+        }
+        for (auto & table : outputs) {
+            output->addToCache(std::move(table));
+        }
+    }catch(const rmm::bad_alloc& e){
+        return {ral::execution::task_status::RETRY, std::string(e.what()), std::move(inputs)};
+    }catch(const std::exception& e){
+        return {ral::execution::task_status::FAIL, std::string(e.what()), std::vector< std::unique_ptr<ral::frame::BlazingTable> > ()};
+    }
+    return {ral::execution::task_status::SUCCESS, std::string(), std::vector< std::unique_ptr<ral::frame::BlazingTable> > ()};
+}
+
+kstatus GroupingSetsKernel::run() {
+    CodeTimer timer;
+
+    std::unique_ptr <ral::cache::CacheData> cache_data = this->input_cache()->pullCacheData();
+    if (cache_data != nullptr) {
+        this->input_names = cache_data->names();
+        this->input_types = cache_data->get_schema();
+    }
+
+    while(cache_data != nullptr ){
+        std::vector<std::unique_ptr <ral::cache::CacheData> > inputs;
+        inputs.push_back(std::move(cache_data));
+
+        ral::execution::executor::get_instance()->add_task(
+                std::move(inputs),
+                this->output_cache(),
+                this);
+
+        cache_data = this->input_cache()->pullCacheData();
+    }
+
+    std::unique_lock<std::mutex> lock(kernel_mutex);
+    kernel_cv.wait(lock,[this]{
+        return this->tasks.empty() || ral::execution::executor::get_instance()->has_exception();
+    });
+
+    if(auto ep = ral::execution::executor::get_instance()->last_exception()){
+        std::rethrow_exception(ep);
+    }
+
+    // the groups of the batches in the sets that are not all the columns are merged, they are small next to the input
+    for (std::size_t i = 0; i < this->grouping_sets.size(); i++) {
+        if (this->partials[i].empty()) {
+            continue;
+        }
+        std::vector<ral::frame::BlazingTableView> tables_to_merge;
+        for (auto & table : this->partials[i]) {
+            tables_to_merge.push_back(table->toBlazingTableView());
+        }
+        std::unique_ptr<ral::frame::BlazingTable> concatenated = ral::utilities::concatTables(tables_to_merge);
+        this->partials[i].clear();
+
+        std::vector<int> set_columns(this->set_positions[i].size());
+        std::iota(set_columns.begin(), set_columns.end(), 0);
+        std::unique_ptr<ral::frame::BlazingTable> merged = ral::operators::compute_grouping_set(concatenated->toBlazingTableView(),
+            set_columns.size(), set_columns, this->aggregation_types);
+        this->add_to_output_cache(make_output(merged, i));
+    }
+
+    if(logger) {
+        logger->debug("{query_id}|{step}|{substep}|{info}|{duration}|kernel_id|{kernel_id}||",
+                    "query_id"_a=context->getContextToken(),
+                    "step"_a=context->getQueryStep(),
+                    "substep"_a=context->getQuerySubstep(),
+                    "info"_a="GroupingSets Kernel Completed",
+                    "duration"_a=timer.elapsed_time(),
+                    "kernel_id"_a=this->get_id());
+    }
+    return kstatus::proceed;
+}
+
+// END GroupingSetsKernel
+
 } // namespace batch
 } // namespace ral
@@ -26,11 +26,68 @@ public:
 
     std::pair<bool, uint64_t> get_estimated_output_num_rows();
 
+    /**
+    * Outputs the partial aggregations that the scan it consumes answered from the statistics of the files, with its own.
+    */
+    void set_metadata_aggregation(std::shared_ptr<ral::operators::metadata_aggregation> aggregation) {
+        this->metadata_aggregation = aggregation;
+    }
+
+    /**
+    * The scan it consumes already outputs the partial aggregations, computed by the database of its SQL table, so
+    * they are output as they are.
+    */
+    void set_aggregation_pushed_down() {
+        this->aggregation_pushed_down = true;
+    }
+
 private:
+    // How the batches of a group by are aggregated, decided from how much the first num_sample_batches were reduced
+    enum class aggregation_mode {
+        SAMPLING, // every batch is aggregated on its own, and its reduction is measured
+        AGGREGATE, // every batch is aggregated on its own
+        ACCUMULATE, // the aggregations of the batches are merged with each other before they are output
+        BYPASS // the groups are so many that every row is output as a group of its own
+    };
+
+    /**
+    * Adds the reduction of a batch to the sample, and decides the mode once it has enough batches.
+    */
+    void sample_reduction(std::size_t input_rows, const ral::frame::BlazingTable & aggregated);
+
+    /**
+    * Keeps the aggregations of a batch to merge them with the ones of the next batches. Once they add up to
+    * accumulate_bytes they are merged, and the result is output if it is still bigger than half of it.
+    */
+    void accumulate(std::unique_ptr<ral::frame::BlazingTable> aggregated);
+
+    std::unique_ptr<ral::frame::BlazingTable> merge_aggregations(std::vector<std::unique_ptr<ral::frame::BlazingTable>> & aggregated);
+
     std::vector<AggregateKind> aggregation_types;
     std::vector<int> group_column_indices;
     std::vector<std::string> aggregation_input_expressions;
     std::vector<std::string> aggregation_column_assigned_aliases;
+
+    static constexpr std::size_t num_sample_batches = 4;
+    static constexpr double accumulate_ratio = 0.5; // the most output rows per input row that accumulating is worth it for
+    double bypass_ratio; // the least output rows per input row that bypasses the aggregation, 0 never bypasses it
+    std::size_t accumulate_bytes; // 0 never accumulates
+    std::atomic<bool> check_sorted{true}; // false once a batch was not sorted by the group columns, the next ones are then hashed without checking
+
+    std::mutex mode_mutex;
+    std::atomic<aggregation_mode> mode{aggregation_mode::SAMPLING};
+    std::size_t sampled_batches = 0;
+    std::size_t sampled_input_rows = 0;
+    std::size_t sampled_output_rows = 0;
+    std::vector<std::string> output_names; // of the first aggregated batch, the batches that bypass the aggregation are made like it
+    std::vector<cudf::data_type> output_types;
+
+    std::mutex accumulated_mutex;
+    std::vector<std::unique_ptr<ral::frame::BlazingTable>> accumulated;
+    std::size_t accumulated_bytes = 0;
+
+    std::shared_ptr<ral::operators::metadata_aggregation> metadata_aggregation;
+    bool aggregation_pushed_down = false;
 };
 
 class DistributeAggregateKernel : public distributing_kernel {
@@ -45,12 +102,20 @@ public:
 
     virtual kstatus run();
 
+    /**
+     * @brief Hashes the rows by their group columns cast to the widest type of their kind, so that the rows of inputs
+     * whose columns have different types, like the inputs of a set operation, go to the same node when their values
+     * are the same once they are cast to their common type.
+     */
+    void set_normalize_hashed_keys(bool normalize_hashed_keys) { this->normalize_hashed_keys = normalize_hashed_keys; }
+
 private:
     std::vector<int> group_column_indices;
     std::vector<std::string> aggregation_input_expressions, aggregation_column_assigned_aliases; // not used in this kernel
     std::vector<AggregateKind> aggregation_types; // not used in this kernel
     std::vector<cudf::size_type> columns_to_hash;
     bool set_empty_part_for_non_master_node = false; // this is only for aggregation without group by
+    bool normalize_hashed_keys = false;
 };
 
 class MergeAggregateKernel : public kernel {
@@ -66,7 +131,90 @@ public:
     virtual kstatus run();
 
 private:
+    /**
+    * Merges the batches of a group by in groups of about merge_bytes as they arrive, and then merges the results
+    * with each other in rounds until they fit in merge_bytes, which are merged into the output. When a round
+    * hardly makes them any smaller, they are hash partitioned by their groups and every bucket is merged on its own.
+    */
+    void merge_while_receiving(std::unique_ptr<ral::cache::CacheData> first_batch);
+
+    /**
+    * Merges the batches of a group by that were hashed to this node in several partitions, see HASH_PARTITIONS_PER_NODE.
+    * The batches of every partition are merged in groups of about merge_bytes as they arrive, and since the groups of a
+    * partition are in no other, the results of every partition are merged into the output by a task of their own.
+    */
+    void merge_partitions_while_receiving(std::unique_ptr<ral::cache::CacheData> first_batch);
+
+    void add_merge_task(std::vector<std::unique_ptr<ral::cache::CacheData>> inputs, std::shared_ptr<ral::cache::CacheMachine> output);
+
+    void merge_hash_partitions(std::vector<std::unique_ptr<ral::cache::CacheData>> partials, std::size_t num_bytes);
+
+    ral::execution::task_result hash_partition_batch(std::vector< std::unique_ptr<ral::frame::BlazingTable> > inputs);
+
+    void wait_for_tasks();
+
+    /**
+    * Returns the output of the last merge of the previous run of an incremental aggregation, which is merged with the
+    * partial aggregations of the files that were added since then. It is nullptr if there is none.
+    */
+    std::unique_ptr<ral::frame::BlazingTable> read_incremental_state();
+
+    /**
+    * Writes the output of the last merge, so that the next run of an incremental aggregation merges it. It is written to
+    * a new file, the caller of the query replaces the previous state with it once the query is done.
+    */
+    void write_incremental_state(const ral::frame::BlazingTableView & aggregated);
+
+    static constexpr std::size_t max_hash_partitions = 256;
+    static constexpr double min_merge_reduction = 0.9; // a round of merges that keeps more than this of the bytes is the last one
+
+    std::size_t merge_bytes; // 0 merges all the batches at once when they have all arrived
+    std::size_t num_group_columns = 0;
+    std::atomic<bool> check_sorted{true}; // false once a merge was not sorted by the group columns, the next ones are then hashed without checking
+    std::vector<std::shared_ptr<ral::cache::CacheMachine>> hash_partitions;
+    std::string incremental_state_input; // INCREMENTAL_AGGREGATION_STATE_INPUT, the state of the previous run
+    std::string incremental_state_output; // INCREMENTAL_AGGREGATION_STATE_OUTPUT, empty when the aggregation is not incremental
+};
+
+/**
+* Computes the grouping sets of GROUPING SETS, ROLLUP and CUBE from the groups of all their group columns, which the
+* ComputeAggregateKernel and the MergeAggregateKernel below it compute once. The groups of all the columns are output as
+* they are, and every batch of them is re-aggregated into the groups of the other sets, which are merged once all the
+* batches were.
+*/
+class GroupingSetsKernel : public kernel {
+public:
+    GroupingSetsKernel(std::size_t kernel_id, const std::string & queryString, std::shared_ptr<Context> context, std::shared_ptr<ral::cache::graph> query_graph);
+
+    std::string kernel_name() { return "GroupingSets";}
+
+    ral::execution::task_result do_process(std::vector< std::unique_ptr<ral::frame::BlazingTable> > inputs,
+        std::shared_ptr<ral::cache::CacheMachine> output,
+        cudaStream_t stream, const std::map<std::string, std::string>& args) override;
+
+    virtual kstatus run();
+
+private:
+    /**
+    * Makes the output of a grouping set, with all the group columns, nulls for the ones that are not in the set, and
+    * then the aggregations and the GROUPING calls in the order of the aggregate.
+    * @param grouped the groups of the set, with the columns of the set and then the aggregations. Its columns are
+    * taken once the new columns were made, it is left whole if making them fails.
+    */
+    std::unique_ptr<ral::frame::BlazingTable> make_output(std::unique_ptr<ral::frame::BlazingTable> & grouped, std::size_t set_index);
+
+    std::vector<int> group_column_indices; // in the order of the output
+    std::vector<int> input_group_column_indices; // in the order of the input, see get_grouping_sets_group_columns
+    std::vector<std::vector<int>> grouping_sets;
+    std::vector<std::vector<int>> set_positions; // of the columns of every set in the input
+    std::vector<AggregateKind> aggregation_types;
+    std::vector<std::vector<int>> grouping_call_arguments; // of every call of the aggregate, empty for the aggregations
+    std::vector<std::string> grouping_call_aliases;
+    std::vector<std::string> input_names;
+    std::vector<cudf::data_type> input_types;
 
+    std::mutex partials_mutex;
+    std::vector<std::vector<std::unique_ptr<ral::frame::BlazingTable>>> partials; // the groups of every batch in every set that is not all the columns
 };
 
 } // namespace batch
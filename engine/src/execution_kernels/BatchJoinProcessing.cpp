@@ -1,14 +1,27 @@
+#include <set>
 #include <string>
 #include "BatchJoinProcessing.h"
 #include "ExceptionHandling/BlazingThread.h"
 #include "parser/expression_tree.hpp"
 #include "utilities/CodeTimer.h"
+#include <cudf/binaryop.hpp>
+#include <cudf/column/column_factories.hpp>
+#include <cudf/copying.hpp>
+#include <cudf/filling.hpp>
 #include <cudf/partitioning.hpp>
 #include <cudf/join.hpp>
+#include <cudf/reduction.hpp>
+#include <cudf/replace.hpp>
+#include <cudf/search.hpp>
+#include <cudf/sorting.hpp>
 #include <cudf/stream_compaction.hpp>
+#include <cudf/unary.hpp>
+#include "operators/OrderBy.h"
 #include <src/execution_kernels/LogicalFilter.h>
+#include "LogicalProject.h"
 #include "execution_graph/executor.h"
 #include "cache_machine/CPUCacheData.h"
+#include "cache_machine/GPUCacheData.h"
 
 namespace ral {
 namespace batch {
@@ -23,8 +36,11 @@ std::tuple<std::string, std::string, std::string, std::string> parseExpressionTo
 	condition = get_named_expression(new_join_statement, "condition");
 	join_type = get_named_expression(new_join_statement, "joinType");
 
+	band_join_condition band;
 	if (condition == "true") {
 		join_type = CROSS_JOIN;
+	} else if (join_type == INNER_JOIN && parseJoinConditionToBand(condition, band)) {
+		join_type = BAND_JOIN;
 	}
 	return std::make_tuple(modified_expression, condition, filter_statement, join_type);
 }
@@ -111,6 +127,114 @@ cudf::null_equality parseJoinConditionToEqualityTypes(const std::string & condit
 	return joinEqualityTypes[0];
 }
 
+namespace {
+
+const std::set<std::string> band_comparison_operators = {"<", "<=", ">", ">="};
+
+// a comparison between two columns, that can bound one of them by the other
+bool is_band_comparison(const ral::parser::node & node) {
+	return node.type == ral::parser::node_type::OPERATOR && band_comparison_operators.count(node.value) > 0
+		&& node.children.size() == 2
+		&& node.children[0]->type == ral::parser::node_type::VARIABLE
+		&& node.children[1]->type == ral::parser::node_type::VARIABLE;
+}
+
+cudf::size_type column_of(const ral::parser::node & node) {
+	return static_cast<const ral::parser::variable_node &>(node).index();
+}
+
+// sets the bound of the point column that a band comparison makes, returns false if it does not compare the point column
+bool add_band_bound(const ral::parser::node & comparison, band_join_condition & band) {
+	int first = column_of(*comparison.children[0]);
+	int second = column_of(*comparison.children[1]);
+	if (first != band.point_column && second != band.point_column) {
+		return false;
+	}
+	// the comparison as point OP other
+	std::string op = comparison.value;
+	int other = second;
+	if (second == band.point_column) {
+		other = first;
+		op = op[0] == '<' ? ">" + op.substr(1) : "<" + op.substr(1);
+	}
+	bool inclusive = op.size() == 2;
+	if (op[0] == '>') {
+		if (band.lower_column != -1) {
+			return false;
+		}
+		band.lower_column = other;
+		band.lower_inclusive = inclusive;
+	} else {
+		if (band.upper_column != -1) {
+			return false;
+		}
+		band.upper_column = other;
+		band.upper_inclusive = inclusive;
+	}
+	return true;
+}
+
+// finds the comparisons of an AND that make a band, the two bounds of one column if there are, and returns their positions
+std::vector<std::size_t> find_band_comparisons(const ral::parser::node & root) {
+	for (std::size_t i = 0; i < root.children.size(); i++) {
+		if (!is_band_comparison(*root.children[i])) {
+			continue;
+		}
+		for (std::size_t j = i + 1; j < root.children.size(); j++) {
+			if (!is_band_comparison(*root.children[j])) {
+				continue;
+			}
+			for (auto & point : root.children[i]->children) {
+				band_join_condition band;
+				band.point_column = column_of(*point);
+				if (add_band_bound(*root.children[i], band) && add_band_bound(*root.children[j], band)) {
+					return {i, j};
+				}
+			}
+		}
+	}
+	for (std::size_t i = 0; i < root.children.size(); i++) {
+		if (is_band_comparison(*root.children[i])) {
+			return {i};
+		}
+	}
+	return {};
+}
+
+}  // namespace
+
+bool parseJoinConditionToBand(const std::string & condition, band_join_condition & band) {
+	ral::parser::parse_tree tree;
+	tree.build(replace_calcite_regex(condition));
+	const ral::parser::node & root = tree.root();
+
+	std::vector<const ral::parser::node *> comparisons;
+	if (root.value == "AND" && root.children.size() == 2) {
+		comparisons = {root.children[0].get(), root.children[1].get()};
+	} else {
+		comparisons = {&root};
+	}
+	if (!std::all_of(comparisons.begin(), comparisons.end(), [](const ral::parser::node * node){ return is_band_comparison(*node); })) {
+		return false;
+	}
+
+	// with a single comparison the point is the column of the left table, which has the lower index
+	std::vector<int> candidates;
+	if (comparisons.size() == 1) {
+		candidates = {std::min(column_of(*comparisons[0]->children[0]), column_of(*comparisons[0]->children[1]))};
+	} else {
+		candidates = {column_of(*comparisons[0]->children[0]), column_of(*comparisons[0]->children[1])};
+	}
+	for (int point : candidates) {
+		band = band_join_condition{};
+		band.point_column = point;
+		if (std::all_of(comparisons.begin(), comparisons.end(), [&band](const ral::parser::node * node){ return add_band_bound(*node, band); })) {
+			return true;
+		}
+	}
+	return false;
+}
+
 /*
 This function will take a join_statement and if it contains anything that is not an equijoin, it will try to break it up into an equijoin (new_join_statement) and a filter (filter_statement)
 If its just an equijoin, then the new_join_statement will just be join_statement and filter_statement will be empty
@@ -235,8 +359,30 @@ void split_inequality_join_into_join_and_filter(const std::string & join_stateme
 				filter_statement_expression = ral::parser::detail::rebuild_helper(filter_root.get());
 			}
 		} else {
-			RAL_FAIL("Join condition is currently not supported");
+			// without equalities the comparisons that bound a column make a band join, and the rest is a filter
+			std::vector<std::size_t> band_positions = find_band_comparisons(tree.root());
+			if (band_positions.empty()) {
+				RAL_FAIL("Join condition is currently not supported");
+			}
+			auto join_out_root = std::make_unique<ral::parser::operator_node>("AND");
+			auto filter_root = std::make_unique<ral::parser::operator_node>("AND");
+			for (std::size_t i = 0; i < tree.root().children.size(); i++) {
+				auto & c = tree.root().children[i];
+				bool in_band = std::find(band_positions.begin(), band_positions.end(), i) != band_positions.end();
+				(in_band ? join_out_root : filter_root)->children.push_back(std::unique_ptr<ral::parser::node>(c->clone()));
+			}
+			new_join_statement_expression = join_out_root->children.size() == 1 ?
+				ral::parser::detail::rebuild_helper(join_out_root->children[0].get()) : ral::parser::detail::rebuild_helper(join_out_root.get());
+			if (filter_root->children.size() == 1) {
+				filter_statement_expression = ral::parser::detail::rebuild_helper(filter_root->children[0].get());
+			} else if (filter_root->children.size() > 1) {
+				filter_statement_expression = ral::parser::detail::rebuild_helper(filter_root.get());
+			}
 		}
+	} else if (is_band_comparison(tree.root())) {
+		// a single comparison between two columns is a band join with one bound
+		new_join_statement_expression = condition;
+		filter_statement_expression = "";
 	} else if (tree.root().value == "true") { // cross join case
 		new_join_statement_expression = "true";
 	}
@@ -252,6 +398,31 @@ void split_inequality_join_into_join_and_filter(const std::string & join_stateme
 	}
 }
 
+namespace {
+
+/* Makes the pairs of rows of two tables where every row of the first one matches the range [starts[i], starts[i] + counts[i])
+of rows of the second one. Returns the gather maps of both tables. */
+std::pair<std::unique_ptr<cudf::column>, std::unique_ptr<cudf::column>> expand_match_ranges(const cudf::column_view & starts, const cudf::column_view & counts) {
+	cudf::data_type index_type{cudf::type_id::INT32};
+	cudf::numeric_scalar<int32_t> zero(0);
+
+	// every row is repeated once per match, and its matches are its start plus their position among them
+	std::unique_ptr<cudf::column> rows = cudf::sequence(starts.size(), zero);
+	std::unique_ptr<cudf::column> row_map = std::move(cudf::repeat(cudf::table_view{{rows->view()}}, counts)->release()[0]);
+	std::unique_ptr<cudf::column> first_matches = cudf::scan(counts, cudf::make_sum_aggregation(), cudf::scan_type::EXCLUSIVE);
+	std::vector<std::unique_ptr<cudf::column>> bounds = cudf::gather(cudf::table_view{{first_matches->view(), starts}}, row_map->view())->release();
+	std::unique_ptr<cudf::column> output_rows = cudf::sequence(row_map->size(), zero);
+	std::unique_ptr<cudf::column> positions = cudf::binary_operation(output_rows->view(), bounds[0]->view(), cudf::binary_operator::SUB, index_type);
+	std::unique_ptr<cudf::column> match_map = cudf::binary_operation(positions->view(), bounds[1]->view(), cudf::binary_operator::ADD, index_type);
+	return std::make_pair(std::move(row_map), std::move(match_map));
+}
+
+std::unique_ptr<cudf::column> cast_if_needed(const cudf::column_view & column, cudf::data_type type) {
+	return column.type() == type ? std::make_unique<cudf::column>(column) : cudf::cast(column, type);
+}
+
+}  // namespace
+
 // BEGIN PartwiseJoin
 
 PartwiseJoin::PartwiseJoin(std::size_t kernel_id, const std::string & queryString, std::shared_ptr<Context> context, std::shared_ptr<ral::cache::graph> query_graph)
@@ -273,16 +444,56 @@ PartwiseJoin::PartwiseJoin(std::size_t kernel_id, const std::string & queryStrin
 
 	std::tie(this->expression, this->condition, this->filter_statement, this->join_type) = parseExpressionToGetTypeAndCondition(this->expression);
 
-	if (this->filter_statement != "" && this->join_type != INNER_JOIN){
+	if (this->filter_statement != "" && (this->join_type == SEMI_JOIN || this->join_type == ANTI_JOIN)){
+		// the filter would need the right columns, which are not in their result
+		throw std::runtime_error("Semi and anti joins with inequalities are not currently supported");
+	}
+	if (this->filter_statement != "" && this->join_type != INNER_JOIN && this->join_type != BAND_JOIN){
 		throw std::runtime_error("Outer joins with inequalities are not currently supported");
 	}
+
+	// by default the build sides can take a quarter of the memory that the tasks can use
+	const blazingdb::manager::QueryConfig & config = context->getConfig();
+	std::size_t processing_memory_limit = ral::execution::executor::get_instance()->get_processing_memory_limit();
+	this->max_build_sides_bytes = config.join_hash_table_cache_bytes.value_or(processing_memory_limit / 4);
+
+	this->hash_partition_bytes = config.join_hybrid_hash_partition_bytes.value_or(processing_memory_limit / 4);
+
+	this->output_chunk_bytes = config.join_output_chunk_bytes.value_or(processing_memory_limit / 8);
+
+	// the filter of an inner join is evaluated on the columns it uses before the rest are gathered
+	if (config.enable_join_late_materialization.value_or(false) && this->filter_statement != "" && this->join_type == INNER_JOIN) {
+		std::string filter_condition = get_named_expression(this->filter_statement, "condition");
+		std::vector<int> condition_column_indices = get_referenced_column_indices(filter_condition);
+		if (!condition_column_indices.empty()) {
+			std::vector<int> new_column_indices(condition_column_indices.back() + 1, -1);
+			for (std::size_t i = 0; i < condition_column_indices.size(); i++) {
+				new_column_indices[condition_column_indices[i]] = i;
+			}
+			this->filter_column_indices = condition_column_indices;
+			this->narrow_filter_condition = renumber_column_indices(filter_condition, new_column_indices);
+		}
+	}
+}
+
+namespace {
+
+int get_hash_partition(const ral::cache::CacheData & cache_data) {
+	const ral::cache::MetadataDictionary & metadata = cache_data.getMetadata();
+	if (!metadata.has_value(ral::cache::HASH_PARTITION_METADATA_LABEL)) {
+		return -1;
+	}
+	return std::stoi(metadata.get_value(ral::cache::HASH_PARTITION_METADATA_LABEL));
 }
 
+}  // namespace
+
 std::unique_ptr<ral::cache::CacheData> PartwiseJoin::load_left_set(){
 	this->max_left_ind++;
 	auto cache_data = this->left_input->pullCacheData();
 	RAL_EXPECTS(cache_data != nullptr, "In PartwiseJoin: The left input cache data cannot be null");
 
+	this->left_hash_partitions.push_back(get_hash_partition(*cache_data));
 	return cache_data;
 }
 
@@ -291,9 +502,18 @@ std::unique_ptr<ral::cache::CacheData> PartwiseJoin::load_right_set(){
 	auto cache_data = this->right_input->pullCacheData();
 	RAL_EXPECTS(cache_data != nullptr, "In PartwiseJoin: The right input cache data cannot be null");
 
+	this->right_hash_partitions.push_back(get_hash_partition(*cache_data));
 	return cache_data;
 }
 
+// the rows of different hash partitions have different keys, which an inner join never matches
+bool PartwiseJoin::can_match(int left_ind, int right_ind) const {
+	int left_partition = this->left_hash_partitions[left_ind];
+	int right_partition = this->right_hash_partitions[right_ind];
+	return this->join_type != INNER_JOIN || this->left_column_indices.empty() ||
+		left_partition < 0 || right_partition < 0 || left_partition == right_partition;
+}
+
 void PartwiseJoin::mark_set_completed(int left_ind, int right_ind){
 	assert(left_ind >=0 && right_ind >=0 );
 	if (completion_matrix.size() <= static_cast<size_t>(left_ind)){
@@ -387,6 +607,47 @@ std::unique_ptr<cudf::table> reordering_columns_due_to_right_join(std::unique_pt
 	return std::make_unique<cudf::table>(std::move(columns_right_pos));
 }
 
+void PartwiseJoin::setup_join_columns(const std::vector<std::string> & left_names, const std::vector<cudf::data_type> & left_types,
+	const std::vector<std::string> & right_names, const std::vector<cudf::data_type> & right_types) {
+	// parsing more of the expression here because we need to have the number of columns of the tables
+	if (this->join_type == BAND_JOIN) {
+		parseJoinConditionToBand(this->condition, this->band);
+		int num_left_columns = left_types.size();
+		this->band_point_on_left = this->band.point_column < num_left_columns;
+		for (int bound_column : {this->band.lower_column, this->band.upper_column}) {
+			RAL_EXPECTS(bound_column == -1 || (bound_column < num_left_columns) != this->band_point_on_left,
+				"In a band join the bounds must be columns of the other table");
+		}
+	} else {
+		std::vector<int> column_indices;
+		parseJoinConditionToColumnIndices(this->condition, column_indices);
+		for(std::size_t i = 0; i < column_indices.size();i++){
+			if(column_indices[i] >= static_cast<int>(left_types.size())){
+				this->right_column_indices.push_back(column_indices[i] - left_types.size());
+			}else{
+				this->left_column_indices.push_back(column_indices[i]);
+			}
+		}
+	}
+
+	this->result_names.reserve(left_names.size() + right_names.size());
+	this->result_names.insert(this->result_names.end(), left_names.begin(), left_names.end());
+	if (this->join_type != SEMI_JOIN && this->join_type != ANTI_JOIN) {
+		this->result_names.insert(this->result_names.end(), right_names.begin(), right_names.end());
+	}
+
+	computeNormalizationData(left_types, right_types);
+
+	this->left_names = left_names;
+	this->right_names = right_names;
+	this->left_types = left_types;
+	this->right_types = right_types;
+	for (std::size_t i = 0; i < this->join_column_common_types.size(); i++) {
+		this->left_types[this->left_column_indices[i]] = this->join_column_common_types[i];
+		this->right_types[this->right_column_indices[i]] = this->join_column_common_types[i];
+	}
+}
+
 std::unique_ptr<ral::frame::BlazingTable> PartwiseJoin::join_set(
 	const ral::frame::BlazingTableView & table_left,
 	const ral::frame::BlazingTableView & table_right)
@@ -397,6 +658,8 @@ std::unique_ptr<ral::frame::BlazingTable> PartwiseJoin::join_set(
 		result_table = cudf::cross_join(
 			table_left.view(),
 			table_right.view());
+	} else if (this->join_type == BAND_JOIN) {
+		result_table = band_join(table_left, table_right);
 	} else {
 		bool has_nulls_left = ral::processor::check_if_has_nulls(table_left.view(), left_column_indices);
 		bool has_nulls_right = ral::processor::check_if_has_nulls(table_right.view(), right_column_indices);
@@ -444,6 +707,22 @@ std::unique_ptr<ral::frame::BlazingTable> PartwiseJoin::join_set(
 				this->left_column_indices,
 				this->right_column_indices,
 				(has_nulls_left && has_nulls_right) ? cudf::null_equality::UNEQUAL : cudf::null_equality::EQUAL);
+		} else if(this->join_type == SEMI_JOIN || this->join_type == ANTI_JOIN) {
+			// only the left columns are returned, and every left row at most once, no matter how many right rows it matches
+			cudf::null_equality equalityType = parseJoinConditionToEqualityTypes(this->condition);
+			result_table = this->join_type == SEMI_JOIN ?
+				cudf::left_semi_join(
+					table_left.view(),
+					table_right.view(),
+					this->left_column_indices,
+					this->right_column_indices,
+					equalityType) :
+				cudf::left_anti_join(
+					table_left.view(),
+					table_right.view(),
+					this->left_column_indices,
+					this->right_column_indices,
+					equalityType);
 		} else {
 			RAL_FAIL("Unsupported join operator");
 		}
@@ -452,9 +731,283 @@ std::unique_ptr<ral::frame::BlazingTable> PartwiseJoin::join_set(
 	return std::make_unique<ral::frame::BlazingTable>(std::move(result_table), this->result_names);
 }
 
+std::unique_ptr<cudf::table> PartwiseJoin::band_join(
+	const ral::frame::BlazingTableView & table_left,
+	const ral::frame::BlazingTableView & table_right)
+{
+	const ral::frame::BlazingTableView & point_table = this->band_point_on_left ? table_left : table_right;
+	const ral::frame::BlazingTableView & bounds_table = this->band_point_on_left ? table_right : table_left;
+	cudf::size_type point_offset = this->band_point_on_left ? 0 : table_left.num_columns();
+	cudf::size_type bounds_offset = this->band_point_on_left ? table_left.num_columns() : 0;
+	cudf::size_type point_index = this->band.point_column - point_offset;
+	cudf::size_type lower_index = this->band.lower_column == -1 ? -1 : this->band.lower_column - bounds_offset;
+	cudf::size_type upper_index = this->band.upper_column == -1 ? -1 : this->band.upper_column - bounds_offset;
+
+	// the rows with a null bound don't match any point
+	std::vector<cudf::size_type> bound_indices;
+	for (cudf::size_type index : {lower_index, upper_index}) {
+		if (index != -1) {
+			bound_indices.push_back(index);
+		}
+	}
+	std::unique_ptr<cudf::table> bounds_dropna;
+	cudf::table_view bounds_view = bounds_table.view();
+	if (ral::processor::check_if_has_nulls(bounds_view, bound_indices)) {
+		bounds_dropna = cudf::drop_nulls(bounds_view, bound_indices);
+		bounds_view = bounds_dropna->view();
+	}
+
+	// the points and the bounds are compared in their common type, and the null points are sorted after all the others
+	bool strict = false;
+	cudf::data_type common_type = point_table.view().column(point_index).type();
+	for (cudf::size_type index : bound_indices) {
+		common_type = ral::utilities::get_common_type(common_type, bounds_view.column(index).type(), strict);
+	}
+	std::unique_ptr<cudf::column> points = cast_if_needed(point_table.view().column(point_index), common_type);
+	std::unique_ptr<cudf::column> sorted_order = cudf::sorted_order(cudf::table_view{{points->view()}}, {cudf::order::ASCENDING}, {cudf::null_order::AFTER});
+	std::unique_ptr<cudf::column> sorted_points = std::move(cudf::gather(cudf::table_view{{points->view()}}, sorted_order->view())->release()[0]);
+	cudf::size_type num_valid_points = sorted_points->size() - sorted_points->null_count();
+	cudf::table_view sorted_points_view{{sorted_points->view()}};
+
+	// the points of a row are the range from the first point above its lower bound to the last one below its upper bound
+	std::unique_ptr<cudf::column> starts, ends;
+	if (lower_index != -1) {
+		std::unique_ptr<cudf::column> lower_bounds = cast_if_needed(bounds_view.column(lower_index), common_type);
+		cudf::table_view lower_bounds_view{{lower_bounds->view()}};
+		starts = this->band.lower_inclusive ?
+			cudf::lower_bound(sorted_points_view, lower_bounds_view, {cudf::order::ASCENDING}, {cudf::null_order::AFTER}) :
+			cudf::upper_bound(sorted_points_view, lower_bounds_view, {cudf::order::ASCENDING}, {cudf::null_order::AFTER});
+	} else {
+		starts = cudf::make_column_from_scalar(cudf::numeric_scalar<int32_t>(0), bounds_view.num_rows());
+	}
+	if (upper_index != -1) {
+		std::unique_ptr<cudf::column> upper_bounds = cast_if_needed(bounds_view.column(upper_index), common_type);
+		cudf::table_view upper_bounds_view{{upper_bounds->view()}};
+		ends = this->band.upper_inclusive ?
+			cudf::upper_bound(sorted_points_view, upper_bounds_view, {cudf::order::ASCENDING}, {cudf::null_order::AFTER}) :
+			cudf::lower_bound(sorted_points_view, upper_bounds_view, {cudf::order::ASCENDING}, {cudf::null_order::AFTER});
+	} else {
+		ends = cudf::make_column_from_scalar(cudf::numeric_scalar<int32_t>(num_valid_points), bounds_view.num_rows());
+	}
+	// a lower bound above the upper one matches nothing
+	std::unique_ptr<cudf::column> differences = cudf::binary_operation(ends->view(), starts->view(), cudf::binary_operator::SUB, cudf::data_type{cudf::type_id::INT32});
+	std::unique_ptr<cudf::column> counts = cudf::clamp(differences->view(), cudf::numeric_scalar<int32_t>(0), cudf::numeric_scalar<int32_t>(num_valid_points));
+
+	std::unique_ptr<cudf::column> bounds_map, sorted_points_map;
+	std::tie(bounds_map, sorted_points_map) = expand_match_ranges(starts->view(), counts->view());
+	std::unique_ptr<cudf::column> points_map = std::move(cudf::gather(cudf::table_view{{sorted_order->view()}}, sorted_points_map->view())->release()[0]);
+
+	std::vector<std::unique_ptr<cudf::column>> point_columns = cudf::gather(point_table.view(), points_map->view())->release();
+	std::vector<std::unique_ptr<cudf::column>> bounds_columns = cudf::gather(bounds_view, bounds_map->view())->release();
+	std::vector<std::unique_ptr<cudf::column>> & columns = this->band_point_on_left ? point_columns : bounds_columns;
+	std::vector<std::unique_ptr<cudf::column>> & other_columns = this->band_point_on_left ? bounds_columns : point_columns;
+	std::move(other_columns.begin(), other_columns.end(), std::back_inserter(columns));
+	return std::make_unique<cudf::table>(std::move(columns));
+}
+
+std::shared_ptr<PartwiseJoin::build_side> PartwiseJoin::get_or_make_build_side(int right_ind, std::unique_ptr<ral::frame::BlazingTable> & right_batch) {
+	if (this->max_build_sides_bytes == 0 || (this->join_type != INNER_JOIN && this->join_type != LEFT_JOIN)) {
+		return nullptr;
+	}
+
+	std::lock_guard<std::mutex> lock(build_sides_mutex);
+	auto it = this->build_sides.find(right_ind);
+	if (it != this->build_sides.end()) {
+		return it->second;
+	}
+	if (right_batch->num_rows() == 0) {
+		return nullptr;
+	}
+	// the hash table has about two slots per row, with the hash and the index of the row
+	std::size_t num_bytes = right_batch->sizeInBytes() + 2 * right_batch->num_rows() * (sizeof(cudf::hash_value_type) + sizeof(cudf::size_type));
+	if (this->build_sides_bytes + num_bytes > this->max_build_sides_bytes) {
+		return nullptr;
+	}
+
+	auto build = std::make_shared<build_side>();
+	build->compare_nulls = cudf::null_equality::EQUAL;
+	if (this->join_type == INNER_JOIN) {
+		build->compare_nulls = parseJoinConditionToEqualityTypes(this->condition);
+		build->table = std::move(right_batch);
+	} else if (ral::processor::check_if_has_nulls(right_batch->view(), right_column_indices)) {
+		// the right rows with null keys never match in a left join
+		build->table = std::make_unique<ral::frame::BlazingTable>(cudf::drop_nulls(right_batch->view(), right_column_indices), right_batch->names());
+	} else {
+		build->table = std::move(right_batch);
+	}
+	try {
+		build->hash_table = std::make_unique<cudf::hash_join>(build->table->view(), this->right_column_indices, build->compare_nulls);
+	} catch(const rmm::bad_alloc& e) {
+		if (right_batch == nullptr) {
+			right_batch = std::move(build->table); // so that the task can be retried
+		}
+		throw;
+	}
+
+	if (right_batch == nullptr) {
+		right_batch = ral::utilities::create_empty_table(build->table->toBlazingTableView());
+	} else {
+		right_batch = ral::utilities::create_empty_table(right_batch->toBlazingTableView());
+	}
+	this->build_sides_bytes += num_bytes;
+	this->build_sides[right_ind] = build;
+	return build;
+}
+
+bool PartwiseJoin::chunks_output() const {
+	return this->output_chunk_bytes > 0 && (this->join_type == INNER_JOIN || this->join_type == LEFT_JOIN);
+}
+
+bool PartwiseJoin::late_materializes_filter() const {
+	return !this->narrow_filter_condition.empty();
+}
+
+std::unique_ptr<cudf::table> PartwiseJoin::filter_gather_maps(const cudf::table_view & table_left, const cudf::table_view & table_right,
+	const cudf::column_view & left_map, const cudf::column_view & right_map) {
+	// the columns of the result are the left ones and then the right ones
+	std::vector<cudf::size_type> left_filter_columns, right_filter_columns;
+	for (int column_index : this->filter_column_indices) {
+		if (column_index < table_left.num_columns()) {
+			left_filter_columns.push_back(column_index);
+		} else {
+			right_filter_columns.push_back(column_index - table_left.num_columns());
+		}
+	}
+	std::vector<std::unique_ptr<cudf::column>> filter_columns = cudf::gather(table_left.select(left_filter_columns), left_map)->release();
+	std::vector<std::unique_ptr<cudf::column>> right_columns = cudf::gather(table_right.select(right_filter_columns), right_map)->release();
+	std::move(right_columns.begin(), right_columns.end(), std::back_inserter(filter_columns));
+	cudf::table filter_table(std::move(filter_columns));
+
+	std::vector<std::unique_ptr<ral::frame::BlazingColumn>> evaluated = ral::processor::evaluate_expressions(filter_table.view(), {this->narrow_filter_condition});
+	RAL_EXPECTS(evaluated.size() == 1, "In PartwiseJoin: the filter of a join did not evaluate to a column");
+	return cudf::apply_boolean_mask(cudf::table_view({left_map, right_map}), evaluated[0]->view());
+}
+
+void PartwiseJoin::add_joined_to_output(std::unique_ptr<ral::frame::BlazingTable> joined, bool filtered) {
+	if (filter_statement != "" && !filtered) {
+		joined = ral::processor::process_filter(joined->toBlazingTableView(), filter_statement, this->context.get());
+	}
+	this->add_to_output_cache(std::move(joined));
+}
+
+void PartwiseJoin::join_to_output(const ral::frame::BlazingTableView & table_left, const ral::frame::BlazingTableView & table_right,
+	const build_side * build) {
+	// the rows of a build side are in it, its right batch is left empty
+	ral::frame::BlazingTableView right_table = build != nullptr ? build->table->toBlazingTableView() : table_right;
+	if ((!chunks_output() && !late_materializes_filter()) || table_left.num_rows() == 0) {
+		add_joined_to_output(join_set(table_left, right_table));
+		return;
+	}
+
+	cudf::table_view right_view = right_table.view();
+	cudf::null_equality compare_nulls = build != nullptr ? build->compare_nulls : cudf::null_equality::EQUAL;
+	std::unique_ptr<cudf::table> right_dropna;
+	if (build == nullptr && this->join_type == INNER_JOIN) {
+		compare_nulls = parseJoinConditionToEqualityTypes(this->condition);
+	} else if (build == nullptr && ral::processor::check_if_has_nulls(right_view, right_column_indices)) {
+		// the right rows with null keys never match in a left join
+		right_dropna = cudf::drop_nulls(right_view, right_column_indices);
+		right_view = right_dropna->view();
+	}
+	if (right_view.num_rows() == 0) {
+		add_joined_to_output(join_set(table_left, right_table));
+		return;
+	}
+
+	std::unique_ptr<cudf::hash_join> hash_table;
+	if (build == nullptr) {
+		hash_table = std::make_unique<cudf::hash_join>(right_view, this->right_column_indices, compare_nulls);
+	}
+	const cudf::hash_join & probed_hash_table = build != nullptr ? *build->hash_table : *hash_table;
+	auto join_indices = this->join_type == INNER_JOIN ?
+		probed_hash_table.inner_join(table_left.view(), this->left_column_indices, compare_nulls) :
+		probed_hash_table.left_join(table_left.view(), this->left_column_indices, compare_nulls);
+	cudf::size_type num_output_rows = join_indices.first->size();
+	this->total_probe_rows += table_left.num_rows();
+	this->total_output_rows += num_output_rows;
+	const cudf::size_type * left_indices = join_indices.first->data();
+	const cudf::size_type * right_indices = join_indices.second->data();
+
+	std::unique_ptr<cudf::table> filtered_maps;
+	if (late_materializes_filter() && num_output_rows > 0) {
+		filtered_maps = filter_gather_maps(table_left.view(), right_view,
+			cudf::column_view{cudf::data_type{cudf::type_id::INT32}, num_output_rows, left_indices},
+			cudf::column_view{cudf::data_type{cudf::type_id::INT32}, num_output_rows, right_indices});
+		num_output_rows = filtered_maps->num_rows();
+		left_indices = filtered_maps->view().column(0).data<cudf::size_type>();
+		right_indices = filtered_maps->view().column(1).data<cudf::size_type>();
+		join_indices.first.reset();
+		join_indices.second.reset();
+	}
+
+	// the chunks have the rows that fit in output_chunk_bytes, with the average size of the rows of both sides
+	ral::frame::BlazingTableView left_sized = table_left;
+	std::size_t row_bytes = left_sized.sizeInBytes() / table_left.num_rows();
+	row_bytes += right_table.sizeInBytes() / right_table.num_rows();
+	cudf::size_type chunk_rows = std::max(num_output_rows, 1);
+	if (chunks_output()) {
+		chunk_rows = static_cast<cudf::size_type>(std::min<std::size_t>(
+			std::max<std::size_t>(this->output_chunk_bytes / std::max<std::size_t>(row_bytes, 1), 1), chunk_rows));
+	}
+
+	cudf::size_type offset = 0;
+	do {
+		cudf::size_type num_rows = std::min(chunk_rows, num_output_rows - offset);
+		cudf::column_view left_map{cudf::data_type{cudf::type_id::INT32}, num_rows, left_indices + offset};
+		cudf::column_view right_map{cudf::data_type{cudf::type_id::INT32}, num_rows, right_indices + offset};
+
+		try {
+			std::vector<std::unique_ptr<cudf::column>> columns = cudf::gather(table_left.view(), left_map)->release();
+			// the left rows without matches have an index that is out of bounds, so their right columns are nulls
+			std::vector<std::unique_ptr<cudf::column>> right_columns = cudf::gather(right_view, right_map, cudf::out_of_bounds_policy::NULLIFY)->release();
+			std::move(right_columns.begin(), right_columns.end(), std::back_inserter(columns));
+			add_joined_to_output(std::make_unique<ral::frame::BlazingTable>(std::make_unique<cudf::table>(std::move(columns)), this->result_names),
+				filtered_maps != nullptr);
+		} catch(const rmm::bad_alloc &) {
+			// once a chunk was added the task can't be retried without adding it again, so smaller chunks are tried instead
+			if (offset == 0) {
+				throw;
+			}
+			if (chunk_rows == 1) {
+				throw std::runtime_error("In PartwiseJoin: Could not allocate a chunk of the output of a join");
+			}
+			chunk_rows /= 2;
+			continue;
+		}
+		offset += num_rows;
+	} while (offset < num_output_rows);
+}
+
+std::size_t PartwiseJoin::estimate_output_bytes(const std::vector<std::unique_ptr<ral::cache::CacheData > > & inputs) {
+	std::size_t estimate = kernel::estimate_output_bytes(inputs);
+	// the hash partitioning tasks of a hybrid hash join have one input, and output about as much as it
+	if (!chunks_output() || inputs.size() < 2) {
+		return estimate;
+	}
+
+	std::size_t estimated_map_bytes = 0;
+	std::size_t probe_rows = this->total_probe_rows.load();
+	if (probe_rows > 0) {
+		double output_rows_per_probe_row = static_cast<double>(this->total_output_rows.load()) / probe_rows;
+		std::size_t input_rows = 0;
+		for (auto & input : inputs) {
+			input_rows += input->num_rows();
+		}
+		estimated_map_bytes = static_cast<std::size_t>(input_rows * output_rows_per_probe_row * 2 * sizeof(cudf::size_type));
+	}
+	return std::min(estimate, this->output_chunk_bytes + estimated_map_bytes);
+}
+
 ral::execution::task_result PartwiseJoin::do_process(std::vector<std::unique_ptr<ral::frame::BlazingTable>> inputs,
 	std::shared_ptr<ral::cache::CacheMachine> /*output*/,
 	cudaStream_t /*stream*/, const std::map<std::string, std::string>& args) {
+	const std::string & operation_type = args.at("operation_type");
+	if (operation_type == "hash_partition") {
+		return hash_partition_batch(std::move(inputs), args);
+	} else if (operation_type == "join_partition") {
+		return join_hash_partition(std::move(inputs), args);
+	}
+
 	CodeTimer eventTimer;
 
 	auto & left_batch = inputs[0];
@@ -471,23 +1024,9 @@ ral::execution::task_result PartwiseJoin::do_process(std::vector<std::unique_ptr
 		auto log_input_num_rows = left_batch->num_rows() + right_batch->num_rows();
 		auto log_input_num_bytes = left_batch->sizeInBytes() + right_batch->sizeInBytes();
 
-		std::unique_ptr<ral::frame::BlazingTable> joined = join_set(left_batch->toBlazingTableView(), right_batch->toBlazingTableView());
-
-		auto log_output_num_rows = joined->num_rows();
-		auto log_output_num_bytes = joined->sizeInBytes();
-
-		if (filter_statement != "") {
-			auto filter_table = ral::processor::process_filter(joined->toBlazingTableView(), filter_statement, this->context.get());
-			eventTimer.stop();
-
-			log_output_num_rows = filter_table->num_rows();
-			log_output_num_bytes = filter_table->sizeInBytes();
-
-			this->add_to_output_cache(std::move(filter_table));
-		} else{
-			eventTimer.stop();
-			this->add_to_output_cache(std::move(joined));
-		}
+		std::shared_ptr<build_side> build = get_or_make_build_side(std::stoi(args.at("right_idx")), right_batch);
+		join_to_output(left_batch->toBlazingTableView(), right_batch->toBlazingTableView(), build.get());
+		eventTimer.stop();
 
 	}catch(const rmm::bad_alloc& e){
 		return {ral::execution::task_status::RETRY, std::string(e.what()), std::move(inputs)};
@@ -530,24 +1069,12 @@ kstatus PartwiseJoin::run() {
 			left_ind = this->max_left_ind = 0; // we have loaded just once. This is the highest index for now
 			right_ind = this->max_right_ind = 0; // we have loaded just once. This is the highest index for now
 
-			// parsing more of the expression here because we need to have the number of columns of the tables
-			std::vector<int> column_indices;
-			parseJoinConditionToColumnIndices(this->condition, column_indices);
-			for(std::size_t i = 0; i < column_indices.size();i++){
-				if(column_indices[i] >= static_cast<int>(left_cache_data->num_columns())){
-					this->right_column_indices.push_back(column_indices[i] - left_cache_data->num_columns());
-				}else{
-					this->left_column_indices.push_back(column_indices[i]);
-				}
-			}
-
-			std::vector<std::string> left_names = left_cache_data->names();
-			std::vector<std::string> right_names = right_cache_data->names();
-			this->result_names.reserve(left_names.size() + right_names.size());
-			this->result_names.insert(this->result_names.end(), left_names.begin(), left_names.end());
-			this->result_names.insert(this->result_names.end(), right_names.begin(), right_names.end());
+			setup_join_columns(left_cache_data->names(), left_cache_data->get_schema(), right_cache_data->names(), right_cache_data->get_schema());
 
-			computeNormalizationData(left_cache_data->get_schema(), right_cache_data->get_schema());
+			if (use_hybrid_hash_join(*left_cache_data, *right_cache_data)) {
+				run_hybrid_hash_join(std::move(left_cache_data), std::move(right_cache_data));
+				done = true;
+			}
 		} else {
 			// Not first load, so we have joined a set pair. Now lets see if there is another set pair we can do, but keeping one of the two sides we already have
 			std::tie(left_ind, right_ind) = check_for_another_set_to_do_with_data_we_already_have();
@@ -583,7 +1110,13 @@ kstatus PartwiseJoin::run() {
 				}
 			}
 		}
-		if (!done) {
+		// the first pair is always joined so that the output has a batch, even when no pair can match
+		if (!done && (left_ind > 0 || right_ind > 0) && !can_match(left_ind, right_ind)) {
+			// the pair has no rows to join, its batches only go back to the array caches for the other pairs
+			this->leftArrayCache->put(left_ind, std::move(left_cache_data));
+			this->rightArrayCache->put(right_ind, std::move(right_cache_data));
+			mark_set_completed(left_ind, right_ind);
+		} else if (!done) {
 			std::vector<std::unique_ptr<ral::cache::CacheData>> inputs;
 			inputs.push_back(std::move(left_cache_data));
 			inputs.push_back(std::move(right_cache_data));
@@ -592,7 +1125,7 @@ kstatus PartwiseJoin::run() {
 									std::move(inputs),
 									this->output_cache(),
 									this,
-									{{"left_idx", std::to_string(left_ind)}, {"right_idx", std::to_string(right_ind)}});
+									{{"operation_type", "join_pair"}, {"left_idx", std::to_string(left_ind)}, {"right_idx", std::to_string(right_ind)}});
 
 			mark_set_completed(left_ind, right_ind);
 		}
@@ -630,10 +1163,237 @@ kstatus PartwiseJoin::run() {
 	// these are intra kernel caches. We want to make sure they are empty before we finish.
 	this->leftArrayCache->clear();
 	this->rightArrayCache->clear();
+	this->build_sides.clear();
+	this->hash_partitions_by_id.clear();
 
 	return kstatus::proceed;
 }
 
+namespace {
+
+const int max_hash_partition_levels = 3; // the rows of a single key can't be split, so a bucket is not partitioned forever
+const std::size_t max_hash_partitions = 256;
+
+}  // namespace
+
+bool PartwiseJoin::use_hybrid_hash_join(const ral::cache::CacheData & left_cache_data, const ral::cache::CacheData & right_cache_data) {
+	if (this->hash_partition_bytes == 0 || this->join_type == CROSS_JOIN || this->join_type == BAND_JOIN) {
+		return false;
+	}
+
+	std::pair<bool, uint64_t> left_num_rows_estimate = this->query_graph->get_estimated_input_rows_to_cache(this->kernel_id, "input_a");
+	std::pair<bool, uint64_t> right_num_rows_estimate = this->query_graph->get_estimated_input_rows_to_cache(this->kernel_id, "input_b");
+	if (!left_num_rows_estimate.first || !right_num_rows_estimate.first
+		|| left_cache_data.num_rows() == 0 || right_cache_data.num_rows() == 0) {
+		return false;
+	}
+
+	// the bytes per row of the first batches
+	double left_bytes = left_num_rows_estimate.second * (static_cast<double>(left_cache_data.sizeInBytes()) / left_cache_data.num_rows());
+	double right_bytes = right_num_rows_estimate.second * (static_cast<double>(right_cache_data.sizeInBytes()) / right_cache_data.num_rows());
+	return std::min(left_bytes, right_bytes) > this->hash_partition_bytes;
+}
+
+std::shared_ptr<PartwiseJoin::hash_partitions> PartwiseJoin::make_hash_partitions(const std::string & id, int level, std::size_t num_bytes) {
+	std::size_t num_partitions = (num_bytes + this->hash_partition_bytes - 1) / this->hash_partition_bytes;
+	num_partitions = std::min(std::max(num_partitions, std::size_t{2}), max_hash_partitions);
+
+	ral::cache::cache_settings cache_machine_config;
+	cache_machine_config.type = ral::cache::CacheType::SIMPLE;
+	cache_machine_config.context = context->clone();
+
+	auto partitions = std::make_shared<hash_partitions>();
+	partitions->id = id;
+	partitions->level = level;
+	for (std::size_t i = 0; i < num_partitions; i++) {
+		std::string cache_name = std::to_string(this->get_id()) + "_hash_partition_" + id + "_" + std::to_string(i);
+		partitions->left.push_back(ral::cache::create_cache_machine(cache_machine_config, cache_name + "_left"));
+		partitions->right.push_back(ral::cache::create_cache_machine(cache_machine_config, cache_name + "_right"));
+	}
+
+	std::lock_guard<std::mutex> lock(hash_partitions_mutex);
+	this->hash_partitions_by_id[id] = partitions;
+	return partitions;
+}
+
+void PartwiseJoin::add_hash_partition_task(std::unique_ptr<ral::cache::CacheData> cache_data, const hash_partitions & partitions, bool left_side) {
+	std::vector<std::unique_ptr<ral::cache::CacheData>> inputs;
+	inputs.push_back(std::move(cache_data));
+	ral::execution::executor::get_instance()->add_task(
+			std::move(inputs),
+			this->output_cache(),
+			this,
+			{{"operation_type", "hash_partition"}, {"side", left_side ? "left" : "right"}, {"partitions_id", partitions.id}});
+}
+
+void PartwiseJoin::run_hybrid_hash_join(std::unique_ptr<ral::cache::CacheData> left_cache_data, std::unique_ptr<ral::cache::CacheData> right_cache_data) {
+	std::pair<bool, uint64_t> left_num_rows_estimate = this->query_graph->get_estimated_input_rows_to_cache(this->kernel_id, "input_a");
+	std::pair<bool, uint64_t> right_num_rows_estimate = this->query_graph->get_estimated_input_rows_to_cache(this->kernel_id, "input_b");
+	std::size_t num_bytes = left_num_rows_estimate.second * (left_cache_data->sizeInBytes() / left_cache_data->num_rows())
+		+ right_num_rows_estimate.second * (right_cache_data->sizeInBytes() / right_cache_data->num_rows());
+
+	if(logger) {
+		logger->debug("{query_id}|{step}|{substep}|{info}|{duration}|kernel_id|{kernel_id}||",
+									"query_id"_a=context->getContextToken(),
+									"step"_a=context->getQueryStep(),
+									"substep"_a=context->getQuerySubstep(),
+									"info"_a="PartwiseJoin using a hybrid hash join for about {} bytes"_format(num_bytes),
+									"duration"_a="",
+									"kernel_id"_a=this->get_id());
+	}
+
+	std::shared_ptr<hash_partitions> partitions = make_hash_partitions("0", 0, num_bytes);
+	add_hash_partition_task(std::move(left_cache_data), *partitions, true);
+	add_hash_partition_task(std::move(right_cache_data), *partitions, false);
+	while (this->left_input->wait_for_next()) {
+		add_hash_partition_task(this->left_input->pullCacheData(), *partitions, true);
+	}
+	while (this->right_input->wait_for_next()) {
+		add_hash_partition_task(this->right_input->pullCacheData(), *partitions, false);
+	}
+	wait_for_tasks();
+
+	join_hash_partitions(*partitions);
+}
+
+void PartwiseJoin::join_hash_partitions(const hash_partitions & partitions) {
+	for (std::size_t i = 0; i < partitions.left.size(); i++) {
+		auto & left_partition = partitions.left[i];
+		auto & right_partition = partitions.right[i];
+		left_partition->finish();
+		right_partition->finish();
+
+		std::size_t num_bytes = left_partition->get_num_bytes_added() + right_partition->get_num_bytes_added();
+		if (num_bytes > this->hash_partition_bytes && partitions.level + 1 < max_hash_partition_levels) {
+			std::shared_ptr<hash_partitions> sub_partitions = make_hash_partitions(partitions.id + "_" + std::to_string(i), partitions.level + 1, num_bytes);
+			for (auto & cache_data : left_partition->pull_all_cache_data()) {
+				add_hash_partition_task(std::move(cache_data), *sub_partitions, true);
+			}
+			for (auto & cache_data : right_partition->pull_all_cache_data()) {
+				add_hash_partition_task(std::move(cache_data), *sub_partitions, false);
+			}
+			wait_for_tasks();
+
+			join_hash_partitions(*sub_partitions);
+			continue;
+		}
+
+		std::vector<std::unique_ptr<ral::cache::CacheData>> inputs = left_partition->pull_all_cache_data();
+		std::size_t num_left = inputs.size();
+		for (auto & cache_data : right_partition->pull_all_cache_data()) {
+			inputs.push_back(std::move(cache_data));
+		}
+		std::size_t num_right = inputs.size() - num_left;
+
+		// a bucket without rows on one side has no rows in the result, unless the join keeps the rows of the other side
+		bool keeps_left = this->join_type == LEFT_JOIN || this->join_type == OUTER_JOIN || this->join_type == ANTI_JOIN;
+		bool keeps_right = this->join_type == RIGHT_JOIN || this->join_type == OUTER_JOIN;
+		if ((num_left == 0 && num_right == 0) || (num_left == 0 && !keeps_right) || (num_right == 0 && !keeps_left)) {
+			continue;
+		}
+
+		ral::execution::executor::get_instance()->add_task(
+				std::move(inputs),
+				this->output_cache(),
+				this,
+				{{"operation_type", "join_partition"}, {"num_left", std::to_string(num_left)}});
+	}
+
+	std::lock_guard<std::mutex> lock(hash_partitions_mutex);
+	this->hash_partitions_by_id.erase(partitions.id);
+}
+
+ral::execution::task_result PartwiseJoin::hash_partition_batch(std::vector<std::unique_ptr<ral::frame::BlazingTable>> inputs,
+	const std::map<std::string, std::string>& args) {
+	auto & batch = inputs[0];
+	bool left_side = args.at("side") == "left";
+
+	std::shared_ptr<hash_partitions> partitions;
+	{
+		std::lock_guard<std::mutex> lock(hash_partitions_mutex);
+		partitions = this->hash_partitions_by_id.at(args.at("partitions_id"));
+	}
+	auto & buckets = left_side ? partitions->left : partitions->right;
+	const std::vector<cudf::size_type> & column_indices = left_side ? this->left_column_indices : this->right_column_indices;
+
+	try{
+		if (batch->num_rows() == 0) {
+			return {ral::execution::task_status::SUCCESS, std::string(), std::vector< std::unique_ptr<ral::frame::BlazingTable> > ()};
+		}
+
+		// the keys of both sides must have the same type to hash to the same buckets
+		if (left_side && this->normalize_left){
+			ral::utilities::normalize_types(batch, this->join_column_common_types, this->left_column_indices);
+		}
+		if (!left_side && this->normalize_right){
+			ral::utilities::normalize_types(batch, this->join_column_common_types, this->right_column_indices);
+		}
+
+		// the rows came to this node hashed with the default seed, so every level hashes them with another one
+		uint32_t seed = static_cast<uint32_t>(partitions->level + 1);
+		std::unique_ptr<cudf::table> hashed_data;
+		std::vector<cudf::size_type> hashed_data_offsets;
+		std::tie(hashed_data, hashed_data_offsets) = cudf::hash_partition(batch->view(), column_indices, buckets.size(),
+			cudf::hash_id::HASH_MURMUR3, seed);
+
+		// the offsets returned by hash_partition will always start at 0, which is a value we want to ignore for cudf::split
+		std::vector<cudf::size_type> split_indexes(hashed_data_offsets.begin() + 1, hashed_data_offsets.end());
+		std::vector<cudf::table_view> partitioned = cudf::split(hashed_data->view(), split_indexes);
+
+		std::vector<std::unique_ptr<ral::frame::BlazingTable>> bucket_tables;
+		for (auto & partition : partitioned) {
+			bucket_tables.push_back(std::make_unique<ral::frame::BlazingTable>(std::make_unique<cudf::table>(partition), batch->names()));
+		}
+		for (std::size_t i = 0; i < bucket_tables.size(); i++) {
+			if (bucket_tables[i]->num_rows() > 0) {
+				buckets[i]->addToCache(std::move(bucket_tables[i]));
+			}
+		}
+	}catch(const rmm::bad_alloc& e){
+		return {ral::execution::task_status::RETRY, std::string(e.what()), std::move(inputs)};
+	}catch(const std::exception& e){
+		return {ral::execution::task_status::FAIL, std::string(e.what()), std::vector< std::unique_ptr<ral::frame::BlazingTable> > ()};
+	}
+
+	return {ral::execution::task_status::SUCCESS, std::string(), std::vector< std::unique_ptr<ral::frame::BlazingTable> > ()};
+}
+
+ral::execution::task_result PartwiseJoin::join_hash_partition(std::vector<std::unique_ptr<ral::frame::BlazingTable>> inputs,
+	const std::map<std::string, std::string>& args) {
+	std::size_t num_left = std::stoull(args.at("num_left"));
+
+	try{
+		std::vector<ral::frame::BlazingTableView> left_views, right_views;
+		for (std::size_t i = 0; i < inputs.size(); i++) {
+			(i < num_left ? left_views : right_views).push_back(inputs[i]->toBlazingTableView());
+		}
+		std::unique_ptr<ral::frame::BlazingTable> left_table = left_views.empty() ?
+			ral::utilities::create_empty_table(this->left_names, this->left_types) : ral::utilities::concatTables(left_views);
+		std::unique_ptr<ral::frame::BlazingTable> right_table = right_views.empty() ?
+			ral::utilities::create_empty_table(this->right_names, this->right_types) : ral::utilities::concatTables(right_views);
+
+		join_to_output(left_table->toBlazingTableView(), right_table->toBlazingTableView(), nullptr);
+	}catch(const rmm::bad_alloc& e){
+		return {ral::execution::task_status::RETRY, std::string(e.what()), std::move(inputs)};
+	}catch(const std::exception& e){
+		return {ral::execution::task_status::FAIL, std::string(e.what()), std::vector< std::unique_ptr<ral::frame::BlazingTable> > ()};
+	}
+
+	return {ral::execution::task_status::SUCCESS, std::string(), std::vector< std::unique_ptr<ral::frame::BlazingTable> > ()};
+}
+
+void PartwiseJoin::wait_for_tasks() {
+	{
+		std::unique_lock<std::mutex> lock(kernel_mutex);
+		kernel_cv.wait(lock,[this]{
+			return this->tasks.empty() || ral::execution::executor::get_instance()->has_exception();
+		});
+	}
+	if(auto ep = ral::execution::executor::get_instance()->last_exception()){
+		std::rethrow_exception(ep);
+	}
+}
+
 std::string PartwiseJoin::get_join_type() {
 	return join_type;
 }
@@ -651,6 +1411,16 @@ JoinPartitionKernel::JoinPartitionKernel(std::size_t kernel_id, const std::strin
 	this->output_.add_port("output_a", "output_b");
 
 	std::tie(this->expression, this->condition, this->filter_statement, this->join_type) = parseExpressionToGetTypeAndCondition(this->expression);
+
+	const blazingdb::manager::QueryConfig & config = context->getConfig();
+	this->heavy_hitter_threshold = config.join_skew_heavy_hitter_threshold.value_or(this->heavy_hitter_threshold);
+	this->enable_runtime_filter = config.enable_join_runtime_filter.value_or(this->enable_runtime_filter);
+	this->adaptive_join_wait_ms = config.join_adaptive_wait_ms.value_or(this->adaptive_join_wait_ms);
+}
+
+void JoinPartitionKernel::set_partitioning(bool hash_partitioned, bool left_partitioned, bool right_partitioned) {
+	this->hash_partitioned = hash_partitioned;
+	this->partitioned_left_right = {left_partitioned, right_partitioned};
 }
 
 // this function makes sure that the columns being joined are of the same type so that we can join them properly
@@ -724,6 +1494,14 @@ std::pair<bool, bool> JoinPartitionKernel::determine_if_we_are_scattering_a_smal
 		right_bytes_estimate = right_batch_rows == 0 ? 0 : (int64_t)(right_batch_bytes*(((double)right_num_rows_estimate.second)/right_batch_rows));
 	}
 
+	// how much extra memory consumption per node are we ok with, 500Mb by default
+	unsigned long long max_join_scatter_mem_overhead = context->getConfig().max_join_scatter_mem_overhead.value_or(500000000);
+
+	if ((left_bytes_estimate == -1 || right_bytes_estimate == -1) && this->adaptive_join_wait_ms > 0) {
+		std::tie(left_bytes_estimate, right_bytes_estimate) = replan_input_bytes_estimates(left_bytes_estimate, right_bytes_estimate,
+			max_join_scatter_mem_overhead);
+	}
+
 	context->incrementQuerySubstep();
 
 	auto& self_node = ral::communication::CommunicationData::getInstance().getSelfNode();
@@ -767,9 +1545,9 @@ std::pair<bool, bool> JoinPartitionKernel::determine_if_we_are_scattering_a_smal
 	for (auto & message_id : determination_messages_to_wait_for) {
 		auto message = this->query_graph->get_input_message_cache()->pullCacheData(message_id);
 		auto *message_with_metadata = dynamic_cast<ral::cache::CPUCacheData*>(message.get());
-		int node_idx = context->getNodeIndex(context->getNode(message_with_metadata->getMetadata().get_values()[ral::cache::SENDER_WORKER_ID_METADATA_LABEL]));
-		nodes_num_bytes_left[node_idx] = std::stoll(message_with_metadata->getMetadata().get_values()[ral::cache::JOIN_LEFT_BYTES_METADATA_LABEL]);
-		nodes_num_bytes_right[node_idx] = std::stoll(message_with_metadata->getMetadata().get_values()[ral::cache::JOIN_RIGHT_BYTES_METADATA_LABEL]);
+		int node_idx = context->getNodeIndex(context->getNode(message_with_metadata->getMetadata().get_value(ral::cache::SENDER_WORKER_ID_METADATA_LABEL)));
+		nodes_num_bytes_left[node_idx] = std::stoll(message_with_metadata->getMetadata().get_value(ral::cache::JOIN_LEFT_BYTES_METADATA_LABEL));
+		nodes_num_bytes_right[node_idx] = std::stoll(message_with_metadata->getMetadata().get_value(ral::cache::JOIN_RIGHT_BYTES_METADATA_LABEL));
 	}
 	nodes_num_bytes_left[self_node_idx] = left_bytes_estimate;
 	nodes_num_bytes_right[self_node_idx] = right_bytes_estimate;
@@ -800,8 +1578,8 @@ std::pair<bool, bool> JoinPartitionKernel::determine_if_we_are_scattering_a_smal
 	bool scatter_left = false;
 	bool scatter_right = false;
 	if (any_unknowns_left || any_unknowns_right){
-		// with CROSS_JOIN we want to scatter or or the other, no matter what, even with unknowns
-		if (this->join_type == CROSS_JOIN){
+		// with CROSS_JOIN or BAND_JOIN we want to scatter or or the other, no matter what, even with unknowns
+		if (this->join_type == CROSS_JOIN || this->join_type == BAND_JOIN){
 			if(total_bytes_left < total_bytes_right) {
 				scatter_left = true;
 			} else {
@@ -819,22 +1597,15 @@ std::pair<bool, bool> JoinPartitionKernel::determine_if_we_are_scattering_a_smal
 	int64_t estimate_scatter_left = (total_bytes_left) * (num_nodes - 1);
 	int64_t estimate_scatter_right = (total_bytes_right) * (num_nodes - 1);
 
-	unsigned long long max_join_scatter_mem_overhead = 500000000;  // 500Mb  how much extra memory consumption per node are we ok with
-	std::map<std::string, std::string> config_options = context->getConfigOptions();
-	auto it = config_options.find("MAX_JOIN_SCATTER_MEM_OVERHEAD");
-	if (it != config_options.end()){
-		max_join_scatter_mem_overhead = std::stoull(config_options["MAX_JOIN_SCATTER_MEM_OVERHEAD"]);
-	}
-
-	// with CROSS_JOIN we want to scatter or or the other
-	if (this->join_type == CROSS_JOIN){
+	// with CROSS_JOIN or BAND_JOIN we want to scatter or or the other, since there are no keys to hash
+	if (this->join_type == CROSS_JOIN || this->join_type == BAND_JOIN){
 		if(estimate_scatter_left < estimate_scatter_right) {
 			scatter_left = true;
 		} else {
 			scatter_right = true;
 		}
-	// with LEFT_JOIN we cant scatter the left side
-	} else if (this->join_type == LEFT_JOIN) {
+	// with LEFT_JOIN, SEMI_JOIN or ANTI_JOIN we cant scatter the left side
+	} else if (this->join_type == LEFT_JOIN || this->join_type == SEMI_JOIN || this->join_type == ANTI_JOIN) {
 		if(estimate_scatter_right < estimate_regular_distribution &&
 					static_cast<unsigned long long>(total_bytes_right) < max_join_scatter_mem_overhead) {
 			scatter_right = true;
@@ -854,10 +1625,189 @@ std::pair<bool, bool> JoinPartitionKernel::determine_if_we_are_scattering_a_smal
 	return std::make_pair(scatter_left, scatter_right);
 }
 
-void JoinPartitionKernel::perform_standard_hash_partitioning(
-	std::unique_ptr<ral::cache::CacheData> left_cache_data,
-	std::unique_ptr<ral::cache::CacheData> right_cache_data,
-	std::shared_ptr<ral::cache::CacheMachine> left_input,
+std::pair<int64_t, int64_t> JoinPartitionKernel::replan_input_bytes_estimates(int64_t left_bytes_estimate, int64_t right_bytes_estimate,
+	uint64_t max_scatter_bytes){
+	// an input is known when all of it has arrived, or when what has arrived is already too big to be scattered, so
+	// the bytes so far are enough to choose
+	auto replan_input = [this, max_scatter_bytes](const std::string & port_name, int64_t & bytes_estimate){
+		if (bytes_estimate == -1) {
+			ral::cache::runtime_stats stats = this->query_graph->get_input_runtime_stats(this->get_id(), port_name);
+			if (stats.finished || stats.bytes >= max_scatter_bytes) {
+				bytes_estimate = stats.bytes;
+			}
+		}
+		return bytes_estimate != -1;
+	};
+	this->query_graph->wait_for_runtime_stats([&](){
+		bool left_known = replan_input("input_a", left_bytes_estimate);
+		bool right_known = replan_input("input_b", right_bytes_estimate);
+		return left_known && right_known;
+	}, std::chrono::milliseconds(this->adaptive_join_wait_ms));
+
+	if(logger){
+		logger->trace("{query_id}|{step}|{substep}|{info}|{duration}|kernel_id|{kernel_id}||",
+									"query_id"_a=context->getContextToken(),
+									"step"_a=context->getQueryStep(),
+									"substep"_a=context->getQuerySubstep(),
+									"info"_a="replan_input_bytes_estimates left: " + std::to_string(left_bytes_estimate) + " right: " + std::to_string(right_bytes_estimate),
+									"duration"_a="",
+									"kernel_id"_a=this->get_id());
+	}
+	return std::make_pair(left_bytes_estimate, right_bytes_estimate);
+}
+
+void JoinPartitionKernel::find_heavy_hitters(std::unique_ptr<ral::cache::CacheData> & left_cache_data){
+	// a few rows tell more about the noise than about the keys
+	const cudf::size_type min_sample_rows = 1000;
+
+	auto metadata = left_cache_data->getMetadata();
+	std::unique_ptr<ral::frame::BlazingTable> sample = left_cache_data->decache();
+	std::vector<std::string> key_names;
+	for (auto index : this->left_column_indices) {
+		key_names.push_back(sample->names()[index]);
+	}
+	std::unique_ptr<ral::frame::BlazingTable> keys = ral::frame::BlazingTableView(sample->view().select(this->left_column_indices), key_names).clone();
+	left_cache_data = std::make_unique<ral::cache::GPUCacheData>(std::move(sample), metadata);
+
+	std::vector<cudf::size_type> key_indices(keys->num_columns());
+	std::iota(key_indices.begin(), key_indices.end(), 0);
+	if (this->normalize_left) {
+		ral::utilities::normalize_types(keys, join_column_common_types, key_indices);
+	}
+	std::unique_ptr<ral::frame::BlazingTable> local_heavy_hitters = keys->num_rows() >= min_sample_rows ?
+		ral::distribution::getHeavyHitterKeys(keys->toBlazingTableView(), key_indices, this->heavy_hitter_threshold) :
+		ral::utilities::create_empty_table(keys->toBlazingTableView());
+
+	// every node sends its heavy hitters to the others, and all of them use the same union of them
+	auto& self_node = ral::communication::CommunicationData::getInstance().getSelfNode();
+	auto nodes_to_send = context->getAllOtherNodes(context->getNodeIndex(self_node));
+	std::vector<std::string> target_ids;
+	std::vector<std::string> messages_to_wait_for;
+	for (auto & node_to_send : nodes_to_send) {
+		target_ids.push_back(node_to_send.id());
+		messages_to_wait_for.push_back(
+			"heavy_hitters_" + std::to_string(this->context->getContextToken()) + "_" + std::to_string(this->get_id()) + "_" + node_to_send.id());
+	}
+	send_message(local_heavy_hitters->toBlazingTableView().clone(),
+		false, //specific_cache
+		"", //cache_id
+		target_ids, //target_ids
+		"heavy_hitters_", //message_id_prefix
+		true); //always_add
+
+	std::vector<std::unique_ptr<ral::frame::BlazingTable>> all_heavy_hitters;
+	all_heavy_hitters.push_back(std::move(local_heavy_hitters));
+	for (auto & message_id : messages_to_wait_for) {
+		auto message = this->query_graph->get_input_message_cache()->pullCacheData(message_id);
+		all_heavy_hitters.push_back(message->decache());
+	}
+	auto heavy_hitters = ral::utilities::concatTables(std::move(all_heavy_hitters));
+	if (heavy_hitters->num_rows() == 0) {
+		return;
+	}
+
+	std::unique_ptr<cudf::table> unique_keys = cudf::drop_duplicates(heavy_hitters->view(), key_indices, cudf::duplicate_keep_option::KEEP_FIRST);
+	this->heavy_hitter_keys = std::make_unique<ral::frame::BlazingTable>(std::move(unique_keys), key_names);
+
+	if(logger) {
+		logger->debug("{query_id}|{step}|{substep}|{info}||kernel_id|{kernel_id}||",
+								"query_id"_a=context->getContextToken(),
+								"step"_a=context->getQueryStep(),
+								"substep"_a=context->getQuerySubstep(),
+								"info"_a="JoinPartitionKernel found " + std::to_string(this->heavy_hitter_keys->num_rows()) + " heavy hitter keys",
+								"kernel_id"_a=this->get_id());
+	}
+}
+
+void JoinPartitionKernel::create_runtime_filter(const ral::cache::CacheData & small_cache_data, const ral::cache::CacheData & big_cache_data){
+	const ral::cache::CacheData & left_cache_data = scatter_left_right.first ? small_cache_data : big_cache_data;
+	std::vector<int> column_indices;
+	parseJoinConditionToColumnIndices(condition, column_indices);
+	// the filter drops the null keys, that only match with IS NOT DISTINCT FROM
+	if (column_indices.size() != 2 || this->condition.find("IS_NOT_DISTINCT_FROM") != std::string::npos) {
+		return;
+	}
+	int left_index = column_indices[0];
+	int right_index = column_indices[1] - static_cast<int>(left_cache_data.num_columns());
+	int small_index = scatter_left_right.first ? left_index : right_index;
+	int big_index = scatter_left_right.first ? right_index : left_index;
+
+	auto small_types = small_cache_data.get_schema();
+	auto big_types = big_cache_data.get_schema();
+	if (!ral::operators::runtime_filter::is_supported_type(small_types[small_index]) ||
+			!ral::operators::runtime_filter::is_supported_type(big_types[big_index])) {
+		return;
+	}
+
+	this->runtime_filter_key_index = small_index;
+	this->runtime_filter = std::make_shared<ral::operators::runtime_filter>(big_cache_data.names()[big_index]);
+}
+
+void JoinPartitionKernel::share_runtime_filter(){
+	auto& self_node = ral::communication::CommunicationData::getInstance().getSelfNode();
+	auto nodes_to_send = context->getAllOtherNodes(context->getNodeIndex(self_node));
+	std::vector<std::string> target_ids;
+	std::vector<std::string> messages_to_wait_for;
+	for (auto & node_to_send : nodes_to_send) {
+		target_ids.push_back(node_to_send.id());
+		messages_to_wait_for.push_back(
+			"runtime_filter_" + std::to_string(this->context->getContextToken()) + "_" + std::to_string(this->get_id()) + "_" + node_to_send.id());
+	}
+
+	int64_t min, max;
+	bool has_range = this->runtime_filter->get_range(min, max);
+	ral::cache::MetadataDictionary extra_metadata;
+	extra_metadata.add_value(ral::cache::RUNTIME_FILTER_RANGE_METADATA_LABEL, has_range ? std::to_string(min) + "," + std::to_string(max) : "");
+	send_message(this->runtime_filter->get_bits(),
+		false, //specific_cache
+		"", //cache_id
+		target_ids, //target_ids
+		"runtime_filter_", //message_id_prefix
+		true, //always_add
+		false, //wait_for
+		0, //message_tracker_idx
+		extra_metadata);
+
+	for (auto & message_id : messages_to_wait_for) {
+		auto message = this->query_graph->get_input_message_cache()->pullCacheData(message_id);
+		std::string range = message->getMetadata().get_value(ral::cache::RUNTIME_FILTER_RANGE_METADATA_LABEL);
+		auto bits = message->decache();
+		int64_t other_min = 0, other_max = 0;
+		if (!range.empty()) {
+			std::vector<std::string> min_max = StringUtil::split(range, ",");
+			other_min = std::stoll(min_max[0]);
+			other_max = std::stoll(min_max[1]);
+		}
+		this->runtime_filter->merge(bits->view().column(0), !range.empty(), other_min, other_max);
+	}
+}
+
+void JoinPartitionKernel::push_runtime_filter(const std::string & port_name){
+	std::vector<std::int32_t> producers;
+	for (auto & edge : this->query_graph->get_reverse_neighbours(this->get_id())) {
+		if (edge.target_port_name == port_name) {
+			producers.push_back(edge.source);
+		}
+	}
+	// a filter keeps the names of the columns, other kernels may not
+	while (!producers.empty()) {
+		kernel * producer = this->query_graph->get_node(producers.back());
+		producers.pop_back();
+		if (producer->get_type_id() == kernel_type::TableScanKernel || producer->get_type_id() == kernel_type::BindableTableScanKernel ||
+				producer->get_type_id() == kernel_type::CachedTableScanKernel) {
+			producer->add_runtime_filter(this->runtime_filter);
+		} else if (producer->get_type_id() == kernel_type::FilterKernel) {
+			for (auto & edge : this->query_graph->get_reverse_neighbours(producer->get_id())) {
+				producers.push_back(edge.source);
+			}
+		}
+	}
+}
+
+void JoinPartitionKernel::perform_standard_hash_partitioning(
+	std::unique_ptr<ral::cache::CacheData> left_cache_data,
+	std::unique_ptr<ral::cache::CacheData> right_cache_data,
+	std::shared_ptr<ral::cache::CacheMachine> left_input,
 	std::shared_ptr<ral::cache::CacheMachine> right_input){
 
 	this->context->incrementQuerySubstep();
@@ -875,6 +1825,19 @@ void JoinPartitionKernel::perform_standard_hash_partitioning(
 
 	computeNormalizationData(left_cache_data->get_schema(), right_cache_data->get_schema());
 
+	// casting the keys changes their hash, so an input that has to be cast is hashed again. All the nodes have the same
+	// types, so they make the same choice
+	this->keep_left_right = {this->partitioned_left_right.first && !this->normalize_left,
+		this->partitioned_left_right.second && !this->normalize_right};
+
+	if (this->heavy_hitter_threshold > 0 && context->getTotalNodes() > 1 && !this->hash_partitioned &&
+			!this->keep_left_right.first && !this->keep_left_right.second &&
+			(this->join_type == INNER_JOIN || this->join_type == LEFT_JOIN)) {
+		// the left rows of a heavy hitter can be joined anywhere, as long as all the right rows that match them are there too.
+		// The right rows are broadcast, so the joins that keep the right rows that don't match would output them more than once
+		find_heavy_hitters(left_cache_data);
+	}
+
 	BlazingThread left_thread([this, &left_input, &left_cache_data](){
 		while(left_cache_data != nullptr) {
 			std::vector<std::unique_ptr<ral::cache::CacheData>> inputs;
@@ -977,6 +1940,10 @@ void JoinPartitionKernel::small_table_scatter_distribution(std::unique_ptr<ral::
 	std::string big_output_cache_name = scatter_left_right.first ? "output_b" : "output_a";
 	int big_table_idx = scatter_left_right.first ? RIGHT_TABLE_IDX : LEFT_TABLE_IDX;
 
+	if (this->enable_runtime_filter && this->join_type == INNER_JOIN) {
+		create_runtime_filter(*small_cache_data, *big_cache_data);
+	}
+
 	BlazingThread left_thread([this, &small_input, &small_cache_data, small_output_cache_name](){
 		while(small_cache_data != nullptr ) {
 			std::vector<std::unique_ptr<ral::cache::CacheData>> inputs;
@@ -992,11 +1959,36 @@ void JoinPartitionKernel::small_table_scatter_distribution(std::unique_ptr<ral::
 		}
 	});
 
+	if (this->runtime_filter != nullptr) {
+		// the big table waits for the keys of the whole small table, and from then on the scans that feed it drop
+		// the rows that can't match
+		left_thread.join();
+		{
+			std::unique_lock<std::mutex> lock(kernel_mutex);
+			kernel_cv.wait(lock,[this]{
+				return this->tasks.empty() || ral::execution::executor::get_instance()->has_exception();
+			});
+		}
+		if(auto ep = ral::execution::executor::get_instance()->last_exception()){
+			std::rethrow_exception(ep);
+		}
+		share_runtime_filter();
+		push_runtime_filter(scatter_left_right.first ? "input_b" : "input_a");
+	}
+
 	BlazingThread right_thread([this, &big_input, &big_cache_data, big_output_cache_name, big_table_idx](){
 
 		while (big_cache_data != nullptr) {
 			
-			bool added = this->add_to_output_cache(std::move(big_cache_data), big_output_cache_name);
+			bool added;
+			if (this->runtime_filter != nullptr) {
+				// the batches that were scanned before the filter was pushed
+				std::unique_ptr<ral::frame::BlazingTable> batch = big_cache_data->decache();
+				std::unique_ptr<ral::frame::BlazingTable> filtered = this->runtime_filter->apply(batch->toBlazingTableView());
+				added = this->add_to_output_cache(filtered != nullptr ? std::move(filtered) : std::move(batch), big_output_cache_name);
+			} else {
+				added = this->add_to_output_cache(std::move(big_cache_data), big_output_cache_name);
+			}
 			if (added) {
 				auto& self_node = ral::communication::CommunicationData::getInstance().getSelfNode();
 				increment_node_count(self_node.id(), big_table_idx);
@@ -1006,7 +1998,9 @@ void JoinPartitionKernel::small_table_scatter_distribution(std::unique_ptr<ral::
 		}
 	});
 
-	left_thread.join();
+	if (this->runtime_filter == nullptr) {
+		left_thread.join();
+	}
 	right_thread.join();
 
 	if(logger) {
@@ -1059,6 +2053,10 @@ ral::execution::task_result JoinPartitionKernel::do_process(std::vector<std::uni
 			std::string small_output_cache_name = scatter_left_right.first ? "output_a" : "output_b";
 			int small_table_idx = scatter_left_right.first ? LEFT_TABLE_IDX : RIGHT_TABLE_IDX;
 
+			if (this->runtime_filter != nullptr) {
+				this->runtime_filter->add(input->view().column(this->runtime_filter_key_index));
+			}
+
 			broadcast(std::move(input),
 				this->output_.get_cache(small_output_cache_name).get(),
 				"", //message_id_prefix
@@ -1067,57 +2065,68 @@ ral::execution::task_result JoinPartitionKernel::do_process(std::vector<std::uni
 			);
 		} else if (operation_type == "hash_partition") {
 			bool normalize_types;
+			bool keep;
 			int table_idx;
 			std::string cache_id;
 			std::vector<cudf::size_type> column_indices;
 			if(args.at("side") == "left"){
 				normalize_types = this->normalize_left;
+				keep = this->keep_left_right.first;
 				table_idx = LEFT_TABLE_IDX;
 				cache_id = "output_a";
 				column_indices = this->left_column_indices;
 			} else {
 				normalize_types = this->normalize_right;
+				keep = this->keep_left_right.second;
 				table_idx = RIGHT_TABLE_IDX;
 				cache_id = "output_b";
 				column_indices = this->right_column_indices;
 			}
 
+			if (keep) {
+				// the batch is already in the node that its keys hash to
+				input_consumed = true;
+				bool added = this->output_.get_cache(cache_id)->addToCache(std::move(input), "", false);
+				if (added) {
+					increment_node_count(ral::communication::CommunicationData::getInstance().getSelfNode().id(), table_idx);
+				}
+				return {ral::execution::task_status::SUCCESS, std::string(), std::vector< std::unique_ptr<ral::frame::BlazingTable> > ()};
+			}
+
 			if (normalize_types) {
 				ral::utilities::normalize_types(input, join_column_common_types, column_indices);
 			}
 
-			auto batch_view = input->view();
-			std::unique_ptr<cudf::table> hashed_data;
-			std::vector<cudf::table_view> partitioned;
-			if (input->num_rows() > 0) {
-				// When is cross_join. `column_indices` is equal to 0, so we need all `batch` columns to apply cudf::hash_partition correctly
-				if (column_indices.size() == 0) {
-					column_indices.resize(input->num_columns());
-					std::iota(std::begin(column_indices), std::end(column_indices), 0);
-				}
-
-				int num_partitions = context->getTotalNodes();
-				std::vector<cudf::size_type> hased_data_offsets;
-				std::tie(hashed_data, hased_data_offsets) = cudf::hash_partition(batch_view, column_indices, num_partitions);
-				assert(hased_data_offsets.begin() != hased_data_offsets.end());
-
-				// the offsets returned by hash_partition will always start at 0, which is a value we want to ignore for cudf::split
-				std::vector<cudf::size_type> split_indexes(hased_data_offsets.begin() + 1, hased_data_offsets.end());
-				partitioned = cudf::split(hashed_data->view(), split_indexes);
-			} else {
-				for(int i = 0; i < context->getTotalNodes(); i++){
-					partitioned.push_back(batch_view);
+			if (this->heavy_hitter_keys != nullptr && input->num_rows() > 0) {
+				std::unique_ptr<ral::frame::BlazingTable> heavy_hitters;
+				std::tie(heavy_hitters, input) = ral::distribution::splitHeavyHitters(input->toBlazingTableView(), column_indices,
+					this->heavy_hitter_keys->toBlazingTableView());
+				if (heavy_hitters->num_rows() > 0) {
+					if (args.at("side") == "left") {
+						bool added = this->output_.get_cache(cache_id)->addToCache(std::move(heavy_hitters), "", false);
+						if (added) {
+							increment_node_count(ral::communication::CommunicationData::getInstance().getSelfNode().id(), table_idx);
+						}
+					} else {
+						broadcast(std::move(heavy_hitters),
+							this->output_.get_cache(cache_id).get(),
+							"", //message_id_prefix
+							cache_id, //cache_id
+							table_idx //message_tracker_idx
+						);
+					}
 				}
 			}
 
-			std::vector<ral::frame::BlazingTableView> partitions;
-			for(auto partition : partitioned) {
-				partitions.push_back(ral::frame::BlazingTableView(partition, input->names()));
+			// When is cross_join. `column_indices` is equal to 0, so we need all `batch` columns to apply cudf::hash_partition correctly
+			if (column_indices.size() == 0) {
+				column_indices.resize(input->num_columns());
+				std::iota(std::begin(column_indices), std::end(column_indices), 0);
 			}
 
-			scatter(partitions,
+			scatter_hash_partitions(input->toBlazingTableView(),
+				column_indices,
 				this->output_.get_cache(cache_id).get(),
-				"", //message_id_prefix
 				cache_id, //cache_id
 				table_idx  //message_tracker_idx
 			);
@@ -1162,7 +2171,7 @@ kstatus JoinPartitionKernel::run() {
 		RAL_FAIL("In JoinPartitionKernel left side is empty and cannot determine join column indices");
 	}
 
-	if (this->join_type != OUTER_JOIN){
+	if (this->join_type != OUTER_JOIN && !this->hash_partitioned){
 		// can't scatter a full outer join
 		scatter_left_right = determine_if_we_are_scattering_a_small_table(*left_cache_data, *right_cache_data);
 	}
@@ -1227,5 +2236,529 @@ std::string JoinPartitionKernel::get_join_type() {
 
 // END JoinPartitionKernel
 
+// BEGIN SortMergeJoinKernel
+
+SortMergeJoinKernel::SortMergeJoinKernel(std::size_t kernel_id, const std::string & queryString, std::shared_ptr<Context> context, std::shared_ptr<ral::cache::graph> query_graph)
+	: kernel{kernel_id, queryString, context, kernel_type::SortMergeJoinKernel} {
+	this->query_graph = query_graph;
+	this->input_.add_port("input_a", "input_b");
+
+	ral::cache::cache_settings cache_machine_config;
+	cache_machine_config.type = ral::cache::CacheType::SIMPLE;
+	cache_machine_config.context = context->clone();
+	this->leftArrayCache = ral::cache::create_cache_machine(cache_machine_config, std::to_string(this->get_id()) + "_left_array");
+	this->rightArrayCache = ral::cache::create_cache_machine(cache_machine_config, std::to_string(this->get_id()) + "_right_array");
+
+	std::tie(this->expression, this->condition, this->filter_statement, this->join_type) = parseExpressionToGetTypeAndCondition(this->expression);
+	RAL_EXPECTS(this->join_type == INNER_JOIN, "SortMergeJoin only supports inner joins");
+}
+
+bool SortMergeJoinKernel::can_join(const std::string & join_expression, const std::string & left_expression, const std::string & right_expression) {
+	if (!is_sort(left_expression) || !is_sort(right_expression)
+		|| ral::operators::has_limit_only(left_expression) || ral::operators::has_limit_only(right_expression)) {
+		return false;
+	}
+
+	std::string condition, join_type;
+	std::tie(std::ignore, condition, std::ignore, join_type) = parseExpressionToGetTypeAndCondition(join_expression);
+	if (join_type != INNER_JOIN) {
+		return false;
+	}
+	std::vector<int> column_indices;
+	parseJoinConditionToColumnIndices(condition, column_indices);
+	if (column_indices.size() != 2 || parseJoinConditionToEqualityTypes(condition) != cudf::null_equality::UNEQUAL) {
+		return false;
+	}
+
+	std::vector<int> left_sort_columns, right_sort_columns;
+	std::vector<cudf::order> left_sort_orders, right_sort_orders;
+	std::tie(left_sort_columns, left_sort_orders, std::ignore) = ral::operators::get_sort_vars(left_expression);
+	std::tie(right_sort_columns, right_sort_orders, std::ignore) = ral::operators::get_sort_vars(right_expression);
+	// the index of the right key depends on the number of columns of the left input, which is not known yet
+	return left_sort_columns.front() == column_indices[0] && left_sort_orders.front() == cudf::order::ASCENDING
+		&& right_sort_orders.front() == cudf::order::ASCENDING;
+}
+
+void SortMergeJoinKernel::setup_join_columns(const std::vector<cudf::data_type> & left_types, const std::vector<cudf::data_type> & right_types) {
+	std::vector<int> column_indices;
+	parseJoinConditionToColumnIndices(this->condition, column_indices);
+	this->left_key_index = column_indices[0];
+	this->right_key_index = column_indices[1] - left_types.size();
+
+	bool strict = true;
+	this->key_type = ral::utilities::get_common_type(left_types[this->left_key_index], right_types[this->right_key_index], strict);
+	this->normalize_left = left_types[this->left_key_index] != this->key_type;
+	this->normalize_right = right_types[this->right_key_index] != this->key_type;
+
+	this->result_types = left_types;
+	this->result_types.insert(this->result_types.end(), right_types.begin(), right_types.end());
+	this->result_types[this->left_key_index] = this->key_type;
+	this->result_types[left_types.size() + this->right_key_index] = this->key_type;
+}
+
+ral::execution::task_result SortMergeJoinKernel::make_sorted_run(std::vector<std::unique_ptr<ral::frame::BlazingTable>> inputs, bool left_side, int index) {
+	auto & batch = inputs[0];
+	cudf::size_type key_index = left_side ? this->left_key_index : this->right_key_index;
+
+	try{
+		if ((left_side && this->normalize_left) || (!left_side && this->normalize_right)) {
+			ral::utilities::normalize_types(batch, {this->key_type}, {key_index});
+		}
+		// the rows with null keys can't match in an inner join
+		if (batch->view().column(key_index).null_count() > 0) {
+			batch = std::make_unique<ral::frame::BlazingTable>(cudf::drop_nulls(batch->view(), {key_index}), batch->names());
+		}
+		if (batch->num_rows() == 0) {
+			return {ral::execution::task_status::SUCCESS, std::string(), std::vector< std::unique_ptr<ral::frame::BlazingTable> > ()};
+		}
+
+		cudf::table_view keys = batch->view().select({key_index});
+		if (!cudf::is_sorted(keys, {cudf::order::ASCENDING}, {cudf::null_order::AFTER})) {
+			batch = std::make_unique<ral::frame::BlazingTable>(
+				cudf::sort_by_key(batch->view(), keys, {cudf::order::ASCENDING}, {cudf::null_order::AFTER}), batch->names());
+		}
+
+		// the range of the keys that can't be read as integers covers every key, so the run is joined with all the others
+		sorted_run run{index, std::numeric_limits<int64_t>::min(), std::numeric_limits<int64_t>::max()};
+		if (ral::operators::runtime_filter::is_supported_type(this->key_type)) {
+			std::unique_ptr<cudf::column> casted_keys = cudf::cast(batch->view().column(key_index), cudf::data_type{cudf::type_id::INT64});
+			auto keys_range = cudf::minmax(casted_keys->view());
+			run.min = static_cast<cudf::numeric_scalar<int64_t> *>(keys_range.first.get())->value();
+			run.max = static_cast<cudf::numeric_scalar<int64_t> *>(keys_range.second.get())->value();
+		}
+
+		(left_side ? this->leftArrayCache : this->rightArrayCache)->put(index, std::move(batch));
+		std::lock_guard<std::mutex> lock(runs_mutex);
+		(left_side ? this->left_runs : this->right_runs).push_back(run);
+	}catch(const rmm::bad_alloc& e){
+		return {ral::execution::task_status::RETRY, std::string(e.what()), std::move(inputs)};
+	}catch(const std::exception& e){
+		return {ral::execution::task_status::FAIL, std::string(e.what()), std::vector< std::unique_ptr<ral::frame::BlazingTable> > ()};
+	}
+
+	return {ral::execution::task_status::SUCCESS, std::string(), std::vector< std::unique_ptr<ral::frame::BlazingTable> > ()};
+}
+
+std::unique_ptr<ral::frame::BlazingTable> SortMergeJoinKernel::merge_join(const ral::frame::BlazingTableView & left_run, const ral::frame::BlazingTableView & right_run) {
+	cudf::table_view left_keys = left_run.view().select({this->left_key_index});
+	cudf::table_view right_keys = right_run.view().select({this->right_key_index});
+
+	// the right rows that match every left row are the range between its lower and its upper bound in the right run
+	std::unique_ptr<cudf::column> lower = cudf::lower_bound(right_keys, left_keys, {cudf::order::ASCENDING}, {cudf::null_order::AFTER});
+	std::unique_ptr<cudf::column> upper = cudf::upper_bound(right_keys, left_keys, {cudf::order::ASCENDING}, {cudf::null_order::AFTER});
+	cudf::data_type index_type{cudf::type_id::INT32};
+	std::unique_ptr<cudf::column> counts = cudf::binary_operation(upper->view(), lower->view(), cudf::binary_operator::SUB, index_type);
+
+	std::unique_ptr<cudf::column> left_map, right_map;
+	std::tie(left_map, right_map) = expand_match_ranges(lower->view(), counts->view());
+
+	std::vector<std::unique_ptr<cudf::column>> columns = cudf::gather(left_run.view(), left_map->view())->release();
+	std::vector<std::unique_ptr<cudf::column>> right_columns = cudf::gather(right_run.view(), right_map->view())->release();
+	std::move(right_columns.begin(), right_columns.end(), std::back_inserter(columns));
+	return std::make_unique<ral::frame::BlazingTable>(std::make_unique<cudf::table>(std::move(columns)), this->result_names);
+}
+
+ral::execution::task_result SortMergeJoinKernel::do_process(std::vector<std::unique_ptr<ral::frame::BlazingTable>> inputs,
+	std::shared_ptr<ral::cache::CacheMachine> /*output*/,
+	cudaStream_t /*stream*/, const std::map<std::string, std::string>& args) {
+	const std::string & operation_type = args.at("operation_type");
+	if (operation_type == "sort_run") {
+		return make_sorted_run(std::move(inputs), args.at("side") == "left", std::stoi(args.at("index")));
+	}
+
+	auto & left_run = inputs[0];
+	auto & right_run = inputs[1];
+	try{
+		std::unique_ptr<ral::frame::BlazingTable> joined = merge_join(left_run->toBlazingTableView(), right_run->toBlazingTableView());
+		if (filter_statement != "") {
+			joined = ral::processor::process_filter(joined->toBlazingTableView(), filter_statement, this->context.get());
+		}
+		this->add_to_output_cache(std::move(joined));
+	}catch(const rmm::bad_alloc& e){
+		return {ral::execution::task_status::RETRY, std::string(e.what()), std::move(inputs)};
+	}catch(const std::exception& e){
+		return {ral::execution::task_status::FAIL, std::string(e.what()), std::vector< std::unique_ptr<ral::frame::BlazingTable> > ()};
+	}
+
+	try{
+		this->leftArrayCache->put(std::stoi(args.at("left_idx")), std::move(left_run));
+		this->rightArrayCache->put(std::stoi(args.at("right_idx")), std::move(right_run));
+	}catch(const rmm::bad_alloc& e){
+		return {ral::execution::task_status::RETRY, std::string(e.what()), std::move(inputs)};
+	}catch(const std::exception& e){
+		return {ral::execution::task_status::FAIL, std::string(e.what()), std::vector< std::unique_ptr<ral::frame::BlazingTable> > ()};
+	}
+
+	return {ral::execution::task_status::SUCCESS, std::string(), std::vector< std::unique_ptr<ral::frame::BlazingTable> > ()};
+}
+
+void SortMergeJoinKernel::wait_for_tasks() {
+	{
+		std::unique_lock<std::mutex> lock(kernel_mutex);
+		kernel_cv.wait(lock,[this]{
+			return this->tasks.empty() || ral::execution::executor::get_instance()->has_exception();
+		});
+	}
+	if(auto ep = ral::execution::executor::get_instance()->last_exception()){
+		std::rethrow_exception(ep);
+	}
+}
+
+kstatus SortMergeJoinKernel::run() {
+	CodeTimer timer;
+
+	auto left_input = this->input_.get_cache("input_a");
+	auto right_input = this->input_.get_cache("input_b");
+
+	auto add_sort_run_task = [this](std::unique_ptr<ral::cache::CacheData> cache_data, bool left_side, int index){
+		std::vector<std::unique_ptr<ral::cache::CacheData>> inputs;
+		inputs.push_back(std::move(cache_data));
+		ral::execution::executor::get_instance()->add_task(
+				std::move(inputs),
+				this->output_cache(),
+				this,
+				{{"operation_type", "sort_run"}, {"side", left_side ? "left" : "right"}, {"index", std::to_string(index)}});
+	};
+
+	// every batch is made into a sorted run as it arrives, and the runs are joined once both inputs are finished. The
+	// join columns are set up from the first batches of both inputs before any of them is sorted, and when an input has
+	// no batch at all the result of the inner join is empty, so the batches of the other input are dropped
+	int num_left = 0, num_right = 0;
+	bool has_left = left_input->wait_for_next();
+	bool has_right = right_input->wait_for_next();
+	bool joining = has_left && has_right;
+	if (joining) {
+		std::unique_ptr<ral::cache::CacheData> left_cache_data = left_input->pullCacheData();
+		std::unique_ptr<ral::cache::CacheData> right_cache_data = right_input->pullCacheData();
+		std::vector<std::string> left_names = left_cache_data->names();
+		std::vector<std::string> right_names = right_cache_data->names();
+		this->result_names = left_names;
+		this->result_names.insert(this->result_names.end(), right_names.begin(), right_names.end());
+		setup_join_columns(left_cache_data->get_schema(), right_cache_data->get_schema());
+
+		add_sort_run_task(std::move(left_cache_data), true, num_left++);
+		add_sort_run_task(std::move(right_cache_data), false, num_right++);
+	}
+	while (left_input->wait_for_next()) {
+		std::unique_ptr<ral::cache::CacheData> cache_data = left_input->pullCacheData();
+		if (joining) {
+			add_sort_run_task(std::move(cache_data), true, num_left++);
+		}
+	}
+	while (right_input->wait_for_next()) {
+		std::unique_ptr<ral::cache::CacheData> cache_data = right_input->pullCacheData();
+		if (joining) {
+			add_sort_run_task(std::move(cache_data), false, num_right++);
+		}
+	}
+	wait_for_tasks();
+
+	// the runs of both sides are walked in the order of their keys, so every left run is joined with the right runs
+	// that overlap it, one after the other
+	auto by_range = [](const sorted_run & a, const sorted_run & b){ return a.min < b.min || (a.min == b.min && a.max < b.max); };
+	std::sort(this->left_runs.begin(), this->left_runs.end(), by_range);
+	std::sort(this->right_runs.begin(), this->right_runs.end(), by_range);
+	std::size_t num_pairs = 0;
+	std::size_t first_right = 0;
+	for (auto & left_run : this->left_runs) {
+		// the right runs before first_right end before this left run, so they end before all the following ones too
+		while (first_right < this->right_runs.size() && this->right_runs[first_right].max < left_run.min) {
+			first_right++;
+		}
+		for (std::size_t j = first_right; j < this->right_runs.size() && this->right_runs[j].min <= left_run.max; j++) {
+			auto & right_run = this->right_runs[j];
+			if (right_run.max < left_run.min) {
+				continue;
+			}
+			std::vector<std::unique_ptr<ral::cache::CacheData>> inputs;
+			inputs.push_back(this->leftArrayCache->get_or_wait_CacheData(left_run.index));
+			inputs.push_back(this->rightArrayCache->get_or_wait_CacheData(right_run.index));
+			ral::execution::executor::get_instance()->add_task(
+					std::move(inputs),
+					this->output_cache(),
+					this,
+					{{"operation_type", "join_runs"}, {"left_idx", std::to_string(left_run.index)}, {"right_idx", std::to_string(right_run.index)}});
+			num_pairs++;
+		}
+	}
+
+	if (num_pairs == 0 && !this->result_names.empty()) {
+		// the kernels that follow still need the schema of the result
+		this->add_to_output_cache(ral::utilities::create_empty_table(this->result_names, this->result_types));
+	}
+
+	if(logger) {
+		logger->debug("{query_id}|{step}|{substep}|{info}|{duration}|kernel_id|{kernel_id}||",
+									"query_id"_a=context->getContextToken(),
+									"step"_a=context->getQueryStep(),
+									"substep"_a=context->getQuerySubstep(),
+									"info"_a="SortMergeJoin Kernel joining {} pairs of {} left and {} right runs"_format(num_pairs, this->left_runs.size(), this->right_runs.size()),
+									"duration"_a=timer.elapsed_time(),
+									"kernel_id"_a=this->get_id());
+	}
+
+	wait_for_tasks();
+
+	if(logger) {
+		logger->debug("{query_id}|{step}|{substep}|{info}|{duration}|kernel_id|{kernel_id}||",
+									"query_id"_a=context->getContextToken(),
+									"step"_a=context->getQueryStep(),
+									"substep"_a=context->getQuerySubstep(),
+									"info"_a="SortMergeJoin Kernel Completed",
+									"duration"_a=timer.elapsed_time(),
+									"kernel_id"_a=this->get_id());
+	}
+
+	// these are intra kernel caches. We want to make sure they are empty before we finish.
+	this->leftArrayCache->clear();
+	this->rightArrayCache->clear();
+
+	return kstatus::proceed;
+}
+
+// END SortMergeJoinKernel
+
+// BEGIN StarJoinKernel
+
+StarJoinKernel::StarJoinKernel(std::size_t kernel_id, const std::string & queryString, std::shared_ptr<Context> context, std::shared_ptr<ral::cache::graph> query_graph)
+	: kernel{kernel_id, queryString, context, kernel_type::StarJoinKernel} {
+	this->query_graph = query_graph;
+	// the fact input is input_a and the dimensions are the following ports, as the children of the plan
+	int num_dimensions = std::stoi(get_named_expression(this->expression, "dimensions"));
+	for (int i = 0; i <= num_dimensions; i++) {
+		this->input_.register_port(std::string("input_") + static_cast<char>('a' + i));
+	}
+}
+
+bool StarJoinKernel::can_join(const std::string & join_expression) {
+	std::string condition, filter_statement, join_type;
+	std::tie(std::ignore, condition, filter_statement, join_type) = parseExpressionToGetTypeAndCondition(join_expression);
+	if (join_type != INNER_JOIN || !filter_statement.empty()) {
+		return false;
+	}
+	try {
+		std::vector<int> column_indices;
+		parseJoinConditionToColumnIndices(condition, column_indices);
+		return !column_indices.empty();
+	} catch (const std::exception &) {
+		return false;
+	}
+}
+
+void StarJoinKernel::add_dimension_join(const std::string & join_expression) {
+	dimension dim;
+	std::tie(std::ignore, dim.condition, std::ignore, std::ignore) = parseExpressionToGetTypeAndCondition(join_expression);
+	dim.compare_nulls = parseJoinConditionToEqualityTypes(dim.condition);
+	this->dimensions.push_back(std::move(dim));
+}
+
+bool StarJoinKernel::read_dimensions() {
+	bool has_schemas = true;
+	for (std::size_t i = 0; i < this->dimensions.size(); i++) {
+		auto dimension_input = this->input_.get_cache(std::string("input_") + static_cast<char>('b' + i));
+		std::vector<std::unique_ptr<ral::frame::BlazingTable>> batches;
+		while (dimension_input->wait_for_next()) {
+			batches.push_back(dimension_input->pullCacheData()->decache());
+		}
+		if (batches.empty()) {
+			has_schemas = false;
+			continue;
+		}
+		this->dimensions[i].table = batches.size() == 1 ? std::move(batches[0]) : ral::utilities::concatTables(std::move(batches));
+	}
+	return has_schemas;
+}
+
+void StarJoinKernel::build_dimensions(const std::vector<std::string> & fact_names, const std::vector<cudf::data_type> & fact_types) {
+	this->result_names = fact_names;
+	this->result_types = fact_types;
+	this->source_offsets = {0};
+	bool strict = true;
+	for (auto & dim : this->dimensions) {
+		std::size_t num_probe_columns = this->result_names.size();
+		this->source_offsets.push_back(num_probe_columns);
+
+		std::vector<int> column_indices;
+		parseJoinConditionToColumnIndices(dim.condition, column_indices);
+		std::vector<cudf::data_type> dimension_types = dim.table->get_schema();
+		for (std::size_t i = 0; i < column_indices.size(); i += 2) {
+			RAL_EXPECTS(static_cast<std::size_t>(column_indices[i]) < num_probe_columns && static_cast<std::size_t>(column_indices[i + 1]) >= num_probe_columns,
+				"In StarJoin: the condition of a join does not compare a column of each of its inputs");
+			cudf::size_type probe_index = column_indices[i];
+			cudf::size_type build_index = column_indices[i + 1] - num_probe_columns;
+			dim.probe_column_indices.push_back(probe_index);
+			dim.build_column_indices.push_back(build_index);
+			dim.key_types.push_back(ral::utilities::get_common_type(this->result_types[probe_index], dimension_types[build_index], strict));
+		}
+
+		cudf::table_view build_keys = dim.table->view().select(dim.build_column_indices);
+		std::vector<std::unique_ptr<cudf::column>> casted_columns;
+		bool cast = false;
+		for (std::size_t i = 0; i < dim.key_types.size(); i++) {
+			cast = cast || build_keys.column(i).type() != dim.key_types[i];
+		}
+		if (cast) {
+			for (std::size_t i = 0; i < dim.key_types.size(); i++) {
+				casted_columns.push_back(cudf::cast(build_keys.column(i), dim.key_types[i]));
+			}
+			dim.casted_keys = std::make_unique<cudf::table>(std::move(casted_columns));
+			build_keys = dim.casted_keys->view();
+		}
+		std::vector<cudf::size_type> key_indices(build_keys.num_columns());
+		std::iota(key_indices.begin(), key_indices.end(), 0);
+		if (dim.table->num_rows() > 0) {
+			dim.hash_table = std::make_unique<cudf::hash_join>(build_keys, key_indices, dim.compare_nulls);
+		}
+
+		std::vector<std::string> dimension_names = dim.table->names();
+		this->result_names.insert(this->result_names.end(), dimension_names.begin(), dimension_names.end());
+		this->result_types.insert(this->result_types.end(), dimension_types.begin(), dimension_types.end());
+	}
+}
+
+std::unique_ptr<ral::frame::BlazingTable> StarJoinKernel::probe(const ral::frame::BlazingTableView & fact) {
+	std::vector<cudf::table_view> sources = {fact.view()};
+	for (auto & dim : this->dimensions) {
+		sources.push_back(dim.table->view());
+	}
+
+	// the rows of every input that make the rows joined so far, nullptr for the fact input while it has all its rows
+	std::vector<std::unique_ptr<cudf::column>> maps(sources.size());
+	cudf::size_type num_rows = fact.num_rows();
+	for (std::size_t k = 0; k < this->dimensions.size() && num_rows > 0; k++) {
+		const dimension & dim = this->dimensions[k];
+
+		std::vector<std::unique_ptr<cudf::column>> gathered_keys;
+		std::vector<cudf::column_view> probe_keys;
+		for (std::size_t i = 0; i < dim.probe_column_indices.size(); i++) {
+			std::size_t source = std::upper_bound(this->source_offsets.begin(), this->source_offsets.end(), dim.probe_column_indices[i]) - this->source_offsets.begin() - 1;
+			cudf::column_view key = sources[source].column(dim.probe_column_indices[i] - this->source_offsets[source]);
+			if (maps[source] != nullptr) {
+				gathered_keys.push_back(std::move(cudf::gather(cudf::table_view({key}), maps[source]->view())->release()[0]));
+				key = gathered_keys.back()->view();
+			}
+			if (key.type() != dim.key_types[i]) {
+				gathered_keys.push_back(cudf::cast(key, dim.key_types[i]));
+				key = gathered_keys.back()->view();
+			}
+			probe_keys.push_back(key);
+		}
+
+		std::vector<cudf::size_type> key_indices(probe_keys.size());
+		std::iota(key_indices.begin(), key_indices.end(), 0);
+		auto join_indices = dim.hash_table->inner_join(cudf::table_view(probe_keys), key_indices, dim.compare_nulls);
+		gathered_keys.clear();
+		num_rows = join_indices.first->size();
+		cudf::column_view probe_map{cudf::data_type{cudf::type_id::INT32}, num_rows, join_indices.first->data()};
+		cudf::column_view build_map{cudf::data_type{cudf::type_id::INT32}, num_rows, join_indices.second->data()};
+
+		// the rows joined so far that matched are the map of every input before this dimension
+		for (std::size_t source = 0; source <= k; source++) {
+			maps[source] = maps[source] != nullptr ?
+				std::move(cudf::gather(cudf::table_view({maps[source]->view()}), probe_map)->release()[0]) :
+				std::make_unique<cudf::column>(probe_map);
+		}
+		maps[k + 1] = std::make_unique<cudf::column>(build_map);
+	}
+
+	if (num_rows == 0) {
+		return ral::utilities::create_empty_table(this->result_names, this->result_types);
+	}
+	std::vector<std::unique_ptr<cudf::column>> columns;
+	for (std::size_t source = 0; source < sources.size(); source++) {
+		std::vector<std::unique_ptr<cudf::column>> source_columns = cudf::gather(sources[source], maps[source]->view())->release();
+		maps[source].reset();
+		std::move(source_columns.begin(), source_columns.end(), std::back_inserter(columns));
+	}
+	return std::make_unique<ral::frame::BlazingTable>(std::make_unique<cudf::table>(std::move(columns)), this->result_names);
+}
+
+ral::execution::task_result StarJoinKernel::do_process(std::vector<std::unique_ptr<ral::frame::BlazingTable>> inputs,
+	std::shared_ptr<ral::cache::CacheMachine> /*output*/,
+	cudaStream_t /*stream*/, const std::map<std::string, std::string>& /*args*/) {
+	try{
+		this->add_to_output_cache(probe(inputs[0]->toBlazingTableView()));
+	}catch(const rmm::bad_alloc& e){
+		return {ral::execution::task_status::RETRY, std::string(e.what()), std::move(inputs)};
+	}catch(const std::exception& e){
+		return {ral::execution::task_status::FAIL, std::string(e.what()), std::vector< std::unique_ptr<ral::frame::BlazingTable> > ()};
+	}
+
+	return {ral::execution::task_status::SUCCESS, std::string(), std::vector< std::unique_ptr<ral::frame::BlazingTable> > ()};
+}
+
+void StarJoinKernel::wait_for_tasks() {
+	{
+		std::unique_lock<std::mutex> lock(kernel_mutex);
+		kernel_cv.wait(lock,[this]{
+			return this->tasks.empty() || ral::execution::executor::get_instance()->has_exception();
+		});
+	}
+	if(auto ep = ral::execution::executor::get_instance()->last_exception()){
+		std::rethrow_exception(ep);
+	}
+}
+
+kstatus StarJoinKernel::run() {
+	CodeTimer timer;
+
+	// the hash tables of the dimensions are built once the types of the keys of the fact input are known
+	bool has_schemas = read_dimensions();
+	bool has_rows = has_schemas && std::all_of(this->dimensions.begin(), this->dimensions.end(),
+		[](const dimension & dim){ return dim.table->num_rows() > 0; });
+	auto fact_input = this->input_.get_cache("input_a");
+	int num_batches = 0;
+	while (fact_input->wait_for_next()) {
+		std::unique_ptr<ral::cache::CacheData> cache_data = fact_input->pullCacheData();
+		if (this->result_names.empty() && has_schemas) {
+			build_dimensions(cache_data->names(), cache_data->get_schema());
+		}
+		if (!has_rows) {
+			// an inner join with an empty dimension has no rows
+			continue;
+		}
+		std::vector<std::unique_ptr<ral::cache::CacheData>> inputs;
+		inputs.push_back(std::move(cache_data));
+		ral::execution::executor::get_instance()->add_task(
+				std::move(inputs),
+				this->output_cache(),
+				this);
+		num_batches++;
+	}
+
+	if (num_batches == 0 && !this->result_names.empty()) {
+		// the kernels that follow still need the schema of the result
+		this->add_to_output_cache(ral::utilities::create_empty_table(this->result_names, this->result_types));
+	}
+
+	if(logger) {
+		logger->debug("{query_id}|{step}|{substep}|{info}|{duration}|kernel_id|{kernel_id}||",
+									"query_id"_a=context->getContextToken(),
+									"step"_a=context->getQueryStep(),
+									"substep"_a=context->getQuerySubstep(),
+									"info"_a="StarJoin Kernel probing {} batches against {} dimensions"_format(num_batches, this->dimensions.size()),
+									"duration"_a=timer.elapsed_time(),
+									"kernel_id"_a=this->get_id());
+	}
+
+	wait_for_tasks();
+
+	if(logger) {
+		logger->debug("{query_id}|{step}|{substep}|{info}|{duration}|kernel_id|{kernel_id}||",
+									"query_id"_a=context->getContextToken(),
+									"step"_a=context->getQueryStep(),
+									"substep"_a=context->getQuerySubstep(),
+									"info"_a="StarJoin Kernel Completed",
+									"duration"_a=timer.elapsed_time(),
+									"kernel_id"_a=this->get_id());
+	}
+
+	this->dimensions.clear();
+
+	return kstatus::proceed;
+}
+
+// END StarJoinKernel
+
 } // namespace batch
 } // namespace ral
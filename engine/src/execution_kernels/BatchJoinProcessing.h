@@ -3,6 +3,7 @@
 #include <tuple>
 #include "BatchProcessing.h"
 #include "execution_kernels/distributing_kernel.h"
+#include <cudf/join.hpp>
 
 namespace ral {
 namespace batch {
@@ -19,6 +20,9 @@ const std::string LEFT_JOIN = "left";
 const std::string RIGHT_JOIN = "right";
 const std::string OUTER_JOIN = "full";
 const std::string CROSS_JOIN = "cross";
+const std::string SEMI_JOIN = "semi"; // the left rows that have a match, only the left columns
+const std::string ANTI_JOIN = "anti"; // the left rows that have no match, only the left columns
+const std::string BAND_JOIN = "band"; // an inner join whose condition is a band_join_condition
 
 const int LEFT_TABLE_IDX = 0;
 const int RIGHT_TABLE_IDX = 1;
@@ -34,6 +38,19 @@ void parseJoinConditionToColumnIndices(const std::string & condition, std::vecto
 
 cudf::null_equality parseJoinConditionToEqualityTypes(const std::string & condition);
 
+/* A join condition that bounds a column of one table by one or two columns of the other table, like
+a.ts BETWEEN b.start AND b.end. The indices are the ones of the joined columns, and -1 is an unbounded side. */
+struct band_join_condition {
+	int point_column = -1;
+	int lower_column = -1;
+	bool lower_inclusive = true;
+	int upper_column = -1;
+	bool upper_inclusive = true;
+};
+
+// Parses a condition made of one or two comparisons between columns that bound the same column. Returns false if it is not one.
+bool parseJoinConditionToBand(const std::string & condition, band_join_condition & band);
+
 void split_inequality_join_into_join_and_filter(const std::string & join_statement, std::string & new_join_statement, std::string & filter_statement);
 
 class PartwiseJoin : public kernel {
@@ -42,14 +59,34 @@ public:
 
 	std::string kernel_name() { return "PartwiseJoin";}
 
+	/**
+	* Parses the join condition into the key columns of each side and computes the types both sides have to be normalized to.
+	* It needs the schemas of both sides, so it is called when the first pair of batches is loaded.
+	*/
+	void setup_join_columns(const std::vector<std::string> & left_names, const std::vector<cudf::data_type> & left_types,
+		const std::vector<std::string> & right_names, const std::vector<cudf::data_type> & right_types);
+
 	std::unique_ptr<ral::frame::BlazingTable> join_set(
 		const ral::frame::BlazingTableView & table_left,
 		const ral::frame::BlazingTableView & table_right);
 
+	/**
+	* Joins the rows whose point column is within the bounds of the band condition. The point column is sorted and every
+	* row of the other table matches the range of sorted points between its bounds, so the cross product is never made.
+	*/
+	std::unique_ptr<cudf::table> band_join(
+		const ral::frame::BlazingTableView & table_left,
+		const ral::frame::BlazingTableView & table_right);
+
 	ral::execution::task_result do_process(std::vector<std::unique_ptr<ral::frame::BlazingTable>> inputs,
 		std::shared_ptr<ral::cache::CacheMachine> output,
 		cudaStream_t stream, const std::map<std::string, std::string>& args) override;
 
+	/**
+	* When the output is added in chunks, a task only holds one chunk of it and the gather maps of the whole output at a time.
+	*/
+	std::size_t estimate_output_bytes(const std::vector<std::unique_ptr<ral::cache::CacheData > > & inputs) override;
+
 	kstatus run() override;
 
 	std::string get_join_type();
@@ -70,6 +107,71 @@ private:
   // This function makes sure that the columns being joined are of the same type so that we can join them properly
 	void computeNormalizationData(const	std::vector<cudf::data_type> & left_types, const std::vector<cudf::data_type> & right_types);
 
+	// A right batch with the hash table of its keys, that is probed with every left batch instead of being built again for every pair
+	struct build_side {
+		std::unique_ptr<ral::frame::BlazingTable> table;
+		std::unique_ptr<cudf::hash_join> hash_table;
+		cudf::null_equality compare_nulls;
+	};
+
+	// Returns the build side of a right batch of an inner or left join, and makes it if there is room for it. In that case
+	// the build side takes the rows of the right batch, which is left empty. Returns nullptr if the join does not use them.
+	std::shared_ptr<build_side> get_or_make_build_side(int right_ind, std::unique_ptr<ral::frame::BlazingTable> & right_batch);
+
+	// Returns true if the inner and left joins add their output in chunks of output_chunk_bytes
+	bool chunks_output() const;
+
+	// Joins two batches and adds the result to the output cache. The inner and left joins probe the hash table of the right
+	// batch, or the build side when there is one, to get the gather maps of the whole result first, which have its exact
+	// number of rows, and then gather and add it in chunks of output_chunk_bytes, so that a join with many matches per key
+	// never makes the whole result at once.
+	void join_to_output(const ral::frame::BlazingTableView & table_left, const ral::frame::BlazingTableView & table_right, const build_side * build);
+
+	// Returns true if the inner join evaluates its filter before it gathers its output, on the columns the filter uses
+	// gathered with the gather maps of the keys, so that the rest of the columns are only gathered for the rows that pass
+	// it, see ENABLE_JOIN_LATE_MATERIALIZATION
+	bool late_materializes_filter() const;
+
+	// Keeps the rows of the gather maps of an inner join that pass its filter, with the filter_column_indices of the
+	// left and the right tables gathered with them. Returns the filtered left and right maps.
+	std::unique_ptr<cudf::table> filter_gather_maps(const cudf::table_view & table_left, const cudf::table_view & table_right,
+		const cudf::column_view & left_map, const cudf::column_view & right_map);
+
+	// Applies the filter of the join, if it has one and it was not applied to the gather maps, and adds the result to the output cache
+	void add_joined_to_output(std::unique_ptr<ral::frame::BlazingTable> joined, bool filtered = false);
+
+	// The buckets of both sides of a hybrid hash join. The rows with the same keys are in the bucket with the same index
+	// of both sides, so each bucket can be joined on its own. The caches spill the buckets that don't fit in the GPU.
+	struct hash_partitions {
+		std::string id;
+		int level; // how many times the rows were partitioned, a bucket that is still too big is partitioned again
+		std::vector<std::shared_ptr<ral::cache::CacheMachine>> left;
+		std::vector<std::shared_ptr<ral::cache::CacheMachine>> right;
+	};
+
+	// A hybrid hash join is used when the estimates of both sides are bigger than JOIN_HYBRID_HASH_PARTITION_BYTES,
+	// since otherwise every right batch would be loaded again for every left batch
+	bool use_hybrid_hash_join(const ral::cache::CacheData & left_cache_data, const ral::cache::CacheData & right_cache_data);
+
+	// partitions all the batches of both inputs and then joins the buckets
+	void run_hybrid_hash_join(std::unique_ptr<ral::cache::CacheData> left_cache_data, std::unique_ptr<ral::cache::CacheData> right_cache_data);
+
+	std::shared_ptr<hash_partitions> make_hash_partitions(const std::string & id, int level, std::size_t num_bytes);
+
+	// adds a task that partitions a batch of one side into the buckets of partitions
+	void add_hash_partition_task(std::unique_ptr<ral::cache::CacheData> cache_data, const hash_partitions & partitions, bool left_side);
+
+	// adds the tasks that join every bucket, after partitioning again the ones that are too big
+	void join_hash_partitions(const hash_partitions & partitions);
+
+	ral::execution::task_result hash_partition_batch(std::vector<std::unique_ptr<ral::frame::BlazingTable>> inputs,
+		const std::map<std::string, std::string>& args);
+
+	ral::execution::task_result join_hash_partition(std::vector<std::unique_ptr<ral::frame::BlazingTable>> inputs,
+		const std::map<std::string, std::string>& args);
+
+	void wait_for_tasks();
+
 private:
 	std::shared_ptr<ral::cache::CacheMachine> left_input;
 	std::shared_ptr<ral::cache::CacheMachine> right_input;
@@ -81,6 +183,10 @@ private:
 	std::shared_ptr<ral::cache::CacheMachine> leftArrayCache;
 	std::shared_ptr<ral::cache::CacheMachine> rightArrayCache;
 
+	// the hash partition of every batch that was loaded, see HASH_PARTITIONS_PER_NODE, -1 when it has rows of any of them
+	std::vector<int> left_hash_partitions, right_hash_partitions;
+	bool can_match(int left_ind, int right_ind) const;
+
 	// parsed expression related parameters
 	std::string join_type;
 	std::string condition;
@@ -89,6 +195,30 @@ private:
 	std::vector<cudf::data_type> join_column_common_types;
 	bool normalize_left, normalize_right;
 	std::vector<std::string> result_names;
+	std::vector<std::string> left_names, right_names;
+	std::vector<cudf::data_type> left_types, right_types; // after the keys are normalized
+	band_join_condition band;
+	bool band_point_on_left = true;
+
+	// the most bytes of a chunk of the output of an inner or left join, 0 adds the whole output of a pair at once
+	std::size_t output_chunk_bytes = 0;
+	// the columns of the result that the filter uses, and its condition renumbered to them, when it is late materialized
+	std::vector<int> filter_column_indices;
+	std::string narrow_filter_condition;
+	// the rows of the left batches that were probed and the rows they output, to estimate the size of the gather maps
+	std::atomic<std::size_t> total_probe_rows{0};
+	std::atomic<std::size_t> total_output_rows{0};
+
+	// the build sides are kept until the kernel finishes, as long as they fit in JOIN_HASH_TABLE_CACHE_BYTES
+	std::mutex build_sides_mutex;
+	std::map<int, std::shared_ptr<build_side>> build_sides;
+	std::size_t build_sides_bytes = 0;
+	std::size_t max_build_sides_bytes = 0;
+
+	// the bytes of both sides that a bucket of a hybrid hash join should have, 0 disables the hybrid hash join
+	std::size_t hash_partition_bytes = 0;
+	std::mutex hash_partitions_mutex;
+	std::map<std::string, std::shared_ptr<hash_partitions>> hash_partitions_by_id;
 };
 
 
@@ -106,6 +236,16 @@ public:
 
 	std::string kernel_name() { return "JoinPartition";}
 
+	/**
+	* Sets how the inputs are partitioned, as the plan found it, see tree_processor::get_partitioning.
+	* @param hash_partitioned Both inputs are always hashed by the keys, without scattering a small table or the heavy
+	* hitters, since a consumer relies on the output being split between the nodes by the keys.
+	* @param left_partitioned The left input is already hashed by the keys, in the same order, so its batches stay in
+	* their node as long as its keys don't have to be cast.
+	* @param right_partitioned The same for the right input.
+	*/
+	void set_partitioning(bool hash_partitioned, bool left_partitioned, bool right_partitioned);
+
 private:
 	// this function makes sure that the columns being joined are of the same type so that we can join them properly
 	void computeNormalizationData(const	std::vector<cudf::data_type> & left_types, const	std::vector<cudf::data_type> & right_types);
@@ -113,6 +253,10 @@ private:
 	std::pair<bool, bool> determine_if_we_are_scattering_a_small_table(const ral::cache::CacheData& left_cache_data,
 		const ral::cache::CacheData& right_cache_data);
 
+	// waits for the sizes of the inputs whose estimates are unknown, until they are finished or too big to be scattered
+	std::pair<int64_t, int64_t> replan_input_bytes_estimates(int64_t left_bytes_estimate, int64_t right_bytes_estimate,
+		uint64_t max_scatter_bytes);
+
 	void perform_standard_hash_partitioning(
 		std::unique_ptr<ral::cache::CacheData> left_cache_data,
 		std::unique_ptr<ral::cache::CacheData> right_cache_data,
@@ -124,6 +268,18 @@ private:
 		std::shared_ptr<ral::cache::CacheMachine> small_input,
 		std::shared_ptr<ral::cache::CacheMachine> big_input);
 
+	// samples the first batch of the left table and agrees with the other nodes on the keys that are heavy hitters
+	void find_heavy_hitters(std::unique_ptr<ral::cache::CacheData> & left_cache_data);
+
+	// makes the runtime filter of the keys of the small table of an inner join, if the keys are a single integer column
+	void create_runtime_filter(const ral::cache::CacheData & small_cache_data, const ral::cache::CacheData & big_cache_data);
+
+	// merges the runtime filters of all the nodes, so that all of them have the keys of the whole small table
+	void share_runtime_filter();
+
+	// adds the runtime filter to the scans that feed an input port, through the filters between them
+	void push_runtime_filter(const std::string & port_name);
+
 private:
 	std::pair<bool, bool> scatter_left_right = {false, false};
 
@@ -134,6 +290,145 @@ private:
 	std::vector<cudf::size_type> left_column_indices, right_column_indices;
 	std::vector<cudf::data_type> join_column_common_types;
 	bool normalize_left, normalize_right;
+
+	// the left rows with these keys stay in the node they are in and the right rows that match them are broadcast,
+	// instead of hashing all of them to the same node
+	double heavy_hitter_threshold = 0.1;
+	std::unique_ptr<ral::frame::BlazingTable> heavy_hitter_keys;
+
+	// the keys of the small table of an inner join, to drop the rows of the big table that can't match before they are joined
+	// or even scanned
+	bool enable_runtime_filter = false;
+	std::shared_ptr<ral::operators::runtime_filter> runtime_filter;
+	cudf::size_type runtime_filter_key_index = -1; // of the small table
+
+	// how long the choice between scattering a small table and a hash partitioning can wait for the exact sizes of the
+	// inputs, when they can't be estimated from the first batches
+	int adaptive_join_wait_ms = 1000;
+
+	// see set_partitioning, the inputs that are kept are the partitioned ones whose keys are not cast
+	bool hash_partitioned = false;
+	std::pair<bool, bool> partitioned_left_right = {false, false};
+	std::pair<bool, bool> keep_left_right = {false, false};
+};
+
+/**
+* Joins two inputs whose batches are sorted on the join key, like the ones that come out of a sort.
+* Every batch is a sorted run with a range of keys, and only the runs of both sides whose ranges overlap are joined,
+* by searching the keys of the left run in the right one instead of hashing them. When both inputs are partitioned by
+* ranges of the key, every run overlaps a few runs of the other side, instead of being joined with all of them.
+* The rows of each joined pair of runs come out sorted on the key.
+* Only inner joins on a single equality are supported, and the rest of the condition is applied as a filter.
+*/
+class SortMergeJoinKernel : public kernel {
+public:
+	SortMergeJoinKernel(std::size_t kernel_id, const std::string & queryString, std::shared_ptr<Context> context, std::shared_ptr<ral::cache::graph> query_graph);
+
+	std::string kernel_name() { return "SortMergeJoin";}
+
+	/**
+	* Returns true if a join can be done by this kernel, given the relational algebra of the join and of its two inputs.
+	* The left input must be sorted on its key, and the right one sorted on one column. The batches of the right input that
+	* turn out not to be sorted on its key are sorted by the kernel.
+	*/
+	static bool can_join(const std::string & join_expression, const std::string & left_expression, const std::string & right_expression);
+
+	ral::execution::task_result do_process(std::vector<std::unique_ptr<ral::frame::BlazingTable>> inputs,
+		std::shared_ptr<ral::cache::CacheMachine> output,
+		cudaStream_t stream, const std::map<std::string, std::string>& args) override;
+
+	kstatus run() override;
+
+private:
+	// the index of a batch in its array cache and the range of its keys
+	struct sorted_run {
+		int index;
+		int64_t min;
+		int64_t max;
+	};
+
+	void setup_join_columns(const std::vector<cudf::data_type> & left_types, const std::vector<cudf::data_type> & right_types);
+
+	// normalizes the key of a batch, drops the rows whose key is null and sorts it on the key if it is not sorted already
+	ral::execution::task_result make_sorted_run(std::vector<std::unique_ptr<ral::frame::BlazingTable>> inputs, bool left_side, int index);
+
+	std::unique_ptr<ral::frame::BlazingTable> merge_join(const ral::frame::BlazingTableView & left_run, const ral::frame::BlazingTableView & right_run);
+
+	void wait_for_tasks();
+
+private:
+	std::string join_type;
+	std::string condition;
+	std::string filter_statement;
+	cudf::size_type left_key_index = -1, right_key_index = -1;
+	cudf::data_type key_type;
+	bool normalize_left = false, normalize_right = false;
+	std::vector<std::string> result_names;
+	std::vector<cudf::data_type> result_types;
+
+	std::mutex runs_mutex;
+	std::vector<sorted_run> left_runs, right_runs;
+	std::shared_ptr<ral::cache::CacheMachine> leftArrayCache;
+	std::shared_ptr<ral::cache::CacheMachine> rightArrayCache;
+};
+
+/**
+* Does a chain of inner equijoins ((fact JOIN d1) JOIN d2) ..., like the ones of a star schema query, in a single kernel.
+* The input_a is the fact input and the following inputs are the dimensions, the right inputs of the joins. The
+* dimensions are read whole and hashed once, and every batch of the fact input is probed against all of them one after
+* the other. Only the keys of the next dimension are gathered between the probes, with the gather maps of the inputs
+* composed at every probe, so the columns of the result are gathered once at the end instead of making the output of
+* every join.
+*/
+class StarJoinKernel : public kernel {
+public:
+	StarJoinKernel(std::size_t kernel_id, const std::string & queryString, std::shared_ptr<Context> context, std::shared_ptr<ral::cache::graph> query_graph);
+
+	std::string kernel_name() { return "StarJoin";}
+
+	/**
+	* Returns true if a join can be one of the joins of a StarJoin, which are the inner joins whose condition is only
+	* equalities of their keys.
+	*/
+	static bool can_join(const std::string & join_expression);
+
+	/**
+	* Adds the join of the next dimension, in the order of the chain from the join closest to the fact input.
+	*/
+	void add_dimension_join(const std::string & join_expression);
+
+	ral::execution::task_result do_process(std::vector<std::unique_ptr<ral::frame::BlazingTable>> inputs,
+		std::shared_ptr<ral::cache::CacheMachine> output,
+		cudaStream_t stream, const std::map<std::string, std::string>& args) override;
+
+	kstatus run() override;
+
+private:
+	struct dimension {
+		std::string condition;
+		cudf::null_equality compare_nulls;
+		std::vector<cudf::size_type> probe_column_indices; // in the columns of the fact input and the dimensions before it
+		std::vector<cudf::size_type> build_column_indices;
+		std::vector<cudf::data_type> key_types;
+		std::unique_ptr<ral::frame::BlazingTable> table;
+		std::unique_ptr<cudf::table> casted_keys; // the keys of the table, when some have to be cast to key_types
+		std::unique_ptr<cudf::hash_join> hash_table;
+	};
+
+	// reads all the batches of every dimension, returns false if one of them has no rows
+	bool read_dimensions();
+
+	void build_dimensions(const std::vector<std::string> & fact_names, const std::vector<cudf::data_type> & fact_types);
+
+	std::unique_ptr<ral::frame::BlazingTable> probe(const ral::frame::BlazingTableView & fact);
+
+	void wait_for_tasks();
+
+private:
+	std::vector<dimension> dimensions;
+	std::vector<std::size_t> source_offsets; // the first column of every input in the result, the fact input first
+	std::vector<std::string> result_names;
+	std::vector<cudf::data_type> result_types;
 };
 
 } // namespace batch
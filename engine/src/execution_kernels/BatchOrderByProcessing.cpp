@@ -5,6 +5,9 @@
 #include "parser/expression_utils.hpp"
 #include "cache_machine/CPUCacheData.h"
 #include "cache_machine/GPUCacheData.h"
+#include <deque>
+#include <numeric>
+#include <cudf/copying.hpp>
 
 namespace ral {
 namespace batch {
@@ -17,11 +20,7 @@ PartitionSingleNodeKernel::PartitionSingleNodeKernel(std::size_t kernel_id, cons
     this->input_.add_port("input_a", "input_b");
 
     if (is_window_function(this->expression)) {
-        if (window_expression_contains_partition_by(this->expression)){
-            std::tie(sortColIndices, sortOrderTypes) = ral::operators::get_vars_to_partition(this->expression);
-        } else {
-            std::tie(sortColIndices, sortOrderTypes) = ral::operators::get_vars_to_orders(this->expression);
-		}
+        std::tie(sortColIndices, sortOrderTypes) = ral::operators::get_vars_to_range_partition(this->expression);
     } else {
         std::tie(sortColIndices, sortOrderTypes, std::ignore) = ral::operators::get_sort_vars(this->expression);
     }
@@ -34,7 +33,8 @@ ral::execution::task_result PartitionSingleNodeKernel::do_process(std::vector< s
     try{
         auto & input = inputs[0];
 
-        auto partitions = ral::operators::partition_table(partitionPlan->toBlazingTableView(), input->toBlazingTableView(), this->sortOrderTypes, this->sortColIndices);
+        auto partitions = ral::operators::partition_table(partitionPlan->toBlazingTableView(), input->toBlazingTableView(), this->sortOrderTypes, this->sortColIndices,
+            !is_window_function(this->expression) || window_expression_can_split_partitions(this->expression));
 
         for (std::size_t i = 0; i < partitions.size(); i++) {
             std::string cache_id = "output_" + std::to_string(i);
@@ -136,9 +136,9 @@ void SortAndSampleKernel::make_partition_plan_task(){
             if(!(nodes[i] == ral::communication::CommunicationData::getInstance().getSelfNode())) {
                 std::string message_id = std::to_string(this->context->getContextToken()) + "_" + std::to_string(this->get_id()) + "_" + nodes[i].id();
                 auto samples_cache_data = this->query_graph->get_input_message_cache()->pullCacheData(message_id);
-                auto metadata = samples_cache_data->getMetadata();
-                total_num_rows_for_sampling += std::stoll(metadata.get_values()[ral::cache::TOTAL_TABLE_ROWS_METADATA_LABEL]);
-                total_bytes_for_sampling += std::stoll(metadata.get_values()[ral::cache::TOTAL_TABLE_ROWS_METADATA_LABEL]) * std::stoll(metadata.get_values()[ral::cache::AVG_BYTES_PER_ROW_METADATA_LABEL]);
+                const auto & metadata = samples_cache_data->getMetadata();
+                total_num_rows_for_sampling += metadata.get_total_table_rows();
+                total_bytes_for_sampling += metadata.get_total_table_rows() * metadata.get_avg_bytes_per_row();
                 sampleCacheDatas.push_back(std::move(samples_cache_data));
             }
         }
@@ -278,11 +278,7 @@ ral::execution::task_result SortAndSampleKernel::do_process(std::vector< std::un
 kstatus SortAndSampleKernel::run() {
     CodeTimer timer;
 
-    std::map<std::string, std::string> config_options = context->getConfigOptions();
-    auto it = config_options.find("MAX_ORDER_BY_SAMPLES_PER_NODE");
-    if (it != config_options.end()){
-        max_order_by_samples = std::stoi(config_options["MAX_ORDER_BY_SAMPLES_PER_NODE"]);
-    }
+    max_order_by_samples = context->getConfig().max_order_by_samples_per_node.value_or(max_order_by_samples);
 
     std::unique_ptr <ral::cache::CacheData> cache_data = this->input_cache()->pullCacheData();
     while (cache_data != nullptr) {
@@ -346,20 +342,11 @@ PartitionKernel::PartitionKernel(std::size_t kernel_id, const std::string & quer
     this->query_graph = query_graph;
     this->input_.add_port("input_a", "input_b");
 
-    std::map<std::string, std::string> config_options = context->getConfigOptions();
-    int max_num_order_by_partitions_per_node = 8;
-    auto it = config_options.find("MAX_NUM_ORDER_BY_PARTITIONS_PER_NODE");
-    if (it != config_options.end()){
-        max_num_order_by_partitions_per_node = std::stoi(config_options["MAX_NUM_ORDER_BY_PARTITIONS_PER_NODE"]);
-    }
+    int max_num_order_by_partitions_per_node = context->getConfig().max_num_order_by_partitions_per_node.value_or(8);
     set_number_of_message_trackers(max_num_order_by_partitions_per_node);
 
     if (is_window_function(this->expression)) {
-        if (window_expression_contains_partition_by(this->expression)){
-            std::tie(sortColIndices, sortOrderTypes) = ral::operators::get_vars_to_partition(this->expression);
-        } else {
-            std::tie(sortColIndices, sortOrderTypes) = ral::operators::get_vars_to_orders(this->expression);
-		}
+        std::tie(sortColIndices, sortOrderTypes) = ral::operators::get_vars_to_range_partition(this->expression);
     } else {
         std::tie(sortColIndices, sortOrderTypes, std::ignore) = ral::operators::get_sort_vars(this->expression);
     }
@@ -371,7 +358,8 @@ ral::execution::task_result PartitionKernel::do_process(std::vector< std::unique
     try{
         auto & input = inputs[0];
 
-        std::vector<ral::distribution::NodeColumnView> partitions = ral::distribution::partitionData(this->context.get(), input->toBlazingTableView(), partitionPlan->toBlazingTableView(), sortColIndices, sortOrderTypes);
+        std::vector<ral::distribution::NodeColumnView> partitions = ral::distribution::partitionData(this->context.get(), input->toBlazingTableView(), partitionPlan->toBlazingTableView(), sortColIndices, sortOrderTypes,
+            !is_window_function(this->expression) || window_expression_can_split_partitions(this->expression));
         std::vector<int32_t> part_ids(partitions.size());
         std::generate(part_ids.begin(), part_ids.end(), [count=0, num_partitions_per_node = num_partitions_per_node] () mutable { return (count++) % (num_partitions_per_node); });
 
@@ -479,6 +467,106 @@ MergeStreamKernel::MergeStreamKernel(std::size_t kernel_id, const std::string &
     std::shared_ptr<ral::cache::graph> query_graph)
     : kernel{kernel_id, queryString, context, kernel_type::MergeStreamKernel}  {
     this->query_graph = query_graph;
+
+    std::tie(sortColIndices, sortOrderTypes) = ral::operators::get_right_sorts_vars(this->expression);
+
+    this->merge_window_bytes = context->getConfig().order_by_merge_window_bytes.value_or(
+        ral::execution::executor::get_instance()->get_processing_memory_limit() / 4);
+
+    // the windows that need their whole partitions in one batch can't have them split into merge windows
+    this->can_split_output = this->merge_window_bytes > 0 && (!is_window_function(this->expression) ||
+        window_expression_can_split_partitions(this->expression) || window_expression_can_carry_partitions(this->expression));
+}
+
+void MergeStreamKernel::wait_for_merge_tasks() {
+    std::unique_lock<std::mutex> lock(kernel_mutex);
+    kernel_cv.wait(lock,[this]{
+        return this->tasks.empty() || ral::execution::executor::get_instance()->has_exception();
+    });
+
+    if(auto ep = ral::execution::executor::get_instance()->last_exception()){
+        std::rethrow_exception(ep);
+    }
+}
+
+void MergeStreamKernel::external_merge(std::vector<std::unique_ptr<ral::cache::CacheData>> runs) {
+    // the merges of the caches before this one go to the output first
+    wait_for_merge_tasks();
+
+    std::size_t run_window_bytes = std::max<std::size_t>(this->merge_window_bytes / runs.size(), 1);
+    std::vector<std::deque<std::unique_ptr<ral::cache::CacheData>>> pending(runs.size());
+    for (std::size_t i = 0; i < runs.size(); i++) {
+        pending[i].push_back(std::move(runs[i]));
+    }
+
+    // takes the next rows of a run into the GPU, what is left of a big cached table goes back to the host
+    auto load_window = [&](std::size_t i) {
+        std::unique_ptr<ral::frame::BlazingTable> table = pending[i].front()->decache();
+        pending[i].pop_front();
+        std::size_t table_bytes = table->sizeInBytes();
+        if (table_bytes > run_window_bytes && table->num_rows() > 1) {
+            cudf::size_type window_rows = std::max<cudf::size_type>(table->num_rows() * (static_cast<double>(run_window_bytes) / table_bytes), 1);
+            std::vector<CudfTableView> parts = cudf::split(table->view(), {window_rows});
+            auto rest = std::make_unique<ral::frame::BlazingTable>(std::make_unique<cudf::table>(parts[1]), table->names());
+            pending[i].push_front(std::make_unique<ral::cache::CPUCacheData>(std::move(rest)));
+            table = std::make_unique<ral::frame::BlazingTable>(std::make_unique<cudf::table>(parts[0]), table->names());
+        }
+        return table;
+    };
+
+    std::vector<std::unique_ptr<ral::frame::BlazingTable>> frontiers(runs.size());
+    std::vector<int> bound_col_indices(sortColIndices.size());
+    std::iota(bound_col_indices.begin(), bound_col_indices.end(), 0);
+    while (true) {
+        std::vector<std::unique_ptr<ral::frame::BlazingTable>> last_rows;
+        for (std::size_t i = 0; i < frontiers.size(); i++) {
+            while ((frontiers[i] == nullptr || frontiers[i]->num_rows() == 0) && !pending[i].empty()) {
+                frontiers[i] = load_window(i);
+            }
+            if (!pending[i].empty()) {
+                CudfTableView sort_columns = frontiers[i]->view().select(sortColIndices);
+                CudfTableView last_row = cudf::slice(sort_columns, {sort_columns.num_rows() - 1, sort_columns.num_rows()})[0];
+                last_rows.push_back(std::make_unique<ral::frame::BlazingTable>(std::make_unique<cudf::table>(last_row),
+                    std::vector<std::string>(sortColIndices.size())));
+            }
+        }
+
+        // without any bound every frontier is the end of its run
+        std::unique_ptr<ral::frame::BlazingTable> bound;
+        if (!last_rows.empty()) {
+            auto concatenated = ral::utilities::concatTables(std::move(last_rows));
+            bound = ral::operators::top_k(concatenated->toBlazingTableView(), bound_col_indices, sortOrderTypes, 1);
+        }
+
+        std::vector<std::unique_ptr<ral::cache::CacheData>> window;
+        for (std::size_t i = 0; i < frontiers.size(); i++) {
+            if (frontiers[i] == nullptr || frontiers[i]->num_rows() == 0) {
+                continue;
+            }
+            if (bound == nullptr) {
+                window.push_back(std::make_unique<ral::cache::GPUCacheData>(std::move(frontiers[i])));
+                continue;
+            }
+            std::vector<CudfTableView> parts = ral::operators::partition_table(bound->toBlazingTableView(),
+                frontiers[i]->toBlazingTableView(), sortOrderTypes, sortColIndices);
+            if (parts[0].num_rows() > 0) {
+                window.push_back(std::make_unique<ral::cache::GPUCacheData>(
+                    std::make_unique<ral::frame::BlazingTable>(std::make_unique<cudf::table>(parts[0]), frontiers[i]->names())));
+            }
+            frontiers[i] = std::make_unique<ral::frame::BlazingTable>(std::make_unique<cudf::table>(parts[1]), frontiers[i]->names());
+        }
+
+        if (!window.empty()) {
+            ral::execution::executor::get_instance()->add_task(
+                    std::move(window),
+                    this->output_cache(),
+                    this);
+            wait_for_merge_tasks();
+        }
+        if (bound == nullptr) {
+            break;
+        }
+    }
 }
 
 ral::execution::task_result MergeStreamKernel::do_process(std::vector< std::unique_ptr<ral::frame::BlazingTable> > inputs,
@@ -516,19 +604,28 @@ kstatus MergeStreamKernel::run() {
             auto cache_id = "input_" + std::to_string(idx);
             // This Kernel needs all of the input before it can do any output. So lets wait until all the input is available
             this->input_.get_cache(cache_id)->wait_until_finished();
+            if (this->stop_requested()) {
+                break;
+            }
             std::vector<std::unique_ptr <ral::cache::CacheData> > inputs;
 
+            std::size_t inputs_bytes = 0;
             while(this->input_.get_cache(cache_id)->wait_for_next()){
                 std::unique_ptr <ral::cache::CacheData> cache_data = this->input_.get_cache(cache_id)->pullCacheData();
                 if(cache_data != nullptr) {
+                    inputs_bytes += cache_data->sizeInBytes();
                     inputs.push_back(std::move(cache_data));
                 }
             }
 
-            ral::execution::executor::get_instance()->add_task(
-                    std::move(inputs),
-                    this->output_cache(),
-                    this);
+            if (this->can_split_output && inputs.size() > 1 && inputs_bytes > this->merge_window_bytes) {
+                external_merge(std::move(inputs));
+            } else {
+                ral::execution::executor::get_instance()->add_task(
+                        std::move(inputs),
+                        this->output_cache(),
+                        this);
+            }
 
             batch_count++;
         } catch(const std::exception& e) {
@@ -628,6 +725,10 @@ kstatus LimitKernel::run() {
     CodeTimer timer;
     CodeTimer eventTimer(false);
 
+    cudf::size_type limitRows;
+    std::tie(std::ignore, std::ignore, limitRows) = ral::operators::get_sort_vars(this->expression);
+    rows_limit = limitRows;
+
     int64_t total_batch_rows = 0;
     std::vector<std::unique_ptr<ral::cache::CacheData>> cache_vector;
     BatchSequenceBypass input_seq(this->input_cache(), this);
@@ -635,11 +736,15 @@ kstatus LimitKernel::run() {
         auto batch = input_seq.next();
         total_batch_rows += batch->num_rows();
         cache_vector.push_back(std::move(batch));
-    }
 
-    cudf::size_type limitRows;
-    std::tie(std::ignore, std::ignore, limitRows) = ral::operators::get_sort_vars(this->expression);
-    rows_limit = limitRows;
+        // in a single node the rows are not counted with the other nodes, so the kernels before this one can stop once there are enough of them
+        if (this->context->getTotalNodes() == 1 && limitRows >= 0 && total_batch_rows >= limitRows) {
+            for (auto & edge : this->query_graph->get_reverse_neighbours(this->get_id())) {
+                this->query_graph->get_node(edge.source)->request_stop();
+            }
+            break;
+        }
+    }
 
     if(this->context->getTotalNodes() > 1 && rows_limit >= 0) {
         this->context->incrementQuerySubstep();
@@ -670,7 +775,7 @@ kstatus LimitKernel::run() {
         for (std::size_t i = 0; i < limit_messages_to_wait_for.size(); i++) {
             auto meta_message = this->query_graph->get_input_message_cache()->pullCacheData(limit_messages_to_wait_for[i]);
             if(static_cast<int>(i) < context->getNodeIndex(ral::communication::CommunicationData::getInstance().getSelfNode())){
-                prev_total_rows += std::stoi(static_cast<ral::cache::CPUCacheData*>(meta_message.get())->getMetadata().get_values()[ral::cache::TOTAL_TABLE_ROWS_METADATA_LABEL]);
+                prev_total_rows += static_cast<ral::cache::CPUCacheData*>(meta_message.get())->getMetadata().get_total_table_rows();
             }
         }
         rows_limit = std::min(std::max(rows_limit - prev_total_rows, int64_t{0}), total_batch_rows);
@@ -739,5 +844,185 @@ kstatus LimitKernel::run() {
 
 // END LimitKernel
 
+// BEGIN TopKKernel
+
+TopKKernel::TopKKernel(std::size_t kernel_id, const std::string & queryString,
+    std::shared_ptr<Context> context,
+    std::shared_ptr<ral::cache::graph> query_graph)
+    : distributing_kernel{kernel_id,queryString, context, kernel_type::TopKKernel}  {
+    this->query_graph = query_graph;
+    set_number_of_message_trackers(1); //default
+
+    std::tie(sortColIndices, sortOrderTypes, num_rows_limit) = ral::operators::get_sort_vars(this->expression);
+}
+
+std::unique_ptr<ral::frame::BlazingTable> TopKKernel::merge_top_k(const std::vector<std::unique_ptr<ral::frame::BlazingTable>> & tables) {
+    std::vector<ral::frame::BlazingTableView> tables_views;
+    for (auto & table : tables) {
+        tables_views.push_back(table->toBlazingTableView());
+    }
+    auto concatenated = ral::utilities::concatTables(tables_views);
+    return ral::operators::top_k(concatenated->toBlazingTableView(), this->sortColIndices, this->sortOrderTypes, this->num_rows_limit);
+}
+
+ral::execution::task_result TopKKernel::do_process(std::vector< std::unique_ptr<ral::frame::BlazingTable> > inputs,
+    std::shared_ptr<ral::cache::CacheMachine> output,
+    cudaStream_t /*stream*/, const std::map<std::string, std::string>& args) {
+    try{
+        auto& operation_type = args.at("operation_type");
+
+        if (operation_type == "top_k") {
+            auto & input = inputs[0];
+            auto top_k = ral::operators::top_k(input->toBlazingTableView(), this->sortColIndices, this->sortOrderTypes, this->num_rows_limit);
+
+            std::vector<std::unique_ptr<ral::frame::BlazingTable>> to_merge;
+            {
+                std::lock_guard<std::mutex> lock(partial_top_k_mutex);
+                partial_top_k.push_back(std::move(top_k));
+                if (partial_top_k.size() >= max_partial_top_k) {
+                    to_merge = std::move(partial_top_k);
+                    partial_top_k.clear();
+                }
+            }
+            if (!to_merge.empty()) {
+                std::unique_ptr<ral::frame::BlazingTable> merged;
+                try {
+                    merged = merge_top_k(to_merge);
+                } catch(const rmm::bad_alloc& e) {
+                    // the first rows of this batch are already with the partials, so they are kept unmerged for the next
+                    // batch or the last merge, instead of retrying the batch
+                    std::lock_guard<std::mutex> lock(partial_top_k_mutex);
+                    partial_top_k.insert(partial_top_k.end(), std::make_move_iterator(to_merge.begin()), std::make_move_iterator(to_merge.end()));
+                    return {ral::execution::task_status::SUCCESS, std::string(), std::vector< std::unique_ptr<ral::frame::BlazingTable> > ()};
+                }
+                std::lock_guard<std::mutex> lock(partial_top_k_mutex);
+                partial_top_k.push_back(std::move(merged));
+            }
+        } else if (operation_type == "merge_top_k") {
+            // the inputs are only given up once they are merged, so that a retry gets them back
+            std::unique_ptr<ral::frame::BlazingTable> merged = inputs.size() == 1 ? std::move(inputs[0]) : merge_top_k(inputs);
+
+            if (this->context->getTotalNodes() > 1 && !this->context->isMasterNode(ral::communication::CommunicationData::getInstance().getSelfNode())) {
+                output->addToCache(std::make_unique<ral::frame::BlazingTable>(cudf::empty_like(merged->view()), merged->names()));
+
+                ral::cache::MetadataDictionary extra_metadata;
+                extra_metadata.add_value(ral::cache::TOTAL_TABLE_ROWS_METADATA_LABEL, merged->num_rows());
+                send_message(std::move(merged),
+                    false, //specific_cache
+                    "", //cache_id
+                    {this->context->getMasterNode().id()}, //target_id
+                    "", //message_id_prefix
+                    true, //always_add
+                    false, //wait_for
+                    0, //message_tracker_idx
+                    extra_metadata);
+            } else {
+                output->addToCache(std::move(merged));
+            }
+        }
+    }catch(const rmm::bad_alloc& e){
+        return {ral::execution::task_status::RETRY, std::string(e.what()), std::move(inputs)};
+    }catch(const std::exception& e){
+        return {ral::execution::task_status::FAIL, std::string(e.what()), std::vector< std::unique_ptr<ral::frame::BlazingTable> > ()};
+    }
+    return {ral::execution::task_status::SUCCESS, std::string(), std::vector< std::unique_ptr<ral::frame::BlazingTable> > ()};
+}
+
+kstatus TopKKernel::run() {
+    CodeTimer timer;
+
+    std::unique_ptr <ral::cache::CacheData> cache_data = this->input_cache()->pullCacheData();
+    while (cache_data != nullptr) {
+        std::vector<std::unique_ptr <ral::cache::CacheData> > inputs;
+        inputs.push_back(std::move(cache_data));
+
+        ral::execution::executor::get_instance()->add_task(
+                std::move(inputs),
+                this->output_cache(),
+                this,
+                {{"operation_type", "top_k"}});
+
+        cache_data = this->input_cache()->pullCacheData();
+    }
+
+    std::unique_lock<std::mutex> lock(kernel_mutex);
+    kernel_cv.wait(lock,[this]{
+        return this->tasks.empty() || ral::execution::executor::get_instance()->has_exception();
+    });
+
+    if(auto ep = ral::execution::executor::get_instance()->last_exception()){
+        std::rethrow_exception(ep);
+    }
+    lock.unlock();
+
+    bool is_master_node = this->context->isMasterNode(ral::communication::CommunicationData::getInstance().getSelfNode());
+    std::vector<std::unique_ptr <ral::cache::CacheData> > inputs;
+    for (auto & top_k : partial_top_k) {
+        inputs.push_back(std::make_unique<ral::cache::GPUCacheData>(std::move(top_k)));
+    }
+    partial_top_k.clear();
+
+    if (this->context->getTotalNodes() > 1) {
+        this->context->incrementQuerySubstep();
+
+        if (is_master_node) {
+            // the nodes without any batch send a message without a table, that is only waited for
+            auto nodes = context->getAllNodes();
+            for(std::size_t i = 0; i < nodes.size(); ++i) {
+                if(!(nodes[i] == ral::communication::CommunicationData::getInstance().getSelfNode())) {
+                    std::string message_id = std::to_string(this->context->getContextToken()) + "_" + std::to_string(this->get_id()) + "_" + nodes[i].id();
+                    auto top_k_cache_data = this->query_graph->get_input_message_cache()->pullCacheData(message_id);
+                    if (top_k_cache_data->getMetadata().get_total_table_rows() > 0) {
+                        inputs.push_back(std::move(top_k_cache_data));
+                    }
+                }
+            }
+        } else if (inputs.empty()) {
+            ral::cache::MetadataDictionary extra_metadata;
+            extra_metadata.add_value(ral::cache::TOTAL_TABLE_ROWS_METADATA_LABEL, 0);
+            send_message(nullptr, //empty table
+                false, //specific_cache
+                "", //cache_id
+                {this->context->getMasterNode().id()}, //target_id
+                "", //message_id_prefix
+                true, //always_add
+                false, //wait_for
+                0, //message_tracker_idx
+                extra_metadata);
+        }
+    }
+
+    if (!inputs.empty()) {
+        ral::execution::executor::get_instance()->add_task(
+                std::move(inputs),
+                this->output_cache(),
+                this,
+                {{"operation_type", "merge_top_k"}});
+
+        std::unique_lock<std::mutex> lock(kernel_mutex);
+        kernel_cv.wait(lock,[this]{
+            return this->tasks.empty() || ral::execution::executor::get_instance()->has_exception();
+        });
+
+        if(auto ep = ral::execution::executor::get_instance()->last_exception()){
+            std::rethrow_exception(ep);
+        }
+    }
+
+    if(logger) {
+        logger->debug("{query_id}|{step}|{substep}|{info}|{duration}|kernel_id|{kernel_id}||",
+                                    "query_id"_a=context->getContextToken(),
+                                    "step"_a=context->getQueryStep(),
+                                    "substep"_a=context->getQuerySubstep(),
+                                    "info"_a="TopK Kernel Completed",
+                                    "duration"_a=timer.elapsed_time(),
+                                    "kernel_id"_a=this->get_id());
+    }
+
+    return kstatus::proceed;
+}
+
+// END TopKKernel
+
 } // namespace batch
 } // namespace ral
@@ -94,6 +94,7 @@ private:
 /**
  * This kernel has a loop over all its different input caches.
  * It then pulls all the inputs from one cache and merges them.
+ * When the sorted runs of a cache are bigger than ORDER_BY_MERGE_WINDOW_BYTES they are merged in windows instead, see external_merge.
  */
 class MergeStreamKernel : public kernel {
 public:
@@ -108,6 +109,24 @@ public:
 		cudaStream_t stream, const std::map<std::string, std::string>& args) override;
 
 	kstatus run() override;
+
+private:
+	void wait_for_merge_tasks();
+
+	/**
+	 * @brief Merges sorted runs that don't fit in the GPU a window at a time.
+	 *
+	 * Only the frontier of every run, its next rows of about merge_window_bytes / runs.size() bytes, is in the GPU, the rest
+	 * of the run stays where it was cached. Every window merges the rows of all the frontiers up to the smallest of the
+	 * last rows of the frontiers whose runs have more rows, since no row after them can come before it, and outputs them
+	 * before the next window is taken.
+	 */
+	void external_merge(std::vector<std::unique_ptr<ral::cache::CacheData>> runs);
+
+	std::size_t merge_window_bytes;
+	bool can_split_output;
+	std::vector<int> sortColIndices;
+	std::vector<cudf::order> sortOrderTypes;
 };
 
 
@@ -133,5 +152,37 @@ private:
 	std::atomic<int64_t> rows_limit;
 };
 
+/**
+ * @brief This kernel returns the first rows of a sort with a small limit, without sorting or partitioning all of them.
+ *
+ * Every batch is made into its first rows, these are merged together as they pile up, and once all the batches were
+ * processed every node sends its first rows to the master node, which merges them into the output. The other nodes
+ * output an empty table.
+ */
+class TopKKernel : public distributing_kernel {
+public:
+	TopKKernel(std::size_t kernel_id, const std::string & queryString,
+		std::shared_ptr<Context> context,
+		std::shared_ptr<ral::cache::graph> query_graph);
+
+	std::string kernel_name() { return "TopK";}
+
+	ral::execution::task_result do_process(std::vector< std::unique_ptr<ral::frame::BlazingTable> > inputs,
+		std::shared_ptr<ral::cache::CacheMachine> output,
+		cudaStream_t stream, const std::map<std::string, std::string>& args) override;
+
+	kstatus run() override;
+
+private:
+	std::unique_ptr<ral::frame::BlazingTable> merge_top_k(const std::vector<std::unique_ptr<ral::frame::BlazingTable>> & tables);
+
+	std::vector<int> sortColIndices;
+	std::vector<cudf::order> sortOrderTypes;
+	cudf::size_type num_rows_limit;
+	std::vector<std::unique_ptr<ral::frame::BlazingTable>> partial_top_k;
+	std::mutex partial_top_k_mutex;
+	std::size_t max_partial_top_k = 16; /**< The first rows of the batches are merged once there are these many of them */
+};
+
 } // namespace batch
 } // namespace ral
@@ -1,4 +1,6 @@
 #include "BatchProcessing.h"
+#include "cache_machine/ConcatCacheData.h"
+#include "cache_machine/GPUCacheData.h"
 #include "utilities/CodeTimer.h"
 #include "communication/CommunicationData.h"
 #include "ExceptionHandling/BlazingThread.h"
@@ -19,10 +21,16 @@
 #include "parser/expression_utils.hpp"
 #include "execution_graph/executor.h"
 #include <cudf/types.hpp>
+#include <cudf/concatenate.hpp>
+#include <cudf/copying.hpp>
+#include <cudf/reduction.hpp>
 #include <src/utilities/DebuggingUtils.h>
 #include "execution_kernels/LogicalFilter.h"
 #include "execution_kernels/LogicalProject.h"
+#include "utilities/CommonOperations.h"
 #include "io/data_provider/sql/AbstractSQLDataProvider.h"
+#include "skip_data/SkipDataProcessor.h"
+#include "io/data_provider/shared_scan.h"
 
 namespace ral {
 namespace batch {
@@ -45,6 +53,47 @@ std::vector<int> get_projections_wrapper(size_t num_columns, const std::string &
   return projections;
 }
 
+// Prunes the row groups of a file that can't have the keys of the runtime filters of the scan, with the statistics of the file.
+// Returns false if none of the row groups can have them, so that the file does not need to be read.
+bool prune_row_groups_with_runtime_filters(ral::io::data_parser * parser, const ral::io::data_handle & handle,
+    const std::vector<std::shared_ptr<ral::operators::runtime_filter>> & filters,
+    const std::vector<std::string> & output_names, const std::vector<std::string> & file_names,
+    std::vector<int> & row_group_ids) {
+
+    for (auto & filter : filters) {
+        auto it = std::find(output_names.begin(), output_names.end(), filter->get_column_name());
+        if (it == output_names.end()) {
+            continue;
+        }
+        int64_t min, max;
+        if (!filter->get_range(min, max)) {
+            return false; // the build side of the join is empty
+        }
+        std::string file_name = file_names[std::distance(output_names.begin(), it)];
+        if (parser->get_row_groups_in_range(handle, file_name, min, max, row_group_ids) && row_group_ids.empty()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Prunes the row groups of a file that can't have the values of the equalities of the filter of the scan, with the page
+// indexes and bloom filters of the file. Returns false if none of the row groups can have them.
+bool prune_row_groups_with_equality_literals(ral::io::data_parser * parser, const ral::io::data_handle & handle,
+    const std::map<int, std::vector<std::string>> & equality_literals, const std::vector<std::string> & file_names,
+    std::vector<int> & row_group_ids) {
+
+    for (auto & equality : equality_literals) {
+        if (equality.first < 0 || equality.first >= static_cast<int>(file_names.size())) {
+            continue;
+        }
+        if (parser->get_row_groups_with_values(handle, file_names[equality.first], equality.second, row_group_ids) && row_group_ids.empty()) {
+            return false;
+        }
+    }
+    return true;
+}
+
 // BEGIN BatchSequence
 
 BatchSequence::BatchSequence(std::shared_ptr<ral::cache::CacheMachine> cache, const ral::cache::kernel * kernel, bool ordered)
@@ -103,31 +152,237 @@ bool BatchSequenceBypass::has_next_now() {
 
 // BEGIN TableScan
 
+namespace {
+
+/**
+ * Gets the first row of every row group of a file, by its index, and the number of rows of the file last, so that the
+ * rows of a row group can be read by their position in the file.
+ */
+bool get_row_group_first_rows(ral::io::data_parser * parser, const ral::io::data_handle & handle, std::vector<int64_t> & first_rows) {
+    std::vector<int> all_row_groups;
+    std::vector<cudf::size_type> num_rows;
+    if (!parser->get_row_group_num_rows(handle, all_row_groups, num_rows)) {
+        return false;
+    }
+    first_rows.assign(1, 0);
+    for (cudf::size_type row_group_rows : num_rows) {
+        first_rows.push_back(first_rows.back() + row_group_rows);
+    }
+    return true;
+}
+
+std::size_t get_scan_task_target_bytes(std::shared_ptr<Context> context) {
+    return context->getConfig().scan_task_target_bytes.value_or(0);
+}
+
+/**
+ * Makes the chunks of the csv files, of max_bytes_chunk_read when it was given and otherwise of about
+ * target_bytes split at row boundaries, and the chunks of the json lines files of about target_bytes, as row groups
+ * of the schema.
+ * @return the number of batches of the scan.
+ */
+std::size_t split_text_files(std::shared_ptr<ral::io::data_provider> provider, std::shared_ptr<ral::io::data_parser> parser,
+    ral::io::Schema & schema, std::size_t target_bytes) {
+
+    bool is_csv = parser->type() == ral::io::DataType::CSV;
+    size_t max_bytes_chunk_size = is_csv ? static_cast<ral::io::csv_parser*>(parser.get())->max_bytes_chunk_size() : 0;
+    if (max_bytes_chunk_size == 0 && target_bytes == 0) {
+        return provider->get_num_handles();
+    }
+
+    std::size_t num_batches = 0;
+    int file_idx = 0;
+    while (provider->has_next()) {
+        auto data_handle = provider->get_next();
+        size_t num_chunks = 1;
+        if (max_bytes_chunk_size > 0) {
+            int64_t file_size = data_handle.file_handle->GetSize().ValueOrDie();
+            num_chunks = (file_size + max_bytes_chunk_size - 1) / max_bytes_chunk_size;
+        } else if (is_csv) {
+            num_chunks = static_cast<ral::io::csv_parser*>(parser.get())->split_into_chunks(data_handle, target_bytes);
+        } else {
+            num_chunks = static_cast<ral::io::json_parser*>(parser.get())->split_into_chunks(data_handle, target_bytes);
+        }
+        // the files that are not split are read whole
+        if (max_bytes_chunk_size > 0 || num_chunks > 1) {
+            std::vector<int> file_row_groups(num_chunks);
+            std::iota(file_row_groups.begin(), file_row_groups.end(), 0);
+            schema.get_rowgroups()[file_idx] = std::move(file_row_groups);
+        }
+        num_batches += num_chunks;
+        file_idx++;
+    }
+    provider->reset();
+    return num_batches;
+}
+
+// the number of slices of about target_bytes of the Arrow tables of a scan, every one of them a batch
+std::size_t count_arrow_slices(std::shared_ptr<ral::io::data_provider> provider, std::size_t target_bytes) {
+    if (target_bytes == 0) {
+        return provider->get_num_handles();
+    }
+    std::size_t num_batches = 0;
+    while (provider->has_next()) {
+        auto data_handle = provider->get_next();
+        num_batches += ral::cache::split_arrow_table(data_handle.arrow_table, target_bytes).size();
+    }
+    provider->reset();
+    return num_batches;
+}
+
+/**
+ * Counts the tasks that TableScan::run makes of the row groups of the parquet files with target_bytes, split and put
+ * together the same way, using the sizes in the metadata of the files. The row groups that a sample, a runtime filter
+ * or a metadata aggregation drops later are still counted.
+ * @return the number of batches of the scan.
+ */
+std::size_t count_parquet_scan_tasks(std::shared_ptr<ral::io::data_provider> provider, std::shared_ptr<ral::io::data_parser> parser,
+    const ral::io::Schema & schema, std::size_t target_bytes) {
+    if (target_bytes == 0) {
+        return provider->get_num_handles();
+    }
+
+    std::size_t num_tasks = 0;
+    std::size_t pending_inputs = 0;
+    std::size_t pending_bytes = 0;
+    auto add_pending_task = [&]() {
+        if (pending_inputs > 0) {
+            num_tasks++;
+        }
+        pending_inputs = 0;
+        pending_bytes = 0;
+    };
+    std::size_t file_index = 0;
+    while (provider->has_next()) {
+        auto handle = provider->get_next();
+        std::vector<int> row_group_ids = schema.get_rowgroup_ids(file_index);
+        std::vector<std::size_t> row_group_byte_sizes;
+        file_index++;
+        if (!parser->get_row_group_byte_sizes(handle, row_group_ids, row_group_byte_sizes)) {
+            num_tasks++;
+            continue;
+        }
+
+        bool has_task = false;
+        std::size_t task_bytes = 0;
+        std::vector<int64_t> row_group_first_rows;
+        for (std::size_t i = 0; i < row_group_ids.size(); i++) {
+            if (row_group_byte_sizes[i] > target_bytes &&
+                    (!row_group_first_rows.empty() || get_row_group_first_rows(parser.get(), handle, row_group_first_rows))) {
+                if (has_task) {
+                    pending_inputs++;
+                    pending_bytes += task_bytes;
+                    has_task = false;
+                    task_bytes = 0;
+                }
+                add_pending_task();
+
+                // a slice of the rows of the row group each
+                int row_group = row_group_ids[i];
+                int64_t row_group_rows = row_group_first_rows[row_group + 1] - row_group_first_rows[row_group];
+                int64_t num_slices = (row_group_byte_sizes[i] + target_bytes - 1) / target_bytes;
+                int64_t slice_rows = std::max<int64_t>((row_group_rows + num_slices - 1) / num_slices, 1);
+                num_tasks += (row_group_rows + slice_rows - 1) / slice_rows;
+                continue;
+            }
+            if (pending_bytes + task_bytes > 0 && pending_bytes + task_bytes + row_group_byte_sizes[i] > target_bytes) {
+                if (has_task) {
+                    pending_inputs++;
+                    pending_bytes += task_bytes;
+                }
+                add_pending_task();
+                has_task = false;
+                task_bytes = 0;
+            }
+            has_task = true;
+            task_bytes += row_group_byte_sizes[i];
+        }
+        if (has_task) {
+            pending_inputs++;
+            pending_bytes += task_bytes;
+        }
+        if (pending_bytes >= target_bytes) {
+            add_pending_task();
+        }
+    }
+    add_pending_task();
+    provider->reset();
+    return num_tasks;
+}
+
+// the inputs of the tasks of a file, a task each: the slices of an Arrow table, or the CacheData of the other files
+template<typename ...Params>
+std::vector<std::unique_ptr<ral::cache::CacheData>> get_scan_task_inputs(const ral::io::data_handle & handle,
+    std::shared_ptr<ral::io::data_parser> parser, const ral::io::Schema & schema, std::size_t target_bytes, Params&&... params) {
+    std::vector<std::unique_ptr<ral::cache::CacheData>> inputs;
+    if (parser->type() == ral::io::DataType::ARROW) {
+        for (auto & slice : ral::cache::split_arrow_table(handle.arrow_table, target_bytes)) {
+            inputs.push_back(std::make_unique<ral::cache::ArrowCacheData>(slice, schema));
+        }
+    } else {
+        inputs.push_back(CacheDataDispatcher(handle, parser, schema, std::forward<Params>(params)...));
+    }
+    return inputs;
+}
+
+// the provider of a MySQL, PostgreSQL or SQLite table, or nullptr for the other tables
+ral::io::abstractsql_data_provider * get_sql_data_provider(ral::io::data_parser * parser, ral::io::data_provider * provider) {
+    if (parser->type() != ral::io::DataType::MYSQL && parser->type() != ral::io::DataType::POSTGRESQL &&
+            parser->type() != ral::io::DataType::SQLITE) {
+        return nullptr;
+    }
+    return dynamic_cast<ral::io::abstractsql_data_provider *>(provider);
+}
+
+// the registration of a TableScan in the shared_scan, for the circular scans of the files of a table
+struct shared_scan_registration {
+    shared_scan_registration(const std::vector<std::string> & files) : table_key(ral::io::shared_scan::make_table_key(files)) {
+        scan_id = ral::io::shared_scan::get_instance().join_scan(table_key, start_file_index);
+        if (start_file_index >= files.size()) {
+            start_file_index = 0;
+        }
+    }
+    ~shared_scan_registration() { leave(); }
+
+    void update(std::size_t file_index) {
+        if (!left) {
+            ral::io::shared_scan::get_instance().update_scan(table_key, scan_id, file_index);
+        }
+    }
+    void leave() {
+        if (!left) {
+            ral::io::shared_scan::get_instance().leave_scan(table_key, scan_id);
+            left = true;
+        }
+    }
+
+    std::string table_key;
+    std::size_t scan_id = 0;
+    std::size_t start_file_index = 0;
+    bool left = false;
+};
+
+// every node decides the same, since the scans that would not ask for files would never answer the requests either
+bool use_scan_work_stealing(const std::shared_ptr<Context> & context, ral::io::data_parser * parser, const ral::io::Schema & schema) {
+    return context->getConfig().enable_scan_work_stealing.value_or(false) && context->getTotalNodes() > 1 &&
+        (parser->type() == ral::io::DataType::PARQUET || parser->type() == ral::io::DataType::ORC) &&
+        schema.has_shareable_files() && !schema.is_bucketed();
+}
+
+// stops the waits of the work stealing when the query is cancelled or failed
+std::function<bool()> get_work_stealing_stop(const kernel * scan) {
+    return [scan]() { return scan->is_cancelled() || ral::execution::executor::get_instance()->has_exception(); };
+}
+
+} // namespace
+
 TableScan::TableScan(std::size_t kernel_id, const std::string & queryString, std::shared_ptr<ral::io::data_provider> provider, std::shared_ptr<ral::io::data_parser> parser, ral::io::Schema & schema, std::shared_ptr<Context> context, std::shared_ptr<ral::cache::graph> query_graph)
-: kernel(kernel_id, queryString, context, kernel_type::TableScanKernel), provider(provider), parser(parser), schema(schema), num_batches(0)
+: distributing_kernel(kernel_id, queryString, context, kernel_type::TableScanKernel), provider(provider), parser(parser), schema(schema), num_batches(0)
 {
     if(parser->type() == ral::io::DataType::CUDF || parser->type() == ral::io::DataType::DASK_CUDF){
         num_batches = std::max(provider->get_num_handles(), (size_t)1);
-    } else if (parser->type() == ral::io::DataType::CSV)	{
-        auto csv_parser = static_cast<ral::io::csv_parser*>(parser.get());
-        num_batches = 0;
-        size_t max_bytes_chunk_size = csv_parser->max_bytes_chunk_size();
-        if (max_bytes_chunk_size > 0) {
-            int file_idx = 0;
-            while (provider->has_next()) {
-                auto data_handle = provider->get_next();
-                int64_t file_size = data_handle.file_handle->GetSize().ValueOrDie();
-                size_t num_chunks = (file_size + max_bytes_chunk_size - 1) / max_bytes_chunk_size;
-                std::vector<int> file_row_groups(num_chunks);
-                std::iota(file_row_groups.begin(), file_row_groups.end(), 0);
-                schema.get_rowgroups()[file_idx] = std::move(file_row_groups);
-                num_batches += num_chunks;
-                file_idx++;
-            }
-            provider->reset();
-        } else {
-            num_batches = provider->get_num_handles();
-        }
+    } else if (parser->type() == ral::io::DataType::CSV || parser->type() == ral::io::DataType::JSON)	{
+        num_batches = split_text_files(provider, parser, schema, get_scan_task_target_bytes(context));
     } else if (parser->type() == ral::io::DataType::MYSQL)	{
 #ifdef MYSQL_SUPPORT
       ral::io::set_sql_projections<ral::io::mysql_data_provider>(provider.get(), get_projections_wrapper(schema.get_num_columns()));
@@ -146,6 +401,11 @@ TableScan::TableScan(std::size_t kernel_id, const std::string & queryString, std
 #else
       throw std::runtime_error("ERROR: This BlazingSQL version doesn't support SQLite integration");
 #endif
+    } else if (parser->type() == ral::io::DataType::ARROW) {
+        num_batches = count_arrow_slices(provider, get_scan_task_target_bytes(context));
+    } else if (parser->type() == ral::io::DataType::PARQUET) {
+        scan_task_target_bytes = get_scan_task_target_bytes(context);
+        num_batches = count_parquet_scan_tasks(provider, parser, schema, scan_task_target_bytes);
     } else {
         num_batches = provider->get_num_handles();
     }
@@ -155,10 +415,22 @@ TableScan::TableScan(std::size_t kernel_id, const std::string & queryString, std
 
 ral::execution::task_result TableScan::do_process(std::vector< std::unique_ptr<ral::frame::BlazingTable> > inputs,
     std::shared_ptr<ral::cache::CacheMachine> output,
-    cudaStream_t /*stream*/, const std::map<std::string, std::string>& /*args*/) {
+    cudaStream_t /*stream*/, const std::map<std::string, std::string>& args) {
     try{
+        auto sample_seed = args.find("sample_seed");
+        if (sample_seed != args.end()) {
+            inputs[0] = ral::operators::sample_rows(inputs[0]->toBlazingTableView(), std::stoull(sample_seed->second), sample->rate);
+        }
+        if (cache_fill) {
+            cache_fill->add(inputs[0]->toBlazingTableView());
+        }
+        this->apply_runtime_filters(inputs[0]);
         output->addToCache(std::move(inputs[0]));
     }catch(const rmm::bad_alloc& e){
+        // the batch would be added twice to the cached table when the task is retried
+        if (cache_fill) {
+            cache_fill->abandon();
+        }
         //can still recover if the input was not a GPUCacheData 
         return {ral::execution::task_status::RETRY, std::string(e.what()), std::move(inputs)};
     }catch(const std::exception& e){
@@ -173,33 +445,201 @@ kstatus TableScan::run() {
     std::vector<int> projections(schema.get_num_columns());
     std::iota(projections.begin(), projections.end(), 0);
 
+    // the nodes give the files they did not start to the scans that finished theirs
+    std::unique_ptr<scan_work_stealing> work_stealing;
+    if (sample == nullptr && use_scan_work_stealing(context, parser.get(), schema)) {
+        work_stealing = std::make_unique<scan_work_stealing>(this, context, this->query_graph, provider, schema);
+    }
+
     //if its empty we can just add it to the cache without scheduling
-    if (!provider->has_next()) {
+    if (!provider->has_next() && work_stealing == nullptr) {
         this->add_to_output_cache(std::move(schema.makeEmptyBlazingTable(projections)));
     } else {
+        // the scans of the same parquet or orc files start at the file where the oldest running one is, and wrap around
+        // to the first files, so that the reads of the queries that run at the same time are shared
+        std::unique_ptr<shared_scan_registration> shared_registration;
+        std::vector<std::string> files = schema.get_files();
+        if ((parser->type() == ral::io::DataType::PARQUET || parser->type() == ral::io::DataType::ORC) &&
+                ral::io::shared_scan::get_instance().is_enabled() && files.size() > 1 && files.size() == provider->get_num_handles() &&
+                sample == nullptr && work_stealing == nullptr) {
+            shared_registration = std::make_unique<shared_scan_registration>(files);
+            while (file_index < shared_registration->start_file_index && provider->has_next()) {
+                provider->get_next(false);
+                file_index++;
+            }
+        }
+        bool wrapped = false;
+        // a scan with a limit stops reading before the end of the table
+        if (cache_fill && this->has_limit_) {
+            cache_fill->abandon();
+        }
+
+        while(!this->stop_requested()) {
+            if (!provider->has_next() && work_stealing) {
+                std::size_t num_stolen = work_stealing->steal(file_index, get_work_stealing_stop(this));
+                if (num_stolen == 0) {
+                    break;
+                }
+                // the scan does not read the same files as the scans that fill the table_cache
+                if (cache_fill) {
+                    cache_fill->abandon();
+                }
+                num_batches += num_stolen;
+            }
+            if (!provider->has_next()) {
+                if (shared_registration == nullptr || shared_registration->start_file_index == 0 || wrapped) {
+                    break;
+                }
+                provider->reset();
+                file_index = 0;
+                wrapped = true;
+            }
+            if (wrapped && file_index >= shared_registration->start_file_index) {
+                break;
+            }
+            if (shared_registration) {
+                shared_registration->update(file_index);
+            }
+
+            // don't create more tasks while the consumers have not drained the output cache
+            this->wait_for_output_cache_to_drain();
+            if (this->stop_requested()) {
+                break;
+            }
+            if (work_stealing) {
+                std::size_t num_given = work_stealing->answer_requests(file_index);
+                if (num_given > 0 && cache_fill) {
+                    cache_fill->abandon();
+                }
+                num_batches -= num_given;
+            }
 
-        while(provider->has_next()) {
             //retrieve the file handle but do not open the file
             //this will allow us to prevent from having too many open file handles by being
             //able to limit the number of file tasks
             auto handle = provider->get_next(true);
             auto file_schema = schema.fileSchema(file_index);
             auto row_group_ids = schema.get_rowgroup_ids(file_index);
-            //this is the part where we make the task now
-            std::unique_ptr<ral::cache::CacheData> input =
-                CacheDataDispatcher(handle, parser, schema, file_schema, row_group_ids, projections);
-
-            std::vector<std::unique_ptr<ral::cache::CacheData> > inputs;
-            inputs.push_back(std::move(input));
-            auto output_cache = this->output_cache();
+            // a SYSTEM sample reads the row groups it keeps, or the whole file when the parser can't tell its row groups
+            if (sample && sample->system) {
+                std::vector<cudf::size_type> row_group_num_rows;
+                bool keep_file;
+                if (!row_group_ids.empty() || parser->get_row_group_num_rows(handle, row_group_ids, row_group_num_rows)) {
+                    row_group_ids = ral::operators::sample_row_groups(*sample, file_index, row_group_ids);
+                    keep_file = !row_group_ids.empty();
+                } else {
+                    keep_file = sample->keep_block(file_index, -1);
+                }
+                if (!keep_file) {
+                    this->add_to_output_cache(schema.makeEmptyBlazingTable(projections));
+                    file_index++;
+                    continue;
+                }
+            }
+            auto runtime_filters = this->get_runtime_filters();
+            if (!runtime_filters.empty() && !prune_row_groups_with_runtime_filters(parser.get(), handle, runtime_filters,
+                    schema.get_names(), schema.get_names(), row_group_ids)) {
+                if (cache_fill) {
+                    cache_fill->abandon();
+                }
+                this->add_to_output_cache(schema.makeEmptyBlazingTable(projections));
+                file_index++;
+                continue;
+            }
+            if (this->metadata_aggregation && !this->metadata_aggregation->answer_row_groups(parser.get(), handle,
+                    expression, schema, projections, schema.get_names(), row_group_ids)) {
+                if (cache_fill) {
+                    cache_fill->abandon();
+                }
+                this->add_to_output_cache(schema.makeEmptyBlazingTable(projections));
+                file_index++;
+                continue;
+            }
+            // the row groups are split into tasks of about scan_task_target_bytes, and the ones of small files are read
+            // together with the ones of the next files, using the sizes in the metadata of the files
+            std::vector<std::size_t> row_group_byte_sizes;
+            if (scan_task_target_bytes > 0 && parser->get_row_group_byte_sizes(handle, row_group_ids, row_group_byte_sizes)) {
+                std::vector<int> task_row_group_ids;
+                std::size_t task_bytes = 0;
+                std::vector<int64_t> row_group_first_rows;
+                for (std::size_t i = 0; i < row_group_ids.size(); i++) {
+                    // a row group larger than a task is read by several tasks, every one of them a slice of its rows,
+                    // so that none of them decodes the whole row group at once
+                    if (row_group_byte_sizes[i] > scan_task_target_bytes &&
+                            (!row_group_first_rows.empty() || get_row_group_first_rows(parser.get(), handle, row_group_first_rows))) {
+                        if (!task_row_group_ids.empty()) {
+                            pending_scan_inputs.push_back(std::make_unique<ral::cache::CacheDataIO>(handle, parser, schema, file_schema, task_row_group_ids, projections));
+                            pending_scan_bytes += task_bytes;
+                            task_row_group_ids.clear();
+                            task_bytes = 0;
+                        }
+                        add_pending_scan_task();
+
+                        int row_group = row_group_ids[i];
+                        int64_t row_group_rows = row_group_first_rows[row_group + 1] - row_group_first_rows[row_group];
+                        int64_t num_slices = (row_group_byte_sizes[i] + scan_task_target_bytes - 1) / scan_task_target_bytes;
+                        int64_t slice_rows = std::max<int64_t>((row_group_rows + num_slices - 1) / num_slices, 1);
+                        for (int64_t slice_start = 0; slice_start < row_group_rows; slice_start += slice_rows) {
+                            ral::io::data_handle slice_handle = handle;
+                            slice_handle.skip_rows = row_group_first_rows[row_group] + slice_start;
+                            slice_handle.num_rows = std::min(slice_rows, row_group_rows - slice_start);
+                            pending_scan_inputs.push_back(std::make_unique<ral::cache::CacheDataIO>(slice_handle, parser, schema, file_schema, std::vector<int>{row_group}, projections));
+                            add_pending_scan_task();
+                        }
+                        continue;
+                    }
+                    if (pending_scan_bytes + task_bytes > 0 && pending_scan_bytes + task_bytes + row_group_byte_sizes[i] > scan_task_target_bytes) {
+                        if (!task_row_group_ids.empty()) {
+                            pending_scan_inputs.push_back(std::make_unique<ral::cache::CacheDataIO>(handle, parser, schema, file_schema, task_row_group_ids, projections));
+                            pending_scan_bytes += task_bytes;
+                        }
+                        add_pending_scan_task();
+                        task_row_group_ids.clear();
+                        task_bytes = 0;
+                    }
+                    task_row_group_ids.push_back(row_group_ids[i]);
+                    task_bytes += row_group_byte_sizes[i];
+                }
+                if (!task_row_group_ids.empty()) {
+                    pending_scan_inputs.push_back(std::make_unique<ral::cache::CacheDataIO>(handle, parser, schema, file_schema, task_row_group_ids, projections));
+                    pending_scan_bytes += task_bytes;
+                }
+                if (pending_scan_bytes >= scan_task_target_bytes) {
+                    add_pending_scan_task();
+                }
+                file_index++;
+                continue;
+            }
 
-            ral::execution::executor::get_instance()->add_task(
-                    std::move(inputs),
-                    output_cache,
-                    this);
+            //this is the part where we make the task now
+            for (auto & input : get_scan_task_inputs(handle, parser, schema, get_scan_task_target_bytes(context),
+                    file_schema, row_group_ids, projections)) {
+                std::vector<std::unique_ptr<ral::cache::CacheData> > inputs;
+                inputs.push_back(std::move(input));
+                auto output_cache = this->output_cache();
+
+                ral::execution::executor::get_instance()->add_task(
+                        std::move(inputs),
+                        output_cache,
+                        this,
+                        get_task_args());
+            }
 
             file_index++;
         }
+        if (shared_registration) {
+            shared_registration->leave();
+        }
+        if (!this->stop_requested()) {
+            add_pending_scan_task();
+        }
+        if (work_stealing) {
+            work_stealing->finish(get_work_stealing_stop(this));
+            // a node without files that got none still outputs a batch
+            if (file_index == 0) {
+                this->add_to_output_cache(schema.makeEmptyBlazingTable(projections));
+            }
+        }
 
         if(logger) {
             logger->debug("{query_id}|{step}|{substep}|{info}|{duration}|kernel_id|{kernel_id}||",
@@ -219,6 +659,9 @@ kstatus TableScan::run() {
         if(auto ep = ral::execution::executor::get_instance()->last_exception()){
             std::rethrow_exception(ep);
         }
+        if (cache_fill && !this->stop_requested()) {
+            cache_fill->finish();
+        }
     }
 
     if(logger) {
@@ -234,6 +677,39 @@ kstatus TableScan::run() {
     return kstatus::proceed;
 }
 
+void TableScan::add_pending_scan_task() {
+    if (pending_scan_inputs.empty()) {
+        return;
+    }
+
+    std::vector<std::unique_ptr<ral::cache::CacheData> > inputs;
+    if (pending_scan_inputs.size() == 1) {
+        inputs.push_back(std::move(pending_scan_inputs[0]));
+    } else {
+        inputs.push_back(std::make_unique<ral::cache::ConcatCacheData>(std::move(pending_scan_inputs), schema.get_names(), schema.get_data_types()));
+    }
+    pending_scan_inputs.clear();
+    pending_scan_bytes = 0;
+
+    ral::execution::executor::get_instance()->add_task(
+            std::move(inputs),
+            this->output_cache(),
+            this,
+            get_task_args());
+}
+
+std::map<std::string, std::string> TableScan::get_task_args() {
+    if (sample == nullptr || sample->system) {
+        return {};
+    }
+    return {{"sample_seed", std::to_string(sample->get_batch_seed(num_sampled_tasks++))}};
+}
+
+bool TableScan::set_limit_pushdown(const std::string & sort_expression) {
+    ral::io::abstractsql_data_provider * sql_provider = get_sql_data_provider(parser.get(), provider.get());
+    return sql_provider != nullptr && sql_provider->set_limit_pushdown(sort_expression, schema.get_dtypes());
+}
+
 std::pair<bool, uint64_t> TableScan::get_estimated_output_num_rows(){
     double rows_so_far = (double)this->output_.total_rows_added();
     double batches_so_far = (double)this->output_.total_batches_added();
@@ -249,33 +725,48 @@ std::pair<bool, uint64_t> TableScan::get_estimated_output_num_rows(){
 // BEGIN BindableTableScan
 
 BindableTableScan::BindableTableScan(std::size_t kernel_id, const std::string & queryString, std::shared_ptr<ral::io::data_provider> provider, std::shared_ptr<ral::io::data_parser> parser, ral::io::Schema & schema, std::shared_ptr<Context> context, std::shared_ptr<ral::cache::graph> query_graph)
-: kernel(kernel_id, queryString, context, kernel_type::BindableTableScanKernel), provider(provider), parser(parser), schema(schema) {
+: distributing_kernel(kernel_id, queryString, context, kernel_type::BindableTableScanKernel), provider(provider), parser(parser), schema(schema) {
     this->query_graph = query_graph;
     this->filterable = is_filtered_bindable_scan(expression);
     this->predicate_pushdown_done = false;
+    if (this->filterable && parser->type() == ral::io::DataType::PARQUET) {
+        this->equality_literals = get_equality_literals(get_named_expression(expression, "filters"));
+    }
+
+    bool late_materialization = context->getConfig().enable_late_materialization.value_or(false);
+    if (this->filterable && late_materialization &&
+            (parser->type() == ral::io::DataType::PARQUET || parser->type() == ral::io::DataType::ORC)) {
+        std::string filter_condition = get_named_expression(expression, "filters");
+        std::size_t num_projections = get_projections_wrapper(schema.get_num_columns(), expression).size();
+        std::vector<int> filter_column_indices = get_referenced_column_indices(filter_condition);
+        // it is only worth it when there are columns the filter does not use
+        if (!filter_column_indices.empty() && filter_column_indices.size() < num_projections) {
+            std::vector<int> new_column_indices(num_projections, -1);
+            for (std::size_t i = 0; i < filter_column_indices.size(); i++) {
+                new_column_indices[filter_column_indices[i]] = i;
+            }
+            this->predicate_column_indices = filter_column_indices;
+            this->narrow_filter_condition = renumber_column_indices(filter_condition, new_column_indices);
+        }
+    }
+
+    if (this->filterable) {
+        // the partitions the filter rules out by their values are dropped before any of their files is listed or opened
+        std::vector<std::map<std::string, std::string>> partition_values = provider->get_partition_values();
+        if (!partition_values.empty()) {
+            std::vector<std::size_t> partitions_to_read = ral::skip_data::get_partitions_to_read(
+                partition_values, schema.get_names(), schema.get_dtypes(), expression);
+            if (partitions_to_read.size() < partition_values.size()) {
+                provider->keep_partitions(partitions_to_read);
+                this->schema.keep_files(partitions_to_read);
+            }
+        }
+    }
 
     if(parser->type() == ral::io::DataType::CUDF || parser->type() == ral::io::DataType::DASK_CUDF){
         num_batches = std::max(provider->get_num_handles(), (size_t)1);
-    } else if (parser->type() == ral::io::DataType::CSV)	{
-        auto csv_parser = static_cast<ral::io::csv_parser*>(parser.get());
-        num_batches = 0;
-        size_t max_bytes_chunk_size = csv_parser->max_bytes_chunk_size();
-        if (max_bytes_chunk_size > 0) {
-            int file_idx = 0;
-            while (provider->has_next()) {
-                auto data_handle = provider->get_next();
-                int64_t file_size = data_handle.file_handle->GetSize().ValueOrDie();
-                size_t num_chunks = (file_size + max_bytes_chunk_size - 1) / max_bytes_chunk_size;
-                std::vector<int> file_row_groups(num_chunks);
-                std::iota(file_row_groups.begin(), file_row_groups.end(), 0);
-                schema.get_rowgroups()[file_idx] = std::move(file_row_groups);
-                num_batches += num_chunks;
-                file_idx++;
-            }
-            provider->reset();
-        } else {
-            num_batches = provider->get_num_handles();
-        }
+    } else if (parser->type() == ral::io::DataType::CSV || parser->type() == ral::io::DataType::JSON)	{
+        num_batches = split_text_files(provider, parser, schema, get_scan_task_target_bytes(context));
     } else if (parser->type() == ral::io::DataType::MYSQL)	{
 #ifdef MYSQL_SUPPORT
       ral::io::set_sql_projections<ral::io::mysql_data_provider>(provider.get(), get_projections_wrapper(schema.get_num_columns(), queryString));
@@ -295,6 +786,8 @@ BindableTableScan::BindableTableScan(std::size_t kernel_id, const std::string &
 #else
       throw std::runtime_error("ERROR: This BlazingSQL version doesn't support SQLite integration");
 #endif
+    } else if (parser->type() == ral::io::DataType::ARROW) {
+        num_batches = count_arrow_slices(provider, get_scan_task_target_bytes(context));
     } else {
         num_batches = provider->get_num_handles();
     }
@@ -307,15 +800,27 @@ ral::execution::task_result BindableTableScan::do_process(std::vector< std::uniq
     std::unique_ptr<ral::frame::BlazingTable> filtered_input;
 
     try{
-        if(this->filterable && !this->predicate_pushdown_done) {
+        if (this->aggregation_pushed_down) {
+            // the partial aggregations already have the names the aggregation gives them
+            output->addToCache(std::move(input));
+        } else if(this->filterable && !this->predicate_pushdown_done) {
             filtered_input = ral::processor::process_filter(input->toBlazingTableView(), expression, this->context.get());
             filtered_input->setNames(fix_column_aliases(filtered_input->names(), expression));
+            this->apply_runtime_filters(filtered_input);
             output->addToCache(std::move(filtered_input));
         } else {
+            if (cache_fill) {
+                cache_fill->add(input->toBlazingTableView());
+            }
             input->setNames(fix_column_aliases(input->names(), expression));
+            this->apply_runtime_filters(input);
             output->addToCache(std::move(input));
         }
     }catch(const rmm::bad_alloc& e){
+        // the batch would be added twice to the cached table when the task is retried
+        if (cache_fill) {
+            cache_fill->abandon();
+        }
         //can still recover if the input was not a GPUCacheData
         return {ral::execution::task_status::RETRY, std::string(e.what()), std::move(inputs)};
     }catch(const std::exception& e){
@@ -325,40 +830,228 @@ ral::execution::task_result BindableTableScan::do_process(std::vector< std::uniq
     return {ral::execution::task_status::SUCCESS, std::string(), std::vector< std::unique_ptr<ral::frame::BlazingTable> > ()};
 }
 
+std::unique_ptr<ral::frame::BlazingTable> BindableTableScan::decache_input(ral::cache::CacheData & input) {
+    if (narrow_filter_condition.empty() || input.get_type() != ral::cache::CacheDataType::IO_FILE) {
+        return input.decache();
+    }
+    auto & file_input = static_cast<ral::cache::CacheDataIO &>(input);
+    std::vector<int> row_group_ids;
+    std::vector<cudf::size_type> row_group_num_rows;
+    if (!file_input.get_row_group_num_rows(row_group_ids, row_group_num_rows)) {
+        return input.decache();
+    }
+
+    std::unique_ptr<ral::frame::BlazingTable> predicate_table = file_input.decache(predicate_column_indices);
+    std::vector<std::unique_ptr<ral::frame::BlazingColumn>> evaluated = ral::processor::evaluate_expressions(predicate_table->view(), {narrow_filter_condition});
+    RAL_EXPECTS(evaluated.size() == 1 && evaluated[0]->view().type().id() == cudf::type_id::BOOL8, "Expression does not evaluate to a boolean mask");
+    cudf::column_view mask = evaluated[0]->view();
+    if (std::accumulate(row_group_num_rows.begin(), row_group_num_rows.end(), cudf::size_type(0)) != mask.size()) {
+        return input.decache();
+    }
+
+    // the row groups without rows that pass the filter are not decoded
+    std::vector<int> selected_row_group_ids;
+    std::vector<CudfTableView> selected_predicate_views;
+    cudf::size_type offset = 0;
+    for (std::size_t i = 0; i < row_group_ids.size(); i++) {
+        cudf::size_type end = offset + row_group_num_rows[i];
+        if (end > offset) {
+            std::unique_ptr<cudf::scalar> any_selected = cudf::reduce(cudf::slice(mask, {offset, end})[0],
+                cudf::make_any_aggregation<cudf::aggregation>(), cudf::data_type{cudf::type_id::BOOL8});
+            if (any_selected->is_valid() && static_cast<cudf::numeric_scalar<bool> *>(any_selected.get())->value()) {
+                selected_row_group_ids.push_back(row_group_ids[i]);
+                selected_predicate_views.push_back(cudf::slice(predicate_table->view(), {offset, end})[0]);
+            }
+        }
+        offset = end;
+    }
+
+    std::vector<int> projections = get_projections_wrapper(schema.get_num_columns(), expression);
+    if (selected_row_group_ids.empty()) {
+        return schema.makeEmptyBlazingTable(projections);
+    }
+
+    std::vector<std::string> predicate_names = predicate_table->names();
+    std::unique_ptr<CudfTable> selected_predicate_table = selected_row_group_ids.size() == row_group_ids.size() ?
+        predicate_table->releaseCudfTable() : cudf::concatenate(selected_predicate_views);
+    std::vector<std::unique_ptr<cudf::column>> predicate_columns = selected_predicate_table->release();
+
+    std::vector<int> other_column_indices;
+    for (std::size_t i = 0; i < projections.size(); i++) {
+        if (!std::binary_search(predicate_column_indices.begin(), predicate_column_indices.end(), static_cast<int>(i))) {
+            other_column_indices.push_back(i);
+        }
+    }
+    std::unique_ptr<ral::frame::BlazingTable> other_table = file_input.decache(other_column_indices, selected_row_group_ids);
+    std::vector<std::string> other_names = other_table->names();
+    std::vector<std::unique_ptr<cudf::column>> other_columns = other_table->releaseCudfTable()->release();
+
+    // the columns are put back in the order of the projections
+    std::vector<std::unique_ptr<cudf::column>> columns(projections.size());
+    std::vector<std::string> names(projections.size());
+    for (std::size_t i = 0; i < predicate_column_indices.size(); i++) {
+        columns[predicate_column_indices[i]] = std::move(predicate_columns[i]);
+        names[predicate_column_indices[i]] = predicate_names[i];
+    }
+    for (std::size_t i = 0; i < other_column_indices.size(); i++) {
+        columns[other_column_indices[i]] = std::move(other_columns[i]);
+        names[other_column_indices[i]] = other_names[i];
+    }
+    return std::make_unique<ral::frame::BlazingTable>(std::make_unique<CudfTable>(std::move(columns)), names);
+}
+
 kstatus BindableTableScan::run() {
     CodeTimer timer;
 
-    std::vector<int> projections = get_projections_wrapper(schema.get_num_columns(), expression);
+    // the queries of the table return the partial aggregations when they are pushed down
+    const ral::io::Schema & scan_schema = this->aggregation_pushed_down ? this->aggregation_schema : this->schema;
+    std::vector<int> projections = this->aggregation_pushed_down ?
+        get_projections_wrapper(scan_schema.get_num_columns()) : get_projections_wrapper(schema.get_num_columns(), expression);
+    std::vector<std::string> projected_names;
+    for (int projection : projections) {
+        projected_names.push_back(scan_schema.get_name(projection));
+    }
+    std::vector<std::string> output_names = this->aggregation_pushed_down ?
+        projected_names : fix_column_aliases(projected_names, expression);
+
+    // the nodes give the files they did not start to the scans that finished theirs
+    std::unique_ptr<scan_work_stealing> work_stealing;
+    if (use_scan_work_stealing(context, parser.get(), schema)) {
+        work_stealing = std::make_unique<scan_work_stealing>(this, context, this->query_graph, provider, schema);
+    }
 
     //if its empty we can just add it to the cache without scheduling
-    if (!provider->has_next()) {
-        auto empty = schema.makeEmptyBlazingTable(projections);
-        empty->setNames(fix_column_aliases(empty->names(), expression));
+    if (!provider->has_next() && work_stealing == nullptr) {
+        auto empty = scan_schema.makeEmptyBlazingTable(projections);
+        empty->setNames(output_names);
         this->add_to_output_cache(std::move(empty));
     } else {
+        // the scans of the same parquet or orc files start at the file where the oldest running one is, and wrap around
+        // to the first files, so that the reads of the queries that run at the same time are shared
+        std::unique_ptr<shared_scan_registration> shared_registration;
+        std::vector<std::string> files = schema.get_files();
+        if ((parser->type() == ral::io::DataType::PARQUET || parser->type() == ral::io::DataType::ORC) &&
+                ral::io::shared_scan::get_instance().is_enabled() && files.size() > 1 && files.size() == provider->get_num_handles() &&
+                work_stealing == nullptr) {
+            shared_registration = std::make_unique<shared_scan_registration>(files);
+            while (file_index < shared_registration->start_file_index && provider->has_next()) {
+                provider->get_next(false);
+                file_index++;
+            }
+        }
+        bool wrapped = false;
+        // a scan with a limit stops reading before the end of the table
+        if (cache_fill && this->has_limit_) {
+            cache_fill->abandon();
+        }
+
+        while(!this->stop_requested()) {
+            if (!provider->has_next() && work_stealing) {
+                std::size_t num_stolen = work_stealing->steal(file_index, get_work_stealing_stop(this));
+                if (num_stolen == 0) {
+                    break;
+                }
+                // the scan does not read the same files as the scans that fill the table_cache
+                if (cache_fill) {
+                    cache_fill->abandon();
+                }
+                num_batches += num_stolen;
+            }
+            if (!provider->has_next()) {
+                if (shared_registration == nullptr || shared_registration->start_file_index == 0 || wrapped) {
+                    break;
+                }
+                provider->reset();
+                file_index = 0;
+                wrapped = true;
+            }
+            if (wrapped && file_index >= shared_registration->start_file_index) {
+                break;
+            }
+            if (shared_registration) {
+                shared_registration->update(file_index);
+            }
+
+            // don't create more tasks while the consumers have not drained the output cache
+            this->wait_for_output_cache_to_drain();
+            if (this->stop_requested()) {
+                break;
+            }
+            if (work_stealing) {
+                std::size_t num_given = work_stealing->answer_requests(file_index);
+                if (num_given > 0 && cache_fill) {
+                    cache_fill->abandon();
+                }
+                num_batches -= num_given;
+            }
 
-        while(provider->has_next()) {
             //retrieve the file handle but do not open the file
             //this will allow us to prevent from having too many open file handles by being
             //able to limit the number of file tasks
             auto handle = provider->get_next(true);
-            auto file_schema = schema.fileSchema(file_index);
+            auto file_schema = scan_schema.fileSchema(file_index);
             auto row_group_ids = schema.get_rowgroup_ids(file_index);
+            // the filters are on the columns of the table, not on its partial aggregations
+            auto runtime_filters = this->aggregation_pushed_down ?
+                std::vector<std::shared_ptr<ral::operators::runtime_filter>>() : this->get_runtime_filters();
+            if (!runtime_filters.empty() && !prune_row_groups_with_runtime_filters(parser.get(), handle, runtime_filters,
+                    output_names, projected_names, row_group_ids)) {
+                if (cache_fill) {
+                    cache_fill->abandon();
+                }
+                auto empty = schema.makeEmptyBlazingTable(projections);
+                empty->setNames(output_names);
+                this->add_to_output_cache(std::move(empty));
+                file_index++;
+                continue;
+            }
+            if (!this->equality_literals.empty() && !prune_row_groups_with_equality_literals(parser.get(), handle,
+                    this->equality_literals, projected_names, row_group_ids)) {
+                if (cache_fill) {
+                    cache_fill->abandon();
+                }
+                auto empty = schema.makeEmptyBlazingTable(projections);
+                empty->setNames(output_names);
+                this->add_to_output_cache(std::move(empty));
+                file_index++;
+                continue;
+            }
+            if (this->metadata_aggregation && !this->metadata_aggregation->answer_row_groups(parser.get(), handle,
+                    expression, schema, projections, output_names, row_group_ids)) {
+                if (cache_fill) {
+                    cache_fill->abandon();
+                }
+                auto empty = schema.makeEmptyBlazingTable(projections);
+                empty->setNames(output_names);
+                this->add_to_output_cache(std::move(empty));
+                file_index++;
+                continue;
+            }
             //this is the part where we make the task now
-            std::unique_ptr<ral::cache::CacheData> input =
-                CacheDataDispatcher(handle, parser, schema, file_schema, row_group_ids, projections);
-            std::vector<std::unique_ptr<ral::cache::CacheData>> inputs;
-            inputs.push_back(std::move(input));
+            for (auto & input : get_scan_task_inputs(handle, parser, scan_schema, get_scan_task_target_bytes(context),
+                    file_schema, row_group_ids, projections)) {
+                std::vector<std::unique_ptr<ral::cache::CacheData>> inputs;
+                inputs.push_back(std::move(input));
 
-            auto output_cache = this->output_cache();
+                auto output_cache = this->output_cache();
 
-            ral::execution::executor::get_instance()->add_task(
-                    std::move(inputs),
-                    output_cache,
-                    this);
+                ral::execution::executor::get_instance()->add_task(
+                        std::move(inputs),
+                        output_cache,
+                        this);
+            }
 
             file_index++;
         }
+        if (work_stealing) {
+            work_stealing->finish(get_work_stealing_stop(this));
+            // a node without files that got none still outputs a batch
+            if (file_index == 0) {
+                auto empty = scan_schema.makeEmptyBlazingTable(projections);
+                empty->setNames(output_names);
+                this->add_to_output_cache(std::move(empty));
+            }
+        }
 
         if(logger){
             logger->debug("{query_id}|{step}|{substep}|{info}|{duration}|kernel_id|{kernel_id}||",
@@ -378,6 +1071,9 @@ kstatus BindableTableScan::run() {
         if(auto ep = ral::execution::executor::get_instance()->last_exception()){
             std::rethrow_exception(ep);
         }
+        if (cache_fill && !this->stop_requested()) {
+            cache_fill->finish();
+        }
     }
 
     if(logger){
@@ -392,6 +1088,23 @@ kstatus BindableTableScan::run() {
     return kstatus::proceed;
 }
 
+bool BindableTableScan::set_aggregation_pushdown(const std::string & aggregate_expression) {
+    ral::io::abstractsql_data_provider * sql_provider = get_sql_data_provider(parser.get(), provider.get());
+    if (sql_provider == nullptr || (this->filterable && !this->predicate_pushdown_done) ||
+            !sql_provider->set_aggregation_pushdown(aggregate_expression, schema.get_dtypes())) {
+        return false;
+    }
+    this->aggregation_schema = sql_provider->get_aggregation_schema();
+    this->aggregation_pushed_down = true;
+    return true;
+}
+
+bool BindableTableScan::set_limit_pushdown(const std::string & sort_expression) {
+    ral::io::abstractsql_data_provider * sql_provider = get_sql_data_provider(parser.get(), provider.get());
+    return sql_provider != nullptr && (!this->filterable || this->predicate_pushdown_done) &&
+        sql_provider->set_limit_pushdown(sort_expression, schema.get_dtypes());
+}
+
 std::pair<bool, uint64_t> BindableTableScan::get_estimated_output_num_rows(){
     double rows_so_far = (double)this->output_.total_rows_added();
     double current_batch = (double)file_index;
@@ -417,8 +1130,21 @@ ral::execution::task_result Projection::do_process(std::vector< std::unique_ptr<
     cudaStream_t /*stream*/, const std::map<std::string, std::string>& /*args*/) {
 
     try{
-        auto & input = inputs[0];
-        auto columns = ral::processor::process_project(std::move(input), expression, this->context.get());
+        // inputs decached by decache_input only have the used columns, which the narrow expressions refer to
+        bool narrow_input = !input_column_indices.empty() && static_cast<std::size_t>(inputs[0]->num_columns()) == input_column_indices.size();
+        auto & filter_expressions = narrow_input ? narrow_fused_filter_expressions : fused_filter_expressions;
+
+        std::string project_expression = narrow_input ? narrow_expression : expression;
+        std::unique_ptr<ral::frame::BlazingTable> columns;
+        if (filter_expressions.empty()) {
+            columns = ral::processor::process_project(std::move(inputs[0]), project_expression, this->context.get());
+        } else {
+            // the fused filters only read the input, so that it is still available if we need to retry. They make a
+            // selection vector, so only the columns the projection uses are gathered, instead of every column being compacted
+            std::unique_ptr<cudf::column> selection = ral::processor::get_filter_selection(inputs[0]->toBlazingTableView(), filter_expressions);
+            auto selected = ral::processor::gather_selected_columns(inputs[0]->toBlazingTableView(), selection->view(), project_expression);
+            columns = ral::processor::process_project(std::move(selected), project_expression, this->context.get());
+        }
         output->addToCache(std::move(columns));
     }catch(const rmm::bad_alloc& e){
         //can still recover if the input was not a GPUCacheData 
@@ -429,6 +1155,49 @@ ral::execution::task_result Projection::do_process(std::vector< std::unique_ptr<
     return {ral::execution::task_status::SUCCESS, std::string(), std::vector< std::unique_ptr<ral::frame::BlazingTable> > ()};
 }
 
+void Projection::add_fused_filter(const std::string & filter_expression) {
+    fused_filter_expressions.push_back(filter_expression);
+}
+
+void Projection::set_input_columns(std::size_t num_input_columns) {
+    this->num_input_columns = num_input_columns;
+
+    std::vector<int> used_column_indices = get_referenced_column_indices(expression);
+    for (auto & filter_expression : fused_filter_expressions) {
+        auto filter_column_indices = get_referenced_column_indices(filter_expression);
+        used_column_indices.insert(used_column_indices.end(), filter_column_indices.begin(), filter_column_indices.end());
+    }
+    std::sort(used_column_indices.begin(), used_column_indices.end());
+    used_column_indices.erase(std::unique(used_column_indices.begin(), used_column_indices.end()), used_column_indices.end());
+
+    // when no column is used (i.e. only literals are projected) one column is still needed to know the number of rows
+    if (used_column_indices.empty() && num_input_columns > 0) {
+        used_column_indices.push_back(0);
+    }
+    if (used_column_indices.size() >= num_input_columns || used_column_indices.back() >= static_cast<int>(num_input_columns)) {
+        return;
+    }
+
+    std::vector<int> new_column_indices(num_input_columns, -1);
+    for (std::size_t i = 0; i < used_column_indices.size(); i++) {
+        new_column_indices[used_column_indices[i]] = i;
+    }
+    narrow_expression = renumber_column_indices(expression, new_column_indices);
+    narrow_fused_filter_expressions.clear();
+    for (auto & filter_expression : fused_filter_expressions) {
+        narrow_fused_filter_expressions.push_back(renumber_column_indices(filter_expression, new_column_indices));
+    }
+    input_column_indices = used_column_indices;
+}
+
+std::unique_ptr<ral::frame::BlazingTable> Projection::decache_input(ral::cache::CacheData & input) {
+    // a narrow input that is retried already has only the used columns
+    if (!input_column_indices.empty() && input.num_columns() == num_input_columns) {
+        return input.decache(input_column_indices);
+    }
+    return input.decache();
+}
+
 kstatus Projection::run() {
     CodeTimer timer;
 
@@ -436,14 +1205,24 @@ kstatus Projection::run() {
     RAL_EXPECTS(cache_data != nullptr, "ERROR: Projection::run() first input CacheData was nullptr");
 
     // When this kernel will project all the columns (with or without aliases)
-    // we want to avoid caching and decahing for this kernel
+    // we want to avoid caching and decahing for this kernel, unless it has filters to apply
     bool bypassing_project, bypassing_project_with_aliases;
     std::vector<std::string> aliases;
     std::vector<std::string> column_names = cache_data->names();
     std::tie(bypassing_project, bypassing_project_with_aliases, aliases) = bypassingProject(this->expression, column_names);
+    if (!fused_filter_expressions.empty()) {
+        bypassing_project = false;
+        bypassing_project_with_aliases = false;
+    }
+
+    if (!bypassing_project && !bypassing_project_with_aliases) {
+        set_input_columns(column_names.size());
+    }
 
     while(cache_data != nullptr){
-        if (bypassing_project_with_aliases) {
+        if (this->stop_requested()) {
+            // the input is still drained, so that the kernels before this one don't wait for it
+        } else if (bypassing_project_with_aliases) {
             cache_data->set_names(aliases);
             this->add_to_output_cache(std::move(cache_data));
         } else if (bypassing_project) {
@@ -499,6 +1278,7 @@ Filter::Filter(std::size_t kernel_id, const std::string & queryString, std::shar
 : kernel(kernel_id, queryString, context, kernel_type::FilterKernel)
 {
     this->query_graph = query_graph;
+    this->is_constant_condition = ral::processor::is_constant_filter_condition(this->expression, this->constant_condition_value);
 }
 
 ral::execution::task_result Filter::do_process(std::vector< std::unique_ptr<ral::frame::BlazingTable> > inputs,
@@ -523,17 +1303,33 @@ kstatus Filter::run() {
     CodeTimer timer;
 
     std::unique_ptr <ral::cache::CacheData> cache_data = this->input_cache()->pullCacheData();
+    std::unique_ptr<ral::frame::BlazingTable> empty_output;
     while(cache_data != nullptr){
-        std::vector<std::unique_ptr <ral::cache::CacheData> > inputs;
-        inputs.push_back(std::move(cache_data));
+        // once the output is not needed the input is only drained
+        if (this->stop_requested()) {
+            // do nothing
+        } else if (this->is_constant_condition && this->constant_condition_value) {
+            this->add_to_output_cache(std::move(cache_data));
+        } else if (this->is_constant_condition) {
+            // no row passes, so only the schema of the input is kept, for one empty batch at the end
+            if (empty_output == nullptr) {
+                empty_output = ral::utilities::create_empty_table(cache_data->names(), cache_data->get_schema());
+            }
+        } else {
+            std::vector<std::unique_ptr <ral::cache::CacheData> > inputs;
+            inputs.push_back(std::move(cache_data));
 
-        ral::execution::executor::get_instance()->add_task(
-                std::move(inputs),
-                this->output_cache(),
-                this);
+            ral::execution::executor::get_instance()->add_task(
+                    std::move(inputs),
+                    this->output_cache(),
+                    this);
+        }
 
         cache_data = this->input_cache()->pullCacheData();
     }
+    if (empty_output != nullptr) {
+        this->add_to_output_cache(std::move(empty_output));
+    }
 
     if(logger){
         logger->debug("{query_id}|{step}|{substep}|{info}|{duration}|kernel_id|{kernel_id}||",
@@ -584,6 +1380,321 @@ std::pair<bool, uint64_t> Filter::get_estimated_output_num_rows(){
 
 // END Filter
 
+// BEGIN Materialize
+
+Materialize::Materialize(std::size_t kernel_id, const std::string & queryString, const std::string & fingerprint,
+    std::shared_ptr<Context> context, std::shared_ptr<ral::cache::graph> query_graph)
+: kernel(kernel_id, queryString, context, kernel_type::MaterializeKernel), fingerprint(fingerprint),
+    result(std::make_shared<ral::cache::materialized_result>())
+{
+    this->query_graph = query_graph;
+}
+
+ral::execution::task_result Materialize::do_process(std::vector< std::unique_ptr<ral::frame::BlazingTable> > inputs,
+    std::shared_ptr<ral::cache::CacheMachine> output,
+    cudaStream_t stream, const std::map<std::string, std::string>& /*args*/) {
+
+    try{
+        auto & input = inputs[0];
+        auto host_table = ral::communication::messages::serialize_gpu_message_to_host_table(input->toBlazingTableView(), false, stream);
+        {
+            std::lock_guard<std::mutex> lock(result_mutex);
+            result->bytes += host_table->sizeInBytes();
+            result->tables.push_back(std::move(host_table));
+        }
+        output->addToCache(std::move(input));
+    }catch(const rmm::bad_alloc& e){
+        return {ral::execution::task_status::RETRY, std::string(e.what()), std::move(inputs)};
+    }catch(const std::exception& e){
+        return {ral::execution::task_status::FAIL, std::string(e.what()), std::vector< std::unique_ptr<ral::frame::BlazingTable> > ()};
+    }
+
+    return {ral::execution::task_status::SUCCESS, std::string(), std::vector< std::unique_ptr<ral::frame::BlazingTable> > ()};
+}
+
+kstatus Materialize::run() {
+    CodeTimer timer;
+
+    std::unique_ptr <ral::cache::CacheData> cache_data = this->input_cache()->pullCacheData();
+    while(cache_data != nullptr){
+        std::vector<std::unique_ptr <ral::cache::CacheData> > inputs;
+        inputs.push_back(std::move(cache_data));
+
+        ral::execution::executor::get_instance()->add_task(
+                std::move(inputs),
+                this->output_cache(),
+                this);
+
+        cache_data = this->input_cache()->pullCacheData();
+    }
+
+    std::unique_lock<std::mutex> lock(kernel_mutex);
+    kernel_cv.wait(lock,[this]{
+        return this->tasks.empty() || ral::execution::executor::get_instance()->has_exception();
+    });
+
+    if(auto ep = ral::execution::executor::get_instance()->last_exception()){
+        std::rethrow_exception(ep);
+    }
+
+    std::size_t max_bytes = context->getConfig().materialization_cache_max_bytes.value_or(1073741824); // 1 GB
+    bool added = !result->tables.empty() &&
+        ral::cache::materialization_cache::get_instance().put(fingerprint, std::move(result), max_bytes);
+
+    if(logger) {
+        logger->debug("{query_id}|{step}|{substep}|{info}|{duration}|kernel_id|{kernel_id}||",
+                                    "query_id"_a=context->getContextToken(),
+                                    "step"_a=context->getQueryStep(),
+                                    "substep"_a=context->getQuerySubstep(),
+                                    "info"_a=added ? "Materialize Kernel Completed, result added to the materialization cache" : "Materialize Kernel Completed",
+                                    "duration"_a=timer.elapsed_time(),
+                                    "kernel_id"_a=this->get_id());
+    }
+
+    return kstatus::proceed;
+}
+
+// END Materialize
+
+// BEGIN MaterializedResultScan
+
+MaterializedResultScan::MaterializedResultScan(std::size_t kernel_id, const std::string & queryString, std::shared_ptr<const ral::cache::materialized_result> result,
+    std::shared_ptr<Context> context, std::shared_ptr<ral::cache::graph> query_graph)
+: kernel(kernel_id, queryString, context, kernel_type::MaterializedResultScanKernel), result(result)
+{
+    this->query_graph = query_graph;
+}
+
+ral::execution::task_result MaterializedResultScan::do_process(std::vector< std::unique_ptr<ral::frame::BlazingTable> > /*inputs*/,
+    std::shared_ptr<ral::cache::CacheMachine> /*output*/,
+    cudaStream_t /*stream*/, const std::map<std::string, std::string>& /*args*/) {
+    // the batches are copied directly in run()
+    return {ral::execution::task_status::SUCCESS, std::string(), std::vector< std::unique_ptr<ral::frame::BlazingTable> > ()};
+}
+
+kstatus MaterializedResultScan::run() {
+    CodeTimer timer;
+
+    // the materialized result can be read by several queries at the same time, so its host tables are copied and not moved
+    for (auto & host_table : result->tables) {
+        this->add_to_output_cache(host_table->get_gpu_table());
+    }
+
+    if(logger) {
+        logger->debug("{query_id}|{step}|{substep}|{info}|{duration}|kernel_id|{kernel_id}||",
+                                    "query_id"_a=context->getContextToken(),
+                                    "step"_a=context->getQueryStep(),
+                                    "substep"_a=context->getQuerySubstep(),
+                                    "info"_a="MaterializedResultScan Kernel Completed",
+                                    "duration"_a=timer.elapsed_time(),
+                                    "kernel_id"_a=this->get_id());
+    }
+
+    return kstatus::proceed;
+}
+
+std::pair<bool, uint64_t> MaterializedResultScan::get_estimated_output_num_rows(){
+    uint64_t num_rows = 0;
+    for (auto & host_table : result->tables) {
+        num_rows += host_table->num_rows();
+    }
+    return std::make_pair(true, num_rows);
+}
+
+// END MaterializedResultScan
+
+// BEGIN CachedTableScan
+
+CachedTableScan::CachedTableScan(std::size_t kernel_id, const std::string & queryString, std::shared_ptr<ral::cache::cached_table> table,
+    const std::vector<int> & column_indices, std::shared_ptr<Context> context, std::shared_ptr<ral::cache::graph> query_graph)
+: kernel(kernel_id, queryString, context, kernel_type::CachedTableScanKernel), table(table), column_indices(column_indices)
+{
+    this->query_graph = query_graph;
+    this->filterable = is_filtered_bindable_scan(expression);
+
+    // the columns of the filter are the projected ones
+    if (this->filterable) {
+        for (auto & column_ranges : get_literal_ranges(get_named_expression(expression, "filters"))) {
+            if (column_ranges.first >= 0 && column_ranges.first < static_cast<int>(column_indices.size()) &&
+                    table->has_index(column_indices[column_ranges.first])) {
+                key_column_index = column_indices[column_ranges.first];
+                key_ranges = column_ranges.second;
+                break;
+            }
+        }
+    }
+}
+
+ral::execution::task_result CachedTableScan::do_process(std::vector< std::unique_ptr<ral::frame::BlazingTable> > inputs,
+    std::shared_ptr<ral::cache::CacheMachine> output,
+    cudaStream_t /*stream*/, const std::map<std::string, std::string>& /*args*/) {
+    auto & input = inputs[0];
+
+    try{
+        if(this->filterable) {
+            input = ral::processor::process_filter(input->toBlazingTableView(), expression, this->context.get());
+        }
+        if(is_bindable_scan(expression)) {
+            input->setNames(fix_column_aliases(input->names(), expression));
+        }
+        this->apply_runtime_filters(input);
+        output->addToCache(std::move(input));
+    }catch(const rmm::bad_alloc& e){
+        return {ral::execution::task_status::RETRY, std::string(e.what()), std::move(inputs)};
+    }catch(const std::exception& e){
+        return {ral::execution::task_status::FAIL, std::string(e.what()), std::vector< std::unique_ptr<ral::frame::BlazingTable> > ()};
+    }
+
+    return {ral::execution::task_status::SUCCESS, std::string(), std::vector< std::unique_ptr<ral::frame::BlazingTable> > ()};
+}
+
+kstatus CachedTableScan::run() {
+    CodeTimer timer;
+
+    // the cached table can be read by several queries at the same time, so its batches are copied and not moved
+    std::size_t num_batches = table->num_batches();
+    for (std::size_t i = 0; i < num_batches && !this->stop_requested(); i++) {
+        this->wait_for_output_cache_to_drain();
+        if (this->stop_requested()) {
+            break;
+        }
+
+        std::vector<std::unique_ptr<ral::cache::CacheData> > inputs;
+        // the filter is still applied to the rows the index finds, since they only satisfy its bounds of the key
+        std::unique_ptr<ral::frame::BlazingTable> batch = key_column_index >= 0 ?
+            table->get_batch(i, column_indices, key_column_index, key_ranges) : table->get_batch(i, column_indices);
+        inputs.push_back(std::make_unique<ral::cache::GPUCacheData>(std::move(batch)));
+        ral::execution::executor::get_instance()->add_task(
+                std::move(inputs),
+                this->output_cache(),
+                this);
+    }
+
+    std::unique_lock<std::mutex> lock(kernel_mutex);
+    kernel_cv.wait(lock,[this]{
+        return this->tasks.empty() || ral::execution::executor::get_instance()->has_exception();
+    });
+
+    if(auto ep = ral::execution::executor::get_instance()->last_exception()){
+        std::rethrow_exception(ep);
+    }
+
+    if(logger) {
+        logger->debug("{query_id}|{step}|{substep}|{info}|{duration}|kernel_id|{kernel_id}||",
+                                    "query_id"_a=context->getContextToken(),
+                                    "step"_a=context->getQueryStep(),
+                                    "substep"_a=context->getQuerySubstep(),
+                                    "info"_a="CachedTableScan Kernel Completed",
+                                    "duration"_a=timer.elapsed_time(),
+                                    "kernel_id"_a=this->get_id());
+    }
+
+    return kstatus::proceed;
+}
+
+std::pair<bool, uint64_t> CachedTableScan::get_estimated_output_num_rows(){
+    // the rows of the table are only known to be the output when there is no filter
+    return std::make_pair(!this->filterable, table->num_rows());
+}
+
+// END CachedTableScan
+
+// BEGIN SpoolKernel
+
+SpoolKernel::SpoolKernel(std::size_t kernel_id, const std::string & queryString,
+    std::shared_ptr<Context> context, std::shared_ptr<ral::cache::graph> query_graph)
+: kernel(kernel_id, queryString, context, kernel_type::SpoolKernel)
+{
+    this->query_graph = query_graph;
+}
+
+std::string SpoolKernel::add_consumer_port() {
+    std::string port_name = "output_" + std::to_string(consumer_ports.size());
+    consumer_ports.push_back(port_name);
+    return port_name;
+}
+
+ral::execution::task_result SpoolKernel::do_process(std::vector< std::unique_ptr<ral::frame::BlazingTable> > inputs,
+    std::shared_ptr<ral::cache::CacheMachine> /*output*/,
+    cudaStream_t /*stream*/, const std::map<std::string, std::string>& /*args*/) {
+
+    try{
+        auto & input = inputs[0];
+        // all the copies are made before any of them is added, so that a retry does not give a batch twice to a consumer
+        std::vector<std::unique_ptr<ral::frame::BlazingTable>> copies;
+        for (std::size_t i = 1; i < consumer_ports.size(); i++) {
+            copies.push_back(input->toBlazingTableView().clone());
+        }
+        for (std::size_t i = 1; i < consumer_ports.size(); i++) {
+            this->add_to_output_cache(std::move(copies[i - 1]), consumer_ports[i]);
+        }
+        this->add_to_output_cache(std::move(input), consumer_ports[0]);
+    }catch(const rmm::bad_alloc& e){
+        return {ral::execution::task_status::RETRY, std::string(e.what()), std::move(inputs)};
+    }catch(const std::exception& e){
+        return {ral::execution::task_status::FAIL, std::string(e.what()), std::vector< std::unique_ptr<ral::frame::BlazingTable> > ()};
+    }
+
+    return {ral::execution::task_status::SUCCESS, std::string(), std::vector< std::unique_ptr<ral::frame::BlazingTable> > ()};
+}
+
+kstatus SpoolKernel::run() {
+    CodeTimer timer;
+
+    RAL_EXPECTS(!consumer_ports.empty(), "ERROR: SpoolKernel::run() has no consumers");
+
+    std::unique_ptr <ral::cache::CacheData> cache_data = this->input_cache()->pullCacheData();
+    while(cache_data != nullptr){
+        std::vector<std::unique_ptr <ral::cache::CacheData> > inputs;
+        inputs.push_back(std::move(cache_data));
+
+        ral::execution::executor::get_instance()->add_task(
+                std::move(inputs),
+                this->output_cache(consumer_ports[0]),
+                this);
+
+        cache_data = this->input_cache()->pullCacheData();
+    }
+
+    std::unique_lock<std::mutex> lock(kernel_mutex);
+    kernel_cv.wait(lock,[this]{
+        return this->tasks.empty() || ral::execution::executor::get_instance()->has_exception();
+    });
+
+    if(auto ep = ral::execution::executor::get_instance()->last_exception()){
+        std::rethrow_exception(ep);
+    }
+
+    if(logger) {
+        logger->debug("{query_id}|{step}|{substep}|{info}|{duration}|kernel_id|{kernel_id}||",
+                                    "query_id"_a=context->getContextToken(),
+                                    "step"_a=context->getQueryStep(),
+                                    "substep"_a=context->getQuerySubstep(),
+                                    "info"_a="Spool Kernel Completed for " + std::to_string(consumer_ports.size()) + " consumers",
+                                    "duration"_a=timer.elapsed_time(),
+                                    "kernel_id"_a=this->get_id());
+    }
+
+    return kstatus::proceed;
+}
+
+std::size_t SpoolKernel::estimate_output_bytes(const std::vector<std::unique_ptr<ral::cache::CacheData > > & inputs) {
+    std::size_t input_bytes = 0;
+    for (auto & input : inputs) {
+        input_bytes += input->sizeInBytes();
+    }
+    return consumer_ports.size() > 1 ? input_bytes * (consumer_ports.size() - 1) : 0;
+}
+
+void SpoolKernel::request_stop() {
+    // a consumer asks only once, since its own stop is only requested once
+    if (this->stop_requests.fetch_add(1) + 1 >= consumer_ports.size()) {
+        kernel::request_stop();
+    }
+}
+
+// END SpoolKernel
+
 // BEGIN Print
 
 kstatus Print::run() {
@@ -600,23 +1711,77 @@ kstatus Print::run() {
 
 // BEGIN OutputKernel
 
-kstatus OutputKernel::run() {
-    while (this->input_.get_cache()->wait_for_next()) {
-        std::unique_ptr<frame::BlazingTable> temp_output = this->input_.get_cache()->pullFromCache();
+OutputKernel::OutputKernel(std::size_t kernel_id, std::shared_ptr<Context> context)
+: kernel(kernel_id,"OutputKernel", context, kernel_type::OutputKernel), done(false) {
+    const blazingdb::manager::QueryConfig & config = context->getConfig();
+    std::string output_path = config.output_path.value_or("");
+    if (!output_path.empty()) {
+        std::string output_format = config.output_format.value_or("parquet");
+        std::size_t max_file_bytes = config.output_file_max_bytes.value_or(268435456);
+        int node_index = std::max(context->getNodeIndex(ral::communication::CommunicationData::getInstance().getSelfNode()), 0);
+        this->writer = std::make_unique<ral::io::result_writer>(output_path, output_format, max_file_bytes, node_index);
+    }
+    this->streaming = !this->writer && config.return_iterator.value_or(false);
+    if (config.result_iterator_max_batches) {
+        this->max_queued_batches = std::max<std::size_t>(*config.result_iterator_max_batches, 1);
+    }
+}
 
-        if(temp_output){
-            output.emplace_back(std::move(temp_output));
+kstatus OutputKernel::run() {
+    try {
+        while (this->input_.get_cache()->wait_for_next()) {
+            std::unique_ptr<frame::BlazingTable> temp_output = this->input_.get_cache()->pullFromCache();
+
+            if(temp_output){
+                if (this->writer) {
+                    // every node writes its part of the output as it comes, so that it is never gathered
+                    this->writer->write(std::move(temp_output));
+                } else if (this->streaming) {
+                    // the batches that were not taken yet hold back the kernel, and through its input cache the rest of the graph
+                    std::unique_lock<std::mutex> lock(output_mutex);
+                    while (output.size() >= max_queued_batches && !this->is_cancelled()) {
+                        output_cv.wait_for(lock, std::chrono::milliseconds(100));
+                    }
+                    output.emplace_back(std::move(temp_output));
+                    output_cv.notify_all();
+                } else {
+                    output.emplace_back(std::move(temp_output));
+                }
+            }
+        }
+        if (this->writer) {
+            output.emplace_back(this->writer->finish());
         }
+    } catch(...) {
+        std::lock_guard<std::mutex> lock(output_mutex);
+        done = true;
+        output_cv.notify_all();
+        throw;
     }
+    std::lock_guard<std::mutex> lock(output_mutex);
     done = true;
+    output_cv.notify_all();
 
     return kstatus::stop;
 }
 
 frame_type OutputKernel::release() {
+    std::lock_guard<std::mutex> lock(output_mutex);
     return std::move(output);
 }
 
+std::unique_ptr<ral::frame::BlazingTable> OutputKernel::next_batch() {
+    std::unique_lock<std::mutex> lock(output_mutex);
+    output_cv.wait(lock, [this]{ return !output.empty() || done.load(); });
+    if (output.empty()) {
+        return nullptr;
+    }
+    std::unique_ptr<ral::frame::BlazingTable> batch = std::move(output.front());
+    output.erase(output.begin());
+    output_cv.notify_all();
+    return batch;
+}
+
 bool OutputKernel::is_done() {
     return done.load();
 }
@@ -1,16 +1,23 @@
 #pragma once
 
+#include <condition_variable>
 #include <mutex>
 #include <typeinfo>
 #include "cache_machine/CacheMachine.h"
 #include "execution_graph/graph.h"
 #include "io/Schema.h"
 #include "io/DataLoader.h"
+#include "io/ResultWriter.h"
 #include "execution_kernels/kernel.h"
+#include "execution_kernels/scan_work_stealing.h"
 #include "execution_kernels/LogicPrimitives.h"
 
 #include "cache_machine/CacheDataIO.h"
 #include "cache_machine/ArrowCacheData.h"
+#include "cache_machine/MaterializationCache.h"
+#include "cache_machine/TableCache.h"
+#include "operators/MetadataAggregation.h"
+#include "operators/TableSample.h"
 
 #include "io/data_parser/CSVParser.h"
 #include "io/data_parser/JSONParser.h"
@@ -122,7 +129,7 @@ private:
 /**
  * @brief This kernel loads the data from the specified data source.
  */
-class TableScan : public kernel {
+class TableScan : public distributing_kernel {
 public:
     /**
      * Constructor for TableScan
@@ -158,12 +165,59 @@ public:
      */
     std::pair<bool, uint64_t> get_estimated_output_num_rows() override;
 
+    /**
+     * Answers the row groups that the aggregation consuming this scan can get from the statistics of the files,
+     * see ral::operators::metadata_aggregation. Those row groups are not read.
+     */
+    void set_metadata_aggregation(std::shared_ptr<ral::operators::metadata_aggregation> aggregation) {
+        this->metadata_aggregation = aggregation;
+    }
+
+    /**
+     * Copies the cached columns of the batches this scan reads into the table_cache, when the scan reads the whole table.
+     */
+    void set_table_cache_fill(std::shared_ptr<ral::cache::table_cache_fill> cache_fill) {
+        this->cache_fill = cache_fill;
+    }
+
+    /**
+     * Reads only a sample of the table, for the TABLESAMPLE over the scan. A SYSTEM sample skips the row groups that it
+     * does not keep, and a BERNOULLI sample filters the rows of every batch.
+     */
+    void set_table_sample(const ral::operators::table_sample & sample) {
+        this->sample = std::make_unique<ral::operators::table_sample>(sample);
+    }
+
+    /**
+     * Makes the queries of a SQL table return only their first rows of the sort with a limit over the scan, see
+     * ral::io::abstractsql_data_provider::set_limit_pushdown.
+     * @return false if the table is not a SQL table or its database can't apply them.
+     */
+    bool set_limit_pushdown(const std::string & sort_expression);
+
 private:
+    /**
+     * Adds the pending row groups as one task, and clears them.
+     */
+    void add_pending_scan_task();
+
+    /**
+     * The args of a task that reads some row groups, with the seed of the rows of its BERNOULLI sample.
+     */
+    std::map<std::string, std::string> get_task_args();
+
     std::shared_ptr<ral::io::data_provider> provider;
     std::shared_ptr<ral::io::data_parser> parser;
     ral::io::Schema  schema; /**< Table schema associated to the data to be loaded. */
     size_t file_index = 0;
-    size_t num_batches;
+    size_t num_batches; /**< The number of tasks that the scan makes, a batch each, for get_estimated_output_num_rows. */
+    size_t scan_task_target_bytes = 0; /**< The size of the row groups of every task, 0 makes one task per file. */
+    std::vector<std::unique_ptr<ral::cache::CacheData>> pending_scan_inputs; /**< Row groups of small files, read by the next task. */
+    size_t pending_scan_bytes = 0; /**< The size of the row groups in pending_scan_inputs. */
+    std::shared_ptr<ral::operators::metadata_aggregation> metadata_aggregation;
+    std::shared_ptr<ral::cache::table_cache_fill> cache_fill;
+    std::unique_ptr<ral::operators::table_sample> sample;
+    size_t num_sampled_tasks = 0; /**< The tasks made so far, every one gets the seed of its index. */
 };
 
 /**
@@ -171,7 +225,7 @@ private:
  * It also filters the data if there are one or more filters, and sets their column aliases
  * accordingly.
  */
-class BindableTableScan : public kernel {
+class BindableTableScan : public distributing_kernel {
 public:
     /**
      * Constructor for BindableTableScan
@@ -206,14 +260,56 @@ public:
      */
     std::pair<bool, uint64_t> get_estimated_output_num_rows() override;
 
+    /**
+     * With ENABLE_LATE_MATERIALIZATION, decodes the columns of the filter of a file first and evaluates it, and then
+     * decodes the rest of the columns only for the row groups that have rows that pass it.
+     */
+    std::unique_ptr<ral::frame::BlazingTable> decache_input(ral::cache::CacheData & input) override;
+
+    /**
+     * Answers the row groups that the aggregation consuming this scan can get from the statistics of the files,
+     * see ral::operators::metadata_aggregation. Those row groups are not read.
+     */
+    void set_metadata_aggregation(std::shared_ptr<ral::operators::metadata_aggregation> aggregation) {
+        this->metadata_aggregation = aggregation;
+    }
+
+    /**
+     * Copies the cached columns of the batches this scan reads into the table_cache, when the scan reads the whole table.
+     */
+    void set_table_cache_fill(std::shared_ptr<ral::cache::table_cache_fill> cache_fill) {
+        this->cache_fill = cache_fill;
+    }
+
+    /**
+     * Makes the queries of a SQL table compute the partial aggregations of the LogicalAggregate over the scan, see
+     * ral::io::abstractsql_data_provider::set_aggregation_pushdown. The scan then outputs the partial aggregations
+     * instead of the rows.
+     * @return false if the table is not a SQL table, its filter was not pushed down too, or its database can't
+     * compute them.
+     */
+    bool set_aggregation_pushdown(const std::string & aggregate_expression);
+
+    /**
+     * See TableScan::set_limit_pushdown, the filter of the scan must be pushed down too.
+     */
+    bool set_limit_pushdown(const std::string & sort_expression);
+
 private:
     std::shared_ptr<ral::io::data_provider> provider;
     std::shared_ptr<ral::io::data_parser> parser;
     ral::io::Schema  schema; /**< Table schema associated to the data to be loaded. */
+    ral::io::Schema aggregation_schema; /**< The schema of the partial aggregations the database computes, when they are pushed down. */
+    bool aggregation_pushed_down = false;
     size_t file_index = 0;
     size_t num_batches;
     bool filterable;
     bool predicate_pushdown_done;
+    std::vector<int> predicate_column_indices; /**< The projected columns the filter uses, when they are late materialized. */
+    std::string narrow_filter_condition; /**< The filter, renumbered for predicate_column_indices. */
+    std::map<int, std::vector<std::string>> equality_literals; /**< The values the filter compares the projected columns with, to prune the parquet row groups. */
+    std::shared_ptr<ral::operators::metadata_aggregation> metadata_aggregation;
+    std::shared_ptr<ral::cache::table_cache_fill> cache_fill;
 };
 
 /**
@@ -232,6 +328,19 @@ public:
 
     std::string kernel_name() { return "Projection";}
 
+    /**
+     * Adds a filter that is applied to every batch in the same task, before the projection.
+     * This is used to fuse the Filter kernels that would feed this kernel, to avoid passing the batches through a cache.
+     * The filters are applied in the order they are added.
+     * @param filter_expression the logical expression of the filter.
+     */
+    void add_fused_filter(const std::string & filter_expression);
+
+    /**
+     * Decaches only the columns that the projection and its fused filters use.
+     */
+    std::unique_ptr<ral::frame::BlazingTable> decache_input(ral::cache::CacheData & input) override;
+
     ral::execution::task_result do_process(std::vector< std::unique_ptr<ral::frame::BlazingTable> > inputs,
         std::shared_ptr<ral::cache::CacheMachine> output,
         cudaStream_t stream, const std::map<std::string, std::string>& args) override;
@@ -243,6 +352,20 @@ public:
      * @return kstatus 'stop' to halt processing, or 'proceed' to continue processing.
      */
     kstatus run() override;
+
+private:
+    /**
+     * Finds the input columns used by the projection and its fused filters. If some are not used, the inputs are decached
+     * without them and the expressions are renumbered to work on the narrower inputs.
+     * @param num_input_columns the number of columns of the inputs.
+     */
+    void set_input_columns(std::size_t num_input_columns);
+
+    std::vector<std::string> fused_filter_expressions; /**< Filters applied before the projection, in order. */
+    std::size_t num_input_columns = 0; /**< The number of columns of the inputs. */
+    std::vector<int> input_column_indices; /**< The input columns used, only set when some columns are not used. */
+    std::string narrow_expression; /**< The projection, renumbered to the columns in input_column_indices. */
+    std::vector<std::string> narrow_fused_filter_expressions; /**< The fused filters, renumbered to the columns in input_column_indices. */
 };
 
 /**
@@ -278,6 +401,184 @@ public:
      * @return A pair representing that there is no data to be processed, or the estimated number of output rows.
      */
     std::pair<bool, uint64_t> get_estimated_output_num_rows() override;
+
+private:
+    // when the condition is a constant the batches are passed along or dropped as they are, without being decached
+    bool is_constant_condition = false;
+    bool constant_condition_value = false;
+};
+
+/**
+ * @brief This kernel passes its input through unchanged while it keeps a host copy of it,
+ * which is added to the materialization cache once the subplan below it is done, so that later queries can reuse it.
+ */
+class Materialize : public kernel {
+public:
+    /**
+     * Constructor for Materialize
+     * @param kernel_id Kernel identifier.
+     * @param queryString Original logical expression that the kernel will execute.
+     * @param fingerprint Fingerprint of the subplan whose output is materialized.
+     * @param context Shared context associated to the running query.
+     * @param query_graph Shared pointer of the current execution graph.
+     */
+    Materialize(std::size_t kernel_id, const std::string & queryString, const std::string & fingerprint,
+        std::shared_ptr<Context> context, std::shared_ptr<ral::cache::graph> query_graph);
+
+    std::string kernel_name() { return "Materialize";}
+
+    ral::execution::task_result do_process(std::vector< std::unique_ptr<ral::frame::BlazingTable> > inputs,
+        std::shared_ptr<ral::cache::CacheMachine> output,
+        cudaStream_t stream, const std::map<std::string, std::string>& args) override;
+
+    /**
+     * Executes the batch processing.
+     * Loads the data from their input port, and after processing it,
+     * the results are stored in their output port.
+     * @return kstatus 'stop' to halt processing, or 'proceed' to continue processing.
+     */
+    kstatus run() override;
+
+private:
+    std::string fingerprint; /**< Fingerprint of the subplan whose output is materialized. */
+    std::mutex result_mutex; /**< Protects the result, since the tasks add to it concurrently. */
+    std::shared_ptr<ral::cache::materialized_result> result; /**< The host copies of the batches that went through so far. */
+};
+
+/**
+ * @brief This kernel gives the batches of a result that was materialized by a previous query, instead of running its subplan again.
+ */
+class MaterializedResultScan : public kernel {
+public:
+    /**
+     * Constructor for MaterializedResultScan
+     * @param kernel_id Kernel identifier.
+     * @param queryString Original logical expression that the kernel will execute.
+     * @param result The materialized result this kernel gives.
+     * @param context Shared context associated to the running query.
+     * @param query_graph Shared pointer of the current execution graph.
+     */
+    MaterializedResultScan(std::size_t kernel_id, const std::string & queryString, std::shared_ptr<const ral::cache::materialized_result> result,
+        std::shared_ptr<Context> context, std::shared_ptr<ral::cache::graph> query_graph);
+
+    std::string kernel_name() { return "MaterializedResultScan";}
+
+    ral::execution::task_result do_process(std::vector< std::unique_ptr<ral::frame::BlazingTable> > inputs,
+        std::shared_ptr<ral::cache::CacheMachine> output,
+        cudaStream_t stream, const std::map<std::string, std::string>& args) override;
+
+    /**
+     * Executes the batch processing.
+     * Copies every batch of the materialized result into its output port.
+     * @return kstatus 'stop' to halt processing, or 'proceed' to continue processing.
+     */
+    kstatus run() override;
+
+    /**
+     * Returns the estimated num_rows for the output at one point.
+     * @return A pair representing that the number of output rows is known, and that number.
+     */
+    std::pair<bool, uint64_t> get_estimated_output_num_rows() override;
+
+private:
+    std::shared_ptr<const ral::cache::materialized_result> result; /**< The materialized result this kernel gives. */
+};
+
+/**
+ * @brief This kernel gives the batches of a table that is in the table_cache, instead of reading its files.
+ * It filters them and sets their column aliases like the scan it replaces would. When the filter bounds an indexed
+ * column by literals, only the rows that the index finds in those bounds are filtered.
+ */
+class CachedTableScan : public kernel {
+public:
+    /**
+     * Constructor for CachedTableScan
+     * @param kernel_id Kernel identifier.
+     * @param queryString Original logical expression that the kernel will execute.
+     * @param table The cached table this kernel reads.
+     * @param column_indices The calcite indices of the columns the scan projects, all of them are cached.
+     * @param context Shared context associated to the running query.
+     * @param query_graph Shared pointer of the current execution graph.
+     */
+    CachedTableScan(std::size_t kernel_id, const std::string & queryString, std::shared_ptr<ral::cache::cached_table> table,
+        const std::vector<int> & column_indices, std::shared_ptr<Context> context, std::shared_ptr<ral::cache::graph> query_graph);
+
+    std::string kernel_name() { return "CachedTableScan";}
+
+    ral::execution::task_result do_process(std::vector< std::unique_ptr<ral::frame::BlazingTable> > inputs,
+        std::shared_ptr<ral::cache::CacheMachine> output,
+        cudaStream_t stream, const std::map<std::string, std::string>& args) override;
+
+    /**
+     * Executes the batch processing.
+     * Makes a task for every batch of the cached table.
+     * @return kstatus 'stop' to halt processing, or 'proceed' to continue processing.
+     */
+    kstatus run() override;
+
+    /**
+     * Returns the estimated num_rows for the output at one point.
+     * @return A pair representing that the number of rows of the table is known, and that number.
+     */
+    std::pair<bool, uint64_t> get_estimated_output_num_rows() override;
+
+private:
+    std::shared_ptr<ral::cache::cached_table> table; /**< The cached table this kernel reads. */
+    std::vector<int> column_indices; /**< The calcite indices of the columns the scan projects. */
+    bool filterable;
+    int key_column_index = -1; /**< The calcite index of the indexed column the filter bounds, -1 if there is none. */
+    std::vector<literal_range> key_ranges; /**< The ranges of that column that the rows that pass the filter are in. */
+};
+
+/**
+ * @brief This kernel gives every batch of a subplan to several consumers, when the same subplan is used more than once in a query,
+ * as by a CTE that is read twice or a self join. The subplan runs once, and every consumer has its own output cache,
+ * which spills its batches like any other cache when the consumers read them at different times.
+ */
+class SpoolKernel : public kernel {
+public:
+    /**
+     * Constructor for SpoolKernel
+     * @param kernel_id Kernel identifier.
+     * @param queryString Original logical expression that the kernel will execute.
+     * @param context Shared context associated to the running query.
+     * @param query_graph Shared pointer of the current execution graph.
+     */
+    SpoolKernel(std::size_t kernel_id, const std::string & queryString,
+        std::shared_ptr<Context> context, std::shared_ptr<ral::cache::graph> query_graph);
+
+    std::string kernel_name() { return "Spool";}
+
+    /**
+     * Gives a new output port for a consumer of this kernel. It must be called for every consumer before the graph is executed.
+     * @return The name of the output port.
+     */
+    std::string add_consumer_port();
+
+    ral::execution::task_result do_process(std::vector< std::unique_ptr<ral::frame::BlazingTable> > inputs,
+        std::shared_ptr<ral::cache::CacheMachine> output,
+        cudaStream_t stream, const std::map<std::string, std::string>& args) override;
+
+    /**
+     * Executes the batch processing.
+     * Loads the data from their input port, and copies it into the output port of every consumer.
+     * @return kstatus 'stop' to halt processing, or 'proceed' to continue processing.
+     */
+    kstatus run() override;
+
+    /**
+     * Every consumer but one gets a copy of the inputs.
+     */
+    std::size_t estimate_output_bytes(const std::vector<std::unique_ptr<ral::cache::CacheData > > & inputs) override;
+
+    /**
+     * The subplan is only told to stop once all the consumers asked for it.
+     */
+    void request_stop() override;
+
+private:
+    std::vector<std::string> consumer_ports; /**< The output port of every consumer. */
+    std::atomic<std::size_t> stop_requests{0}; /**< The consumers that need no more of the output. */
 };
 
 /**
@@ -319,7 +620,7 @@ public:
      * @param kernel_id Kernel identifier.
      * @param context Shared context associated to the running query.
      */
-    OutputKernel(std::size_t kernel_id, std::shared_ptr<Context> context) : kernel(kernel_id,"OutputKernel", context, kernel_type::OutputKernel), done(false) { }
+    OutputKernel(std::size_t kernel_id, std::shared_ptr<Context> context);
 
     std::string kernel_name() { return "Output";}
 
@@ -342,6 +643,7 @@ public:
 
     /**
      * Returns the vector containing the final processed output.
+     * With OUTPUT_PATH, it is a single table with the files this node wrote the output to.
      * @return frame_type A vector of unique_ptr of BlazingTables.
      */
     frame_type release();
@@ -352,9 +654,27 @@ public:
      */
     bool is_done();
 
+    /**
+     * Returns true when the output is delivered batch by batch with next_batch instead of with release, as it is when
+     * the query is run with RETURN_ITERATOR.
+     */
+    bool is_streaming() const { return streaming; }
+
+    /**
+     * Waits for the next batch of the output of a streaming query and takes it, which lets the kernel keep
+     * the next one once it holds RESULT_ITERATOR_MAX_BATCHES of them.
+     * @return the next batch, or nullptr when the kernel is done and all of its batches were taken.
+     */
+    std::unique_ptr<ral::frame::BlazingTable> next_batch();
+
 protected:
     frame_type output; /**< Vector of tables with the final output. */
     std::atomic<bool> done;
+    bool streaming = false;
+    std::size_t max_queued_batches = 4; /**< How many batches a streaming query keeps before its kernel waits for them to be taken. */
+    std::mutex output_mutex;
+    std::condition_variable output_cv;
+    std::unique_ptr<ral::io::result_writer> writer; /**< Writes the output to OUTPUT_PATH instead of keeping it, when it is set. */
 };
 
 template<typename T1, typename T2, typename T3, typename ...Params>
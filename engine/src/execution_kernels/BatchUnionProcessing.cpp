@@ -4,6 +4,10 @@
 #include "parser/expression_utils.hpp"
 #include "utilities/CommonOperations.h"
 #include "execution_graph/executor.h"
+#include "operators/GroupBy.h"
+
+#include <numeric>
+#include <cudf/join.hpp>
 
 namespace ral {
 namespace batch {
@@ -131,5 +135,222 @@ kstatus UnionKernel::run() {
     return kstatus::proceed;
 }
 
+// BEGIN SetOperationKernel
+
+SetOperationKernel::SetOperationKernel(std::size_t kernel_id, const std::string & queryString, std::shared_ptr<Context> context, std::shared_ptr<ral::cache::graph> query_graph)
+    : kernel{kernel_id, queryString, context, kernel_type::SetOperationKernel} {
+    this->query_graph = query_graph;
+    this->input_.add_port("input_a", "input_b");
+
+    this->is_intersect = ::is_intersect(this->expression);
+    this->is_except = is_minus(this->expression);
+
+    ral::cache::cache_settings cache_machine_config;
+    cache_machine_config.type = ral::cache::CacheType::SIMPLE;
+    cache_machine_config.context = context->clone();
+    this->set_cache = ral::cache::create_cache_machine(cache_machine_config, std::to_string(this->get_id()) + "_set_rows");
+}
+
+std::shared_ptr<ral::frame::BlazingTable> SetOperationKernel::acquire_set_rows(std::size_t & version) {
+    std::lock_guard<std::mutex> lock(set_mutex);
+    if (this->set_rows_in_cache) {
+        // only the first batch after the set was cached decaches it
+        this->set_rows = this->set_cache->pullFromCache();
+        this->set_rows_in_cache = false;
+    }
+    this->set_users++;
+    version = this->set_version;
+    return this->set_rows;
+}
+
+bool SetOperationKernel::replace_set_rows(std::size_t version, std::unique_ptr<ral::frame::BlazingTable> & new_rows) {
+    std::lock_guard<std::mutex> lock(set_mutex);
+    this->set_users--;
+    bool replaced = version == this->set_version;
+    if (replaced) {
+        this->set_rows = std::move(new_rows);
+        this->set_version++;
+    }
+    cache_unused_set_rows();
+    return replaced;
+}
+
+void SetOperationKernel::release_set_rows() {
+    std::lock_guard<std::mutex> lock(set_mutex);
+    this->set_users--;
+    cache_unused_set_rows();
+}
+
+void SetOperationKernel::cache_unused_set_rows() {
+    // the batches drop the set they took before they give it back, so nothing else refers to it here
+    if (this->set_users == 0 && this->set_rows != nullptr) {
+        // an empty set is cached too, since it is still the set
+        this->set_cache->addToCache(std::make_unique<ral::frame::BlazingTable>(this->set_rows->releaseCudfTable(), this->set_rows->names()), "", true);
+        this->set_rows = nullptr;
+        this->set_rows_in_cache = true;
+    }
+}
+
+ral::execution::task_result SetOperationKernel::do_process(std::vector< std::unique_ptr<ral::frame::BlazingTable>> inputs,
+    std::shared_ptr<ral::cache::CacheMachine> output,
+    cudaStream_t /*stream*/, const std::map<std::string, std::string>& args) {
+
+    auto & input = inputs[0];
+    try{
+        input->setNames(common_names);
+        ral::utilities::normalize_types(input, common_types);
+
+        std::vector<int> all_columns(input->num_columns());
+        std::iota(all_columns.begin(), all_columns.end(), 0);
+        std::vector<cudf::size_type> keys(all_columns.begin(), all_columns.end());
+        std::unique_ptr<ral::frame::BlazingTable> distinct = ral::operators::compute_groupby_without_aggregations(input->toBlazingTableView(), all_columns);
+
+        bool is_build = args.at(SET_OPERATION_TASK_ARG) == SET_OPERATION_BUILD;
+        std::unique_ptr<ral::frame::BlazingTable> result;
+        bool replaced = false;
+        while (!replaced) {
+            // the set is only replaced once the new one is built, so that a bad_alloc leaves it as it was
+            std::size_t version;
+            std::shared_ptr<ral::frame::BlazingTable> rows = acquire_set_rows(version);
+            std::unique_ptr<ral::frame::BlazingTable> new_rows;
+            try {
+                if (is_build) {
+                    if (rows != nullptr) {
+                        auto concatenated = ral::utilities::concatTables({rows->toBlazingTableView(), distinct->toBlazingTableView()});
+                        new_rows = ral::operators::compute_groupby_without_aggregations(concatenated->toBlazingTableView(), all_columns);
+                    }
+                } else if (this->is_intersect) {
+                    // the rows are output once, so the ones that were found leave the set
+                    if (rows == nullptr) {
+                        result = ral::utilities::create_empty_table(distinct->toBlazingTableView());
+                    } else {
+                        result = std::make_unique<ral::frame::BlazingTable>(cudf::left_semi_join(rows->view(), distinct->view(),
+                            keys, keys, cudf::null_equality::EQUAL), common_names);
+                        new_rows = std::make_unique<ral::frame::BlazingTable>(cudf::left_anti_join(rows->view(), distinct->view(),
+                            keys, keys, cudf::null_equality::EQUAL), common_names);
+                    }
+                } else {
+                    // the rows that are output join the ones that must not be output again
+                    if (rows == nullptr) {
+                        result = distinct->toBlazingTableView().clone();
+                        new_rows = distinct->toBlazingTableView().clone();
+                    } else {
+                        result = std::make_unique<ral::frame::BlazingTable>(cudf::left_anti_join(distinct->view(), rows->view(),
+                            keys, keys, cudf::null_equality::EQUAL), common_names);
+                        new_rows = ral::utilities::concatTables({rows->toBlazingTableView(), result->toBlazingTableView()});
+                    }
+                }
+            } catch(...) {
+                rows = nullptr;
+                release_set_rows();
+                throw;
+            }
+            bool is_empty_intersect = !is_build && this->is_intersect && rows == nullptr;
+            rows = nullptr;
+            if (is_build && new_rows == nullptr) {
+                replaced = replace_set_rows(version, distinct);
+            } else if (is_empty_intersect) {
+                // there was nothing to intersect with, so the set stays as it is
+                release_set_rows();
+                replaced = true;
+            } else {
+                replaced = replace_set_rows(version, new_rows);
+            }
+        }
+
+        if (is_build) {
+            return {ral::execution::task_status::SUCCESS, std::string(), std::vector< std::unique_ptr<ral::frame::BlazingTable> > ()};
+        }
+        output->addToCache(std::move(result));
+    }catch(const rmm::bad_alloc& e){
+        return {ral::execution::task_status::RETRY, std::string(e.what()), std::move(inputs)};
+    }catch(const std::exception& e){
+        return {ral::execution::task_status::FAIL, std::string(e.what()), std::vector< std::unique_ptr<ral::frame::BlazingTable> > ()};
+    }
+    return {ral::execution::task_status::SUCCESS, std::string(), std::vector< std::unique_ptr<ral::frame::BlazingTable> > ()};
+}
+
+void SetOperationKernel::wait_for_tasks() {
+    std::unique_lock<std::mutex> lock(kernel_mutex);
+    kernel_cv.wait(lock,[this]{
+        return this->tasks.empty() || ral::execution::executor::get_instance()->has_exception();
+    });
+
+    if(auto ep = ral::execution::executor::get_instance()->last_exception()){
+        std::rethrow_exception(ep);
+    }
+}
+
+kstatus SetOperationKernel::run() {
+    CodeTimer timer;
+
+    auto cache_machine_a = this->input_.get_cache("input_a");
+    auto cache_machine_b = this->input_.get_cache("input_b");
+    std::unique_ptr<ral::cache::CacheData> cache_data_a = cache_machine_a->pullCacheData();
+    std::unique_ptr<ral::cache::CacheData> cache_data_b = cache_machine_b->pullCacheData();
+    RAL_EXPECTS(cache_data_a != nullptr && cache_data_b != nullptr, "In SetOperationKernel: The input cache data cannot be null");
+
+    common_names = cache_data_a->names();
+
+    bool strict = false;
+    common_types = ral::utilities::get_common_types(cache_data_a->get_schema(), cache_data_b->get_schema(), strict);
+
+    auto add_tasks = [this](std::unique_ptr<ral::cache::CacheData> & cache_data, std::shared_ptr<ral::cache::CacheMachine> & cache_machine, const std::string & operation) {
+        while(cache_data != nullptr) {
+            std::vector<std::unique_ptr<ral::cache::CacheData>> inputs;
+            inputs.push_back(std::move(cache_data));
+
+            std::map<std::string, std::string> task_args;
+            task_args[SET_OPERATION_TASK_ARG] = operation;
+            ral::execution::executor::get_instance()->add_task(
+                    std::move(inputs),
+                    this->output_cache(),
+                    this,
+                    task_args);
+
+            cache_data = cache_machine->pullCacheData();
+        }
+    };
+
+    if (this->is_intersect || this->is_except) {
+        // all of the right input is in the set before any left row is looked up in it
+        add_tasks(cache_data_b, cache_machine_b, SET_OPERATION_BUILD);
+        wait_for_tasks();
+        add_tasks(cache_data_a, cache_machine_a, SET_OPERATION_PROBE);
+    } else {
+        add_tasks(cache_data_a, cache_machine_a, SET_OPERATION_PROBE);
+        add_tasks(cache_data_b, cache_machine_b, SET_OPERATION_PROBE);
+    }
+
+    if(logger) {
+        logger->debug("{query_id}|{step}|{substep}|{info}|{duration}|kernel_id|{kernel_id}||",
+                                "query_id"_a=context->getContextToken(),
+                                "step"_a=context->getQueryStep(),
+                                "substep"_a=context->getQuerySubstep(),
+                                "info"_a="SetOperation Kernel tasks created",
+                                "duration"_a=timer.elapsed_time(),
+                                "kernel_id"_a=this->get_id());
+    }
+
+    wait_for_tasks();
+    this->set_rows = nullptr;
+    this->set_rows_in_cache = false;
+    this->set_cache->clear();
+
+    if(logger) {
+        logger->debug("{query_id}|{step}|{substep}|{info}|{duration}|kernel_id|{kernel_id}||",
+                    "query_id"_a=context->getContextToken(),
+                    "step"_a=context->getQueryStep(),
+                    "substep"_a=context->getQuerySubstep(),
+                    "info"_a="SetOperation Kernel Completed",
+                    "duration"_a=timer.elapsed_time(),
+                    "kernel_id"_a=this->get_id());
+    }
+
+    return kstatus::proceed;
+}
+
+// END SetOperationKernel
+
 } // namespace batch
 } // namespace ral
@@ -29,5 +29,71 @@ private:
     std::vector<cudf::data_type> common_types;
 };
 
+/**
+ * @brief This kernel computes UNION, INTERSECT and EXCEPT without ALL, which output every distinct row once.
+ *
+ * The kernel keeps a set of distinct rows that every batch is looked up in with a hash semi or anti join. For INTERSECT
+ * it is the right input, which is all taken first, and the rows are removed from it once they are output. For UNION and
+ * EXCEPT it is the rows that must not be output, the right input for EXCEPT, and the rows are added to it once they are
+ * output. Once the right input is in the set, every batch of the left input is output as soon as it is looked up. When
+ * there are more nodes, both inputs are hashed by all of their columns to the nodes first, so every node only keeps the
+ * rows that hash to it.
+ *
+ * The batches are looked up in the set at the same time. The first one to be done replaces the set, and the others look
+ * their rows up again in the new one, so that the set only changes as if they were looked up one after the other. While
+ * no batch is looked up in it, the set is kept in a cache, which can spill it.
+ */
+class SetOperationKernel : public kernel {
+public:
+    SetOperationKernel(std::size_t kernel_id, const std::string & queryString, std::shared_ptr<Context> context, std::shared_ptr<ral::cache::graph> query_graph);
+
+    std::string kernel_name() { return "SetOperation";}
+
+    ral::execution::task_result do_process(std::vector< std::unique_ptr<ral::frame::BlazingTable> > inputs,
+        std::shared_ptr<ral::cache::CacheMachine> output,
+        cudaStream_t stream, const std::map<std::string, std::string>& args) override;
+
+    virtual kstatus run();
+
+private:
+    void wait_for_tasks();
+
+    /**
+     * @brief Takes the set to look a batch up in, or nullptr if it has no rows yet, and the version it has.
+     */
+    std::shared_ptr<ral::frame::BlazingTable> acquire_set_rows(std::size_t & version);
+
+    /**
+     * @brief Replaces the set with new_rows, which is then moved from, if it still has the version it was taken with.
+     * The set is given back either way.
+     * @return whether the set was replaced.
+     */
+    bool replace_set_rows(std::size_t version, std::unique_ptr<ral::frame::BlazingTable> & new_rows);
+
+    /**
+     * @brief Gives back the set without replacing it.
+     */
+    void release_set_rows();
+
+    // puts the set in the set_cache once no batch is looked up in it. set_mutex must be held
+    void cache_unused_set_rows();
+
+    bool is_intersect;
+    bool is_except;
+    std::vector<std::string> common_names;
+    std::vector<cudf::data_type> common_types;
+
+    std::mutex set_mutex; // only held to take, replace and give back the set
+    std::shared_ptr<ral::frame::BlazingTable> set_rows; // the distinct rows every batch is looked up in, while any batch is
+    std::size_t set_version = 0; // how many times the set was replaced
+    std::size_t set_users = 0; // the batches that are looked up in the set
+    bool set_rows_in_cache = false;
+    std::shared_ptr<ral::cache::CacheMachine> set_cache; // keeps the set while no batch is looked up in it
+};
+
+const std::string SET_OPERATION_TASK_ARG="set_operation";
+const std::string SET_OPERATION_BUILD="build";
+const std::string SET_OPERATION_PROBE="probe";
+
 } // namespace batch
 } // namespace ral
@@ -1,6 +1,8 @@
 #include "BatchWindowFunctionProcessing.h"
 
+#include <algorithm>
 #include <iterator>
+#include <numeric>
 
 #include "blazing_table/BlazingColumn.h"
 #include "cache_machine/GPUCacheData.h"
@@ -22,8 +24,9 @@
 #include <cudf/copying.hpp>
 #include <cudf/aggregation.hpp>
 #include <cudf/search.hpp>
-#include <cudf/join.hpp>
-#include <cudf/sorting.hpp>
+#include <cudf/binaryop.hpp>
+#include <cudf/column/column_factories.hpp>
+#include <cudf/scalar/scalar.hpp>
 
 namespace ral {
 namespace batch {
@@ -49,108 +52,129 @@ ComputeWindowKernel::ComputeWindowKernel(std::size_t kernel_id, const std::strin
         this->aggs_wind_func.push_back(aggr_kind_i);
     }
 
-    // if the window function has no partitioning but does have order by and a bounded window, then we need to remove the overlaps that are present in the data
-    if (column_indices_partitioned.size() == 0 && column_indices_ordered.size() > 0 && this->preceding_value > 0 && this->following_value > 0){
+    // if the window function has no partitioning (or its partitions can be split) but does have order by and a bounded window, then we need to remove the overlaps that are present in the data
+    bool uses_overlaps = column_indices_partitioned.size() == 0 || window_expression_can_split_partitions(this->expression);
+    if (uses_overlaps && column_indices_ordered.size() > 0 && this->preceding_value > 0 && this->following_value > 0){
         this->remove_overlap = true;
     } else {
         this->remove_overlap = false;
     }
-}
-
-// TODO: Support for RANK() and DENSE_RANK()
-std::unique_ptr<CudfColumn> ComputeWindowKernel::compute_column_from_window_function(
-    cudf::table_view input_table_cudf_view,
-    cudf::column_view col_view_to_agg,
-    std::size_t pos ) {
 
-    // we want firs get the type of aggregation
-    std::unique_ptr<cudf::rolling_aggregation> window_aggregation = ral::operators::makeCudfAggregation<cudf::rolling_aggregation>(this->aggs_wind_func[pos], this->agg_param_values[pos]);
-
-    // want all columns to be partitioned
-    std::vector<cudf::column_view> columns_to_partition;
-    for (std::size_t col_i = 0; col_i < this->column_indices_partitioned.size(); ++col_i) {
-        columns_to_partition.push_back(input_table_cudf_view.column(this->column_indices_partitioned[col_i]));
+    // the batches of a partition that goes on from one batch to the next are carried in order
+    this->carry_partitions = window_expression_can_carry_partitions(this->expression);
+    if (this->carry_partitions) {
+        ral::cache::cache_settings cache_machine_config;
+        cache_machine_config.type = ral::cache::CacheType::SIMPLE;
+        cache_machine_config.context = context->clone();
+        cache_machine_config.is_array_access = true;
+        this->windowed_batches = ral::cache::create_cache_machine(cache_machine_config, std::to_string(this->get_id()) + "_windowed_batches");
     }
+}
 
-    cudf::table_view partitioned_table_view(columns_to_partition);
-
-    std::unique_ptr<CudfColumn> windowed_col;
-    if (window_expression_contains_partition_by(this->expression)) {
-        if (is_first_value_window(this->type_aggs_as_str[pos]) || is_last_value_window(this->type_aggs_as_str[pos])) {
-
-            if (is_last_value_window(this->type_aggs_as_str[pos])) {
-                // We want also all the ordered columns
-                for (std::size_t col_i = 0; col_i < this->column_indices_ordered.size(); ++col_i) {
-                    columns_to_partition.push_back(input_table_cudf_view.column(this->column_indices_ordered[col_i]));
-                }
+namespace {
 
-                partitioned_table_view = {{cudf::table_view(columns_to_partition)}};
-            }
+// Returns the offsets where every group of these sorted keys starts, followed by the number of rows
+std::vector<cudf::size_type> get_group_offsets(cudf::table_view sorted_keys) {
+    cudf::groupby::groupby gb_obj(sorted_keys, cudf::null_policy::INCLUDE, cudf::sorted::YES);
+    return gb_obj.get_groups().offsets;
+}
 
-            // first: we want to get all the first (or last) values (due to the columns to partition)
-            std::vector<cudf::groupby::aggregation_request> requests;
-            requests.emplace_back(cudf::groupby::aggregation_request());
-            requests[0].values = col_view_to_agg;
-            requests[0].aggregations.push_back(std::move(window_aggregation));
+/* Returns the first (or the last) row of the group of every row, given the offsets of the groups. The row of every
+group is broadcast to all of its rows with a repeat, without joining them back. */
+std::unique_ptr<CudfColumn> get_group_bounds_per_row(const std::vector<cudf::size_type> & offsets, bool last_row) {
+    if (offsets.size() < 2) {
+        return cudf::make_empty_column(cudf::data_type{cudf::type_id::INT32});
+    }
 
-            cudf::groupby::groupby gb_obj(cudf::table_view({partitioned_table_view}), cudf::null_policy::INCLUDE, cudf::sorted::YES, {}, {});
-            std::pair<std::unique_ptr<cudf::table>, std::vector<cudf::groupby::aggregation_result>> result = gb_obj.aggregate(requests);
+    std::vector<cudf::size_type> bounds(offsets.size() - 1);
+    std::vector<cudf::size_type> counts(offsets.size() - 1);
+    for (std::size_t group = 0; group + 1 < offsets.size(); ++group) {
+        bounds[group] = last_row ? offsets[group + 1] - 1 : offsets[group];
+        counts[group] = offsets[group + 1] - offsets[group];
+    }
 
-            windowed_col = std::move(result.second[0].results[0]);
+    std::unique_ptr<CudfColumn> bounds_col = ral::utilities::vector_to_column(bounds, cudf::data_type{cudf::type_id::INT32});
+    std::unique_ptr<CudfColumn> counts_col = ral::utilities::vector_to_column(counts, cudf::data_type{cudf::type_id::INT32});
+    std::unique_ptr<cudf::table> bounds_per_row = cudf::repeat(cudf::table_view({bounds_col->view()}), counts_col->view());
+    return std::move(bounds_per_row->release()[0]);
+}
 
-            // if exists duplicated values (in partitioned_table_view) we want to fill `windowed_col` with repeated values
-            // So let's do a join
-            if (windowed_col->size() < col_view_to_agg.size()) {
-                std::vector<std::unique_ptr<cudf::column>> keys_grouped = result.first->release();
-                keys_grouped.push_back(std::move(windowed_col));
+} // namespace
 
-                std::unique_ptr<cudf::table> left_table = std::make_unique<cudf::table>(std::move(keys_grouped));
+window_segments ComputeWindowKernel::compute_window_segments(cudf::table_view input_table_cudf_view) {
+    window_segments segments;
+    if (!window_expression_contains_partition_by(this->expression)) {
+        return segments;
+    }
 
-                // Let's get all the necessary params for the join
-                // we just want the key columns, not the values column (which is the last column)
-                std::vector<cudf::size_type> left_column_indices(left_table->num_columns() - 1);
-                std::iota(left_column_indices.begin(), left_column_indices.end(), 0);
+    cudf::size_type num_rows = input_table_cudf_view.num_rows();
+    cudf::data_type window_type{cudf::type_id::INT32};
+    cudf::table_view partitioned_table_view = input_table_cudf_view.select(this->column_indices_partitioned);
+
+    std::vector<cudf::size_type> offsets = get_group_offsets(partitioned_table_view);
+    segments.num_partitions = offsets.size() < 2 ? 0 : offsets.size() - 1;
+    segments.first_partition_rows = offsets.size() < 2 ? 0 : offsets[1];
+
+    segments.first_rows = get_group_bounds_per_row(offsets, false);
+    std::unique_ptr<CudfColumn> last_rows = get_group_bounds_per_row(offsets, true);
+    std::unique_ptr<CudfColumn> row_indices = cudf::sequence(num_rows, cudf::numeric_scalar<cudf::size_type>(0), cudf::numeric_scalar<cudf::size_type>(1));
+
+    std::unique_ptr<CudfColumn> rows_before = cudf::binary_operation(row_indices->view(), segments.first_rows->view(), cudf::binary_operator::SUB, window_type);
+    segments.preceding_window = cudf::binary_operation(rows_before->view(), cudf::numeric_scalar<cudf::size_type>(1), cudf::binary_operator::ADD, window_type);
+    segments.following_window = cudf::binary_operation(last_rows->view(), row_indices->view(), cudf::binary_operator::SUB, window_type);
+    segments.empty_window = cudf::make_column_from_scalar(cudf::numeric_scalar<cudf::size_type>(0), num_rows);
+
+    bool has_last_value = std::any_of(this->type_aggs_as_str.begin(), this->type_aggs_as_str.end(),
+        [](const std::string & agg) { return is_last_value_window(agg); });
+    if (has_last_value) {
+        // the last value is the one of the last row that is equal to this one in the order columns too
+        std::vector<cudf::size_type> peer_column_indices(this->column_indices_partitioned.begin(), this->column_indices_partitioned.end());
+        peer_column_indices.insert(peer_column_indices.end(), this->column_indices_ordered.begin(), this->column_indices_ordered.end());
+        segments.last_peer_rows = get_group_bounds_per_row(get_group_offsets(input_table_cudf_view.select(peer_column_indices)), true);
+    }
 
-                std::vector<cudf::size_type> right_column_indices(partitioned_table_view.num_columns());
-                std::iota(right_column_indices.begin(), right_column_indices.end(), 0);
+    return segments;
+}
 
-                std::unique_ptr<cudf::table> join_table = cudf::inner_join(
-                                                            left_table->view(),
-                                                            partitioned_table_view,
-                                                            left_column_indices,
-                                                            right_column_indices
-                                                            );
+// TODO: Support for RANK() and DENSE_RANK()
+std::unique_ptr<CudfColumn> ComputeWindowKernel::compute_column_from_window_function(
+    cudf::table_view input_table_cudf_view,
+    cudf::column_view col_view_to_agg,
+    std::size_t pos,
+    const window_segments & segments) {
 
-                // Because the values column is unordered, we want to sort it
-                std::vector<cudf::null_order> null_orders(join_table->num_columns(), cudf::null_order::AFTER);
+    std::unique_ptr<CudfColumn> windowed_col;
+    if (window_expression_contains_partition_by(this->expression)) {
+        // FIRST_VALUE and LAST_VALUE are the value of one row of every group, gathered for all of its rows
+        if (is_first_value_window(this->type_aggs_as_str[pos])) {
+            return std::move(cudf::gather(cudf::table_view({col_view_to_agg}), segments.first_rows->view())->release()[0]);
+        } else if (is_last_value_window(this->type_aggs_as_str[pos])) {
+            return std::move(cudf::gather(cudf::table_view({col_view_to_agg}), segments.last_peer_rows->view())->release()[0]);
+        }
 
-                // partition by is always in ASCENDING order
-                std::vector<cudf::order> sortOrderTypes(join_table->num_columns(), cudf::order::ASCENDING);
-                std::unique_ptr<cudf::table> sorted_table = cudf::sort(join_table->view(), sortOrderTypes, null_orders);
+        std::unique_ptr<cudf::rolling_aggregation> window_aggregation = ral::operators::makeCudfAggregation<cudf::rolling_aggregation>(this->aggs_wind_func[pos], this->agg_param_values[pos]);
 
-                size_t position_of_values_column = left_table->num_columns() - 1;
-                windowed_col = std::move(sorted_table->release()[position_of_values_column]);
-            }
-        }
-        else if (window_expression_contains_order_by(this->expression)) {
+        if (window_expression_contains_order_by(this->expression)) {
             if (window_expression_contains_bounds(this->expression)) {
                 // TODO: for now just ROWS bounds works (not RANGE)
+                cudf::table_view partitioned_table_view = input_table_cudf_view.select(this->column_indices_partitioned);
                 windowed_col = cudf::grouped_rolling_window(partitioned_table_view, col_view_to_agg, 
                     this->preceding_value >= 0 ? this->preceding_value + 1: partitioned_table_view.num_rows(), 
                     this->following_value >= 0 ? this->following_value : partitioned_table_view.num_rows(), 
                     1, *window_aggregation);
             } else {
                 if (this->type_aggs_as_str[pos] == "LEAD") {
-                    windowed_col = cudf::grouped_rolling_window(partitioned_table_view, col_view_to_agg, 0, col_view_to_agg.size(), 1, *window_aggregation);
+                    windowed_col = cudf::rolling_window(col_view_to_agg, segments.empty_window->view(), segments.following_window->view(), 1, *window_aggregation);
                 } else {
-                    windowed_col = cudf::grouped_rolling_window(partitioned_table_view, col_view_to_agg, col_view_to_agg.size(), 0, 1, *window_aggregation);
+                    windowed_col = cudf::rolling_window(col_view_to_agg, segments.preceding_window->view(), segments.empty_window->view(), 1, *window_aggregation);
                 }
             }
         } else {
-            windowed_col = cudf::grouped_rolling_window(partitioned_table_view, col_view_to_agg, col_view_to_agg.size(), col_view_to_agg.size(), 1, *window_aggregation);
+            windowed_col = cudf::rolling_window(col_view_to_agg, segments.preceding_window->view(), segments.following_window->view(), 1, *window_aggregation);
         }
     } else {
         if (window_expression_contains_bounds(this->expression)) {
+            std::unique_ptr<cudf::rolling_aggregation> window_aggregation = ral::operators::makeCudfAggregation<cudf::rolling_aggregation>(this->aggs_wind_func[pos], this->agg_param_values[pos]);
             // TODO: for now just ROWS bounds works (not RANGE)
             windowed_col = cudf::rolling_window(col_view_to_agg, this->preceding_value + 1, this->following_value, 1, *window_aggregation);
         } else {
@@ -161,6 +185,97 @@ std::unique_ptr<CudfColumn> ComputeWindowKernel::compute_column_from_window_func
     return std::move(windowed_col);
 }
 
+std::vector<std::unique_ptr<CudfColumn>> ComputeWindowKernel::apply_carry(cudf::table_view window_columns, cudf::table_view carry_window_columns) {
+    std::vector<std::unique_ptr<CudfColumn>> carried_columns;
+    for (cudf::size_type col_i = 0; col_i < window_columns.num_columns(); ++col_i) {
+        // the minimums and maximums keep the values of the rows without any valid value before them
+        cudf::binary_operator op = cudf::binary_operator::ADD;
+        if (this->aggs_wind_func[col_i] == AggregateKind::MIN) {
+            op = cudf::binary_operator::NULL_MIN;
+        } else if (this->aggs_wind_func[col_i] == AggregateKind::MAX) {
+            op = cudf::binary_operator::NULL_MAX;
+        }
+
+        cudf::column_view window_column = window_columns.column(col_i);
+        std::unique_ptr<cudf::scalar> carried_value = cudf::get_element(carry_window_columns.column(col_i), 0);
+        carried_columns.push_back(cudf::binary_operation(window_column, *carried_value, op, window_column.type()));
+    }
+    return carried_columns;
+}
+
+void ComputeWindowKernel::carry_partition_aggregations(std::size_t num_batches, bool wait) {
+    std::vector<cudf::size_type> key_indices(this->column_indices_partitioned.size());
+    std::iota(key_indices.begin(), key_indices.end(), 0);
+    std::vector<cudf::size_type> window_indices(this->aggs_wind_func.size());
+    std::iota(window_indices.begin(), window_indices.end(), key_indices.size());
+
+    while (this->next_carry_batch < num_batches) {
+        window_batch_summary summary;
+        {
+            std::unique_lock<std::mutex> lock(kernel_mutex);
+            if (wait) {
+                kernel_cv.wait(lock,[this]{
+                    return this->batch_summaries.count(this->next_carry_batch) > 0 || ral::execution::executor::get_instance()->has_exception();
+                });
+            }
+            auto it = this->batch_summaries.find(this->next_carry_batch);
+            if (it == this->batch_summaries.end()) {
+                break;
+            }
+            summary = std::move(it->second);
+            this->batch_summaries.erase(it);
+        }
+
+        std::unique_ptr<ral::cache::CacheData> batch = this->windowed_batches->get_or_wait_CacheData(this->next_carry_batch);
+        this->next_carry_batch++;
+
+        if (summary.num_partitions == 0) {
+            this->output_cache()->addCacheData(std::move(batch));
+            continue;
+        }
+
+        bool goes_on = false;
+        if (this->carry != nullptr) {
+            std::vector<cudf::table_view> first_keys = {this->carry->view().select(key_indices), summary.first_keys->view()};
+            std::unique_ptr<cudf::table> both_keys = cudf::concatenate(first_keys);
+            goes_on = get_group_offsets(both_keys->view()).size() == 2;
+        }
+
+        if (!goes_on) {
+            this->output_cache()->addCacheData(std::move(batch));
+            this->carry = std::move(summary.last_row);
+            continue;
+        }
+
+        // what is carried to the next batch is the last row of this one, plus this carry when the partition is the whole batch
+        std::unique_ptr<cudf::table> next_carry;
+        if (summary.num_partitions == 1) {
+            std::vector<std::unique_ptr<CudfColumn>> carry_columns = std::make_unique<cudf::table>(summary.last_row->view().select(key_indices))->release();
+            std::vector<std::unique_ptr<CudfColumn>> carried = apply_carry(summary.last_row->view().select(window_indices), this->carry->view().select(window_indices));
+            std::move(carried.begin(), carried.end(), std::back_inserter(carry_columns));
+            next_carry = std::make_unique<cudf::table>(std::move(carry_columns));
+        } else {
+            next_carry = std::move(summary.last_row);
+        }
+
+        std::vector<std::string> carry_names(this->carry->num_columns());
+        std::vector<std::unique_ptr<ral::cache::CacheData>> inputs;
+        inputs.push_back(std::move(batch));
+        inputs.push_back(std::make_unique<ral::cache::GPUCacheData>(std::make_unique<ral::frame::BlazingTable>(std::move(this->carry), carry_names)));
+
+        std::map<std::string, std::string> task_args;
+        task_args[TASK_ARG_OP_TYPE] = CARRY_OP_TYPE;
+        task_args[TASK_ARG_CARRY_ROWS] = std::to_string(summary.first_partition_rows);
+        ral::execution::executor::get_instance()->add_task(
+                std::move(inputs),
+                this->output_cache(),
+                this,
+                task_args);
+
+        this->carry = std::move(next_carry);
+    }
+}
+
 ral::execution::task_result ComputeWindowKernel::do_process(std::vector< std::unique_ptr<ral::frame::BlazingTable> > inputs,
     std::shared_ptr<ral::cache::CacheMachine> output,
     cudaStream_t /*stream*/, const std::map<std::string, std::string>& args) {
@@ -173,16 +288,46 @@ ral::execution::task_result ComputeWindowKernel::do_process(std::vector< std::un
     std::unique_ptr<ral::frame::BlazingTable> & input = inputs[0];
 
     try{
+        auto op_type = args.find(TASK_ARG_OP_TYPE);
+        if (op_type != args.end() && op_type->second == CARRY_OP_TYPE) {
+            // the rows of the first partition of the batch get the aggregations of the batches before it
+            std::unique_ptr<ral::frame::BlazingTable> & carry_row = inputs[1];
+            cudf::size_type carry_rows = std::stoi(args.at(TASK_ARG_CARRY_ROWS));
+            std::size_t num_window_cols = this->aggs_wind_func.size();
+            std::size_t num_input_cols = input->num_columns() - num_window_cols;
+
+            std::vector<cudf::size_type> input_indices(num_input_cols);
+            std::iota(input_indices.begin(), input_indices.end(), 0);
+            std::vector<cudf::size_type> window_indices(num_window_cols);
+            std::iota(window_indices.begin(), window_indices.end(), num_input_cols);
+            std::vector<cudf::size_type> carry_window_indices(num_window_cols);
+            std::iota(carry_window_indices.begin(), carry_window_indices.end(), this->column_indices_partitioned.size());
+
+            std::vector<CudfTableView> parts = cudf::split(input->view(), {carry_rows});
+            std::vector<std::unique_ptr<CudfColumn>> carried_columns = std::make_unique<cudf::table>(parts[0].select(input_indices))->release();
+            std::vector<std::unique_ptr<CudfColumn>> window_columns = apply_carry(parts[0].select(window_indices), carry_row->view().select(carry_window_indices));
+            std::move(window_columns.begin(), window_columns.end(), std::back_inserter(carried_columns));
+
+            std::unique_ptr<cudf::table> carried_table = std::make_unique<cudf::table>(std::move(carried_columns));
+            std::unique_ptr<cudf::table> output_table = cudf::concatenate(std::vector<cudf::table_view>{carried_table->view(), parts[1]});
+            output->addToCache(std::make_unique<ral::frame::BlazingTable>(std::move(output_table), input->names()));
+
+            return {ral::execution::task_status::SUCCESS, std::string(), std::vector< std::unique_ptr<ral::frame::BlazingTable> > ()};
+        }
+
         cudf::table_view input_table_cudf_view = input->view();
 
         std::vector<std::string> input_names = input->names();
         
+        // all the window columns have the same partitions, so they are found once for the whole batch
+        window_segments segments = compute_window_segments(input_table_cudf_view);
+
         std::vector< std::unique_ptr<CudfColumn> > new_wf_cols;
         for (std::size_t col_i = 0; col_i < this->type_aggs_as_str.size(); ++col_i) {
             cudf::column_view col_view_to_agg = input_table_cudf_view.column(column_indices_to_agg[col_i]);
 
             // calling main window function
-            std::unique_ptr<CudfColumn> windowed_col = compute_column_from_window_function(input_table_cudf_view, col_view_to_agg, col_i);
+            std::unique_ptr<CudfColumn> windowed_col = compute_column_from_window_function(input_table_cudf_view, col_view_to_agg, col_i, segments);
             new_wf_cols.push_back(std::move(windowed_col));
         }
 
@@ -232,6 +377,31 @@ ral::execution::task_result ComputeWindowKernel::do_process(std::vector< std::un
         
         std::unique_ptr<ral::frame::BlazingTable> windowed_table = std::make_unique<ral::frame::BlazingTable>(std::move(cudf_table_window), output_names);
 
+        if (this->carry_partitions) {
+            // the batch waits for the carry of the batches before it, see carry_partition_aggregations
+            window_batch_summary summary;
+            summary.num_partitions = segments.num_partitions;
+            summary.first_partition_rows = segments.first_partition_rows;
+            cudf::size_type num_rows = windowed_table->num_rows();
+            if (num_rows > 0) {
+                std::vector<cudf::size_type> carry_indices(this->column_indices_partitioned.begin(), this->column_indices_partitioned.end());
+                for (std::size_t col_i = num_input_cols; col_i < total_output_columns; ++col_i) {
+                    carry_indices.push_back(col_i);
+                }
+                CudfTableView first_keys = cudf::slice(windowed_table->view().select(this->column_indices_partitioned), {0, 1})[0];
+                CudfTableView last_row = cudf::slice(windowed_table->view().select(carry_indices), {num_rows - 1, num_rows})[0];
+                summary.first_keys = std::make_unique<cudf::table>(first_keys);
+                summary.last_row = std::make_unique<cudf::table>(last_row);
+            }
+
+            std::size_t batch_index = std::stoull(args.at(TASK_ARG_SOURCE_BATCH_INDEX));
+            this->windowed_batches->put(batch_index, std::move(windowed_table));
+            std::lock_guard<std::mutex> lock(kernel_mutex);
+            this->batch_summaries[batch_index] = std::move(summary);
+
+            return {ral::execution::task_status::SUCCESS, std::string(), std::vector< std::unique_ptr<ral::frame::BlazingTable> > ()};
+        }
+
         if (windowed_table) {
             cudf::size_type num_rows = windowed_table->num_rows();
             std::size_t num_bytes = windowed_table->sizeInBytes();
@@ -282,6 +452,30 @@ kstatus ComputeWindowKernel::run() {
 
             is_first_batch = false;
         }
+    } else if (this->carry_partitions){
+        std::size_t num_batches = 0;
+        while (cache_data != nullptr ){
+            std::vector<std::unique_ptr <ral::cache::CacheData> > inputs;
+            inputs.push_back(std::move(cache_data));
+
+            std::map<std::string, std::string> task_args;
+            task_args[TASK_ARG_SOURCE_BATCH_INDEX] = std::to_string(num_batches);
+            ral::execution::executor::get_instance()->add_task(
+                    std::move(inputs),
+                    this->output_cache(),
+                    this,
+                    task_args);
+            num_batches++;
+
+            // the batches that are done are carried while the rest are computed
+            carry_partition_aggregations(num_batches, false);
+            cache_data = this->input_cache()->pullCacheData();
+        }
+        carry_partition_aggregations(num_batches, true);
+
+        if(auto ep = ral::execution::executor::get_instance()->last_exception()){
+            std::rethrow_exception(ep);
+        }
     } else {
         while (cache_data != nullptr ){
             std::vector<std::unique_ptr <ral::cache::CacheData> > inputs;
@@ -19,16 +19,47 @@ using ral::cache::kernel_type;
  * New columns will be added to each batch
  */
 
+/**
+ * @brief The partitions of a batch, made once per batch and shared by all of its window columns.
+ *
+ * The batch is already sorted by its partition and order columns, so the rows of every partition are together and
+ * the groups are found with a sorted groupby, without any join or sort. The columns have one INT32 row per row of
+ * the batch.
+ */
+struct window_segments {
+	std::unique_ptr<CudfColumn> first_rows;         // the first row of the partition of every row
+	std::unique_ptr<CudfColumn> last_peer_rows;     // the last row of the rows that are equal in the partition and order columns, only for LAST_VALUE
+	std::unique_ptr<CudfColumn> preceding_window;   // the rows from the first row of the partition up to every row, including it
+	std::unique_ptr<CudfColumn> following_window;   // the rows after every row up to the last row of the partition
+	std::unique_ptr<CudfColumn> empty_window;       // zeros, for windows that end (or start) at every row
+	cudf::size_type num_partitions = 0;
+	cudf::size_type first_partition_rows = 0;       // the rows of the first partition of the batch
+};
+
+/**
+ * @brief What is kept of a windowed batch to carry the aggregations of its last partition to the next batch, when
+ * the partition goes on in it.
+ */
+struct window_batch_summary {
+	std::unique_ptr<cudf::table> first_keys;        // the partition columns of the first row
+	std::unique_ptr<cudf::table> last_row;          // the partition columns and then the window columns of the last row
+	cudf::size_type num_partitions = 0;
+	cudf::size_type first_partition_rows = 0;
+};
+
 class ComputeWindowKernel : public kernel {
 public:
 	ComputeWindowKernel(std::size_t kernel_id, const std::string & queryString,
 		std::shared_ptr<Context> context,
 		std::shared_ptr<ral::cache::graph> query_graph);
 
+	window_segments compute_window_segments(cudf::table_view input_cudf_view);
+
 	std::unique_ptr<CudfColumn> compute_column_from_window_function(
 		cudf::table_view input_cudf_view,
 		cudf::column_view input_col_view,
-		std::size_t pos);
+		std::size_t pos,
+		const window_segments & segments);
 
 	std::string kernel_name() { return "ComputeWindow";}
 
@@ -39,6 +70,19 @@ public:
 	kstatus run() override;
 
 private:
+	/**
+	 * @brief Goes through the summaries of the windowed batches in order, outputting the batches whose first partition
+	 * does not go on from the previous batch, and adding a task that carries the aggregations of the previous batches to
+	 * the rows of that partition for the rest.
+	 *
+	 * @param num_batches The batches that have tasks
+	 * @param wait If it has to wait for all of them, otherwise it stops at the first batch that is not done
+	 */
+	void carry_partition_aggregations(std::size_t num_batches, bool wait);
+
+	// Combines every window column with the aggregation carried from the previous batches, in its one row table
+	std::vector<std::unique_ptr<CudfColumn>> apply_carry(cudf::table_view window_columns, cudf::table_view carry_window_columns);
+
 	// LogicalComputeWindow(min_keys=[MIN($0) OVER (PARTITION BY $1 ORDER BY $3 DESC)], lag_col=[LAG($0, 5) OVER (PARTITION BY $1)], n_name=[$2])
 	std::vector<int> column_indices_partitioned;   // column indices to be partitioned: [1]
 	std::vector<int> column_indices_ordered;   	   // column indices to be ordered: [3]
@@ -50,6 +94,12 @@ private:
 	std::vector<std::string> type_aggs_as_str;     // ["MIN", "LAG"]
 	std::vector<AggregateKind> aggs_wind_func;     // [AggregateKind::MIN, AggregateKind::LAG]
 	bool remove_overlap; 						   // If we need to remove the overlaps after computing the windows
+	bool carry_partitions;                         // If the aggregations of the partitions are carried to the next batch, see window_expression_can_carry_partitions
+
+	std::shared_ptr<ral::cache::CacheMachine> windowed_batches;  // the windowed batches by batch index, until they are carried
+	std::map<std::size_t, window_batch_summary> batch_summaries;
+	std::unique_ptr<cudf::table> carry;            // the last row of the partition being carried
+	std::size_t next_carry_batch = 0;
 };
 
 
@@ -68,6 +118,9 @@ const std::string TASK_ARG_OVERLAP_SIZE="overlap_size";
 const std::string TASK_ARG_SOURCE_BATCH_INDEX="source_batch_index";
 const std::string TASK_ARG_TARGET_BATCH_INDEX="target_batch_index";
 const std::string TASK_ARG_TARGET_NODE_INDEX="target_node_index";
+const std::string TASK_ARG_CARRY_ROWS="carry_rows";
+
+const std::string CARRY_OP_TYPE="carry";
 
 const std::string PRECEDING_OVERLAP_TYPE="preceding";
 const std::string FOLLOWING_OVERLAP_TYPE="following";
@@ -79,7 +132,9 @@ const std::string FOLLOWING_RESPONSE="following_response";
 
 
 /**
-* The OverlapGeneratorKernel is only used for window functions that have no partition by clause and that also have bounded window frames.
+* The OverlapGeneratorKernel is only used for window functions that have bounded window frames and either no partition by clause,
+* or partitions that can be split across batches and nodes (see window_expression_can_split_partitions). The overlaps of these
+* can have rows of other partitions, which grouped_rolling_window leaves out of the windows of every row.
 * The OverlapGeneratorKernel assumes that it will be following by OverlapAccumulatorKernel and has three output caches:
 * - "batches"
 * - "preceding_overlaps"
@@ -31,7 +31,10 @@ BlazingTable::BlazingTable(const CudfTableView & table, const std::vector<std::s
 
 void BlazingTable::ensureOwnership(){
 	for (size_t i = 0; i < columns.size(); i++){
-		columns[i] = std::make_unique<BlazingColumnOwner>(std::move(columns[i]->release()));
+		// the views of the registered dataframes stay valid for as long as the query, so they are not copied
+		if (columns[i]->type() != blazing_column_type::EXTERNAL_VIEW) {
+			columns[i] = std::make_unique<BlazingColumnOwner>(std::move(columns[i]->release()));
+		}
 	}
 }
 
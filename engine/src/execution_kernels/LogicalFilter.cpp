@@ -1,9 +1,13 @@
 #include <spdlog/spdlog.h>
 #include <cudf/stream_compaction.hpp>
 #include <cudf/copying.hpp>
+#include <cudf/column/column_factories.hpp>
+#include <cudf/filling.hpp>
+#include <cudf/scalar/scalar.hpp>
 #include "LogicalFilter.h"
 #include "LogicalProject.h"
 #include "parser/expression_utils.hpp"
+#include "parser/expression_tree.hpp"
 #include "utilities/error.hpp"
 
 namespace ral {
@@ -32,6 +36,35 @@ std::unique_ptr<ral::frame::BlazingTable> applyBooleanFilter(
     filteredTable),table.names());
 }
 
+namespace {
+
+std::string get_filter_condition(const std::string & query_part) {
+  std::string conditional_expression = get_named_expression(query_part, "condition");
+  if(conditional_expression.empty()) {
+    conditional_expression = get_named_expression(query_part, "filters");
+  }
+  return conditional_expression;
+}
+
+} // namespace
+
+bool is_constant_filter_condition(const std::string & query_part, bool & value) {
+  std::string conditional_expression = get_filter_condition(query_part);
+  if(conditional_expression.empty()) {
+    return false;
+  }
+
+  ral::parser::parse_tree tree;
+  tree.build(expand_if_logical_op(replace_calcite_regex(conditional_expression)));
+  tree.transform_to_custom_op();
+  tree.fold_constants();
+  if(tree.root().type != ral::parser::node_type::LITERAL) {
+    return false;
+  }
+  value = tree.root().value == "true";
+  return true;
+}
+
 std::unique_ptr<ral::frame::BlazingTable> process_filter(
   const ral::frame::BlazingTableView & table_view,
   const std::string & query_part,
@@ -41,10 +74,7 @@ std::unique_ptr<ral::frame::BlazingTable> process_filter(
 		return std::make_unique<ral::frame::BlazingTable>(cudf::empty_like(table_view.view()), table_view.names());
 	}
 
-  std::string conditional_expression = get_named_expression(query_part, "condition");
-	if(conditional_expression.empty()) {
-		conditional_expression = get_named_expression(query_part, "filters");
-	}
+  std::string conditional_expression = get_filter_condition(query_part);
 
   std::vector<std::unique_ptr<ral::frame::BlazingColumn>> evaluated_table = evaluate_expressions(table_view.view(), {conditional_expression});
 
@@ -54,6 +84,66 @@ std::unique_ptr<ral::frame::BlazingTable> process_filter(
 }
 
 
+std::unique_ptr<ral::frame::BlazingTable> gather_selected_columns(
+  const ral::frame::BlazingTableView & table,
+  const cudf::column_view & selection,
+  std::string & expression) {
+
+  std::vector<int> column_indices = get_referenced_column_indices(expression);
+  // when no column is used one column is still needed to know the number of rows
+  if(column_indices.empty() && table.num_columns() > 0) {
+    column_indices.push_back(0);
+  }
+
+  std::vector<int> new_column_indices(table.num_columns(), -1);
+  std::vector<cudf::size_type> selected_columns;
+  std::vector<std::string> names = table.names();
+  std::vector<std::string> selected_names;
+  for(std::size_t i = 0; i < column_indices.size(); i++) {
+    new_column_indices[column_indices[i]] = i;
+    selected_columns.push_back(column_indices[i]);
+    selected_names.push_back(names[column_indices[i]]);
+  }
+  expression = renumber_column_indices(expression, new_column_indices);
+
+  return std::make_unique<ral::frame::BlazingTable>(cudf::gather(table.view().select(selected_columns), selection), selected_names);
+}
+
+std::unique_ptr<cudf::column> get_filter_selection(
+  const ral::frame::BlazingTableView & table_view,
+  const std::vector<std::string> & query_parts) {
+
+  std::unique_ptr<cudf::column> selection;
+  if(table_view.num_rows() == 0) {
+    selection = cudf::make_empty_column(cudf::data_type{cudf::type_id::INT32});
+  }
+
+  for(auto & query_part : query_parts) {
+    if(selection != nullptr && selection->size() == 0) {
+      break;
+    }
+
+    // the filters after the first one only see the rows that are still selected, of the columns they use
+    std::string conditional_expression = get_filter_condition(query_part);
+    std::unique_ptr<ral::frame::BlazingTable> selected_table;
+    if(selection != nullptr) {
+      selected_table = gather_selected_columns(table_view, selection->view(), conditional_expression);
+    }
+    CudfTableView input = selected_table != nullptr ? selected_table->view() : table_view.view();
+
+    std::vector<std::unique_ptr<ral::frame::BlazingColumn>> evaluated_table = evaluate_expressions(input, {conditional_expression});
+
+    RAL_EXPECTS(evaluated_table.size() == 1 && evaluated_table[0]->view().type().id() == cudf::type_id::BOOL8, "Expression does not evaluate to a boolean mask");
+
+    if(selection == nullptr) {
+      selection = cudf::sequence(table_view.num_rows(), cudf::numeric_scalar<int32_t>(0), cudf::numeric_scalar<int32_t>(1));
+    }
+    selection = std::move(cudf::apply_boolean_mask(cudf::table_view{{selection->view()}}, evaluated_table[0]->view())->release()[0]);
+  }
+  return selection;
+}
+
+
   namespace{
     typedef std::pair<blazingdb::transport::Node, std::unique_ptr<ral::frame::BlazingTable> > NodeColumn;
     typedef std::pair<blazingdb::transport::Node, ral::frame::BlazingTableView > NodeColumnView;
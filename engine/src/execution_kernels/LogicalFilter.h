@@ -20,6 +20,31 @@ std::unique_ptr<ral::frame::BlazingTable> process_filter(
   const std::string & query_part,
   blazingdb::manager::Context * context);
 
+/**
+ * Returns true if the condition of a filter does not depend on its rows once its literals are folded, like
+ * `AND(=(1, 1), true)`, in which case value is whether it keeps every row. A null condition keeps none, like false.
+ */
+bool is_constant_filter_condition(const std::string & query_part, bool & value);
+
+/**
+ * Returns the positions of the rows of a table that pass the filters, applied in order, as an INT32 column. It is a
+ * selection vector, so the filters don't compact every column of the table like process_filter does: the filters after
+ * the first one only gather the columns they use, and the kernel that needs the rows gathers the columns it uses with
+ * gather_selected_columns.
+ */
+std::unique_ptr<cudf::column> get_filter_selection(
+  const ral::frame::BlazingTableView & table,
+  const std::vector<std::string> & query_parts);
+
+/**
+ * Gathers the rows of a selection vector made by get_filter_selection from the columns of a table an expression uses,
+ * and renumbers the expression to the columns of the returned table.
+ */
+std::unique_ptr<ral::frame::BlazingTable> gather_selected_columns(
+  const ral::frame::BlazingTableView & table,
+  const cudf::column_view & selection,
+  std::string & expression);
+
 bool check_if_has_nulls(CudfTableView const& input, std::vector<cudf::size_type> const& keys);
 
 /**
@@ -1,9 +1,20 @@
+#include <algorithm>
+#include <cctype>
+#include <limits>
+#include <set>
 #include <spdlog/spdlog.h>
+#include <cudf/binaryop.hpp>
+#include <cudf/concatenate.hpp>
 #include <cudf/copying.hpp>
+#include <cudf/filling.hpp>
+#include <cudf/reduction.hpp>
+#include <cudf/stream_compaction.hpp>
 #include <cudf/replace.hpp>
+#include <cudf/strings/attributes.hpp>
 #include <cudf/strings/capitalize.hpp>
 #include <cudf/strings/combine.hpp>
 #include <cudf/strings/contains.hpp>
+#include <cudf/strings/find.hpp>
 #include <cudf/strings/replace_re.hpp>
 #include <cudf/strings/replace.hpp>
 #include <cudf/strings/substring.hpp>
@@ -11,6 +22,7 @@
 #include <cudf/strings/strip.hpp>
 #include <cudf/strings/convert/convert_booleans.hpp>
 #include <cudf/strings/convert/convert_datetime.hpp>
+#include <cudf/strings/convert/convert_fixed_point.hpp>
 #include <cudf/strings/convert/convert_floats.hpp>
 #include <cudf/strings/convert/convert_integers.hpp>
 #include <cudf/unary.hpp>
@@ -18,7 +30,11 @@
 #include "LogicalProject.h"
 #include "utilities/transform.hpp"
 #include "Interpreter/interpreter_cpp.h"
+#include "Interpreter/jit_expressions.h"
+#include "Interpreter/interpreter_plan_cache.h"
 #include "parser/expression_utils.hpp"
+#include "utilities/timestamp_parser.h"
+#include "utilities/StreamForkJoin.h"
 
 namespace ral {
 namespace processor {
@@ -46,6 +62,88 @@ std::string like_expression_to_regex_str(const std::string & like_exp) {
 	return (match_start ? "^" : "") + re + (match_end ? "$" : "");
 }
 
+/**
+ * @brief Finds how a LIKE matches its pattern. A literal string with a '%' at its start, at its end, at both or only in
+ * its middle is matched by cudf with a single pass over the strings, the rest of the patterns need the regex of
+ * like_expression_to_regex_str.
+ */
+interops::like_pattern parse_like_pattern(const std::string & like_exp) {
+	using match_kind = interops::like_pattern::match_kind;
+	interops::like_pattern pattern;
+
+	if (like_exp.find_first_of("_\\") == std::string::npos) {
+		std::size_t first_wildcard = like_exp.find('%');
+		std::size_t last_wildcard = like_exp.rfind('%');
+		bool match_start = like_exp.empty() || like_exp[0] != '%';
+		bool match_end = like_exp.empty() || like_exp[like_exp.size() - 1] != '%';
+		std::string target = like_exp.substr(match_start ? 0 : 1);
+		target = target.substr(0, target.size() - (match_end || target.empty() ? 0 : 1));
+
+		if (first_wildcard == std::string::npos) {
+			pattern.kind = match_kind::EXACT;
+			pattern.literal = like_exp;
+			return pattern;
+		}
+		if (target.find('%') == std::string::npos) {
+			pattern.kind = match_start ? match_kind::PREFIX : (match_end ? match_kind::SUFFIX : match_kind::CONTAINS);
+			pattern.literal = target;
+			pattern.prefix = target;
+			pattern.suffix = target;
+			return pattern;
+		}
+		if (match_start && match_end && first_wildcard == last_wildcard) {
+			pattern.kind = match_kind::PREFIX_AND_SUFFIX;
+			pattern.prefix = like_exp.substr(0, first_wildcard);
+			pattern.suffix = like_exp.substr(first_wildcard + 1);
+			return pattern;
+		}
+	}
+
+	pattern.kind = match_kind::REGEX;
+	pattern.regex = like_expression_to_regex_str(like_exp);
+	return pattern;
+}
+
+/**
+ * @brief Evaluates a LIKE with its parsed pattern, which is kept in the like_pattern_cache for the next batches and
+ * queries with the same pattern.
+ */
+std::unique_ptr<cudf::column> evaluate_like(const cudf::strings_column_view & column, const std::string & like_exp) {
+	using match_kind = interops::like_pattern::match_kind;
+	std::shared_ptr<const interops::like_pattern> pattern = interops::like_pattern_cache::get_instance().get(like_exp);
+	if (!pattern) {
+		pattern = std::make_shared<const interops::like_pattern>(parse_like_pattern(like_exp));
+		interops::like_pattern_cache::get_instance().put(like_exp, pattern);
+	}
+
+	switch (pattern->kind) {
+		case match_kind::EXACT:
+			return cudf::binary_operation(column.parent(), cudf::string_scalar(pattern->literal),
+				cudf::binary_operator::EQUAL, cudf::data_type{cudf::type_id::BOOL8});
+		case match_kind::PREFIX:
+			return cudf::strings::starts_with(column, cudf::string_scalar(pattern->prefix));
+		case match_kind::SUFFIX:
+			return cudf::strings::ends_with(column, cudf::string_scalar(pattern->suffix));
+		case match_kind::CONTAINS:
+			return cudf::strings::contains(column, cudf::string_scalar(pattern->literal));
+		case match_kind::PREFIX_AND_SUFFIX: {
+			// the string has to be long enough for its prefix and its suffix not to overlap
+			std::unique_ptr<cudf::column> lengths = cudf::strings::count_bytes(column);
+			std::unique_ptr<cudf::column> long_enough = cudf::binary_operation(lengths->view(),
+				cudf::numeric_scalar<int32_t>(static_cast<int32_t>(pattern->prefix.size() + pattern->suffix.size())),
+				cudf::binary_operator::GREATER_EQUAL, cudf::data_type{cudf::type_id::BOOL8});
+			std::unique_ptr<cudf::column> starts = cudf::strings::starts_with(column, cudf::string_scalar(pattern->prefix));
+			std::unique_ptr<cudf::column> ends = cudf::strings::ends_with(column, cudf::string_scalar(pattern->suffix));
+			std::unique_ptr<cudf::column> both = cudf::binary_operation(starts->view(), ends->view(),
+				cudf::binary_operator::LOGICAL_AND, cudf::data_type{cudf::type_id::BOOL8});
+			return cudf::binary_operation(both->view(), long_enough->view(),
+				cudf::binary_operator::LOGICAL_AND, cudf::data_type{cudf::type_id::BOOL8});
+		}
+		default:
+			return cudf::strings::contains_re(column, pattern->regex);
+	}
+}
+
 cudf::strings::strip_type map_trim_flag_to_strip_type(const std::string & trim_flag)
 {
     if (trim_flag == "BOTH")
@@ -67,7 +165,7 @@ struct cast_to_str_functor {
 
     template<typename T, std::enable_if_t<cudf::is_fixed_point<T>()> * = nullptr>
     std::unique_ptr<cudf::column> operator()(const cudf::column_view & col) {
-        return cudf::strings::from_floats(col);
+        return cudf::strings::from_fixed_point(col);
     }
 
     template<typename T, std::enable_if_t<std::is_integral<T>::value && !cudf::is_boolean<T>()> * = nullptr>
@@ -126,9 +224,7 @@ std::unique_ptr<cudf::column> evaluate_string_functions(const cudf::table_view &
         }
 
         std::string literal_expression = StringUtil::removeEncapsulation(arg_tokens[1], encapsulation_character);
-        std::string regex = like_expression_to_regex_str(literal_expression);
-
-        computed_col = cudf::strings::contains_re(column, regex);
+        computed_col = evaluate_like(column, literal_expression);
         break;
     }
     case operator_type::BLZ_STR_REPLACE:
@@ -477,7 +573,7 @@ std::unique_ptr<cudf::column> evaluate_string_functions(const cudf::table_view &
 
         cudf::column_view column = table.column(get_index(arg_tokens[0]));
         if (is_type_string(column.type().id())) {
-            computed_col = cudf::strings::to_timestamps(column, cudf::data_type{cudf::type_id::TIMESTAMP_DAYS}, "%Y-%m-%d");
+            computed_col = ral::utilities::strings_to_timestamps(column, cudf::data_type{cudf::type_id::TIMESTAMP_DAYS});
         }
         break;
     }
@@ -495,14 +591,15 @@ std::unique_ptr<cudf::column> evaluate_string_functions(const cudf::table_view &
 
         cudf::column_view column = table.column(get_index(arg_tokens[0]));
         if (is_type_string(column.type().id())) {
+            // the format is detected from the first rows, see ral::utilities::strings_to_timestamps
             if (op == operator_type::BLZ_CAST_TIMESTAMP_SECONDS) {
-                computed_col = cudf::strings::to_timestamps(column, cudf::data_type{cudf::type_id::TIMESTAMP_SECONDS}, "%Y-%m-%d %H:%M:%S");
+                computed_col = ral::utilities::strings_to_timestamps(column, cudf::data_type{cudf::type_id::TIMESTAMP_SECONDS});
             } else if (op == operator_type::BLZ_CAST_TIMESTAMP_MILLISECONDS) {
-                computed_col = cudf::strings::to_timestamps(column, cudf::data_type{cudf::type_id::TIMESTAMP_MILLISECONDS}, "%Y-%m-%d %H:%M:%S");
+                computed_col = ral::utilities::strings_to_timestamps(column, cudf::data_type{cudf::type_id::TIMESTAMP_MILLISECONDS});
             } else if (op == operator_type::BLZ_CAST_TIMESTAMP_MICROSECONDS) {
-                computed_col = cudf::strings::to_timestamps(column, cudf::data_type{cudf::type_id::TIMESTAMP_MICROSECONDS}, "%Y-%m-%d %H:%M:%S");
+                computed_col = ral::utilities::strings_to_timestamps(column, cudf::data_type{cudf::type_id::TIMESTAMP_MICROSECONDS});
             } else {
-                computed_col = cudf::strings::to_timestamps(column, cudf::data_type{cudf::type_id::TIMESTAMP_NANOSECONDS}, "%Y-%m-%d %H:%M:%S");
+                computed_col = ral::utilities::strings_to_timestamps(column, cudf::data_type{cudf::type_id::TIMESTAMP_NANOSECONDS});
             }
         }
         break;
@@ -602,57 +699,117 @@ std::unique_ptr<cudf::column> evaluate_string_functions(const cudf::table_view &
     return computed_col;
 }
 
+// The number of conditions of a CASE on strings whose first match is looked for in the same pass of the interpreter
+const std::size_t CASE_BRANCHES_PER_PASS = 8;
+
+/**
+ * @brief Returns true if a result expression of a CASE makes it a CASE on strings
+ */
+bool is_string_case_value(const cudf::table_view & table, const parser::node & node) {
+    if (node.type == parser::node_type::OPERATOR) {
+        return false;
+    }
+    if (is_var_column(node.value)) {
+        return table.column(get_index(node.value)).type().id() == cudf::type_id::STRING;
+    }
+    return is_string(node.value) || is_null(node.value);
+}
+
 /**
- * @brief Evaluates a "CASE WHEN ELSE" when any of the result expressions is a string.
+ * @brief Evaluates a "CASE WHEN ELSE" on strings with all of its branches at once.
+ *
+ * The branch that every row takes is found with the interpreter, a few conditions at a time, so the conditions past
+ * them are only evaluated on the rows that don't have a match yet, which are compacted when they are at most half of
+ * them. Then the branches that are literals are gathered in one pass, and the ones that are columns are only copied
+ * into their own rows.
  *
  * @param table The input table
- * @param op The string function to evaluate
- * @param arg_tokens The parsed function arguments
+ * @param conditions The conditions of the branches, in order
+ * @param values The results of the branches, with the one of the ELSE last. They are string literals, nulls, or string columns.
  */
-std::unique_ptr<cudf::column> evaluate_string_case_when_else(const cudf::table_view & table,
-                                                            const std::string & condition_expr,
-                                                            const std::string & expr1,
-                                                            const std::string & expr2)
+std::unique_ptr<cudf::column> evaluate_string_case(const cudf::table_view & table,
+                                                   const std::vector<std::string> & conditions,
+                                                   const std::vector<std::string> & values)
 {
-    if ((!is_string(expr1) && !is_var_column(expr1) && !is_null(expr1)) || (!is_string(expr2) && !is_var_column(expr2) && !is_null(expr2))) {
-        return nullptr;
-    }
+    assert(values.size() == conditions.size() + 1);
+
+    // the rows without a match get the index of the ELSE in the last pass, and one past it before
+    const int32_t else_branch = conditions.size();
+    cudf::numeric_scalar<int32_t> no_match(else_branch + 1);
+
+    std::unique_ptr<cudf::column> branches;
+    cudf::table_view remaining_table = table;
+    std::unique_ptr<cudf::table> compacted_table;
+    std::unique_ptr<cudf::column> remaining_rows; // the rows of remaining_table in table, when they are not all of them
+    std::unique_ptr<cudf::column> remaining_branches;
+    auto merge_remaining_branches = [&]() {
+        if (!remaining_rows) {
+            branches = std::move(remaining_branches);
+        } else {
+            branches = std::move(cudf::scatter(cudf::table_view{{remaining_branches->view()}}, remaining_rows->view(), cudf::table_view{{branches->view()}})->release()[0]);
+        }
+    };
 
-    if ((is_var_column(expr1) && table.column(get_index(expr1)).type().id() != cudf::type_id::STRING)
-        || (is_var_column(expr2) && table.column(get_index(expr2)).type().id() != cudf::type_id::STRING)) {
-        return nullptr;
-    }
+    for (std::size_t first = 0; first < conditions.size(); first += CASE_BRANCHES_PER_PASS) {
+        std::size_t last = std::min(first + CASE_BRANCHES_PER_PASS, conditions.size());
+        bool is_last_pass = last == conditions.size();
 
-    RAL_EXPECTS(!is_literal(condition_expr), "CASE operator not supported for condition expression literals");
+        std::string case_expression = "CASE(";
+        for (std::size_t i = first; i < last; i++) {
+            RAL_EXPECTS(!is_literal(conditions[i]), "CASE operator not supported for condition expression literals");
+            case_expression += conditions[i] + ", " + std::to_string(i) + ", ";
+        }
+        case_expression += std::to_string(is_last_pass ? else_branch : else_branch + 1) + ")";
 
-    std::vector<std::unique_ptr<ral::frame::BlazingColumn>> evaluated_table;
-    cudf::column_view boolean_mask_view;
-    if (is_var_column(condition_expr)) {
-        boolean_mask_view = table.column(get_index(condition_expr));
-    } else {
-        evaluated_table = evaluate_expressions(table, {condition_expr});
-        RAL_EXPECTS(evaluated_table.size() == 1 && evaluated_table[0]->view().type().id() == cudf::type_id::BOOL8, "Expression does not evaluate to a boolean mask");
+        auto evaluated_table = evaluate_expressions(remaining_table, {case_expression});
+        std::unique_ptr<cudf::column> pass_branches = evaluated_table[0]->release();
+        if (!remaining_branches) {
+            remaining_branches = std::move(pass_branches);
+        } else {
+            // the rows matched by the passes before keep their branch
+            auto matched = cudf::binary_operation(remaining_branches->view(), no_match, cudf::binary_operator::NOT_EQUAL, cudf::data_type{cudf::type_id::BOOL8});
+            remaining_branches = cudf::copy_if_else(remaining_branches->view(), pass_branches->view(), matched->view());
+        }
+        if (is_last_pass) {
+            break;
+        }
 
-        boolean_mask_view = evaluated_table[0]->view();
+        auto unmatched = cudf::binary_operation(remaining_branches->view(), no_match, cudf::binary_operator::EQUAL, cudf::data_type{cudf::type_id::BOOL8});
+        auto positions = cudf::sequence(remaining_table.num_rows(), cudf::numeric_scalar<int32_t>(0));
+        std::unique_ptr<cudf::column> unmatched_positions = std::move(cudf::apply_boolean_mask(cudf::table_view{{positions->view()}}, unmatched->view())->release()[0]);
+        if (unmatched_positions->size() == 0) {
+            break;
+        }
+        if (unmatched_positions->size() * 2 <= remaining_table.num_rows()) {
+            merge_remaining_branches();
+            auto unmatched_table = cudf::gather(remaining_table, unmatched_positions->view());
+            if (remaining_rows) {
+                remaining_rows = std::move(cudf::gather(cudf::table_view{{remaining_rows->view()}}, unmatched_positions->view())->release()[0]);
+            } else {
+                remaining_rows = std::move(unmatched_positions);
+            }
+            compacted_table = std::move(unmatched_table);
+            remaining_table = compacted_table->view();
+        }
     }
+    merge_remaining_branches();
+
+    // the branches that are columns are null among the literals
+    std::vector<std::unique_ptr<cudf::column>> literal_columns;
+    std::vector<cudf::column_view> literal_views;
+    for (auto && value : values) {
+        std::unique_ptr<cudf::scalar> literal = get_scalar_from_string(is_var_column(value) ? "null" : value, cudf::data_type{cudf::type_id::STRING});
+        literal_columns.push_back(cudf::make_column_from_scalar(*literal, 1));
+        literal_views.push_back(literal_columns.back()->view());
+    }
+    std::unique_ptr<cudf::column> literals = cudf::concatenate(literal_views);
+    std::unique_ptr<cudf::column> computed_col = std::move(cudf::gather(cudf::table_view{{literals->view()}}, branches->view())->release()[0]);
 
-    std::unique_ptr<cudf::column> computed_col;
-    if ((is_string(expr1) || is_null(expr1)) && (is_string(expr2) || is_null(expr2))) {
-        std::unique_ptr<cudf::scalar> lhs = get_scalar_from_string(expr1, cudf::data_type{cudf::type_id::STRING});
-        std::unique_ptr<cudf::scalar> rhs = get_scalar_from_string(expr2, cudf::data_type{cudf::type_id::STRING});
-        computed_col = cudf::copy_if_else(*lhs, *rhs, boolean_mask_view);
-    } else if (is_string(expr1) || is_null(expr1)) {
-        std::unique_ptr<cudf::scalar> lhs = get_scalar_from_string(expr1, cudf::data_type{cudf::type_id::STRING});
-        cudf::column_view rhs = table.column(get_index(expr2));
-        computed_col = cudf::copy_if_else(*lhs, rhs, boolean_mask_view);
-    } else if (is_string(expr2) || is_null(expr2)) {
-        cudf::column_view lhs = table.column(get_index(expr1));
-        std::unique_ptr<cudf::scalar> rhs = get_scalar_from_string(expr2, cudf::data_type{cudf::type_id::STRING});
-        computed_col = cudf::copy_if_else(lhs, *rhs, boolean_mask_view);
-    } else {
-        cudf::column_view lhs = table.column(get_index(expr1));
-        cudf::column_view rhs = table.column(get_index(expr2));
-        computed_col = cudf::copy_if_else(lhs, rhs, boolean_mask_view);
+    for (std::size_t i = 0; i < values.size(); i++) {
+        if (is_var_column(values[i])) {
+            auto in_branch = cudf::binary_operation(branches->view(), cudf::numeric_scalar<int32_t>(i), cudf::binary_operator::EQUAL, cudf::data_type{cudf::type_id::BOOL8});
+            computed_col = cudf::copy_if_else(table.column(get_index(values[i])), computed_col->view(), in_branch->view());
+        }
     }
 
     return computed_col;
@@ -677,31 +834,35 @@ public:
     parser::node * transform(parser::operator_node& node) override {
         operator_type op = map_to_operator_type(node.value);
 
-        std::unique_ptr<cudf::column> computed_col;
-        std::vector<std::string> arg_tokens;
         if (op == operator_type::BLZ_FIRST_NON_MAGIC) {
             // Handle special case for CASE WHEN ELSE END operation for strings
             assert(node.children[0]->type == parser::node_type::OPERATOR);
             assert(map_to_operator_type(node.children[0]->value) == operator_type::BLZ_MAGIC_IF_NOT);
 
-            const parser::node * magic_if_not_node = node.children[0].get();
-            const parser::node * condition_node = magic_if_not_node->children[0].get();
-            const parser::node * expr_node_1 = magic_if_not_node->children[1].get();
-            const parser::node * expr_node_2 = node.children[1].get();
-
-            std::string conditional_exp = parser::detail::rebuild_helper(condition_node);
-
-            arg_tokens = {conditional_exp, expr_node_1->value, expr_node_2->value};
-            computed_col = strings::evaluate_string_case_when_else(cudf::table_view{{table, computed_columns_view()}}, conditional_exp, expr_node_1->value, expr_node_2->value);
-        } else {
-            arg_tokens.reserve(node.children.size());
-            for (auto &&c : node.children) {
-                arg_tokens.push_back(parser::detail::rebuild_helper(c.get()));
+            // The branches of a CASE are nested in its ELSE, which is seen first, so the CASE is only evaluated
+            // once all of its branches have been seen, by its parent or by evaluate_deferred_cases
+            const parser::node * then_node = node.children[0]->children[1].get();
+            const parser::node * else_node = node.children[1].get();
+            cudf::table_view input_table{{table, computed_columns_view()}};
+            if (strings::is_string_case_value(input_table, *then_node)
+                && (deferred_cases.count(else_node) > 0 || strings::is_string_case_value(input_table, *else_node))) {
+                deferred_cases.insert(&node);
+                return &node;
             }
+            evaluate_deferred_children(node);
+            return &node;
+        }
+        evaluate_deferred_children(node);
 
-            computed_col = strings::evaluate_string_functions(cudf::table_view{{table, computed_columns_view()}}, op, arg_tokens);
+        std::unique_ptr<cudf::column> computed_col;
+        std::vector<std::string> arg_tokens;
+        arg_tokens.reserve(node.children.size());
+        for (auto &&c : node.children) {
+            arg_tokens.push_back(parser::detail::rebuild_helper(c.get()));
         }
 
+        computed_col = strings::evaluate_string_functions(cudf::table_view{{table, computed_columns_view()}}, op, arg_tokens);
+
         // If computed_col is a not nullptr then the node was a complex operation and
         // we need to remove it from the tree so that only simple operations (that the
         // interpreter is able to handle) remain
@@ -736,11 +897,270 @@ public:
 
     std::vector<std::unique_ptr<cudf::column>> release_computed_columns() { return std::move(computed_columns); }
 
+    /**
+     * @brief Evaluates the CASE on strings that is the root of the tree, if there is one, after the tree was transformed
+     */
+    void evaluate_deferred_cases(parser::parse_tree & tree) {
+        if (deferred_cases.count(&tree.root()) > 0) {
+            deferred_root_transformer root_transformer{*this, &tree.root()};
+            tree.transform(root_transformer);
+        }
+    }
+
 private:
+    struct deferred_root_transformer : public parser::node_transformer {
+        deferred_root_transformer(function_evaluator_transformer & evaluator, const parser::node * root) : evaluator{evaluator}, root{root} {}
+
+        parser::node * transform(parser::operad_node& node) override { return &node; }
+
+        parser::node * transform(parser::operator_node& node) override {
+            return &node == root ? evaluator.evaluate_deferred_case(node) : &node;
+        }
+
+        function_evaluator_transformer & evaluator;
+        const parser::node * root;
+    };
+
+    void evaluate_deferred_children(parser::operator_node& node) {
+        for (auto &&c : node.children) {
+            if (deferred_cases.count(c.get()) > 0) {
+                c.reset(evaluate_deferred_case(*c));
+            }
+        }
+    }
+
+    // Evaluates a CASE on strings with all its branches, see strings::evaluate_string_case. The columns its results use
+    // are not discarded, since the ones computed after them would change their indices.
+    parser::node * evaluate_deferred_case(const parser::node & case_node) {
+        std::vector<std::string> conditions;
+        std::vector<std::string> values;
+        const parser::node * current_node = &case_node;
+        while (deferred_cases.count(current_node) > 0) {
+            deferred_cases.erase(current_node);
+            const parser::node * magic_if_not_node = current_node->children[0].get();
+            conditions.push_back(parser::detail::rebuild_helper(magic_if_not_node->children[0].get()));
+            values.push_back(magic_if_not_node->children[1]->value);
+            current_node = current_node->children[1].get();
+        }
+        values.push_back(current_node->value);
+
+        auto computed_col = strings::evaluate_string_case(cudf::table_view{{table, computed_columns_view()}}, conditions, values);
+
+        std::string computed_var_token = "$" + std::to_string(table.num_columns() + computed_columns.size());
+        computed_columns.push_back(std::move(computed_col));
+        return new parser::variable_node(computed_var_token);
+    }
+
     cudf::table_view table;
     std::vector<std::unique_ptr<cudf::column>> computed_columns;
+    std::set<const parser::node *> deferred_cases; // the CASE on strings that are evaluated once their parent is seen
+};
+
+bool is_decimal_type(cudf::data_type type) {
+    return type.id() == cudf::type_id::DECIMAL32 || type.id() == cudf::type_id::DECIMAL64;
+}
+
+/**
+ * @brief Keeps the decimals of the expressions of the interpreter in fixed point.
+ *
+ * The interpreter computes the decimals as their unscaled values, which is exact for the sums, the differences and the
+ * comparisons of decimals with the same scale, and for the products, whose scale is the sum of the scales. This finds
+ * the types and the scales of the nodes with decimals, and it makes the number literals they are used with into their
+ * unscaled values at the same scale. Anything else with a decimal, like a division or decimals with different scales,
+ * makes is_supported false, and then the expressions are evaluated with the decimals cast to FLOAT64.
+ *
+ * The unscaled values of a product can overflow the int64 of the interpreter, so this also bounds the number of bits of
+ * the unscaled values of every node, from the minimums and the maximums of the decimal columns, and the products whose
+ * bound is over 63 bits are not supported either.
+ */
+struct fixed_point_transformer : public parser::node_transformer {
+public:
+    fixed_point_transformer(const cudf::table_view & table) : table{table} { }
+
+    parser::node * transform(parser::operad_node& node) override {
+        if (node.type == parser::node_type::VARIABLE) {
+            cudf::data_type type = table.column(static_cast<parser::variable_node&>(node).index()).type();
+            if (is_decimal_type(type)) {
+                decimal_types[&node] = type;
+                magnitude_bits[&node] = get_column_magnitude_bits(static_cast<parser::variable_node&>(node).index());
+            }
+        }
+        return &node;
+    }
+
+    parser::node * transform(parser::operator_node& node) override {
+        bool has_decimal = std::any_of(node.children.begin(), node.children.end(), [this](auto & child) { return decimal_types.count(child.get()) > 0; });
+        const std::string & op = node.value;
+        if (!has_decimal || op == "IS_NULL" || op == "IS_NOT_NULL") {
+            return &node;
+        }
+        if (node.children.size() != 2 || op == "MAGIC_IF_NOT") {
+            // MAGIC_IF_NOT outputs its second operand when its first one is true
+            if (op == "MAGIC_IF_NOT" && decimal_types.count(node.children[0].get()) == 0) {
+                decimal_types[&node] = decimal_types.at(node.children[1].get());
+                magnitude_bits[&node] = get_magnitude_bits(node.children[1]);
+            } else {
+                supported = false;
+            }
+            return &node;
+        }
+
+        if (op == "*") {
+            auto left_scale = get_multiplication_scale(node.children[0]);
+            auto right_scale = get_multiplication_scale(node.children[1]);
+            int32_t bits = get_magnitude_bits(node.children[0]) + get_magnitude_bits(node.children[1]);
+            if (left_scale.first && right_scale.first && bits <= 63) {
+                decimal_types[&node] = cudf::data_type{cudf::type_id::DECIMAL64, left_scale.second + right_scale.second};
+                magnitude_bits[&node] = bits;
+            } else {
+                supported = false;
+            }
+        } else if (op == "+" || op == "-" || op == "FIRST_NON_MAGIC" || op == "=" || op == "<>" || op == "<" || op == "<=" || op == ">" || op == ">=") {
+            auto & decimal_child = decimal_types.count(node.children[0].get()) > 0 ? node.children[0] : node.children[1];
+            auto & other_child = decimal_types.count(node.children[0].get()) > 0 ? node.children[1] : node.children[0];
+            cudf::data_type type = decimal_types.at(decimal_child.get());
+            if (!align_to_scale(other_child, type.scale())) {
+                supported = false;
+            } else if (op == "+" || op == "-" || op == "FIRST_NON_MAGIC") {
+                auto other_type = decimal_types.find(other_child.get());
+                bool is_64 = type.id() == cudf::type_id::DECIMAL64 || other_type == decimal_types.end() || other_type->second.id() == cudf::type_id::DECIMAL64;
+                decimal_types[&node] = cudf::data_type{is_64 ? cudf::type_id::DECIMAL64 : cudf::type_id::DECIMAL32, type.scale()};
+                magnitude_bits[&node] = std::min(std::max(get_magnitude_bits(decimal_child), get_magnitude_bits(other_child)) + 1, 64);
+            }
+        } else {
+            supported = false;
+        }
+        return &node;
+    }
+
+    bool is_supported() const { return supported; }
+
+    const std::map<const parser::node *, cudf::data_type> & get_decimal_types() const { return decimal_types; }
+
+private:
+    bool is_null_literal(const std::unique_ptr<parser::node> & child) {
+        return child->type == parser::node_type::LITERAL && is_null(child->value);
+    }
+
+    bool is_number_literal(const std::unique_ptr<parser::node> & child) {
+        if (child->type != parser::node_type::LITERAL || is_null(child->value)) {
+            return false;
+        }
+        cudf::type_id type = static_cast<const parser::literal_node &>(*child).type().id();
+        return is_type_integer(type) || is_type_float(type);
+    }
+
+    // Makes the operand of a decimal with this scale have the same scale, which is exact for the nulls, the decimals
+    // with the same scale, the integers when the scale is 0, and the number literals that can be written with it
+    bool align_to_scale(std::unique_ptr<parser::node> & child, int32_t scale) {
+        auto type = decimal_types.find(child.get());
+        if (type != decimal_types.end()) {
+            return type->second.scale() == scale;
+        }
+        if (is_null_literal(child)) {
+            return true;
+        }
+        if (is_number_literal(child)) {
+            int64_t unscaled_value;
+            if (!get_unscaled_decimal_value(child->value, scale, unscaled_value)) {
+                return false;
+            }
+            child.reset(new parser::literal_node(std::to_string(unscaled_value), cudf::data_type{cudf::type_id::INT64}));
+            decimal_types[child.get()] = cudf::data_type{cudf::type_id::DECIMAL64, scale};
+            magnitude_bits[child.get()] = get_value_magnitude_bits(unscaled_value);
+            return true;
+        }
+        return scale == 0 && child->type == parser::node_type::VARIABLE
+            && is_type_integer(table.column(static_cast<const parser::variable_node &>(*child).index()).type().id());
+    }
+
+    // Returns the scale of an operand of a product with a decimal, the integer columns have a scale of 0 and the
+    // number literals have the smallest scale they can be written with
+    std::pair<bool, int32_t> get_multiplication_scale(std::unique_ptr<parser::node> & child) {
+        auto type = decimal_types.find(child.get());
+        if (type != decimal_types.end()) {
+            return {true, type->second.scale()};
+        }
+        if (is_number_literal(child)) {
+            for (int32_t scale = 0; scale >= -9; scale--) {
+                if (align_to_scale(child, scale)) {
+                    return {true, scale};
+                }
+            }
+            return {false, 0};
+        }
+        return {align_to_scale(child, 0), 0};
+    }
+
+    // Returns the number of bits of the largest unscaled value of an aligned operand, the integer columns can have any
+    // value of their type and the nulls have none
+    int32_t get_magnitude_bits(const std::unique_ptr<parser::node> & child) {
+        auto bits = magnitude_bits.find(child.get());
+        if (bits != magnitude_bits.end()) {
+            return bits->second;
+        }
+        if (child->type == parser::node_type::VARIABLE) {
+            return cudf::size_of(table.column(static_cast<const parser::variable_node &>(*child).index()).type()) * 8;
+        }
+        return is_null_literal(child) ? 0 : 64;
+    }
+
+    static int32_t get_value_magnitude_bits(int64_t value) {
+        if (value == std::numeric_limits<int64_t>::min()) {
+            return 64;
+        }
+        int32_t bits = 0;
+        for (uint64_t magnitude = static_cast<uint64_t>(value < 0 ? -value : value); magnitude > 0; magnitude >>= 1) {
+            bits++;
+        }
+        return bits;
+    }
+
+    // The unscaled values of a decimal column are read as the integers they are stored as, to find their bound
+    int32_t get_column_magnitude_bits(cudf::size_type column_index) {
+        auto bits = column_magnitude_bits.find(column_index);
+        if (bits != column_magnitude_bits.end()) {
+            return bits->second;
+        }
+        cudf::column_view column = table.column(column_index);
+        bool is_64 = column.type().id() == cudf::type_id::DECIMAL64;
+        cudf::column_view unscaled_values(cudf::data_type{is_64 ? cudf::type_id::INT64 : cudf::type_id::INT32},
+            column.size(), column.head(), column.null_mask(), column.null_count(), column.offset());
+        int32_t column_bits = 0;
+        if (unscaled_values.size() > unscaled_values.null_count()) {
+            auto min_max = cudf::minmax(unscaled_values);
+            if (is_64) {
+                column_bits = std::max(get_value_magnitude_bits(static_cast<cudf::numeric_scalar<int64_t> *>(min_max.first.get())->value()),
+                    get_value_magnitude_bits(static_cast<cudf::numeric_scalar<int64_t> *>(min_max.second.get())->value()));
+            } else {
+                column_bits = std::max(get_value_magnitude_bits(static_cast<cudf::numeric_scalar<int32_t> *>(min_max.first.get())->value()),
+                    get_value_magnitude_bits(static_cast<cudf::numeric_scalar<int32_t> *>(min_max.second.get())->value()));
+            }
+        }
+        column_magnitude_bits[column_index] = column_bits;
+        return column_bits;
+    }
+
+    cudf::table_view table;
+    std::map<const parser::node *, cudf::data_type> decimal_types;
+    std::map<const parser::node *, int32_t> magnitude_bits;
+    std::map<cudf::size_type, int32_t> column_magnitude_bits;
+    bool supported = true;
 };
 
+// Casts the decimal columns of a table to FLOAT64, for the expressions the interpreter can't keep in fixed point
+std::unique_ptr<cudf::table> cast_decimal_columns_to_float(const cudf::table_view & table) {
+    std::vector<std::unique_ptr<cudf::column>> columns;
+    for (cudf::size_type i = 0; i < table.num_columns(); i++) {
+        if (is_decimal_type(table.column(i).type())) {
+            columns.push_back(cudf::cast(table.column(i), cudf::data_type{cudf::type_id::FLOAT64}));
+        } else {
+            columns.push_back(std::make_unique<cudf::column>(table.column(i)));
+        }
+    }
+    return std::make_unique<cudf::table>(std::move(columns));
+}
+
 /**
  * @brief A class that traverses an expression tree and calculates the final
  * output type of the expression.
@@ -748,11 +1168,14 @@ private:
 struct expr_output_type_visitor : public ral::parser::node_visitor
 {
 public:
-	expr_output_type_visitor(const cudf::table_view & table) : table_{table} { }
+	expr_output_type_visitor(const cudf::table_view & table, const std::map<const ral::parser::node*, cudf::data_type> & decimal_types = {})
+		: table_{table}, decimal_types_{decimal_types} { }
 
 	void visit(const ral::parser::operad_node& node) override {
 		cudf::data_type output_type;
-		if (is_literal(node.value)) {
+		if (decimal_types_.count(&node) > 0) {
+			output_type = decimal_types_.at(&node);
+		} else if (is_literal(node.value)) {
 			output_type = static_cast<const ral::parser::literal_node&>(node).type();
 		} else {
             cudf::size_type idx = static_cast<const ral::parser::variable_node&>(node).index();
@@ -769,7 +1192,9 @@ public:
 	void visit(const ral::parser::operator_node& node) override {
 		cudf::data_type output_type;
 		operator_type op = map_to_operator_type(node.value);
-		if(is_binary_operator(op)) {
+		if(decimal_types_.count(&node) > 0) {
+			output_type = decimal_types_.at(&node);
+		} else if(is_binary_operator(op)) {
 			output_type = cudf::data_type{get_output_type(op, node_to_type_map_.at(node.children[0].get()).id(), node_to_type_map_.at(node.children[1].get()).id())};
 		} else if (is_unary_operator(op)) {
 			output_type = cudf::data_type{get_output_type(op, node_to_type_map_.at(node.children[0].get()).id())};
@@ -791,12 +1216,65 @@ private:
 
 	std::map<const ral::parser::node*, cudf::data_type> node_to_type_map_;
 	cudf::table_view table_;
+	std::map<const ral::parser::node*, cudf::data_type> decimal_types_;
 };
 
+// Evaluates the expressions with a plan that was made for a table with the same schema
+std::vector<std::unique_ptr<ral::frame::BlazingColumn>> evaluate_interpreter_plan(
+    const cudf::table_view & table,
+    const interops::interpreter_plan & plan) {
+    using output_kind = interops::interpreter_plan::output_kind;
+
+    std::vector<std::unique_ptr<ral::frame::BlazingColumn>> out_columns(plan.expression_outputs.size());
+    std::vector<cudf::mutable_column_view> interpreter_out_column_views;
+    for(size_t i = 0; i < plan.expression_outputs.size(); i++){
+        const interops::interpreter_plan::expression_output & output = plan.expression_outputs[i];
+        if (output.kind == output_kind::LITERAL) {
+            out_columns[i] = std::make_unique<ral::frame::BlazingColumnOwner>(cudf::make_column_from_scalar(*output.literal, table.num_rows()));
+        } else if (output.kind == output_kind::INPUT_COLUMN) {
+            out_columns[i] = std::make_unique<ral::frame::BlazingColumnOwner>(std::make_unique<cudf::column>(table.column(output.input_index)));
+        } else {
+            auto new_column = cudf::make_fixed_width_column(output.type, table.num_rows(), cudf::mask_state::UNINITIALIZED);
+            interpreter_out_column_views.push_back(new_column->mutable_view());
+            out_columns[i] = std::make_unique<ral::frame::BlazingColumnOwner>(std::move(new_column));
+        }
+    }
+
+    if(!interpreter_out_column_views.empty()){
+        cudf::table_view interops_input_table = table.select(plan.input_col_indices);
+        cudf::mutable_table_view out_table_view(interpreter_out_column_views);
+        if (!plan.jit_kernel_source.empty()) {
+            interops::jit::evaluate(plan.jit_kernel_source, interops_input_table, out_table_view);
+        } else {
+            interops::perform_interpreter_operation(out_table_view,
+                                                    interops_input_table,
+                                                    plan.left_inputs,
+                                                    plan.right_inputs,
+                                                    plan.outputs,
+                                                    plan.final_output_positions,
+                                                    plan.operators,
+                                                    plan.left_scalars,
+                                                    plan.right_scalars,
+                                                    table.num_rows());
+        }
+    }
+
+    return out_columns;
+}
+
 std::vector<std::unique_ptr<ral::frame::BlazingColumn>> evaluate_expressions(
     const cudf::table_view & table,
     const std::vector<std::string> & expressions) {
     using interops::column_index_type;
+    using output_kind = interops::interpreter_plan::output_kind;
+
+    // the expressions that were already parsed and encoded for a table like this one are not parsed again
+    std::string plan_key = interops::get_interpreter_plan_key(table, expressions);
+    if (std::shared_ptr<const interops::interpreter_plan> cached_plan = interops::interpreter_plan_cache::get_instance().get(plan_key)) {
+        return evaluate_interpreter_plan(table, *cached_plan);
+    }
+    auto plan = std::make_shared<interops::interpreter_plan>();
+    plan->expression_outputs.resize(expressions.size());
 
     std::vector<std::unique_ptr<ral::frame::BlazingColumn>> out_columns(expressions.size());
 
@@ -817,21 +1295,34 @@ std::vector<std::unique_ptr<ral::frame::BlazingColumn>> evaluate_expressions(
         // Transform the expression tree so that only nodes that can be evaluated
         // by the interpreter remain
         tree.transform_to_custom_op();
+        tree.fold_constants();
         tree.transform(evaluator);
+        evaluator.evaluate_deferred_cases(tree);
 
         if (tree.root().type == parser::node_type::LITERAL) {
             cudf::data_type literal_type = static_cast<const ral::parser::literal_node&>(tree.root()).type();
             std::unique_ptr<cudf::scalar> literal_scalar = get_scalar_from_string(tree.root().value, literal_type);
             out_columns[i] = std::make_unique<ral::frame::BlazingColumnOwner>(cudf::make_column_from_scalar(*literal_scalar, table.num_rows()));
+            plan->expression_outputs[i].kind = output_kind::LITERAL;
+            plan->expression_outputs[i].literal = std::move(literal_scalar);
         } else if (tree.root().type == parser::node_type::VARIABLE) {
             cudf::size_type idx = static_cast<const ral::parser::variable_node&>(tree.root()).index();
             if (idx < table.num_columns()) {
                 out_columns[i] = std::make_unique<ral::frame::BlazingColumnOwner>(std::make_unique<cudf::column>(table.column(idx)));
+                plan->expression_outputs[i].kind = output_kind::INPUT_COLUMN;
+                plan->expression_outputs[i].input_index = idx;
             } else {
                 out_idx_computed_idx_pair.push_back({i, idx - table.num_columns()});
             }
         } else {
-        	expr_output_type_visitor visitor{cudf::table_view{{table, evaluator.computed_columns_view()}}};
+            fixed_point_transformer fixed_point{cudf::table_view{{table, evaluator.computed_columns_view()}}};
+            tree.transform(fixed_point);
+            if (!fixed_point.is_supported()) {
+                std::unique_ptr<cudf::table> float_table = cast_decimal_columns_to_float(table);
+                return evaluate_expressions(float_table->view(), expressions);
+            }
+
+        	expr_output_type_visitor visitor{cudf::table_view{{table, evaluator.computed_columns_view()}}, fixed_point.get_decimal_types()};
 	        tree.visit(visitor);
 
             cudf::data_type expr_out_type = visitor.get_expr_output_type();
@@ -839,6 +1330,8 @@ std::vector<std::unique_ptr<ral::frame::BlazingColumn>> evaluate_expressions(
             auto new_column = cudf::make_fixed_width_column(expr_out_type, table.num_rows(), cudf::mask_state::UNINITIALIZED);
             interpreter_out_column_views.push_back(new_column->mutable_view());
             out_columns[i] = std::make_unique<ral::frame::BlazingColumnOwner>(std::move(new_column));
+            plan->expression_outputs[i].kind = output_kind::INTERPRETED;
+            plan->expression_outputs[i].type = expr_out_type;
 
             // Keep track of which columns are used in the expression
             for(auto&& idx : visitor.get_variable_indices()) {
@@ -855,6 +1348,8 @@ std::vector<std::unique_ptr<ral::frame::BlazingColumn>> evaluate_expressions(
     for (auto &&p : out_idx_computed_idx_pair) {
         out_columns[p.first] = std::make_unique<ral::frame::BlazingColumnOwner>(std::move(computed_columns[p.second]));
     }
+    // the columns that were computed for this batch can't be reused by the next one
+    bool can_cache_plan = computed_columns.empty();
 
     // Get the needed columns indices in order and keep track of the mapped indices
     std::map<column_index_type, column_index_type> col_idx_map;
@@ -879,6 +1374,21 @@ std::vector<std::unique_ptr<ral::frame::BlazingColumn>> evaluate_expressions(
     }
 
     cudf::table_view interops_input_table{{table.select(input_col_indices), cudf::table_view{filtered_computed_views}}};
+    plan->input_col_indices = input_col_indices;
+
+    // the expressions the JIT backend supports are evaluated by a kernel compiled for them, instead of the interpreter
+    if(!expr_tree_vector.empty() && interops::jit::is_enabled()){
+        cudf::mutable_table_view out_table_view(interpreter_out_column_views);
+        std::string kernel_source = interops::jit::generate_kernel_source(expr_tree_vector, col_idx_map, interops_input_table, out_table_view);
+        if(!kernel_source.empty()){
+            interops::jit::evaluate(kernel_source, interops_input_table, out_table_view);
+            if (can_cache_plan) {
+                plan->jit_kernel_source = std::move(kernel_source);
+                interops::interpreter_plan_cache::get_instance().put(plan_key, std::move(plan));
+            }
+            return std::move(out_columns);
+        }
+    }
 
     std::vector<column_index_type> left_inputs;
     std::vector<column_index_type> right_inputs;
@@ -888,12 +1398,32 @@ std::vector<std::unique_ptr<ral::frame::BlazingColumn>> evaluate_expressions(
     std::vector<std::unique_ptr<cudf::scalar>> left_scalars;
     std::vector<std::unique_ptr<cudf::scalar>> right_scalars;
 
+    // the subexpressions that more than one place uses are computed once, into positions past the ones of the outputs
+    column_index_type first_subexpression_position = interops_input_table.num_columns() + interpreter_out_column_views.size();
+    std::vector<parser::parse_tree> subexpression_trees = interops::extract_common_subexpressions(expr_tree_vector, table.num_columns() + computed_columns.size());
+    for (size_t i = 0; i < subexpression_trees.size(); i++) {
+        col_idx_map.insert({table.num_columns() + computed_columns.size() + i, first_subexpression_position + i});
+    }
+    cudf::size_type start_processing_position = first_subexpression_position + subexpression_trees.size();
+    for (size_t i = subexpression_trees.size(); i-- > 0;) {
+        interops::add_expression_to_interpreter_plan(subexpression_trees[i],
+                                                    col_idx_map,
+                                                    start_processing_position,
+                                                    first_subexpression_position + i,
+                                                    left_inputs,
+                                                    right_inputs,
+                                                    outputs,
+                                                    operators,
+                                                    left_scalars,
+                                                    right_scalars);
+    }
+
     for (size_t i = 0; i < expr_tree_vector.size(); i++) {
         final_output_positions.push_back(interops_input_table.num_columns() + i);
 
         interops::add_expression_to_interpreter_plan(expr_tree_vector[i],
                                                     col_idx_map,
-                                                    interops_input_table.num_columns() + interpreter_out_column_views.size(),
+                                                    start_processing_position,
                                                     interops_input_table.num_columns() + i,
                                                     left_inputs,
                                                     right_inputs,
@@ -937,6 +1467,17 @@ std::vector<std::unique_ptr<ral::frame::BlazingColumn>> evaluate_expressions(
                                                 table.num_rows());
     }
 
+    if (can_cache_plan) {
+        plan->left_inputs = std::move(left_inputs);
+        plan->right_inputs = std::move(right_inputs);
+        plan->outputs = std::move(outputs);
+        plan->final_output_positions = std::move(final_output_positions);
+        plan->operators = std::move(operators);
+        plan->left_scalars = std::move(left_scalars);
+        plan->right_scalars = std::move(right_scalars);
+        interops::interpreter_plan_cache::get_instance().put(plan_key, std::move(plan));
+    }
+
     return std::move(out_columns);
 }
 
@@ -995,6 +1536,63 @@ std::unique_ptr<ral::frame::BlazingTable> process_project(
     // as they should be updated with new indices
     expressions = clean_window_function_expressions(expressions, blazing_table_in->num_columns());
 
+    // the projections of only input columns, like the ones that drop the columns that are not needed above a join,
+    // move the columns of the input instead of copying them
+    auto is_input_column = [&](const std::string & expression) {
+        return expression.size() > 1 && expression[0] == '$' &&
+            std::all_of(expression.begin() + 1, expression.end(), [](char c) { return std::isdigit(c); }) &&
+            std::stoi(expression.substr(1)) < blazing_table_in->num_columns();
+    };
+    if (!expressions.empty() && std::all_of(expressions.begin(), expressions.end(), is_input_column)) {
+        std::vector<std::unique_ptr<ral::frame::BlazingColumn>> input_columns = blazing_table_in->releaseBlazingColumns();
+        std::vector<int> output_positions(input_columns.size(), -1);
+        std::vector<std::unique_ptr<ral::frame::BlazingColumn>> output_columns;
+        for (const std::string & expression : expressions) {
+            int index = std::stoi(expression.substr(1));
+            if (output_positions[index] >= 0) {
+                // a column that is used twice is copied the second time
+                output_columns.push_back(std::make_unique<ral::frame::BlazingColumnOwner>(
+                    std::make_unique<cudf::column>(output_columns[output_positions[index]]->view())));
+            } else if (input_columns[index]->type() == ral::frame::blazing_column_type::VIEW) {
+                // the views don't own their buffers, which may not outlive the input
+                output_columns.push_back(std::make_unique<ral::frame::BlazingColumnOwner>(input_columns[index]->release()));
+            } else {
+                output_columns.push_back(std::move(input_columns[index]));
+            }
+            output_positions[index] = output_columns.size() - 1;
+        }
+        return std::make_unique<ral::frame::BlazingTable>(std::move(output_columns), out_column_names);
+    }
+
+    // the expressions of a narrow batch leave most of the GPU idle when they are evaluated one after the other, so they
+    // are dealt round robin into groups that are evaluated at the same time on the streams of the stream_fork_join
+    auto & fork_join = ral::utilities::stream_fork_join::get_instance();
+    uint64_t fork_join_max_rows = context != nullptr ? context->getConfig().project_fork_join_max_rows.value_or(1000000) : 1000000;
+    std::size_t num_computed = std::count_if(expressions.begin(), expressions.end(),
+        [&](const std::string & expression) { return !is_input_column(expression); });
+    std::size_t num_groups = std::min<std::size_t>(fork_join.get_num_streams(), num_computed);
+    if (num_groups > 1 && static_cast<uint64_t>(blazing_table_in->num_rows()) <= fork_join_max_rows) {
+        std::vector<std::vector<std::string>> group_expressions(num_groups);
+        for (std::size_t i = 0; i < expressions.size(); i++) {
+            group_expressions[i % num_groups].push_back(expressions[i]);
+        }
+        cudf::table_view input_view = blazing_table_in->view();
+        std::vector<std::vector<std::unique_ptr<ral::frame::BlazingColumn>>> group_columns(num_groups);
+        std::vector<std::function<void()>> branches;
+        for (std::size_t group = 0; group < num_groups; group++) {
+            branches.push_back([&, group] {
+                group_columns[group] = evaluate_expressions(input_view, group_expressions[group]);
+            });
+        }
+        fork_join.run(branches);
+
+        std::vector<std::unique_ptr<ral::frame::BlazingColumn>> output_columns(expressions.size());
+        for (std::size_t i = 0; i < expressions.size(); i++) {
+            output_columns[i] = std::move(group_columns[i % num_groups][i / num_groups]);
+        }
+        return std::make_unique<ral::frame::BlazingTable>(std::move(output_columns), out_column_names);
+    }
+
     return std::make_unique<ral::frame::BlazingTable>(evaluate_expressions(blazing_table_in->view(), expressions), out_column_names);
 }
 
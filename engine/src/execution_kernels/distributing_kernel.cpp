@@ -2,6 +2,10 @@
 #include "utilities/CommonOperations.h"
 #include <src/utilities/DebuggingUtils.h>
 #include "cache_machine/CPUCacheData.h"
+#include <algorithm>
+#include <numeric>
+#include <cudf/copying.hpp>
+#include <cudf/partitioning.hpp>
 
 namespace ral {
 namespace cache {
@@ -25,11 +29,27 @@ void distributing_kernel::set_number_of_message_trackers(std::size_t num_message
     }
 
     messages_to_wait_for.resize(num_message_trackers);
+
+    const blazingdb::manager::QueryConfig & config = context->getConfig();
+    coalesce_bytes_threshold = config.coalesce_messages_bytes_threshold.value_or(coalesce_bytes_threshold);
+    coalesce_timeout_ms = config.coalesce_messages_timeout_ms.value_or(coalesce_timeout_ms);
+    tree_broadcast = config.enable_tree_broadcast.value_or(tree_broadcast);
+    hash_partitions_per_node = std::max<std::size_t>(config.hash_partitions_per_node.value_or(hash_partitions_per_node), 1);
+
+    if (config.shuffle_checkpoint_path && checkpoint == nullptr) {
+        checkpoint = std::make_unique<ral::distribution::shuffle_checkpoint>(config.shuffle_checkpoint_path.value(),
+            kernel_id,
+            get_kernel_type_name(get_type_id()),
+            context->getContextToken(),
+            context->getNodeIndex(node),
+            context->getTotalNodes(),
+            hash_partitions_per_node);
+    }
 }
 
 std::atomic<uint32_t> unique_message_id(std::rand());
 
-void distributing_kernel::send_message(std::unique_ptr<ral::frame::BlazingTable> table,
+bool distributing_kernel::send_message(std::unique_ptr<ral::frame::BlazingTable> table,
         bool specific_cache,
         std::string cache_id,
         std::vector<std::string> target_ids,
@@ -57,9 +77,9 @@ void distributing_kernel::send_message(std::unique_ptr<ral::frame::BlazingTable>
     metadata.add_value(ral::cache::WORKER_IDS_METADATA_LABEL, worker_ids_metadata);
     metadata.add_value(ral::cache::UNIQUE_MESSAGE_ID, std::to_string(unique_message_id.fetch_add(1)));
 
-    const std::string MESSAGE_ID_CONTENT = metadata.get_values()[ral::cache::QUERY_ID_METADATA_LABEL] + "_" +
-                                           metadata.get_values()[ral::cache::KERNEL_ID_METADATA_LABEL] + "_" +
-                                           metadata.get_values()[ral::cache::SENDER_WORKER_ID_METADATA_LABEL];
+    const std::string MESSAGE_ID_CONTENT = metadata.get_value(ral::cache::QUERY_ID_METADATA_LABEL) + "_" +
+                                           metadata.get_value(ral::cache::KERNEL_ID_METADATA_LABEL) + "_" +
+                                           metadata.get_value(ral::cache::SENDER_WORKER_ID_METADATA_LABEL);
 
     if (message_id_prefix!="") {
         metadata.add_value(
@@ -69,17 +89,17 @@ void distributing_kernel::send_message(std::unique_ptr<ral::frame::BlazingTable>
             ral::cache::MESSAGE_ID, MESSAGE_ID_CONTENT);
     }
 
-    for(auto meta_value : extra_metadata.get_values()) {
-        metadata.add_value(meta_value.first, meta_value.second);
-    }
+    metadata.add_values(extra_metadata);
 
     std::shared_ptr<ral::cache::CacheMachine> output_cache = query_graph->get_output_message_cache();
 
     bool added;
-    std::string message_id = metadata.get_values()[ral::cache::MESSAGE_ID];
+    std::string message_id = metadata.get_value(ral::cache::MESSAGE_ID);
     if(table==nullptr) {
         table = ral::utilities::create_empty_table({}, {});
-    } 
+    } else {
+        total_bytes_shuffled += table->sizeInBytes();
+    }
     
     added = output_cache->addToCache(std::move(table),"",always_add,metadata,true);
     
@@ -87,8 +107,8 @@ void distributing_kernel::send_message(std::unique_ptr<ral::frame::BlazingTable>
     if(wait_for) {
         std::lock_guard<std::mutex> lock(messages_to_wait_for_mutex);
         for (auto target_id : target_ids) {
-            const std::string message_id_to_wait_for = metadata.get_values()[ral::cache::QUERY_ID_METADATA_LABEL] + "_" +
-                                           metadata.get_values()[ral::cache::KERNEL_ID_METADATA_LABEL] + "_" +
+            const std::string message_id_to_wait_for = metadata.get_value(ral::cache::QUERY_ID_METADATA_LABEL) + "_" +
+                                           metadata.get_value(ral::cache::KERNEL_ID_METADATA_LABEL) + "_" +
                                            target_id;
             messages_to_wait_for[message_tracker_idx].push_back(message_id_prefix + message_id_to_wait_for);
         }
@@ -101,13 +121,17 @@ void distributing_kernel::send_message(std::unique_ptr<ral::frame::BlazingTable>
             }
         }
     }
+    return added;
 }
 
 int distributing_kernel::get_total_partition_counts(std::size_t message_tracker_idx) {
     int total_count = node_count[message_tracker_idx].at(node.id());
     for (auto message : messages_to_wait_for[message_tracker_idx]){
-        auto meta_message = query_graph->get_input_message_cache()->pullCacheData(message);
-        total_count += std::stoi(static_cast<ral::cache::CPUCacheData *>(meta_message.get())->getMetadata().get_values()[ral::cache::PARTITION_COUNT]);
+        auto meta_message = query_graph->get_input_message_cache()->pullCacheData(message, [this]{ return this->is_cancelled(); });
+        if (meta_message == nullptr) {
+            throw std::runtime_error("ERROR: the query was cancelled while waiting for the partition counts of the other nodes");
+        }
+        total_count += static_cast<ral::cache::CPUCacheData *>(meta_message.get())->getMetadata().get_partition_count();
     }
     return total_count;
 }
@@ -118,6 +142,9 @@ void distributing_kernel::send_total_partition_counts(
         std::size_t message_tracker_idx) {
     auto nodes = context->getAllNodes();
 
+    // the counts have to include the partitions that are still waiting to be sent
+    flush_pending_messages(message_tracker_idx, false);
+
     message_id_prefix = "tableidx" + std::to_string(message_tracker_idx) + "_" + message_id_prefix;
 
     for(std::size_t i = 0; i < nodes.size(); ++i) {
@@ -145,21 +172,54 @@ void distributing_kernel::broadcast(std::unique_ptr<ral::frame::BlazingTable> ta
         std::size_t message_tracker_idx,
         bool always_add) {
 
+    if (checkpoint) {
+        checkpoint->invalidate();
+    }
+
     int self_node_idx = context->getNodeIndex(node);
     auto nodes_to_send = context->getAllOtherNodes(self_node_idx);
     std::vector<std::string> target_ids;
     for (auto & node : nodes_to_send)	{
         target_ids.push_back(node.id());
     }
-    send_message(table->toBlazingTableView().clone(),
-        true, //specific_cache
-        cache_id, //cache_id
-        target_ids, //target_ids
-        message_id_prefix, //message_id_prefix
-        always_add, //always_add
-        false, //wait_for
-        message_tracker_idx //message_tracker_idx
-    );
+
+    if (tree_broadcast && target_ids.size() > 1) {
+        // every node sends the table to a few others and those forward it, so that no node sends it to all of them
+        auto groups = ral::distribution::group_broadcast_targets(target_ids, node.id(),
+            ral::communication::CommunicationData::getInstance().get_worker_hosts());
+        for (auto & child : ral::distribution::get_broadcast_children(groups)) {
+            ral::cache::MetadataDictionary extra_metadata;
+            extra_metadata.add_value(ral::cache::BROADCAST_SUBTREE_METADATA_LABEL, ral::distribution::serialize_broadcast_groups(child.subtree));
+            bool added = send_message(table->toBlazingTableView().clone(),
+                true, //specific_cache
+                cache_id, //cache_id
+                {child.worker_id}, //target_ids
+                message_id_prefix, //message_id_prefix
+                always_add, //always_add
+                false, //wait_for
+                message_tracker_idx, //message_tracker_idx
+                extra_metadata);
+
+            // the nodes in the subtree of the child get the table from it, but they still have to wait for it
+            if (added) {
+                for (auto & group : child.subtree) {
+                    for (auto & target_id : group) {
+                        node_count[message_tracker_idx].at(target_id)++;
+                    }
+                }
+            }
+        }
+    } else {
+        send_message(table->toBlazingTableView().clone(),
+            true, //specific_cache
+            cache_id, //cache_id
+            target_ids, //target_ids
+            message_id_prefix, //message_id_prefix
+            always_add, //always_add
+            false, //wait_for
+            message_tracker_idx //message_tracker_idx
+        );
+    }
 
     // now lets add to the self node
     bool added = output->addToCache(std::move(table), message_id_prefix, always_add);
@@ -173,19 +233,31 @@ void distributing_kernel::scatter(std::vector<ral::frame::BlazingTableView> part
         ral::cache::CacheMachine* output,
         std::string message_id_prefix,
         std::string cache_id,
-        std::size_t message_tracker_idx) {
+        std::size_t message_tracker_idx,
+        const ral::cache::MetadataDictionary & extra_metadata) {
     auto nodes = context->getAllNodes();
     assert(nodes.size() == partitions.size());
 
+    // output is the output cache cache_id of the kernel, the same one the partitions go to in the other nodes
+    if (checkpoint) {
+        for(std::size_t i = 0; i < nodes.size(); ++i) {
+            checkpoint->write_partition(partitions[i], i, cache_id, message_id_prefix, extra_metadata.get_values());
+        }
+    }
+
     for(std::size_t i = 0; i < nodes.size(); ++i) {
         if (nodes[i] == node) {
             // hash_partition followed by split does not create a partition that we can own, so we need to clone it.
             // if we dont clone it, hashed_data will go out of scope before we get to use the partition
             // also we need a BlazingTable to put into the cache, we cant cache views.
-            bool added = output->addToCache(std::move(partitions[i].clone()), message_id_prefix, false);
+            bool added = output->addToCache(std::move(partitions[i].clone()), message_id_prefix, false, extra_metadata);
             if (added) {
                 node_count[message_tracker_idx].at(node.id())++;
             }
+        } else if (coalesce_bytes_threshold > 0) {
+            if (partitions[i].num_rows() > 0) {
+                coalesce_message(partitions[i].clone(), nodes[i].id(), cache_id, message_id_prefix, message_tracker_idx, extra_metadata);
+            }
         } else {
             send_message(std::move(partitions[i].clone()),
                 true, //specific_cache
@@ -194,10 +266,135 @@ void distributing_kernel::scatter(std::vector<ral::frame::BlazingTableView> part
                 message_id_prefix, //message_id_prefix
                 false, //always_add
                 false, //wait_for
-                message_tracker_idx //message_tracker_idx
+                message_tracker_idx, //message_tracker_idx
+                extra_metadata //extra_metadata
             );
         }
     }
+
+    if (coalesce_bytes_threshold > 0) {
+        flush_pending_messages(message_tracker_idx, true);
+    }
+}
+
+void distributing_kernel::scatter_hash_partitions(const ral::frame::BlazingTableView & table,
+        const std::vector<cudf::size_type> & columns_to_hash,
+        ral::cache::CacheMachine* output,
+        std::string cache_id,
+        std::size_t message_tracker_idx,
+        cudf::size_type num_columns_to_send) {
+    std::size_t num_nodes = context->getTotalNodes();
+    std::size_t num_partitions = num_nodes * hash_partitions_per_node;
+
+    std::vector<cudf::table_view> partitioned;
+    std::unique_ptr<cudf::table> hashed_data; // Keep table alive in this scope
+    if (table.num_rows() > 0) {
+        std::vector<cudf::size_type> hashed_data_offsets;
+        std::tie(hashed_data, hashed_data_offsets) = cudf::hash_partition(table.view(), columns_to_hash, num_partitions);
+        // the offsets returned by hash_partition will always start at 0, which is a value we want to ignore for cudf::split
+        std::vector<cudf::size_type> split_indexes(hashed_data_offsets.begin() + 1, hashed_data_offsets.end());
+        partitioned = cudf::split(hashed_data->view(), split_indexes);
+    } else {
+        // an empty table is only scattered once
+        partitioned.assign(num_nodes, table.view());
+    }
+    std::vector<std::string> names = table.names();
+    if (num_columns_to_send >= 0) {
+        std::vector<cudf::size_type> columns_to_send(num_columns_to_send);
+        std::iota(columns_to_send.begin(), columns_to_send.end(), 0);
+        for (auto & partition : partitioned) {
+            partition = partition.select(columns_to_send);
+        }
+        names.resize(num_columns_to_send);
+    }
+
+    // the partition p goes to the node p % num_nodes, the same node that it would go to with one partition per node
+    for (std::size_t m = 0; m * num_nodes < partitioned.size(); m++) {
+        std::vector<ral::frame::BlazingTableView> partitions;
+        for (std::size_t i = 0; i < num_nodes; i++) {
+            partitions.push_back(ral::frame::BlazingTableView(partitioned[m * num_nodes + i], names));
+        }
+        if (hash_partitions_per_node == 1) {
+            scatter(partitions, output, "", cache_id, message_tracker_idx);
+        } else {
+            ral::cache::MetadataDictionary extra_metadata;
+            extra_metadata.add_value(ral::cache::HASH_PARTITION_METADATA_LABEL, std::to_string(m));
+            // with its own prefix every index is coalesced into its own messages
+            scatter(partitions, output, "hash_partition_" + std::to_string(m) + "_", cache_id, message_tracker_idx, extra_metadata);
+        }
+    }
+}
+
+void distributing_kernel::coalesce_message(std::unique_ptr<ral::frame::BlazingTable> table,
+        const std::string & target_id,
+        const std::string & cache_id,
+        const std::string & message_id_prefix,
+        std::size_t message_tracker_idx,
+        const ral::cache::MetadataDictionary & extra_metadata) {
+    pending_message_key key{message_tracker_idx, target_id, cache_id, message_id_prefix};
+    pending_message message_to_send;
+    {
+        std::lock_guard<std::mutex> lock(pending_messages_mutex);
+        auto & pending = pending_messages[key];
+        if (pending.tables.empty()) {
+            pending.first_added = std::chrono::steady_clock::now();
+            pending.extra_metadata = extra_metadata;
+        }
+        pending.num_bytes += table->sizeInBytes();
+        pending.tables.push_back(std::move(table));
+        if (pending.num_bytes < coalesce_bytes_threshold) {
+            return;
+        }
+        message_to_send = std::move(pending);
+        pending_messages.erase(key);
+    }
+    send_pending_message(key, std::move(message_to_send));
+}
+
+void distributing_kernel::flush_pending_messages(std::size_t message_tracker_idx, bool only_expired) {
+    std::vector<std::pair<pending_message_key, pending_message>> messages_to_send;
+    {
+        std::lock_guard<std::mutex> lock(pending_messages_mutex);
+        auto now = std::chrono::steady_clock::now();
+        for (auto it = pending_messages.begin(); it != pending_messages.end();) {
+            bool expired = now - it->second.first_added >= std::chrono::milliseconds(coalesce_timeout_ms);
+            if (std::get<0>(it->first) == message_tracker_idx && (expired || !only_expired)) {
+                messages_to_send.emplace_back(it->first, std::move(it->second));
+                it = pending_messages.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    for (auto & message : messages_to_send) {
+        send_pending_message(message.first, std::move(message.second));
+    }
+}
+
+void distributing_kernel::send_pending_message(const pending_message_key & key, pending_message message) {
+    std::size_t message_tracker_idx;
+    std::string target_id, cache_id, message_id_prefix;
+    std::tie(message_tracker_idx, target_id, cache_id, message_id_prefix) = key;
+
+    // the tables are sent in as few messages as the strings length lets them be concatenated into
+    std::vector<std::unique_ptr<ral::frame::BlazingTable>> tables_to_send;
+    if (message.tables.size() > 1) {
+        tables_to_send = ral::utilities::concatTablesInBatches(message.tables);
+    } else {
+        tables_to_send = std::move(message.tables);
+    }
+    for (auto & table : tables_to_send) {
+        send_message(std::move(table),
+            true, //specific_cache
+            cache_id, //cache_id
+            {target_id}, //target_id
+            message_id_prefix, //message_id_prefix
+            false, //always_add
+            false, //wait_for
+            message_tracker_idx, //message_tracker_idx
+            message.extra_metadata //extra_metadata
+        );
+    }
 }
 
 void distributing_kernel::scatterParts(std::vector<ral::distribution::NodeColumnView> partitions,
@@ -206,6 +403,10 @@ void distributing_kernel::scatterParts(std::vector<ral::distribution::NodeColumn
 
     assert(part_ids.size() == partitions.size());
 
+    if (checkpoint) {
+        checkpoint->invalidate();
+    }
+
     for (std::size_t i = 0; i < partitions.size(); i++) {
         blazingdb::transport::Node dest_node;
         ral::frame::BlazingTableView table_view;
@@ -238,8 +439,49 @@ void distributing_kernel::scatterParts(std::vector<ral::distribution::NodeColumn
 }
 
 void distributing_kernel::increment_node_count(std::string node_id, std::size_t message_tracker_idx) {
+    // only the kernels that keep some batches in their node, instead of scattering them, count them by themselves
+    if (checkpoint) {
+        checkpoint->invalidate();
+    }
     node_count[message_tracker_idx].at(node_id)++;
 }
 
+void distributing_kernel::commit_checkpoint() {
+    if (checkpoint && !is_cancelled()) {
+        checkpoint->commit();
+    }
+}
+
+bool distributing_kernel::has_checkpoint() const {
+    return checkpoint != nullptr;
+}
+
+void distributing_kernel::set_checkpoint_fingerprint(const std::string & fingerprint) {
+    if (checkpoint) {
+        checkpoint->set_fingerprint(fingerprint);
+    }
+}
+
+bool distributing_kernel::can_restore_checkpoint() {
+    return checkpoint && checkpoint->can_restore();
+}
+
+kstatus distributing_kernel::restore_checkpoint() {
+    checkpoint->restore([this](std::unique_ptr<ral::frame::BlazingTable> table, const ral::distribution::checkpoint_partition & partition) {
+        ral::cache::MetadataDictionary extra_metadata;
+        for (const auto & value : partition.metadata) {
+            extra_metadata.add_value(value.first, value.second);
+        }
+        this->output_cache(partition.cache_id)->addToCache(std::move(table), partition.message_id_prefix, false, extra_metadata);
+    });
+
+    for (auto & input : this->input_.cache_machines_) {
+        while (input.second->wait_for_next()) {
+            input.second->pullCacheData();
+        }
+    }
+    return kstatus::proceed;
+}
+
 }  // namespace cache
 }  // namespace ral
@@ -1,9 +1,13 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
 #include <map>
+#include <tuple>
 #include <vector>
 #include "distribution_utils/primitives.h"
+#include "distribution_utils/broadcast_tree.h"
+#include "distribution_utils/shuffle_checkpoint.h"
 #include "cache_machine/CacheMachine.h"
 #include <execution_graph/Context.h>
 #include "kernel.h"
@@ -53,8 +57,9 @@ class distributing_kernel : public kernel {
      * @param wait_for Indicates if this message must be registered to wait for back.
      * @param message_tracker_idx The message tracker index.
      * @param extra_metadata The cache identifier.
+     * @return If the table was added to the output message cache, to be sent.
      */
-    void send_message(std::unique_ptr<ral::frame::BlazingTable> table,
+    bool send_message(std::unique_ptr<ral::frame::BlazingTable> table,
         bool specific_cache,
         std::string cache_id,
         std::vector<std::string> target_ids,
@@ -73,12 +78,41 @@ class distributing_kernel : public kernel {
      * @param message_id_prefix The prefix of the identifier of this message.
      * @param cache_id Indicates what cache a message should be routed to.
      * @param message_tracker_idx The message tracker index.
+     * @param extra_metadata The metadata that every partition gets, also the one of this node.
      */
     void scatter(std::vector<ral::frame::BlazingTableView> partitions,
         ral::cache::CacheMachine* output,
         std::string message_id_prefix,
         std::string cache_id,
-        std::size_t message_tracker_idx = 0);
+        std::size_t message_tracker_idx = 0,
+        const ral::cache::MetadataDictionary & extra_metadata = {});
+
+    /**
+     * @brief Hash partitions a table by some of its columns and scatters the partitions, hash_partitions_per_node of
+     * them to every node.
+     * With more than one partition per node, the partition index m of every node is in the
+     * HASH_PARTITION_METADATA_LABEL of its partition, and the kernel that receives them can work on each index on its
+     * own, since the rows with the same hashed columns always get the same index.
+     *
+     * @param table The table to be partitioned.
+     * @param columns_to_hash The columns the rows are hashed by.
+     * @param output The output cache.
+     * @param cache_id Indicates what cache a message should be routed to.
+     * @param message_tracker_idx The message tracker index.
+     * @param num_columns_to_send Only the first columns of the partitions are sent, so that the columns that were only
+     * added to hash the rows by are not. -1 sends all of them.
+     */
+    void scatter_hash_partitions(const ral::frame::BlazingTableView & table,
+        const std::vector<cudf::size_type> & columns_to_hash,
+        ral::cache::CacheMachine* output,
+        std::string cache_id,
+        std::size_t message_tracker_idx = 0,
+        cudf::size_type num_columns_to_send = -1);
+
+    /**
+     * @brief The hash partitions that scatter_hash_partitions sends to every node, HASH_PARTITIONS_PER_NODE or 1.
+     */
+    std::size_t get_hash_partitions_per_node() const { return hash_partitions_per_node; }
 
     /**
      * @brief Sends each partition to its corresponding nodes and corresponding part_id
@@ -94,6 +128,8 @@ class distributing_kernel : public kernel {
 
     /**
      * @brief Sends same table to all other nodes.
+     * With tree broadcasts the table is only sent to a few nodes, which forward it to the rest, see
+     * ral::distribution::get_broadcast_children. Otherwise it is sent to every node.
      *
      * @param table The table to be broadcast
      * @param output The output cache.
@@ -145,16 +181,92 @@ class distributing_kernel : public kernel {
      */
     void increment_node_count(std::string node_id, std::size_t message_tracker_idx = 0);
 
+    /**
+     * @brief Writes the manifest of the shuffle checkpoint of the kernel once it finished, with
+     * SHUFFLE_CHECKPOINT_PATH, see ral::distribution::shuffle_checkpoint.
+     */
+    void commit_checkpoint();
+
+    /**
+     * @return true if the kernel keeps a shuffle checkpoint, with SHUFFLE_CHECKPOINT_PATH.
+     */
+    bool has_checkpoint() const;
+
+    /**
+     * @brief Sets the fingerprint of the plan and the inputs of the query in the shuffle checkpoint of the kernel, see
+     * ral::distribution::make_checkpoint_fingerprint. It does nothing without SHUFFLE_CHECKPOINT_PATH.
+     */
+    void set_checkpoint_fingerprint(const std::string & fingerprint);
+
+    /**
+     * @return true if all the nodes finished the kernel in an earlier attempt of the query, and the plan and the inputs
+     * of this node did not change, so that its output can be restored from the shuffle checkpoint instead of running it.
+     */
+    bool can_restore_checkpoint();
+
+    /**
+     * @brief Runs the kernel from its shuffle checkpoint: the partitions that were sent to this node are added to the
+     * output caches they were sent to, and the input, if the kernels before it still ran, is dropped.
+     * can_restore_checkpoint has to be true.
+     */
+    kstatus restore_checkpoint();
+
     /**
      * Destructor
      */
     virtual ~distributing_kernel() = default;
 
     private:
+        /**
+         * @brief Adds a partition to the pending message for its destination, and sends the pending message
+         * once it is big enough. It also sends the pending messages that waited for too long.
+         *
+         * @param table The partition to be sent.
+         * @param target_id The worker that will be receiving it.
+         * @param cache_id Indicates what cache the message should be routed to.
+         * @param message_id_prefix The prefix of the identifier of the message.
+         * @param message_tracker_idx The message tracker index.
+         * @param extra_metadata The metadata of the message, the same for all the partitions with the same prefix.
+         */
+        void coalesce_message(std::unique_ptr<ral::frame::BlazingTable> table,
+            const std::string & target_id,
+            const std::string & cache_id,
+            const std::string & message_id_prefix,
+            std::size_t message_tracker_idx,
+            const ral::cache::MetadataDictionary & extra_metadata);
+
+        /**
+         * @brief Sends the pending messages of a message tracker.
+         *
+         * @param message_tracker_idx The message tracker index.
+         * @param only_expired Only sends the messages whose first partition was added more than coalesce_timeout_ms ago.
+         */
+        void flush_pending_messages(std::size_t message_tracker_idx, bool only_expired);
+
+        /**
+         * The partitions going to the same cache of the same node are sent together, so that there are fewer small messages.
+         */
+        struct pending_message {
+            std::vector<std::unique_ptr<ral::frame::BlazingTable>> tables;
+            std::size_t num_bytes = 0;
+            std::chrono::steady_clock::time_point first_added;
+            ral::cache::MetadataDictionary extra_metadata;
+        };
+        using pending_message_key = std::tuple<std::size_t, std::string, std::string, std::string>; /**< message tracker index, target id, cache id and message id prefix */
+
+        void send_pending_message(const pending_message_key & key, pending_message message);
+
         const blazingdb::transport::Node& node; /**< Stores the reference of the current node. */
         std::vector<std::map<std::string, std::atomic<size_t>>> node_count; /**< Vector of maps that stores the message count associated to a node. Each vector corresponds to a message tracker. It's thread-safe. */
         std::vector<std::vector<std::string>> messages_to_wait_for; /**< Vector of vectors of the messages registered to wait for. Each vector corresponds to a message tracker. It's thread-safe. */
         std::mutex messages_to_wait_for_mutex;
+        std::map<pending_message_key, pending_message> pending_messages;
+        std::mutex pending_messages_mutex;
+        std::size_t coalesce_bytes_threshold = 0; /**< A pending message is sent once it has this many bytes. 0 means that the partitions are sent right away. */
+        bool tree_broadcast = true; /**< If broadcast sends the table down a tree of nodes instead of to every node */
+        std::size_t hash_partitions_per_node = 1; /**< The partitions that scatter_hash_partitions sends to every node. */
+        int coalesce_timeout_ms = 100; /**< A pending message is sent, at the latest, with the first partition scattered after it waited this long. */
+        std::unique_ptr<ral::distribution::shuffle_checkpoint> checkpoint; /**< The partitions scattered, with SHUFFLE_CHECKPOINT_PATH. */
 };
 
 }  // namespace cache
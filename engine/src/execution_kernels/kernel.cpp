@@ -1,6 +1,8 @@
 #include "kernel.h"
+#include <limits>
 #include "utilities/CodeTimer.h"
 #include "communication/CommunicationData.h"
+#include "execution_graph/executor.h"
 
 namespace ral {
 namespace cache {
@@ -17,6 +19,14 @@ kernel::kernel(std::size_t kernel_id, std::string expr, std::shared_ptr<Context>
           limit_rows_(-1),
           logger(spdlog::get("batch_logger")) {
 
+    if (this->context) {
+        const blazingdb::manager::QueryConfig & config = this->context->getConfig();
+        query_priority = config.query_priority.value_or(query_priority);
+        resource_group_name = config.resource_group.value_or(resource_group_name);
+        resource_group_memory_fraction = config.resource_group_memory_fraction.value_or(resource_group_memory_fraction);
+        resource_group_threads = config.resource_group_executor_threads.value_or(resource_group_threads);
+    }
+
     std::shared_ptr<spdlog::logger> kernels_logger = spdlog::get("kernels_logger");
     if(kernels_logger) {
         kernels_logger->info("{ral_id}|{query_id}|{kernel_id}|{is_kernel}|{kernel_type}|{description}",
@@ -87,11 +97,16 @@ ral::execution::task_result kernel::process(std::vector<std::unique_ptr<ral::fra
         bytes += input->sizeInBytes();
         rows += input->num_rows();
     }
+    CodeTimer timer;
     auto result = do_process(std::move(inputs), output, stream, args);
+    total_task_time_us += timer.elapsed_time<std::chrono::microseconds>();
     if(result.status == ral::execution::SUCCESS){
          // increment these AFTER its been processed successfully
         total_input_bytes_processed += bytes;
         total_input_rows_processed += rows;
+        if (this->query_graph != nullptr) {
+            this->query_graph->notify_runtime_stats();
+        }
     } else {
         auto logger = spdlog::get("batch_logger");
         if (logger) {
@@ -102,6 +117,109 @@ ral::execution::task_result kernel::process(std::vector<std::unique_ptr<ral::fra
     return std::move(result);
 }
 
+kernel_stats kernel::get_stats() {
+    kernel_stats stats;
+    stats.kernel_id = this->kernel_id;
+    stats.kernel_name = this->kernel_name();
+    stats.wall_time_us = run_time_us;
+    stats.task_time_us = total_task_time_us;
+    stats.input_rows = total_input_rows_processed;
+    stats.input_bytes = total_input_bytes_processed;
+    stats.output_rows = this->output_.total_rows_added();
+    stats.output_bytes = this->output_.total_bytes_added();
+    stats.output_batches = this->output_.total_batches_added();
+    stats.spill_bytes = this->output_.total_bytes_spilled();
+    stats.retries = total_task_retries;
+    stats.shuffle_bytes = total_bytes_shuffled;
+    stats.finished = this->output_.all_finished();
+    return stats;
+}
+
+void kernel::wait_for_output_cache_to_drain() {
+    if (!flow_control_enabled || this->stop_requested()) {
+        return;
+    }
+    if (flow_control_bytes_threshold == 0) {
+        if (this->context) {
+            const blazingdb::manager::QueryConfig & config = this->context->getConfig();
+            flow_control_bytes_threshold = config.flow_control_bytes_threshold.value_or(flow_control_bytes_threshold);
+            flow_control_max_wait_ms = config.flow_control_max_wait_ms.value_or(flow_control_max_wait_ms);
+        }
+        if (flow_control_bytes_threshold == 0) {
+            std::size_t num_kernels = this->query_graph ? std::max(this->query_graph->num_nodes(), (size_t)1) : 1;
+            flow_control_bytes_threshold = std::max(ral::execution::executor::get_instance()->get_processing_memory_limit() / num_kernels, (size_t)1);
+        }
+        if (flow_control_bytes_threshold == std::numeric_limits<std::size_t>::max()) {
+            flow_control_enabled = false;
+            return;
+        }
+    }
+
+    CodeTimer timer;
+    // request_stop wakes it up, so a kernel whose output is not needed anymore does not wait for it to be drained
+    if (!this->output_cache()->wait_until_num_bytes_below(flow_control_bytes_threshold, flow_control_max_wait_ms,
+            [this] { return this->stop_requested(); })) {
+        flow_control_enabled = false;
+        if (logger) {
+            logger->warn("{query_id}|{step}|{substep}|{info}|{duration}|kernel_id|{kernel_id}||",
+                        "query_id"_a=context->getContextToken(),
+                        "step"_a=context->getQueryStep(),
+                        "substep"_a=context->getQuerySubstep(),
+                        "info"_a="Output cache was not drained below " + std::to_string(flow_control_bytes_threshold) + " bytes, turning off flow control for " + this->kernel_name(),
+                        "duration"_a=timer.elapsed_time(),
+                        "kernel_id"_a=this->get_id());
+        }
+    }
+}
+
+void kernel::add_runtime_filter(std::shared_ptr<ral::operators::runtime_filter> filter) {
+    std::lock_guard<std::mutex> lock(runtime_filters_mutex);
+    this->runtime_filters.push_back(filter);
+}
+
+std::vector<std::shared_ptr<ral::operators::runtime_filter>> kernel::get_runtime_filters() {
+    std::lock_guard<std::mutex> lock(runtime_filters_mutex);
+    return this->runtime_filters;
+}
+
+void kernel::apply_runtime_filters(std::unique_ptr<ral::frame::BlazingTable> & table) {
+    for (auto & filter : this->get_runtime_filters()) {
+        std::unique_ptr<ral::frame::BlazingTable> filtered = filter->apply(table->toBlazingTableView());
+        if (filtered != nullptr) {
+            table = std::move(filtered);
+        }
+    }
+}
+
+void kernel::request_stop() {
+    if (this->stop_was_requested.exchange(true)) {
+        return;
+    }
+    for (auto & cache : this->output_.cache_machines_) {
+        if (cache.second) {
+            cache.second->notify_waiters(); // for wait_for_output_cache_to_drain
+        }
+    }
+    if (!this->query_graph) {
+        return;
+    }
+    for (auto & edge : this->query_graph->get_reverse_neighbours(this->get_id())) {
+        kernel * producer = this->query_graph->get_node(edge.source);
+        if (producer) {
+            producer->request_stop();
+        }
+    }
+}
+
+void kernel::cancel() {
+    this->cancelled = true;
+    this->stop_was_requested = true;
+    this->input_.clear();
+    this->output_.clear();
+    std::lock_guard<std::mutex> lock(kernel_mutex);
+    kernel_cv.notify_all();
+}
+
 void kernel::add_task(size_t task_id){
     std::lock_guard<std::mutex> lock(kernel_mutex);
     this->tasks.insert(task_id);
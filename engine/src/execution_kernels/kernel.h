@@ -1,8 +1,11 @@
 #pragma once
 
 #include "kernel_type.h"
+#include "kernel_throughput.h"
 #include "execution_graph/port.h"
 #include "execution_graph/graph.h"
+#include "execution_graph/kernel_run_pool.h"
+#include "operators/RuntimeFilter.h"
 
 namespace ral {
 namespace execution{
@@ -202,12 +205,22 @@ public:
 			return {ral::execution::task_status::SUCCESS, std::string(), std::vector< std::unique_ptr<ral::frame::BlazingTable> > ()};
 	}
 
+	/**
+	* @brief Decaches an input of a task right before the task runs.
+	* Kernels that only use some of the columns of their inputs can override this to decache only those columns,
+	* so that the other columns of a CacheData in CPU memory or on disk are never brought back into the GPU.
+	* @param input the CacheData to decache.
+	*/
+	virtual std::unique_ptr<ral::frame::BlazingTable> decache_input(ral::cache::CacheData & input) {
+		return input.decache();
+	}
+
 	/**
 	* @brief given the inputs, estimates the number of bytes that will be necessary for holding the output after performing a transformation. For many kernels this is not an estimate but rather a certainty. For operations whose outputs are of indeterminate size it provides an estimate.
 	* @param inputs the data that would be transformed
 	* @returns the number of bytes that we expect to be needed to hold the output after performing this kernels transformations on the given inputs.
 	*/
-	std::size_t estimate_output_bytes(const std::vector<std::unique_ptr<ral::cache::CacheData > > & inputs);
+	virtual std::size_t estimate_output_bytes(const std::vector<std::unique_ptr<ral::cache::CacheData > > & inputs);
 
 	/**
 	* @brief given the inputs, estimates the number of bytes that will be necessary for performing the transformation. This can be thought of as the memory overhead of the actual transformations being performed. For many kernels this is not an estimate but rather a certainty. For operations that perform indeterminately sized allocations based on the contents of inputs it provides an estimate.
@@ -236,12 +249,131 @@ public:
 	bool finished_tasks(){
 		return tasks.empty();
 	}
+
+	/**
+	* @brief Sets how far this kernel is from the end of the execution graph. Used to prioritize its tasks.
+	*/
+	void set_priority_level(std::size_t level) { priority_level = level; }
+
+	/**
+	* @brief Returns how far this kernel is from the end of the execution graph. Kernels closer to the OutputKernel have smaller values.
+	*/
+	std::size_t get_priority_level() const { return priority_level; }
+
+	/**
+	* @brief Returns the priority of the query this kernel belongs to (QUERY_PRIORITY). Smaller values are more urgent.
+	*/
+	std::size_t get_query_priority() const { return query_priority; }
+
+	/**
+	* @brief Returns the resource group of the query this kernel belongs to (RESOURCE_GROUP). Empty if the query has no group.
+	*/
+	const std::string & get_resource_group_name() const { return resource_group_name; }
+
+	/**
+	* @brief Returns the fraction of the executor memory limit that the resource group of this kernel can use (RESOURCE_GROUP_MEMORY_FRACTION).
+	*/
+	double get_resource_group_memory_fraction() const { return resource_group_memory_fraction; }
+
+	/**
+	* @brief Returns the number of executor threads that the resource group of this kernel can use (RESOURCE_GROUP_EXECUTOR_THREADS). 0 means all of them.
+	*/
+	int get_resource_group_threads() const { return resource_group_threads; }
+
+	/**
+	* @brief Returns the model of how long the tasks of this kernel take depending on the size of their inputs.
+	*/
+	std::shared_ptr<kernel_throughput> get_throughput() const { return throughput; }
+
+	/**
+	* @brief Flow control for the kernels that produce data faster than it can be consumed, like the scans.
+	* It waits while the output cache holds more bytes than its high water mark, so that the kernel does not create more tasks until
+	* the consumers drain the cache. The high water mark is FLOW_CONTROL_BYTES_THRESHOLD or, when it is 0, the processing memory limit
+	* of the executor divided among the kernels of the query.
+	* If the cache is not drained within FLOW_CONTROL_MAX_WAIT_MS, the consumer is probably waiting for something else and the flow control is turned off for this kernel.
+	* It returns right away once request_stop was called, so the callers have to check stop_requested after it.
+	*/
+	void wait_for_output_cache_to_drain();
+
+	/**
+	* @brief Adds a filter of the keys of a join that consumes the output of this kernel. The kernels that support it, like the scans,
+	* drop the rows that the join would drop anyway. It can be added while the kernel is running, and only applies from then on.
+	*/
+	void add_runtime_filter(std::shared_ptr<ral::operators::runtime_filter> filter);
+
+	/**
+	* @brief Tells this kernel and all the kernels it consumes from, directly or not, that no more of their output is needed,
+	* as when a LimitKernel already has all of its rows. The kernels that support it, like the scans, the filters and the projections,
+	* stop creating tasks and the ones that were created still finish. It must only be used when no other node waits for their output.
+	*/
+	virtual void request_stop();
+
+	/**
+	* @brief Returns true if no more of the output of this kernel is needed, see request_stop.
+	*/
+	bool stop_requested() const { return stop_was_requested; }
+
+	/**
+	* @brief Cancels the work of this kernel, as part of graph::cancel. It stops creating tasks, its queued tasks are
+	* dropped by the executor instead of run, and its input and output caches are finished and emptied, so that its
+	* run() loop and the ones of its consumers see no more data.
+	*/
+	void cancel();
+
+	/**
+	* @brief Returns true if the query of this kernel was cancelled, see cancel.
+	*/
+	bool is_cancelled() const { return cancelled; }
+
+	/**
+	* @brief Returns what this kernel did so far, see graph::get_kernel_stats. The ids of its inputs are filled by the graph.
+	*/
+	kernel_stats get_stats();
+
+	/**
+	* @brief Records how long the run() loop of this kernel took, from when it started until it finished.
+	*/
+	void record_run_time(uint64_t elapsed_us) { run_time_us = elapsed_us; }
+
+	/**
+	* @brief Counts a task of this kernel that failed and was queued again, like the ones that ran out of memory.
+	*/
+	void notify_retry() { total_task_retries++; }
+
 protected:
+	/**
+	* @brief Returns the runtime filters that were added to this kernel so far.
+	*/
+	std::vector<std::shared_ptr<ral::operators::runtime_filter>> get_runtime_filters();
+
+	/**
+	* @brief Replaces a table with the rows that pass all the runtime filters of this kernel.
+	* If one of them fails the table keeps the rows of the ones that passed, so that the task can be retried with it.
+	*/
+	void apply_runtime_filters(std::unique_ptr<ral::frame::BlazingTable> & table);
+
 	std::set<size_t> tasks;
 	std::mutex kernel_mutex;
-	std::condition_variable kernel_cv;
+	ral::execution::blocking_condition_variable kernel_cv; // its waits let the kernel_run_pool run another kernel
 	std::atomic<std::size_t> total_input_bytes_processed;
 	std::atomic<std::size_t> total_input_rows_processed;
+	std::atomic<uint64_t> total_task_time_us{0}; /**< Spent in do_process by the tasks of this kernel. */
+	std::atomic<uint64_t> total_task_retries{0};
+	std::atomic<uint64_t> total_bytes_shuffled{0}; /**< Sent to the other nodes. */
+	std::atomic<uint64_t> run_time_us{0};
+	std::size_t priority_level = 0; /**< Distance to the OutputKernel in the execution graph. */
+	std::size_t query_priority = 0; /**< Priority of the query, set by the QUERY_PRIORITY config option. */
+	std::string resource_group_name; /**< Resource group of the query, set by the RESOURCE_GROUP config option. */
+	double resource_group_memory_fraction = 1.0; /**< Set by the RESOURCE_GROUP_MEMORY_FRACTION config option. */
+	int resource_group_threads = 0; /**< Set by the RESOURCE_GROUP_EXECUTOR_THREADS config option. */
+	std::shared_ptr<kernel_throughput> throughput = std::make_shared<kernel_throughput>(); /**< Updated every time a task of this kernel finishes. */
+	std::size_t flow_control_bytes_threshold = 0; /**< High water mark of the output cache, computed the first time it is needed. */
+	int flow_control_max_wait_ms = 5000;
+	bool flow_control_enabled = true;
+	std::mutex runtime_filters_mutex;
+	std::vector<std::shared_ptr<ral::operators::runtime_filter>> runtime_filters;
+	std::atomic<bool> stop_was_requested{false};
+	std::atomic<bool> cancelled{false};
 	
 
 public:
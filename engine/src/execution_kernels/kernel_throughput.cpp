@@ -0,0 +1,46 @@
+#include "kernel_throughput.h"
+
+namespace ral {
+namespace cache {
+
+kernel_throughput::kernel_throughput(double overhead_fraction, std::size_t min_samples, double decay) :
+	overhead_fraction(overhead_fraction), min_samples(min_samples), decay(decay) {}
+
+void kernel_throughput::record(std::size_t input_bytes, double duration) {
+	double bytes = (double)input_bytes;
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	sum_weights = decay * sum_weights + 1;
+	sum_bytes = decay * sum_bytes + bytes;
+	sum_durations = decay * sum_durations + duration;
+	sum_bytes_squared = decay * sum_bytes_squared + bytes * bytes;
+	sum_bytes_durations = decay * sum_bytes_durations + bytes * duration;
+	num_samples++;
+}
+
+std::pair<bool, std::size_t> kernel_throughput::get_target_batch_bytes() {
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (num_samples < min_samples) {
+		return std::make_pair(false, 0);
+	}
+
+	double mean_bytes = sum_bytes / sum_weights;
+	double mean_durations = sum_durations / sum_weights;
+	double variance_bytes = sum_bytes_squared / sum_weights - mean_bytes * mean_bytes;
+	if (variance_bytes <= 0) {
+		// all the batches had the same size, so we can not tell the overhead from the cost per byte
+		return std::make_pair(false, 0);
+	}
+	double cost_per_byte = (sum_bytes_durations / sum_weights - mean_bytes * mean_durations) / variance_bytes;
+	double overhead = mean_durations - cost_per_byte * mean_bytes;
+	if (cost_per_byte <= 0 || overhead <= 0) {
+		return std::make_pair(false, 0);
+	}
+
+	// overhead / (overhead + cost_per_byte * bytes) = overhead_fraction
+	double target = overhead * (1 - overhead_fraction) / (overhead_fraction * cost_per_byte);
+	return std::make_pair(true, (std::size_t)target);
+}
+
+}  // namespace cache
+}  // namespace ral
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <utility>
+
+namespace ral {
+namespace cache {
+
+/**
+* Tracks how long the tasks of a kernel take depending on the size of their inputs.
+* It fits the duration of the tasks as a fixed overhead plus a cost per byte, giving more weight to the most recent tasks.
+* With that, it can suggest how big the batches of a kernel need to be so that the fixed overhead (kernel launches,
+* allocations, etc) is only a small part of the time of every task. Caches that feed the kernel use the suggestion to
+* decide how much data to concatenate.
+*/
+class kernel_throughput {
+public:
+	/**
+	* Constructor
+	* @param overhead_fraction the fraction of the time of a task that we want the fixed overhead to be.
+	* @param min_samples the number of tasks that need to be recorded before making suggestions.
+	* @param decay the weight that the previous tasks keep every time a new task is recorded.
+	*/
+	kernel_throughput(double overhead_fraction = 0.1, std::size_t min_samples = 5, double decay = 0.95);
+
+	/**
+	* Records a task that ran.
+	* @param input_bytes the size in bytes of the inputs of the task.
+	* @param duration the time the task took, in microseconds.
+	*/
+	void record(std::size_t input_bytes, double duration);
+
+	/**
+	* Suggests the size of the batches for this kernel.
+	* @return a pair where the first value indicates if there is a suggestion and the second one is the suggested batch size in bytes.
+	*/
+	std::pair<bool, std::size_t> get_target_batch_bytes();
+
+private:
+	double overhead_fraction;
+	std::size_t min_samples;
+	double decay;
+
+	std::mutex mutex_;
+	std::size_t num_samples = 0;
+	// weighted sums for a least squares fit of duration = overhead + cost_per_byte * bytes
+	double sum_weights = 0;
+	double sum_bytes = 0;
+	double sum_durations = 0;
+	double sum_bytes_squared = 0;
+	double sum_bytes_durations = 0;
+};
+
+}  // namespace cache
+}  // namespace ral
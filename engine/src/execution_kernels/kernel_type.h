@@ -9,6 +9,7 @@ enum class kernel_type {
 	ProjectKernel,
 	FilterKernel,
 	UnionKernel,
+	SetOperationKernel,
 	MergeStreamKernel,
 	PartitionKernel,
 	SortAndSampleKernel,
@@ -17,16 +18,24 @@ enum class kernel_type {
 	OverlapAccumulatorKernel,
 	PartitionSingleNodeKernel,
 	LimitKernel,
+	TopKKernel,
 	ComputeAggregateKernel,
 	DistributeAggregateKernel,
 	MergeAggregateKernel,
+	GroupingSetsKernel,
 	TableScanKernel,
 	BindableTableScanKernel,
 	PartwiseJoinKernel,
 	JoinPartitionKernel,
+	SortMergeJoinKernel,
+	StarJoinKernel,
 	OutputKernel,
 	PrintKernel,
 	GenerateKernel,
+	MaterializeKernel,
+	MaterializedResultScanKernel,
+	SpoolKernel,
+	CachedTableScanKernel,
 };
 
 std::string get_kernel_type_name(kernel_type type);
@@ -0,0 +1,214 @@
+#include "scan_work_stealing.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include "communication/CommunicationData.h"
+#include "execution_graph/graph.h"
+
+namespace ral {
+namespace batch {
+
+namespace {
+
+const char FILE_SEPARATOR = '\x1e';
+const char FIELD_SEPARATOR = '\x1f';
+const auto POLL_INTERVAL = std::chrono::milliseconds(10);
+
+// unlike StringUtil::split, it keeps the empty fields
+std::vector<std::string> split_fields(const std::string & value, char separator) {
+	std::vector<std::string> fields;
+	std::size_t start = 0;
+	while (true) {
+		std::size_t end = value.find(separator, start);
+		if (end == std::string::npos) {
+			fields.push_back(value.substr(start));
+			return fields;
+		}
+		fields.push_back(value.substr(start, end - start));
+		start = end + 1;
+	}
+}
+
+} // namespace
+
+std::string serialize_scan_files(const std::vector<scan_file> & files) {
+	std::string value;
+	for (std::size_t i = 0; i < files.size(); i++) {
+		if (i > 0) {
+			value += FILE_SEPARATOR;
+		}
+		value += files[i].uri;
+		value += FIELD_SEPARATOR;
+		for (std::size_t j = 0; j < files[i].row_group_ids.size(); j++) {
+			value += (j > 0 ? "," : "") + std::to_string(files[i].row_group_ids[j]);
+		}
+		for (auto & column_value : files[i].column_values) {
+			value += FIELD_SEPARATOR + column_value.first + FIELD_SEPARATOR + column_value.second;
+		}
+	}
+	return value;
+}
+
+std::vector<scan_file> deserialize_scan_files(const std::string & value) {
+	std::vector<scan_file> files;
+	if (value.empty()) {
+		return files;
+	}
+	for (const std::string & file_value : split_fields(value, FILE_SEPARATOR)) {
+		std::vector<std::string> fields = split_fields(file_value, FIELD_SEPARATOR);
+		if (fields.size() < 2 || fields.size() % 2 != 0) {
+			throw std::runtime_error("ERROR: the files of a reply of the scan work stealing are malformed");
+		}
+		scan_file file;
+		file.uri = fields[0];
+		if (!fields[1].empty()) {
+			for (const std::string & row_group_id : split_fields(fields[1], ',')) {
+				file.row_group_ids.push_back(std::stoi(row_group_id));
+			}
+		}
+		for (std::size_t i = 2; i < fields.size(); i += 2) {
+			file.column_values[fields[i]] = fields[i + 1];
+		}
+		files.push_back(file);
+	}
+	return files;
+}
+
+scan_work_stealing::scan_work_stealing(distributing_kernel * kernel, std::shared_ptr<Context> context,
+	std::shared_ptr<ral::cache::graph> query_graph, std::shared_ptr<ral::io::data_provider> provider,
+	ral::io::Schema & schema)
+	: kernel{kernel}, context{context}, query_graph{query_graph}, provider{provider}, schema{schema} {
+	auto & self_node = ral::communication::CommunicationData::getInstance().getSelfNode();
+	std::vector<blazingdb::transport::Node> nodes = context->getAllNodes();
+	int self_node_idx = context->getNodeIndex(self_node);
+	for (std::size_t i = 1; i < nodes.size(); i++) {
+		peer other;
+		other.id = nodes[(self_node_idx + i) % nodes.size()].id();
+		this->peers.push_back(other);
+	}
+}
+
+std::string scan_work_stealing::get_message_id(const std::string & prefix, std::size_t sequence, const std::string & sender_id) const {
+	return prefix + std::to_string(sequence) + "_" + std::to_string(this->context->getContextToken()) + "_" +
+		std::to_string(this->kernel->get_id()) + "_" + sender_id;
+}
+
+void scan_work_stealing::send_request(peer & victim, bool wants_files) {
+	ral::cache::MetadataDictionary extra_metadata;
+	extra_metadata.add_value(ral::cache::SCAN_STEAL_WANTS_FILES_METADATA_LABEL, wants_files ? "true" : "false");
+	this->kernel->send_message(nullptr,
+		false, //specific_cache
+		"", //cache_id
+		{victim.id}, //target_ids
+		"scan_steal_request_" + std::to_string(victim.num_requests_sent) + "_", //message_id_prefix
+		true, //always_add
+		false, //wait_for
+		0, //message_tracker_idx
+		extra_metadata);
+	victim.num_requests_sent++;
+}
+
+std::size_t scan_work_stealing::answer_requests(std::size_t file_index) {
+	return answer_requests(file_index, true);
+}
+
+std::size_t scan_work_stealing::answer_requests(std::size_t file_index, bool give_files) {
+	auto input_message_cache = this->query_graph->get_input_message_cache();
+	std::size_t num_files_given = 0;
+	for (peer & thief : this->peers) {
+		while (!thief.done) {
+			std::string request_id = get_message_id("scan_steal_request_", thief.num_requests_answered, thief.id);
+			if (!input_message_cache->has_messages_now({request_id})) {
+				break;
+			}
+			auto request = input_message_cache->pullCacheData(request_id);
+			std::size_t sequence = thief.num_requests_answered++;
+			if (request->getMetadata().get_value(ral::cache::SCAN_STEAL_WANTS_FILES_METADATA_LABEL) == "false") {
+				thief.done = true;
+				break;
+			}
+
+			// the files that were not started are the last ones, the ones of a provider that lists directories can't be told apart
+			std::vector<scan_file> files;
+			std::size_t num_files = this->provider->get_num_handles();
+			if (give_files && num_files == this->schema.get_files().size() && num_files > file_index + 1) {
+				std::vector<ral::io::data_handle> handles = this->provider->take_last_files((num_files - file_index) / 2);
+				std::size_t first_given = num_files - handles.size();
+				for (std::size_t i = 0; i < handles.size(); i++) {
+					files.push_back({handles[i].uri.toString(), handles[i].column_values, this->schema.get_rowgroup_ids(first_given + i)});
+				}
+				this->schema.remove_files_from(first_given);
+			}
+
+			ral::cache::MetadataDictionary extra_metadata;
+			extra_metadata.add_value(ral::cache::SCAN_STOLEN_FILES_METADATA_LABEL, serialize_scan_files(files));
+			this->kernel->send_message(nullptr,
+				false, //specific_cache
+				"", //cache_id
+				{thief.id}, //target_ids
+				"scan_steal_reply_" + std::to_string(sequence) + "_", //message_id_prefix
+				true, //always_add
+				false, //wait_for
+				0, //message_tracker_idx
+				extra_metadata);
+
+			// a node that got no files does not ask again
+			thief.done = files.empty();
+			num_files_given += files.size();
+		}
+	}
+	return num_files_given;
+}
+
+std::size_t scan_work_stealing::steal(std::size_t file_index, const std::function<bool()> & stop) {
+	auto input_message_cache = this->query_graph->get_input_message_cache();
+	while (this->next_victim < this->peers.size()) {
+		peer & victim = this->peers[this->next_victim];
+		std::string reply_id = get_message_id("scan_steal_reply_", victim.num_requests_sent, victim.id);
+		send_request(victim, true);
+
+		// the others may be waiting for this node too
+		while (!input_message_cache->has_messages_now({reply_id})) {
+			answer_requests(file_index, true);
+			if (stop()) {
+				return 0;
+			}
+			std::this_thread::sleep_for(POLL_INTERVAL);
+		}
+		auto reply = input_message_cache->pullCacheData(reply_id);
+		std::vector<scan_file> files = deserialize_scan_files(reply->getMetadata().get_value(ral::cache::SCAN_STOLEN_FILES_METADATA_LABEL));
+		if (files.empty()) {
+			this->next_victim++;
+			continue;
+		}
+
+		std::vector<ral::io::data_handle> handles;
+		for (const scan_file & file : files) {
+			ral::io::data_handle handle;
+			handle.uri = Uri{file.uri};
+			handle.column_values = file.column_values;
+			handles.push_back(handle);
+			this->schema.add_file(file.uri, file.row_group_ids);
+		}
+		this->provider->add_files(handles);
+		return files.size();
+	}
+	return 0;
+}
+
+void scan_work_stealing::finish(const std::function<bool()> & stop) {
+	for (; this->next_victim < this->peers.size(); this->next_victim++) {
+		send_request(this->peers[this->next_victim], false);
+	}
+	while (true) {
+		answer_requests(0, false);
+		if (stop() || std::all_of(this->peers.begin(), this->peers.end(), [](const peer & other) { return other.done; })) {
+			return;
+		}
+		std::this_thread::sleep_for(POLL_INTERVAL);
+	}
+}
+
+} // namespace batch
+} // namespace ral
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "execution_kernels/distributing_kernel.h"
+#include "io/data_provider/DataProvider.h"
+#include "io/Schema.h"
+
+namespace ral {
+namespace batch {
+
+using ral::cache::distributing_kernel;
+using Context = blazingdb::manager::Context;
+
+/**
+ * A file of a parquet or orc table that the scan of a node gives to the scan of another node, with its hive values
+ * and the row groups that it reads (all of them when it has none).
+ */
+struct scan_file {
+	std::string uri;
+	std::map<std::string, std::string> column_values;
+	std::vector<int> row_group_ids;
+};
+
+/**
+ * The files as the value of SCAN_STOLEN_FILES_METADATA_LABEL, separated by the ascii record separator, and the fields
+ * of each one by the unit separator: the uri, the comma separated row groups and then the keys and values of its hive
+ * values, so that they can have any other character.
+ */
+std::string serialize_scan_files(const std::vector<scan_file> & files);
+std::vector<scan_file> deserialize_scan_files(const std::string & value);
+
+/**
+ * The work stealing of the scans of a table over the nodes, with ENABLE_SCAN_WORK_STEALING. The files of a table are
+ * given to the nodes before the query starts, so a node that is slower, or got the larger files, keeps scanning while
+ * the others wait for it. When the scan of a node made the tasks of all its files, it asks the scans of the other nodes
+ * in turn for half of the files they did not start yet, and scans them too, until all of them answer that they have
+ * none. Every scan answers the requests of the others while it makes its tasks, and before it finishes it waits until
+ * it told every other node that it has no files to give, see finish.
+ *
+ * A request of node A to node B is the message scan_steal_request_<n>_<query>_<kernel>_<A>, where n counts the
+ * requests of A to B, and its reply is scan_steal_reply_<n>_<query>_<kernel>_<B>. The replies only add files at the
+ * end of the provider and the schema of the scan, so the batches it makes are still counted as its own by the
+ * distributing kernels that consume them.
+ */
+class scan_work_stealing {
+public:
+	/**
+	 * @param kernel The scan, that sends the messages.
+	 * @param provider The provider of the files of the scan, the files it gives are taken out of it and the ones it
+	 * gets are added to it.
+	 * @param schema The schema of the scan, with the files and row groups of the provider.
+	 */
+	scan_work_stealing(distributing_kernel * kernel, std::shared_ptr<Context> context,
+		std::shared_ptr<ral::cache::graph> query_graph, std::shared_ptr<ral::io::data_provider> provider,
+		ral::io::Schema & schema);
+
+	/**
+	 * Answers the requests that arrived, each one with half of the files after file_index, the next one the scan reads.
+	 * @return The number of files that it gave.
+	 */
+	std::size_t answer_requests(std::size_t file_index);
+
+	/**
+	 * Asks the other nodes for files until one gives some, and adds them to the provider and the schema. It answers the
+	 * requests of the others while it waits for the replies.
+	 * @param stop Gives up the wait for a reply when it returns true.
+	 * @return The number of files that it got, 0 when no node has files to give.
+	 */
+	std::size_t steal(std::size_t file_index, const std::function<bool()> & stop);
+
+	/**
+	 * Tells the nodes that it did not ask yet that it won't ask them, and answers the requests of the others, with no
+	 * files, until it answered every one of them with no files.
+	 */
+	void finish(const std::function<bool()> & stop);
+
+private:
+	struct peer {
+		std::string id;
+		std::size_t num_requests_sent = 0; /**< The requests to this node so far. */
+		std::size_t num_requests_answered = 0; /**< The requests of this node so far. */
+		bool done = false; /**< This node won't send more requests, it was told that there are no files. */
+	};
+
+	std::string get_message_id(const std::string & prefix, std::size_t sequence, const std::string & sender_id) const;
+	void send_request(peer & victim, bool wants_files);
+	std::size_t answer_requests(std::size_t file_index, bool give_files);
+
+	distributing_kernel * kernel;
+	std::shared_ptr<Context> context;
+	std::shared_ptr<ral::cache::graph> query_graph;
+	std::shared_ptr<ral::io::data_provider> provider;
+	ral::io::Schema & schema;
+	std::vector<peer> peers; /**< The other nodes, starting at the one after this one, so that they don't all ask the same node first. */
+	std::size_t next_victim = 0; /**< The first of the peers that may still have files to give. */
+};
+
+} // namespace batch
+} // namespace ral
@@ -15,7 +15,8 @@ typedef enum {
   ARROW = 6,
   MYSQL = 7,
   POSTGRESQL = 8,
-  SQLITE = 9
+  SQLITE = 9,
+  ARROW_FLIGHT = 10
 } DataType;
 
 } /* namespace io */
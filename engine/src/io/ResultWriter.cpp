@@ -0,0 +1,287 @@
+#include "ResultWriter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+
+#include <arrow/io/interfaces.h>
+#include <arrow/ipc/writer.h>
+#include <arrow/memory_pool.h>
+#include <cudf/concatenate.hpp>
+#include <cudf/copying.hpp>
+#include <cudf/interop.hpp>
+#include <cudf/io/data_sink.hpp>
+#include <cudf/io/orc.hpp>
+#include <cudf/io/parquet.hpp>
+#include <cudf/strings/strings_column_view.hpp>
+#include <cudf/utilities/traits.hpp>
+
+#include <blazingdb/io/Config/BlazingContext.h>
+#include "bmr/BufferProvider.h"
+#include "io/data_parser/metadata/common_metadata.h"
+#include "utilities/CommonOperations.h"
+
+namespace ral {
+namespace io {
+
+namespace {
+
+// Lets cudf write into the output streams of the filesystems, which upload the files in parts as they are written
+class output_stream_sink : public cudf::io::data_sink {
+public:
+	explicit output_stream_sink(std::shared_ptr<arrow::io::OutputStream> stream) : stream(stream) {}
+
+	void host_write(void const * data, size_t size) override {
+		check(stream->Write(data, size));
+		written += size;
+	}
+
+	void flush() override { check(stream->Flush()); }
+
+	size_t bytes_written() override { return written; }
+
+	void close() { check(stream->Close()); }
+
+private:
+	void check(const arrow::Status & status) {
+		if (!status.ok()) {
+			throw std::runtime_error("ERROR: Writing a file of the result failed: " + status.ToString());
+		}
+	}
+
+	std::shared_ptr<arrow::io::OutputStream> stream;
+	size_t written = 0;
+};
+
+void check_arrow_status(const arrow::Status & status) {
+	if (!status.ok()) {
+		throw std::runtime_error("ERROR: Writing a file of the result failed: " + status.ToString());
+	}
+}
+
+// Lets cudf::to_arrow copy the columns into the pinned buffers of the pinned buffer provider, so that the copies from
+// the GPU are not staged through pageable memory. The allocations that do not fit in a buffer come from the default
+// pool of arrow.
+class pinned_staging_pool : public arrow::MemoryPool {
+public:
+	pinned_staging_pool() : pinned_pool(ral::memory::buffer_providers::get_pinned_buffer_provider()) {}
+
+	arrow::Status Allocate(int64_t size, uint8_t ** out) override {
+		if (pinned_pool != nullptr && size > 0 && static_cast<std::size_t>(size) <= pinned_pool->size_buffers()) {
+			std::unique_ptr<ral::memory::blazing_allocation_chunk> chunk = pinned_pool->get_chunk(size);
+			*out = reinterpret_cast<uint8_t *>(chunk->data);
+			std::lock_guard<std::mutex> lock(mutex);
+			chunks[*out] = std::move(chunk);
+		} else {
+			ARROW_RETURN_NOT_OK(arrow::default_memory_pool()->Allocate(size, out));
+		}
+		allocated += size;
+		return arrow::Status::OK();
+	}
+
+	arrow::Status Reallocate(int64_t old_size, int64_t new_size, uint8_t ** ptr) override {
+		std::size_t chunk_size = 0;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			auto it = chunks.find(*ptr);
+			if (it != chunks.end()) {
+				chunk_size = it->second->size;
+			}
+		}
+		if (chunk_size == 0) {
+			ARROW_RETURN_NOT_OK(arrow::default_memory_pool()->Reallocate(old_size, new_size, ptr));
+			allocated += new_size - old_size;
+			return arrow::Status::OK();
+		}
+		if (static_cast<std::size_t>(new_size) <= chunk_size) {
+			allocated += new_size - old_size;
+			return arrow::Status::OK();
+		}
+		uint8_t * new_ptr;
+		ARROW_RETURN_NOT_OK(Allocate(new_size, &new_ptr));
+		std::memcpy(new_ptr, *ptr, old_size);
+		Free(*ptr, old_size);
+		*ptr = new_ptr;
+		return arrow::Status::OK();
+	}
+
+	void Free(uint8_t * buffer, int64_t size) override {
+		std::unique_ptr<ral::memory::blazing_allocation_chunk> chunk;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			auto it = chunks.find(buffer);
+			if (it != chunks.end()) {
+				chunk = std::move(it->second);
+				chunks.erase(it);
+			}
+		}
+		if (chunk != nullptr) {
+			pinned_pool->free_chunk(std::move(chunk));
+		} else {
+			arrow::default_memory_pool()->Free(buffer, size);
+		}
+		allocated -= size;
+	}
+
+	int64_t bytes_allocated() const override { return allocated; }
+
+	std::string backend_name() const override { return "blazing_pinned"; }
+
+private:
+	std::shared_ptr<ral::memory::allocation_pool> pinned_pool;
+	std::mutex mutex;
+	std::map<uint8_t *, std::unique_ptr<ral::memory::blazing_allocation_chunk>> chunks;
+	std::atomic<int64_t> allocated{0};
+};
+
+// the most bytes that a row takes in a buffer of one of the columns. The size of the chars of the strings is an
+// average over the column, a slice with longer strings than that gets the buffers of its chars from the default pool.
+std::size_t get_max_row_bytes(const CudfTableView & view) {
+	std::size_t max_row_bytes = 1;
+	for (const auto & column : view) {
+		std::size_t row_bytes = 0;
+		if (column.type().id() == cudf::type_id::STRING && column.size() > 0) {
+			std::size_t chars_size = cudf::strings_column_view(column).chars_size();
+			row_bytes = std::max<std::size_t>((chars_size + column.size() - 1) / column.size(), sizeof(int32_t));
+		} else if (cudf::is_fixed_width(column.type())) {
+			row_bytes = cudf::size_of(column.type());
+		}
+		max_row_bytes = std::max(max_row_bytes, row_bytes);
+	}
+	return max_row_bytes;
+}
+
+}  // namespace
+
+result_writer::result_writer(const std::string & output_path, const std::string & format, std::size_t max_file_bytes, int node_index)
+	: folder(output_path), format(format), max_file_bytes(std::max<std::size_t>(max_file_bytes, 1)), node_index(node_index) {
+	if (format != "parquet" && format != "orc" && format != "arrow") {
+		throw std::runtime_error("ERROR: The result can't be written as " + format + ", only as parquet, orc or arrow");
+	}
+	while (this->folder.size() > 1 && this->folder.back() == '/') {
+		this->folder.pop_back();
+	}
+
+	// the object stores have no folders, so only the others need them to be made
+	Uri folder_uri(this->folder);
+	if (folder_uri.getFileSystemType() == FileSystemType::LOCAL || folder_uri.getFileSystemType() == FileSystemType::HDFS) {
+		auto fs = BlazingContext::getInstance()->getFileSystemManager();
+		if (!fs->exists(folder_uri)) {
+			fs->makeDirectory(folder_uri);
+		}
+	}
+}
+
+void result_writer::write(std::unique_ptr<ral::frame::BlazingTable> table) {
+	if (table == nullptr || table->num_rows() == 0) {
+		return;
+	}
+	pending_bytes += table->sizeInBytes();
+	pending.push_back(std::move(table));
+	if (pending_bytes >= max_file_bytes) {
+		write_pending();
+	}
+}
+
+std::unique_ptr<ral::frame::BlazingTable> result_writer::finish() {
+	write_pending();
+
+	std::vector<std::unique_ptr<cudf::column>> columns;
+	columns.push_back(make_cudf_strings_column_from_vector(file_paths));
+	columns.push_back(ral::utilities::vector_to_column(file_num_rows, cudf::data_type{cudf::type_id::INT64}));
+	return std::make_unique<ral::frame::BlazingTable>(std::make_unique<CudfTable>(std::move(columns)),
+		std::vector<std::string>{"file_path", "num_rows"});
+}
+
+void result_writer::write_pending() {
+	if (pending.empty()) {
+		return;
+	}
+	std::vector<std::string> names = pending[0]->names();
+	std::unique_ptr<CudfTable> concatenated;
+	CudfTableView view = pending[0]->view();
+	if (pending.size() > 1) {
+		std::vector<CudfTableView> views;
+		for (auto & table : pending) {
+			views.push_back(table->view());
+		}
+		concatenated = cudf::concatenate(views);
+		view = concatenated->view();
+	}
+
+	// a batch larger than max_file_bytes is split into files of about max_file_bytes
+	std::size_t num_files = std::max<std::size_t>((pending_bytes + max_file_bytes - 1) / max_file_bytes, 1);
+	cudf::size_type rows_per_file = (view.num_rows() + num_files - 1) / num_files;
+	for (cudf::size_type start = 0; start < view.num_rows(); start += rows_per_file) {
+		cudf::size_type end = std::min(start + rows_per_file, view.num_rows());
+		write_file(ral::frame::BlazingTableView(cudf::slice(view, {start, end})[0], names));
+	}
+
+	pending.clear();
+	pending_bytes = 0;
+}
+
+void result_writer::write_file(const ral::frame::BlazingTableView & table) {
+	std::string file_path = folder + "/part-" + std::to_string(node_index) + "-" + std::to_string(file_paths.size()) + "." + format;
+	auto stream = BlazingContext::getInstance()->getFileSystemManager()->openWriteable(Uri(file_path));
+	if (stream == nullptr) {
+		throw std::runtime_error("ERROR: Could not open " + file_path + " to write the result");
+	}
+
+	if (format == "arrow") {
+		write_arrow_file(table, stream);
+		check_arrow_status(stream->Close());
+	} else {
+		output_stream_sink sink(stream);
+
+		cudf::io::table_metadata metadata;
+		metadata.column_names = table.names();
+		if (format == "parquet") {
+			cudf::io::parquet_writer_options options = cudf::io::parquet_writer_options::builder(
+				cudf::io::sink_info{&sink}, table.view()).metadata(&metadata);
+			cudf::io::write_parquet(options);
+		} else {
+			cudf::io::orc_writer_options options = cudf::io::orc_writer_options::builder(
+				cudf::io::sink_info{&sink}, table.view()).metadata(&metadata);
+			cudf::io::write_orc(options);
+		}
+		sink.close();
+	}
+
+	file_paths.push_back(file_path);
+	file_num_rows.push_back(table.num_rows());
+}
+
+void result_writer::write_arrow_file(const ral::frame::BlazingTableView & table, std::shared_ptr<arrow::io::OutputStream> stream) {
+	std::vector<cudf::column_metadata> metadata;
+	for (const auto & name : table.names()) {
+		metadata.emplace_back(name);
+	}
+
+	// every slice is a record batch of the file, whose buffers are staged in pinned buffers and released once it is written
+	auto pinned_pool = ral::memory::buffer_providers::get_pinned_buffer_provider();
+	std::size_t slice_bytes = pinned_pool != nullptr ? pinned_pool->size_buffers() : max_file_bytes;
+	cudf::size_type rows_per_slice = std::max<std::size_t>(slice_bytes / get_max_row_bytes(table.view()), 1);
+
+	pinned_staging_pool staging_pool;
+	std::shared_ptr<arrow::ipc::RecordBatchWriter> writer;
+	for (cudf::size_type start = 0; start < table.num_rows(); start += rows_per_slice) {
+		cudf::size_type end = std::min(start + rows_per_slice, table.num_rows());
+		std::shared_ptr<arrow::Table> slice = cudf::to_arrow(cudf::slice(table.view(), {start, end})[0], metadata, &staging_pool);
+		if (writer == nullptr) {
+			auto file_writer = arrow::ipc::NewFileWriter(stream.get(), slice->schema());
+			check_arrow_status(file_writer.status());
+			writer = *file_writer;
+		}
+		check_arrow_status(writer->WriteTable(*slice));
+	}
+	if (writer != nullptr) {
+		check_arrow_status(writer->Close());
+	}
+}
+
+}  // namespace io
+}  // namespace ral
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <arrow/io/interfaces.h>
+#include <FileSystem/Uri.h>
+#include "execution_kernels/LogicPrimitives.h"
+
+namespace ral {
+namespace io {
+
+/**
+ * @brief Writes the result of a query as parquet, orc or Arrow IPC files into a folder of any of the registered
+ * filesystems, instead of returning it.
+ *
+ * Every node writes the partitions of the result it has, so the nodes write in parallel and nothing is gathered
+ * through the client. The batches are gathered into files of about max_file_bytes of decoded data, named
+ * part-<node index>-<file index>, so that the files of the nodes never collide.
+ *
+ * The Arrow IPC files are meant for the processes of the same host that read the result on the CPU: written into a
+ * folder of shared memory, like /dev/shm, they can be memory mapped and read without copying or decoding them. Their
+ * columns are copied from the GPU into pinned buffers of the pinned buffer provider, in slices of rows whose buffers
+ * fit in a buffer of the provider, and from there into the file.
+ */
+class result_writer {
+public:
+	/**
+	 * @param format parquet, orc or arrow
+	 */
+	result_writer(const std::string & output_path, const std::string & format, std::size_t max_file_bytes, int node_index);
+
+	void write(std::unique_ptr<ral::frame::BlazingTable> table);
+
+	/**
+	 * @brief Writes the batches that are left.
+	 * @return the paths of the files that were written, with their number of rows
+	 */
+	std::unique_ptr<ral::frame::BlazingTable> finish();
+
+private:
+	void write_pending();
+	void write_file(const ral::frame::BlazingTableView & table);
+	void write_arrow_file(const ral::frame::BlazingTableView & table, std::shared_ptr<arrow::io::OutputStream> stream);
+
+	std::string folder;
+	std::string format;
+	std::size_t max_file_bytes;
+	int node_index;
+
+	std::vector<std::unique_ptr<ral::frame::BlazingTable>> pending;
+	std::size_t pending_bytes = 0;
+
+	std::vector<std::string> file_paths;
+	std::vector<int64_t> file_num_rows;
+};
+
+}  // namespace io
+}  // namespace ral
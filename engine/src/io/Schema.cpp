@@ -86,6 +86,34 @@ void Schema::set_row_count(size_t row_count_value) {
     this->row_count = row_count_value;
 }
 
+bool Schema::is_bucketed() const { return this->num_buckets > 0; }
+
+void Schema::set_bucketing(size_t bucket_column_index, size_t num_buckets, const std::string & bucket_hash) {
+	this->bucket_column_index = bucket_column_index;
+	this->num_buckets = num_buckets;
+	this->bucket_hash = bucket_hash;
+}
+
+size_t Schema::get_bucket_column_index() const { return this->bucket_column_index; }
+
+size_t Schema::get_num_buckets() const { return this->num_buckets; }
+
+std::string Schema::get_bucket_hash() const { return this->bucket_hash; }
+
+bool Schema::is_cached() const { return !this->cached_column_indices.empty(); }
+
+void Schema::set_cached_columns(const std::vector<int> & cached_column_indices) {
+	this->cached_column_indices = cached_column_indices;
+}
+
+std::vector<int> Schema::get_cached_columns() const { return this->cached_column_indices; }
+
+void Schema::set_index_columns(const std::vector<int> & index_column_indices) {
+	this->index_column_indices = index_column_indices;
+}
+
+std::vector<int> Schema::get_index_columns() const { return this->index_column_indices; }
+
 void Schema::add_column(std::string name, cudf::type_id type, size_t file_index, bool is_in_file) {
 	this->names.push_back(name);
 	this->types.push_back(type);
@@ -93,10 +121,47 @@ void Schema::add_column(std::string name, cudf::type_id type, size_t file_index,
 	this->in_file.push_back(is_in_file);
 }
 
+bool Schema::has_shareable_files() const { return this->shareable_files; }
+
+void Schema::set_shareable_files(bool shareable_files) {
+	this->shareable_files = shareable_files;
+}
+
 void Schema::add_file(std::string file){
 	this->files.push_back(file);
 }
 
+void Schema::add_file(const std::string & file, const std::vector<int> & row_group_ids) {
+	// the files before it read all their row groups when they have none
+	this->row_groups_ids.resize(this->files.size());
+	this->row_groups_ids.push_back(row_group_ids);
+	this->files.push_back(file);
+}
+
+void Schema::keep_files(const std::vector<size_t> & file_indices) {
+	std::vector<std::vector<int>> kept_row_groups_ids;
+	std::vector<std::string> kept_files;
+	for (size_t file_index : file_indices) {
+		if (this->row_groups_ids.size() > file_index) {
+			kept_row_groups_ids.push_back(this->row_groups_ids[file_index]);
+		}
+		if (this->files.size() > file_index) {
+			kept_files.push_back(this->files[file_index]);
+		}
+	}
+	this->row_groups_ids = kept_row_groups_ids;
+	this->files = kept_files;
+}
+
+void Schema::remove_files_from(size_t file_index) {
+	if (this->row_groups_ids.size() > file_index) {
+		this->row_groups_ids.resize(file_index);
+	}
+	if (this->files.size() > file_index) {
+		this->files.resize(file_index);
+	}
+}
+
 Schema Schema::fileSchema(size_t current_file_index) const {
 	Schema schema;
 	for(size_t i = 0; i < this->names.size(); i++) {
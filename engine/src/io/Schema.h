@@ -64,7 +64,34 @@ public:
     size_t get_row_count() const;
     void set_row_count(size_t row_count);
 
+	// a bucketed table has its rows split into num_buckets files by the hash of one of its columns, see set_bucketing
+	bool is_bucketed() const;
+	void set_bucketing(size_t bucket_column_index, size_t num_buckets, const std::string & bucket_hash);
+	size_t get_bucket_column_index() const;
+	size_t get_num_buckets() const;
+	std::string get_bucket_hash() const;
+
+	// the columns of a cached table are kept in the table_cache after the first scan that reads all of them, see cache_table
+	bool is_cached() const;
+	void set_cached_columns(const std::vector<int> & cached_column_indices);
+	std::vector<int> get_cached_columns() const;
+	// the cached columns that are indexed, see sorted_key_index
+	void set_index_columns(const std::vector<int> & index_column_indices);
+	std::vector<int> get_index_columns() const;
+
+	// the files of a table that every node can read, so that the scans of the nodes can give the files they did not
+	// start to each other, see ral::batch::scan_work_stealing
+	bool has_shareable_files() const;
+	void set_shareable_files(bool shareable_files);
+
 	void add_file(std::string file);
+	// a file that the scan of another node gave, with the row groups it reads
+	void add_file(const std::string & file, const std::vector<int> & row_group_ids);
+
+	// keeps the row groups and the files of only these file indices, when the provider drops the other files
+	void keep_files(const std::vector<size_t> & file_indices);
+	// removes the row groups and the files from this file index on, when the provider gives them to another node
+	void remove_files_from(size_t file_index);
 
 	void add_column(std::string name,
 		cudf::type_id type,
@@ -88,6 +115,12 @@ private:
 	std::vector<std::vector<int>> row_groups_ids;
 	bool has_header_csv = false;
 	size_t row_count = 0;
+	size_t bucket_column_index = 0; // the calcite index of the column the files are bucketed by
+	size_t num_buckets = 0; // 0 when the table is not bucketed
+	std::string bucket_hash;
+	bool shareable_files = false;
+	std::vector<int> cached_column_indices; // the calcite indices of the cached columns, empty when the table is not cached
+	std::vector<int> index_column_indices;
 };
 
 } /* namespace io */
@@ -1,5 +1,8 @@
 #include "ArgsUtil.h"
 
+#include <algorithm>
+#include <stdexcept>
+
 #include <blazingdb/io/FileSystem/Uri.h>
 #include <blazingdb/io/Util/StringUtil.h>
 
@@ -29,6 +32,8 @@ DataType inferDataType(std::string file_format_hint) {
 		return DataType::POSTGRESQL;
 	if(file_format_hint == "sqlite")
 		return DataType::SQLITE;
+	if(file_format_hint == "flight")
+		return DataType::ARROW_FLIGHT;
 	// NOTE if you need more options the user can pass file_format in the create table
 
 	return DataType::UNDEFINED;
@@ -37,7 +42,8 @@ DataType inferDataType(std::string file_format_hint) {
 DataType inferFileType(std::vector<std::string> files, DataType data_type_hint, bool ignore_missing_paths) {
 	if(data_type_hint == DataType::PARQUET || data_type_hint == DataType::CSV || data_type_hint == DataType::JSON ||
 		data_type_hint == DataType::ORC || data_type_hint == DataType::MYSQL ||
-    data_type_hint == DataType::POSTGRESQL || data_type_hint == DataType::SQLITE) {
+    data_type_hint == DataType::POSTGRESQL || data_type_hint == DataType::SQLITE ||
+    data_type_hint == DataType::ARROW_FLIGHT) {
 		return data_type_hint;
 	}
 
@@ -233,6 +239,70 @@ cudf::io::csv_reader_options getCsvReaderOptions(const std::map<std::string, std
 	return reader_opts;
 }
 
+cudf::io::compression_type infer_compression_type(const std::map<std::string, std::string> & args, const data_handle & handle) {
+	auto compression = cudf::io::compression_type::AUTO;
+	if(map_contains("compression", args)) {
+		compression = static_cast<cudf::io::compression_type>(to_int(args.at("compression")));
+	}
+	if(compression != cudf::io::compression_type::AUTO) {
+		return compression;
+	}
+
+	const std::string path = handle.uri.isEmpty() ? "" : StringUtil::toLower(handle.uri.getPath().toString());
+	auto has_extension = [&path](const std::string & extension) {
+		return path.size() >= extension.size() && path.compare(path.size() - extension.size(), extension.size(), extension) == 0;
+	};
+	if(has_extension(".zst") || has_extension(".zstd")) {
+		throw std::runtime_error("ERROR: zstd compressed files are not supported, the file " + handle.uri.toString() +
+			" must be decompressed first");
+	}
+	if(has_extension(".gz") || has_extension(".gzip")) {
+		return cudf::io::compression_type::GZIP;
+	}
+	if(has_extension(".bz2")) {
+		return cudf::io::compression_type::BZIP2;
+	}
+	if(has_extension(".zip")) {
+		return cudf::io::compression_type::ZIP;
+	}
+	if(has_extension(".xz")) {
+		return cudf::io::compression_type::XZ;
+	}
+
+	for(const std::string & extension : {".csv", ".psv", ".tbl", ".txt", ".json"}) {
+		if(has_extension(extension)) {
+			return cudf::io::compression_type::NONE;
+		}
+	}
+
+	// the files without a known extension are told apart by their magic numbers
+	if(handle.file_handle == nullptr) {
+		return cudf::io::compression_type::NONE;
+	}
+	auto header = handle.file_handle->ReadAt(0, 6);
+	if(!header.ok() || header.ValueOrDie() == nullptr) {
+		return cudf::io::compression_type::NONE;
+	}
+	const std::string magic(reinterpret_cast<const char *>(header.ValueOrDie()->data()), header.ValueOrDie()->size());
+	if(magic.compare(0, 2, "\x1f\x8b") == 0) {
+		return cudf::io::compression_type::GZIP;
+	}
+	if(magic.compare(0, 3, "BZh") == 0) {
+		return cudf::io::compression_type::BZIP2;
+	}
+	if(magic.compare(0, 4, "PK\x03\x04") == 0) {
+		return cudf::io::compression_type::ZIP;
+	}
+	if(magic.compare(0, 6, std::string("\xfd" "7zXZ\x00", 6)) == 0) {
+		return cudf::io::compression_type::XZ;
+	}
+	if(magic.compare(0, 4, "\x28\xb5\x2f\xfd") == 0) {
+		throw std::runtime_error("ERROR: zstd compressed files are not supported, the file " + handle.uri.toString() +
+			" must be decompressed first");
+	}
+	return cudf::io::compression_type::NONE;
+}
+
 std::map<std::string, std::string> to_map(std::vector<std::string> arg_keys, std::vector<std::string> arg_values) {
 	std::map<std::string, std::string> ret;
 	for(size_t i = 0; i < arg_keys.size(); ++i) {
@@ -261,6 +331,7 @@ std::string getDataTypeName(DataType dataType) {
 sql_info getSqlInfo(std::map<std::string, std::string> &args_map) {
   // TODO percy william maybe we can move this constant as a bc.BlazingContext config opt
   const size_t DETAULT_TABLE_BATCH_SIZE = 100000;
+  const size_t DEFAULT_TABLE_CONNECTIONS = 4;
   // TODO(percy, cristhian): add exception for key error and const
   // TODO(percy, cristhian): for sqlite, add contionals to avoid unncessary fields
   sql_info sql;
@@ -294,6 +365,17 @@ sql_info getSqlInfo(std::map<std::string, std::string> &args_map) {
   } else {
     sql.table_batch_size = DETAULT_TABLE_BATCH_SIZE;
   }
+  if (args_map.find("table_partition_column") != args_map.end()) {
+    sql.table_partition_column = args_map.at("table_partition_column");
+  }
+  sql.table_partitions = 0;
+  if (args_map.find("table_partitions") != args_map.end()) {
+    sql.table_partitions = static_cast<std::size_t>(std::atoll(args_map.at("table_partitions").data()));
+  }
+  sql.table_connections = DEFAULT_TABLE_CONNECTIONS;
+  if (args_map.find("table_connections") != args_map.end()) {
+    sql.table_connections = std::max<std::size_t>(1, std::atoll(args_map.at("table_connections").data()));
+  }
   return sql;
 }
 
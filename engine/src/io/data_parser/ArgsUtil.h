@@ -17,6 +17,8 @@ DataType inferFileType(std::vector<std::string> files, DataType data_type_hint,
 
 bool in(std::string key, std::map<std::string, std::string> args);
 
+bool map_contains(std::string key, std::map<std::string, std::string> args);
+
 bool to_bool(std::string value);
 
 char ord(std::string value);
@@ -31,6 +33,12 @@ cudf::io::orc_reader_options getOrcReaderOptions(const std::map<std::string, std
 
 cudf::io::csv_reader_options getCsvReaderOptions(const std::map<std::string, std::string> & args, cudf::io::arrow_io_source & arrow_source);
 
+/**
+ * The compression of a file, from the compression arg unless it is left to be inferred, and then from the extension of
+ * its uri or its first bytes, since cudf can only infer it from the paths of the files it opens by itself.
+ */
+cudf::io::compression_type infer_compression_type(const std::map<std::string, std::string> & args, const data_handle & handle);
+
 std::map<std::string, std::string> to_map(std::vector<std::string> arg_keys, std::vector<std::string> arg_values);
 
 std::string getDataTypeName(DataType dataType);
@@ -8,10 +8,12 @@
 #include "CSVParser.h"
 #include <arrow/buffer.h>
 #include <arrow/io/memory.h>
+#include <algorithm>
 #include <numeric>
 
 #include <blazingdb/io/Library/Logging/Logger.h>
 #include "ArgsUtil.h"
+#include "LineSplitter.h"
 
 #define checkError(error, txt)                                                                                         \
 	if(error != GDF_SUCCESS) {                                                                                         \
@@ -40,10 +42,29 @@ std::unique_ptr<ral::frame::BlazingTable> csv_parser::parse_batch(
 
 	if(column_indices.size() > 0) {
 
+		// the chunks of the files that were split at row boundaries are read by themselves
+		std::vector<int64_t> chunk_points;
+		if (!row_groups.empty()) {
+			std::lock_guard<std::mutex> lock(split_points_mutex);
+			auto it = split_points.find(handle.uri.toString());
+			if (it != split_points.end()) {
+				chunk_points = it->second;
+			}
+		}
+		int64_t chunk_index = chunk_points.empty() ? 0 : row_groups[0];
+		if (!chunk_points.empty()) {
+			int64_t chunk_offset = chunk_points[chunk_index];
+			int64_t chunk_size = chunk_points[chunk_index + 1] - chunk_offset;
+			file = std::make_shared<arrow::io::BufferReader>(file->ReadAt(chunk_offset, chunk_size).ValueOrDie());
+		}
+
 		// copy column_indices into use_col_indexes (at the moment is ordered only)
 		auto arrow_source = cudf::io::arrow_io_source{file};
 		cudf::io::csv_reader_options args = getCsvReaderOptions(args_map, arrow_source);
 		args.set_use_cols_indexes(column_indices);
+		if (chunk_points.empty()) {
+			args.set_compression(infer_compression_type(args_map, handle));
+		}
 
 		if (args.get_header() > 0) {
 			args.set_header(args.get_header());
@@ -53,9 +74,14 @@ std::unique_ptr<ral::frame::BlazingTable> csv_parser::parse_batch(
 		} 
 		else args.set_header(-1);
 
+		// only the first chunk has the header
+		if (chunk_index > 0) {
+			args.set_header(-1);
+		}
+
 		// Overrride `byte_range_offset` and `byte_range_size`
 		auto iter = args_map.find("max_bytes_chunk_read");
-		if(iter != args_map.end() && !row_groups.empty()) {
+		if(iter != args_map.end() && !row_groups.empty() && chunk_points.empty()) {
 			auto chunk_size = std::stoll(iter->second);
 			args.set_byte_range_offset(chunk_size * row_groups[0]);
 			args.set_byte_range_size(chunk_size);
@@ -101,6 +127,7 @@ void csv_parser::parse_schema(
   auto file = handle.file_handle;
 	auto arrow_source = cudf::io::arrow_io_source{file};
 	cudf::io::csv_reader_options args = getCsvReaderOptions(args_map, arrow_source);
+	args.set_compression(infer_compression_type(args_map, handle));
 
 	// if names were not passed when create_table
 	if (args.get_header() == 0) {
@@ -135,5 +162,68 @@ size_t csv_parser::max_bytes_chunk_size() const {
 	return std::stoll(iter->second);
 }
 
+size_t csv_parser::split_into_chunks(ral::io::data_handle handle, size_t target_bytes) {
+	std::shared_ptr<arrow::io::RandomAccessFile> file = handle.file_handle;
+	if (file == nullptr || target_bytes == 0) {
+		return 1;
+	}
+	// the rows of those options are counted from the start or the end of the whole file
+	for (const std::string & option : {"nrows", "skiprows", "skipfooter"}) {
+		if (args_map.find(option) != args_map.end()) {
+			return 1;
+		}
+	}
+	if (infer_compression_type(args_map, handle) != cudf::io::compression_type::NONE) {
+		return 1;
+	}
+
+	auto line_terminator = args_map.find("lineterminator");
+	char terminator = line_terminator != args_map.end() ? ord(line_terminator->second) : '\n';
+	std::vector<int64_t> points = find_line_split_points(handle, target_bytes, terminator);
+	if (points.empty()) {
+		return 1;
+	}
+	std::lock_guard<std::mutex> lock(split_points_mutex);
+	split_points[handle.uri.toString()] = points;
+	return points.size() - 1;
+}
+
+bool csv_parser::estimate_decoded_bytes(
+	ral::io::data_handle handle,
+	const Schema & schema,
+	std::vector<int> column_indices,
+	std::vector<int> row_groups,
+	std::size_t & bytes) {
+
+	std::shared_ptr<arrow::io::RandomAccessFile> file = handle.file_handle;
+	if (file == nullptr || column_indices.empty()) {
+		return false;
+	}
+
+	std::size_t chunk_bytes = 0;
+	if (!row_groups.empty()) {
+		std::lock_guard<std::mutex> lock(split_points_mutex);
+		auto it = split_points.find(handle.uri.toString());
+		if (it != split_points.end() && row_groups[0] + 1 < static_cast<int>(it->second.size())) {
+			chunk_bytes = it->second[row_groups[0] + 1] - it->second[row_groups[0]];
+		}
+	}
+	if (chunk_bytes == 0 && !row_groups.empty() && max_bytes_chunk_size() > 0) {
+		chunk_bytes = max_bytes_chunk_size();
+	}
+	if (chunk_bytes == 0) {
+		// the size of a compressed file does not tell what it decompresses into
+		if (infer_compression_type(args_map, handle) != cudf::io::compression_type::NONE) {
+			return false;
+		}
+		chunk_bytes = file->GetSize().ValueOrDie();
+	}
+
+	// the text is copied to the GPU, and parsed into columns about as large as the text of the columns that are read
+	std::size_t num_columns = std::max<std::size_t>(schema.get_num_columns(), column_indices.size());
+	bytes = chunk_bytes + chunk_bytes * column_indices.size() / std::max<std::size_t>(num_columns, 1);
+	return true;
+}
+
 } /* namespace io */
 } /* namespace ral */
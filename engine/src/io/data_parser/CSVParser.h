@@ -11,7 +11,9 @@
 #include "DataParser.h"
 #include "../data_provider/DataProvider.h"
 #include "arrow/io/interfaces.h"
+#include <map>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 #include <cudf/io/datasource.hpp>
@@ -36,10 +38,31 @@ public:
 
 	size_t max_bytes_chunk_size() const;
 
+	/**
+	 * @brief Splits a file into chunks of about target_bytes that start and end at row boundaries, so that they can be
+	 * parsed by different tasks. The split points are cached across queries for the files that did not change.
+	 *
+	 * @return the number of chunks, which parse_batch reads by their index in row_groups. 1 if the file is not split,
+	 * which is when it is small, compressed or read with nrows, skiprows or skipfooter.
+	 */
+	size_t split_into_chunks(ral::io::data_handle handle, size_t target_bytes);
+
+	/**
+	 * @brief Estimates the decoded size of a chunk of a file, or of the whole file, from its size in bytes.
+	 */
+	bool estimate_decoded_bytes(
+		ral::io::data_handle handle,
+		const Schema & schema,
+		std::vector<int> column_indices,
+		std::vector<int> row_groups,
+		std::size_t & bytes) override;
+
 	DataType type() const override { return DataType::CSV; }
 
 private:
 	std::map<std::string, std::string> args_map;
+	std::map<std::string, std::vector<int64_t>> split_points; // the offsets of the chunks of the split files, and their sizes last
+	std::mutex split_points_mutex;
 };
 
 } /* namespace io */
@@ -44,6 +44,96 @@ public:
 		return nullptr;
 	}
 
+	/**
+	 * @brief Prunes the row groups of a file that can't have a value of a column between min and max, using the statistics of the file.
+	 *
+	 * @param row_groups The row groups to read, all of them if it is empty. Replaced with the row groups that can have those values.
+	 * @return true if row_groups was replaced, which can leave it empty when none of them has those values.
+	 */
+	virtual bool get_row_groups_in_range(
+		ral::io::data_handle /*handle*/,
+		const std::string & /*column_name*/,
+		int64_t /*min*/,
+		int64_t /*max*/,
+		std::vector<int> & /*row_groups*/) {
+		return false;
+	}
+
+	/**
+	 * @brief Prunes the row groups of a file that can't have any of some values of a column, using the page indexes and the
+	 * bloom filters of the file, which tell more than the min and max of the row groups for the equalities and IN lists.
+	 *
+	 * @param values The values, like the literals of the expressions: 5 or 'abc'.
+	 * @param row_groups The row groups to read, all of them if it is empty. Replaced with the row groups that can have those values.
+	 * @return true if row_groups was replaced, which can leave it empty when none of them has those values.
+	 */
+	virtual bool get_row_groups_with_values(
+		ral::io::data_handle /*handle*/,
+		const std::string & /*column_name*/,
+		const std::vector<std::string> & /*values*/,
+		std::vector<int> & /*row_groups*/) {
+		return false;
+	}
+
+	/**
+	 * @brief Gets the number of rows of every row group that is read from a file, using the metadata of the file.
+	 *
+	 * @param row_groups The row groups to read, all of them if it is empty, in which case it is filled with all of them.
+	 * @param num_rows The number of rows of every one of row_groups.
+	 * @return false if the parser can't tell them.
+	 */
+	virtual bool get_row_group_num_rows(
+		ral::io::data_handle /*handle*/,
+		std::vector<int> & /*row_groups*/,
+		std::vector<cudf::size_type> & /*num_rows*/) {
+		return false;
+	}
+
+	/**
+	 * @brief Gets the uncompressed size in bytes of every row group that is read from a file, using the metadata of the file.
+	 *
+	 * @param row_groups The row groups to read, all of them if it is empty, in which case it is filled with all of them.
+	 * @param byte_sizes The size in bytes of every one of row_groups.
+	 * @return false if the parser can't tell them.
+	 */
+	virtual bool get_row_group_byte_sizes(
+		ral::io::data_handle /*handle*/,
+		std::vector<int> & /*row_groups*/,
+		std::vector<std::size_t> & /*byte_sizes*/) {
+		return false;
+	}
+
+	/**
+	 * @brief Estimates the GPU memory that the columns parse_batch decodes for these columns and row groups of a file
+	 * take, from the metadata of the file, so that the task that reads them is admitted by the executor with it.
+	 *
+	 * @param row_groups The row groups to read, all of them if it is empty.
+	 * @param bytes The estimate.
+	 * @return false if the parser can't tell it.
+	 */
+	virtual bool estimate_decoded_bytes(
+		ral::io::data_handle /*handle*/,
+		const Schema & /*schema*/,
+		std::vector<int> /*column_indices*/,
+		std::vector<int> /*row_groups*/,
+		std::size_t & /*bytes*/) {
+		return false;
+	}
+
+	/**
+	 * @brief Queues the bytes of a file that parse_batch reads for these columns and row groups to be read ahead by the
+	 * data_prefetcher. parse_batch reads them from handle.prefetched once they are set there.
+	 *
+	 * @return nullptr if the parser can't tell what it reads, or if the prefetcher is off.
+	 */
+	virtual std::shared_ptr<prefetched_data> prefetch(
+		ral::io::data_handle /*handle*/,
+		const Schema & /*schema*/,
+		std::vector<int> /*column_indices*/,
+		std::vector<int> /*row_groups*/) {
+		return nullptr;
+	}
+
 	virtual DataType type() const { return 	DataType::UNDEFINED; }
 };
 
@@ -0,0 +1,56 @@
+#include "FlightParser.h"
+
+#include <stdexcept>
+
+#include <cudf/interop.hpp>
+#include <arrow/api.h>
+
+namespace ral {
+namespace io {
+
+flight_parser::flight_parser() {}
+
+flight_parser::~flight_parser() {}
+
+std::unique_ptr<ral::frame::BlazingTable> flight_parser::parse_batch(
+	ral::io::data_handle handle,
+	const Schema & schema,
+	std::vector<int> column_indices,
+	std::vector<cudf::size_type> /*row_groups*/) {
+
+	if(handle.arrow_table == nullptr || column_indices.empty()) {
+		return schema.makeEmptyBlazingTable(column_indices);
+	}
+
+	std::vector<std::string> names;
+	std::vector<std::shared_ptr<arrow::Field>> fields;
+	std::vector<std::shared_ptr<arrow::ChunkedArray>> columns;
+	for(int column_index : column_indices) {
+		const std::string name = schema.get_name(column_index);
+		int field_index = handle.arrow_table->schema()->GetFieldIndex(name);
+		if(field_index < 0) {
+			throw std::runtime_error("ERROR: The column " + name + " is not in the arrow flight");
+		}
+		names.push_back(name);
+		fields.push_back(handle.arrow_table->schema()->field(field_index));
+		columns.push_back(handle.arrow_table->column(field_index));
+	}
+	auto table = arrow::Table::Make(arrow::schema(fields), columns, handle.arrow_table->num_rows());
+
+	return std::make_unique<ral::frame::BlazingTable>(cudf::from_arrow(*table), names);
+}
+
+void flight_parser::parse_schema(ral::io::data_handle handle, ral::io::Schema & schema) {
+	if(handle.arrow_table == nullptr) {
+		return;
+	}
+	// the handle of the schema has no rows, so this only converts the types
+	std::unique_ptr<cudf::table> table = cudf::from_arrow(*handle.arrow_table);
+	auto names = handle.arrow_table->ColumnNames();
+	for(cudf::size_type i = 0; i < table->num_columns(); i++) {
+		schema.add_column(names[i], table->get_column(i).type().id(), i, true);
+	}
+}
+
+} /* namespace io */
+} /* namespace ral */
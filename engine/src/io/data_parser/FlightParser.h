@@ -0,0 +1,35 @@
+#ifndef FLIGHTPARSER_H_
+#define FLIGHTPARSER_H_
+
+#include "DataParser.h"
+
+#include <memory>
+#include <vector>
+
+namespace ral {
+namespace io {
+
+/**
+ * Copies the tables of record batches that the flight_data_provider reads to the GPU, only the columns that are used.
+ */
+class flight_parser : public data_parser {
+public:
+	flight_parser();
+
+	virtual ~flight_parser();
+
+	std::unique_ptr<ral::frame::BlazingTable> parse_batch(
+		ral::io::data_handle handle,
+		const Schema & schema,
+		std::vector<int> column_indices,
+		std::vector<cudf::size_type> row_groups) override;
+
+	void parse_schema(ral::io::data_handle handle, ral::io::Schema & schema) override;
+
+	DataType type() const override { return DataType::ARROW_FLIGHT; }
+};
+
+} /* namespace io */
+} /* namespace ral */
+
+#endif /* FLIGHTPARSER_H_ */
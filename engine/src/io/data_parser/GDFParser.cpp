@@ -11,6 +11,8 @@
 #include <blazingdb/io/Library/Logging/Logger.h>
 #include <cudf/concatenate.hpp>
 
+#include "blazing_table/BlazingColumnView.h"
+
 namespace ral {
 namespace io {
 
@@ -47,7 +49,12 @@ std::unique_ptr<ral::frame::BlazingTable> gdf_parser::parse_batch(
 		column_names_out[i] = data_handle.table_view.names()[idx];
 	}
 
-	return std::make_unique<ral::frame::BlazingTable>(tableView, column_names_out);
+	// the columns are not copied, the dataframe of the table keeps their buffers while the table is registered
+	std::vector<std::unique_ptr<ral::frame::BlazingColumn>> columns;
+	for (int i = 0; i < tableView.num_columns(); i++) {
+		columns.push_back(std::make_unique<ral::frame::BlazingColumnExternalView>(tableView.column(i)));
+	}
+	return std::make_unique<ral::frame::BlazingTable>(std::move(columns), column_names_out);
 }
 
 size_t gdf_parser::get_num_partitions() {return 0;}
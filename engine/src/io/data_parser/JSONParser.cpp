@@ -1,13 +1,65 @@
 #include <arrow/io/file.h>
+#include <arrow/io/memory.h>
 #include <blazingdb/io/Library/Logging/Logger.h>
 #include <numeric>
 
 #include "ArgsUtil.h"
 #include "JSONParser.h"
+#include "LineSplitter.h"
 
 namespace ral {
 namespace io {
 
+namespace {
+
+// the columns of the schemas inferred by earlier tables, keyed by the file they were inferred from and the reader options
+std::mutex schema_cache_mutex;
+std::map<std::string, std::vector<std::pair<std::string, cudf::type_id>>> schema_cache;
+
+/**
+ * The name of a type for the dtypes of the json reader, empty for the types that are left to its inference.
+ */
+std::string to_json_dtype(cudf::type_id type) {
+	switch(type) {
+	case cudf::type_id::INT8: return "int8";
+	case cudf::type_id::INT16: return "int16";
+	case cudf::type_id::INT32: return "int32";
+	case cudf::type_id::INT64: return "int64";
+	case cudf::type_id::UINT8: return "uint8";
+	case cudf::type_id::UINT16: return "uint16";
+	case cudf::type_id::UINT32: return "uint32";
+	case cudf::type_id::UINT64: return "uint64";
+	case cudf::type_id::FLOAT32: return "float32";
+	case cudf::type_id::FLOAT64: return "float64";
+	case cudf::type_id::BOOL8: return "bool";
+	case cudf::type_id::TIMESTAMP_DAYS: return "date32";
+	case cudf::type_id::TIMESTAMP_SECONDS: return "timestamp[s]";
+	case cudf::type_id::TIMESTAMP_MILLISECONDS: return "timestamp[ms]";
+	case cudf::type_id::TIMESTAMP_MICROSECONDS: return "timestamp[us]";
+	case cudf::type_id::TIMESTAMP_NANOSECONDS: return "timestamp[ns]";
+	case cudf::type_id::STRING: return "str";
+	default: return "";
+	}
+}
+
+/**
+ * The dtypes of the columns of the file, by name, so that every chunk of every file is read with the types of the
+ * schema instead of the ones its own rows would be inferred with.
+ */
+std::vector<std::string> get_json_dtypes(const Schema & schema) {
+	std::vector<std::string> dtypes;
+	for(size_t i = 0; i < schema.get_num_columns(); i++) {
+		std::string dtype = to_json_dtype(schema.get_dtype(i));
+		if(dtype.empty()) {
+			return {};
+		}
+		dtypes.push_back(schema.get_name(i) + ":" + dtype);
+	}
+	return dtypes;
+}
+
+} // namespace
+
 json_parser::json_parser(std::map<std::string, std::string> args_map_) : args_map{args_map_} {}
 
 json_parser::~json_parser() {
@@ -17,15 +69,40 @@ json_parser::~json_parser() {
 std::unique_ptr<ral::frame::BlazingTable> json_parser::parse_batch(ral::io::data_handle handle,
 	const Schema & schema,
 	std::vector<int> column_indices,
-	std::vector<cudf::size_type> /*row_groups*/) {
+	std::vector<cudf::size_type> row_groups) {
 	std::shared_ptr<arrow::io::RandomAccessFile> file = handle.file_handle;
 	if(file == nullptr) {
 		return schema.makeEmptyBlazingTable(column_indices);
 	}
 
 	if(column_indices.size() > 0) {
+		// the chunks of the files that were split at line boundaries are read by themselves
+		std::vector<int64_t> chunk_points;
+		if (!row_groups.empty()) {
+			std::lock_guard<std::mutex> lock(split_points_mutex);
+			auto it = split_points.find(handle.uri.toString());
+			if (it != split_points.end()) {
+				chunk_points = it->second;
+			}
+		}
+		if (!chunk_points.empty()) {
+			int64_t chunk_offset = chunk_points[row_groups[0]];
+			int64_t chunk_size = chunk_points[row_groups[0] + 1] - chunk_offset;
+			file = std::make_shared<arrow::io::BufferReader>(file->ReadAt(chunk_offset, chunk_size).ValueOrDie());
+		}
+
 		auto arrow_source = cudf::io::arrow_io_source{file};
 		cudf::io::json_reader_options json_opts = getJsonReaderOptions(args_map, arrow_source);
+		if (chunk_points.empty()) {
+			json_opts.compression(infer_compression_type(args_map, handle));
+		}
+		// the reader of this cudf version has no column selection, but with the types of the schema it infers nothing
+		if (!map_contains("dtype", args_map)) {
+			std::vector<std::string> dtypes = get_json_dtypes(schema);
+			if (!dtypes.empty()) {
+				json_opts.dtypes(dtypes);
+			}
+		}
 
 		cudf::io::table_with_metadata json_table = cudf::io::read_json(json_opts);
 
@@ -51,28 +128,82 @@ std::unique_ptr<ral::frame::BlazingTable> json_parser::parse_batch(ral::io::data
 
 void json_parser::parse_schema(ral::io::data_handle handle, ral::io::Schema & schema) {
   auto file = handle.file_handle;
+
+	int64_t file_size = -1;
+	std::string key = get_file_version_key(handle.uri, file_size);
+	if (!key.empty()) {
+		for(auto && arg : args_map) {
+			key += "|" + arg.first + "=" + arg.second;
+		}
+		std::lock_guard<std::mutex> lock(schema_cache_mutex);
+		auto it = schema_cache.find(key);
+		if (it != schema_cache.end()) {
+			file->Close();
+			for(size_t i = 0; i < it->second.size(); i++) {
+				schema.add_column(it->second[i].first, it->second[i].second, i, true);
+			}
+			return;
+		}
+	}
+
 	auto arrow_source = cudf::io::arrow_io_source{file};
 	cudf::io::json_reader_options args = getJsonReaderOptions(args_map, arrow_source);
+	args.compression(infer_compression_type(args_map, handle));
 
-	int64_t num_bytes = file->GetSize().ValueOrDie();
+	// cudf can not read byte ranges of compressed files
+	if(args.get_compression() == cudf::io::compression_type::NONE) {
+		int64_t num_bytes = file->GetSize().ValueOrDie();
 
-	// lets only read up to 48192 bytes. We are assuming that a full row will always be less than that
-	if(num_bytes > 48192) {
-		num_bytes = 48192;
+		// lets only read up to 48192 bytes. We are assuming that a full row will always be less than that
+		if(num_bytes > 48192) {
+			num_bytes = 48192;
+		}
+		args.set_byte_range_offset(0);
+		args.set_byte_range_size(num_bytes);
 	}
-	args.set_byte_range_offset(0);
-	args.set_byte_range_size(num_bytes);
 
 	cudf::io::table_with_metadata table_and_metadata = cudf::io::read_json(args);
 	file->Close();
 
+	std::vector<std::pair<std::string, cudf::type_id>> columns;
 	for(auto i = 0; i < table_and_metadata.tbl->num_columns(); i++) {
 		std::string name = table_and_metadata.metadata.column_names[i];
 		cudf::type_id type = table_and_metadata.tbl->get_column(i).type().id();
 		size_t file_index = i;
 		bool is_in_file = true;
 		schema.add_column(name, type, file_index, is_in_file);
+		columns.emplace_back(name, type);
+	}
+	if (!key.empty() && !columns.empty()) {
+		std::lock_guard<std::mutex> lock(schema_cache_mutex);
+		schema_cache[key] = columns;
+	}
+}
+
+size_t json_parser::split_into_chunks(ral::io::data_handle handle, size_t target_bytes) {
+	if (handle.file_handle == nullptr || target_bytes == 0) {
+		return 1;
+	}
+	// a json document that is not made of lines can't be split, and the byte ranges are counted from the whole file
+	if (map_contains("lines", args_map) && !to_bool(args_map.at("lines"))) {
+		return 1;
+	}
+	for (const std::string & option : {"byte_range_offset", "byte_range_size"}) {
+		if (map_contains(option, args_map)) {
+			return 1;
+		}
+	}
+	if (infer_compression_type(args_map, handle) != cudf::io::compression_type::NONE) {
+		return 1;
+	}
+
+	std::vector<int64_t> points = find_line_split_points(handle, target_bytes, '\n');
+	if (points.empty()) {
+		return 1;
 	}
+	std::lock_guard<std::mutex> lock(split_points_mutex);
+	split_points[handle.uri.toString()] = points;
+	return points.size() - 1;
 }
 
 } /* namespace io */
@@ -3,7 +3,9 @@
 #include <arrow/io/interfaces.h>
 #include <cudf/io/datasource.hpp>
 #include <cudf/io/json.hpp>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 #include "DataParser.h"
@@ -22,12 +24,28 @@ public:
 		std::vector<int> column_indices,
 		std::vector<cudf::size_type> row_groups) override;
 
+	/**
+	 * @brief Infers the schema from the start of the file. The schemas inferred are cached across queries, keyed by
+	 * the file they were inferred from and the options of the reader, so the tables created again on files that did
+	 * not change don't read them again.
+	 */
 	void parse_schema(ral::io::data_handle handle, Schema & schema);
 
+	/**
+	 * @brief Splits a file of json lines into chunks of about target_bytes that start and end at line boundaries, so
+	 * that they can be parsed by different tasks, like csv_parser::split_into_chunks.
+	 *
+	 * @return the number of chunks, which parse_batch reads by their index in row_groups. 1 if the file is not split,
+	 * which is when it is small, compressed, not made of json lines or read with a byte range.
+	 */
+	size_t split_into_chunks(ral::io::data_handle handle, size_t target_bytes);
+
 	DataType type() const override { return DataType::JSON; }
 
 private:
 	std::map<std::string, std::string> args_map;
+	std::map<std::string, std::vector<int64_t>> split_points; // the offsets of the chunks of the split files, and their sizes last
+	std::mutex split_points_mutex;
 };
 
 } /* namespace io */
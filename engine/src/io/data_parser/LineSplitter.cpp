@@ -0,0 +1,108 @@
+#include "LineSplitter.h"
+
+#include <algorithm>
+#include <map>
+#include <mutex>
+
+#include <arrow/buffer.h>
+#include <blazingdb/io/Config/BlazingContext.h>
+
+namespace ral {
+namespace io {
+
+namespace {
+
+// the lines are found by reading this much at a time after the points where the files are split
+const int64_t LINE_BOUNDARY_WINDOW_SIZE = 64 * 1024;
+
+// the split points of the files that earlier scans split, keyed by their uri, size and modification time
+std::mutex split_points_cache_mutex;
+std::map<std::string, std::vector<int64_t>> split_points_cache;
+
+/**
+ * Finds the first line that starts at or after position, which is right after a line terminator. Like the byte ranges
+ * of cudf, it does not tell the line terminators inside of quoted fields apart.
+ */
+int64_t find_line_start(arrow::io::RandomAccessFile & file, int64_t position, int64_t file_size, char line_terminator) {
+	int64_t offset = position - 1;
+	while (offset < file_size) {
+		std::shared_ptr<arrow::Buffer> window = file.ReadAt(offset, std::min(LINE_BOUNDARY_WINDOW_SIZE, file_size - offset)).ValueOrDie();
+		if (window == nullptr || window->size() == 0) {
+			break;
+		}
+		const char * data = reinterpret_cast<const char *>(window->data());
+		const char * terminator = std::find(data, data + window->size(), line_terminator);
+		if (terminator != data + window->size()) {
+			return offset + (terminator - data) + 1;
+		}
+		offset += window->size();
+	}
+	return file_size;
+}
+
+} // namespace
+
+std::string get_file_version_key(const Uri & uri, int64_t & file_size) {
+	file_size = -1;
+	if (uri.isEmpty()) {
+		return "";
+	}
+	try {
+		FileStatus status = BlazingContext::getInstance()->getFileSystemManager()->getFileStatus(uri);
+		file_size = status.getFileSize();
+		if (status.getModificationTime() > 0) {
+			return uri.toString() + "|" + std::to_string(file_size) + "|" + std::to_string(status.getModificationTime());
+		}
+	} catch (const std::exception &) {
+		// the file is not cached
+	}
+	return "";
+}
+
+std::vector<int64_t> find_line_split_points(ral::io::data_handle handle, size_t target_bytes, char line_terminator) {
+	std::shared_ptr<arrow::io::RandomAccessFile> file = handle.file_handle;
+	if (file == nullptr || target_bytes == 0) {
+		return {};
+	}
+
+	int64_t file_size = -1;
+	std::string key = get_file_version_key(handle.uri, file_size);
+	if (file_size < 0) {
+		file_size = file->GetSize().ValueOrDie();
+	}
+	if (file_size <= static_cast<int64_t>(target_bytes)) {
+		return {};
+	}
+
+	std::vector<int64_t> points;
+	if (!key.empty()) {
+		std::lock_guard<std::mutex> lock(split_points_cache_mutex);
+		auto it = split_points_cache.find(key);
+		if (it != split_points_cache.end()) {
+			points = it->second;
+		}
+	}
+	if (points.empty()) {
+		points.push_back(0);
+		for (int64_t position = target_bytes; position < file_size; position += target_bytes) {
+			int64_t line_start = find_line_start(*file, std::max(position, points.back() + 1), file_size, line_terminator);
+			if (line_start >= file_size) {
+				break;
+			}
+			points.push_back(line_start);
+		}
+		points.push_back(file_size);
+		if (!key.empty()) {
+			std::lock_guard<std::mutex> lock(split_points_cache_mutex);
+			split_points_cache[key] = points;
+		}
+	}
+
+	if (points.size() <= 2) {
+		return {};
+	}
+	return points;
+}
+
+}  // namespace io
+}  // namespace ral
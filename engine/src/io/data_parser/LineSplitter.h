@@ -0,0 +1,30 @@
+#ifndef BLAZINGDB_RAL_SRC_IO_DATA_PARSER_LINESPLITTER_H_
+#define BLAZINGDB_RAL_SRC_IO_DATA_PARSER_LINESPLITTER_H_
+
+#include <string>
+#include <vector>
+
+#include "../data_provider/DataProvider.h"
+
+namespace ral {
+namespace io {
+
+/**
+ * @brief A key of the file that changes when the file changes, made of its uri, size and modification time.
+ * @param file_size set to the size of the file when its status could be read, and to -1 otherwise
+ * @return empty if the status of the file could not be read or it has no modification time
+ */
+std::string get_file_version_key(const Uri & uri, int64_t & file_size);
+
+/**
+ * @brief Finds the points where a text file can be split into chunks of about target_bytes that start and end at line
+ * boundaries, so that they can be parsed by different tasks. The points are cached across queries for the files that
+ * did not change.
+ * @return the offsets of the chunks and the size of the file last, or an empty vector if the file is not split
+ */
+std::vector<int64_t> find_line_split_points(ral::io::data_handle handle, size_t target_bytes, char line_terminator);
+
+}  // namespace io
+}  // namespace ral
+
+#endif	// BLAZINGDB_RAL_SRC_IO_DATA_PARSER_LINESPLITTER_H_
@@ -5,12 +5,59 @@
 
 #include <blazingdb/io/Library/Logging/Logger.h>
 
+#include <algorithm>
 #include <numeric>
 #include "ArgsUtil.h"
 
 namespace ral {
 namespace io {
 
+namespace {
+
+// The stripes play the part of the row groups of parquet, and their statistics are the only metadata cudf parses
+bool read_stripe_statistics(const ral::io::data_handle & handle, cudf::io::parsed_orc_statistics & statistics) {
+	if (handle.file_handle == nullptr) {
+		return false;
+	}
+	auto arrow_source = cudf::io::arrow_io_source{handle.file_handle};
+	statistics = cudf::io::read_parsed_orc_statistics(cudf::io::source_info{&arrow_source});
+	return !statistics.stripes_stats.empty();
+}
+
+// The number of rows of a stripe is the number of values of `col_0`, its root struct
+bool get_stripe_num_rows(const std::vector<cudf::io::column_statistics> & stripe_statistics, int64_t & num_rows) {
+	if (stripe_statistics.empty() || stripe_statistics[0].number_of_values() == nullptr) {
+		return false;
+	}
+	num_rows = *stripe_statistics[0].number_of_values();
+	return true;
+}
+
+void fill_all_stripes(const cudf::io::parsed_orc_statistics & statistics, std::vector<int> & stripes) {
+	if (stripes.empty()) {
+		stripes.resize(statistics.stripes_stats.size());
+		std::iota(stripes.begin(), stripes.end(), 0);
+	}
+}
+
+// The stripe footers with the stream sizes are not parsed by cudf, so the decoded size of a column of a stripe is
+// estimated from its number of values, and the total length of its strings
+std::size_t estimate_column_bytes(const cudf::io::column_statistics & column_statistics, int64_t stripe_rows) {
+	std::size_t num_values = column_statistics.number_of_values() != nullptr ? *column_statistics.number_of_values() : stripe_rows;
+	auto string_stat = column_statistics.type() == cudf::io::statistics_type::STRING ?
+		column_statistics.type_specific_stats<cudf::io::string_statistics>() : nullptr;
+	if (string_stat != nullptr && string_stat->has_sum()) {
+		return *string_stat->sum() + num_values * sizeof(cudf::size_type);
+	} else if (column_statistics.type() == cudf::io::statistics_type::BUCKET) {
+		return num_values;
+	} else if (column_statistics.type() == cudf::io::statistics_type::DATE) {
+		return num_values * sizeof(int32_t);
+	}
+	return num_values * sizeof(int64_t);
+}
+
+} // namespace
+
 orc_parser::orc_parser(std::map<std::string, std::string> args_map_) : args_map{args_map_} {}
 
 orc_parser::~orc_parser() {
@@ -86,5 +133,138 @@ std::unique_ptr<ral::frame::BlazingTable> orc_parser::get_metadata(
 	return minmax_metadata_table;
 }
 
+bool orc_parser::get_row_groups_in_range(
+	ral::io::data_handle handle,
+	const std::string & column_name,
+	int64_t min,
+	int64_t max,
+	std::vector<int> & row_groups) {
+
+	cudf::io::parsed_orc_statistics statistics;
+	if (!read_stripe_statistics(handle, statistics)) {
+		return false;
+	}
+	auto it = std::find(statistics.column_names.begin(), statistics.column_names.end(), column_name);
+	if (it == statistics.column_names.end()) {
+		return false;
+	}
+	std::size_t column_index = std::distance(statistics.column_names.begin(), it);
+
+	std::vector<int> candidates = row_groups;
+	fill_all_stripes(statistics, candidates);
+
+	std::vector<int> stripes_in_range;
+	for (int stripe : candidates) {
+		const std::vector<cudf::io::column_statistics> & stripe_statistics = statistics.stripes_stats[stripe];
+		if (column_index >= stripe_statistics.size() || stripe_statistics[column_index].type() != cudf::io::statistics_type::INT) {
+			stripes_in_range.push_back(stripe);
+			continue;
+		}
+		auto type_stat = stripe_statistics[column_index].type_specific_stats<cudf::io::integer_statistics>();
+		if (type_stat == nullptr || !type_stat->has_minimum() || !type_stat->has_maximum() ||
+				(*type_stat->maximum() >= min && *type_stat->minimum() <= max)) {
+			stripes_in_range.push_back(stripe);
+		}
+	}
+
+	if (stripes_in_range.size() == candidates.size()) {
+		return false;
+	}
+	row_groups = std::move(stripes_in_range);
+	return true;
+}
+
+bool orc_parser::get_row_group_num_rows(
+	ral::io::data_handle handle,
+	std::vector<int> & row_groups,
+	std::vector<cudf::size_type> & num_rows) {
+
+	cudf::io::parsed_orc_statistics statistics;
+	if (!read_stripe_statistics(handle, statistics)) {
+		return false;
+	}
+	std::vector<int> stripes = row_groups;
+	fill_all_stripes(statistics, stripes);
+
+	std::vector<cudf::size_type> stripe_num_rows;
+	for (int stripe : stripes) {
+		int64_t stripe_rows;
+		if (!get_stripe_num_rows(statistics.stripes_stats[stripe], stripe_rows)) {
+			return false;
+		}
+		stripe_num_rows.push_back(stripe_rows);
+	}
+	row_groups = std::move(stripes);
+	num_rows = std::move(stripe_num_rows);
+	return true;
+}
+
+bool orc_parser::get_row_group_byte_sizes(
+	ral::io::data_handle handle,
+	std::vector<int> & row_groups,
+	std::vector<std::size_t> & byte_sizes) {
+
+	cudf::io::parsed_orc_statistics statistics;
+	if (!read_stripe_statistics(handle, statistics)) {
+		return false;
+	}
+	std::vector<int> stripes = row_groups;
+	fill_all_stripes(statistics, stripes);
+
+	std::vector<std::size_t> stripe_byte_sizes;
+	for (int stripe : stripes) {
+		const std::vector<cudf::io::column_statistics> & stripe_statistics = statistics.stripes_stats[stripe];
+		int64_t stripe_rows;
+		if (!get_stripe_num_rows(stripe_statistics, stripe_rows)) {
+			return false;
+		}
+		std::size_t byte_size = 0;
+		for (std::size_t column_index = 1; column_index < stripe_statistics.size(); column_index++) {
+			byte_size += estimate_column_bytes(stripe_statistics[column_index], stripe_rows);
+		}
+		stripe_byte_sizes.push_back(byte_size);
+	}
+	row_groups = std::move(stripes);
+	byte_sizes = std::move(stripe_byte_sizes);
+	return true;
+}
+
+bool orc_parser::estimate_decoded_bytes(
+	ral::io::data_handle handle,
+	const Schema & schema,
+	std::vector<int> column_indices,
+	std::vector<int> row_groups,
+	std::size_t & bytes) {
+
+	cudf::io::parsed_orc_statistics statistics;
+	if (!read_stripe_statistics(handle, statistics)) {
+		return false;
+	}
+	std::vector<std::size_t> statistics_indices;
+	for (int column_index : column_indices) {
+		auto it = std::find(statistics.column_names.begin(), statistics.column_names.end(), schema.get_name(column_index));
+		if (it == statistics.column_names.end()) {
+			return false;
+		}
+		statistics_indices.push_back(std::distance(statistics.column_names.begin(), it));
+	}
+	fill_all_stripes(statistics, row_groups);
+
+	bytes = 0;
+	for (int stripe : row_groups) {
+		const std::vector<cudf::io::column_statistics> & stripe_statistics = statistics.stripes_stats[stripe];
+		int64_t stripe_rows;
+		if (!get_stripe_num_rows(stripe_statistics, stripe_rows)) {
+			return false;
+		}
+		for (std::size_t statistics_index : statistics_indices) {
+			if (statistics_index < stripe_statistics.size()) {
+				bytes += estimate_column_bytes(stripe_statistics[statistics_index], stripe_rows);
+			}
+		}
+	}
+	return true;
+}
+
 } /* namespace io */
 } /* namespace ral */
@@ -31,6 +31,34 @@ public:
 		std::vector<ral::io::data_handle> handles,
 		int offset);
 
+	bool get_row_groups_in_range(
+		ral::io::data_handle handle,
+		const std::string & column_name,
+		int64_t min,
+		int64_t max,
+		std::vector<int> & row_groups) override;
+
+	bool get_row_group_num_rows(
+		ral::io::data_handle handle,
+		std::vector<int> & row_groups,
+		std::vector<cudf::size_type> & num_rows) override;
+
+	bool get_row_group_byte_sizes(
+		ral::io::data_handle handle,
+		std::vector<int> & row_groups,
+		std::vector<std::size_t> & byte_sizes) override;
+
+	/**
+	 * @brief Sums the decoded sizes of these columns in the statistics of the stripes, like get_row_group_byte_sizes
+	 * does for all of them.
+	 */
+	bool estimate_decoded_bytes(
+		ral::io::data_handle handle,
+		const Schema & schema,
+		std::vector<int> column_indices,
+		std::vector<int> row_groups,
+		std::size_t & bytes) override;
+
 	DataType type() const override { return DataType::ORC; }
 
 private:
@@ -1,9 +1,16 @@
 
 #include "metadata/parquet_metadata.h"
+#include "metadata/parquet_metadata_cache.h"
+#include "metadata/parquet_page_index.h"
 
 #include "ParquetParser.h"
+#include "io/data_provider/DataPrefetcher.h"
+#include <blazingdb/io/FileSystem/RangedReadCache.h>
 #include "utilities/CommonOperations.h"
 
+#include <algorithm>
+#include <cstring>
+#include <limits>
 #include <numeric>
 
 #include <arrow/io/file.h>
@@ -19,6 +26,118 @@ namespace io {
 
 namespace cudf_io = cudf::io;
 
+namespace {
+
+/**
+ * Gets the byte ranges the reader reads for these columns and row groups of a file: its footer, which is read again by
+ * the reader, and the column chunks, from the metadata of the file.
+ */
+std::vector<byte_range> get_read_ranges(const ral::io::data_handle & handle,
+	const std::vector<std::string> & col_names,
+	const std::vector<int> & row_groups) {
+
+	std::shared_ptr<arrow::io::RandomAccessFile> file = handle.file_handle;
+	std::shared_ptr<parquet::FileMetaData> file_metadata = parquet_metadata_cache::get_instance().get_file_metadata(handle);
+
+	std::vector<int> leaf_columns;
+	const parquet::SchemaDescriptor * file_schema = file_metadata->schema();
+	for (int i = 0; i < file_schema->num_columns(); i++) {
+		std::string top_name = file_schema->Column(i)->path()->ToDotVector()[0];
+		if (std::find(col_names.begin(), col_names.end(), top_name) != col_names.end()) {
+			leaf_columns.push_back(i);
+		}
+	}
+
+	std::vector<int> read_row_groups = row_groups;
+	if (read_row_groups.empty()) {
+		read_row_groups.resize(file_metadata->num_row_groups());
+		std::iota(read_row_groups.begin(), read_row_groups.end(), 0);
+	}
+
+	// the footer and the column chunks
+	int64_t file_size = file->GetSize().ValueOrDie();
+	int64_t footer_size = static_cast<int64_t>(file_metadata->size()) + 8;
+	std::vector<byte_range> ranges{{file_size - footer_size, footer_size}};
+	for (int row_group : read_row_groups) {
+		auto row_group_metadata = file_metadata->RowGroup(row_group);
+		for (int leaf_column : leaf_columns) {
+			auto column_chunk = row_group_metadata->ColumnChunk(leaf_column);
+			int64_t offset = column_chunk->data_page_offset();
+			if (column_chunk->has_dictionary_page() && column_chunk->dictionary_page_offset() > 0) {
+				offset = std::min(offset, column_chunk->dictionary_page_offset());
+			}
+			ranges.push_back({offset, column_chunk->total_compressed_size()});
+		}
+	}
+
+	// the chunks of the columns of a row group are next to each other, so they are read at once
+	std::sort(ranges.begin(), ranges.end(), [](const byte_range & a, const byte_range & b) { return a.offset < b.offset; });
+	std::vector<byte_range> merged_ranges;
+	for (const byte_range & range : ranges) {
+		if (!merged_ranges.empty() && range.offset <= merged_ranges.back().offset + merged_ranges.back().length) {
+			int64_t end = std::max(merged_ranges.back().offset + merged_ranges.back().length, range.offset + range.length);
+			merged_ranges.back().length = end - merged_ranges.back().offset;
+		} else {
+			merged_ranges.push_back(range);
+		}
+	}
+	return merged_ranges;
+}
+
+/**
+ * Tells the files of the remote filesystems which ranges the reader is going to read, so that they are fetched in
+ * parallel with as few requests as they can, instead of one request for every read of the reader.
+ */
+void plan_remote_reads(const ral::io::data_handle & handle,
+	const std::vector<std::string> & col_names,
+	const std::vector<int> & row_groups) {
+
+	auto ranged_file = std::dynamic_pointer_cast<RangedReadableFile>(handle.file_handle);
+	if (ranged_file == nullptr) {
+		return;
+	}
+	std::vector<ByteRange> ranges;
+	for (const byte_range & range : get_read_ranges(handle, col_names, row_groups)) {
+		ranges.push_back({range.offset, range.length});
+	}
+	ranged_file->planReads(ranges);
+}
+
+// a dictionary chunk of strings without statistics is assumed to decode into this many times its uncompressed size
+constexpr std::size_t DICTIONARY_STRING_EXPANSION = 4;
+
+// the bytes a column chunk takes once cudf decodes it into a column of num_rows
+std::size_t estimate_column_chunk_bytes(const parquet::ColumnChunkMetaData & column_chunk, std::size_t num_rows) {
+	std::size_t num_values = column_chunk.num_values();
+	std::size_t null_mask_bytes = (num_rows + 7) / 8;
+	switch (column_chunk.type()) {
+		case parquet::Type::BOOLEAN: return num_values + null_mask_bytes;
+		case parquet::Type::INT32:
+		case parquet::Type::FLOAT: return num_values * 4 + null_mask_bytes;
+		case parquet::Type::INT64:
+		case parquet::Type::INT96:
+		case parquet::Type::DOUBLE: return num_values * 8 + null_mask_bytes;
+		case parquet::Type::BYTE_ARRAY: break;
+		default: return column_chunk.total_uncompressed_size() + null_mask_bytes;
+	}
+
+	std::size_t offsets_bytes = (num_rows + 1) * sizeof(cudf::size_type);
+	std::size_t uncompressed_bytes = column_chunk.total_uncompressed_size();
+	if (!column_chunk.has_dictionary_page()) {
+		// the plain values are their lengths and their characters
+		return uncompressed_bytes + offsets_bytes + null_mask_bytes;
+	}
+	std::shared_ptr<parquet::Statistics> statistics = column_chunk.is_stats_set() ? column_chunk.statistics() : nullptr;
+	if (statistics != nullptr && statistics->HasMinMax()) {
+		auto string_statistics = std::static_pointer_cast<parquet::ByteArrayStatistics>(statistics);
+		std::size_t average_length = (string_statistics->min().len + string_statistics->max().len) / 2;
+		return std::max(num_values * average_length, uncompressed_bytes) + offsets_bytes + null_mask_bytes;
+	}
+	return DICTIONARY_STRING_EXPANSION * uncompressed_bytes + offsets_bytes + null_mask_bytes;
+}
+
+} // namespace
+
 parquet_parser::parquet_parser() {
 	// TODO Auto-generated constructor stub
 }
@@ -40,7 +159,12 @@ std::unique_ptr<ral::frame::BlazingTable> parquet_parser::parse_batch(
 	if(column_indices.size() > 0) {
 		// Fill data to pq_args
 		auto arrow_source = cudf_io::arrow_io_source{file};
-		cudf_io::parquet_reader_options pq_args = cudf_io::parquet_reader_options::builder(cudf_io::source_info{&arrow_source});
+		std::unique_ptr<prefetched_source> prefetched;
+		if (handle.prefetched != nullptr) {
+			prefetched = std::make_unique<prefetched_source>(handle.prefetched);
+		}
+		cudf_io::parquet_reader_options pq_args = cudf_io::parquet_reader_options::builder(
+			prefetched != nullptr ? cudf_io::source_info{prefetched.get()} : cudf_io::source_info{&arrow_source});
 
 		pq_args.enable_convert_strings_to_categories(false);
 		pq_args.enable_use_pandas_metadata(false);
@@ -53,13 +177,25 @@ std::unique_ptr<ral::frame::BlazingTable> parquet_parser::parse_batch(
 
 		pq_args.set_columns(col_names);
 
+		// the ranges that were prefetched are already in memory
+		if (prefetched == nullptr) {
+			plan_remote_reads(handle, col_names, std::vector<int>(row_groups.begin(), row_groups.end()));
+		}
+
 		// when we set `get_metadata=False` we need to send and empty full_row_groups
 		std::vector<std::vector<cudf::size_type>> full_row_groups;
 		if (row_groups.size() != 0) {
 			full_row_groups = std::vector<std::vector<cudf::size_type>>(1, row_groups);
 		}
 
-		pq_args.set_row_groups(full_row_groups);
+		// a slice of the rows of a large row group is read by its position in the file, which cudf does not take
+		// together with the row groups
+		if (handle.num_rows >= 0) {
+			pq_args.set_skip_rows(handle.skip_rows);
+			pq_args.set_num_rows(handle.num_rows);
+		} else {
+			pq_args.set_row_groups(full_row_groups);
+		}
 
 		auto result = cudf::io::read_parquet(pq_args);
 
@@ -79,31 +215,36 @@ std::unique_ptr<ral::frame::BlazingTable> parquet_parser::parse_batch(
 void parquet_parser::parse_schema(
 	ral::io::data_handle handle, ral::io::Schema & schema) {
 
-  auto file = handle.file_handle;
-	auto parquet_reader = parquet::ParquetFileReader::Open(file);
-	auto num_rows_parquet_reader = parquet_reader->metadata()->num_rows();
+	auto file = handle.file_handle;
+	parquet_metadata_cache & metadata_cache = parquet_metadata_cache::get_instance();
+	auto num_rows_parquet_reader = metadata_cache.get_file_metadata(handle)->num_rows();
 	if (num_rows_parquet_reader == 0) {
-		parquet_reader->Close();
 		return; // if the file has no rows, we dont want cudf_io to try to read it
 	}
 
     schema.set_row_count(num_rows_parquet_reader);
 
-	auto arrow_source = cudf_io::arrow_io_source{file};
-	cudf_io::parquet_reader_options pq_args = cudf_io::parquet_reader_options::builder(cudf_io::source_info{&arrow_source});
+	std::vector<parquet_schema_column> columns;
+	if (!metadata_cache.get_schema_columns(handle, columns)) {
+		auto arrow_source = cudf_io::arrow_io_source{file};
+		cudf_io::parquet_reader_options pq_args = cudf_io::parquet_reader_options::builder(cudf_io::source_info{&arrow_source});
+
+		pq_args.enable_convert_strings_to_categories(false);
+		pq_args.enable_use_pandas_metadata(false);
+		pq_args.set_num_rows(1);  // we only need the metadata, so one row is fine
 
-	pq_args.enable_convert_strings_to_categories(false);
-	pq_args.enable_use_pandas_metadata(false);
-	pq_args.set_num_rows(1);  // we only need the metadata, so one row is fine
+		cudf_io::table_with_metadata table_out = cudf_io::read_parquet(pq_args);
 
-	cudf_io::table_with_metadata table_out = cudf_io::read_parquet(pq_args);
+		for(int i = 0; i < table_out.tbl->num_columns(); i++) {
+			columns.push_back({table_out.metadata.column_names.at(i), table_out.tbl->get_column(i).type().id()});
+		}
+		metadata_cache.put_schema_columns(handle, columns);
+	}
 
-	for(int i = 0; i < table_out.tbl->num_columns(); i++) {
-		cudf::type_id type = table_out.tbl->get_column(i).type().id();
+	for(size_t i = 0; i < columns.size(); i++) {
 		size_t file_index = i;
 		bool is_in_file = true;
-		std::string name = table_out.metadata.column_names.at(i);
-		schema.add_column(name, type, file_index, is_in_file);
+		schema.add_column(columns[i].name, columns[i].type, file_index, is_in_file);
 	}
 }
 
@@ -114,8 +255,10 @@ std::unique_ptr<ral::frame::BlazingTable> parquet_parser::get_metadata(
 	std::vector<std::unique_ptr<parquet::ParquetFileReader>> parquet_readers(handles.size());
 	for(size_t file_index = 0; file_index < handles.size(); file_index++) {
 		threads[file_index] = BlazingThread([&, file_index]() {
-		  parquet_readers[file_index] =
-			  std::move(parquet::ParquetFileReader::Open(handles[file_index].file_handle));
+		  // the readers only read the statistics of the footers, which can be cached
+		  parquet_readers[file_index] = std::move(parquet::ParquetFileReader::Open(handles[file_index].file_handle,
+			  parquet::default_reader_properties(),
+			  parquet_metadata_cache::get_instance().get_file_metadata(handles[file_index])));
 		  std::shared_ptr<parquet::FileMetaData> file_metadata = parquet_readers[file_index]->metadata();
 		  num_row_groups[file_index] = file_metadata->num_row_groups();
 		});
@@ -135,5 +278,276 @@ std::unique_ptr<ral::frame::BlazingTable> parquet_parser::get_metadata(
 	return minmax_metadata_table;
 }
 
+bool parquet_parser::get_row_groups_in_range(
+	ral::io::data_handle handle,
+	const std::string & column_name,
+	int64_t min,
+	int64_t max,
+	std::vector<int> & row_groups) {
+
+	if (handle.file_handle == nullptr) {
+		return false;
+	}
+	std::shared_ptr<parquet::FileMetaData> file_metadata = parquet_metadata_cache::get_instance().get_file_metadata(handle);
+	const parquet::SchemaDescriptor * file_schema = file_metadata->schema();
+	int column_index = file_schema->ColumnIndex(column_name);
+	if (column_index < 0) {
+		return false;
+	}
+	const parquet::ColumnDescriptor * column = file_schema->Column(column_index);
+	auto logical_type = column->converted_type();
+	// the statistics of the unsigned columns are not sorted as signed integers
+	bool is_signed = logical_type == parquet::ConvertedType::NONE || logical_type == parquet::ConvertedType::INT_8 ||
+		logical_type == parquet::ConvertedType::INT_16 || logical_type == parquet::ConvertedType::INT_32 ||
+		logical_type == parquet::ConvertedType::INT_64;
+	if (!is_signed || (column->physical_type() != parquet::Type::INT32 && column->physical_type() != parquet::Type::INT64)) {
+		return false;
+	}
+
+	std::vector<int> candidates = row_groups;
+	if (candidates.empty()) {
+		candidates.resize(file_metadata->num_row_groups());
+		std::iota(candidates.begin(), candidates.end(), 0);
+	}
+
+	std::vector<int> row_groups_in_range;
+	for (int row_group : candidates) {
+		auto column_metadata = file_metadata->RowGroup(row_group)->ColumnChunk(column_index);
+		std::shared_ptr<parquet::Statistics> statistics = column_metadata->is_stats_set() ? column_metadata->statistics() : nullptr;
+		if (statistics == nullptr || !statistics->HasMinMax()) {
+			row_groups_in_range.push_back(row_group);
+			continue;
+		}
+		int64_t row_group_min, row_group_max;
+		if (column->physical_type() == parquet::Type::INT32) {
+			auto converted_statistics = std::static_pointer_cast<parquet::Int32Statistics>(statistics);
+			row_group_min = converted_statistics->min();
+			row_group_max = converted_statistics->max();
+		} else {
+			auto converted_statistics = std::static_pointer_cast<parquet::Int64Statistics>(statistics);
+			row_group_min = converted_statistics->min();
+			row_group_max = converted_statistics->max();
+		}
+		if (row_group_max >= min && row_group_min <= max) {
+			row_groups_in_range.push_back(row_group);
+		}
+	}
+
+	if (row_groups_in_range.size() == candidates.size()) {
+		return false;
+	}
+	row_groups = std::move(row_groups_in_range);
+	return true;
+}
+
+namespace {
+
+int compare_plain_values(const parquet::ColumnDescriptor & column, bool is_signed, const std::string & left, const std::string & right) {
+	if (column.physical_type() == parquet::Type::INT32 || column.physical_type() == parquet::Type::INT64) {
+		int64_t left_value = 0, right_value = 0;
+		std::memcpy(&left_value, left.data(), std::min(left.size(), sizeof(left_value)));
+		std::memcpy(&right_value, right.data(), std::min(right.size(), sizeof(right_value)));
+		if (column.physical_type() == parquet::Type::INT32) {
+			left_value = is_signed ? static_cast<int64_t>(static_cast<int32_t>(left_value)) : static_cast<uint32_t>(left_value);
+			right_value = is_signed ? static_cast<int64_t>(static_cast<int32_t>(right_value)) : static_cast<uint32_t>(right_value);
+		} else if (!is_signed) {
+			return static_cast<uint64_t>(left_value) < static_cast<uint64_t>(right_value) ? -1 : (left_value == right_value ? 0 : 1);
+		}
+		return left_value < right_value ? -1 : (left_value == right_value ? 0 : 1);
+	}
+	// the byte arrays are sorted as unsigned bytes
+	return left.compare(right);
+}
+
+} // namespace
+
+bool parquet_parser::get_row_groups_with_values(
+	ral::io::data_handle handle,
+	const std::string & column_name,
+	const std::vector<std::string> & values,
+	std::vector<int> & row_groups) {
+
+	if (handle.file_handle == nullptr || values.empty()) {
+		return false;
+	}
+	std::shared_ptr<parquet::FileMetaData> file_metadata = parquet_metadata_cache::get_instance().get_file_metadata(handle);
+	const parquet::SchemaDescriptor * file_schema = file_metadata->schema();
+	int column_index = file_schema->ColumnIndex(column_name);
+	if (column_index < 0) {
+		return false;
+	}
+	const parquet::ColumnDescriptor * column = file_schema->Column(column_index);
+	auto logical_type = column->converted_type();
+	bool is_signed = logical_type != parquet::ConvertedType::UINT_8 && logical_type != parquet::ConvertedType::UINT_16 &&
+		logical_type != parquet::ConvertedType::UINT_32 && logical_type != parquet::ConvertedType::UINT_64;
+	if (column->physical_type() == parquet::Type::BYTE_ARRAY && logical_type != parquet::ConvertedType::UTF8) {
+		return false;
+	}
+	std::vector<std::string> encoded_values;
+	if (!parquet_encode_plain_values(*column, values, encoded_values)) {
+		return false;
+	}
+
+	std::vector<std::vector<parquet_column_chunk_indexes>> indexes = read_parquet_column_chunk_indexes(*handle.file_handle);
+	if (static_cast<int>(indexes.size()) != file_metadata->num_row_groups()) {
+		return false;
+	}
+
+	std::vector<int> candidates = row_groups;
+	if (candidates.empty()) {
+		candidates.resize(file_metadata->num_row_groups());
+		std::iota(candidates.begin(), candidates.end(), 0);
+	}
+
+	std::vector<int> row_groups_with_values;
+	for (int row_group : candidates) {
+		if (row_group >= static_cast<int>(indexes.size()) || column_index >= static_cast<int>(indexes[row_group].size())) {
+			row_groups_with_values.push_back(row_group);
+			continue;
+		}
+		const parquet_column_chunk_indexes & column_indexes = indexes[row_group][column_index];
+
+		// a row group whose min and max have a value can still have no page whose min and max have it
+		bool may_have_values = true;
+		parquet_page_ranges page_ranges;
+		if (read_parquet_page_ranges(*handle.file_handle, column_indexes, page_ranges)) {
+			may_have_values = false;
+			for (std::size_t page = 0; page < page_ranges.min_values.size() && !may_have_values; page++) {
+				for (const std::string & value : encoded_values) {
+					if (compare_plain_values(*column, is_signed, page_ranges.min_values[page], value) <= 0 &&
+						compare_plain_values(*column, is_signed, value, page_ranges.max_values[page]) <= 0) {
+						may_have_values = true;
+						break;
+					}
+				}
+			}
+		}
+
+		std::vector<uint8_t> bloom_filter;
+		if (may_have_values && read_parquet_bloom_filter(*handle.file_handle, column_indexes, bloom_filter)) {
+			may_have_values = std::any_of(encoded_values.begin(), encoded_values.end(), [&bloom_filter](const std::string & value) {
+				return parquet_bloom_filter_find(bloom_filter, parquet_bloom_filter_hash(value));
+			});
+		}
+
+		if (may_have_values) {
+			row_groups_with_values.push_back(row_group);
+		}
+	}
+
+	if (row_groups_with_values.size() == candidates.size()) {
+		return false;
+	}
+	row_groups = std::move(row_groups_with_values);
+	return true;
+}
+
+bool parquet_parser::get_row_group_num_rows(
+	ral::io::data_handle handle,
+	std::vector<int> & row_groups,
+	std::vector<cudf::size_type> & num_rows) {
+
+	if (handle.file_handle == nullptr) {
+		return false;
+	}
+	std::shared_ptr<parquet::FileMetaData> file_metadata = parquet_metadata_cache::get_instance().get_file_metadata(handle);
+	if (row_groups.empty()) {
+		row_groups.resize(file_metadata->num_row_groups());
+		std::iota(row_groups.begin(), row_groups.end(), 0);
+	}
+
+	num_rows.clear();
+	for (int row_group : row_groups) {
+		num_rows.push_back(file_metadata->RowGroup(row_group)->num_rows());
+	}
+	return true;
+}
+
+bool parquet_parser::get_row_group_byte_sizes(
+	ral::io::data_handle handle,
+	std::vector<int> & row_groups,
+	std::vector<std::size_t> & byte_sizes) {
+
+	if (handle.file_handle == nullptr) {
+		return false;
+	}
+	std::shared_ptr<parquet::FileMetaData> file_metadata = parquet_metadata_cache::get_instance().get_file_metadata(handle);
+	if (row_groups.empty()) {
+		row_groups.resize(file_metadata->num_row_groups());
+		std::iota(row_groups.begin(), row_groups.end(), 0);
+	}
+
+	byte_sizes.clear();
+	for (int row_group : row_groups) {
+		byte_sizes.push_back(file_metadata->RowGroup(row_group)->total_byte_size());
+	}
+	return true;
+}
+
+bool parquet_parser::estimate_decoded_bytes(
+	ral::io::data_handle handle,
+	const Schema & schema,
+	std::vector<int> column_indices,
+	std::vector<int> row_groups,
+	std::size_t & bytes) {
+
+	if (handle.file_handle == nullptr) {
+		return false;
+	}
+	std::shared_ptr<parquet::FileMetaData> file_metadata = parquet_metadata_cache::get_instance().get_file_metadata(handle);
+	std::vector<std::string> col_names;
+	for (int column_index : column_indices) {
+		col_names.push_back(schema.get_name(column_index));
+	}
+	std::vector<int> leaf_columns;
+	const parquet::SchemaDescriptor * file_schema = file_metadata->schema();
+	for (int i = 0; i < file_schema->num_columns(); i++) {
+		std::string top_name = file_schema->Column(i)->path()->ToDotVector()[0];
+		if (std::find(col_names.begin(), col_names.end(), top_name) != col_names.end()) {
+			leaf_columns.push_back(i);
+		}
+	}
+	if (row_groups.empty()) {
+		row_groups.resize(file_metadata->num_row_groups());
+		std::iota(row_groups.begin(), row_groups.end(), 0);
+	}
+
+	bytes = 0;
+	int64_t num_rows = 0;
+	for (int row_group : row_groups) {
+		auto row_group_metadata = file_metadata->RowGroup(row_group);
+		for (int leaf_column : leaf_columns) {
+			bytes += estimate_column_chunk_bytes(*row_group_metadata->ColumnChunk(leaf_column), row_group_metadata->num_rows());
+		}
+		num_rows += row_group_metadata->num_rows();
+	}
+	// a slice of the rows of the row groups decodes into its part of them
+	if (handle.num_rows >= 0 && num_rows > 0) {
+		bytes = static_cast<std::size_t>(static_cast<double>(bytes) * std::min(handle.num_rows, num_rows) / num_rows);
+	}
+	return true;
+}
+
+std::shared_ptr<prefetched_data> parquet_parser::prefetch(
+	ral::io::data_handle handle,
+	const Schema & schema,
+	std::vector<int> column_indices,
+	std::vector<int> row_groups) {
+
+	std::shared_ptr<arrow::io::RandomAccessFile> file = handle.file_handle;
+	if (file == nullptr || column_indices.empty()) {
+		return nullptr;
+	}
+	std::vector<std::string> col_names;
+	for (int column_index : column_indices) {
+		col_names.push_back(schema.get_name(column_index));
+	}
+
+	// reading the metadata is I/O too, so the ranges are found by the prefetcher
+	return data_prefetcher::get_instance().prefetch(file, [handle, col_names, row_groups]() {
+		return get_read_ranges(handle, col_names, row_groups);
+	});
+}
+
 } /* namespace io */
 } /* namespace ral */
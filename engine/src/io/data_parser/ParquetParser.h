@@ -36,6 +36,50 @@ public:
 		std::vector<ral::io::data_handle> handles,
 		int offset);
 
+	bool get_row_groups_in_range(
+		ral::io::data_handle handle,
+		const std::string & column_name,
+		int64_t min,
+		int64_t max,
+		std::vector<int> & row_groups) override;
+
+	bool get_row_groups_with_values(
+		ral::io::data_handle handle,
+		const std::string & column_name,
+		const std::vector<std::string> & values,
+		std::vector<int> & row_groups) override;
+
+	bool get_row_group_num_rows(
+		ral::io::data_handle handle,
+		std::vector<int> & row_groups,
+		std::vector<cudf::size_type> & num_rows) override;
+
+	bool get_row_group_byte_sizes(
+		ral::io::data_handle handle,
+		std::vector<int> & row_groups,
+		std::vector<std::size_t> & byte_sizes) override;
+
+	/**
+	 * @brief Sums the decoded sizes of the column chunks of these columns in the footer of the file. The fixed width
+	 * values are counted by their number, and the strings by their uncompressed size, or by the lengths of their min
+	 * and max when they are in a dictionary, since the dictionary only has every value once.
+	 */
+	bool estimate_decoded_bytes(
+		ral::io::data_handle handle,
+		const Schema & schema,
+		std::vector<int> column_indices,
+		std::vector<int> row_groups,
+		std::size_t & bytes) override;
+
+	/**
+	 * @brief Prefetches the footer of the file and the column chunks of these columns in these row groups.
+	 */
+	std::shared_ptr<prefetched_data> prefetch(
+		ral::io::data_handle handle,
+		const Schema & schema,
+		std::vector<int> column_indices,
+		std::vector<int> row_groups) override;
+
 	DataType type() const override { return DataType::PARQUET; }
 };
 
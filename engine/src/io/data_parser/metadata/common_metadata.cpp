@@ -4,6 +4,9 @@
 #include "orc_metadata.h"
 #include "utilities/CommonOperations.h"
 
+#include <cudf/column/column_factories.hpp>
+#include <cudf/detail/utilities/vector_factories.hpp>
+
 std::unique_ptr<ral::frame::BlazingTable> make_dummy_metadata_table_from_col_names(std::vector<std::string> col_names) {
 	const int ncols = col_names.size();
 	std::vector<std::string> metadata_col_names;
@@ -50,6 +53,18 @@ std::unique_ptr<cudf::column> make_cudf_column_from_vector(cudf::data_type dtype
 	}
 }
 
+std::unique_ptr<cudf::column> make_cudf_strings_column_from_vector(const std::vector<std::string> & vector) {
+	std::vector<char> chars;
+	std::vector<cudf::size_type> offsets(1, 0); // the first offset value must be 0
+	for (const std::string & value : vector) {
+		chars.insert(chars.end(), value.begin(), value.end());
+		offsets.push_back(chars.size());
+	}
+	auto d_chars = cudf::detail::make_device_uvector_sync(chars);
+	auto d_offsets = cudf::detail::make_device_uvector_sync(offsets);
+	return cudf::make_strings_column(d_chars, d_offsets, {}, 0);
+}
+
 std::basic_string<char> get_typed_vector_content(cudf::type_id dtype, std::vector<int64_t> &vector) {
   std::basic_string<char> output;
   switch (dtype) {
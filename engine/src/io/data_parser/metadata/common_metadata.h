@@ -10,6 +10,9 @@ std::unique_ptr<cudf::column> make_cudf_column_from_vector(
 
 std::unique_ptr<cudf::column> make_empty_column(cudf::data_type type);
 
+// Makes a STRING column without nulls, used for the min and max of the string columns
+std::unique_ptr<cudf::column> make_cudf_strings_column_from_vector(const std::vector<std::string> & vector);
+
 std::basic_string<char> get_typed_vector_content(
 	cudf::type_id dtype, std::vector<int64_t> &vector);
 
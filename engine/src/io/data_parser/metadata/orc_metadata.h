@@ -4,12 +4,12 @@
 #include "common_metadata.h"
 #include <cudf/io/orc_metadata.hpp>
 
-cudf::type_id to_dtype(cudf::io::statistics_type stat_type);
+cudf::type_id statistic_to_dtype(cudf::io::statistics_type stat_type);
 
 void set_min_max(
 	std::vector<std::vector<int64_t>> & minmax_metadata_table,
-	cudf::io::column_statistics & statistic,
-    int col_index);
+	int col_index, const cudf::io::column_statistics * statistic,
+	cudf::io::statistics_type stat_type);
 
 std::unique_ptr<ral::frame::BlazingTable> get_minmax_metadata(
     std::vector<cudf::io::parsed_orc_statistics> & statistics,
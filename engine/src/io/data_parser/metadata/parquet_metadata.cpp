@@ -125,6 +125,23 @@ void set_min_max(
 	}	
 }
 
+// The strings are compared by their bytes, like parquet orders the UTF8 byte arrays, and no UTF-8 string starts with
+// a 0xFF byte, so "\xFF" is greater than all of them when the row group has no max
+void set_min_max_string(
+	std::vector<std::vector<std::string>> &minmax_string_metadata_table,
+	int col_index, std::shared_ptr<parquet::Statistics> &statistics) {
+
+	std::string min = "";
+	std::string max = "\xFF";
+	if (statistics != nullptr && statistics->HasMinMax()) {
+		auto convertedStats = std::static_pointer_cast<parquet::ByteArrayStatistics>(statistics);
+		min = std::string(reinterpret_cast<const char *>(convertedStats->min().ptr), convertedStats->min().len);
+		max = std::string(reinterpret_cast<const char *>(convertedStats->max().ptr), convertedStats->max().len);
+	}
+	minmax_string_metadata_table[col_index].push_back(min);
+	minmax_string_metadata_table[col_index + 1].push_back(max);
+}
+
 // This function is copied and adapted from cudf
 cudf::type_id to_dtype(parquet::Type::type physical, parquet::ConvertedType::type logical) {
 
@@ -185,6 +202,7 @@ std::unique_ptr<ral::frame::BlazingTable> get_minmax_metadata(
 	std::vector<std::string> metadata_names;
 	std::vector<cudf::data_type> metadata_dtypes;
 	std::vector<size_t> columns_with_metadata;
+	std::vector<std::string> null_count_names;
 
 	// NOTE: we must try to use and load always a parquet reader that row groups > 0
 	int valid_parquet_reader = -1;
@@ -224,7 +242,10 @@ std::unique_ptr<ral::frame::BlazingTable> get_minmax_metadata(
 			auto logical_type = column->converted_type();
 			cudf::data_type dtype = cudf::data_type (to_dtype(physical_type, logical_type)) ;
 
-			if (columnMetaData->is_stats_set() && dtype.id() != cudf::type_id::STRING) {
+			// only the BYTE_ARRAY that are not decimals are read as strings
+			bool has_min_max = dtype.id() != cudf::type_id::STRING ||
+				(physical_type == parquet::Type::type::BYTE_ARRAY && logical_type != parquet::ConvertedType::type::DECIMAL);
+			if (columnMetaData->is_stats_set() && has_min_max) {
 				auto statistics = columnMetaData->statistics();
 					auto col_name_min = "min_" + std::to_string(colIndex) + "_" + column->name();
 					metadata_dtypes.push_back(dtype);
@@ -235,9 +256,18 @@ std::unique_ptr<ral::frame::BlazingTable> get_minmax_metadata(
 					metadata_names.push_back(col_name_max);
 
 					columns_with_metadata.push_back(colIndex);
+					null_count_names.push_back("nulls_" + std::to_string(colIndex) + "_" + column->name());
 			}
 		}
 
+		// the null counts are compared with row_count by the skip data of the IS NULL and IS NOT NULL predicates
+		for (const std::string & null_count_name : null_count_names) {
+			metadata_dtypes.push_back(cudf::data_type{cudf::type_id::INT64});
+			metadata_names.push_back(null_count_name);
+		}
+		metadata_dtypes.push_back(cudf::data_type{cudf::type_id::INT64});
+		metadata_names.push_back("row_count");
+
 		metadata_dtypes.push_back(cudf::data_type{cudf::type_id::INT32});
 		metadata_names.push_back("file_handle_index");
 		metadata_dtypes.push_back(cudf::data_type{cudf::type_id::INT32});
@@ -247,18 +277,21 @@ std::unique_ptr<ral::frame::BlazingTable> get_minmax_metadata(
 	size_t num_metadata_cols = metadata_names.size();
 
 	std::vector<std::vector<std::vector<int64_t>>> minmax_metadata_table_per_file(parquet_readers.size());
+	std::vector<std::vector<std::vector<std::string>>> minmax_string_metadata_table_per_file(parquet_readers.size());
+	size_t null_count_col_offset = columns_with_metadata.size() * 2;
 
 	std::vector<BlazingThread> threads(parquet_readers.size());
 	std::mutex guard;
 	for (size_t file_index = 0; file_index < parquet_readers.size(); file_index++){
 		// NOTE: It is really important to mantain the `file_index order` in order to match the same order in HiveMetadata
 		threads[file_index] = BlazingThread([&guard, metadata_offset,  &parquet_readers, file_index,
-									&minmax_metadata_table_per_file, num_metadata_cols, columns_with_metadata](){
+									&minmax_metadata_table_per_file, &minmax_string_metadata_table_per_file, num_metadata_cols, columns_with_metadata, null_count_col_offset](){
 
 		std::shared_ptr<parquet::FileMetaData> file_metadata = parquet_readers[file_index]->metadata();
 
 		if (file_metadata->num_row_groups() > 0){
 			std::vector<std::vector<int64_t>> this_minmax_metadata_table(num_metadata_cols);
+			std::vector<std::vector<std::string>> this_minmax_string_metadata_table(num_metadata_cols);
 
 			int num_row_groups = file_metadata->num_row_groups();
 			const parquet::SchemaDescriptor *schema = file_metadata->schema();
@@ -269,21 +302,36 @@ std::unique_ptr<ral::frame::BlazingTable> get_minmax_metadata(
 				for (size_t col_count = 0; col_count < columns_with_metadata.size(); col_count++) {
 					const parquet::ColumnDescriptor *column = schema->Column(columns_with_metadata[col_count]);
 					auto columnMetaData = rowGroupMetadata->ColumnChunk(columns_with_metadata[col_count]);
+					// the null count is -1 when it is not known
+					int64_t null_count = -1;
 					if (columnMetaData->is_stats_set()) {
 						auto statistics = columnMetaData->statistics();
-						set_min_max(this_minmax_metadata_table,
-									col_count * 2,
-									column->physical_type(),
-									column->converted_type(),
-									statistics);
+						if (column->physical_type() == parquet::Type::type::BYTE_ARRAY) {
+							set_min_max_string(this_minmax_string_metadata_table, col_count * 2, statistics);
+						} else {
+							set_min_max(this_minmax_metadata_table,
+										col_count * 2,
+										column->physical_type(),
+										column->converted_type(),
+										statistics);
+						}
+						if (statistics->HasNullCount()) {
+							null_count = statistics->null_count();
+						}
+					} else if (column->physical_type() == parquet::Type::type::BYTE_ARRAY) {
+						std::shared_ptr<parquet::Statistics> no_statistics;
+						set_min_max_string(this_minmax_string_metadata_table, col_count * 2, no_statistics);
 					}
+					this_minmax_metadata_table[null_count_col_offset + col_count].push_back(null_count);
 				}
+				this_minmax_metadata_table[this_minmax_metadata_table.size() - 3].push_back(rowGroupMetadata->num_rows());
 				this_minmax_metadata_table[this_minmax_metadata_table.size() - 2].push_back(metadata_offset + file_index);
 				this_minmax_metadata_table[this_minmax_metadata_table.size() - 1].push_back(row_group_index);
 			}
 
 			guard.lock();
 			minmax_metadata_table_per_file[file_index] = std::move(this_minmax_metadata_table);
+			minmax_string_metadata_table_per_file[file_index] = std::move(this_minmax_string_metadata_table);
 			guard.unlock();
 		}
 		});
@@ -298,11 +346,21 @@ std::unique_ptr<ral::frame::BlazingTable> get_minmax_metadata(
 			std::copy(minmax_metadata_table_per_file[i][j].begin(), minmax_metadata_table_per_file[i][j].end(), std::back_inserter(minmax_metadata_table[j]));
 		}
 	}
+	std::vector<std::vector<std::string>> minmax_string_metadata_table = minmax_string_metadata_table_per_file[valid_parquet_reader];
+	for (size_t i = valid_parquet_reader + 1; i < minmax_string_metadata_table_per_file.size(); i++) {
+		for (size_t j = 0; j < minmax_string_metadata_table_per_file[i].size(); j++) {
+			std::copy(minmax_string_metadata_table_per_file[i][j].begin(), minmax_string_metadata_table_per_file[i][j].end(), std::back_inserter(minmax_string_metadata_table[j]));
+		}
+	}
 
 	std::vector<std::unique_ptr<cudf::column>> minmax_metadata_gdf_table(minmax_metadata_table.size());
 	for (size_t index = 0; index < 	minmax_metadata_table.size(); index++) {
-		auto vector = minmax_metadata_table[index];
 		auto dtype = metadata_dtypes[index];
+		if (dtype.id() == cudf::type_id::STRING) {
+			minmax_metadata_gdf_table[index] = make_cudf_strings_column_from_vector(minmax_string_metadata_table[index]);
+			continue;
+		}
+		auto vector = minmax_metadata_table[index];
 		auto content =  get_typed_vector_content(dtype.id(), vector);
 		minmax_metadata_gdf_table[index] = make_cudf_column_from_vector(dtype, content, total_num_row_groups);
 	}
@@ -0,0 +1,183 @@
+#include "parquet_metadata_cache.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <sstream>
+#include <sys/stat.h>
+
+#include <arrow/io/memory.h>
+#include <blazingdb/io/Config/BlazingContext.h>
+
+namespace ral {
+namespace io {
+
+void parquet_metadata_cache::configure(std::size_t max_files, const std::string & sidecar_directory) {
+	std::lock_guard<std::mutex> lock(cache_mutex);
+	this->max_files = max_files;
+	this->sidecar_directory = sidecar_directory;
+	if (!sidecar_directory.empty()) {
+		mkdir(sidecar_directory.c_str(), 0777); // fails harmlessly if it already exists
+	}
+	while (entries.size() > max_files) {
+		entries_by_key.erase(entries.back().key);
+		entries.pop_back();
+	}
+	keys_by_file.clear();
+}
+
+std::string parquet_metadata_cache::get_key(const data_handle & handle) {
+	if (handle.file_handle == nullptr || handle.uri.isEmpty()) {
+		return "";
+	}
+	{
+		std::lock_guard<std::mutex> lock(cache_mutex);
+		if (max_files == 0) {
+			return "";
+		}
+		auto it = keys_by_file.find(handle.file_handle.get());
+		if (it != keys_by_file.end() && it->second.first.lock() == handle.file_handle) {
+			return it->second.second;
+		}
+	}
+
+	std::string key;
+	try {
+		FileStatus status = BlazingContext::getInstance()->getFileSystemManager()->getFileStatus(handle.uri);
+		// without the modification time there is no way to know whether the file changed
+		if (status.getModificationTime() > 0) {
+			key = handle.uri.toString() + "|" + std::to_string(status.getFileSize()) + "|" + std::to_string(status.getModificationTime());
+		}
+	} catch (const std::exception &) {
+		// the file is read as if there was no cache, which reports its errors if there are any
+	}
+
+	std::lock_guard<std::mutex> lock(cache_mutex);
+	if (keys_by_file.size() > max_files) {
+		for (auto it = keys_by_file.begin(); it != keys_by_file.end();) {
+			it = it->second.first.expired() ? keys_by_file.erase(it) : std::next(it);
+		}
+	}
+	keys_by_file[handle.file_handle.get()] = {handle.file_handle, key};
+	return key;
+}
+
+std::shared_ptr<parquet::FileMetaData> parquet_metadata_cache::get_file_metadata(const data_handle & handle) {
+	std::string key = get_key(handle);
+	if (!key.empty()) {
+		std::lock_guard<std::mutex> lock(cache_mutex);
+		auto it = entries_by_key.find(key);
+		if (it != entries_by_key.end()) {
+			entries.splice(entries.begin(), entries, it->second);
+			return it->second->file_metadata;
+		}
+	}
+	if (key.empty()) {
+		return parquet::ParquetFileReader::Open(handle.file_handle)->metadata();
+	}
+
+	std::shared_ptr<parquet::FileMetaData> file_metadata = read_sidecar(key);
+	if (file_metadata == nullptr) {
+		file_metadata = parquet::ParquetFileReader::Open(handle.file_handle)->metadata();
+		write_sidecar(key, file_metadata);
+	}
+	insert(key, file_metadata);
+	return file_metadata;
+}
+
+bool parquet_metadata_cache::get_schema_columns(const data_handle & handle, std::vector<parquet_schema_column> & columns) {
+	std::string key = get_key(handle);
+	std::lock_guard<std::mutex> lock(cache_mutex);
+	auto it = entries_by_key.find(key);
+	if (key.empty() || it == entries_by_key.end() || !it->second->has_schema_columns) {
+		return false;
+	}
+	columns = it->second->schema_columns;
+	return true;
+}
+
+void parquet_metadata_cache::put_schema_columns(const data_handle & handle, const std::vector<parquet_schema_column> & columns) {
+	std::string key = get_key(handle);
+	std::lock_guard<std::mutex> lock(cache_mutex);
+	auto it = entries_by_key.find(key);
+	if (key.empty() || it == entries_by_key.end()) {
+		return;
+	}
+	it->second->schema_columns = columns;
+	it->second->has_schema_columns = true;
+}
+
+void parquet_metadata_cache::insert(const std::string & key, std::shared_ptr<parquet::FileMetaData> file_metadata) {
+	std::lock_guard<std::mutex> lock(cache_mutex);
+	if (max_files == 0 || entries_by_key.count(key) > 0) {
+		return;
+	}
+	entries.push_front({key, std::move(file_metadata)});
+	entries_by_key[key] = entries.begin();
+	if (entries.size() > max_files) {
+		entries_by_key.erase(entries.back().key);
+		entries.pop_back();
+	}
+}
+
+std::string parquet_metadata_cache::get_sidecar_path(const std::string & key) {
+	std::lock_guard<std::mutex> lock(cache_mutex);
+	if (sidecar_directory.empty()) {
+		return "";
+	}
+	std::stringstream path;
+	path << sidecar_directory << "/" << std::hex << std::hash<std::string>{}(key) << ".footer";
+	return path.str();
+}
+
+std::shared_ptr<parquet::FileMetaData> parquet_metadata_cache::read_sidecar(const std::string & key) {
+	std::string path = get_sidecar_path(key);
+	if (path.empty()) {
+		return nullptr;
+	}
+	// the first line is the key of the file, since different keys can have the same hash
+	std::ifstream sidecar(path, std::ios::binary);
+	std::string sidecar_key;
+	if (!std::getline(sidecar, sidecar_key) || sidecar_key != key) {
+		return nullptr;
+	}
+	std::string serialized((std::istreambuf_iterator<char>(sidecar)), std::istreambuf_iterator<char>());
+	try {
+		uint32_t length = serialized.size();
+		return parquet::FileMetaData::Make(serialized.data(), &length);
+	} catch (const std::exception &) {
+		return nullptr;
+	}
+}
+
+void parquet_metadata_cache::write_sidecar(const std::string & key, const std::shared_ptr<parquet::FileMetaData> & file_metadata) {
+	std::string path = get_sidecar_path(key);
+	if (path.empty()) {
+		return;
+	}
+	try {
+		auto stream = arrow::io::BufferOutputStream::Create().ValueOrDie();
+		file_metadata->WriteTo(stream.get());
+		std::shared_ptr<arrow::Buffer> serialized = stream->Finish().ValueOrDie();
+
+		// written to another file first, so that the processes that read the directory never see half of a footer
+		std::string temporary_path = path + "." + std::to_string(reinterpret_cast<std::uintptr_t>(file_metadata.get()));
+		{
+			std::ofstream sidecar(temporary_path, std::ios::binary | std::ios::trunc);
+			sidecar << key << '\n';
+			sidecar.write(reinterpret_cast<const char *>(serialized->data()), serialized->size());
+			if (!sidecar) {
+				std::remove(temporary_path.c_str());
+				return;
+			}
+		}
+		std::rename(temporary_path.c_str(), path.c_str());
+	} catch (const std::exception &) {
+		// the sidecar is only a cache
+	}
+}
+
+}  // namespace io
+}  // namespace ral
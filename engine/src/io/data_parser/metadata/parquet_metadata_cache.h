@@ -0,0 +1,92 @@
+#ifndef BLAZINGDB_RAL_SRC_IO_DATA_PARSER_METADATA_PARQUET_METADATA_CACHE_H_
+#define BLAZINGDB_RAL_SRC_IO_DATA_PARSER_METADATA_PARQUET_METADATA_CACHE_H_
+
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <cudf/types.hpp>
+#include <parquet/api/reader.h>
+
+#include "io/data_provider/DataProvider.h"
+
+namespace ral {
+namespace io {
+
+struct parquet_schema_column {
+	std::string name;
+	cudf::type_id type;
+};
+
+/**
+ * @brief A process wide cache of the footers of the parquet files, keyed by their uri, size and modification time, so
+ * that the schema inference and the skip data statistics of the files that did not change don't read and parse their
+ * footers again for every query.
+ *
+ * The footers can also be kept in a sidecar directory, so that they outlive the process. Only the files whose
+ * filesystem tells their modification time are cached.
+ */
+class parquet_metadata_cache {
+public:
+	static parquet_metadata_cache & get_instance() {
+		static parquet_metadata_cache instance;
+		return instance;
+	}
+
+	/**
+	 * @brief Keeps the footers of up to max_files files, and writes them to sidecar_directory too unless it is empty.
+	 * A max_files of 0 turns the cache off. It is set by PARQUET_METADATA_CACHE_MAX_FILES and
+	 * PARQUET_METADATA_CACHE_DIRECTORY when the engine is initialized.
+	 */
+	void configure(std::size_t max_files, const std::string & sidecar_directory);
+
+	/**
+	 * @brief Returns the footer of the file of the handle, which is read from the file only if it is not cached.
+	 */
+	std::shared_ptr<parquet::FileMetaData> get_file_metadata(const data_handle & handle);
+
+	/**
+	 * @brief The columns that the schema inference found for a file, which are kept with its footer.
+	 * @return false if they are not cached.
+	 */
+	bool get_schema_columns(const data_handle & handle, std::vector<parquet_schema_column> & columns);
+
+	void put_schema_columns(const data_handle & handle, const std::vector<parquet_schema_column> & columns);
+
+private:
+	struct entry {
+		std::string key;
+		std::shared_ptr<parquet::FileMetaData> file_metadata;
+		std::vector<parquet_schema_column> schema_columns;
+		bool has_schema_columns = false;
+	};
+
+	parquet_metadata_cache() = default;
+	parquet_metadata_cache(parquet_metadata_cache &&) = delete;
+	parquet_metadata_cache(const parquet_metadata_cache &) = delete;
+	parquet_metadata_cache & operator=(parquet_metadata_cache &&) = delete;
+	parquet_metadata_cache & operator=(const parquet_metadata_cache &) = delete;
+
+	// the uri, size and modification time of the file, or an empty key if it can not be cached
+	std::string get_key(const data_handle & handle);
+	std::string get_sidecar_path(const std::string & key);
+	std::shared_ptr<parquet::FileMetaData> read_sidecar(const std::string & key);
+	void write_sidecar(const std::string & key, const std::shared_ptr<parquet::FileMetaData> & file_metadata);
+	void insert(const std::string & key, std::shared_ptr<parquet::FileMetaData> file_metadata);
+
+	std::mutex cache_mutex;
+	std::size_t max_files = 0;
+	std::string sidecar_directory;
+	std::list<entry> entries; // the most recently used first
+	std::map<std::string, std::list<entry>::iterator> entries_by_key;
+	// the keys of the files that are open, so that the status of a file is asked for once and not on every read of its footer
+	std::map<const arrow::io::RandomAccessFile *, std::pair<std::weak_ptr<arrow::io::RandomAccessFile>, std::string>> keys_by_file;
+};
+
+}  // namespace io
+}  // namespace ral
+
+#endif	// BLAZINGDB_RAL_SRC_IO_DATA_PARSER_METADATA_PARQUET_METADATA_CACHE_H_
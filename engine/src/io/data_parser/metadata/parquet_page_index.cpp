@@ -0,0 +1,598 @@
+#include "parquet_page_index.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <regex>
+#include <stdexcept>
+
+#include <arrow/buffer.h>
+
+#include "io/data_parser/sql/sqlcommon.h"
+
+namespace ral {
+namespace io {
+
+namespace {
+
+// the thrift compact protocol of the parquet metadata, see
+// https://github.com/apache/thrift/blob/master/doc/specs/thrift-compact-protocol.md
+enum thrift_type : uint8_t {
+	THRIFT_STOP = 0,
+	THRIFT_BOOLEAN_TRUE = 1,
+	THRIFT_BOOLEAN_FALSE = 2,
+	THRIFT_BYTE = 3,
+	THRIFT_I16 = 4,
+	THRIFT_I32 = 5,
+	THRIFT_I64 = 6,
+	THRIFT_DOUBLE = 7,
+	THRIFT_BINARY = 8,
+	THRIFT_LIST = 9,
+	THRIFT_SET = 10,
+	THRIFT_MAP = 11,
+	THRIFT_STRUCT = 12
+};
+
+class thrift_compact_reader {
+public:
+	thrift_compact_reader(const uint8_t * data, std::size_t size) : pos(data), end(data + size) {}
+
+	std::size_t consumed(const uint8_t * data) const { return pos - data; }
+
+	uint8_t read_byte() {
+		if (pos >= end) {
+			throw std::runtime_error("ERROR: The parquet metadata ends too soon");
+		}
+		return *pos++;
+	}
+
+	uint64_t read_varint() {
+		uint64_t value = 0;
+		for (int shift = 0; shift < 64; shift += 7) {
+			uint8_t byte = read_byte();
+			value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+			if ((byte & 0x80) == 0) {
+				return value;
+			}
+		}
+		throw std::runtime_error("ERROR: The parquet metadata has a bad varint");
+	}
+
+	int64_t read_zigzag() {
+		uint64_t value = read_varint();
+		return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+	}
+
+	std::string read_binary() {
+		uint64_t size = read_varint();
+		if (size > static_cast<uint64_t>(end - pos)) {
+			throw std::runtime_error("ERROR: The parquet metadata ends too soon");
+		}
+		std::string value(reinterpret_cast<const char *>(pos), size);
+		pos += size;
+		return value;
+	}
+
+	// returns false at the end of the struct
+	bool read_field_header(int16_t & field_id, uint8_t & type) {
+		uint8_t byte = read_byte();
+		type = byte & 0x0f;
+		if (type == THRIFT_STOP) {
+			return false;
+		}
+		uint8_t delta = byte >> 4;
+		field_id = delta != 0 ? field_id + delta : static_cast<int16_t>(read_zigzag());
+		return true;
+	}
+
+	void read_list_header(uint64_t & size, uint8_t & element_type) {
+		uint8_t byte = read_byte();
+		element_type = byte & 0x0f;
+		size = byte >> 4;
+		if (size == 15) {
+			size = read_varint();
+		}
+	}
+
+	// the booleans of the fields are in their type, but in the lists they are a byte
+	bool read_list_boolean() { return read_byte() == THRIFT_BOOLEAN_TRUE; }
+
+	void skip(uint8_t type) {
+		switch (type) {
+		case THRIFT_BOOLEAN_TRUE:
+		case THRIFT_BOOLEAN_FALSE: break;
+		case THRIFT_BYTE: read_byte(); break;
+		case THRIFT_I16:
+		case THRIFT_I32:
+		case THRIFT_I64: read_varint(); break;
+		case THRIFT_DOUBLE: skip_bytes(8); break;
+		case THRIFT_BINARY: skip_bytes(read_varint()); break;
+		case THRIFT_LIST:
+		case THRIFT_SET: {
+			uint64_t size;
+			uint8_t element_type;
+			read_list_header(size, element_type);
+			for (uint64_t i = 0; i < size; i++) {
+				if (element_type == THRIFT_BOOLEAN_TRUE || element_type == THRIFT_BOOLEAN_FALSE) {
+					read_byte();
+				} else {
+					skip(element_type);
+				}
+			}
+		} break;
+		case THRIFT_MAP: {
+			uint64_t size = read_varint();
+			if (size > 0) {
+				uint8_t types = read_byte();
+				for (uint64_t i = 0; i < size; i++) {
+					skip(types >> 4);
+					skip(types & 0x0f);
+				}
+			}
+		} break;
+		case THRIFT_STRUCT: {
+			int16_t field_id = 0;
+			uint8_t field_type;
+			while (read_field_header(field_id, field_type)) {
+				skip(field_type);
+			}
+		} break;
+		default: throw std::runtime_error("ERROR: The parquet metadata has a bad thrift type");
+		}
+	}
+
+private:
+	void skip_bytes(uint64_t size) {
+		if (size > static_cast<uint64_t>(end - pos)) {
+			throw std::runtime_error("ERROR: The parquet metadata ends too soon");
+		}
+		pos += size;
+	}
+
+	const uint8_t * pos;
+	const uint8_t * end;
+};
+
+// ColumnMetaData, the bloom filter offset is its field 14
+void read_column_metadata(thrift_compact_reader & reader, parquet_column_chunk_indexes & indexes) {
+	int16_t field_id = 0;
+	uint8_t type;
+	while (reader.read_field_header(field_id, type)) {
+		if (field_id == 14 && type == THRIFT_I64) {
+			indexes.bloom_filter_offset = reader.read_zigzag();
+		} else {
+			reader.skip(type);
+		}
+	}
+}
+
+// ColumnChunk, the column index is in its fields 6 and 7
+parquet_column_chunk_indexes read_column_chunk(thrift_compact_reader & reader) {
+	parquet_column_chunk_indexes indexes;
+	int16_t field_id = 0;
+	uint8_t type;
+	while (reader.read_field_header(field_id, type)) {
+		if (field_id == 3 && type == THRIFT_STRUCT) {
+			read_column_metadata(reader, indexes);
+		} else if (field_id == 6 && type == THRIFT_I64) {
+			indexes.column_index_offset = reader.read_zigzag();
+		} else if (field_id == 7 && type == THRIFT_I32) {
+			indexes.column_index_length = static_cast<int32_t>(reader.read_zigzag());
+		} else {
+			reader.skip(type);
+		}
+	}
+	return indexes;
+}
+
+// RowGroup, whose columns are its field 1
+std::vector<parquet_column_chunk_indexes> read_row_group(thrift_compact_reader & reader) {
+	std::vector<parquet_column_chunk_indexes> columns;
+	int16_t field_id = 0;
+	uint8_t type;
+	while (reader.read_field_header(field_id, type)) {
+		if (field_id == 1 && type == THRIFT_LIST) {
+			uint64_t size;
+			uint8_t element_type;
+			reader.read_list_header(size, element_type);
+			for (uint64_t i = 0; i < size; i++) {
+				columns.push_back(read_column_chunk(reader));
+			}
+		} else {
+			reader.skip(type);
+		}
+	}
+	return columns;
+}
+
+std::shared_ptr<arrow::Buffer> read_at(arrow::io::RandomAccessFile & file, int64_t position, int64_t nbytes) {
+	auto result = file.ReadAt(position, nbytes);
+	if (!result.ok() || (*result)->size() != nbytes) {
+		return nullptr;
+	}
+	return *result;
+}
+
+// see the split block bloom filter of https://github.com/apache/parquet-format/blob/master/BloomFilter.md
+const uint32_t BLOOM_FILTER_SALT[8] = {
+	0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU, 0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U};
+const std::size_t BLOOM_FILTER_BLOCK_BYTES = 32;
+// the header of a bloom filter is a few bytes, which are read with the start of its bitset
+const int64_t BLOOM_FILTER_HEADER_MAX_BYTES = 64;
+
+std::size_t get_bloom_filter_block(const std::vector<uint8_t> & bitset, uint64_t hash) {
+	uint64_t num_blocks = bitset.size() / BLOOM_FILTER_BLOCK_BYTES;
+	return static_cast<std::size_t>(((hash >> 32) * num_blocks) >> 32) * BLOOM_FILTER_BLOCK_BYTES;
+}
+
+uint64_t rotate_left(uint64_t value, int bits) { return (value << bits) | (value >> (64 - bits)); }
+
+uint64_t load_uint64(const uint8_t * data) {
+	uint64_t value;
+	std::memcpy(&value, data, sizeof(value));
+	return value;
+}
+
+uint32_t load_uint32(const uint8_t * data) {
+	uint32_t value;
+	std::memcpy(&value, data, sizeof(value));
+	return value;
+}
+
+const uint64_t XXH_PRIME64_1 = 11400714785074694791ULL;
+const uint64_t XXH_PRIME64_2 = 14029467366897019727ULL;
+const uint64_t XXH_PRIME64_3 = 1609587929392839161ULL;
+const uint64_t XXH_PRIME64_4 = 9650029242287828579ULL;
+const uint64_t XXH_PRIME64_5 = 2870177450012600261ULL;
+
+uint64_t xxh64_round(uint64_t accumulator, uint64_t input) {
+	accumulator += input * XXH_PRIME64_2;
+	return rotate_left(accumulator, 31) * XXH_PRIME64_1;
+}
+
+uint64_t xxh64_merge_round(uint64_t accumulator, uint64_t value) {
+	accumulator ^= xxh64_round(0, value);
+	return accumulator * XXH_PRIME64_1 + XXH_PRIME64_4;
+}
+
+std::string unquote(const std::string & value) {
+	if (value.size() >= 2 && value.front() == '\'' && value.back() == '\'') {
+		return value.substr(1, value.size() - 2);
+	}
+	return value;
+}
+
+// the whole literal has to be the number, so that a date like 1994-01-01 is not read as 1994
+bool parse_plain_integer(const std::string & value, int64_t & number) {
+	std::size_t parsed_length = 0;
+	number = std::stoll(value, &parsed_length);
+	return parsed_length == value.size();
+}
+
+// the microseconds of a date or a timestamp from the epoch, or of a time from midnight
+bool parse_plain_microseconds(const std::string & value, bool is_time, int64_t & microseconds) {
+	static const std::regex timestamp_format("\\d{4}-\\d{2}-\\d{2}( \\d{2}:\\d{2}:\\d{2}(\\.\\d{1,6})?)?");
+	static const std::regex time_format("\\d{2}:\\d{2}:\\d{2}(\\.\\d{1,6})?");
+	std::string text = unquote(value);
+	if (!std::regex_match(text, is_time ? time_format : timestamp_format)) {
+		return false;
+	}
+	return parse_timestamp_microseconds(text.data(), text.size(), microseconds);
+}
+
+// the unscaled value of a decimal literal, which can't have more significant digits after the point than the scale
+bool parse_plain_decimal(const std::string & value, int scale, int64_t & unscaled) {
+	static const std::regex decimal_format("-?\\d+(\\.\\d+)?");
+	if (scale < 0 || !std::regex_match(value, decimal_format)) {
+		return false;
+	}
+	std::size_t point = value.find('.');
+	std::string fraction = point == std::string::npos ? "" : value.substr(point + 1);
+	while (fraction.size() > static_cast<std::size_t>(scale) && fraction.back() == '0') {
+		fraction.pop_back();
+	}
+	if (fraction.size() > static_cast<std::size_t>(scale)) {
+		return false;
+	}
+	fraction.append(scale - fraction.size(), '0');
+	return parse_plain_integer(value.substr(0, point) + fraction, unscaled);
+}
+
+// a literal as the integer of the physical type of the column
+bool parse_plain_number(const parquet::ColumnDescriptor & column, const std::string & value, int64_t & number) {
+	const int64_t microseconds_per_day = 86400000000LL;
+	int64_t microseconds = 0;
+	switch (column.converted_type()) {
+	case parquet::ConvertedType::NONE:
+		// the newer logical types, like the timestamps of nanoseconds, have no converted type
+		if (column.logical_type() != nullptr && !column.logical_type()->is_none() && !column.logical_type()->is_int()) {
+			return false;
+		}
+		return parse_plain_integer(value, number);
+	case parquet::ConvertedType::INT_8:
+	case parquet::ConvertedType::INT_16:
+	case parquet::ConvertedType::INT_32:
+	case parquet::ConvertedType::INT_64:
+	case parquet::ConvertedType::UINT_8:
+	case parquet::ConvertedType::UINT_16:
+	case parquet::ConvertedType::UINT_32:
+	case parquet::ConvertedType::UINT_64:
+		return parse_plain_integer(value, number);
+	case parquet::ConvertedType::DATE:
+		if (!parse_plain_microseconds(value, false, microseconds) || microseconds % microseconds_per_day != 0) {
+			return false;
+		}
+		number = microseconds / microseconds_per_day;
+		return true;
+	case parquet::ConvertedType::TIMESTAMP_MILLIS:
+	case parquet::ConvertedType::TIME_MILLIS:
+		if (!parse_plain_microseconds(value, column.converted_type() == parquet::ConvertedType::TIME_MILLIS, microseconds) ||
+				microseconds % 1000 != 0) {
+			return false;
+		}
+		number = microseconds / 1000;
+		return true;
+	case parquet::ConvertedType::TIMESTAMP_MICROS:
+	case parquet::ConvertedType::TIME_MICROS:
+		return parse_plain_microseconds(value, column.converted_type() == parquet::ConvertedType::TIME_MICROS, number);
+	case parquet::ConvertedType::DECIMAL:
+		return parse_plain_decimal(value, column.type_scale(), number);
+	default:
+		return false;
+	}
+}
+
+}  // namespace
+
+std::vector<std::vector<parquet_column_chunk_indexes>> read_parquet_column_chunk_indexes(arrow::io::RandomAccessFile & file) {
+	std::vector<std::vector<parquet_column_chunk_indexes>> row_groups;
+	auto file_size = file.GetSize();
+	if (!file_size.ok() || *file_size < 12) {
+		return row_groups;
+	}
+	// the footer is followed by its length and PAR1
+	std::shared_ptr<arrow::Buffer> tail = read_at(file, *file_size - 8, 8);
+	if (tail == nullptr || std::memcmp(tail->data() + 4, "PAR1", 4) != 0) {
+		return row_groups;
+	}
+	int64_t footer_size = load_uint32(tail->data());
+	if (footer_size + 8 > *file_size) {
+		return row_groups;
+	}
+	std::shared_ptr<arrow::Buffer> footer = read_at(file, *file_size - 8 - footer_size, footer_size);
+	if (footer == nullptr) {
+		return row_groups;
+	}
+
+	try {
+		// FileMetaData, whose row groups are its field 4
+		thrift_compact_reader reader(footer->data(), footer->size());
+		int16_t field_id = 0;
+		uint8_t type;
+		while (reader.read_field_header(field_id, type)) {
+			if (field_id == 4 && type == THRIFT_LIST) {
+				uint64_t size;
+				uint8_t element_type;
+				reader.read_list_header(size, element_type);
+				for (uint64_t i = 0; i < size; i++) {
+					row_groups.push_back(read_row_group(reader));
+				}
+			} else {
+				reader.skip(type);
+			}
+		}
+	} catch (const std::exception &) {
+		row_groups.clear(); // the file is read without the indexes, and its reader reports what is wrong with it
+	}
+	return row_groups;
+}
+
+bool read_parquet_page_ranges(arrow::io::RandomAccessFile & file, const parquet_column_chunk_indexes & indexes, parquet_page_ranges & ranges) {
+	if (indexes.column_index_offset < 0 || indexes.column_index_length <= 0) {
+		return false;
+	}
+	std::shared_ptr<arrow::Buffer> buffer = read_at(file, indexes.column_index_offset, indexes.column_index_length);
+	if (buffer == nullptr) {
+		return false;
+	}
+
+	try {
+		// ColumnIndex: the null_pages, min_values and max_values are its fields 1, 2 and 3
+		std::vector<bool> null_pages;
+		std::vector<std::string> min_values, max_values;
+		thrift_compact_reader reader(buffer->data(), buffer->size());
+		int16_t field_id = 0;
+		uint8_t type;
+		while (reader.read_field_header(field_id, type)) {
+			if (field_id >= 1 && field_id <= 3 && type == THRIFT_LIST) {
+				uint64_t size;
+				uint8_t element_type;
+				reader.read_list_header(size, element_type);
+				for (uint64_t i = 0; i < size; i++) {
+					if (field_id == 1) {
+						null_pages.push_back(reader.read_list_boolean());
+					} else {
+						(field_id == 2 ? min_values : max_values).push_back(reader.read_binary());
+					}
+				}
+			} else {
+				reader.skip(type);
+			}
+		}
+		if (min_values.size() != max_values.size() || null_pages.size() != min_values.size()) {
+			return false;
+		}
+
+		ranges = parquet_page_ranges();
+		for (std::size_t page = 0; page < null_pages.size(); page++) {
+			if (!null_pages[page]) {
+				ranges.min_values.push_back(std::move(min_values[page]));
+				ranges.max_values.push_back(std::move(max_values[page]));
+			}
+		}
+		return true;
+	} catch (const std::exception &) {
+		return false;
+	}
+}
+
+bool read_parquet_bloom_filter(arrow::io::RandomAccessFile & file, const parquet_column_chunk_indexes & indexes, std::vector<uint8_t> & bitset) {
+	auto file_size = file.GetSize();
+	if (indexes.bloom_filter_offset < 0 || !file_size.ok() || indexes.bloom_filter_offset >= *file_size) {
+		return false;
+	}
+	std::shared_ptr<arrow::Buffer> header = read_at(file, indexes.bloom_filter_offset,
+		std::min(BLOOM_FILTER_HEADER_MAX_BYTES, *file_size - indexes.bloom_filter_offset));
+	if (header == nullptr) {
+		return false;
+	}
+
+	try {
+		// BloomFilterHeader: numBytes is its field 1, and the algorithm, hash and compression are the unions 2, 3 and 4,
+		// whose field 1 is the only one there is: a split block bloom filter whose xxHash64 values are not compressed
+		int64_t num_bytes = 0;
+		thrift_compact_reader reader(header->data(), header->size());
+		int16_t field_id = 0;
+		uint8_t type;
+		while (reader.read_field_header(field_id, type)) {
+			if (field_id == 1 && type == THRIFT_I32) {
+				num_bytes = reader.read_zigzag();
+			} else if (field_id >= 2 && field_id <= 4 && type == THRIFT_STRUCT) {
+				int16_t union_field_id = 0;
+				uint8_t union_type;
+				while (reader.read_field_header(union_field_id, union_type)) {
+					if (union_field_id != 1) {
+						return false;
+					}
+					reader.skip(union_type);
+				}
+			} else {
+				reader.skip(type);
+			}
+		}
+		if (num_bytes <= 0 || num_bytes % BLOOM_FILTER_BLOCK_BYTES != 0) {
+			return false;
+		}
+
+		std::shared_ptr<arrow::Buffer> data = read_at(file, indexes.bloom_filter_offset + reader.consumed(header->data()), num_bytes);
+		if (data == nullptr) {
+			return false;
+		}
+		bitset.assign(data->data(), data->data() + data->size());
+		return true;
+	} catch (const std::exception &) {
+		return false;
+	}
+}
+
+uint64_t parquet_bloom_filter_hash(const std::string & value) {
+	const uint8_t * data = reinterpret_cast<const uint8_t *>(value.data());
+	const uint8_t * end = data + value.size();
+	const uint64_t seed = 0;
+	uint64_t hash;
+
+	if (value.size() >= 32) {
+		uint64_t v1 = seed + XXH_PRIME64_1 + XXH_PRIME64_2;
+		uint64_t v2 = seed + XXH_PRIME64_2;
+		uint64_t v3 = seed;
+		uint64_t v4 = seed - XXH_PRIME64_1;
+		for (; data + 32 <= end; data += 32) {
+			v1 = xxh64_round(v1, load_uint64(data));
+			v2 = xxh64_round(v2, load_uint64(data + 8));
+			v3 = xxh64_round(v3, load_uint64(data + 16));
+			v4 = xxh64_round(v4, load_uint64(data + 24));
+		}
+		hash = rotate_left(v1, 1) + rotate_left(v2, 7) + rotate_left(v3, 12) + rotate_left(v4, 18);
+		hash = xxh64_merge_round(hash, v1);
+		hash = xxh64_merge_round(hash, v2);
+		hash = xxh64_merge_round(hash, v3);
+		hash = xxh64_merge_round(hash, v4);
+	} else {
+		hash = seed + XXH_PRIME64_5;
+	}
+	hash += value.size();
+
+	for (; data + 8 <= end; data += 8) {
+		hash ^= xxh64_round(0, load_uint64(data));
+		hash = rotate_left(hash, 27) * XXH_PRIME64_1 + XXH_PRIME64_4;
+	}
+	if (data + 4 <= end) {
+		hash ^= static_cast<uint64_t>(load_uint32(data)) * XXH_PRIME64_1;
+		hash = rotate_left(hash, 23) * XXH_PRIME64_2 + XXH_PRIME64_3;
+		data += 4;
+	}
+	for (; data < end; data++) {
+		hash ^= *data * XXH_PRIME64_5;
+		hash = rotate_left(hash, 11) * XXH_PRIME64_1;
+	}
+
+	hash ^= hash >> 33;
+	hash *= XXH_PRIME64_2;
+	hash ^= hash >> 29;
+	hash *= XXH_PRIME64_3;
+	hash ^= hash >> 32;
+	return hash;
+}
+
+bool parquet_bloom_filter_find(const std::vector<uint8_t> & bitset, uint64_t hash) {
+	if (bitset.size() < BLOOM_FILTER_BLOCK_BYTES) {
+		return true;
+	}
+	const uint8_t * block = bitset.data() + get_bloom_filter_block(bitset, hash);
+	const uint32_t key = static_cast<uint32_t>(hash);
+	for (int i = 0; i < 8; i++) {
+		uint32_t mask = 1U << ((key * BLOOM_FILTER_SALT[i]) >> 27);
+		if ((load_uint32(block + i * 4) & mask) == 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void parquet_bloom_filter_insert(std::vector<uint8_t> & bitset, uint64_t hash) {
+	if (bitset.size() < BLOOM_FILTER_BLOCK_BYTES) {
+		return;
+	}
+	uint8_t * block = bitset.data() + get_bloom_filter_block(bitset, hash);
+	const uint32_t key = static_cast<uint32_t>(hash);
+	for (int i = 0; i < 8; i++) {
+		uint32_t word = load_uint32(block + i * 4) | (1U << ((key * BLOOM_FILTER_SALT[i]) >> 27));
+		std::memcpy(block + i * 4, &word, sizeof(word));
+	}
+}
+
+bool parquet_encode_plain_values(const parquet::ColumnDescriptor & column, const std::vector<std::string> & values, std::vector<std::string> & encoded) {
+	try {
+		for (const std::string & value : values) {
+			int64_t number = 0;
+			if (column.physical_type() == parquet::Type::INT32) {
+				int64_t max = column.converted_type() == parquet::ConvertedType::UINT_32 ?
+					std::numeric_limits<uint32_t>::max() : std::numeric_limits<int32_t>::max();
+				if (!parse_plain_number(column, value, number) || number < std::numeric_limits<int32_t>::min() || number > max) {
+					return false;
+				}
+				int32_t plain = static_cast<int32_t>(number);
+				encoded.emplace_back(reinterpret_cast<const char *>(&plain), sizeof(plain));
+			} else if (column.physical_type() == parquet::Type::INT64) {
+				if (!parse_plain_number(column, value, number)) {
+					return false;
+				}
+				encoded.emplace_back(reinterpret_cast<const char *>(&number), sizeof(number));
+			} else if (column.physical_type() == parquet::Type::BYTE_ARRAY && value.size() >= 2 && value.front() == '\'' && value.back() == '\'') {
+				std::string text = value.substr(1, value.size() - 2);
+				if (text.find('\'') != std::string::npos) {
+					return false; // an escaped quote
+				}
+				encoded.push_back(text);
+			} else {
+				return false;
+			}
+		}
+	} catch (const std::exception &) {
+		return false; // a number that is out of range
+	}
+	return true;
+}
+
+}  // namespace io
+}  // namespace ral
@@ -0,0 +1,71 @@
+#ifndef BLAZINGDB_RAL_SRC_IO_DATA_PARSER_METADATA_PARQUET_PAGE_INDEX_H_
+#define BLAZINGDB_RAL_SRC_IO_DATA_PARSER_METADATA_PARQUET_PAGE_INDEX_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <arrow/io/interfaces.h>
+#include <parquet/schema.h>
+
+namespace ral {
+namespace io {
+
+/**
+ * @brief Where the column index (the min and max of every page) and the bloom filter of a column chunk are in its file.
+ * The footers have them since parquet-format 2.4 and 2.7, but the FileMetaData of this arrow version does not tell
+ * them, so they are read from the footer with read_parquet_column_chunk_indexes.
+ */
+struct parquet_column_chunk_indexes {
+	int64_t column_index_offset = -1;
+	int32_t column_index_length = 0;
+	int64_t bloom_filter_offset = -1;
+};
+
+/**
+ * @brief Reads the indexes of the column chunks of every row group from the footer of a parquet file.
+ * @return the indexes by row group and column, empty if the footer can't be read
+ */
+std::vector<std::vector<parquet_column_chunk_indexes>> read_parquet_column_chunk_indexes(arrow::io::RandomAccessFile & file);
+
+/**
+ * @brief The min and max of the pages of a column chunk, plain encoded, without the pages that only have nulls.
+ */
+struct parquet_page_ranges {
+	std::vector<std::string> min_values;
+	std::vector<std::string> max_values;
+};
+
+/**
+ * @return false if the column chunk has no column index or it can't be read
+ */
+bool read_parquet_page_ranges(arrow::io::RandomAccessFile & file, const parquet_column_chunk_indexes & indexes, parquet_page_ranges & ranges);
+
+/**
+ * @brief Reads the split block bloom filter of a column chunk.
+ * @return false if the column chunk has no bloom filter or it is not a split block bloom filter
+ */
+bool read_parquet_bloom_filter(arrow::io::RandomAccessFile & file, const parquet_column_chunk_indexes & indexes, std::vector<uint8_t> & bitset);
+
+/**
+ * @brief The xxHash64 of a plain encoded value, whose bytes are what the bloom filters hash (without the length of the byte arrays).
+ */
+uint64_t parquet_bloom_filter_hash(const std::string & value);
+
+bool parquet_bloom_filter_find(const std::vector<uint8_t> & bitset, uint64_t hash);
+
+void parquet_bloom_filter_insert(std::vector<uint8_t> & bitset, uint64_t hash);
+
+/**
+ * @brief Encodes the literals of a filter like the plain encoding of a column, so that they can be compared with its
+ * page ranges and hashed like its bloom filter does. The dates, times and timestamps are encoded as the ticks of their
+ * unit, and the decimals as their unscaled value.
+ * @return false if a literal is not exactly a value of the column, or the column has a type that is not supported, so
+ * that nothing is pruned by them
+ */
+bool parquet_encode_plain_values(const parquet::ColumnDescriptor & column, const std::vector<std::string> & values, std::vector<std::string> & encoded);
+
+}  // namespace io
+}  // namespace ral
+
+#endif	// BLAZINGDB_RAL_SRC_IO_DATA_PARSER_METADATA_PARQUET_PAGE_INDEX_H_
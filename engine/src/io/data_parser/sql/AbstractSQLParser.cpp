@@ -172,11 +172,26 @@ void abstractsql_parser::parse_sql(void *src,
         std::vector<int8_t> *v = (std::vector<int8_t>*)host_cols[col];
         valid = this->parse_cudf_bool8(src, col, row, v);
       } break;
-      case cudf::type_id::TIMESTAMP_DAYS:
-      case cudf::type_id::TIMESTAMP_SECONDS:
-      case cudf::type_id::TIMESTAMP_MILLISECONDS:
-      case cudf::type_id::TIMESTAMP_MICROSECONDS:
-      case cudf::type_id::TIMESTAMP_NANOSECONDS:
+      case cudf::type_id::TIMESTAMP_DAYS: {
+        std::vector<int32_t> *v = (std::vector<int32_t>*)host_cols[col];
+        valid = this->parse_cudf_timestamp_days(src, col, row, v);
+      } break;
+      case cudf::type_id::TIMESTAMP_SECONDS: {
+        std::vector<int64_t> *v = (std::vector<int64_t>*)host_cols[col];
+        valid = this->parse_cudf_timestamp_seconds(src, col, row, v);
+      } break;
+      case cudf::type_id::TIMESTAMP_MILLISECONDS: {
+        std::vector<int64_t> *v = (std::vector<int64_t>*)host_cols[col];
+        valid = this->parse_cudf_timestamp_milliseconds(src, col, row, v);
+      } break;
+      case cudf::type_id::TIMESTAMP_MICROSECONDS: {
+        std::vector<int64_t> *v = (std::vector<int64_t>*)host_cols[col];
+        valid = this->parse_cudf_timestamp_microseconds(src, col, row, v);
+      } break;
+      case cudf::type_id::TIMESTAMP_NANOSECONDS: {
+        std::vector<int64_t> *v = (std::vector<int64_t>*)host_cols[col];
+        valid = this->parse_cudf_timestamp_nanoseconds(src, col, row, v);
+      } break;
       // TODO percy it seems we don't support this yet
       // case cudf::type_id::DURATION_DAYS: {} break;
       // case cudf::type_id::DURATION_SECONDS: {} break;
@@ -272,11 +287,19 @@ std::pair<std::vector<void*>, std::vector<std::vector<cudf::bitmask_type>>> init
         tmp->resize(total_rows);
         host_cols[col] = tmp;
       } break;
-      case cudf::type_id::TIMESTAMP_DAYS:
+      case cudf::type_id::TIMESTAMP_DAYS: {
+        std::vector<int32_t> *tmp = new std::vector<int32_t>();
+        tmp->resize(total_rows);
+        host_cols[col] = tmp;
+      } break;
       case cudf::type_id::TIMESTAMP_SECONDS:
       case cudf::type_id::TIMESTAMP_MILLISECONDS:
       case cudf::type_id::TIMESTAMP_MICROSECONDS:
-      case cudf::type_id::TIMESTAMP_NANOSECONDS:
+      case cudf::type_id::TIMESTAMP_NANOSECONDS: {
+        std::vector<int64_t> *tmp = new std::vector<int64_t>();
+        tmp->resize(total_rows);
+        host_cols[col] = tmp;
+      } break;
       // TODO percy it seems we don't support this yet
       // case cudf::type_id::DURATION_DAYS: {} break;
       // case cudf::type_id::DURATION_SECONDS: {} break;
@@ -363,25 +386,16 @@ cudf::io::table_with_metadata abstractsql_parser::read_sql(void *src,
         cudf_cols[col] = build_fixed_width_cudf_col<uint8_t>(total_rows, v, null_masks[col], cudf_type_id);
       } break;
       case cudf::type_id::TIMESTAMP_DAYS: {
-        cudf_string_col *v = (cudf_string_col*)host_cols[col];
-        auto str_col = build_str_cudf_col(v, null_masks[col]);
-        auto vals_col = cudf::strings::to_timestamps(str_col->view(), cudf::data_type{cudf::type_id::TIMESTAMP_DAYS}, "%Y-%m-%d");
-        cudf_cols[col] = std::move(vals_col);
-      } break;
-      case cudf::type_id::TIMESTAMP_SECONDS: {
-        cudf_string_col *v = (cudf_string_col*)host_cols[col];
-        auto str_col = build_str_cudf_col(v, null_masks[col]);
-        auto vals_col = cudf::strings::to_timestamps(str_col->view(), cudf::data_type{cudf::type_id::TIMESTAMP_SECONDS}, "%H:%M:%S");
-        cudf_cols[col] = std::move(vals_col);
+        std::vector<int32_t> *v = (std::vector<int32_t>*)host_cols[col];
+        cudf_cols[col] = build_fixed_width_cudf_col<int32_t>(total_rows, v, null_masks[col], cudf_type_id);
       } break;
-      case cudf::type_id::TIMESTAMP_MILLISECONDS: {
-        cudf_string_col *v = (cudf_string_col*)host_cols[col];
-        auto str_col = build_str_cudf_col(v, null_masks[col]);
-        auto vals_col = cudf::strings::to_timestamps(str_col->view(), cudf::data_type{cudf::type_id::TIMESTAMP_MILLISECONDS}, "%Y-%m-%d %H:%M:%S");
-        cudf_cols[col] = std::move(vals_col);
+      case cudf::type_id::TIMESTAMP_SECONDS:
+      case cudf::type_id::TIMESTAMP_MILLISECONDS:
+      case cudf::type_id::TIMESTAMP_MICROSECONDS:
+      case cudf::type_id::TIMESTAMP_NANOSECONDS: {
+        std::vector<int64_t> *v = (std::vector<int64_t>*)host_cols[col];
+        cudf_cols[col] = build_fixed_width_cudf_col<int64_t>(total_rows, v, null_masks[col], cudf_type_id);
       } break;
-      case cudf::type_id::TIMESTAMP_MICROSECONDS: {} break;
-      case cudf::type_id::TIMESTAMP_NANOSECONDS: {} break;
       // TODO percy it seems we don't support this yet
       // case cudf::type_id::DURATION_DAYS: {} break;
       // case cudf::type_id::DURATION_SECONDS: {} break;
@@ -454,11 +468,17 @@ cudf::io::table_with_metadata abstractsql_parser::read_sql(void *src,
         std::vector<int8_t> *tmp = (std::vector<int8_t>*)host_cols[col];
         delete(tmp);
       } break;
-      case cudf::type_id::TIMESTAMP_DAYS:
+      case cudf::type_id::TIMESTAMP_DAYS: {
+        std::vector<int32_t> *tmp = (std::vector<int32_t>*)host_cols[col];
+        delete(tmp);
+      } break;
       case cudf::type_id::TIMESTAMP_SECONDS:
       case cudf::type_id::TIMESTAMP_MILLISECONDS:
       case cudf::type_id::TIMESTAMP_MICROSECONDS:
-      case cudf::type_id::TIMESTAMP_NANOSECONDS:
+      case cudf::type_id::TIMESTAMP_NANOSECONDS: {
+        std::vector<int64_t> *tmp = (std::vector<int64_t>*)host_cols[col];
+        delete(tmp);
+      } break;
       // TODO percy it seems we don't support this yet
       // case cudf::type_id::DURATION_DAYS: {} break;
       // case cudf::type_id::DURATION_SECONDS: {} break;
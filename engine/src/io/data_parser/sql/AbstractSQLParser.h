@@ -56,11 +56,12 @@ protected:
   virtual uint8_t parse_cudf_float32(void *src, size_t col, size_t row, std::vector<float> *v) = 0;
   virtual uint8_t parse_cudf_float64(void *src, size_t col, size_t row, std::vector<double> *v) = 0;
   virtual uint8_t parse_cudf_bool8(void *src, size_t col, size_t row, std::vector<int8_t> *v) = 0;
-  virtual uint8_t parse_cudf_timestamp_days(void *src, size_t col, size_t row, cudf_string_col *v) = 0;
-  virtual uint8_t parse_cudf_timestamp_seconds(void *src, size_t col, size_t row, cudf_string_col *v) = 0;
-  virtual uint8_t parse_cudf_timestamp_milliseconds(void *src, size_t col, size_t row, cudf_string_col *v) = 0;
-  virtual uint8_t parse_cudf_timestamp_microseconds(void *src, size_t col, size_t row, cudf_string_col *v) = 0;
-  virtual uint8_t parse_cudf_timestamp_nanoseconds(void *src, size_t col, size_t row, cudf_string_col *v) = 0;
+  // the timestamps are read as the ticks of their cudf type, see parse_timestamp_microseconds
+  virtual uint8_t parse_cudf_timestamp_days(void *src, size_t col, size_t row, std::vector<int32_t> *v) = 0;
+  virtual uint8_t parse_cudf_timestamp_seconds(void *src, size_t col, size_t row, std::vector<int64_t> *v) = 0;
+  virtual uint8_t parse_cudf_timestamp_milliseconds(void *src, size_t col, size_t row, std::vector<int64_t> *v) = 0;
+  virtual uint8_t parse_cudf_timestamp_microseconds(void *src, size_t col, size_t row, std::vector<int64_t> *v) = 0;
+  virtual uint8_t parse_cudf_timestamp_nanoseconds(void *src, size_t col, size_t row, std::vector<int64_t> *v) = 0;
   // todo percy it seems we don't support this yet
   // case cudf::type_id::duration_days: {} break;
   // case cudf::type_id::duration_seconds: {} break;
@@ -233,29 +233,43 @@ uint8_t mysql_parser::parse_cudf_bool8(void *src, size_t col, size_t row, std::v
   return 1;
 }
 
-uint8_t mysql_parser::parse_cudf_timestamp_days(void *src, size_t col, size_t row, cudf_string_col *v)
+// the binary protocol sends the dates and times as MYSQL_TIME structs, which the connector formats as
+// YYYY-MM-DD HH:MM:SS.ffffff, so they are parsed back here instead of on the GPU
+template <typename T>
+static inline uint8_t parse_mysql_timestamp(void *src, size_t col, size_t row, cudf::type_id type, std::vector<T> *v)
 {
-  return this->parse_cudf_string(src, col, row, v);
+  auto res = (sql::ResultSet*)src;
+  ++col; // mysql count columns starting from 1
+  std::string real_data = res->getString(col).asStdString();
+  int64_t us;
+  if (res->wasNull() || !parse_timestamp_microseconds(real_data.data(), real_data.length(), us)) return 0;
+  (*v)[row] = static_cast<T>(microseconds_to_ticks(us, type));
+  return 1;
+}
+
+uint8_t mysql_parser::parse_cudf_timestamp_days(void *src, size_t col, size_t row, std::vector<int32_t> *v)
+{
+  return parse_mysql_timestamp(src, col, row, cudf::type_id::TIMESTAMP_DAYS, v);
 }
 
-uint8_t mysql_parser::parse_cudf_timestamp_seconds(void *src, size_t col, size_t row, cudf_string_col *v)
+uint8_t mysql_parser::parse_cudf_timestamp_seconds(void *src, size_t col, size_t row, std::vector<int64_t> *v)
 {
-  return this->parse_cudf_string(src, col, row, v);
+  return parse_mysql_timestamp(src, col, row, cudf::type_id::TIMESTAMP_SECONDS, v);
 }
 
-uint8_t mysql_parser::parse_cudf_timestamp_milliseconds(void *src, size_t col, size_t row, cudf_string_col *v)
+uint8_t mysql_parser::parse_cudf_timestamp_milliseconds(void *src, size_t col, size_t row, std::vector<int64_t> *v)
 {
-  return this->parse_cudf_string(src, col, row, v);
+  return parse_mysql_timestamp(src, col, row, cudf::type_id::TIMESTAMP_MILLISECONDS, v);
 }
 
-uint8_t mysql_parser::parse_cudf_timestamp_microseconds(void *src, size_t col, size_t row, cudf_string_col *v)
+uint8_t mysql_parser::parse_cudf_timestamp_microseconds(void *src, size_t col, size_t row, std::vector<int64_t> *v)
 {
-  return this->parse_cudf_string(src, col, row, v);
+  return parse_mysql_timestamp(src, col, row, cudf::type_id::TIMESTAMP_MICROSECONDS, v);
 }
 
-uint8_t mysql_parser::parse_cudf_timestamp_nanoseconds(void *src, size_t col, size_t row, cudf_string_col *v)
+uint8_t mysql_parser::parse_cudf_timestamp_nanoseconds(void *src, size_t col, size_t row, std::vector<int64_t> *v)
 {
-  return this->parse_cudf_string(src, col, row, v);
+  return parse_mysql_timestamp(src, col, row, cudf::type_id::TIMESTAMP_NANOSECONDS, v);
 }
 
 // todo percy it seems we don't support this yet
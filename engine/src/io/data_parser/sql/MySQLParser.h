@@ -36,11 +36,11 @@ protected:
   uint8_t parse_cudf_float32(void *src, size_t col, size_t row, std::vector<float> *v) override;
   uint8_t parse_cudf_float64(void *src, size_t col, size_t row, std::vector<double> *v) override;
   uint8_t parse_cudf_bool8(void *src, size_t col, size_t row, std::vector<int8_t> *v) override;
-  uint8_t parse_cudf_timestamp_days(void *src, size_t col, size_t row, cudf_string_col *v) override;
-  uint8_t parse_cudf_timestamp_seconds(void *src, size_t col, size_t row, cudf_string_col *v) override;
-  uint8_t parse_cudf_timestamp_milliseconds(void *src, size_t col, size_t row, cudf_string_col *v) override;
-  uint8_t parse_cudf_timestamp_microseconds(void *src, size_t col, size_t row, cudf_string_col *v) override;
-  uint8_t parse_cudf_timestamp_nanoseconds(void *src, size_t col, size_t row, cudf_string_col *v) override;
+  uint8_t parse_cudf_timestamp_days(void *src, size_t col, size_t row, std::vector<int32_t> *v) override;
+  uint8_t parse_cudf_timestamp_seconds(void *src, size_t col, size_t row, std::vector<int64_t> *v) override;
+  uint8_t parse_cudf_timestamp_milliseconds(void *src, size_t col, size_t row, std::vector<int64_t> *v) override;
+  uint8_t parse_cudf_timestamp_microseconds(void *src, size_t col, size_t row, std::vector<int64_t> *v) override;
+  uint8_t parse_cudf_timestamp_nanoseconds(void *src, size_t col, size_t row, std::vector<int64_t> *v) override;
   //virtual uint8_t parse_cudf_timestamp_seconds(void *src, size_t col, size_t row, cudf_string_col *v) override;
   //virtual uint8_t parse_cudf_timestamp_milliseconds(void *src, size_t col, size_t row, cudf_string_col *v) override;
   //virtual uint8_t parse_cudf_timestamp_microseconds(void *src, size_t col, size_t row, cudf_string_col *v) override;
@@ -4,6 +4,7 @@
  */
 
 #include <array>
+#include <cstring>
 #include <iomanip>
 #include <sstream>
 
@@ -157,6 +158,89 @@ static inline cudf::type_id parse_postgresql_column_type(
   throw std::runtime_error("PostgreSQL type hint not found: " + columnTypeName);
 }
 
+// the values of the results are in binary, in network order
+static inline std::int8_t decode_int8(const char * value) {
+  return *reinterpret_cast<const std::int8_t *>(value);
+}
+
+static inline std::int16_t decode_int16(const char * value) {
+  return ntohs(*reinterpret_cast<const std::int16_t *>(value));
+}
+
+static inline std::int32_t decode_int32(const char * value) {
+  return ntohl(*reinterpret_cast<const std::int32_t *>(value));
+}
+
+static inline std::int64_t decode_int64(const char * value) {
+  return __builtin_bswap64(*reinterpret_cast<const std::int64_t *>(value));
+}
+
+static inline float decode_float32(const char * value) {
+  const std::int32_t bits = decode_int32(value);
+  float ret;
+  std::memcpy(&ret, &bits, sizeof(ret));
+  return ret;
+}
+
+static inline double decode_float64(const char * value) {
+  const std::int64_t bits = decode_int64(value);
+  double ret;
+  std::memcpy(&ret, &bits, sizeof(ret));
+  return ret;
+}
+
+// the microseconds from the unix epoch of a date, timestamp or time, which are
+// counted from 2000-01-01 by postgresql
+static inline bool decode_timestamp_microseconds(
+  const char * value, Oid oid, std::int64_t & us) {
+  const std::int64_t POSTGRESQL_EPOCH_DAYS = 10957;
+  switch (oid) {
+  case 1082:  // date
+    us = (decode_int32(value) + POSTGRESQL_EPOCH_DAYS) * 86400000000LL;
+    return true;
+  case 1114:  // timestamp
+  case 1184:  // timestamp with time zone, which is sent in UTC
+    us = decode_int64(value) + POSTGRESQL_EPOCH_DAYS * 86400000000LL;
+    return true;
+  case 1083:  // time, as a time of 1970-01-01
+    us = decode_int64(value);
+    return true;
+  default: return false;
+  }
+}
+
+template <typename T>
+static inline std::uint8_t parse_postgresql_timestamp(void * src,
+  std::size_t col,
+  std::size_t row,
+  cudf::type_id type,
+  std::vector<T> * v) {
+  PGresult * pgResult = static_cast<PGresult *>(src);
+  std::int64_t us;
+  if (PQgetisnull(pgResult, row, col) ||
+      !decode_timestamp_microseconds(
+        PQgetvalue(pgResult, row, col), PQftype(pgResult, col), us)) {
+    return 0;
+  }
+  v->at(row) = static_cast<T>(microseconds_to_ticks(us, type));
+  return 1;
+}
+
+template <typename T, typename Decode>
+static inline void read_fixed_width_column(PGresult * result,
+  int col,
+  int ntuples,
+  void * host_col,
+  std::vector<cudf::bitmask_type> & null_mask,
+  Decode decode) {
+  std::vector<T> & values = *static_cast<std::vector<T> *>(host_col);
+  for (int row = 0; row < ntuples; row++) {
+    if (PQgetisnull(result, row, col)) { continue; }
+    values[row] = static_cast<T>(decode(PQgetvalue(result, row, col)));
+    cudf::set_bit_unsafe(null_mask.data(), row);
+  }
+}
+
 postgresql_parser::postgresql_parser()
     : abstractsql_parser{DataType::POSTGRESQL} {}
 
@@ -169,9 +253,85 @@ void postgresql_parser::read_sql_loop(void * src,
   std::vector<std::vector<cudf::bitmask_type>> & null_masks) {
   PGresult * result = static_cast<PGresult *>(src);
   const int ntuples = PQntuples(result);
-  for (int rowCounter = 0; rowCounter < ntuples; rowCounter++) {
-    parse_sql(
-      src, column_indices, cudf_types, rowCounter, host_cols, null_masks);
+  // the result has all of its rows already, so it is converted a column at a
+  // time, which dispatches on the type of a column once instead of per value
+  for (std::size_t col = 0; col < column_indices.size(); col++) {
+    auto & null_mask = null_masks[col];
+    switch (cudf_types[column_indices[col]]) {
+    case cudf::type_id::INT8:
+    case cudf::type_id::BOOL8:
+      read_fixed_width_column<std::int8_t>(
+        result, col, ntuples, host_cols[col], null_mask, decode_int8);
+      break;
+    case cudf::type_id::UINT8:
+      read_fixed_width_column<std::uint8_t>(
+        result, col, ntuples, host_cols[col], null_mask, decode_int8);
+      break;
+    case cudf::type_id::INT16:
+      read_fixed_width_column<std::int16_t>(
+        result, col, ntuples, host_cols[col], null_mask, decode_int16);
+      break;
+    case cudf::type_id::UINT16:
+      read_fixed_width_column<std::uint16_t>(
+        result, col, ntuples, host_cols[col], null_mask, decode_int16);
+      break;
+    case cudf::type_id::INT32:
+      read_fixed_width_column<std::int32_t>(
+        result, col, ntuples, host_cols[col], null_mask, decode_int32);
+      break;
+    case cudf::type_id::UINT32:
+      read_fixed_width_column<std::uint32_t>(
+        result, col, ntuples, host_cols[col], null_mask, decode_int32);
+      break;
+    case cudf::type_id::INT64:
+      read_fixed_width_column<std::int64_t>(
+        result, col, ntuples, host_cols[col], null_mask, decode_int64);
+      break;
+    case cudf::type_id::UINT64:
+      read_fixed_width_column<std::uint64_t>(
+        result, col, ntuples, host_cols[col], null_mask, decode_int64);
+      break;
+    case cudf::type_id::FLOAT32:
+      read_fixed_width_column<float>(
+        result, col, ntuples, host_cols[col], null_mask, decode_float32);
+      break;
+    case cudf::type_id::FLOAT64:
+      read_fixed_width_column<double>(
+        result, col, ntuples, host_cols[col], null_mask, decode_float64);
+      break;
+    case cudf::type_id::TIMESTAMP_DAYS:
+      for (int row = 0; row < ntuples; row++) {
+        if (parse_postgresql_timestamp(src, col, row, cudf::type_id::TIMESTAMP_DAYS,
+              static_cast<std::vector<std::int32_t> *>(host_cols[col]))) {
+          cudf::set_bit_unsafe(null_mask.data(), row);
+        }
+      }
+      break;
+    case cudf::type_id::TIMESTAMP_SECONDS:
+    case cudf::type_id::TIMESTAMP_MILLISECONDS:
+    case cudf::type_id::TIMESTAMP_MICROSECONDS:
+    case cudf::type_id::TIMESTAMP_NANOSECONDS: {
+      const cudf::type_id type = cudf_types[column_indices[col]];
+      for (int row = 0; row < ntuples; row++) {
+        if (parse_postgresql_timestamp(src, col, row, type,
+              static_cast<std::vector<std::int64_t> *>(host_cols[col]))) {
+          cudf::set_bit_unsafe(null_mask.data(), row);
+        }
+      }
+    } break;
+    case cudf::type_id::STRING: {
+      cudf_string_col * v = static_cast<cudf_string_col *>(host_cols[col]);
+      v->offsets.reserve(ntuples + 1);
+      for (int row = 0; row < ntuples; row++) {
+        if (postgresql_parser::parse_cudf_string(src, col, row, v)) {
+          cudf::set_bit_unsafe(null_mask.data(), row);
+        }
+      }
+    } break;
+    default:
+      // the other types are not read yet, see abstractsql_parser::parse_sql
+      break;
+    }
   }
 }
 
@@ -302,28 +462,33 @@ std::uint8_t postgresql_parser::parse_cudf_bool8(
 }
 
 std::uint8_t postgresql_parser::parse_cudf_timestamp_days(
-  void * src, std::size_t col, std::size_t row, cudf_string_col * v) {
-  return parse_cudf_string(src, col, row, v);
+  void * src, std::size_t col, std::size_t row, std::vector<std::int32_t> * v) {
+  return parse_postgresql_timestamp(
+    src, col, row, cudf::type_id::TIMESTAMP_DAYS, v);
 }
 
 std::uint8_t postgresql_parser::parse_cudf_timestamp_seconds(
-  void * src, std::size_t col, std::size_t row, cudf_string_col * v) {
-  return parse_cudf_string(src, col, row, v);
+  void * src, std::size_t col, std::size_t row, std::vector<std::int64_t> * v) {
+  return parse_postgresql_timestamp(
+    src, col, row, cudf::type_id::TIMESTAMP_SECONDS, v);
 }
 
 std::uint8_t postgresql_parser::parse_cudf_timestamp_milliseconds(
-  void * src, std::size_t col, std::size_t row, cudf_string_col * v) {
-  return parse_cudf_string(src, col, row, v);
+  void * src, std::size_t col, std::size_t row, std::vector<std::int64_t> * v) {
+  return parse_postgresql_timestamp(
+    src, col, row, cudf::type_id::TIMESTAMP_MILLISECONDS, v);
 }
 
 std::uint8_t postgresql_parser::parse_cudf_timestamp_microseconds(
-  void * src, std::size_t col, std::size_t row, cudf_string_col * v) {
-  return parse_cudf_string(src, col, row, v);
+  void * src, std::size_t col, std::size_t row, std::vector<std::int64_t> * v) {
+  return parse_postgresql_timestamp(
+    src, col, row, cudf::type_id::TIMESTAMP_MICROSECONDS, v);
 }
 
 std::uint8_t postgresql_parser::parse_cudf_timestamp_nanoseconds(
-  void * src, std::size_t col, std::size_t row, cudf_string_col * v) {
-  return parse_cudf_string(src, col, row, v);
+  void * src, std::size_t col, std::size_t row, std::vector<std::int64_t> * v) {
+  return parse_postgresql_timestamp(
+    src, col, row, cudf::type_id::TIMESTAMP_NANOSECONDS, v);
 }
 
 std::uint8_t postgresql_parser::parse_cudf_string(
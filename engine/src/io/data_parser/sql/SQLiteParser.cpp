@@ -232,29 +232,59 @@ std::uint8_t sqlite_parser::parse_cudf_bool8(void * src,
   return 1;
 }
 
+// the dates are either text or unix time, the julian day numbers are not supported yet
+template <typename T>
+static inline std::uint8_t parse_sqlite_timestamp(void * src,
+    std::size_t col,
+    std::size_t row,
+    cudf::type_id type,
+    std::vector<T> * v) {
+  sqlite3_stmt * stmt = reinterpret_cast<sqlite3_stmt *>(src);
+  std::int64_t us;
+  switch (sqlite3_column_type(stmt, col)) {
+  case SQLITE_NULL: return 0;
+  case SQLITE_INTEGER: us = sqlite3_column_int64(stmt, col) * 1000000; break;
+  default: {
+    const char * text =
+        reinterpret_cast<const char *>(sqlite3_column_text(stmt, col));
+    if (!parse_timestamp_microseconds(
+            text, sqlite3_column_bytes(stmt, col), us)) {
+      return 0;
+    }
+  }
+  }
+  v->at(row) = static_cast<T>(microseconds_to_ticks(us, type));
+  return 1;
+}
+
 std::uint8_t sqlite_parser::parse_cudf_timestamp_days(
-    void * src, std::size_t col, std::size_t row, cudf_string_col * v) {
-  return parse_cudf_string(src, col, row, v);
+    void * src, std::size_t col, std::size_t row, std::vector<std::int32_t> * v) {
+  return parse_sqlite_timestamp(
+      src, col, row, cudf::type_id::TIMESTAMP_DAYS, v);
 }
 
 std::uint8_t sqlite_parser::parse_cudf_timestamp_seconds(
-    void * src, std::size_t col, std::size_t row, cudf_string_col * v) {
-  return parse_cudf_string(src, col, row, v);
+    void * src, std::size_t col, std::size_t row, std::vector<std::int64_t> * v) {
+  return parse_sqlite_timestamp(
+      src, col, row, cudf::type_id::TIMESTAMP_SECONDS, v);
 }
 
 std::uint8_t sqlite_parser::parse_cudf_timestamp_milliseconds(
-    void * src, std::size_t col, std::size_t row, cudf_string_col * v) {
-  return parse_cudf_string(src, col, row, v);
+    void * src, std::size_t col, std::size_t row, std::vector<std::int64_t> * v) {
+  return parse_sqlite_timestamp(
+      src, col, row, cudf::type_id::TIMESTAMP_MILLISECONDS, v);
 }
 
 std::uint8_t sqlite_parser::parse_cudf_timestamp_microseconds(
-    void * src, std::size_t col, std::size_t row, cudf_string_col * v) {
-  return parse_cudf_string(src, col, row, v);
+    void * src, std::size_t col, std::size_t row, std::vector<std::int64_t> * v) {
+  return parse_sqlite_timestamp(
+      src, col, row, cudf::type_id::TIMESTAMP_MICROSECONDS, v);
 }
 
 std::uint8_t sqlite_parser::parse_cudf_timestamp_nanoseconds(
-    void * src, std::size_t col, std::size_t row, cudf_string_col * v) {
-  return parse_cudf_string(src, col, row, v);
+    void * src, std::size_t col, std::size_t row, std::vector<std::int64_t> * v) {
+  return parse_sqlite_timestamp(
+      src, col, row, cudf::type_id::TIMESTAMP_NANOSECONDS, v);
 }
 
 std::uint8_t sqlite_parser::parse_cudf_string(
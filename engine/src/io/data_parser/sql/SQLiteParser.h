@@ -48,15 +48,15 @@ protected:
   std::uint8_t parse_cudf_bool8(
     void *, std::size_t, std::size_t, std::vector<std::int8_t> *) override;
   std::uint8_t parse_cudf_timestamp_days(
-    void *, std::size_t, std::size_t, cudf_string_col *) override;
+    void *, std::size_t, std::size_t, std::vector<std::int32_t> *) override;
   std::uint8_t parse_cudf_timestamp_seconds(
-    void *, std::size_t, std::size_t, cudf_string_col *) override;
+    void *, std::size_t, std::size_t, std::vector<std::int64_t> *) override;
   std::uint8_t parse_cudf_timestamp_milliseconds(
-    void *, std::size_t, std::size_t, cudf_string_col *) override;
+    void *, std::size_t, std::size_t, std::vector<std::int64_t> *) override;
   std::uint8_t parse_cudf_timestamp_microseconds(
-    void *, std::size_t, std::size_t, cudf_string_col *) override;
+    void *, std::size_t, std::size_t, std::vector<std::int64_t> *) override;
   std::uint8_t parse_cudf_timestamp_nanoseconds(
-    void *, std::size_t, std::size_t, cudf_string_col *) override;
+    void *, std::size_t, std::size_t, std::vector<std::int64_t> *) override;
   std::uint8_t parse_cudf_string(
     void *, std::size_t, std::size_t, cudf_string_col *) override;
 };
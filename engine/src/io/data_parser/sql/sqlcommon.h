@@ -16,6 +16,82 @@ struct cudf_string_col {
   std::vector<cudf::size_type> offsets;
 };
 
+static inline int64_t floor_div(int64_t a, int64_t b) {
+  return a / b - (a % b != 0 && (a < 0) != (b < 0));
+}
+
+// the days from 1970-01-01 to a date of the proleptic gregorian calendar
+// see http://howardhinnant.github.io/date_algorithms.html#days_from_civil
+static inline int64_t days_from_civil(int64_t y, int64_t m, int64_t d) {
+  y -= m <= 2;
+  const int64_t era = (y >= 0 ? y : y - 399) / 400;
+  const int64_t yoe = y - era * 400;
+  const int64_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+  const int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + doe - 719468;
+}
+
+// converts the microseconds from the epoch into the ticks of a cudf timestamp type
+static inline int64_t microseconds_to_ticks(int64_t us, cudf::type_id type) {
+  switch (type) {
+    case cudf::type_id::TIMESTAMP_DAYS: return floor_div(us, 86400000000LL);
+    case cudf::type_id::TIMESTAMP_SECONDS: return floor_div(us, 1000000LL);
+    case cudf::type_id::TIMESTAMP_MILLISECONDS: return floor_div(us, 1000LL);
+    case cudf::type_id::TIMESTAMP_NANOSECONDS: return us * 1000LL;
+    default: return us;
+  }
+}
+
+static inline bool parse_digits(const char *&text, const char *end, size_t max_digits, int64_t &value) {
+  const char *begin = text;
+  value = 0;
+  while (text < end && text - begin < static_cast<std::ptrdiff_t>(max_digits) && *text >= '0' && *text <= '9') {
+    value = value * 10 + (*text - '0');
+    ++text;
+  }
+  return text > begin;
+}
+
+/**
+ * Parses YYYY-MM-DD, YYYY-MM-DD HH:MM:SS[.ffffff] and HH:MM:SS (a time of 1970-01-01) into the microseconds from the
+ * epoch, so that the timestamps are decoded on the host with the other fixed width values instead of being copied to
+ * the GPU as strings and parsed there. Whatever comes after the timestamp is ignored.
+ * @return false if the text is not a timestamp
+ */
+static inline bool parse_timestamp_microseconds(const char *text, size_t length, int64_t &us) {
+  const char *end = text + length;
+  int64_t days = 0;
+  const bool time_only = length > 2 && text[2] == ':';
+  if (!time_only) {
+    int64_t year, month, day;
+    if (!parse_digits(text, end, 4, year) || text == end || *text++ != '-' ||
+        !parse_digits(text, end, 2, month) || text == end || *text++ != '-' ||
+        !parse_digits(text, end, 2, day)) {
+      return false;
+    }
+    days = days_from_civil(year, month, day);
+  }
+  int64_t hour = 0, minute = 0, second = 0, fraction = 0;
+  if (time_only || (text < end && (*text == ' ' || *text == 'T'))) {
+    if (!time_only) ++text;
+    if (!parse_digits(text, end, 2, hour) || text == end || *text++ != ':' ||
+        !parse_digits(text, end, 2, minute) || text == end || *text++ != ':' ||
+        !parse_digits(text, end, 2, second)) {
+      return false;
+    }
+    if (text < end && *text == '.') {
+      ++text;
+      const char *begin = text;
+      parse_digits(text, end, 6, fraction);
+      for (auto digits = text - begin; digits < 6; ++digits) {
+        fraction *= 10;
+      }
+    }
+  }
+  us = ((days * 24 + hour) * 60 + minute) * 60000000LL + second * 1000000LL + fraction;
+  return true;
+}
+
 
 static inline std::unique_ptr<cudf::column>
 build_str_cudf_col(cudf_string_col *host_col,
@@ -0,0 +1,311 @@
+#include "DataPrefetcher.h"
+
+#include <algorithm>
+#include <cstring>
+#include <blazingdb/io/FileSystem/RangedReadCache.h>
+
+namespace ral {
+namespace io {
+
+namespace {
+
+// the bytes of a range that were copied out of the chunks it is in
+class copied_buffer : public cudf::io::datasource::buffer {
+public:
+	explicit copied_buffer(std::vector<uint8_t> && bytes) : bytes(std::move(bytes)) {}
+
+	size_t size() const override { return bytes.size(); }
+
+	const uint8_t * data() const override { return bytes.data(); }
+
+private:
+	std::vector<uint8_t> bytes;
+};
+
+} // namespace
+
+prefetched_data::buffer::~buffer() {
+	if (!chunks.empty()) {
+		data_prefetcher::get_instance().free_pinned_chunks(chunks);
+	}
+}
+
+prefetched_data::prefetched_data(std::shared_ptr<arrow::io::RandomAccessFile> file, std::function<std::vector<byte_range>()> get_ranges)
+	: file_handle(file), get_ranges(get_ranges) {
+}
+
+prefetched_data::~prefetched_data() {
+	release();
+}
+
+void prefetched_data::read() {
+	{
+		std::lock_guard<std::mutex> lock(state_mutex);
+		if (state != prefetch_state::PENDING) {
+			data_prefetcher::get_instance().release_slot();
+			return;
+		}
+		state = prefetch_state::READING;
+		holds_slot = true;
+	}
+
+	std::vector<buffer> read_buffers;
+	try {
+		std::vector<byte_range> ranges = get_ranges();
+		std::sort(ranges.begin(), ranges.end(), [](const byte_range & a, const byte_range & b) { return a.offset < b.offset; });
+		// the files of the remote filesystems fetch all of them in parallel
+		auto ranged_file = std::dynamic_pointer_cast<RangedReadableFile>(file_handle);
+		if (ranged_file != nullptr) {
+			std::vector<ByteRange> planned_ranges;
+			for (const byte_range & range : ranges) {
+				planned_ranges.push_back({range.offset, range.length});
+			}
+			ranged_file->planReads(planned_ranges);
+		}
+		auto & pinned_pool = ral::memory::buffer_providers::get_pinned_buffer_provider();
+		std::size_t chunk_size = pinned_pool != nullptr ? pinned_pool->size_buffers() : 0;
+		for (const byte_range & range : ranges) {
+			if (range.length <= 0 || chunk_size == 0) {
+				break;
+			}
+			// the ranges that don't fit in the pinned chunks the prefetcher can hold now are read by the parser
+			buffer read_buffer(range);
+			read_buffer.chunks = data_prefetcher::get_instance().take_pinned_chunks((range.length + chunk_size - 1) / chunk_size);
+			if (read_buffer.chunks.empty()) {
+				break;
+			}
+			bool read_ok = true;
+			for (std::size_t i = 0; i < read_buffer.chunks.size() && read_ok; i++) {
+				int64_t piece_offset = i * chunk_size;
+				int64_t piece_length = std::min<int64_t>(chunk_size, range.length - piece_offset);
+				auto result = file_handle->ReadAt(range.offset + piece_offset, piece_length, read_buffer.chunks[i]->data);
+				read_ok = result.ok() && result.ValueOrDie() == piece_length;
+			}
+			if (!read_ok) {
+				break;
+			}
+			read_buffers.push_back(std::move(read_buffer));
+		}
+	} catch (const std::exception &) {
+		// the parser reads what is missing by itself, and it reports the errors of the file if there are any
+	}
+
+	std::lock_guard<std::mutex> lock(state_mutex);
+	buffers = std::move(read_buffers);
+	state = prefetch_state::READ;
+	state_cv.notify_all();
+}
+
+void prefetched_data::acquire() {
+	std::unique_lock<std::mutex> lock(state_mutex);
+	if (state == prefetch_state::PENDING) {
+		state = prefetch_state::RELEASED;
+		return;
+	}
+	state_cv.wait(lock, [this] { return state != prefetch_state::READING; });
+}
+
+void prefetched_data::release() {
+	bool release_slot = false;
+	{
+		std::lock_guard<std::mutex> lock(state_mutex);
+		if (state == prefetch_state::READING) {
+			return; // only when the prefetcher is reading it, which owns it until it is done
+		}
+		state = prefetch_state::RELEASED;
+		buffers.clear();
+		release_slot = holds_slot;
+		holds_slot = false;
+	}
+	if (release_slot) {
+		data_prefetcher::get_instance().release_slot();
+	}
+}
+
+const prefetched_data::buffer * prefetched_data::find_buffer(int64_t offset, int64_t length) const {
+	auto it = std::upper_bound(buffers.begin(), buffers.end(), offset,
+		[](int64_t offset, const buffer & read_buffer) { return offset < read_buffer.range.offset; });
+	if (it == buffers.begin()) {
+		return nullptr;
+	}
+	--it;
+	if (offset + length > it->range.offset + it->range.length) {
+		return nullptr;
+	}
+	return &(*it);
+}
+
+const uint8_t * prefetched_data::find(int64_t offset, int64_t length) const {
+	const buffer * read_buffer = find_buffer(offset, length);
+	if (read_buffer == nullptr) {
+		return nullptr;
+	}
+	std::size_t chunk_size = read_buffer->chunks[0]->size;
+	std::size_t start = offset - read_buffer->range.offset;
+	std::size_t chunk_index = start / chunk_size;
+	if (chunk_index >= read_buffer->chunks.size() || (length > 0 && (start + length - 1) / chunk_size != chunk_index)) {
+		return nullptr;
+	}
+	return reinterpret_cast<const uint8_t *>(read_buffer->chunks[chunk_index]->data) + (start % chunk_size);
+}
+
+bool prefetched_data::copy(int64_t offset, int64_t length, uint8_t * dst) const {
+	const buffer * read_buffer = find_buffer(offset, length);
+	if (read_buffer == nullptr) {
+		return false;
+	}
+	std::size_t chunk_size = read_buffer->chunks[0]->size;
+	std::size_t start = offset - read_buffer->range.offset;
+	std::size_t copied = 0;
+	while (copied < static_cast<std::size_t>(length)) {
+		std::size_t chunk_index = (start + copied) / chunk_size;
+		std::size_t chunk_offset = (start + copied) % chunk_size;
+		std::size_t piece_length = std::min(chunk_size - chunk_offset, length - copied);
+		std::memcpy(dst + copied, read_buffer->chunks[chunk_index]->data + chunk_offset, piece_length);
+		copied += piece_length;
+	}
+	return true;
+}
+
+data_prefetcher::~data_prefetcher() {
+	stop_threads();
+}
+
+void data_prefetcher::set_max_in_flight(std::size_t max_in_flight) {
+	stop_threads();
+
+	std::lock_guard<std::mutex> lock(prefetcher_mutex);
+	this->max_in_flight = max_in_flight;
+	for (std::size_t i = 0; i < max_in_flight; i++) {
+		threads.emplace_back(&data_prefetcher::run_thread, this);
+	}
+}
+
+bool data_prefetcher::is_enabled() {
+	std::lock_guard<std::mutex> lock(prefetcher_mutex);
+	return max_in_flight > 0;
+}
+
+std::shared_ptr<prefetched_data> data_prefetcher::prefetch(std::shared_ptr<arrow::io::RandomAccessFile> file,
+	std::function<std::vector<byte_range>()> get_ranges) {
+
+	std::lock_guard<std::mutex> lock(prefetcher_mutex);
+	if (max_in_flight == 0 || file == nullptr) {
+		return nullptr;
+	}
+	auto data = std::make_shared<prefetched_data>(file, get_ranges);
+	queue.push_back(data);
+	prefetcher_cv.notify_one();
+	return data;
+}
+
+void data_prefetcher::release_slot() {
+	std::lock_guard<std::mutex> lock(prefetcher_mutex);
+	in_flight--;
+	prefetcher_cv.notify_all();
+}
+
+std::vector<std::unique_ptr<ral::memory::blazing_allocation_chunk>> data_prefetcher::take_pinned_chunks(std::size_t num_chunks) {
+	std::vector<std::unique_ptr<ral::memory::blazing_allocation_chunk>> chunks;
+	auto & pinned_pool = ral::memory::buffer_providers::get_pinned_buffer_provider();
+	if (pinned_pool == nullptr) {
+		return chunks;
+	}
+	{
+		std::lock_guard<std::mutex> lock(prefetcher_mutex);
+		std::size_t capacity = pinned_pool->get_total_buffers();
+		bool has_free_chunks = pinned_pool->get_allocated_buffers() + num_chunks <= capacity;
+		if (!has_free_chunks || pinned_chunks_held + num_chunks > capacity / 2) {
+			return chunks;
+		}
+		pinned_chunks_held += num_chunks;
+	}
+	for (std::size_t i = 0; i < num_chunks; i++) {
+		chunks.push_back(pinned_pool->get_chunk());
+	}
+	return chunks;
+}
+
+void data_prefetcher::free_pinned_chunks(std::vector<std::unique_ptr<ral::memory::blazing_allocation_chunk>> & chunks) {
+	std::size_t num_chunks = chunks.size();
+	for (auto & chunk : chunks) {
+		chunk->allocation->pool->free_chunk(std::move(chunk));
+	}
+	chunks.clear();
+
+	std::lock_guard<std::mutex> lock(prefetcher_mutex);
+	pinned_chunks_held -= num_chunks;
+}
+
+void data_prefetcher::stop_threads() {
+	{
+		std::lock_guard<std::mutex> lock(prefetcher_mutex);
+		stopping = true;
+		prefetcher_cv.notify_all();
+	}
+	for (auto & thread : threads) {
+		thread.join();
+	}
+
+	std::lock_guard<std::mutex> lock(prefetcher_mutex);
+	threads.clear();
+	// the ranges that are still queued are read by their parsers
+	queue.clear();
+	stopping = false;
+}
+
+void data_prefetcher::run_thread() {
+	while (true) {
+		std::shared_ptr<prefetched_data> data;
+		{
+			std::unique_lock<std::mutex> lock(prefetcher_mutex);
+			prefetcher_cv.wait(lock, [this] { return stopping || (!queue.empty() && in_flight < max_in_flight); });
+			if (stopping) {
+				return;
+			}
+			data = queue.front().lock();
+			queue.pop_front();
+			if (data == nullptr) {
+				continue;
+			}
+			in_flight++;
+		}
+		data->read();
+	}
+}
+
+prefetched_source::prefetched_source(std::shared_ptr<prefetched_data> data)
+	: data(data), file_source(data->file()) {
+	this->data->acquire();
+}
+
+prefetched_source::~prefetched_source() {
+	data->release();
+}
+
+std::unique_ptr<cudf::io::datasource::buffer> prefetched_source::host_read(size_t offset, size_t size) {
+	const uint8_t * prefetched = data->find(offset, size);
+	if (prefetched != nullptr) {
+		return std::make_unique<non_owning_buffer>(const_cast<uint8_t *>(prefetched), size);
+	}
+	// a range in several chunks is copied, which is still faster than reading it again
+	std::vector<uint8_t> bytes(size);
+	if (!data->copy(offset, size, bytes.data())) {
+		return file_source.host_read(offset, size);
+	}
+	return std::make_unique<copied_buffer>(std::move(bytes));
+}
+
+size_t prefetched_source::host_read(size_t offset, size_t size, uint8_t * dst) {
+	if (!data->copy(offset, size, dst)) {
+		return file_source.host_read(offset, size, dst);
+	}
+	return size;
+}
+
+size_t prefetched_source::size() const {
+	return file_source.size();
+}
+
+}  // namespace io
+}  // namespace ral
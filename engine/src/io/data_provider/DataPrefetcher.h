@@ -0,0 +1,176 @@
+#pragma once
+
+#include <arrow/io/interfaces.h>
+#include <cudf/io/datasource.hpp>
+#include "bmr/BufferProvider.h"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ral {
+namespace io {
+
+struct byte_range {
+	int64_t offset;
+	int64_t length;
+};
+
+/**
+ * @brief The byte ranges of a file that a parser will read, which the data_prefetcher reads into chunks of the pinned
+ * buffer provider ahead of time, while the GPU decodes the batches before them.
+ *
+ * The ranges are only known once the metadata of the file is read, which is also I/O, so they are computed by the
+ * threads of the prefetcher too.
+ */
+class prefetched_data {
+public:
+	prefetched_data(std::shared_ptr<arrow::io::RandomAccessFile> file, std::function<std::vector<byte_range>()> get_ranges);
+	~prefetched_data();
+
+	/**
+	 * @brief Reads the ranges, unless the parser took them first. It is called by the threads of the data_prefetcher.
+	 */
+	void read();
+
+	/**
+	 * @brief Waits for the ranges that are being read. If they were not being read yet they are not read ahead anymore,
+	 * and the parser reads the file by itself.
+	 */
+	void acquire();
+
+	/**
+	 * @brief Frees the buffers once the parser is done with them, which lets the prefetcher read ahead more ranges.
+	 */
+	void release();
+
+	/**
+	 * @brief Returns the memory with the bytes of [offset, offset + length) or nullptr if they were not read ahead or
+	 * they are in several chunks. Only valid between acquire and release.
+	 */
+	const uint8_t * find(int64_t offset, int64_t length) const;
+
+	/**
+	 * @brief Copies the bytes of [offset, offset + length) to dst, from all the chunks they are in.
+	 * @return false if they were not read ahead. Only valid between acquire and release.
+	 */
+	bool copy(int64_t offset, int64_t length, uint8_t * dst) const;
+
+	std::shared_ptr<arrow::io::RandomAccessFile> file() const { return file_handle; }
+
+private:
+	enum class prefetch_state { PENDING, READING, READ, RELEASED };
+
+	// the bytes of a range, in chunks of the pinned buffer provider that are given back when it is destroyed
+	struct buffer {
+		explicit buffer(byte_range range) : range(range) {}
+		buffer(buffer &&) = default;
+		buffer & operator=(buffer &&) = default;
+		~buffer();
+
+		byte_range range;
+		std::vector<std::unique_ptr<ral::memory::blazing_allocation_chunk>> chunks;
+	};
+
+	const buffer * find_buffer(int64_t offset, int64_t length) const;
+
+	void release_buffers();
+
+	std::shared_ptr<arrow::io::RandomAccessFile> file_handle;
+	std::function<std::vector<byte_range>()> get_ranges;
+	std::vector<buffer> buffers; // sorted by their offsets
+	prefetch_state state = prefetch_state::PENDING;
+	bool holds_slot = false;
+	std::mutex state_mutex;
+	std::condition_variable state_cv;
+};
+
+/**
+ * @brief A process wide pool of threads that reads ahead the byte ranges of the files of the scans, in the order the
+ * tasks that parse them were made, with at most max_in_flight of them read and not yet parsed at a time.
+ */
+class data_prefetcher {
+public:
+	static data_prefetcher & get_instance() {
+		static data_prefetcher instance;
+		return instance;
+	}
+
+	/**
+	 * @brief Sets the number of files or row groups that are read ahead at a time. 0 turns the prefetcher off. It is set by
+	 * IO_PREFETCH_IN_FLIGHT when the engine is initialized.
+	 */
+	void set_max_in_flight(std::size_t max_in_flight);
+
+	bool is_enabled();
+
+	/**
+	 * @brief Queues the ranges of a file to be read ahead.
+	 * @return nullptr if the prefetcher is off.
+	 */
+	std::shared_ptr<prefetched_data> prefetch(std::shared_ptr<arrow::io::RandomAccessFile> file,
+		std::function<std::vector<byte_range>()> get_ranges);
+
+	/**
+	 * @brief Frees the slot the ranges of a prefetched_data took while they were read and not yet parsed.
+	 */
+	void release_slot();
+
+	/**
+	 * @brief Takes num_chunks chunks off the pinned buffer provider for the ranges that are read ahead, as long as they
+	 * hold at most half of its chunks, so that the transports and the spills keep the rest and the pool does not grow.
+	 * @return the chunks, or none if they can't be taken now.
+	 */
+	std::vector<std::unique_ptr<ral::memory::blazing_allocation_chunk>> take_pinned_chunks(std::size_t num_chunks);
+
+	/**
+	 * @brief Gives back the chunks of take_pinned_chunks.
+	 */
+	void free_pinned_chunks(std::vector<std::unique_ptr<ral::memory::blazing_allocation_chunk>> & chunks);
+
+private:
+	data_prefetcher() = default;
+	~data_prefetcher();
+	data_prefetcher(data_prefetcher &&) = delete;
+	data_prefetcher(const data_prefetcher &) = delete;
+	data_prefetcher & operator=(data_prefetcher &&) = delete;
+	data_prefetcher & operator=(const data_prefetcher &) = delete;
+
+	void stop_threads();
+	void run_thread();
+
+	std::mutex prefetcher_mutex;
+	std::condition_variable prefetcher_cv;
+	std::deque<std::weak_ptr<prefetched_data>> queue;
+	std::vector<std::thread> threads;
+	std::size_t max_in_flight = 0;
+	std::size_t in_flight = 0;
+	std::size_t pinned_chunks_held = 0;
+	bool stopping = false;
+};
+
+/**
+ * @brief A cudf datasource that reads the ranges of a file that were read ahead from their host buffers, and the rest of
+ * the file from the file itself.
+ */
+class prefetched_source : public cudf::io::datasource {
+public:
+	explicit prefetched_source(std::shared_ptr<prefetched_data> data);
+	~prefetched_source() override;
+
+	std::unique_ptr<datasource::buffer> host_read(size_t offset, size_t size) override;
+
+	size_t host_read(size_t offset, size_t size, uint8_t * dst) override;
+
+	size_t size() const override;
+
+private:
+	std::shared_ptr<prefetched_data> data;
+	cudf::io::arrow_io_source file_source;
+};
+
+}  // namespace io
+}  // namespace ral
@@ -65,13 +65,20 @@ struct sql_datasource {
   // TODO percy c.gonzales add other backends here
 };
 
+class prefetched_data;
+
 struct data_handle {
 	std::shared_ptr<arrow::io::RandomAccessFile> file_handle;
+	std::shared_ptr<prefetched_data> prefetched;	  // the bytes of the file that were read ahead, see data_prefetcher
 	std::map<std::string, std::string> column_values;  // allows us to add hive values
 	Uri uri;										  // in case the data was loaded from a file
 	frame::BlazingTableView table_view;
 	std::shared_ptr<arrow::Table> arrow_table;
 	sql_datasource sql_handle;
+	// a range of the rows of a file that is read instead of whole row groups, so that a large row group is decoded a
+	// slice at a time, see parquet_parser. -1 reads the row groups
+	int64_t skip_rows = 0;
+	int64_t num_rows = -1;
 	data_handle(){}
 
 	data_handle(
@@ -131,6 +138,33 @@ public:
 	 * Get the number of data_handles that will be provided.
 	 */
 	virtual size_t get_num_handles() = 0;
+
+	/**
+	 * Get a string that identifies the version of the data given by this provider, so that the results computed from it
+	 * can be reused while it does not change. An empty string means that the version is not known.
+	 */
+	virtual std::string get_data_version() { return ""; }
+
+	/**
+	 * Get the hive partition values of each of the uris of this provider, empty if it has none.
+	 */
+	virtual std::vector<std::map<std::string, std::string>> get_partition_values() { return {}; }
+
+	/**
+	 * Keeps only the uris at these indices, so that the files of the other partitions are never listed nor opened.
+	 */
+	virtual void keep_partitions(const std::vector<std::size_t> & /*indices*/) {}
+
+	/**
+	 * Takes up to num_files of the last uris that were not given yet out of this provider, for the scan of another node
+	 * to read them. The data_handles have the uris and their hive values, but no open files.
+	 */
+	virtual std::vector<data_handle> take_last_files(std::size_t /*num_files*/) { return {}; }
+
+	/**
+	 * Adds the uris that the scan of another node gave, with their hive values, after the ones of this provider.
+	 */
+	virtual void add_files(const std::vector<data_handle> & /*files*/) {}
 };
 
 } /* namespace io */
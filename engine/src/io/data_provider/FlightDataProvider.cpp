@@ -0,0 +1,180 @@
+#include "FlightDataProvider.h"
+
+#include <stdexcept>
+
+#include <arrow/ipc/dictionary.h>
+
+namespace ral {
+namespace io {
+
+namespace {
+
+const std::size_t DEFAULT_FLIGHT_BATCH_BYTES = 268435456;
+
+void check_status(const arrow::Status & status, const std::string & what) {
+	if (!status.ok()) {
+		throw std::runtime_error("ERROR: " + what + " of the arrow flight failed: " + status.ToString());
+	}
+}
+
+std::unique_ptr<arrow::flight::FlightClient> connect(const std::string & uri) {
+	arrow::flight::Location location;
+	check_status(arrow::flight::Location::Parse(uri, &location), "Parsing the location " + uri);
+	std::unique_ptr<arrow::flight::FlightClient> client;
+	check_status(arrow::flight::FlightClient::Connect(location, &client), "Connecting to " + uri);
+	return client;
+}
+
+int64_t get_byte_size(const arrow::ArrayData & data) {
+	int64_t size = 0;
+	for (const auto & buffer : data.buffers) {
+		if (buffer != nullptr) {
+			size += buffer->size();
+		}
+	}
+	for (const auto & child : data.child_data) {
+		size += get_byte_size(*child);
+	}
+	return size;
+}
+
+} // namespace
+
+flight_info getFlightInfo(const std::map<std::string, std::string> & args_map) {
+	flight_info info;
+	auto it = args_map.find("flight_location");
+	if (it == args_map.end()) {
+		throw std::runtime_error("ERROR: The location of the arrow flight was not given");
+	}
+	info.location = it->second;
+	it = args_map.find("from_flight");
+	info.command = it != args_map.end() ? it->second : "";
+	it = args_map.find("flight_batch_bytes");
+	info.batch_bytes = it != args_map.end() ? std::stoull(it->second) : DEFAULT_FLIGHT_BATCH_BYTES;
+	return info;
+}
+
+flight_data_provider::flight_data_provider(const flight_info & info, size_t total_number_of_nodes, size_t self_node_idx)
+	: info(info), total_number_of_nodes(total_number_of_nodes), self_node_idx(self_node_idx) {
+	client = connect(info.location);
+
+	std::unique_ptr<arrow::flight::FlightInfo> flight;
+	check_status(client->GetFlightInfo(arrow::flight::FlightDescriptor::Command(info.command), &flight), "Getting the info");
+	arrow::ipc::DictionaryMemo dictionary_memo;
+	check_status(flight->GetSchema(&dictionary_memo, &schema), "Getting the schema");
+
+	// the endpoints are split between the nodes like the files are
+	for (std::size_t i = 0; i < flight->endpoints().size(); i++) {
+		if (total_number_of_nodes == 0 || i % total_number_of_nodes == self_node_idx) {
+			endpoints.push_back(flight->endpoints()[i]);
+		}
+	}
+}
+
+flight_data_provider::~flight_data_provider() {
+	if (next_table_future.valid()) {
+		next_table_future.wait();
+	}
+}
+
+std::shared_ptr<data_provider> flight_data_provider::clone() {
+	return std::make_shared<flight_data_provider>(this->info, this->total_number_of_nodes, this->self_node_idx);
+}
+
+std::shared_ptr<arrow::Table> flight_data_provider::read_next_table() {
+	std::vector<std::shared_ptr<arrow::RecordBatch>> batches;
+	std::size_t batches_bytes = 0;
+	while (batches_bytes < info.batch_bytes && current_endpoint < endpoints.size()) {
+		if (stream == nullptr) {
+			const auto & endpoint = endpoints[current_endpoint];
+			arrow::flight::FlightClient * endpoint_source = client.get();
+			if (!endpoint.locations.empty() && endpoint.locations[0].ToString() != info.location) {
+				endpoint_client = connect(endpoint.locations[0].ToString());
+				endpoint_source = endpoint_client.get();
+			}
+			check_status(endpoint_source->DoGet(endpoint.ticket, &stream), "Reading a stream");
+		}
+
+		arrow::flight::FlightStreamChunk chunk;
+		check_status(stream->Next(&chunk), "Reading a batch");
+		if (chunk.data == nullptr) {
+			stream.reset();
+			endpoint_client.reset();
+			current_endpoint++;
+			continue;
+		}
+		for (int i = 0; i < chunk.data->num_columns(); i++) {
+			batches_bytes += get_byte_size(*chunk.data->column_data(i));
+		}
+		batches.push_back(chunk.data);
+	}
+	if (batches.empty()) {
+		return nullptr;
+	}
+
+	// the batches are made contiguous here, so that each column is copied to the GPU at once instead of batch by batch
+	auto table = arrow::Table::FromRecordBatches(schema, batches).ValueOrDie();
+	return table->CombineChunks().ValueOrDie();
+}
+
+void flight_data_provider::wait_for_next_table() {
+	if (!next_table_ready) {
+		next_table = next_table_future.valid() ? next_table_future.get() : read_next_table();
+		next_table_ready = true;
+	}
+}
+
+bool flight_data_provider::has_next() {
+	wait_for_next_table();
+	return next_table != nullptr;
+}
+
+void flight_data_provider::reset() {
+	if (next_table_future.valid()) {
+		next_table_future.wait();
+		next_table_future = std::future<std::shared_ptr<arrow::Table>>();
+	}
+	stream.reset();
+	endpoint_client.reset();
+	current_endpoint = 0;
+	next_table = nullptr;
+	next_table_ready = false;
+}
+
+data_handle flight_data_provider::get_next(bool open_file) {
+	if (!open_file) {
+		std::vector<std::shared_ptr<arrow::ChunkedArray>> columns;
+		for (const auto & field : schema->fields()) {
+			columns.push_back(std::make_shared<arrow::ChunkedArray>(arrow::ArrayVector{}, field->type()));
+		}
+		return data_handle(nullptr, {}, Uri("flight"), arrow::Table::Make(schema, columns, 0));
+	}
+
+	wait_for_next_table();
+	auto table = next_table;
+	next_table = nullptr;
+	next_table_ready = false;
+	if (table != nullptr) {
+		// the next table is read while this one is decoded and processed
+		next_table_future = std::async(std::launch::async, [this]() { return this->read_next_table(); });
+	}
+	return data_handle(nullptr, {}, Uri("flight"), table);
+}
+
+std::vector<data_handle> flight_data_provider::get_some(std::size_t num_files, bool /*open_file*/) {
+	// the handles without a table would never advance the streams, so the tables are always read
+	std::vector<data_handle> handles;
+	while (handles.size() < num_files && this->has_next()) {
+		handles.push_back(this->get_next(true));
+	}
+	return handles;
+}
+
+void flight_data_provider::close_file_handles() {}
+
+size_t flight_data_provider::get_num_handles() {
+	return 0;
+}
+
+} /* namespace io */
+} /* namespace ral */
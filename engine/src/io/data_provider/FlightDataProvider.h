@@ -0,0 +1,96 @@
+#ifndef FLIGHTDATAPROVIDER_H_
+#define FLIGHTDATAPROVIDER_H_
+
+#include "DataProvider.h"
+
+#include <future>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <arrow/flight/api.h>
+#include <arrow/table.h>
+
+namespace ral {
+namespace io {
+
+struct flight_info {
+	std::string location;	 // the uri of the flight service, for example grpc://localhost:8815
+	std::string command;	 // the command of the descriptor of the flight
+	std::size_t batch_bytes; // the record batches are concatenated into tables of about this size
+};
+
+/**
+ * The flight of a table, from the flight_location, from_flight and flight_batch_bytes args of create_table
+ */
+flight_info getFlightInfo(const std::map<std::string, std::string> & args_map);
+
+/**
+ * Streams the record batches of the endpoints of an Arrow Flight, whose tickets are split between the nodes.
+ *
+ * The consecutive batches of a stream are concatenated into tables of about batch_bytes, which is what the parser
+ * copies to the GPU in one go. The table after the one that was returned is read from the stream in the background,
+ * so that the flight transfer overlaps with the decoding and processing of the tables before it.
+ */
+class flight_data_provider : public data_provider {
+public:
+	flight_data_provider(const flight_info & info, size_t total_number_of_nodes, size_t self_node_idx);
+
+	virtual ~flight_data_provider();
+
+	std::shared_ptr<data_provider> clone() override;
+
+	/**
+	 * tells us if there are more record batches in the streams, which waits for the next table to be read
+	 */
+	bool has_next() override;
+
+	/**
+	 * Starts reading the streams from their first batch again
+	 */
+	void reset() override;
+
+	/**
+	 * gets the next table of record batches, and starts reading the one after it.
+	 * open_file = false does not read the streams, and returns a handle to an empty table with the schema of the flight
+	 */
+	data_handle get_next(bool open_file = true) override;
+
+	/**
+	 * gets up to num_files tables, which are always read from the streams
+	 */
+	std::vector<data_handle> get_some(std::size_t num_files, bool open_file = true) override;
+
+	/**
+	 * Does nothing. Used for compatiblity with apis that open files.
+	 */
+	void close_file_handles() override;
+
+	/**
+	 * The number of tables is not known until the streams end, so it returns 0
+	 */
+	size_t get_num_handles() override;
+
+private:
+	std::shared_ptr<arrow::Table> read_next_table();
+	void wait_for_next_table();
+
+	flight_info info;
+	size_t total_number_of_nodes;
+	size_t self_node_idx;
+	std::unique_ptr<arrow::flight::FlightClient> client;
+	std::shared_ptr<arrow::Schema> schema;
+	std::vector<arrow::flight::FlightEndpoint> endpoints; // the endpoints of this node
+	std::size_t current_endpoint = 0;
+	std::unique_ptr<arrow::flight::FlightClient> endpoint_client; // when the endpoint is not served by the main location
+	std::unique_ptr<arrow::flight::FlightStreamReader> stream;
+	std::future<std::shared_ptr<arrow::Table>> next_table_future;
+	std::shared_ptr<arrow::Table> next_table;
+	bool next_table_ready = false;
+};
+
+} /* namespace io */
+} /* namespace ral */
+
+#endif /* FLIGHTDATAPROVIDER_H_ */
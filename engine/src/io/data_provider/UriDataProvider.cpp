@@ -10,13 +10,36 @@
 #include "UriDataProvider.h"
 #include "Config/BlazingContext.h"
 #include "arrow/status.h"
+#include <blazingdb/io/FileSystem/ObjectStoreConfig.h>
 #include <blazingdb/io/Util/StringUtil.h>
 
+#include <algorithm>
+
 using namespace fmt::literals;
 
 namespace ral {
 namespace io {
 
+namespace {
+
+// the files of the remote filesystems take one or more round trips to open, the local ones are opened right away
+bool is_opened_concurrently(const Uri & uri) {
+	return uri.getFileSystemType() == FileSystemType::S3 || uri.getFileSystemType() == FileSystemType::GOOGLE_CLOUD_STORAGE ||
+		uri.getFileSystemType() == FileSystemType::HDFS;
+}
+
+// the size is asked for here, so that when the filesystem did not get it from a listing its request is made by the
+// thread that opens the file and not by the parser
+std::shared_ptr<arrow::io::RandomAccessFile> open_file_and_size(const Uri & uri) {
+	std::shared_ptr<arrow::io::RandomAccessFile> file = BlazingContext::getInstance()->getFileSystemManager()->openReadable(uri);
+	if (file) {
+		file->GetSize();
+	}
+	return file;
+}
+
+}  // namespace
+
 uri_data_provider::uri_data_provider(std::vector<Uri> uris, bool ignore_missing_paths)
 	: data_provider(), file_uris(uris), current_file(0), opened_files({}), errors({}),
 	uri_values({}), directory_uris({}), directory_current_file(0), ignore_missing_paths(ignore_missing_paths) {}
@@ -38,6 +61,86 @@ size_t uri_data_provider::get_num_handles(){
 	return file_uris.size();
 }
 
+std::string uri_data_provider::get_data_version() {
+	std::string version;
+	try {
+		auto fs_manager = BlazingContext::getInstance()->getFileSystemManager();
+		if (!fs_manager) {
+			return "";
+		}
+		for (auto & uri : this->file_uris) {
+			std::vector<Uri> uris;
+			if (uri.getPath().hasWildcard()) {
+				Uri parent_uri(uri.getScheme(), uri.getAuthority(), uri.getPath().getParentPath());
+				uris = fs_manager->list(parent_uri, uri.getPath().getResourceName());
+			} else if (fs_manager->getFileStatus(uri).isDirectory()) {
+				uris = fs_manager->list(uri);
+			} else {
+				uris.push_back(uri);
+			}
+			for (auto & file_uri : uris) {
+				FileStatus status = fs_manager->getFileStatus(file_uri);
+				version += file_uri.toString() + "@" + std::to_string(status.getModificationTime()) + ":" + std::to_string(status.getFileSize()) + ";";
+			}
+		}
+	} catch(const std::exception & e) {
+		// if we can't know the version of all the files, the results that were computed from them can't be reused
+		return "";
+	}
+	return version;
+}
+
+std::vector<std::map<std::string, std::string>> uri_data_provider::get_partition_values() {
+	return this->uri_values.size() == this->file_uris.size() ? this->uri_values : std::vector<std::map<std::string, std::string>>();
+}
+
+void uri_data_provider::keep_partitions(const std::vector<std::size_t> & indices) {
+	std::vector<Uri> kept_uris;
+	std::vector<std::map<std::string, std::string>> kept_values;
+	for (std::size_t index : indices) {
+		kept_uris.push_back(this->file_uris[index]);
+		if (index < this->uri_values.size()) {
+			kept_values.push_back(this->uri_values[index]);
+		}
+	}
+	this->file_uris = kept_uris;
+	this->uri_values = kept_values;
+	this->directory_uris = {};
+	this->reset();
+}
+
+std::vector<data_handle> uri_data_provider::take_last_files(std::size_t num_files) {
+	// the directory that is being listed is not given
+	std::size_t first_unstarted = this->current_file + (this->directory_uris.empty() ? 0 : 1);
+	std::size_t num_unstarted = this->file_uris.size() > first_unstarted ? this->file_uris.size() - first_unstarted : 0;
+	std::size_t first_taken = this->file_uris.size() - std::min(num_files, num_unstarted);
+
+	std::vector<data_handle> taken;
+	for (std::size_t i = first_taken; i < this->file_uris.size(); i++) {
+		data_handle handle;
+		handle.uri = this->file_uris[i];
+		if (i < this->uri_values.size()) {
+			handle.column_values = this->uri_values[i];
+		}
+		taken.push_back(handle);
+	}
+	this->file_uris.resize(first_taken);
+	if (this->uri_values.size() > first_taken) {
+		this->uri_values.resize(first_taken);
+	}
+	return taken;
+}
+
+void uri_data_provider::add_files(const std::vector<data_handle> & files) {
+	for (const data_handle & file : files) {
+		if (!file.column_values.empty() || !this->uri_values.empty()) {
+			this->uri_values.resize(this->file_uris.size());
+			this->uri_values.push_back(file.column_values);
+		}
+		this->file_uris.push_back(file.uri);
+	}
+}
+
 uri_data_provider::~uri_data_provider() {
 	// TODO: when a shared_ptr to a randomaccessfile goes out of scope does it close files automatically?
 	// in case it doesnt we can close that here
@@ -60,23 +163,75 @@ std::vector<data_handle> uri_data_provider::get_some(std::size_t num_files, bool
 	std::size_t count = 0;
 	std::vector<data_handle> file_handles;
 	while(this->has_next() && count < num_files) {
-		auto handle = this->get_next(open_file);
+		auto handle = this->get_next(false);
 		if (handle.is_valid())
 			file_handles.emplace_back(std::move(handle));
 		count++;
 	}
+	if (!open_file) {
+		return file_handles;
+	}
+
+	// the files of the object stores are opened up to OBJECT_STORE_OPEN_CONCURRENCY at a time, over the connections
+	// that the client of their filesystem keeps alive
+	const std::size_t concurrency = ObjectStoreConfig::getInstance().getOpenConcurrency();
+	for (std::size_t first = 0; first < file_handles.size(); first += concurrency) {
+		const std::size_t last = std::min(first + concurrency, file_handles.size());
+		std::vector<std::future<std::shared_ptr<arrow::io::RandomAccessFile>>> opens;
+		for (std::size_t i = first; i < last; i++) {
+			const Uri uri = file_handles[i].uri;
+			if (is_opened_concurrently(uri) && this->pending_opens.count(uri.toString()) == 0) {
+				opens.push_back(std::async(std::launch::async, [uri]() { return open_file_and_size(uri); }));
+			} else {
+				std::promise<std::shared_ptr<arrow::io::RandomAccessFile>> opened;
+				opened.set_value(this->open_readable(uri));
+				opens.push_back(opened.get_future());
+			}
+		}
+		for (std::size_t i = first; i < last; i++) {
+			std::shared_ptr<arrow::io::RandomAccessFile> file = opens[i - first].get();
+			file_handles[i].file_handle = file;
+			this->opened_files.push_back(file);
+		}
+	}
 	return file_handles;
 }
 
+std::shared_ptr<arrow::io::RandomAccessFile> uri_data_provider::open_readable(const Uri & uri) {
+	auto pending = this->pending_opens.find(uri.toString());
+	if (pending == this->pending_opens.end()) {
+		return BlazingContext::getInstance()->getFileSystemManager()->openReadable(uri);
+	}
+	std::future<std::shared_ptr<arrow::io::RandomAccessFile>> open = std::move(pending->second);
+	this->pending_opens.erase(pending);
+	return open.get();
+}
+
+void uri_data_provider::open_ahead(size_t first) {
+	const size_t concurrency = ObjectStoreConfig::getInstance().getOpenConcurrency();
+	for (size_t i = first; i < this->directory_uris.size() && i < first + concurrency - 1 &&
+			this->pending_opens.size() < concurrency - 1; i++) {
+		const Uri uri = this->directory_uris[i];
+		if (!is_opened_concurrently(uri)) {
+			return;
+		}
+		if (this->pending_opens.count(uri.toString()) == 0) {
+			this->pending_opens.emplace(uri.toString(), std::async(std::launch::async, [uri]() { return open_file_and_size(uri); }));
+		}
+	}
+}
+
 data_handle uri_data_provider::get_next(bool open_file) {
 	// TODO: Take a look at this later, just calling this function to ensure
 	// the uri is in a valid state otherwise throw an exception
 	// because openReadable doens't  validate it and just return a nullptr
 
 	if(this->directory_uris.size() > 0 && this->directory_current_file < this->directory_uris.size()) {
-		std::shared_ptr<arrow::io::RandomAccessFile> file = open_file ? 
-			BlazingContext::getInstance()->getFileSystemManager()->openReadable(
-				this->directory_uris[this->directory_current_file]) : nullptr;
+		std::shared_ptr<arrow::io::RandomAccessFile> file = nullptr;
+		if (open_file) {
+			file = this->open_readable(this->directory_uris[this->directory_current_file]);
+			this->open_ahead(this->directory_current_file + 1);
+		}
 
 		data_handle handle;
 		handle.uri = this->directory_uris[this->directory_current_file];
@@ -250,6 +405,19 @@ void uri_data_provider::close_file_handles() {
 		//
 	}
 	this->opened_files.resize(0);
+
+	// the files that were opened ahead and never given are closed too, once their opens are done
+	for(auto & pending : this->pending_opens) {
+		try {
+			std::shared_ptr<arrow::io::RandomAccessFile> file = pending.second.get();
+			if (file) {
+				file->Close();
+			}
+		} catch(const std::exception & e) {
+			// the error of a file that was not asked for is not an error of the query
+		}
+	}
+	this->pending_opens.clear();
 }
 
 
@@ -13,6 +13,8 @@
 #include <blazingdb/io/FileSystem/Uri.h>
 #include <vector>
 
+#include <future>
+#include <map>
 #include <memory>
 
 
@@ -63,7 +65,30 @@ public:
 
 	size_t get_num_handles();
 
+	/**
+	 * Get the uri, modification time and size of every file that this provider gives.
+	 */
+	std::string get_data_version() override;
+
+	std::vector<std::map<std::string, std::string>> get_partition_values() override;
+
+	void keep_partitions(const std::vector<std::size_t> & indices) override;
+
+	std::vector<data_handle> take_last_files(std::size_t num_files) override;
+
+	void add_files(const std::vector<data_handle> & files) override;
+
 private:
+	/**
+	 * opens the file of the uri, with the open that was started ahead for it if there was one
+	 */
+	std::shared_ptr<arrow::io::RandomAccessFile> open_readable(const Uri & uri);
+	/**
+	 * starts opening the files of the directory being listed that come after the one at first, so that the requests of
+	 * the object stores for the next files are in flight while this one is parsed
+	 */
+	void open_ahead(size_t first);
+
 	/**
 	 * stores the list of uris that will be used by the provider
 	 */
@@ -76,6 +101,10 @@ private:
 	 * stores the files that were opened by the provider to be closed when it goes out of scope
 	 */
 	std::vector<std::shared_ptr<arrow::io::RandomAccessFile>> opened_files;
+	/**
+	 * stores the files of the directory being listed that are being opened ahead, by their uris
+	 */
+	std::map<std::string, std::future<std::shared_ptr<arrow::io::RandomAccessFile>>> pending_opens;
 	// TODO: we should really be either handling exceptions up the call stack or
 	// storing something more elegant than just a string with an error message
 	/**
@@ -0,0 +1,130 @@
+#include "folder_lister.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+
+#include <blazingdb/io/Config/BlazingContext.h>
+#include "ExceptionHandling/BlazingThread.h"
+
+namespace ral {
+namespace io {
+
+void folder_lister::configure(std::size_t max_threads, std::size_t cache_ttl_ms) {
+	std::lock_guard<std::mutex> lock(cache_mutex);
+	this->max_threads = std::max<std::size_t>(max_threads, 1);
+	this->cache_ttl = std::chrono::milliseconds(cache_ttl_ms);
+	listings.clear();
+}
+
+std::vector<Uri> folder_lister::list_partition_folders_uncached(const Uri & folder_uri) {
+	auto fs = BlazingContext::getInstance()->getFileSystemManager();
+	std::vector<Uri> folders;
+	if (folder_uri.getFileSystemType() == FileSystemType::S3) {
+		// the common prefixes of the delimited listing are the folders, so their status needs no other request
+		for (auto && status : fs->list(folder_uri, FileType::DIRECTORY)) {
+			if (status.getUri().getPath().getResourceName().find('=') != std::string::npos) {
+				folders.push_back(status.getUri());
+			}
+		}
+	} else {
+		for (auto && uri : fs->list(folder_uri, "*=*")) {
+			if (fs->getFileStatus(uri).isDirectory()) {
+				folders.push_back(uri);
+			}
+		}
+	}
+	return folders;
+}
+
+std::vector<Uri> folder_lister::list_partition_folders(const Uri & folder_uri) {
+	std::string key = folder_uri.toString();
+	auto now = std::chrono::steady_clock::now();
+	{
+		std::lock_guard<std::mutex> lock(cache_mutex);
+		auto it = listings.find(key);
+		if (it != listings.end()) {
+			if (now - it->second.listed_at < cache_ttl) {
+				return it->second.folders;
+			}
+			listings.erase(it);
+		}
+	}
+
+	std::vector<Uri> folders = list_partition_folders_uncached(folder_uri);
+
+	std::lock_guard<std::mutex> lock(cache_mutex);
+	if (cache_ttl.count() > 0) {
+		listings[key] = {now, folders};
+	}
+	return folders;
+}
+
+std::vector<std::pair<Uri, int>> folder_lister::find_partition_folders(const Uri & folder_uri) {
+	std::size_t num_threads;
+	{
+		std::lock_guard<std::mutex> lock(cache_mutex);
+		num_threads = max_threads;
+		// the expired listings of the tables that are not read anymore are dropped here
+		auto now = std::chrono::steady_clock::now();
+		for (auto it = listings.begin(); it != listings.end();) {
+			it = now - it->second.listed_at < cache_ttl ? std::next(it) : listings.erase(it);
+		}
+	}
+
+	std::mutex mutex;
+	std::condition_variable condition;
+	std::deque<std::pair<Uri, int>> pending{{folder_uri, 0}}; // the folders to list, with the depth of their folders
+	std::size_t listing_count = 0;
+	std::exception_ptr error;
+	std::vector<std::pair<Uri, int>> partition_folders;
+
+	auto list_pending_folders = [&]() {
+		std::unique_lock<std::mutex> lock(mutex);
+		while (true) {
+			condition.wait(lock, [&]() { return !pending.empty() || listing_count == 0 || error; });
+			if (pending.empty() || error) {
+				break;
+			}
+			auto folder = pending.front();
+			pending.pop_front();
+			listing_count++;
+			lock.unlock();
+
+			std::vector<Uri> folders;
+			std::exception_ptr listing_error;
+			try {
+				folders = list_partition_folders(folder.first);
+			} catch (...) {
+				listing_error = std::current_exception();
+			}
+
+			lock.lock();
+			listing_count--;
+			if (listing_error && !error) {
+				error = listing_error;
+			}
+			for (auto && uri : folders) {
+				partition_folders.emplace_back(uri, folder.second);
+				pending.emplace_back(uri, folder.second + 1);
+			}
+			condition.notify_all();
+		}
+	};
+
+	std::vector<BlazingThread> threads;
+	for (std::size_t i = 0; i < num_threads; i++) {
+		threads.push_back(BlazingThread(list_pending_folders));
+	}
+	for (auto && thread : threads) {
+		thread.join();
+	}
+	if (error) {
+		std::rethrow_exception(error);
+	}
+	return partition_folders;
+}
+
+}  // namespace io
+}  // namespace ral
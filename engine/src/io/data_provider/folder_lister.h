@@ -0,0 +1,72 @@
+#ifndef BLAZINGDB_RAL_SRC_IO_DATA_PROVIDER_FOLDER_LISTER_H_
+#define BLAZINGDB_RAL_SRC_IO_DATA_PROVIDER_FOLDER_LISTER_H_
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <blazingdb/io/FileSystem/Uri.h>
+
+namespace ral {
+namespace io {
+
+/**
+ * @brief Lists the folders of the filesystems for the discovery of the hive partitions, with a process wide cache of
+ * the listings.
+ *
+ * The partition folders are walked level by level by up to max_threads listings at a time, so that the tables with
+ * many partitions in an object store don't wait for one listing request after another. S3 lists a folder with a
+ * single delimited prefix listing, which already tells which of its entries are folders.
+ */
+class folder_lister {
+public:
+	static folder_lister & get_instance() {
+		static folder_lister instance;
+		return instance;
+	}
+
+	/**
+	 * @brief Lists up to max_threads folders at a time and keeps the listings for cache_ttl_ms milliseconds, where a
+	 * cache_ttl_ms of 0 turns the cache off. It is set by FOLDER_LISTING_THREADS and FOLDER_LISTING_CACHE_TTL_MS when
+	 * the engine is initialized.
+	 */
+	void configure(std::size_t max_threads, std::size_t cache_ttl_ms);
+
+	/**
+	 * @brief The uris of the folders named column=value in the folder, which is listed only if its listing is not cached.
+	 */
+	std::vector<Uri> list_partition_folders(const Uri & folder_uri);
+
+	/**
+	 * @brief Finds the partition folders under the folder, at any depth.
+	 * @return the uris of the partition folders with their depth, 0 being the folders in folder_uri
+	 */
+	std::vector<std::pair<Uri, int>> find_partition_folders(const Uri & folder_uri);
+
+private:
+	struct listing {
+		std::chrono::steady_clock::time_point listed_at;
+		std::vector<Uri> folders;
+	};
+
+	folder_lister() = default;
+	folder_lister(folder_lister &&) = delete;
+	folder_lister(const folder_lister &) = delete;
+	folder_lister & operator=(folder_lister &&) = delete;
+	folder_lister & operator=(const folder_lister &) = delete;
+
+	std::vector<Uri> list_partition_folders_uncached(const Uri & folder_uri);
+
+	std::mutex cache_mutex;
+	std::size_t max_threads = 16;
+	std::chrono::milliseconds cache_ttl{60000};
+	std::map<std::string, listing> listings; // by the uri of the folder
+};
+
+}  // namespace io
+}  // namespace ral
+
+#endif	// BLAZINGDB_RAL_SRC_IO_DATA_PROVIDER_FOLDER_LISTER_H_
@@ -0,0 +1,170 @@
+#include "shared_scan.h"
+
+#include <algorithm>
+
+namespace ral {
+namespace io {
+
+namespace {
+
+// the columns of the read are sorted, so that includes can tell if it has all the columns of another one
+std::vector<int> sorted_columns(const std::vector<int> & column_indices) {
+	std::vector<int> sorted = column_indices;
+	std::sort(sorted.begin(), sorted.end());
+	sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+	return sorted;
+}
+
+// a copy of the columns of a shared read, in the order of column_indices
+std::unique_ptr<ral::frame::BlazingTable> select_columns(const ral::frame::BlazingTable & table,
+	const std::vector<int> & read_column_indices, const std::vector<int> & column_indices) {
+	std::vector<cudf::size_type> positions;
+	std::vector<std::string> names;
+	std::vector<std::string> read_names = table.names();
+	for (int column_index : column_indices) {
+		auto it = std::find(read_column_indices.begin(), read_column_indices.end(), column_index);
+		cudf::size_type position = std::distance(read_column_indices.begin(), it);
+		positions.push_back(position);
+		names.push_back(read_names[position]);
+	}
+	return ral::frame::BlazingTableView(table.view().select(positions), names).clone();
+}
+
+} // namespace
+
+void shared_scan::configure(bool enabled) {
+	std::lock_guard<std::mutex> lock(reads_mutex);
+	this->enabled = enabled;
+}
+
+bool shared_scan::is_enabled() {
+	std::lock_guard<std::mutex> lock(reads_mutex);
+	return enabled;
+}
+
+std::unique_ptr<ral::frame::BlazingTable> shared_scan::read(const std::string & file_key,
+	const std::vector<int> & column_indices,
+	const std::vector<int> & row_group_ids,
+	const std::function<std::unique_ptr<ral::frame::BlazingTable>(const std::vector<int> &)> & read_columns) {
+
+	std::string key = file_key + "|";
+	for (int row_group_id : row_group_ids) {
+		key += std::to_string(row_group_id) + ",";
+	}
+	std::vector<int> wanted_columns = sorted_columns(column_indices);
+
+	std::unique_lock<std::mutex> lock(reads_mutex);
+	if (!enabled || column_indices.empty()) {
+		lock.unlock();
+		return read_columns(column_indices);
+	}
+
+	auto range = reads.equal_range(key);
+	for (auto it = range.first; it != range.second; ++it) {
+		std::shared_ptr<in_flight_read> read = it->second;
+		std::vector<int> read_columns_sorted = sorted_columns(read->column_indices);
+		if (read->done || !std::includes(read_columns_sorted.begin(), read_columns_sorted.end(), wanted_columns.begin(), wanted_columns.end())) {
+			continue;
+		}
+
+		read->num_waiters++;
+		reads_cv.wait(lock, [&read]{ return read->done; });
+		lock.unlock();
+		if (read->error) {
+			std::rethrow_exception(read->error);
+		}
+		if (read->table == nullptr) {
+			return nullptr;
+		}
+		return select_columns(*read->table, read->column_indices, column_indices);
+	}
+
+	auto read = std::make_shared<in_flight_read>();
+	read->column_indices = column_indices;
+	auto read_it = reads.emplace(key, read);
+	lock.unlock();
+
+	std::unique_ptr<ral::frame::BlazingTable> table;
+	std::exception_ptr error;
+	try {
+		table = read_columns(column_indices);
+	} catch (...) {
+		error = std::current_exception();
+	}
+
+	lock.lock();
+	reads.erase(read_it);
+	read->done = true;
+	if (error) {
+		read->error = error;
+		reads_cv.notify_all();
+		lock.unlock();
+		std::rethrow_exception(error);
+	}
+	if (read->num_waiters == 0) {
+		return table;
+	}
+	read->table = std::move(table);
+	reads_cv.notify_all();
+	lock.unlock();
+	if (read->table == nullptr) {
+		return nullptr;
+	}
+	return read->table->toBlazingTableView().clone();
+}
+
+std::size_t shared_scan::join_scan(const std::string & table_key, std::size_t & start_file_index) {
+	std::lock_guard<std::mutex> lock(scans_mutex);
+	std::vector<active_scan> & table_scans = scans[table_key];
+	start_file_index = table_scans.empty() ? 0 : table_scans.front().file_index;
+	std::size_t scan_id = next_scan_id++;
+	table_scans.push_back({scan_id, start_file_index});
+	return scan_id;
+}
+
+void shared_scan::update_scan(const std::string & table_key, std::size_t scan_id, std::size_t file_index) {
+	std::lock_guard<std::mutex> lock(scans_mutex);
+	auto it = scans.find(table_key);
+	if (it == scans.end()) {
+		return;
+	}
+	for (active_scan & scan : it->second) {
+		if (scan.scan_id == scan_id) {
+			scan.file_index = file_index;
+		}
+	}
+}
+
+void shared_scan::leave_scan(const std::string & table_key, std::size_t scan_id) {
+	std::lock_guard<std::mutex> lock(scans_mutex);
+	auto it = scans.find(table_key);
+	if (it == scans.end()) {
+		return;
+	}
+	std::vector<active_scan> & table_scans = it->second;
+	table_scans.erase(std::remove_if(table_scans.begin(), table_scans.end(),
+		[scan_id](const active_scan & scan) { return scan.scan_id == scan_id; }), table_scans.end());
+	if (table_scans.empty()) {
+		scans.erase(it);
+	}
+}
+
+std::string shared_scan::make_table_key(const std::vector<std::string> & files) {
+	std::string key;
+	for (const std::string & file : files) {
+		key += file + "\n";
+	}
+	return key;
+}
+
+std::string shared_scan::make_file_key(const std::string & uri, const std::vector<std::string> & names,
+	const std::vector<cudf::type_id> & types) {
+	std::string key = uri + "|";
+	for (std::size_t i = 0; i < names.size() && i < types.size(); i++) {
+		key += names[i] + ":" + std::to_string(static_cast<int32_t>(types[i])) + ",";
+	}
+	return key;
+}
+
+}  // namespace io
+}  // namespace ral
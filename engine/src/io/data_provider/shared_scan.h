@@ -0,0 +1,110 @@
+#ifndef BLAZINGDB_RAL_SRC_IO_DATA_PROVIDER_SHARED_SCAN_H_
+#define BLAZINGDB_RAL_SRC_IO_DATA_PROVIDER_SHARED_SCAN_H_
+
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "execution_kernels/LogicPrimitives.h"
+
+namespace ral {
+namespace io {
+
+/**
+ * @brief Shares the scans of the tables between the queries that run at the same time in the process.
+ *
+ * A read of some columns of some row groups of a file is done once for all the TableScans that want them while it is
+ * in flight: the scans that want the same row groups and a subset of its columns wait for it and get a copy of their
+ * columns, and the filters of each query are then applied by its own kernels. Since the queries rarely start at the
+ * same time, a TableScan that starts while another one is scanning the same files starts at the file where that one
+ * is and wraps around to the first files at the end, like a circular scan, so that their reads line up.
+ */
+class shared_scan {
+public:
+	static shared_scan & get_instance() {
+		static shared_scan instance;
+		return instance;
+	}
+
+	/**
+	 * @brief Turns the sharing on or off. It is set by ENABLE_SHARED_SCANS when the engine is initialized.
+	 */
+	void configure(bool enabled);
+
+	bool is_enabled();
+
+	/**
+	 * @brief Reads the columns of the row groups of a file, or waits for the read in flight of the same row groups
+	 * with all these columns.
+	 * @param file_key identifies the file and the schema its columns are read with, see make_file_key.
+	 * @param column_indices the columns to read, in the order the table has them.
+	 * @param row_group_ids the row groups to read, empty for all of them.
+	 * @param read_columns does the read of the columns when there is no read to wait for.
+	 * @return the columns in the order of column_indices. The errors of the read are thrown to all of its waiters.
+	 */
+	std::unique_ptr<ral::frame::BlazingTable> read(const std::string & file_key,
+		const std::vector<int> & column_indices,
+		const std::vector<int> & row_group_ids,
+		const std::function<std::unique_ptr<ral::frame::BlazingTable>(const std::vector<int> &)> & read_columns);
+
+	/**
+	 * @brief Registers a scan of the files of a table.
+	 * @param table_key identifies the files of the table, see make_table_key.
+	 * @param start_file_index is set to the index of the file where the scan starts, the one where the oldest scan of
+	 * the table that is still running is, or 0 when there is none.
+	 * @return the id of the scan, for update_scan and leave_scan.
+	 */
+	std::size_t join_scan(const std::string & table_key, std::size_t & start_file_index);
+
+	/**
+	 * @brief Moves the scan to the file that it reads next.
+	 */
+	void update_scan(const std::string & table_key, std::size_t scan_id, std::size_t file_index);
+
+	void leave_scan(const std::string & table_key, std::size_t scan_id);
+
+	static std::string make_table_key(const std::vector<std::string> & files);
+
+	static std::string make_file_key(const std::string & uri, const std::vector<std::string> & names,
+		const std::vector<cudf::type_id> & types);
+
+private:
+	struct in_flight_read {
+		std::vector<int> column_indices;
+		bool done = false;
+		std::size_t num_waiters = 0;
+		std::shared_ptr<ral::frame::BlazingTable> table;
+		std::exception_ptr error;
+	};
+
+	struct active_scan {
+		std::size_t scan_id;
+		std::size_t file_index;
+	};
+
+	shared_scan() = default;
+	shared_scan(shared_scan &&) = delete;
+	shared_scan(const shared_scan &) = delete;
+	shared_scan & operator=(shared_scan &&) = delete;
+	shared_scan & operator=(const shared_scan &) = delete;
+
+	std::mutex reads_mutex;
+	std::condition_variable reads_cv;
+	bool enabled = true;
+	std::multimap<std::string, std::shared_ptr<in_flight_read>> reads; // by the file and the row groups
+
+	std::mutex scans_mutex;
+	std::map<std::string, std::vector<active_scan>> scans; // by the table, in the order they joined
+	std::size_t next_scan_id = 0;
+};
+
+}  // namespace io
+}  // namespace ral
+
+#endif	// BLAZINGDB_RAL_SRC_IO_DATA_PROVIDER_SHARED_SCAN_H_
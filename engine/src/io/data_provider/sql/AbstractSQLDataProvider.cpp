@@ -6,9 +6,30 @@
 
 #include "compatibility/SQLTranspiler.h"
 
+#include <algorithm>
+#include <numeric>
+
+#include "blazingdb/io/Util/StringUtil.h"
+#include "operators/OrderBy.h"
+#include "parser/expression_utils.hpp"
+
 namespace ral {
 namespace io {
 
+namespace {
+
+const std::vector<std::string> integer_column_types = {
+  "TINYINT", "SMALLINT", "MEDIUMINT", "INT", "INTEGER", "BIGINT", "SMALLSERIAL", "SERIAL", "BIGSERIAL"};
+
+// the types are like BIGINT(20) UNSIGNED in mysql and bigint in postgresql
+bool is_integer_column_type(const std::string &column_type) {
+  std::string type = StringUtil::toUpper(column_type);
+  type = type.substr(0, type.find_first_of("( "));
+  return std::find(integer_column_types.begin(), integer_column_types.end(), type) != integer_column_types.end();
+}
+
+} // namespace
+
 abstractsql_data_provider::abstractsql_data_provider(
     const sql_info &sql,
     size_t total_number_of_nodes,
@@ -50,10 +71,107 @@ bool abstractsql_data_provider::set_predicate_pushdown(const std::string &queryS
   return !this->where.empty();
 }
 
+std::vector<int> abstractsql_data_provider::get_selected_column_indices() const {
+  if (!this->column_indices.empty()) {
+    return this->column_indices;
+  }
+  std::vector<int> indices(this->column_names.size());
+  std::iota(indices.begin(), indices.end(), 0);
+  return indices;
+}
+
+bool abstractsql_data_provider::set_aggregation_pushdown(const std::string &aggregate_expression,
+    const std::vector<cudf::type_id> &column_types)
+{
+  sql_tools::aggregation_pushdown pushdown;
+  if (column_types.size() != this->column_names.size() || !sql_tools::transpile_aggregation(aggregate_expression,
+      this->get_selected_column_indices(), this->column_names, column_types, this->get_dialect(), pushdown)) {
+    return false;
+  }
+  this->aggregation = pushdown;
+  return true;
+}
+
+bool abstractsql_data_provider::set_limit_pushdown(const std::string &sort_expression,
+    const std::vector<cudf::type_id> &column_types)
+{
+  // the rows before the offset are not known to the partitions
+  if (!get_named_expression(sort_expression, "offset").empty() || column_types.size() != this->column_names.size()) {
+    return false;
+  }
+  int64_t limit = ral::operators::get_limit_rows_when_relational_alg_is_simple(sort_expression);
+  if (limit <= 0) {
+    return false;
+  }
+  std::string order;
+  if (!ral::operators::has_limit_only(sort_expression)) {
+    order = sql_tools::transpile_order_by(sort_expression, this->get_selected_column_indices(), this->column_names, column_types);
+    if (order.empty()) {
+      return false;
+    }
+  }
+  this->order_by = order;
+  this->limit_rows = limit;
+  return true;
+}
+
+void abstractsql_data_provider::init_partitions() {
+  this->partition_column = this->sql.table_partition_column;
+  if (this->partition_column.empty()) {
+    for (size_t i = 0; i < this->column_names.size(); ++i) {
+      if (is_integer_column_type(this->column_types[i])) {
+        this->partition_column = this->column_names[i];
+        break;
+      }
+    }
+  }
+  if (this->partition_column.empty()) {
+    return;
+  }
+
+  std::string query = "SELECT MIN(" + this->partition_column + "), MAX(" + this->partition_column + "), COUNT(*) FROM " + this->sql.table;
+  if (!this->sql.table_filter.empty()) {
+    query += " where " + this->sql.table_filter;
+  }
+  std::vector<std::string> range = this->run_single_row_query(query);
+  if (range.size() != 3 || range[0].empty() || range[1].empty()) {
+    return;
+  }
+  const int64_t min = std::stoll(range[0]);
+  const int64_t max = std::stoll(range[1]);
+  const size_t row_count = std::stoull(range[2]);
+
+  size_t num_partitions = this->sql.table_partitions;
+  if (num_partitions == 0) {
+    num_partitions = (row_count + this->sql.table_batch_size - 1) / this->sql.table_batch_size;
+  }
+  // the width is computed unsigned, since the range of an int64 column does not fit in an int64
+  const uint64_t width = static_cast<uint64_t>(max) - static_cast<uint64_t>(min);
+  num_partitions = std::max<size_t>(1, std::min<uint64_t>(num_partitions, width + 1 == 0 ? width : width + 1));
+  const uint64_t step = width / num_partitions + 1;
+
+  this->partition_bounds.clear();
+  for (size_t i = 0; i < num_partitions; ++i) {
+    this->partition_bounds.push_back(static_cast<int64_t>(static_cast<uint64_t>(min) + i * step));
+  }
+}
+
+bool abstractsql_data_provider::has_partition(size_t batch_index) const {
+  return this->total_number_of_nodes * batch_index + this->self_node_idx < this->partition_bounds.size();
+}
+
+size_t abstractsql_data_provider::get_num_partitions() const {
+  const size_t num_nodes = std::max<size_t>(1, this->total_number_of_nodes);
+  const size_t num_partitions = this->partition_bounds.size();
+  return num_partitions > this->self_node_idx ? (num_partitions - this->self_node_idx + num_nodes - 1) / num_nodes : 0;
+}
+
 std::string abstractsql_data_provider::build_select_query(size_t batch_index) const {
   std::string cols;
 
-  if (this->column_indices.empty()) {
+  if (this->has_aggregation_pushdown()) {
+    cols = this->aggregation.select_list + " ";
+  } else if (this->column_indices.empty()) {
     cols = "* ";
   } else {
     for (int i = 0; i < this->column_indices.size(); ++i) {
@@ -67,20 +185,52 @@ std::string abstractsql_data_provider::build_select_query(size_t batch_index) co
     }
   }
 
-  const size_t offset = this->sql.table_batch_size * (this->total_number_of_nodes * batch_index + this->self_node_idx);
-  std::string limit = " LIMIT " + std::to_string(this->sql.table_batch_size) + " OFFSET " + std::to_string(offset);
-  auto ret = "SELECT " + cols + "FROM " + this->sql.table;
-
-  if(!sql.table_filter.empty() && !this->where.empty()) {
-    ret += " where " + sql.table_filter + " AND " + this->where;
-  } else {
-    if (sql.table_filter.empty()) {
-      if (!this->where.empty()) { // then the filter is from the predicate pushdown{
-        ret += " where " + this->where;
-      }
+  const size_t partition = this->total_number_of_nodes * batch_index + this->self_node_idx;
+  std::string limit;
+  std::string range;
+  if (this->is_partitioned()) {
+    // the last partition has no upper bound, and has the nulls too
+    range = this->partition_column + " >= " + std::to_string(this->partition_bounds[partition]);
+    if (partition + 1 < this->partition_bounds.size()) {
+      range += " AND " + this->partition_column + " < " + std::to_string(this->partition_bounds[partition + 1]);
     } else {
-      ret += " where " + sql.table_filter;
+      range = "(" + range + " OR " + this->partition_column + " IS NULL)";
+    }
+    if (this->limit_rows > 0) {
+      limit = " LIMIT " + std::to_string(this->limit_rows);
+    }
+  } else if (this->has_aggregation_pushdown() || this->limit_rows > 0) {
+    // the pages of the groups, or of a sort with ties, would not be the same rows in every query, so all of them are
+    // in the first batch, and the empty second batch ends the table
+    if (partition > 0) {
+      limit = " LIMIT 0";
+    } else if (this->limit_rows > 0) {
+      limit = " LIMIT " + std::to_string(this->limit_rows);
     }
+  } else {
+    const size_t offset = this->sql.table_batch_size * partition;
+    limit = " LIMIT " + std::to_string(this->sql.table_batch_size) + " OFFSET " + std::to_string(offset);
+  }
+  auto ret = "SELECT " + cols + "FROM " + this->sql.table;
+
+  std::vector<std::string> conditions;
+  if (!sql.table_filter.empty()) {
+    conditions.push_back("(" + sql.table_filter + ")");
+  }
+  if (!this->where.empty()) { // then the filter is from the predicate pushdown
+    conditions.push_back("(" + this->where + ")");
+  }
+  if (!range.empty()) {
+    conditions.push_back(range);
+  }
+  for (size_t i = 0; i < conditions.size(); ++i) {
+    ret += (i == 0 ? " where " : " AND ") + conditions[i];
+  }
+  if (!this->aggregation.group_by.empty()) {
+    ret += " GROUP BY " + this->aggregation.group_by;
+  }
+  if (!this->order_by.empty()) {
+    ret += " ORDER BY " + this->order_by;
   }
 
   return ret + limit;
@@ -8,6 +8,7 @@
 #include "io/data_provider/DataProvider.h"
 #include "io/Schema.h"
 #include "parser/expression_tree.hpp"
+#include "compatibility/SQLTranspiler.h"
 
 namespace ral {
 namespace io {
@@ -21,6 +22,9 @@ struct sql_info {
   std::string table;
   std::string table_filter;
   size_t table_batch_size;
+  std::string table_partition_column; // an integer column, the first one of the table when it is empty
+  size_t table_partitions;            // 0 makes a partition of about table_batch_size rows
+  size_t table_connections;           // the partitions that are queried at the same time, each over its own connection
 };
 
 /**
@@ -54,13 +58,72 @@ public:
 
   bool set_predicate_pushdown(const std::string &queryString);
 
+  /**
+	 * Makes the queries of the partitions compute the partial aggregations of a LogicalAggregate over the scan, see
+	 * sql_tools::transpile_aggregation, so that only the groups of every partition are read from the database.
+	 * @param column_types The types of all the columns of the table.
+	 * @return false if the database can't compute them, the rows are then read as they are.
+	 */
+  bool set_aggregation_pushdown(const std::string &aggregate_expression, const std::vector<cudf::type_id> &column_types);
+
+  bool has_aggregation_pushdown() const { return !this->aggregation.select_list.empty(); }
+
+  /**
+	 * The schema of the partial aggregations that the queries return once the aggregation is pushed down
+	 */
+  Schema get_aggregation_schema() const { return Schema(this->aggregation.names, this->aggregation.types); }
+
+  /**
+	 * Makes the queries of the partitions return only their first rows of a LIMIT, or of an ORDER BY with a LIMIT, over
+	 * the scan. The engine still sorts and limits the rows of all the partitions.
+	 * @param column_types The types of all the columns of the table.
+	 * @return false if the database can't order the rows like the engine does.
+	 */
+  bool set_limit_pushdown(const std::string &sort_expression, const std::vector<cudf::type_id> &column_types);
+
 protected:
   virtual std::unique_ptr<ral::parser::node_transformer> get_predicate_transformer() const = 0;
 
+  /**
+	 * The types that the aggregations are cast to and how the database compares strings
+	 */
+  virtual sql_tools::sql_dialect get_dialect() const {
+    return sql_tools::sql_dialect{{{cudf::type_id::INT64, "BIGINT"},
+                                   {cudf::type_id::FLOAT32, "REAL"},
+                                   {cudf::type_id::FLOAT64, "DOUBLE PRECISION"}}, true};
+  }
+
+  /**
+	 * Runs a query that returns one row, and returns its values as strings, empty for the nulls
+	 */
+  virtual std::vector<std::string> run_single_row_query(const std::string &/*query*/) { return {}; }
+
 protected:
-  // returns SELECT ... FROM ... WHERE ... LIMIT ... OFFSET
+  // returns SELECT ... FROM ... WHERE ... LIMIT ... OFFSET, or SELECT ... FROM ... WHERE ... of a partition
   std::string build_select_query(size_t batch_index) const;
 
+  /**
+	 * Splits the table into ranges of the values of its partition column, using the MIN, MAX and COUNT of the column.
+	 * The tables without an integer column are read by LIMIT and OFFSET instead.
+	 * It is called by the providers once they know the columns of the table.
+	 */
+  void init_partitions();
+
+  bool is_partitioned() const { return !this->partition_bounds.empty(); }
+
+  // the columns of the table that the queries select, all of them when there are no projections
+  std::vector<int> get_selected_column_indices() const;
+
+  /**
+	 * Tells whether the batch of this node is a partition of the table, the partitions are split between the nodes
+	 */
+  bool has_partition(size_t batch_index) const;
+
+  /**
+	 * The number of partitions of this node
+	 */
+  size_t get_num_partitions() const;
+
 protected:
   sql_info sql;
   std::vector<int> column_indices;
@@ -69,6 +132,11 @@ protected:
   size_t total_number_of_nodes;
   size_t self_node_idx;
   std::string where;
+  std::string partition_column;
+  std::vector<int64_t> partition_bounds; // the lower bound of every partition
+  sql_tools::aggregation_pushdown aggregation;
+  std::string order_by;
+  size_t limit_rows = 0; // 0 when the queries have no LIMIT of their own
 };
 
 template<class SQLProvider>
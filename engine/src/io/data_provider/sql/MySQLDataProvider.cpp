@@ -109,6 +109,29 @@ std::shared_ptr<sql::ResultSet> execute_mysql_query(sql::Connection *con,
   return ret;
 }
 
+// the results of the prepared statements come in the binary protocol, so the numbers, dates and times are not
+// formatted as text by the server and parsed back by the connector; used for the batches of the table
+std::shared_ptr<sql::ResultSet> execute_mysql_prepared_query(sql::Connection *con,
+                                                             const std::string &query)
+{
+  std::shared_ptr<sql::ResultSet> ret = nullptr;
+  try {
+    std::shared_ptr<sql::PreparedStatement> stmt(con->prepareStatement(query), [](sql::PreparedStatement *pointer) {
+      pointer->close();
+      delete pointer;
+    });
+    // the statement owns the buffers of its result set, so it lives as long as the result set does
+    ret = std::shared_ptr<sql::ResultSet>(stmt->executeQuery(), [stmt](sql::ResultSet *pointer) {
+      pointer->close();
+      delete pointer;
+    });
+  } catch (sql::SQLException &e) {
+    throw std::runtime_error("ERROR: Could not run the MySQL query  " + query + ": " + e.what());
+  }
+
+  return ret;
+}
+
 mysql_table_info get_mysql_table_info(sql::Connection *con, const std::string &table) {
   mysql_table_info ret;
 
@@ -161,13 +184,7 @@ mysql_data_provider::mysql_data_provider(
   , mysql_connection(nullptr), estimated_table_row_count(0)
   , batch_index(0), table_fetch_completed(false)
 {
-  sql::Driver *driver = sql::mysql::get_driver_instance();
-  sql::ConnectOptionsMap options = build_jdbc_mysql_connection(this->sql.host,
-                                                               this->sql.user,
-                                                               this->sql.password,
-                                                               this->sql.port,
-                                                               this->sql.schema);
-  this->mysql_connection = std::unique_ptr<sql::Connection>(driver->connect(options));
+  this->mysql_connection = this->connect();
   mysql_table_info tbl_info = get_mysql_table_info(this->mysql_connection.get(),
                                                    this->sql.table);
   this->estimated_table_row_count = tbl_info.estimated_table_row_count;
@@ -175,9 +192,34 @@ mysql_data_provider::mysql_data_provider(
                                                         this->sql.table);
   this->column_names = cols_info.columns;
   this->column_types = cols_info.types;
+  this->init_partitions();
+  this->table_fetch_completed = this->is_partitioned() && !this->has_partition(0);
 }
 
 mysql_data_provider::~mysql_data_provider() {
+  // the queries use the connections, so they are waited for first
+  this->partition_queries.clear();
+}
+
+std::unique_ptr<sql::Connection> mysql_data_provider::connect() const {
+  sql::Driver *driver = sql::mysql::get_driver_instance();
+  sql::ConnectOptionsMap options = build_jdbc_mysql_connection(this->sql.host,
+                                                               this->sql.user,
+                                                               this->sql.password,
+                                                               this->sql.port,
+                                                               this->sql.schema);
+  return std::unique_ptr<sql::Connection>(driver->connect(options));
+}
+
+std::vector<std::string> mysql_data_provider::run_single_row_query(const std::string &query) {
+  std::vector<std::string> ret;
+  auto res = execute_mysql_query(this->mysql_connection.get(), query);
+  if (res->next()) {
+    for (unsigned int col = 1; col <= res->getMetaData()->getColumnCount(); ++col) {
+      ret.push_back(res->isNull(col) ? "" : res->getString(col).asStdString());
+    }
+  }
+  return ret;
 }
 
 std::shared_ptr<data_provider> mysql_data_provider::clone() {
@@ -189,7 +231,8 @@ bool mysql_data_provider::has_next() {
 }
 
 void mysql_data_provider::reset() {
-  this->table_fetch_completed = false;
+  this->partition_queries.clear();
+  this->table_fetch_completed = this->is_partitioned() && !this->has_partition(0);
   this->batch_index = 0;
 }
 
@@ -203,15 +246,40 @@ data_handle mysql_data_provider::get_next(bool open_file) {
     return ret;
   }
 
-  std::string query = this->build_select_query(this->batch_index);
-
-  // DEBUG
-  //std::cout << "\n>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>MYSQL QUERY:\n\n" << query << "\n\n\n";
-  ++this->batch_index;
-  auto res = execute_mysql_query(this->mysql_connection.get(), query);
-
-  if (res->rowsCount() == 0) {
-    this->table_fetch_completed = true;
+  std::shared_ptr<sql::ResultSet> res;
+  if (this->is_partitioned()) {
+    // the partitions after this one are queried meanwhile, each one over its own connection
+    this->partition_connections.resize(this->sql.table_connections);
+    for (size_t batch = this->batch_index;
+         batch < this->batch_index + this->sql.table_connections && this->has_partition(batch); ++batch) {
+      if (this->partition_queries.count(batch) == 0) {
+        auto &connection = this->partition_connections[batch % this->sql.table_connections];
+        if (connection == nullptr) {
+          connection = this->connect();
+        }
+        std::string query = this->build_select_query(batch);
+        sql::Connection *con = connection.get();
+        this->partition_queries[batch] = std::async(std::launch::async, [con, query]() {
+          return execute_mysql_prepared_query(con, query);
+        });
+      }
+    }
+    auto partition_query = this->partition_queries.find(this->batch_index);
+    res = partition_query->second.get();
+    this->partition_queries.erase(partition_query);
+    ++this->batch_index;
+    this->table_fetch_completed = !this->has_partition(this->batch_index);
+  } else {
+    std::string query = this->build_select_query(this->batch_index);
+
+    // DEBUG
+    //std::cout << "\n>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>MYSQL QUERY:\n\n" << query << "\n\n\n";
+    ++this->batch_index;
+    res = execute_mysql_prepared_query(this->mysql_connection.get(), query);
+
+    if (res->rowsCount() == 0) {
+      this->table_fetch_completed = true;
+    }
   }
 
   ret.sql_handle.table = this->sql.table;
@@ -225,6 +293,9 @@ data_handle mysql_data_provider::get_next(bool open_file) {
 }
 
 size_t mysql_data_provider::get_num_handles() {
+  if (this->is_partitioned()) {
+    return this->get_num_partitions();
+  }
   size_t ret = this->estimated_table_row_count / this->sql.table_batch_size;
   return ret == 0? 1 : ret;
 }
@@ -238,5 +309,14 @@ std::unique_ptr<ral::parser::node_transformer> mysql_data_provider::get_predicat
   ));
 }
 
+sql_tools::sql_dialect mysql_data_provider::get_dialect() const
+{
+  // the default collations of MySQL ignore the case and the trailing spaces of the strings, so their groups are not
+  // the ones of the engine
+  return sql_tools::sql_dialect{{{cudf::type_id::INT64, "SIGNED"},
+                                 {cudf::type_id::FLOAT32, "FLOAT"},
+                                 {cudf::type_id::FLOAT64, "DOUBLE"}}, false};
+}
+
 } /* namespace io */
 } /* namespace ral */
@@ -7,7 +7,11 @@
 
 #include "AbstractSQLDataProvider.h"
 
+#include <future>
+#include <map>
+
 #include <jdbc/cppconn/connection.h>
+#include <jdbc/cppconn/resultset.h>
 
 namespace ral {
 namespace io {
@@ -52,11 +56,20 @@ public:
 protected:
   std::unique_ptr<ral::parser::node_transformer> get_predicate_transformer() const override;
 
+  sql_tools::sql_dialect get_dialect() const override;
+
+  std::vector<std::string> run_single_row_query(const std::string &query) override;
+
 private:
+  std::unique_ptr<sql::Connection> connect() const;
+
   std::unique_ptr<sql::Connection> mysql_connection;
   size_t estimated_table_row_count;
   size_t batch_index;
   bool table_fetch_completed;
+  // the connections of the partitions that are queried at the same time, and their queries by batch index
+  std::vector<std::unique_ptr<sql::Connection>> partition_connections;
+  std::map<size_t, std::future<std::shared_ptr<sql::ResultSet>>> partition_queries;
 };
 
 } /* namespace io */
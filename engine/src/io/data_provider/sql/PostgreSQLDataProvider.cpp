@@ -81,6 +81,26 @@ TableInfo ExecuteTableInfo(PGconn *connection, const sql_info &sql) {
   return tableInfo;
 }
 
+std::shared_ptr<PGconn> ConnectPartition(const sql_info &sql) {
+  std::shared_ptr<PGconn> connection(PQconnectdb(MakePostgreSQLConnectionString(sql).c_str()), PQfinish);
+  if (PQstatus(connection.get()) != CONNECTION_OK) {
+    throw std::runtime_error("Connection to database failed: " +
+                             std::string{PQerrorMessage(connection.get())});
+  }
+  return connection;
+}
+
+// the values are read in binary, like the parser expects them
+std::shared_ptr<PGresult> ExecuteBatchQuery(PGconn *connection, const std::string &query) {
+  std::shared_ptr<PGresult> result(PQexecParams(
+      connection, query.c_str(), 0, nullptr, nullptr, nullptr, nullptr, 1), PQclear);
+  if (PQresultStatus(result.get()) != PGRES_TUPLES_OK) {
+    throw std::runtime_error("Error getting next batch from postgresql: " +
+                             std::string{PQerrorMessage(connection)});
+  }
+  return result;
+}
+
 }  // namespace
 
 postgresql_data_provider::postgresql_data_provider(const sql_info &sql,
@@ -104,9 +124,27 @@ postgresql_data_provider::postgresql_data_provider(const sql_info &sql,
 
   column_names = tableInfo.column_names;
   column_types = tableInfo.column_types;
+  this->init_partitions();
+  this->table_fetch_completed = this->is_partitioned() && !this->has_partition(0);
 }
 
-postgresql_data_provider::~postgresql_data_provider() { PQfinish(connection); }
+postgresql_data_provider::~postgresql_data_provider() {
+  // the queries use the connections, so they are waited for first
+  this->partition_queries.clear();
+  PQfinish(connection);
+}
+
+std::vector<std::string> postgresql_data_provider::run_single_row_query(const std::string &query) {
+  std::vector<std::string> ret;
+  PGresult *result = PQexec(connection, query.c_str());
+  if (PQresultStatus(result) == PGRES_TUPLES_OK && PQntuples(result) > 0) {
+    for (int col = 0; col < PQnfields(result); col++) {
+      ret.emplace_back(PQgetisnull(result, 0, col) ? "" : PQgetvalue(result, 0, col));
+    }
+  }
+  PQclear(result);
+  return ret;
+}
 
 std::shared_ptr<data_provider> postgresql_data_provider::clone() {
   return std::static_pointer_cast<data_provider>(
@@ -118,7 +156,8 @@ bool postgresql_data_provider::has_next() {
 }
 
 void postgresql_data_provider::reset() {
-  this->table_fetch_completed = false;
+  this->partition_queries.clear();
+  this->table_fetch_completed = this->is_partitioned() && !this->has_partition(0);
   this->batch_position = 0;
 }
 
@@ -131,30 +170,47 @@ data_handle postgresql_data_provider::get_next(bool open_file) {
 
   if (!open_file) { return handle; }
 
-  const std::string query = this->build_select_query(this->batch_position);
-
-  batch_position += sql.table_batch_size;
-  PGresult *result = PQexecParams(
-      connection, query.c_str(), 0, nullptr, nullptr, nullptr, nullptr, 1);
-
-  if (PQresultStatus(result) != PGRES_TUPLES_OK) {
-    PQclear(result);
-    PQfinish(connection);
-    throw std::runtime_error("Error getting next batch from postgresql");
+  if (this->is_partitioned()) {
+    // the partitions after this one are queried meanwhile, each one over its own connection
+    partition_connections.resize(sql.table_connections);
+    for (std::size_t batch = batch_position;
+         batch < batch_position + sql.table_connections && this->has_partition(batch); batch++) {
+      if (partition_queries.count(batch) == 0) {
+        auto &partition_connection = partition_connections[batch % sql.table_connections];
+        if (partition_connection == nullptr) {
+          partition_connection = ConnectPartition(sql);
+        }
+        std::shared_ptr<PGconn> con = partition_connection;
+        const std::string query = this->build_select_query(batch);
+        partition_queries[batch] = std::async(std::launch::async, [con, query]() {
+          return ExecuteBatchQuery(con.get(), query);
+        });
+      }
+    }
+    auto partition_query = partition_queries.find(batch_position);
+    handle.sql_handle.postgresql_result = partition_query->second.get();
+    partition_queries.erase(partition_query);
+    batch_position++;
+    table_fetch_completed = !this->has_partition(batch_position);
+  } else {
+    const std::string query = this->build_select_query(this->batch_position);
+
+    batch_position++;
+    handle.sql_handle.postgresql_result = ExecuteBatchQuery(connection, query);
+
+    if (!PQntuples(handle.sql_handle.postgresql_result.get())) { table_fetch_completed = true; }
   }
 
-  int resultNtuples = PQntuples(result);
-
-  if (!resultNtuples) { table_fetch_completed = true; }
-
-  handle.sql_handle.postgresql_result.reset(result, PQclear);
-  handle.sql_handle.row_count = PQntuples(result);
+  handle.sql_handle.row_count = PQntuples(handle.sql_handle.postgresql_result.get());
   handle.uri = Uri("postgresql", "", sql.schema + "/" + sql.table, "", "");
 
   return handle;
 }
 
 std::size_t postgresql_data_provider::get_num_handles() {
+  if (this->is_partitioned()) {
+    return this->get_num_partitions();
+  }
   std::size_t ret = estimated_table_row_count / sql.table_batch_size;
   return ret == 0 ? ret : 1;
 }
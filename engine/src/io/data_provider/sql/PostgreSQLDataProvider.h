@@ -8,6 +8,9 @@
 
 #include "AbstractSQLDataProvider.h"
 
+#include <future>
+#include <map>
+
 #include <libpq-fe.h>
 
 namespace ral {
@@ -35,11 +38,16 @@ protected:
   // TODO percy c.gonzales
   std::unique_ptr<ral::parser::node_transformer> get_predicate_transformer() const override { return nullptr; }
 
+  std::vector<std::string> run_single_row_query(const std::string &query) override;
+
 private:
   PGconn *connection;
   bool table_fetch_completed;
   std::size_t batch_position;
   std::size_t estimated_table_row_count;
+  // the connections of the partitions that are queried at the same time, and their queries by batch position
+  std::vector<std::shared_ptr<PGconn>> partition_connections;
+  std::map<std::size_t, std::future<std::shared_ptr<PGresult>>> partition_queries;
 };
 
 } /* namespace io */
@@ -4,6 +4,12 @@
 
 #include "SQLTranspiler.h"
 
+#include <cudf/utilities/traits.hpp>
+
+#include "operators/GroupBy.h"
+#include "operators/OrderBy.h"
+#include "parser/CalciteExpressionParsing.h"
+
 namespace ral {
 namespace io {
 namespace sql_tools {
@@ -88,6 +94,141 @@ std::string transpile_predicate(const std::string &source,
   return "";
 }
 
+namespace {
+
+bool is_integer_type(cudf::type_id type) {
+  return type == cudf::type_id::INT8 || type == cudf::type_id::INT16 ||
+    type == cudf::type_id::INT32 || type == cudf::type_id::INT64;
+}
+
+bool is_floating_type(cudf::type_id type) {
+  return type == cudf::type_id::FLOAT32 || type == cudf::type_id::FLOAT64;
+}
+
+// the databases order and compare these like the engine does
+bool is_comparable_type(cudf::type_id type) {
+  return type != cudf::type_id::BOOL8 && type != cudf::type_id::EMPTY &&
+    (cudf::is_numeric(cudf::data_type{type}) || cudf::is_timestamp(cudf::data_type{type}));
+}
+
+} // namespace
+
+bool transpile_aggregation(const std::string &aggregate_expression,
+                           const std::vector<int> &column_indices,
+                           const std::vector<std::string> &column_names,
+                           const std::vector<cudf::type_id> &column_types,
+                           const sql_dialect &dialect,
+                           aggregation_pushdown &pushdown)
+{
+  std::vector<int> group_column_indices;
+  std::vector<std::string> aggregation_input_expressions;
+  std::vector<AggregateKind> aggregation_types;
+  std::vector<std::string> aggregation_column_assigned_aliases;
+  std::tie(group_column_indices, aggregation_input_expressions, aggregation_types, aggregation_column_assigned_aliases) =
+    ral::operators::parseGroupByExpression(aggregate_expression, column_indices.size());
+  if (group_column_indices.empty() && aggregation_types.empty()) {
+    return false;
+  }
+
+  std::vector<std::string> select_columns;
+  std::vector<std::string> group_columns;
+  pushdown.names.clear();
+  pushdown.types.clear();
+  for (int group_column_index : group_column_indices) {
+    if (group_column_index < 0 || group_column_index >= static_cast<int>(column_indices.size())) {
+      return false;
+    }
+    int column = column_indices[group_column_index];
+    cudf::type_id type = column_types[column];
+    bool can_group = type == cudf::type_id::STRING ? dialect.compares_strings_exactly :
+      type == cudf::type_id::BOOL8 || is_comparable_type(type);
+    if (!can_group) {
+      return false;
+    }
+    select_columns.push_back(column_names[column]);
+    group_columns.push_back(column_names[column]);
+    pushdown.names.push_back(column_names[column]);
+    pushdown.types.push_back(type);
+  }
+
+  for (size_t i = 0; i < aggregation_types.size(); ++i) {
+    AggregateKind aggregation = aggregation_types[i];
+    if (aggregation == AggregateKind::COUNT_ALL && aggregation_input_expressions[i].empty()) {
+      select_columns.push_back("COUNT(*)");
+      pushdown.names.push_back(aggregation_column_assigned_aliases[i].empty() ?
+        ral::operators::aggregator_to_string(aggregation) + "(*)" : aggregation_column_assigned_aliases[i]);
+      pushdown.types.push_back(cudf::type_id::INT64);
+      continue;
+    }
+    if (!is_var_column(aggregation_input_expressions[i])) {
+      return false;
+    }
+    int index = get_index(aggregation_input_expressions[i]);
+    if (index < 0 || index >= static_cast<int>(column_indices.size())) {
+      return false;
+    }
+    const std::string &name = column_names[column_indices[index]];
+    cudf::type_id type = column_types[column_indices[index]];
+
+    if (aggregation == AggregateKind::COUNT_VALID) {
+      select_columns.push_back("COUNT(" + name + ")");
+      type = cudf::type_id::INT64;
+    } else if (aggregation == AggregateKind::MIN || aggregation == AggregateKind::MAX) {
+      if (!is_comparable_type(type)) {
+        return false;
+      }
+      select_columns.push_back((aggregation == AggregateKind::MIN ? "MIN(" : "MAX(") + name + ")");
+    } else if (aggregation == AggregateKind::SUM || aggregation == AggregateKind::SUM0) {
+      // the sums are cast to the type the engine sums into, since the databases sum into wider or decimal types
+      if (is_integer_type(type)) {
+        type = cudf::type_id::INT64;
+      } else if (!is_floating_type(type)) {
+        return false;
+      }
+      if (dialect.cast_types.count(type) == 0) {
+        return false;
+      }
+      std::string sum = aggregation == AggregateKind::SUM ? "SUM(" + name + ")" : "COALESCE(SUM(" + name + "), 0)";
+      select_columns.push_back("CAST(" + sum + " AS " + dialect.cast_types.at(type) + ")");
+    } else {
+      return false;
+    }
+    pushdown.names.push_back(aggregation_column_assigned_aliases[i].empty() ?
+      ral::operators::aggregator_to_string(aggregation) + "(" + name + ")" : aggregation_column_assigned_aliases[i]);
+    pushdown.types.push_back(type);
+  }
+
+  pushdown.select_list = StringUtil::join(select_columns, ", ");
+  pushdown.group_by = StringUtil::join(group_columns, ", ");
+  return true;
+}
+
+std::string transpile_order_by(const std::string &sort_expression,
+                               const std::vector<int> &column_indices,
+                               const std::vector<std::string> &column_names,
+                               const std::vector<cudf::type_id> &column_types)
+{
+  std::vector<int> sort_column_indices;
+  std::vector<cudf::order> sort_order_types;
+  std::tie(sort_column_indices, sort_order_types, std::ignore) = ral::operators::get_sort_vars(sort_expression);
+
+  std::vector<std::string> order_columns;
+  for (size_t i = 0; i < sort_column_indices.size(); ++i) {
+    if (sort_column_indices[i] < 0 || sort_column_indices[i] >= static_cast<int>(column_indices.size())) {
+      return "";
+    }
+    int column = column_indices[sort_column_indices[i]];
+    if (!is_comparable_type(column_types[column])) {
+      return "";
+    }
+    // the nulls are greater than the other values, like the engine sorts them, whatever the database does with them
+    const std::string direction = sort_order_types[i] == cudf::order::ASCENDING ? " ASC" : " DESC";
+    order_columns.push_back("CASE WHEN " + column_names[column] + " IS NULL THEN 1 ELSE 0 END" + direction);
+    order_columns.push_back(column_names[column] + direction);
+  }
+  return StringUtil::join(order_columns, ", ");
+}
+
 std::map<operator_type, operator_info> get_default_operators() {
   using ral::parser::operator_node;
   static std::map<operator_type, operator_info> operators;
@@ -55,6 +55,53 @@ NOTE Current implementation and future improvements/ideas:
 std::string transpile_predicate(const std::string &source,
                                 ral::parser::node_transformer *predicate_transformer);
 
+/**
+ * @brief The partial aggregations of a LogicalAggregate over a scan, as the select list and the group by of the
+ * queries of the partitions of the table.
+ */
+struct aggregation_pushdown {
+  std::string select_list;        // the group columns and then the aggregations, like the ComputeAggregateKernel outputs them
+  std::string group_by;
+  std::vector<std::string> names; // of the columns of the select list
+  std::vector<cudf::type_id> types;
+};
+
+/**
+ * @brief The dialect of a database that the aggregations and the sorts are transpiled for.
+ */
+struct sql_dialect {
+  std::map<cudf::type_id, std::string> cast_types; // the types the sums are cast to, for the INT64, FLOAT32 and FLOAT64 columns
+  bool compares_strings_exactly = true;             // false when the strings are grouped by a collation, i.e. ignoring their case
+};
+
+/**
+ * @brief Transpiles the aggregation of a LogicalAggregate over a scan into the partial aggregations that a database
+ * computes, which are merged by the engine like the ones of the ComputeAggregateKernel. Only the groups and the SUM,
+ * $SUM0, COUNT, MIN and MAX of columns are supported, since the partial results of the others can't be merged.
+ *
+ * @param column_indices The columns of the table that the scan outputs.
+ * @param column_types The types of all the columns of the table.
+ * @return false if the aggregation can't be computed by the database.
+ */
+bool transpile_aggregation(const std::string &aggregate_expression,
+                           const std::vector<int> &column_indices,
+                           const std::vector<std::string> &column_names,
+                           const std::vector<cudf::type_id> &column_types,
+                           const sql_dialect &dialect,
+                           aggregation_pushdown &pushdown);
+
+/**
+ * @brief Transpiles the order of a sort over a scan into an ORDER BY with the nulls where the engine puts them, after
+ * the other values in ascending order.
+ *
+ * @return the columns of the ORDER BY, or an empty string if the sort has no columns or the database could order them
+ * differently than the engine, like the strings that it orders by a collation.
+ */
+std::string transpile_order_by(const std::string &sort_expression,
+                               const std::vector<int> &column_indices,
+                               const std::vector<std::string> &column_names,
+                               const std::vector<cudf::type_id> &column_types);
+
 struct operator_info {
   std::string label;
   ral::parser::operator_node::placement_type placement = ral::parser::operator_node::AUTO;
@@ -0,0 +1,405 @@
+#pragma GCC diagnostic ignored "-Wunknown-pragmas"
+#include <cudf/column/column_device_view.cuh>
+#include <cudf/column/column_factories.hpp>
+#include <cudf/hashing.hpp>
+#include <cudf/sorting.hpp>
+#include <cudf/stream_compaction.hpp>
+#include <cudf/strings/string_view.cuh>
+#include <cudf/table/table.hpp>
+#include <cudf/transform.hpp>
+#include <cudf/unary.hpp>
+#include <rmm/thrust_rmm_allocator.h>
+#include <thrust/binary_search.h>
+#include <thrust/fill.h>
+#include <thrust/for_each.h>
+#include <thrust/scan.h>
+#include <thrust/sequence.h>
+#include <thrust/transform.h>
+#include <thrust/iterator/counting_iterator.h>
+#pragma GCC diagnostic pop
+
+#include <cmath>
+#include <limits>
+
+#include "ApproxAggregations.h"
+#include "utilities/error.hpp"
+
+namespace ral {
+namespace operators {
+
+namespace {
+
+constexpr std::size_t digest_sketch_bytes = sizeof(double) + digest_num_centroids * 2 * sizeof(double);
+
+// splitmix64, the 32 bits of the hash of a value are spread over the 64 bits of the register index and the rank
+__device__ __forceinline__ uint64_t mix_hash(uint64_t x) {
+	x += 0x9e3779b97f4a7c15ULL;
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+	return x ^ (x >> 31);
+}
+
+// there is no atomicMax of a byte, so the word that has it is swapped until the byte is not smaller than the value
+__device__ __forceinline__ void atomic_max_byte(uint8_t * address, uint8_t value) {
+	uint32_t * word = reinterpret_cast<uint32_t *>(reinterpret_cast<uintptr_t>(address) & ~uintptr_t{3});
+	uint32_t shift = (reinterpret_cast<uintptr_t>(address) & 3) * 8;
+	uint32_t old = *word;
+	uint32_t assumed;
+	do {
+		assumed = old;
+		if(((assumed >> shift) & 0xff) >= value) {
+			return;
+		}
+		old = atomicCAS(word, assumed, (assumed & ~(0xffu << shift)) | (static_cast<uint32_t>(value) << shift));
+	} while(old != assumed);
+}
+
+// the bytes of the strings are not aligned to doubles
+__device__ __forceinline__ double load_double(const char * bytes) {
+	double value;
+	memcpy(&value, bytes, sizeof(double));
+	return value;
+}
+
+__device__ __forceinline__ void store_double(char * bytes, double value) {
+	memcpy(bytes, &value, sizeof(double));
+}
+
+cudf::size_type get_num_groups(const std::vector<cudf::size_type> & group_offsets) {
+	RAL_EXPECTS(!group_offsets.empty() && group_offsets.front() == 0, "The offsets of the groups of a sketch must start at 0");
+	return group_offsets.size() - 1;
+}
+
+// the group of every row
+std::unique_ptr<cudf::column> make_group_labels(const std::vector<cudf::size_type> & group_offsets) {
+	rmm::device_vector<cudf::size_type> d_offsets(group_offsets);
+	cudf::size_type num_rows = group_offsets.back();
+	std::unique_ptr<cudf::column> labels = cudf::make_numeric_column(cudf::data_type{cudf::type_id::INT32}, num_rows);
+	thrust::upper_bound(rmm::exec_policy(0)->on(0),
+						d_offsets.begin() + 1,
+						d_offsets.end(),
+						thrust::make_counting_iterator<cudf::size_type>(0),
+						thrust::make_counting_iterator<cudf::size_type>(num_rows),
+						labels->mutable_view().begin<cudf::size_type>());
+	return labels;
+}
+
+std::unique_ptr<cudf::column> make_sketches_column(cudf::size_type num_sketches, std::size_t sketch_bytes, rmm::device_buffer && bytes) {
+	RAL_EXPECTS(num_sketches * sketch_bytes <= static_cast<std::size_t>(std::numeric_limits<cudf::size_type>::max()),
+		"Too many groups for the sketches of a batch");
+	std::unique_ptr<cudf::column> offsets = cudf::make_numeric_column(cudf::data_type{cudf::type_id::INT32}, num_sketches + 1);
+	thrust::sequence(rmm::exec_policy(0)->on(0),
+					offsets->mutable_view().begin<int32_t>(),
+					offsets->mutable_view().end<int32_t>(),
+					0,
+					static_cast<int32_t>(sketch_bytes));
+	std::unique_ptr<cudf::column> chars = std::make_unique<cudf::column>(cudf::data_type{cudf::type_id::INT8},
+		static_cast<cudf::size_type>(num_sketches * sketch_bytes), std::move(bytes));
+	return cudf::make_strings_column(num_sketches, std::move(offsets), std::move(chars), 0, rmm::device_buffer{});
+}
+
+void expect_sketches(const cudf::column_view & sketches, const std::vector<cudf::size_type> & group_offsets) {
+	RAL_EXPECTS(sketches.type().id() == cudf::type_id::STRING, "The sketches of an approximate aggregation must be a STRING column");
+	RAL_EXPECTS(group_offsets.back() == sketches.size(), "The offsets of the groups don't match the sketches");
+}
+
+// Compresses the centroids of every group into its digest. The centroids of a group are sorted by their means, and
+// every one is added to the centroid of the digest that the middle of its weight falls in, so that the centroids of the
+// digest get about the same weight.
+std::unique_ptr<cudf::column> compress_centroids(const cudf::column_view & labels, const cudf::column_view & means,
+	const cudf::column_view & weights, const rmm::device_vector<double> & percentiles, cudf::size_type num_groups) {
+
+	rmm::device_buffer bytes(num_groups * digest_sketch_bytes);
+	cudaMemset(bytes.data(), 0, bytes.size());
+	char * d_bytes = static_cast<char *>(bytes.data());
+
+	cudf::size_type num_centroids = labels.size();
+	if (num_centroids > 0) {
+		cudf::table_view centroids{{labels, means, weights}};
+		std::unique_ptr<cudf::table> sorted = cudf::sort_by_key(centroids, centroids.select({0, 1}));
+		const cudf::size_type * d_labels = sorted->view().column(0).data<cudf::size_type>();
+		const double * d_means = sorted->view().column(1).data<double>();
+		const double * d_weights = sorted->view().column(2).data<double>();
+
+		rmm::device_vector<double> cumulative_weights(num_centroids);
+		thrust::inclusive_scan_by_key(rmm::exec_policy(0)->on(0), d_labels, d_labels + num_centroids, d_weights, cumulative_weights.begin());
+		const double * d_cumulative_weights = cumulative_weights.data().get();
+
+		rmm::device_vector<double> total_weights(num_groups, 0.0);
+		double * d_total_weights = total_weights.data().get();
+		thrust::for_each(rmm::exec_policy(0)->on(0),
+						thrust::make_counting_iterator<cudf::size_type>(0),
+						thrust::make_counting_iterator<cudf::size_type>(num_centroids),
+						[d_labels, d_cumulative_weights, d_total_weights, num_centroids] __device__ (cudf::size_type i){
+							if (i == num_centroids - 1 || d_labels[i + 1] != d_labels[i]) {
+								d_total_weights[d_labels[i]] = d_cumulative_weights[i];
+							}
+						});
+
+		rmm::device_vector<double> sums(num_groups * digest_num_centroids, 0.0);
+		rmm::device_vector<double> sum_weights(num_groups * digest_num_centroids, 0.0);
+		double * d_sums = sums.data().get();
+		double * d_sum_weights = sum_weights.data().get();
+		thrust::for_each(rmm::exec_policy(0)->on(0),
+						thrust::make_counting_iterator<cudf::size_type>(0),
+						thrust::make_counting_iterator<cudf::size_type>(num_centroids),
+						[d_labels, d_means, d_weights, d_cumulative_weights, d_total_weights, d_sums, d_sum_weights] __device__ (cudf::size_type i){
+							if (d_weights[i] <= 0) {
+								return;
+							}
+							cudf::size_type group = d_labels[i];
+							double position = (d_cumulative_weights[i] - d_weights[i] / 2) / d_total_weights[group];
+							std::size_t centroid = static_cast<std::size_t>(position * digest_num_centroids);
+							centroid = centroid < digest_num_centroids ? centroid : digest_num_centroids - 1;
+							atomicAdd(d_sums + group * digest_num_centroids + centroid, d_means[i] * d_weights[i]);
+							atomicAdd(d_sum_weights + group * digest_num_centroids + centroid, d_weights[i]);
+						});
+
+		thrust::for_each(rmm::exec_policy(0)->on(0),
+						thrust::make_counting_iterator<std::size_t>(0),
+						thrust::make_counting_iterator<std::size_t>(num_groups * digest_num_centroids),
+						[d_sums, d_sum_weights, d_bytes] __device__ (std::size_t i){
+							std::size_t group = i / digest_num_centroids;
+							std::size_t centroid = i % digest_num_centroids;
+							char * centroid_bytes = d_bytes + group * digest_sketch_bytes + sizeof(double) + centroid * 2 * sizeof(double);
+							double weight = d_sum_weights[i];
+							store_double(centroid_bytes, weight > 0 ? d_sums[i] / weight : 0);
+							store_double(centroid_bytes + sizeof(double), weight);
+						});
+	}
+
+	const double * d_percentiles = percentiles.data().get();
+	thrust::for_each(rmm::exec_policy(0)->on(0),
+					thrust::make_counting_iterator<cudf::size_type>(0),
+					thrust::make_counting_iterator<cudf::size_type>(num_groups),
+					[d_percentiles, d_bytes] __device__ (cudf::size_type group){
+						store_double(d_bytes + group * digest_sketch_bytes, d_percentiles[group]);
+					});
+
+	return make_sketches_column(num_groups, digest_sketch_bytes, std::move(bytes));
+}
+
+}  // namespace
+
+std::unique_ptr<cudf::column> make_distinct_count_sketches(const cudf::column_view & values, const std::vector<cudf::size_type> & group_offsets) {
+	cudf::size_type num_groups = get_num_groups(group_offsets);
+	RAL_EXPECTS(group_offsets.back() == values.size(), "The offsets of the groups don't match the values");
+
+	rmm::device_buffer registers(num_groups * hll_num_registers);
+	cudaMemset(registers.data(), 0, registers.size());
+
+	if (values.size() > values.null_count()) {
+		std::unique_ptr<cudf::column> labels = make_group_labels(group_offsets);
+		std::unique_ptr<cudf::column> hashes = cudf::hash(cudf::table_view{{values}});
+		if (hashes->type().id() != cudf::type_id::UINT32) {
+			hashes = cudf::cast(hashes->view(), cudf::data_type{cudf::type_id::UINT32});
+		}
+
+		auto d_values_ptr = cudf::column_device_view::create(values);
+		cudf::column_device_view d_values = *d_values_ptr;
+		const uint32_t * d_hashes = hashes->view().data<uint32_t>();
+		const cudf::size_type * d_labels = labels->view().data<cudf::size_type>();
+		uint8_t * d_registers = static_cast<uint8_t *>(registers.data());
+		thrust::for_each(rmm::exec_policy(0)->on(0),
+						thrust::make_counting_iterator<cudf::size_type>(0),
+						thrust::make_counting_iterator<cudf::size_type>(values.size()),
+						[d_values, d_hashes, d_labels, d_registers] __device__ (cudf::size_type row){
+							if (d_values.is_null(row)) {
+								return;
+							}
+							// the first bits of the hash are the register, the rank is the position of the first 1 of the rest
+							uint64_t hash = mix_hash(d_hashes[row]);
+							std::size_t index = hash >> (64 - hll_precision);
+							uint64_t rest = hash << hll_precision;
+							uint8_t rank = rest == 0 ? 64 - hll_precision + 1 : __clzll(rest) + 1;
+							atomic_max_byte(d_registers + d_labels[row] * hll_num_registers + index, rank);
+						});
+	}
+
+	return make_sketches_column(num_groups, hll_num_registers, std::move(registers));
+}
+
+std::unique_ptr<cudf::column> merge_distinct_count_sketches(const cudf::column_view & sketches, const std::vector<cudf::size_type> & group_offsets) {
+	cudf::size_type num_groups = get_num_groups(group_offsets);
+	expect_sketches(sketches, group_offsets);
+
+	rmm::device_buffer registers(num_groups * hll_num_registers);
+	cudaMemset(registers.data(), 0, registers.size());
+
+	if (sketches.size() > 0) {
+		std::unique_ptr<cudf::column> labels = make_group_labels(group_offsets);
+		auto d_sketches_ptr = cudf::column_device_view::create(sketches);
+		cudf::column_device_view d_sketches = *d_sketches_ptr;
+		const cudf::size_type * d_labels = labels->view().data<cudf::size_type>();
+		uint8_t * d_registers = static_cast<uint8_t *>(registers.data());
+		thrust::for_each(rmm::exec_policy(0)->on(0),
+						thrust::make_counting_iterator<std::size_t>(0),
+						thrust::make_counting_iterator<std::size_t>(sketches.size() * hll_num_registers),
+						[d_sketches, d_labels, d_registers] __device__ (std::size_t i){
+							cudf::size_type row = i / hll_num_registers;
+							std::size_t index = i % hll_num_registers;
+							if (d_sketches.is_null(row)) {
+								return;
+							}
+							const uint8_t * sketch = reinterpret_cast<const uint8_t *>(d_sketches.element<cudf::string_view>(row).data());
+							atomic_max_byte(d_registers + d_labels[row] * hll_num_registers + index, sketch[index]);
+						});
+	}
+
+	return make_sketches_column(num_groups, hll_num_registers, std::move(registers));
+}
+
+std::unique_ptr<cudf::column> estimate_distinct_counts(const cudf::column_view & sketches) {
+	RAL_EXPECTS(sketches.type().id() == cudf::type_id::STRING, "The sketches of an approximate aggregation must be a STRING column");
+	std::unique_ptr<cudf::column> estimates = cudf::make_numeric_column(cudf::data_type{cudf::type_id::INT64}, sketches.size());
+	if (sketches.size() == 0) {
+		return estimates;
+	}
+
+	auto d_sketches_ptr = cudf::column_device_view::create(sketches);
+	cudf::column_device_view d_sketches = *d_sketches_ptr;
+	thrust::transform(rmm::exec_policy(0)->on(0),
+					thrust::make_counting_iterator<cudf::size_type>(0),
+					thrust::make_counting_iterator<cudf::size_type>(sketches.size()),
+					estimates->mutable_view().begin<int64_t>(),
+					[d_sketches] __device__ (cudf::size_type row){
+						const uint8_t * registers = reinterpret_cast<const uint8_t *>(d_sketches.element<cudf::string_view>(row).data());
+						double sum = 0;
+						std::size_t num_zeros = 0;
+						for (std::size_t i = 0; i < hll_num_registers; i++) {
+							sum += ldexp(1.0, -static_cast<int>(registers[i]));
+							num_zeros += registers[i] == 0 ? 1 : 0;
+						}
+						double m = static_cast<double>(hll_num_registers);
+						double estimate = 0.7213 / (1 + 1.079 / m) * m * m / sum;
+						if (estimate <= 2.5 * m && num_zeros > 0) {
+							// linear counting is more accurate for the small counts
+							estimate = m * log(m / num_zeros);
+						}
+						return static_cast<int64_t>(llround(estimate));
+					});
+	return estimates;
+}
+
+std::unique_ptr<cudf::column> make_percentile_sketches(const cudf::column_view & values, double percentile, const std::vector<cudf::size_type> & group_offsets) {
+	cudf::size_type num_groups = get_num_groups(group_offsets);
+	RAL_EXPECTS(group_offsets.back() == values.size(), "The offsets of the groups don't match the values");
+	RAL_EXPECTS(std::isnan(percentile) || (percentile >= 0 && percentile <= 1), "The percentile of APPROX_PERCENTILE must be between 0 and 1");
+
+	// every value is a centroid of weight one
+	std::unique_ptr<cudf::column> labels = make_group_labels(group_offsets);
+	std::unique_ptr<cudf::column> means = cudf::cast(values, cudf::data_type{cudf::type_id::FLOAT64});
+	std::unique_ptr<cudf::table> valid_centroids = cudf::drop_nulls(cudf::table_view{{labels->view(), means->view()}}, {1});
+	std::unique_ptr<cudf::column> weights = cudf::make_numeric_column(cudf::data_type{cudf::type_id::FLOAT64}, valid_centroids->num_rows());
+	thrust::fill(rmm::exec_policy(0)->on(0), weights->mutable_view().begin<double>(), weights->mutable_view().end<double>(), 1.0);
+
+	rmm::device_vector<double> percentiles(num_groups, percentile);
+	return compress_centroids(valid_centroids->view().column(0), valid_centroids->view().column(1), weights->view(), percentiles, num_groups);
+}
+
+std::unique_ptr<cudf::column> merge_percentile_sketches(const cudf::column_view & sketches, const std::vector<cudf::size_type> & group_offsets) {
+	cudf::size_type num_groups = get_num_groups(group_offsets);
+	expect_sketches(sketches, group_offsets);
+
+	std::size_t num_centroids = sketches.size() * digest_num_centroids;
+	std::unique_ptr<cudf::column> labels = cudf::make_numeric_column(cudf::data_type{cudf::type_id::INT32}, num_centroids);
+	std::unique_ptr<cudf::column> means = cudf::make_numeric_column(cudf::data_type{cudf::type_id::FLOAT64}, num_centroids);
+	std::unique_ptr<cudf::column> weights = cudf::make_numeric_column(cudf::data_type{cudf::type_id::FLOAT64}, num_centroids);
+	rmm::device_vector<double> percentiles(num_groups, std::numeric_limits<double>::quiet_NaN());
+
+	if (sketches.size() > 0) {
+		std::unique_ptr<cudf::column> sketch_labels = make_group_labels(group_offsets);
+		auto d_sketches_ptr = cudf::column_device_view::create(sketches);
+		cudf::column_device_view d_sketches = *d_sketches_ptr;
+		const cudf::size_type * d_sketch_labels = sketch_labels->view().data<cudf::size_type>();
+		cudf::size_type * d_labels = labels->mutable_view().data<cudf::size_type>();
+		double * d_means = means->mutable_view().data<double>();
+		double * d_weights = weights->mutable_view().data<double>();
+		double * d_percentiles = percentiles.data().get();
+
+		// the sketches without any value of a batch don't know the percentile, any other sketch of the group does
+		thrust::for_each(rmm::exec_policy(0)->on(0),
+						thrust::make_counting_iterator<cudf::size_type>(0),
+						thrust::make_counting_iterator<cudf::size_type>(sketches.size()),
+						[d_sketches, d_sketch_labels, d_percentiles] __device__ (cudf::size_type row){
+							double percentile = load_double(d_sketches.element<cudf::string_view>(row).data());
+							if (!isnan(percentile)) {
+								d_percentiles[d_sketch_labels[row]] = percentile;
+							}
+						});
+
+		thrust::for_each(rmm::exec_policy(0)->on(0),
+						thrust::make_counting_iterator<std::size_t>(0),
+						thrust::make_counting_iterator<std::size_t>(num_centroids),
+						[d_sketches, d_sketch_labels, d_labels, d_means, d_weights] __device__ (std::size_t i){
+							cudf::size_type row = i / digest_num_centroids;
+							std::size_t centroid = i % digest_num_centroids;
+							const char * centroid_bytes = d_sketches.element<cudf::string_view>(row).data() + sizeof(double) + centroid * 2 * sizeof(double);
+							d_labels[i] = d_sketch_labels[row];
+							d_means[i] = load_double(centroid_bytes);
+							d_weights[i] = load_double(centroid_bytes + sizeof(double));
+						});
+	}
+
+	return compress_centroids(labels->view(), means->view(), weights->view(), percentiles, num_groups);
+}
+
+std::unique_ptr<cudf::column> estimate_percentiles(const cudf::column_view & sketches) {
+	RAL_EXPECTS(sketches.type().id() == cudf::type_id::STRING, "The sketches of an approximate aggregation must be a STRING column");
+	std::unique_ptr<cudf::column> estimates = cudf::make_numeric_column(cudf::data_type{cudf::type_id::FLOAT64}, sketches.size());
+	if (sketches.size() == 0) {
+		return estimates;
+	}
+
+	auto d_sketches_ptr = cudf::column_device_view::create(sketches);
+	cudf::column_device_view d_sketches = *d_sketches_ptr;
+	thrust::transform(rmm::exec_policy(0)->on(0),
+					thrust::make_counting_iterator<cudf::size_type>(0),
+					thrust::make_counting_iterator<cudf::size_type>(sketches.size()),
+					estimates->mutable_view().begin<double>(),
+					[d_sketches] __device__ (cudf::size_type row){
+						const char * sketch = d_sketches.element<cudf::string_view>(row).data();
+						double percentile = load_double(sketch);
+						double total_weight = 0;
+						for (std::size_t i = 0; i < digest_num_centroids; i++) {
+							total_weight += load_double(sketch + sizeof(double) + i * 2 * sizeof(double) + sizeof(double));
+						}
+						if (total_weight == 0 || isnan(percentile)) {
+							return nan("");
+						}
+
+						// every centroid stands for the value at the middle of its weight, the ones in between are interpolated
+						double target = percentile * total_weight;
+						double cumulative_weight = 0;
+						bool has_previous = false;
+						double previous_center = 0;
+						double previous_mean = 0;
+						for (std::size_t i = 0; i < digest_num_centroids; i++) {
+							const char * centroid_bytes = sketch + sizeof(double) + i * 2 * sizeof(double);
+							double weight = load_double(centroid_bytes + sizeof(double));
+							if (weight == 0) {
+								continue;
+							}
+							double mean = load_double(centroid_bytes);
+							double center = cumulative_weight + weight / 2;
+							if (target <= center) {
+								if (!has_previous) {
+									return mean;
+								}
+								return previous_mean + (target - previous_center) / (center - previous_center) * (mean - previous_mean);
+							}
+							has_previous = true;
+							previous_center = center;
+							previous_mean = mean;
+							cumulative_weight += weight;
+						}
+						return previous_mean;
+					});
+
+	auto null_mask = cudf::nans_to_nulls(estimates->view());
+	estimates->set_null_mask(std::move(*null_mask.first), null_mask.second);
+	return estimates;
+}
+
+}  // namespace operators
+}  // namespace ral
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <cudf/column/column.hpp>
+#include <cudf/column/column_view.hpp>
+
+namespace ral {
+namespace operators {
+
+/**
+ * The sketches of the approximate aggregations are STRING columns where every string has the same number of bytes, so
+ * that they go through the caches and the communication like any other column. The rows of a group are given by the
+ * offsets where every group starts, the rows of group g are [group_offsets[g], group_offsets[g + 1]).
+ *
+ * The distinct counts are a HyperLogLog of hll_num_registers registers of one byte. The percentiles are a digest of
+ * digest_num_centroids centroids (a mean and a weight) that all get about the same weight, preceded by the percentile
+ * they have to compute. Merging the sketches of a group gives the same sketch as if all of its rows had been in one batch.
+ */
+constexpr int hll_precision = 11;
+constexpr std::size_t hll_num_registers = std::size_t{1} << hll_precision; /**< About 2.3% of standard error */
+constexpr std::size_t digest_num_centroids = 100;
+
+/**
+ * @brief Returns the HyperLogLog sketch of the distinct values of every group. The null values are not counted.
+ */
+std::unique_ptr<cudf::column> make_distinct_count_sketches(const cudf::column_view & values, const std::vector<cudf::size_type> & group_offsets);
+
+/**
+ * @brief Returns the sketch of every group of sketches, with the maximum of every register.
+ */
+std::unique_ptr<cudf::column> merge_distinct_count_sketches(const cudf::column_view & sketches, const std::vector<cudf::size_type> & group_offsets);
+
+/**
+ * @brief Returns the INT64 estimate of the distinct count of every sketch.
+ */
+std::unique_ptr<cudf::column> estimate_distinct_counts(const cudf::column_view & sketches);
+
+/**
+ * @brief Returns the digest of the values of every group. The null values are left out.
+ *
+ * @param percentile The percentile to compute, between 0 and 1. NaN if it is not known, it is then taken from the
+ * sketches this one is merged with.
+ */
+std::unique_ptr<cudf::column> make_percentile_sketches(const cudf::column_view & values, double percentile, const std::vector<cudf::size_type> & group_offsets);
+
+/**
+ * @brief Returns the digest of every group of digests, made by compressing all of their centroids.
+ */
+std::unique_ptr<cudf::column> merge_percentile_sketches(const cudf::column_view & sketches, const std::vector<cudf::size_type> & group_offsets);
+
+/**
+ * @brief Returns the FLOAT64 estimate of the percentile of every digest, interpolated between its centroids. It is
+ * null for the digests without any value.
+ */
+std::unique_ptr<cudf::column> estimate_percentiles(const cudf::column_view & sketches);
+
+}  // namespace operators
+}  // namespace ral
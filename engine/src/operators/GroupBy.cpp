@@ -4,6 +4,7 @@
 #include <spdlog/sinks/stdout_color_sinks.h>
 
 #include "GroupBy.h"
+#include "ApproxAggregations.h"
 #include "parser/expression_utils.hpp"
 #include "parser/CalciteExpressionParsing.h"
 #include "utilities/CodeTimer.h"
@@ -11,15 +12,20 @@
 #include "utilities/CommonOperations.h"
 #include <blazingdb/io/Util/StringUtil.h>
 #include "execution_kernels/LogicalProject.h"
+#include "blazing_table/BlazingColumnOwner.h"
 #include <regex>
+#include <map>
+#include <limits>
 
 #include <cudf/aggregation.hpp>
+#include <cudf/copying.hpp>
 #include <cudf/sorting.hpp>
 #include <cudf/replace.hpp>
 #include <cudf/stream_compaction.hpp>
 #include <cudf/filling.hpp>
 #include <cudf/scalar/scalar_factories.hpp>
 #include <cudf/reduction.hpp>
+#include <cudf/unary.hpp>
 
 namespace ral {
 namespace operators {
@@ -45,10 +51,6 @@ cudf::type_id get_aggregation_output_type(cudf::type_id input_type, AggregateKin
 	} else if(aggregation == AggregateKind::MEAN) {
 		return cudf::type_id::FLOAT64;
 	} else if(aggregation == AggregateKind::COUNT_DISTINCT) {
-		/* Currently this conditional is unreachable.
-		   Calcite transforms count distincts through the
-		   AggregateExpandDistinctAggregates rule, so in fact,
-		   each count distinct is replaced by some group by clauses. */
 		return cudf::type_id::INT64;
 	} else {
 		throw std::runtime_error(
@@ -56,6 +58,11 @@ cudf::type_id get_aggregation_output_type(cudf::type_id input_type, AggregateKin
 	}
 }
 
+// The sums of the DECIMAL32 are computed as DECIMAL64 with the same scale, so that they don't overflow the 32 bits
+bool is_widened_decimal_sum(cudf::data_type input_type, AggregateKind aggregation) {
+	return input_type.id() == cudf::type_id::DECIMAL32 && (aggregation == AggregateKind::SUM || aggregation == AggregateKind::SUM0);
+}
+
 /* Function used to name columns*/
 std::string aggregator_to_string(AggregateKind aggregation) {
 	if(aggregation == AggregateKind::COUNT_VALID || aggregation == AggregateKind::COUNT_ALL) {
@@ -71,11 +78,11 @@ std::string aggregator_to_string(AggregateKind aggregation) {
 	} else if(aggregation == AggregateKind::MEAN) {
 		return "avg";
 	} else if(aggregation == AggregateKind::COUNT_DISTINCT) {
-		/* Currently this conditional is unreachable.
-		   Calcite transforms count distincts through the
-		   AggregateExpandDistinctAggregates rule, so in fact,
-		   each count distinct is replaced by some group by clauses. */
 		return "count_distinct";
+	} else if(aggregation == AggregateKind::APPROX_COUNT_DISTINCT || aggregation == AggregateKind::MERGE_APPROX_COUNT_DISTINCT) {
+		return "approx_count_distinct";
+	} else if(aggregation == AggregateKind::APPROX_PERCENTILE || aggregation == AggregateKind::MERGE_APPROX_PERCENTILE) {
+		return "approx_percentile";
 	} else {
 		return "";  // FIXME: is really necessary?
 	}
@@ -109,11 +116,12 @@ AggregateKind get_aggregation_operation(std::string expression_in, bool is_windo
 	} else if (operator_string == "FIRST_VALUE" || operator_string == "LAST_VALUE") {
 		return AggregateKind::NTH_ELEMENT;
 	}else if(operator_string == "COUNT_DISTINCT") {
-		/* Currently this conditional is unreachable.
-		   Calcite transforms count distincts through the
-		   AggregateExpandDistinctAggregates rule, so in fact,
-		   each count distinct is replaced by some group by clauses. */
+		// the planner leaves the distinct counts of one column to the engine instead of expanding them into group bys
 		return AggregateKind::COUNT_DISTINCT;
+	} else if(operator_string == "APPROX_COUNT_DISTINCT") {
+		return AggregateKind::APPROX_COUNT_DISTINCT;
+	} else if(operator_string == "APPROX_PERCENTILE") {
+		return AggregateKind::APPROX_PERCENTILE;
 	}
 
 	throw std::runtime_error(
@@ -160,7 +168,7 @@ std::tuple<std::vector<int>, std::vector<std::string>, std::vector<AggregateKind
 	std::vector<std::string> expressions = get_expressions_from_expression_list(combined_expression);
 	for(std::string expr : expressions) {
 		std::string expression = std::regex_replace(expr, std::regex("^ +| +$|( ) +"), "$1");
-		if(expression.find("group=") == std::string::npos) {
+		if(expression.find("group=") == std::string::npos && expression.find("groups=") != 0) {
 			aggregation_expressions.push_back(expression);
 
 			// if the aggregation has an alias, lets capture it here, otherwise we'll figure out what to call the
@@ -193,6 +201,10 @@ std::tuple<std::vector<int>, std::vector<std::string>, std::vector<AggregateKind
 	for (size_t i = 0; i < mod_aggregation_types.size(); i++){
 		if (mod_aggregation_types[i] == AggregateKind::COUNT_ALL || mod_aggregation_types[i] == AggregateKind::COUNT_VALID){
 			mod_aggregation_types[i] = AggregateKind::SUM; // if we have a COUNT, we want to SUM the output of the counts from other nodes
+		} else if (mod_aggregation_types[i] == AggregateKind::APPROX_COUNT_DISTINCT){
+			mod_aggregation_types[i] = AggregateKind::MERGE_APPROX_COUNT_DISTINCT; // the sketches from other nodes are merged, not made again
+		} else if (mod_aggregation_types[i] == AggregateKind::APPROX_PERCENTILE){
+			mod_aggregation_types[i] = AggregateKind::MERGE_APPROX_PERCENTILE;
 		}
 		mod_aggregation_input_expressions[i] = std::to_string(i + mod_group_column_indices.size()); // we just want to aggregate the input columns, so we are setting the indices here
 		mod_aggregation_column_assigned_aliases[i] = merging_column_names[i + mod_group_column_indices.size()];
@@ -203,6 +215,132 @@ std::tuple<std::vector<int>, std::vector<std::string>, std::vector<AggregateKind
 
 using namespace ral::distribution;
 
+bool is_approx_aggregation(AggregateKind aggregation) {
+	return aggregation == AggregateKind::APPROX_COUNT_DISTINCT || aggregation == AggregateKind::APPROX_PERCENTILE ||
+		aggregation == AggregateKind::MERGE_APPROX_COUNT_DISTINCT || aggregation == AggregateKind::MERGE_APPROX_PERCENTILE;
+}
+
+/* Computes the sketches of an approximate aggregation for the groups of a table whose rows are ordered by their groups.
+APPROX_PERCENTILE has two arguments, the values and the percentile, which is the same in every row. */
+std::unique_ptr<cudf::column> compute_approx_aggregation(const ral::frame::BlazingTableView & table, std::string aggregation_input_expression,
+		AggregateKind aggregation, const std::vector<cudf::size_type> & group_offsets) {
+
+	std::vector<std::string> arguments = get_expressions_from_expression_list(aggregation_input_expression);
+	RAL_EXPECTS(arguments.size() > 0, "In compute_approx_aggregation function: the aggregation has no input");
+
+	std::vector<std::unique_ptr<ral::frame::BlazingColumn>> aggregation_inputs_scope_holder;
+	auto get_input = [&](const std::string & expression) -> CudfColumnView {
+		if(is_var_column(expression) || is_number(expression)) {
+			return table.view().column(get_index(expression));
+		}
+		std::vector<std::unique_ptr<ral::frame::BlazingColumn>> computed_columns = ral::processor::evaluate_expressions(table.view(), {expression});
+		aggregation_inputs_scope_holder.push_back(std::move(computed_columns[0]));
+		return aggregation_inputs_scope_holder.back()->view();
+	};
+
+	CudfColumnView aggregation_input = get_input(arguments[0]);
+	if(aggregation == AggregateKind::APPROX_COUNT_DISTINCT) {
+		return make_distinct_count_sketches(aggregation_input, group_offsets);
+	} else if(aggregation == AggregateKind::MERGE_APPROX_COUNT_DISTINCT) {
+		return merge_distinct_count_sketches(aggregation_input, group_offsets);
+	} else if(aggregation == AggregateKind::APPROX_PERCENTILE) {
+		RAL_EXPECTS(arguments.size() == 2, "APPROX_PERCENTILE takes the values and the percentile");
+		// a batch without rows does not know the percentile, it is taken from the batches it is merged with
+		double percentile = std::numeric_limits<double>::quiet_NaN();
+		if(table.num_rows() > 0) {
+			std::unique_ptr<cudf::column> percentiles = cudf::cast(get_input(arguments[1]), cudf::data_type(cudf::type_id::FLOAT64));
+			std::unique_ptr<cudf::scalar> first_percentile = cudf::get_element(percentiles->view(), 0);
+			RAL_EXPECTS(first_percentile->is_valid(), "The percentile of APPROX_PERCENTILE can't be null");
+			percentile = static_cast<cudf::scalar_type_t<double> *>(first_percentile.get())->value();
+		}
+		return make_percentile_sketches(aggregation_input, percentile, group_offsets);
+	} else if(aggregation == AggregateKind::MERGE_APPROX_PERCENTILE) {
+		return merge_percentile_sketches(aggregation_input, group_offsets);
+	}
+	throw std::runtime_error("In compute_approx_aggregation function: aggregation type not supported");
+}
+
+std::string get_approx_aggregation_name(const ral::frame::BlazingTableView & table, std::string aggregation_input_expression,
+		AggregateKind aggregation, const std::string & aggregation_column_assigned_alias) {
+	if(aggregation_column_assigned_alias != "") {
+		return aggregation_column_assigned_alias;
+	}
+	std::string values_expression = get_expressions_from_expression_list(aggregation_input_expression)[0];
+	if(is_var_column(values_expression) || is_number(values_expression)) {
+		return aggregator_to_string(aggregation) + "(" + table.names().at(get_index(values_expression)) + ")";
+	}
+	return aggregator_to_string(aggregation) + "(" + values_expression + ")";
+}
+
+/* The sketches need the rows of every group together, so the table is ordered by its groups first. The rest of the
+aggregations are then computed on it as sorted, which outputs the groups in the same order. */
+std::unique_ptr<ral::frame::BlazingTable> compute_approx_aggregations_with_groupby(
+		const ral::frame::BlazingTableView & table, const std::vector<std::string> & aggregation_input_expressions, const std::vector<AggregateKind> & aggregation_types,
+		const std::vector<std::string> & aggregation_column_assigned_aliases, const std::vector<int> & group_column_indices) {
+
+	CudfTableView keys = table.view().select(group_column_indices);
+	cudf::groupby::groupby group_by_obj(keys, cudf::null_policy::INCLUDE);
+	cudf::groupby::groupby::groups groups = group_by_obj.get_groups(table.view());
+	ral::frame::BlazingTableView grouped_table(groups.values->view(), table.names());
+	std::vector<cudf::size_type> group_offsets = groups.offsets.empty() ? std::vector<cudf::size_type>{0} : groups.offsets;
+
+	std::vector<std::string> exact_input_expressions, exact_column_assigned_aliases;
+	std::vector<AggregateKind> exact_types;
+	std::vector<std::size_t> exact_indices;
+	for (size_t i = 0; i < aggregation_types.size(); i++){
+		if (!is_approx_aggregation(aggregation_types[i])){
+			exact_input_expressions.push_back(aggregation_input_expressions[i]);
+			exact_types.push_back(aggregation_types[i]);
+			exact_column_assigned_aliases.push_back(aggregation_column_assigned_aliases[i]);
+			exact_indices.push_back(i);
+		}
+	}
+	std::unique_ptr<ral::frame::BlazingTable> exact = compute_aggregations_with_groupby(grouped_table, exact_input_expressions, exact_types,
+		exact_column_assigned_aliases, group_column_indices, true);
+	std::vector<std::string> exact_names = exact->names();
+	std::vector< std::unique_ptr<cudf::column> > exact_columns = exact->releaseCudfTable()->release();
+
+	// output table is grouped columns and then aggregated columns
+	std::size_t num_group_columns = group_column_indices.size();
+	std::vector< std::unique_ptr<cudf::column> > output_columns(num_group_columns + aggregation_types.size());
+	std::vector<std::string> output_names(output_columns.size());
+	for (size_t i = 0; i < num_group_columns; i++){
+		output_columns[i] = std::move(exact_columns[i]);
+		output_names[i] = exact_names[i];
+	}
+	for (size_t i = 0; i < exact_indices.size(); i++){
+		output_columns[exact_indices[i] + num_group_columns] = std::move(exact_columns[i + num_group_columns]);
+		output_names[exact_indices[i] + num_group_columns] = exact_names[i + num_group_columns];
+	}
+	for (size_t i = 0; i < aggregation_types.size(); i++){
+		if (is_approx_aggregation(aggregation_types[i])){
+			output_columns[i + num_group_columns] = compute_approx_aggregation(grouped_table, aggregation_input_expressions[i], aggregation_types[i], group_offsets);
+			output_names[i + num_group_columns] = get_approx_aggregation_name(table, aggregation_input_expressions[i], aggregation_types[i],
+				aggregation_column_assigned_aliases[i]);
+		}
+	}
+	return std::make_unique<BlazingTable>(std::make_unique<CudfTable>(std::move(output_columns)), output_names);
+}
+
+std::unique_ptr<ral::frame::BlazingTable> estimate_approx_aggregations(std::unique_ptr<ral::frame::BlazingTable> aggregated,
+		const std::vector<AggregateKind> & aggregation_types, std::size_t num_group_columns) {
+	if(std::none_of(aggregation_types.begin(), aggregation_types.end(), is_approx_aggregation)) {
+		return aggregated;
+	}
+
+	std::vector<std::string> names = aggregated->names();
+	std::vector< std::unique_ptr<cudf::column> > columns = aggregated->releaseCudfTable()->release();
+	for (size_t i = 0; i < aggregation_types.size(); i++){
+		std::unique_ptr<cudf::column> & column = columns[i + num_group_columns];
+		if(aggregation_types[i] == AggregateKind::APPROX_COUNT_DISTINCT || aggregation_types[i] == AggregateKind::MERGE_APPROX_COUNT_DISTINCT) {
+			column = estimate_distinct_counts(column->view());
+		} else if(aggregation_types[i] == AggregateKind::APPROX_PERCENTILE || aggregation_types[i] == AggregateKind::MERGE_APPROX_PERCENTILE) {
+			column = estimate_percentiles(column->view());
+		}
+	}
+	return std::make_unique<BlazingTable>(std::make_unique<CudfTable>(std::move(columns)), names);
+}
+
 std::unique_ptr<ral::frame::BlazingTable> compute_groupby_without_aggregations(
 	const ral::frame::BlazingTableView & table, const std::vector<int> & group_column_indices) {
 
@@ -218,8 +356,17 @@ std::unique_ptr<ral::frame::BlazingTable> compute_aggregations_without_groupby(
 		const std::vector<AggregateKind> & aggregation_types, const std::vector<std::string> & aggregation_column_assigned_aliases){
 
 	std::vector<std::unique_ptr<cudf::scalar>> reductions;
+	std::vector<std::unique_ptr<cudf::column>> sketches(aggregation_types.size());
 	std::vector<std::string> agg_output_column_names;
 	for (size_t i = 0; i < aggregation_types.size(); i++){
+		if(is_approx_aggregation(aggregation_types[i])) { // the whole table is one group
+			sketches[i] = compute_approx_aggregation(table, aggregation_input_expressions[i], aggregation_types[i], {0, table.num_rows()});
+			reductions.emplace_back(nullptr);
+			agg_output_column_names.push_back(get_approx_aggregation_name(table, aggregation_input_expressions[i], aggregation_types[i],
+				aggregation_column_assigned_aliases[i]));
+			continue;
+		}
+
 		if(aggregation_input_expressions[i] == "" && aggregation_types[i] == AggregateKind::COUNT_ALL) { // this is a COUNT(*)
 			std::unique_ptr<cudf::scalar> scalar = cudf::make_numeric_scalar(cudf::data_type(cudf::type_id::INT64));
 			auto numeric_s = static_cast< cudf::scalar_type_t<int64_t>* >(scalar.get());
@@ -240,10 +387,24 @@ std::unique_ptr<ral::frame::BlazingTable> compute_aggregations_without_groupby(
 				auto numeric_s = static_cast< cudf::scalar_type_t<int64_t>* >(scalar.get());
 				numeric_s->set_value((int64_t)(aggregation_input.size() - aggregation_input.null_count()));
 				reductions.emplace_back(std::move(scalar));
+			} else if( aggregation_types[i] == AggregateKind::COUNT_DISTINCT) {
+				std::unique_ptr<cudf::scalar> scalar = cudf::make_numeric_scalar(cudf::data_type(cudf::type_id::INT64));
+				auto numeric_s = static_cast< cudf::scalar_type_t<int64_t>* >(scalar.get());
+				numeric_s->set_value((int64_t)cudf::distinct_count(aggregation_input, cudf::null_policy::EXCLUDE, cudf::nan_policy::NAN_IS_VALID));
+				reductions.emplace_back(std::move(scalar));
 			} else {
 				std::unique_ptr<cudf::aggregation> agg = makeCudfAggregation<cudf::aggregation>(aggregation_types[i]);
-				cudf::type_id output_type = get_aggregation_output_type(aggregation_input.type().id(), aggregation_types[i], false);
-				std::unique_ptr<cudf::scalar> reduction_out = cudf::reduce(aggregation_input, agg, cudf::data_type(output_type));
+				cudf::data_type output_type(get_aggregation_output_type(aggregation_input.type().id(), aggregation_types[i], false));
+				std::unique_ptr<cudf::column> widened_input;
+				if (is_widened_decimal_sum(aggregation_input.type(), aggregation_types[i])) {
+					widened_input = cudf::cast(aggregation_input, cudf::data_type{cudf::type_id::DECIMAL64, aggregation_input.type().scale()});
+					aggregation_input = widened_input->view();
+				}
+				if (cudf::is_fixed_point(aggregation_input.type()) && aggregation_types[i] != AggregateKind::MEAN) {
+					// the sums, the minimums and the maximums of the decimals keep their scale
+					output_type = aggregation_input.type();
+				}
+				std::unique_ptr<cudf::scalar> reduction_out = cudf::reduce(aggregation_input, agg, output_type);
 				if (aggregation_types[i] == AggregateKind::SUM0 && !reduction_out->is_valid()){ // if this aggregation was a SUM0, and it was not valid, we want it to be a valid 0 instead
 					std::unique_ptr<cudf::scalar> zero_scalar = get_scalar_from_string("0", reduction_out->type()); // this does not need to be from a string, but this is a convenient way to make the scalar i need
 					reductions.emplace_back(std::move(zero_scalar));
@@ -267,15 +428,36 @@ std::unique_ptr<ral::frame::BlazingTable> compute_aggregations_without_groupby(
 	// convert scalars into columns
 	std::vector<std::unique_ptr<cudf::column>> output_columns;
 	for (size_t i = 0; i < reductions.size(); i++){
+		if (sketches[i] != nullptr) {
+			output_columns.emplace_back(std::move(sketches[i]));
+			continue;
+		}
 		std::unique_ptr<cudf::column> temp = cudf::make_column_from_scalar(*(reductions[i]), 1);
 		output_columns.emplace_back(std::move(temp));
 	}
 	return std::make_unique<ral::frame::BlazingTable>(std::move(std::make_unique<CudfTable>(std::move(output_columns))), agg_output_column_names);
 }
 
+bool are_groups_sorted(const ral::frame::BlazingTableView & table, const std::vector<int> & group_column_indices) {
+	if (group_column_indices.empty() || table.num_rows() < 2) {
+		return false;
+	}
+	CudfTableView keys = table.view().select(group_column_indices);
+	std::vector<cudf::order> ascending(group_column_indices.size(), cudf::order::ASCENDING);
+	std::vector<cudf::order> descending(group_column_indices.size(), cudf::order::DESCENDING);
+	// nulls last, as the sorts of calcite put them by default
+	return cudf::is_sorted(keys, ascending, std::vector<cudf::null_order>(group_column_indices.size(), cudf::null_order::AFTER)) ||
+		cudf::is_sorted(keys, descending, std::vector<cudf::null_order>(group_column_indices.size(), cudf::null_order::BEFORE));
+}
+
 std::unique_ptr<ral::frame::BlazingTable> compute_aggregations_with_groupby(
 		const ral::frame::BlazingTableView & table, const std::vector<std::string> & aggregation_input_expressions, const std::vector<AggregateKind> & aggregation_types,
-		const std::vector<std::string> & aggregation_column_assigned_aliases, const std::vector<int> & group_column_indices) {
+		const std::vector<std::string> & aggregation_column_assigned_aliases, const std::vector<int> & group_column_indices, bool keys_are_sorted) {
+
+	if (std::any_of(aggregation_types.begin(), aggregation_types.end(), is_approx_aggregation)) {
+		return compute_approx_aggregations_with_groupby(table, aggregation_input_expressions, aggregation_types,
+			aggregation_column_assigned_aliases, group_column_indices);
+	}
 
 	// lets get the unique expressions. This is how many aggregation requests we will need
 	std::vector<std::string> unique_expressions = aggregation_input_expressions;
@@ -290,6 +472,8 @@ std::unique_ptr<ral::frame::BlazingTable> compute_aggregations_with_groupby(
 	std::vector<cudf::groupby::aggregation_request> requests;
 	std::vector<int> agg_out_indices;
 	std::vector<std::string> agg_output_column_names;
+	// the aggregations whose DECIMAL32 input was widened for a sum with the same input, and whose results go back to DECIMAL32
+	std::vector<bool> narrowed_results(aggregation_types.size(), false);
 	for (size_t u = 0; u < unique_expressions.size(); u++){
 		std::string expression = unique_expressions[u];
 
@@ -332,12 +516,26 @@ std::unique_ptr<ral::frame::BlazingTable> compute_aggregations_with_groupby(
 					agg_output_column_names.push_back(aggregation_column_assigned_aliases[i]);
 				}
 			}
+		}
+		bool widen_input = false;
+		for (size_t i = 0; i < aggregation_input_expressions.size(); i++){
+			widen_input = widen_input || (expression == aggregation_input_expressions[i] && is_widened_decimal_sum(aggregation_input.type(), aggregation_types[i]));
+		}
+		if (widen_input) {
+			int32_t scale = aggregation_input.type().scale();
+			aggregation_inputs_scope_holder.push_back(std::make_unique<ral::frame::BlazingColumnOwner>(
+				cudf::cast(aggregation_input, cudf::data_type{cudf::type_id::DECIMAL64, scale})));
+			aggregation_input = aggregation_inputs_scope_holder.back()->view();
+			for (size_t i = 0; i < aggregation_input_expressions.size(); i++){
+				narrowed_results[i] = narrowed_results[i] || (expression == aggregation_input_expressions[i]
+					&& (aggregation_types[i] == AggregateKind::MIN || aggregation_types[i] == AggregateKind::MAX));
+			}
 		}
 			requests.push_back(cudf::groupby::aggregation_request {.values = aggregation_input, .aggregations = std::move(agg_ops_for_request)});
 	}
 
 	CudfTableView keys = table.view().select(group_column_indices);
-	cudf::groupby::groupby group_by_obj(keys, cudf::null_policy::INCLUDE);
+	cudf::groupby::groupby group_by_obj(keys, cudf::null_policy::INCLUDE, keys_are_sorted ? cudf::sorted::YES : cudf::sorted::NO);
 	std::pair<std::unique_ptr<cudf::table>, std::vector<cudf::groupby::aggregation_result>> result = group_by_obj.aggregate( requests );
 
 	// output table is grouped columns and then aggregated columns
@@ -356,6 +554,12 @@ std::unique_ptr<ral::frame::BlazingTable> compute_aggregations_with_groupby(
 			std::unique_ptr<cudf::scalar> scalar = get_scalar_from_string("0", agg_cols_out[i]->type()); // this does not need to be from a string, but this is a convenient way to make the scalar i need
 			std::unique_ptr<cudf::column> temp = cudf::replace_nulls(agg_cols_out[i]->view(), *scalar );
 			output_columns[agg_out_indices[i] + group_column_indices.size()] = std::move(temp);
+		} else if (aggregation_types[agg_out_indices[i]] == AggregateKind::COUNT_DISTINCT && agg_cols_out[i]->type().id() != cudf::type_id::INT64){
+			// nunique counts in cudf::size_type, but the distinct counts are BIGINT like the other counts
+			output_columns[agg_out_indices[i] + group_column_indices.size()] = cudf::cast(agg_cols_out[i]->view(), cudf::data_type(cudf::type_id::INT64));
+		} else if (narrowed_results[agg_out_indices[i]]){
+			output_columns[agg_out_indices[i] + group_column_indices.size()] = cudf::cast(agg_cols_out[i]->view(),
+				cudf::data_type{cudf::type_id::DECIMAL32, agg_cols_out[i]->type().scale()});
 		} else {
 			output_columns[agg_out_indices[i] + group_column_indices.size()] = std::move(agg_cols_out[i]);
 		}
@@ -374,5 +578,299 @@ std::unique_ptr<ral::frame::BlazingTable> compute_aggregations_with_groupby(
 	return std::make_unique<BlazingTable>(std::move(output_table), output_names);
 }
 
+bool has_distinct_aggregations(const std::vector<AggregateKind> & aggregation_types) {
+	return std::find(aggregation_types.begin(), aggregation_types.end(), AggregateKind::COUNT_DISTINCT) != aggregation_types.end();
+}
+
+std::unique_ptr<ral::frame::BlazingTable> compute_partial_aggregations_with_distinct(
+		const ral::frame::BlazingTableView & table, const std::vector<std::string> & aggregation_input_expressions, const std::vector<AggregateKind> & aggregation_types,
+		const std::vector<std::string> & aggregation_column_assigned_aliases, const std::vector<int> & group_column_indices) {
+
+	// the inputs of the distinct aggregations that are not columns are computed and added to the table
+	std::vector< std::unique_ptr<ral::frame::BlazingColumn> > distinct_inputs_scope_holder;
+	std::vector<CudfColumnView> columns(table.view().begin(), table.view().end());
+	std::vector<std::string> names = table.names();
+
+	std::vector<int> partial_group_column_indices = group_column_indices;
+	std::map<std::string, std::size_t> distinct_group_positions; // where every distinct input is in the partial group columns
+	std::vector<std::string> other_input_expressions, other_column_assigned_aliases;
+	std::vector<AggregateKind> other_aggregation_types;
+	for (size_t i = 0; i < aggregation_types.size(); i++){
+		std::string expression = aggregation_input_expressions[i];
+		if (aggregation_types[i] != AggregateKind::COUNT_DISTINCT){
+			other_input_expressions.push_back(expression);
+			other_aggregation_types.push_back(aggregation_types[i]);
+			other_column_assigned_aliases.push_back(aggregation_column_assigned_aliases[i]);
+			continue;
+		}
+		if (distinct_group_positions.find(expression) != distinct_group_positions.end()){
+			continue;
+		}
+
+		int column_index;
+		if(is_var_column(expression) || is_number(expression)) {
+			column_index = get_index(expression);
+		} else {
+			std::vector< std::unique_ptr<ral::frame::BlazingColumn> > computed_columns = ral::processor::evaluate_expressions(table.view(), {expression});
+			distinct_inputs_scope_holder.push_back(std::move(computed_columns[0]));
+			columns.push_back(distinct_inputs_scope_holder.back()->view());
+			names.push_back(expression);
+			column_index = columns.size() - 1;
+		}
+		distinct_group_positions[expression] = partial_group_column_indices.size();
+		partial_group_column_indices.push_back(column_index);
+	}
+
+	ral::frame::BlazingTableView extended_table(CudfTableView{columns}, names);
+	std::unique_ptr<ral::frame::BlazingTable> grouped;
+	if (other_aggregation_types.empty()) {
+		ral::frame::BlazingTableView group_columns(extended_table.view().select(partial_group_column_indices), std::vector<std::string>(partial_group_column_indices.size()));
+		std::vector<int> all_group_columns(partial_group_column_indices.size());
+		std::iota(all_group_columns.begin(), all_group_columns.end(), 0);
+		grouped = compute_groupby_without_aggregations(group_columns, all_group_columns);
+	} else {
+		grouped = compute_aggregations_with_groupby(extended_table, other_input_expressions, other_aggregation_types,
+			other_column_assigned_aliases, partial_group_column_indices);
+	}
+
+	// the output has the group columns and then the aggregations, with the distinct values in the columns of theirs
+	std::vector<std::string> grouped_names = grouped->names();
+	std::vector< std::unique_ptr<cudf::column> > grouped_columns = grouped->releaseCudfTable()->release();
+	std::vector<CudfColumnView> grouped_views;
+	for (auto & column : grouped_columns) {
+		grouped_views.push_back(column->view());
+	}
+	// a group column is copied when it was already output
+	auto take_grouped_column = [&](std::size_t position) {
+		return grouped_columns[position] != nullptr ? std::move(grouped_columns[position]) : std::make_unique<cudf::column>(grouped_views[position]);
+	};
+
+	std::size_t num_group_columns = group_column_indices.size();
+	std::vector< std::unique_ptr<cudf::column> > output_columns;
+	std::vector<std::string> output_names;
+	for (size_t i = 0; i < num_group_columns; i++){
+		output_columns.push_back(take_grouped_column(i));
+		output_names.push_back(names[group_column_indices[i]]);
+	}
+	std::size_t other_position = partial_group_column_indices.size();
+	for (size_t i = 0; i < aggregation_types.size(); i++){
+		if (aggregation_types[i] == AggregateKind::COUNT_DISTINCT){
+			std::size_t position = distinct_group_positions[aggregation_input_expressions[i]];
+			output_columns.push_back(take_grouped_column(position));
+			if (aggregation_column_assigned_aliases[i] == ""){
+				output_names.push_back(aggregator_to_string(aggregation_types[i]) + "(" + names[partial_group_column_indices[position]] + ")");
+			} else {
+				output_names.push_back(aggregation_column_assigned_aliases[i]);
+			}
+		} else {
+			output_columns.push_back(take_grouped_column(other_position));
+			output_names.push_back(grouped_names[other_position]);
+			other_position++;
+		}
+	}
+	return std::make_unique<BlazingTable>(std::make_unique<CudfTable>(std::move(output_columns)), output_names);
+}
+
+bool can_compute_aggregations_per_row(const std::vector<AggregateKind> & aggregation_types) {
+	return std::all_of(aggregation_types.begin(), aggregation_types.end(), [](AggregateKind aggregation){
+		return aggregation == AggregateKind::SUM || aggregation == AggregateKind::SUM0 || aggregation == AggregateKind::MIN ||
+			aggregation == AggregateKind::MAX || aggregation == AggregateKind::COUNT_VALID || aggregation == AggregateKind::COUNT_ALL;
+	});
+}
+
+bool can_merge_aggregated_output(const std::vector<AggregateKind> & aggregation_types) {
+	// the counts are merged as sums, the distinct counts and the sketches are gone once they are estimated
+	return std::all_of(aggregation_types.begin(), aggregation_types.end(), [](AggregateKind aggregation){
+		return aggregation == AggregateKind::SUM || aggregation == AggregateKind::SUM0 || aggregation == AggregateKind::MIN ||
+			aggregation == AggregateKind::MAX || aggregation == AggregateKind::COUNT_VALID || aggregation == AggregateKind::COUNT_ALL;
+	});
+}
+
+std::unique_ptr<ral::frame::BlazingTable> compute_aggregations_per_row(
+		const ral::frame::BlazingTableView & table, const std::vector<std::string> & aggregation_input_expressions, const std::vector<AggregateKind> & aggregation_types,
+		const std::vector<int> & group_column_indices, const std::vector<std::string> & output_names, const std::vector<cudf::data_type> & output_types) {
+	RAL_EXPECTS(can_compute_aggregations_per_row(aggregation_types), "In compute_aggregations_per_row function: aggregation type not supported");
+
+	std::vector< std::unique_ptr<cudf::column> > output_columns;
+	for (size_t i = 0; i < group_column_indices.size(); i++){
+		output_columns.push_back(std::make_unique<cudf::column>(table.view().column(group_column_indices[i])));
+	}
+
+	for (size_t i = 0; i < aggregation_types.size(); i++){
+		cudf::data_type output_type = output_types[i + group_column_indices.size()];
+		if(aggregation_types[i] == AggregateKind::COUNT_ALL) {
+			// every row is counted once
+			std::unique_ptr<cudf::scalar> one = get_scalar_from_string("1", output_type);
+			output_columns.push_back(cudf::make_column_from_scalar(*one, table.num_rows()));
+			continue;
+		}
+
+		std::vector<std::unique_ptr<ral::frame::BlazingColumn>> aggregation_input_scope_holder;
+		CudfColumnView aggregation_input;
+		if(is_var_column(aggregation_input_expressions[i]) || is_number(aggregation_input_expressions[i])) {
+			aggregation_input = table.view().column(get_index(aggregation_input_expressions[i]));
+		} else {
+			aggregation_input_scope_holder = ral::processor::evaluate_expressions(table.view(), {aggregation_input_expressions[i]});
+			aggregation_input = aggregation_input_scope_holder[0]->view();
+		}
+
+		if(aggregation_types[i] == AggregateKind::COUNT_VALID) {
+			// a row is counted once if its value is valid
+			std::unique_ptr<cudf::column> valid = cudf::is_valid(aggregation_input);
+			output_columns.push_back(cudf::cast(valid->view(), output_type));
+		} else if(aggregation_input.type() == output_type) {
+			// the sum, the min and the max of a single value are the value
+			output_columns.push_back(std::make_unique<cudf::column>(aggregation_input));
+		} else {
+			output_columns.push_back(cudf::cast(aggregation_input, output_type));
+		}
+	}
+	return std::make_unique<BlazingTable>(std::make_unique<CudfTable>(std::move(output_columns)), output_names);
+}
+
+// the aggregate calls of an aggregate, without its group columns and its grouping sets
+std::vector<std::string> get_aggregate_calls(const std::string & query_part) {
+	auto rangeStart = query_part.find("(");
+	auto rangeEnd = query_part.rfind(")") - rangeStart;
+	std::string combined_expression = query_part.substr(rangeStart + 1, rangeEnd - 1);
+
+	std::vector<std::string> calls;
+	for(std::string expr : get_expressions_from_expression_list(combined_expression)) {
+		std::string expression = std::regex_replace(expr, std::regex("^ +| +$|( ) +"), "$1");
+		if(expression.find("group=") != 0 && expression.find("groups=") != 0) {
+			calls.push_back(expression);
+		}
+	}
+	return calls;
+}
+
+bool is_grouping_call(const std::string & expression) {
+	std::string operator_string = get_aggregation_operation_string(expression);
+	return operator_string == "GROUPING" || operator_string == "GROUPING_ID";
+}
+
+std::vector<std::vector<int>> get_grouping_sets(const std::string & query_part) {
+	std::vector<std::vector<int>> grouping_sets;
+	if(query_part.find("groups=[[") == std::string::npos) {
+		return grouping_sets;
+	}
+
+	// Now we have something like {0, 1}, {0}, {}
+	std::string sets_string = get_named_expression(query_part, "groups");
+	std::size_t start = sets_string.find("{");
+	while(start != std::string::npos) {
+		std::size_t end = sets_string.find("}", start);
+		std::vector<int> grouping_set;
+		for(const std::string & column : StringUtil::split(sets_string.substr(start + 1, end - start - 1), ",")) {
+			if(column.find_first_not_of(' ') != std::string::npos) {
+				grouping_set.push_back(std::stoi(column));
+			}
+		}
+		grouping_sets.push_back(grouping_set);
+		start = sets_string.find("{", end);
+	}
+	return grouping_sets;
+}
+
+std::vector<int> get_grouping_sets_group_columns(const std::vector<int> & group_column_indices,
+	const std::vector<std::vector<int>> & grouping_sets) {
+	auto in_every_set = [&](int column_index) {
+		return std::all_of(grouping_sets.begin(), grouping_sets.end(), [column_index](const std::vector<int> & grouping_set) {
+			return std::find(grouping_set.begin(), grouping_set.end(), column_index) != grouping_set.end();
+		});
+	};
+	std::vector<int> ordered_columns;
+	std::copy_if(group_column_indices.begin(), group_column_indices.end(), std::back_inserter(ordered_columns), in_every_set);
+	std::copy_if(group_column_indices.begin(), group_column_indices.end(), std::back_inserter(ordered_columns),
+		[&](int column_index) { return !in_every_set(column_index); });
+	return ordered_columns;
+}
+
+std::string get_grouping_sets_aggregate_expression(const std::string & query_part, const std::vector<int> & group_column_indices) {
+	std::string expression = query_part.substr(0, query_part.find("(")) + "(group=[{";
+	for(std::size_t i = 0; i < group_column_indices.size(); i++) {
+		expression += (i > 0 ? ", " : "") + std::to_string(group_column_indices[i]);
+	}
+	expression += "}]";
+	bool has_aggregations = false;
+	for(const std::string & call : get_aggregate_calls(query_part)) {
+		if(!is_grouping_call(call)) {
+			expression += ", " + call;
+			has_aggregations = true;
+		}
+	}
+	// the groups of the grand total have no columns, their COUNT(*) is what keeps their row
+	if(!has_aggregations) {
+		expression += ", EXPR$0=[COUNT()]";
+	}
+	return expression + ")";
+}
+
+std::tuple<std::vector<std::vector<int>>, std::vector<std::string>> get_grouping_calls(const std::string & query_part) {
+	std::vector<std::vector<int>> arguments;
+	std::vector<std::string> aliases;
+	for(const std::string & call : get_aggregate_calls(query_part)) {
+		std::vector<int> call_arguments;
+		std::string alias;
+		if(is_grouping_call(call)) {
+			for(std::string argument : StringUtil::split(get_string_between_outer_parentheses(call), ",")) {
+				call_arguments.push_back(get_index(StringUtil::trim(argument)));
+			}
+			if(call.find("EXPR$") != 0) {
+				alias = call.substr(0, call.find("=["));
+			}
+		}
+		arguments.push_back(call_arguments);
+		aliases.push_back(alias);
+	}
+	return std::make_tuple(std::move(arguments), std::move(aliases));
+}
+
+int64_t get_grouping_value(const std::vector<int> & arguments, const std::vector<int> & grouping_set) {
+	int64_t value = 0;
+	for(int column_index : arguments) {
+		bool in_set = std::find(grouping_set.begin(), grouping_set.end(), column_index) != grouping_set.end();
+		value = (value << 1) | (in_set ? 0 : 1);
+	}
+	return value;
+}
+
+std::unique_ptr<ral::frame::BlazingTable> compute_grouping_set(const ral::frame::BlazingTableView & table, std::size_t num_group_columns,
+	const std::vector<int> & set_positions, const std::vector<AggregateKind> & aggregation_types) {
+	RAL_EXPECTS(can_merge_aggregated_output(aggregation_types), "In compute_grouping_set function: only SUM, MIN, MAX and COUNT can be re-aggregated");
+
+	// the counts are merged as sums, like the partial aggregations of the nodes
+	std::vector<AggregateKind> merge_aggregation_types;
+	std::vector<std::string> aggregation_input_expressions, aggregation_column_assigned_aliases;
+	for(std::size_t i = 0; i < aggregation_types.size(); i++) {
+		bool is_count = aggregation_types[i] == AggregateKind::COUNT_VALID || aggregation_types[i] == AggregateKind::COUNT_ALL;
+		merge_aggregation_types.push_back(is_count ? AggregateKind::SUM : aggregation_types[i]);
+		aggregation_input_expressions.push_back(std::to_string(num_group_columns + i));
+		aggregation_column_assigned_aliases.push_back(table.names()[num_group_columns + i]);
+	}
+
+	if(!set_positions.empty()) {
+		return compute_aggregations_with_groupby(table, aggregation_input_expressions, merge_aggregation_types,
+			aggregation_column_assigned_aliases, set_positions);
+	}
+
+	// the grand total is the group of a constant, so that its aggregations have the types of the ones of the other sets
+	std::unique_ptr<cudf::scalar> zero = get_scalar_from_string("0", cudf::data_type(cudf::type_id::INT8));
+	std::unique_ptr<cudf::column> constant = cudf::make_column_from_scalar(*zero, table.num_rows());
+	std::vector<CudfColumnView> columns(table.view().begin(), table.view().end());
+	columns.push_back(constant->view());
+	std::vector<std::string> names = table.names();
+	names.push_back("");
+	std::unique_ptr<ral::frame::BlazingTable> grouped = compute_aggregations_with_groupby(
+		ral::frame::BlazingTableView(CudfTableView(columns), names), aggregation_input_expressions, merge_aggregation_types,
+		aggregation_column_assigned_aliases, {static_cast<int>(columns.size()) - 1});
+
+	std::vector<std::string> grouped_names = grouped->names();
+	std::vector<std::unique_ptr<ral::frame::BlazingColumn>> grouped_columns = grouped->releaseBlazingColumns();
+	grouped_columns.erase(grouped_columns.begin());
+	grouped_names.erase(grouped_names.begin());
+	return std::make_unique<ral::frame::BlazingTable>(std::move(grouped_columns), grouped_names);
+}
+
 }  // namespace operators
 }  // namespace ral
@@ -24,7 +24,11 @@ enum AggregateKind{
 	ROW_NUMBER,
 	LAG,
 	LEAD,
-	NTH_ELEMENT
+	NTH_ELEMENT,
+	APPROX_COUNT_DISTINCT,
+	APPROX_PERCENTILE,
+	MERGE_APPROX_COUNT_DISTINCT, // merges the sketches of APPROX_COUNT_DISTINCT
+	MERGE_APPROX_PERCENTILE // merges the sketches of APPROX_PERCENTILE
 };
 
 namespace ral {
@@ -57,18 +61,23 @@ namespace operators {
 			// TODO: https://github.com/BlazingDB/blazingsql/issues/1531
 			// return cudf::make_nth_element_aggregation<cudf_aggregation_type_T>(offset, cudf::null_policy::INCLUDE);	
 		}else if(input == AggregateKind::COUNT_DISTINCT){
-			/* Currently this conditional is unreachable.
-			Calcite transforms count distincts through the
-			AggregateExpandDistinctAggregates rule, so in fact,
-			each count distinct is replaced by some group by clauses. */
-			// return cudf::make_nunique_aggregation<cudf_aggregation_type_T>();
+			// the partial aggregations keep the distinct values, see compute_partial_aggregations_with_distinct. Its
+			// cudf::size_type result is cast to INT64 by compute_aggregations_with_groupby
+			return cudf::make_nunique_aggregation<cudf_aggregation_type_T>(cudf::null_policy::EXCLUDE);
 		}
+		// the approximate aggregations are sketches of their own, see is_approx_aggregation
 		throw std::runtime_error(
 			"In makeCudfAggregation function: AggregateKind type not supported");
 	}
 
 	AggregateKind get_aggregation_operation(std::string expression_in, bool is_window_operation = false);
 
+	// the name of the aggregation in the names of the columns that have no alias, like count(*) or min(column)
+	std::string aggregator_to_string(AggregateKind aggregation);
+
+	// the calcite indices of the group columns of an aggregate
+	std::vector<int> get_group_columns(std::string query_part);
+
 	std::tuple<std::vector<int>, std::vector<std::string>, std::vector<AggregateKind>, std::vector<std::string>> 
 		parseGroupByExpression(const std::string & queryString, std::size_t num_cols);
 
@@ -83,9 +92,78 @@ namespace operators {
 		const ral::frame::BlazingTableView & table, const std::vector<std::string> & aggregation_input_expressions, 
 		const std::vector<AggregateKind> & aggregation_types, const std::vector<std::string> & aggregation_column_assigned_aliases);
 
+	/* Returns true if the rows of every group are together in the table, because it is sorted by the group columns in
+	ascending or descending order, as the batches of the MergeStreamKernel or of a dataset that was written sorted are.
+	Their groups are then found by comparing every row with the one before, without a hash table. */
+	bool are_groups_sorted(const ral::frame::BlazingTableView & table, const std::vector<int> & group_column_indices);
+
+	// keys_are_sorted is true when the rows of every group are together in the table, the groups are then output in the order they are in
 	std::unique_ptr<ral::frame::BlazingTable> compute_aggregations_with_groupby(
+		const ral::frame::BlazingTableView & table, const std::vector<std::string> & aggregation_input_expressions, const std::vector<AggregateKind> & aggregation_types,
+		const std::vector<std::string> & aggregation_column_assigned_aliases, const std::vector<int> & group_column_indices, bool keys_are_sorted = false);
+
+	// Returns true if there is a COUNT_DISTINCT, whose partial aggregations are computed by compute_partial_aggregations_with_distinct
+	bool has_distinct_aggregations(const std::vector<AggregateKind> & aggregation_types);
+
+	/* Computes the partial aggregations of a table with COUNT_DISTINCT aggregations, which can't be merged from the counts of
+	every batch. Their inputs are grouped by along with the group columns, so that every group keeps each of its distinct
+	values once, in the column of the aggregation, and the rest of the aggregations are computed for these groups. It is
+	also how the partial aggregations are merged, until the last merge counts the distinct values of every group. */
+	std::unique_ptr<ral::frame::BlazingTable> compute_partial_aggregations_with_distinct(
 		const ral::frame::BlazingTableView & table, const std::vector<std::string> & aggregation_input_expressions, const std::vector<AggregateKind> & aggregation_types,
 		const std::vector<std::string> & aggregation_column_assigned_aliases, const std::vector<int> & group_column_indices);
 
+	/* Returns true for the aggregations that are not computed by cudf, but are sketches that are merged with each other
+	until the end of the aggregation, when they are made into their values by estimate_approx_aggregations. */
+	bool is_approx_aggregation(AggregateKind aggregation);
+
+	/* Makes the sketch columns of the approximate aggregations of a table that was aggregated into their values. It is
+	done by the last merge of the aggregation, the other aggregations are left as they are. */
+	std::unique_ptr<ral::frame::BlazingTable> estimate_approx_aggregations(std::unique_ptr<ral::frame::BlazingTable> aggregated,
+		const std::vector<AggregateKind> & aggregation_types, std::size_t num_group_columns);
+
+	// Returns true if every row can be made into the partial aggregations of a group of its own, see compute_aggregations_per_row
+	bool can_compute_aggregations_per_row(const std::vector<AggregateKind> & aggregation_types);
+
+	/* Makes every row of a table into the partial aggregations of a group of its own, with the schema of the output of
+	compute_aggregations_with_groupby, so that it is merged with the groups of the other batches as if it was aggregated.
+	It is cheaper than aggregating when almost every row has a group of its own. */
+	std::unique_ptr<ral::frame::BlazingTable> compute_aggregations_per_row(
+		const ral::frame::BlazingTableView & table, const std::vector<std::string> & aggregation_input_expressions, const std::vector<AggregateKind> & aggregation_types,
+		const std::vector<int> & group_column_indices, const std::vector<std::string> & output_names, const std::vector<cudf::data_type> & output_types);
+
+	/* Returns true if the output of the last merge of these aggregations can be merged again with more partial aggregations,
+	as if it was one of them. It is what the incremental aggregations keep from one query to the next. */
+	bool can_merge_aggregated_output(const std::vector<AggregateKind> & aggregation_types);
+
+	/* The grouping sets of an aggregate of GROUPING SETS, ROLLUP or CUBE, as the calcite indices of their group columns,
+	or nothing for an aggregate that only has the groups of all its group columns. */
+	std::vector<std::vector<int>> get_grouping_sets(const std::string & query_part);
+
+	/* The group columns of an aggregate of grouping sets in the order that its aggregate of all the group columns outputs
+	them, the columns that are in every set first, so that the groups can be distributed by them. */
+	std::vector<int> get_grouping_sets_group_columns(const std::vector<int> & group_column_indices,
+		const std::vector<std::vector<int>> & grouping_sets);
+
+	/* Makes the expression of the aggregate of some group columns of an aggregate of grouping sets, with the aggregations
+	of the aggregate but without its grouping sets and its GROUPING calls. An aggregate without aggregations gets a
+	COUNT(*) after its calls, which the GroupingSetsKernel does not output. */
+	std::string get_grouping_sets_aggregate_expression(const std::string & query_part, const std::vector<int> & group_column_indices);
+
+	/* For every call of an aggregate of grouping sets, the calcite indices of the arguments of a GROUPING call, or nothing
+	for the aggregations, and the alias of every GROUPING call, empty when it has none. */
+	std::tuple<std::vector<std::vector<int>>, std::vector<std::string>> get_grouping_calls(const std::string & query_part);
+
+	/* The value of a GROUPING call for the rows of a grouping set, a bit for every argument, the first one the highest,
+	which is 1 when the column of the argument is not in the set. */
+	int64_t get_grouping_value(const std::vector<int> & arguments, const std::vector<int> & grouping_set);
+
+	/* Re-aggregates the aggregations of some groups into the groups of some of their group columns, as the groups of all
+	the group columns of an aggregate of grouping sets are made into the groups of every set. The table has the group
+	columns and then the aggregations, and so does the output, with the columns of the set as group columns.
+	@param set_positions the positions of the group columns of the set in the table, empty for the grand total */
+	std::unique_ptr<ral::frame::BlazingTable> compute_grouping_set(const ral::frame::BlazingTableView & table, std::size_t num_group_columns,
+		const std::vector<int> & set_positions, const std::vector<AggregateKind> & aggregation_types);
+
 }  // namespace operators
 }  // namespace ral
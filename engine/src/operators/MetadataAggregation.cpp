@@ -0,0 +1,230 @@
+#include "MetadataAggregation.h"
+
+#include <algorithm>
+#include <limits>
+#include <set>
+
+#include <cudf/column/column_factories.hpp>
+#include <cudf/scalar/scalar.hpp>
+#include <cudf/unary.hpp>
+
+#include "GroupBy.h"
+#include "parser/CalciteExpressionParsing.h"
+#include "parser/expression_utils.hpp"
+#include "skip_data/SkipDataProcessor.h"
+#include "utilities/CommonOperations.h"
+
+namespace ral {
+namespace operators {
+
+namespace {
+
+// the statistics of a column as host values, read as INT64
+std::vector<int64_t> get_statistic(const ral::frame::BlazingTable & metadata, int column_index) {
+	cudf::column_view column = metadata.view().column(column_index);
+	if (column.type().id() == cudf::type_id::INT64) {
+		return ral::utilities::column_to_vector<int64_t>(column);
+	}
+	std::unique_ptr<cudf::column> casted = cudf::cast(column, cudf::data_type{cudf::type_id::INT64});
+	return ral::utilities::column_to_vector<int64_t>(casted->view());
+}
+
+// the min and max of the statistics are only exact for these types, the others are converted or rounded when they are
+// read, and when a row group has no min and max its statistics are the limits of the type
+bool get_statistic_limits(cudf::type_id type, int64_t & lowest, int64_t & highest) {
+	if (type == cudf::type_id::INT32) {
+		lowest = std::numeric_limits<int32_t>::min();
+		highest = std::numeric_limits<int32_t>::max();
+		return true;
+	} else if (type == cudf::type_id::INT64) {
+		lowest = std::numeric_limits<int64_t>::min();
+		highest = std::numeric_limits<int64_t>::max();
+		return true;
+	}
+	return false;
+}
+
+} // namespace
+
+metadata_aggregation::metadata_aggregation(const std::string & aggregate_expression)
+	: aggregate_expression(aggregate_expression) {}
+
+bool metadata_aggregation::answer_row_groups(ral::io::data_parser * parser, const ral::io::data_handle & handle,
+	const std::string & scan_expression, const ral::io::Schema & schema, const std::vector<int> & projections,
+	const std::vector<std::string> & output_names, std::vector<int> & row_groups) {
+
+	if ((parser->type() != ral::io::DataType::PARQUET && parser->type() != ral::io::DataType::ORC) || handle.file_handle == nullptr) {
+		return true;
+	}
+
+	std::vector<int> group_column_indices;
+	std::vector<std::string> aggregation_input_expressions;
+	std::vector<AggregateKind> aggregation_types;
+	std::vector<std::string> aggregation_column_assigned_aliases;
+	std::tie(group_column_indices, aggregation_input_expressions, aggregation_types, aggregation_column_assigned_aliases) =
+		parseGroupByExpression(aggregate_expression, projections.size());
+	if (!group_column_indices.empty() || aggregation_types.empty()) {
+		return true;
+	}
+
+	std::unique_ptr<ral::frame::BlazingTable> metadata = parser->get_metadata({handle}, 0);
+	if (metadata == nullptr || metadata->num_rows() == 0) {
+		return true;
+	}
+	std::vector<std::string> metadata_names = metadata->names();
+	auto find_metadata_column = [&](const std::string & name) {
+		auto it = std::find(metadata_names.begin(), metadata_names.end(), name);
+		return it != metadata_names.end() ? static_cast<int>(std::distance(metadata_names.begin(), it)) : -1;
+	};
+	int row_count_index = find_metadata_column("row_count");
+	int row_group_index = find_metadata_column("row_group_index");
+	if (row_count_index < 0 || row_group_index < 0) {
+		return true;
+	}
+
+	// the statistics that each aggregation needs, every one of them must have them
+	std::vector<int> null_count_indices(aggregation_types.size(), -1);
+	std::vector<int> min_max_indices(aggregation_types.size(), -1);
+	std::vector<cudf::data_type> output_types;
+	std::vector<std::string> partial_names;
+	for (size_t i = 0; i < aggregation_types.size(); i++) {
+		if (aggregation_types[i] == AggregateKind::COUNT_ALL && aggregation_input_expressions[i].empty()) {
+			output_types.push_back(cudf::data_type{cudf::type_id::INT64});
+			partial_names.push_back(aggregation_column_assigned_aliases[i].empty() ?
+				aggregator_to_string(aggregation_types[i]) + "(*)" : aggregation_column_assigned_aliases[i]);
+			continue;
+		}
+		if (!is_var_column(aggregation_input_expressions[i])) {
+			return true;
+		}
+		int column = get_index(aggregation_input_expressions[i]);
+		if (column < 0 || column >= static_cast<int>(projections.size())) {
+			return true;
+		}
+		std::string suffix = std::to_string(projections[column]) + "_" + schema.get_name(projections[column]);
+		null_count_indices[i] = find_metadata_column("nulls_" + suffix);
+		if (null_count_indices[i] < 0) {
+			return true;
+		}
+
+		cudf::data_type type{schema.get_dtype(projections[column])};
+		if (aggregation_types[i] == AggregateKind::COUNT_VALID) {
+			output_types.push_back(cudf::data_type{cudf::type_id::INT64});
+		} else if (aggregation_types[i] == AggregateKind::MIN || aggregation_types[i] == AggregateKind::MAX) {
+			min_max_indices[i] = find_metadata_column((aggregation_types[i] == AggregateKind::MIN ? "min_" : "max_") + suffix);
+			int64_t lowest, highest;
+			if (min_max_indices[i] < 0 || metadata->view().column(min_max_indices[i]).type() != type ||
+					!get_statistic_limits(type.id(), lowest, highest)) {
+				return true;
+			}
+			output_types.push_back(type);
+		} else {
+			return true;
+		}
+		partial_names.push_back(aggregation_column_assigned_aliases[i].empty() ?
+			aggregator_to_string(aggregation_types[i]) + "(" + output_names[column] + ")" : aggregation_column_assigned_aliases[i]);
+	}
+
+	// the row groups whose rows all pass the filter of the scan, the others have to be read
+	std::set<int32_t> passing_row_groups;
+	{
+		std::unique_ptr<ral::frame::BlazingTable> passing = ral::skip_data::get_row_groups_with_all_rows_passing(
+			metadata->toBlazingTableView(), schema.get_names(), scan_expression);
+		if (passing == nullptr) {
+			return true;
+		}
+		std::vector<int32_t> passing_ids = ral::utilities::column_to_vector<int32_t>(passing->view().column(row_group_index));
+		passing_row_groups.insert(passing_ids.begin(), passing_ids.end());
+	}
+
+	std::vector<int32_t> metadata_row_groups = ral::utilities::column_to_vector<int32_t>(metadata->view().column(row_group_index));
+	std::vector<int64_t> row_counts = get_statistic(*metadata, row_count_index);
+	std::vector<std::vector<int64_t>> null_counts(aggregation_types.size());
+	std::vector<std::vector<int64_t>> min_max_values(aggregation_types.size());
+	for (size_t i = 0; i < aggregation_types.size(); i++) {
+		if (null_count_indices[i] >= 0) {
+			null_counts[i] = get_statistic(*metadata, null_count_indices[i]);
+		}
+		if (min_max_indices[i] >= 0) {
+			min_max_values[i] = get_statistic(*metadata, min_max_indices[i]);
+		}
+	}
+
+	std::set<int> candidate_row_groups(row_groups.begin(), row_groups.end());
+	std::vector<int64_t> values(aggregation_types.size(), 0);
+	std::vector<bool> has_value(aggregation_types.size(), false);
+	std::vector<int> remaining_row_groups;
+	std::size_t answered_row_groups = 0;
+	for (size_t row = 0; row < metadata_row_groups.size(); row++) {
+		int row_group = metadata_row_groups[row];
+		if (!row_groups.empty() && candidate_row_groups.count(row_group) == 0) {
+			continue;
+		}
+
+		bool answerable = row_counts[row] >= 0 && passing_row_groups.count(row_group) > 0;
+		for (size_t i = 0; answerable && i < aggregation_types.size(); i++) {
+			if (null_count_indices[i] >= 0 && (null_counts[i][row] < 0 || null_counts[i][row] > row_counts[row])) {
+				answerable = false; // the null count is not known
+			} else if (min_max_indices[i] >= 0 && null_counts[i][row] < row_counts[row]) {
+				int64_t lowest, highest;
+				get_statistic_limits(output_types[i].id(), lowest, highest);
+				answerable = min_max_values[i][row] != lowest && min_max_values[i][row] != highest;
+			}
+		}
+		if (!answerable) {
+			remaining_row_groups.push_back(row_group);
+			continue;
+		}
+
+		answered_row_groups++;
+		for (size_t i = 0; i < aggregation_types.size(); i++) {
+			if (aggregation_types[i] == AggregateKind::COUNT_ALL) {
+				values[i] += row_counts[row];
+				has_value[i] = true;
+			} else if (aggregation_types[i] == AggregateKind::COUNT_VALID) {
+				values[i] += row_counts[row] - null_counts[i][row];
+				has_value[i] = true;
+			} else if (null_counts[i][row] < row_counts[row]) { // the MIN and MAX of the row groups that are not all nulls
+				int64_t value = min_max_values[i][row];
+				if (!has_value[i]) {
+					values[i] = value;
+				} else {
+					values[i] = aggregation_types[i] == AggregateKind::MIN ? std::min(values[i], value) : std::max(values[i], value);
+				}
+				has_value[i] = true;
+			}
+		}
+	}
+	if (answered_row_groups == 0) {
+		return true;
+	}
+
+	// a partial aggregation of one row, with the types and the names of the ones of ComputeAggregateKernel
+	std::vector<std::unique_ptr<cudf::column>> columns;
+	for (size_t i = 0; i < aggregation_types.size(); i++) {
+		cudf::numeric_scalar<int64_t> scalar(values[i], has_value[i]);
+		std::unique_ptr<cudf::column> column = cudf::make_column_from_scalar(scalar, 1);
+		if (output_types[i].id() != cudf::type_id::INT64) {
+			column = cudf::cast(column->view(), output_types[i]);
+		}
+		columns.push_back(std::move(column));
+	}
+	auto partial = std::make_unique<ral::frame::BlazingTable>(std::make_unique<cudf::table>(std::move(columns)), partial_names);
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		partial_aggregations.push_back(std::move(partial));
+	}
+
+	row_groups = remaining_row_groups;
+	return !row_groups.empty();
+}
+
+std::vector<std::unique_ptr<ral::frame::BlazingTable>> metadata_aggregation::release_partial_aggregations() {
+	std::lock_guard<std::mutex> lock(mutex);
+	std::vector<std::unique_ptr<ral::frame::BlazingTable>> released = std::move(partial_aggregations);
+	partial_aggregations.clear();
+	return released;
+}
+
+}  // namespace operators
+}  // namespace ral
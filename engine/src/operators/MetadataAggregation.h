@@ -0,0 +1,57 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "execution_kernels/LogicPrimitives.h"
+#include "io/data_parser/DataParser.h"
+#include "io/Schema.h"
+
+namespace ral {
+namespace operators {
+
+/**
+ * @brief The partial aggregations of an aggregation without groups that are answered from the statistics of the row
+ * groups of parquet and orc files, instead of from their rows.
+ *
+ * It is shared by the scan and the ComputeAggregateKernel that consumes it. The scan answers the row groups whose rows
+ * all pass its filter and reads the others, and the ComputeAggregateKernel outputs the partial aggregations of the
+ * answered row groups with its own, to be merged with them. Only COUNT(*), COUNT, MIN and MAX of columns are answered,
+ * and MIN and MAX only for integer columns, whose footer statistics are exact.
+ */
+class metadata_aggregation {
+public:
+	/**
+	 * @param aggregate_expression The expression of the LogicalAggregate that consumes the scan.
+	 */
+	explicit metadata_aggregation(const std::string & aggregate_expression);
+
+	/**
+	 * @brief Answers the row groups of a file that the statistics of the file are enough for, and takes them out of
+	 * the row groups to read.
+	 *
+	 * @param scan_expression The expression of the scan, with its projections and its filter.
+	 * @param projections The columns of the schema that the scan outputs.
+	 * @param output_names The names of the columns that the scan outputs.
+	 * @param row_groups The row groups of the file to read, all of them if it is empty.
+	 * @return false if none of the row groups needs to be read, so that the file can be skipped.
+	 */
+	bool answer_row_groups(ral::io::data_parser * parser, const ral::io::data_handle & handle, const std::string & scan_expression,
+		const ral::io::Schema & schema, const std::vector<int> & projections, const std::vector<std::string> & output_names,
+		std::vector<int> & row_groups);
+
+	/**
+	 * @brief Returns the partial aggregations of the row groups answered so far, one table of one row per file.
+	 */
+	std::vector<std::unique_ptr<ral::frame::BlazingTable>> release_partial_aggregations();
+
+private:
+	std::string aggregate_expression;
+	std::mutex mutex;
+	std::vector<std::unique_ptr<ral::frame::BlazingTable>> partial_aggregations;
+};
+
+}  // namespace operators
+}  // namespace ral
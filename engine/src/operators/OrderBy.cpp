@@ -1,4 +1,5 @@
 #include "OrderBy.h"
+#include "RadixSort.h"
 #include "parser/CalciteExpressionParsing.h"
 #include "utilities/CodeTimer.h"
 #include "communication/CommunicationData.h"
@@ -7,7 +8,7 @@
 #include <cudf/copying.hpp>
 #include <cudf/sorting.hpp>
 #include <cudf/search.hpp>
-#include <random>
+#include "utilities/RandomGenerator.h"
 #include "parser/expression_utils.hpp"
 #include "utilities/CommonOperations.h"
 #include <blazingdb/io/Util/StringUtil.h>
@@ -25,6 +26,19 @@ using namespace ral::distribution;
 const std::string ASCENDING_ORDER_SORT_TEXT = "ASC";
 const std::string DESCENDING_ORDER_SORT_TEXT = "DESC";
 
+namespace {
+
+// the fixed width keys that fit in 64 bits are radix sorted, the rest are compared by cudf
+std::unique_ptr<cudf::column> get_sorted_order(const CudfTableView & sortColumns,
+	const std::vector<cudf::order> & sortOrderTypes, const std::vector<cudf::null_order> & null_orders) {
+	if (sortColumns.num_rows() > 0 && can_radix_sort(sortColumns)) {
+		return radix_sorted_order(sortColumns, sortOrderTypes, null_orders);
+	}
+	return cudf::sorted_order(sortColumns, sortOrderTypes, null_orders);
+}
+
+}  // namespace
+
 /**---------------------------------------------------------------------------*
  * @brief Sorts the columns of the input table according the sortOrderTypes
  * and sortColIndices.
@@ -47,7 +61,12 @@ std::unique_ptr<ral::frame::BlazingTable> logicalSort(
 	/*ToDo: Edit this according the Calcite output*/
 	std::vector<cudf::null_order> null_orders(sortColIndices.size(), cudf::null_order::AFTER);
 
-	std::unique_ptr<cudf::column> output = cudf::sorted_order( sortColumns, sortOrderTypes, null_orders );
+	// the batches that are already in order, like the ones of a dataset that was written sorted, are only copied
+	if (cudf::is_sorted( sortColumns, sortOrderTypes, null_orders )) {
+		return std::make_unique<ral::frame::BlazingTable>( std::make_unique<cudf::table>(table.view()), table.names() );
+	}
+
+	std::unique_ptr<cudf::column> output = get_sorted_order( sortColumns, sortOrderTypes, null_orders );
 
 	std::unique_ptr<cudf::table> gathered = cudf::gather( table.view(), output->view() );
 
@@ -183,6 +202,17 @@ std::tuple<std::vector<int>, std::vector<cudf::order> > get_right_sorts_vars(con
 	return std::make_tuple(sortColIndices, sortOrderTypes);
 }
 
+// The rows of a partition are kept together, unless it can be split by its order columns too
+std::tuple<std::vector<int>, std::vector<cudf::order> > get_vars_to_range_partition(const std::string & query_part) {
+	if (window_expression_can_split_partitions(query_part)) {
+		return get_vars_to_partition_and_order(query_part);
+	} else if (window_expression_contains_partition_by(query_part)) {
+		return get_vars_to_partition(query_part);
+	} else {
+		return get_vars_to_orders(query_part);
+	}
+}
+
 bool has_limit_only(const std::string & query_part){
 	std::vector<int> sortColIndices;
 	std::tie(sortColIndices, std::ignore, std::ignore) = get_sort_vars(query_part);
@@ -196,6 +226,19 @@ int64_t get_limit_rows_when_relational_alg_is_simple(const std::string & query_p
 	return limitRows;
 }
 
+std::unique_ptr<ral::frame::BlazingTable> top_k(const ral::frame::BlazingTableView & table,
+	const std::vector<int> & sortColIndices, const std::vector<cudf::order> & sortOrderTypes, cudf::size_type num_rows) {
+
+	std::vector<cudf::null_order> null_orders(sortColIndices.size(), cudf::null_order::AFTER);
+	std::unique_ptr<cudf::column> order = get_sorted_order(table.view().select(sortColIndices), sortOrderTypes, null_orders);
+
+	cudf::size_type num_kept = std::min(num_rows, table.num_rows());
+	CudfColumnView kept_order = cudf::slice(order->view(), {0, num_kept})[0];
+	std::unique_ptr<cudf::table> gathered = cudf::gather(table.view(), kept_order);
+
+	return std::make_unique<ral::frame::BlazingTable>(std::move(gathered), table.names());
+}
+
 std::tuple<std::unique_ptr<ral::frame::BlazingTable>, bool, int64_t>
 limit_table(const ral::frame::BlazingTableView & table, int64_t num_rows_limit) {
 
@@ -234,11 +277,7 @@ std::unique_ptr<ral::frame::BlazingTable> sample(const ral::frame::BlazingTableV
 	std::vector<int> sortColIndices;
 	
 	if (is_window_function(query_part)){
-		if (window_expression_contains_partition_by(query_part)) {
-			std::tie(sortColIndices, sortOrderTypes) = get_vars_to_partition(query_part);
-		} else {
-			std::tie(sortColIndices, sortOrderTypes) = get_vars_to_orders(query_part);
-		}
+		std::tie(sortColIndices, sortOrderTypes) = get_vars_to_range_partition(query_part);
 	}
 	else {
 		std::tie(sortColIndices, sortOrderTypes, std::ignore) = get_sort_vars(query_part);
@@ -249,8 +288,8 @@ std::unique_ptr<ral::frame::BlazingTable> sample(const ral::frame::BlazingTableV
 	std::transform(sortColIndices.begin(), sortColIndices.end(), sortColNames.begin(), [&](auto index) { return tableNames[index]; });
 
 	std::size_t num_samples = compute_total_samples(table.num_rows());
-	std::random_device rd;
-	auto samples = cudf::sample(table.view().select(sortColIndices), num_samples, cudf::sample_with_replacement::FALSE, rd());
+	auto samples = cudf::sample(table.view().select(sortColIndices), num_samples, cudf::sample_with_replacement::FALSE,
+		ral::utilities::random_generator::get_instance().next_seed());
 
 	return std::make_unique<ral::frame::BlazingTable>(std::move(samples), sortColNames);
 }
@@ -258,7 +297,8 @@ std::unique_ptr<ral::frame::BlazingTable> sample(const ral::frame::BlazingTableV
 std::vector<cudf::table_view> partition_table(const ral::frame::BlazingTableView & partitionPlan,
 	const ral::frame::BlazingTableView & sortedTable,
 	const std::vector<cudf::order> & sortOrderTypes,
-	const std::vector<int> & sortColIndices) {
+	const std::vector<int> & sortColIndices,
+	bool split_duplicate_pivots) {
 	
 	if (sortedTable.num_rows() == 0) {
 		return {sortedTable.view()};
@@ -271,6 +311,37 @@ std::vector<cudf::table_view> partition_table(const ral::frame::BlazingTableView
 	auto pivot_indexes = cudf::upper_bound(columns_to_search, partitionPlan.view(), sortOrderTypes, null_orders);
 
 	std::vector<cudf::size_type> split_indexes = ral::utilities::column_to_vector<cudf::size_type>(pivot_indexes->view());
+
+	if (split_duplicate_pivots && partitionPlan.num_rows() > 1) {
+		// the first pivot that is the same as every pivot
+		auto first_equal_pivots = cudf::lower_bound(partitionPlan.view(), partitionPlan.view(), sortOrderTypes, null_orders);
+		std::vector<cudf::size_type> first_equal = ral::utilities::column_to_vector<cudf::size_type>(first_equal_pivots->view());
+		bool has_duplicate_pivots = false;
+		for (std::size_t i = 0; i < first_equal.size(); i++) {
+			has_duplicate_pivots = has_duplicate_pivots || first_equal[i] < static_cast<cudf::size_type>(i);
+		}
+		if (has_duplicate_pivots) {
+			auto lower_pivot_indexes = cudf::lower_bound(columns_to_search, partitionPlan.view(), sortOrderTypes, null_orders);
+			std::vector<cudf::size_type> lower_indexes = ral::utilities::column_to_vector<cudf::size_type>(lower_pivot_indexes->view());
+			// the rows equal to the pivots first..last go to the partitions first..last+1, all of them are after the rows before them
+			std::size_t first = 0;
+			while (first < split_indexes.size()) {
+				std::size_t last = first;
+				while (last + 1 < split_indexes.size() && first_equal[last + 1] == static_cast<cudf::size_type>(first)) {
+					last++;
+				}
+				if (last > first) {
+					cudf::size_type equal_begin = lower_indexes[first];
+					cudf::size_type equal_rows = split_indexes[first] - equal_begin;
+					std::size_t num_sharing_partitions = last - first + 2;
+					for (std::size_t i = first; i <= last; i++) {
+						split_indexes[i] = equal_begin + static_cast<cudf::size_type>(static_cast<int64_t>(equal_rows) * (i - first + 1) / num_sharing_partitions);
+					}
+				}
+				first = last + 1;
+			}
+		}
+	}
 	return cudf::split(sortedTable.view(), split_indexes);
 }
 
@@ -284,11 +355,7 @@ std::unique_ptr<ral::frame::BlazingTable> generate_partition_plan(
 	cudf::size_type limitRows;
 	
 	if (is_window_function(query_part)){
-		if (window_expression_contains_partition_by(query_part)) {
-			std::tie(sortColIndices, sortOrderTypes) = get_vars_to_partition(query_part);
-		} else {
-			std::tie(sortColIndices, sortOrderTypes) = get_vars_to_orders(query_part);
-		}
+		std::tie(sortColIndices, sortOrderTypes) = get_vars_to_range_partition(query_part);
 	}
 	else {
 		std::tie(sortColIndices, sortOrderTypes, std::ignore) = get_sort_vars(query_part);
@@ -296,17 +363,9 @@ std::unique_ptr<ral::frame::BlazingTable> generate_partition_plan(
 	
 	std::unique_ptr<ral::frame::BlazingTable> partitionPlan;
 
-	std::size_t num_bytes_per_order_by_partition = 400000000;
-	int max_num_order_by_partitions_per_node = 8;
-	std::map<std::string, std::string> config_options = context->getConfigOptions();
-	auto it = config_options.find("NUM_BYTES_PER_ORDER_BY_PARTITION");
-	if (it != config_options.end()){
-		num_bytes_per_order_by_partition = std::stoull(config_options["NUM_BYTES_PER_ORDER_BY_PARTITION"]);
-	}
-	it = config_options.find("MAX_NUM_ORDER_BY_PARTITIONS_PER_NODE");
-	if (it != config_options.end()){
-		max_num_order_by_partitions_per_node = std::stoi(config_options["MAX_NUM_ORDER_BY_PARTITIONS_PER_NODE"]);
-	}
+	const blazingdb::manager::QueryConfig & config = context->getConfig();
+	std::size_t num_bytes_per_order_by_partition = config.num_bytes_per_order_by_partition.value_or(400000000);
+	int max_num_order_by_partitions_per_node = config.max_num_order_by_partitions_per_node.value_or(8);
 
 	int num_nodes = context->getTotalNodes();
 	cudf::size_type total_num_partitions = (double)table_num_rows*(double)avg_bytes_per_row/(double)num_bytes_per_order_by_partition;
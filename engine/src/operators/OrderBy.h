@@ -30,6 +30,11 @@ std::tuple< std::vector<int>, std::vector<cudf::order> > get_vars_to_orders(cons
 
 std::tuple< std::vector<int>, std::vector<cudf::order> > get_vars_to_partition_and_order(const std::string & query_part);
 
+std::tuple<std::vector<int>, std::vector<cudf::order> > get_right_sorts_vars(const std::string & query_part);
+
+// The columns the batches of a window function are range partitioned by, see window_expression_can_split_partitions
+std::tuple<std::vector<int>, std::vector<cudf::order> > get_vars_to_range_partition(const std::string & query_part);
+
 std::unique_ptr<ral::frame::BlazingTable> sort(const ral::frame::BlazingTableView & table, const std::string & query_part);
 
 std::size_t compute_total_samples(std::size_t num_rows);
@@ -39,13 +44,29 @@ std::unique_ptr<ral::frame::BlazingTable> sample(const ral::frame::BlazingTableV
 std::unique_ptr<ral::frame::BlazingTable> generate_partition_plan(const std::vector<std::unique_ptr<ral::frame::BlazingTable>> & samples,
     std::size_t table_num_rows, std::size_t avg_bytes_per_row, const std::string & query_part, Context * context);
 
+/**
+ * @brief Splits a sorted table into the rows up to every pivot of the partition plan, and the rows after the last one.
+ *
+ * @param split_duplicate_pivots When some pivots are the same, the rows equal to them are split evenly by their position
+ * among the partitions that start at or after them, instead of all going to the first one, so that many rows with the
+ * same key don't end up in one partition. It must be false when the rows with the same key have to be in the same
+ * partition, as for the partitions of a window function.
+ */
 std::vector<cudf::table_view> partition_table(const ral::frame::BlazingTableView & partitionPlan,
-	const ral::frame::BlazingTableView & sortedTable, const std::vector<cudf::order> & sortOrderTypes,	const std::vector<int> & sortColIndices);
+	const ral::frame::BlazingTableView & sortedTable, const std::vector<cudf::order> & sortOrderTypes,	const std::vector<int> & sortColIndices,
+	bool split_duplicate_pivots = false);
 
 bool has_limit_only(const std::string & query_part);
 
 int64_t get_limit_rows_when_relational_alg_is_simple(const std::string & query_part);
 
+/**
+ * @brief Returns the first num_rows rows of a table in the given order, sorted. Only the sort columns are sorted, the
+ * rest of the columns are gathered for the rows that are kept.
+ */
+std::unique_ptr<ral::frame::BlazingTable> top_k(const ral::frame::BlazingTableView & table,
+	const std::vector<int> & sortColIndices, const std::vector<cudf::order> & sortOrderTypes, cudf::size_type num_rows);
+
 std::tuple<std::unique_ptr<ral::frame::BlazingTable>, bool, int64_t> limit_table(const ral::frame::BlazingTableView & table, int64_t num_rows_limit);
 
 std::unique_ptr<ral::frame::BlazingTable> merge(std::vector<ral::frame::BlazingTableView> partitions_to_merge, const std::string & query_part);
@@ -0,0 +1,158 @@
+#pragma GCC diagnostic ignored "-Wunknown-pragmas"
+#include <cudf/column/column_factories.hpp>
+#include <cudf/utilities/bit.hpp>
+#include <rmm/thrust_rmm_allocator.h>
+#include <thrust/for_each.h>
+#include <thrust/partition.h>
+#include <thrust/sequence.h>
+#include <thrust/sort.h>
+#include <thrust/iterator/counting_iterator.h>
+#pragma GCC diagnostic pop
+
+#include <type_traits>
+
+#include "RadixSort.h"
+#include "utilities/error.hpp"
+
+namespace ral {
+namespace operators {
+
+namespace {
+
+// the bytes of the values of a key and whether they are signed, 0 when it can't be radix sorted
+int get_key_bytes(cudf::type_id type, bool & is_signed) {
+	is_signed = true;
+	switch (type) {
+		case cudf::type_id::INT8: return 1;
+		case cudf::type_id::INT16: return 2;
+		case cudf::type_id::INT32:
+		case cudf::type_id::TIMESTAMP_DAYS:
+		case cudf::type_id::DURATION_DAYS: return 4;
+		case cudf::type_id::INT64:
+		case cudf::type_id::TIMESTAMP_SECONDS:
+		case cudf::type_id::TIMESTAMP_MILLISECONDS:
+		case cudf::type_id::TIMESTAMP_MICROSECONDS:
+		case cudf::type_id::TIMESTAMP_NANOSECONDS:
+		case cudf::type_id::DURATION_SECONDS:
+		case cudf::type_id::DURATION_MILLISECONDS:
+		case cudf::type_id::DURATION_MICROSECONDS:
+		case cudf::type_id::DURATION_NANOSECONDS: return 8;
+		default: break;
+	}
+	is_signed = false;
+	switch (type) {
+		case cudf::type_id::BOOL8:
+		case cudf::type_id::UINT8: return 1;
+		case cudf::type_id::UINT16: return 2;
+		case cudf::type_id::UINT32: return 4;
+		case cudf::type_id::UINT64: return 8;
+		default: return 0;
+	}
+}
+
+bool nulls_go_first(cudf::order order, cudf::null_order null_precedence) {
+	// like the comparator of cudf, a null is less than the values with BEFORE, and a descending key reverses it
+	return (order == cudf::order::ASCENDING) == (null_precedence == cudf::null_order::BEFORE);
+}
+
+// shifts the packed keys of every row to make room for the key, and puts the key in their low bits
+template <typename T>
+void pack_key(const cudf::column_view & key, bool descending, bool null_bit, bool nulls_first, uint64_t * packed) {
+	using unsigned_type = typename std::make_unsigned<T>::type;
+	const T * data = key.data<T>();
+	const cudf::bitmask_type * null_mask = key.nullable() ? key.null_mask() : nullptr;
+	cudf::size_type offset = key.offset();
+	bool is_bool = key.type().id() == cudf::type_id::BOOL8;
+	int value_bits = 8 * sizeof(T);
+	int width = value_bits + (null_bit ? 1 : 0);
+	uint64_t value_mask = value_bits == 64 ? ~uint64_t{0} : (uint64_t{1} << value_bits) - 1;
+	uint64_t sign_bit = std::is_signed<T>::value ? uint64_t{1} << (value_bits - 1) : 0;
+
+	thrust::for_each(rmm::exec_policy(0)->on(0),
+		thrust::make_counting_iterator<cudf::size_type>(0),
+		thrust::make_counting_iterator<cudf::size_type>(key.size()),
+		[=] __device__ (cudf::size_type row) {
+			uint64_t value = is_bool ? (data[row] != 0) : static_cast<uint64_t>(static_cast<unsigned_type>(data[row]));
+			value ^= sign_bit;
+			if (descending) {
+				value = ~value & value_mask;
+			}
+			// the nulls are ordered among themselves by the keys after them
+			bool valid = null_mask == nullptr || cudf::bit_is_set(null_mask, offset + row);
+			if (!valid) {
+				value = 0;
+			}
+			if (null_bit && valid == nulls_first) {
+				value |= uint64_t{1} << value_bits;
+			}
+			packed[row] = (width < 64 ? packed[row] << width : 0) | value;
+		});
+}
+
+void pack_key(const cudf::column_view & key, cudf::order order, cudf::null_order null_precedence, bool null_bit, uint64_t * packed) {
+	bool is_signed;
+	int bytes = get_key_bytes(key.type().id(), is_signed);
+	bool descending = order == cudf::order::DESCENDING;
+	bool nulls_first = nulls_go_first(order, null_precedence);
+	switch (is_signed ? bytes : -bytes) {
+		case 1: pack_key<int8_t>(key, descending, null_bit, nulls_first, packed); break;
+		case 2: pack_key<int16_t>(key, descending, null_bit, nulls_first, packed); break;
+		case 4: pack_key<int32_t>(key, descending, null_bit, nulls_first, packed); break;
+		case 8: pack_key<int64_t>(key, descending, null_bit, nulls_first, packed); break;
+		case -1: pack_key<uint8_t>(key, descending, null_bit, nulls_first, packed); break;
+		case -2: pack_key<uint16_t>(key, descending, null_bit, nulls_first, packed); break;
+		case -4: pack_key<uint32_t>(key, descending, null_bit, nulls_first, packed); break;
+		case -8: pack_key<uint64_t>(key, descending, null_bit, nulls_first, packed); break;
+		default: RAL_FAIL("In radix_sorted_order: a key can't be radix sorted");
+	}
+}
+
+}  // namespace
+
+bool can_radix_sort(const cudf::table_view & keys) {
+	int total_bits = 0;
+	for (cudf::size_type i = 0; i < keys.num_columns(); i++) {
+		bool is_signed;
+		int bytes = get_key_bytes(keys.column(i).type().id(), is_signed);
+		if (bytes == 0) {
+			return false;
+		}
+		total_bits += 8 * bytes + (i > 0 && keys.column(i).has_nulls() ? 1 : 0);
+	}
+	return keys.num_columns() > 0 && total_bits <= 64;
+}
+
+std::unique_ptr<cudf::column> radix_sorted_order(const cudf::table_view & keys,
+	const std::vector<cudf::order> & column_order, const std::vector<cudf::null_order> & null_precedence) {
+	RAL_EXPECTS(can_radix_sort(keys), "In radix_sorted_order: the keys can't be radix sorted");
+
+	cudf::size_type num_rows = keys.num_rows();
+	rmm::device_vector<uint64_t> packed(num_rows, 0);
+	for (cudf::size_type i = 0; i < keys.num_columns(); i++) {
+		cudf::order order = column_order.empty() ? cudf::order::ASCENDING : column_order[i];
+		cudf::null_order nulls = null_precedence.empty() ? cudf::null_order::BEFORE : null_precedence[i];
+		pack_key(keys.column(i), order, nulls, i > 0 && keys.column(i).has_nulls(), packed.data().get());
+	}
+
+	std::unique_ptr<cudf::column> order = cudf::make_numeric_column(cudf::data_type{cudf::type_id::INT32}, num_rows);
+	cudf::size_type * indices = order->mutable_view().data<cudf::size_type>();
+	thrust::sequence(rmm::exec_policy(0)->on(0), indices, indices + num_rows);
+	// the keys are primitive with the default comparison, so thrust does a radix sort of them
+	thrust::stable_sort_by_key(rmm::exec_policy(0)->on(0), packed.begin(), packed.end(), indices);
+
+	cudf::column_view first_key = keys.column(0);
+	if (first_key.has_nulls()) {
+		const cudf::bitmask_type * null_mask = first_key.null_mask();
+		cudf::size_type offset = first_key.offset();
+		bool nulls_first = nulls_go_first(column_order.empty() ? cudf::order::ASCENDING : column_order[0],
+			null_precedence.empty() ? cudf::null_order::BEFORE : null_precedence[0]);
+		thrust::stable_partition(rmm::exec_policy(0)->on(0), indices, indices + num_rows,
+			[null_mask, offset, nulls_first] __device__ (cudf::size_type row) {
+				return cudf::bit_is_set(null_mask, offset + row) != nulls_first;
+			});
+	}
+	return order;
+}
+
+}  // namespace operators
+}  // namespace ral
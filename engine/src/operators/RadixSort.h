@@ -0,0 +1,37 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <cudf/column/column.hpp>
+#include <cudf/table/table_view.hpp>
+#include <cudf/types.hpp>
+
+namespace ral {
+namespace operators {
+
+/**
+ * @brief Whether the rows of the keys can be ordered by radix_sorted_order.
+ *
+ * The keys have to be integers, booleans, timestamps or durations, and all of them, with a bit for the nulls of every
+ * key that has nulls but the first one, have to fit in 64 bits. Floats are left to cudf, because of how it orders NaN.
+ */
+bool can_radix_sort(const cudf::table_view & keys);
+
+/**
+ * @brief The same order of the rows as cudf::sorted_order, with a radix sort of a key of 64 bits per row instead of the
+ * comparisons of the rows.
+ *
+ * Every key is made unsigned with its sign bit flipped, and its bits are inverted when it is descending, so that the
+ * order of the unsigned values is the order of the keys. The keys are then packed into the 64 bits from the first one,
+ * in the high bits, to the last one, each one after a bit that puts its nulls before or after its values. The nulls of
+ * the first key are put in their place after the sort instead, so that a single key of 64 bits fits.
+ *
+ * @param keys The sort columns, it must be can_radix_sort(keys).
+ * @returns The INT32 column with the index of the rows, in their order.
+ */
+std::unique_ptr<cudf::column> radix_sorted_order(const cudf::table_view & keys,
+	const std::vector<cudf::order> & column_order, const std::vector<cudf::null_order> & null_precedence);
+
+}  // namespace operators
+}  // namespace ral
@@ -0,0 +1,188 @@
+#pragma GCC diagnostic ignored "-Wunknown-pragmas"
+#include <cudf/column/column_device_view.cuh>
+#include <cudf/column/column_factories.hpp>
+#include <cudf/reduction.hpp>
+#include <cudf/scalar/scalar.hpp>
+#include <cudf/stream_compaction.hpp>
+#include <cudf/unary.hpp>
+#include <rmm/thrust_rmm_allocator.h>
+#include <thrust/for_each.h>
+#include <thrust/transform.h>
+#include <thrust/iterator/counting_iterator.h>
+#pragma GCC diagnostic pop
+
+#include <algorithm>
+
+#include "RuntimeFilter.h"
+#include "utilities/error.hpp"
+
+namespace ral {
+namespace operators {
+
+namespace {
+
+// splitmix64, the bits of the keys that are close to each other end up far apart
+__device__ __forceinline__ uint64_t mix_key(int64_t key) {
+	uint64_t x = static_cast<uint64_t>(key) + 0x9e3779b97f4a7c15ULL;
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+	return x ^ (x >> 31);
+}
+
+// the positions of the bits of a key are h1 + i * h2, the two halves of its hash
+__device__ __forceinline__ std::size_t bit_position(uint64_t hash, int i, std::size_t num_bits) {
+	uint32_t h1 = static_cast<uint32_t>(hash);
+	uint32_t h2 = static_cast<uint32_t>(hash >> 32) | 1;
+	return (static_cast<uint64_t>(h1) + static_cast<uint64_t>(i) * h2) % num_bits;
+}
+
+std::unique_ptr<cudf::column> cast_to_int64(const cudf::column_view & keys) {
+	return cudf::cast(keys, cudf::data_type{cudf::type_id::INT64});
+}
+
+}  // namespace
+
+runtime_filter::runtime_filter(const std::string & column_name, std::size_t num_bits)
+	: column_name{column_name}, num_bits{num_bits}, bits{num_bits / 8} {
+	RAL_EXPECTS(num_bits > 0 && num_bits % 32 == 0, "The number of bits of a runtime filter must be a multiple of 32");
+	cudaMemset(bits.data(), 0, bits.size());
+}
+
+bool runtime_filter::is_supported_type(cudf::data_type type) {
+	switch (type.id()) {
+		case cudf::type_id::INT8:
+		case cudf::type_id::INT16:
+		case cudf::type_id::INT32:
+		case cudf::type_id::INT64:
+		case cudf::type_id::UINT8:
+		case cudf::type_id::UINT16:
+		case cudf::type_id::UINT32:
+			return true;
+		default:
+			return false;
+	}
+}
+
+void runtime_filter::add(const cudf::column_view & keys) {
+	RAL_EXPECTS(is_supported_type(keys.type()), "Unsupported type of the keys of a runtime filter");
+	if (keys.size() == keys.null_count()) {
+		return;
+	}
+
+	std::unique_ptr<cudf::column> casted_keys = cast_to_int64(keys);
+	auto keys_range = cudf::minmax(casted_keys->view());
+	int64_t keys_min = static_cast<cudf::numeric_scalar<int64_t> *>(keys_range.first.get())->value();
+	int64_t keys_max = static_cast<cudf::numeric_scalar<int64_t> *>(keys_range.second.get())->value();
+
+	auto d_keys_ptr = cudf::column_device_view::create(casted_keys->view());
+	cudf::column_device_view d_keys = *d_keys_ptr;
+	std::size_t filter_bits = this->num_bits;
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	uint32_t * d_bits = static_cast<uint32_t *>(bits.data());
+	thrust::for_each(rmm::exec_policy(0)->on(0),
+					thrust::make_counting_iterator<cudf::size_type>(0),
+					thrust::make_counting_iterator<cudf::size_type>(keys.size()),
+					[d_keys, d_bits, filter_bits] __device__ (cudf::size_type row){
+						if (d_keys.is_null(row)) {
+							return;
+						}
+						uint64_t hash = mix_key(d_keys.element<int64_t>(row));
+						for (int i = 0; i < num_hashes; i++) {
+							std::size_t bit = bit_position(hash, i, filter_bits);
+							atomicOr(d_bits + bit / 32, 1u << (bit % 32));
+						}
+					});
+
+	this->min = this->has_range ? std::min(this->min, keys_min) : keys_min;
+	this->max = this->has_range ? std::max(this->max, keys_max) : keys_max;
+	this->has_range = true;
+}
+
+void runtime_filter::merge(const cudf::column_view & other_bits, bool other_has_range, int64_t other_min, int64_t other_max) {
+	RAL_EXPECTS(other_bits.type().id() == cudf::type_id::UINT32 && static_cast<std::size_t>(other_bits.size()) * 32 == num_bits,
+		"Can't merge runtime filters of different sizes");
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	uint32_t * d_bits = static_cast<uint32_t *>(bits.data());
+	thrust::transform(rmm::exec_policy(0)->on(0),
+					other_bits.begin<uint32_t>(),
+					other_bits.end<uint32_t>(),
+					d_bits,
+					d_bits,
+					[] __device__ (uint32_t other_word, uint32_t word){
+						return word | other_word;
+					});
+
+	if (other_has_range) {
+		this->min = this->has_range ? std::min(this->min, other_min) : other_min;
+		this->max = this->has_range ? std::max(this->max, other_max) : other_max;
+		this->has_range = true;
+	}
+}
+
+std::unique_ptr<ral::frame::BlazingTable> runtime_filter::get_bits() const {
+	std::lock_guard<std::mutex> lock(mutex_);
+	std::vector<std::unique_ptr<cudf::column>> columns;
+	columns.push_back(std::make_unique<cudf::column>(cudf::data_type{cudf::type_id::UINT32},
+		static_cast<cudf::size_type>(num_bits / 32), rmm::device_buffer{bits}));
+	return std::make_unique<ral::frame::BlazingTable>(std::make_unique<cudf::table>(std::move(columns)), std::vector<std::string>{"bits"});
+}
+
+bool runtime_filter::get_range(int64_t & min, int64_t & max) const {
+	std::lock_guard<std::mutex> lock(mutex_);
+	min = this->min;
+	max = this->max;
+	return this->has_range;
+}
+
+std::unique_ptr<ral::frame::BlazingTable> runtime_filter::apply(const ral::frame::BlazingTableView & table) const {
+	std::vector<std::string> names = table.names();
+	auto it = std::find(names.begin(), names.end(), column_name);
+	if (it == names.end() || table.num_rows() == 0) {
+		return nullptr;
+	}
+	cudf::column_view keys = table.view().column(std::distance(names.begin(), it));
+	if (!is_supported_type(keys.type())) {
+		return nullptr;
+	}
+
+	std::unique_ptr<cudf::column> casted_keys = cast_to_int64(keys);
+	auto d_keys_ptr = cudf::column_device_view::create(casted_keys->view());
+	cudf::column_device_view d_keys = *d_keys_ptr;
+	std::unique_ptr<cudf::column> mask = cudf::make_numeric_column(cudf::data_type{cudf::type_id::BOOL8}, keys.size());
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	const uint32_t * d_bits = static_cast<const uint32_t *>(bits.data());
+	std::size_t filter_bits = this->num_bits;
+	bool filter_has_range = this->has_range;
+	int64_t filter_min = this->min;
+	int64_t filter_max = this->max;
+	thrust::transform(rmm::exec_policy(0)->on(0),
+					thrust::make_counting_iterator<cudf::size_type>(0),
+					thrust::make_counting_iterator<cudf::size_type>(keys.size()),
+					mask->mutable_view().begin<bool>(),
+					[d_keys, d_bits, filter_bits, filter_has_range, filter_min, filter_max] __device__ (cudf::size_type row){
+						if (!filter_has_range || d_keys.is_null(row)) {
+							return false;
+						}
+						int64_t key = d_keys.element<int64_t>(row);
+						if (key < filter_min || key > filter_max) {
+							return false;
+						}
+						uint64_t hash = mix_key(key);
+						for (int i = 0; i < num_hashes; i++) {
+							std::size_t bit = bit_position(hash, i, filter_bits);
+							if ((d_bits[bit / 32] & (1u << (bit % 32))) == 0) {
+								return false;
+							}
+						}
+						return true;
+					});
+
+	std::unique_ptr<cudf::table> filtered = cudf::apply_boolean_mask(table.view(), mask->view());
+	return std::make_unique<ral::frame::BlazingTable>(std::move(filtered), names);
+}
+
+}  // namespace operators
+}  // namespace ral
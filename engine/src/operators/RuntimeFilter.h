@@ -0,0 +1,79 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "execution_kernels/LogicPrimitives.h"
+#include <cudf/column/column_view.hpp>
+#include <rmm/device_buffer.hpp>
+
+namespace ral {
+namespace operators {
+
+/**
+ * @brief A filter of the keys that the probe side of an inner join can match, made from the keys of its build side.
+ *
+ * It keeps the min and the max of the keys and a bloom filter of them, so a row of the probe side is only dropped when
+ * its key is surely not in the build side. Only integer keys are supported, and they are all compared as INT64 so that
+ * the two sides of the join don't need the same type. All the nodes make their filters with the same number of bits,
+ * so that they can be merged.
+ */
+class runtime_filter {
+public:
+	/**
+	 * @param column_name The name of the column of the probe side that the filter applies to.
+	 * @param num_bits The size of the bloom filter. A multiple of 32.
+	 */
+	runtime_filter(const std::string & column_name, std::size_t num_bits = default_num_bits);
+
+	/**
+	 * @brief Returns true for the types of the keys that the filter supports.
+	 */
+	static bool is_supported_type(cudf::data_type type);
+
+	const std::string & get_column_name() const { return column_name; }
+
+	/**
+	 * @brief Adds the keys of a batch of the build side. The null keys can't match, so they are not added.
+	 */
+	void add(const cudf::column_view & keys);
+
+	/**
+	 * @brief Adds the keys that were added to the filter of another node, see get_bits and get_range.
+	 *
+	 * @param bits The column of get_bits of the other filter.
+	 */
+	void merge(const cudf::column_view & bits, bool has_range, int64_t min, int64_t max);
+
+	/**
+	 * @brief Returns the bits of the bloom filter as a table with one UINT32 column, to send them to other nodes.
+	 */
+	std::unique_ptr<ral::frame::BlazingTable> get_bits() const;
+
+	/**
+	 * @brief Gets the min and the max of the keys that were added. Returns false if no key was added.
+	 */
+	bool get_range(int64_t & min, int64_t & max) const;
+
+	/**
+	 * @brief Returns the rows of a table whose key can be in the build side, without the null keys.
+	 * Returns nullptr if the table does not have the column of the filter, or it has no rows.
+	 */
+	std::unique_ptr<ral::frame::BlazingTable> apply(const ral::frame::BlazingTableView & table) const;
+
+	static constexpr std::size_t default_num_bits = 1 << 23; /**< 1 MB, about 1% of false positives for 800K distinct keys */
+	static constexpr int num_hashes = 3;
+
+private:
+	std::string column_name;
+	std::size_t num_bits;
+	rmm::device_buffer bits;
+	mutable std::mutex mutex_;
+	bool has_range = false;
+	int64_t min = 0;
+	int64_t max = 0;
+};
+
+}  // namespace operators
+}  // namespace ral
@@ -0,0 +1,83 @@
+#pragma GCC diagnostic ignored "-Wunknown-pragmas"
+#include <cudf/column/column_factories.hpp>
+#include <cudf/stream_compaction.hpp>
+#include <rmm/thrust_rmm_allocator.h>
+#include <thrust/transform.h>
+#include <thrust/iterator/counting_iterator.h>
+#pragma GCC diagnostic pop
+
+#include "TableSample.h"
+#include "parser/expression_utils.hpp"
+#include "utilities/RandomGenerator.h"
+#include "utilities/error.hpp"
+
+namespace ral {
+namespace operators {
+
+namespace {
+
+// splitmix64, the same seeds always give the same hashes
+__host__ __device__ __forceinline__ uint64_t mix_seed(uint64_t x) {
+	x += 0x9e3779b97f4a7c15ULL;
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+	return x ^ (x >> 31);
+}
+
+// a hash is kept when its 53 high bits, as a fraction from 0 to 1, are below the rate
+__host__ __device__ __forceinline__ bool is_kept(uint64_t hash, double rate) {
+	return static_cast<double>(hash >> 11) * (1.0 / 9007199254740992.0) < rate;
+}
+
+}  // namespace
+
+bool table_sample::keep_block(std::size_t file_index, int block_index) const {
+	return is_kept(mix_seed(mix_seed(seed ^ mix_seed(file_index)) + static_cast<uint64_t>(block_index + 1)), rate);
+}
+
+uint64_t table_sample::get_batch_seed(std::size_t batch_index) const {
+	return mix_seed(seed + mix_seed(batch_index));
+}
+
+table_sample parse_table_sample(const std::string & expression) {
+	table_sample sample;
+	sample.system = get_named_expression(expression, "mode") == "system";
+	sample.rate = std::stod(get_named_expression(expression, "rate"));
+	RAL_EXPECTS(sample.rate >= 0 && sample.rate <= 1, "The rate of a TABLESAMPLE must be between 0 and 100 percent");
+
+	std::string seed = get_named_expression(expression, "repeatableSeed");
+	sample.repeatable = !seed.empty() && seed != "-";
+	if (sample.repeatable) {
+		sample.seed = static_cast<uint64_t>(std::stoll(seed));
+	} else {
+		sample.seed = ral::utilities::random_generator::get_instance().next_seed();
+	}
+	return sample;
+}
+
+std::vector<int> sample_row_groups(const table_sample & sample, std::size_t file_index, const std::vector<int> & row_groups) {
+	std::vector<int> sampled_row_groups;
+	for (int row_group : row_groups) {
+		if (sample.keep_block(file_index, row_group)) {
+			sampled_row_groups.push_back(row_group);
+		}
+	}
+	return sampled_row_groups;
+}
+
+std::unique_ptr<ral::frame::BlazingTable> sample_rows(const ral::frame::BlazingTableView & table, uint64_t batch_seed, double rate) {
+	std::unique_ptr<cudf::column> mask = cudf::make_numeric_column(cudf::data_type{cudf::type_id::BOOL8}, table.num_rows());
+	thrust::transform(rmm::exec_policy(0)->on(0),
+					thrust::make_counting_iterator<uint64_t>(0),
+					thrust::make_counting_iterator<uint64_t>(table.num_rows()),
+					mask->mutable_view().begin<bool>(),
+					[batch_seed, rate] __device__ (uint64_t row){
+						return is_kept(mix_seed(batch_seed ^ mix_seed(row)), rate);
+					});
+
+	std::unique_ptr<cudf::table> sampled = cudf::apply_boolean_mask(table.view(), mask->view());
+	return std::make_unique<ral::frame::BlazingTable>(std::move(sampled), table.names());
+}
+
+}  // namespace operators
+}  // namespace ral
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "execution_kernels/LogicPrimitives.h"
+
+namespace ral {
+namespace operators {
+
+/**
+ * @brief The TABLESAMPLE of a scan, from the Sample relational algebra that Calcite puts over the scan.
+ *
+ * SYSTEM keeps every block of the table with a probability of rate, the row groups of parquet and orc files and the
+ * files of the other formats, and the blocks that are not kept are not read. BERNOULLI keeps every row with a
+ * probability of rate. Which blocks and rows are kept only depends on the seed, so a REPEATABLE sample gives the same
+ * rows every time the table is read in the same way.
+ */
+struct table_sample {
+	bool system = false;
+	double rate = 1.0; /**< The fraction of the rows that are kept, from 0 to 1. */
+	uint64_t seed = 0;
+	bool repeatable = false;
+
+	/**
+	 * @brief Whether a block of the table is kept.
+	 *
+	 * @param file_index The index of the file of the block.
+	 * @param block_index The index of the block in its file, -1 for the whole file.
+	 */
+	bool keep_block(std::size_t file_index, int block_index) const;
+
+	/**
+	 * @brief Get the seed of the rows of a batch, so that the batches are not sampled with the same rows.
+	 */
+	uint64_t get_batch_seed(std::size_t batch_index) const;
+};
+
+/**
+ * @brief Parses a Sample like Sample(mode=[bernoulli], rate=[0.1], repeatableSeed=[-]). A sample that is not REPEATABLE
+ * gets a random seed.
+ */
+table_sample parse_table_sample(const std::string & expression);
+
+/**
+ * @brief Keeps the row groups of a file that its SYSTEM sample keeps.
+ *
+ * @param row_groups The row groups of the file, they can't be empty.
+ */
+std::vector<int> sample_row_groups(const table_sample & sample, std::size_t file_index, const std::vector<int> & row_groups);
+
+/**
+ * @brief Returns the rows of a batch that its BERNOULLI sample keeps.
+ *
+ * @param batch_seed The seed of the batch, see table_sample::get_batch_seed.
+ */
+std::unique_ptr<ral::frame::BlazingTable> sample_rows(const ral::frame::BlazingTableView & table, uint64_t batch_seed, double rate);
+
+}  // namespace operators
+}  // namespace ral
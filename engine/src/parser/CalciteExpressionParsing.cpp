@@ -129,6 +129,48 @@ std::unique_ptr<cudf::scalar> str_to_timestamp_scalar_with_decimal_format(const
 	}
 }
 
+bool get_unscaled_decimal_value(const std::string & number, int32_t scale, int64_t & unscaled_value) {
+	std::string digits = StringUtil::trim(number);
+	bool negative = !digits.empty() && digits[0] == '-';
+	if (!digits.empty() && (digits[0] == '-' || digits[0] == '+')) {
+		digits = digits.substr(1);
+	}
+	size_t point = digits.find('.');
+	std::string fraction = point == std::string::npos ? "" : digits.substr(point + 1);
+	digits = digits.substr(0, point);
+	if (digits.empty() && fraction.empty()) {
+		return false;
+	}
+	if (!std::all_of(digits.begin(), digits.end(), ::isdigit) || !std::all_of(fraction.begin(), fraction.end(), ::isdigit)) {
+		return false;
+	}
+
+	// the number is all_digits * 10^exponent, which has to be a whole number of units of 10^scale
+	fraction.erase(fraction.find_last_not_of('0') + 1);
+	std::string all_digits = digits + fraction;
+	int32_t exponent = -static_cast<int32_t>(fraction.size()) - scale;
+	all_digits.erase(0, std::min(all_digits.find_first_not_of('0'), all_digits.size()));
+	for (; exponent < 0 && !all_digits.empty() && all_digits.back() == '0'; exponent++) {
+		all_digits.pop_back();
+	}
+	if (all_digits.empty()) {
+		unscaled_value = 0;
+		return true;
+	}
+	if (exponent < 0 || all_digits.size() > 18) {
+		return false;
+	}
+
+	int64_t value = std::stoll(all_digits);
+	for (int32_t i = 0; i < exponent; i++) {
+		if (__builtin_mul_overflow(value, 10, &value)) {
+			return false;
+		}
+	}
+	unscaled_value = negative ? -value : value;
+	return true;
+}
+
 std::unique_ptr<cudf::scalar> get_scalar_from_string(const std::string & scalar_string, cudf::data_type type, bool strings_have_quotes) {
 	if (is_null(scalar_string)) {
 		return cudf::make_default_constructed_scalar(type);
@@ -210,6 +252,16 @@ std::unique_ptr<cudf::scalar> get_scalar_from_string(const std::string & scalar_
 		static_cast<ScalarType *>(ret.get())->set_value(static_cast<T>(std::stod(scalar_string)));
 		return ret;
 	}
+	if(type.id() == cudf::type_id::DECIMAL32 || type.id() == cudf::type_id::DECIMAL64) {
+		int64_t unscaled_value;
+		RAL_EXPECTS(get_unscaled_decimal_value(scalar_string, type.scale(), unscaled_value),
+			"In CalciteExpressionParsing, " + scalar_string + " can't be a decimal with scale " + std::to_string(type.scale()));
+		if (type.id() == cudf::type_id::DECIMAL32) {
+			RAL_EXPECTS(unscaled_value >= INT_MIN && unscaled_value <= INT_MAX, "In CalciteExpressionParsing, " + scalar_string + " does not fit in a DECIMAL32");
+			return cudf::make_fixed_point_scalar<numeric::decimal32>(static_cast<int32_t>(unscaled_value), numeric::scale_type{type.scale()});
+		}
+		return cudf::make_fixed_point_scalar<numeric::decimal64>(unscaled_value, numeric::scale_type{type.scale()});
+	}
 	if(type.id() == cudf::type_id::STRING) {
 		if (strings_have_quotes) {
 			return cudf::make_string_scalar(scalar_string.substr(1, scalar_string.length() - 2));
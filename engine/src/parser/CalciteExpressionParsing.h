@@ -25,6 +25,9 @@ std::string get_string_between_outer_parentheses(std::string operator_string);
 
 std::unique_ptr<cudf::scalar> get_max_integer_scalar(cudf::data_type type);
 
+// returns true if the number can be written exactly as a decimal with this scale, in which case unscaled_value is its value times 10^-scale
+bool get_unscaled_decimal_value(const std::string & number, int32_t scale, int64_t & unscaled_value);
+
 std::unique_ptr<cudf::scalar> get_scalar_from_string(const std::string & scalar_string, cudf::data_type type, bool strings_have_quotes = true);
 
 int count_string_occurrence(std::string haystack, std::string needle);
@@ -1,6 +1,11 @@
 #include "expression_tree.hpp"
 #include <cassert>
+#include <cctype>
+#include <cmath>
+#include <iomanip>
+#include <limits>
 #include <limits.h>
+#include <sstream>
 
 namespace ral {
 namespace parser {
@@ -335,6 +340,205 @@ cudf::data_type type_from_type_token(const lexer::token & token) {
   RAL_FAIL("Invalid literal cast type");
 }
 
+namespace {
+
+bool is_null_literal(const node & n) {
+  return n.type == node_type::LITERAL && is_null(n.value);
+}
+
+bool is_boolean_literal(const node & n, bool value) {
+  return n.type == node_type::LITERAL && static_cast<const literal_node &>(n).type().id() == cudf::type_id::BOOL8
+    && n.value == (value ? "true" : "false");
+}
+
+// The literals of the types the interpreter computes as int64 or double, and whose value it reads the same way
+bool is_number_literal(const node & n) {
+  if (n.type != node_type::LITERAL || is_null(n.value)) {
+    return false;
+  }
+  cudf::type_id type = static_cast<const literal_node &>(n).type().id();
+  if (type == cudf::type_id::FLOAT32 || type == cudf::type_id::FLOAT64) {
+    return true;
+  }
+  if (type != cudf::type_id::INT8 && type != cudf::type_id::INT16 && type != cudf::type_id::INT32 && type != cudf::type_id::INT64) {
+    return false;
+  }
+  size_t first_digit = (!n.value.empty() && n.value[0] == '-') ? 1 : 0;
+  return n.value.size() > first_digit && n.value.size() - first_digit < 19
+    && std::all_of(n.value.begin() + first_digit, n.value.end(), [](char c) { return std::isdigit(c); });
+}
+
+bool is_float_literal(const literal_node & literal) {
+  return literal.type().id() == cudf::type_id::FLOAT32 || literal.type().id() == cudf::type_id::FLOAT64;
+}
+
+double literal_as_double(const literal_node & literal) {
+  return literal.type().id() == cudf::type_id::FLOAT32 ? static_cast<double>(std::stof(literal.value)) : std::stod(literal.value);
+}
+
+node * make_boolean_literal(bool value) {
+  return new literal_node(value ? "true" : "false", cudf::data_type{cudf::type_id::BOOL8});
+}
+
+node * make_null_boolean_literal() {
+  return new literal_node("null", cudf::data_type{cudf::type_id::BOOL8});
+}
+
+// The interpreter computes the integers as int64 and then casts them to the type of the output
+int64_t cast_to_integer_type(int64_t value, cudf::type_id type) {
+  switch (type) {
+    case cudf::type_id::INT8: return static_cast<int8_t>(value);
+    case cudf::type_id::INT16: return static_cast<int16_t>(value);
+    case cudf::type_id::INT32: return static_cast<int32_t>(value);
+    default: return value;
+  }
+}
+
+std::string float_to_string(double value, cudf::type_id type) {
+  std::ostringstream out;
+  if (type == cudf::type_id::FLOAT32) {
+    out << std::setprecision(std::numeric_limits<float>::max_digits10) << static_cast<float>(value);
+  } else {
+    out << std::setprecision(std::numeric_limits<double>::max_digits10) << value;
+  }
+  return out.str();
+}
+
+} // namespace
+
+node * constant_folding_transformer::transform(operator_node& node) {
+  if (node.value == "AND" || node.value == "OR") {
+    return fold_logical_op(node, node.value == "AND");
+  } else if (node.value == "+" || node.value == "-" || node.value == "*" || node.value == "/") {
+    return fold_arithmetic_op(node);
+  } else if (node.value == "=" || node.value == "<>" || node.value == "<" || node.value == "<=" || node.value == ">" || node.value == ">=") {
+    return fold_comparison_op(node);
+  } else if (node.children.size() == 1 && node.children[0]->type == node_type::LITERAL) {
+    const auto & operand = *node.children[0];
+    if (node.value == "IS_NULL" || node.value == "IS_NOT_NULL") {
+      return make_boolean_literal(is_null_literal(operand) == (node.value == "IS_NULL"));
+    } else if (node.value == "NOT") {
+      if (is_null_literal(operand)) {
+        return make_null_boolean_literal();
+      } else if (is_boolean_literal(operand, true) || is_boolean_literal(operand, false)) {
+        return make_boolean_literal(!is_boolean_literal(operand, true));
+      }
+    }
+  }
+
+  return &node;
+}
+
+node * constant_folding_transformer::fold_logical_op(operator_node& op_node, bool is_and) {
+  // false decides an AND and true an OR, even if the other operands are null, and the other value does not change them
+  std::vector<std::unique_ptr<node>> kept_children;
+  for (auto && child : op_node.children) {
+    if (is_boolean_literal(*child, !is_and)) {
+      return make_boolean_literal(!is_and);
+    }
+    if (!is_boolean_literal(*child, is_and)) {
+      kept_children.push_back(std::move(child));
+    }
+  }
+
+  if (kept_children.empty()) {
+    return make_boolean_literal(is_and);
+  } else if (kept_children.size() == 1) {
+    if (is_null_literal(*kept_children[0])) {
+      return make_null_boolean_literal();
+    }
+    return kept_children[0].release();
+  }
+
+  op_node.children = std::move(kept_children);
+  return &op_node;
+}
+
+node * constant_folding_transformer::fold_arithmetic_op(operator_node& op_node) {
+  if (op_node.children.size() != 2 || !is_number_literal(*op_node.children[0]) || !is_number_literal(*op_node.children[1])) {
+    return &op_node;
+  }
+
+  const auto & left = static_cast<const literal_node &>(*op_node.children[0]);
+  const auto & right = static_cast<const literal_node &>(*op_node.children[1]);
+  operator_type op = map_to_operator_type(op_node.value);
+  cudf::type_id out_type = get_output_type(op, left.type().id(), right.type().id());
+
+  if (out_type == cudf::type_id::FLOAT32 || out_type == cudf::type_id::FLOAT64) {
+    double left_value = literal_as_double(left);
+    double right_value = literal_as_double(right);
+    double result;
+    if (op == operator_type::BLZ_ADD) {
+      result = left_value + right_value;
+    } else if (op == operator_type::BLZ_SUB) {
+      result = left_value - right_value;
+    } else if (op == operator_type::BLZ_MUL) {
+      result = left_value * right_value;
+    } else {
+      if (right_value == 0) {
+        return &op_node;
+      }
+      result = left_value / right_value;
+    }
+    if (!std::isfinite(result)) {
+      return &op_node;
+    }
+    return new literal_node(float_to_string(result, out_type), cudf::data_type{out_type});
+  }
+
+  int64_t left_value = std::stoll(left.value);
+  int64_t right_value = std::stoll(right.value);
+  int64_t result;
+  bool overflow = false;
+  if (op == operator_type::BLZ_ADD) {
+    overflow = __builtin_add_overflow(left_value, right_value, &result);
+  } else if (op == operator_type::BLZ_SUB) {
+    overflow = __builtin_sub_overflow(left_value, right_value, &result);
+  } else if (op == operator_type::BLZ_MUL) {
+    overflow = __builtin_mul_overflow(left_value, right_value, &result);
+  } else {
+    if (right_value == 0) {
+      return &op_node;
+    }
+    result = left_value / right_value;
+  }
+  if (overflow) {
+    return &op_node;
+  }
+  return new literal_node(std::to_string(cast_to_integer_type(result, out_type)), cudf::data_type{out_type});
+}
+
+node * constant_folding_transformer::fold_comparison_op(operator_node& op_node) {
+  if (op_node.children.size() != 2) {
+    return &op_node;
+  }
+  // a comparison with a null is null whatever the other operand is
+  if (is_null_literal(*op_node.children[0]) || is_null_literal(*op_node.children[1])) {
+    return make_null_boolean_literal();
+  }
+  if (!is_number_literal(*op_node.children[0]) || !is_number_literal(*op_node.children[1])) {
+    return &op_node;
+  }
+
+  const auto & left = static_cast<const literal_node &>(*op_node.children[0]);
+  const auto & right = static_cast<const literal_node &>(*op_node.children[1]);
+  int comparison;
+  if (is_float_literal(left) || is_float_literal(right)) {
+    double left_value = literal_as_double(left);
+    double right_value = literal_as_double(right);
+    comparison = left_value < right_value ? -1 : (left_value > right_value ? 1 : 0);
+  } else {
+    int64_t left_value = std::stoll(left.value);
+    int64_t right_value = std::stoll(right.value);
+    comparison = left_value < right_value ? -1 : (left_value > right_value ? 1 : 0);
+  }
+
+  const std::string & op = op_node.value;
+  bool result = (op == "=" && comparison == 0) || (op == "<>" && comparison != 0) || (op == "<" && comparison < 0)
+    || (op == "<=" && comparison <= 0) || (op == ">" && comparison > 0) || (op == ">=" && comparison >= 0);
+  return make_boolean_literal(result);
+}
+
 } // namespace detail
 } // namespace parser
 } // namespace ral
@@ -257,6 +257,26 @@ private:
     }
 };
 
+/**
+ * @brief Replaces the subtrees that only have literals with the literal they evaluate to, so that they are computed once
+ * on the host instead of for every row in the GPU, and drops the operands of AND and OR that can't change their result,
+ * like the true of AND(true, $0). It only folds the operators whose result on the host is the one the interpreter would
+ * get: the arithmetic and the comparisons of numbers, NOT, AND, OR, IS_NULL and IS_NOT_NULL.
+ */
+struct constant_folding_transformer : public node_transformer {
+public:
+    node * transform(operad_node& node) override { return &node; }
+
+    node * transform(operator_node& node) override;
+
+private:
+    node * fold_logical_op(operator_node& op_node, bool is_and);
+
+    node * fold_arithmetic_op(operator_node& op_node);
+
+    node * fold_comparison_op(operator_node& op_node);
+};
+
 class lexer
 {
 public:
@@ -355,6 +375,7 @@ private:
 
 public:
     parse_tree() = default;
+    explicit parse_tree(std::unique_ptr<node> root) : root_{std::move(root)} { }
     ~parse_tree() = default;
 
     parse_tree(const parse_tree & other) = delete;
@@ -363,7 +384,7 @@ public:
     parse_tree(parse_tree&& other) : root_{std::move(other.root_)} { }
     parse_tree& operator=(parse_tree&& other) = delete;
 
-    const node & root() {
+    const node & root() const {
         assert(!!this->root_);
         return *(this->root_);
     }
@@ -399,6 +420,12 @@ public:
         transform(t);
     }
 
+    void fold_constants() {
+        assert(!!this->root_);
+        detail::constant_folding_transformer t;
+        transform(t);
+    }
+
     std::string rebuildExpression() {
         assert(!!this->root_);
         return detail::rebuild_helper(this->root_.get());
@@ -1,10 +1,13 @@
 #include <map>
 #include <regex>
 #include <cassert>
+#include <algorithm>
+#include <cctype>
 #include <blazingdb/io/Util/StringUtil.h>
 
 #include "expression_utils.hpp"
 #include "parser/CalciteExpressionParsing.h"
+#include "parser/expression_tree.hpp"
 #include "utilities/error.hpp"
 
 bool is_nullary_operator(operator_type op){
@@ -561,8 +564,65 @@ std::vector<int> get_projections(const std::string & query_part) {
 	return projections;
 }
 
+namespace {
+
+/**
+* Calls a function for every input column reference ($0, $1, ...) of an expression, with its position, length and index.
+* References are only recognized outside string literals and when they are not part of a name, like the alias EXPR$0.
+*/
+template <typename Function>
+void for_each_column_reference(const std::string & expression, Function function) {
+	bool in_string = false;
+	for(size_t i = 0; i < expression.size(); i++) {
+		char c = expression[i];
+		if(c == '\'') {
+			in_string = !in_string;
+		} else if(!in_string && c == '$' && i + 1 < expression.size() && std::isdigit(expression[i + 1]) &&
+			(i == 0 || !(std::isalnum(expression[i - 1]) || expression[i - 1] == '_'))) {
+			size_t end = i + 1;
+			while(end < expression.size() && std::isdigit(expression[end])) {
+				end++;
+			}
+			function(i, end - i, std::stoi(expression.substr(i + 1, end - i - 1)));
+			i = end - 1;
+		}
+	}
+}
+
+}  // namespace
+
+std::vector<int> get_referenced_column_indices(const std::string & expression) {
+	std::vector<int> column_indices;
+	for_each_column_reference(expression, [&column_indices](size_t /*position*/, size_t /*length*/, int column_index) {
+		column_indices.push_back(column_index);
+	});
+	std::sort(column_indices.begin(), column_indices.end());
+	column_indices.erase(std::unique(column_indices.begin(), column_indices.end()), column_indices.end());
+	return column_indices;
+}
+
+std::string renumber_column_indices(const std::string & expression, const std::vector<int> & new_column_indices) {
+	std::string renumbered;
+	size_t last_position = 0;
+	for_each_column_reference(expression, [&](size_t position, size_t length, int column_index) {
+		renumbered += expression.substr(last_position, position - last_position);
+		renumbered += "$" + std::to_string(new_column_indices.at(column_index));
+		last_position = position + length;
+	});
+	renumbered += expression.substr(last_position);
+	return renumbered;
+}
+
 bool is_union(std::string query_part) { return (query_part.find(LOGICAL_UNION_TEXT) != std::string::npos); }
 
+bool is_intersect(std::string query_part) { return (query_part.find(LOGICAL_INTERSECT_TEXT) != std::string::npos); }
+
+bool is_minus(std::string query_part) { return (query_part.find(LOGICAL_MINUS_TEXT) != std::string::npos); }
+
+bool is_set_operation(std::string query_part) {
+	return is_intersect(query_part) || is_minus(query_part) || (is_union(query_part) && get_named_expression(query_part, "all") == "false");
+}
+
 bool is_project(std::string query_part) { return (query_part.find(LOGICAL_PROJECT_TEXT) != std::string::npos); }
 
 bool is_logical_scan(std::string query_part) { return (query_part.find(LOGICAL_SCAN_TEXT) != std::string::npos); }
@@ -579,6 +639,8 @@ bool is_filter(std::string query_part) { return (query_part.find(LOGICAL_FILTER_
 
 bool is_limit(std::string query_part) { return (query_part.find(LOGICAL_LIMIT_TEXT) != std::string::npos); }
 
+bool is_top_k(std::string query_part) { return (query_part.find(LOGICAL_TOP_K_TEXT) != std::string::npos); }
+
 bool is_sort(std::string query_part) { return (query_part.find(LOGICAL_SORT_TEXT) != std::string::npos); }
 
 bool is_merge(std::string query_part) { return (query_part.find(LOGICAL_MERGE_TEXT) != std::string::npos); }
@@ -595,6 +657,10 @@ bool is_pairwise_join(const std::string & query) { return (query.find(LOGICAL_PA
 
 bool is_join_partition(const std::string & query) { return (query.find(LOGICAL_JOIN_PARTITION_TEXT) != std::string::npos); }
 
+bool is_sort_merge_join(const std::string & query) { return (query.find(LOGICAL_SORT_MERGE_JOIN_TEXT) != std::string::npos); }
+
+bool is_star_join(const std::string & query) { return (query.find(LOGICAL_STAR_JOIN_TEXT) != std::string::npos); }
+
 bool is_aggregate(std::string query_part) { return (query_part.find(LOGICAL_AGGREGATE_TEXT) != std::string::npos); }
 
 bool is_compute_aggregate(std::string query_part) { return (query_part.find(LOGICAL_COMPUTE_AGGREGATE_TEXT) != std::string::npos); }
@@ -603,6 +669,10 @@ bool is_distribute_aggregate(std::string query_part) { return (query_part.find(L
 
 bool is_merge_aggregate(std::string query_part) { return (query_part.find(LOGICAL_MERGE_AGGREGATE_TEXT) != std::string::npos); }
 
+bool is_grouping_sets(std::string query_part) { return (query_part.find(LOGICAL_GROUPING_SETS_TEXT) != std::string::npos); }
+
+bool is_table_sample(std::string query_part) { return (query_part.find(LOGICAL_TABLE_SAMPLE_TEXT) != std::string::npos); }
+
 bool is_window_function(std::string query_part) { return (query_part.find("OVER") != std::string::npos); }
 
 bool is_generate_overlaps(std::string query_part) { return (query_part.find(LOGICAL_GENERATE_OVERLAPS_TEXT) != std::string::npos); }
@@ -611,6 +681,12 @@ bool is_accumulate_overlaps(std::string query_part) { return (query_part.find(LO
 
 bool is_window_compute(std::string query_part) { return (query_part.find(LOGICAL_COMPUTE_WINDOW_TEXT) != std::string::npos); }
 
+bool is_materialize(std::string query_part) { return (query_part.find(LOGICAL_MATERIALIZE_TEXT) != std::string::npos); }
+
+bool is_materialized_result_scan(std::string query_part) { return (query_part.find(LOGICAL_MATERIALIZED_RESULT_SCAN_TEXT) != std::string::npos); }
+
+bool is_spool(std::string query_part) { return (query_part.find(LOGICAL_SPOOL_TEXT) != std::string::npos); }
+
 bool window_expression_contains_partition_by(std::string query_part) { return (query_part.find("PARTITION") != std::string::npos); }
 
 bool window_expression_contains_order_by(std::string query_part) { return (query_part.find("ORDER BY") != std::string::npos); }
@@ -619,6 +695,56 @@ bool window_expression_contains_bounds(std::string query_part) { return (query_p
 
 bool window_expression_contains_bounds_by_range(std::string query_part) { return (query_part.find("RANGE") != std::string::npos); }
 
+// A window with PARTITION BY that is bounded by ROWS on both sides only needs the rows of its frame, which are given to
+// the batches as the overlaps of their neighbours, so its partitions can be range split by the order columns too.
+// The aggregations that need the whole partition can't split it.
+bool window_expression_can_split_partitions(const std::string & query_part) {
+	if (!window_expression_contains_partition_by(query_part) || !window_expression_contains_order_by(query_part) ||
+		!window_expression_contains_bounds(query_part) || window_expression_contains_bounds_by_range(query_part)) {
+		return false;
+	}
+
+	int preceding_value, following_value;
+	std::tie(preceding_value, following_value) = get_bounds_from_window_expression(query_part);
+	if (preceding_value <= 0 || following_value <= 0) {
+		return false;
+	}
+
+	std::vector<std::string> type_aggs_as_str;
+	std::tie(std::ignore, type_aggs_as_str, std::ignore) = get_cols_to_apply_window_and_cols_to_apply_agg(query_part);
+	for (const std::string & agg : type_aggs_as_str) {
+		if (is_lag_or_lead_aggregation(agg) || is_first_value_window(agg) || is_last_value_window(agg) || agg == "ROW_NUMBER") {
+			return false;
+		}
+	}
+	return true;
+}
+
+// A cumulative window, from the start of the partition up to every row, of aggregations that are combined by adding
+// them or by taking their minimum or maximum, only needs the aggregations of the rows of its partition that were in
+// the batches before, so a partition does not need to be in one batch.
+bool window_expression_can_carry_partitions(const std::string & query_part) {
+	if (!window_expression_contains_partition_by(query_part) || !window_expression_contains_order_by(query_part) ||
+		window_expression_contains_bounds_by_range(query_part)) {
+		return false;
+	}
+
+	int preceding_value, following_value;
+	std::tie(preceding_value, following_value) = get_bounds_from_window_expression(query_part);
+	if (preceding_value != -1 || following_value != 0) {
+		return false;
+	}
+
+	std::vector<std::string> type_aggs_as_str;
+	std::tie(std::ignore, type_aggs_as_str, std::ignore) = get_cols_to_apply_window_and_cols_to_apply_agg(query_part);
+	for (const std::string & agg : type_aggs_as_str) {
+		if (agg != "MIN" && agg != "MAX" && agg != "COUNT" && agg != "$SUM0" && agg != "ROW_NUMBER") {
+			return false;
+		}
+	}
+	return true;
+}
+
 bool is_lag_or_lead_aggregation(std::string expression) {
 	return (expression == "LAG" || expression == "LEAD");
 }
@@ -1046,9 +1172,190 @@ std::vector<std::string> get_expressions_from_expression_list(std::string & comb
 	return expressions;
 }
 
+namespace {
+
+// the column and the literal of =($i, literal) or =(literal, $i)
+bool get_equality_literal(const ral::parser::node & node, int & column, std::string & literal) {
+	if (node.type != ral::parser::node_type::OPERATOR || node.value != "=" || node.children.size() != 2) {
+		return false;
+	}
+	const ral::parser::node * variable = node.children[0].get();
+	const ral::parser::node * value = node.children[1].get();
+	if (variable->type != ral::parser::node_type::VARIABLE) {
+		std::swap(variable, value);
+	}
+	if (variable->type != ral::parser::node_type::VARIABLE || value->type != ral::parser::node_type::LITERAL || value->value == "null") {
+		return false;
+	}
+	column = static_cast<const ral::parser::variable_node *>(variable)->index();
+	literal = value->value;
+	return true;
+}
+
+// the literals of an OR of equalities of the same column, which can be nested ORs
+bool get_or_equality_literals(const ral::parser::node & node, int & column, std::vector<std::string> & literals) {
+	int equality_column;
+	std::string literal;
+	if (get_equality_literal(node, equality_column, literal)) {
+		if (column >= 0 && equality_column != column) {
+			return false;
+		}
+		column = equality_column;
+		literals.push_back(literal);
+		return true;
+	}
+	if (node.value != "OR" || node.children.empty()) {
+		return false;
+	}
+	for (auto & child : node.children) {
+		if (!get_or_equality_literals(*child, column, literals)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void add_equality_literals(const ral::parser::node & node, std::map<int, std::vector<std::string>> & literals) {
+	if (node.value == "AND") {
+		for (auto & child : node.children) {
+			add_equality_literals(*child, literals);
+		}
+		return;
+	}
+	int column = -1;
+	std::vector<std::string> values;
+	if (get_or_equality_literals(node, column, values)) {
+		literals.emplace(column, values);
+	}
+}
+
+// the literals of =($i, literal), or of an OR of them, as ranges of one value
+bool get_or_equality_ranges(const ral::parser::node & node, int & column, std::vector<literal_range> & ranges) {
+	int equality_column;
+	std::string literal;
+	if (get_equality_literal(node, equality_column, literal)) {
+		if (column >= 0 && equality_column != column) {
+			return false;
+		}
+		const ral::parser::node * value = node.children[0]->type == ral::parser::node_type::LITERAL ?
+			node.children[0].get() : node.children[1].get();
+		column = equality_column;
+		literal_range range;
+		range.has_lower = range.has_upper = true;
+		range.lower = range.upper = literal;
+		range.type = static_cast<const ral::parser::literal_node *>(value)->type();
+		ranges.push_back(range);
+		return true;
+	}
+	if (node.value != "OR" || node.children.empty()) {
+		return false;
+	}
+	for (auto & child : node.children) {
+		if (!get_or_equality_ranges(*child, column, ranges)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// the bound of >($i, literal), <=(literal, $i) and the like on a range of the column
+bool add_comparison_bound(const ral::parser::node & node, std::map<int, literal_range> & bounds) {
+	static const std::map<std::string, std::string> swapped_operators = {{">", "<"}, {">=", "<="}, {"<", ">"}, {"<=", ">="}};
+	if (node.type != ral::parser::node_type::OPERATOR || node.children.size() != 2 || swapped_operators.count(node.value) == 0) {
+		return false;
+	}
+	std::string op = node.value;
+	const ral::parser::node * variable = node.children[0].get();
+	const ral::parser::node * value = node.children[1].get();
+	if (variable->type != ral::parser::node_type::VARIABLE) {
+		std::swap(variable, value);
+		op = swapped_operators.at(op);
+	}
+	if (variable->type != ral::parser::node_type::VARIABLE || value->type != ral::parser::node_type::LITERAL || value->value == "null") {
+		return false;
+	}
+	int column = static_cast<const ral::parser::variable_node *>(variable)->index();
+	cudf::data_type type = static_cast<const ral::parser::literal_node *>(value)->type();
+	auto it = bounds.find(column);
+	if (it != bounds.end() && it->second.type != type) {
+		return false;
+	}
+	literal_range & range = bounds[column];
+	range.type = type;
+	// when a column has several bounds on the same side the first one is kept, since the literals are not compared here
+	if ((op == ">" || op == ">=") && !range.has_lower) {
+		range.has_lower = true;
+		range.lower = value->value;
+		range.lower_inclusive = op == ">=";
+	} else if ((op == "<" || op == "<=") && !range.has_upper) {
+		range.has_upper = true;
+		range.upper = value->value;
+		range.upper_inclusive = op == "<=";
+	}
+	return true;
+}
+
+void add_literal_ranges(const ral::parser::node & node, std::map<int, std::vector<literal_range>> & ranges,
+	std::map<int, literal_range> & bounds) {
+	if (node.value == "AND") {
+		for (auto & child : node.children) {
+			add_literal_ranges(*child, ranges, bounds);
+		}
+		return;
+	}
+	int column = -1;
+	std::vector<literal_range> values;
+	if (get_or_equality_ranges(node, column, values)) {
+		ranges.emplace(column, values);
+		return;
+	}
+	add_comparison_bound(node, bounds);
+}
+
+} // namespace
+
+std::map<int, std::vector<literal_range>> get_literal_ranges(const std::string & condition) {
+	std::map<int, std::vector<literal_range>> ranges;
+	if (condition.empty()) {
+		return ranges;
+	}
+	try {
+		ral::parser::parse_tree tree;
+		tree.build(replace_calcite_regex(condition));
+		std::map<int, literal_range> bounds;
+		add_literal_ranges(tree.root(), ranges, bounds);
+		// the equalities of a column are narrower than its comparisons
+		for (auto & bound : bounds) {
+			ranges.emplace(bound.first, std::vector<literal_range>{bound.second});
+		}
+	} catch (const std::exception &) {
+		ranges.clear(); // they are only used to read less rows, the filter itself reports what is wrong with it
+	}
+	return ranges;
+}
+
+std::map<int, std::vector<std::string>> get_equality_literals(const std::string & condition) {
+	std::map<int, std::vector<std::string>> literals;
+	if (condition.empty()) {
+		return literals;
+	}
+	try {
+		ral::parser::parse_tree tree;
+		tree.build(replace_calcite_regex(condition));
+		add_equality_literals(tree.root(), literals);
+	} catch (const std::exception &) {
+		literals.clear(); // they are only used to skip data, the filter itself reports what is wrong with it
+	}
+	return literals;
+}
+
 std::string replace_calcite_regex(const std::string & expression) {
 	std::string ret = expression;
 
+	// the approximate distinct counts that were not made into APPROX_COUNT_DISTINCT by the planner
+	static const std::regex approx_count_re{R""(COUNT\(APPROXIMATE DISTINCT (\W\(.+?\)|.+)\))"", std::regex_constants::icase};
+	ret = std::regex_replace(ret, approx_count_re, "APPROX_COUNT_DISTINCT($1)");
+
 	static const std::regex count_re{R""(COUNT\(DISTINCT (\W\(.+?\)|.+)\))"", std::regex_constants::icase};
 	ret = std::regex_replace(ret, count_re, "COUNT_DISTINCT($1)");
 
@@ -135,18 +135,37 @@ std::string get_named_expression(const std::string & query_part, const std::stri
 
 std::vector<int> get_projections(const std::string & query_part);
 
+/**
+* Gets the indices of the input columns ($0, $1, ...) referenced by an expression, sorted and without repetitions.
+* Text inside string literals is ignored.
+*/
+std::vector<int> get_referenced_column_indices(const std::string & expression);
+
+/**
+* Renumbers the input columns ($0, $1, ...) referenced by an expression.
+* @param expression the expression to renumber.
+* @param new_column_indices the new index of every input column, indexed by its current index.
+*/
+std::string renumber_column_indices(const std::string & expression, const std::vector<int> & new_column_indices);
+
 const std::string LOGICAL_JOIN_TEXT = "LogicalJoin";
 const std::string LOGICAL_PARTWISE_JOIN_TEXT = "PartwiseJoin";
 const std::string LOGICAL_JOIN_PARTITION_TEXT = "JoinPartition";
+const std::string LOGICAL_SORT_MERGE_JOIN_TEXT = "SortMergeJoin";
+const std::string LOGICAL_STAR_JOIN_TEXT = "StarJoin";
 const std::string LOGICAL_UNION_TEXT = "LogicalUnion";
+const std::string LOGICAL_INTERSECT_TEXT = "LogicalIntersect";
+const std::string LOGICAL_MINUS_TEXT = "LogicalMinus";
 const std::string LOGICAL_SCAN_TEXT = "LogicalTableScan";
 const std::string BINDABLE_SCAN_TEXT = "BindableTableScan";
 const std::string LOGICAL_AGGREGATE_TEXT = "LogicalAggregate";  // this is the base Aggregate that gets replaced
 const std::string LOGICAL_COMPUTE_AGGREGATE_TEXT = "ComputeAggregate";
 const std::string LOGICAL_DISTRIBUTE_AGGREGATE_TEXT = "DistributeAggregate";
 const std::string LOGICAL_MERGE_AGGREGATE_TEXT = "MergeAggregate";
+const std::string LOGICAL_GROUPING_SETS_TEXT = "LogicalGroupingSets";
 const std::string LOGICAL_PROJECT_TEXT = "LogicalProject";
 const std::string LOGICAL_LIMIT_TEXT = "LogicalLimit";
+const std::string LOGICAL_TOP_K_TEXT = "LogicalTopK";
 const std::string LOGICAL_SORT_TEXT = "LogicalSort";
 const std::string LOGICAL_MERGE_TEXT = "LogicalMerge";
 const std::string LOGICAL_PARTITION_TEXT = "LogicalPartition";
@@ -156,11 +175,19 @@ const std::string LOGICAL_FILTER_TEXT = "LogicalFilter";
 const std::string LOGICAL_GENERATE_OVERLAPS_TEXT = "LogicalGenerateOverlaps";
 const std::string LOGICAL_ACCUMULATE_OVERLAPS_TEXT = "LogicalAccumulateOverlaps";
 const std::string LOGICAL_COMPUTE_WINDOW_TEXT = "LogicalComputeWindow";
+const std::string LOGICAL_MATERIALIZE_TEXT = "LogicalMaterialize";
+const std::string LOGICAL_MATERIALIZED_RESULT_SCAN_TEXT = "MaterializedResultScan";
+const std::string LOGICAL_SPOOL_TEXT = "LogicalSpool";
+const std::string LOGICAL_TABLE_SAMPLE_TEXT = "Sample(mode=";  // the Sample of a TABLESAMPLE, not a Logical_SortAndSample
 const std::string ASCENDING_ORDER_SORT_TEXT = "ASC";
 const std::string DESCENDING_ORDER_SORT_TEXT = "DESC";
 
 
 bool is_union(std::string query_part);
+bool is_intersect(std::string query_part);
+bool is_minus(std::string query_part);
+// UNION, INTERSECT and EXCEPT that keep every row once, see SetOperationKernel
+bool is_set_operation(std::string query_part);
 bool is_project(std::string query_part);
 bool is_logical_scan(std::string query_part);
 bool is_bindable_scan(std::string query_part);
@@ -168,6 +195,7 @@ bool is_filtered_bindable_scan(std::string query_part);
 bool is_scan(std::string query_part);
 bool is_filter(std::string query_part);
 bool is_limit(std::string query_part);
+bool is_top_k(std::string query_part);
 bool is_sort(std::string query_part);
 bool is_merge(std::string query_part);
 bool is_partition(std::string query_part);
@@ -176,10 +204,14 @@ bool is_single_node_partition(std::string query_part);
 bool is_join(const std::string & query);
 bool is_pairwise_join(const std::string & query);
 bool is_join_partition(const std::string & query);
+bool is_sort_merge_join(const std::string & query);
+bool is_star_join(const std::string & query);
 bool is_aggregate(std::string query_part); // this is the base Aggregate that gets replaced
 bool is_compute_aggregate(std::string query_part);
 bool is_distribute_aggregate(std::string query_part);
 bool is_merge_aggregate(std::string query_part);
+bool is_grouping_sets(std::string query_part);
+bool is_table_sample(std::string query_part);
 bool is_aggregate_merge(std::string query_part); // to be deprecated
 bool is_aggregate_partition(std::string query_part); // to be deprecated
 bool is_aggregate_and_sample(std::string query_part); // to be deprecated
@@ -187,6 +219,9 @@ bool is_window_function(std::string query_part);
 bool is_generate_overlaps(std::string query_part);
 bool is_accumulate_overlaps(std::string query_part);
 bool is_window_compute(std::string query_part);
+bool is_materialize(std::string query_part);
+bool is_materialized_result_scan(std::string query_part);
+bool is_spool(std::string query_part);
 
 bool window_expression_contains_partition_by(std::string query_part);
 
@@ -196,6 +231,12 @@ bool window_expression_contains_bounds(std::string query_part);
 
 bool window_expression_contains_bounds_by_range(std::string query_part);
 
+// Returns true when the partitions of a window can be split across batches and nodes, see OverlapGeneratorKernel
+bool window_expression_can_split_partitions(const std::string & query_part);
+
+// Returns true when the aggregations of a partition can be carried from one batch to the next, see ComputeWindowKernel
+bool window_expression_can_carry_partitions(const std::string & query_part);
+
 bool is_lag_or_lead_aggregation(std::string expression);
 
 bool is_first_value_window(std::string expression);
@@ -241,6 +282,28 @@ std::vector<std::string> get_expressions_from_expression_list(std::string & comb
 
 std::string replace_calcite_regex(const std::string & expression);
 
+// Returns the literals that a column is compared with by the equalities (or the ORs of equalities, like the IN lists)
+// that every row that passes a filter condition satisfies, by the index of the column.
+// For example AND(=($0, 5), OR(=($1, 'a'), =($1, 'b')), >($2, 3)) gives {0: [5], 1: ['a', 'b']}
+std::map<int, std::vector<std::string>> get_equality_literals(const std::string & condition);
+
+// A range of the values of a column that is bounded by literals. A side without a bound is open.
+struct literal_range {
+	bool has_lower = false;
+	std::string lower;
+	bool lower_inclusive = true;
+	bool has_upper = false;
+	std::string upper;
+	bool upper_inclusive = true;
+	cudf::data_type type; // the type of the literals
+};
+
+// Returns the ranges of values that a column has in every row that passes a filter condition, by the index of the
+// column. The equalities (or the ORs of equalities, like the IN lists) give a range for every literal, and the
+// comparisons with literals give one range. The rows in the ranges can still not pass the rest of the condition.
+// For example AND(>=($0, 5), <($0, 10), OR(=($1, 'a'), =($1, 'b'))) gives {0: [[5, 10)], 1: [['a', 'a'], ['b', 'b']]}
+std::map<int, std::vector<literal_range>> get_literal_ranges(const std::string & condition);
+
 //Returns the column names according to the corresponding algebra expression
 std::vector<std::string> fix_column_aliases(const std::vector<std::string> & column_names, std::string expression);
 
@@ -0,0 +1,153 @@
+#include "CalcitePlanner.h"
+
+#include <cstdlib>
+#include <stdexcept>
+
+namespace ral {
+namespace server {
+
+namespace {
+
+const char * planner_class_name = "com/blazingdb/calcite/application/ServerPlanner";
+
+std::string to_string(JNIEnv * env, jstring value) {
+	if (value == nullptr) {
+		return "";
+	}
+	const char * chars = env->GetStringUTFChars(value, nullptr);
+	std::string result(chars);
+	env->ReleaseStringUTFChars(value, chars);
+	return result;
+}
+
+}  // namespace
+
+std::string get_default_class_path() {
+	const char * conda_prefix = std::getenv("CONDA_PREFIX");
+	std::string lib_dir = conda_prefix != nullptr ? std::string(conda_prefix) + "/lib/" : "";
+	return lib_dir + "blazingsql-algebra.jar:" + lib_dir + "blazingsql-algebra-core.jar";
+}
+
+calcite_planner::calcite_planner(const std::string & class_path) {
+	std::string class_path_option = "-Djava.class.path=" + class_path;
+	// -Xrs leaves SIGINT and SIGTERM to the server, so that it can shut down
+	JavaVMOption options[3];
+	options[0].optionString = const_cast<char *>(class_path_option.c_str());
+	options[1].optionString = const_cast<char *>("-ea");
+	options[2].optionString = const_cast<char *>("-Xrs");
+
+	JavaVMInitArgs vm_args;
+	vm_args.version = JNI_VERSION_1_8;
+	vm_args.nOptions = 3;
+	vm_args.options = options;
+	vm_args.ignoreUnrecognized = JNI_FALSE;
+
+	JNIEnv * env = nullptr;
+	if (JNI_CreateJavaVM(&jvm, reinterpret_cast<void **>(&env), &vm_args) != JNI_OK) {
+		throw std::runtime_error("ERROR: could not start the JVM of the planner with the class path " + class_path);
+	}
+
+	jclass planner_class = env->FindClass(planner_class_name);
+	check_exception(env, "ERROR: could not find the planner class in the class path " + class_path);
+	jmethodID constructor = env->GetMethodID(planner_class, "<init>", "()V");
+	add_table_method = env->GetMethodID(planner_class, "addTable", "(Ljava/lang/String;[Ljava/lang/String;[II)V");
+	get_plan_method = env->GetMethodID(planner_class, "getPlan", "(Ljava/lang/String;)Ljava/lang/String;");
+	check_exception(env, "ERROR: the planner class of the class path " + class_path + " does not match this server");
+
+	jobject local_planner = env->NewObject(planner_class, constructor);
+	check_exception(env, "ERROR: could not create the planner");
+	planner = env->NewGlobalRef(local_planner);
+	env->DeleteLocalRef(local_planner);
+	env->DeleteLocalRef(planner_class);
+}
+
+calcite_planner::~calcite_planner() {
+	// the JVM is not destroyed, a process can not create another one anyway
+	if (planner != nullptr) {
+		get_env()->DeleteGlobalRef(planner);
+	}
+}
+
+JNIEnv * calcite_planner::get_env() {
+	JNIEnv * env = nullptr;
+	jint status = jvm->GetEnv(reinterpret_cast<void **>(&env), JNI_VERSION_1_8);
+	if (status == JNI_EDETACHED) {
+		// as a daemon, so that the threads of the server that planned a query do not keep the JVM from exiting
+		status = jvm->AttachCurrentThreadAsDaemon(reinterpret_cast<void **>(&env), nullptr);
+	}
+	if (status != JNI_OK) {
+		throw std::runtime_error("ERROR: could not attach the thread to the JVM of the planner");
+	}
+	return env;
+}
+
+void calcite_planner::check_exception(JNIEnv * env, const std::string & context) {
+	jthrowable exception = env->ExceptionOccurred();
+	if (exception == nullptr) {
+		return;
+	}
+	env->ExceptionClear();
+
+	jclass throwable_class = env->FindClass("java/lang/Throwable");
+	jmethodID get_message = env->GetMethodID(throwable_class, "getMessage", "()Ljava/lang/String;");
+	jmethodID to_string_method = env->GetMethodID(throwable_class, "toString", "()Ljava/lang/String;");
+	jstring message = static_cast<jstring>(env->CallObjectMethod(exception, get_message));
+	if (message == nullptr) {
+		message = static_cast<jstring>(env->CallObjectMethod(exception, to_string_method));
+	}
+	std::string text = to_string(env, message);
+	env->DeleteLocalRef(message);
+	env->DeleteLocalRef(throwable_class);
+	env->DeleteLocalRef(exception);
+	throw std::runtime_error(context + ": " + text);
+}
+
+void calcite_planner::add_table(const std::string & name,
+	const std::vector<std::string> & column_names,
+	const std::vector<cudf::type_id> & types,
+	std::size_t row_count) {
+	JNIEnv * env = get_env();
+
+	jclass string_class = env->FindClass("java/lang/String");
+	jobjectArray java_column_names = env->NewObjectArray(column_names.size(), string_class, nullptr);
+	for (std::size_t i = 0; i < column_names.size(); i++) {
+		jstring column_name = env->NewStringUTF(column_names[i].c_str());
+		env->SetObjectArrayElement(java_column_names, i, column_name);
+		env->DeleteLocalRef(column_name);
+	}
+	std::vector<jint> type_ids(types.size());
+	for (std::size_t i = 0; i < types.size(); i++) {
+		type_ids[i] = static_cast<jint>(types[i]);
+	}
+	jintArray java_type_ids = env->NewIntArray(type_ids.size());
+	env->SetIntArrayRegion(java_type_ids, 0, type_ids.size(), type_ids.data());
+	jstring java_name = env->NewStringUTF(name.c_str());
+
+	env->CallVoidMethod(planner, add_table_method, java_name, java_column_names, java_type_ids, static_cast<jint>(row_count));
+
+	env->DeleteLocalRef(java_name);
+	env->DeleteLocalRef(java_type_ids);
+	env->DeleteLocalRef(java_column_names);
+	env->DeleteLocalRef(string_class);
+	check_exception(env, "ERROR: could not add the table " + name + " to the planner");
+}
+
+std::string calcite_planner::get_plan(const std::string & sql) {
+	JNIEnv * env = get_env();
+
+	jstring java_sql = env->NewStringUTF(sql.c_str());
+	jstring java_plan = static_cast<jstring>(env->CallObjectMethod(planner, get_plan_method, java_sql));
+	env->DeleteLocalRef(java_sql);
+	check_exception(env, "ERROR: could not plan the query");
+
+	std::string plan = to_string(env, java_plan);
+	env->DeleteLocalRef(java_plan);
+	// the errors that are not of the sql come back as their message, like in BlazingContext._get_algebra
+	if (plan.empty() || plan[0] != '{') {
+		throw std::runtime_error("ERROR: could not plan the query: " + plan);
+	}
+	return plan;
+}
+
+}  // namespace server
+}  // namespace ral
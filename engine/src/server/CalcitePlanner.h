@@ -0,0 +1,61 @@
+#pragma once
+
+#include <jni.h>
+#include <string>
+#include <vector>
+
+#include <cudf/types.hpp>
+
+namespace ral {
+namespace server {
+
+/**
+* Plans the queries of the blazingsql-server with Apache Calcite, in a JVM that is started once, when the server
+* starts, and that every query reuses. The JVM runs com.blazingdb.calcite.application.ServerPlanner, which holds the
+* tables and the RelationalAlgebraGenerator like the BlazingContext of pyblazing does through jpype.
+*
+* Any thread can call it, it is attached to the JVM the first time it does.
+*/
+class calcite_planner {
+public:
+	/**
+	* Starts the JVM.
+	* @param class_path the jars of the algebra, separated by ':'.
+	* @throws std::runtime_error if the JVM or the ServerPlanner could not be created.
+	*/
+	calcite_planner(const std::string & class_path);
+	~calcite_planner();
+
+	calcite_planner(const calcite_planner &) = delete;
+	calcite_planner & operator=(const calcite_planner &) = delete;
+
+	void add_table(const std::string & name,
+		const std::vector<std::string> & column_names,
+		const std::vector<cudf::type_id> & types,
+		std::size_t row_count);
+
+	/**
+	* @return the JSON of the plan of the query, the one that runGenerateGraph takes.
+	* @throws std::runtime_error with the message of the error of Calcite if the query could not be planned.
+	*/
+	std::string get_plan(const std::string & sql);
+
+private:
+	JNIEnv * get_env();
+
+	// throws the pending java exception of the current thread, if any, as a std::runtime_error
+	void check_exception(JNIEnv * env, const std::string & context);
+
+	JavaVM * jvm = nullptr;
+	jobject planner = nullptr;
+	jmethodID add_table_method = nullptr;
+	jmethodID get_plan_method = nullptr;
+};
+
+/**
+* The default class path of the planner, the jars that the conda package installs in $CONDA_PREFIX/lib.
+*/
+std::string get_default_class_path();
+
+}  // namespace server
+}  // namespace ral
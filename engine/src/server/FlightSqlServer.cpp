@@ -0,0 +1,459 @@
+#include "FlightSqlServer.h"
+
+#include <chrono>
+#include <ctime>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+
+#include <arrow/builder.h>
+#include <arrow/record_batch.h>
+#include <arrow/table.h>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <cudf/interop.hpp>
+
+#include "../../include/engine/engine.h"
+
+namespace ral {
+namespace server {
+
+namespace {
+
+// the statements that were planned and never taken are dropped, oldest first, once there are more than these
+const std::size_t MAX_PENDING_STATEMENTS = 10000;
+
+const std::string flight_sql_type_url_prefix = "type.googleapis.com/arrow.flight.protocol.sql.";
+
+/**
+* The fields of a protobuf message that the server reads. Flight SQL only uses strings, bytes, nested messages and
+* bools in the messages that the server takes, so the fields are kept as the bytes of the length delimited fields and
+* the values of the varint fields, by their number.
+*/
+struct protobuf_message {
+	std::map<int, std::vector<std::string>> bytes_fields;
+	std::map<int, uint64_t> varint_fields;
+
+	std::string get_bytes(int field) const {
+		auto it = bytes_fields.find(field);
+		return it == bytes_fields.end() ? "" : it->second.back();
+	}
+};
+
+bool read_varint(const std::string & bytes, std::size_t & pos, uint64_t & value) {
+	value = 0;
+	for (int shift = 0; shift < 64 && pos < bytes.size(); shift += 7) {
+		uint8_t byte = static_cast<uint8_t>(bytes[pos++]);
+		value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+		if ((byte & 0x80) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// false if the bytes are not a protobuf message with only varint, fixed and length delimited fields
+bool parse_protobuf_message(const std::string & bytes, protobuf_message & message) {
+	std::size_t pos = 0;
+	while (pos < bytes.size()) {
+		uint64_t key;
+		if (!read_varint(bytes, pos, key) || (key >> 3) == 0) {
+			return false;
+		}
+		int field = static_cast<int>(key >> 3);
+		switch (key & 0x7) {
+		case 0: {
+			uint64_t value;
+			if (!read_varint(bytes, pos, value)) {
+				return false;
+			}
+			message.varint_fields[field] = value;
+			break;
+		}
+		case 1:
+			pos += 8;
+			break;
+		case 2: {
+			uint64_t length;
+			if (!read_varint(bytes, pos, length) || length > bytes.size() - pos) {
+				return false;
+			}
+			message.bytes_fields[field].push_back(bytes.substr(pos, length));
+			pos += length;
+			break;
+		}
+		case 5:
+			pos += 4;
+			break;
+		default:
+			return false;
+		}
+	}
+	return pos == bytes.size();
+}
+
+void write_varint(std::string & bytes, uint64_t value) {
+	while (value >= 0x80) {
+		bytes.push_back(static_cast<char>((value & 0x7f) | 0x80));
+		value >>= 7;
+	}
+	bytes.push_back(static_cast<char>(value));
+}
+
+void write_bytes_field(std::string & bytes, int field, const std::string & value) {
+	write_varint(bytes, (static_cast<uint64_t>(field) << 3) | 2);
+	write_varint(bytes, value.size());
+	bytes += value;
+}
+
+/**
+* Unpacks a google.protobuf.Any {type_url = 1, value = 2} with a Flight SQL message.
+* @return the name of the message, like CommandStatementQuery, or empty if the bytes are not a Flight SQL message.
+*/
+std::string unpack_flight_sql_command(const std::string & bytes, protobuf_message & command) {
+	protobuf_message any;
+	if (bytes.empty() || !parse_protobuf_message(bytes, any)) {
+		return "";
+	}
+	std::string type_url = any.get_bytes(1);
+	if (type_url.compare(0, flight_sql_type_url_prefix.size(), flight_sql_type_url_prefix) != 0 ||
+		!parse_protobuf_message(any.get_bytes(2), command)) {
+		return "";
+	}
+	return type_url.substr(flight_sql_type_url_prefix.size());
+}
+
+std::string pack_flight_sql_command(const std::string & name, const std::string & value) {
+	std::string bytes;
+	write_bytes_field(bytes, 1, flight_sql_type_url_prefix + name);
+	write_bytes_field(bytes, 2, value);
+	return bytes;
+}
+
+// the relational algebra of a plan, each node indented by its depth, like format_json_plan of pyblazing
+void format_plan(const boost::property_tree::ptree & node, int level, std::string & algebra) {
+	auto expr = node.get_optional<std::string>("expr");
+	if (expr) {
+		algebra += std::string(2 * level, ' ') + *expr + "\n";
+	}
+	auto children = node.get_child_optional("children");
+	if (children) {
+		for (const auto & child : *children) {
+			format_plan(child.second, level + 1, algebra);
+		}
+	}
+}
+
+std::string get_relational_algebra(const std::string & json_plan) {
+	boost::property_tree::ptree plan;
+	std::istringstream input(json_plan);
+	boost::property_tree::read_json(input, plan);
+	std::string algebra;
+	format_plan(plan, 0, algebra);
+	return algebra;
+}
+
+// like str(datetime.now()), the CURRENT_TIMESTAMP of the query
+std::string get_current_timestamp() {
+	auto now = std::chrono::system_clock::now();
+	std::time_t seconds = std::chrono::system_clock::to_time_t(now);
+	auto micros = std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()).count() % 1000000;
+	std::tm local_time;
+	localtime_r(&seconds, &local_time);
+	std::ostringstream timestamp;
+	timestamp << std::put_time(&local_time, "%Y-%m-%d %H:%M:%S") << "." << std::setw(6) << std::setfill('0') << micros;
+	return timestamp.str();
+}
+
+std::shared_ptr<arrow::Array> make_string_array(const std::vector<std::string> & values, bool null_values = false) {
+	arrow::StringBuilder builder;
+	for (const auto & value : values) {
+		if (null_values) {
+			builder.AppendNull();
+		} else {
+			builder.Append(value);
+		}
+	}
+	std::shared_ptr<arrow::Array> array;
+	builder.Finish(&array);
+	return array;
+}
+
+std::shared_ptr<arrow::Schema> get_catalogs_schema() {
+	return arrow::schema({arrow::field("catalog_name", arrow::utf8(), false)});
+}
+
+std::shared_ptr<arrow::Schema> get_db_schemas_schema() {
+	return arrow::schema({arrow::field("catalog_name", arrow::utf8()), arrow::field("db_schema_name", arrow::utf8(), false)});
+}
+
+std::shared_ptr<arrow::Schema> get_tables_schema() {
+	return arrow::schema({arrow::field("catalog_name", arrow::utf8()),
+		arrow::field("db_schema_name", arrow::utf8(), false),
+		arrow::field("table_name", arrow::utf8(), false),
+		arrow::field("table_type", arrow::utf8(), false)});
+}
+
+std::shared_ptr<arrow::Schema> get_table_types_schema() {
+	return arrow::schema({arrow::field("table_type", arrow::utf8(), false)});
+}
+
+arrow::Status make_batch_stream(std::shared_ptr<arrow::RecordBatch> batch,
+	std::unique_ptr<arrow::flight::FlightDataStream> * stream) {
+	auto reader = arrow::RecordBatchReader::Make({batch}, batch->schema());
+	if (!reader.ok()) {
+		return reader.status();
+	}
+	*stream = std::make_unique<arrow::flight::RecordBatchStream>(*reader);
+	return arrow::Status::OK();
+}
+
+/**
+* The batches of the result of a query, as the engine makes them. The first table of the result is taken when the
+* reader is created, for the schema of the stream, so a query that fails to start fails the DoGet.
+*/
+class query_result_reader : public arrow::RecordBatchReader {
+public:
+	query_result_reader(std::shared_ptr<ral::cache::graph> graph, int32_t ctx_token)
+		: graph(graph), ctx_token(ctx_token) {
+		next_table();
+	}
+
+	~query_result_reader() {
+		if (!finished) {
+			// the client went away before the end of the result, so the rest of it is not needed
+			cancelQuery(ctx_token);
+			try {
+				while (!getExecuteGraphResultBatch(graph, ctx_token)->cudfTables.empty()) {
+				}
+			} catch (const std::exception & e) {
+			}
+		}
+	}
+
+	std::shared_ptr<arrow::Schema> schema() const override { return result_schema; }
+
+	arrow::Status ReadNext(std::shared_ptr<arrow::RecordBatch> * batch) override {
+		try {
+			while (true) {
+				if (batches != nullptr) {
+					ARROW_RETURN_NOT_OK(batches->ReadNext(batch));
+					if (*batch != nullptr) {
+						return arrow::Status::OK();
+					}
+					batches.reset();
+					current_table.reset();
+				}
+				if (finished) {
+					*batch = nullptr;
+					return arrow::Status::OK();
+				}
+				next_table();
+			}
+		} catch (const std::exception & e) {
+			finished = true;
+			return arrow::Status::ExecutionError(e.what());
+		}
+	}
+
+private:
+	void next_table() {
+		std::unique_ptr<PartitionedResultSet> result = getExecuteGraphResultBatch(graph, ctx_token);
+		if (result->cudfTables.empty()) {
+			finished = true;
+			if (result_schema == nullptr) {
+				// the result had no tables at all, its columns have no types then
+				std::vector<std::shared_ptr<arrow::Field>> fields;
+				for (const auto & name : result->names) {
+					fields.push_back(arrow::field(name, arrow::null()));
+				}
+				result_schema = arrow::schema(fields);
+			}
+			return;
+		}
+
+		std::vector<cudf::column_metadata> metadata;
+		for (const auto & name : result->names) {
+			metadata.emplace_back(name);
+		}
+		current_table = cudf::to_arrow(result->cudfTables[0]->view(), metadata);
+		if (result_schema == nullptr) {
+			result_schema = current_table->schema();
+		}
+		batches = std::make_unique<arrow::TableBatchReader>(*current_table);
+	}
+
+	std::shared_ptr<ral::cache::graph> graph;
+	int32_t ctx_token;
+	bool finished = false;
+	std::shared_ptr<arrow::Schema> result_schema;
+	std::shared_ptr<arrow::Table> current_table;
+	std::unique_ptr<arrow::TableBatchReader> batches;
+};
+
+}  // namespace
+
+flight_sql_server::flight_sql_server(std::shared_ptr<calcite_planner> planner,
+	std::vector<server_table> tables,
+	std::map<std::string, std::string> config_options)
+	: planner(planner), config_options(config_options) {
+	for (auto & table : tables) {
+		this->tables[table.name] = std::move(table);
+	}
+	// like the random ctxToken of pyblazing, so that the caches of two runs of the server do not mix on the disk
+	std::random_device random;
+	next_ctx_token = static_cast<int32_t>(random() & 0x3fffffff);
+	// the batches are taken as the OutputKernel makes them
+	this->config_options["RETURN_ITERATOR"] = "True";
+}
+
+arrow::Status flight_sql_server::GetFlightInfo(const arrow::flight::ServerCallContext & /*context*/,
+	const arrow::flight::FlightDescriptor & request,
+	std::unique_ptr<arrow::flight::FlightInfo> * info) {
+	if (request.type != arrow::flight::FlightDescriptor::CMD) {
+		return arrow::Status::NotImplemented("the flights of the server are described by commands, not paths");
+	}
+
+	protobuf_message command;
+	std::string command_name = unpack_flight_sql_command(request.cmd, command);
+	std::shared_ptr<arrow::Schema> schema = arrow::schema({});
+	std::string ticket = request.cmd;
+	if (command_name == "CommandGetCatalogs") {
+		schema = get_catalogs_schema();
+	} else if (command_name == "CommandGetDbSchemas") {
+		schema = get_db_schemas_schema();
+	} else if (command_name == "CommandGetTables") {
+		schema = get_tables_schema();
+	} else if (command_name == "CommandGetTableTypes") {
+		schema = get_table_types_schema();
+	} else if (command_name.empty() || command_name == "CommandStatementQuery") {
+		// the schema of the result is not known until the query runs, the flight has an empty one
+		statement query;
+		query.sql = command_name.empty() ? request.cmd : command.get_bytes(1);
+		try {
+			query.plan = planner->get_plan(query.sql);
+		} catch (const std::exception & e) {
+			return arrow::Status::Invalid(e.what());
+		}
+
+		std::lock_guard<std::mutex> lock(statements_mutex);
+		uint64_t handle = next_statement_handle++;
+		statements[handle] = query;
+		if (statements.size() > MAX_PENDING_STATEMENTS) {
+			statements.erase(statements.begin());
+		}
+		std::string ticket_statement;
+		write_bytes_field(ticket_statement, 1, std::to_string(handle));
+		ticket = pack_flight_sql_command("TicketStatementQuery", ticket_statement);
+	} else {
+		return arrow::Status::NotImplemented("the server does not support the Flight SQL command ", command_name);
+	}
+
+	arrow::flight::FlightEndpoint endpoint;
+	endpoint.ticket.ticket = ticket;
+	auto flight_info = arrow::flight::FlightInfo::Make(*schema, request, {endpoint}, -1, -1);
+	if (!flight_info.ok()) {
+		return flight_info.status();
+	}
+	*info = std::make_unique<arrow::flight::FlightInfo>(std::move(*flight_info));
+	return arrow::Status::OK();
+}
+
+arrow::Status flight_sql_server::DoGet(const arrow::flight::ServerCallContext & /*context*/,
+	const arrow::flight::Ticket & request,
+	std::unique_ptr<arrow::flight::FlightDataStream> * stream) {
+	protobuf_message command;
+	std::string command_name = unpack_flight_sql_command(request.ticket, command);
+	if (command_name == "CommandGetCatalogs") {
+		auto batch = arrow::RecordBatch::Make(get_catalogs_schema(), 0, {make_string_array({})});
+		return make_batch_stream(batch, stream);
+	} else if (command_name == "CommandGetDbSchemas") {
+		auto batch = arrow::RecordBatch::Make(get_db_schemas_schema(), 1, {make_string_array({""}, true), make_string_array({"main"})});
+		return make_batch_stream(batch, stream);
+	} else if (command_name == "CommandGetTables") {
+		return make_batch_stream(get_tables(), stream);
+	} else if (command_name == "CommandGetTableTypes") {
+		auto batch = arrow::RecordBatch::Make(get_table_types_schema(), 1, {make_string_array({"TABLE"})});
+		return make_batch_stream(batch, stream);
+	} else if (command_name == "TicketStatementQuery") {
+		statement query;
+		{
+			std::lock_guard<std::mutex> lock(statements_mutex);
+			auto it = statements.end();
+			try {
+				it = statements.find(std::stoull(command.get_bytes(1)));
+			} catch (const std::exception & e) {
+			}
+			if (it == statements.end()) {
+				return arrow::Status::KeyError("the statement of the ticket is not known, or was already taken");
+			}
+			query = it->second;
+			statements.erase(it);
+		}
+		return run_statement(query, stream);
+	} else if (command_name.empty()) {
+		// a ticket with the text of the query, which plans and runs it in a single call
+		statement query;
+		query.sql = request.ticket;
+		try {
+			query.plan = planner->get_plan(query.sql);
+		} catch (const std::exception & e) {
+			return arrow::Status::Invalid(e.what());
+		}
+		return run_statement(query, stream);
+	}
+	return arrow::Status::NotImplemented("the server does not support the Flight SQL ticket ", command_name);
+}
+
+arrow::Status flight_sql_server::run_statement(const statement & query,
+	std::unique_ptr<arrow::flight::FlightDataStream> * stream) {
+	try {
+		TableScanInfo scan_info = getTableScanInfo(get_relational_algebra(query.plan));
+
+		std::vector<TableSchema> table_schemas;
+		std::vector<std::vector<std::string>> arg_keys, arg_values, files_all;
+		std::vector<int> file_types;
+		std::vector<std::vector<std::map<std::string, std::string>>> uri_values;
+		for (const auto & table_name : scan_info.table_names) {
+			auto it = tables.find(table_name);
+			if (it == tables.end()) {
+				return arrow::Status::KeyError("the table ", table_name, " is not a table of the server");
+			}
+			const server_table & table = it->second;
+			table_schemas.push_back(table.schema);
+			arg_keys.push_back(table.arg_keys);
+			arg_values.push_back(table.arg_values);
+			files_all.push_back(table.schema.files);
+			file_types.push_back(table.schema.data_type);
+			uri_values.emplace_back();
+		}
+
+		int32_t ctx_token = next_ctx_token++;
+		std::shared_ptr<ral::cache::graph> graph = runGenerateGraph(0, {"self"}, scan_info.table_names,
+			scan_info.relational_algebra_steps, table_schemas, arg_keys, arg_values, files_all, file_types, ctx_token,
+			query.plan, uri_values, config_options, query.sql, get_current_timestamp());
+		startExecuteGraph(graph, ctx_token);
+
+		*stream = std::make_unique<arrow::flight::RecordBatchStream>(std::make_shared<query_result_reader>(graph, ctx_token));
+		return arrow::Status::OK();
+	} catch (const std::exception & e) {
+		return arrow::Status::ExecutionError(e.what());
+	}
+}
+
+std::shared_ptr<arrow::RecordBatch> flight_sql_server::get_tables() {
+	std::vector<std::string> table_names;
+	for (const auto & table : tables) {
+		table_names.push_back(table.first);
+	}
+	std::size_t num_tables = table_names.size();
+	return arrow::RecordBatch::Make(get_tables_schema(), num_tables, {
+		make_string_array(std::vector<std::string>(num_tables), true),
+		make_string_array(std::vector<std::string>(num_tables, "main")),
+		make_string_array(table_names),
+		make_string_array(std::vector<std::string>(num_tables, "TABLE"))});
+}
+
+}  // namespace server
+}  // namespace ral
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <arrow/flight/api.h>
+
+#include "CalcitePlanner.h"
+#include "../../include/io/io.h"
+
+namespace ral {
+namespace server {
+
+/**
+* A table of the server, from its config file. Its schema is parsed once, when the server starts, like create_table
+* of the BlazingContext does.
+*/
+struct server_table {
+	std::string name;
+	TableSchema schema;
+	std::vector<std::string> arg_keys;
+	std::vector<std::string> arg_values;
+};
+
+/**
+* The Arrow Flight service of the blazingsql-server. It speaks the Flight SQL protocol, whose messages travel as
+* protobuf Any messages in the commands of the descriptors and in the tickets:
+*
+* - GetFlightInfo of a CommandStatementQuery plans the query with the calcite_planner and returns a flight with a
+*   single endpoint, whose ticket is a TicketStatementQuery with the handle of the statement.
+* - DoGet of that ticket runs the plan on this node and streams the batches of the result, as the OutputKernel
+*   makes them (RETURN_ITERATOR), so the client gets the first rows before the query finishes. Dropping the stream
+*   cancels the query.
+* - CommandGetCatalogs, CommandGetDbSchemas, CommandGetTables and CommandGetTableTypes list the tables, all of them in
+*   the "main" schema. Their filters are not applied and the schemas of the tables are not included.
+*
+* A descriptor whose command is not a Flight SQL message is taken as the text of the query, so that a plain Arrow
+* Flight client can run queries too.
+*/
+class flight_sql_server : public arrow::flight::FlightServerBase {
+public:
+	flight_sql_server(std::shared_ptr<calcite_planner> planner,
+		std::vector<server_table> tables,
+		std::map<std::string, std::string> config_options);
+
+	arrow::Status GetFlightInfo(const arrow::flight::ServerCallContext & context,
+		const arrow::flight::FlightDescriptor & request,
+		std::unique_ptr<arrow::flight::FlightInfo> * info) override;
+
+	arrow::Status DoGet(const arrow::flight::ServerCallContext & context,
+		const arrow::flight::Ticket & request,
+		std::unique_ptr<arrow::flight::FlightDataStream> * stream) override;
+
+private:
+	struct statement {
+		std::string sql;
+		std::string plan;
+	};
+
+	arrow::Status run_statement(const statement & query, std::unique_ptr<arrow::flight::FlightDataStream> * stream);
+
+	std::shared_ptr<arrow::RecordBatch> get_tables();
+
+	std::shared_ptr<calcite_planner> planner;
+	std::map<std::string, server_table> tables;
+	std::map<std::string, std::string> config_options;
+
+	std::mutex statements_mutex;
+	std::map<uint64_t, statement> statements; // the planned statements by their handle, until their DoGet
+	uint64_t next_statement_handle = 0;
+	std::atomic<int32_t> next_ctx_token;
+};
+
+}  // namespace server
+}  // namespace ral
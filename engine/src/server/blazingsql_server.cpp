@@ -0,0 +1,135 @@
+/**
+* blazingsql-server: runs the engine on a single GPU as a long running process, which takes queries over Arrow
+* Flight SQL, see flight_sql_server. The JVM of Calcite, the memory resources, the thread pools and the tables are
+* set up once, when it starts, so a query only pays for its planning and its execution.
+*
+* Usage: blazingsql-server <config.json>
+*
+* {
+*   "host": "0.0.0.0",                  // where the flight service listens, 0.0.0.0 by default
+*   "port": 8815,                       // 8815 by default
+*   "class_path": "a.jar:b.jar",        // the jars of the algebra, the ones of $CONDA_PREFIX/lib by default
+*   "allocator": "pool_memory_resource", // the allocation_mode of the engine, cuda_memory_resource by default
+*   "initial_pool_size": 0,
+*   "maximum_pool_size": 0,
+*   "enable_logging": false,
+*   "config_options": {"MAX_KERNEL_RUN_THREADS": "16"},  // the config options of the BlazingContext
+*   "tables": [
+*     {"name": "orders", "files": ["/data/orders/"], "file_format": "parquet", "args": {}}
+*   ]
+* }
+*/
+
+#include <csignal>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include "CalcitePlanner.h"
+#include "FlightSqlServer.h"
+#include "../../include/engine/initialize.h"
+#include "../../include/io/io.h"
+
+namespace {
+
+void check_status(const arrow::Status & status, const std::string & what) {
+	if (!status.ok()) {
+		throw std::runtime_error("ERROR: " + what + " failed: " + status.ToString());
+	}
+}
+
+std::vector<std::string> get_strings(const boost::property_tree::ptree & node, const std::string & key) {
+	std::vector<std::string> values;
+	auto child = node.get_child_optional(key);
+	if (child) {
+		for (const auto & value : *child) {
+			values.push_back(value.second.get_value<std::string>());
+		}
+	}
+	return values;
+}
+
+ral::server::server_table load_table(const boost::property_tree::ptree & config, ral::server::calcite_planner & planner) {
+	ral::server::server_table table;
+	table.name = config.get<std::string>("name");
+	std::vector<std::string> files = get_strings(config, "files");
+	std::string file_format = config.get<std::string>("file_format", "undefined");
+	auto args = config.get_child_optional("args");
+	if (args) {
+		for (const auto & arg : *args) {
+			table.arg_keys.push_back(arg.first);
+			table.arg_values.push_back(arg.second.get_value<std::string>());
+		}
+	}
+
+	table.schema = parseSchema(files, file_format, table.arg_keys, table.arg_values, {}, false);
+	// like create_table of the BlazingContext for the tables of files without partitions
+	table.schema.datasource = files;
+	table.schema.in_file.clear();
+
+	planner.add_table(table.name, table.schema.names, table.schema.types, table.schema.row_count);
+	std::cout << "table " << table.name << ": " << table.schema.files.size() << " files, " << table.schema.row_count << " rows" << std::endl;
+	return table;
+}
+
+}  // namespace
+
+int main(int argc, char ** argv) {
+	if (argc != 2) {
+		std::cerr << "Usage: " << argv[0] << " <config.json>" << std::endl;
+		return 1;
+	}
+
+	try {
+		boost::property_tree::ptree config;
+		boost::property_tree::read_json(argv[1], config);
+
+		std::map<std::string, std::string> config_options;
+		auto options = config.get_child_optional("config_options");
+		if (options) {
+			for (const auto & option : *options) {
+				config_options[option.first] = option.second.get_value<std::string>();
+			}
+		}
+
+		initialize(0, "self", "lo", 0, {}, true, config_options,
+			config.get<std::string>("allocator", "cuda_memory_resource"),
+			config.get<std::size_t>("initial_pool_size", 0),
+			config.get<std::size_t>("maximum_pool_size", 0),
+			config.get<bool>("enable_logging", false));
+
+		auto planner = std::make_shared<ral::server::calcite_planner>(
+			config.get<std::string>("class_path", ral::server::get_default_class_path()));
+
+		std::vector<ral::server::server_table> tables;
+		auto tables_config = config.get_child_optional("tables");
+		if (tables_config) {
+			for (const auto & table_config : *tables_config) {
+				tables.push_back(load_table(table_config.second, *planner));
+			}
+		}
+
+		std::string host = config.get<std::string>("host", "0.0.0.0");
+		int port = config.get<int>("port", 8815);
+		arrow::flight::Location location;
+		check_status(arrow::flight::Location::ForGrpcTcp(host, port, &location), "Parsing the location of the server");
+
+		ral::server::flight_sql_server server(planner, std::move(tables), config_options);
+		arrow::flight::FlightServerOptions server_options(location);
+		check_status(server.Init(server_options), "Starting the flight service");
+		check_status(server.SetShutdownOnSignals({SIGINT, SIGTERM}), "Setting up the signals");
+		std::cout << "blazingsql-server listening on " << location.ToString() << std::endl;
+		check_status(server.Serve(), "Serving");
+
+		finalize({});
+	} catch (const std::exception & e) {
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
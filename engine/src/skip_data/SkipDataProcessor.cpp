@@ -11,7 +11,11 @@
 #include "execution_kernels/LogicalFilter.h"
 #include "execution_kernels/LogicalProject.h"
 #include "utilities/error.hpp"
+#include "utilities/CommonOperations.h"
+#include "io/data_parser/metadata/common_metadata.h"
+#include "io/data_parser/sql/sqlcommon.h"
 
+#include <cstring>
 #include <numeric>
 
 using namespace fmt::literals;
@@ -173,9 +177,15 @@ private:
 
 struct skip_data_reducer : public node_transformer {
 public:
+    explicit skip_data_reducer(const std::vector<bool> & null_count_columns) : null_count_columns_{null_count_columns} {}
+
     node * transform(operad_node& node) override { return &node; }
 
     node * transform(operator_node& node) override {
+        if (node.value == "IS_NULL" or node.value == "IS_NOT_NULL") {
+            return transform_null_check(node);
+        }
+
         if (ral::skip_data::is_unsupported_binary_op(node.value)) {
             return new operator_node("NONE");
         }
@@ -215,6 +225,33 @@ public:
 
         return &node;
     }
+
+private:
+    // IS_NULL($i) keeps the row groups whose null count is not 0, and IS_NOT_NULL($i) the ones whose null count is not
+    // their row count, which the null counts that are not known (-1) never are.
+    // The null count of $i is $(2 * n + i) and the row count is $(3 * n), like process_skipdata_for_table lays them out
+    node * transform_null_check(operator_node& node) {
+        assert(node.children.size() == 1);
+
+        node * operand = node.children[0].get();
+        int id = operand->type == node_type::VARIABLE ? ral::skip_data::get_id(operand->value) : -1;
+        if (id < 0 or id >= static_cast<int>(null_count_columns_.size()) or not null_count_columns_[id]) {
+            return new operator_node("NONE");
+        }
+
+        size_t num_columns = null_count_columns_.size();
+        node * ptr = new operator_node("<>");
+        ptr->children.push_back(std::unique_ptr<node>(new variable_node("$" + std::to_string(2 * num_columns + id))));
+        if (node.value == "IS_NULL") {
+            ptr->children.push_back(std::unique_ptr<node>(new literal_node("0", cudf::data_type{cudf::type_id::INT64})));
+        } else {
+            ptr->children.push_back(std::unique_ptr<node>(new variable_node("$" + std::to_string(3 * num_columns))));
+        }
+
+        return ptr;
+    }
+
+    std::vector<bool> null_count_columns_;
 };
 
 } // namespace
@@ -224,8 +261,8 @@ void drop_value(ral::parser::parse_tree& tree, const std::string & value) {
     tree.transform(t);
 }
 
-bool apply_skip_data_rules(ral::parser::parse_tree& tree) {
-    skip_data_reducer r;
+bool apply_skip_data_rules(ral::parser::parse_tree& tree, const std::vector<bool> & null_count_columns) {
+    skip_data_reducer r(null_count_columns);
     tree.transform(r);
 
     if (tree.root().value == "NONE") {
@@ -238,6 +275,86 @@ bool apply_skip_data_rules(ral::parser::parse_tree& tree) {
     return true;
 }
 
+namespace {
+using namespace ral::parser;
+
+// A comparison of a column with a literal holds for all the rows when it holds for the min or the max of the column
+// that bounds it, and the column has no nulls
+std::string all_rows_pass_condition(const ral::parser::node * node, const std::vector<int> & min_col_indices,
+    const std::vector<int> & null_count_col_indices) {
+
+    if (node->type != node_type::OPERATOR) {
+        return "";
+    }
+    auto no_nulls = [&](int id) {
+        return "=($" + std::to_string(null_count_col_indices[id]) + ", 0)";
+    };
+    auto is_column = [&](const ral::parser::node * operand) {
+        if (operand->type != node_type::VARIABLE) {
+            return false;
+        }
+        int id = ral::skip_data::get_id(operand->value);
+        return id >= 0 && id < static_cast<int>(min_col_indices.size()) && min_col_indices[id] >= 0 && null_count_col_indices[id] >= 0;
+    };
+
+    if (node->value == "AND" || node->value == "OR") {
+        std::vector<std::string> conditions;
+        for (auto & child : node->children) {
+            std::string condition = all_rows_pass_condition(child.get(), min_col_indices, null_count_col_indices);
+            if (condition.empty() && node->value == "AND") {
+                return "";
+            }
+            if (!condition.empty()) {
+                conditions.push_back(condition);
+            }
+        }
+        if (conditions.empty()) {
+            return "";
+        }
+        std::string condition = conditions[0];
+        for (size_t i = 1; i < conditions.size(); i++) {
+            condition = node->value + "(" + condition + ", " + conditions[i] + ")";
+        }
+        return condition;
+    }
+
+    if (node->value == "IS_NOT_NULL" && node->children.size() == 1 && is_column(node->children[0].get())) {
+        return no_nulls(ral::skip_data::get_id(node->children[0]->value));
+    }
+
+    static const std::map<std::string, std::string> mirrored_ops = {{"=", "="}, {"<", ">"}, {"<=", ">="}, {">", "<"}, {">=", "<="}};
+    auto op_it = mirrored_ops.find(node->value);
+    if (op_it == mirrored_ops.end() || node->children.size() != 2) {
+        return "";
+    }
+    const ral::parser::node * column = node->children[0].get();
+    const ral::parser::node * literal = node->children[1].get();
+    std::string op = node->value;
+    if (column->type == node_type::LITERAL) {
+        std::swap(column, literal);
+        op = op_it->second;
+    }
+    if (!is_column(column) || literal->type != node_type::LITERAL ||
+            static_cast<const literal_node *>(literal)->type().id() == cudf::type_id::STRING) {
+        return "";
+    }
+
+    int id = ral::skip_data::get_id(column->value);
+    std::string min = "$" + std::to_string(min_col_indices[id]);
+    std::string max = "$" + std::to_string(min_col_indices[id] + 1);
+    std::string condition;
+    if (op == "=") {
+        condition = "AND(=(" + min + ", " + literal->value + "), =(" + max + ", " + literal->value + "))";
+    } else if (op == ">" || op == ">=") {
+        condition = op + "(" + min + ", " + literal->value + ")";
+    } else {
+        condition = op + "(" + max + ", " + literal->value + ")";
+    }
+    return "AND(" + condition + ", " + no_nulls(id) + ")";
+}
+
+} // namespace
+
 // "BindableTableScan(table=[[main, customer]], filters=[[OR(AND(<($0, 15000), =($1, 5)), =($0, *($1, $1)), >=($1, 10), <=($2, 500))]], projects=[[0, 3, 5]], aliases=[[c_custkey, c_nationkey, c_acctbal]])"
 //      projects=[[0, 3, 5]]
 // minmax_metadata_table => use these indices [[0, 3, 5]]
@@ -288,7 +405,12 @@ std::pair<std::unique_ptr<ral::frame::BlazingTable>, bool> process_skipdata_for_
     std::vector<std::unique_ptr<ral::frame::BlazingColumn>> metadata_columns = metadata_view.toBlazingColumns();
     std::vector<std::unique_ptr<ral::frame::BlazingColumn>> projected_metadata_cols;
     std::vector<bool> valid_metadata_columns;
+    std::vector<int> null_count_col_indices;
     for (int col_index : column_indeces){
+        std::string metadata_null_count_name = "nulls_" + std::to_string(col_index) + '_' + names[col_index];
+        auto it = std::find(metadata_names.begin(), metadata_names.end(), metadata_null_count_name);
+        null_count_col_indices.push_back(it != metadata_names.end() ? std::distance(metadata_names.begin(), it) : -1);
+
         std::string metadata_min_name = "min_" + std::to_string(col_index) + '_' + names[col_index];
         std::string metadata_max_name = "max_" + std::to_string(col_index) + '_' + names[col_index];
         if (std::find(metadata_names.begin(), metadata_names.end(), metadata_min_name) != metadata_names.end() &&
@@ -306,6 +428,22 @@ std::pair<std::unique_ptr<ral::frame::BlazingTable>, bool> process_skipdata_for_
         }
     }
 
+    // the null counts and the row count go after the min and max of all the columns, when the metadata has them
+    std::vector<bool> null_count_columns;
+    auto row_count_it = std::find(metadata_names.begin(), metadata_names.end(), "row_count");
+    if (row_count_it != metadata_names.end()) {
+        for (size_t i = 0; i < null_count_col_indices.size(); i++) {
+            if (null_count_col_indices[i] >= 0 && valid_metadata_columns[i]) {
+                null_count_columns.push_back(true);
+                projected_metadata_cols.emplace_back(std::move(metadata_columns[null_count_col_indices[i]]));
+            } else {
+                null_count_columns.push_back(false);
+                projected_metadata_cols.emplace_back(std::make_unique<ral::frame::BlazingColumnView>(temp_no_data->view()));
+            }
+        }
+        projected_metadata_cols.emplace_back(std::move(metadata_columns[std::distance(metadata_names.begin(), row_count_it)]));
+    }
+
     // process filter_string to convert to skip data version
     ral::parser::parse_tree tree;
     if (tree.build(filter_string)){
@@ -315,7 +453,7 @@ std::pair<std::unique_ptr<ral::frame::BlazingTable>, bool> process_skipdata_for_
                 drop_value(tree, "$" + std::to_string(i));
             }
         }
-        if (apply_skip_data_rules(tree)) {
+        if (apply_skip_data_rules(tree, null_count_columns)) {
             // std::cout << " skiP-data: " << filter_string << " | " << tree.rebuildExpression() << std::endl;
             filter_string =  tree.rebuildExpression();
         } else{
@@ -348,6 +486,161 @@ std::pair<std::unique_ptr<ral::frame::BlazingTable>, bool> process_skipdata_for_
     return std::make_pair(std::move(filtered_metadata_ids), false);
 }
 
+namespace {
+
+// Parses the partition values into the int64 slots that get_typed_vector_content reads for the type
+bool parse_partition_values(const std::vector<std::string> & values, cudf::type_id type, std::vector<int64_t> & parsed) {
+    parsed.assign(values.size(), 0);
+    try {
+        for (size_t i = 0; i < values.size(); i++) {
+            const std::string & value = values[i];
+            size_t parsed_length = value.size();
+            if (type == cudf::type_id::BOOL8) {
+                if (value != "true" && value != "false") {
+                    return false;
+                }
+                parsed[i] = value == "true";
+            } else if (is_type_integer(type)) {
+                parsed[i] = std::stoll(value, &parsed_length);
+            } else if (type == cudf::type_id::FLOAT32) {
+                float float_value = std::stof(value, &parsed_length);
+                std::memcpy(&parsed[i], &float_value, sizeof(float));
+            } else if (type == cudf::type_id::FLOAT64) {
+                double double_value = std::stod(value, &parsed_length);
+                std::memcpy(&parsed[i], &double_value, sizeof(double));
+            } else if (type == cudf::type_id::TIMESTAMP_DAYS || type == cudf::type_id::TIMESTAMP_SECONDS ||
+                    type == cudf::type_id::TIMESTAMP_MILLISECONDS || type == cudf::type_id::TIMESTAMP_MICROSECONDS ||
+                    type == cudf::type_id::TIMESTAMP_NANOSECONDS) {
+                int64_t microseconds;
+                if (!ral::io::parse_timestamp_microseconds(value.data(), value.size(), microseconds)) {
+                    return false;
+                }
+                parsed[i] = ral::io::microseconds_to_ticks(microseconds, type);
+            } else {
+                return false;
+            }
+            if (parsed_length != value.size()) {
+                return false;
+            }
+        }
+    } catch (const std::exception &) {
+        // the values std::stoll and friends can't parse or that are out of range
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+std::string get_all_rows_pass_condition(const std::string & filter_string, const std::vector<int> & min_col_indices,
+    const std::vector<int> & null_count_col_indices) {
+
+    ral::parser::parse_tree tree;
+    if (!tree.build(filter_string)) {
+        return "";
+    }
+    return all_rows_pass_condition(&tree.root(), min_col_indices, null_count_col_indices);
+}
+
+std::unique_ptr<ral::frame::BlazingTable> get_row_groups_with_all_rows_passing(
+    const ral::frame::BlazingTableView & metadata_view, const std::vector<std::string> & names, const std::string & table_scan) {
+
+    std::string filter_string = get_named_expression(table_scan, "filters");
+    if (filter_string.empty()) {
+        return metadata_view.clone();
+    }
+    filter_string = replace_calcite_regex(filter_string);
+    filter_string = expand_if_logical_op(filter_string);
+
+    std::vector<int> column_indices = get_projections(table_scan);
+    if (column_indices.empty()) {
+        column_indices.resize(names.size());
+        std::iota(column_indices.begin(), column_indices.end(), 0);
+    }
+
+    // the same metadata columns that process_skipdata_for_table uses, taken straight from the metadata
+    std::vector<std::string> metadata_names = metadata_view.names();
+    std::vector<int> min_col_indices;
+    std::vector<int> null_count_col_indices;
+    for (int col_index : column_indices) {
+        std::string suffix = std::to_string(col_index) + '_' + names[col_index];
+        auto min_it = std::find(metadata_names.begin(), metadata_names.end(), "min_" + suffix);
+        bool has_max = min_it != metadata_names.end() && std::next(min_it) != metadata_names.end() && *std::next(min_it) == "max_" + suffix;
+        min_col_indices.push_back(has_max ? std::distance(metadata_names.begin(), min_it) : -1);
+        auto nulls_it = std::find(metadata_names.begin(), metadata_names.end(), "nulls_" + suffix);
+        null_count_col_indices.push_back(nulls_it != metadata_names.end() ? std::distance(metadata_names.begin(), nulls_it) : -1);
+    }
+
+    std::string condition = get_all_rows_pass_condition(filter_string, min_col_indices, null_count_col_indices);
+    if (condition.empty()) {
+        return nullptr;
+    }
+
+    std::vector<std::unique_ptr<ral::frame::BlazingColumn>> evaluated_table = ral::processor::evaluate_expressions(metadata_view.view(), {condition});
+    RAL_EXPECTS(evaluated_table.size() == 1 && evaluated_table[0]->view().type().id() == cudf::type_id::BOOL8, "Expression in skip_data processing did not evaluate to a boolean mask");
+
+    return ral::processor::applyBooleanFilter(metadata_view, evaluated_table[0]->view());
+}
+
+std::vector<std::size_t> get_partitions_to_read(const std::vector<std::map<std::string, std::string>> & partition_values,
+    const std::vector<std::string> & names, const std::vector<cudf::type_id> & types, const std::string & table_scan) {
+
+    std::vector<std::size_t> all_partitions(partition_values.size());
+    std::iota(all_partitions.begin(), all_partitions.end(), 0);
+    if (partition_values.empty()) {
+        return all_partitions;
+    }
+
+    // each uri is a row whose min and max are its partition value, for the columns every uri has a value of
+    std::vector<std::unique_ptr<cudf::column>> metadata_columns;
+    std::vector<std::string> metadata_names;
+    for (size_t col_index = 0; col_index < names.size(); col_index++) {
+        std::vector<std::string> values;
+        for (auto & partition : partition_values) {
+            auto it = partition.find(names[col_index]);
+            if (it == partition.end()) {
+                break;
+            }
+            values.push_back(it->second);
+        }
+        if (values.size() != partition_values.size()) {
+            continue;
+        }
+
+        std::vector<int64_t> parsed;
+        if (types[col_index] != cudf::type_id::STRING && !parse_partition_values(values, types[col_index], parsed)) {
+            continue;
+        }
+        for (const char * prefix : {"min_", "max_"}) {
+            if (types[col_index] == cudf::type_id::STRING) {
+                metadata_columns.push_back(make_cudf_strings_column_from_vector(values));
+            } else {
+                std::basic_string<char> content = get_typed_vector_content(types[col_index], parsed);
+                metadata_columns.push_back(make_cudf_column_from_vector(cudf::data_type{types[col_index]}, content, values.size()));
+            }
+            metadata_names.push_back(prefix + std::to_string(col_index) + '_' + names[col_index]);
+        }
+    }
+    if (metadata_columns.empty()) {
+        return all_partitions;
+    }
+
+    std::vector<int32_t> file_handle_indices(partition_values.size());
+    std::iota(file_handle_indices.begin(), file_handle_indices.end(), 0);
+    metadata_columns.push_back(ral::utilities::vector_to_column(file_handle_indices, cudf::data_type{cudf::type_id::INT32}));
+    metadata_names.push_back("file_handle_index");
+    metadata_columns.push_back(ral::utilities::vector_to_column(std::vector<int32_t>(partition_values.size(), 0), cudf::data_type{cudf::type_id::INT32}));
+    metadata_names.push_back("row_group_index");
+
+    auto metadata = std::make_unique<ral::frame::BlazingTable>(std::make_unique<cudf::table>(std::move(metadata_columns)), metadata_names);
+    auto result = process_skipdata_for_table(metadata->toBlazingTableView(), names, table_scan);
+    if (result.second) {
+        return all_partitions;
+    }
+
+    std::vector<int32_t> kept_indices = ral::utilities::column_to_vector<int32_t>(result.first->view().column(0));
+    return std::vector<std::size_t>(kept_indices.begin(), kept_indices.end());
+}
 
 } // namespace skip_data
 } // namespace ral
@@ -3,7 +3,9 @@
 #define SKIPDATAPROCESSOR_H_
 
 #include <iostream>
+#include <map>
 #include <string>
+#include <vector>
 #include "parser/expression_tree.hpp"
 #include "execution_kernels/LogicPrimitives.h"
 
@@ -12,11 +14,30 @@ namespace skip_data {
 
 // For unit testing
 void drop_value(ral::parser::parse_tree& tree, const std::string & value);
-bool apply_skip_data_rules(ral::parser::parse_tree& tree);
+// null_count_columns tells which of the columns have null counts, for the IS_NULL and IS_NOT_NULL predicates
+bool apply_skip_data_rules(ral::parser::parse_tree& tree, const std::vector<bool> & null_count_columns = {});
 
 std::pair<std::unique_ptr<ral::frame::BlazingTable>, bool> process_skipdata_for_table(
     const ral::frame::BlazingTableView & metadata_view, const std::vector<std::string> & names, std::string table_scan);
 
+// The condition on the metadata under which all the rows of a row group pass the filter, or "" when it can't be told.
+// The min of the column $i of the filter is $min_col_indices[i], followed by its max, and its null count is
+// $null_count_col_indices[i], where -1 means that the metadata does not have them.
+std::string get_all_rows_pass_condition(const std::string & filter_string, const std::vector<int> & min_col_indices,
+    const std::vector<int> & null_count_col_indices);
+
+// The rows of the metadata of the row groups whose rows all pass the filter of the table scan, as told by their min, max
+// and null counts, or nullptr when the filter can't be decided that way. The row groups that are left out can still
+// have rows that pass it.
+std::unique_ptr<ral::frame::BlazingTable> get_row_groups_with_all_rows_passing(
+    const ral::frame::BlazingTableView & metadata_view, const std::vector<std::string> & names, const std::string & table_scan);
+
+// Evaluates the filter of the table scan on the hive partition values of each uri, as if they were the min and max of
+// its files. Returns the indices of the uris whose partitions can pass the filter, which are all of them when it can't
+// be evaluated on the partition values.
+std::vector<std::size_t> get_partitions_to_read(const std::vector<std::map<std::string, std::string>> & partition_values,
+    const std::vector<std::string> & names, const std::vector<cudf::type_id> & types, const std::string & table_scan);
+
 } // namespace skip_data
 } // namespace ral
 
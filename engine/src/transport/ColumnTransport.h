@@ -20,6 +20,15 @@ struct ColumnTransport {
   int strings_nullmask{};
   int strings_data_size{0};
   int strings_offsets_size{0};
+  // a strings column sent as a dictionary has its distinct values in the strings buffers and the UINT32 index of the
+  // value of every row in this buffer, see serialize_gpu_message_to_gpu_containers. (-1) it is not a dictionary
+  int dictionary_indices{-1};
+  int dictionary_keys_size{0};
+  // a table with many columns is serialized packed by cudf::pack, with the data of all of its columns in one buffer
+  // and the metadata that describes them in another one, which all of its columns refer to. (-1) it is not packed
+  int packed_data{-1};
+  int packed_metadata{-1};
+  int packed_column{-1};  // the index of the column in the packed table
 
   std::size_t size_in_bytes{0};
 };
@@ -11,6 +11,8 @@
 #include <cudf/unary.hpp>
 #include <cudf/column/column_factories.hpp>
 #include <cudf/strings/strings_column_view.hpp>
+#include <algorithm>
+#include <limits>
 #include <numeric>
 #include "blazing_table/BlazingColumnOwner.h"
 
@@ -26,55 +28,99 @@ bool checkIfConcatenatingStringsWillOverflow(const std::vector<std::unique_ptr<B
 	return checkIfConcatenatingStringsWillOverflow(tables_to_concat);
 }
 
-bool checkIfConcatenatingStringsWillOverflow(const std::vector<BlazingTableView> & tables) {
-	if( tables.size() == 0 ) {
-		return false;
+namespace {
+
+// the number of chars and offsets of every string column of a table, which cudf can only concatenate up to size_type
+std::vector<std::pair<std::size_t, std::size_t>> get_string_sizes(const BlazingTableView & table) {
+	std::vector<std::pair<std::size_t, std::size_t>> sizes(table.num_columns(), {0, 0});
+	for(cudf::size_type col_idx = 0; col_idx < table.num_columns(); col_idx++) {
+		auto & column = table.column(col_idx);
+		// Similarly to cudf, we focus only on the byte number of chars and the offsets count
+		if(column.type().id() == cudf::type_id::STRING && column.num_children() == 2) {
+			sizes[col_idx].first = column.child(1).size();
+			sizes[col_idx].second = column.child(0).size() + 1;
+		}
 	}
+	return sizes;
+}
 
-	// Lets only look at tables that not empty
-	std::vector<size_t> non_empty_index;
-	for(size_t table_idx = 0; table_idx < tables.size(); table_idx++) {
-		if (tables[table_idx].num_columns() > 0){
-			non_empty_index.push_back(table_idx);
-		}
+// adds the string sizes of a table to the ones of the tables before it, false if they go over what cudf can concatenate
+bool add_string_sizes(std::vector<std::pair<std::size_t, std::size_t>> & total_sizes,
+	const std::vector<std::pair<std::size_t, std::size_t>> & sizes) {
+	const std::size_t max_size = static_cast<std::size_t>(std::numeric_limits<cudf::size_type>::max());
+	bool fits = true;
+	if (total_sizes.size() < sizes.size()) {
+		total_sizes.resize(sizes.size(), {0, 0});
 	}
-	if( non_empty_index.size() == 0 ) {
-		return false;
+	for(std::size_t col_idx = 0; col_idx < sizes.size(); col_idx++) {
+		total_sizes[col_idx].first += sizes[col_idx].first;
+		total_sizes[col_idx].second += sizes[col_idx].second;
+		if (total_sizes[col_idx].first > max_size || total_sizes[col_idx].second > max_size) {
+			fits = false;
+		}
 	}
+	return fits;
+}
 
+} // namespace
 
-	for(size_t col_idx = 0; col_idx < tables[non_empty_index[0]].get_schema().size(); col_idx++) {
-		if(tables[non_empty_index[0]].get_schema()[col_idx].id() == cudf::type_id::STRING) {
-			std::size_t total_bytes_size = 0;
-			std::size_t total_offset_count = 0;
-
-			for(size_t i = 0; i < non_empty_index.size(); i++) {
-				size_t table_idx = non_empty_index[i];
-
-				// Column i-th from the next tables are expected to have the same string data type
-				assert( tables[table_idx].get_schema()[col_idx].id() == cudf::type_id::STRING );
-
-				auto & column = tables[table_idx].column(col_idx);
-				auto num_children = column.num_children();
-				if(num_children == 2) {
-
-					auto offsets_column = column.child(0);
-					auto chars_column = column.child(1);
+bool checkIfConcatenatingStringsWillOverflow(const std::vector<BlazingTableView> & tables) {
+	std::vector<std::pair<std::size_t, std::size_t>> total_sizes;
+	for(size_t table_idx = 0; table_idx < tables.size(); table_idx++) {
+		// Lets only look at tables that not empty
+		if (tables[table_idx].num_columns() > 0 && !add_string_sizes(total_sizes, get_string_sizes(tables[table_idx]))){
+			return true;
+		}
+	}
+	return false;
+}
 
-					// Similarly to cudf, we focus only on the byte number of chars and the offsets count
-					total_bytes_size += chars_column.size();
-					total_offset_count += offsets_column.size() + 1;
+std::vector<std::unique_ptr<BlazingTable>> concatTablesInBatches(std::vector<std::unique_ptr<BlazingTable>> & tables,
+	std::size_t max_batch_bytes) {
+
+	// the batches are planned from the sizes of the tables, and every table stays where it is until all the batches
+	// are concatenated, so that a bad_alloc leaves the tables for a retry
+	std::vector<std::pair<std::size_t, std::size_t>> batch_ranges; // the first table and the end of every batch
+	std::vector<std::pair<std::size_t, std::size_t>> batch_string_sizes;
+	std::size_t batch_begin = 0;
+	std::size_t batch_bytes = 0;
+	for (std::size_t i = 0; i < tables.size(); i++) {
+		std::vector<std::pair<std::size_t, std::size_t>> string_sizes = get_string_sizes(tables[i]->toBlazingTableView());
+		std::size_t table_bytes = tables[i]->sizeInBytes();
+		// a table that does not fit with the ones before it starts the next batch, even if it does not fit on its own
+		std::vector<std::pair<std::size_t, std::size_t>> new_string_sizes = batch_string_sizes;
+		bool fits = add_string_sizes(new_string_sizes, string_sizes) &&
+			(max_batch_bytes == 0 || batch_bytes + table_bytes <= max_batch_bytes);
+		if (!fits && i > batch_begin) {
+			batch_ranges.emplace_back(batch_begin, i);
+			batch_begin = i;
+			batch_bytes = 0;
+			new_string_sizes = string_sizes;
+		}
+		batch_string_sizes = std::move(new_string_sizes);
+		batch_bytes += table_bytes;
+	}
+	if (batch_begin < tables.size()) {
+		batch_ranges.emplace_back(batch_begin, tables.size());
+	}
 
-					if( total_bytes_size > static_cast<std::size_t>(std::numeric_limits<cudf::size_type>::max()) ||
-						total_offset_count > static_cast<std::size_t>(std::numeric_limits<cudf::size_type>::max())) {
-						return true;
-					}
-				}
+	std::vector<std::unique_ptr<BlazingTable>> batches(batch_ranges.size());
+	for (std::size_t b = 0; b < batch_ranges.size(); b++) {
+		if (batch_ranges[b].second - batch_ranges[b].first > 1) {
+			std::vector<BlazingTableView> batch_views;
+			for (std::size_t i = batch_ranges[b].first; i < batch_ranges[b].second; i++) {
+				batch_views.push_back(tables[i]->toBlazingTableView());
 			}
+			batches[b] = concatTables(batch_views);
 		}
 	}
-
-	return false;
+	for (std::size_t b = 0; b < batch_ranges.size(); b++) {
+		if (batches[b] == nullptr) {
+			batches[b] = std::move(tables[batch_ranges[b].first]);
+		}
+	}
+	tables.clear();
+	return batches;
 }
 
 std::unique_ptr<BlazingTable> concatTables(std::vector<std::unique_ptr<BlazingTable>> tables){
@@ -113,11 +159,23 @@ std::unique_ptr<BlazingTable> concatTables(const std::vector<BlazingTableView> &
 	if (empty_count == table_views_to_concat.size()) {
 		return std::make_unique<ral::frame::BlazingTable>(table_views_to_concat[0], names);
 	}
+	// the empty LIST and STRUCT columns that are made from a type, like the ones of the empty tables of the scans,
+	// don't have the child columns of the others, so the empty tables are not concatenated
+	if (empty_count > 0) {
+		table_views_to_concat.erase(std::remove_if(table_views_to_concat.begin(), table_views_to_concat.end(),
+			[](const CudfTableView & table_view) { return table_view.num_rows() == 0; }), table_views_to_concat.end());
+	}
 
 	std::unique_ptr<CudfTable> concatenated_tables = cudf::concatenate(table_views_to_concat);
 	return std::make_unique<BlazingTable>(std::move(concatenated_tables), names);
 }
 
+bool has_nested_columns(const CudfTableView & table) {
+	return std::any_of(table.begin(), table.end(), [](const cudf::column_view & column) {
+		return column.type().id() == cudf::type_id::LIST || column.type().id() == cudf::type_id::STRUCT;
+	});
+}
+
 std::unique_ptr<BlazingTable> getLimitedRows(const BlazingTableView& table, cudf::size_type num_rows, bool front){
 	
 	if (num_rows == 0) {
@@ -230,6 +288,16 @@ void normalize_types(std::unique_ptr<ral::frame::BlazingTable> & table,  const s
 	} else {
 		RAL_EXPECTS(column_indices.size() == types.size(), "In normalize_types: column_indices.size() != types.size()");
 	}
+	// a batch that was already normalized, like the ones a join keeps to pair with the others, is left as it is
+	cudf::table_view view = table->view();
+	bool needs_cast = false;
+	for (size_t i = 0; i < column_indices.size(); i++){
+		needs_cast = needs_cast || !(view.column(column_indices[i]).type() == types[i]);
+	}
+	if (!needs_cast){
+		return;
+	}
+
 	std::vector<std::unique_ptr<ral::frame::BlazingColumn>> columns = table->releaseBlazingColumns();
 	for (size_t i = 0; i < column_indices.size(); i++){
 		if (!(columns[column_indices[i]]->view().type() == types[i])){
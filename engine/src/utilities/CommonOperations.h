@@ -16,6 +16,21 @@ bool checkIfConcatenatingStringsWillOverflow(const std::vector<std::unique_ptr<B
 std::unique_ptr<BlazingTable> concatTables(std::vector<std::unique_ptr<BlazingTable>> tables);
 std::unique_ptr<BlazingTable> concatTables(const std::vector<BlazingTableView> & tables);
 
+/**
+* Concatenates the tables into as few batches as it can, in their order: a batch takes the next tables while its string
+* columns fit in the offsets of cudf and, when max_batch_bytes is not 0, while it is not bigger than max_batch_bytes.
+* The tables that make a batch on their own are returned as they are. The tables are only taken, and left empty, once
+* all the batches were concatenated, so that they are still there if it throws.
+*/
+std::vector<std::unique_ptr<BlazingTable>> concatTablesInBatches(std::vector<std::unique_ptr<BlazingTable>> & tables,
+	std::size_t max_batch_bytes = 0);
+
+/**
+* Whether the table has LIST or STRUCT columns, whose data is in their child columns. Those tables are serialized packed
+* and spilled as RAW files, since the buffers of the other columns and the ORC spill files describe flat columns only.
+*/
+bool has_nested_columns(const CudfTableView & table);
+
 std::unique_ptr<BlazingTable> getLimitedRows(const BlazingTableView& table, cudf::size_type num_rows, bool front=true);
 
 std::unique_ptr<ral::frame::BlazingTable> create_empty_table(const std::vector<std::string> &column_names,
@@ -29,6 +44,10 @@ cudf::data_type get_common_type(cudf::data_type type1, cudf::data_type type2, bo
 
 std::vector<cudf::data_type> get_common_types(const std::vector<cudf::data_type> & types1, const std::vector<cudf::data_type> & types2, bool strict);
 
+/**
+ * Casts the columns of a table that are not of their types, only the ones of column_indices when it is not empty.
+ * Only the columns that change are copied, and a table that has all the types is not touched.
+ */
 void normalize_types(std::unique_ptr<ral::frame::BlazingTable> & table,  const std::vector<cudf::data_type> & types,
 	 		std::vector<cudf::size_type> column_indices = std::vector<cudf::size_type>() );
 
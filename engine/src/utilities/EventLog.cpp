@@ -0,0 +1,167 @@
+#include "EventLog.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace ral {
+namespace utilities {
+
+void event_record::add(const char * value, std::size_t length) {
+	if (num_fields >= max_fields) {
+		return;
+	}
+	length = std::min(length, text_size - text_used);
+	std::memcpy(text + text_used, value, length);
+	kinds[num_fields] = field_kind::string;
+	values[num_fields].string.offset = text_used;
+	values[num_fields].string.length = static_cast<uint16_t>(length);
+	num_fields++;
+	text_used += length;
+}
+
+std::string event_record::format() const {
+	fmt::memory_buffer line;
+	for (uint8_t i = 0; i < num_fields; i++) {
+		if (i > 0) {
+			line.push_back('|');
+		}
+		switch (kinds[i]) {
+		case field_kind::integer:
+			fmt::format_to(std::back_inserter(line), "{}", values[i].integer);
+			break;
+		case field_kind::unsigned_integer:
+			fmt::format_to(std::back_inserter(line), "{}", values[i].unsigned_integer);
+			break;
+		case field_kind::floating:
+			fmt::format_to(std::back_inserter(line), "{}", values[i].floating);
+			break;
+		case field_kind::string:
+			line.append(text + values[i].string.offset, text + values[i].string.offset + values[i].string.length);
+			break;
+		}
+	}
+	return fmt::to_string(line);
+}
+
+event_log::~event_log() {
+	stop();
+}
+
+void event_log::start(std::vector<std::shared_ptr<spdlog::logger>> loggers, int flush_interval_ms) {
+	std::lock_guard<std::mutex> lock(writer_mutex);
+	if (is_running()) {
+		return;
+	}
+	{
+		// whatever was left from a previous run could point to loggers that are gone
+		std::lock_guard<std::mutex> rings_lock(rings_mutex);
+		for (auto & ring : rings) {
+			ring->tail.store(ring->head.load(std::memory_order_acquire), std::memory_order_release);
+		}
+	}
+	this->loggers = std::move(loggers);
+	this->flush_interval_ms = flush_interval_ms;
+	stop_requested = false;
+	writer = std::thread(&event_log::run, this);
+	running.store(true, std::memory_order_relaxed);
+}
+
+void event_log::stop() {
+	std::unique_lock<std::mutex> lock(writer_mutex);
+	if (!is_running()) {
+		return;
+	}
+	running.store(false, std::memory_order_relaxed);
+	stop_requested = true;
+	lock.unlock();
+	writer_cv.notify_all();
+	writer.join();
+
+	lock.lock();
+	drain();
+	for (auto & logger : loggers) {
+		logger->flush();
+	}
+	loggers.clear();
+}
+
+event_log::thread_ring & event_log::get_thread_ring() {
+	// gives the ring back when the thread exits, so that the threads of the kernels, that come and go with the
+	// queries, don't keep adding rings
+	struct ring_holder {
+		std::shared_ptr<thread_ring> ring;
+		~ring_holder() {
+			if (ring) {
+				ring->in_use.store(false, std::memory_order_release);
+			}
+		}
+	};
+	static thread_local ring_holder holder;
+	if (holder.ring == nullptr) {
+		std::lock_guard<std::mutex> lock(rings_mutex);
+		for (auto & ring : rings) {
+			if (!ring->in_use.load(std::memory_order_acquire) &&
+				ring->head.load(std::memory_order_acquire) == ring->tail.load(std::memory_order_acquire)) {
+				ring->in_use.store(true, std::memory_order_relaxed);
+				holder.ring = ring;
+				break;
+			}
+		}
+		if (holder.ring == nullptr) {
+			holder.ring = std::make_shared<thread_ring>();
+			holder.ring->records.resize(records_per_thread);
+			rings.push_back(holder.ring);
+		}
+	}
+	return *holder.ring;
+}
+
+bool event_log::drain() {
+	std::vector<std::shared_ptr<thread_ring>> rings_to_drain;
+	{
+		std::lock_guard<std::mutex> lock(rings_mutex);
+		rings_to_drain = rings;
+	}
+
+	bool wrote = false;
+	for (auto & ring : rings_to_drain) {
+		std::size_t tail = ring->tail.load(std::memory_order_relaxed);
+		std::size_t head = ring->head.load(std::memory_order_acquire);
+		for (; tail != head; tail++) {
+			const event_record & record = ring->records[tail % records_per_thread];
+			record.logger->info(record.format());
+			// the slot can be reused as soon as the tail moves past it
+			ring->tail.store(tail + 1, std::memory_order_release);
+			wrote = true;
+		}
+	}
+	return wrote;
+}
+
+void event_log::run() {
+	uint64_t num_dropped_reported = get_num_dropped();
+	while (true) {
+		bool wrote = drain();
+
+		uint64_t dropped = get_num_dropped();
+		if (dropped != num_dropped_reported) {
+			std::shared_ptr<spdlog::logger> logger = spdlog::get("batch_logger");
+			if (logger) {
+				logger->warn("|||{info}|||||", fmt::arg("info", "event_log dropped " + std::to_string(dropped - num_dropped_reported) +
+					" lines because the ring buffers of their threads were full"));
+			}
+			num_dropped_reported = dropped;
+		}
+
+		std::unique_lock<std::mutex> lock(writer_mutex);
+		if (stop_requested) {
+			break;
+		}
+		if (!wrote) {
+			writer_cv.wait_for(lock, std::chrono::milliseconds(flush_interval_ms), [this] { return stop_requested; });
+		}
+	}
+}
+
+}  // namespace utilities
+}  // namespace ral
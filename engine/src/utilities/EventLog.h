@@ -0,0 +1,232 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+#include <spdlog/fmt/fmt.h>
+
+namespace ral {
+namespace utilities {
+
+/**
+* A line of one of the event logs (the task, comms and cache events logs), kept as its raw fields until the writer of
+* the event_log formats it. The strings are copied into text, and truncated if they don't fit.
+*/
+struct event_record {
+	static constexpr std::size_t max_fields = 12;
+	static constexpr std::size_t text_size = 256;
+
+	enum class field_kind : uint8_t { integer, unsigned_integer, floating, string };
+
+	union field_value {
+		int64_t integer;
+		uint64_t unsigned_integer;
+		double floating;
+		struct {
+			uint16_t offset;
+			uint16_t length;
+		} string;
+	};
+
+	spdlog::logger * logger;
+	uint8_t num_fields;
+	uint16_t text_used;
+	field_kind kinds[max_fields];
+	field_value values[max_fields];
+	char text[text_size];
+
+	void add(const char * value, std::size_t length);
+
+	void add(const std::string & value) {
+		add(value.data(), value.size());
+	}
+
+	void add(const char * value) {
+		add(value, std::strlen(value));
+	}
+
+	template <typename T, typename std::enable_if<std::is_floating_point<T>::value, int>::type = 0>
+	void add(T value) {
+		if (num_fields < max_fields) {
+			kinds[num_fields] = field_kind::floating;
+			values[num_fields++].floating = value;
+		}
+	}
+
+	template <typename T, typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value, int>::type = 0>
+	void add(T value) {
+		if (num_fields < max_fields) {
+			kinds[num_fields] = field_kind::integer;
+			values[num_fields++].integer = value;
+		}
+	}
+
+	template <typename T, typename std::enable_if<std::is_integral<T>::value && !std::is_signed<T>::value, int>::type = 0>
+	void add(T value) {
+		if (num_fields < max_fields) {
+			kinds[num_fields] = field_kind::unsigned_integer;
+			values[num_fields++].unsigned_integer = value;
+		}
+	}
+
+	/**
+	* Get the line of the record, its fields separated by '|'.
+	*/
+	std::string format() const;
+};
+
+/**
+* Takes the lines of the event logs off the threads that log them. Every thread writes the records of its lines into
+* a ring buffer of its own, without taking any lock or formatting anything, and a writer thread formats them and
+* writes them to their loggers, which are synchronous loggers that only the writer uses.
+* The lines of every thread keep their order, but the lines of different threads can be interleaved differently than
+* when they were logged; every line has its own timestamps. When the ring buffer of a thread is full its new lines
+* are dropped and counted, so that logging never blocks the executor or the comms.
+* @note Myers' singleton.
+*/
+class event_log {
+public:
+	static event_log & get_instance() {
+		static event_log instance;
+		return instance;
+	}
+
+	event_log(event_log &&) = delete;
+	event_log(const event_log &) = delete;
+	event_log & operator=(event_log &&) = delete;
+	event_log & operator=(const event_log &) = delete;
+
+	~event_log();
+
+	/**
+	* Starts the writer thread. From then on log_event hands the lines to it.
+	* @param loggers the loggers the lines are written to, kept alive until stop.
+	* @param flush_interval_ms how long the writer sleeps when there was nothing to write.
+	*/
+	void start(std::vector<std::shared_ptr<spdlog::logger>> loggers, int flush_interval_ms = 5);
+
+	/**
+	* Writes all the lines that are still in the ring buffers and stops the writer thread.
+	*/
+	void stop();
+
+	bool is_running() const {
+		return running.load(std::memory_order_relaxed);
+	}
+
+	/**
+	* Puts a line into the ring buffer of the calling thread.
+	* @return false if the ring buffer was full and the line was dropped.
+	*/
+	template <typename... Fields>
+	bool push(spdlog::logger * logger, const Fields &... fields) {
+		thread_ring & ring = get_thread_ring();
+		std::size_t head = ring.head.load(std::memory_order_relaxed);
+		if (head - ring.tail.load(std::memory_order_acquire) == records_per_thread) {
+			num_dropped.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+		event_record & record = ring.records[head % records_per_thread];
+		record.logger = logger;
+		record.num_fields = 0;
+		record.text_used = 0;
+		int expand[] = {0, (record.add(fields), 0)...};
+		(void) expand;
+		ring.head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	/**
+	* Get how many lines were dropped because the ring buffer of their thread was full.
+	*/
+	uint64_t get_num_dropped() const {
+		return num_dropped.load(std::memory_order_relaxed);
+	}
+
+	static constexpr std::size_t records_per_thread = 1 << 11;
+
+private:
+	event_log() : running{false}, num_dropped{0} {}
+
+	/**
+	* Single producer single consumer ring buffer. Only its thread moves the head and only the writer the tail.
+	*/
+	struct thread_ring {
+		std::vector<event_record> records;
+		std::atomic<std::size_t> head{0};
+		std::atomic<std::size_t> tail{0};
+		std::atomic<bool> in_use{true}; /**< false once its thread exited, so that another thread can take it when it is empty. */
+	};
+
+	thread_ring & get_thread_ring();
+
+	/**
+	* Writes all the records that are in the ring buffers.
+	* @return true if there was something to write.
+	*/
+	bool drain();
+
+	void run();
+
+	std::atomic<bool> running;
+	std::atomic<uint64_t> num_dropped;
+	int flush_interval_ms = 5;
+	std::mutex rings_mutex; /**< Protects rings. */
+	std::vector<std::shared_ptr<thread_ring>> rings;
+	std::mutex writer_mutex; /**< Protects loggers and the start and stop of the writer. */
+	std::condition_variable writer_cv;
+	bool stop_requested = false;
+	std::vector<std::shared_ptr<spdlog::logger>> loggers;
+	std::thread writer;
+};
+
+namespace detail {
+
+inline void append_field(fmt::memory_buffer & line, const std::string & value) {
+	line.append(value.data(), value.data() + value.size());
+}
+
+inline void append_field(fmt::memory_buffer & line, const char * value) {
+	line.append(value, value + std::strlen(value));
+}
+
+template <typename T>
+void append_field(fmt::memory_buffer & line, const T & value) {
+	fmt::format_to(std::back_inserter(line), "{}", value);
+}
+
+}  // namespace detail
+
+/**
+* Logs a line of an event log, its fields separated by '|'. When the event_log is running the line is written by its
+* writer thread, otherwise it is formatted and logged right away.
+*/
+template <typename... Fields>
+void log_event(const std::shared_ptr<spdlog::logger> & logger, const Fields &... fields) {
+	if (!logger || !logger->should_log(spdlog::level::info)) {
+		return;
+	}
+	event_log & instance = event_log::get_instance();
+	if (instance.is_running()) {
+		instance.push(logger.get(), fields...);
+	} else {
+		fmt::memory_buffer line;
+		bool first = true;
+		int expand[] = {0, ((first ? void() : line.push_back('|')), first = false, detail::append_field(line, fields), 0)...};
+		(void) expand;
+		logger->info(spdlog::string_view_t(line.data(), line.size()));
+	}
+}
+
+}  // namespace utilities
+}  // namespace ral
@@ -0,0 +1,36 @@
+#include "RandomGenerator.h"
+
+#include <random>
+
+namespace ral {
+namespace utilities {
+
+namespace {
+
+// splitmix64, so that consecutive counters give unrelated seeds
+uint64_t mix(uint64_t x) {
+	x += 0x9e3779b97f4a7c15ULL;
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+	return x ^ (x >> 31);
+}
+
+}  // namespace
+
+random_generator::random_generator() {
+	std::random_device random_device;
+	seed = (static_cast<uint64_t>(random_device()) << 32) | random_device();
+}
+
+random_generator::philox_offset random_generator::reserve(uint64_t count) {
+	// Philox makes its values in groups of 4, every reservation starts a group of its own
+	uint64_t reserved = (count + 3) / 4 * 4;
+	return philox_offset{seed, offset.fetch_add(reserved)};
+}
+
+uint64_t random_generator::next_seed() {
+	return mix(seed ^ mix(num_seeds.fetch_add(1)));
+}
+
+}  // namespace utilities
+}  // namespace ral
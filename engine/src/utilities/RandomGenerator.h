@@ -0,0 +1,47 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace ral {
+namespace utilities {
+
+/**
+* The random numbers of the engine, for RAND() and the samples of the tables. They come from counter based Philox
+* generators, whose state is just a seed and where they are in their sequence, so they don't need a setup kernel for
+* every call like the curandState of every thread did. Every call reserves its own part of the sequence with an atomic,
+* so the tasks of every stream get different numbers without sharing any state in the device.
+*/
+class random_generator {
+public:
+	struct philox_offset {
+		uint64_t seed;
+		uint64_t offset; /**< The first of the reserved values of every subsequence. */
+	};
+
+	static random_generator & get_instance() {
+		static random_generator instance;
+		return instance;
+	}
+
+	/**
+	* Reserves count 32 bit values of every subsequence, usually one per row, for curand_init(seed, row, offset, state)
+	* of a curandStatePhilox4_32_10_t.
+	*/
+	philox_offset reserve(uint64_t count);
+
+	/**
+	* A seed that is different every time, for the functions that take a seed, like cudf::sample.
+	*/
+	uint64_t next_seed();
+
+private:
+	random_generator();
+
+	uint64_t seed; /**< From std::random_device, once per process. */
+	std::atomic<uint64_t> offset{0};
+	std::atomic<uint64_t> num_seeds{0};
+};
+
+}  // namespace utilities
+}  // namespace ral
@@ -0,0 +1,233 @@
+#include "RuntimeMetrics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <sstream>
+
+#include "bmr/BlazingMemoryResource.h"
+#include "communication/CommunicationInterface/protocols.hpp"
+#include "communication/CommunicationInterface/transportMetrics.hpp"
+#include "execution_graph/executor.h"
+
+namespace ral {
+namespace utilities {
+
+namespace {
+
+void write_header(std::ostringstream & out, const std::string & name, const std::string & type, const std::string & help) {
+	out << "# TYPE " << name << " " << type << "\n";
+	out << "# HELP " << name << " " << help << "\n";
+}
+
+// the buckets are cumulative in OpenMetrics, the upper bound of bucket i is 2^i microseconds. The sum is left out
+// when it is negative, for the histograms that don't keep it
+void write_histogram(std::ostringstream & out, const std::string & name, const std::string & labels,
+		const std::vector<uint64_t> & buckets, int64_t sum_us) {
+	std::string separator = labels.empty() ? "" : ",";
+	std::string braced_labels = labels.empty() ? "" : "{" + labels + "}";
+	uint64_t cumulative = 0;
+	for (std::size_t i = 0; i < buckets.size(); i++) {
+		cumulative += buckets[i];
+		if (i + 1 < buckets.size()) {
+			out << name << "_bucket{" << labels << separator << "le=\"" << static_cast<double>(uint64_t{1} << i) / 1e6 << "\"} " << cumulative << "\n";
+		}
+	}
+	out << name << "_bucket{" << labels << separator << "le=\"+Inf\"} " << cumulative << "\n";
+	out << name << "_count" << braced_labels << " " << cumulative << "\n";
+	if (sum_us >= 0) {
+		out << name << "_sum" << braced_labels << " " << static_cast<double>(sum_us) / 1e6 << "\n";
+	}
+}
+
+// the label values can't have quotes, backslashes or line breaks unescaped
+std::string escape_label(const std::string & value) {
+	std::string escaped;
+	for (char c : value) {
+		if (c == '"' || c == '\\') {
+			escaped += '\\';
+			escaped += c;
+		} else if (c == '\n') {
+			escaped += "\\n";
+		} else {
+			escaped += c;
+		}
+	}
+	return escaped;
+}
+
+}  // namespace
+
+atomic_histogram::atomic_histogram() : count{0}, sum_us{0} {
+	for (auto & bucket : buckets) {
+		bucket.store(0);
+	}
+}
+
+std::size_t atomic_histogram::bucket(double seconds) {
+	double microseconds = seconds * 1e6;
+	std::size_t bucket = 0;
+	while (bucket < num_buckets - 1 && microseconds >= static_cast<double>(uint64_t{1} << bucket)) {
+		bucket++;
+	}
+	return bucket;
+}
+
+void atomic_histogram::record(double seconds) {
+	buckets[bucket(seconds)].fetch_add(1, std::memory_order_relaxed);
+	count.fetch_add(1, std::memory_order_relaxed);
+	sum_us.fetch_add(static_cast<uint64_t>(std::llround(seconds * 1e6)), std::memory_order_relaxed);
+}
+
+std::vector<uint64_t> atomic_histogram::get_buckets() const {
+	std::vector<uint64_t> values;
+	for (auto & bucket : buckets) {
+		values.push_back(bucket.load(std::memory_order_relaxed));
+	}
+	return values;
+}
+
+runtime_metrics::runtime_metrics()
+	: host_spills{0}, host_spill_bytes{0}, disk_spills{0}, disk_spill_bytes{0}, unspills{0}, unspill_bytes{0}, oom_retries{0} {}
+
+void runtime_metrics::record_spill(spill_tier tier, std::size_t bytes) {
+	if (tier == spill_tier::host) {
+		host_spills.fetch_add(1, std::memory_order_relaxed);
+		host_spill_bytes.fetch_add(bytes, std::memory_order_relaxed);
+	} else {
+		disk_spills.fetch_add(1, std::memory_order_relaxed);
+		disk_spill_bytes.fetch_add(bytes, std::memory_order_relaxed);
+	}
+}
+
+void runtime_metrics::record_unspill(std::size_t bytes) {
+	unspills.fetch_add(1, std::memory_order_relaxed);
+	unspill_bytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void runtime_metrics::record_oom_retry() {
+	oom_retries.fetch_add(1, std::memory_order_relaxed);
+}
+
+void runtime_metrics::record_task(double seconds) {
+	task_durations.record(seconds);
+}
+
+uint64_t runtime_metrics::get_spills(spill_tier tier) const {
+	return (tier == spill_tier::host ? host_spills : disk_spills).load(std::memory_order_relaxed);
+}
+
+uint64_t runtime_metrics::get_spill_bytes(spill_tier tier) const {
+	return (tier == spill_tier::host ? host_spill_bytes : disk_spill_bytes).load(std::memory_order_relaxed);
+}
+
+uint64_t runtime_metrics::get_unspills() const {
+	return unspills.load(std::memory_order_relaxed);
+}
+
+uint64_t runtime_metrics::get_unspill_bytes() const {
+	return unspill_bytes.load(std::memory_order_relaxed);
+}
+
+uint64_t runtime_metrics::get_oom_retries() const {
+	return oom_retries.load(std::memory_order_relaxed);
+}
+
+std::string runtime_metrics::to_openmetrics() {
+	std::ostringstream out;
+
+	std::map<int, ral::execution::executor *> executors = ral::execution::executor::get_all_instances();
+	write_header(out, "blazingsql_executor_queued_tasks", "gauge", "Tasks waiting to run.");
+	for (auto & executor : executors) {
+		out << "blazingsql_executor_queued_tasks{device=\"" << executor.first << "\"} " << executor.second->get_num_queued_tasks() << "\n";
+	}
+	write_header(out, "blazingsql_executor_active_tasks", "gauge", "Tasks running.");
+	for (auto & executor : executors) {
+		out << "blazingsql_executor_active_tasks{device=\"" << executor.first << "\"} " << executor.second->get_num_active_tasks() << "\n";
+	}
+	write_header(out, "blazingsql_tasks", "counter", "Tasks that ran.");
+	out << "blazingsql_tasks_total " << task_durations.get_count() << "\n";
+	write_header(out, "blazingsql_task_duration_seconds", "histogram", "How long the tasks took to decache their inputs and process them.");
+	write_histogram(out, "blazingsql_task_duration_seconds", "", task_durations.get_buckets(), task_durations.get_sum_us());
+	write_header(out, "blazingsql_oom_retries", "counter", "Tasks that ran out of GPU memory and were queued again.");
+	out << "blazingsql_oom_retries_total " << get_oom_retries() << "\n";
+
+	std::vector<std::pair<std::string, BlazingMemoryResource *>> tiers = {
+		{"gpu", &blazing_device_memory_resource::getInstance()},
+		{"host", &blazing_host_memory_resource::getInstance()},
+		{"disk", &blazing_disk_memory_resource::getInstance()}};
+	write_header(out, "blazingsql_memory_used_bytes", "gauge", "Memory used by the engine, by tier.");
+	for (auto & tier : tiers) {
+		out << "blazingsql_memory_used_bytes{tier=\"" << tier.first << "\"} " << tier.second->get_memory_used() << "\n";
+	}
+	write_header(out, "blazingsql_memory_limit_bytes", "gauge", "Memory the engine tries to stay under before spilling, by tier.");
+	for (auto & tier : tiers) {
+		out << "blazingsql_memory_limit_bytes{tier=\"" << tier.first << "\"} " << tier.second->get_memory_limit() << "\n";
+	}
+	write_header(out, "blazingsql_memory_total_bytes", "gauge", "Total memory of every tier.");
+	for (auto & tier : tiers) {
+		out << "blazingsql_memory_total_bytes{tier=\"" << tier.first << "\"} " << tier.second->get_total_memory() << "\n";
+	}
+
+	write_header(out, "blazingsql_spills", "counter", "Tables moved out of the GPU, or from the host to the disk, by the tier they went to.");
+	out << "blazingsql_spills_total{tier=\"host\"} " << get_spills(spill_tier::host) << "\n";
+	out << "blazingsql_spills_total{tier=\"disk\"} " << get_spills(spill_tier::disk) << "\n";
+	write_header(out, "blazingsql_spill_bytes", "counter", "Bytes moved out of the GPU, or from the host to the disk, by the tier they went to.");
+	out << "blazingsql_spill_bytes_total{tier=\"host\"} " << get_spill_bytes(spill_tier::host) << "\n";
+	out << "blazingsql_spill_bytes_total{tier=\"disk\"} " << get_spill_bytes(spill_tier::disk) << "\n";
+	write_header(out, "blazingsql_unspills", "counter", "Tables moved back into the GPU for a task.");
+	out << "blazingsql_unspills_total " << get_unspills() << "\n";
+	write_header(out, "blazingsql_unspill_bytes", "counter", "Bytes moved back into the GPU for a task.");
+	out << "blazingsql_unspill_bytes_total " << get_unspill_bytes() << "\n";
+
+	std::map<std::string, comm::peer_metrics_snapshot> peers = comm::transport_metrics::get_instance().get_snapshot();
+	write_header(out, "blazingsql_peer_sent_bytes", "counter", "Bytes sent to every other node.");
+	for (auto & peer : peers) {
+		out << "blazingsql_peer_sent_bytes_total{peer=\"" << escape_label(peer.first) << "\"} " << peer.second.bytes_sent << "\n";
+	}
+	write_header(out, "blazingsql_peer_received_bytes", "counter", "Bytes received from every other node.");
+	for (auto & peer : peers) {
+		out << "blazingsql_peer_received_bytes_total{peer=\"" << escape_label(peer.first) << "\"} " << peer.second.bytes_received << "\n";
+	}
+	write_header(out, "blazingsql_peer_sent_messages", "counter", "Messages sent to every other node.");
+	for (auto & peer : peers) {
+		out << "blazingsql_peer_sent_messages_total{peer=\"" << escape_label(peer.first) << "\"} " << peer.second.messages_sent << "\n";
+	}
+	write_header(out, "blazingsql_peer_received_messages", "counter", "Messages received from every other node.");
+	for (auto & peer : peers) {
+		out << "blazingsql_peer_received_messages_total{peer=\"" << escape_label(peer.first) << "\"} " << peer.second.messages_received << "\n";
+	}
+	write_header(out, "blazingsql_peer_queued_messages", "gauge", "Messages waiting to be sent to every other node.");
+	for (auto & peer : peers) {
+		out << "blazingsql_peer_queued_messages{peer=\"" << escape_label(peer.first) << "\"} " << peer.second.queued_messages << "\n";
+	}
+	write_header(out, "blazingsql_peer_send_duration_seconds", "histogram", "How long the sends to every other node took.");
+	for (auto & peer : peers) {
+		write_histogram(out, "blazingsql_peer_send_duration_seconds", "peer=\"" + escape_label(peer.first) + "\"",
+			peer.second.send_latency_histogram, -1);
+	}
+
+	std::map<int32_t, ral::cache::graph_progress> queries = comm::graphs_info::getInstance().get_progress();
+	write_header(out, "blazingsql_query_kernels", "gauge", "Kernels of every running query.");
+	for (auto & query : queries) {
+		out << "blazingsql_query_kernels{query=\"" << query.first << "\"} " << query.second.kernel_descriptions.size() << "\n";
+	}
+	write_header(out, "blazingsql_query_finished_kernels", "gauge", "Kernels of every running query that finished.");
+	for (auto & query : queries) {
+		out << "blazingsql_query_finished_kernels{query=\"" << query.first << "\"} "
+			<< std::count(query.second.finished.begin(), query.second.finished.end(), true) << "\n";
+	}
+	write_header(out, "blazingsql_query_kernel_batches", "gauge", "Batches that every kernel of every running query has output.");
+	for (auto & query : queries) {
+		for (std::size_t i = 0; i < query.second.kernel_descriptions.size(); i++) {
+			out << "blazingsql_query_kernel_batches{query=\"" << query.first << "\",kernel=\""
+				<< escape_label(query.second.kernel_descriptions[i]) << "\"} " << query.second.batches_completed[i] << "\n";
+		}
+	}
+
+	out << "# EOF\n";
+	return out.str();
+}
+
+}  // namespace utilities
+}  // namespace ral
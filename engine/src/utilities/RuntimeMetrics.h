@@ -0,0 +1,124 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ral {
+namespace utilities {
+
+/**
+* A histogram of durations in power of two buckets of microseconds, made of atomic counters so that recording into it
+* never takes a lock. Bucket i counts the durations of less than 2^i microseconds that did not fit in the bucket
+* before, and the last bucket all the longer ones.
+*/
+class atomic_histogram {
+public:
+	static constexpr std::size_t num_buckets = 32;
+
+	atomic_histogram();
+
+	void record(double seconds);
+
+	/**
+	* Get the bucket of a duration.
+	*/
+	static std::size_t bucket(double seconds);
+
+	std::vector<uint64_t> get_buckets() const;
+
+	uint64_t get_count() const {
+		return count.load(std::memory_order_relaxed);
+	}
+
+	/**
+	* Get the sum of all the durations recorded, in microseconds.
+	*/
+	uint64_t get_sum_us() const {
+		return sum_us.load(std::memory_order_relaxed);
+	}
+
+private:
+	std::array<std::atomic<uint64_t>, num_buckets> buckets;
+	std::atomic<uint64_t> count;
+	std::atomic<uint64_t> sum_us;
+};
+
+/**
+* The tiers that the tables of the caches are spilled to.
+*/
+enum class spill_tier {
+	host,
+	disk
+};
+
+/**
+* Engine wide counters of the hot paths of the executor and the caches, that are exported with the gauges of the
+* executors, the memory resources, the transports and the running queries in the OpenMetrics text format, so that
+* Prometheus can scrape them. The counters are atomic and always on; the rates are left to the scraper.
+* @note Myers' singleton.
+*/
+class runtime_metrics {
+public:
+	static runtime_metrics & get_instance() {
+		static runtime_metrics instance;
+		return instance;
+	}
+
+	runtime_metrics(runtime_metrics &&) = delete;
+	runtime_metrics(const runtime_metrics &) = delete;
+	runtime_metrics & operator=(runtime_metrics &&) = delete;
+	runtime_metrics & operator=(const runtime_metrics &) = delete;
+
+	/**
+	* Counts a table that was moved out of the GPU, or from the host to the disk.
+	*/
+	void record_spill(spill_tier tier, std::size_t bytes);
+
+	/**
+	* Counts a table that was moved back into the GPU from the host or the disk.
+	*/
+	void record_unspill(std::size_t bytes);
+
+	/**
+	* Counts a task that ran out of GPU memory and was queued again.
+	*/
+	void record_oom_retry();
+
+	/**
+	* Counts a task that ran, with how long it took to decache its inputs and process them.
+	*/
+	void record_task(double seconds);
+
+	uint64_t get_spills(spill_tier tier) const;
+	uint64_t get_spill_bytes(spill_tier tier) const;
+	uint64_t get_unspills() const;
+	uint64_t get_unspill_bytes() const;
+	uint64_t get_oom_retries() const;
+
+	const atomic_histogram & get_task_durations() const {
+		return task_durations;
+	}
+
+	/**
+	* Get all the metrics of this process in the OpenMetrics text format, ending with "# EOF".
+	*/
+	std::string to_openmetrics();
+
+private:
+	runtime_metrics();
+
+	std::atomic<uint64_t> host_spills;
+	std::atomic<uint64_t> host_spill_bytes;
+	std::atomic<uint64_t> disk_spills;
+	std::atomic<uint64_t> disk_spill_bytes;
+	std::atomic<uint64_t> unspills;
+	std::atomic<uint64_t> unspill_bytes;
+	std::atomic<uint64_t> oom_retries;
+	atomic_histogram task_durations;
+};
+
+}  // namespace utilities
+}  // namespace ral
@@ -0,0 +1,139 @@
+#include "StreamForkJoin.h"
+
+#include <algorithm>
+#include <exception>
+#include <future>
+#include <cuda_runtime.h>
+
+#include "bmr/BlazingMemoryResource.h"
+#include "bmr/QueryMemoryTracker.h"
+#include "utilities/ThreadAffinity.h"
+
+namespace ral {
+namespace utilities {
+
+namespace {
+
+// the branches that fork again run their branches themselves, since they could be waiting for threads of the pool
+// that are waiting for them
+thread_local bool running_branch = false;
+
+struct branch_result {
+	std::exception_ptr exception;
+	int64_t memory_used = 0;
+	std::size_t peak_memory_used = 0;
+};
+
+}  // namespace
+
+stream_fork_join & stream_fork_join::get_instance() {
+	static stream_fork_join instance;
+	return instance;
+}
+
+void stream_fork_join::initialize(int num_streams) {
+	std::lock_guard<std::mutex> lock(mutex);
+	this->num_streams = std::max(num_streams, 1);
+	if (this->num_streams > 1 && pool == nullptr) {
+		pool = std::make_unique<ctpl::thread_pool<BlazingThread>>(this->num_streams - 1);
+	} else if (this->num_streams > 1) {
+		pool->resize(this->num_streams - 1);
+	}
+}
+
+int stream_fork_join::get_num_streams() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return num_streams;
+}
+
+void stream_fork_join::run(const std::vector<std::function<void()>> & branches) {
+	ctpl::thread_pool<BlazingThread> * branch_pool;
+	std::size_t num_groups;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		branch_pool = pool.get();
+		num_groups = std::min<std::size_t>(num_streams, branches.size());
+	}
+	if (num_groups < 2 || branch_pool == nullptr || running_branch) {
+		for (const auto & branch : branches) {
+			branch();
+		}
+		return;
+	}
+
+	// the branches are dealt round robin to the streams, the first one is the stream of the calling thread
+	auto run_group = [&branches, num_groups](std::size_t group) {
+		for (std::size_t i = group; i < branches.size(); i += num_groups) {
+			branches[i]();
+		}
+	};
+
+	int device_id = 0;
+	cudaGetDevice(&device_id);
+	ral::memory::allocation_owner owner = ral::memory::query_memory_tracker::get_thread_owner();
+
+	cudaEvent_t fork_event;
+	cudaEventCreateWithFlags(&fork_event, cudaEventDisableTiming);
+	cudaEventRecord(fork_event, cudaStreamPerThread);
+
+	std::vector<cudaEvent_t> join_events(num_groups - 1);
+	std::vector<branch_result> results(num_groups - 1);
+	std::vector<std::future<void>> futures;
+	for (std::size_t group = 1; group < num_groups; group++) {
+		cudaEventCreateWithFlags(&join_events[group - 1], cudaEventDisableTiming);
+		futures.push_back(branch_pool->push([&, group](int /*thread_id*/) {
+			cudaSetDevice(device_id);
+			thread_affinity::get_instance().pin_current_thread(thread_group::COMPUTE);
+			ral::memory::scoped_allocation_owner allocation_owner(owner.ctx_token, owner.kernel_id);
+			blazing_device_memory_resource::reset_thread_max_memory_used();
+			running_branch = true;
+
+			branch_result & result = results[group - 1];
+			cudaStreamWaitEvent(cudaStreamPerThread, fork_event, 0);
+			try {
+				run_group(group);
+			} catch (...) {
+				result.exception = std::current_exception();
+			}
+			// the event is recorded even if the branch failed, since its kernels may still be using the memory of the task
+			cudaEventRecord(join_events[group - 1], cudaStreamPerThread);
+
+			running_branch = false;
+			result.memory_used = blazing_device_memory_resource::get_thread_memory_used();
+			result.peak_memory_used = blazing_device_memory_resource::get_thread_max_memory_used();
+		}));
+	}
+
+	std::exception_ptr exception;
+	running_branch = true;
+	try {
+		run_group(0);
+	} catch (...) {
+		exception = std::current_exception();
+	}
+	running_branch = false;
+
+	for (auto & future : futures) {
+		future.wait();
+	}
+	int64_t memory_used = 0;
+	std::size_t peak_memory_used = 0;
+	for (std::size_t i = 0; i < results.size(); i++) {
+		cudaStreamWaitEvent(cudaStreamPerThread, join_events[i], 0);
+		cudaEventDestroy(join_events[i]);
+		memory_used += results[i].memory_used;
+		peak_memory_used += results[i].peak_memory_used;
+		if (!exception && results[i].exception) {
+			exception = results[i].exception;
+		}
+	}
+	cudaEventDestroy(fork_event);
+	blazing_device_memory_resource::add_thread_memory_used(memory_used, peak_memory_used);
+
+	if (exception) {
+		std::rethrow_exception(exception);
+	}
+}
+
+}  // namespace utilities
+}  // namespace ral
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "ExceptionHandling/BlazingThread.h"
+#include "utilities/ctpl_stl.h"
+
+namespace ral {
+namespace utilities {
+
+/**
+* Runs independent pieces of the work of a task, like the columns of a projection, at the same time on the GPU. The
+* engine is built with the per-thread default stream, so every thread that calls cudf queues its kernels on its own
+* stream. The first branch runs on the calling thread and the others on the threads of a small pool, each of them
+* on its own stream:
+*
+* - fork: an event is recorded on the stream of the calling thread, which the streams of the branches wait on, so
+*   that they see everything that was queued before, like the columns they read.
+* - join: every branch records an event on its stream after its work, which the stream of the calling thread waits
+*   on, so that what is queued after the join, like freeing the memory of the branches, waits for them.
+*
+* The memory of the branches is allocated on their streams by the stream ordered allocators of rmm, and is counted
+* for the task of the calling thread and for its query. A branch that forks again runs all of its branches itself,
+* so that the threads of the pool never wait on each other.
+*/
+class stream_fork_join {
+public:
+	static stream_fork_join & get_instance();
+
+	/**
+	* Sets how many streams the work of a task can run on (TASK_FORK_JOIN_STREAMS), the calling thread and
+	* num_streams - 1 threads of the pool. 1 or less runs all the branches on the calling thread.
+	*/
+	void initialize(int num_streams);
+
+	/**
+	* How many branches run at the same time, 1 if the branches run one after the other.
+	*/
+	int get_num_streams();
+
+	/**
+	* Runs the branches and waits for all of them, and for their streams on the stream of the calling thread.
+	* @throws the exception of the first branch that failed, after all of them are done, like rmm::bad_alloc so that
+	* the executor retries the task.
+	*/
+	void run(const std::vector<std::function<void()>> & branches);
+
+private:
+	stream_fork_join() = default;
+
+	std::mutex mutex;
+	std::unique_ptr<ctpl::thread_pool<BlazingThread>> pool;
+	int num_streams = 1;
+};
+
+}  // namespace utilities
+}  // namespace ral
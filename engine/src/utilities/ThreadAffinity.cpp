@@ -0,0 +1,150 @@
+#include "ThreadAffinity.h"
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <pthread.h>
+#include <sched.h>
+#include <cuda_runtime.h>
+
+#include "bmr/BufferProvider.h"
+
+namespace ral {
+namespace utilities {
+
+namespace {
+
+thread_local bool current_thread_pinned = false;
+
+// the cpus that are local to the PCI bus of the GPU, or the ones of its NUMA node if sysfs does not have them
+std::vector<int> get_device_local_cpus(int device_id) {
+	std::string cpu_list;
+	char pci_bus_id[32];
+	if (cudaDeviceGetPCIBusId(pci_bus_id, sizeof(pci_bus_id), device_id) == cudaSuccess) {
+		// sysfs uses lowercase hexadecimal digits in the pci addresses
+		std::string bus_id(pci_bus_id);
+		std::transform(bus_id.begin(), bus_id.end(), bus_id.begin(), ::tolower);
+		std::ifstream cpu_list_file("/sys/bus/pci/devices/" + bus_id + "/local_cpulist");
+		std::getline(cpu_list_file, cpu_list);
+	}
+	if (cpu_list.empty()) {
+		int numa_node = ral::memory::get_device_numa_node(device_id);
+		if (numa_node >= 0) {
+			std::ifstream cpu_list_file("/sys/devices/system/node/node" + std::to_string(numa_node) + "/cpulist");
+			std::getline(cpu_list_file, cpu_list);
+		}
+	}
+	try {
+		return ral::memory::parse_cpu_list(cpu_list);
+	} catch (const std::exception & e) {
+		return {};
+	}
+}
+
+// the cpus this process is allowed to run on, since a container or a cgroup can leave some of them out
+std::vector<int> get_allowed_cpus() {
+	std::vector<int> cpus;
+	cpu_set_t cpu_set;
+	if (sched_getaffinity(0, sizeof(cpu_set_t), &cpu_set) == 0) {
+		for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+			if (CPU_ISSET(cpu, &cpu_set)) {
+				cpus.push_back(cpu);
+			}
+		}
+	}
+	return cpus;
+}
+
+}  // namespace
+
+std::string format_cpu_list(const std::vector<int> & cpus) {
+	std::string cpu_list;
+	for (std::size_t i = 0; i < cpus.size();) {
+		std::size_t last = i;
+		while (last + 1 < cpus.size() && cpus[last + 1] == cpus[last] + 1) {
+			last++;
+		}
+		if (!cpu_list.empty()) {
+			cpu_list += ",";
+		}
+		cpu_list += std::to_string(cpus[i]);
+		if (last > i) {
+			cpu_list += "-" + std::to_string(cpus[last]);
+		}
+		i = last + 1;
+	}
+	return cpu_list;
+}
+
+thread_affinity & thread_affinity::get_instance() {
+	static thread_affinity instance;
+	return instance;
+}
+
+void thread_affinity::configure(const std::string & policy, int device_id, int num_comms_cores, int reserved_core) {
+	if (policy != "NONE" && policy != "GPU_LOCAL" && policy != "GPU_LOCAL_SPLIT") {
+		throw std::runtime_error("ERROR: the config option THREAD_AFFINITY_POLICY has to be NONE, GPU_LOCAL or GPU_LOCAL_SPLIT, it was '" + policy + "'");
+	}
+	std::lock_guard<std::mutex> lock(mutex);
+	this->policy = policy;
+	compute_cpus.clear();
+	comms_cpus.clear();
+	if (policy == "NONE") {
+		return;
+	}
+
+	std::vector<int> allowed_cpus = get_allowed_cpus();
+	std::vector<int> cpus;
+	for (int cpu : get_device_local_cpus(device_id)) {
+		if (cpu != reserved_core && std::find(allowed_cpus.begin(), allowed_cpus.end(), cpu) != allowed_cpus.end()) {
+			cpus.push_back(cpu);
+		}
+	}
+
+	// the comms threads only get cores of their own if there are some left for the tasks
+	if (policy == "GPU_LOCAL_SPLIT" && num_comms_cores > 0 && static_cast<std::size_t>(num_comms_cores) < cpus.size()) {
+		compute_cpus.assign(cpus.begin(), cpus.end() - num_comms_cores);
+		comms_cpus.assign(cpus.end() - num_comms_cores, cpus.end());
+	} else {
+		compute_cpus = cpus;
+		comms_cpus = cpus;
+	}
+}
+
+void thread_affinity::pin_current_thread(thread_group group) {
+	if (current_thread_pinned) {
+		return;
+	}
+	current_thread_pinned = true;
+
+	std::vector<int> cpus = get_cpus(group);
+	if (cpus.empty()) {
+		return;
+	}
+	cpu_set_t cpu_set;
+	CPU_ZERO(&cpu_set);
+	for (int cpu : cpus) {
+		CPU_SET(cpu, &cpu_set);
+	}
+	pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpu_set);
+}
+
+std::vector<int> thread_affinity::get_cpus(thread_group group) {
+	std::lock_guard<std::mutex> lock(mutex);
+	return group == thread_group::COMPUTE ? compute_cpus : comms_cpus;
+}
+
+std::string thread_affinity::describe() {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (policy == "NONE") {
+		return "thread affinity: NONE";
+	}
+	if (compute_cpus.empty()) {
+		return "thread affinity: " + policy + ", the cpus of the GPU are not known, the threads are not pinned";
+	}
+	return "thread affinity: " + policy + ", compute threads on cpus " + format_cpu_list(compute_cpus) +
+		", comms threads on cpus " + format_cpu_list(comms_cpus);
+}
+
+}  // namespace utilities
+}  // namespace ral
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ral {
+namespace utilities {
+
+/**
+* The kinds of threads of the engine that the thread_affinity places on cpus.
+*/
+enum class thread_group {
+	COMPUTE, // the threads of the executor, its prefetch pool and the kernel_run_pool
+	COMMS    // the threads of the message_listener and message_sender, and their pools
+};
+
+/**
+* Where the threads of the engine run. The threads are not pinned by default and the OS moves them around all the
+* cpus of the machine, so on a machine with more than one socket a thread can end up copying from and to the memory
+* of a GPU that is attached to the other socket.
+*
+* The policies (THREAD_AFFINITY_POLICY) are:
+* - NONE: the threads are not pinned.
+* - GPU_LOCAL: all the threads are pinned to the cpus that are local to the GPU, from the local_cpulist of its PCI
+*   device in sysfs.
+* - GPU_LOCAL_SPLIT: like GPU_LOCAL, but the COMMS threads get the last num_comms_cores of the cpus to themselves and
+*   the COMPUTE threads get the rest, so that the messages are not held up by the tasks.
+*
+* The core that the ucx progress thread is pinned to (UCX_PROGRESS_THREAD_CORE) is taken out of the cpus of both
+* groups, so that it has it to itself.
+*/
+class thread_affinity {
+public:
+	static thread_affinity & get_instance();
+
+	/**
+	* Sets up the cpus of the groups, it has to be called before the threads are started.
+	* @param policy NONE, GPU_LOCAL or GPU_LOCAL_SPLIT.
+	* @param device_id the CUDA device the engine runs on.
+	* @param num_comms_cores how many of the cpus the COMMS threads get with GPU_LOCAL_SPLIT.
+	* @param reserved_core the core of the ucx progress thread, -1 if it is not pinned.
+	*/
+	void configure(const std::string & policy, int device_id, int num_comms_cores, int reserved_core);
+
+	/**
+	* Pins the calling thread to the cpus of its group, once, so it can be called at the start of every task that runs
+	* on a thread of a pool. It does nothing with the NONE policy or if the cpus of the GPU are not known.
+	*/
+	void pin_current_thread(thread_group group);
+
+	std::vector<int> get_cpus(thread_group group);
+
+	/**
+	* The policy and the cpus of every group, for the logs.
+	*/
+	std::string describe();
+
+private:
+	thread_affinity() = default;
+
+	std::mutex mutex;
+	std::string policy = "NONE";
+	std::vector<int> compute_cpus;
+	std::vector<int> comms_cpus;
+};
+
+/**
+* Formats a list of cpus like the cpulist files of sysfs, i.e. "0-15,32-47".
+*/
+std::string format_cpu_list(const std::vector<int> & cpus);
+
+}  // namespace utilities
+}  // namespace ral
@@ -0,0 +1,131 @@
+#include "Tracer.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+namespace ral {
+namespace utilities {
+
+namespace {
+
+void write_json_string(std::ostringstream & out, const char * value) {
+	out << '"';
+	for(const char * c = value; c != nullptr && *c != '\0'; c++) {
+		if(*c == '"' || *c == '\\') {
+			out << '\\';
+		}
+		out << *c;
+	}
+	out << '"';
+}
+
+}  // namespace
+
+void tracer::start_tracing(int32_t query_id) {
+	std::lock_guard<std::mutex> lock(mutex_);
+	if(traced_queries.insert(query_id).second) {
+		num_traced_queries++;
+	}
+}
+
+void tracer::stop_tracing(int32_t query_id) {
+	std::lock_guard<std::mutex> lock(mutex_);
+	if(traced_queries.erase(query_id) > 0) {
+		num_traced_queries--;
+	}
+}
+
+bool tracer::is_tracing(int32_t query_id) {
+	if(!is_tracing()) {
+		return false;
+	}
+	std::lock_guard<std::mutex> lock(mutex_);
+	return traced_queries.find(query_id) != traced_queries.end();
+}
+
+tracer::thread_buffer & tracer::get_thread_buffer() {
+	static thread_local std::shared_ptr<thread_buffer> buffer;
+	if(buffer == nullptr) {
+		buffer = std::make_shared<thread_buffer>();
+		buffer->events.resize(events_per_thread);
+		std::lock_guard<std::mutex> lock(mutex_);
+		buffer->thread_id = thread_buffers.size();
+		thread_buffers.push_back(buffer);
+	}
+	return *buffer;
+}
+
+void tracer::record(const char * name, const char * category, int32_t query_id, int64_t id, int64_t start, int64_t duration) {
+	if(!is_tracing()) {
+		return;
+	}
+	thread_buffer & buffer = get_thread_buffer();
+	std::lock_guard<std::mutex> lock(buffer.mutex_);
+	trace_event & event = buffer.events[buffer.num_recorded % events_per_thread];
+	event.name = name;
+	event.category = category;
+	event.query_id = query_id;
+	event.id = id;
+	event.start = start;
+	event.duration = duration;
+	buffer.num_recorded++;
+}
+
+std::vector<std::pair<int, trace_event>> tracer::get_events(int32_t query_id) {
+	std::vector<std::shared_ptr<thread_buffer>> buffers;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		buffers = thread_buffers;
+	}
+
+	std::vector<std::pair<int, trace_event>> events;
+	for(auto & buffer : buffers) {
+		std::lock_guard<std::mutex> lock(buffer->mutex_);
+		std::size_t num_events = std::min(buffer->num_recorded, events_per_thread);
+		for(std::size_t i = buffer->num_recorded - num_events; i < buffer->num_recorded; i++) {
+			const trace_event & event = buffer->events[i % events_per_thread];
+			if(event.query_id == query_id) {
+				events.emplace_back(buffer->thread_id, event);
+			}
+		}
+	}
+	std::sort(events.begin(), events.end(), [](const std::pair<int, trace_event> & a, const std::pair<int, trace_event> & b) {
+		return a.second.start < b.second.start;
+	});
+	return events;
+}
+
+std::string tracer::export_chrome_trace(int32_t query_id, int process_id) {
+	std::ostringstream out;
+	out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	bool first = true;
+	for(auto & thread_event : get_events(query_id)) {
+		const trace_event & event = thread_event.second;
+		if(!first) {
+			out << ',';
+		}
+		first = false;
+		out << "{\"name\":";
+		write_json_string(out, event.name);
+		out << ",\"cat\":";
+		write_json_string(out, event.category);
+		out << ",\"ph\":\"X\",\"ts\":" << event.start << ",\"dur\":" << event.duration
+			<< ",\"pid\":" << process_id << ",\"tid\":" << thread_event.first
+			<< ",\"args\":{\"query_id\":" << event.query_id << ",\"id\":" << event.id << "}}";
+	}
+	out << "]}";
+	return out.str();
+}
+
+bool tracer::write_chrome_trace(int32_t query_id, int process_id, const std::string & path) {
+	std::ofstream file(path);
+	if(!file) {
+		return false;
+	}
+	file << export_chrome_trace(query_id, process_id);
+	return static_cast<bool>(file);
+}
+
+}  // namespace utilities
+}  // namespace ral
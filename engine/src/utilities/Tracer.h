@@ -0,0 +1,148 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace ral {
+namespace utilities {
+
+/**
+* A timestamped span recorded by the tracer.
+* The name and the category must be string literals, so that recording a span does not allocate.
+*/
+struct trace_event {
+	const char * name = nullptr;
+	const char * category = nullptr;
+	int32_t query_id = -1;
+	int64_t id = -1; /**< Kernel, cache or message specific identifier. -1 if it does not apply. */
+	int64_t start = 0; /**< Microseconds since the tracer was created. */
+	int64_t duration = 0; /**< In microseconds. */
+};
+
+/**
+* Records the spans of the hot paths of the engine (tasks, caches and communication) into a ring buffer per thread,
+* and exports the spans of a query as a Chrome trace (chrome://tracing and https://ui.perfetto.dev can open it).
+* Recording is only done while at least one query is being traced, so it costs an atomic load otherwise.
+* When a ring buffer is full the oldest spans of that thread are overwritten.
+*/
+class tracer {
+public:
+	static tracer & getInstance() {
+		static tracer instance;
+		return instance;
+	}
+
+	tracer(tracer &&) = delete;
+	tracer(const tracer &) = delete;
+	tracer & operator=(tracer &&) = delete;
+	tracer & operator=(const tracer &) = delete;
+
+	/**
+	* Starts recording the spans of a query.
+	*/
+	void start_tracing(int32_t query_id);
+
+	/**
+	* Stops recording the spans of a query. The spans already recorded can still be exported.
+	*/
+	void stop_tracing(int32_t query_id);
+
+	/**
+	* Lets us know if any query is being traced. This is the check done in the hot paths.
+	*/
+	bool is_tracing() const {
+		return num_traced_queries.load(std::memory_order_relaxed) > 0;
+	}
+
+	/**
+	* Lets us know if a specific query is being traced.
+	*/
+	bool is_tracing(int32_t query_id);
+
+	/**
+	* Get the current time in microseconds since the tracer was created.
+	*/
+	int64_t now() const {
+		return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - epoch).count();
+	}
+
+	/**
+	* Records a span into the ring buffer of the calling thread. Does nothing if no query is being traced.
+	*/
+	void record(const char * name, const char * category, int32_t query_id, int64_t id, int64_t start, int64_t duration);
+
+	/**
+	* Get the spans of a query that are still in the ring buffers, as a Chrome trace JSON document.
+	* @param query_id the query whose spans we want.
+	* @param process_id used as the pid of the events, so that the traces of several nodes can be merged.
+	*/
+	std::string export_chrome_trace(int32_t query_id, int process_id);
+
+	/**
+	* Writes the Chrome trace of a query to a file.
+	* @return true if the file could be written.
+	*/
+	bool write_chrome_trace(int32_t query_id, int process_id, const std::string & path);
+
+	/**
+	* Get the spans of a query that are still in the ring buffers, together with the id of the thread that recorded them.
+	*/
+	std::vector<std::pair<int, trace_event>> get_events(int32_t query_id);
+
+	static constexpr std::size_t events_per_thread = 1 << 14;
+
+private:
+	tracer() : epoch(std::chrono::steady_clock::now()) {}
+
+	struct thread_buffer {
+		std::mutex mutex_; /**< Only contended while exporting. */
+		std::vector<trace_event> events; /**< Ring buffer of events_per_thread events. */
+		std::size_t num_recorded = 0; /**< Total number of events recorded, the next one goes to num_recorded % events_per_thread. */
+		int thread_id;
+	};
+
+	thread_buffer & get_thread_buffer();
+
+	std::chrono::steady_clock::time_point epoch;
+	std::atomic<int> num_traced_queries{0};
+	std::mutex mutex_; /**< Protects traced_queries and thread_buffers. */
+	std::set<int32_t> traced_queries;
+	std::vector<std::shared_ptr<thread_buffer>> thread_buffers; /**< Kept alive after their threads exit so their spans can be exported. */
+};
+
+/**
+* Records a span from its construction to its destruction, when tracing is enabled.
+*/
+class trace_scope {
+public:
+	trace_scope(const char * name, const char * category, int32_t query_id, int64_t id = -1)
+		: name(name), category(category), query_id(query_id), id(id),
+		  enabled(tracer::getInstance().is_tracing()), start(enabled ? tracer::getInstance().now() : 0) {}
+
+	~trace_scope() {
+		if(enabled) {
+			tracer & instance = tracer::getInstance();
+			instance.record(name, category, query_id, id, start, instance.now() - start);
+		}
+	}
+
+	trace_scope(const trace_scope &) = delete;
+	trace_scope & operator=(const trace_scope &) = delete;
+
+private:
+	const char * name;
+	const char * category;
+	int32_t query_id;
+	int64_t id;
+	bool enabled;
+	int64_t start;
+};
+
+}  // namespace utilities
+}  // namespace ral
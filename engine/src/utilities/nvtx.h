@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#ifdef NVTX_RANGES
+#include <nvToolsExt.h>
+#endif
+
+namespace ral {
+namespace utilities {
+
+/**
+* The colors of the NVTX ranges of every part of the engine, so that they can be told apart in the Nsight Systems
+* timeline at a glance.
+*/
+enum class nvtx_color : uint32_t {
+	kernel = 0xff76b900, /**< The tasks and the compute of the kernels. */
+	decache = 0xff00a0e0, /**< Moving the inputs of a task back into the GPU. */
+	serialization = 0xffffb000, /**< Copying tables to and from host buffers. */
+	comms = 0xffe03030, /**< Sending and receiving messages. */
+	spill = 0xffa040e0 /**< Moving tables out of the GPU, into host memory or disk. */
+};
+
+#ifdef NVTX_RANGES
+/**
+* A NVTX range of the BlazingSQL domain that lasts as long as this object. NVTX ranges are per thread, so it has to
+* end in the thread where it started.
+*/
+class nvtx_range {
+public:
+	nvtx_range(const std::string & name, nvtx_color color) {
+		static nvtxDomainHandle_t domain = nvtxDomainCreateA("BlazingSQL");
+		nvtxEventAttributes_t attributes = {0};
+		attributes.version = NVTX_VERSION;
+		attributes.size = NVTX_EVENT_ATTRIB_STRUCT_SIZE;
+		attributes.colorType = NVTX_COLOR_ARGB;
+		attributes.color = static_cast<uint32_t>(color);
+		attributes.messageType = NVTX_MESSAGE_TYPE_ASCII;
+		attributes.message.ascii = name.c_str();
+		nvtxDomainRangePushEx(domain, &attributes);
+		this->domain = domain;
+	}
+
+	~nvtx_range() {
+		nvtxDomainRangePop(domain);
+	}
+
+	nvtx_range(const nvtx_range &) = delete;
+	nvtx_range & operator=(const nvtx_range &) = delete;
+
+private:
+	nvtxDomainHandle_t domain;
+};
+#endif
+
+}  // namespace utilities
+}  // namespace ral
+
+#define BLAZING_NVTX_CONCAT_IMPL(a, b) a##b
+#define BLAZING_NVTX_CONCAT(a, b) BLAZING_NVTX_CONCAT_IMPL(a, b)
+
+/**
+* Opens a NVTX range until the end of the scope. Without the NVTX_RANGES build option it is compiled out, so the name
+* is not even evaluated.
+*/
+#ifdef NVTX_RANGES
+#define BLAZING_NVTX_RANGE(name, color) \
+	ral::utilities::nvtx_range BLAZING_NVTX_CONCAT(nvtx_range_, __LINE__)(name, ral::utilities::nvtx_color::color)
+#else
+#define BLAZING_NVTX_RANGE(name, color)
+#endif
@@ -0,0 +1,174 @@
+#include <cudf/binaryop.hpp>
+#include <cudf/copying.hpp>
+#include <cudf/reduction.hpp>
+#include <cudf/scalar/scalar_factories.hpp>
+#include <cudf/stream_compaction.hpp>
+#include <cudf/strings/convert/convert_datetime.hpp>
+#include <cudf/table/table_view.hpp>
+
+#include <cctype>
+
+#include "timestamp_parser.h"
+
+namespace ral {
+namespace utilities {
+
+namespace {
+
+// true when all the non null rows are true, the null rows are skipped
+bool all_true(const cudf::column_view & mask) {
+	if (mask.size() == mask.null_count()) {
+		return false;
+	}
+	std::unique_ptr<cudf::scalar> all = cudf::reduce(mask, cudf::make_all_aggregation<cudf::aggregation>(),
+		cudf::data_type{cudf::type_id::BOOL8});
+	return all->is_valid() && static_cast<cudf::numeric_scalar<bool> *>(all.get())->value();
+}
+
+bool any_true(const cudf::column_view & mask) {
+	std::unique_ptr<cudf::scalar> any = cudf::reduce(mask, cudf::make_any_aggregation<cudf::aggregation>(),
+		cudf::data_type{cudf::type_id::BOOL8});
+	return any->is_valid() && static_cast<cudf::numeric_scalar<bool> *>(any.get())->value();
+}
+
+// a format is matched by the strings that start with it
+bool all_match(const cudf::strings_column_view & column, const std::string & format) {
+	std::unique_ptr<cudf::column> matched = cudf::strings::is_timestamp(column, format);
+	return all_true(matched->view());
+}
+
+}  // namespace
+
+const std::vector<std::string> & get_timestamp_formats() {
+	static const std::vector<std::string> formats = {
+		"%Y-%m-%d %H:%M:%S.%f",
+		"%Y-%m-%dT%H:%M:%S.%f",
+		"%Y-%m-%d %H:%M:%S",
+		"%Y-%m-%dT%H:%M:%S",
+		"%Y-%m-%d %H:%M",
+		"%Y-%m-%dT%H:%M",
+		"%Y/%m/%d %H:%M:%S",
+		"%Y/%m/%d",
+		"%Y%m%d %H%M%S",
+		"%Y-%m-%d"};
+	return formats;
+}
+
+std::string timestamp_format_cache::get(const std::string & shape) {
+	std::lock_guard<std::mutex> lock(mutex_);
+	auto it = formats.find(shape);
+	return it != formats.end() ? it->second : "";
+}
+
+void timestamp_format_cache::put(const std::string & shape, const std::string & format) {
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (formats.size() >= max_entries) {
+		formats.clear();
+	}
+	formats[shape] = format;
+}
+
+void timestamp_format_cache::clear() {
+	std::lock_guard<std::mutex> lock(mutex_);
+	formats.clear();
+}
+
+std::string get_timestamp_shape(const std::string & str) {
+	std::string shape = str;
+	for (char & c : shape) {
+		if (std::isdigit(static_cast<unsigned char>(c))) {
+			c = 'd';
+		}
+	}
+	return shape;
+}
+
+std::string detect_timestamp_format(const cudf::strings_column_view & column, cudf::size_type sample_size) {
+	cudf::column_view sample = cudf::slice(column.parent(), {0, std::min(sample_size, column.size())})[0];
+	std::unique_ptr<cudf::table> valid_sample = cudf::drop_nulls(cudf::table_view{{sample}}, {0});
+	if (valid_sample->num_rows() == 0) {
+		return "";
+	}
+
+	std::unique_ptr<cudf::scalar> first = cudf::get_element(valid_sample->get_column(0).view(), 0);
+	std::string shape = get_timestamp_shape(static_cast<cudf::string_scalar *>(first.get())->to_string());
+	std::string cached_format = timestamp_format_cache::get_instance().get(shape);
+	if (!cached_format.empty() && all_match(valid_sample->get_column(0).view(), cached_format)) {
+		return cached_format;
+	}
+
+	// without a format for all of them, the one of most of them. Every string counts for the first format it matches,
+	// the most specific one, since the less specific ones match the start of it too
+	std::string best_format;
+	int64_t best_count = 0;
+	std::unique_ptr<cudf::column> matched;
+	for (const std::string & format : get_timestamp_formats()) {
+		std::unique_ptr<cudf::column> format_matched = cudf::strings::is_timestamp(valid_sample->get_column(0).view(), format);
+		if (matched == nullptr) {
+			matched = std::move(format_matched);
+			format_matched = std::make_unique<cudf::column>(matched->view());
+		} else {
+			// true > false, the strings this format matches and the ones before did not
+			std::unique_ptr<cudf::column> newly_matched = cudf::binary_operation(format_matched->view(), matched->view(),
+				cudf::binary_operator::GREATER, cudf::data_type{cudf::type_id::BOOL8});
+			matched = cudf::binary_operation(matched->view(), format_matched->view(),
+				cudf::binary_operator::LOGICAL_OR, cudf::data_type{cudf::type_id::BOOL8});
+			format_matched = std::move(newly_matched);
+		}
+		std::unique_ptr<cudf::scalar> count = cudf::reduce(format_matched->view(), cudf::make_sum_aggregation<cudf::aggregation>(),
+			cudf::data_type{cudf::type_id::INT64});
+		int64_t matched_count = count->is_valid() ? static_cast<cudf::numeric_scalar<int64_t> *>(count.get())->value() : 0;
+		if (matched_count == valid_sample->num_rows()) {
+			timestamp_format_cache::get_instance().put(shape, format);
+			return format;
+		}
+		if (matched_count > best_count) {
+			best_format = format;
+			best_count = matched_count;
+		}
+	}
+	return best_format;
+}
+
+std::unique_ptr<cudf::column> strings_to_timestamps(const cudf::column_view & column, cudf::data_type timestamp_type) {
+	const std::vector<std::string> & formats = get_timestamp_formats();
+	std::string format = detect_timestamp_format(column);
+	if (format.empty()) {
+		format = formats[2];  // "%Y-%m-%d %H:%M:%S", what was always used before
+	}
+
+	std::unique_ptr<cudf::column> timestamps = cudf::strings::to_timestamps(column, timestamp_type, format);
+	std::unique_ptr<cudf::column> matched = cudf::strings::is_timestamp(column, format);
+	if (all_true(matched->view()) || column.null_count() == column.size()) {
+		return timestamps;
+	}
+
+	// the rows that don't match the format of the column are parsed with the other formats they match
+	for (const std::string & other_format : formats) {
+		if (other_format == format) {
+			continue;
+		}
+		std::unique_ptr<cudf::column> other_matched = cudf::strings::is_timestamp(column, other_format);
+		// true > false, the rows this format matches and the ones before did not
+		std::unique_ptr<cudf::column> newly_matched = cudf::binary_operation(other_matched->view(), matched->view(),
+			cudf::binary_operator::GREATER, cudf::data_type{cudf::type_id::BOOL8});
+		if (!any_true(newly_matched->view())) {
+			continue;
+		}
+		std::unique_ptr<cudf::column> other_timestamps = cudf::strings::to_timestamps(column, timestamp_type, other_format);
+		timestamps = cudf::copy_if_else(timestamps->view(), other_timestamps->view(), matched->view());
+		matched = cudf::binary_operation(matched->view(), other_matched->view(),
+			cudf::binary_operator::LOGICAL_OR, cudf::data_type{cudf::type_id::BOOL8});
+		if (all_true(matched->view())) {
+			return timestamps;
+		}
+	}
+
+	// what none of the formats match is not a timestamp
+	std::unique_ptr<cudf::scalar> null_timestamp = cudf::make_timestamp_scalar(timestamp_type);
+	null_timestamp->set_valid(false);
+	return cudf::copy_if_else(timestamps->view(), *null_timestamp, matched->view());
+}
+
+}  // namespace utilities
+}  // namespace ral
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <cudf/column/column.hpp>
+#include <cudf/strings/strings_column_view.hpp>
+
+namespace ral {
+namespace utilities {
+
+/**
+ * @brief The formats that the casts of strings to timestamps and dates try, the most specific ones first, since a
+ * format also matches the strings that have more characters after it.
+ */
+const std::vector<std::string> & get_timestamp_formats();
+
+/**
+ * @brief Remembers the format of the timestamps of the strings with the same shape, the strings with their digits
+ * replaced by 'd', so that the batches of a column and the next queries on it check that format first.
+ * @note Myers' singleton.
+ */
+class timestamp_format_cache {
+public:
+	static timestamp_format_cache & get_instance() {
+		static timestamp_format_cache instance;
+		return instance;
+	}
+
+	timestamp_format_cache(timestamp_format_cache &&) = delete;
+	timestamp_format_cache(const timestamp_format_cache &) = delete;
+	timestamp_format_cache & operator=(timestamp_format_cache &&) = delete;
+	timestamp_format_cache & operator=(const timestamp_format_cache &) = delete;
+
+	/**
+	 * @return the format, or an empty string if there is none for the shape.
+	 */
+	std::string get(const std::string & shape);
+
+	void put(const std::string & shape, const std::string & format);
+	void clear();
+
+	static constexpr std::size_t max_entries = 1024;
+
+private:
+	timestamp_format_cache() = default;
+
+	std::mutex mutex_;
+	std::map<std::string, std::string> formats;
+};
+
+/**
+ * @brief Get the shape of a string for the timestamp_format_cache.
+ */
+std::string get_timestamp_shape(const std::string & str);
+
+/**
+ * @brief Finds the format that all the non null strings of a sample of the column match, checking them on the GPU, or
+ * the one that most of them match. Only a format that all of them match is put in the timestamp_format_cache.
+ *
+ * @param sample_size The number of rows from the start of the column that are checked.
+ * @return the format, or an empty string if none of get_timestamp_formats matches any of them.
+ */
+std::string detect_timestamp_format(const cudf::strings_column_view & column, cudf::size_type sample_size = 1024);
+
+/**
+ * @brief Parses a strings column into timestamps or dates. The column is parsed with the format detected from
+ * its first rows, and its rows that don't match it with the other formats they match. The strings that none of
+ * the formats match are null.
+ */
+std::unique_ptr<cudf::column> strings_to_timestamps(const cudf::column_view & column, cudf::data_type timestamp_type);
+
+}  // namespace utilities
+}  // namespace ral
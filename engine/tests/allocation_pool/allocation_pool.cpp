@@ -4,6 +4,7 @@
 
 #include <cudf_test/column_wrapper.hpp>
 #include "src/bmr/BufferProvider.h"
+#include <thread>
 
 
 
@@ -111,3 +112,108 @@ TEST_F(AllocationPoolTest, mem_map_test) {
     ASSERT_TRUE(attr.length != 0);
     ral::memory::empty_pools();
 }
+
+TEST_F(AllocationPoolTest, parse_cpu_list_test) {
+    std::vector<int> expected{0, 1, 2, 3, 8, 10, 11};
+    ASSERT_EQ(ral::memory::parse_cpu_list("0-3,8,10-11\n"), expected);
+    ASSERT_TRUE(ral::memory::parse_cpu_list("").empty());
+}
+
+TEST_F(AllocationPoolTest, thread_cache_test) {
+    auto pool = std::make_shared<ral::memory::allocation_pool>(
+        std::make_unique<ral::memory::host_allocator>(false), 4096, 10, 4);
+
+    auto chunk = pool->get_chunk();
+    char * data = chunk->data;
+    ASSERT_EQ(pool->get_allocated_buffers(), 1);
+    pool->free_chunk(std::move(chunk));
+    ASSERT_EQ(pool->get_allocated_buffers(), 0);
+
+    // the chunk that was just freed is kept by this thread, so it is the next one it gets
+    chunk = pool->get_chunk();
+    ASSERT_EQ(chunk->data, data);
+    pool->free_chunk(std::move(chunk));
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; i++) {
+        threads.emplace_back([pool]() {
+            for (int j = 0; j < 100; j++) {
+                std::vector<std::unique_ptr<ral::memory::blazing_allocation_chunk>> chunks;
+                for (int k = 0; k < 7; k++) {
+                    chunks.push_back(pool->get_chunk());
+                }
+                for (auto & chunk : chunks) {
+                    pool->free_chunk(std::move(chunk));
+                }
+            }
+        });
+    }
+    for (auto & thread : threads) {
+        thread.join();
+    }
+    ASSERT_EQ(pool->get_allocated_buffers(), 0);
+}
+
+TEST_F(AllocationPoolTest, lazy_pool_test) {
+    auto pool = std::make_shared<ral::memory::allocation_pool>(
+        std::make_unique<ral::memory::host_allocator>(false), 4096, 10, 0, true);
+    ASSERT_EQ(pool->get_total_buffers(), 0);
+
+    // the first chunk allocates all of the first buffers
+    auto chunk = pool->get_chunk();
+    ASSERT_EQ(pool->get_total_buffers(), 10);
+    ASSERT_EQ(pool->get_allocated_buffers(), 1);
+    pool->free_chunk(std::move(chunk));
+    ASSERT_EQ(pool->get_allocated_buffers(), 0);
+}
+
+TEST_F(AllocationPoolTest, size_class_test) {
+    auto pool = std::make_shared<ral::memory::allocation_pool>(
+        std::make_unique<ral::memory::host_allocator>(false), 1 << 20, 4, 0);
+    pool->add_size_class(std::make_shared<ral::memory::allocation_pool>(
+        std::make_unique<ral::memory::host_allocator>(false), 1 << 18, 4, 0, true));
+
+    // the small buffers come from the size class, and the large ones from the pool
+    auto small_chunk = pool->get_chunk(1000);
+    ASSERT_EQ(small_chunk->size, 1 << 18);
+    auto large_chunk = pool->get_chunk(1 << 19);
+    ASSERT_EQ(large_chunk->size, 1 << 20);
+
+    auto stats = pool->get_usage_stats();
+    ASSERT_EQ(stats.total_bytes, 5 << 20);
+    ASSERT_EQ(stats.allocated_bytes, (1 << 20) + (1 << 18));
+
+    pool->free_chunk(std::move(small_chunk));
+    pool->free_chunk(std::move(large_chunk));
+    stats = pool->get_usage_stats();
+    ASSERT_EQ(stats.allocated_bytes, 0);
+    ASSERT_EQ(stats.high_water_bytes, (1 << 20) + (1 << 18));
+}
+
+TEST_F(AllocationPoolTest, shrink_test) {
+    auto pool = std::make_shared<ral::memory::allocation_pool>(
+        std::make_unique<ral::memory::host_allocator>(false), 4096, 4, 0);
+    pool->set_shrink_idle_time(std::chrono::milliseconds(50));
+
+    // the fifth chunk makes the pool grow by 2 chunks
+    std::vector<std::unique_ptr<ral::memory::blazing_allocation_chunk>> chunks;
+    for (int i = 0; i < 5; i++) {
+        chunks.push_back(pool->get_chunk());
+    }
+    ASSERT_EQ(pool->get_total_buffers(), 6);
+    for (auto & chunk : chunks) {
+        pool->free_chunk(std::move(chunk));
+    }
+
+    // the allocation it grew by is kept until it has been free for the idle time
+    ASSERT_EQ(pool->shrink(), 0);
+    ASSERT_EQ(pool->get_total_buffers(), 6);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    ASSERT_EQ(pool->shrink(), 2 * 4096);
+    ASSERT_EQ(pool->get_total_buffers(), 4);
+
+    auto stats = pool->get_usage_stats();
+    ASSERT_EQ(stats.grows, 1);
+    ASSERT_EQ(stats.shrinks, 1);
+    ASSERT_EQ(stats.total_bytes, 4 * 4096);
+}
@@ -4,12 +4,16 @@
 #include <src/execution_kernels/LogicalFilter.h>
 #include <src/execution_kernels/LogicalProject.h>
 #include <src/cache_machine/CacheMachine.h>
+#include <src/cache_machine/CacheDataLocalFile.h>
+#include <src/cache_machine/CPUCacheData.h>
 #include <src/utilities/DebuggingUtils.h>
+#include <src/utilities/CommonOperations.h>
 
 #include <cudf_test/column_wrapper.hpp>
 #include <cudf_test/table_utilities.hpp>
 #include <cudf_test/column_utilities.hpp>
 #include "bmr/BufferProvider.h"
+#include "communication/messages/GPUComponentMessage.h"
 
 using blazingdb::manager::Context;
 using blazingdb::transport::Node;
@@ -98,6 +102,31 @@ TEST_F(CacheMachineTest, CacheMachineTest) {
 	std::this_thread::sleep_for(std::chrono::seconds(1));
 }
 
+TEST_F(CacheMachineTest, DirectCacheMachineTest) {
+	std::vector<Node> nodes;
+	Node master_node;
+	std::string logicalPlan;
+	std::map<std::string, std::string> config_options;
+	std::string current_timestamp;
+	std::shared_ptr<Context> context = std::make_shared<Context>(0, nodes, master_node, logicalPlan, config_options, current_timestamp);
+	ral::cache::DirectCacheMachine cacheMachine(context, "");
+
+	auto compare_table = build_custom_table();
+	for(int i = 0; i < 3; ++i) {
+		cacheMachine.addToCache(build_custom_table());
+	}
+	EXPECT_EQ(cacheMachine.get_num_rows_added(), 3 * compare_table->num_rows());
+	EXPECT_EQ(cacheMachine.get_num_bytes_added(), 3 * compare_table->sizeInBytes());
+	EXPECT_EQ(cacheMachine.get_gpu_bytes(), 3 * compare_table->sizeInBytes());
+	cacheMachine.finish();
+
+	for(int i = 0; i < 3; ++i) {
+		auto cacheTable = cacheMachine.pullFromCache();
+		cudf::test::expect_tables_equivalent(compare_table->view(), cacheTable->view());
+	}
+	EXPECT_EQ(cacheMachine.pullFromCache(), nullptr);
+}
+
 
 TEST_F(CacheMachineTest, CPUCacheMachineTest) {
 	std::vector<Node> nodes;
@@ -128,3 +157,187 @@ TEST_F(CacheMachineTest, CPUCacheMachineTest) {
 
 	std::this_thread::sleep_for(std::chrono::seconds(1));
 }
+
+
+TEST_F(CacheMachineTest, RawLocalFileCacheDataTest) {
+	auto compare_table = build_custom_table();
+
+	for (auto spill_format : {ral::cache::SpillFormat::ORC, ral::cache::SpillFormat::RAW}) {
+		ral::cache::CacheDataLocalFile cache_data(build_custom_table(), "/tmp", "0", spill_format);
+		EXPECT_EQ(cache_data.get_spill_format(), spill_format);
+		EXPECT_EQ(cache_data.num_rows(), compare_table->num_rows());
+		EXPECT_GT(cache_data.fileSizeInBytes(), 0);
+
+		auto cacheTable = cache_data.decache();
+		cudf::test::expect_tables_equivalent(compare_table->view(), cacheTable->view());
+		EXPECT_EQ(cacheTable->names(), compare_table->names());
+	}
+}
+
+TEST_F(CacheMachineTest, HostTableLocalFileCacheDataTest) {
+	auto compare_table = build_custom_table();
+
+	// the host table is written to disk without going through the GPU, and it reads back like any RAW file
+	ral::cache::CPUCacheData cpu_cache_data(build_custom_table());
+	ral::cache::CacheDataLocalFile cache_data(cpu_cache_data.releaseHostTable(), "/tmp", "0");
+	EXPECT_EQ(cache_data.get_spill_format(), ral::cache::SpillFormat::RAW);
+	EXPECT_EQ(cache_data.num_rows(), compare_table->num_rows());
+	EXPECT_GT(cache_data.fileSizeInBytes(), 0);
+
+	auto cacheTable = cache_data.decache();
+	cudf::test::expect_tables_equivalent(compare_table->view(), cacheTable->view());
+	EXPECT_EQ(cacheTable->names(), compare_table->names());
+}
+
+TEST_F(CacheMachineTest, PartialDecacheTest) {
+	std::vector<int> column_indices = {4, 1};
+	auto compare_table = build_custom_table();
+	auto compare_view = compare_table->view().select(column_indices);
+	std::vector<std::string> compare_names = {"STRING", "INT32"};
+
+	std::vector<std::unique_ptr<ral::cache::CacheData>> cache_datas;
+	cache_datas.push_back(std::make_unique<ral::cache::CPUCacheData>(build_custom_table()));
+	cache_datas.push_back(std::make_unique<ral::cache::CacheDataLocalFile>(build_custom_table(), "/tmp", "0", ral::cache::SpillFormat::ORC));
+	cache_datas.push_back(std::make_unique<ral::cache::CacheDataLocalFile>(build_custom_table(), "/tmp", "0", ral::cache::SpillFormat::RAW));
+
+	for (auto & cache_data : cache_datas) {
+		auto cacheTable = cache_data->decache(column_indices);
+		cudf::test::expect_tables_equivalent(compare_view, cacheTable->view());
+		EXPECT_EQ(cacheTable->names(), compare_names);
+	}
+}
+
+TEST_F(CacheMachineTest, AsyncCPUCacheDataTest) {
+	auto compare_table = build_custom_table();
+	auto & copy_stream = ral::cache::host_copy_stream::get_instance();
+
+	ral::cache::CPUCacheData cache_data(build_custom_table(), copy_stream);
+	EXPECT_EQ(cache_data.num_rows(), compare_table->num_rows());
+
+	auto cacheTable = cache_data.decache();
+	cudf::test::expect_tables_equivalent(compare_table->view(), cacheTable->view());
+	EXPECT_EQ(cacheTable->names(), compare_table->names());
+
+	copy_stream.release_finished();
+	EXPECT_EQ(copy_stream.get_pending_bytes(), 0);
+}
+
+TEST_F(CacheMachineTest, CompressedCPUCacheDataTest) {
+	std::vector<int> column_indices = {4, 1};
+	auto compare_table = build_custom_table();
+
+	ral::cache::CPUCacheData cache_data(build_custom_table());
+	cache_data.compress();
+	EXPECT_EQ(cache_data.sizeInBytes(), ral::cache::CPUCacheData(build_custom_table()).sizeInBytes());
+
+	auto partialTable = cache_data.decache(column_indices);
+	cudf::test::expect_tables_equivalent(compare_table->view().select(column_indices), partialTable->view());
+
+	auto cacheTable = cache_data.decache();
+	cudf::test::expect_tables_equivalent(compare_table->view(), cacheTable->view());
+	EXPECT_EQ(cacheTable->names(), compare_table->names());
+
+	// what is written to disk is decompressed first
+	ral::cache::CacheDataLocalFile file_cache_data(cache_data.releaseHostTable(), "/tmp", "0");
+	auto fileTable = file_cache_data.decache();
+	cudf::test::expect_tables_equivalent(compare_table->view(), fileTable->view());
+}
+
+TEST_F(CacheMachineTest, DictionaryEncodedCPUCacheDataTest) {
+	std::vector<std::string> values;
+	std::vector<bool> valids;
+	for (int i = 0; i < 1000; i++) {
+		values.push_back(i % 3 == 0 ? "a long value that repeats" : "another long value that repeats");
+		valids.push_back(i % 7 != 0);
+	}
+	std::vector<std::unique_ptr<cudf::column>> columns;
+	columns.push_back(make_col<int32_t>(values.size()));
+	columns.push_back(cudf::test::strings_column_wrapper(values.begin(), values.end(), valids.begin()).release());
+	std::vector<std::string> column_names = {"INT32", "STRING"};
+	auto compare_table = std::make_unique<ral::frame::BlazingTable>(std::make_unique<cudf::table>(std::move(columns)), column_names);
+
+	ral::cache::CPUCacheData plain_cache_data(compare_table->toBlazingTableView().clone());
+	ral::communication::messages::set_dictionary_encoding(true);
+	ral::cache::CPUCacheData cache_data(compare_table->toBlazingTableView().clone());
+	ral::communication::messages::set_dictionary_encoding(false);
+	EXPECT_LT(cache_data.sizeInBytes() * 2, plain_cache_data.sizeInBytes());
+
+	auto cacheTable = cache_data.decache();
+	cudf::test::expect_tables_equivalent(compare_table->view(), cacheTable->view());
+	EXPECT_EQ(cacheTable->names(), compare_table->names());
+}
+
+TEST_F(CacheMachineTest, PackedCPUCacheDataTest) {
+	std::vector<int> column_indices = {4, 1};
+	auto compare_table = build_custom_table();
+	auto compare_view = compare_table->view().select(column_indices);
+	std::vector<std::string> compare_names = {"STRING", "INT32"};
+
+	ral::communication::messages::set_packed_transport_min_columns(1);
+	std::vector<std::unique_ptr<ral::cache::CacheData>> cache_datas;
+	std::vector<std::unique_ptr<ral::cache::CacheData>> partial_cache_datas;
+	for (auto * datas : {&cache_datas, &partial_cache_datas}) {
+		datas->push_back(std::make_unique<ral::cache::CPUCacheData>(build_custom_table()));
+		datas->push_back(std::make_unique<ral::cache::CacheDataLocalFile>(build_custom_table(), "/tmp", "0", ral::cache::SpillFormat::RAW));
+	}
+	ral::communication::messages::set_packed_transport_min_columns(32);
+
+	for (auto & cache_data : cache_datas) {
+		auto cacheTable = cache_data->decache();
+		cudf::test::expect_tables_equivalent(compare_table->view(), cacheTable->view());
+		EXPECT_EQ(cacheTable->names(), compare_table->names());
+	}
+
+	// the columns of a packed table share its buffer, but some of them can still be decached alone
+	for (auto & cache_data : partial_cache_datas) {
+		auto cacheTable = cache_data->decache(column_indices);
+		cudf::test::expect_tables_equivalent(compare_view, cacheTable->view());
+		EXPECT_EQ(cacheTable->names(), compare_names);
+	}
+}
+
+TEST_F(CacheMachineTest, NestedColumnsCacheDataTest) {
+	std::vector<std::unique_ptr<cudf::column>> columns;
+	columns.push_back(make_col<int32_t>(4));
+	columns.push_back(cudf::test::lists_column_wrapper<int32_t>{{1, 2}, {3}, {}, {4, 5, 6}}.release());
+	std::vector<std::string> column_names = {"INT32", "LIST"};
+	auto compare_table = std::make_unique<ral::frame::BlazingTable>(std::make_unique<cudf::table>(std::move(columns)), column_names);
+	EXPECT_TRUE(ral::utilities::has_nested_columns(compare_table->view()));
+
+	// the nested columns are packed and spilled as RAW, without flattening them
+	std::vector<std::unique_ptr<ral::cache::CacheData>> cache_datas;
+	cache_datas.push_back(std::make_unique<ral::cache::CPUCacheData>(compare_table->toBlazingTableView().clone()));
+	cache_datas.push_back(std::make_unique<ral::cache::CacheDataLocalFile>(compare_table->toBlazingTableView().clone(), "/tmp", "0", ral::cache::SpillFormat::ORC));
+	EXPECT_EQ(static_cast<ral::cache::CacheDataLocalFile *>(cache_datas.back().get())->get_spill_format(), ral::cache::SpillFormat::RAW);
+
+	for (auto & cache_data : cache_datas) {
+		auto cacheTable = cache_data->decache();
+		cudf::test::expect_tables_equivalent(compare_table->view(), cacheTable->view());
+		EXPECT_EQ(cacheTable->names(), compare_table->names());
+	}
+}
+
+TEST_F(CacheMachineTest, ConcatTablesInBatchesTest) {
+	std::size_t table_bytes = build_custom_table()->sizeInBytes();
+
+	std::vector<std::unique_ptr<ral::frame::BlazingTable>> tables;
+	for (int i = 0; i < 5; i++) {
+		tables.push_back(build_custom_table());
+	}
+	// the strings fit, so only the byte cap splits them, in their order
+	std::vector<std::unique_ptr<ral::frame::BlazingTable>> batches = ral::utilities::concatTablesInBatches(tables, 2 * table_bytes);
+	EXPECT_TRUE(tables.empty());
+	ASSERT_EQ(batches.size(), 3);
+	EXPECT_EQ(batches[0]->num_rows(), 20);
+	EXPECT_EQ(batches[1]->num_rows(), 20);
+	EXPECT_EQ(batches[2]->num_rows(), 10);
+	EXPECT_EQ(batches[0]->names(), build_custom_table()->names());
+
+	tables.clear();
+	for (int i = 0; i < 5; i++) {
+		tables.push_back(build_custom_table());
+	}
+	batches = ral::utilities::concatTablesInBatches(tables);
+	ASSERT_EQ(batches.size(), 1);
+	EXPECT_EQ(batches[0]->num_rows(), 50);
+}
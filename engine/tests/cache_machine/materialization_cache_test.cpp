@@ -0,0 +1,56 @@
+#include <gtest/gtest.h>
+
+#include <src/cache_machine/MaterializationCache.h>
+
+using ral::cache::materialization_cache;
+using ral::cache::materialized_result;
+
+struct MaterializationCacheTest : public ::testing::Test {
+	MaterializationCacheTest() { materialization_cache::get_instance().clear(); }
+	~MaterializationCacheTest() { materialization_cache::get_instance().clear(); }
+};
+
+std::shared_ptr<materialized_result> make_result(std::size_t bytes) {
+	auto result = std::make_shared<materialized_result>();
+	result->bytes = bytes;
+	return result;
+}
+
+TEST_F(MaterializationCacheTest, GetReturnsWhatWasPut) {
+	auto & cache = materialization_cache::get_instance();
+	auto result = make_result(100);
+	EXPECT_TRUE(cache.put("a", result, 1000));
+
+	EXPECT_EQ(cache.get("a"), result);
+	EXPECT_EQ(cache.get("b"), nullptr);
+	EXPECT_EQ(cache.get_total_bytes(), 100);
+
+	// putting the same fingerprint again replaces the result
+	auto new_result = make_result(300);
+	EXPECT_TRUE(cache.put("a", new_result, 1000));
+	EXPECT_EQ(cache.get("a"), new_result);
+	EXPECT_EQ(cache.get_total_bytes(), 300);
+	EXPECT_EQ(cache.size(), 1);
+}
+
+TEST_F(MaterializationCacheTest, EvictsLeastRecentlyUsed) {
+	auto & cache = materialization_cache::get_instance();
+	cache.put("a", make_result(400), 1000);
+	cache.put("b", make_result(400), 1000);
+	cache.get("a"); // now b is the least recently used one
+
+	EXPECT_TRUE(cache.put("c", make_result(400), 1000));
+	EXPECT_NE(cache.get("a"), nullptr);
+	EXPECT_EQ(cache.get("b"), nullptr);
+	EXPECT_NE(cache.get("c"), nullptr);
+	EXPECT_EQ(cache.get_total_bytes(), 800);
+}
+
+TEST_F(MaterializationCacheTest, DoesNotAddResultsBiggerThanTheLimit) {
+	auto & cache = materialization_cache::get_instance();
+	cache.put("a", make_result(400), 1000);
+
+	EXPECT_FALSE(cache.put("b", make_result(2000), 1000));
+	EXPECT_NE(cache.get("a"), nullptr);
+	EXPECT_EQ(cache.get("b"), nullptr);
+}
@@ -0,0 +1,122 @@
+#include "tests/utilities/BlazingUnitTest.h"
+
+#include <src/cache_machine/TableCache.h>
+
+#include <cudf_test/column_wrapper.hpp>
+#include <cudf_test/table_utilities.hpp>
+
+using ral::cache::cached_table;
+using ral::cache::table_cache;
+using ral::cache::table_cache_fill;
+
+struct TableCacheTest : public BlazingUnitTest {
+	TableCacheTest() { table_cache::get_instance().clear(); }
+	~TableCacheTest() { table_cache::get_instance().clear(); }
+};
+
+std::unique_ptr<ral::frame::BlazingTable> make_scan_batch() {
+	cudf::test::fixed_width_column_wrapper<int32_t> a{{1, 2, 3}};
+	cudf::test::fixed_width_column_wrapper<int64_t> b{{4, 5, 6}};
+	cudf::test::fixed_width_column_wrapper<double> c{{7.0, 8.0, 9.0}};
+	std::vector<std::unique_ptr<cudf::column>> columns;
+	columns.push_back(a.release());
+	columns.push_back(b.release());
+	columns.push_back(c.release());
+	return std::make_unique<ral::frame::BlazingTable>(std::make_unique<cudf::table>(std::move(columns)), std::vector<std::string>{"a", "b", "c"});
+}
+
+TEST_F(TableCacheTest, FillPutsTheCachedColumns) {
+	// the scan reads the columns 0, 1 and 2, and the columns 0 and 2 are cached
+	auto table = std::make_shared<cached_table>("t", std::vector<int>{0, 2});
+	table_cache_fill fill("t{v}", table, {0, 2}, 1000000);
+	auto batch = make_scan_batch();
+	fill.add(batch->toBlazingTableView());
+	fill.add(batch->toBlazingTableView());
+	EXPECT_EQ(table_cache::get_instance().get("t{v}"), nullptr);
+
+	EXPECT_TRUE(fill.finish());
+	auto cached = table_cache::get_instance().get("t{v}");
+	ASSERT_NE(cached, nullptr);
+	EXPECT_EQ(cached->num_batches(), 2);
+	EXPECT_EQ(cached->num_rows(), 6);
+	EXPECT_TRUE(cached->has_columns({2}));
+	EXPECT_FALSE(cached->has_columns({1, 2}));
+
+	auto column_c = cached->get_batch(1, {2});
+	EXPECT_EQ(column_c->names(), std::vector<std::string>{"c"});
+	cudf::test::fixed_width_column_wrapper<double> expected{{7.0, 8.0, 9.0}};
+	cudf::test::expect_columns_equal(column_c->view().column(0), expected);
+}
+
+TEST_F(TableCacheTest, AbandonedFillIsNotPut) {
+	auto table = std::make_shared<cached_table>("t", std::vector<int>{0});
+	table_cache_fill fill("t{v}", table, {0}, 1000000);
+	fill.add(make_scan_batch()->toBlazingTableView());
+	fill.abandon();
+	fill.add(make_scan_batch()->toBlazingTableView());
+
+	EXPECT_FALSE(fill.finish());
+	EXPECT_EQ(table_cache::get_instance().get("t{v}"), nullptr);
+}
+
+TEST_F(TableCacheTest, FillBiggerThanTheLimitIsNotPut) {
+	auto table = std::make_shared<cached_table>("t", std::vector<int>{0, 1, 2});
+	table_cache_fill fill("t{v}", table, {0, 1, 2}, 10);
+	fill.add(make_scan_batch()->toBlazingTableView());
+
+	EXPECT_FALSE(fill.finish());
+	EXPECT_EQ(table_cache::get_instance().size(), 0);
+}
+
+TEST_F(TableCacheTest, RemoveTableDropsAllItsVersions) {
+	for (std::string key : {"t{v1}", "t{v2}", "u{v1}"}) {
+		auto table = std::make_shared<cached_table>(key.substr(0, 1), std::vector<int>{0});
+		table->add_batch(make_scan_batch());
+		EXPECT_TRUE(table_cache::get_instance().put(key, table, 1000000));
+	}
+
+	table_cache::get_instance().remove_table("t");
+	EXPECT_EQ(table_cache::get_instance().get("t{v1}"), nullptr);
+	EXPECT_EQ(table_cache::get_instance().get("t{v2}"), nullptr);
+	EXPECT_NE(table_cache::get_instance().get("u{v1}"), nullptr);
+	EXPECT_EQ(table_cache::get_instance().size(), 1);
+}
+
+TEST_F(TableCacheTest, IndexFindsTheRowsInTheRanges) {
+	auto table = std::make_shared<cached_table>("t", std::vector<int>{0, 1}, std::vector<int>{1});
+	cudf::test::fixed_width_column_wrapper<int32_t> a{{1, 2, 3, 4, 5}, {1, 1, 1, 1, 1}};
+	cudf::test::fixed_width_column_wrapper<int64_t> b{{50, 10, 40, 10, 20}, {1, 1, 1, 0, 1}};
+	std::vector<std::unique_ptr<cudf::column>> columns;
+	columns.push_back(a.release());
+	columns.push_back(b.release());
+	table->add_batch(std::make_unique<ral::frame::BlazingTable>(std::make_unique<cudf::table>(std::move(columns)), std::vector<std::string>{"a", "b"}));
+	EXPECT_TRUE(table->has_index(1));
+	EXPECT_FALSE(table->has_index(0));
+
+	literal_range range;
+	range.type = cudf::data_type{cudf::type_id::INT32};
+	range.has_lower = true;
+	range.lower = "10";
+	range.has_upper = true;
+	range.upper = "40";
+	range.upper_inclusive = false;
+	// the null key is not in any range, and the rows keep their order
+	auto rows = table->get_batch(0, {0}, 1, {range});
+	cudf::test::fixed_width_column_wrapper<int32_t> expected{{2, 5}};
+	cudf::test::expect_columns_equal(rows->view().column(0), expected);
+
+	// the equalities of the same value give its rows once
+	literal_range point;
+	point.type = cudf::data_type{cudf::type_id::INT32};
+	point.has_lower = point.has_upper = true;
+	point.lower = point.upper = "40";
+	rows = table->get_batch(0, {0, 1}, 1, {point, point});
+	EXPECT_EQ(rows->num_rows(), 1);
+
+	// a literal that is not an integer is left to the filter, which gets all the rows
+	literal_range decimal_range;
+	decimal_range.type = cudf::data_type{cudf::type_id::FLOAT64};
+	decimal_range.has_upper = true;
+	decimal_range.upper = "15.5";
+	EXPECT_EQ(table->get_batch(0, {0}, 1, {decimal_range})->num_rows(), 5);
+}
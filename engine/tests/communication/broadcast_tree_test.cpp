@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+
+#include <src/distribution_utils/broadcast_tree.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace ral::distribution;
+
+namespace {
+
+// walks the tree from the sender, counting how many times every node gets the table and how many of those cross hosts
+void walk_tree(const std::string & sender, broadcast_groups subtree, const std::map<std::string, std::string> & worker_hosts,
+	std::map<std::string, int> & times_received, int & cross_host_sends, int depth, int & max_depth) {
+	max_depth = std::max(max_depth, depth);
+	for (auto & child : get_broadcast_children(subtree)) {
+		times_received[child.worker_id]++;
+		if (worker_hosts.at(child.worker_id) != worker_hosts.at(sender)) {
+			cross_host_sends++;
+		}
+		EXPECT_EQ(deserialize_broadcast_groups(serialize_broadcast_groups(child.subtree)), child.subtree);
+		walk_tree(child.worker_id, child.subtree, worker_hosts, times_received, cross_host_sends, depth + 1, max_depth);
+	}
+}
+
+}  // namespace
+
+TEST(BroadcastTreeTest, EveryNodeGetsTheTableOnce) {
+	std::map<std::string, std::string> worker_hosts;
+	std::vector<std::string> target_ids;
+	for (int i = 0; i < 64; i++) {
+		std::string worker_id = "worker" + std::to_string(i);
+		worker_hosts[worker_id] = "host" + std::to_string(i / 8);
+		if (i != 13) {
+			target_ids.push_back(worker_id);
+		}
+	}
+
+	auto groups = group_broadcast_targets(target_ids, "worker13", worker_hosts);
+	ASSERT_EQ(groups.size(), 8);
+	EXPECT_EQ(groups.front().size(), 7); // the other nodes of host1
+	EXPECT_EQ(worker_hosts[groups.front().front()], "host1");
+
+	std::map<std::string, int> times_received;
+	int cross_host_sends = 0;
+	int max_depth = 0;
+	walk_tree("worker13", groups, worker_hosts, times_received, cross_host_sends, 0, max_depth);
+
+	EXPECT_EQ(times_received.size(), target_ids.size());
+	for (auto & target_id : target_ids) {
+		EXPECT_EQ(times_received[target_id], 1);
+	}
+	EXPECT_EQ(cross_host_sends, 7);
+	EXPECT_LE(max_depth, 6);
+	EXPECT_LE(get_broadcast_children(groups).size(), 6);
+}
+
+TEST(BroadcastTreeTest, UnknownHostsAreGroupsOfTheirOwn) {
+	auto groups = group_broadcast_targets({"a", "b", "c"}, "self", {});
+	EXPECT_EQ(groups, (broadcast_groups{{"a"}, {"b"}, {"c"}}));
+
+	auto children = get_broadcast_children(broadcast_groups{{"a", "b", "c"}});
+	ASSERT_EQ(children.size(), 2);
+	EXPECT_EQ(children[0].worker_id, "b");
+	EXPECT_EQ(children[0].subtree, (broadcast_groups{{"c"}}));
+	EXPECT_EQ(children[1].worker_id, "a");
+	EXPECT_TRUE(children[1].subtree.empty());
+
+	EXPECT_TRUE(deserialize_broadcast_groups("").empty());
+}
@@ -0,0 +1,61 @@
+#include <gtest/gtest.h>
+
+#include <src/communication/CommunicationInterface/compression.hpp>
+
+#include <vector>
+
+using namespace comm;
+
+TEST(CompressionTest, CompressAndDecompress) {
+	std::vector<char> buffer(100000);
+	for (size_t i = 0; i < buffer.size(); i++) {
+		buffer[i] = static_cast<char>(i % 7);
+	}
+	std::vector<char> compressed(buffer.size());
+	std::size_t compressed_size = compress_buffer(buffer.data(), buffer.size(), compressed.data(), compressed.size());
+	ASSERT_GT(compressed_size, 0);
+	EXPECT_LT(compressed_size, buffer.size());
+
+	std::vector<char> decompressed(buffer.size());
+	decompress_buffer(compressed.data(), compressed_size, decompressed.data(), decompressed.size());
+	EXPECT_EQ(decompressed, buffer);
+
+	EXPECT_THROW(decompress_buffer(compressed.data(), compressed_size, decompressed.data(), decompressed.size() - 1), std::runtime_error);
+}
+
+TEST(CompressionTest, DoesNotCompressWhenItDoesNotGetSmaller) {
+	std::vector<char> buffer(1000);
+	unsigned int state = 12345;
+	for (auto & value : buffer) {
+		state = state * 1103515245 + 12345;
+		value = static_cast<char>(state >> 16);
+	}
+	std::vector<char> compressed(buffer.size());
+	EXPECT_EQ(compress_buffer(buffer.data(), buffer.size(), compressed.data(), compressed.size()), 0);
+}
+
+TEST(CompressionTest, PolicyComparesLinkAndCompression) {
+	EXPECT_FALSE(compression_policy(compression_mode::none).should_compress());
+	EXPECT_TRUE(compression_policy(compression_mode::lz4).should_compress());
+
+	// a slow link and a good ratio
+	compression_policy slow_link(compression_mode::automatic);
+	slow_link.record_send(1000000, 1.0);
+	slow_link.record_compression(1000000, 200000, 0.001);
+	for (int i = 0; i < 20; i++) {
+		EXPECT_TRUE(slow_link.should_compress());
+	}
+
+	// a fast link and a poor ratio, only the probes compress
+	compression_policy fast_link(compression_mode::automatic);
+	fast_link.record_send(1000000000, 0.01);
+	fast_link.record_compression(1000000, 900000, 0.001);
+	int num_compressed = 0;
+	for (int i = 0; i < 32; i++) {
+		num_compressed += fast_link.should_compress();
+	}
+	EXPECT_EQ(num_compressed, 2);
+
+	EXPECT_EQ(parse_compression_mode("auto"), compression_mode::automatic);
+	EXPECT_THROW(parse_compression_mode("gzip"), std::runtime_error);
+}
@@ -150,9 +150,9 @@ TEST_F(SendAndReceiveTest, SendAndReceiveTest0) {
   metadata.add_value(ral::cache::WORKER_IDS_METADATA_LABEL, "1");
   metadata.add_value(ral::cache::UNIQUE_MESSAGE_ID, std::to_string(1));
 
-  const std::string MESSAGE_ID_CONTENT = metadata.get_values()[ral::cache::QUERY_ID_METADATA_LABEL] + "_" +
-                                          metadata.get_values()[ral::cache::KERNEL_ID_METADATA_LABEL] + "_" +
-                                          metadata.get_values()[ral::cache::SENDER_WORKER_ID_METADATA_LABEL];
+  const std::string MESSAGE_ID_CONTENT = metadata.get_value(ral::cache::QUERY_ID_METADATA_LABEL) + "_" +
+                                          metadata.get_value(ral::cache::KERNEL_ID_METADATA_LABEL) + "_" +
+                                          metadata.get_value(ral::cache::SENDER_WORKER_ID_METADATA_LABEL);
 
   metadata.add_value(ral::cache::MESSAGE_ID, MESSAGE_ID_CONTENT);
     
@@ -192,9 +192,9 @@ TEST_F(SendAndReceiveTest, SendAndReceiveALOT) {
       metadata.add_value(ral::cache::WORKER_IDS_METADATA_LABEL, "1");
       metadata.add_value(ral::cache::UNIQUE_MESSAGE_ID, std::to_string(1));
 
-      const std::string MESSAGE_ID_CONTENT = metadata.get_values()[ral::cache::QUERY_ID_METADATA_LABEL] + "_" +
-                                              metadata.get_values()[ral::cache::KERNEL_ID_METADATA_LABEL] + "_" +
-                                              metadata.get_values()[ral::cache::SENDER_WORKER_ID_METADATA_LABEL];
+      const std::string MESSAGE_ID_CONTENT = metadata.get_value(ral::cache::QUERY_ID_METADATA_LABEL) + "_" +
+                                              metadata.get_value(ral::cache::KERNEL_ID_METADATA_LABEL) + "_" +
+                                              metadata.get_value(ral::cache::SENDER_WORKER_ID_METADATA_LABEL);
 
       metadata.add_value(ral::cache::MESSAGE_ID, MESSAGE_ID_CONTENT);
         
@@ -242,9 +242,9 @@ TEST_F(SendAndReceiveTest, SendAndReceiveALOT) {
       metadata.add_value(ral::cache::WORKER_IDS_METADATA_LABEL, "1");
       metadata.add_value(ral::cache::UNIQUE_MESSAGE_ID, std::to_string(1));
 
-      const std::string MESSAGE_ID_CONTENT = metadata.get_values()[ral::cache::QUERY_ID_METADATA_LABEL] + "_" +
-                                              metadata.get_values()[ral::cache::KERNEL_ID_METADATA_LABEL] + "_" +
-                                              metadata.get_values()[ral::cache::SENDER_WORKER_ID_METADATA_LABEL];
+      const std::string MESSAGE_ID_CONTENT = metadata.get_value(ral::cache::QUERY_ID_METADATA_LABEL) + "_" +
+                                              metadata.get_value(ral::cache::KERNEL_ID_METADATA_LABEL) + "_" +
+                                              metadata.get_value(ral::cache::SENDER_WORKER_ID_METADATA_LABEL);
 
       metadata.add_value(ral::cache::MESSAGE_ID, MESSAGE_ID_CONTENT);
         
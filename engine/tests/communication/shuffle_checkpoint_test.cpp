@@ -0,0 +1,136 @@
+#include <gtest/gtest.h>
+
+#include <src/distribution_utils/shuffle_checkpoint.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace ral::distribution;
+
+namespace {
+
+checkpoint_manifest make_manifest(std::size_t sender, std::size_t num_nodes, int32_t attempt) {
+	checkpoint_manifest manifest;
+	manifest.attempt = attempt;
+	manifest.kernel_name = "JoinPartitionKernel";
+	manifest.sender = sender;
+	manifest.num_nodes = num_nodes;
+	manifest.fingerprint = "0123456789abcdef";
+	for (std::size_t destination = 0; destination < num_nodes; destination++) {
+		checkpoint_partition partition;
+		partition.file_name = "part-" + std::to_string(sender) + "-" + std::to_string(attempt) + "-" + std::to_string(destination) + ".raw";
+		partition.destination = destination;
+		partition.cache_id = "output_a";
+		partition.column_names = {"o_orderkey", "o_custkey"};
+		manifest.partitions.push_back(partition);
+	}
+	return manifest;
+}
+
+std::vector<checkpoint_manifest> make_manifests(std::size_t num_nodes, int32_t attempt) {
+	std::vector<checkpoint_manifest> manifests;
+	for (std::size_t sender = 0; sender < num_nodes; sender++) {
+		manifests.push_back(make_manifest(sender, num_nodes, attempt));
+	}
+	return manifests;
+}
+
+}  // namespace
+
+TEST(ShuffleCheckpointTest, ManifestRoundTrip) {
+	checkpoint_manifest manifest = make_manifest(2, 4, 12345);
+	manifest.hash_partitions_per_node = 3;
+	manifest.partitions[1].message_id_prefix = "hash_partition_1_";
+	manifest.partitions[1].metadata["hash_partition"] = "1";
+	manifest.partitions[1].metadata["some.dotted.label"] = "a \"quoted\" value";
+	manifest.partitions[2].column_names = {};
+
+	checkpoint_manifest read = deserialize_checkpoint_manifest(serialize_checkpoint_manifest(manifest));
+	EXPECT_EQ(read.attempt, manifest.attempt);
+	EXPECT_EQ(read.kernel_name, manifest.kernel_name);
+	EXPECT_EQ(read.sender, manifest.sender);
+	EXPECT_EQ(read.num_nodes, manifest.num_nodes);
+	EXPECT_EQ(read.hash_partitions_per_node, manifest.hash_partitions_per_node);
+	EXPECT_EQ(read.fingerprint, manifest.fingerprint);
+	ASSERT_EQ(read.partitions.size(), manifest.partitions.size());
+	for (std::size_t i = 0; i < manifest.partitions.size(); i++) {
+		EXPECT_EQ(read.partitions[i].file_name, manifest.partitions[i].file_name);
+		EXPECT_EQ(read.partitions[i].destination, manifest.partitions[i].destination);
+		EXPECT_EQ(read.partitions[i].cache_id, manifest.partitions[i].cache_id);
+		EXPECT_EQ(read.partitions[i].message_id_prefix, manifest.partitions[i].message_id_prefix);
+		EXPECT_EQ(read.partitions[i].column_names, manifest.partitions[i].column_names);
+		EXPECT_EQ(read.partitions[i].metadata, manifest.partitions[i].metadata);
+	}
+}
+
+TEST(ShuffleCheckpointTest, ManifestCutShortThrows) {
+	std::string manifest = serialize_checkpoint_manifest(make_manifest(0, 2, 7));
+	EXPECT_THROW(deserialize_checkpoint_manifest(manifest.substr(0, manifest.size() / 2)), std::runtime_error);
+	EXPECT_THROW(deserialize_checkpoint_manifest(""), std::runtime_error);
+}
+
+TEST(ShuffleCheckpointTest, CompleteWithEveryNode) {
+	EXPECT_TRUE(is_complete_checkpoint(make_manifests(4, 7), "JoinPartitionKernel", 4, 1, 0, "0123456789abcdef"));
+	EXPECT_TRUE(is_complete_checkpoint(make_manifests(1, 7), "JoinPartitionKernel", 1, 1, 0, "0123456789abcdef"));
+	EXPECT_FALSE(is_complete_checkpoint({}, "JoinPartitionKernel", 4, 1, 0, "0123456789abcdef"));
+}
+
+TEST(ShuffleCheckpointTest, IncompleteWithoutANode) {
+	auto manifests = make_manifests(4, 7);
+	manifests.erase(manifests.begin() + 2);
+	EXPECT_FALSE(is_complete_checkpoint(manifests, "JoinPartitionKernel", 4, 1, 0, "0123456789abcdef"));
+
+	// the same node twice does not make up for the missing one
+	manifests.push_back(make_manifest(1, 4, 7));
+	EXPECT_FALSE(is_complete_checkpoint(manifests, "JoinPartitionKernel", 4, 1, 0, "0123456789abcdef"));
+}
+
+TEST(ShuffleCheckpointTest, IncompleteWithMixedAttempts) {
+	// a node overwrote its manifest in a later attempt that the others did not finish
+	auto manifests = make_manifests(4, 7);
+	manifests[0] = make_manifest(0, 4, 8);
+	EXPECT_FALSE(is_complete_checkpoint(manifests, "JoinPartitionKernel", 4, 1, 0, "0123456789abcdef"));
+}
+
+TEST(ShuffleCheckpointTest, IncompleteWithAnotherQueryShape) {
+	EXPECT_FALSE(is_complete_checkpoint(make_manifests(4, 7), "JoinPartitionKernel", 3, 1, 0, "0123456789abcdef"));
+	EXPECT_FALSE(is_complete_checkpoint(make_manifests(4, 7), "JoinPartitionKernel", 5, 1, 0, "0123456789abcdef"));
+	EXPECT_FALSE(is_complete_checkpoint(make_manifests(4, 7), "JoinPartitionKernel", 4, 2, 0, "0123456789abcdef"));
+	EXPECT_FALSE(is_complete_checkpoint(make_manifests(4, 7), "DistributeAggregateKernel", 4, 1, 0, "0123456789abcdef"));
+}
+
+TEST(ShuffleCheckpointTest, IncompleteWithAnotherFingerprint) {
+	// the plan or the inputs of this node changed since its manifest was written
+	EXPECT_FALSE(is_complete_checkpoint(make_manifests(4, 7), "JoinPartitionKernel", 4, 1, 0, "fedcba9876543210"));
+	EXPECT_FALSE(is_complete_checkpoint(make_manifests(4, 7), "JoinPartitionKernel", 4, 1, 0, ""));
+
+	// each node only checks its own manifest, the others are checked by their nodes
+	std::vector<checkpoint_manifest> manifests = make_manifests(4, 7);
+	manifests[2].fingerprint = "fedcba9876543210";
+	EXPECT_TRUE(is_complete_checkpoint(manifests, "JoinPartitionKernel", 4, 1, 0, "0123456789abcdef"));
+	EXPECT_FALSE(is_complete_checkpoint(manifests, "JoinPartitionKernel", 4, 1, 2, "0123456789abcdef"));
+}
+
+TEST(ShuffleCheckpointTest, ManifestWithoutFingerprintIsNeverComplete) {
+	std::string manifest = serialize_checkpoint_manifest(make_manifest(0, 1, 7));
+	std::size_t start = manifest.find("\"fingerprint\"");
+	ASSERT_NE(start, std::string::npos);
+	manifest.erase(start, manifest.find(',', start) + 1 - start);
+	checkpoint_manifest read = deserialize_checkpoint_manifest(manifest);
+	EXPECT_EQ(read.fingerprint, "");
+	EXPECT_FALSE(is_complete_checkpoint({read}, "JoinPartitionKernel", 1, 1, 0, "0123456789abcdef"));
+}
+
+TEST(ShuffleCheckpointTest, FingerprintOfPlanAndInputs) {
+	std::string plan = "LogicalProject(o_orderkey=[$0])\n  BindableTableScan(table=[[main, orders]])";
+	std::string fingerprint = make_checkpoint_fingerprint(plan, {"orders"}, {"/data/orders.parquet@100:2000"});
+	EXPECT_EQ(fingerprint.size(), 16u);
+	EXPECT_EQ(fingerprint, make_checkpoint_fingerprint(plan, {"orders"}, {"/data/orders.parquet@100:2000"}));
+	EXPECT_NE(fingerprint, make_checkpoint_fingerprint(plan, {"orders"}, {"/data/orders.parquet@101:2000"}));
+	EXPECT_NE(fingerprint, make_checkpoint_fingerprint(plan + " ", {"orders"}, {"/data/orders.parquet@100:2000"}));
+	EXPECT_NE(make_checkpoint_fingerprint(plan, {"a", "bc"}, {"v", "v"}), make_checkpoint_fingerprint(plan, {"ab", "c"}, {"v", "v"}));
+
+	// the tables in memory have no version, so nothing is restored
+	EXPECT_EQ(make_checkpoint_fingerprint(plan, {"orders", "lineitem"}, {"/data/orders.parquet@100:2000", ""}), "");
+}
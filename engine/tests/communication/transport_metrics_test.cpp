@@ -0,0 +1,43 @@
+#include <gtest/gtest.h>
+
+#include <src/communication/CommunicationInterface/transportMetrics.hpp>
+
+using namespace comm;
+
+TEST(TransportMetricsTest, CountsMessagesByPeer) {
+	auto & metrics = transport_metrics::get_instance();
+	metrics.register_peers({"worker_a", "worker_b"});
+
+	metrics.record_send("worker_a", 100, 0.0000005);
+	metrics.record_send("worker_a", 50, 0.003);
+	metrics.record_receive("worker_b", 70);
+	metrics.record_send("worker_c", 10, 0.001);
+
+	auto snapshot = metrics.get_snapshot();
+	EXPECT_EQ(snapshot["worker_a"].bytes_sent, 150);
+	EXPECT_EQ(snapshot["worker_a"].messages_sent, 2);
+	EXPECT_EQ(snapshot["worker_a"].send_latency_histogram[0], 1);
+	EXPECT_EQ(snapshot["worker_a"].send_latency_histogram[transport_metrics::latency_bucket(0.003)], 1);
+	EXPECT_EQ(snapshot["worker_b"].bytes_received, 70);
+	EXPECT_EQ(snapshot["worker_b"].messages_received, 1);
+	EXPECT_EQ(snapshot.count("worker_c"), 0);
+	EXPECT_EQ(snapshot[transport_metrics::unknown_peer_id].bytes_sent, 10);
+}
+
+TEST(TransportMetricsTest, CountsQueuedMessagesWhileTheGuardLives) {
+	auto & metrics = transport_metrics::get_instance();
+	metrics.register_peers({"worker_q"});
+	{
+		queued_message_guard guard({"worker_q"});
+		queued_message_guard moved{std::move(guard)};
+		EXPECT_EQ(metrics.get_snapshot()["worker_q"].queued_messages, 1);
+	}
+	EXPECT_EQ(metrics.get_snapshot()["worker_q"].queued_messages, 0);
+}
+
+TEST(TransportMetricsTest, LatencyBuckets) {
+	EXPECT_EQ(transport_metrics::latency_bucket(0), 0);
+	EXPECT_EQ(transport_metrics::latency_bucket(0.000001), 1);
+	EXPECT_EQ(transport_metrics::latency_bucket(0.000003), 2);
+	EXPECT_EQ(transport_metrics::latency_bucket(1000), peer_metrics::num_latency_buckets - 1);
+}
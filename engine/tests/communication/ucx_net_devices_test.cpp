@@ -0,0 +1,35 @@
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+
+#include <src/communication/ucx_net_devices.h>
+
+using namespace ral::communication;
+
+TEST(UcxNetDevicesTest, MeasuresHowCloseThePciDevicesAre) {
+	std::string gpu = "/sys/devices/pci0000:00/0000:00:01.0/0000:01:00.0/0000:02:00.0/0000:03:00.0";
+	std::string same_switch_nic = "/sys/devices/pci0000:00/0000:00:01.0/0000:01:00.0/0000:02:04.0/0000:05:00.0";
+	std::string other_switch_nic = "/sys/devices/pci0000:00/0000:00:03.0/0000:07:00.0";
+	std::string other_root_nic = "/sys/devices/pci0000:80/0000:80:01.0/0000:81:00.0";
+
+	EXPECT_GT(get_common_pci_depth(gpu, same_switch_nic), get_common_pci_depth(gpu, other_switch_nic));
+	EXPECT_GT(get_common_pci_depth(gpu, other_switch_nic), get_common_pci_depth(gpu, other_root_nic));
+	EXPECT_EQ(get_common_pci_depth(gpu, gpu), get_common_pci_depth(gpu, gpu + "/"));
+}
+
+TEST(UcxNetDevicesTest, SelectsTheDevicesOfEveryGpu) {
+	unsetenv("CUDA_VISIBLE_DEVICES");
+	EXPECT_EQ(select_ucx_net_devices("", 0, 2), "");
+	EXPECT_EQ(select_ucx_net_devices("mlx5_0:1,mlx5_1:1", 1, 2), "mlx5_0:1,mlx5_1:1");
+	EXPECT_EQ(select_ucx_net_devices("0=mlx5_0:1,mlx5_1:1; 1=mlx5_2:1", 0, 2), "mlx5_0:1,mlx5_1:1");
+	EXPECT_EQ(select_ucx_net_devices("0=mlx5_0:1,mlx5_1:1; 1=mlx5_2:1", 1, 2), "mlx5_2:1");
+	EXPECT_EQ(select_ucx_net_devices("0=mlx5_0:1,mlx5_1:1; 1=mlx5_2:1", 2, 2), "");
+
+	// every process sees its GPU as the device 0
+	setenv("CUDA_VISIBLE_DEVICES", "3,0", 1);
+	EXPECT_EQ(get_physical_device_index(0), 3);
+	EXPECT_EQ(select_ucx_net_devices("0=mlx5_0:1;3=mlx5_3:1", 0, 2), "mlx5_3:1");
+	setenv("CUDA_VISIBLE_DEVICES", "GPU-8f6c1a2e", 1);
+	EXPECT_EQ(get_physical_device_index(0), 0);
+	unsetenv("CUDA_VISIBLE_DEVICES");
+}
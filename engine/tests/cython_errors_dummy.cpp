@@ -15,7 +15,9 @@ PyObject *InitializeError_ = nullptr,
 				 *GetProductDetailsError_ = nullptr,
 				 *GetFreeMemoryError_ = nullptr,
 				 *ResetMaxMemoryUsedError_ = nullptr,
-				 *GetMaxMemoryUsedError_ = nullptr ;
+				 *GetMaxMemoryUsedError_ = nullptr,
+				 *GetQueryMemoryUsageError_ = nullptr,
+				 *GetTransportMetricsError_ = nullptr ;
 
 
 // PyErr_SetString
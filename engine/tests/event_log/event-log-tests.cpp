@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include <spdlog/sinks/ostream_sink.h>
+
+#include "tests/utilities/BlazingUnitTest.h"
+#include "utilities/EventLog.h"
+
+#define DESCR(d) RecordProperty("description", d)
+
+using namespace ral;
+
+struct EventLogTest : public BlazingUnitTest {
+	std::shared_ptr<spdlog::logger> make_logger(const std::string & name, std::ostringstream & out) {
+		auto sink = std::make_shared<spdlog::sinks::ostream_sink_mt>(out);
+		sink->set_pattern("%v");
+		auto logger = std::make_shared<spdlog::logger>(name, sink);
+		logger->set_level(spdlog::level::trace);
+		return logger;
+	}
+
+	std::vector<std::string> lines(const std::ostringstream & out) {
+		std::vector<std::string> result;
+		std::istringstream in(out.str());
+		std::string line;
+		while (std::getline(in, line)) {
+			result.push_back(line);
+		}
+		return result;
+	}
+};
+
+TEST_F(EventLogTest, formatsFieldsLikeTheLoggers) {
+	DESCR("the writer formats the fields of a line separated by '|', and so does log_event when the event_log is not running");
+
+	std::ostringstream sync_out;
+	auto sync_logger = make_logger("event_log_sync_test", sync_out);
+	utilities::log_event(sync_logger, 3, std::size_t{1024}, -1, 0.5, std::string("message_1"), "begin");
+
+	std::ostringstream async_out;
+	auto async_logger = make_logger("event_log_async_test", async_out);
+	utilities::event_log::get_instance().start({async_logger});
+	utilities::log_event(async_logger, 3, std::size_t{1024}, -1, 0.5, std::string("message_1"), "begin");
+	utilities::event_log::get_instance().stop();
+
+	EXPECT_EQ(lines(sync_out), std::vector<std::string>({"3|1024|-1|0.5|message_1|begin"}));
+	EXPECT_EQ(lines(async_out), lines(sync_out));
+}
+
+TEST_F(EventLogTest, keepsTheOrderOfEveryThread) {
+	DESCR("all the lines of all the threads are written when the event_log stops, and the lines of every thread in the order they were logged");
+
+	std::ostringstream out;
+	auto logger = make_logger("event_log_threads_test", out);
+	utilities::event_log::get_instance().start({logger}, 1);
+	uint64_t dropped = utilities::event_log::get_instance().get_num_dropped();
+
+	const int num_threads = 4;
+	const int lines_per_thread = 1000;
+	std::vector<std::thread> threads;
+	for (int t = 0; t < num_threads; t++) {
+		threads.emplace_back([&, t] {
+			for (int i = 0; i < lines_per_thread; i++) {
+				utilities::log_event(logger, t, i);
+			}
+		});
+	}
+	for (auto & thread : threads) {
+		thread.join();
+	}
+	utilities::event_log::get_instance().stop();
+
+	std::vector<int> next(num_threads, 0);
+	std::size_t num_lines = 0;
+	for (const std::string & line : lines(out)) {
+		std::size_t separator = line.find('|');
+		int t = std::stoi(line.substr(0, separator));
+		int i = std::stoi(line.substr(separator + 1));
+		EXPECT_GE(i, next[t]);
+		next[t] = i + 1;
+		num_lines++;
+	}
+	EXPECT_EQ(num_lines + (utilities::event_log::get_instance().get_num_dropped() - dropped), num_threads * lines_per_thread);
+}
+
+TEST_F(EventLogTest, dropsLinesWhenTheRingIsFull) {
+	DESCR("a thread that logs more lines than its ring buffer holds before the writer runs drops the rest instead of blocking");
+
+	std::ostringstream out;
+	auto logger = make_logger("event_log_full_test", out);
+	uint64_t dropped = utilities::event_log::get_instance().get_num_dropped();
+
+	for (std::size_t i = 0; i < utilities::event_log::records_per_thread + 10; i++) {
+		utilities::event_log::get_instance().push(logger.get(), i);
+	}
+	EXPECT_EQ(utilities::event_log::get_instance().get_num_dropped(), dropped + 10);
+
+	// the lines that were left are discarded when it starts, as their loggers could be gone
+	utilities::event_log::get_instance().start({logger});
+	utilities::event_log::get_instance().stop();
+	EXPECT_TRUE(out.str().empty());
+}
+
+TEST_F(EventLogTest, truncatesLongStrings) {
+	DESCR("the strings that don't fit in a record are truncated");
+
+	utilities::event_record record;
+	record.logger = nullptr;
+	record.num_fields = 0;
+	record.text_used = 0;
+	record.add(std::string(utilities::event_record::text_size + 10, 'a'));
+	record.add(std::string("b"));
+	record.add(7);
+
+	EXPECT_EQ(record.format(), std::string(utilities::event_record::text_size, 'a') + "||7");
+}
@@ -0,0 +1,41 @@
+#include <gtest/gtest.h>
+
+#include "bmr/EvictionPolicy.h"
+
+using ral::memory::eviction_candidate;
+using ral::memory::eviction_order;
+
+TEST(EvictionPolicyTest, DataConsumedLaterGoesFirst) {
+	eviction_candidate soon;
+	soon.bytes = 100;
+	eviction_candidate later = soon;
+	later.distance = 3;
+	eviction_candidate much_later = soon;
+	much_later.distance = 3;
+	much_later.batches_ahead = 10;
+
+	std::vector<std::size_t> expected = {2, 1, 0};
+	EXPECT_EQ(eviction_order({soon, later, much_later}), expected);
+}
+
+TEST(EvictionPolicyTest, ExpensiveAndReusedDataStays) {
+	eviction_candidate to_host;
+	to_host.batches_ahead = 2;
+	eviction_candidate to_disk = to_host;
+	to_disk.reload_cost_per_byte = ral::memory::disk_reload_cost_per_byte;
+	eviction_candidate build_side = to_host;
+	build_side.reuses = 4;
+
+	std::vector<std::size_t> expected = {0, 2, 1};
+	EXPECT_EQ(eviction_order({to_host, to_disk, build_side}), expected);
+}
+
+TEST(EvictionPolicyTest, BiggestFirstForTheSameValue) {
+	eviction_candidate small;
+	small.bytes = 10;
+	eviction_candidate big;
+	big.bytes = 1000;
+
+	std::vector<std::size_t> expected = {1, 0};
+	EXPECT_EQ(eviction_order({small, big}), expected);
+}
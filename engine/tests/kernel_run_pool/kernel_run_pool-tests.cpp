@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <stdexcept>
+
+#include "execution_graph/kernel_run_pool.h"
+
+#define DESCR(d) RecordProperty("description", d)
+
+using namespace ral;
+
+TEST(KernelRunPoolTest, moreWaitingKernelsThanThreads) {
+   DESCR("a chain of kernels that wait for the ones after them finishes with a single running kernel at a time");
+
+   const int num_kernels = 40;
+   execution::kernel_run_pool pool(1);
+   std::mutex mutex;
+   execution::blocking_condition_variable condition;
+   int started = 0;
+
+   std::vector<std::future<void>> futures;
+   for (int i = 0; i < num_kernels; i++) {
+      futures.push_back(pool.push([&]() {
+         std::unique_lock<std::mutex> lock(mutex);
+         started++;
+         condition.notify_all();
+         condition.wait(lock, [&]() { return started == num_kernels; });
+      }));
+   }
+   for (auto & future : futures) {
+      ASSERT_EQ(future.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+   }
+   EXPECT_EQ(started, num_kernels);
+}
+
+TEST(KernelRunPoolTest, limitsRunningKernels) {
+   DESCR("the kernels that don't wait run at most max_running_kernels at a time");
+
+   execution::kernel_run_pool pool(2);
+   std::atomic<int> running{0};
+   std::atomic<int> max_running{0};
+
+   std::vector<std::future<void>> futures;
+   for (int i = 0; i < 8; i++) {
+      futures.push_back(pool.push([&]() {
+         int now = ++running;
+         int seen = max_running.load();
+         while (now > seen && !max_running.compare_exchange_weak(seen, now)) {}
+         std::this_thread::sleep_for(std::chrono::milliseconds(20));
+         running--;
+      }));
+   }
+   for (auto & future : futures) {
+      future.get();
+   }
+   EXPECT_LE(max_running.load(), 2);
+}
+
+TEST(KernelRunPoolTest, keepsExceptions) {
+   DESCR("the exception of a kernel is in its future");
+
+   execution::kernel_run_pool pool(1);
+   auto future = pool.push([]() { throw std::runtime_error("ERROR: kernel failed"); });
+   EXPECT_THROW(future.get(), std::runtime_error);
+}
@@ -0,0 +1,44 @@
+#include <gtest/gtest.h>
+
+#include "execution_kernels/kernel_throughput.h"
+
+#define DESCR(d) RecordProperty("description", d)
+
+using namespace ral;
+
+TEST(KernelThroughputTest, needsSamples) {
+   DESCR("there is no suggestion until enough tasks with different input sizes are recorded");
+
+   cache::kernel_throughput throughput(0.1, 3);
+   throughput.record(1000, 20);
+   throughput.record(2000, 30);
+   EXPECT_FALSE(throughput.get_target_batch_bytes().first);
+
+   cache::kernel_throughput same_sizes(0.1, 3);
+   for (int i = 0; i < 5; i++) {
+      same_sizes.record(1000, 20);
+   }
+   EXPECT_FALSE(same_sizes.get_target_batch_bytes().first);
+}
+
+TEST(KernelThroughputTest, suggestsBatchThatAmortizesOverhead) {
+   DESCR("with an overhead of 1000us and a cost of 1us per KB, the overhead is 10% of a task of 9000KB");
+
+   cache::kernel_throughput throughput(0.1, 3, 1.0);
+   for (std::size_t kb = 100; kb <= 1000; kb += 100) {
+      throughput.record(kb * 1000, 1000 + kb);
+   }
+   auto target = throughput.get_target_batch_bytes();
+   EXPECT_TRUE(target.first);
+   EXPECT_NEAR(target.second, 9000000, 1000);
+}
+
+TEST(KernelThroughputTest, noSuggestionWithoutOverhead) {
+   DESCR("if the duration of the tasks is proportional to their size, batching does not help");
+
+   cache::kernel_throughput throughput(0.1, 3, 1.0);
+   for (std::size_t kb = 100; kb <= 1000; kb += 100) {
+      throughput.record(kb * 1000, kb);
+   }
+   EXPECT_FALSE(throughput.get_target_batch_bytes().first);
+}
@@ -843,3 +843,246 @@ TEST_F(PhysicalPlanGeneratorTest, wf_sum_agg_single_node)
 
 	ASSERT_EQ(p_tree, p_tree_cmp);
 }
+
+TEST_F(PhysicalPlanGeneratorTest, transform_json_tree_fuse_filters_into_project)
+{
+	//	Query
+	// 	select n_name from nation where n_nationkey > 5
+	//
+	//  Optimized Plan
+	//	LogicalProject(n_name=[$1])
+	//		LogicalFilter(condition=[>($0, 5)])
+	//			LogicalTableScan(table=[[main, nation]])
+
+	std::string logicalPlan =
+	R"raw(
+	{
+		"expr": "LogicalProject(n_name=[$1])",
+		"children": [
+			{
+				"expr": "LogicalFilter(condition=[>($0, 5)])",
+				"children": [
+					{
+						"expr": "LogicalTableScan(table=[[main, nation]])",
+						"children": []
+					}
+				]
+			}
+		]
+	}
+	)raw";
+
+	std::shared_ptr<Context> context = make_single_context(logicalPlan);
+	ral::batch::tree_processor tree{{}, context->clone(), {}, {}, {}, {}, true};
+
+	std::istringstream input(logicalPlan);
+	boost::property_tree::ptree p_tree;
+	boost::property_tree::read_json(input, p_tree);
+	tree.transform_json_tree(p_tree);
+
+	std::string jsonCompare =
+	R"raw(
+	{
+		"expr": "LogicalProject(n_name=[$1])",
+		"children": [
+			{
+				"expr": "LogicalTableScan(table=[[main, nation]])",
+				"children": []
+			}
+		],
+		"fused_filters": [
+			"LogicalFilter(condition=[>($0, 5)])"
+		]
+	}
+	)raw";
+
+	std::istringstream inputcmp(jsonCompare);
+	boost::property_tree::ptree p_tree_cmp;
+	boost::property_tree::read_json(inputcmp, p_tree_cmp);
+
+	ASSERT_EQ(p_tree, p_tree_cmp);
+}
+
+TEST_F(PhysicalPlanGeneratorTest, apply_common_subplan_reuse_self_join)
+{
+	//	Query
+	// 	with big as (select n_nationkey, n_regionkey from nation where n_nationkey > 5)
+	// 	select * from big b1 inner join big b2 on b1.n_regionkey = b2.n_nationkey
+	//
+	//  Optimized Plan
+	//	LogicalJoin(condition=[=($1, $2)], joinType=[inner])
+	//		LogicalProject(n_nationkey=[$0], n_regionkey=[$2])
+	//			LogicalFilter(condition=[>($0, 5)])
+	//				LogicalTableScan(table=[[main, nation]])
+	//		LogicalProject(n_nationkey=[$0], n_regionkey=[$2])
+	//			LogicalFilter(condition=[>($0, 5)])
+	//				LogicalTableScan(table=[[main, nation]])
+
+	std::string logicalPlan =
+	R"raw(
+	{
+		"expr": "LogicalJoin(condition=[=($1, $2)], joinType=[inner])",
+		"children": [
+			{
+				"expr": "LogicalProject(n_nationkey=[$0], n_regionkey=[$2])",
+				"children": [
+					{
+						"expr": "LogicalFilter(condition=[>($0, 5)])",
+						"children": [
+							{
+								"expr": "LogicalTableScan(table=[[main, nation]])",
+								"children": []
+							}
+						]
+					}
+				]
+			},
+			{
+				"expr": "LogicalProject(n_nationkey=[$0], n_regionkey=[$2])",
+				"children": [
+					{
+						"expr": "LogicalFilter(condition=[>($0, 5)])",
+						"children": [
+							{
+								"expr": "LogicalTableScan(table=[[main, nation]])",
+								"children": []
+							}
+						]
+					}
+				]
+			}
+		]
+	}
+	)raw";
+
+	std::shared_ptr<Context> context = make_single_context(logicalPlan);
+	ral::batch::tree_processor tree{{}, context->clone(), {}, {}, {}, {}, true};
+
+	std::istringstream input(logicalPlan);
+	boost::property_tree::ptree p_tree;
+	boost::property_tree::read_json(input, p_tree);
+	tree.apply_common_subplan_reuse(p_tree);
+
+	// the subplans inside the repeated projection are not spooled on their own
+	std::string jsonCompare =
+	R"raw(
+	{
+		"expr": "LogicalJoin(condition=[=($1, $2)], joinType=[inner])",
+		"children": [
+			{
+				"expr": "LogicalSpool",
+				"spool_id": "0",
+				"children": [
+					{
+						"expr": "LogicalProject(n_nationkey=[$0], n_regionkey=[$2])",
+						"children": [
+							{
+								"expr": "LogicalFilter(condition=[>($0, 5)])",
+								"children": [
+									{
+										"expr": "LogicalTableScan(table=[[main, nation]])",
+										"children": []
+									}
+								]
+							}
+						]
+					}
+				]
+			},
+			{
+				"expr": "LogicalSpool",
+				"spool_id": "0",
+				"children": []
+			}
+		]
+	}
+	)raw";
+
+	std::istringstream inputcmp(jsonCompare);
+	boost::property_tree::ptree p_tree_cmp;
+	boost::property_tree::read_json(inputcmp, p_tree_cmp);
+
+	ASSERT_EQ(p_tree, p_tree_cmp);
+}
+
+TEST_F(PhysicalPlanGeneratorTest, apply_common_subplan_reuse_non_deterministic)
+{
+	//	Query
+	// 	select * from (select RAND() as r from nation) t1 inner join (select RAND() as r from nation) t2 on t1.r = t2.r
+
+	std::string logicalPlan =
+	R"raw(
+	{
+		"expr": "LogicalJoin(condition=[=($0, $1)], joinType=[inner])",
+		"children": [
+			{
+				"expr": "LogicalProject(r=[RAND()])",
+				"children": [
+					{
+						"expr": "LogicalTableScan(table=[[main, nation]])",
+						"children": []
+					}
+				]
+			},
+			{
+				"expr": "LogicalProject(r=[RAND()])",
+				"children": [
+					{
+						"expr": "LogicalTableScan(table=[[main, nation]])",
+						"children": []
+					}
+				]
+			}
+		]
+	}
+	)raw";
+
+	std::shared_ptr<Context> context = make_single_context(logicalPlan);
+	ral::batch::tree_processor tree{{}, context->clone(), {}, {}, {}, {}, true};
+
+	std::istringstream input(logicalPlan);
+	boost::property_tree::ptree p_tree;
+	boost::property_tree::read_json(input, p_tree);
+	tree.apply_common_subplan_reuse(p_tree);
+
+	// only the scans give the same rows twice
+	std::string jsonCompare =
+	R"raw(
+	{
+		"expr": "LogicalJoin(condition=[=($0, $1)], joinType=[inner])",
+		"children": [
+			{
+				"expr": "LogicalProject(r=[RAND()])",
+				"children": [
+					{
+						"expr": "LogicalSpool",
+						"spool_id": "0",
+						"children": [
+							{
+								"expr": "LogicalTableScan(table=[[main, nation]])",
+								"children": []
+							}
+						]
+					}
+				]
+			},
+			{
+				"expr": "LogicalProject(r=[RAND()])",
+				"children": [
+					{
+						"expr": "LogicalSpool",
+						"spool_id": "0",
+						"children": []
+					}
+				]
+			}
+		]
+	}
+	)raw";
+
+	std::istringstream inputcmp(jsonCompare);
+	boost::property_tree::ptree p_tree_cmp;
+	boost::property_tree::read_json(inputcmp, p_tree_cmp);
+
+	ASSERT_EQ(p_tree, p_tree_cmp);
+}
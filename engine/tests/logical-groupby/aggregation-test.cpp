@@ -1,8 +1,10 @@
 //#include "gtest/gtest.h"
 
+#include <cudf/copying.hpp>
 #include <cudf/sorting.hpp>
 
 #include <operators/GroupBy.h>
+#include <utilities/CommonOperations.h>
 #include <cudf_test/column_wrapper.hpp>
 #include <cudf_test/base_fixture.hpp>
 #include <cudf_test/type_lists.hpp>
@@ -174,3 +176,228 @@ using T = TypeParam;
 	cudf::test::expect_tables_equivalent(result->view(), expect_table);										
 
 }
+
+TYPED_TEST(AggregationTest, MergeApproxAggregations) {
+
+	using T = TypeParam;
+
+	cudf::test::fixed_width_column_wrapper<T> key{{   5,  4,  3, 5, 8,  5, 6, 5}, {1, 1, 1, 1, 1, 1, 1, 0}};
+	cudf::test::fixed_width_column_wrapper<T> value{{10, 40, 70, 5, 2, 10, 11, 55}, {1, 1, 1, 1, 1, 1, 1, 0}};
+	cudf::test::fixed_width_column_wrapper<double> percentile{{0.5, 0.5, 0.5, 0.5, 0.5, 0.5, 0.5, 0.5}};
+
+	std::vector<std::string> column_names{"A", "B", "C"};
+	CudfTableView table_view{{key, value, percentile}};
+
+	std::vector<AggregateKind> aggregation_types{AggregateKind::APPROX_COUNT_DISTINCT, AggregateKind::APPROX_PERCENTILE};
+	std::vector<std::string> aggregation_input_expressions{"1", "1, 2"};
+	std::vector<std::string> aggregation_column_assigned_aliases{"agg0", "agg1"};
+	std::vector<int> group_column_indices{0};
+
+	// every half is aggregated into sketches on its own, and then they are merged
+	std::vector<std::unique_ptr<ral::frame::BlazingTable>> partials;
+	for (CudfTableView half : cudf::split(table_view, {4})) {
+		partials.push_back(ral::operators::compute_aggregations_with_groupby(ral::frame::BlazingTableView(half, column_names),
+			aggregation_input_expressions, aggregation_types, aggregation_column_assigned_aliases, group_column_indices));
+	}
+	std::unique_ptr<ral::frame::BlazingTable> concatenated = ral::utilities::concatTables({partials[0]->toBlazingTableView(), partials[1]->toBlazingTableView()});
+
+	std::vector<int> mod_group_column_indices;
+	std::vector<std::string> mod_aggregation_input_expressions, mod_aggregation_column_assigned_aliases;
+	std::vector<AggregateKind> mod_aggregation_types;
+	std::tie(mod_group_column_indices, mod_aggregation_input_expressions, mod_aggregation_types, mod_aggregation_column_assigned_aliases) =
+		ral::operators::modGroupByParametersPostComputeAggregations(group_column_indices, aggregation_types, concatenated->names());
+
+	std::unique_ptr<ral::frame::BlazingTable> merged = ral::operators::compute_aggregations_with_groupby(concatenated->toBlazingTableView(),
+		mod_aggregation_input_expressions, mod_aggregation_types, mod_aggregation_column_assigned_aliases, mod_group_column_indices);
+	std::unique_ptr<ral::frame::BlazingTable> result = ral::operators::estimate_approx_aggregations(std::move(merged), mod_aggregation_types, mod_group_column_indices.size());
+
+	// the groups are small enough for the sketches to be exact
+	cudf::test::fixed_width_column_wrapper<T> expect_key{{ 3,  4,  5,  6, 8, 0}, {1, 1, 1, 1, 1, 0}};
+	cudf::test::fixed_width_column_wrapper<int64_t> expect_agg0{{1, 1, 2, 1, 1, 0}};
+	cudf::test::fixed_width_column_wrapper<double> expect_agg1{{70, 40, 10, 11, 2, 0}, {1, 1, 1, 1, 1, 0}};
+
+	CudfTableView expect_table{{expect_key, expect_agg0, expect_agg1}};
+
+	std::unique_ptr<cudf::table> sorted_result = cudf::sort_by_key(result->view(),result->view().select({0}));
+	std::unique_ptr<cudf::table> sorted_expected = cudf::sort_by_key(expect_table,expect_table.select({0}));
+
+	cudf::test::expect_tables_equivalent(sorted_result->view(), sorted_expected->view());
+}
+
+TYPED_TEST(AggregationTest, MergeDistinctCounts) {
+
+	using T = TypeParam;
+
+	cudf::test::fixed_width_column_wrapper<T> key{{   5,  4,  3, 5, 8,  5, 6, 5}, {1, 1, 1, 1, 1, 1, 1, 0}};
+	cudf::test::fixed_width_column_wrapper<T> value{{10, 40, 70, 5, 2, 10, 11, 55}, {1, 1, 1, 1, 1, 1, 1, 0}};
+
+	std::vector<std::string> column_names{"A", "B"};
+	CudfTableView table_view{{key, value}};
+
+	std::vector<AggregateKind> aggregation_types{AggregateKind::COUNT_DISTINCT, AggregateKind::COUNT_VALID};
+	std::vector<std::string> aggregation_input_expressions{"1", "1"};
+	std::vector<std::string> aggregation_column_assigned_aliases{"agg0", "agg1"};
+	std::vector<int> group_column_indices{0};
+
+	// every half keeps its distinct values on its own, and then they are merged
+	std::vector<std::unique_ptr<ral::frame::BlazingTable>> partials;
+	for (CudfTableView half : cudf::split(table_view, {4})) {
+		partials.push_back(ral::operators::compute_partial_aggregations_with_distinct(ral::frame::BlazingTableView(half, column_names),
+			aggregation_input_expressions, aggregation_types, aggregation_column_assigned_aliases, group_column_indices));
+	}
+	std::unique_ptr<ral::frame::BlazingTable> concatenated = ral::utilities::concatTables({partials[0]->toBlazingTableView(), partials[1]->toBlazingTableView()});
+
+	std::vector<int> mod_group_column_indices;
+	std::vector<std::string> mod_aggregation_input_expressions, mod_aggregation_column_assigned_aliases;
+	std::vector<AggregateKind> mod_aggregation_types;
+	std::tie(mod_group_column_indices, mod_aggregation_input_expressions, mod_aggregation_types, mod_aggregation_column_assigned_aliases) =
+		ral::operators::modGroupByParametersPostComputeAggregations(group_column_indices, aggregation_types, concatenated->names());
+
+	// an intermediate merge keeps the distinct values, only the last one counts them
+	std::unique_ptr<ral::frame::BlazingTable> merged = ral::operators::compute_partial_aggregations_with_distinct(concatenated->toBlazingTableView(),
+		mod_aggregation_input_expressions, mod_aggregation_types, mod_aggregation_column_assigned_aliases, mod_group_column_indices);
+	std::unique_ptr<ral::frame::BlazingTable> result = ral::operators::compute_aggregations_with_groupby(merged->toBlazingTableView(),
+		mod_aggregation_input_expressions, mod_aggregation_types, mod_aggregation_column_assigned_aliases, mod_group_column_indices);
+
+	cudf::test::fixed_width_column_wrapper<T> expect_key{{ 3,  4,  5,  6, 8, 0}, {1, 1, 1, 1, 1, 0}};
+	cudf::test::fixed_width_column_wrapper<int64_t> expect_agg0{{1, 1, 2, 1, 1, 0}};
+	cudf::test::fixed_width_column_wrapper<int64_t> expect_agg1{{1, 1, 3, 1, 1, 0}};
+
+	CudfTableView expect_table{{expect_key, expect_agg0, expect_agg1}};
+
+	std::unique_ptr<cudf::table> sorted_result = cudf::sort_by_key(result->view(),result->view().select({0}));
+	std::unique_ptr<cudf::table> sorted_expected = cudf::sort_by_key(expect_table,expect_table.select({0}));
+
+	cudf::test::expect_tables_equivalent(sorted_result->view(), sorted_expected->view());
+}
+
+TYPED_TEST(AggregationTest, SortedGroupbyAcrossBatches) {
+
+	using T = TypeParam;
+
+	// sorted in descending order with the nulls first, the group of 5 goes on from one batch to the next
+	cudf::test::fixed_width_column_wrapper<T> key{{   0,  8, 6, 5,  5,  5,  4,  3}, {0, 1, 1, 1, 1, 1, 1, 1}};
+	cudf::test::fixed_width_column_wrapper<T> value{{55,  2, 11, 10, 5, 10, 40, 70}, {1, 1, 1, 1, 1, 1, 1, 1}};
+
+	std::vector<std::string> column_names{"A", "B"};
+	CudfTableView table_view{{key, value}};
+
+	std::vector<AggregateKind> aggregation_types{AggregateKind::SUM, AggregateKind::COUNT_VALID};
+	std::vector<std::string> aggregation_input_expressions{"1", "1"};
+	std::vector<std::string> aggregation_column_assigned_aliases{"agg0", "agg1"};
+	std::vector<int> group_column_indices{0};
+
+	EXPECT_TRUE(ral::operators::are_groups_sorted(ral::frame::BlazingTableView(table_view, column_names), group_column_indices));
+	EXPECT_FALSE(ral::operators::are_groups_sorted(ral::frame::BlazingTableView(table_view, column_names), {1}));
+
+	std::vector<std::unique_ptr<ral::frame::BlazingTable>> partials;
+	for (CudfTableView half : cudf::split(table_view, {4})) {
+		ral::frame::BlazingTableView batch(half, column_names);
+		ASSERT_TRUE(ral::operators::are_groups_sorted(batch, group_column_indices));
+		partials.push_back(ral::operators::compute_aggregations_with_groupby(batch,
+			aggregation_input_expressions, aggregation_types, aggregation_column_assigned_aliases, group_column_indices, true));
+	}
+	std::unique_ptr<ral::frame::BlazingTable> concatenated = ral::utilities::concatTables({partials[0]->toBlazingTableView(), partials[1]->toBlazingTableView()});
+
+	std::vector<int> mod_group_column_indices;
+	std::vector<std::string> mod_aggregation_input_expressions, mod_aggregation_column_assigned_aliases;
+	std::vector<AggregateKind> mod_aggregation_types;
+	std::tie(mod_group_column_indices, mod_aggregation_input_expressions, mod_aggregation_types, mod_aggregation_column_assigned_aliases) =
+		ral::operators::modGroupByParametersPostComputeAggregations(group_column_indices, aggregation_types, concatenated->names());
+
+	// the partial aggregations of the batches are still in order, with the group of 5 in both of them
+	ASSERT_TRUE(ral::operators::are_groups_sorted(concatenated->toBlazingTableView(), mod_group_column_indices));
+	std::unique_ptr<ral::frame::BlazingTable> result = ral::operators::compute_aggregations_with_groupby(concatenated->toBlazingTableView(),
+		mod_aggregation_input_expressions, mod_aggregation_types, mod_aggregation_column_assigned_aliases, mod_group_column_indices, true);
+
+	// the groups are output in the order they are in
+	cudf::test::fixed_width_column_wrapper<T> expect_key{{ 0, 8,  6,  5,  4,  3}, {0, 1, 1, 1, 1, 1}};
+	cudf::test::fixed_width_column_wrapper<T> expect_agg0{{55, 2, 11, 25, 40, 70}};
+	cudf::test::fixed_width_column_wrapper<int64_t> expect_agg1{{1, 1, 1, 3, 1, 1}};
+
+	CudfTableView expect_table{{expect_key, expect_agg0, expect_agg1}};
+
+	cudf::test::expect_tables_equivalent(result->view(), expect_table);
+}
+
+TYPED_TEST(AggregationTest, GroupingSetsFromTheFinestGroups) {
+
+	using T = TypeParam;
+
+	std::string expression = "LogicalAggregate(group=[{0, 1}], groups=[[{0, 1}, {0}, {}]], EXPR$2=[SUM($2)], EXPR$3=[COUNT()], EXPR$4=[GROUPING($0, $1)])";
+	std::vector<std::vector<int>> grouping_sets = ral::operators::get_grouping_sets(expression);
+	EXPECT_EQ(grouping_sets, (std::vector<std::vector<int>>{{0, 1}, {0}, {}}));
+	EXPECT_EQ(ral::operators::get_grouping_sets_group_columns({0, 1}, grouping_sets), (std::vector<int>{0, 1}));
+	// the columns in every set go first
+	EXPECT_EQ(ral::operators::get_grouping_sets_group_columns({0, 1}, {{0, 1}, {1}}), (std::vector<int>{1, 0}));
+	EXPECT_EQ(ral::operators::get_grouping_sets_aggregate_expression(expression, {0, 1}),
+		"LogicalAggregate(group=[{0, 1}], EXPR$2=[SUM($2)], EXPR$3=[COUNT()])");
+	EXPECT_TRUE(ral::operators::get_grouping_sets("LogicalAggregate(group=[{0, 1}], EXPR$2=[SUM($2)])").empty());
+
+	std::vector<std::vector<int>> grouping_call_arguments;
+	std::tie(grouping_call_arguments, std::ignore) = ral::operators::get_grouping_calls(expression);
+	EXPECT_EQ(grouping_call_arguments, (std::vector<std::vector<int>>{{}, {}, {0, 1}}));
+	EXPECT_EQ(ral::operators::get_grouping_value({0, 1}, {0, 1}), 0);
+	EXPECT_EQ(ral::operators::get_grouping_value({0, 1}, {0}), 1);
+	EXPECT_EQ(ral::operators::get_grouping_value({0, 1}, {}), 3);
+
+	// the groups of both columns, as MergeAggregate outputs them
+	cudf::test::fixed_width_column_wrapper<T> key0{{1, 1, 2}};
+	cudf::test::fixed_width_column_wrapper<T> key1{{1, 2, 1}, {1, 0, 1}};
+	cudf::test::fixed_width_column_wrapper<T> sum{{10, 20, 5}};
+	cudf::test::fixed_width_column_wrapper<int64_t> count{{1, 2, 1}};
+	CudfTableView table_view{{key0, key1, sum, count}};
+	ral::frame::BlazingTableView table(table_view, {"A", "B", "EXPR$2", "EXPR$3"});
+	std::vector<AggregateKind> aggregation_types{AggregateKind::SUM, AggregateKind::COUNT_ALL};
+
+	std::unique_ptr<ral::frame::BlazingTable> first_column = ral::operators::compute_grouping_set(table, 2, {0}, aggregation_types);
+	cudf::test::fixed_width_column_wrapper<T> expect_key{{1, 2}};
+	cudf::test::fixed_width_column_wrapper<T> expect_sum{{30, 5}};
+	cudf::test::fixed_width_column_wrapper<int64_t> expect_count{{3, 1}};
+	CudfTableView expect_table{{expect_key, expect_sum, expect_count}};
+
+	std::unique_ptr<cudf::table> sorted_result = cudf::sort_by_key(first_column->view(), first_column->view().select({0}));
+	cudf::test::expect_tables_equivalent(sorted_result->view(), expect_table);
+
+	std::unique_ptr<ral::frame::BlazingTable> grand_total = ral::operators::compute_grouping_set(table, 2, {}, aggregation_types);
+	cudf::test::fixed_width_column_wrapper<T> expect_total_sum{{35}};
+	cudf::test::fixed_width_column_wrapper<int64_t> expect_total_count{{4}};
+	CudfTableView expect_total{{expect_total_sum, expect_total_count}};
+	cudf::test::expect_tables_equivalent(grand_total->view(), expect_total);
+}
+
+struct DecimalAggregationTest : public BlazingUnitTest {};
+
+TEST_F(DecimalAggregationTest, SumsAreWidened) {
+
+	// the sums of these DECIMAL32 overflow 32 bits
+	cudf::test::fixed_width_column_wrapper<int32_t> key{{1, 1, 2, 2}};
+	cudf::test::fixed_point_column_wrapper<int32_t> value{{2000000000, 2000000000, 150, -50}, numeric::scale_type{-2}};
+
+	std::vector<std::string> column_names{"A", "B"};
+	ral::frame::BlazingTableView table(CudfTableView{{key, value}}, column_names);
+
+	std::vector<AggregateKind> aggregation_types{AggregateKind::SUM, AggregateKind::MAX};
+	std::vector<std::string> aggregation_input_expressions{"1", "1"};
+	std::vector<std::string> aggregation_column_assigned_aliases{"agg0", "agg1"};
+
+	std::unique_ptr<ral::frame::BlazingTable> total = ral::operators::compute_aggregations_without_groupby(
+		table, aggregation_input_expressions, aggregation_types, aggregation_column_assigned_aliases);
+
+	cudf::test::fixed_point_column_wrapper<int64_t> expect_total_sum{{4000000100}, numeric::scale_type{-2}};
+	cudf::test::fixed_point_column_wrapper<int32_t> expect_total_max{{2000000000}, numeric::scale_type{-2}};
+	CudfTableView expect_total{{expect_total_sum, expect_total_max}};
+	cudf::test::expect_tables_equivalent(total->view(), expect_total);
+
+	std::unique_ptr<ral::frame::BlazingTable> result = ral::operators::compute_aggregations_with_groupby(
+		table, aggregation_input_expressions, aggregation_types, aggregation_column_assigned_aliases, {0});
+
+	// the maximums keep the type of their input
+	cudf::test::fixed_width_column_wrapper<int32_t> expect_key{{1, 2}};
+	cudf::test::fixed_point_column_wrapper<int64_t> expect_sum{{4000000000, 100}, numeric::scale_type{-2}};
+	cudf::test::fixed_point_column_wrapper<int32_t> expect_max{{2000000000, 150}, numeric::scale_type{-2}};
+	CudfTableView expect_table{{expect_key, expect_sum, expect_max}};
+
+	std::unique_ptr<cudf::table> sorted_result = cudf::sort_by_key(result->view(), result->view().select({0}));
+	cudf::test::expect_tables_equivalent(sorted_result->view(), expect_table);
+}
@@ -0,0 +1,49 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include <src/bmr/MemoryPressure.h>
+
+using ral::memory::memory_pressure;
+
+TEST(MemoryPressureTest, DoesNotWaitWithoutMonitors) {
+	auto & pressure = memory_pressure::get_instance();
+	pressure.configure(std::chrono::milliseconds(1000));
+
+	auto start = std::chrono::steady_clock::now();
+	EXPECT_FALSE(pressure.wait_for_eviction(100));
+	EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(500));
+}
+
+TEST(MemoryPressureTest, AllocationWaitsForTheMonitor) {
+	auto & pressure = memory_pressure::get_instance();
+	pressure.configure(std::chrono::milliseconds(10000));
+
+	std::mutex monitor_mutex;
+	std::condition_variable monitor_condition;
+	bool finished = false;
+	pressure.add_monitor(&monitor_condition);
+
+	std::thread monitor([&]() {
+		pressure.set_monitor_thread();
+		std::unique_lock<std::mutex> lock(monitor_mutex);
+		while (!finished) {
+			pressure.wait_for_signal(lock, monitor_condition, std::chrono::milliseconds(100), [&] { return finished; });
+			pressure.notify_evicted();
+		}
+	});
+
+	// the allocation is let go by the monitor long before its wait time is over
+	auto start = std::chrono::steady_clock::now();
+	EXPECT_TRUE(pressure.wait_for_eviction(100));
+	EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(5000));
+	EXPECT_EQ(pressure.get_waiting_bytes(), 0);
+
+	{
+		std::lock_guard<std::mutex> lock(monitor_mutex);
+		finished = true;
+	}
+	monitor_condition.notify_all();
+	monitor.join();
+	pressure.remove_monitor(&monitor_condition);
+}
@@ -212,3 +212,30 @@ TEST_F(LogicalFilterWithStringsTest, IneqWithNulls)
 
   cudf::test::expect_tables_equal(expected_table_view, out_table->view());
 }
+
+TEST_F(LogicalFilterWithStringsTest, FilterSelection)
+{
+  cudf::test::strings_column_wrapper col1({"foo", "d", "e", "a", "hello", "k", "d", "l", "bar", ""});
+  cudf::test::fixed_width_column_wrapper<int32_t> col2({10,8,6,4,2,1,11,9,7,5});
+
+  cudf::table_view in_table_view ({col1, col2});
+  std::vector<std::string> column_names{"col1", "col2"};
+  ral::frame::BlazingTableView table{in_table_view, column_names};
+
+  auto selection = ral::processor::get_filter_selection(table,
+                                                        {"LogicalFilter(condition=[>($1, 4)])", "LogicalFilter(condition=[<>($0, 'd')])"});
+
+  cudf::test::fixed_width_column_wrapper<int32_t> expected_selection({0, 2, 7, 8, 9});
+  cudf::test::expect_columns_equal(expected_selection, selection->view());
+
+  // only the column the expression uses is gathered
+  std::string expression = "LogicalProject(EXPR$0=[$1])";
+  auto out_table = ral::processor::gather_selected_columns(table, selection->view(), expression);
+
+  cudf::test::fixed_width_column_wrapper<int32_t> expected_col2({10, 6, 9, 7, 5});
+  cudf::table_view expected_table_view ({expected_col2});
+
+  cudf::test::expect_tables_equal(expected_table_view, out_table->view());
+  EXPECT_EQ(expression, "LogicalProject(EXPR$0=[$0])");
+  EXPECT_EQ(out_table->names(), std::vector<std::string>{"col2"});
+}
@@ -13,6 +13,8 @@
 #include "cudf_test/type_lists.hpp"
 #include "cudf_test/type_list_utilities.hpp"
 #include "Interpreter/interpreter_cpp.h"
+#include "Interpreter/jit_expressions.h"
+#include "Interpreter/interpreter_plan_cache.h"
 #include "execution_kernels/LogicalProject.h"
 #include "tests/utilities/BlazingUnitTest.h"
 #include <thrust/host_vector.h>
@@ -556,6 +558,94 @@ TYPED_TEST(InteropsTestTimestamp, test_timestamp_types) {
     }
 }
 
+TEST_F(OperatorTest, jit_expressions_match_interpreter) {
+    cudf::test::fixed_width_column_wrapper<int32_t> col1({0, 1, 2, 3, 4, 5, 6, 7, 8, 9}, {1, 1, 1, 0, 1, 1, 1, 1, 0, 1});
+    cudf::test::fixed_width_column_wrapper<double> col2({0.5, 1.5, 2.5, 3.5, 4.5, 5.5, 6.5, 7.5, 8.5, 9.5});
+    cudf::table_view in_table_view({col1, col2});
+
+    std::vector<std::string> expressions{"+(*($0, $1), 2)", "AND(>($0, 3), IS NOT NULL($1))", "/($1, $0)"};
+
+    interops::jit::set_enabled(false);
+    auto interpreted = ral::processor::evaluate_expressions(in_table_view, expressions);
+    interops::jit::set_enabled(true);
+    auto compiled = ral::processor::evaluate_expressions(in_table_view, expressions);
+    interops::jit::set_enabled(false);
+
+    for (std::size_t i = 0; i < expressions.size(); i++) {
+        cudf::test::expect_columns_equal(interpreted[i]->view(), compiled[i]->view());
+    }
+}
+
+TEST_F(OperatorTest, cached_interpreter_plan_matches_interpreter) {
+    cudf::test::fixed_width_column_wrapper<int32_t> col1({0, 1, 2, 3, 4, 5, 6, 7, 8, 9}, {1, 1, 1, 0, 1, 1, 1, 1, 0, 1});
+    cudf::test::fixed_width_column_wrapper<double> col2({0.5, 1.5, 2.5, 3.5, 4.5, 5.5, 6.5, 7.5, 8.5, 9.5});
+    cudf::table_view in_table_view({col1, col2});
+
+    std::vector<std::string> expressions{"+(*($0, $1), 2)", "$1", "7", ">($0, 3)"};
+
+    interops::interpreter_plan_cache::get_instance().set_max_size(0);
+    auto interpreted = ral::processor::evaluate_expressions(in_table_view, expressions);
+    interops::interpreter_plan_cache::get_instance().set_max_size(1024);
+    ral::processor::evaluate_expressions(in_table_view, expressions);
+    std::string key = interops::get_interpreter_plan_key(in_table_view, expressions);
+    ASSERT_NE(interops::interpreter_plan_cache::get_instance().get(key), nullptr);
+    auto cached = ral::processor::evaluate_expressions(in_table_view, expressions);
+
+    for (std::size_t i = 0; i < expressions.size(); i++) {
+        cudf::test::expect_columns_equal(interpreted[i]->view(), cached[i]->view());
+    }
+}
+
+TEST_F(OperatorTest, split_interpreter_launches_match_one_launch) {
+    cudf::test::fixed_width_column_wrapper<int32_t> col1({0, 1, 2, 3, 4, 5, 6, 7, 8, 9}, {1, 1, 1, 0, 1, 1, 1, 1, 0, 1});
+    cudf::test::fixed_width_column_wrapper<double> col2({0.5, 1.5, 2.5, 3.5, 4.5, 5.5, 6.5, 7.5, 8.5, 9.5});
+    cudf::test::fixed_width_column_wrapper<double> col3({1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0, 9.0, 10.0}, {1, 0, 1, 1, 1, 1, 0, 1, 1, 1});
+    cudf::table_view in_table_view({col1, col2, col3});
+
+    std::vector<std::string> expressions{"+(*($0, $1), *($2, 2))", "-(/($1, $2), *($0, 3))", ">(+($0, $2), *($1, $1))",
+        "*(+($0, 1), -($2, $1))", "+(+(+($0, $1), $2), 4)", "$1", "7"};
+
+    interops::interpreter_plan_cache::get_instance().set_max_size(0);
+    interops::set_interpreter_min_occupancy(0);
+    auto one_launch = ral::processor::evaluate_expressions(in_table_view, expressions);
+    // the plans that keep fewer threads than an SM can run are split into a launch for every few outputs
+    interops::set_interpreter_min_occupancy(1.0);
+    auto split_launches = ral::processor::evaluate_expressions(in_table_view, expressions);
+    interops::set_interpreter_min_occupancy(0.25);
+    interops::interpreter_plan_cache::get_instance().set_max_size(1024);
+
+    for (std::size_t i = 0; i < expressions.size(); i++) {
+        cudf::test::expect_columns_equal(one_launch[i]->view(), split_launches[i]->view());
+    }
+}
+
+TEST_F(OperatorTest, common_subexpressions_are_computed_once) {
+    std::vector<ral::parser::parse_tree> expr_trees(3);
+    expr_trees[0].build("+(*($0, -(1, $1)), 2)");
+    expr_trees[1].build("/(*($0, -(1, $1)), $2)");
+    expr_trees[2].build("*(-(1, $1), $2)");
+
+    auto subexpression_trees = interops::extract_common_subexpressions(expr_trees, 3);
+    ASSERT_EQ(subexpression_trees.size(), 2);
+    EXPECT_EQ(expr_trees[0].rebuildExpression(), "+($3, 2)");
+    EXPECT_EQ(expr_trees[1].rebuildExpression(), "/($3, $2)");
+    EXPECT_EQ(expr_trees[2].rebuildExpression(), "*($4, $2)");
+    EXPECT_EQ(subexpression_trees[0].rebuildExpression(), "*($0, $4)");
+    EXPECT_EQ(subexpression_trees[1].rebuildExpression(), "-(1, $1)");
+
+    cudf::test::fixed_width_column_wrapper<double> col1({0.5, 1.5, 2.5, 3.5, 4.5});
+    cudf::test::fixed_width_column_wrapper<double> col2({0.1, 0.2, 0.3, 0.4, 0.5}, {1, 1, 0, 1, 1});
+    cudf::test::fixed_width_column_wrapper<double> col3({1.0, 2.0, 3.0, 4.0, 5.0});
+    cudf::table_view in_table_view({col1, col2, col3});
+
+    std::vector<std::string> expressions{"+(*($0, -(1, $1)), 2)", "/(*($0, -(1, $1)), $2)", "*(-(1, $1), $2)"};
+    auto combined = ral::processor::evaluate_expressions(in_table_view, expressions);
+    for (std::size_t i = 0; i < expressions.size(); i++) {
+        auto alone = ral::processor::evaluate_expressions(in_table_view, {expressions[i]});
+        cudf::test::expect_columns_equal(alone[0]->view(), combined[i]->view());
+    }
+}
+
 /*
 template <typename T>
 struct InteropsTestNumericDivZero : public BlazingUnitTest {
@@ -5,6 +5,7 @@
 #include "cudf_test/type_lists.hpp"
 
 #include "execution_kernels/LogicalProject.h"
+#include "utilities/timestamp_parser.h"
 #include <execution_kernels/LogicPrimitives.h>
 #include "tests/utilities/BlazingUnitTest.h"
 
@@ -239,6 +240,35 @@ TYPED_TEST(ProjectTestNumeric, test_numeric_types7)
 //   }
 }
 
+TYPED_TEST(ProjectTestNumeric, test_input_columns_moved)
+{
+    using T = TypeParam;
+
+    cudf::test::fixed_width_column_wrapper<T> col1{{4, 5, 3, 5, 8, 5, 6}, {1, 1, 1, 1, 1, 1, 1}};
+    cudf::test::strings_column_wrapper col2({"b", "d", "a", "d", "l", "d", "k"}, {1, 1, 1, 1, 1, 1, 1});
+    cudf::test::fixed_width_column_wrapper<T> col3{{10, 40, 70, 5, 2, 10, 11}, {1, 1, 1, 1, 1, 1, 1}};
+
+    CudfTableView cudf_table_in_view {{col1, col2, col3}};
+    std::unique_ptr<CudfTable> cudf_table = std::make_unique<CudfTable>(cudf_table_in_view);
+
+    std::vector<std::string> names({"A", "B", "C"});
+    std::unique_ptr<ral::frame::BlazingTable> table = std::make_unique<ral::frame::BlazingTable>(std::move(cudf_table), names);
+
+    // the columns are moved out of the input, and the one that is used twice is copied
+    std::string query_part = "LogicalProject(C=[$2], A=[$0], A0=[$0])";
+    blazingdb::manager::Context * context = nullptr;
+
+    std::unique_ptr<ral::frame::BlazingTable> table_out = ral::processor::process_project(
+        std::move(table),
+        query_part,
+        context);
+
+    CudfTableView expect_cudf_table_view {{col3, col1, col1}};
+
+    cudf::test::expect_tables_equal(expect_cudf_table_view, table_out->view());
+    EXPECT_EQ(table_out->names(), std::vector<std::string>({"C", "A", "A0"}));
+}
+
 TYPED_TEST(ProjectTestNumeric, test_rand)
 {
     using T = TypeParam;
@@ -303,6 +333,116 @@ TEST_F(ProjectTestString, test_string_like)
     cudf::test::expect_tables_equal(expected_table_view, out_table->view());
 }
 
+TEST_F(ProjectTestString, test_string_like_simple_patterns)
+{
+    cudf::test::strings_column_wrapper col1({"foo", "food", "afoo", "bar", "", "xfooy", "fo"}, {1, 1, 1, 1, 1, 1, 0});
+    cudf::test::fixed_width_column_wrapper<int32_t> col2{{1, 6, 7, 8, 9, 3, 10}};
+
+    cudf::table_view in_table_view {{col1, col2}};
+    std::unique_ptr<CudfTable> cudf_table = std::make_unique<CudfTable>(in_table_view);
+    std::vector<std::string> names(in_table_view.num_columns());
+    std::unique_ptr<ral::frame::BlazingTable> table = std::make_unique<ral::frame::BlazingTable>(std::move(cudf_table), names);
+
+    auto out_table = ral::processor::process_project(std::move(table),
+                                                    "LogicalProject(EXPR$0=[LIKE($0, 'foo%')], EXPR$1=[LIKE($0, '%foo')], EXPR$2=[LIKE($0, '%foo%')], EXPR$3=[AND(LIKE($0, '%foo%'), >($1, 5))])",
+                                                    nullptr);
+
+    cudf::test::fixed_width_column_wrapper<bool> expected_col1{{1,1,0,0,0,0,0}, {1,1,1,1,1,1,0}};
+    cudf::test::fixed_width_column_wrapper<bool> expected_col2{{1,0,1,0,0,0,0}, {1,1,1,1,1,1,0}};
+    cudf::test::fixed_width_column_wrapper<bool> expected_col3{{1,1,1,0,0,1,0}, {1,1,1,1,1,1,0}};
+    cudf::test::fixed_width_column_wrapper<bool> expected_col4{{0,1,1,0,0,0,0}, {1,1,1,1,1,1,0}};
+    cudf::table_view expected_table_view {{expected_col1, expected_col2, expected_col3, expected_col4}};
+
+    cudf::test::expect_tables_equal(expected_table_view, out_table->view());
+}
+
+TEST_F(ProjectTestString, test_string_like_literal_patterns)
+{
+    cudf::test::strings_column_wrapper col1({"foo", "fo", "fooo", "f", "o", "fxo", "", "bar"}, {1, 1, 1, 1, 1, 1, 1, 0});
+
+    cudf::table_view in_table_view {{col1}};
+    std::unique_ptr<CudfTable> cudf_table = std::make_unique<CudfTable>(in_table_view);
+    std::vector<std::string> names(in_table_view.num_columns());
+    std::unique_ptr<ral::frame::BlazingTable> table = std::make_unique<ral::frame::BlazingTable>(std::move(cudf_table), names);
+
+    auto out_table = ral::processor::process_project(std::move(table),
+                                                    "LogicalProject(EXPR$0=[LIKE($0, 'foo')], EXPR$1=[LIKE($0, 'f%o')], EXPR$2=[LIKE($0, 'fo%o')], EXPR$3=[LIKE($0, '')])",
+                                                    nullptr);
+
+    cudf::test::fixed_width_column_wrapper<bool> expected_col1{{1,0,0,0,0,0,0,0}, {1,1,1,1,1,1,1,0}};
+    cudf::test::fixed_width_column_wrapper<bool> expected_col2{{1,1,1,0,0,1,0,0}, {1,1,1,1,1,1,1,0}};
+    cudf::test::fixed_width_column_wrapper<bool> expected_col3{{1,0,1,0,0,0,0,0}, {1,1,1,1,1,1,1,0}};
+    cudf::test::fixed_width_column_wrapper<bool> expected_col4{{0,0,0,0,0,0,1,0}, {1,1,1,1,1,1,1,0}};
+    cudf::table_view expected_table_view {{expected_col1, expected_col2, expected_col3, expected_col4}};
+
+    cudf::test::expect_tables_equal(expected_table_view, out_table->view());
+}
+
+TEST_F(ProjectTestString, test_string_case_many_branches)
+{
+    cudf::test::strings_column_wrapper col1{{"x0", "x1", "x2", "x3", "x4", "x5", "x6", "x7", "x8", "x9", "x10", "x11"}};
+    cudf::test::fixed_width_column_wrapper<int32_t> col2{{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11}};
+
+    cudf::table_view in_table_view {{col1, col2}};
+    std::unique_ptr<CudfTable> cudf_table = std::make_unique<CudfTable>(in_table_view);
+    std::vector<std::string> names(in_table_view.num_columns());
+    std::unique_ptr<ral::frame::BlazingTable> table = std::make_unique<ral::frame::BlazingTable>(std::move(cudf_table), names);
+
+    // more branches than a pass of the interpreter looks for, so the rows without a match are compacted
+    auto out_table = ral::processor::process_project(std::move(table),
+                                                    "LogicalProject(EXPR$0=[CASE(=($1, 0), 'v0', =($1, 1), 'v1', =($1, 2), 'v2', =($1, 3), $0, =($1, 4), 'v4', "
+                                                    "=($1, 5), 'v5', =($1, 6), 'v6', =($1, 7), 'v7', =($1, 8), 'v8', =($1, 9), 'v9', 'none')])",
+                                                    nullptr);
+
+    cudf::test::strings_column_wrapper expected_col1{{"v0", "v1", "v2", "x3", "v4", "v5", "v6", "v7", "v8", "v9", "none", "none"}};
+    cudf::table_view expected_table_view {{expected_col1}};
+
+    cudf::test::expect_tables_equal(expected_table_view, out_table->view());
+}
+
+TEST_F(ProjectTestString, test_decimal_arithmetic)
+{
+    cudf::test::fixed_point_column_wrapper<int64_t> col1{{125, 250, -100}, numeric::scale_type{-2}};
+    cudf::test::fixed_point_column_wrapper<int32_t> col2{{100, 200, 300}, numeric::scale_type{-2}};
+
+    cudf::table_view in_table_view {{col1, col2}};
+    std::unique_ptr<CudfTable> cudf_table = std::make_unique<CudfTable>(in_table_view);
+    std::vector<std::string> names(in_table_view.num_columns());
+    std::unique_ptr<ral::frame::BlazingTable> table = std::make_unique<ral::frame::BlazingTable>(std::move(cudf_table), names);
+
+    // the decimals stay in fixed point, the scales of the sums are kept and the ones of the products are added
+    auto out_table = ral::processor::process_project(std::move(table),
+                                                    "LogicalProject(EXPR$0=[+($0, $1)], EXPR$1=[*($0, 2.5)], EXPR$2=[>($0, 1.5)])",
+                                                    nullptr);
+
+    cudf::test::fixed_point_column_wrapper<int64_t> expected_col1{{225, 450, 200}, numeric::scale_type{-2}};
+    cudf::test::fixed_point_column_wrapper<int64_t> expected_col2{{3125, 6250, -2500}, numeric::scale_type{-3}};
+    cudf::test::fixed_width_column_wrapper<bool> expected_col3{{false, true, false}};
+    cudf::table_view expected_table_view {{expected_col1, expected_col2, expected_col3}};
+
+    cudf::test::expect_tables_equivalent(expected_table_view, out_table->view());
+}
+
+TEST_F(ProjectTestString, test_decimal_product_overflow)
+{
+    cudf::test::fixed_point_column_wrapper<int64_t> col1{{4000000000000, 200}, numeric::scale_type{-2}};
+
+    cudf::table_view in_table_view {{col1}};
+    std::unique_ptr<CudfTable> cudf_table = std::make_unique<CudfTable>(in_table_view);
+    std::vector<std::string> names(in_table_view.num_columns());
+    std::unique_ptr<ral::frame::BlazingTable> table = std::make_unique<ral::frame::BlazingTable>(std::move(cudf_table), names);
+
+    // the unscaled values of the product would overflow 64 bits, so it is computed with the decimals cast to FLOAT64
+    auto out_table = ral::processor::process_project(std::move(table),
+                                                    "LogicalProject(EXPR$0=[*($0, $0)])",
+                                                    nullptr);
+
+    cudf::test::fixed_width_column_wrapper<double> expected_col1{{1.6e21, 4.0}};
+    cudf::table_view expected_table_view {{expected_col1}};
+
+    cudf::test::expect_tables_equivalent(expected_table_view, out_table->view());
+}
+
 TEST_F(ProjectTestString, test_string_substring)
 {
     cudf::test::strings_column_wrapper col1{{"The", "quick", "brown", "fox", "jumps", "over", "the", "lazy", "dog"}};
@@ -444,6 +584,34 @@ TEST_F(ProjectTestString, test_cast_from_string)
     cudf::test::expect_tables_equivalent(expected_table_view, out_table->view());
 }
 
+TEST_F(ProjectTestString, test_cast_from_string_with_varied_timestamp_formats)
+{
+    cudf::test::strings_column_wrapper col1({"1970-01-01T00:00:10.5","1970-01-01T00:43:20.25","","1970-01-02 00:47:40","1970-01-07","not a timestamp"},
+                                            {1, 1, 0, 1, 1, 1});
+
+    cudf::table_view in_table_view {{col1}};
+    std::unique_ptr<CudfTable> cudf_table = std::make_unique<CudfTable>(in_table_view);
+    std::vector<std::string> names(in_table_view.num_columns());
+    std::unique_ptr<ral::frame::BlazingTable> table = std::make_unique<ral::frame::BlazingTable>(std::move(cudf_table), names);
+
+    auto out_table = ral::processor::process_project(std::move(table),
+                                                    "LogicalProject(EXPR$0=[CAST($0):TIMESTAMP])",
+                                                    nullptr);
+
+    // most rows have the format of the column, the others are parsed with the formats they match
+    cudf::test::fixed_width_column_wrapper<cudf::timestamp_ns, cudf::timestamp_ns::rep> expected_col1{
+        {10500000000L, 2600250000000L, 0L, 89260000000000L, 518400000000000L, 0L}, {1, 1, 0, 1, 1, 0}};
+    cudf::table_view expected_table_view {{expected_col1}};
+
+    cudf::test::expect_tables_equivalent(expected_table_view, out_table->view());
+
+    // the format of a column whose rows all have it is kept for the next batches
+    cudf::test::strings_column_wrapper iso_col({"2008-12-31T10:40:00", "1992-09-01T15:06:40"});
+    EXPECT_EQ(ral::utilities::detect_timestamp_format(cudf::strings_column_view(iso_col)), "%Y-%m-%dT%H:%M:%S");
+    EXPECT_EQ(ral::utilities::timestamp_format_cache::get_instance().get(ral::utilities::get_timestamp_shape("2008-12-31T10:40:00")),
+        "%Y-%m-%dT%H:%M:%S");
+}
+
 TEST_F(ProjectTestString, test_string_case)
 {
     cudf::test::fixed_width_column_wrapper<int32_t> col1{{0, 1, 2, 3, 4, 5, 6, 7, 8}};
@@ -0,0 +1,96 @@
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <arrow/io/file.h>
+
+#include "tests/utilities/BlazingUnitTest.h"
+#include "io/data_parser/ArgsUtil.h"
+#include "io/data_parser/CSVParser.h"
+
+struct CSVParserTest : public BlazingUnitTest {};
+
+TEST_F(CSVParserTest, split_into_chunks) {
+	const std::string path = "/tmp/csv_parser_split_test.csv";
+	{
+		std::ofstream csv(path);
+		csv << "a,b\n";
+		for (int i = 0; i < 100; i++) {
+			csv << i << "," << i * 2 << "\n";
+		}
+	}
+
+	ral::io::data_handle handle;
+	handle.file_handle = arrow::io::ReadableFile::Open(path).ValueOrDie();
+
+	ral::io::csv_parser parser({{"has_header_csv", "True"}});
+	std::size_t num_chunks = parser.split_into_chunks(handle, 100);
+	EXPECT_GT(num_chunks, 1);
+
+	// every row is read once, by the chunk it starts in
+	ral::io::Schema schema({"a", "b"}, {cudf::type_id::INT64, cudf::type_id::INT64});
+	cudf::size_type num_rows = 0;
+	for (std::size_t chunk = 0; chunk < num_chunks; chunk++) {
+		auto table = parser.parse_batch(handle, schema, {0, 1}, {static_cast<cudf::size_type>(chunk)});
+		EXPECT_EQ(table->num_columns(), 2);
+		num_rows += table->num_rows();
+	}
+	EXPECT_EQ(num_rows, 100);
+
+	// the files that are smaller than a chunk are not split
+	EXPECT_EQ(parser.split_into_chunks(handle, 1 << 20), 1);
+}
+
+TEST_F(CSVParserTest, infer_compression_type) {
+	// a gzip file without an extension is told apart by its magic number
+	const std::string path = "/tmp/csv_parser_compression_test";
+	{
+		std::ofstream file(path, std::ios::binary);
+		file << '\x1f' << '\x8b' << '\x08' << '\x00';
+	}
+
+	ral::io::data_handle handle;
+	handle.file_handle = arrow::io::ReadableFile::Open(path).ValueOrDie();
+	EXPECT_EQ(ral::io::infer_compression_type({}, handle), cudf::io::compression_type::GZIP);
+
+	// the compression arg wins over the inferred one
+	std::map<std::string, std::string> args = {{"compression", std::to_string(static_cast<int>(cudf::io::compression_type::NONE))}};
+	EXPECT_EQ(ral::io::infer_compression_type(args, handle), cudf::io::compression_type::NONE);
+
+	// and the compressed files are not split
+	ral::io::csv_parser parser({{"has_header_csv", "False"}});
+	EXPECT_EQ(parser.split_into_chunks(handle, 1), 1);
+}
+
+TEST_F(CSVParserTest, estimate_decoded_bytes) {
+	const std::string path = "/tmp/csv_parser_estimate_test.csv";
+	{
+		std::ofstream csv(path);
+		csv << "a,b\n";
+		for (int i = 0; i < 100; i++) {
+			csv << i << "," << i * 2 << "\n";
+		}
+	}
+
+	ral::io::data_handle handle;
+	handle.file_handle = arrow::io::ReadableFile::Open(path).ValueOrDie();
+	std::size_t file_bytes = handle.file_handle->GetSize().ValueOrDie();
+
+	ral::io::csv_parser parser({{"has_header_csv", "True"}});
+	ral::io::Schema schema({"a", "b"}, {cudf::type_id::INT64, cudf::type_id::INT64});
+
+	// the whole file is copied to the GPU, and parsed into half of it for one of the two columns
+	std::size_t bytes = 0;
+	EXPECT_TRUE(parser.estimate_decoded_bytes(handle, schema, {0}, {}, bytes));
+	EXPECT_EQ(bytes, file_bytes + file_bytes / 2);
+
+	// a chunk of a split file is estimated from its own size
+	std::size_t num_chunks = parser.split_into_chunks(handle, 100);
+	ASSERT_GT(num_chunks, 1);
+	std::size_t total_bytes = 0;
+	for (std::size_t chunk = 0; chunk < num_chunks; chunk++) {
+		EXPECT_TRUE(parser.estimate_decoded_bytes(handle, schema, {0, 1}, {static_cast<int>(chunk)}, bytes));
+		total_bytes += bytes;
+	}
+	EXPECT_EQ(total_bytes, 2 * file_bytes);
+}
@@ -74,3 +74,23 @@ TEST_F(ExpressionTreeTest, case_8) {
 	tree.transform_to_custom_op();
 	EXPECT_EQ(tree.rebuildExpression(), expected);
 }
+
+TEST_F(ExpressionTreeTest, fold_constants) {
+	ral::parser::parse_tree tree;
+	tree.build("AND(=(+(1, 2), 3), >($0, *(2, 3)), OR($1, <(2.5, 1)))");
+	tree.transform_to_custom_op();
+	tree.fold_constants();
+	EXPECT_EQ(tree.rebuildExpression(), "AND(>($0, 6), $1)");
+
+	ral::parser::parse_tree constant_tree;
+	constant_tree.build("OR(IS_NULL($0), AND(NOT(false), <>(1, 1)), IS_NOT_NULL(null))");
+	constant_tree.transform_to_custom_op();
+	constant_tree.fold_constants();
+	EXPECT_EQ(constant_tree.rebuildExpression(), "IS_NULL($0)");
+
+	ral::parser::parse_tree null_tree;
+	null_tree.build("AND(true, =(null, $0))");
+	null_tree.transform_to_custom_op();
+	null_tree.fold_constants();
+	EXPECT_EQ(null_tree.rebuildExpression(), "null");
+}
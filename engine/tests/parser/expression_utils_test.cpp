@@ -1,6 +1,9 @@
 #include "parser/expression_tree.hpp"
+#include "parser/expression_utils.hpp"
+#include "operators/TableSample.h"
 #include <gtest/gtest.h>
 #include <iostream>
+#include <numeric>
 
 using namespace ral::parser;
 struct ExpressionUtilsTest : public ::testing::Test {
@@ -128,6 +131,30 @@ TEST_F(ExpressionUtilsTest, gettings_bounds_from_window_expression) {
 	}		
 }
 
+TEST_F(ExpressionUtilsTest, window_can_split_partitions) {
+	std::string bounded = "LogicalComputeWindow(max_keys=[MAX($0) OVER (PARTITION BY $1 ORDER BY $2 ROWS BETWEEN 2 PRECEDING AND 3 FOLLOWING)])";
+	std::string unbounded = "LogicalComputeWindow(max_keys=[MAX($0) OVER (PARTITION BY $1 ORDER BY $2 ROWS BETWEEN UNBOUNDED PRECEDING AND 3 FOLLOWING)])";
+	std::string not_ordered = "LogicalComputeWindow(max_keys=[MAX($0) OVER (PARTITION BY $1)])";
+	std::string lag = "LogicalComputeWindow(lag_keys=[LAG($0, 2) OVER (PARTITION BY $1 ORDER BY $2)])";
+
+	EXPECT_TRUE(window_expression_can_split_partitions(bounded));
+	EXPECT_FALSE(window_expression_can_split_partitions(unbounded));
+	EXPECT_FALSE(window_expression_can_split_partitions(not_ordered));
+	EXPECT_FALSE(window_expression_can_split_partitions(lag));
+}
+
+TEST_F(ExpressionUtilsTest, window_can_carry_partitions) {
+	std::string cumulative = "LogicalComputeWindow(min_keys=[MIN($0) OVER (PARTITION BY $1 ORDER BY $2)], row_num=[ROW_NUMBER() OVER (PARTITION BY $1 ORDER BY $2)])";
+	std::string not_ordered = "LogicalComputeWindow(min_keys=[MIN($0) OVER (PARTITION BY $1)])";
+	std::string bounded = "LogicalComputeWindow(min_keys=[MIN($0) OVER (PARTITION BY $1 ORDER BY $2 ROWS BETWEEN 2 PRECEDING AND CURRENT ROW)])";
+	std::string lead = "LogicalComputeWindow(lead_keys=[LEAD($0, 2) OVER (PARTITION BY $1 ORDER BY $2)])";
+
+	EXPECT_TRUE(window_expression_can_carry_partitions(cumulative));
+	EXPECT_FALSE(window_expression_can_carry_partitions(not_ordered));
+	EXPECT_FALSE(window_expression_can_carry_partitions(bounded));
+	EXPECT_FALSE(window_expression_can_carry_partitions(lead));
+}
+
 TEST_F(ExpressionUtilsTest, getting_cols_to_apply_window_and_cols_to_apply_agg) {
 	std::vector<int> column_indices_to_agg, agg_param_values;
 	std::vector<std::string> type_aggs_as_str;
@@ -602,3 +629,92 @@ TEST_F(ExpressionUtilsTest, reinterpreting_timestamp_ns)
 
 	EXPECT_EQ(out_expression, expression);
 }
+
+TEST_F(ExpressionUtilsTest, referenced_column_indices)
+{
+	std::string expression = "LogicalProject(EXPR$0=[+($3, $1)], name=[$3], label=['$2'], $f3=[$10])";
+	std::vector<int> expected = {1, 3, 10};
+
+	EXPECT_EQ(get_referenced_column_indices(expression), expected);
+}
+
+TEST_F(ExpressionUtilsTest, renumbering_column_indices)
+{
+	std::string expression = "LogicalProject(EXPR$0=[+($3, $1)], name=[$3], label=['$2'], $f3=[$10])";
+	std::vector<int> new_column_indices(11, -1);
+	new_column_indices[1] = 0;
+	new_column_indices[3] = 1;
+	new_column_indices[10] = 2;
+	std::string expected = "LogicalProject(EXPR$0=[+($1, $0)], name=[$1], label=['$2'], $f3=[$2])";
+
+	EXPECT_EQ(renumber_column_indices(expression, new_column_indices), expected);
+}
+
+TEST_F(ExpressionUtilsTest, set_operations)
+{
+	EXPECT_TRUE(is_set_operation("LogicalUnion(all=[false])"));
+	EXPECT_FALSE(is_set_operation("LogicalUnion(all=[true])"));
+	EXPECT_TRUE(is_set_operation("LogicalIntersect(all=[false])"));
+	EXPECT_TRUE(is_set_operation("LogicalMinus(all=[false])"));
+	EXPECT_FALSE(is_set_operation("LogicalProject(EXPR$0=[$0])"));
+}
+
+TEST_F(ExpressionUtilsTest, getting_equality_literals) {
+	std::map<int, std::vector<std::string>> expected = {{0, {"5"}}, {1, {"'a'", "'b'"}}};
+	EXPECT_EQ(get_equality_literals("AND(=($0, 5), OR(=($1, 'a'), =($1, 'b')), >($2, 3))"), expected);
+
+	// the ORs of different columns don't make every row have one of their values
+	expected = {{2, {"7"}}};
+	EXPECT_EQ(get_equality_literals("AND(OR(=($0, 1), =($1, 2)), =(7, $2))"), expected);
+
+	EXPECT_TRUE(get_equality_literals(">($0, 5)").empty());
+}
+
+TEST_F(ExpressionUtilsTest, getting_literal_ranges) {
+	std::map<int, std::vector<literal_range>> ranges = get_literal_ranges("AND(>=($0, 5), >(10, $0), OR(=($1, 'a'), =($1, 'b')))");
+	ASSERT_EQ(ranges.size(), 2);
+
+	ASSERT_EQ(ranges[0].size(), 1);
+	EXPECT_TRUE(ranges[0][0].has_lower);
+	EXPECT_EQ(ranges[0][0].lower, "5");
+	EXPECT_TRUE(ranges[0][0].lower_inclusive);
+	// 10 > $0 is an upper bound of $0
+	EXPECT_TRUE(ranges[0][0].has_upper);
+	EXPECT_EQ(ranges[0][0].upper, "10");
+	EXPECT_FALSE(ranges[0][0].upper_inclusive);
+	EXPECT_EQ(ranges[0][0].type.id(), cudf::type_id::INT32);
+
+	ASSERT_EQ(ranges[1].size(), 2);
+	EXPECT_EQ(ranges[1][0].lower, "'a'");
+	EXPECT_EQ(ranges[1][0].upper, "'a'");
+	EXPECT_EQ(ranges[1][1].lower, "'b'");
+	EXPECT_EQ(ranges[1][0].type.id(), cudf::type_id::STRING);
+
+	// the rows of an OR of different columns can have any value of them
+	EXPECT_TRUE(get_literal_ranges("OR(>($0, 1), =($1, 2))").empty());
+}
+
+TEST_F(ExpressionUtilsTest, parsing_table_samples) {
+	std::string query_part = "Sample(mode=[system], rate=[0.25], repeatableSeed=[42])";
+	EXPECT_TRUE(is_table_sample(query_part));
+	EXPECT_FALSE(is_table_sample("Logical_SortAndSample(sort0=[$0], dir0=[ASC])"));
+
+	ral::operators::table_sample sample = ral::operators::parse_table_sample(query_part);
+	EXPECT_TRUE(sample.system);
+	EXPECT_DOUBLE_EQ(sample.rate, 0.25);
+	EXPECT_TRUE(sample.repeatable);
+	EXPECT_EQ(sample.seed, 42u);
+
+	ral::operators::table_sample bernoulli = ral::operators::parse_table_sample("Sample(mode=[bernoulli], rate=[0.1], repeatableSeed=[-])");
+	EXPECT_FALSE(bernoulli.system);
+	EXPECT_FALSE(bernoulli.repeatable);
+
+	// the same seed keeps the same row groups, about a quarter of them
+	std::vector<int> row_groups(1000);
+	std::iota(row_groups.begin(), row_groups.end(), 0);
+	std::vector<int> sampled = ral::operators::sample_row_groups(sample, 3, row_groups);
+	EXPECT_EQ(sampled, ral::operators::sample_row_groups(ral::operators::parse_table_sample(query_part), 3, row_groups));
+	EXPECT_GT(sampled.size(), 150u);
+	EXPECT_LT(sampled.size(), 350u);
+	EXPECT_NE(sampled, ral::operators::sample_row_groups(sample, 4, row_groups));
+}
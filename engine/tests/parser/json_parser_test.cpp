@@ -0,0 +1,43 @@
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <arrow/io/file.h>
+
+#include "tests/utilities/BlazingUnitTest.h"
+#include "io/data_parser/JSONParser.h"
+
+struct JSONParserTest : public BlazingUnitTest {};
+
+TEST_F(JSONParserTest, split_into_chunks) {
+	const std::string path = "/tmp/json_parser_split_test.json";
+	{
+		std::ofstream json(path);
+		for (int i = 0; i < 100; i++) {
+			json << "{\"a\": " << i << ", \"b\": " << i * 2 << "}\n";
+		}
+	}
+
+	ral::io::data_handle handle;
+	handle.file_handle = arrow::io::ReadableFile::Open(path).ValueOrDie();
+
+	ral::io::json_parser parser({});
+	std::size_t num_chunks = parser.split_into_chunks(handle, 200);
+	EXPECT_GT(num_chunks, 1);
+
+	// every line is read once, by the chunk it starts in, and with the types of the schema
+	ral::io::Schema schema({"a", "b"}, {cudf::type_id::INT64, cudf::type_id::INT64});
+	cudf::size_type num_rows = 0;
+	for (std::size_t chunk = 0; chunk < num_chunks; chunk++) {
+		auto table = parser.parse_batch(handle, schema, {0, 1}, {static_cast<cudf::size_type>(chunk)});
+		EXPECT_EQ(table->num_columns(), 2);
+		EXPECT_EQ(table->view().column(0).type().id(), cudf::type_id::INT64);
+		num_rows += table->num_rows();
+	}
+	EXPECT_EQ(num_rows, 100);
+
+	// the files that are smaller than a chunk, and the json documents that are not lines, are not split
+	EXPECT_EQ(parser.split_into_chunks(handle, 1 << 20), 1);
+	ral::io::json_parser document_parser({{"lines", "False"}});
+	EXPECT_EQ(document_parser.split_into_chunks(handle, 200), 1);
+}
@@ -1,4 +1,5 @@
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -9,6 +10,7 @@
 #include <cudf_test/table_utilities.hpp>
 #include "tests/utilities/BlazingUnitTest.h"
 #include "io/data_parser/metadata/parquet_metadata.h"
+#include "io/data_parser/metadata/parquet_page_index.h"
 #include <parquet/statistics.h>
 #include <parquet/types.h>
 #include <parquet/schema.h>
@@ -88,3 +90,74 @@ TEST_F(ParquetMetadataTest, typed_test) {
     process_minmax_metadata<double, parquet::Type::type::DOUBLE>();
 }
 
+TEST_F(ParquetMetadataTest, bloom_filter) {
+	// the xxHash64 test vectors
+	EXPECT_EQ(ral::io::parquet_bloom_filter_hash(""), 0xef46db3751d8e999ULL);
+	EXPECT_EQ(ral::io::parquet_bloom_filter_hash("a"), 0xd24ec4f1a98c6e5bULL);
+
+	std::vector<uint8_t> bitset(1024, 0);
+	for (int64_t key = 0; key < 100; key++) {
+		std::string plain(reinterpret_cast<const char *>(&key), sizeof(key));
+		ral::io::parquet_bloom_filter_insert(bitset, ral::io::parquet_bloom_filter_hash(plain));
+	}
+	std::size_t false_positives = 0;
+	for (int64_t key = 0; key < 10000; key++) {
+		std::string plain(reinterpret_cast<const char *>(&key), sizeof(key));
+		bool found = ral::io::parquet_bloom_filter_find(bitset, ral::io::parquet_bloom_filter_hash(plain));
+		if (key < 100) {
+			EXPECT_TRUE(found);
+		} else if (found) {
+			false_positives++;
+		}
+	}
+	EXPECT_LT(false_positives, 100);
+}
+
+TEST_F(ParquetMetadataTest, encode_plain_date_values) {
+	auto make_column = [](parquet::Type::type physical_type, parquet::ConvertedType::type converted_type, int precision = -1, int scale = -1) {
+		return parquet::ColumnDescriptor(parquet::schema::PrimitiveNode::Make(
+			"c", parquet::Repetition::OPTIONAL, physical_type, converted_type, -1, precision, scale), 1, 0);
+	};
+	auto as_int32 = [](const std::string & plain) {
+		int32_t value;
+		std::memcpy(&value, plain.data(), sizeof(value));
+		return value;
+	};
+
+	// the dates are the days from the epoch, not the year that std::stoll stops at
+	std::vector<std::string> encoded;
+	EXPECT_TRUE(ral::io::parquet_encode_plain_values(make_column(parquet::Type::INT32, parquet::ConvertedType::DATE),
+		{"1994-01-01", "'1970-01-02'"}, encoded));
+	ASSERT_EQ(encoded.size(), 2);
+	EXPECT_EQ(as_int32(encoded[0]), 8766);
+	EXPECT_EQ(as_int32(encoded[1]), 1);
+
+	// a date is not a value of an integer column, and a date with a time is not one of a date column
+	encoded.clear();
+	EXPECT_FALSE(ral::io::parquet_encode_plain_values(make_column(parquet::Type::INT32, parquet::ConvertedType::NONE),
+		{"1994-01-01"}, encoded));
+	encoded.clear();
+	EXPECT_FALSE(ral::io::parquet_encode_plain_values(make_column(parquet::Type::INT32, parquet::ConvertedType::DATE),
+		{"1994-01-01 10:00:00"}, encoded));
+
+	// the decimals are their unscaled values, and a literal with more digits than the scale prunes nothing
+	encoded.clear();
+	EXPECT_TRUE(ral::io::parquet_encode_plain_values(make_column(parquet::Type::INT32, parquet::ConvertedType::DECIMAL, 9, 2),
+		{"12.34", "-5", "1.50"}, encoded));
+	ASSERT_EQ(encoded.size(), 3);
+	EXPECT_EQ(as_int32(encoded[0]), 1234);
+	EXPECT_EQ(as_int32(encoded[1]), -500);
+	EXPECT_EQ(as_int32(encoded[2]), 150);
+	encoded.clear();
+	EXPECT_FALSE(ral::io::parquet_encode_plain_values(make_column(parquet::Type::INT32, parquet::ConvertedType::DECIMAL, 9, 2),
+		{"12.345"}, encoded));
+
+	// the timestamps are the ticks of their unit
+	encoded.clear();
+	EXPECT_TRUE(ral::io::parquet_encode_plain_values(make_column(parquet::Type::INT64, parquet::ConvertedType::TIMESTAMP_MILLIS),
+		{"1970-01-01 00:00:01.5"}, encoded));
+	ASSERT_EQ(encoded.size(), 1);
+	int64_t millis;
+	std::memcpy(&millis, encoded[0].data(), sizeof(millis));
+	EXPECT_EQ(millis, 1500);
+}
@@ -108,7 +108,7 @@ TEST_F(SplitIneQualityJoinTest, error_case1) {
 
 TEST_F(SplitIneQualityJoinTest, error_case2) {
 
-  std::string join_statement = "  LogicalJoin(condition=[AND(<($7, $0), >($7, $1)], joinType=[inner])";
+  std::string join_statement = "  LogicalJoin(condition=[AND(<(+($7, 1), $0), IS NULL($1))], joinType=[inner])";
   std::string new_join_statement, filter_statement;
   try {
     ral::batch::split_inequality_join_into_join_and_filter(join_statement, new_join_statement, filter_statement);
@@ -117,3 +117,42 @@ TEST_F(SplitIneQualityJoinTest, error_case2) {
     ASSERT_TRUE(true);  // we are expecting an error
   }
 }
+
+TEST_F(SplitIneQualityJoinTest, band_case_1) {
+
+  std::string join_statement = "  LogicalJoin(condition=[AND(<($7, $0), >($7, $1))], joinType=[inner])";
+  std::string new_join_statement, filter_statement;
+  ral::batch::split_inequality_join_into_join_and_filter(join_statement, new_join_statement, filter_statement);
+  std::string expected_new_join_statement = "LogicalJoin(condition=[AND(<($7, $0), >($7, $1))], joinType=[inner])";
+  std::string expected_filter_statement = "";
+  EXPECT_EQ(new_join_statement, expected_new_join_statement);
+  EXPECT_EQ(filter_statement, expected_filter_statement);
+
+  ral::batch::band_join_condition band;
+  ASSERT_TRUE(ral::batch::parseJoinConditionToBand("AND(<($7, $0), >($7, $1))", band));
+  EXPECT_EQ(band.point_column, 7);
+  EXPECT_EQ(band.lower_column, 1);
+  EXPECT_FALSE(band.lower_inclusive);
+  EXPECT_EQ(band.upper_column, 0);
+  EXPECT_FALSE(band.upper_inclusive);
+}
+
+TEST_F(SplitIneQualityJoinTest, band_case_2) {
+
+  std::string join_statement = "LogicalJoin(condition=[AND(>=($0, $5), <>($1, $7), <=($0, $6))], joinType=[inner])";
+  std::string new_join_statement, filter_statement;
+  ral::batch::split_inequality_join_into_join_and_filter(join_statement, new_join_statement, filter_statement);
+  std::string expected_new_join_statement = "LogicalJoin(condition=[AND(>=($0, $5), <=($0, $6))], joinType=[inner])";
+  std::string expected_filter_statement = "LogicalFilter(condition=[<>($1, $7)])";
+  EXPECT_EQ(new_join_statement, expected_new_join_statement);
+  EXPECT_EQ(filter_statement, expected_filter_statement);
+
+  ral::batch::band_join_condition band;
+  ASSERT_TRUE(ral::batch::parseJoinConditionToBand("AND(>=($0, $5), <=($0, $6))", band));
+  EXPECT_EQ(band.point_column, 0);
+  EXPECT_EQ(band.lower_column, 5);
+  EXPECT_TRUE(band.lower_inclusive);
+  EXPECT_EQ(band.upper_column, 6);
+  EXPECT_TRUE(band.upper_inclusive);
+  EXPECT_FALSE(ral::batch::parseJoinConditionToBand("=($0, $5)", band));
+}
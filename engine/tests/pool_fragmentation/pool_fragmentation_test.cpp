@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+
+#include <src/bmr/PoolFragmentation.h>
+
+#include <rmm/mr/device/cuda_memory_resource.hpp>
+
+using ral::memory::fragmentation_report;
+using ral::memory::fragmentation_tracker;
+using ral::memory::tracked_pool_memory_resource;
+
+namespace {
+void * address(std::uintptr_t value) {
+	return reinterpret_cast<void *>(value);
+}
+}
+
+TEST(PoolFragmentationTest, EmptyChunkIsOneFreeBlock) {
+	fragmentation_tracker tracker;
+	tracker.add_chunk(address(0x10000), 4096);
+
+	fragmentation_report report = tracker.get_report();
+	EXPECT_EQ(report.pool_bytes, 4096);
+	EXPECT_EQ(report.free_bytes, 4096);
+	EXPECT_EQ(report.largest_free_block, 4096);
+	EXPECT_EQ(report.num_free_blocks, 1);
+	EXPECT_EQ(report.fragmentation(), 0);
+}
+
+TEST(PoolFragmentationTest, FreeBlocksAreTheGapsBetweenBlocks) {
+	fragmentation_tracker tracker;
+	tracker.add_chunk(address(0x10000), 4096);
+	tracker.add_chunk(address(0x20000), 1024);
+	tracker.add_block(address(0x10000 + 256), 256);
+	tracker.add_block(address(0x10000 + 1024), 1024);
+	tracker.add_block(address(0x20000), 1024);
+
+	// free: 256 at the start, 512 between the blocks and 2048 at the end of the first chunk, none in the second
+	fragmentation_report report = tracker.get_report();
+	EXPECT_EQ(report.num_chunks, 2);
+	EXPECT_EQ(report.pool_bytes, 5120);
+	EXPECT_EQ(report.allocated_bytes, 2304);
+	EXPECT_EQ(report.free_bytes, 2816);
+	EXPECT_EQ(report.largest_free_block, 2048);
+	EXPECT_EQ(report.num_free_blocks, 3);
+	EXPECT_EQ(report.free_block_histogram[256], 1);
+	EXPECT_EQ(report.free_block_histogram[512], 1);
+	EXPECT_EQ(report.free_block_histogram[2048], 1);
+
+	tracker.remove_block(address(0x10000 + 1024));
+	report = tracker.get_report();
+	EXPECT_EQ(report.largest_free_block, 3584);
+	EXPECT_EQ(report.num_free_blocks, 2);
+}
+
+TEST(PoolFragmentationTest, CompactsAPoolThatGrewIntoSeveralChunks) {
+	std::size_t initial_size = 1 << 20;
+	tracked_pool_memory_resource pool(std::make_shared<rmm::mr::cuda_memory_resource>(), initial_size, 0, false);
+
+	void * small = pool.allocate(initial_size / 2);
+	void * large = pool.allocate(initial_size); // does not fit in the first chunk
+	EXPECT_FALSE(pool.compact(0));
+	pool.deallocate(large, initial_size);
+	pool.deallocate(small, initial_size / 2);
+
+	fragmentation_report report = pool.get_fragmentation_report();
+	EXPECT_GT(report.num_chunks, 1);
+	EXPECT_EQ(report.allocated_bytes, 0);
+
+	EXPECT_TRUE(pool.compact(0));
+	EXPECT_EQ(pool.get_num_compactions(), 1);
+	report = pool.get_fragmentation_report();
+	EXPECT_EQ(report.num_chunks, 1);
+	EXPECT_GE(report.pool_bytes, initial_size * 3 / 2);
+
+	void * all = pool.allocate(report.pool_bytes);
+	EXPECT_NE(all, nullptr);
+	pool.deallocate(all, report.pool_bytes);
+}
+
+TEST(PoolFragmentationTest, BinningKeepsSmallAllocationsOutOfThePool) {
+	std::size_t initial_size = 16 << 20;
+	tracked_pool_memory_resource pool(std::make_shared<rmm::mr::cuda_memory_resource>(), initial_size, 0, true);
+
+	void * small = pool.allocate(4096);
+	void * large = pool.allocate(8 << 20);
+	pool.deallocate(small, 4096);
+
+	// the block of the bin of the small allocation stays allocated from the pool, but not split from the large one
+	fragmentation_report report = pool.get_fragmentation_report();
+	EXPECT_GE(report.allocated_bytes, 8 << 20);
+	pool.deallocate(large, 8 << 20);
+}
@@ -1,6 +1,16 @@
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <fstream>
+#include <thread>
 #include "tests/utilities/BlazingUnitTest.h"
 #include "io/data_provider/UriDataProvider.h"
+#include "io/data_provider/DataPrefetcher.h"
+#include "io/data_provider/folder_lister.h"
+#include "io/data_provider/shared_scan.h"
+#include "execution_kernels/scan_work_stealing.h"
+#include <arrow/buffer.h>
+#include <arrow/io/memory.h>
 #include "FileSystem/LocalFileSystem.h"
 #include "Util/StringUtil.h"
 
@@ -870,4 +880,156 @@ TEST_F(ProviderTest, uri_values_empty_dir) {
 
 	bool dir_remove_ok = localFileSystem->remove(Uri{dirname});
 	ASSERT_TRUE(dir_remove_ok);
-}
\ No newline at end of file
+}
+
+TEST_F(ProviderTest, prefetched_source) {
+	ral::io::data_prefetcher::get_instance().set_max_in_flight(1);
+
+	auto file = std::make_shared<arrow::io::BufferReader>(arrow::Buffer::FromString("0123456789"));
+	auto data = ral::io::data_prefetcher::get_instance().prefetch(file, []() {
+		return std::vector<ral::io::byte_range>{{2, 3}, {6, 4}};
+	});
+	ASSERT_NE(data, nullptr);
+
+	{
+		// the ranges that were read ahead and the rest of the file read the same bytes
+		ral::io::prefetched_source source(data);
+		EXPECT_EQ(source.size(), 10);
+
+		auto prefetched = source.host_read(6, 3);
+		EXPECT_EQ(std::string(reinterpret_cast<const char *>(prefetched->data()), prefetched->size()), "678");
+
+		auto not_prefetched = source.host_read(1, 5);
+		EXPECT_EQ(std::string(reinterpret_cast<const char *>(not_prefetched->data()), not_prefetched->size()), "12345");
+
+		uint8_t dst[3];
+		EXPECT_EQ(source.host_read(2, 3, dst), 3);
+		EXPECT_EQ(std::string(reinterpret_cast<const char *>(dst), 3), "234");
+	}
+
+	ral::io::data_prefetcher::get_instance().set_max_in_flight(0);
+	EXPECT_EQ(ral::io::data_prefetcher::get_instance().prefetch(file, []() { return std::vector<ral::io::byte_range>{}; }), nullptr);
+}
+
+TEST_F(ProviderTest, finding_partition_folders) {
+	ASSERT_TRUE(create_folder_test());
+	LocalFileSystem localFileSystem(Path("/"));
+	std::string table_path = BLAZING_TMP_PATH + "/partitioned";
+	for (std::string folder : {"", "/a=1", "/a=1/b=x", "/a=2", "/a=2/b=y", "/a=2/not_a_partition"}) {
+		ASSERT_TRUE(localFileSystem.makeDirectory(Uri{table_path + folder}));
+	}
+	ASSERT_TRUE(create_dummy_file("a|b", table_path + "/a=3"));
+
+	ral::io::folder_lister::get_instance().configure(4, 0);
+	auto partition_folders = ral::io::folder_lister::get_instance().find_partition_folders(Uri{table_path});
+
+	std::vector<std::pair<std::string, int>> result;
+	for (auto && partition_folder : partition_folders) {
+		result.emplace_back(partition_folder.first.getPath().getResourceName(), partition_folder.second);
+	}
+	std::sort(result.begin(), result.end());
+
+	localFileSystem.remove(Uri{table_path});
+
+	std::vector<std::pair<std::string, int>> expected{{"a=1", 0}, {"a=2", 0}, {"b=x", 1}, {"b=y", 1}};
+	EXPECT_EQ(result, expected);
+}
+
+TEST_F(ProviderTest, circular_shared_scans) {
+	auto & shared_scan = ral::io::shared_scan::get_instance();
+	std::string table_key = ral::io::shared_scan::make_table_key({"/data/a.parquet", "/data/b.parquet", "/data/c.parquet"});
+
+	std::size_t first_start = 5;
+	std::size_t first_scan = shared_scan.join_scan(table_key, first_start);
+	EXPECT_EQ(first_start, 0);
+	shared_scan.update_scan(table_key, first_scan, 2);
+
+	// the scans that join later start where the oldest one is
+	std::size_t second_start = 0;
+	std::size_t second_scan = shared_scan.join_scan(table_key, second_start);
+	EXPECT_EQ(second_start, 2);
+	shared_scan.update_scan(table_key, second_scan, 1);
+
+	shared_scan.leave_scan(table_key, first_scan);
+	std::size_t third_start = 0;
+	std::size_t third_scan = shared_scan.join_scan(table_key, third_start);
+	EXPECT_EQ(third_start, 1);
+
+	shared_scan.leave_scan(table_key, second_scan);
+	shared_scan.leave_scan(table_key, third_scan);
+	std::size_t last_start = 5;
+	shared_scan.leave_scan(table_key, shared_scan.join_scan(table_key, last_start));
+	EXPECT_EQ(last_start, 0);
+}
+
+TEST_F(ProviderTest, shared_scan_read_errors) {
+	auto & shared_scan = ral::io::shared_scan::get_instance();
+	std::string file_key = ral::io::shared_scan::make_file_key("/data/a.parquet", {"a", "b"}, {cudf::type_id::INT32, cudf::type_id::INT64});
+
+	std::atomic<int> num_reads(0);
+	std::mutex read_mutex;
+	std::condition_variable read_cv;
+	bool release_read = false;
+	auto slow_failing_read = [&](const std::vector<int> & /*column_indices*/) -> std::unique_ptr<ral::frame::BlazingTable> {
+		num_reads++;
+		std::unique_lock<std::mutex> lock(read_mutex);
+		read_cv.wait(lock, [&]{ return release_read; });
+		throw std::runtime_error("ERROR: the read failed");
+	};
+
+	// the error of the read in flight is thrown to the scans that wait for it
+	std::thread leader([&]{ EXPECT_THROW(shared_scan.read(file_key, {0, 1}, {2}, slow_failing_read), std::runtime_error); });
+	while (num_reads == 0) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	std::thread waiter([&]{ EXPECT_THROW(shared_scan.read(file_key, {1}, {2}, slow_failing_read), std::runtime_error); });
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	{
+		std::lock_guard<std::mutex> lock(read_mutex);
+		release_read = true;
+	}
+	read_cv.notify_all();
+	leader.join();
+	waiter.join();
+	EXPECT_EQ(num_reads, 1);
+
+	// the reads of other row groups are not shared
+	EXPECT_EQ(shared_scan.read(file_key, {0}, {3}, [&](const std::vector<int> & column_indices) {
+		EXPECT_EQ(column_indices, std::vector<int>{0});
+		num_reads++;
+		return std::unique_ptr<ral::frame::BlazingTable>();
+	}), nullptr);
+	EXPECT_EQ(num_reads, 2);
+}
+
+TEST_F(ProviderTest, scan_work_stealing_files) {
+	std::vector<Uri> uris = {Uri("/data/0.parquet"), Uri("/data/1.parquet"), Uri("/data/2.parquet"), Uri("/data/3.parquet")};
+	std::vector<std::map<std::string, std::string>> uri_values = {{{"year", "2019"}}, {{"year", "2020"}}, {{"year", "2021"}}, {{"year", "2022"}}};
+	ral::io::uri_data_provider provider(uris, uri_values);
+
+	std::vector<ral::io::data_handle> taken = provider.take_last_files(3);
+	ASSERT_EQ(taken.size(), 3);
+	EXPECT_EQ(taken[0].uri.toString(), "/data/1.parquet");
+	EXPECT_EQ(taken[2].column_values.at("year"), "2022");
+	EXPECT_EQ(provider.get_num_handles(), 1);
+	EXPECT_EQ(provider.get_partition_values().size(), 1);
+
+	ral::io::uri_data_provider other({Uri("/data/4.parquet")});
+	other.add_files(taken);
+	EXPECT_EQ(other.get_num_handles(), 4);
+	std::vector<std::map<std::string, std::string>> other_values = other.get_partition_values();
+	ASSERT_EQ(other_values.size(), 4);
+	EXPECT_TRUE(other_values[0].empty());
+	EXPECT_EQ(other_values[1].at("year"), "2020");
+
+	// the uris and hive values of the reply may have any character but the separators
+	std::vector<ral::batch::scan_file> files = {{"hdfs://cluster/a,b.parquet", {{"year", "2020"}, {"city", ""}}, {1, 3}}, {"/data/c.parquet", {}, {}}};
+	std::vector<ral::batch::scan_file> received = ral::batch::deserialize_scan_files(ral::batch::serialize_scan_files(files));
+	ASSERT_EQ(received.size(), 2);
+	EXPECT_EQ(received[0].uri, files[0].uri);
+	EXPECT_EQ(received[0].column_values, files[0].column_values);
+	EXPECT_EQ(received[0].row_group_ids, files[0].row_group_ids);
+	EXPECT_EQ(received[1].uri, files[1].uri);
+	EXPECT_TRUE(received[1].row_group_ids.empty());
+	EXPECT_TRUE(ral::batch::deserialize_scan_files("").empty());
+}
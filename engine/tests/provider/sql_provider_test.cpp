@@ -1,6 +1,7 @@
 #include "io/data_parser/sql/MySQLParser.h"
 #include "io/data_parser/sql/PostgreSQLParser.h"
 #include "io/data_parser/sql/SQLiteParser.h"
+#include "io/data_parser/sql/sqlcommon.h"
 #include "io/data_provider/sql/MySQLDataProvider.h"
 #include "io/data_provider/sql/PostgreSQLDataProvider.h"
 #include "io/data_provider/sql/SQLiteDataProvider.h"
@@ -13,6 +14,91 @@
 
 struct SQLProviderTest : public BlazingUnitTest {};
 
+namespace {
+
+// answers the MIN, MAX and COUNT query of the partitions without a database
+class range_sql_data_provider : public ral::io::abstractsql_data_provider {
+public:
+  range_sql_data_provider(const ral::io::sql_info &sql, size_t total_number_of_nodes, size_t self_node_idx,
+    std::vector<std::string> range)
+    : abstractsql_data_provider(sql, total_number_of_nodes, self_node_idx), range(range) {
+    this->column_names = {"name", "id"};
+    this->column_types = {"varchar(20)", "bigint(20)"};
+    this->init_partitions();
+  }
+
+  std::shared_ptr<data_provider> clone() override { return nullptr; }
+  bool has_next() override { return false; }
+  void reset() override {}
+  ral::io::data_handle get_next(bool = true) override { return ral::io::data_handle(); }
+  size_t get_num_handles() override { return this->get_num_partitions(); }
+
+  std::string query(size_t batch_index) const { return this->build_select_query(batch_index); }
+
+protected:
+  std::unique_ptr<ral::parser::node_transformer> get_predicate_transformer() const override { return nullptr; }
+
+  std::vector<std::string> run_single_row_query(const std::string &) override { return this->range; }
+
+private:
+  std::vector<std::string> range;
+};
+
+} // namespace
+
+TEST_F(SQLProviderTest, parse_timestamp_microseconds) {
+  using ral::io::microseconds_to_ticks;
+  using ral::io::parse_timestamp_microseconds;
+  std::int64_t us;
+
+  std::string date = "2021-03-04";
+  ASSERT_TRUE(parse_timestamp_microseconds(date.data(), date.size(), us));
+  EXPECT_EQ(microseconds_to_ticks(us, cudf::type_id::TIMESTAMP_DAYS), 18690);
+
+  std::string timestamp = "1969-12-31 23:59:59.5";
+  ASSERT_TRUE(parse_timestamp_microseconds(timestamp.data(), timestamp.size(), us));
+  EXPECT_EQ(us, -500000);
+  EXPECT_EQ(microseconds_to_ticks(us, cudf::type_id::TIMESTAMP_MILLISECONDS), -500);
+  EXPECT_EQ(microseconds_to_ticks(us, cudf::type_id::TIMESTAMP_SECONDS), -1);
+
+  std::string time = "01:02:03";
+  ASSERT_TRUE(parse_timestamp_microseconds(time.data(), time.size(), us));
+  EXPECT_EQ(microseconds_to_ticks(us, cudf::type_id::TIMESTAMP_SECONDS), 3723);
+
+  std::string text = "not a date";
+  EXPECT_FALSE(parse_timestamp_microseconds(text.data(), text.size(), us));
+}
+
+TEST_F(SQLProviderTest, partitions_by_integer_column) {
+  ral::io::sql_info sql;
+  sql.table = "prueba";
+  sql.table_filter = "name <> ''";
+  sql.table_batch_size = 100;
+  sql.table_partitions = 3;
+  sql.table_connections = 1;
+
+  // the partitions are split between the two nodes
+  range_sql_data_provider provider(sql, 2, 1, {"0", "29", "30"});
+  EXPECT_EQ(provider.get_num_handles(), 1u);
+  EXPECT_EQ(provider.query(0), "SELECT * FROM prueba where (name <> '') AND id >= 10 AND id < 20");
+
+  range_sql_data_provider first_node(sql, 2, 0, {"0", "29", "30"});
+  EXPECT_EQ(first_node.get_num_handles(), 2u);
+  EXPECT_EQ(first_node.query(1), "SELECT * FROM prueba where (name <> '') AND (id >= 20 OR id IS NULL)");
+}
+
+TEST_F(SQLProviderTest, partitions_fall_back_to_limit_offset) {
+  ral::io::sql_info sql;
+  sql.table = "prueba";
+  sql.table_batch_size = 100;
+  sql.table_partitions = 0;
+  sql.table_connections = 1;
+
+  // an empty table has no MIN and MAX
+  range_sql_data_provider provider(sql, 1, 0, {"", "", "0"});
+  EXPECT_EQ(provider.query(2), "SELECT * FROM prueba LIMIT 100 OFFSET 200");
+}
+
 TEST_F(SQLProviderTest, DISABLED_postgresql_select_all) {
   ral::io::sql_info sql;
   sql.host = "localhost";
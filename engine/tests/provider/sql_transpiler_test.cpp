@@ -127,3 +127,57 @@ TEST_P(SQLTranspilerTest, default_check) {
 }
 
 INSTANTIATE_TEST_SUITE_P(SQLTranspilerTestCase, SQLTranspilerTest, testing::ValuesIn(default_check_entries));
+
+struct SQLPushdownTest : public testing::Test {
+  std::vector<int> column_indices = {0, 1, 2, 3};
+  std::vector<std::string> column_names = {"a", "b", "c", "d"};
+  std::vector<cudf::type_id> column_types = {cudf::type_id::INT32, cudf::type_id::FLOAT64,
+                                             cudf::type_id::STRING, cudf::type_id::INT64};
+  sql_tools::sql_dialect dialect{{{cudf::type_id::INT64, "BIGINT"},
+                                  {cudf::type_id::FLOAT64, "DOUBLE PRECISION"}}, true};
+};
+
+TEST_F(SQLPushdownTest, aggregation_with_groups) {
+  sql_tools::aggregation_pushdown pushdown;
+  ASSERT_TRUE(sql_tools::transpile_aggregation(
+    "LogicalAggregate(group=[{2}], EXPR$1=[SUM($0)], total=[$SUM0($1)], EXPR$3=[COUNT()], EXPR$4=[MAX($3)])",
+    this->column_indices, this->column_names, this->column_types, this->dialect, pushdown));
+
+  EXPECT_EQ(pushdown.select_list, "c, CAST(SUM(a) AS BIGINT), CAST(COALESCE(SUM(b), 0) AS DOUBLE PRECISION), COUNT(*), MAX(d)");
+  EXPECT_EQ(pushdown.group_by, "c");
+  EXPECT_EQ(pushdown.names.size(), 5);
+  EXPECT_EQ(pushdown.names[2], "total");
+  std::vector<cudf::type_id> expected_types = {cudf::type_id::STRING, cudf::type_id::INT64,
+    cudf::type_id::FLOAT64, cudf::type_id::INT64, cudf::type_id::INT64};
+  EXPECT_EQ(pushdown.types, expected_types);
+}
+
+TEST_F(SQLPushdownTest, aggregation_of_projected_columns) {
+  sql_tools::aggregation_pushdown pushdown;
+  ASSERT_TRUE(sql_tools::transpile_aggregation("LogicalAggregate(group=[{}], EXPR$0=[COUNT($1)])",
+    {3, 0}, this->column_names, this->column_types, this->dialect, pushdown));
+
+  EXPECT_EQ(pushdown.select_list, "COUNT(a)");
+  EXPECT_TRUE(pushdown.group_by.empty());
+}
+
+TEST_F(SQLPushdownTest, aggregation_not_pushed_down) {
+  sql_tools::aggregation_pushdown pushdown;
+  // the strings are not compared like the engine does
+  this->dialect.compares_strings_exactly = false;
+  EXPECT_FALSE(sql_tools::transpile_aggregation("LogicalAggregate(group=[{2}], EXPR$1=[SUM($0)])",
+    this->column_indices, this->column_names, this->column_types, this->dialect, pushdown));
+  // MIN and MAX of strings, and the distinct aggregations
+  EXPECT_FALSE(sql_tools::transpile_aggregation("LogicalAggregate(group=[{}], EXPR$0=[MIN($2)])",
+    this->column_indices, this->column_names, this->column_types, this->dialect, pushdown));
+  EXPECT_FALSE(sql_tools::transpile_aggregation("LogicalAggregate(group=[{}], EXPR$0=[COUNT(DISTINCT $0)])",
+    this->column_indices, this->column_names, this->column_types, this->dialect, pushdown));
+}
+
+TEST_F(SQLPushdownTest, order_by) {
+  EXPECT_EQ(sql_tools::transpile_order_by("LogicalSort(sort0=[$3], sort1=[$0], dir0=[DESC], dir1=[ASC], fetch=[10])",
+    this->column_indices, this->column_names, this->column_types),
+    "CASE WHEN d IS NULL THEN 1 ELSE 0 END DESC, d DESC, CASE WHEN a IS NULL THEN 1 ELSE 0 END ASC, a ASC");
+  EXPECT_EQ(sql_tools::transpile_order_by("LogicalSort(sort0=[$2], dir0=[ASC], fetch=[10])",
+    this->column_indices, this->column_names, this->column_types), "");
+}
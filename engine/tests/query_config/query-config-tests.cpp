@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+
+#include "tests/utilities/BlazingUnitTest.h"
+#include "execution_graph/QueryConfig.h"
+#include "cache_machine/CacheData.h"
+
+#define DESCR(d) RecordProperty("description", d)
+
+using blazingdb::manager::QueryConfig;
+
+struct QueryConfigTest : public BlazingUnitTest {
+	QueryConfig parse(const std::map<std::string, std::string> & config_options) {
+		return QueryConfig(config_options);
+	}
+};
+
+TEST_F(QueryConfigTest, parses_typed_options) {
+	DESCR("The options are parsed into their types, and the ones that are not set are left empty");
+
+	QueryConfig config = parse({{"MAX_KERNEL_RUN_THREADS", "4"},
+		{"JOIN_SKEW_HEAVY_HITTER_THRESHOLD", "0.25"},
+		{"ENABLE_TREE_BROADCAST", "False"},
+		{"MAX_JOIN_SCATTER_MEM_OVERHEAD", "500000000.0"},
+		{"RESOURCE_GROUP", "etl"},
+		{"CACHE_SPILL_FORMAT", "RAW"},
+		{"SOME_PLANNER_OPTION", "x"}});
+
+	EXPECT_EQ(config.max_kernel_run_threads.value(), 4);
+	EXPECT_DOUBLE_EQ(config.join_skew_heavy_hitter_threshold.value(), 0.25);
+	EXPECT_FALSE(config.enable_tree_broadcast.value());
+	EXPECT_EQ(config.max_join_scatter_mem_overhead.value(), 500000000u);
+	EXPECT_EQ(config.resource_group.value(), "etl");
+	EXPECT_TRUE(config.cache_spill_raw);
+	EXPECT_FALSE(config.query_priority.has_value());
+	EXPECT_EQ(config.max_order_by_samples_per_node.value_or(10000), 10000u);
+	EXPECT_EQ(config.options.at("SOME_PLANNER_OPTION"), "x");
+}
+
+TEST_F(QueryConfigTest, rejects_invalid_values) {
+	DESCR("A value that is not of the type of its option fails the query when its Context is created");
+
+	EXPECT_THROW(parse({{"MAX_KERNEL_RUN_THREADS", "four"}}), std::runtime_error);
+	EXPECT_THROW(parse({{"QUERY_PRIORITY", "-1"}}), std::runtime_error);
+	EXPECT_THROW(parse({{"FLOW_CONTROL_BYTES_THRESHOLD", "1.5"}}), std::runtime_error);
+	EXPECT_THROW(parse({{"ENABLE_JOIN_RUNTIME_FILTER", "yes"}}), std::runtime_error);
+	EXPECT_THROW(parse({{"CACHE_SPILL_FORMAT", "ZIP"}}), std::runtime_error);
+}
+
+TEST_F(QueryConfigTest, metadata_header) {
+	DESCR("The routing fields of the message metadata are parsed when they are set, and kept in the map that is sent");
+
+	ral::cache::MetadataDictionary metadata;
+	metadata.add_value(ral::cache::QUERY_ID_METADATA_LABEL, 12);
+	metadata.add_value(ral::cache::KERNEL_ID_METADATA_LABEL, "7");
+	metadata.add_value(ral::cache::ADD_TO_SPECIFIC_CACHE_METADATA_LABEL, "true");
+	metadata.add_value(ral::cache::TOTAL_TABLE_ROWS_METADATA_LABEL, "1000");
+
+	EXPECT_EQ(metadata.get_query_id(), 12);
+	EXPECT_EQ(metadata.get_kernel_id(), 7);
+	EXPECT_TRUE(metadata.get_header().add_to_specific_cache);
+	EXPECT_EQ(metadata.get_total_table_rows(), 1000);
+	EXPECT_THROW(metadata.get_partition_count(), BlazingMissingMetadataException);
+	EXPECT_EQ(metadata.get_value(ral::cache::KERNEL_ID_METADATA_LABEL), "7");
+	EXPECT_EQ(metadata.get_value(ral::cache::CACHE_ID_METADATA_LABEL), "");
+
+	ral::cache::MetadataDictionary received;
+	received.set_values(metadata.get_values());
+	EXPECT_EQ(received.get_query_id(), 12);
+	EXPECT_EQ(received.get_kernel_id(), 7);
+	EXPECT_EQ(received.get_total_table_rows(), 1000);
+}
+
+TEST_F(QueryConfigTest, metadata_serialization) {
+	DESCR("The metadata reads back the same from its binary form, with the fields that are not numbers as extensions");
+
+	ral::cache::MetadataDictionary metadata;
+	metadata.add_value(ral::cache::QUERY_ID_METADATA_LABEL, 12);
+	metadata.add_value(ral::cache::UNIQUE_MESSAGE_ID, "123456789012");
+	metadata.add_value(ral::cache::ADD_TO_SPECIFIC_CACHE_METADATA_LABEL, "false");
+	metadata.add_value(ral::cache::WORKER_IDS_METADATA_LABEL, "0,1,2");
+	metadata.add_value(ral::cache::CACHE_ID_METADATA_LABEL, "");
+	metadata.add_value(ral::cache::KERNEL_ID_METADATA_LABEL, "not a number");
+	metadata.add_value(ral::cache::OVERLAP_STATUS, "DONE");
+
+	std::vector<char> buffer;
+	metadata.serialize(buffer);
+	ral::cache::MetadataDictionary received = ral::cache::MetadataDictionary::deserialize(buffer.data(), buffer.size());
+
+	EXPECT_TRUE(received == metadata);
+	EXPECT_EQ(received.get_query_id(), 12);
+	EXPECT_EQ(received.get_header().worker_ids, "0,1,2");
+	EXPECT_TRUE(received.has_value(ral::cache::CACHE_ID_METADATA_LABEL));
+	EXPECT_FALSE(received.has_value(ral::cache::MESSAGE_ID));
+	EXPECT_EQ(received.get_value(ral::cache::UNIQUE_MESSAGE_ID), "123456789012");
+	EXPECT_EQ(received.get_value(ral::cache::ADD_TO_SPECIFIC_CACHE_METADATA_LABEL), "false");
+	EXPECT_THROW(received.get_kernel_id(), BlazingMissingMetadataException);
+	EXPECT_EQ(received.get_value(ral::cache::KERNEL_ID_METADATA_LABEL), "not a number");
+	EXPECT_EQ(received.get_value(ral::cache::OVERLAP_STATUS), "DONE");
+
+	EXPECT_THROW(ral::cache::MetadataDictionary::deserialize(buffer.data(), buffer.size() - 1), std::runtime_error);
+}
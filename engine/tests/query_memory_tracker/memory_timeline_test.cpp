@@ -0,0 +1,53 @@
+#include <gtest/gtest.h>
+
+#include <sstream>
+
+#include <spdlog/sinks/ostream_sink.h>
+
+#include <src/bmr/MemoryTimeline.h>
+#include <src/bmr/QueryMemoryTracker.h>
+
+using ral::memory::memory_timeline;
+using ral::memory::scoped_allocation_owner;
+
+TEST(MemoryTimelineTest, LogsEventsWithTheOwnerOfTheThread) {
+	std::ostringstream out;
+	auto sink = std::make_shared<spdlog::sinks::ostream_sink_mt>(out);
+	sink->set_pattern("%v");
+	auto logger = std::make_shared<spdlog::logger>("memory_timeline_test", sink);
+
+	auto & timeline = memory_timeline::get_instance();
+	timeline.start(logger);
+	ASSERT_TRUE(timeline.is_recording());
+	char buffer[1];
+	{
+		scoped_allocation_owner owner(2001, 3);
+		timeline.record_allocation(&buffer[0], 100, 100);
+		timeline.record_out_of_memory(1000, 100);
+	}
+	timeline.record_deallocation(&buffer[0], 100, 0);
+	timeline.record_spill(2001, -1, 40, 60, "cache 5");
+	timeline.stop();
+	EXPECT_FALSE(timeline.is_recording());
+
+	std::vector<std::vector<std::string>> lines;
+	std::istringstream in(out.str());
+	std::string line;
+	while (std::getline(in, line)) {
+		std::vector<std::string> fields;
+		std::istringstream line_in(line);
+		std::string field;
+		while (std::getline(line_in, field, '|')) {
+			fields.push_back(field);
+		}
+		// the timestamp and the address change from run to run
+		fields.erase(fields.begin());
+		fields.erase(fields.begin() + 1);
+		lines.push_back(fields);
+	}
+	ASSERT_EQ(lines.size(), 4);
+	EXPECT_EQ(lines[0], std::vector<std::string>({"allocate", "100", "2001", "3", "100"}));
+	EXPECT_EQ(lines[1], std::vector<std::string>({"oom", "1000", "2001", "3", "100"}));
+	EXPECT_EQ(lines[2], std::vector<std::string>({"free", "100", "-1", "-1", "0"}));
+	EXPECT_EQ(lines[3], std::vector<std::string>({"spill", "40", "2001", "-1", "60", "cache 5"}));
+}
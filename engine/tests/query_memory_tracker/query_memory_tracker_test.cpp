@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include <src/bmr/QueryMemoryTracker.h>
+
+using ral::memory::query_memory_tracker;
+using ral::memory::scoped_allocation_owner;
+
+TEST(QueryMemoryTrackerTest, TracksCurrentAndPeakUsage) {
+	auto & tracker = query_memory_tracker::get_instance();
+	char buffer[3];
+	{
+		scoped_allocation_owner owner(1001, 1);
+		tracker.record_allocation(&buffer[0], 100);
+		tracker.record_allocation(&buffer[1], 50);
+	}
+	{
+		scoped_allocation_owner owner(1001, 2);
+		tracker.record_allocation(&buffer[2], 200);
+	}
+	tracker.record_deallocation(&buffer[0]);
+
+	auto usage = tracker.get_query_usage(1001);
+	EXPECT_EQ(usage.current, 250);
+	EXPECT_EQ(usage.peak, 350);
+
+	auto kernel_usages = tracker.get_kernel_usages(1001);
+	ASSERT_EQ(kernel_usages.size(), 2);
+	EXPECT_EQ(kernel_usages[1].current, 50);
+	EXPECT_EQ(kernel_usages[1].peak, 150);
+	EXPECT_EQ(kernel_usages[2].current, 200);
+
+	tracker.record_deallocation(&buffer[1]);
+	tracker.record_deallocation(&buffer[2]);
+	EXPECT_EQ(tracker.get_query_usage(1001).current, 0);
+	EXPECT_EQ(tracker.get_query_usage(1001).peak, 350);
+}
+
+TEST(QueryMemoryTrackerTest, DoesNotTrackAllocationsWithoutOwner) {
+	auto & tracker = query_memory_tracker::get_instance();
+	char buffer;
+	tracker.record_allocation(&buffer, 100);
+	tracker.record_deallocation(&buffer);
+	EXPECT_EQ(tracker.get_query_usage(-1).peak, 0);
+}
+
+TEST(QueryMemoryTrackerTest, DeallocationFromOtherThreadIsAttributedToOwner) {
+	auto & tracker = query_memory_tracker::get_instance();
+	char buffer;
+	{
+		scoped_allocation_owner owner(1002, 1);
+		tracker.record_allocation(&buffer, 100);
+		{
+			scoped_allocation_owner nested_owner(1003, 1);
+			EXPECT_EQ(query_memory_tracker::get_thread_owner().ctx_token, 1003);
+		}
+		EXPECT_EQ(query_memory_tracker::get_thread_owner().ctx_token, 1002);
+	}
+	std::thread([&]() { tracker.record_deallocation(&buffer); }).join();
+
+	EXPECT_EQ(tracker.get_query_usage(1002).current, 0);
+	EXPECT_EQ(tracker.get_query_usage(1002).peak, 100);
+	EXPECT_EQ(tracker.get_query_usage(1003).peak, 0);
+}
@@ -0,0 +1,48 @@
+#include <gtest/gtest.h>
+
+#include "execution_graph/resource_group.h"
+
+#define DESCR(d) RecordProperty("description", d)
+
+using namespace ral;
+
+TEST(ResourceGroupTest, firstTaskAlwaysRuns) {
+   DESCR("a task can always run if there are no tasks of its group running, even if it does not fit in the budget");
+
+   execution::resource_group group("interactive", 100, 2);
+   EXPECT_TRUE(group.can_run(1000));
+
+   group.task_started(1000);
+   EXPECT_FALSE(group.can_run(1));
+   group.task_finished(1000);
+   EXPECT_TRUE(group.can_run(1000));
+}
+
+TEST(ResourceGroupTest, limitsThreadsAndMemory) {
+   DESCR("tasks of a group can not run over the thread share or the memory limit of the group");
+
+   execution::resource_group group("batch", 100, 2);
+   group.task_started(40);
+   EXPECT_TRUE(group.can_run(60));
+   EXPECT_FALSE(group.can_run(61));
+
+   group.task_started(10);
+   EXPECT_EQ(group.get_active_tasks(), 2);
+   EXPECT_FALSE(group.can_run(1));
+}
+
+TEST(ResourceGroupTest, overBudgetCountsQueryCaches) {
+   DESCR("the memory held in the caches of the queries of a group counts towards its budget");
+
+   execution::resource_group group("batch", 100, 2);
+   group.task_started(50);
+   EXPECT_FALSE(group.is_over_budget());
+
+   group.set_query_cache_bytes(1, 30);
+   group.set_query_cache_bytes(2, 30);
+   EXPECT_EQ(group.get_memory_used(), 110);
+   EXPECT_TRUE(group.is_over_budget());
+
+   group.remove_query(2);
+   EXPECT_FALSE(group.is_over_budget());
+}
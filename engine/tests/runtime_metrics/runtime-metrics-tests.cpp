@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+
+#include "tests/utilities/BlazingUnitTest.h"
+#include "utilities/RuntimeMetrics.h"
+
+#define DESCR(d) RecordProperty("description", d)
+
+using namespace ral;
+
+struct RuntimeMetricsTest : public BlazingUnitTest {};
+
+TEST_F(RuntimeMetricsTest, countsSpillsByTier) {
+   DESCR("the spills are counted by the tier they went to, and the unspills and oom retries on their own");
+
+   auto & metrics = utilities::runtime_metrics::get_instance();
+   uint64_t host_spills = metrics.get_spills(utilities::spill_tier::host);
+   uint64_t host_bytes = metrics.get_spill_bytes(utilities::spill_tier::host);
+   uint64_t disk_bytes = metrics.get_spill_bytes(utilities::spill_tier::disk);
+   uint64_t unspill_bytes = metrics.get_unspill_bytes();
+   uint64_t oom_retries = metrics.get_oom_retries();
+
+   metrics.record_spill(utilities::spill_tier::host, 100);
+   metrics.record_spill(utilities::spill_tier::host, 50);
+   metrics.record_spill(utilities::spill_tier::disk, 10);
+   metrics.record_unspill(30);
+   metrics.record_oom_retry();
+
+   EXPECT_EQ(metrics.get_spills(utilities::spill_tier::host), host_spills + 2);
+   EXPECT_EQ(metrics.get_spill_bytes(utilities::spill_tier::host), host_bytes + 150);
+   EXPECT_EQ(metrics.get_spill_bytes(utilities::spill_tier::disk), disk_bytes + 10);
+   EXPECT_EQ(metrics.get_unspill_bytes(), unspill_bytes + 30);
+   EXPECT_EQ(metrics.get_oom_retries(), oom_retries + 1);
+}
+
+TEST_F(RuntimeMetricsTest, histogramBuckets) {
+   DESCR("bucket i of a histogram counts the durations of less than 2^i microseconds");
+
+   EXPECT_EQ(utilities::atomic_histogram::bucket(0), 0);
+   EXPECT_EQ(utilities::atomic_histogram::bucket(0.000001), 1);
+   EXPECT_EQ(utilities::atomic_histogram::bucket(0.000003), 2);
+   EXPECT_EQ(utilities::atomic_histogram::bucket(1e9), utilities::atomic_histogram::num_buckets - 1);
+
+   utilities::atomic_histogram histogram;
+   histogram.record(0.000003);
+   histogram.record(0.000003);
+   histogram.record(0.5);
+   EXPECT_EQ(histogram.get_count(), 3);
+   EXPECT_EQ(histogram.get_buckets()[2], 2);
+   EXPECT_EQ(histogram.get_sum_us(), 500006);
+}
+
+TEST_F(RuntimeMetricsTest, exportsOpenMetrics) {
+   DESCR("the metrics are exported in the OpenMetrics text format, with the counters ending in _total");
+
+   auto & metrics = utilities::runtime_metrics::get_instance();
+   metrics.record_task(0.002);
+   std::string text = metrics.to_openmetrics();
+
+   EXPECT_NE(text.find("# TYPE blazingsql_spill_bytes counter\n"), std::string::npos);
+   EXPECT_NE(text.find("blazingsql_spill_bytes_total{tier=\"host\"} "), std::string::npos);
+   EXPECT_NE(text.find("blazingsql_memory_used_bytes{tier=\"gpu\"} "), std::string::npos);
+   EXPECT_NE(text.find("blazingsql_task_duration_seconds_bucket{le=\"+Inf\"} "), std::string::npos);
+   EXPECT_NE(text.find("blazingsql_task_duration_seconds_count "), std::string::npos);
+   EXPECT_EQ(text.substr(text.size() - 6), "# EOF\n");
+}
@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+
+#include <src/bmr/ScratchArena.h>
+
+using ral::memory::scratch_arena_memory_resource;
+
+namespace {
+const std::size_t MiB = 1 << 20;
+}
+
+TEST(ScratchArenaTest, AllocationsAreConsecutiveAndReusedAfterReset) {
+	scratch_arena_memory_resource arena(8 * MiB);
+
+	char * first = static_cast<char *>(arena.allocate(100));
+	char * second = static_cast<char *>(arena.allocate(1000));
+	EXPECT_EQ(second, first + 256);
+	EXPECT_EQ(arena.get_capacity(), MiB);
+
+	arena.deallocate(second, 1000);
+	arena.deallocate(first, 100);
+	arena.reset(false);
+
+	char * again = static_cast<char *>(arena.allocate(100));
+	EXPECT_EQ(again, first);
+	arena.deallocate(again, 100);
+	arena.reset(true);
+	EXPECT_EQ(arena.get_capacity(), 0);
+}
+
+TEST(ScratchArenaTest, ResetKeepsTheBlockWhileSomethingIsAlive) {
+	scratch_arena_memory_resource arena(8 * MiB);
+
+	char * alive = static_cast<char *>(arena.allocate(100));
+	arena.reset(false);
+	char * next = static_cast<char *>(arena.allocate(100));
+	EXPECT_NE(next, alive);
+
+	arena.deallocate(next, 100);
+	arena.deallocate(alive, 100);
+	arena.reset(true);
+}
+
+TEST(ScratchArenaTest, WhatDoesNotFitGrowsTheNextBlock) {
+	scratch_arena_memory_resource arena(8 * MiB);
+
+	void * small = arena.allocate(MiB / 2);
+	void * large = arena.allocate(2 * MiB); // from the device resource, it does not fit in the first block
+	arena.deallocate(large, 2 * MiB);
+	arena.deallocate(small, MiB / 2);
+	arena.reset(false);
+
+	void * p = arena.allocate(100);
+	EXPECT_EQ(arena.get_capacity(), 2 * MiB + MiB / 2);
+	arena.deallocate(p, 100);
+
+	void * too_large = arena.allocate(16 * MiB); // never from the block
+	arena.deallocate(too_large, 16 * MiB);
+	arena.reset(false);
+	p = arena.allocate(100);
+	EXPECT_EQ(arena.get_capacity(), 8 * MiB);
+	arena.deallocate(p, 100);
+	arena.reset(true);
+}
+
+TEST(ScratchArenaTest, TaskScratchResourceIsTheArenaOfTheThread) {
+	scratch_arena_memory_resource arena(8 * MiB);
+	EXPECT_EQ(ral::memory::get_task_scratch_resource(), rmm::mr::get_current_device_resource());
+
+	ral::memory::set_task_scratch_arena(&arena);
+	EXPECT_EQ(ral::memory::get_task_scratch_resource(), &arena);
+
+	ral::memory::set_task_scratch_arena(nullptr);
+	EXPECT_EQ(ral::memory::get_task_scratch_resource(), rmm::mr::get_current_device_resource());
+}
@@ -150,6 +150,36 @@ TEST_F(ExpressionTreeTest, expr_test_12) {
   process(prefix, expected, valid_expr);
 }
 
+TEST_F(ExpressionTreeTest, string_equal) {
+  std::string prefix = "=($1, 'active')";
+  std::string expected = "AND <= $2 'active' >= $3 'active'";
+  process(prefix, expected);
+}
+
+TEST_F(ExpressionTreeTest, string_in_list) {
+  std::string prefix = "OR(=($0, 'US'), =($0, 'EU'))";
+  std::string expected = "OR AND <= $0 'US' >= $1 'US' AND <= $0 'EU' >= $1 'EU'";
+  process(prefix, expected);
+}
+
+TEST_F(ExpressionTreeTest, null_checks_with_null_counts) {
+  std::vector<bool> null_count_columns{true, false};
+
+  ral::parser::parse_tree is_null_tree;
+  is_null_tree.build("IS_NULL($0)");
+  EXPECT_TRUE(ral::skip_data::apply_skip_data_rules(is_null_tree, null_count_columns));
+  EXPECT_EQ(is_null_tree.prefix(), "<> $4 0");
+
+  ral::parser::parse_tree is_not_null_tree;
+  is_not_null_tree.build("AND(IS_NOT_NULL($0), =($1, 500))");
+  EXPECT_TRUE(ral::skip_data::apply_skip_data_rules(is_not_null_tree, null_count_columns));
+  EXPECT_EQ(is_not_null_tree.prefix(), "AND <> $4 $6 AND <= $2 500 >= $3 500");
+
+  ral::parser::parse_tree no_null_count_tree;
+  no_null_count_tree.build("OR(IS_NULL($1), =($0, 500))");
+  EXPECT_FALSE(ral::skip_data::apply_skip_data_rules(no_null_count_tree, null_count_columns));
+}
+
 TEST_F(ExpressionTreeTest, drop_test1) {
   std::string prefix = "OR(AND(AND(>($0, 100), =(+($0, $1), 123)), <($1, 10)), =($0, 500))";
   std::string expected = "OR > $1 100 AND <= $0 500 >= $1 500";
@@ -225,3 +255,33 @@ TEST_F(ExpressionTreeTest, drop_test3) {
     EXPECT_EQ(solution, expected);
 
 }
+
+TEST_F(ExpressionTreeTest, partitions_to_read) {
+  std::vector<std::map<std::string, std::string>> partition_values{{{"year", "2019"}}, {{"year", "2020"}}, {{"year", "2021"}}};
+  std::vector<std::string> names{"a", "year"};
+  std::vector<cudf::type_id> types{cudf::type_id::INT32, cudf::type_id::INT32};
+
+  std::string table_scan = "BindableTableScan(table=[[main, t]], filters=[[>=($1, 2020)]], projects=[[0, 1]], aliases=[[a, year]])";
+  EXPECT_EQ(get_partitions_to_read(partition_values, names, types, table_scan), std::vector<std::size_t>({1, 2}));
+
+  // a filter on a column that is not a partition column can't prune any partition
+  table_scan = "BindableTableScan(table=[[main, t]], filters=[[=($0, 5)]], projects=[[0, 1]], aliases=[[a, year]])";
+  EXPECT_EQ(get_partitions_to_read(partition_values, names, types, table_scan), std::vector<std::size_t>({0, 1, 2}));
+}
+
+TEST_F(ExpressionTreeTest, all_rows_pass_condition) {
+  // the min and max of $0 are $0 and $1, the ones of $1 are $2 and $3, and their null counts are $4 and $5
+  std::vector<int> min_col_indices{0, 2};
+  std::vector<int> null_count_col_indices{4, 5};
+
+  EXPECT_EQ(get_all_rows_pass_condition(">=($0, 10)", min_col_indices, null_count_col_indices), "AND(>=($0, 10), =($4, 0))");
+  EXPECT_EQ(get_all_rows_pass_condition("AND(<($1, 5), =(3, $0))", min_col_indices, null_count_col_indices),
+    "AND(AND(<($3, 5), =($5, 0)), AND(AND(=($0, 3), =($1, 3)), =($4, 0)))");
+
+  // one side of an OR is enough for all the rows to pass it, but not of an AND
+  EXPECT_EQ(get_all_rows_pass_condition("OR(>($0, 1), =($0, $1))", min_col_indices, null_count_col_indices), "AND(>($0, 1), =($4, 0))");
+  EXPECT_EQ(get_all_rows_pass_condition("AND(>($0, 1), =($0, $1))", min_col_indices, null_count_col_indices), "");
+
+  // a column without statistics can't tell
+  EXPECT_EQ(get_all_rows_pass_condition("<($1, 5)", {0, -1}, {4, -1}), "");
+}
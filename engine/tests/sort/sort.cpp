@@ -12,6 +12,10 @@
 #include <cudf/detail/gather.hpp>
 #include "tests/utilities/BlazingUnitTest.h"
 #include <operators/OrderBy.h>
+#include <operators/RadixSort.h>
+#include <cudf/copying.hpp>
+#include <cudf/sorting.hpp>
+#include <distribution_utils/primitives.h>
 #include <utilities/CommonOperations.h>
 
 template <typename T>
@@ -75,3 +79,115 @@ TYPED_TEST(LimitTest, withoutNull) {
 
     cudf::test::expect_tables_equivalent(expect_cudf_table_view, table_out->view());
 }
+
+TYPED_TEST(SortTest, topK) {
+
+    using T = TypeParam;
+
+    cudf::test::fixed_width_column_wrapper<T> col1{{5, 4, 3, 5, 8, 5, 6}, {1, 1, 1, 1, 1, 1, 1}};
+    cudf::test::strings_column_wrapper col2({"b", "d", "a", "d", "l", "c", "k"}, {1, 1, 1, 1, 1, 1, 1});
+    cudf::test::fixed_width_column_wrapper<T> col3{{10, 40, 70, 5, 2, 12, 11}, {1, 1, 1, 1, 1, 1, 1}};
+
+    CudfTableView cudf_table_in_view {{col1, col2, col3}};
+
+    std::vector<std::string> names({"A", "B", "C"});
+    ral::frame::BlazingTableView table(cudf_table_in_view, names);
+
+    std::vector<int> sortColIndices{0, 2};
+    std::vector<cudf::order> sortOrderTypes{cudf::order::DESCENDING, cudf::order::ASCENDING};
+
+    std::unique_ptr<ral::frame::BlazingTable> table_out = ral::operators::top_k(table, sortColIndices, sortOrderTypes, 4);
+
+    cudf::test::fixed_width_column_wrapper<T> expect_col1{{8, 6, 5, 5}, {1, 1, 1, 1}};
+    cudf::test::strings_column_wrapper expect_col2({"l", "k", "d", "b"}, {1, 1, 1, 1});
+    cudf::test::fixed_width_column_wrapper<T> expect_col3{{2, 11, 5, 10}, {1, 1, 1, 1}};
+    CudfTableView expect_cudf_table_view {{expect_col1, expect_col2, expect_col3}};
+
+    cudf::test::expect_tables_equivalent(expect_cudf_table_view, table_out->view());
+}
+
+TYPED_TEST(SortTest, partitionWithDuplicatePivots) {
+
+    using T = TypeParam;
+
+    cudf::test::fixed_width_column_wrapper<T> col1{{1, 2, 2, 2, 2, 2, 2, 3}};
+    cudf::test::fixed_width_column_wrapper<T> col2{{10, 40, 70, 5, 2, 10, 11, 4}};
+    CudfTableView cudf_table_in_view {{col1, col2}};
+    ral::frame::BlazingTableView table(cudf_table_in_view, {"A", "B"});
+
+    cudf::test::fixed_width_column_wrapper<T> pivots_col{{2, 2}};
+    CudfTableView pivots_view {{pivots_col}};
+    ral::frame::BlazingTableView pivots(pivots_view, {"A"});
+
+    std::vector<int> sortColIndices{0};
+    std::vector<cudf::order> sortOrderTypes{cudf::order::ASCENDING};
+
+    // all the rows with the pivot go to the first partition
+    std::vector<cudf::table_view> partitions = ral::operators::partition_table(pivots, table, sortOrderTypes, sortColIndices);
+    EXPECT_EQ(partitions.size(), 3);
+    EXPECT_EQ(partitions[0].num_rows(), 7);
+    EXPECT_EQ(partitions[1].num_rows(), 0);
+    EXPECT_EQ(partitions[2].num_rows(), 1);
+
+    // they are split among the partitions that start at or after the pivot
+    partitions = ral::operators::partition_table(pivots, table, sortOrderTypes, sortColIndices, true);
+    EXPECT_EQ(partitions.size(), 3);
+    EXPECT_EQ(partitions[0].num_rows(), 3);
+    EXPECT_EQ(partitions[1].num_rows(), 2);
+    EXPECT_EQ(partitions[2].num_rows(), 3);
+}
+
+TYPED_TEST(SortTest, mergeRunsThatDontOverlap) {
+
+    using T = TypeParam;
+
+    cudf::test::fixed_width_column_wrapper<T> run1_col{{5, 6, 7}};
+    cudf::test::fixed_width_column_wrapper<T> run2_col{{1, 2, 3}};
+    cudf::test::fixed_width_column_wrapper<T> run3_col{{2, 4}};
+    CudfTableView run1_view {{run1_col}};
+    CudfTableView run2_view {{run2_col}};
+    CudfTableView run3_view {{run3_col}};
+
+    std::vector<int> sortColIndices{0};
+    std::vector<cudf::order> sortOrderTypes{cudf::order::ASCENDING};
+    std::vector<cudf::null_order> null_orders{cudf::null_order::AFTER};
+
+    // the runs that are one after the other are concatenated in the order of their ranges
+    std::vector<size_t> order = ral::distribution::get_concatenation_order({run1_view, run2_view}, sortOrderTypes, sortColIndices, null_orders);
+    std::vector<size_t> expected_order{1, 0};
+    EXPECT_EQ(order, expected_order);
+
+    std::vector<ral::frame::BlazingTableView> runs{ral::frame::BlazingTableView(run1_view, {"A"}), ral::frame::BlazingTableView(run2_view, {"A"})};
+    std::unique_ptr<ral::frame::BlazingTable> merged = ral::distribution::sortedMerger(runs, sortOrderTypes, sortColIndices);
+    cudf::test::fixed_width_column_wrapper<T> expected_col{{1, 2, 3, 5, 6, 7}};
+    cudf::test::expect_columns_equal(merged->view().column(0), expected_col);
+
+    // the runs that overlap have to be merged
+    order = ral::distribution::get_concatenation_order({run1_view, run2_view, run3_view}, sortOrderTypes, sortColIndices, null_orders);
+    EXPECT_TRUE(order.empty());
+}
+
+struct RadixSortTest : public BlazingUnitTest {};
+
+TEST_F(RadixSortTest, sortedOrderOfPackedKeys) {
+
+    cudf::test::fixed_width_column_wrapper<int32_t> col1{{4, -5, 3, 0, 8, -5, 6, 4}, {1, 1, 0, 1, 1, 1, 0, 1}};
+    cudf::test::fixed_width_column_wrapper<int16_t> col2{{1, 7, -2, 3, 3, 9, 5, 2}, {1, 1, 1, 0, 1, 1, 1, 1}};
+    cudf::test::fixed_width_column_wrapper<int64_t> col3{{-1, 2, 3, 4, 5, 6, 7, 8}};
+    CudfTableView keys {{col1, col2}};
+    EXPECT_TRUE(ral::operators::can_radix_sort(keys));
+    EXPECT_FALSE(ral::operators::can_radix_sort(CudfTableView{{col1, col3}}));
+    EXPECT_TRUE(ral::operators::can_radix_sort(CudfTableView{{col3}}));
+
+    // the keys come out in the order of cudf, for every direction and place of the nulls
+    for (auto order : {cudf::order::ASCENDING, cudf::order::DESCENDING}) {
+        for (auto null_order : {cudf::null_order::AFTER, cudf::null_order::BEFORE}) {
+            std::vector<cudf::order> sortOrderTypes{order, cudf::order::DESCENDING};
+            std::vector<cudf::null_order> null_orders{null_order, null_order};
+
+            std::unique_ptr<cudf::column> expected = cudf::sorted_order(keys, sortOrderTypes, null_orders);
+            std::unique_ptr<cudf::column> radix = ral::operators::radix_sorted_order(keys, sortOrderTypes, null_orders);
+            cudf::test::expect_tables_equivalent(cudf::gather(keys, expected->view())->view(), cudf::gather(keys, radix->view())->view());
+        }
+    }
+}
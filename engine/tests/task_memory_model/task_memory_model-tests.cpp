@@ -0,0 +1,61 @@
+#include <gtest/gtest.h>
+
+#include "execution_graph/task_memory_model.h"
+
+#define DESCR(d) RecordProperty("description", d)
+
+using namespace ral;
+using ral::cache::kernel_type;
+
+TEST(TaskMemoryModelTest, noPredictionBeforeMinSamples) {
+   DESCR("the model does not predict until enough tasks of the same kind ran");
+
+   execution::task_memory_model model(3);
+   EXPECT_FALSE(model.predict(kernel_type::JoinPartitionKernel, 1000).first);
+
+   model.record(kernel_type::JoinPartitionKernel, 1000, 3000);
+   model.record(kernel_type::JoinPartitionKernel, 1000, 3000);
+   EXPECT_FALSE(model.predict(kernel_type::JoinPartitionKernel, 1000).first);
+
+   model.record(kernel_type::JoinPartitionKernel, 1000, 3000);
+   auto prediction = model.predict(kernel_type::JoinPartitionKernel, 1000);
+   EXPECT_TRUE(prediction.first);
+   EXPECT_EQ(prediction.second, 3000);
+}
+
+TEST(TaskMemoryModelTest, predictionsAreKeyedByKernelTypeAndSize) {
+   DESCR("samples of a kernel type or input size do not affect the predictions of others");
+
+   execution::task_memory_model model(1);
+   model.record(kernel_type::JoinPartitionKernel, 1000, 3000);
+
+   EXPECT_FALSE(model.predict(kernel_type::FilterKernel, 1000).first);
+   EXPECT_FALSE(model.predict(kernel_type::JoinPartitionKernel, 1000000).first);
+   EXPECT_TRUE(model.predict(kernel_type::JoinPartitionKernel, 1020).first);
+}
+
+TEST(TaskMemoryModelTest, estimateGrowsFasterThanItShrinks) {
+   DESCR("a bigger peak moves the estimate more than a smaller one");
+
+   execution::task_memory_model model(1);
+   model.record(kernel_type::FilterKernel, 1000, 2000);
+   model.record(kernel_type::FilterKernel, 1000, 4000);
+   std::size_t after_growth = model.predict(kernel_type::FilterKernel, 1000).second;
+   EXPECT_GT(after_growth, 2000);
+
+   model.record(kernel_type::FilterKernel, 1000, 0);
+   std::size_t after_shrink = model.predict(kernel_type::FilterKernel, 1000).second;
+   EXPECT_LT(after_shrink, after_growth);
+   EXPECT_GT(after_growth - after_shrink, 0);
+   EXPECT_LT(after_growth - after_shrink, after_growth - 2000);
+}
+
+TEST(TaskMemoryModelTest, failureMakesPredictionAvailableAndBigger) {
+   DESCR("a task that ran out of memory makes the next tasks like it predict more than what it used");
+
+   execution::task_memory_model model(3);
+   model.record_failure(kernel_type::ProjectKernel, 1000, 1500);
+   auto prediction = model.predict(kernel_type::ProjectKernel, 1000);
+   EXPECT_TRUE(prediction.first);
+   EXPECT_GT(prediction.second, 1500);
+}
@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include "utilities/Tracer.h"
+
+#define DESCR(d) RecordProperty("description", d)
+
+using namespace ral;
+
+TEST(TracerTest, recordsOnlyWhileTracing) {
+   DESCR("spans are only recorded while a query is being traced, and are exported per query");
+
+   auto & tracer = utilities::tracer::getInstance();
+   { utilities::trace_scope trace("NotTraced", "test", 1001); }
+
+   tracer.start_tracing(1001);
+   EXPECT_TRUE(tracer.is_tracing(1001));
+   EXPECT_FALSE(tracer.is_tracing(1002));
+   { utilities::trace_scope trace("Traced", "test", 1001, 7); }
+   { utilities::trace_scope trace("OtherQuery", "test", 1002); }
+   tracer.stop_tracing(1001);
+   { utilities::trace_scope trace("AfterStop", "test", 1001); }
+
+   auto events = tracer.get_events(1001);
+   ASSERT_EQ(events.size(), 1);
+   EXPECT_STREQ(events[0].second.name, "Traced");
+   EXPECT_EQ(events[0].second.id, 7);
+   EXPECT_GE(events[0].second.duration, 0);
+   EXPECT_TRUE(tracer.get_events(1002).size() == 1);
+}
+
+TEST(TracerTest, ringBufferPerThread) {
+   DESCR("every thread records into its own ring buffer, which keeps only the most recent spans");
+
+   auto & tracer = utilities::tracer::getInstance();
+   tracer.start_tracing(2001);
+   std::thread producer([&tracer] {
+      for (std::size_t i = 0; i < utilities::tracer::events_per_thread + 10; i++) {
+         tracer.record("Span", "test", 2001, i, i, 1);
+      }
+   });
+   producer.join();
+   tracer.record("MainThread", "test", 2001, -1, 0, 1);
+   tracer.stop_tracing(2001);
+
+   auto events = tracer.get_events(2001);
+   ASSERT_EQ(events.size(), utilities::tracer::events_per_thread + 1);
+   int main_thread_id = -1;
+   int64_t smallest_id = -1;
+   for (auto & event : events) {
+      if (std::string(event.second.name) == "MainThread") {
+         main_thread_id = event.first;
+      } else if (smallest_id == -1 || event.second.id < smallest_id) {
+         smallest_id = event.second.id;
+      }
+   }
+   EXPECT_EQ(smallest_id, 10);
+   EXPECT_NE(main_thread_id, events.back().first);
+}
+
+TEST(TracerTest, exportsChromeTrace) {
+   DESCR("the export is a Chrome trace of complete events");
+
+   auto & tracer = utilities::tracer::getInstance();
+   tracer.start_tracing(3001);
+   tracer.record("KernelCompute", "task", 3001, 3, 10, 20);
+   tracer.stop_tracing(3001);
+
+   std::string trace = tracer.export_chrome_trace(3001, 0);
+   EXPECT_NE(trace.find("\"traceEvents\":[{\"name\":\"KernelCompute\",\"cat\":\"task\",\"ph\":\"X\",\"ts\":10,\"dur\":20,\"pid\":0"), std::string::npos);
+   EXPECT_NE(trace.find("\"args\":{\"query_id\":3001,\"id\":3}}]}"), std::string::npos);
+   EXPECT_EQ(tracer.export_chrome_trace(3002, 0), "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[]}");
+}
@@ -560,3 +560,99 @@ TEST_F(WaitingQueueTestFixture, putAllUnsafe) {
       EXPECT_EQ(msgVect[i]->get_message_id(), "uniqueId" + std::to_string(i));
    }
 }
+
+
+TEST_F(WaitingQueueTestFixture, getOrWaitKeepsOrder) {
+   DESCR("tests that get_or_wait() removes the requested message and keeps the order of the rest");
+
+   cache::WaitingQueue< std::unique_ptr<ral::cache::message> >  wq("", WAITING_QUEUE_TIMEOUT);
+
+   int totalNumItems = 10;
+   for(int i=0; i<totalNumItems; ++i) {
+      wq.put(createCacheMsg("uniqueId" + std::to_string(i)));
+   }
+
+   std::unique_ptr<cache::message> msgOut = wq.get_or_wait("uniqueId5");
+   ASSERT_NE(msgOut, nullptr);
+   EXPECT_EQ(msgOut->get_message_id(), "uniqueId5");
+
+   std::vector<std::unique_ptr<cache::message>> msgVect = wq.get_all_unsafe();
+   ASSERT_EQ(msgVect.size(), totalNumItems - 1);
+   for(int i=0, j=0; i<totalNumItems; ++i) {
+      if (i != 5) {
+         EXPECT_EQ(msgVect[j++]->get_message_id(), "uniqueId" + std::to_string(i));
+      }
+   }
+}
+
+
+TEST_F(WaitingQueueTestFixture, hasMessagesNow) {
+   DESCR("tests that has_messages_now() tracks the messages put and removed, including repeated ids");
+
+   cache::WaitingQueue< std::unique_ptr<ral::cache::message> >  wq("", WAITING_QUEUE_TIMEOUT);
+
+   wq.put(createCacheMsg("a"));
+   wq.put(createCacheMsg("b"));
+   wq.put(createCacheMsg("b"));
+
+   EXPECT_TRUE(wq.has_messages_now({"a", "b"}));
+   EXPECT_FALSE(wq.has_messages_now({"a", "c"}));
+
+   wq.get_or_wait("b");
+   EXPECT_TRUE(wq.has_messages_now({"b"}));
+   wq.get_or_wait("b");
+   EXPECT_FALSE(wq.has_messages_now({"b"}));
+
+   wq.pop_or_wait();
+   EXPECT_FALSE(wq.has_messages_now({"a"}));
+
+   wq.finish();
+   EXPECT_EQ(wq.get_or_wait("a"), nullptr);
+}
+
+
+TEST_F(WaitingQueueTestFixture, waitUntilNumBytesBelow) {
+   DESCR("tests that wait_until_num_bytes_below() waits for the consumers to take messages out");
+
+   cache::WaitingQueue< std::unique_ptr<ral::cache::message> >  wq("", WAITING_QUEUE_TIMEOUT);
+
+   for(int i=0; i<3; ++i) {
+      std::vector<std::unique_ptr<frame::BlazingColumn>> blazingColumns;
+      auto blazingTable = std::make_unique<frame::BlazingTable>(std::move(blazingColumns), std::vector<std::string>{});
+      auto content = std::make_unique<cache::GPUCacheData>(std::move(blazingTable), cache::MetadataDictionary{}, 100);
+      wq.put(std::make_unique<cache::message>(std::move(content), "uniqueId" + std::to_string(i)));
+   }
+
+   EXPECT_TRUE(wq.wait_until_num_bytes_below(300, 10));
+   EXPECT_FALSE(wq.wait_until_num_bytes_below(150, 10));
+
+   std::thread consumer([&wq]() {
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+      wq.pop_or_wait();
+      wq.pop_or_wait();
+   });
+   EXPECT_TRUE(wq.wait_until_num_bytes_below(150, WAITING_QUEUE_TIMEOUT));
+   consumer.join();
+}
+
+TEST_F(WaitingQueueTestFixture, waitUntilNumBytesBelowStops) {
+   DESCR("tests that wait_until_num_bytes_below() returns once it is told to stop, without waiting for the consumers");
+
+   cache::WaitingQueue< std::unique_ptr<ral::cache::message> >  wq("", WAITING_QUEUE_TIMEOUT);
+
+   std::vector<std::unique_ptr<frame::BlazingColumn>> blazingColumns;
+   auto blazingTable = std::make_unique<frame::BlazingTable>(std::move(blazingColumns), std::vector<std::string>{});
+   auto content = std::make_unique<cache::GPUCacheData>(std::move(blazingTable), cache::MetadataDictionary{}, 100);
+   wq.put(std::make_unique<cache::message>(std::move(content), "uniqueId"));
+
+   std::atomic<bool> stop{false};
+   std::thread stopper([&wq, &stop]() {
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+      stop = true;
+      wq.notify_waiters();
+   });
+   auto start = std::chrono::steady_clock::now();
+   EXPECT_TRUE(wq.wait_until_num_bytes_below(50, 60000, [&stop] { return stop.load(); }));
+   EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(30));
+   stopper.join();
+}
@@ -0,0 +1,181 @@
+#include <atomic>
+#include <memory>
+#include <set>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "execution_graph/work_stealing_queue.h"
+
+#define DESCR(d) RecordProperty("description", d)
+
+using namespace ral;
+
+using queue_t = execution::work_stealing_queue<std::unique_ptr<int>, int>;
+
+TEST(WorkStealingQueueTest, putPopSamePriorityIsFIFO) {
+   DESCR("items with the same priority in the same deque are popped in FIFO order");
+
+   queue_t queue(1);
+   int totalNumItems = 20;
+   for(int i = 0; i < totalNumItems; ++i) {
+      queue.put(std::make_unique<int>(i), 0);
+   }
+
+   for(int i = 0; i < totalNumItems; ++i) {
+      auto item = queue.try_pop(0);
+      ASSERT_NE(item, nullptr);
+      EXPECT_EQ(*item, i);
+   }
+   EXPECT_EQ(queue.try_pop(0), nullptr);
+   EXPECT_EQ(queue.size(), 0);
+}
+
+TEST(WorkStealingQueueTest, popMostUrgentFirst) {
+   DESCR("items with smaller priorities are popped first");
+
+   queue_t queue(1);
+   queue.put(std::make_unique<int>(30), 3);
+   queue.put(std::make_unique<int>(10), 1);
+   queue.put(std::make_unique<int>(20), 2);
+   queue.put(std::make_unique<int>(0), 0);
+
+   for(int expected : {0, 10, 20, 30}) {
+      auto item = queue.try_pop(0);
+      ASSERT_NE(item, nullptr);
+      EXPECT_EQ(*item, expected);
+   }
+}
+
+TEST(WorkStealingQueueTest, idleWorkerSteals) {
+   DESCR("a worker with an empty deque steals from the other workers");
+
+   queue_t queue(4);
+   queue.register_worker(2);
+   queue.put(std::make_unique<int>(7), 0);
+   queue.register_worker(-1);
+
+   auto item = queue.try_pop(0);
+   ASSERT_NE(item, nullptr);
+   EXPECT_EQ(*item, 7);
+}
+
+TEST(WorkStealingQueueTest, putFrontIsPoppedFirstOfItsPriority) {
+   DESCR("an item put back at the front is the next one of its priority, but does not overtake more urgent items");
+
+   queue_t queue(2);
+   queue.register_worker(1);
+   queue.put(std::make_unique<int>(1), 1);
+   queue.put(std::make_unique<int>(2), 1);
+   queue.register_worker(-1);
+   queue.put_front(std::make_unique<int>(3), 1, 1);
+   queue.put_front(std::make_unique<int>(0), 0, 1);
+
+   for(int expected : {0, 3, 1, 2}) {
+      auto item = queue.try_pop(1);
+      ASSERT_NE(item, nullptr);
+      EXPECT_EQ(*item, expected);
+   }
+   EXPECT_EQ(queue.size(), 0);
+}
+
+TEST(WorkStealingQueueTest, popBackTakesLeastUrgent) {
+   DESCR("pop_back takes the least urgent item of all the deques");
+
+   queue_t queue(3);
+   queue.put(std::make_unique<int>(1), 1);
+   queue.put(std::make_unique<int>(5), 5);
+   queue.put(std::make_unique<int>(3), 3);
+
+   auto item = queue.pop_back();
+   ASSERT_NE(item, nullptr);
+   EXPECT_EQ(*item, 5);
+   EXPECT_EQ(queue.size(), 2);
+}
+
+TEST(WorkStealingQueueTest, removeIfTakesTheMatchingItems) {
+   DESCR("remove_if takes the matching items and leaves the others in their order");
+
+   queue_t queue(1);
+   for(int i = 0; i < 12; ++i) {
+      queue.put(std::make_unique<int>(i), i % 2);
+   }
+
+   auto removed = queue.remove_if([](const std::unique_ptr<int> & item) { return *item % 3 == 0; });
+   std::set<int> removed_values;
+   for(auto & item : removed) {
+      removed_values.insert(*item);
+   }
+   EXPECT_EQ(removed_values, std::set<int>({0, 3, 6, 9}));
+   EXPECT_EQ(queue.size(), 8);
+
+   for(int expected : {2, 4, 8, 10, 1, 5, 7, 11}) {
+      auto item = queue.try_pop(0);
+      ASSERT_NE(item, nullptr);
+      EXPECT_EQ(*item, expected);
+   }
+   EXPECT_EQ(queue.try_pop(0), nullptr);
+}
+
+TEST(WorkStealingQueueTest, popOrWaitReturnsAfterFinish) {
+   DESCR("pop_or_wait returns nullptr when the queue is empty and finished");
+
+   queue_t queue(2, 10000);
+   std::thread finisher([&queue]() {
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+      queue.finish();
+   });
+   auto item = queue.pop_or_wait(0);
+   finisher.join();
+   EXPECT_EQ(item, nullptr);
+   EXPECT_TRUE(queue.is_finished());
+}
+
+TEST(WorkStealingQueueTest, multiThreadedAllItemsPoppedOnce) {
+   DESCR("items put from several threads are popped exactly once by several workers");
+
+   int numWorkers = 4;
+   int numProducers = 3;
+   int itemsPerProducer = 1000;
+   queue_t queue(numWorkers);
+
+   std::vector<std::thread> producers;
+   for(int p = 0; p < numProducers; ++p) {
+      producers.emplace_back([&queue, p, itemsPerProducer]() {
+         for(int i = 0; i < itemsPerProducer; ++i) {
+            queue.put(std::make_unique<int>(p * itemsPerProducer + i), i % 5);
+         }
+      });
+   }
+
+   std::mutex poppedMutex;
+   std::multiset<int> popped;
+   std::atomic<int> numPopped{0};
+   int totalNumItems = numProducers * itemsPerProducer;
+   std::vector<std::thread> workers;
+   for(int w = 0; w < numWorkers; ++w) {
+      workers.emplace_back([&, w]() {
+         queue.register_worker(w);
+         while(numPopped.load() < totalNumItems) {
+            auto item = queue.pop_or_wait(w);
+            if(item != nullptr) {
+               std::lock_guard<std::mutex> lock(poppedMutex);
+               popped.insert(*item);
+               numPopped++;
+            }
+         }
+      });
+   }
+
+   for(auto & producer : producers) {
+      producer.join();
+   }
+   for(auto & worker : workers) {
+      worker.join();
+   }
+
+   ASSERT_EQ(popped.size(), totalNumItems);
+   for(int i = 0; i < totalNumItems; ++i) {
+      EXPECT_EQ(popped.count(i), 1);
+   }
+}
@@ -15,6 +15,7 @@ class FileStatus {
 public:
 	FileStatus();
 	FileStatus(const Uri & uri, FileType fileType, unsigned long long fileSize);
+	FileStatus(const Uri & uri, FileType fileType, unsigned long long fileSize, unsigned long long modificationTime);
 	FileStatus(const FileStatus & other);
 	FileStatus(FileStatus && other);
 	~FileStatus();
@@ -22,6 +23,8 @@ public:
 	Uri getUri() const noexcept;
 	FileType getFileType() const noexcept;
 	unsigned long long getFileSize() const noexcept;
+	// in milliseconds since the epoch, or 0 if the filesystem did not tell
+	unsigned long long getModificationTime() const noexcept;
 
 	// Helpers
 	bool isFile() const noexcept;
@@ -41,7 +44,6 @@ public:
 
 	 unsigned long long getBlockSize() const noexcept;
 
-	 unsigned long long getModificationTime() const noexcept;
 	 unsigned long long getAccessTime() const noexcept;
 
 	 std::string getOwner() const noexcept;
@@ -52,6 +54,7 @@ private:
 	Uri uri;
 	FileType fileType;
 	unsigned long long fileSize;
+	unsigned long long modificationTime;
 };
 
 #endif /* _BLAZING_FILE_STATUS_H_ */
@@ -6,6 +6,8 @@
 #ifndef _FILESYSTEMINTERFACE_H_
 #define _FILESYSTEMINTERFACE_H_
 
+#include <map>
+
 #include "arrow/io/interfaces.h"
 
 #include "FileSystem/FileFilter.h"
@@ -119,6 +121,11 @@ public:
 	virtual bool move(const Uri & src, const Uri & dst) const = 0;
 	virtual bool truncateFile(const Uri & uri, long long length) const = 0;
 
+	// Locality
+	// the bytes of the file that each host has a replica of, empty if the file system does not know where the data
+	// of its files is (all of them but HDFS)
+	virtual std::map<std::string, long long> getFileLocations(const Uri & /*uri*/) const { return {}; }
+
 	// I/O
 	virtual std::shared_ptr<arrow::io::RandomAccessFile> openReadable(const Uri & uri) const = 0;
 	virtual std::shared_ptr<arrow::io::OutputStream> openWriteable(const Uri & uri) const = 0;
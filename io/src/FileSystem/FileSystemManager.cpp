@@ -87,6 +87,10 @@ bool FileSystemManager::truncateFile(const Uri & uri, const long long length) co
 	return this->pimpl->truncateFile(uri, length);
 }
 
+std::map<std::string, long long> FileSystemManager::getFileLocations(const Uri & uri) const {
+	return this->pimpl->getFileLocations(uri);
+}
+
 std::shared_ptr<arrow::io::RandomAccessFile> FileSystemManager::openReadable(const Uri & uri) const {
 	return this->pimpl->openReadable(uri);
 }
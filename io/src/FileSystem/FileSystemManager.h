@@ -6,6 +6,7 @@
 #ifndef _FILESYSTEM_MANAGER_H_
 #define _FILESYSTEM_MANAGER_H_
 
+#include <map>
 #include <memory>
 
 #include "arrow/io/interfaces.h"
@@ -41,6 +42,9 @@ public:
 	bool move(const Uri & src, const Uri & dst) const;  // powerfull: can move between diferent fs
 	bool truncateFile(const Uri & path, const long long length) const;
 
+	// Locality
+	std::map<std::string, long long> getFileLocations(const Uri & uri) const;  // see FileSystemInterface
+
 	// I/O
 	std::shared_ptr<arrow::io::RandomAccessFile> openReadable(const Uri & uri) const;
 	std::shared_ptr<arrow::io::OutputStream> openWriteable(const Uri & uri) const;
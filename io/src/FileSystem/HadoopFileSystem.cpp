@@ -55,6 +55,10 @@ std::vector<std::string> HadoopFileSystem::listResourceNames(const Uri & uri, co
 	return result;
 }
 
+std::map<std::string, long long> HadoopFileSystem::getFileLocations(const Uri & uri) const {
+	return this->pimpl->getFileLocations(uri);
+}
+
 bool HadoopFileSystem::makeDirectory(const Uri & uri) const {
 	const bool result = this->pimpl->makeDirectory(uri);
 	return result;
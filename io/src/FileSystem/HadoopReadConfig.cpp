@@ -0,0 +1,29 @@
+/*
+ * Copyright 2021 BlazingDB, Inc.
+ */
+
+#include "HadoopReadConfig.h"
+
+#include <algorithm>
+
+void HadoopReadConfig::configure(bool shortCircuitReads, const std::string & domainSocketPath, int maxReadHandles) {
+	std::lock_guard<std::mutex> lock(mutex);
+	this->shortCircuitReads = shortCircuitReads;
+	this->domainSocketPath = domainSocketPath;
+	this->maxReadHandles = std::max(maxReadHandles, 1);
+}
+
+bool HadoopReadConfig::getShortCircuitReads() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return shortCircuitReads;
+}
+
+std::string HadoopReadConfig::getDomainSocketPath() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return domainSocketPath;
+}
+
+int HadoopReadConfig::getMaxReadHandles() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return maxReadHandles;
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright 2021 BlazingDB, Inc.
+ */
+
+#ifndef _HADOOP_READ_CONFIG_H_
+#define _HADOOP_READ_CONFIG_H_
+
+#include <mutex>
+#include <string>
+
+/**
+ *  @class HadoopReadConfig
+ *
+ *  @brief How the HDFS files are read: with short-circuit local reads, which read the blocks of the datanode of the
+ *  same host straight from its disks, and with up to maxReadHandles handles per file, so that the ranges of a file
+ *  (the column chunks of a parquet file) are read with concurrent preads.
+ *
+ *  The client falls back to reading through the datanode when it is not local or its domain socket can't be used, so
+ *  the short-circuit reads can be enabled for any cluster. These settings apply to the filesystems registered after
+ *  they are configured.
+ */
+class HadoopReadConfig {
+public:
+	static HadoopReadConfig & getInstance() {
+		static HadoopReadConfig instance;
+		return instance;
+	}
+
+	/**
+	 *  @brief An empty domainSocketPath keeps the dfs.domain.socket.path of the hdfs-site.xml of the client.
+	 */
+	void configure(bool shortCircuitReads, const std::string & domainSocketPath, int maxReadHandles);
+
+	bool getShortCircuitReads();
+
+	std::string getDomainSocketPath();
+
+	int getMaxReadHandles();
+
+private:
+	HadoopReadConfig() = default;
+	HadoopReadConfig(HadoopReadConfig &&) = delete;
+	HadoopReadConfig(const HadoopReadConfig &) = delete;
+	HadoopReadConfig & operator=(HadoopReadConfig &&) = delete;
+	HadoopReadConfig & operator=(const HadoopReadConfig &) = delete;
+
+	std::mutex mutex;
+	bool shortCircuitReads = true;
+	std::string domainSocketPath;
+	int maxReadHandles = 4;
+};
+
+#endif /* _HADOOP_READ_CONFIG_H_ */
@@ -0,0 +1,43 @@
+/*
+ * Copyright 2021 BlazingDB, Inc.
+ */
+
+#include "ObjectStoreConfig.h"
+
+#include <algorithm>
+
+namespace {
+
+const std::size_t MAX_OBJECT_SIZES = 1024 * 1024;
+
+}  // namespace
+
+void ObjectStoreConfig::configure(int maxConnections, int openConcurrency) {
+	std::lock_guard<std::mutex> lock(mutex);
+	this->maxConnections = std::max(maxConnections, 1);
+	this->openConcurrency = std::max(openConcurrency, 1);
+}
+
+int ObjectStoreConfig::getMaxConnections() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return maxConnections;
+}
+
+int ObjectStoreConfig::getOpenConcurrency() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return openConcurrency;
+}
+
+void ObjectStoreConfig::rememberObjectSize(const std::string & objectUri, int64_t size) {
+	std::lock_guard<std::mutex> lock(mutex);
+	if(objectSizes.size() >= MAX_OBJECT_SIZES && objectSizes.find(objectUri) == objectSizes.end()) {
+		objectSizes.clear();
+	}
+	objectSizes[objectUri] = size;
+}
+
+int64_t ObjectStoreConfig::getObjectSize(const std::string & objectUri) {
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = objectSizes.find(objectUri);
+	return it == objectSizes.end() ? -1 : it->second;
+}
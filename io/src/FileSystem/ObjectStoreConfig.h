@@ -0,0 +1,62 @@
+/*
+ * Copyright 2021 BlazingDB, Inc.
+ */
+
+#ifndef _OBJECT_STORE_CONFIG_H_
+#define _OBJECT_STORE_CONFIG_H_
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/**
+ *  @class ObjectStoreConfig
+ *
+ *  @brief How the filesystems of the object stores (S3 and GCS) connect and open their files.
+ *
+ *  Every registered filesystem has one client, which keeps a pool of up to maxConnections keep-alive connections, so
+ *  that the requests of the files it opens reuse the connections instead of each one doing its own handshake. The
+ *  data providers open up to openConcurrency files at a time.
+ *
+ *  The sizes of the objects of the listings are remembered, so that the files that are opened after a listing don't
+ *  each ask for their size with a HEAD request. A listing replaces the sizes of its objects, and the sizes are dropped
+ *  when there are more than a million of them.
+ */
+class ObjectStoreConfig {
+public:
+	static ObjectStoreConfig & getInstance() {
+		static ObjectStoreConfig instance;
+		return instance;
+	}
+
+	void configure(int maxConnections, int openConcurrency);
+
+	int getMaxConnections();
+
+	int getOpenConcurrency();
+
+	/**
+	 *  @brief Remembers the size of an object, keyed by its uri with the bucket, i.e. s3://bucket/key.
+	 */
+	void rememberObjectSize(const std::string & objectUri, int64_t size);
+
+	/**
+	 *  @brief The size of the object of the last listing or status that had it, or -1 if it is not known.
+	 */
+	int64_t getObjectSize(const std::string & objectUri);
+
+private:
+	ObjectStoreConfig() = default;
+	ObjectStoreConfig(ObjectStoreConfig &&) = delete;
+	ObjectStoreConfig(const ObjectStoreConfig &) = delete;
+	ObjectStoreConfig & operator=(ObjectStoreConfig &&) = delete;
+	ObjectStoreConfig & operator=(const ObjectStoreConfig &) = delete;
+
+	std::mutex mutex;
+	int maxConnections = 64;
+	int openConcurrency = 16;
+	std::unordered_map<std::string, int64_t> objectSizes;
+};
+
+#endif /* _OBJECT_STORE_CONFIG_H_ */
@@ -0,0 +1,40 @@
+/*
+ * Copyright 2021 BlazingDB, Inc.
+ */
+
+#include "ObjectUploadConfig.h"
+
+#include <algorithm>
+
+void ObjectUploadConfig::configure(int64_t partSize, int maxConcurrentParts) {
+	std::lock_guard<std::mutex> lock(mutex);
+	this->partSize = partSize;
+	this->maxConcurrentParts = std::max(maxConcurrentParts, 1);
+}
+
+void ObjectUploadConfig::setAllocator(Allocator allocator) {
+	std::lock_guard<std::mutex> lock(mutex);
+	this->allocator = allocator;
+}
+
+int64_t ObjectUploadConfig::getPartSize() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return partSize;
+}
+
+int ObjectUploadConfig::getMaxConcurrentParts() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return maxConcurrentParts;
+}
+
+std::shared_ptr<char> ObjectUploadConfig::allocate(int64_t nbytes) {
+	Allocator allocator;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		allocator = this->allocator;
+	}
+	if(allocator) {
+		return allocator(nbytes);
+	}
+	return std::shared_ptr<char>(new char[nbytes], std::default_delete<char[]>());
+}
@@ -0,0 +1,55 @@
+/*
+ * Copyright 2021 BlazingDB, Inc.
+ */
+
+#ifndef _OBJECT_UPLOAD_CONFIG_H_
+#define _OBJECT_UPLOAD_CONFIG_H_
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+/**
+ *  @class ObjectUploadConfig
+ *
+ *  @brief How the output streams of the object stores (S3 and GCS) upload the files: in parts of partSize bytes, with
+ *  up to maxConcurrentParts of them being uploaded at once while the writer fills the next one.
+ *
+ *  The buffers of the parts come from the allocator, which is a plain heap allocation unless the engine sets one,
+ *  since it can take them from its pool of pinned host memory.
+ */
+class ObjectUploadConfig {
+public:
+	// allocates a buffer of at least the given number of bytes, which is freed by the deleter of the shared_ptr
+	using Allocator = std::function<std::shared_ptr<char>(int64_t nbytes)>;
+
+	static ObjectUploadConfig & getInstance() {
+		static ObjectUploadConfig instance;
+		return instance;
+	}
+
+	void configure(int64_t partSize, int maxConcurrentParts);
+
+	void setAllocator(Allocator allocator);
+
+	int64_t getPartSize();
+
+	int getMaxConcurrentParts();
+
+	std::shared_ptr<char> allocate(int64_t nbytes);
+
+private:
+	ObjectUploadConfig() = default;
+	ObjectUploadConfig(ObjectUploadConfig &&) = delete;
+	ObjectUploadConfig(const ObjectUploadConfig &) = delete;
+	ObjectUploadConfig & operator=(ObjectUploadConfig &&) = delete;
+	ObjectUploadConfig & operator=(const ObjectUploadConfig &) = delete;
+
+	std::mutex mutex;
+	int64_t partSize = 16 * 1024 * 1024;
+	int maxConcurrentParts = 8;
+	Allocator allocator;
+};
+
+#endif /* _OBJECT_UPLOAD_CONFIG_H_ */
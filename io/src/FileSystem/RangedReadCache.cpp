@@ -0,0 +1,135 @@
+/*
+ * Copyright 2021 BlazingDB, Inc.
+ */
+
+#include "RangedReadCache.h"
+
+#include <algorithm>
+#include <cstring>
+
+RangedReadCache::RangedReadCache(FetchFunction fetch, int64_t holeSizeLimit, int64_t rangeSizeLimit, int maxConcurrentFetches)
+	: fetch(fetch), holeSizeLimit(holeSizeLimit), rangeSizeLimit(rangeSizeLimit),
+	  maxConcurrentFetches(std::max(maxConcurrentFetches, 1)) {}
+
+RangedReadCache::~RangedReadCache() {
+	std::deque<PendingFetch> notStarted;
+	{
+		std::lock_guard<std::mutex> lock(fetchMutex);
+		stopping = true;
+		notStarted = std::move(pendingFetches);
+		pendingFetches.clear();
+	}
+	fetchCondition.notify_all();
+	// a reader that still waits for one of them reads the file by itself
+	for(PendingFetch & pending : notStarted) {
+		pending.data.set_value(std::make_shared<std::vector<uint8_t>>());
+	}
+	for(std::thread & thread : fetchThreads) {
+		thread.join();
+	}
+}
+
+void RangedReadCache::runFetchThread() {
+	while(true) {
+		PendingFetch pending;
+		{
+			std::unique_lock<std::mutex> lock(fetchMutex);
+			idleFetchThreads++;
+			fetchCondition.wait(lock, [this] { return stopping || !pendingFetches.empty(); });
+			idleFetchThreads--;
+			if(stopping) {
+				return;
+			}
+			pending = std::move(pendingFetches.front());
+			pendingFetches.pop_front();
+		}
+
+		auto bytes = std::make_shared<std::vector<uint8_t>>(pending.range.length);
+		int64_t bytesRead = -1;
+		try {
+			bytesRead = fetch(pending.range.offset, pending.range.length, bytes->data());
+		} catch(...) {
+			// the reader reads the file by itself, and reports the error if it happens again
+		}
+		bytes->resize(std::max(bytesRead, int64_t(0)));
+		pending.data.set_value(bytes);
+	}
+}
+
+std::vector<ByteRange> RangedReadCache::coalesceRanges(
+	std::vector<ByteRange> ranges, int64_t holeSizeLimit, int64_t rangeSizeLimit) {
+	std::sort(ranges.begin(), ranges.end(), [](const ByteRange & a, const ByteRange & b) { return a.offset < b.offset; });
+
+	std::vector<ByteRange> coalesced;
+	for(const ByteRange & range : ranges) {
+		if(range.length <= 0) {
+			continue;
+		}
+		if(!coalesced.empty()) {
+			ByteRange & last = coalesced.back();
+			int64_t lastEnd = last.offset + last.length;
+			int64_t end = std::max(lastEnd, range.offset + range.length);
+			if(range.offset - lastEnd <= holeSizeLimit && end - last.offset <= rangeSizeLimit) {
+				last.length = end - last.offset;
+				continue;
+			}
+		}
+		coalesced.push_back(range);
+	}
+	return coalesced;
+}
+
+void RangedReadCache::planReads(const std::vector<ByteRange> & ranges) {
+	std::lock_guard<std::mutex> lock(mutex);
+	std::lock_guard<std::mutex> fetchLock(fetchMutex);
+	for(const ByteRange & range : coalesceRanges(ranges, holeSizeLimit, rangeSizeLimit)) {
+		PendingFetch pending;
+		pending.range = range;
+		fetchedRanges.push_back({range, pending.data.get_future().share()});
+		pendingFetches.push_back(std::move(pending));
+	}
+	// the threads that are waiting take the new fetches first
+	std::size_t neededThreads = pendingFetches.size() > idleFetchThreads ? pendingFetches.size() - idleFetchThreads : 0;
+	while(neededThreads > 0 && fetchThreads.size() < maxConcurrentFetches) {
+		fetchThreads.emplace_back(&RangedReadCache::runFetchThread, this);
+		neededThreads--;
+	}
+	fetchCondition.notify_all();
+}
+
+bool RangedReadCache::read(int64_t position, int64_t nbytes, void * out, int64_t & bytesRead) {
+	std::shared_future<std::shared_ptr<std::vector<uint8_t>>> data;
+	ByteRange range;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		auto it = std::find_if(fetchedRanges.begin(), fetchedRanges.end(), [position, nbytes](const FetchedRange & fetched) {
+			return position >= fetched.range.offset && position + nbytes <= fetched.range.offset + fetched.range.length;
+		});
+		if(it == fetchedRanges.end()) {
+			return false;
+		}
+		data = it->data;
+		range = it->range;
+		// the readers read forward, so nothing is read from a range after its end was read
+		if(position + nbytes == it->range.offset + it->range.length) {
+			fetchedRanges.erase(it);
+		}
+	}
+
+	const std::shared_ptr<std::vector<uint8_t>> & bytes = data.get();
+	int64_t start = position - range.offset;
+	// the fetch can come back short, at the end of the file or when it failed
+	bytesRead = std::max(std::min(nbytes, static_cast<int64_t>(bytes->size()) - start), int64_t(0));
+	if(bytesRead < nbytes) {
+		return false;
+	}
+	std::memcpy(out, bytes->data() + start, bytesRead);
+	return true;
+}
+
+bool RangedReadCache::contains(int64_t position, int64_t nbytes) {
+	std::lock_guard<std::mutex> lock(mutex);
+	return std::any_of(fetchedRanges.begin(), fetchedRanges.end(), [position, nbytes](const FetchedRange & fetched) {
+		return position >= fetched.range.offset && position + nbytes <= fetched.range.offset + fetched.range.length;
+	});
+}
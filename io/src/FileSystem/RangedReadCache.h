@@ -0,0 +1,112 @@
+/*
+ * Copyright 2021 BlazingDB, Inc.
+ */
+
+#ifndef _RANGED_READ_CACHE_H_
+#define _RANGED_READ_CACHE_H_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "arrow/io/interfaces.h"
+
+struct ByteRange {
+	int64_t offset;
+	int64_t length;
+};
+
+/**
+ *  @class RangedReadCache
+ *
+ *  @brief Keeps the bytes of the ranges of a remote file that are going to be read, so that the many small reads of a
+ *  reader (the footer, the page headers, the column chunks of a parquet file) don't each become a request.
+ *
+ *  The planned ranges that are closer than holeSizeLimit are merged, up to rangeSizeLimit bytes, and the merged ranges
+ *  are fetched in parallel by at most maxConcurrentFetches threads of the cache, in the order of their offsets. A range
+ *  is dropped once its last bytes are read.
+ */
+class RangedReadCache {
+public:
+	// reads nbytes at position into out, and returns how many bytes were read
+	using FetchFunction = std::function<int64_t(int64_t position, int64_t nbytes, void * out)>;
+
+	static const int DEFAULT_MAX_CONCURRENT_FETCHES = 8;
+
+	RangedReadCache(FetchFunction fetch, int64_t holeSizeLimit, int64_t rangeSizeLimit,
+		int maxConcurrentFetches = DEFAULT_MAX_CONCURRENT_FETCHES);
+
+	/**
+	 *  @brief Waits for the fetches that started. The ones that did not start are not fetched anymore.
+	 */
+	~RangedReadCache();
+
+	/**
+	 *  @brief Starts fetching these ranges, merged with each other.
+	 */
+	void planReads(const std::vector<ByteRange> & ranges);
+
+	/**
+	 *  @brief Reads from a fetched range, waiting for it if it is still being fetched.
+	 *
+	 *  @return false if no fetched range has all of [position, position + nbytes).
+	 */
+	bool read(int64_t position, int64_t nbytes, void * out, int64_t & bytesRead);
+
+	/**
+	 *  @brief Returns true if a planned range has all of [position, position + nbytes).
+	 */
+	bool contains(int64_t position, int64_t nbytes);
+
+	/**
+	 *  @brief Sorts the ranges and merges the ones closer than holeSizeLimit as long as the merged range is not longer
+	 *  than rangeSizeLimit.
+	 */
+	static std::vector<ByteRange> coalesceRanges(
+		std::vector<ByteRange> ranges, int64_t holeSizeLimit, int64_t rangeSizeLimit);
+
+private:
+	struct FetchedRange {
+		ByteRange range;
+		std::shared_future<std::shared_ptr<std::vector<uint8_t>>> data;
+	};
+
+	struct PendingFetch {
+		ByteRange range;
+		std::promise<std::shared_ptr<std::vector<uint8_t>>> data;
+	};
+
+	void runFetchThread();
+
+	FetchFunction fetch;
+	int64_t holeSizeLimit;
+	int64_t rangeSizeLimit;
+	std::size_t maxConcurrentFetches;
+	std::mutex mutex;
+	std::vector<FetchedRange> fetchedRanges;
+
+	std::mutex fetchMutex;
+	std::condition_variable fetchCondition;
+	std::deque<PendingFetch> pendingFetches;
+	std::vector<std::thread> fetchThreads;  // started as they are needed, up to maxConcurrentFetches
+	std::size_t idleFetchThreads = 0;
+	bool stopping = false;
+};
+
+/**
+ *  @class RangedReadableFile
+ *
+ *  @brief A RandomAccessFile of a remote filesystem that can be told ahead of time which ranges are going to be read,
+ *  which it then fetches with as few requests as it can, all of them in parallel.
+ */
+class RangedReadableFile : public arrow::io::RandomAccessFile {
+public:
+	virtual void planReads(const std::vector<ByteRange> & ranges) = 0;
+};
+
+#endif /* _RANGED_READ_CACHE_H_ */
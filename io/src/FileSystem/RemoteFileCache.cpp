@@ -0,0 +1,130 @@
+/*
+ * Copyright 2021 BlazingDB, Inc.
+ */
+
+#include "RemoteFileCache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+namespace {
+
+const std::string CACHE_FILE_EXTENSION = ".range";
+
+}  // namespace
+
+void RemoteFileCache::configure(const std::string & directory, int64_t maxBytes) {
+	std::lock_guard<std::mutex> lock(mutex);
+	while(!entries.empty()) {
+		remove(entries.begin());
+	}
+	this->directory = directory;
+	this->maxBytes = directory.empty() ? 0 : maxBytes;
+	if(this->maxBytes == 0) {
+		return;
+	}
+
+	std::error_code error;
+	std::filesystem::create_directories(directory, error);
+	for(const auto & file : std::filesystem::directory_iterator(directory, error)) {
+		if(file.path().extension() == CACHE_FILE_EXTENSION) {
+			std::filesystem::remove(file.path(), error);
+		}
+	}
+}
+
+bool RemoteFileCache::isEnabled() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return maxBytes > 0;
+}
+
+int64_t RemoteFileCache::getCachedBytes() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return cachedBytes;
+}
+
+std::string RemoteFileCache::makeKey(
+	const std::string & uri, const std::string & version, int64_t position, int64_t nbytes) {
+	return uri + "|" + version + "|" + std::to_string(position) + "-" + std::to_string(nbytes);
+}
+
+int64_t RemoteFileCache::read(const std::string & key, int64_t nbytes, void * out, FetchFunction fetch) {
+	std::string path;
+	int64_t sizeLimit = 0;
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		if(maxBytes == 0) {
+			lock.unlock();
+			return fetch(out);
+		}
+		while(true) {
+			// the threads that want a range that is being downloaded wait for it
+			fillDone.wait(lock, [this, &key] { return filling.count(key) == 0; });
+
+			auto it = entriesByKey.find(key);
+			if(it == entriesByKey.end()) {
+				break;
+			}
+			entries.splice(entries.begin(), entries, it->second);
+			const Entry & entry = *it->second;
+			int64_t size = std::min(entry.size, nbytes);
+			// the file is opened while the lock is held, so that it can be read even if it is evicted meanwhile
+			std::ifstream file(entry.path, std::ios::binary);
+			lock.unlock();
+			if(file.read(static_cast<char *>(out), size)) {
+				return size;
+			}
+			// the file is gone or broken, so the range is downloaded again
+			lock.lock();
+			it = entriesByKey.find(key);
+			if(it != entriesByKey.end()) {
+				remove(it->second);
+			}
+		}
+		filling.insert(key);
+		sizeLimit = maxBytes;
+		path = directory + "/" + std::to_string(nextFileId++) + CACHE_FILE_EXTENSION;
+	}
+
+	int64_t bytesRead = 0;
+	try {
+		bytesRead = fetch(out);
+	} catch(...) {
+		std::lock_guard<std::mutex> lock(mutex);
+		filling.erase(key);
+		fillDone.notify_all();
+		throw;
+	}
+
+	// a failed read is not cached, and neither is a range that would not fit
+	bool written = false;
+	if(bytesRead > 0 && bytesRead <= sizeLimit) {
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		written = static_cast<bool>(file.write(static_cast<const char *>(out), bytesRead));
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	filling.erase(key);
+	fillDone.notify_all();
+	if(!written) {
+		std::remove(path.c_str());
+		return bytesRead;
+	}
+	entries.push_front({key, path, bytesRead});
+	entriesByKey[key] = entries.begin();
+	cachedBytes += bytesRead;
+	while(cachedBytes > maxBytes && !entries.empty()) {
+		remove(std::prev(entries.end()));
+	}
+	return bytesRead;
+}
+
+void RemoteFileCache::remove(std::list<Entry>::iterator entry) {
+	std::remove(entry->path.c_str());
+	cachedBytes -= entry->size;
+	entriesByKey.erase(entry->key);
+	entries.erase(entry);
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright 2021 BlazingDB, Inc.
+ */
+
+#ifndef _REMOTE_FILE_CACHE_H_
+#define _REMOTE_FILE_CACHE_H_
+
+#include <condition_variable>
+#include <functional>
+#include <list>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+
+/**
+ *  @class RemoteFileCache
+ *
+ *  @brief A node local cache on disk (usually an SSD) of the byte ranges read from the files of the remote filesystems
+ *  (S3 and GCS), so that the datasets that are queried again and again are not downloaded again by every query.
+ *
+ *  The ranges are keyed by the uri of the file, its version (the etag) and the range itself, so that a file that
+ *  changed is never read from an old copy. The least recently used ranges are removed once the cache holds more than
+ *  maxBytes, and a range that is being downloaded by a thread is waited for by the others instead of downloaded again.
+ */
+class RemoteFileCache {
+public:
+	// reads the range into out, and returns how many bytes were read
+	using FetchFunction = std::function<int64_t(void * out)>;
+
+	static RemoteFileCache & getInstance() {
+		static RemoteFileCache instance;
+		return instance;
+	}
+
+	/**
+	 *  @brief Keeps the ranges in this directory, up to maxBytes. A maxBytes of 0 turns the cache off. The ranges that
+	 *  a previous process left in the directory are removed, since there is no way to know whether they are still valid.
+	 */
+	void configure(const std::string & directory, int64_t maxBytes);
+
+	bool isEnabled();
+
+	/**
+	 *  @brief Reads a range from the cache, or with fetch when it is not cached, in which case it is cached for the
+	 *  reads that follow.
+	 *
+	 *  @return the number of bytes read, which can be less than nbytes at the end of the file.
+	 */
+	int64_t read(const std::string & key, int64_t nbytes, void * out, FetchFunction fetch);
+
+	int64_t getCachedBytes();
+
+	static std::string makeKey(const std::string & uri, const std::string & version, int64_t position, int64_t nbytes);
+
+private:
+	struct Entry {
+		std::string key;
+		std::string path;
+		int64_t size;
+	};
+
+	RemoteFileCache() = default;
+	RemoteFileCache(RemoteFileCache &&) = delete;
+	RemoteFileCache(const RemoteFileCache &) = delete;
+	RemoteFileCache & operator=(RemoteFileCache &&) = delete;
+	RemoteFileCache & operator=(const RemoteFileCache &) = delete;
+
+	void remove(std::list<Entry>::iterator entry);
+
+	std::mutex mutex;
+	std::condition_variable fillDone;
+	std::string directory;
+	int64_t maxBytes = 0;
+	int64_t cachedBytes = 0;
+	int64_t nextFileId = 0;
+	std::list<Entry> entries;  // the most recently used first
+	std::map<std::string, std::list<Entry>::iterator> entriesByKey;
+	std::set<std::string> filling;  // the keys that are being downloaded
+};
+
+#endif /* _REMOTE_FILE_CACHE_H_ */
@@ -338,6 +338,18 @@ bool FileSystemManager::Private::truncateFile(const Uri & uri, long long length)
 	}
 }
 
+std::map<std::string, long long> FileSystemManager::Private::getFileLocations(const Uri & uri) const {
+	try {
+		const int fileSystemId = this->verifyFileSystemUri(uri);
+
+		return this->fileSystems.at(fileSystemId)->getFileLocations(uri);
+	} catch(const std::exception & e) {
+		std::string uriStr = uri.toString();
+		Logging::Logger().logError("Caught error in getFileLocations with Uri: " + uriStr);
+		throw;
+	}
+}
+
 std::shared_ptr<arrow::io::RandomAccessFile> FileSystemManager::Private::openReadable(const Uri & uri) const {
 	if(uri.isValid() == false) {
 		// TODO percy thrown exception
@@ -40,6 +40,9 @@ public:
 	bool move(const Uri & src, const Uri & dst) const;  // powerfull: can move between diferent fs
 	bool truncateFile(const Uri & uri, long long length) const;
 
+	// Locality
+	std::map<std::string, long long> getFileLocations(const Uri & uri) const;
+
 	// I/O
 	std::shared_ptr<arrow::io::RandomAccessFile> openReadable(const Uri & uri) const;
 	std::shared_ptr<arrow::io::OutputStream> openWriteable(const Uri & uri) const;
@@ -13,8 +13,14 @@
 #include <FileSystem/private/GoogleCloudStorageReadableFile.h>
 
 #include "arrow/buffer.h"
+#include <algorithm>
+#include <deque>
+#include <future>
 #include <istream>
 #include <streambuf>
+#include <vector>
+
+#include "FileSystem/ObjectUploadConfig.h"
 
 #include "ExceptionHandling/BlazingException.h"
 
@@ -22,43 +28,48 @@
 
 namespace Logging = Library::Logging;
 
-// TODO: handle the situation when not all data is read
-// const Aws::String FAILED_UPLOAD = "failed-upload";
+namespace {
+
+// the most objects that a compose request can take
+const size_t MAX_COMPOSE_SOURCES = 32;
+
+}  // namespace
+
 class GoogleCloudStorageOutputStream::GoogleCloudStorageOutputStreamImpl {
 public:
-	//~GoogleCloudStorageOutputStreamImpl();
 	GoogleCloudStorageOutputStreamImpl(
 		const std::string & bucketName, const std::string & objectKey, std::shared_ptr<gcs::Client> gcsClient);
+	~GoogleCloudStorageOutputStreamImpl();
 
 	arrow::Status close();
 	arrow::Status write(const void * buffer, int64_t nbytes);
-	arrow::Status write(const void * buffer, int64_t nbytes, int64_t * bytes_written);
 	arrow::Status flush();
 	arrow::Result<int64_t> tell() const;
+	bool closed() const;
 
 private:
+	arrow::Status insert_object(const std::string & objectName, const char * buffer, int64_t nbytes);
+	arrow::Status start_part_upload();
+	arrow::Status wait_for_part_uploads(size_t maxPending);
+	arrow::Status compose_parts();
+	void delete_parts();
+
 	std::shared_ptr<gcs::Client> gcsClient;
 	std::string bucket;
 	std::string key;
 
-	//		Aws::String uploadId;
-
-	//		std::vector<Aws::GoogleCloudStorage::Model::CompletedPart> completedParts; //just an etag (for response) and a
-	//part number
-	size_t currentPart;
+	// a parallel composite upload: the parts are uploaded as temporary objects, which are composed into the file
+	// once it is closed. A file that fits in a single part is uploaded as it is
+	std::vector<std::string> partNames;
 	int64_t written;
-};
-
-struct membuf : std::streambuf {
-	membuf(char const * base, size_t size) {
-		char * p(const_cast<char *>(base));
-		this->setg(p, p, p + size);
-	}
-};
-
-struct imemstream : virtual membuf, std::iostream {
-	imemstream(char const * base, size_t size)
-		: membuf(base, size), std::iostream(static_cast<std::streambuf *>(this)) {}
+	int64_t partSize;
+	size_t maxConcurrentParts;
+	std::shared_ptr<char> part_buffer;  // the bytes of the next part, uploaded once it has partSize
+	int64_t part_buffer_size;
+	arrow::Status status;  // the first error of the part uploads
+	bool is_closed;
+	// the parts being uploaded, destroyed (and so waited for) before the members above that they use
+	std::deque<std::future<arrow::Status>> uploads;
 };
 
 GoogleCloudStorageOutputStream::GoogleCloudStorageOutputStreamImpl::GoogleCloudStorageOutputStreamImpl(
@@ -67,114 +78,143 @@ GoogleCloudStorageOutputStream::GoogleCloudStorageOutputStreamImpl::GoogleCloudS
 	this->key = objectKey;
 	this->gcsClient = gcsClient;
 
-	currentPart = 1;
 	written = 0;
+	is_closed = false;
+	partSize = std::max<int64_t>(ObjectUploadConfig::getInstance().getPartSize(), 1);
+	maxConcurrentParts = ObjectUploadConfig::getInstance().getMaxConcurrentParts();
+	part_buffer_size = 0;
+}
+
+GoogleCloudStorageOutputStream::GoogleCloudStorageOutputStreamImpl::~GoogleCloudStorageOutputStreamImpl() {
+	if(!is_closed) {
+		wait_for_part_uploads(0);
+		delete_parts();
+	}
+}
+
+arrow::Status GoogleCloudStorageOutputStream::GoogleCloudStorageOutputStreamImpl::insert_object(
+	const std::string & objectName, const char * buffer, int64_t nbytes) {
+	google::cloud::StatusOr<gcs::ObjectMetadata> metadata =
+		this->gcsClient->InsertObject(bucket, objectName, nbytes > 0 ? std::string(buffer, nbytes) : std::string());
+	if(!metadata.ok()) {
+		Logging::Logger().logError("In Write: Uploading " + this->bucket + "/" + objectName + ". Problem was " +
+								   metadata.status().message());
+		return arrow::Status::IOError("Had a trouble uploading to file " + this->bucket + "/" + objectName +
+									  ". Problem was " + metadata.status().message());
+	}
+	return arrow::Status::OK();
+}
 
-	//    Aws::GoogleCloudStorage::Model::CreateMultipartUploadRequest request;
-	//	request.SetBucket(bucket);
-	//	request.SetKey(key);
-	//    Aws::GoogleCloudStorage::Model::CreateMultipartUploadOutcome createMultipartUploadOutcome =
-	//    GoogleCloudStorageClient->CreateMultipartUpload(request);
-	//	if (createMultipartUploadOutcome.IsSuccess()) {
-	//		this->uploadId = createMultipartUploadOutcome.GetResult().GetUploadId();
-	//	} else {
-	//        Logging::Logger().logError("Failed to create Aws::GoogleCloudStorage::Model::CreateMultipartUploadOutcome
-	//        for bucket: " + bucketName + " and key: " + objectKey);
-	//		bool shouldRetry = createMultipartUploadOutcome.GetError().ShouldRetry();
-	//		if (shouldRetry){
-	//			Logging::Logger().logError(createMultipartUploadOutcome.GetError().GetExceptionName() + " : " +
-	//createMultipartUploadOutcome.GetError().GetMessage() + "  SHOULD RETRY"); 		} else {
-	//			Logging::Logger().logError(createMultipartUploadOutcome.GetError().GetExceptionName() + " : " +
-	//createMultipartUploadOutcome.GetError().GetMessage() + "  SHOULD NOT RETRY");
-	//		}
-	//        throw BlazingGoogleCloudStorageException("Failed to create
-	//        Aws::GoogleCloudStorage::Model::CreateMultipartUploadOutcome. Problem was " +
-	//        createMultipartUploadOutcome.GetError().GetExceptionName() + " : " +
-	//        createMultipartUploadOutcome.GetError().GetMessage());
-	//		this->uploadId = FAILED_UPLOAD;
-	//	}
-
-	// start upload here
+arrow::Status GoogleCloudStorageOutputStream::GoogleCloudStorageOutputStreamImpl::wait_for_part_uploads(size_t maxPending) {
+	while(uploads.size() > maxPending) {
+		arrow::Status uploadStatus = uploads.front().get();
+		uploads.pop_front();
+		if(status.ok() && !uploadStatus.ok()) {
+			status = uploadStatus;
+		}
+	}
+	return status;
 }
 
-arrow::Status GoogleCloudStorageOutputStream::GoogleCloudStorageOutputStreamImpl::write(
-	const void * /*buffer*/, int64_t /*nbytes*/) {
-	//    Aws::GoogleCloudStorage::Model::UploadPartRequest uploadPartRequest;
-	//	uploadPartRequest.SetBucket(bucket);
-	//	uploadPartRequest.SetKey(key);
-	//	uploadPartRequest.SetPartNumber(currentPart);
-	//	uploadPartRequest.SetUploadId(uploadId);
-	//	//char * tempBuffer = (char *) buffer;
-
-	//	//std::shared_ptr<imemstream> membuffer =  std::make_shared<imemstream>(new );
-	//	//   imemstream membuffer((char *) buffer,nbytes);
-
-	////    std::shared_ptr<imemstream> memBufferPtr
-	//	uploadPartRequest.SetBody(std::make_shared < imemstream > ((char *) buffer, nbytes));
-
-	//	// uploadPart1Request.SetContentMD5(HashingUtils::Base64Encode(md5OfStream));
-
-	//	uploadPartRequest.SetContentLength(nbytes);
-
-	//	written += nbytes;
-	//    Aws::GoogleCloudStorage::Model::UploadPartOutcome uploadOutcome =
-	//    GoogleCloudStorageClient->UploadPart(uploadPartRequest);
-	//	if (uploadOutcome.IsSuccess()) {
-	//        Aws::GoogleCloudStorage::Model::CompletedPart completedPart;
-	//		completedPart.SetETag(uploadOutcome.GetResult().GetETag());
-	//		completedPart.SetPartNumber(currentPart);
-	//		this->completedParts.push_back(completedPart);
-	//		currentPart++;
-	//		return arrow::Status::OK();
-	//	} else {
-	//		Logging::Logger().logError("In Write: Uploading part " + std::to_string(currentPart) + " on file " +
-	//this->bucket + "/" + key + ". Problem was " + uploadOutcome.GetError().GetExceptionName() + " : " +
-	//uploadOutcome.GetError().GetMessage()); 		return arrow::Status::IOError("Had a trouble uploading part " +
-	//std::to_string(currentPart) + " on file " + this->bucket + "/" + key + ". Problem was " +
-	//uploadOutcome.GetError().GetExceptionName() + " : " + uploadOutcome.GetError().GetMessage());
-	//	}
+arrow::Status GoogleCloudStorageOutputStream::GoogleCloudStorageOutputStreamImpl::start_part_upload() {
+	// the writer only blocks when maxConcurrentParts parts are already being uploaded
+	ARROW_RETURN_NOT_OK(wait_for_part_uploads(maxConcurrentParts - 1));
+
+	std::string partName = key + ".upload-part-" + std::to_string(partNames.size());
+	partNames.push_back(partName);
+	std::shared_ptr<char> buffer = std::move(part_buffer);
+	int64_t nbytes = part_buffer_size;
+	part_buffer_size = 0;
+	uploads.push_back(std::async(std::launch::async, [this, partName, buffer, nbytes]() {
+		return this->insert_object(partName, buffer.get(), nbytes);
+	}));
+	return arrow::Status::OK();
+}
+
+arrow::Status GoogleCloudStorageOutputStream::GoogleCloudStorageOutputStreamImpl::write(const void * buffer, int64_t nbytes) {
+	ARROW_RETURN_NOT_OK(status);
+	written += nbytes;
+	const char * data = (const char *) buffer;
+	while(nbytes > 0) {
+		if(part_buffer == nullptr) {
+			part_buffer = ObjectUploadConfig::getInstance().allocate(partSize);
+		}
+		int64_t size = std::min(nbytes, partSize - part_buffer_size);
+		memcpy(part_buffer.get() + part_buffer_size, data, size);
+		part_buffer_size += size;
+		data += size;
+		nbytes -= size;
+		// a full part is only uploaded once more bytes come, so that a file of a single part needs no compose
+		if(part_buffer_size == partSize && nbytes > 0) {
+			ARROW_RETURN_NOT_OK(start_part_upload());
+		}
+	}
 	return arrow::Status::OK();
 }
 
 arrow::Status GoogleCloudStorageOutputStream::GoogleCloudStorageOutputStreamImpl::flush() {
-	// flush is a pass through in all reality
-	// we are making each write send the contents for now for simplicity of design
+	// the parts are only uploaded once they are full, and the rest when the stream is closed
 	return arrow::Status::OK();
 }
 
-arrow::Status GoogleCloudStorageOutputStream::GoogleCloudStorageOutputStreamImpl::close() {
-	//	//flush the buffer
-	//	flush();
-	//    Aws::GoogleCloudStorage::Model::CompleteMultipartUploadRequest completeMultipartUploadRequest;
-
-	//	completeMultipartUploadRequest.SetBucket(bucket);
-	//	completeMultipartUploadRequest.SetKey(key);
-	//	completeMultipartUploadRequest.SetUploadId(uploadId);
-
-	//    Aws::GoogleCloudStorage::Model::CompletedMultipartUpload completedMultipartUpload;
-	//	completedMultipartUpload.SetParts(completedParts);
-	//	completeMultipartUploadRequest.WithMultipartUpload(completedMultipartUpload);
-
-	//    Aws::GoogleCloudStorage::Model::CompleteMultipartUploadOutcome completeMultipartUploadOutcome =
-	//    GoogleCloudStorageClient->CompleteMultipartUpload(completeMultipartUploadRequest);
-	//	if (completeMultipartUploadOutcome.IsSuccess()) {
-	//		return arrow::Status::OK();
-	//	} else {
-	//		Logging::Logger().logError("In closing outputstream. Problem was " +
-	//completeMultipartUploadOutcome.GetError().GetExceptionName() + " : " +
-	//completeMultipartUploadOutcome.GetError().GetMessage()); 		return arrow::Status::IOError("Error closing
-	//outputstream. Problem was " + completeMultipartUploadOutcome.GetError().GetExceptionName() + " : " +
-	//completeMultipartUploadOutcome.GetError().GetMessage());
-
-	//	}
-	////	GoogleCloudStorageClient->CompleteMultipartUpload(uploadCompleteRequest);
+arrow::Status GoogleCloudStorageOutputStream::GoogleCloudStorageOutputStreamImpl::compose_parts() {
+	// a compose takes up to MAX_COMPOSE_SOURCES objects, so the file is composed from the first ones and then
+	// appended to with the others
+	for(size_t first = 0; first < partNames.size();) {
+		std::vector<gcs::ComposeSourceObject> sources;
+		if(first > 0) {
+			sources.push_back(gcs::ComposeSourceObject{key, {}, {}});
+		}
+		while(first < partNames.size() && sources.size() < MAX_COMPOSE_SOURCES) {
+			sources.push_back(gcs::ComposeSourceObject{partNames[first++], {}, {}});
+		}
+		google::cloud::StatusOr<gcs::ObjectMetadata> metadata = this->gcsClient->ComposeObject(bucket, sources, key);
+		if(!metadata.ok()) {
+			Logging::Logger().logError("In closing outputstream. Problem was " + metadata.status().message());
+			return arrow::Status::IOError("Error closing outputstream. Problem was " + metadata.status().message());
+		}
+	}
 	return arrow::Status::OK();
 }
 
+void GoogleCloudStorageOutputStream::GoogleCloudStorageOutputStreamImpl::delete_parts() {
+	for(const std::string & partName : partNames) {
+		google::cloud::Status deleteStatus = this->gcsClient->DeleteObject(bucket, partName);
+		if(!deleteStatus.ok()) {
+			Logging::Logger().logError("In deleting the upload part " + this->bucket + "/" + partName +
+									   ". Problem was " + deleteStatus.message());
+		}
+	}
+	partNames.clear();
+}
+
+arrow::Status GoogleCloudStorageOutputStream::GoogleCloudStorageOutputStreamImpl::close() {
+	if(is_closed) {
+		return status;
+	}
+	is_closed = true;
+	if(partNames.empty()) {
+		status = insert_object(key, part_buffer.get(), part_buffer_size);
+		part_buffer.reset();
+		return status;
+	}
+	if(status.ok() && part_buffer_size > 0) {
+		start_part_upload();
+	}
+	wait_for_part_uploads(0);
+	if(status.ok()) {
+		status = compose_parts();
+	}
+	delete_parts();
+	return status;
+}
+
 arrow::Result<int64_t> GoogleCloudStorageOutputStream::GoogleCloudStorageOutputStreamImpl::tell() const {
 	return written;
 }
 
+bool GoogleCloudStorageOutputStream::GoogleCloudStorageOutputStreamImpl::closed() const { return is_closed; }
+
 // BEGIN GoogleCloudStorageOutputStream
 
 GoogleCloudStorageOutputStream::GoogleCloudStorageOutputStream(
@@ -193,11 +233,6 @@ arrow::Status GoogleCloudStorageOutputStream::Flush() { return this->impl_->flus
 
 arrow::Result<int64_t> GoogleCloudStorageOutputStream::Tell() const { return this->impl_->tell(); }
 
-bool GoogleCloudStorageOutputStream::closed() const {
-	// Since every file interaction is a request, then the file is never really open. This function is necesary due to
-	// the Apache Arrow interface starting with v12. Depending on who or what uses this function, we may want this to
-	// always return false??
-	return true;
-}
+bool GoogleCloudStorageOutputStream::closed() const { return this->impl_->closed(); }
 
 // END GoogleCloudStorageOutputStream
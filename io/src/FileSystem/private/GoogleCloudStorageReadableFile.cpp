@@ -5,6 +5,7 @@
 
 #include "GoogleCloudStorageReadableFile.h"
 
+#include <algorithm>
 #include <istream>
 #include <streambuf>
 
@@ -13,6 +14,7 @@
 #include "arrow/buffer.h"
 #include <arrow/memory_pool.h>
 
+#include "FileSystem/RemoteFileCache.h"
 #include "Util/StringUtil.h"
 
 #include "Library/Logging/Logger.h"
@@ -21,17 +23,35 @@ namespace Logging = Library::Logging;
 
 // TODO: handle the situation when not all data is read
 
+namespace {
+
+// the planned ranges closer than this are fetched with one request, since a round trip costs more than reading the hole
+const int64_t COALESCE_HOLE_SIZE_LIMIT = 1024 * 1024;
+const int64_t COALESCE_RANGE_SIZE_LIMIT = 64 * 1024 * 1024;
+
+// the ranges of the RemoteFileCache are keyed by the uri of their objects
+const std::string URI_SCHEME = "gs://";
+
+}  // namespace
+
 GoogleCloudStorageReadableFile::~GoogleCloudStorageReadableFile() {}
 
 GoogleCloudStorageReadableFile::GoogleCloudStorageReadableFile(
-	std::shared_ptr<gcs::Client> gcsClient, std::string bucketName, std::string key) {
+	std::shared_ptr<gcs::Client> gcsClient, std::string bucketName, std::string key, int64_t size)
+	: size(size) {
 	this->key = key;
 	this->bucketName = bucketName;
 	this->gcsClient = gcsClient;
 	position = 0;
 	valid = true;
+	readCache = std::make_unique<RangedReadCache>(
+		[this](int64_t position, int64_t nbytes, void * buffer) { return this->fetchRange(position, nbytes, buffer); },
+		COALESCE_HOLE_SIZE_LIMIT,
+		COALESCE_RANGE_SIZE_LIMIT);
 }
 
+void GoogleCloudStorageReadableFile::planReads(const std::vector<ByteRange> & ranges) { readCache->planReads(ranges); }
+
 arrow::Status GoogleCloudStorageReadableFile::Seek(int64_t position) {
 	this->position = position;
 	return arrow::Status::OK();
@@ -45,7 +65,25 @@ arrow::Status GoogleCloudStorageReadableFile::Close() {
 	return arrow::Status::OK();
 }
 
+std::string GoogleCloudStorageReadableFile::getVersion() {
+	std::call_once(versionFlag, [this]() {
+		using ::google::cloud::StatusOr;
+
+		StatusOr<gcs::ObjectMetadata> objectMetadata = this->gcsClient->GetObjectMetadata(this->bucketName, this->key);
+		if(objectMetadata) {
+			version = objectMetadata->etag();
+		} else {
+			// without it the ranges of the object are not cached, the object could have changed
+			Logging::Logger().logWarn("GoogleCloudStorageReadableFile::getVersion, GetObjectMetadata failed for bucketName: " + bucketName + " key " + key);
+		}
+	});
+	return version;
+}
+
 arrow::Result<int64_t> GoogleCloudStorageReadableFile::GetSize() {
+	if(this->size >= 0) {
+		return this->size.load();
+	}
     int64_t size = -1;
 	using ::google::cloud::StatusOr;
 
@@ -54,6 +92,7 @@ arrow::Result<int64_t> GoogleCloudStorageReadableFile::GetSize() {
 	if(objectMetadata) {  // if success
 		const long long contentLength = objectMetadata->size();
 		size = contentLength;
+		this->size = size;
 	} else {
 		size = -1;
 		Logging::Logger().logWarn("GoogleCloudStorageReadableFile::GetSize, HeadObject failed");
@@ -79,6 +118,13 @@ arrow::Result<int64_t> GoogleCloudStorageReadableFile::GetSize() {
 
 arrow::Result<int64_t> GoogleCloudStorageReadableFile::Read(int64_t nbytes, void* buffer) {
     int64_t bytesRead = -1;
+	if(readCache->read(position, nbytes, buffer, bytesRead)) {
+		position += bytesRead;
+		return bytesRead;
+	}
+	if(RemoteFileCache::getInstance().isEnabled()) {
+		return this->ReadAt(position, nbytes, buffer);
+	}
 	auto results = this->gcsClient->ReadObject(this->bucketName, key, gcs::ReadRange(position, position + nbytes));
 
 	if(!results.status().ok()) {
@@ -129,6 +175,19 @@ arrow::Result<int64_t> GoogleCloudStorageReadableFile::Read(int64_t nbytes, void
 
 arrow::Result<std::shared_ptr<arrow::Buffer>> GoogleCloudStorageReadableFile::Read(int64_t nbytes) {
     std::shared_ptr<arrow::Buffer> out = nullptr;
+	// the ranges that were planned or that can be in the RemoteFileCache are read like any other range
+	if(readCache->contains(position, nbytes) || RemoteFileCache::getInstance().isEnabled()) {
+		arrow::Result<std::unique_ptr<arrow::ResizableBuffer>> buffer = AllocateResizableBuffer(nbytes, arrow::default_memory_pool());
+		int64_t bytesRead = 0;
+		if(!readCache->read(position, nbytes, buffer.ValueOrDie()->mutable_data(), bytesRead)) {
+			bytesRead = fetchRange(position, nbytes, buffer.ValueOrDie()->mutable_data());
+		}
+		if(bytesRead > 0) {
+			this->position = position + bytesRead;
+			out = std::move(buffer.ValueOrDie());
+		}
+		return out;
+	}
     
 	//	std::cout<<"GoogleCloudStorageReadableFile::Read " + std::to_string(nbytes)<<std::endl;
 	auto results = this->gcsClient->ReadObject(this->bucketName, key, gcs::ReadRange(position, position + nbytes));
@@ -195,6 +254,27 @@ return arrow::Status::OK();
 }
 
 arrow::Result<int64_t> GoogleCloudStorageReadableFile::ReadAt(int64_t position, int64_t nbytes, void* buffer) {
+    int64_t bytesRead = -1;
+	if(!readCache->read(position, nbytes, buffer, bytesRead)) {
+		bytesRead = fetchRange(position, nbytes, buffer);
+	}
+	this->position = position + std::max(bytesRead, int64_t(0));
+	return bytesRead;
+}
+
+int64_t GoogleCloudStorageReadableFile::fetchRange(int64_t position, int64_t nbytes, void* buffer) {
+	RemoteFileCache & diskCache = RemoteFileCache::getInstance();
+	const std::string version = diskCache.isEnabled() ? getVersion() : "";
+	if(version.empty()) {
+		return requestRange(position, nbytes, buffer);
+	}
+	return diskCache.read(RemoteFileCache::makeKey(URI_SCHEME + bucketName + "/" + key, version, position, nbytes),
+		nbytes,
+		buffer,
+		[this, position, nbytes](void * out) { return this->requestRange(position, nbytes, out); });
+}
+
+int64_t GoogleCloudStorageReadableFile::requestRange(int64_t position, int64_t nbytes, void* buffer) {
     int64_t bytesRead = -1;
     
 	//	std::cout<<"GoogleCloudStorageReadableFile::ReadAt " + std::to_string(nbytes)<<std::endl;
@@ -227,7 +307,6 @@ arrow::Result<int64_t> GoogleCloudStorageReadableFile::ReadAt(int64_t position,
 		// so we avoid read first all the stuff only to get its size (results.gcount() doesnt work)
 		bytesRead = nbytes;
 		//*bytesRead = nbytes < *bytesRead ? nbytes : *bytesRead;
-		this->position = position + bytesRead;
 		results.read((char *) buffer, bytesRead);
 
 		// NOTE percy check for badbit also the user should never read more bytes than the result content size
@@ -243,6 +322,19 @@ arrow::Result<int64_t> GoogleCloudStorageReadableFile::ReadAt(int64_t position,
 
 arrow::Result<std::shared_ptr<arrow::Buffer>> GoogleCloudStorageReadableFile::ReadAt(int64_t position, int64_t nbytes) {
     std::shared_ptr<arrow::Buffer> out = nullptr;
+	// the ranges that were planned or that can be in the RemoteFileCache are read like any other range
+	if(readCache->contains(position, nbytes) || RemoteFileCache::getInstance().isEnabled()) {
+		arrow::Result<std::unique_ptr<arrow::ResizableBuffer>> buffer = AllocateResizableBuffer(nbytes, arrow::default_memory_pool());
+		int64_t bytesRead = 0;
+		if(!readCache->read(position, nbytes, buffer.ValueOrDie()->mutable_data(), bytesRead)) {
+			bytesRead = fetchRange(position, nbytes, buffer.ValueOrDie()->mutable_data());
+		}
+		if(bytesRead > 0) {
+			this->position = position + bytesRead;
+			out = std::move(buffer.ValueOrDie());
+		}
+		return out;
+	}
 
 	//	std::cout<<"GoogleCloudStorageReadableFile::ReadAt " + std::to_string(nbytes)<<std::endl;
 
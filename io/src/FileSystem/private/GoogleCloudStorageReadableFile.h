@@ -26,11 +26,21 @@
 
 #include "google/cloud/storage/client.h"
 
+#include <atomic>
+#include <mutex>
+
+#include "FileSystem/RangedReadCache.h"
+
 namespace gcs = google::cloud::storage;
 
-class GoogleCloudStorageReadableFile : public arrow::io::RandomAccessFile {
+class GoogleCloudStorageReadableFile : public RangedReadableFile {
 public:
-	GoogleCloudStorageReadableFile(std::shared_ptr<gcs::Client> gcsClient, std::string bucket, std::string key);
+	/**
+	 * @param size the size of the object when it is known, like from a listing, so that GetSize does not ask for it,
+	 * or -1.
+	 */
+	GoogleCloudStorageReadableFile(
+		std::shared_ptr<gcs::Client> gcsClient, std::string bucket, std::string key, int64_t size = -1);
 	~GoogleCloudStorageReadableFile();
 
     arrow::Status Close() override;
@@ -54,12 +64,30 @@ public:
 
 	bool closed() const override;
 
+	/**
+	 * Fetches these ranges in parallel and keeps them for the reads that follow, see RangedReadCache.
+	 */
+	void planReads(const std::vector<ByteRange> & ranges) override;
+
 private:
+	// reads a range from the RemoteFileCache, and downloads it with requestRange when it is not there
+	int64_t fetchRange(int64_t position, int64_t nbytes, void * buffer);
+
+	// one ReadObject request for a range, without the planned reads
+	int64_t requestRange(int64_t position, int64_t nbytes, void * buffer);
+
+	// the etag of the object, which tells the ranges of the RemoteFileCache of its older versions apart
+	std::string getVersion();
+
 	std::shared_ptr<gcs::Client> gcsClient;
 	std::string bucketName;
 	std::string key;
 	size_t position;
 	bool valid;
+	std::once_flag versionFlag;
+	std::string version;
+	std::atomic<int64_t> size;  // -1 until it is known
+	std::unique_ptr<RangedReadCache> readCache;  // last, so that its fetches are done before the client goes away
 
 	ARROW_DISALLOW_COPY_AND_ASSIGN(GoogleCloudStorageReadableFile);
 };
@@ -10,6 +10,7 @@
 #include "arrow/buffer.h"
 
 #include "ExceptionHandling/BlazingException.h"
+#include "FileSystem/ObjectStoreConfig.h"
 #include "Util/StringUtil.h"
 
 #include "ExceptionHandling/BlazingThread.h"
@@ -58,7 +59,10 @@ bool GoogleCloudStorage::Private::connect(const FileSystemConnection & fileSyste
 		throw std::runtime_error(error);
 	}
 
-	auto connConf = opts->set_project_id(projectId);
+	// all the files of the filesystem share this client, so its pool of keep-alive connections is sized for the files
+	// that are opened and read at the same time
+	auto connConf = opts->set_project_id(projectId).set_connection_pool_size(
+		ObjectStoreConfig::getInstance().getMaxConnections());
 
 	this->gcsClient = std::make_shared<gcs::Client>(connConf);
 
@@ -181,7 +185,10 @@ FileStatus GoogleCloudStorage::Private::getFileStatus(const Uri & uri) const {
 			const FileStatus fileStatus(uri, fileType, contentLength);
 			return fileStatus;
 		} else {  // is probably a file (e.g. application/octet-stream or text/x-python and so on ...
-			const FileStatus fileStatus(uri, FileType::FILE, contentLength);
+			const unsigned long long modificationTime = std::chrono::duration_cast<std::chrono::milliseconds>(
+				objectMetadata->updated().time_since_epoch()).count();
+			ObjectStoreConfig::getInstance().rememberObjectSize("gs://" + bucketName + "/" + objectKey, contentLength);
+			const FileStatus fileStatus(uri, FileType::FILE, contentLength, modificationTime);
 			return fileStatus;
 		}
 	} else {
@@ -358,6 +365,8 @@ std::vector<Uri> GoogleCloudStorage::Private::list(const Uri & uri, const std::s
 			// WARNING TODO percy there is no folders concept in S# ... we should change Path::isFile::bool to
 			// Path::ObjectType::Unkwnow,DIR,FILE,SYMLIN,ETC
 			const Path path = Path("/" + object_metadata->name(), true); // TODO percy avoid hardcoded string
+			ObjectStoreConfig::getInstance().rememberObjectSize(
+				"gs://" + bucket + "/" + object_metadata->name(), object_metadata->size());
 
 			if(path != folderPath) {
 				const bool pass = WildcardFilter::match(path.toString(true), finalWildcard);
@@ -376,6 +385,8 @@ std::vector<Uri> GoogleCloudStorage::Private::list(const Uri & uri, const std::s
 				// WARNING TODO percy there is no folders concept in S# ... we should change Path::isFile::bool to
 				// Path::ObjectType::Unkwnow,DIR,FILE,SYMLIN,ETC
 				const Path path = Path("/" + object_metadata->name(), true);  // TODO percy avoid hardcoded string
+				ObjectStoreConfig::getInstance().rememberObjectSize(
+					"gs://" + bucket + "/" + object_metadata->name(), object_metadata->size());
 	
 				if(path != folderPath) {
 					const bool pass = WildcardFilter::match(path.toString(true), finalWildcard);
@@ -833,23 +844,24 @@ bool GoogleCloudStorage::Private::openReadable(
 	const Path path = uriWithRoot.getPath();
 	const std::string objectKey = path.toString(true).substr(1, path.toString(true).size());
 	const std::string bucketName = this->getBucketName();
+	// the size of the object is taken from its listing when there was one, instead of a metadata request
+	const int64_t size = ObjectStoreConfig::getInstance().getObjectSize("gs://" + bucketName + "/" + objectKey);
 	// TODO: S3ReadableFile currentl has no validity check add it and throw errors here
-	*file = std::make_shared<GoogleCloudStorageReadableFile>(this->gcsClient, bucketName, objectKey);
+	*file = std::make_shared<GoogleCloudStorageReadableFile>(this->gcsClient, bucketName, objectKey, size);
 	return (*file)->isValid();
 }
 
 bool GoogleCloudStorage::Private::openWriteable(
-	const Uri & /*uri*/, std::shared_ptr<GoogleCloudStorageOutputStream> * /*file*/) const {
-	//	if (uri.isValid() == false) {
-	//		throw BlazingInvalidPathException(uri);
-	//	}
+	const Uri & uri, std::shared_ptr<GoogleCloudStorageOutputStream> * file) const {
+	if(uri.isValid() == false) {
+		throw BlazingInvalidPathException(uri);
+	}
 
-	//	const Uri uriWithRoot(uri.getScheme(), uri.getAuthority(), this->root + uri.getPath().toString());
-	//	const Path path = uriWithRoot.getPath();
-	//	const std::string objectKey = path.toString(true).substr(1, path.toString(true).size());
-	//	const std::string bucketName = this->getBucketName();
-	//	//TODO: S3Outputstream currentl has no validity check add it and throw errors here
-	//	*file = std::make_shared < S3OutputStream > (bucketName, objectKey, this->s3Client);
+	const Uri uriWithRoot(uri.getScheme(), uri.getAuthority(), this->root + uri.getPath().toString());
+	const Path path = uriWithRoot.getPath();
+	const std::string objectKey = path.toString(true).substr(1, path.toString(true).size());
+	const std::string bucketName = this->getBucketName();
+	*file = std::make_shared<GoogleCloudStorageOutputStream>(bucketName, objectKey, this->gcsClient);
 
 	return true;
 }
@@ -5,12 +5,15 @@
 
 #include "HadoopFileSystem_p.h"
 
+#include <algorithm>
 #include <iostream>
 
 #include <arrow/io/api.h>
 #include "arrow/buffer.h"
 #include "arrow/status.h"
 
+#include "FileSystem/HadoopReadConfig.h"
+#include "FileSystem/private/HadoopReadableFile.h"
 #include "Util/StringUtil.h"
 
 HadoopFileSystem::Private::Private(const FileSystemConnection & fileSystemConnection, const Path & root)
@@ -62,6 +65,16 @@ bool HadoopFileSystem::Private::connect(const FileSystemConnection & fileSystemC
     
 	hdfsConfig.kerb_ticket = kerberosTicket;
 
+	// the blocks of a datanode on this host are read from its disks instead of through it, when the client can
+	HadoopReadConfig & readConfig = HadoopReadConfig::getInstance();
+	if(readConfig.getShortCircuitReads()) {
+		hdfsConfig.extra_conf["dfs.client.read.shortcircuit"] = "true";
+		if(!readConfig.getDomainSocketPath().empty()) {
+			hdfsConfig.extra_conf["dfs.domain.socket.path"] = readConfig.getDomainSocketPath();
+		}
+	}
+	this->maxReadHandles = readConfig.getMaxReadHandles();
+
 	const arrow::Status connectionStat = arrow::io::HadoopFileSystem::Connect(&hdfsConfig, &this->hdfs);
 
 	if(connectionStat.ok() == false) {
@@ -88,6 +101,11 @@ bool HadoopFileSystem::Private::connect(const FileSystemConnection & fileSystemC
 }
 
 bool HadoopFileSystem::Private::disconnect() {
+	if(this->locationsFs != nullptr) {
+		this->locationsDriver->Disconnect(this->locationsFs);
+		this->locationsFs = nullptr;
+	}
+
 	if(this->connected == false) {
 		auto temphdfs = std::move(this->hdfs);
 		this->hdfs = nullptr;
@@ -508,6 +526,66 @@ bool HadoopFileSystem::Private::truncateFile(const Uri & uri, unsigned long long
 	return false;
 }
 
+std::map<std::string, long long> HadoopFileSystem::Private::getFileLocations(const Uri & uri) const {
+	using namespace HadoopFileSystemConnection;
+
+	std::map<std::string, long long> hostBytes;
+	if(uri.isValid() == false || this->connected == false) {
+		return hostBytes;
+	}
+
+	const Uri uriWithRoot(uri.getScheme(), uri.getAuthority(), this->root + uri.getPath().toString());
+	const std::string path = uriWithRoot.getPath().toString();
+
+	arrow::io::HdfsPathInfo info;
+	const arrow::Status status = this->hdfs->GetPathInfo(path, &info);
+	if(status.ok() == false || info.kind != arrow::io::ObjectType::type::FILE || info.size == 0) {
+		return hostBytes;
+	}
+
+	std::lock_guard<std::mutex> lock(this->locationsMutex);
+	if(this->locationsFs == nullptr) {
+		if(arrow::io::internal::ConnectLibHdfs(&this->locationsDriver).ok() == false) {
+			return hostBytes;
+		}
+
+		hdfsBuilder * builder = this->locationsDriver->NewBuilder();
+		const std::string host = this->fileSystemConnection.getConnectionProperty(ConnectionProperty::HOST);
+		const std::string user = this->fileSystemConnection.getConnectionProperty(ConnectionProperty::USER);
+		const std::string kerberosTicket = this->fileSystemConnection.getConnectionProperty(ConnectionProperty::KERBEROS_TICKET);
+		this->locationsDriver->BuilderSetNameNode(builder, host.c_str());
+		this->locationsDriver->BuilderSetNameNodePort(
+			builder, atoi(this->fileSystemConnection.getConnectionProperty(ConnectionProperty::PORT).c_str()));
+		if(!user.empty()) {
+			this->locationsDriver->BuilderSetUserName(builder, user.c_str());
+		}
+		if(!kerberosTicket.empty()) {
+			this->locationsDriver->BuilderSetKerbTicketCachePath(builder, kerberosTicket.c_str());
+		}
+		this->locationsFs = this->locationsDriver->BuilderConnect(builder);
+		if(this->locationsFs == nullptr) {
+			return hostBytes;
+		}
+	}
+
+	// a list of the hosts of every block, each one ending with a null
+	char *** blockHosts = this->locationsDriver->GetHosts(this->locationsFs, path.c_str(), 0, info.size);
+	if(blockHosts == nullptr) {
+		return hostBytes;
+	}
+
+	const long long blockSize = info.block_size > 0 ? info.block_size : info.size;
+	for(long long block = 0; blockHosts[block] != nullptr; block++) {
+		const long long blockBytes = std::min(blockSize, info.size - block * blockSize);
+		for(int replica = 0; blockHosts[block][replica] != nullptr; replica++) {
+			hostBytes[blockHosts[block][replica]] += blockBytes;
+		}
+	}
+	this->locationsDriver->FreeHosts(blockHosts);
+
+	return hostBytes;
+}
+
 std::shared_ptr<arrow::io::RandomAccessFile> HadoopFileSystem::Private::openReadable(const Uri & uri) const {
 	if(uri.isValid() == false) {
 		// TODO percy raise error
@@ -517,12 +595,14 @@ std::shared_ptr<arrow::io::RandomAccessFile> HadoopFileSystem::Private::openRead
 	const Uri uriWithRoot(uri.getScheme(), uri.getAuthority(), this->root + uri.getPath().toString());
 	const Path path = uriWithRoot.getPath();
 
-	std::shared_ptr<arrow::io::HdfsReadableFile> in_file;
-
 	// path is the location on hdfs
-	arrow::Status stat = this->hdfs->OpenReadable(path.toString(), &in_file);
+	auto in_file = std::make_shared<HadoopReadableFile>(this->hdfs, path.toString(), this->maxReadHandles);
+	arrow::Status stat = in_file->Open();
 
 	// TODO check stat and thrown FileSystemException
+	if(stat.ok() == false) {
+		return nullptr;
+	}
 
 	return in_file;
 }
@@ -8,7 +8,10 @@
 
 #include "FileSystem/HadoopFileSystem.h"
 
+#include <mutex>
+
 #include "arrow/io/hdfs.h"
+#include "arrow/io/hdfs_internal.h"
 
 class HadoopFileSystem::Private {
 public:
@@ -35,6 +38,9 @@ public:
 	bool move(const Uri & src, const Uri & dst) const;
 	bool truncateFile(const Uri & uri, unsigned long long length) const;
 
+	// Locality
+	std::map<std::string, long long> getFileLocations(const Uri & uri) const;
+
 	// I/O
 	std::shared_ptr<arrow::io::RandomAccessFile> openReadable(const Uri & uri) const;
 	std::shared_ptr<arrow::io::OutputStream> openWriteable(const Uri & uri) const;
@@ -63,6 +69,13 @@ private:
 private:
 	FileSystemConnection fileSystemConnection;
 	std::shared_ptr<arrow::io::HadoopFileSystem> hdfs;  // should be std::unique_ptr but we are contrained by Arrow API
+	int maxReadHandles = 1;  // the handles a readable file preads its ranges with, see HadoopReadConfig
+
+	// arrow does not tell where the blocks of a file are, so they are asked to libhdfs with a connection of its own,
+	// made the first time that they are needed
+	mutable std::mutex locationsMutex;
+	mutable arrow::io::internal::LibHdfsShim * locationsDriver = nullptr;
+	mutable hdfsFS locationsFs = nullptr;
 };
 
 #endif /* _HADOOP_FILE_SYSTEM_PRIVATE_H_ */
@@ -0,0 +1,199 @@
+/*
+ * Copyright 2021 BlazingDB, Inc.
+ */
+
+#include "HadoopReadableFile.h"
+
+#include <algorithm>
+#include <future>
+
+#include "arrow/buffer.h"
+#include <arrow/memory_pool.h>
+
+namespace {
+
+// the blocks of HDFS are read locally or from a datanode close by, so only the ranges with small holes are merged,
+// and the merged ranges are kept small enough to be read on different handles
+const int64_t COALESCE_HOLE_SIZE_LIMIT = 64 * 1024;
+const int64_t COALESCE_RANGE_SIZE_LIMIT = 16 * 1024 * 1024;
+
+// the reads larger than this are split between the handles
+const int64_t SPLIT_READ_SIZE = 8 * 1024 * 1024;
+
+}  // namespace
+
+HadoopReadableFile::HadoopReadableFile(
+	std::shared_ptr<arrow::io::HadoopFileSystem> hdfs, std::string path, int maxHandles)
+	: hdfs(hdfs), path(path), maxHandles(std::max(maxHandles, 1)), position(0), size(-1), is_closed(false),
+	  openHandles(0) {
+	readCache = std::make_unique<RangedReadCache>(
+		[this](int64_t position, int64_t nbytes, void * buffer) {
+			arrow::Result<int64_t> bytesRead = this->readRange(position, nbytes, buffer);
+			return bytesRead.ok() ? bytesRead.ValueOrDie() : int64_t(-1);
+		},
+		COALESCE_HOLE_SIZE_LIMIT,
+		COALESCE_RANGE_SIZE_LIMIT);
+}
+
+HadoopReadableFile::~HadoopReadableFile() {
+	readCache.reset();
+	Close();
+}
+
+arrow::Status HadoopReadableFile::Open() {
+	ARROW_ASSIGN_OR_RAISE(auto handle, acquireHandle());
+	releaseHandle(handle);
+	return arrow::Status::OK();
+}
+
+arrow::Status HadoopReadableFile::Close() {
+	std::lock_guard<std::mutex> lock(handlesMutex);
+	is_closed = true;
+	arrow::Status status;
+	for(auto & handle : freeHandles) {
+		arrow::Status closeStatus = handle->Close();
+		if(status.ok() && !closeStatus.ok()) {
+			status = closeStatus;
+		}
+	}
+	freeHandles.clear();
+	return status;
+}
+
+bool HadoopReadableFile::closed() const { return is_closed; }
+
+arrow::Result<std::shared_ptr<arrow::io::HdfsReadableFile>> HadoopReadableFile::acquireHandle() {
+	{
+		std::unique_lock<std::mutex> lock(handlesMutex);
+		handlesCondition.wait(lock, [this]() { return !freeHandles.empty() || openHandles < maxHandles; });
+		if(!freeHandles.empty()) {
+			auto handle = freeHandles.back();
+			freeHandles.pop_back();
+			return handle;
+		}
+		openHandles++;
+	}
+
+	// the handles are opened outside of the lock, since opening one is a round trip to the namenode
+	std::shared_ptr<arrow::io::HdfsReadableFile> handle;
+	arrow::Status status = this->hdfs->OpenReadable(path, &handle);
+	if(!status.ok()) {
+		std::lock_guard<std::mutex> lock(handlesMutex);
+		openHandles--;
+		handlesCondition.notify_one();
+		return status;
+	}
+	return handle;
+}
+
+void HadoopReadableFile::releaseHandle(std::shared_ptr<arrow::io::HdfsReadableFile> handle) {
+	std::lock_guard<std::mutex> lock(handlesMutex);
+	if(is_closed) {
+		handle->Close();
+		openHandles--;
+	} else {
+		freeHandles.push_back(handle);
+	}
+	handlesCondition.notify_one();
+}
+
+arrow::Result<int64_t> HadoopReadableFile::readRange(int64_t position, int64_t nbytes, void * out) {
+	ARROW_ASSIGN_OR_RAISE(auto handle, acquireHandle());
+	// a pread can return less than it was asked for before the end of the file, at the end of a block
+	int64_t bytesRead = 0;
+	arrow::Status status;
+	while(bytesRead < nbytes) {
+		arrow::Result<int64_t> result = handle->ReadAt(position + bytesRead, nbytes - bytesRead, (uint8_t *) out + bytesRead);
+		if(!result.ok()) {
+			status = result.status();
+			break;
+		}
+		if(result.ValueOrDie() == 0) {
+			break;
+		}
+		bytesRead += result.ValueOrDie();
+	}
+	releaseHandle(handle);
+	ARROW_RETURN_NOT_OK(status);
+	return bytesRead;
+}
+
+arrow::Result<int64_t> HadoopReadableFile::readSplitRange(int64_t position, int64_t nbytes, void * out) {
+	if(maxHandles == 1 || nbytes < 2 * SPLIT_READ_SIZE) {
+		return readRange(position, nbytes, out);
+	}
+
+	int64_t partSize = std::max(SPLIT_READ_SIZE, (nbytes + maxHandles - 1) / maxHandles);
+	std::vector<std::future<arrow::Result<int64_t>>> reads;
+	for(int64_t offset = 0; offset < nbytes; offset += partSize) {
+		int64_t partBytes = std::min(partSize, nbytes - offset);
+		reads.push_back(std::async(std::launch::async, [this, position, offset, partBytes, out]() {
+			return this->readRange(position + offset, partBytes, (uint8_t *) out + offset);
+		}));
+	}
+
+	// the bytes read are the ones before the first part that came short, which is the end of the file
+	int64_t bytesRead = 0;
+	bool complete = true;
+	arrow::Status status;
+	for(size_t i = 0; i < reads.size(); i++) {
+		arrow::Result<int64_t> result = reads[i].get();
+		if(!result.ok()) {
+			status = status.ok() ? result.status() : status;
+			continue;
+		}
+		if(complete) {
+			bytesRead += result.ValueOrDie();
+			complete = result.ValueOrDie() == std::min(partSize, nbytes - (int64_t) i * partSize);
+		}
+	}
+	ARROW_RETURN_NOT_OK(status);
+	return bytesRead;
+}
+
+void HadoopReadableFile::planReads(const std::vector<ByteRange> & ranges) { readCache->planReads(ranges); }
+
+arrow::Result<int64_t> HadoopReadableFile::GetSize() {
+	if(size < 0) {
+		ARROW_ASSIGN_OR_RAISE(auto handle, acquireHandle());
+		arrow::Result<int64_t> result = handle->GetSize();
+		releaseHandle(handle);
+		ARROW_ASSIGN_OR_RAISE(size, result);
+	}
+	return size;
+}
+
+arrow::Status HadoopReadableFile::Seek(int64_t position) {
+	this->position = position;
+	return arrow::Status::OK();
+}
+
+arrow::Result<int64_t> HadoopReadableFile::Tell() const { return this->position; }
+
+arrow::Result<int64_t> HadoopReadableFile::Read(int64_t nbytes, void * out) {
+	ARROW_ASSIGN_OR_RAISE(int64_t bytesRead, ReadAt(position, nbytes, out));
+	return bytesRead;
+}
+
+arrow::Result<std::shared_ptr<arrow::Buffer>> HadoopReadableFile::Read(int64_t nbytes) {
+	return ReadAt(position, nbytes);
+}
+
+arrow::Result<int64_t> HadoopReadableFile::ReadAt(int64_t position, int64_t nbytes, void * out) {
+	int64_t bytesRead = 0;
+	if(!readCache->read(position, nbytes, out, bytesRead)) {
+		ARROW_ASSIGN_OR_RAISE(bytesRead, readSplitRange(position, nbytes, out));
+	}
+	this->position = position + bytesRead;
+	return bytesRead;
+}
+
+arrow::Result<std::shared_ptr<arrow::Buffer>> HadoopReadableFile::ReadAt(int64_t position, int64_t nbytes) {
+	ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::ResizableBuffer> buffer,
+		arrow::AllocateResizableBuffer(nbytes, arrow::default_memory_pool()));
+	ARROW_ASSIGN_OR_RAISE(int64_t bytesRead, ReadAt(position, nbytes, buffer->mutable_data()));
+	if(bytesRead < nbytes) {
+		ARROW_RETURN_NOT_OK(buffer->Resize(bytesRead));
+	}
+	return std::shared_ptr<arrow::Buffer>(std::move(buffer));
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright 2021 BlazingDB, Inc.
+ */
+
+#ifndef SRC_UTIL_BLAZINGHDFS_HADOOPREADABLEFILE_H_
+#define SRC_UTIL_BLAZINGHDFS_HADOOPREADABLEFILE_H_
+
+#include "arrow/io/hdfs.h"
+#include "arrow/io/interfaces.h"
+#include "arrow/status.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+#include "FileSystem/RangedReadCache.h"
+
+/**
+ *  @brief A file of HDFS read with preads on up to maxHandles handles of its own, so that the reads of several
+ *  threads and the planned ranges are read concurrently instead of one after the other on a single handle.
+ */
+class HadoopReadableFile : public RangedReadableFile {
+public:
+	HadoopReadableFile(std::shared_ptr<arrow::io::HadoopFileSystem> hdfs, std::string path, int maxHandles);
+	~HadoopReadableFile();
+
+	/**
+	 *  @brief Opens the first handle, so that a file that can't be opened is known before it is read.
+	 */
+	arrow::Status Open();
+
+	arrow::Status Close() override;
+
+	arrow::Result<int64_t> GetSize() override;
+
+	arrow::Result<int64_t> Read(int64_t nbytes, void * out) override;
+
+	arrow::Result<std::shared_ptr<arrow::Buffer>> Read(int64_t nbytes) override;
+
+	arrow::Result<int64_t> ReadAt(int64_t position, int64_t nbytes, void * out) override;
+
+	arrow::Result<std::shared_ptr<arrow::Buffer>> ReadAt(int64_t position, int64_t nbytes) override;
+
+	arrow::Status Seek(int64_t position) override;
+	arrow::Result<int64_t> Tell() const override;
+
+	bool closed() const override;
+
+	/**
+	 *  Reads these ranges in parallel and keeps them for the reads that follow, see RangedReadCache.
+	 */
+	void planReads(const std::vector<ByteRange> & ranges) override;
+
+private:
+	// takes a free handle, or opens one if there are less than maxHandles, or else waits for one
+	arrow::Result<std::shared_ptr<arrow::io::HdfsReadableFile>> acquireHandle();
+	void releaseHandle(std::shared_ptr<arrow::io::HdfsReadableFile> handle);
+
+	// preads the range on a single handle
+	arrow::Result<int64_t> readRange(int64_t position, int64_t nbytes, void * out);
+
+	// preads the range, split in parts that are read on different handles when it is large
+	arrow::Result<int64_t> readSplitRange(int64_t position, int64_t nbytes, void * out);
+
+	std::shared_ptr<arrow::io::HadoopFileSystem> hdfs;
+	std::string path;
+	int maxHandles;
+	int64_t position;
+	int64_t size;
+	bool is_closed;
+
+	std::mutex handlesMutex;
+	std::condition_variable handlesCondition;
+	std::vector<std::shared_ptr<arrow::io::HdfsReadableFile>> freeHandles;
+	int openHandles;
+
+	std::unique_ptr<RangedReadCache> readCache;  // last, so that its reads are done before the handles go away
+
+	ARROW_DISALLOW_COPY_AND_ASSIGN(HadoopReadableFile);
+};
+
+#endif /* SRC_UTIL_BLAZINGHDFS_HADOOPREADABLEFILE_H_ */
@@ -45,6 +45,7 @@
 #include <aws/s3/model/UploadPartRequest.h>
 
 #include "ExceptionHandling/BlazingException.h"
+#include "FileSystem/ObjectStoreConfig.h"
 #include "Util/StringUtil.h"
 
 #include "ExceptionHandling/BlazingThread.h"
@@ -80,6 +81,11 @@ std::shared_ptr<Aws::S3::S3Client> make_s3_client(
 		clientConfig.requestTimeoutMs = requestTimeoutMs;
 	}
 
+	// all the files of the filesystem share this client, so its pool of keep-alive connections is sized for the files
+	// that are opened and read at the same time
+	clientConfig.maxConnections = ObjectStoreConfig::getInstance().getMaxConnections();
+	clientConfig.enableTcpKeepAlive = true;
+
 	bool useVirtualAddressing = true;
 
 	if (endpointOverride.empty() == false) {
@@ -362,7 +368,8 @@ FileStatus S3FileSystem::Private::getFileStatus(const Uri & uri) const {
 			const FileStatus fileStatus(uri, FileType::DIRECTORY, contentLength);
 			return fileStatus;
 		} else {
-			const FileStatus fileStatus(uri, FileType::FILE, contentLength);
+			ObjectStoreConfig::getInstance().rememberObjectSize("s3://" + bucket + "/" + objectKey, contentLength);
+			const FileStatus fileStatus(uri, FileType::FILE, contentLength, result.GetLastModified().Millis());
 			return fileStatus;
 		}
 	} else {
@@ -434,55 +441,81 @@ std::vector<FileStatus> S3FileSystem::Private::list(const Uri & uri, const FileF
 	request.WithDelimiter("/");  // NOTE percy since we control how to create files in S3 we should use this convention
 	request.WithPrefix(objectKey.data());
 
-	auto objectsOutcome = this->s3Client->ListObjectsV2(request);
+	// a listing returns up to 1000 keys, the rest are asked for with the continuation token
+	bool isTruncated = false;
+	do {
+		auto objectsOutcome = this->s3Client->ListObjectsV2(request);
+
+		if(objectsOutcome.IsSuccess()) {
+			this->rememberObjectSizes(objectsOutcome.GetResult().GetContents());
+			if(this->root.isRoot()) {  // if root is '/' then we don't need to replace the uris to relative paths
+				const Aws::Vector<Aws::S3::Model::Object> objects = objectsOutcome.GetResult().GetContents();
 
-	if(objectsOutcome.IsSuccess()) {
-		if(this->root.isRoot()) {  // if root is '/' then we don't need to replace the uris to relative paths
-			const Aws::Vector<Aws::S3::Model::Object> objects = objectsOutcome.GetResult().GetContents();
+				for(auto const & s3Object : objects) {
+					// WARNING TODO percy there is no folders concept in S3 ... we should change Path::isFile::bool to
+					// Path::ObjectType::Unkwnow,DIR,FILE,SYMLIN,ETC
+	                auto a = s3Object.GetKey().data();
+					const Path path("/" + std::string(a), true);  // TODO percy avoid hardcoded string
+
+					if(path != folderPath) {
+						const Uri entry(uri.getScheme(), uri.getAuthority(), path);
+						const FileStatus fileStatus(entry, FileType::FILE, s3Object.GetSize());
+						const bool pass = filter(fileStatus);
+
+						if(pass) {
+							response.push_back(fileStatus);
+						}
+					}
+				}
 
-			for(auto const & s3Object : objects) {
-				// WARNING TODO percy there is no folders concept in S3 ... we should change Path::isFile::bool to
-				// Path::ObjectType::Unkwnow,DIR,FILE,SYMLIN,ETC
-                auto a = s3Object.GetKey().data();
-				const Path path("/" + std::string(a), true);  // TODO percy avoid hardcoded string
+				const Aws::Vector<Aws::S3::Model::CommonPrefix> folders = objectsOutcome.GetResult().GetCommonPrefixes();
 
-				if(path != folderPath) {
+				for(auto const & s3Folder : folders) {
+					// WARNING TODO percy there is no folders concept in S# ... we should change Path::isFile::bool to
+					// Path::ObjectType::Unkwnow,DIR,FILE,SYMLIN,ETC
+					const Path path("/" + std::string(s3Folder.GetPrefix().data()), true);  // TODO percy avoid hardcoded string
 					const Uri entry(uri.getScheme(), uri.getAuthority(), path);
-					const FileStatus fileStatus(entry, FileType::FILE, s3Object.GetSize());
+					const FileStatus fileStatus(
+						entry, FileType::DIRECTORY, 0);  // TODO percy get info about the size of this kind of object
 					const bool pass = filter(fileStatus);
 
 					if(pass) {
 						response.push_back(fileStatus);
 					}
 				}
-			}
+			} else {  // if root is not '/' then we need to replace the uris to relative paths
+				const Aws::Vector<Aws::S3::Model::Object> objects = objectsOutcome.GetResult().GetContents();
+
+				for(auto const & s3Object : objects) {
+					// WARNING TODO percy there is no folders concept in S3 ... we should change Path::isFile::bool to
+					// Path::ObjectType::Unkwnow,DIR,FILE,SYMLIN,ETC
+					const Path fullPath("/" + std::string(s3Object.GetKey().data()), true);  // TODO percy avoid hardcoded string
 
-			const Aws::Vector<Aws::S3::Model::CommonPrefix> folders = objectsOutcome.GetResult().GetCommonPrefixes();
+					if(fullPath != folderPath) {
+						const Uri fullUri(uri.getScheme(), uri.getAuthority(), fullPath);
+						const FileStatus fullFileStatus(fullUri, FileType::FILE, s3Object.GetSize());
 
-			for(auto const & s3Folder : folders) {
-				// WARNING TODO percy there is no folders concept in S# ... we should change Path::isFile::bool to
-				// Path::ObjectType::Unkwnow,DIR,FILE,SYMLIN,ETC
-				const Path path("/" + std::string(s3Folder.GetPrefix().data()), true);  // TODO percy avoid hardcoded string
-				const Uri entry(uri.getScheme(), uri.getAuthority(), path);
-				const FileStatus fileStatus(
-					entry, FileType::DIRECTORY, 0);  // TODO percy get info about the size of this kind of object
-				const bool pass = filter(fileStatus);
+						const bool pass = filter(fullFileStatus);  // filter must use the full path
 
-				if(pass) {
-					response.push_back(fileStatus);
+						if(pass) {
+							const Path relativePath = fullPath.replaceParentPath(uriWithRoot.getPath(), uri.getPath());
+							const Uri relativeUri(uri.getScheme(), uri.getAuthority(), relativePath);
+							const FileStatus relativeFileStatus(
+								relativeUri, fullFileStatus.getFileType(), fullFileStatus.getFileSize());
+
+							response.push_back(relativeFileStatus);
+						}
+					}
 				}
-			}
-		} else {  // if root is not '/' then we need to replace the uris to relative paths
-			const Aws::Vector<Aws::S3::Model::Object> objects = objectsOutcome.GetResult().GetContents();
 
-			for(auto const & s3Object : objects) {
-				// WARNING TODO percy there is no folders concept in S3 ... we should change Path::isFile::bool to
-				// Path::ObjectType::Unkwnow,DIR,FILE,SYMLIN,ETC
-				const Path fullPath("/" + std::string(s3Object.GetKey().data()), true);  // TODO percy avoid hardcoded string
+				const Aws::Vector<Aws::S3::Model::CommonPrefix> folders = objectsOutcome.GetResult().GetCommonPrefixes();
 
-				if(fullPath != folderPath) {
+				for(auto const & s3Folder : folders) {
+					// WARNING TODO percy there is no folders concept in S# ... we should change Path::isFile::bool to
+					// Path::ObjectType::Unkwnow,DIR,FILE,SYMLIN,ETC
+					const Path fullPath("/" + std::string(s3Folder.GetPrefix().data()), true);  // TODO percy avoid hardcoded string
 					const Uri fullUri(uri.getScheme(), uri.getAuthority(), fullPath);
-					const FileStatus fullFileStatus(fullUri, FileType::FILE, s3Object.GetSize());
+					const FileStatus fullFileStatus(fullUri, FileType::DIRECTORY, 0);
 
 					const bool pass = filter(fullFileStatus);  // filter must use the full path
 
@@ -496,42 +529,23 @@ std::vector<FileStatus> S3FileSystem::Private::list(const Uri & uri, const FileF
 					}
 				}
 			}
-
-			const Aws::Vector<Aws::S3::Model::CommonPrefix> folders = objectsOutcome.GetResult().GetCommonPrefixes();
-
-			for(auto const & s3Folder : folders) {
-				// WARNING TODO percy there is no folders concept in S# ... we should change Path::isFile::bool to
-				// Path::ObjectType::Unkwnow,DIR,FILE,SYMLIN,ETC
-				const Path fullPath("/" + std::string(s3Folder.GetPrefix().data()), true);  // TODO percy avoid hardcoded string
-				const Uri fullUri(uri.getScheme(), uri.getAuthority(), fullPath);
-				const FileStatus fullFileStatus(fullUri, FileType::DIRECTORY, 0);
-
-				const bool pass = filter(fullFileStatus);  // filter must use the full path
-
-				if(pass) {
-					const Path relativePath = fullPath.replaceParentPath(uriWithRoot.getPath(), uri.getPath());
-					const Uri relativeUri(uri.getScheme(), uri.getAuthority(), relativePath);
-					const FileStatus relativeFileStatus(
-						relativeUri, fullFileStatus.getFileType(), fullFileStatus.getFileSize());
-
-					response.push_back(relativeFileStatus);
-				}
-			}
-		}
-	} else {
-		Logging::Logger().logError("S3FileSystem::Private::list failed for URI: " + uri.toString());
-		bool shouldRetry = objectsOutcome.GetError().ShouldRetry();
-		if(shouldRetry) {
-			Logging::Logger().logError(std::string(objectsOutcome.GetError().GetExceptionName().data()) + " : " +
-									   objectsOutcome.GetError().GetMessage().data() + "  SHOULD RETRY");
 		} else {
-			Logging::Logger().logError(std::string(objectsOutcome.GetError().GetExceptionName().data()) + " : " +
-									   objectsOutcome.GetError().GetMessage().data() + "  SHOULD NOT RETRY");
+			Logging::Logger().logError("S3FileSystem::Private::list failed for URI: " + uri.toString());
+			bool shouldRetry = objectsOutcome.GetError().ShouldRetry();
+			if(shouldRetry) {
+				Logging::Logger().logError(std::string(objectsOutcome.GetError().GetExceptionName().data()) + " : " +
+										   objectsOutcome.GetError().GetMessage().data() + "  SHOULD RETRY");
+			} else {
+				Logging::Logger().logError(std::string(objectsOutcome.GetError().GetExceptionName().data()) + " : " +
+										   objectsOutcome.GetError().GetMessage().data() + "  SHOULD NOT RETRY");
+			}
+			throw BlazingFileSystemException("Could not list files found at " + uriWithRoot.toString() + ". Problem was " +
+											 std::string(objectsOutcome.GetError().GetExceptionName().data()) + " : " +
+											 objectsOutcome.GetError().GetMessage().data());
 		}
-		throw BlazingFileSystemException("Could not list files found at " + uriWithRoot.toString() + ". Problem was " +
-										 std::string(objectsOutcome.GetError().GetExceptionName().data()) + " : " +
-										 objectsOutcome.GetError().GetMessage().data());
-	}
+		isTruncated = objectsOutcome.GetResult().GetIsTruncated();
+		request.SetContinuationToken(objectsOutcome.GetResult().GetNextContinuationToken());
+	} while(isTruncated);
 
 	return response;
 }
@@ -558,51 +572,72 @@ std::vector<Uri> S3FileSystem::Private::list(const Uri & uri, const std::string
 	request.WithDelimiter("/");  // NOTE percy since we control how to create files in S3 we should use this convention
 	request.WithPrefix(objectKey.data());
 
-	auto objectsOutcome = this->s3Client->ListObjectsV2(request);
-
-	if(objectsOutcome.IsSuccess()) {
-		const Path wildcardPath = uriWithRoot.getPath() + wildcard;
-		const std::string finalWildcard = wildcardPath.toString(true);
-
-		if(this->root.isRoot()) {  // if root is '/' then we don't need to replace the uris to relative paths
-			const Aws::Vector<Aws::S3::Model::Object> objects = objectsOutcome.GetResult().GetContents();
+	bool isTruncated = false;
+	do {
+		auto objectsOutcome = this->s3Client->ListObjectsV2(request);
+
+		if(objectsOutcome.IsSuccess()) {
+			this->rememberObjectSizes(objectsOutcome.GetResult().GetContents());
+			const Path wildcardPath = uriWithRoot.getPath() + wildcard;
+			const std::string finalWildcard = wildcardPath.toString(true);
+
+			if(this->root.isRoot()) {  // if root is '/' then we don't need to replace the uris to relative paths
+				const Aws::Vector<Aws::S3::Model::Object> objects = objectsOutcome.GetResult().GetContents();
+
+				for(auto const & s3Object : objects) {
+					// WARNING TODO percy there is no folders concept in S# ... we should change Path::isFile::bool to
+					// Path::ObjectType::Unkwnow,DIR,FILE,SYMLIN,ETC
+					const Path path("/" + std::string(s3Object.GetKey().data()), true);  // TODO percy avoid hardcoded string
+
+					if(path != folderPath) {
+						const bool pass = WildcardFilter::match(path.toString(true), finalWildcard);
+						if(pass) {
+							const Uri entry(uri.getScheme(), uri.getAuthority(), path);
+							response.push_back(entry);
+						}
+					}
+				}
 
-			for(auto const & s3Object : objects) {
-				// WARNING TODO percy there is no folders concept in S# ... we should change Path::isFile::bool to
-				// Path::ObjectType::Unkwnow,DIR,FILE,SYMLIN,ETC
-				const Path path("/" + std::string(s3Object.GetKey().data()), true);  // TODO percy avoid hardcoded string
+				const Aws::Vector<Aws::S3::Model::CommonPrefix> folders = objectsOutcome.GetResult().GetCommonPrefixes();
 
-				if(path != folderPath) {
+				for(auto const & s3Folder : folders) {
+					// WARNING TODO percy there is no folders concept in S# ... we should change Path::isFile::bool to
+					// Path::ObjectType::Unkwnow,DIR,FILE,SYMLIN,ETC
+					const Path path("/" + std::string(s3Folder.GetPrefix().data()), true);  // TODO percy avoid hardcoded string
 					const bool pass = WildcardFilter::match(path.toString(true), finalWildcard);
+
 					if(pass) {
 						const Uri entry(uri.getScheme(), uri.getAuthority(), path);
 						response.push_back(entry);
 					}
 				}
-			}
+			} else {  // if root is not '/' then we need to replace the uris to relative paths
+				const Aws::Vector<Aws::S3::Model::Object> objects = objectsOutcome.GetResult().GetContents();
 
-			const Aws::Vector<Aws::S3::Model::CommonPrefix> folders = objectsOutcome.GetResult().GetCommonPrefixes();
+				for(auto const & s3Object : objects) {
+					// WARNING TODO percy there is no folders concept in S# ... we should change Path::isFile::bool to
+					// Path::ObjectType::Unkwnow,DIR,FILE,SYMLIN,ETC
+					const Path fullPath("/" + std::string(s3Object.GetKey().data()), true);  // TODO percy avoid hardcoded string
 
-			for(auto const & s3Folder : folders) {
-				// WARNING TODO percy there is no folders concept in S# ... we should change Path::isFile::bool to
-				// Path::ObjectType::Unkwnow,DIR,FILE,SYMLIN,ETC
-				const Path path("/" + std::string(s3Folder.GetPrefix().data()), true);  // TODO percy avoid hardcoded string
-				const bool pass = WildcardFilter::match(path.toString(true), finalWildcard);
+					if(fullPath != folderPath) {
+						const bool pass =
+							WildcardFilter::match(fullPath.toString(true), finalWildcard);  // filter must use the full path
 
-				if(pass) {
-					const Uri entry(uri.getScheme(), uri.getAuthority(), path);
-					response.push_back(entry);
+						if(pass) {
+							const Path relativePath = fullPath.replaceParentPath(uriWithRoot.getPath(), uri.getPath());
+							const Uri relativeUri(uri.getScheme(), uri.getAuthority(), relativePath);
+
+							response.push_back(relativeUri);
+						}
+					}
 				}
-			}
-		} else {  // if root is not '/' then we need to replace the uris to relative paths
-			const Aws::Vector<Aws::S3::Model::Object> objects = objectsOutcome.GetResult().GetContents();
 
-			for(auto const & s3Object : objects) {
-				// WARNING TODO percy there is no folders concept in S# ... we should change Path::isFile::bool to
-				// Path::ObjectType::Unkwnow,DIR,FILE,SYMLIN,ETC
-				const Path fullPath("/" + std::string(s3Object.GetKey().data()), true);  // TODO percy avoid hardcoded string
+				const Aws::Vector<Aws::S3::Model::CommonPrefix> folders = objectsOutcome.GetResult().GetCommonPrefixes();
 
-				if(fullPath != folderPath) {
+				for(auto const & s3Folder : folders) {
+					// WARNING TODO percy there is no folders concept in S# ... we should change Path::isFile::bool to
+					// Path::ObjectType::Unkwnow,DIR,FILE,SYMLIN,ETC
+					const Path fullPath("/" + std::string(s3Folder.GetPrefix().data()), true);  // TODO percy avoid hardcoded string
 					const bool pass =
 						WildcardFilter::match(fullPath.toString(true), finalWildcard);  // filter must use the full path
 
@@ -614,38 +649,23 @@ std::vector<Uri> S3FileSystem::Private::list(const Uri & uri, const std::string
 					}
 				}
 			}
-
-			const Aws::Vector<Aws::S3::Model::CommonPrefix> folders = objectsOutcome.GetResult().GetCommonPrefixes();
-
-			for(auto const & s3Folder : folders) {
-				// WARNING TODO percy there is no folders concept in S# ... we should change Path::isFile::bool to
-				// Path::ObjectType::Unkwnow,DIR,FILE,SYMLIN,ETC
-				const Path fullPath("/" + std::string(s3Folder.GetPrefix().data()), true);  // TODO percy avoid hardcoded string
-				const bool pass =
-					WildcardFilter::match(fullPath.toString(true), finalWildcard);  // filter must use the full path
-
-				if(pass) {
-					const Path relativePath = fullPath.replaceParentPath(uriWithRoot.getPath(), uri.getPath());
-					const Uri relativeUri(uri.getScheme(), uri.getAuthority(), relativePath);
-
-					response.push_back(relativeUri);
-				}
-			}
-		}
-	} else {
-		Logging::Logger().logError("S3FileSystem::Private::list failed for URI: " + uri.toString());
-		bool shouldRetry = objectsOutcome.GetError().ShouldRetry();
-		if(shouldRetry) {
-			Logging::Logger().logError(std::string(objectsOutcome.GetError().GetExceptionName().data()) + " : " +
-									   objectsOutcome.GetError().GetMessage().data() + "  SHOULD RETRY");
 		} else {
-			Logging::Logger().logError(std::string(objectsOutcome.GetError().GetExceptionName().data()) + " : " +
-									   objectsOutcome.GetError().GetMessage().data() + "  SHOULD NOT RETRY");
+			Logging::Logger().logError("S3FileSystem::Private::list failed for URI: " + uri.toString());
+			bool shouldRetry = objectsOutcome.GetError().ShouldRetry();
+			if(shouldRetry) {
+				Logging::Logger().logError(std::string(objectsOutcome.GetError().GetExceptionName().data()) + " : " +
+										   objectsOutcome.GetError().GetMessage().data() + "  SHOULD RETRY");
+			} else {
+				Logging::Logger().logError(std::string(objectsOutcome.GetError().GetExceptionName().data()) + " : " +
+										   objectsOutcome.GetError().GetMessage().data() + "  SHOULD NOT RETRY");
+			}
+			throw BlazingFileSystemException("Could not list files found at " + uriWithRoot.toString() + ". Problem was " +
+											 std::string(objectsOutcome.GetError().GetExceptionName().data()) + " : " +
+											 objectsOutcome.GetError().GetMessage().data());
 		}
-		throw BlazingFileSystemException("Could not list files found at " + uriWithRoot.toString() + ". Problem was " +
-										 std::string(objectsOutcome.GetError().GetExceptionName().data()) + " : " +
-										 objectsOutcome.GetError().GetMessage().data());
-	}
+		isTruncated = objectsOutcome.GetResult().GetIsTruncated();
+		request.SetContinuationToken(objectsOutcome.GetResult().GetNextContinuationToken());
+	} while(isTruncated);
 
 	return response;
 }
@@ -673,109 +693,114 @@ std::vector<std::string> S3FileSystem::Private::listResourceNames(
 	request.WithDelimiter("/");  // NOTE percy since we control how to create files in S3 we should use this convention
 	request.WithPrefix(objectKey.data());
 
-	auto objectsOutcome = this->s3Client->ListObjectsV2(request);
+	bool isTruncated = false;
+	do {
+		auto objectsOutcome = this->s3Client->ListObjectsV2(request);
 
-	if(objectsOutcome.IsSuccess()) {
-		const Path wildcardPath = uriWithRoot.getPath() + wildcard;
-		const std::string finalWildcard = wildcardPath.toString(true);
-		const FileTypeWildcardFilter filter(fileType, finalWildcard);
+		if(objectsOutcome.IsSuccess()) {
+			const Path wildcardPath = uriWithRoot.getPath() + wildcard;
+			const std::string finalWildcard = wildcardPath.toString(true);
+			const FileTypeWildcardFilter filter(fileType, finalWildcard);
 
-		if(this->root.isRoot()) {  // if root is '/' then we don't need to replace the uris to relative paths
-			const Aws::Vector<Aws::S3::Model::Object> objects = objectsOutcome.GetResult().GetContents();
+			if(this->root.isRoot()) {  // if root is '/' then we don't need to replace the uris to relative paths
+				const Aws::Vector<Aws::S3::Model::Object> objects = objectsOutcome.GetResult().GetContents();
 
-			for(auto const & s3Object : objects) {
-				// WARNING TODO percy there is no folders concept in S# ... we should change Path::isFile::bool to
-				// Path::ObjectType::Unkwnow,DIR,FILE,SYMLIN,ETC
-				const Path path("/" + std::string(s3Object.GetKey().data()), true);  // TODO percy avoid hardcoded string
+				for(auto const & s3Object : objects) {
+					// WARNING TODO percy there is no folders concept in S# ... we should change Path::isFile::bool to
+					// Path::ObjectType::Unkwnow,DIR,FILE,SYMLIN,ETC
+					const Path path("/" + std::string(s3Object.GetKey().data()), true);  // TODO percy avoid hardcoded string
 
-				if(path != folderPath) {
-					const Uri entry(uri.getScheme(), uri.getAuthority(), path);
-					const FileStatus fileStatus(entry, FileType::FILE, s3Object.GetSize());
-					const bool pass = filter(fileStatus);
+					if(path != folderPath) {
+						const Uri entry(uri.getScheme(), uri.getAuthority(), path);
+						const FileStatus fileStatus(entry, FileType::FILE, s3Object.GetSize());
+						const bool pass = filter(fileStatus);
 
-					if(pass) {
-						response.push_back(fileStatus.getUri().getPath().getResourceName());
+						if(pass) {
+							response.push_back(fileStatus.getUri().getPath().getResourceName());
+						}
 					}
 				}
-			}
 
-			const Aws::Vector<Aws::S3::Model::CommonPrefix> folders = objectsOutcome.GetResult().GetCommonPrefixes();
+				const Aws::Vector<Aws::S3::Model::CommonPrefix> folders = objectsOutcome.GetResult().GetCommonPrefixes();
 
-			for(auto const & s3Folder : folders) {
-				// WARNING TODO percy there is no folders concept in S# ... we should change Path::isFile::bool to
-				// Path::ObjectType::Unkwnow,DIR,FILE,SYMLIN,ETC
-				const Path path("/" + std::string(s3Folder.GetPrefix().data()), true);  // TODO percy avoid hardcoded string
+				for(auto const & s3Folder : folders) {
+					// WARNING TODO percy there is no folders concept in S# ... we should change Path::isFile::bool to
+					// Path::ObjectType::Unkwnow,DIR,FILE,SYMLIN,ETC
+					const Path path("/" + std::string(s3Folder.GetPrefix().data()), true);  // TODO percy avoid hardcoded string
 
-				if(path != folderPath) {
-					const Uri entry(uri.getScheme(), uri.getAuthority(), path);
-					const FileStatus fileStatus(
-						entry, FileType::DIRECTORY, 0);  // TODO percy get info about the size of this kind of object
-					const bool pass = filter(fileStatus);
+					if(path != folderPath) {
+						const Uri entry(uri.getScheme(), uri.getAuthority(), path);
+						const FileStatus fileStatus(
+							entry, FileType::DIRECTORY, 0);  // TODO percy get info about the size of this kind of object
+						const bool pass = filter(fileStatus);
 
-					if(pass) {
-						response.push_back(fileStatus.getUri().getPath().getResourceName());
+						if(pass) {
+							response.push_back(fileStatus.getUri().getPath().getResourceName());
+						}
 					}
 				}
-			}
-		} else {  // if root is not '/' then we need to replace the uris to relative paths
-			const Aws::Vector<Aws::S3::Model::Object> objects = objectsOutcome.GetResult().GetContents();
-
-			for(auto const & s3Object : objects) {
-				// WARNING TODO percy there is no folders concept in S# ... we should change Path::isFile::bool to
-				// Path::ObjectType::Unkwnow,DIR,FILE,SYMLIN,ETC
-				const Path fullPath("/" + std::string(s3Object.GetKey().data()), true);  // TODO percy avoid hardcoded string
-
-				if(fullPath != folderPath) {
-					const Uri fullUri(uri.getScheme(), uri.getAuthority(), fullPath);
-					const FileStatus fullFileStatus(fullUri, FileType::FILE, s3Object.GetSize());
-
-					const bool pass = filter(fullFileStatus);  // filter must use the full path
-
-					if(pass) {
-						response.push_back(
-							fullFileStatus.getUri()
-								.getPath()
-								.getResourceName());  // resource name is the same for full paths or relative paths
+			} else {  // if root is not '/' then we need to replace the uris to relative paths
+				const Aws::Vector<Aws::S3::Model::Object> objects = objectsOutcome.GetResult().GetContents();
+
+				for(auto const & s3Object : objects) {
+					// WARNING TODO percy there is no folders concept in S# ... we should change Path::isFile::bool to
+					// Path::ObjectType::Unkwnow,DIR,FILE,SYMLIN,ETC
+					const Path fullPath("/" + std::string(s3Object.GetKey().data()), true);  // TODO percy avoid hardcoded string
+
+					if(fullPath != folderPath) {
+						const Uri fullUri(uri.getScheme(), uri.getAuthority(), fullPath);
+						const FileStatus fullFileStatus(fullUri, FileType::FILE, s3Object.GetSize());
+
+						const bool pass = filter(fullFileStatus);  // filter must use the full path
+
+						if(pass) {
+							response.push_back(
+								fullFileStatus.getUri()
+									.getPath()
+									.getResourceName());  // resource name is the same for full paths or relative paths
+						}
 					}
 				}
-			}
-
-			const Aws::Vector<Aws::S3::Model::CommonPrefix> folders = objectsOutcome.GetResult().GetCommonPrefixes();
 
-			for(auto const & s3Folder : folders) {
-				// WARNING TODO percy there is no folders concept in S# ... we should change Path::isFile::bool to
-				// Path::ObjectType::Unkwnow,DIR,FILE,SYMLIN,ETC
-				const Path fullPath("/" + std::string(s3Folder.GetPrefix().data()), true);  // TODO percy avoid hardcoded string
-
-				if(fullPath != folderPath) {
-					const Uri fullUri(uri.getScheme(), uri.getAuthority(), fullPath);
-					const FileStatus fullFileStatus(
-						fullUri, FileType::DIRECTORY, 0);  // TODO percy get info about the size of this kind of object
-					const bool pass = filter(fullFileStatus);
-
-					if(pass) {
-						response.push_back(
-							fullFileStatus.getUri()
-								.getPath()
-								.getResourceName());  // resource name is the same for full paths or relative paths
+				const Aws::Vector<Aws::S3::Model::CommonPrefix> folders = objectsOutcome.GetResult().GetCommonPrefixes();
+
+				for(auto const & s3Folder : folders) {
+					// WARNING TODO percy there is no folders concept in S# ... we should change Path::isFile::bool to
+					// Path::ObjectType::Unkwnow,DIR,FILE,SYMLIN,ETC
+					const Path fullPath("/" + std::string(s3Folder.GetPrefix().data()), true);  // TODO percy avoid hardcoded string
+
+					if(fullPath != folderPath) {
+						const Uri fullUri(uri.getScheme(), uri.getAuthority(), fullPath);
+						const FileStatus fullFileStatus(
+							fullUri, FileType::DIRECTORY, 0);  // TODO percy get info about the size of this kind of object
+						const bool pass = filter(fullFileStatus);
+
+						if(pass) {
+							response.push_back(
+								fullFileStatus.getUri()
+									.getPath()
+									.getResourceName());  // resource name is the same for full paths or relative paths
+						}
 					}
 				}
 			}
-		}
-	} else {
-		Logging::Logger().logError("S3FileSystem::Private::listResourceNames failed for URI: " + uri.toString());
-		bool shouldRetry = objectsOutcome.GetError().ShouldRetry();
-		if(shouldRetry) {
-			Logging::Logger().logError(std::string(objectsOutcome.GetError().GetExceptionName().data()) + " : " +
-									   objectsOutcome.GetError().GetMessage().data() + "  SHOULD RETRY");
 		} else {
-			Logging::Logger().logError(std::string(objectsOutcome.GetError().GetExceptionName().data()) + " : " +
-									   objectsOutcome.GetError().GetMessage().data() + "  SHOULD NOT RETRY");
+			Logging::Logger().logError("S3FileSystem::Private::listResourceNames failed for URI: " + uri.toString());
+			bool shouldRetry = objectsOutcome.GetError().ShouldRetry();
+			if(shouldRetry) {
+				Logging::Logger().logError(std::string(objectsOutcome.GetError().GetExceptionName().data()) + " : " +
+										   objectsOutcome.GetError().GetMessage().data() + "  SHOULD RETRY");
+			} else {
+				Logging::Logger().logError(std::string(objectsOutcome.GetError().GetExceptionName().data()) + " : " +
+										   objectsOutcome.GetError().GetMessage().data() + "  SHOULD NOT RETRY");
+			}
+			throw BlazingFileSystemException("Could not list resources found at " + uriWithRoot.toString() +
+											 ". Problem was " + std::string(objectsOutcome.GetError().GetExceptionName().data()) + " : " +
+											 objectsOutcome.GetError().GetMessage().data());
 		}
-		throw BlazingFileSystemException("Could not list resources found at " + uriWithRoot.toString() +
-										 ". Problem was " + std::string(objectsOutcome.GetError().GetExceptionName().data()) + " : " +
-										 objectsOutcome.GetError().GetMessage().data());
-	}
+		isTruncated = objectsOutcome.GetResult().GetIsTruncated();
+		request.SetContinuationToken(objectsOutcome.GetResult().GetNextContinuationToken());
+	} while(isTruncated);
 
 	return response;
 }
@@ -802,101 +827,106 @@ std::vector<std::string> S3FileSystem::Private::listResourceNames(const Uri & ur
 	request.WithDelimiter("/");  // NOTE percy since we control how to create files in S3 we should use this convention
 	request.WithPrefix(objectKey.data());
 
-	auto objectsOutcome = this->s3Client->ListObjectsV2(request);
+	bool isTruncated = false;
+	do {
+		auto objectsOutcome = this->s3Client->ListObjectsV2(request);
 
-	if(objectsOutcome.IsSuccess()) {
-		const Path wildcardPath = uriWithRoot.getPath() + wildcard;
-		const std::string finalWildcard = wildcardPath.toString(true);
+		if(objectsOutcome.IsSuccess()) {
+			const Path wildcardPath = uriWithRoot.getPath() + wildcard;
+			const std::string finalWildcard = wildcardPath.toString(true);
 
-		if(this->root.isRoot()) {  // if root is '/' then we don't need to replace the uris to relative paths
-			Aws::Vector<Aws::S3::Model::Object> objects = objectsOutcome.GetResult().GetContents();
+			if(this->root.isRoot()) {  // if root is '/' then we don't need to replace the uris to relative paths
+				Aws::Vector<Aws::S3::Model::Object> objects = objectsOutcome.GetResult().GetContents();
 
-			for(auto const & s3Object : objects) {
-				// WARNING TODO percy there is no folders concept in S# ... we should change Path::isFile::bool to
-				// Path::ObjectType::Unkwnow,DIR,FILE,SYMLIN,ETC
-				const Path path("/" + std::string(s3Object.GetKey().data()), true);  // TODO percy avoid hardcoded string
+				for(auto const & s3Object : objects) {
+					// WARNING TODO percy there is no folders concept in S# ... we should change Path::isFile::bool to
+					// Path::ObjectType::Unkwnow,DIR,FILE,SYMLIN,ETC
+					const Path path("/" + std::string(s3Object.GetKey().data()), true);  // TODO percy avoid hardcoded string
 
-				if(path != folderPath) {
-					const Uri entry(uri.getScheme(), uri.getAuthority(), path);
-					const bool pass = WildcardFilter::match(uri.toString(true), finalWildcard);
+					if(path != folderPath) {
+						const Uri entry(uri.getScheme(), uri.getAuthority(), path);
+						const bool pass = WildcardFilter::match(uri.toString(true), finalWildcard);
 
-					if(pass) {
-						response.push_back(entry.getPath().getResourceName());
+						if(pass) {
+							response.push_back(entry.getPath().getResourceName());
+						}
 					}
 				}
-			}
 
-			Aws::Vector<Aws::S3::Model::CommonPrefix> folders = objectsOutcome.GetResult().GetCommonPrefixes();
+				Aws::Vector<Aws::S3::Model::CommonPrefix> folders = objectsOutcome.GetResult().GetCommonPrefixes();
 
-			for(auto const & s3Folder : folders) {
-				// WARNING TODO percy there is no folders concept in S# ... we should change Path::isFile::bool to
-				// Path::ObjectType::Unkwnow,DIR,FILE,SYMLIN,ETC
-				const Path path("/" + std::string(s3Folder.GetPrefix().data()), true);  // TODO percy avoid hardcoded string
+				for(auto const & s3Folder : folders) {
+					// WARNING TODO percy there is no folders concept in S# ... we should change Path::isFile::bool to
+					// Path::ObjectType::Unkwnow,DIR,FILE,SYMLIN,ETC
+					const Path path("/" + std::string(s3Folder.GetPrefix().data()), true);  // TODO percy avoid hardcoded string
 
-				if(path != folderPath) {
-					const Uri entry(uri.getScheme(), uri.getAuthority(), path);
-					const bool pass = WildcardFilter::match(uri.toString(true), finalWildcard);
+					if(path != folderPath) {
+						const Uri entry(uri.getScheme(), uri.getAuthority(), path);
+						const bool pass = WildcardFilter::match(uri.toString(true), finalWildcard);
 
-					if(pass) {
-						response.push_back(entry.getPath().getResourceName());
+						if(pass) {
+							response.push_back(entry.getPath().getResourceName());
+						}
 					}
 				}
-			}
-		} else {  // if root is not '/' then we need to replace the uris to relative paths
-			Aws::Vector<Aws::S3::Model::Object> objects = objectsOutcome.GetResult().GetContents();
-
-			for(auto const & s3Object : objects) {
-				// WARNING TODO percy there is no folders concept in S# ... we should change Path::isFile::bool to
-				// Path::ObjectType::Unkwnow,DIR,FILE,SYMLIN,ETC
-				const Path fullPath("/" + std::string(s3Object.GetKey().data()), true);  // TODO percy avoid hardcoded string
-
-				if(fullPath != folderPath) {
-					const Uri fullUri(uri.getScheme(), uri.getAuthority(), fullPath);
-					const bool pass =
-						WildcardFilter::match(fullUri.toString(true), finalWildcard);  // filter must use the full path
-
-					if(pass) {
-						response.push_back(
-							fullUri.getPath()
-								.getResourceName());  // resource name is the same for full paths or relative paths
+			} else {  // if root is not '/' then we need to replace the uris to relative paths
+				Aws::Vector<Aws::S3::Model::Object> objects = objectsOutcome.GetResult().GetContents();
+
+				for(auto const & s3Object : objects) {
+					// WARNING TODO percy there is no folders concept in S# ... we should change Path::isFile::bool to
+					// Path::ObjectType::Unkwnow,DIR,FILE,SYMLIN,ETC
+					const Path fullPath("/" + std::string(s3Object.GetKey().data()), true);  // TODO percy avoid hardcoded string
+
+					if(fullPath != folderPath) {
+						const Uri fullUri(uri.getScheme(), uri.getAuthority(), fullPath);
+						const bool pass =
+							WildcardFilter::match(fullUri.toString(true), finalWildcard);  // filter must use the full path
+
+						if(pass) {
+							response.push_back(
+								fullUri.getPath()
+									.getResourceName());  // resource name is the same for full paths or relative paths
+						}
 					}
 				}
-			}
 
-			Aws::Vector<Aws::S3::Model::CommonPrefix> folders = objectsOutcome.GetResult().GetCommonPrefixes();
+				Aws::Vector<Aws::S3::Model::CommonPrefix> folders = objectsOutcome.GetResult().GetCommonPrefixes();
 
-			for(auto const & s3Folder : folders) {
-				// WARNING TODO percy there is no folders concept in S# ... we should change Path::isFile::bool to
-				// Path::ObjectType::Unkwnow,DIR,FILE,SYMLIN,ETC
-				const Path fullPath("/" + std::string(s3Folder.GetPrefix().data()), true);  // TODO percy avoid hardcoded string
+				for(auto const & s3Folder : folders) {
+					// WARNING TODO percy there is no folders concept in S# ... we should change Path::isFile::bool to
+					// Path::ObjectType::Unkwnow,DIR,FILE,SYMLIN,ETC
+					const Path fullPath("/" + std::string(s3Folder.GetPrefix().data()), true);  // TODO percy avoid hardcoded string
 
-				if(fullPath != folderPath) {
-					const Uri fullUri(uri.getScheme(), uri.getAuthority(), fullPath);
-					const bool pass =
-						WildcardFilter::match(fullUri.toString(true), finalWildcard);  // filter must use the full path
+					if(fullPath != folderPath) {
+						const Uri fullUri(uri.getScheme(), uri.getAuthority(), fullPath);
+						const bool pass =
+							WildcardFilter::match(fullUri.toString(true), finalWildcard);  // filter must use the full path
 
-					if(pass) {
-						response.push_back(
-							fullUri.getPath()
-								.getResourceName());  // resource name is the same for full paths or relative paths
+						if(pass) {
+							response.push_back(
+								fullUri.getPath()
+									.getResourceName());  // resource name is the same for full paths or relative paths
+						}
 					}
 				}
 			}
-		}
-	} else {
-		Logging::Logger().logError("S3FileSystem::Private::listResourceNames failed for URI: " + uri.toString());
-		bool shouldRetry = objectsOutcome.GetError().ShouldRetry();
-		if(shouldRetry) {
-			Logging::Logger().logError(std::string(objectsOutcome.GetError().GetExceptionName().data()) + " : " +
-									   objectsOutcome.GetError().GetMessage().data() + "  SHOULD RETRY");
 		} else {
-			Logging::Logger().logError(std::string(objectsOutcome.GetError().GetExceptionName().data()) + " : " +
-									   objectsOutcome.GetError().GetMessage().data() + "  SHOULD NOT RETRY");
+			Logging::Logger().logError("S3FileSystem::Private::listResourceNames failed for URI: " + uri.toString());
+			bool shouldRetry = objectsOutcome.GetError().ShouldRetry();
+			if(shouldRetry) {
+				Logging::Logger().logError(std::string(objectsOutcome.GetError().GetExceptionName().data()) + " : " +
+										   objectsOutcome.GetError().GetMessage().data() + "  SHOULD RETRY");
+			} else {
+				Logging::Logger().logError(std::string(objectsOutcome.GetError().GetExceptionName().data()) + " : " +
+										   objectsOutcome.GetError().GetMessage().data() + "  SHOULD NOT RETRY");
+			}
+			throw BlazingFileSystemException("Could not list resources found at " + uriWithRoot.toString() +
+											 ". Problem was " + std::string(objectsOutcome.GetError().GetExceptionName().data()) + " : " +
+											 objectsOutcome.GetError().GetMessage().data());
 		}
-		throw BlazingFileSystemException("Could not list resources found at " + uriWithRoot.toString() +
-										 ". Problem was " + std::string(objectsOutcome.GetError().GetExceptionName().data()) + " : " +
-										 objectsOutcome.GetError().GetMessage().data());
-	}
+		isTruncated = objectsOutcome.GetResult().GetIsTruncated();
+		request.SetContinuationToken(objectsOutcome.GetResult().GetNextContinuationToken());
+	} while(isTruncated);
 
 	return response;
 }
@@ -1150,8 +1180,10 @@ bool S3FileSystem::Private::openReadable(const Uri & uri, std::shared_ptr<S3Read
 	const Path path = uriWithRoot.getPath();
 	const std::string objectKey = path.toString(true).substr(1, path.toString(true).size());
 	const std::string bucketName = this->getBucketName();
+	// the size of the object is taken from its listing when there was one, instead of a HEAD request
+	const int64_t size = ObjectStoreConfig::getInstance().getObjectSize("s3://" + bucketName + "/" + objectKey);
 	// TODO: S3ReadableFile currentl has no validity check add it and throw errors here
-	*file = std::make_shared<S3ReadableFile>(this->s3Client, bucketName, objectKey);
+	*file = std::make_shared<S3ReadableFile>(this->s3Client, bucketName, objectKey, size);
 	return (*file)->isValid();
 }
 
@@ -1170,6 +1202,14 @@ bool S3FileSystem::Private::openWriteable(const Uri & uri, std::shared_ptr<S3Out
 	return true;
 }
 
+void S3FileSystem::Private::rememberObjectSizes(const Aws::Vector<Aws::S3::Model::Object> & objects) const {
+	const std::string bucket = this->getBucketName();
+	for(auto const & s3Object : objects) {
+		ObjectStoreConfig::getInstance().rememberObjectSize(
+			"s3://" + bucket + "/" + std::string(s3Object.GetKey().data()), s3Object.GetSize());
+	}
+}
+
 const std::string S3FileSystem::Private::getBucketName() const {
 	using namespace S3FileSystemConnection;
 	return this->fileSystemConnection.getConnectionProperty(ConnectionProperty::BUCKET_NAME);
@@ -7,6 +7,7 @@
 #define _S3_FILE_SYSTEM_PRIVATE_H_
 
 #include "aws/s3/S3Client.h"
+#include <aws/s3/model/Object.h>
 
 #include "S3OutputStream.h"
 #include "S3ReadableFile.h"
@@ -52,6 +53,8 @@ private:
 	bool disconnect();
 
 	const std::string getBucketName() const;  // get the bucket name from the current s3 file system connection
+	// remembers the sizes of the objects of a listing, for the files that are opened after it
+	void rememberObjectSizes(const Aws::Vector<Aws::S3::Model::Object> & objects) const;
 	bool checkBucket() const;
 	S3FileSystemConnection::EncryptionType
 	encryptionType() const;	// get the encryption type from the current s3 file system connection
@@ -22,6 +22,7 @@
 #include <aws/s3/model/BucketLocationConstraint.h>
 #include <aws/s3/model/GetBucketLocationRequest.h>
 
+#include <aws/s3/model/AbortMultipartUploadRequest.h>
 #include <aws/s3/model/CompleteMultipartUploadRequest.h>
 #include <aws/s3/model/CreateMultipartUploadRequest.h>
 #include <aws/s3/model/Object.h>
@@ -31,8 +32,15 @@
 #include <aws/s3/model/UploadPartRequest.h>
 
 #include "arrow/buffer.h"
+#include <algorithm>
+#include <deque>
+#include <future>
 #include <istream>
+#include <mutex>
 #include <streambuf>
+#include <vector>
+
+#include "FileSystem/ObjectUploadConfig.h"
 
 #include "ExceptionHandling/BlazingException.h"
 
@@ -41,9 +49,11 @@ namespace Logging = Library::Logging;
 
 // TODO: handle the situation when not all data is read
 const Aws::String FAILED_UPLOAD = "failed-upload";
+// every part of a multipart upload but the last one must have at least 5 MiB
+const int64_t MIN_PART_SIZE = 5 * 1024 * 1024;
 class S3OutputStream::S3OutputStreamImpl {
 public:
-	//~S3OutputStreamImpl();
+	~S3OutputStreamImpl();
 	S3OutputStreamImpl(
 		const std::string & bucketName, const std::string & objectKey, std::shared_ptr<Aws::S3::S3Client> s3Client);
 
@@ -52,17 +62,32 @@ public:
 	arrow::Status write(const void * buffer, int64_t nbytes, int64_t * bytes_written);
 	arrow::Status flush();
     arrow::Result<int64_t> tell() const;
+	bool closed() const;
 
 private:
+	arrow::Status upload_part(int partNumber, const char * buffer, int64_t nbytes);
+	arrow::Status start_part_upload();
+	arrow::Status wait_for_part_uploads(size_t maxPending);
+	void abort();
+
 	std::shared_ptr<Aws::S3::S3Client> s3Client;
 	std::string bucket;
 	std::string key;
 
 	Aws::String uploadId;
 
+	std::mutex partsMutex;
 	Aws::Vector<Aws::S3::Model::CompletedPart> completedParts;  // just an etag (for response) and a part number
-	size_t currentPart;
+	int currentPart;
 	int64_t written;
+	int64_t partSize;
+	size_t maxConcurrentParts;
+	std::shared_ptr<char> part_buffer;  // the bytes of the next part, uploaded once it has partSize
+	int64_t part_buffer_size;
+	arrow::Status status;  // the first error of the part uploads
+	bool is_closed;
+	// the parts being uploaded, destroyed (and so waited for) before the members above that they use
+	std::deque<std::future<arrow::Status>> uploads;
 };
 
 struct membuf : std::streambuf {
@@ -85,6 +110,10 @@ S3OutputStream::S3OutputStreamImpl::S3OutputStreamImpl(
 
 	currentPart = 1;
 	written = 0;
+	is_closed = false;
+	partSize = std::max(ObjectUploadConfig::getInstance().getPartSize(), MIN_PART_SIZE);
+	maxConcurrentParts = ObjectUploadConfig::getInstance().getMaxConcurrentParts();
+	part_buffer_size = 0;
 
 	Aws::S3::Model::CreateMultipartUploadRequest request;
 	request.SetBucket(bucket.data());
@@ -113,54 +142,135 @@ S3OutputStream::S3OutputStreamImpl::S3OutputStreamImpl(
 	// start upload here
 }
 
-arrow::Status S3OutputStream::S3OutputStreamImpl::write(const void * buffer, int64_t nbytes) {
+S3OutputStream::S3OutputStreamImpl::~S3OutputStreamImpl() {
+	// a stream that was never closed leaves no parts behind, as S3 keeps (and bills) them until the upload is aborted
+	if(!is_closed) {
+		wait_for_part_uploads(0);
+		abort();
+	}
+}
+
+arrow::Status S3OutputStream::S3OutputStreamImpl::upload_part(int partNumber, const char * buffer, int64_t nbytes) {
 	Aws::S3::Model::UploadPartRequest uploadPartRequest;
 	uploadPartRequest.SetBucket(bucket.data());
 	uploadPartRequest.SetKey(key.data());
-	uploadPartRequest.SetPartNumber(currentPart);
+	uploadPartRequest.SetPartNumber(partNumber);
 	uploadPartRequest.SetUploadId(uploadId);
-	// char * tempBuffer = (char *) buffer;
-
-	// std::shared_ptr<imemstream> membuffer =  std::make_shared<imemstream>(new );
-	//   imemstream membuffer((char *) buffer,nbytes);
-
-	//    std::shared_ptr<imemstream> memBufferPtr
 	uploadPartRequest.SetBody(std::make_shared<imemstream>((char *) buffer, nbytes));
 
 	// uploadPart1Request.SetContentMD5(HashingUtils::Base64Encode(md5OfStream));
 
 	uploadPartRequest.SetContentLength(nbytes);
 
-	written += nbytes;
 	Aws::S3::Model::UploadPartOutcome uploadOutcome = s3Client->UploadPart(uploadPartRequest);
 	if(uploadOutcome.IsSuccess()) {
 		Aws::S3::Model::CompletedPart completedPart;
 		completedPart.SetETag(uploadOutcome.GetResult().GetETag());
-		completedPart.SetPartNumber(currentPart);
+		completedPart.SetPartNumber(partNumber);
+		std::lock_guard<std::mutex> lock(partsMutex);
 		this->completedParts.push_back(completedPart);
-		currentPart++;
 		return arrow::Status::OK();
 	} else {
-		Logging::Logger().logError("In Write: Uploading part " + std::to_string(currentPart) + " on file " +
+		Logging::Logger().logError("In Write: Uploading part " + std::to_string(partNumber) + " on file " +
 								   this->bucket + "/" + key + ". Problem was " +
 								   std::string(uploadOutcome.GetError().GetExceptionName().data()) + " : " +
 								   uploadOutcome.GetError().GetMessage().data());
-		return arrow::Status::IOError("Had a trouble uploading part " + std::to_string(currentPart) + " on file " +
+		return arrow::Status::IOError("Had a trouble uploading part " + std::to_string(partNumber) + " on file " +
 									  this->bucket + "/" + key + ". Problem was " +
 									  std::string(uploadOutcome.GetError().GetExceptionName().data()) + " : " +
 									  uploadOutcome.GetError().GetMessage().data());
 	}
 }
 
+arrow::Status S3OutputStream::S3OutputStreamImpl::wait_for_part_uploads(size_t maxPending) {
+	while(uploads.size() > maxPending) {
+		arrow::Status uploadStatus = uploads.front().get();
+		uploads.pop_front();
+		if(status.ok() && !uploadStatus.ok()) {
+			status = uploadStatus;
+		}
+	}
+	return status;
+}
+
+arrow::Status S3OutputStream::S3OutputStreamImpl::start_part_upload() {
+	// the writer only blocks when maxConcurrentParts parts are already being uploaded
+	ARROW_RETURN_NOT_OK(wait_for_part_uploads(maxConcurrentParts - 1));
+
+	int partNumber = currentPart++;
+	std::shared_ptr<char> buffer = std::move(part_buffer);
+	int64_t nbytes = part_buffer_size;
+	part_buffer_size = 0;
+	uploads.push_back(std::async(std::launch::async, [this, partNumber, buffer, nbytes]() {
+		return this->upload_part(partNumber, buffer.get(), nbytes);
+	}));
+	return arrow::Status::OK();
+}
+
+arrow::Status S3OutputStream::S3OutputStreamImpl::write(const void * buffer, int64_t nbytes) {
+	// the writes are gathered into parts of partSize, which are uploaded in the background while the next one is filled
+	ARROW_RETURN_NOT_OK(status);
+	written += nbytes;
+	const char * data = (const char *) buffer;
+	while(nbytes > 0) {
+		if(part_buffer == nullptr) {
+			part_buffer = ObjectUploadConfig::getInstance().allocate(partSize);
+		}
+		int64_t size = std::min(nbytes, partSize - part_buffer_size);
+		memcpy(part_buffer.get() + part_buffer_size, data, size);
+		part_buffer_size += size;
+		data += size;
+		nbytes -= size;
+		if(part_buffer_size == partSize) {
+			ARROW_RETURN_NOT_OK(start_part_upload());
+		}
+	}
+	return arrow::Status::OK();
+}
+
 arrow::Status S3OutputStream::S3OutputStreamImpl::flush() {
 	// flush is a pass through in all reality
-	// we are making each write send the contents for now for simplicity of design
+	// the parts are only uploaded once they have partSize, as S3 rejects the ones smaller than MIN_PART_SIZE
 	return arrow::Status::OK();
 }
 
+void S3OutputStream::S3OutputStreamImpl::abort() {
+	Aws::S3::Model::AbortMultipartUploadRequest abortRequest;
+	abortRequest.SetBucket(bucket.data());
+	abortRequest.SetKey(key.data());
+	abortRequest.SetUploadId(uploadId);
+	Aws::S3::Model::AbortMultipartUploadOutcome abortOutcome = s3Client->AbortMultipartUpload(abortRequest);
+	if(!abortOutcome.IsSuccess()) {
+		Logging::Logger().logError("In aborting the upload of " + this->bucket + "/" + key + ". Problem was " +
+								   std::string(abortOutcome.GetError().GetExceptionName().data()) + " : " +
+								   abortOutcome.GetError().GetMessage().data());
+	}
+}
+
 arrow::Status S3OutputStream::S3OutputStreamImpl::close() {
-	// flush the buffer
-	flush();
+	if(is_closed) {
+		return status;
+	}
+	is_closed = true;
+	// the last part can be smaller than MIN_PART_SIZE, and an empty file is a single empty part
+	if(status.ok() && (part_buffer_size > 0 || currentPart == 1)) {
+		if(part_buffer == nullptr) {
+			part_buffer = ObjectUploadConfig::getInstance().allocate(0);
+		}
+		start_part_upload();
+	}
+	wait_for_part_uploads(0);
+	if(!status.ok()) {
+		abort();
+		return status;
+	}
+
+	// the parts finish in any order, but S3 wants them by part number
+	std::sort(completedParts.begin(), completedParts.end(),
+		[](const Aws::S3::Model::CompletedPart & a, const Aws::S3::Model::CompletedPart & b) {
+			return a.GetPartNumber() < b.GetPartNumber();
+		});
+
 	Aws::S3::Model::CompleteMultipartUploadRequest completeMultipartUploadRequest;
 
 	completeMultipartUploadRequest.SetBucket(bucket.data());
@@ -179,17 +289,20 @@ arrow::Status S3OutputStream::S3OutputStreamImpl::close() {
 		Logging::Logger().logError("In closing outputstream. Problem was " +
 								   std::string(completeMultipartUploadOutcome.GetError().GetExceptionName().data()) + " : " +
 								   std::string(completeMultipartUploadOutcome.GetError().GetMessage().data()));
-		return arrow::Status::IOError("Error closing outputstream. Problem was " +
+		status = arrow::Status::IOError("Error closing outputstream. Problem was " +
 									  std::string(completeMultipartUploadOutcome.GetError().GetExceptionName().data()) + " : " +
 									  completeMultipartUploadOutcome.GetError().GetMessage().data());
+		abort();
+		return status;
 	}
-	//	s3Client->CompleteMultipartUpload(uploadCompleteRequest);
 }
 
 arrow::Result<int64_t> S3OutputStream::S3OutputStreamImpl::tell() const { 
     return written;
 }
 
+bool S3OutputStream::S3OutputStreamImpl::closed() const { return is_closed; }
+
 // BEGIN S3OutputStream
 
 S3OutputStream::S3OutputStream(
@@ -208,11 +321,6 @@ arrow::Result<int64_t> S3OutputStream::Tell() const {
     return this->impl_->tell();
 }
 
-bool S3OutputStream::closed() const {
-	// Since every file interaction is a request, then the file is never really open. This function is necesary due to
-	// the Apache Arrow interface starting with v12. Depending on who or what uses this function, we may want this to
-	// always return false??
-	return true;
-}
+bool S3OutputStream::closed() const { return this->impl_->closed(); }
 
 // END S3OutputStream
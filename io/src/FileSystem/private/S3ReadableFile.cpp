@@ -11,12 +11,14 @@
 #include "aws/s3/model/HeadObjectRequest.h"
 #include <aws/core/Aws.h>
 #include <aws/s3/model/GetObjectRequest.h>
+#include <algorithm>
 #include <istream>
 #include <streambuf>
 
 #include "arrow/buffer.h"
 #include <arrow/memory_pool.h>
 
+#include "FileSystem/RemoteFileCache.h"
 #include "Util/StringUtil.h"
 
 #include "Library/Logging/Logger.h"
@@ -24,17 +26,36 @@ namespace Logging = Library::Logging;
 
 // TODO: handle the situation when not all data is read
 
+namespace {
+
+// the planned ranges closer than this are fetched with one request, since a round trip costs more than reading the hole
+const int64_t COALESCE_HOLE_SIZE_LIMIT = 1024 * 1024;
+const int64_t COALESCE_RANGE_SIZE_LIMIT = 64 * 1024 * 1024;
+
+// the ranges of the RemoteFileCache are keyed by the uri of their objects
+const std::string URI_SCHEME = "s3://";
+
+}  // namespace
+
 S3ReadableFile::~S3ReadableFile() {}
 
 
-S3ReadableFile::S3ReadableFile(std::shared_ptr<Aws::S3::S3Client> s3Client, std::string bucketName, std::string key) {
+S3ReadableFile::S3ReadableFile(
+	std::shared_ptr<Aws::S3::S3Client> s3Client, std::string bucketName, std::string key, int64_t size)
+	: size(size) {
 	this->key = key;
 	this->bucketName = bucketName;
 	this->s3Client = s3Client;
 	position = 0;
 	valid = true;
+	readCache = std::make_unique<RangedReadCache>(
+		[this](int64_t position, int64_t nbytes, void * buffer) { return this->fetchRange(position, nbytes, buffer); },
+		COALESCE_HOLE_SIZE_LIMIT,
+		COALESCE_RANGE_SIZE_LIMIT);
 }
 
+void S3ReadableFile::planReads(const std::vector<ByteRange> & ranges) { readCache->planReads(ranges); }
+
 arrow::Status S3ReadableFile::Seek(int64_t position) {
 	this->position = position;
 	return arrow::Status::OK();
@@ -48,7 +69,27 @@ arrow::Status S3ReadableFile::Close() {
 	return arrow::Status::OK();
 }
 
+std::string S3ReadableFile::getVersion() {
+	std::call_once(versionFlag, [this]() {
+		Aws::S3::Model::HeadObjectRequest request;
+		request.SetBucket(bucketName.data());
+		request.SetKey(key.data());
+
+		Aws::S3::Model::HeadObjectOutcome results = this->s3Client->HeadObject(request);
+		if(results.IsSuccess()) {
+			version = results.GetResult().GetETag().data();
+		} else {
+			// without it the ranges of the object are not cached, the object could have changed
+			Logging::Logger().logWarn("S3ReadableFile::getVersion, HeadObject failed for bucketName: " + bucketName + " key " + key);
+		}
+	});
+	return version;
+}
+
 arrow::Result<int64_t> S3ReadableFile::GetSize() {
+	if(this->size >= 0) {
+		return this->size.load();
+	}
     int64_t size = -1;
 	Aws::S3::Model::HeadObjectRequest request;
 
@@ -59,6 +100,7 @@ arrow::Result<int64_t> S3ReadableFile::GetSize() {
 
 	if(results.IsSuccess()) {
 		size = results.GetResult().GetContentLength();
+		this->size = size;
 
 	} else {
 		size = -1;
@@ -82,6 +124,13 @@ arrow::Result<int64_t> S3ReadableFile::GetSize() {
 //arrow::Status S3ReadableFile::Read(int64_t nbytes, int64_t * bytesRead, void * buffer) {
 arrow::Result<int64_t> S3ReadableFile::Read(int64_t nbytes, void* buffer) {
     int64_t bytesRead = -1;
+	if(readCache->read(position, nbytes, buffer, bytesRead)) {
+		position += bytesRead;
+		return bytesRead;
+	}
+	if(RemoteFileCache::getInstance().isEnabled()) {
+		return this->ReadAt(position, nbytes, buffer);
+	}
 	//	std::cout<<"S3ReadableFile::Read " + std::to_string(nbytes)<<std::endl;
 	Aws::S3::Model::GetObjectRequest object_request;
 
@@ -124,6 +173,19 @@ arrow::Result<int64_t> S3ReadableFile::Read(int64_t nbytes, void* buffer) {
 //arrow::Status S3ReadableFile::Read(int64_t nbytes, std::shared_ptr<arrow::Buffer> * out) {
 arrow::Result<std::shared_ptr<arrow::Buffer>> S3ReadableFile::Read(int64_t nbytes) {
     std::shared_ptr<arrow::Buffer> out = nullptr;
+	// the ranges that were planned or that can be in the RemoteFileCache are read like any other range
+	if(readCache->contains(position, nbytes) || RemoteFileCache::getInstance().isEnabled()) {
+		arrow::Result<std::unique_ptr<arrow::ResizableBuffer>> buffer = AllocateResizableBuffer(nbytes, arrow::default_memory_pool());
+		int64_t bytesRead = 0;
+		if(!readCache->read(position, nbytes, buffer.ValueOrDie()->mutable_data(), bytesRead)) {
+			bytesRead = fetchRange(position, nbytes, buffer.ValueOrDie()->mutable_data());
+		}
+		if(bytesRead > 0) {
+			this->position = position + bytesRead;
+			out = std::move(buffer.ValueOrDie());
+		}
+		return out;
+	}
 
 	//	std::cout<<"S3ReadableFile::Read " + std::to_string(nbytes)<<std::endl;
 	Aws::S3::Model::GetObjectRequest object_request;
@@ -190,6 +252,27 @@ return arrow::Status::OK();
 
 //arrow::Status S3ReadableFile::ReadAt(int64_t position, int64_t nbytes, int64_t * bytesRead, void * buffer) {
 arrow::Result<int64_t> S3ReadableFile::ReadAt(int64_t position, int64_t nbytes, void* buffer) {
+    int64_t bytesRead = -1;
+	if(!readCache->read(position, nbytes, buffer, bytesRead)) {
+		bytesRead = fetchRange(position, nbytes, buffer);
+	}
+	this->position = position + std::max(bytesRead, int64_t(0));
+	return bytesRead;
+}
+
+int64_t S3ReadableFile::fetchRange(int64_t position, int64_t nbytes, void* buffer) {
+	RemoteFileCache & diskCache = RemoteFileCache::getInstance();
+	const std::string version = diskCache.isEnabled() ? getVersion() : "";
+	if(version.empty()) {
+		return requestRange(position, nbytes, buffer);
+	}
+	return diskCache.read(RemoteFileCache::makeKey(URI_SCHEME + bucketName + "/" + key, version, position, nbytes),
+		nbytes,
+		buffer,
+		[this, position, nbytes](void * out) { return this->requestRange(position, nbytes, out); });
+}
+
+int64_t S3ReadableFile::requestRange(int64_t position, int64_t nbytes, void* buffer) {
     int64_t bytesRead = -1;
         
 	//	std::cout<<"S3ReadableFile::ReadAt " + std::to_string(nbytes)<<std::endl;
@@ -211,7 +294,7 @@ arrow::Result<int64_t> S3ReadableFile::ReadAt(int64_t position, int64_t nbytes,
 		bool shouldRetry = results.GetError().ShouldRetry();
 		if(shouldRetry) {
 			Logging::Logger().logTrace("retrying");
-			return this->ReadAt(position, nbytes, buffer);
+			return this->requestRange(position, nbytes, buffer);
 		} else {
 			bytesRead = 0;
 			Logging::Logger().logError(
@@ -225,7 +308,6 @@ arrow::Result<int64_t> S3ReadableFile::ReadAt(int64_t position, int64_t nbytes,
 	} else {
 		bytesRead = results.GetResult().GetContentLength();
 		bytesRead = nbytes < bytesRead ? nbytes : bytesRead;
-		this->position = position + bytesRead;
 		results.GetResult().GetBody().read((char *) buffer, bytesRead);
 
 		return bytesRead;
@@ -237,6 +319,19 @@ arrow::Result<int64_t> S3ReadableFile::ReadAt(int64_t position, int64_t nbytes,
 //arrow::Status S3ReadableFile::ReadAt(int64_t position, int64_t nbytes, std::shared_ptr<arrow::Buffer> * out) {
 arrow::Result<std::shared_ptr<arrow::Buffer>> S3ReadableFile::ReadAt(int64_t position, int64_t nbytes) {
     std::shared_ptr<arrow::Buffer> out = nullptr;
+	// the ranges that were planned or that can be in the RemoteFileCache are read like any other range
+	if(readCache->contains(position, nbytes) || RemoteFileCache::getInstance().isEnabled()) {
+		arrow::Result<std::unique_ptr<arrow::ResizableBuffer>> buffer = AllocateResizableBuffer(nbytes, arrow::default_memory_pool());
+		int64_t bytesRead = 0;
+		if(!readCache->read(position, nbytes, buffer.ValueOrDie()->mutable_data(), bytesRead)) {
+			bytesRead = fetchRange(position, nbytes, buffer.ValueOrDie()->mutable_data());
+		}
+		if(bytesRead > 0) {
+			this->position = position + bytesRead;
+			out = std::move(buffer.ValueOrDie());
+		}
+		return out;
+	}
         
 	//	std::cout<<"S3ReadableFile::ReadAt " + std::to_string(nbytes)<<std::endl;
 
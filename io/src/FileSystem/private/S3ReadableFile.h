@@ -12,9 +12,18 @@
 #include <aws/core/utils/memory/stl/AWSString.h>
 #include <aws/s3/S3Client.h>
 
-class S3ReadableFile : public arrow::io::RandomAccessFile {
+#include <atomic>
+#include <mutex>
+
+#include "FileSystem/RangedReadCache.h"
+
+class S3ReadableFile : public RangedReadableFile {
 public:
-	S3ReadableFile(std::shared_ptr<Aws::S3::S3Client> s3Client, std::string bucket, std::string key);
+	/**
+	 * @param size the size of the object when it is known, like from a listing, so that GetSize does not ask for it,
+	 * or -1.
+	 */
+	S3ReadableFile(std::shared_ptr<Aws::S3::S3Client> s3Client, std::string bucket, std::string key, int64_t size = -1);
 	~S3ReadableFile();
 
 	arrow::Status Close() override;
@@ -38,12 +47,30 @@ public:
 
 	bool closed() const override;
 
+	/**
+	 * Fetches these ranges in parallel and keeps them for the reads that follow, see RangedReadCache.
+	 */
+	void planReads(const std::vector<ByteRange> & ranges) override;
+
 private:
+	// reads a range from the RemoteFileCache, and downloads it with requestRange when it is not there
+	int64_t fetchRange(int64_t position, int64_t nbytes, void * buffer);
+
+	// one GetObject request for a range, without the planned reads
+	int64_t requestRange(int64_t position, int64_t nbytes, void * buffer);
+
+	// the etag of the object, which tells the ranges of the RemoteFileCache of its older versions apart
+	std::string getVersion();
+
 	std::shared_ptr<Aws::S3::S3Client> s3Client;
 	std::string bucketName;
 	std::string key;
 	size_t position;
 	bool valid;
+	std::once_flag versionFlag;
+	std::string version;
+	std::atomic<int64_t> size;  // -1 until it is known
+	std::unique_ptr<RangedReadCache> readCache;  // last, so that its fetches are done before the client goes away
 
 	ARROW_DISALLOW_COPY_AND_ASSIGN(S3ReadableFile);
 };
@@ -34,6 +34,7 @@ TEST_F(LocalFileSystemTest, GetFileStatusLinuxRegularFile) {
 	EXPECT_FALSE(fileStatus.isDirectory());
 	EXPECT_EQ(fileStatus.getUri().getPath().toString(true), currentExe);
 	EXPECT_TRUE(fileStatus.getFileSize() > 0);
+	EXPECT_TRUE(fileStatus.getModificationTime() > 0);
 }
 
 TEST_F(LocalFileSystemTest, GetFileStatusLinuxDirectory) {
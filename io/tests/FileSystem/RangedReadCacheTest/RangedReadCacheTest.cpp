@@ -0,0 +1,113 @@
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "FileSystem/RangedReadCache.h"
+
+TEST(RangedReadCacheTest, CoalesceRanges) {
+	std::vector<ByteRange> ranges = {{100, 10}, {0, 10}, {15, 10}, {30, 5}};
+
+	// the holes of up to 5 bytes are read, as long as the ranges are not longer than 30 bytes
+	std::vector<ByteRange> coalesced = RangedReadCache::coalesceRanges(ranges, 5, 30);
+
+	ASSERT_EQ(coalesced.size(), 3);
+	EXPECT_EQ(coalesced[0].offset, 0);
+	EXPECT_EQ(coalesced[0].length, 25);
+	EXPECT_EQ(coalesced[1].offset, 30);
+	EXPECT_EQ(coalesced[1].length, 5);
+	EXPECT_EQ(coalesced[2].offset, 100);
+	EXPECT_EQ(coalesced[2].length, 10);
+}
+
+TEST(RangedReadCacheTest, ReadPlannedRanges) {
+	const std::string content = "0123456789abcdefghijklmnopqrstuvwxyz";
+	std::atomic<int> fetches(0);
+	RangedReadCache cache(
+		[&](int64_t position, int64_t nbytes, void * out) {
+			fetches++;
+			std::memcpy(out, content.data() + position, nbytes);
+			return nbytes;
+		},
+		4,
+		1024);
+
+	cache.planReads({{2, 4}, {8, 4}, {30, 6}});
+	EXPECT_TRUE(cache.contains(3, 8));
+	EXPECT_FALSE(cache.contains(12, 4));
+
+	char out[8];
+	int64_t bytesRead = 0;
+	ASSERT_TRUE(cache.read(2, 4, out, bytesRead));
+	EXPECT_EQ(std::string(out, bytesRead), "2345");
+	ASSERT_TRUE(cache.read(8, 4, out, bytesRead));
+	EXPECT_EQ(std::string(out, bytesRead), "89ab");
+	ASSERT_TRUE(cache.read(30, 6, out, bytesRead));
+	EXPECT_EQ(std::string(out, bytesRead), "uvwxyz");
+	EXPECT_FALSE(cache.read(20, 4, out, bytesRead));
+
+	// the first two ranges were fetched at once
+	EXPECT_EQ(fetches, 2);
+	// and they are dropped once they were read
+	EXPECT_FALSE(cache.contains(2, 4));
+}
+
+TEST(RangedReadCacheTest, BoundedConcurrentFetches) {
+	const std::string content(1000, 'x');
+	std::atomic<int> running(0);
+	std::atomic<int> maxRunning(0);
+	{
+		RangedReadCache cache(
+			[&](int64_t position, int64_t nbytes, void * out) {
+				int now = ++running;
+				int seen = maxRunning.load();
+				while(now > seen && !maxRunning.compare_exchange_weak(seen, now)) {
+				}
+				std::this_thread::sleep_for(std::chrono::milliseconds(5));
+				std::memcpy(out, content.data() + position, nbytes);
+				running--;
+				return nbytes;
+			},
+			0,
+			10,
+			3);
+
+		// far apart, so that every one of them is a fetch
+		std::vector<ByteRange> ranges;
+		for(int64_t i = 0; i < 20; i++) {
+			ranges.push_back({i * 50, 10});
+		}
+		cache.planReads(ranges);
+
+		char out[10];
+		int64_t bytesRead = 0;
+		for(const ByteRange & range : ranges) {
+			ASSERT_TRUE(cache.read(range.offset, range.length, out, bytesRead));
+			EXPECT_EQ(bytesRead, 10);
+		}
+	}
+	EXPECT_GE(maxRunning, 1);
+	EXPECT_LE(maxRunning, 3);
+}
+
+TEST(RangedReadCacheTest, DestroyedBeforeTheFetchesStart) {
+	std::atomic<int> fetches(0);
+	{
+		RangedReadCache cache(
+			[&](int64_t /*position*/, int64_t nbytes, void * /*out*/) {
+				fetches++;
+				std::this_thread::sleep_for(std::chrono::milliseconds(20));
+				return nbytes;
+			},
+			0,
+			10,
+			1);
+		cache.planReads({{0, 10}, {100, 10}, {200, 10}, {300, 10}});
+	}
+	// the fetch that started finished, and the rest were dropped
+	EXPECT_LT(fetches, 4);
+}
@@ -0,0 +1,44 @@
+#include <atomic>
+#include <cstring>
+#include <string>
+
+#include "gtest/gtest.h"
+
+#include "FileSystem/RemoteFileCache.h"
+
+TEST(RemoteFileCacheTest, ReadThroughAndEvict) {
+	const std::string content = "0123456789abcdefghijklmnopqrstuvwxyz";
+	std::atomic<int> fetches(0);
+	auto fetch = [&](int64_t position, int64_t nbytes) {
+		return [&, position, nbytes](void * out) {
+			fetches++;
+			std::memcpy(out, content.data() + position, nbytes);
+			return nbytes;
+		};
+	};
+
+	RemoteFileCache & cache = RemoteFileCache::getInstance();
+	cache.configure("/tmp/blazing-remote-file-cache-test", 16);
+	ASSERT_TRUE(cache.isEnabled());
+
+	char out[16];
+	const std::string first = RemoteFileCache::makeKey("s3://bucket/file", "etag1", 0, 10);
+	EXPECT_EQ(cache.read(first, 10, out, fetch(0, 10)), 10);
+	EXPECT_EQ(cache.read(first, 10, out, fetch(0, 10)), 10);
+	EXPECT_EQ(std::string(out, 10), "0123456789");
+	EXPECT_EQ(fetches, 1);
+
+	// another version of the file is another range
+	const std::string changed = RemoteFileCache::makeKey("s3://bucket/file", "etag2", 0, 10);
+	EXPECT_EQ(cache.read(changed, 10, out, fetch(10, 10)), 10);
+	EXPECT_EQ(std::string(out, 10), "abcdefghij");
+	EXPECT_EQ(fetches, 2);
+
+	// which evicts the least recently used range, since both don't fit
+	EXPECT_EQ(cache.getCachedBytes(), 10);
+	EXPECT_EQ(cache.read(first, 10, out, fetch(0, 10)), 10);
+	EXPECT_EQ(fetches, 3);
+
+	cache.configure("", 0);
+	EXPECT_FALSE(cache.isEnabled());
+}
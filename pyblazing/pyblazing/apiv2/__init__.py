@@ -15,6 +15,7 @@ class DataType(IntEnum):
     MYSQL = 7,
     POSTGRESQL = 8,
     SQLITE = 9
+    ARROW_FLIGHT = 10
 
 
 # NOTE Same values from io
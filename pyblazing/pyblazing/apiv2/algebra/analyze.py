@@ -0,0 +1,84 @@
+# The counters of the kernel stats of the engine, see kernel_stats in
+# graph.h. The times are given in milliseconds in the tree.
+_COUNTERS = (
+    "input_rows",
+    "input_bytes",
+    "output_rows",
+    "output_bytes",
+    "output_batches",
+    "spill_bytes",
+    "retries",
+    "shuffle_bytes",
+)
+_TIMES = ("wall_time", "task_time")
+
+
+def decode_kernel_stats(stats):
+    """
+    The kernel stats of a graph as they come from the engine, with their
+    names decoded and their times in milliseconds.
+    """
+    decoded = []
+    for kernel in stats:
+        name = kernel["kernel_name"]
+        entry = {
+            "kernel_id": kernel["kernel_id"],
+            "kernel": name.decode() if isinstance(name, bytes) else name,
+            "input_kernel_ids": list(kernel["input_kernel_ids"]),
+            "finished": bool(kernel["finished"]),
+        }
+        for time in _TIMES:
+            entry[time + "_ms"] = kernel[time + "_us"] / 1000.0
+        for counter in _COUNTERS:
+            entry[counter] = kernel[counter]
+        decoded.append(entry)
+    return decoded
+
+
+def merge_kernel_stats(stats_per_worker):
+    """
+    Sums the decoded kernel stats of the workers of a distributed query. All
+    of them run the same graph, but the ids of their kernels can differ, so
+    the kernels are matched by their position and the ids are the ones of the
+    first worker. The wall time of a kernel is the longest one.
+    """
+    stats_per_worker = [stats for stats in stats_per_worker if len(stats) > 0]
+    if len(stats_per_worker) == 0:
+        return []
+    merged = [dict(kernel) for kernel in stats_per_worker[0]]
+    for stats in stats_per_worker[1:]:
+        if len(stats) != len(merged):
+            raise ValueError("The workers ran different graphs for the query")
+        for kernel, other in zip(merged, stats):
+            kernel["wall_time_ms"] = max(kernel["wall_time_ms"], other["wall_time_ms"])
+            kernel["task_time_ms"] += other["task_time_ms"]
+            for counter in _COUNTERS:
+                kernel[counter] += other[counter]
+            kernel["finished"] = kernel["finished"] and other["finished"]
+    return merged
+
+
+def kernel_stats_tree(stats):
+    """
+    The decoded kernel stats of a query as the tree of its plan, from the
+    OutputKernel, which runs last, down to the scans. Each kernel has its
+    inputs in children, and a kernel consumed by several others, like a
+    SpoolKernel, is under each of them.
+    """
+    if len(stats) == 0:
+        return None
+    by_id = {kernel["kernel_id"]: kernel for kernel in stats}
+
+    def make_node(kernel, path):
+        node = {
+            key: value for key, value in kernel.items() if key != "input_kernel_ids"
+        }
+        node["children"] = [
+            make_node(by_id[input_id], path | {input_id})
+            for input_id in kernel["input_kernel_ids"]
+            if input_id in by_id and input_id not in path
+        ]
+        return node
+
+    root = stats[-1]
+    return make_node(root, {root["kernel_id"]})
@@ -0,0 +1,157 @@
+import datetime
+import re
+
+# The parameters of a prepared statement are planned once per kind, with a
+# sentinel literal in their place that is then found in the optimized algebra.
+# The kinds whose literals Calcite can fold or retype are planned with their
+# values every time instead.
+_INT32_SENTINEL_BASE = 2024061700
+_INT64_SENTINEL_BASE = 9024061700000000000
+_STRING_SENTINEL_PREFIX = "blazing_parameter_"
+
+
+def split_placeholders(query):
+    """
+    Splits a query on its ? placeholders, leaving alone the ones inside
+    string literals, quoted identifiers and comments. The query has one more
+    part than placeholders.
+    """
+    parts = []
+    current = []
+    i = 0
+    while i < len(query):
+        char = query[i]
+        if char in ("'", '"'):
+            end = i + 1
+            while end < len(query):
+                if query[end] == char:
+                    if end + 1 < len(query) and query[end + 1] == char:
+                        end += 2  # an escaped quote
+                        continue
+                    break
+                end += 1
+            current.append(query[i : end + 1])
+            i = end + 1
+        elif query.startswith("--", i):
+            end = query.find("\n", i)
+            end = len(query) if end < 0 else end
+            current.append(query[i:end])
+            i = end
+        elif query.startswith("/*", i):
+            end = query.find("*/", i + 2)
+            end = len(query) if end < 0 else end + 2
+            current.append(query[i:end])
+            i = end
+        elif char == "?":
+            parts.append("".join(current))
+            current = []
+            i += 1
+        else:
+            current.append(char)
+            i += 1
+    parts.append("".join(current))
+    return parts
+
+
+def parameter_kind(value):
+    """
+    The kind of literal of a parameter, the ones of None can't be cached.
+    """
+    if isinstance(value, bool):
+        return None  # Calcite simplifies the conditions on boolean literals
+    if isinstance(value, int):
+        if -(2 ** 31) <= value < 2 ** 31:
+            return "int32"
+        return "int64"
+    if isinstance(value, str) and value.isascii() and "'" not in value:
+        # Calcite writes the other strings differently from how they are typed
+        return "string"
+    return None
+
+
+def to_sql_literal(value):
+    if value is None:
+        return "NULL"
+    if isinstance(value, bool):
+        return "TRUE" if value else "FALSE"
+    if isinstance(value, (int, float)):
+        return repr(value)
+    if isinstance(value, datetime.datetime):
+        return "TIMESTAMP '" + value.strftime("%Y-%m-%d %H:%M:%S") + "'"
+    if isinstance(value, datetime.date):
+        return "DATE '" + value.strftime("%Y-%m-%d") + "'"
+    return "'" + str(value).replace("'", "''") + "'"
+
+
+def _sentinel_literal(index, kind):
+    if kind == "int32":
+        return str(_INT32_SENTINEL_BASE + index)
+    if kind == "int64":
+        return str(_INT64_SENTINEL_BASE + index)
+    return "'" + _STRING_SENTINEL_PREFIX + str(index) + "'"
+
+
+def bind_query(parts, literals):
+    """
+    Puts the SQL literals of the parameters in place of the placeholders.
+    """
+    if len(literals) != len(parts) - 1:
+        raise ValueError(
+            "The statement has {} parameters, but {} were given".format(
+                len(parts) - 1, len(literals)
+            )
+        )
+    query = parts[0]
+    for literal, part in zip(literals, parts[1:]):
+        query += literal + part
+    return query
+
+
+def sentinel_query(parts, kinds):
+    """
+    The query to plan the template of a statement with, see make_plan_template.
+    """
+    return bind_query(
+        parts, [_sentinel_literal(index, kind) for index, kind in enumerate(kinds)]
+    )
+
+
+def make_plan_template(algebra, kinds):
+    """
+    Splits the algebra that was planned for sentinel_query on the literals of
+    the parameters, as a list of its texts and of the indices of the
+    parameters between them. Returns None if one of the literals is not there
+    as it was written, because it was folded into another one or given a type.
+    """
+    if len(kinds) == 0:
+        return [algebra]
+    patterns = []
+    for index, kind in enumerate(kinds):
+        literal = re.escape(_sentinel_literal(index, kind))
+        patterns.append("(?<![\\w.$']){}(?![\\w.:'])".format(literal))
+    regex = re.compile("|".join("(" + pattern + ")" for pattern in patterns))
+
+    template = []
+    found = set()
+    position = 0
+    for match in regex.finditer(algebra):
+        template.append(algebra[position : match.start()])
+        template.append(match.lastindex - 1)
+        found.add(match.lastindex - 1)
+        position = match.end()
+    template.append(algebra[position:])
+
+    # a typed literal, like 5:BIGINT, is not matched
+    if len(found) != len(kinds):
+        return None
+    return template
+
+
+def bind_plan(template, literals):
+    """
+    Makes the algebra of a statement from its template and the literals of
+    its parameters.
+    """
+    return "".join(
+        literals[part] if isinstance(part, int) else part for part in template
+    )
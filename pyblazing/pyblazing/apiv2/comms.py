@@ -1,10 +1,16 @@
+import asyncio
 import errno
+import pickle
 import random
 import socket
 
 import netifaces as ni
+import numpy as np
+import pyarrow as pa
+import ucp
 from dask.distributed import default_client
 from distributed import get_worker
+from distributed.comm import parse_address
 from distributed.comm.addressing import parse_host_port
 from distributed.comm.ucx import UCXConnector, UCXListener
 from ucp.endpoint_reuse import EndpointReuse
@@ -34,6 +40,10 @@ def checkSocket(socketNum):
 
 
 def get_communication_port(network_interface):
+    warm_state = getattr(get_worker(), "blazing_warm_state", None)
+    if warm_state is not None:
+        # the engine of a warm worker keeps listening where it was initialized
+        return warm_state["address"]
     ralCommunicationPort = random.randint(10000, 32000)
     workerIp = ni.ifaddresses(network_interface)[ni.AF_INET][0]["addr"]
     while checkSocket(ralCommunicationPort) is False:
@@ -45,3 +55,122 @@ def listen(client, network_interface=""):
     worker_id_maps = client.run(get_communication_port, network_interface, wait=True)
     client.run(set_id_mappings_on_worker, worker_id_maps, wait=True)
     return worker_id_maps
+
+
+def get_client_address(scheduler_address):
+    """Returns the ip of the interface of the client that reaches the
+    scheduler, which the workers can reach too"""
+    host, port = parse_host_port(parse_address(scheduler_address)[1])
+    with socket.socket(socket.AF_INET, socket.SOCK_DGRAM) as s:
+        s.connect((host, port))
+        return s.getsockname()[0]
+
+
+async def _send_part(ep, df, to_host_memory):
+    if to_host_memory:
+        # a client without a GPU gets the part as an arrow stream, which the
+        # worker copies to host memory
+        table = df.to_arrow()
+        sink = pa.BufferOutputStream()
+        with pa.ipc.new_stream(sink, table.schema) as writer:
+            writer.write_table(table)
+        stream = sink.getvalue()
+        header = {"arrow": True, "lengths": [stream.size], "is-cuda": [False]}
+        frames = [np.frombuffer(stream, dtype="u1")]
+    else:
+        header, frames = df.device_serialize()
+    await ep.send_obj(pickle.dumps(header))
+    for frame, length in zip(frames, header["lengths"]):
+        if length > 0:
+            await ep.send(frame)
+
+
+async def _recv_part(ep, to_host_memory):
+    import rmm
+
+    header = pickle.loads(await ep.recv_obj())
+    frames = []
+    for length, is_cuda in zip(header["lengths"], header["is-cuda"]):
+        if is_cuda:
+            frame = rmm.DeviceBuffer(size=length)
+        else:
+            frame = np.empty(length, dtype="u1")
+        if length > 0:
+            await ep.recv(frame)
+        frames.append(frame)
+    if header.get("arrow", False):
+        return pa.ipc.open_stream(pa.py_buffer(frames[0])).read_all()
+
+    import cudf
+
+    return cudf.DataFrame.device_deserialize(header, frames)
+
+
+async def send_query_parts_to_client(
+    query_partids_by_worker, host, port, to_host_memory
+):
+    """Sends the parts of the result of a query that this worker keeps
+    straight to the client over UCX, from device to device memory, instead of
+    through the communications of dask"""
+    worker = get_worker()
+    query_partids = query_partids_by_worker.get(worker.name, [])
+    ep = await ucp.create_endpoint(host, port)
+    try:
+        await ep.send_obj(
+            pickle.dumps({"worker": worker.name, "num_parts": len(query_partids)})
+        )
+        for query_partid in query_partids:
+            await _send_part(ep, worker.query_parts.pop(query_partid), to_host_memory)
+    finally:
+        await ep.close()
+
+
+class ResultReceiver:
+    """Listens on the client for the parts of the result of a query that the
+    workers send with send_query_parts_to_client. It has to be created in the
+    event loop of the client."""
+
+    def __init__(self, num_workers, to_host_memory):
+        self.num_workers = num_workers
+        self.to_host_memory = to_host_memory
+        self.parts = {}
+        self.errors = []
+        self.num_done = 0
+        self.done = asyncio.Event()
+        self.listener = ucp.create_listener(self._receive)
+
+    @property
+    def port(self):
+        return self.listener.port
+
+    async def _receive(self, ep):
+        try:
+            message = pickle.loads(await ep.recv_obj())
+            parts = []
+            for _ in range(message["num_parts"]):
+                parts.append(await _recv_part(ep, self.to_host_memory))
+            self.parts[message["worker"]] = parts
+        except Exception as e:
+            self.errors.append(e)
+        finally:
+            self.num_done += 1
+            if self.num_done == self.num_workers:
+                self.done.set()
+            await ep.close()
+
+    async def wait(self):
+        """Waits for the parts of all the workers, which were sent already
+        when send_query_parts_to_client returned on the workers"""
+        await self.done.wait()
+        self.close()
+        if self.errors:
+            raise self.errors[0]
+        return self.parts
+
+    def close(self):
+        if not self.listener.closed():
+            self.listener.close()
+
+
+async def start_result_receiver(num_workers, to_host_memory):
+    return ResultReceiver(num_workers, to_host_memory)
@@ -15,15 +15,42 @@ from weakref import ref
 from distributed.comm import parse_address
 from pyblazing.apiv2.filesystem import FileSystem
 from pyblazing.apiv2 import DataType
-from pyblazing.apiv2.comms import listen
+from pyblazing.apiv2.comms import (
+    listen,
+    get_communication_port,
+    set_id_mappings_on_worker,
+    get_client_address,
+    send_query_parts_to_client,
+    start_result_receiver,
+)
 from pyblazing.apiv2.sqlengines_utils import (
     SQLEngineDataTypeMap,
     UnsupportedSQLEngineError,
 )
 from pyblazing.apiv2.algebra import get_json_plan, format_json_plan
+from pyblazing.apiv2.algebra.prepared import (
+    split_placeholders,
+    parameter_kind,
+    to_sql_literal,
+    bind_query,
+    sentinel_query,
+    make_plan_template,
+    bind_plan,
+)
+from pyblazing.apiv2.metrics import merge_openmetrics, start_metrics_server
+from pyblazing.apiv2.workload import WorkloadRecorder, replay_workload
+from pyblazing.apiv2.locality import assign_files, get_slice_candidates
+from pyblazing.apiv2.algebra.analyze import (
+    decode_kernel_stats,
+    merge_kernel_stats,
+    kernel_stats_tree,
+)
 
 import json
 import collections
+import copy
+import hashlib
+import uuid
 from pyhive import hive
 from .hive import (
     convertTypeNameStrToCudfType,
@@ -49,6 +76,7 @@ import dask.distributed
 import netifaces as ni
 
 import random
+import re
 
 import logging
 
@@ -103,30 +131,58 @@ if not os.path.isfile(jvm_path):
             + "/default/libjvm.so"
         )
 
-jpype.startJVM("-ea", convertStrings=False, jvmpath=jvm_path)
-# jpype.startJVM()
-
-ArrayClass = jpype.JClass("java.util.ArrayList")
-ColumnTypeClass = jpype.JClass(
-    "com.blazingdb.calcite.catalog.domain.CatalogColumnDataType"
-)
-dataType = ColumnTypeClass.fromString("GDF_INT8")
-ColumnClass = jpype.JClass("com.blazingdb.calcite.catalog.domain.CatalogColumnImpl")
-TableClass = jpype.JClass("com.blazingdb.calcite.catalog.domain.CatalogTableImpl")
-DatabaseClass = jpype.JClass("com.blazingdb.calcite.catalog.domain.CatalogDatabaseImpl")
-BlazingSchemaClass = jpype.JClass("com.blazingdb.calcite.schema.BlazingSchema")
-RelationalAlgebraGeneratorClass = jpype.JClass(
-    "com.blazingdb.calcite.application.RelationalAlgebraGenerator"
-)
-SqlValidationExceptionClass = jpype.JClass(
-    "com.blazingdb.calcite.application.SqlValidationException"
-)
-SqlSyntaxExceptionClass = jpype.JClass(
-    "com.blazingdb.calcite.application.SqlSyntaxException"
-)
-RelConversionExceptionClass = jpype.JClass(
-    "org.apache.calcite.tools.RelConversionException"
-)
+# The JVM and the Calcite classes are only needed by the client, to plan the
+# queries, so they are loaded by the first BlazingContext instead of on import,
+# which the dask workers also do.
+ArrayClass = None
+ColumnTypeClass = None
+ColumnClass = None
+TableClass = None
+DatabaseClass = None
+BlazingSchemaClass = None
+RelationalAlgebraGeneratorClass = None
+SqlValidationExceptionClass = None
+SqlSyntaxExceptionClass = None
+RelConversionExceptionClass = None
+
+
+def start_jvm():
+    """
+    Starts the JVM and loads the Calcite classes the first time it is called.
+    """
+    global ArrayClass, ColumnTypeClass, ColumnClass, TableClass, DatabaseClass
+    global BlazingSchemaClass, RelationalAlgebraGeneratorClass
+    global SqlValidationExceptionClass, SqlSyntaxExceptionClass
+    global RelConversionExceptionClass
+
+    if RelationalAlgebraGeneratorClass is not None:
+        return
+    if not jpype.isJVMStarted():
+        jpype.startJVM("-ea", convertStrings=False, jvmpath=jvm_path)
+
+    ArrayClass = jpype.JClass("java.util.ArrayList")
+    ColumnTypeClass = jpype.JClass(
+        "com.blazingdb.calcite.catalog.domain.CatalogColumnDataType"
+    )
+    ColumnClass = jpype.JClass("com.blazingdb.calcite.catalog.domain.CatalogColumnImpl")
+    TableClass = jpype.JClass("com.blazingdb.calcite.catalog.domain.CatalogTableImpl")
+    DatabaseClass = jpype.JClass(
+        "com.blazingdb.calcite.catalog.domain.CatalogDatabaseImpl"
+    )
+    BlazingSchemaClass = jpype.JClass("com.blazingdb.calcite.schema.BlazingSchema")
+    SqlValidationExceptionClass = jpype.JClass(
+        "com.blazingdb.calcite.application.SqlValidationException"
+    )
+    SqlSyntaxExceptionClass = jpype.JClass(
+        "com.blazingdb.calcite.application.SqlSyntaxException"
+    )
+    RelConversionExceptionClass = jpype.JClass(
+        "org.apache.calcite.tools.RelConversionException"
+    )
+    # it is set last, since it tells that all of them were loaded
+    RelationalAlgebraGeneratorClass = jpype.JClass(
+        "com.blazingdb.calcite.application.RelationalAlgebraGenerator"
+    )
 
 
 def get_blazing_logger(is_dask):
@@ -151,6 +207,20 @@ class blazing_allocation_mode(IntEnum):
     CudaManagedMemory = (2,)
 
 
+def set_mps_client_limits(config_options):
+    """Sets the limits of MPS of the config options in the environment of
+    this process, where the engine sizes itself by them. The ones the
+    environment already has are kept"""
+    limits = {
+        "MPS_ACTIVE_THREAD_PERCENTAGE": "CUDA_MPS_ACTIVE_THREAD_PERCENTAGE",
+        "MPS_PINNED_DEVICE_MEM_LIMIT": "CUDA_MPS_PINNED_DEVICE_MEM_LIMIT",
+    }
+    for option, variable in limits.items():
+        value = config_options.get(option.encode(), b"").decode()
+        if value not in ("", "0") and variable not in os.environ:
+            os.environ[variable] = value
+
+
 def initializeBlazing(
     ralId=0,
     worker_id="",
@@ -167,6 +237,36 @@ def initializeBlazing(
     is_dask=False,
 ):
 
+    warm_key = None
+    if singleNode is False and config_options.get(
+        "ENABLE_WARM_WORKERS".encode(), "True".encode()
+    ) in ("True".encode(), "true".encode()):
+        worker = get_worker()
+        peers = sorted(
+            (name, address["ip"], address["port"])
+            for name, address in worker.ucx_addresses.items()
+        )
+        warm_key = repr(
+            (
+                ralId,
+                worker_id,
+                networkInterface,
+                peers,
+                allocator,
+                pool,
+                initial_pool_size,
+                maximum_pool_size,
+                enable_logging,
+                sorted(config_options.items()),
+                logging_dir_path,
+            )
+        )
+        warm_state = getattr(worker, "blazing_warm_state", None)
+        if warm_state is not None and warm_state["key"] == warm_key:
+            # the engine of this worker is still initialized by a previous
+            # BlazingContext with the same nodes and settings
+            return warm_state["result"]
+
     last_str = '|%(levelname)s|||"%(message)s"||||||'
     FORMAT = "%(asctime)s|" + str(ralId) + last_str
     filename = os.path.join(logging_dir_path, "pyblazing." + str(ralId) + ".log")
@@ -201,7 +301,11 @@ def initializeBlazing(
         "managed_memory_resource",
         "pool_memory_resource",
         "managed_pool_memory_resource",
+        "binning_pool_memory_resource",
         "arena_memory_resource",
+        "binning",
+        "async",
+        "async_memory_resource",
     ]
     if allocator not in possible_allocators:
         print(
@@ -220,6 +324,12 @@ def initializeBlazing(
         allocator = "pool_memory_resource"
     elif pool and allocator == "managed":
         allocator = "managed_pool_memory_resource"
+    elif allocator == "async":
+        allocator = "async_memory_resource"
+    elif allocator == "binning":
+        allocator = "binning_pool_memory_resource"
+
+    set_mps_client_limits(config_options)
 
     import ucp.core as ucp_core
 
@@ -262,7 +372,18 @@ def initializeBlazing(
         log_path = logging_dir_path
     else:
         log_path = os.path.join(os.getcwd(), logging_dir_path)
-    return self_port, ni.ifaddresses(networkInterface)[ni.AF_INET][0]["addr"], log_path
+    result = (
+        self_port,
+        ni.ifaddresses(networkInterface)[ni.AF_INET][0]["addr"],
+        log_path,
+    )
+    if warm_key is not None:
+        worker.blazing_warm_state = {
+            "key": warm_key,
+            "address": worker.ucx_addresses[worker_id],
+            "result": result,
+        }
+    return result
 
 
 def getNodePartitionKeys(df, client):
@@ -283,6 +404,45 @@ def getNodePartitionKeys(df, client):
     return worker_partitions
 
 
+def getFileBucketIds(files, num_buckets):
+    """
+    The bucket of every file of a bucketed table, from the suffix that Spark
+    (part-00000-<uuid>_00003.c000.snappy.parquet) and Hive (000003_0) give to
+    the bucket files, or from the order of the files when there is one
+    file per bucket.
+    """
+    bucket_ids = []
+    for file in files:
+        name = PurePath(file.decode() if isinstance(file, bytes) else file).name
+        match = re.search(r"_(\d{5})(?:\.c\d+)?\.", name) or re.match(r"(\d+)_\d+", name)
+        if match is None:
+            break
+        bucket_ids.append(int(match.group(1)))
+
+    if len(bucket_ids) < len(files):
+        if len(files) != num_buckets:
+            raise ValueError(
+                "ERROR: the bucket of the files can not be told from their names,"
+                + " and there are "
+                + str(len(files))
+                + " files for "
+                + str(num_buckets)
+                + " buckets"
+            )
+        order = sorted(range(len(files)), key=lambda i: files[i])
+        bucket_ids = [0] * len(files)
+        for bucket_id, file_index in enumerate(order):
+            bucket_ids[file_index] = bucket_id
+
+    if any(bucket_id >= num_buckets for bucket_id in bucket_ids):
+        raise ValueError(
+            "ERROR: there are files of buckets beyond the "
+            + str(num_buckets)
+            + " buckets of the table"
+        )
+    return bucket_ids
+
+
 def get_element(query_partid):
     worker = get_worker()
     df = worker.query_parts[query_partid]
@@ -385,6 +545,57 @@ def getQueryProgress(ctxToken):
     return queryProgressAsPandas(progress)
 
 
+def keepQueryKernelStats(ctxToken):
+    worker = get_worker()
+    with worker._lock:
+        if not hasattr(worker, "analyzed_queries"):
+            worker.analyzed_queries = {}
+        worker.analyzed_queries[ctxToken] = None
+
+
+def popQueryKernelStats(ctxToken):
+    worker = get_worker()
+    with worker._lock:
+        return worker.analyzed_queries.pop(ctxToken, None) or []
+
+
+def cancelQuery(ctxToken):
+    return cio.cancelQueryCaller(ctxToken)
+
+
+def openResultCursor(ctxToken, ttl_ms):
+    worker = get_worker()
+
+    graph = worker.query_graphs[ctxToken]
+    del worker.query_graphs[ctxToken]
+    with worker._lock:
+        return cio.openResultCursorCaller(graph, ctxToken, ttl_ms)
+
+
+def fetchResultCursor(ctxToken, offset, num_rows):
+    return cio.fetchResultCursorCaller(ctxToken, offset, num_rows)
+
+
+def closeResultCursor(ctxToken):
+    return cio.closeResultCursorCaller(ctxToken)
+
+
+def removeShuffleCheckpoint(checkpoint_path):
+    cio.removeShuffleCheckpointCaller(checkpoint_path)
+
+
+def addNodesOnWorker(peers):
+    for ral_id, worker_id, address in peers:
+        cio.addNodeCaller(
+            ral_id, worker_id.encode(), address["ip"].encode(), address["port"]
+        )
+
+
+def removeNodeOnWorker(worker_ids):
+    for worker_id in worker_ids:
+        cio.removeNodeCaller(worker_id.encode())
+
+
 def getExecuteGraphResult(ctxToken):
     worker = get_worker()
 
@@ -392,6 +603,11 @@ def getExecuteGraphResult(ctxToken):
     del worker.query_graphs[ctxToken]
     with worker._lock:
         dfs = cio.getExecuteGraphResultCaller(graph, ctxToken, is_single_node=False)
+        # the stats are kept by the graph when its kernels are cleared
+        if ctxToken in getattr(worker, "analyzed_queries", {}):
+            worker.analyzed_queries[ctxToken] = decode_kernel_stats(
+                graph.get_kernel_stats()
+            )
         meta = dask.dataframe.utils.make_meta(dfs[0])
         query_partids = []
 
@@ -647,6 +863,10 @@ def mergeMetadata(curr_table, fileMetadata, hiveMetadata):
         col_name = columns[index]
         names.append("min_" + str(index) + "_" + col_name)
         names.append("max_" + str(index) + "_" + col_name)
+    # the null counts and the row counts of the parquet row groups
+    for index in range(n_cols):
+        names.append("nulls_" + str(index) + "_" + columns[index])
+    names.append("row_count")
     names.append("file_handle_index")
     names.append("row_group_index")
 
@@ -722,6 +942,43 @@ def adjust_due_missing_rowgroups(metadata, files):
     return metadata, new_files
 
 
+# the number of distinct values and nulls of every column, from the min, max and
+# null counts of the row groups, for the planner to estimate the rows of the
+# joins. The files rarely store their distinct counts, so they are bounded by
+# the range of the integer columns and by the rows, and left unknown (None)
+# for the other columns
+def get_column_statistics(metadata, column_names):
+    statistics = [(None, None) for _ in column_names]
+    if metadata is None or "row_count" not in metadata.columns:
+        return statistics
+    if isinstance(metadata, dask_cudf.core.DataFrame):
+        metadata = metadata.compute()
+    if len(metadata) == 0:
+        return statistics
+
+    row_count = float(metadata["row_count"].sum())
+    for index, col_name in enumerate(column_names):
+        nulls_col_name = "nulls_" + str(index) + "_" + col_name
+        null_count = None
+        if nulls_col_name in metadata.columns:
+            null_count = float(metadata[nulls_col_name].sum())
+
+        distinct_count = None
+        min_col_name = "min_" + str(index) + "_" + col_name
+        max_col_name = "max_" + str(index) + "_" + col_name
+        if min_col_name in metadata.columns and max_col_name in metadata.columns:
+            dtype = metadata[min_col_name].dtype
+            if np.issubdtype(dtype, np.integer) or np.issubdtype(dtype, np.bool_):
+                min_value = metadata[min_col_name].min()
+                max_value = metadata[max_col_name].max()
+                values = row_count - (null_count if null_count is not None else 0)
+                distinct_count = float(
+                    max(1, min(int(max_value) - int(min_value) + 1, values))
+                )
+        statistics[index] = (distinct_count, null_count)
+    return statistics
+
+
 def distributed_initialize_server_directory(client, dir_path):
 
     # We are going to differentiate the two cases. When path is absolute,
@@ -856,6 +1113,66 @@ def distributed_remove_orc_files_from_disk(client, data_dir, query_id=None):
     client.gather(dask_futures)
 
 
+# The operators that can be under the aggregation of an incremental query, so that
+# its partial aggregations only depend on the rows of every file on their own
+INCREMENTAL_AGGREGATION_INPUT_OPERATORS = (
+    "LogicalProject",
+    "LogicalFilter",
+    "LogicalTableScan",
+    "BindableTableScan",
+)
+
+
+def check_incremental_aggregation_plan(algebra):
+    """Raises if the aggregation of a plan can't be computed incrementally, which
+    needs a single aggregation over the scan of a single table"""
+    lines = [line.strip() for line in algebra.strip().split("\n")]
+    aggregations = [i for i, line in enumerate(lines) if "LogicalAggregate" in line]
+    if len(aggregations) != 1 or ") OVER (" in algebra:
+        raise ValueError(
+            "Incremental queries need exactly one aggregation and no window functions"
+        )
+    for line in lines[aggregations[0] + 1 :]:
+        if not line.startswith(INCREMENTAL_AGGREGATION_INPUT_OPERATORS):
+            raise ValueError(
+                "Only projections and filters can be under the aggregation "
+                "of an incremental query, found: " + line
+            )
+    for line in lines[: aggregations[0]]:
+        if "Join" in line or "Union" in line or "Intersect" in line or "Minus" in line:
+            raise ValueError(
+                "Incremental queries can't have more than one input, found: " + line
+            )
+
+
+def read_incremental_aggregation_manifest(manifest_path):
+    if not os.path.exists(manifest_path):
+        return {"files": [], "state": ""}
+    with open(manifest_path) as manifest_file:
+        return json.load(manifest_file)
+
+
+def commit_incremental_aggregation_state(incremental_state):
+    """Makes the state written by the query the one of the next run. The
+    manifest is replaced at once, so a query that fails on the way leaves
+    the previous state and list of files as they were"""
+    manifest = {
+        "files": incremental_state["files"],
+        "state": incremental_state["output"],
+    }
+    temp_path = incremental_state["manifest"] + ".tmp"
+    with open(temp_path, "w") as manifest_file:
+        json.dump(manifest, manifest_file)
+    os.replace(temp_path, incremental_state["manifest"])
+    if incremental_state["input"] != "" and os.path.exists(incremental_state["input"]):
+        os.remove(incremental_state["input"])
+
+
+def discard_incremental_aggregation_state(incremental_state):
+    if os.path.exists(incremental_state["output"]):
+        os.remove(incremental_state["output"])
+
+
 def initialize_orc_files_folder(client, data_dir):
     workers = list(client.scheduler_info()["workers"])
     dask_futures = []
@@ -934,6 +1251,16 @@ def kwargs_validation(kwargs, bc_api_str):
             "database",
             "table_filter",
             "table_batch_size",
+            "table_partition_column",
+            "table_partitions",
+            "table_connections",
+            # Arrow Flight arguments
+            "from_flight",
+            "flight_batch_bytes",
+            # bucketed tables arguments
+            "bucket_by",
+            "num_buckets",
+            "bucket_hash",
         ]
         params_info = "https://docs.blazingdb.com/docs/create_table"
 
@@ -1058,6 +1385,13 @@ class BlazingTable(object):
         # a pair of values with the startIndex and batchSize
         # info for each slice
         self.offset = (0, 0)
+        # the bucket of every file, only for the bucketed tables,
+        # see set_bucketing
+        self.bucket_ids = None
+        # the slice of every file, when they were assigned to the workers
+        # that have their data, see set_locality
+        self.locality_slices = None
+        self.locality_num_slices = None
 
         self.column_names = []
         self.column_types = []
@@ -1131,6 +1465,68 @@ class BlazingTable(object):
 
         return nodeFilesList
 
+    def set_bucketing(self, bucket_by, num_buckets, bucket_hash, numSlices):
+        """
+        Registers the table as bucketed, its rows are split into num_buckets
+        files by the bucket_hash of the column bucket_by. The files are sorted
+        so that the slice i gets the buckets b with b % numSlices == i, which
+        puts the same buckets of every table bucketed the same way in the
+        same worker. Then the joins and the group bys on their bucket columns
+        don't need to shuffle their inputs.
+        """
+        if bucket_by not in self.column_names:
+            raise ValueError(
+                "ERROR: the bucket column "
+                + str(bucket_by)
+                + " is not a column of the table "
+                + self.name
+            )
+        num_buckets = int(num_buckets)
+        if num_buckets <= 0:
+            raise ValueError("ERROR: num_buckets has to be greater than 0")
+
+        bucket_ids = getFileBucketIds(self.files, num_buckets)
+        order = sorted(
+            range(len(self.files)),
+            key=lambda i: (bucket_ids[i] % numSlices, bucket_ids[i]),
+        )
+        self.files = [self.files[i] for i in order]
+        if self.uri_values is not None and len(self.uri_values) == len(order):
+            self.uri_values = [self.uri_values[i] for i in order]
+        if self.row_groups_ids is not None and len(self.row_groups_ids) == len(
+            order
+        ):
+            self.row_groups_ids = [self.row_groups_ids[i] for i in order]
+        self.bucket_ids = [bucket_ids[i] for i in order]
+
+        self.args["bucket_column_index"] = self.column_names.index(bucket_by)
+        self.args["num_buckets"] = num_buckets
+        self.args["bucket_hash"] = bucket_hash
+
+    def set_locality(self, file_slices, numSlices):
+        """
+        Assigns every file to a slice, see locality.assign_files. The files
+        are sorted by their slice, like the ones of the bucketed tables, so
+        that every slice is still a range of the files.
+        """
+        order = sorted(range(len(self.files)), key=lambda i: file_slices[i])
+        self.files = [self.files[i] for i in order]
+        if self.uri_values is not None and len(self.uri_values) == len(order):
+            self.uri_values = [self.uri_values[i] for i in order]
+        if self.row_groups_ids is not None and len(self.row_groups_ids) == len(
+            order
+        ):
+            self.row_groups_ids = [self.row_groups_ids[i] for i in order]
+        self.locality_slices = [file_slices[i] for i in order]
+        self.locality_num_slices = numSlices
+
+    def has_locality(self, numSlices):
+        # the assignment is dropped when the workers changed since it was made
+        return (
+            self.locality_slices is not None
+            and self.locality_num_slices == numSlices
+        )
+
     def getSlices(self, numSlices):
         nodeFilesList = []
         if self.files is None:
@@ -1143,7 +1539,13 @@ class BlazingTable(object):
         remaining = len(self.files)
         startIndex = 0
         for i in range(0, numSlices):
-            batchSize = int(remaining / (numSlices - i))
+            if self.bucket_ids is not None:
+                # the files are sorted by the slice of their bucket
+                batchSize = len([b for b in self.bucket_ids if b % numSlices == i])
+            elif self.has_locality(numSlices):
+                batchSize = self.locality_slices.count(i)
+            else:
+                batchSize = int(remaining / (numSlices - i))
             tempFiles = self.files[startIndex : startIndex + batchSize]
             uri_values = self.uri_values[startIndex : startIndex + batchSize]
 
@@ -1225,17 +1627,85 @@ def load_config_options_from_env(user_config_options: dict):
         "MAX_NUM_ORDER_BY_PARTITIONS_PER_NODE": 8,
         "NUM_BYTES_PER_ORDER_BY_PARTITION": 400000000,
         "MAX_DATA_LOAD_CONCAT_CACHE_BYTE_SIZE": 400000000,
-        "FLOW_CONTROL_BYTES_THRESHOLD": 18446744073709551615,  # see https://en.cppreference.com/w/cpp/types/numeric_limits/max
+        "SCAN_TASK_TARGET_BYTES": 268435456,
+        "IO_PREFETCH_IN_FLIGHT": 0,
+        "REMOTE_FILE_CACHE_DIRECTORY": "",
+        "REMOTE_FILE_CACHE_MAX_BYTES": 0,
+        "OBJECT_UPLOAD_PART_BYTES": 16777216,
+        "OBJECT_UPLOAD_CONCURRENCY": 8,
+        "OBJECT_STORE_MAX_CONNECTIONS": 64,
+        "OBJECT_STORE_OPEN_CONCURRENCY": 16,
+        "HDFS_SHORT_CIRCUIT_READS": True,
+        "HDFS_DOMAIN_SOCKET_PATH": "",
+        "HDFS_READ_HANDLES": 4,
+        "ENABLE_LOCALITY_AWARE_SCAN": True,
+        "LOCALITY_BALANCE_SLACK": 0.1,
+        "ENABLE_SCAN_WORK_STEALING": False,
+        "PARQUET_METADATA_CACHE_MAX_FILES": 10000,
+        "PARQUET_METADATA_CACHE_DIRECTORY": "",
+        "FOLDER_LISTING_THREADS": 16,
+        "FOLDER_LISTING_CACHE_TTL_MS": 60000,
+        "ENABLE_SHARED_SCANS": True,
+        "ENABLE_KERNEL_FUSION": True,
+        "ENABLE_JIT_EXPRESSIONS": False,
+        "INTERPRETER_MIN_OCCUPANCY": 0.25,
+        "EXPRESSION_PLAN_CACHE_SIZE": 1024,
+        "ENABLE_DIRECT_CACHE_EDGES": True,
+        "ENABLE_ADAPTIVE_BATCH_COALESCING": False,
+        "ENABLE_LATE_MATERIALIZATION": False,
+        "ENABLE_MATERIALIZATION_CACHE": False,
+        "MATERIALIZATION_CACHE_MAX_BYTES": 1073741824,
+        "TABLE_CACHE_MAX_BYTES": 4294967296,
+        "ENABLE_COMMON_SUBPLAN_REUSE": True,
+        "ENABLE_METADATA_AGGREGATION": True,
+        "ENABLE_SQL_PUSHDOWN": True,
+        "OUTPUT_FILE_MAX_BYTES": 268435456,
+        "RESULT_ITERATOR_MAX_BATCHES": 4,
+        "RESULT_CURSOR_TTL_MS": 600000,
+        "ENABLE_TRACING": False,
+        "FLOW_CONTROL_BYTES_THRESHOLD": 0,
+        "FLOW_CONTROL_MAX_WAIT_MS": 5000,
         "MAX_ORDER_BY_SAMPLES_PER_NODE": 10000,
+        "TOP_K_MAX_ROWS": 10000,
         "BLAZING_PROCESSING_DEVICE_MEM_CONSUMPTION_THRESHOLD": 0.9,
         "BLAZING_DEVICE_MEM_CONSUMPTION_THRESHOLD": 0.6,
         "BLAZ_HOST_MEM_CONSUMPTION_THRESHOLD": 0.75,
+        "ENABLE_NUMA_AWARE_HOST_POOLS": True,
+        "HOST_CHUNK_THREAD_CACHE_SIZE": 4,
+        "ENABLE_LAZY_HOST_POOLS": False,
+        "HOST_POOL_SIZE_CLASSES": 2,
+        "HOST_POOL_SHRINK_IDLE_MS": 30000,
+        "ENABLE_WARM_WORKERS": True,
         "BLAZING_LOGGING_DIRECTORY": "blazing_log",
         "BLAZING_CACHE_DIRECTORY": "/tmp/",
+        "BLAZING_CACHE_DIRECTORIES": "",
+        "BLAZING_CACHE_DIRECTORY_CAPACITY": 0,
+        "CACHE_SPILL_FORMAT": "ORC",
+        "SPILL_SEGMENT_BYTES": 268435456,
+        "ASYNC_CACHE_DOWNGRADE": True,
+        "ENABLE_HOST_CACHE_COMPRESSION": False,
         "BLAZING_LOCAL_LOGGING_DIRECTORY": "blazing_log",
         "MEMORY_MONITOR_PERIOD": 50,
+        "ALLOCATION_EVICTION_WAIT_MS": 50,
+        "MANAGED_MEMORY_PREFETCH": True,
+        "MANAGED_MEMORY_HOST_ADVICE": False,
+        "DEVICE_POOL_COMPACTION_INTERVAL_MS": 60000,
+        "DEVICE_POOL_COMPACTION_MIN_FRAGMENTATION": 0.5,
         "MAX_KERNEL_RUN_THREADS": 16,
         "EXECUTOR_THREADS": 10,
+        "TASK_SCRATCH_ARENA_BYTES": 16777216,
+        "TASK_FORK_JOIN_STREAMS": 4,
+        "ENABLE_GPU_PARTITION_SIZING": True,
+        "MPS_ACTIVE_THREAD_PERCENTAGE": 0,
+        "MPS_PINNED_DEVICE_MEM_LIMIT": "",
+        "PROJECT_FORK_JOIN_MAX_ROWS": 1000000,
+        "THREAD_AFFINITY_POLICY": "NONE",
+        "THREAD_AFFINITY_COMMS_CORES": 2,
+        "QUERY_PRIORITY": 0,
+        "QUERY_TIMEOUT_MS": 0,
+        "RESOURCE_GROUP": "",
+        "RESOURCE_GROUP_MEMORY_FRACTION": 1.0,
+        "RESOURCE_GROUP_EXECUTOR_THREADS": 0,
         "MAX_SEND_MESSAGE_THREADS": 20,
         "LOGGING_LEVEL": "trace",
         "LOGGING_FLUSH_LEVEL": "warn",
@@ -1243,11 +1713,33 @@ def load_config_options_from_env(user_config_options: dict):
         "ENABLE_COMMS_LOGS": False,
         "ENABLE_TASK_LOGS": False,
         "ENABLE_OTHER_ENGINE_LOGS": False,
+        "ENABLE_MEMORY_TIMELINE_LOGS": False,
+        "ASYNC_EVENT_LOGS": True,
         "LOGGING_MAX_SIZE_PER_FILE": 1073741824,  # 1 GB
         "TRANSPORT_BUFFER_BYTE_SIZE": 1048576,  # 1 MB in bytes
         "TRANSPORT_POOL_NUM_BUFFERS": 1000,
         "PROTOCOL": "AUTO",
         "REQUIRE_ACKNOWLEDGE": False,
+        "COMMUNICATION_COMPRESSION": "AUTO",
+        "ENABLE_GPU_DIRECT_TRANSPORT": False,
+        "ENABLE_DICTIONARY_ENCODED_TRANSPORT": False,
+        "PACKED_TRANSPORT_MIN_COLUMNS": 32,
+        "COALESCE_MESSAGES_BYTES_THRESHOLD": 1048576,  # 1 MB in bytes
+        "COALESCE_MESSAGES_TIMEOUT_MS": 100,
+        "TCP_MAX_CONNECTIONS_PER_NODE": 4,
+        "UCX_PROGRESS_THREAD_CORE": -1,
+        "UCX_NET_DEVICES": "",
+        "UCX_MAX_RAILS": 2,
+        "ENABLE_DEVICE_RECEIVE_PLACEMENT": False,
+        "ENABLE_TREE_BROADCAST": True,
+        "HASH_PARTITIONS_PER_NODE": 1,
+        "JOIN_SKEW_HEAVY_HITTER_THRESHOLD": 0.1,
+        "ENABLE_JOIN_RUNTIME_FILTER": False,
+        "ENABLE_JOIN_LATE_MATERIALIZATION": False,
+        "JOIN_ADAPTIVE_WAIT_MS": 1000,
+        "ENABLE_SORT_MERGE_JOIN": True,
+        "ENABLE_STAR_JOIN": False,
+        "ENABLE_PARTITIONING_REUSE": True,
     }
 
     # key: option_name, value: default_value
@@ -1268,6 +1760,149 @@ def load_config_options_from_env(user_config_options: dict):
     return encoded_config_options
 
 
+class PreparedStatement(object):
+    """
+    A query with ? placeholders in place of its literals, made by
+    BlazingContext.prepare. Its optimized plan is kept by the context for
+    the kinds of parameters it was run with, so that running it again only
+    puts the new literals in the plan instead of planning it again.
+    """
+
+    def __init__(self, context, query, optimizer):
+        self.context = context
+        self.query = query
+        self.optimizer = optimizer
+        self.parts = split_placeholders(query)
+
+    @property
+    def num_parameters(self):
+        return len(self.parts) - 1
+
+    def sql(self, *parameters, **kwargs):
+        """
+        Runs the statement with these values for its placeholders, in order.
+        The other arguments are the ones of BlazingContext.sql.
+
+        Examples
+        --------
+
+        >>> statement = bc.prepare('SELECT * FROM taxi WHERE vendor_id = ?')
+        >>> df = statement.sql(1)
+        >>> df = statement.sql(2)
+        """
+        literals = [to_sql_literal(parameter) for parameter in parameters]
+        query = bind_query(self.parts, literals)
+        algebra = self.context._get_prepared_algebra(self, parameters, literals)
+        return self.context.sql(
+            query, optimizer=self.optimizer, algebra=algebra, **kwargs
+        )
+
+
+class ResultCursor(object):
+    """
+    The result of a query run with cursor=True. Every node keeps its part of
+    the result after the query finished, so that the pages of a sorted result
+    are taken from the nodes whose parts they span, instead of running the
+    query again with a larger OFFSET for every page. The parts are released
+    by close, or once they were not fetched from for RESULT_CURSOR_TTL_MS.
+    """
+
+    def __init__(self, context, token, node_num_rows):
+        self.context = context
+        self.token = token
+        # the workers with the number of rows of their parts, in the order of
+        # the result
+        self._node_num_rows = node_num_rows
+        self.closed = False
+
+    @property
+    def num_rows(self):
+        return sum(num_rows for _, num_rows in self._node_num_rows)
+
+    def fetch(self, offset, num_rows):
+        """
+        Returns the rows [offset, offset + num_rows) of the result as a
+        cudf.DataFrame, fewer at the end of the result.
+
+        Examples
+        --------
+
+        >>> cursor = bc.sql('SELECT * FROM taxi ORDER BY Total_amount',
+                cursor=True)
+        >>> first_page = cursor.fetch(0, 100)
+        >>> second_page = cursor.fetch(100, 100)
+        >>> cursor.close()
+        """
+        if self.closed:
+            raise ValueError("The cursor " + str(self.token) + " was closed")
+        if offset < 0 or num_rows < 0:
+            raise ValueError("offset and num_rows can not be negative")
+
+        dask_client = self.context.dask_client
+        if dask_client is None:
+            return cio.fetchResultCursorCaller(self.token, offset, num_rows)
+
+        futures = []
+        node_offset = 0
+        for worker, node_rows in self._node_num_rows:
+            start = max(offset - node_offset, 0)
+            end = min(offset + num_rows - node_offset, node_rows)
+            if start < end:
+                futures.append(
+                    dask_client.submit(
+                        fetchResultCursor,
+                        self.token,
+                        start,
+                        end - start,
+                        workers=[worker],
+                        pure=False,
+                    )
+                )
+            node_offset += node_rows
+        if len(futures) == 0:
+            # an empty page, with the columns of the result
+            futures.append(
+                dask_client.submit(
+                    fetchResultCursor,
+                    self.token,
+                    0,
+                    0,
+                    workers=[self._node_num_rows[0][0]],
+                    pure=False,
+                )
+            )
+        parts = dask_client.gather(futures)
+        if len(parts) == 1:
+            return parts[0]
+        return cudf.concat(parts, ignore_index=True)
+
+    def close(self):
+        """
+        Releases the parts of the result that the nodes keep.
+        """
+        if self.closed:
+            return
+        self.closed = True
+        dask_client = self.context.dask_client
+        if dask_client is None:
+            cio.closeResultCursorCaller(self.token)
+        else:
+            dask_client.gather(
+                [
+                    dask_client.submit(
+                        closeResultCursor, self.token, workers=[worker], pure=False
+                    )
+                    for worker, _ in self._node_num_rows
+                ]
+            )
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *args):
+        self.close()
+
+
 class BlazingContext(object):
     """
     BlazingContext is the Python API of BlazingSQL. Along with initialization
@@ -1288,9 +1923,13 @@ class BlazingContext(object):
         Network interface used for communicating with the
         dask-scheduler.
         **Default:** ``None``. See note below.
-    :param allocator: string, allowed options are ``"default"``, ``"managed"`` or ``'existing'``.
+    :param allocator: string, allowed options are ``"default"``, ``"managed"``, ``"async"`` or ``'existing'``.
         Where ``"managed"`` uses Unified Virtual Memory (UVM) and may use system memory
-        if GPU memory runs out, or ``"existing"`` where it assumes you have already set the
+        if GPU memory runs out, ``"async"`` uses the stream-ordered allocator of CUDA
+        (requires CUDA 11.2) and keeps track of the memory used by every query
+        (see ``get_query_memory_usage``), ``"binning"`` uses a pool where the allocations of up
+        to 1 MiB are served by bins of their own, which keeps long running workers from
+        fragmenting it, or ``"existing"`` where it assumes you have already set the
         rmm allocator and therefore does not initialize it (this is for advanced users.)
         **Default:** ``"default"``
     :param pool: boolean.
@@ -1337,14 +1976,268 @@ class BlazingContext(object):
                 ``MAX_NUM_ORDER_BY_PARTITIONS_PER_NODE`` will be enforced over
                 this parameter.
                 **Default:** ``400000000``
+            ORDER_BY_MERGE_WINDOW_BYTES: long integer
+                When the sorted runs of an order by partition take more than
+                this size in bytes, they are merged in windows that keep only
+                the next rows of every run in the GPU. 0 always merges them all
+                together.
+                **Default:** a quarter of the processing memory limit
             MAX_DATA_LOAD_CONCAT_CACHE_BYTE_SIZE: long integer
                 The max size in bytes to
                 concatenate the batches read from the scan kernels
                 **Default:** ``400000000``
+            SCAN_TASK_TARGET_BYTES: long integer
+                The scans of whole parquet tables split their files into tasks
+                whose row groups add up to about this uncompressed size in
+                bytes, as told by the metadata of the files, and read the row
+                groups of small files together in one task. The row groups
+                larger than this are read by several tasks, a slice of their
+                rows of about this size each. The uncompressed
+                csv and json lines files larger than this are split at row
+                boundaries into chunks of about this size, unless
+                max_bytes_chunk_read was given. The Arrow and pandas tables
+                larger than this are split into slices of about this size,
+                every one copied to the GPU by a task of its own. 0 reads
+                every file in a task of its own.
+                **Default:** ``268435456``
+            IO_PREFETCH_IN_FLIGHT: integer
+                The number of parquet files or groups of row groups whose
+                footer and column chunks are read ahead into pinned host
+                memory, while the GPU decodes the batches before them, so that
+                the latency of remote filesystems like S3 or GCS is hidden.
+                Every one of them is held until its batch is parsed. 0 turns
+                it off.
+                **Default:** ``0``
+            REMOTE_FILE_CACHE_DIRECTORY: string
+                A directory on a local disk, preferably an SSD, where the byte
+                ranges read from the files of S3 and GCS are kept, so that the
+                datasets that are queried again are not downloaded again. The
+                ranges are keyed by the etag of their files, so a file that
+                changed is always downloaded again.
+                **Default:** ``""``
+            REMOTE_FILE_CACHE_MAX_BYTES: integer
+                The most bytes REMOTE_FILE_CACHE_DIRECTORY holds, after which
+                the least recently used ranges are removed. 0 turns the cache
+                off.
+                **Default:** ``0``
+            OBJECT_UPLOAD_PART_BYTES: integer
+                The size of the parts in which the files written to S3 and GCS
+                are uploaded. S3 takes parts of at least 5 MiB. The part
+                buffers are kept in pinned host memory.
+                **Default:** ``16777216``
+            OBJECT_UPLOAD_CONCURRENCY: integer
+                The number of parts of a file that are uploaded at a time,
+                while the writer fills the next one.
+                **Default:** ``8``
+            OBJECT_STORE_MAX_CONNECTIONS: integer
+                The number of keep-alive connections that the client of every
+                S3 and GCS filesystem keeps in its pool, which all of its files
+                share. It applies to the filesystems registered after the
+                BlazingContext is created.
+                **Default:** ``64``
+            OBJECT_STORE_OPEN_CONCURRENCY: integer
+                The number of files of S3, GCS and HDFS that the scans open at
+                a time, while the file before them is parsed.
+                **Default:** ``16``
+            HDFS_SHORT_CIRCUIT_READS: boolean
+                When enabled, the blocks of HDFS that are on a datanode of the
+                same host are read from its disks instead of through the
+                datanode. The client falls back to the usual reads when it
+                can't. It applies to the HDFS filesystems registered after the
+                context is created.
+                **Default:** ``True``
+            HDFS_DOMAIN_SOCKET_PATH: string
+                The dfs.domain.socket.path of the datanodes for the
+                short-circuit reads. Empty keeps the one of the hdfs-site.xml
+                of the client.
+                **Default:** ``""``
+            HDFS_READ_HANDLES: integer
+                The number of handles every HDFS file is read with, so that
+                its column chunks and large ranges are read with concurrent
+                preads.
+                **Default:** ``4``
+            ENABLE_LOCALITY_AWARE_SCAN: boolean
+                When enabled, the files of the HDFS tables are assigned to the
+                workers on the datanodes that have their blocks, and the files
+                of the tables of local_files that several workers can see to
+                the one of them with the fewest bytes to read, instead of in
+                ranges of the same number of files.
+                **Default:** ``True``
+            LOCALITY_BALANCE_SLACK: float
+                How many more bytes than the average a worker can be given so
+                that a file is read where its data is, as a fraction of the
+                average. The files that don't fit go to the workers with the
+                fewest bytes.
+                **Default:** ``0.1``
+            ENABLE_SCAN_WORK_STEALING: boolean
+                When enabled, the scans of the parquet and orc tables whose
+                files every worker can read (not local_files nor bucketed) ask
+                the other workers for half of the files they did not start yet
+                once they started all of their own, so that a slow worker or
+                one with larger files doesn't make the rest of the cluster wait
+                for it. The files that move to another worker are not read
+                from its local disks.
+                **Default:** ``False``
+            PARQUET_METADATA_CACHE_MAX_FILES: integer
+                The number of parquet files whose footers are kept in memory
+                across queries, keyed by their uri, size and modification time,
+                so that the schema inference and the skip data statistics of
+                the files that did not change don't read their footers again.
+                0 turns it off.
+                **Default:** ``10000``
+            PARQUET_METADATA_CACHE_DIRECTORY: string
+                A directory where the cached parquet footers are also written,
+                so that they outlive the process. Empty keeps them only in
+                memory.
+                **Default:** ``""``
+            FOLDER_LISTING_THREADS: integer
+                The number of folders that are listed at a time when the hive
+                partitions of a table are discovered.
+                **Default:** ``16``
+            FOLDER_LISTING_CACHE_TTL_MS: integer
+                How long the listings of the partition folders are kept, in
+                milliseconds, so that the tables created again in that time
+                don't list their folders again. 0 turns it off.
+                **Default:** ``60000``
+            ENABLE_SHARED_SCANS: boolean
+                When enabled, the queries that run at the same time and read
+                the same row groups of a parquet or orc file share the read,
+                and the scan of a table that another query is scanning
+                starts at the file where that one is and wraps around to the
+                first files, so that both read the same files at once.
+                **Default:** ``True``
+            ENABLE_KERNEL_FUSION: boolean
+                When enabled, the filters that feed a projection are run by
+                the projection kernel in the same task, instead of passing
+                every batch through a cache between both kernels.
+                **Default:** ``True``
+            ENABLE_JIT_EXPRESSIONS: boolean
+                When enabled, the filters and projections of numeric columns
+                are evaluated by CUDA kernels generated for every expression
+                and compiled with NVRTC, instead of the interpreter. Every
+                kernel is compiled once, the first time its expression and
+                input types are seen. The expressions it does not support
+                still use the interpreter.
+                **Default:** ``False``
+            INTERPRETER_MIN_OCCUPANCY: float
+                The fraction of the threads of an SM that the kernel of the
+                interpreter has to keep running. The projections with so many
+                intermediate values that their kernel would run fewer threads,
+                since every thread keeps them in shared memory, are evaluated
+                in several launches with some of their expressions each.
+                ``0`` always evaluates them in one launch.
+                **Default:** ``0.25``
+            EXPRESSION_PLAN_CACHE_SIZE: integer
+                The number of parsed and encoded plans of the expressions
+                of filters and projections that are kept for the batches and
+                queries that run the same expressions on the same input
+                types, and the number of parsed patterns of LIKEs that are
+                kept. 0 turns the caches off.
+                **Default:** ``1024``
+            ENABLE_DIRECT_CACHE_EDGES: boolean
+                When enabled, the caches between a kernel and the single
+                kernel that consumes its output hand off the batches that fit
+                in GPU memory directly, without logging a cache event for
+                every batch. Batches that do not fit are still spilled to
+                host memory or disk.
+                **Default:** ``True``
+            ENABLE_ADAPTIVE_BATCH_COALESCING: boolean
+                When enabled, the scan caches concatenate only as many bytes
+                as the consuming kernel needs to amortize the fixed cost of
+                its tasks, based on how long its previous tasks took. It never
+                goes above MAX_DATA_LOAD_CONCAT_CACHE_BYTE_SIZE.
+                **Default:** ``False``
+            ENABLE_LATE_MATERIALIZATION: boolean
+                When enabled, the scans of parquet and orc files with a filter
+                pushed into them decode the columns of the filter first, and
+                decode the rest of the columns only for the row groups (or
+                stripes) that have rows that pass it.
+                **Default:** ``False``
+            ENABLE_MATERIALIZATION_CACHE: boolean
+                When enabled, the result of every group by that only reads
+                files is kept in host memory, and later queries that run the
+                same group by over the same files (same paths, modification
+                times and sizes) read that result instead of running it
+                again. Only used when running on a single node.
+                **Default:** ``False``
+            MATERIALIZATION_CACHE_MAX_BYTES: long integer
+                The max size in bytes of all the results kept by
+                ENABLE_MATERIALIZATION_CACHE. The least recently used results
+                are evicted when it is exceeded.
+                **Default:** ``1073741824``
+            TABLE_CACHE_MAX_BYTES: long integer
+                The max size in bytes of all the tables kept by cache_table
+                on every node. The least recently used tables are dropped
+                when it is exceeded, and a table bigger than it is not kept.
+                **Default:** ``4294967296``
+            ENABLE_COMMON_SUBPLAN_REUSE: boolean
+                When enabled, a subplan that is used more than once in a
+                query, as a CTE that is read twice or the sides of a self
+                join, runs only once and every batch of it is given to all of
+                its consumers. The batches that the consumers did not read yet
+                are spilled to host memory or disk like in any other cache.
+                **Default:** ``True``
+            ENABLE_METADATA_AGGREGATION: boolean
+                When enabled, the COUNT(*), COUNT, MIN and MAX without a group
+                by of a parquet or orc table are answered from the statistics
+                in the footers of its files, for the row groups whose rows all
+                pass the filter of the scan. The other row groups are read.
+                MIN and MAX are only answered for the integer columns.
+                **Default:** ``True``
+            ENABLE_SQL_PUSHDOWN: boolean
+                When enabled, the databases of the MySQL, PostgreSQL and SQLite
+                tables compute the partial aggregations of the group bys over
+                their scans, for COUNT, SUM, MIN and MAX of columns, and
+                return only the first rows of the sorts and limits over their
+                scans. The aggregations are only pushed down when the filter of
+                the scan is too.
+                **Default:** ``True``
+            OUTPUT_FILE_MAX_BYTES: long integer
+                The size in bytes of the decoded data of every file that the
+                queries with an output_path write, after which the next file
+                is started.
+                **Default:** ``268435456``
+            RESULT_ITERATOR_MAX_BATCHES: integer
+                The number of batches of the result of a query run with
+                return_iterator=True that are kept until the client takes
+                them. Once there are that many, the query waits, and so does
+                the GPU memory it uses.
+                **Default:** ``4``
+            RESULT_CURSOR_TTL_MS: long integer
+                The time in milliseconds that the nodes keep the result of a
+                query run with cursor=True after its last page was fetched,
+                when the cursor is not closed.
+                **Default:** ``600000``
+            ENABLE_TRACING: boolean
+                When enabled, the engine records spans for the tasks, the
+                caches and the communication of the query, and writes them as
+                a Chrome trace (that chrome://tracing or Perfetto can open)
+                named trace.<ral_id>.<query_id>.json into the
+                BLAZING_LOGGING_DIRECTORY when the query finishes.
+                **Default:** ``False``
+            FLOW_CONTROL_BYTES_THRESHOLD: long integer
+                The max size in bytes that the output cache of a scan kernel
+                can hold before the scan stops creating tasks to read more
+                files, until the consumers drain it. If 0, it is the
+                processing memory limit (see
+                BLAZING_PROCESSING_DEVICE_MEM_CONSUMPTION_THRESHOLD) divided
+                by the number of kernels of the query. Set it to
+                18446744073709551615 to turn off the flow control.
+                **Default:** ``0``
+            FLOW_CONTROL_MAX_WAIT_MS: integer
+                The max time in ms that a scan waits for its output cache
+                to be drained. If it expires, the flow control is turned off
+                for that scan.
+                **Default:** ``5000``
             MAX_ORDER_BY_SAMPLES_PER_NODE: integer
                 The max number order by samples
                 to capture per node
                 **Default:** ``10000``
+            TOP_K_MAX_ROWS: integer
+                An ORDER BY with a LIMIT of at most this many rows keeps the
+                first rows of every batch and merges them in the master node,
+                instead of sorting and partitioning all the rows. 0 disables it.
+                **Default:** ``10000``
             BLAZING_PROCESSING_DEVICE_MEM_CONSUMPTION_THRESHOLD: float
                 The percent
                 (as a decimal) of total GPU memory that the memory
@@ -1364,10 +2257,52 @@ class BlazingContext(object):
                 (as a decimal) of total host memory that the memory
                 resource will consider to be full. In the presence of
                 several GPUs per server, this resource will be shared
-                among all of them in equal parts.
+                among all of them in equal parts. The memory of the host
+                and pinned memory pools counts against it, and in a
+                container it is a fraction of the memory the container
+                can still use. When it is crossed, the data of the caches
+                in host memory is moved to disk.
                 **NOTE:** This parameter only works when used in the
                 BlazingContext
                 **Default:** ``0.75``
+            ENABLE_NUMA_AWARE_HOST_POOLS: boolean
+                When enabled, the host and pinned memory pools are placed
+                on the NUMA node that the GPU is attached to, since copies
+                to and from the other node are much slower.
+                **Default:** ``True``
+            HOST_CHUNK_THREAD_CACHE_SIZE: integer
+                The max number of free chunks of the host and pinned
+                memory pools that every thread keeps for itself, so that
+                most allocations don't need to lock the pool. 0 disables
+                these caches.
+                **Default:** ``4``
+            ENABLE_LAZY_HOST_POOLS: boolean
+                When enabled, the memory of the host and pinned memory pools
+                is allocated by the first query that needs it instead of when
+                the engine starts. Otherwise it is allocated while the
+                connections to the other nodes are made.
+                **Default:** ``False``
+            HOST_POOL_SIZE_CLASSES: integer
+                The number of pools of smaller chunks that the host and
+                pinned memory pools have, each one with chunks 4 times
+                smaller than the previous one and no smaller than 64 KiB.
+                The small buffers and the last chunk of every table are
+                taken from the smallest one that fits them, so that they
+                don't hold a whole chunk. 0 disables them.
+                **Default:** ``2``
+            HOST_POOL_SHRINK_IDLE_MS: integer
+                How long, in milliseconds, the host and pinned memory pools
+                keep the memory they grew by once none of it is used. A
+                background thread gives it back afterwards. 0 gives it back
+                as soon as it is not used.
+                **Default:** ``30000``
+            ENABLE_WARM_WORKERS: boolean
+                When enabled, the dask workers keep their engine initialized
+                after a BlazingContext is gone, and a later BlazingContext
+                with the same workers and settings uses it again instead of
+                initializing it, which skips their connections to each other
+                and the allocation of their memory pools.
+                **Default:** ``True``
             BLAZING_LOGGING_DIRECTORY: string
                 A folder path to place all logging
                 files. The path can be relative or absolute.
@@ -1381,6 +2316,52 @@ class BlazingContext(object):
                 **NOTE:** This parameter only works when used in the
                 BlazingContext
                 **Default:** ``'/tmp/'``
+            BLAZING_CACHE_DIRECTORIES: string
+                A comma separated list of folder paths where the files
+                are placed when caching on Disk, i.e. one per drive. The
+                files are spread round robin over the folders, instead
+                of placing them all in BLAZING_CACHE_DIRECTORY.
+                **NOTE:** This parameter only works when used in the
+                BlazingContext
+                **Default:** ``''``
+            BLAZING_CACHE_DIRECTORY_CAPACITY: int
+                The number of bytes that the files of every cache
+                directory can use. When it is 0, a directory can use
+                up to a fraction of the size of its filesystem.
+                **NOTE:** This parameter only works when used in the
+                BlazingContext
+                **Default:** 0
+            CACHE_SPILL_FORMAT: string
+                The format of the files written when caching on Disk.
+                ``'ORC'`` compresses the data, using less disk bandwidth
+                but spending time encoding and decoding it. ``'RAW'``
+                writes the column buffers as they are in GPU memory,
+                staged through pinned host buffers.
+                **Default:** ``'ORC'``
+            SPILL_SEGMENT_BYTES: int
+                The size of the preallocated files that the RAW files
+                cached on Disk by a query are written into, so that a
+                query does not create and remove a file for every table
+                it caches. The ORC files are always files of their
+                own. A table larger than it gets a segment of its own
+                size. The segments of a query are removed once it
+                finishes, fails or is cancelled. When it is 0, every
+                table is written to a file of its own.
+                **NOTE:** This parameter only works when used in the
+                BlazingContext
+                **Default:** 268435456
+            ASYNC_CACHE_DOWNGRADE: boolean
+                When a cache moves a table from GPU to CPU memory, only
+                issue the copies into pinned host buffers on a low
+                priority stream instead of waiting for them. The GPU
+                memory is freed once the copies are done.
+                **Default:** True
+            ENABLE_HOST_CACHE_COMPRESSION: boolean
+                Compress the tables that the caches keep in CPU memory
+                with lz4, so that more of them fit before they are
+                spilled to disk. They are decompressed when they are
+                moved back to the GPU.
+                **Default:** False
             BLAZING_LOCAL_LOGGING_DIRECTORY: string
                 A folder path to place the
                 client logging file on a dask environment. The path can
@@ -1390,16 +2371,131 @@ class BlazingContext(object):
                 **Default:** ``'blazing_log'``
             MEMORY_MONITOR_PERIOD: integer
                 How often the memory monitor checks memory
-                consumption. The value is in milliseconds.
+                consumption. The value is in milliseconds. The monitor
+                also checks it as soon as the GPU memory used goes over
+                its limit or an allocation fails.
+                **Default:** ``50``  (milliseconds)
+            ALLOCATION_EVICTION_WAIT_MS: integer
+                How long, in milliseconds, a GPU allocation that fails
+                waits for the memory monitors of the running queries to
+                move the data of their caches out of the GPU before it is
+                tried again. 0 makes it fail at once.
                 **Default:** ``50``  (milliseconds)
+            MANAGED_MEMORY_PREFETCH: boolean
+                When the GPU memory is managed (allocator "managed"), the
+                inputs of each task are prefetched to the GPU on the stream
+                of the task before the kernel runs, instead of being page
+                faulted in as the kernel touches them.
+                **Default:** True
+            MANAGED_MEMORY_HOST_ADVICE: boolean
+                When the GPU memory is managed, the memory monitor advises
+                the driver to keep the cached tables it would spill in host
+                memory, instead of copying them there. This lets the GPU
+                memory be oversubscribed without copies of our own.
+                **Default:** False
+            DEVICE_POOL_COMPACTION_INTERVAL_MS: integer
+                With the pool allocators, how often, in milliseconds, the
+                pool is checked to be compacted. When nothing is allocated
+                from it, that is between queries, and it is fragmented, it
+                is replaced by a pool made of a single chunk of the size it
+                grew to. The fragmentation of the pool is shown in the
+                memory summary of the logs. 0 turns it off.
+                **Default:** ``60000``  (milliseconds)
+            DEVICE_POOL_COMPACTION_MIN_FRAGMENTATION: float
+                How fragmented the pool needs to be to be compacted: the
+                fraction of its free memory that is not in its largest free
+                block.
+                **Default:** ``0.5``
             MAX_KERNEL_RUN_THREADS: integer
-                The number of threads available to run
-                kernels simultaneously.
+                The number of kernels of a query that can run
+                simultaneously. The kernels that are waiting for their inputs
+                or their tasks don't count, so any number of them can wait.
                 **Default:** ``16``
             EXECUTOR_THREADS: integer
                 The number of threads available to run executor
                 tasks simultaneously.
                 **Default:** ``10``
+            THREAD_AFFINITY_POLICY: string
+                Which cpus the threads of the executor, the kernels and the comms
+                are pinned to. ``'NONE'`` does not pin them. ``'GPU_LOCAL'``
+                pins all of them to the cpus that are local to the GPU.
+                ``'GPU_LOCAL_SPLIT'`` does the same, but gives the comms threads
+                THREAD_AFFINITY_COMMS_CORES of those cpus to themselves. The core
+                of UCX_PROGRESS_THREAD_CORE is left out of both.
+                **Default:** ``'NONE'``
+            THREAD_AFFINITY_COMMS_CORES: integer
+                With THREAD_AFFINITY_POLICY ``'GPU_LOCAL_SPLIT'``, how many of
+                the cpus that are local to the GPU the comms threads get.
+                **Default:** ``2``
+            TASK_SCRATCH_ARENA_BYTES: integer
+                The most GPU memory that every executor thread keeps for
+                the temporaries of its tasks, like the buffers of the
+                interpreter, so that they are not allocated and freed from
+                the pool one by one. 0 turns it off.
+                **Default:** ``16777216``
+            TASK_FORK_JOIN_STREAMS: integer
+                How many streams a task can run its independent columns on at
+                the same time, like the expressions of a projection or the
+                columns of a message that is serialized. ``1`` runs them one
+                after the other.
+                **Default:** ``4``
+            ENABLE_GPU_PARTITION_SIZING: boolean
+                When the engine runs on a MIG instance, or as an MPS client
+                with an active thread percentage, EXECUTOR_THREADS and
+                TASK_FORK_JOIN_STREAMS are taken as the ones for the whole GPU
+                and scaled to the part of its compute that the engine has. The
+                memory thresholds are already fractions of the memory of the
+                MIG instance, or of the MPS memory limit of the client.
+                **Default:** ``True``
+            MPS_ACTIVE_THREAD_PERCENTAGE: integer
+                Sets CUDA_MPS_ACTIVE_THREAD_PERCENTAGE for the engines of this
+                context, so that several of them share a GPU under MPS in a
+                predictable way. MPS only applies it to the CUDA contexts that
+                are made after it is set, so for workers that already use the
+                GPU it has to be in their environment when they start. The
+                engine still sizes its executor by it. 0 leaves it unset.
+                **Default:** ``0``
+            MPS_PINNED_DEVICE_MEM_LIMIT: string
+                Sets CUDA_MPS_PINNED_DEVICE_MEM_LIMIT, like ``'0=8G'``, for the
+                engines of this context, the same way as
+                MPS_ACTIVE_THREAD_PERCENTAGE. Its limit is the memory that the
+                memory thresholds of the engine are fractions of.
+                **Default:** ``''``
+            PROJECT_FORK_JOIN_MAX_ROWS: integer
+                The projections of batches with up to this many rows evaluate
+                their expressions on the TASK_FORK_JOIN_STREAMS streams at the
+                same time, since they leave most of the GPU idle when they are
+                evaluated one after the other.
+                **Default:** ``1000000``
+            QUERY_PRIORITY: integer
+                The priority of the tasks of a query in the executor.
+                Tasks of queries with smaller values are run first. This is
+                useful when set per query, for low latency queries that run
+                concurrently with big ones.
+                **Default:** ``0``
+            QUERY_TIMEOUT_MS: integer
+                The deadline of a query, in milliseconds since it starts
+                running. A query that runs over it is cancelled as with
+                BlazingContext.cancel_query, and raises an error. Set it per
+                query to limit the runaway ones. 0 means no deadline.
+                **Default:** ``0``
+            RESOURCE_GROUP: string
+                The name of the resource group of a query. Queries of the
+                same group share a budget of GPU memory and executor threads,
+                and when the GPU memory is over its limit, only the groups that
+                are over their budget free memory. An empty name means that
+                the query does not belong to a group.
+                **Default:** ``''``
+            RESOURCE_GROUP_MEMORY_FRACTION: float
+                The fraction of the executor processing memory limit that a
+                resource group can use. It is set by the first query that
+                uses the group.
+                **Default:** ``1.0``
+            RESOURCE_GROUP_EXECUTOR_THREADS: integer
+                The number of executor threads that a resource group can use
+                concurrently. 0 means all of them. It is set by the first
+                query that uses the group.
+                **Default:** ``0``
             MAX_SEND_MESSAGE_THREADS: integer
                 The number of threads available to send
                 outgoing messages.
@@ -1432,6 +2528,23 @@ class BlazingContext(object):
                 Enables ``'queries_logger'``, ``'kernels_logger'``,
                 ``'kernels_edges_logger'``, ``'cache_events_logger'`` loggers
                 **Default:** ``False``
+            ENABLE_MEMORY_TIMELINE_LOGS: boolean
+                Enables ``'memory_timeline_logger'`` logger, which records
+                every GPU allocation and deallocation with the query and
+                kernel that made it, the out of memory errors and the spills
+                of the memory monitor. ``pyblazing.apiv2.memory_timeline``
+                turns it into a timeline with the peak contributors.
+                **Default:** ``False``
+            ASYNC_EVENT_LOGS: boolean
+                The lines of the ``'task_logger'``, ``'output_comms'``,
+                ``'input_comms'``, ``'cache_events_logger'`` and
+                ``'memory_timeline_logger'`` loggers are kept in a ring buffer
+                per thread and formatted and written by a background thread,
+                so that these logs barely slow down the queries. Lines are
+                dropped if a ring buffer fills up.
+                **NOTE:** This parameter only works when used in the
+                BlazingContext
+                **Default:** ``True``
             LOGGING_MAX_SIZE_PER_FILE: string
                 Set the max size in bytes for the log files.
                 **NOTE:** This parameter only works when used in the
@@ -1449,6 +2562,176 @@ class BlazingContext(object):
                 by default it will be set by whatever dask client is using (``'tcp'``, ``'ucx'``, ..).
                 **NOTE:** This parameter only works when used in the BlazingContext.
                 **Default:** ``'tcp'``
+            COMMUNICATION_COMPRESSION: string
+                Whether the messages sent to other nodes are compressed with lz4.
+                ``'NONE'`` never compresses them, ``'LZ4'`` always does, and
+                ``'AUTO'`` compresses them when the network is slower than the
+                compression, which is measured as the messages are sent.
+                **NOTE:** This parameter only works when used in the BlazingContext.
+                **Default:** ``'AUTO'``
+            ENABLE_GPU_DIRECT_TRANSPORT: boolean
+                Sends the messages to other nodes straight from GPU memory and
+                receives them into GPU memory, instead of staging them in pinned
+                host buffers. It only applies to the ``'ucx'`` protocol, and UCX
+                has to be able to move CUDA memory (e.g. over NVLink or
+                InfiniBand with GPUDirect RDMA). The messages are not compressed.
+                **NOTE:** This parameter only works when used in the BlazingContext.
+                **Default:** ``False``
+            ENABLE_DICTIONARY_ENCODED_TRANSPORT: boolean
+                Serializes the strings columns with few distinct values as
+                dictionaries, their distinct values and the index of the value
+                of every row, when the messages are sent to other nodes and when
+                the tables are moved to host memory or disk. They are decoded
+                back into strings columns when they are deserialized.
+                **Default:** ``False``
+            PACKED_TRANSPORT_MIN_COLUMNS: integer
+                The tables with at least this many columns are packed into a
+                single buffer, instead of a buffer per column, offsets and null
+                mask, when they are sent to other nodes and when they are moved
+                to host memory or disk. They are unpacked without copying their
+                data. Their strings columns are not dictionary encoded. 0 never
+                packs them.
+                **Default:** ``32``
+            COALESCE_MESSAGES_BYTES_THRESHOLD: long integer
+                The partitions that a kernel scatters to the same node are kept and
+                sent together once they add up to this many bytes, so that there
+                are fewer small messages. ``0`` sends every partition right away.
+                **Default:** ``1048576`` (1 MB)
+            COALESCE_MESSAGES_TIMEOUT_MS: integer
+                The longest time in milliseconds that a partition waits for others
+                to be sent together with it. The partitions are also sent when the
+                kernel finishes scattering.
+                **Default:** ``100``
+            TCP_MAX_CONNECTIONS_PER_NODE: integer
+                With the ``'tcp'`` protocol the connections to the other nodes are
+                kept open and reused. This is how many connections there can be to
+                a node, which is how many messages can be sent to it at the same time.
+                **Default:** ``4``
+            UCX_PROGRESS_THREAD_CORE: integer
+                With the ``'ucx'`` protocol, the cpu core to pin the thread that
+                progresses the ucx worker to. ``-1`` does not pin it.
+                **Default:** ``-1``
+            UCX_NET_DEVICES: string
+                With the ``'ucx'`` protocol, the network devices that the engine
+                of every GPU sends and receives over, in the format of the
+                ``UCX_NET_DEVICES`` env var of UCX (i.e. ``'mlx5_0:1,mlx5_1:1'``).
+                ``'AUTO'`` picks the NICs that are closest to the GPU in the PCIe
+                topology, and the devices of every GPU can be listed like
+                ``'0=mlx5_0:1;1=mlx5_1:1'``, where the GPUs are numbered like
+                ``CUDA_VISIBLE_DEVICES`` numbers them. ``''`` uses the devices
+                that UCX picks.
+                **Default:** ``''``
+            UCX_MAX_RAILS: integer
+                With ``UCX_NET_DEVICES``, the most network devices that the large
+                messages are striped over, and the most that ``'AUTO'`` picks.
+                **Default:** ``2``
+            ENABLE_DEVICE_RECEIVE_PLACEMENT: boolean
+                With the ``'ucx'`` protocol, receives the messages from other nodes
+                straight into GPU memory when there is enough of it, and puts them
+                in the cache of the kernel they go to as GPU tables. Otherwise
+                they are received into pinned host memory. UCX has to be able to
+                write into CUDA memory. Compressed messages always go to the host.
+                **Default:** ``False``
+            ENABLE_TREE_BROADCAST: boolean
+                When a node broadcasts a table, like the small table of a join,
+                it sends it to a few nodes that forward it to the others, down a
+                tree where the nodes of the same host get it from each other.
+                Otherwise it sends it to every other node itself.
+                **Default:** ``True``
+            HASH_PARTITIONS_PER_NODE: integer
+                The group bys and the joins that hash their rows to the nodes
+                split the rows of every node into this many partitions, by
+                their hash. Every partition is then merged or joined by its
+                own tasks, which work on less memory and can run at the same
+                time. A join only pairs the batches of the same partition.
+                **Default:** ``1``
+            JOIN_SKEW_HEAVY_HITTER_THRESHOLD: float
+                The keys that are in more than this fraction of the rows of a
+                sample of the left table of a distributed inner or left join are
+                heavy hitters. Their left rows are not shuffled and the right
+                rows that match them are sent to every node, so a few big keys
+                don't leave all the work to one node. 0 disables it.
+                **Default:** ``0.1``
+            ENABLE_JOIN_RUNTIME_FILTER: boolean
+                When a distributed inner join on one integer key sends its small
+                table to every node, the keys of the small table are gathered in
+                a bloom filter with their min and max, and the scans of the big
+                table drop the rows that can't match. The parquet row groups
+                whose statistics are out of the range of the keys are not read.
+                **Default:** ``False``
+            JOIN_ADAPTIVE_WAIT_MS: int
+                When the sizes of the inputs of a distributed join can't be
+                estimated from their first batches, the join waits up to this
+                many milliseconds for the exact sizes before choosing between
+                sending the small table to every node and a hash partitioning.
+                It chooses as soon as each input has arrived or is already too
+                big to be sent to every node. 0 disables it.
+                **Default:** ``1000``
+            JOIN_HASH_TABLE_CACHE_BYTES: int
+                The bytes of the hash tables of the right batches of an inner
+                or left join that are kept to be probed by all the left batches,
+                instead of being built again for each of them. 0 disables it.
+                **Default:** a quarter of the processing memory limit
+            JOIN_HYBRID_HASH_PARTITION_BYTES: int
+                When the estimates of both sides of a join are bigger than this,
+                both sides are hash partitioned into buckets of about this size,
+                that are spilled as needed and joined one at a time, instead of
+                joining every left batch with every right batch. The buckets
+                that are still too big are partitioned again. 0 disables it.
+                **Default:** a quarter of the processing memory limit
+            JOIN_OUTPUT_CHUNK_BYTES: int
+                The largest piece of the output of an inner or left join that
+                is made at once. The matches of a pair of batches are found
+                first, and their rows are gathered and output in chunks of
+                about this size, so that keys with many matches don't make a
+                huge table. 0 outputs the whole result of a pair at once.
+                **Default:** an eighth of the processing memory limit
+            ENABLE_JOIN_LATE_MATERIALIZATION: boolean
+                The inner joins with a condition that is not only equalities of
+                their keys, like a range of a column, evaluate the rest of
+                their condition on the columns it uses for the matches of their
+                keys first, and only gather the other columns for the rows that
+                pass it.
+                **Default:** ``False``
+            ENABLE_SORT_MERGE_JOIN: boolean
+                In a single node, an inner join on one key whose inputs are both
+                sorts only joins the sorted batches of both sides whose ranges
+                of keys overlap, searching the keys instead of hashing them.
+                **Default:** ``True``
+            ENABLE_STAR_JOIN: boolean
+                In a single node, a chain of inner equijoins where every join is
+                the left input of the next one, like the joins of a fact table
+                with its dimension tables, is done by a single kernel that hashes
+                the right inputs once and probes every batch of the left input
+                against all of them. The right inputs have to fit in GPU memory.
+                **Default:** ``False``
+            ENABLE_PARTITIONING_REUSE: boolean
+                When enabled, a group by whose input was already hashed to the
+                nodes by some of its group columns, as the output of a join on
+                them, is not distributed again, and a join keeps the input that
+                was already hashed by its keys in its node, hashing only the
+                other one. The joins whose output is reused this way always
+                hash both inputs, instead of sending a small one to every node.
+                **Default:** ``True``
+            AGGREGATION_BYPASS_RATIO: float
+                When the first batches of a group by keep more than this
+                fraction of their rows after being aggregated, the next
+                batches are not aggregated before they are distributed. 0
+                always aggregates them.
+                **Default:** 0.9
+            AGGREGATION_ACCUMULATE_BYTES: int
+                When the first batches of a group by are reduced to less than
+                half of their rows, their aggregations are merged with each
+                other until they add up to about this size before they are
+                distributed. 0 disables it.
+                **Default:** an eighth of the processing memory limit
+            AGGREGATION_MERGE_BYTES: int
+                The final merge of a group by merges its batches in groups of
+                about this size as they arrive, and then merges the results in
+                rounds until they fit in one group. When they don't, they are
+                hash partitioned into buckets of this size that are merged on
+                their own. 0 merges all the batches together after they arrive.
+                **Default:** a quarter of the processing memory limit
 
     .. note:: When using BlazingSQL with multiple nodes, you will need to set the
         correct ``network_interface`` your servers are using to communicate with the
@@ -1490,6 +2773,18 @@ class BlazingContext(object):
                 "BLAZING_CACHE_DIRECTORY".encode()
             ].decode()
 
+        # the disk tier can spread its files over several directories
+        self.cache_dir_paths = [self.cache_dir_path]
+        if "BLAZING_CACHE_DIRECTORIES".encode() in self.config_options:
+            cache_dir_paths = self.config_options[
+                "BLAZING_CACHE_DIRECTORIES".encode()
+            ].decode()
+            cache_dir_paths = [
+                path.strip() for path in cache_dir_paths.split(",") if path.strip()
+            ]
+            if len(cache_dir_paths) > 0:
+                self.cache_dir_paths = cache_dir_paths
+
         local_logging_dir_path = "blazing_log"
         if "BLAZING_LOCAL_LOGGING_DIRECTORY".encode() in self.config_options:
             local_logging_dir_path = self.config_options[
@@ -1520,14 +2815,16 @@ class BlazingContext(object):
 
             distributed_initialize_server_directory(self.dask_client, logging_dir_path)
 
-            distributed_remove_orc_files_from_disk(
-                self.dask_client, self.cache_dir_path
-            )
-            #  first lets initialize the root cache_dir_path before initializing the ones for all the individual workers
-            distributed_initialize_server_directory(
-                self.dask_client, self.cache_dir_path
-            )
-            initialize_orc_files_folder(self.dask_client, self.cache_dir_path)
+            all_cache_dir_paths = set([self.cache_dir_path] + self.cache_dir_paths)
+            for cache_dir_path in all_cache_dir_paths:
+                distributed_remove_orc_files_from_disk(
+                    self.dask_client, cache_dir_path
+                )
+                #  first lets initialize the root cache_dir_path before initializing the ones for all the individual workers
+                distributed_initialize_server_directory(
+                    self.dask_client, cache_dir_path
+                )
+                initialize_orc_files_folder(self.dask_client, cache_dir_path)
 
             if network_interface is None:
                 import psutil
@@ -1570,6 +2867,18 @@ class BlazingContext(object):
                 node["communication_port"] = worker_maps[node_name]["port"]
                 self.nodes.append(node)
 
+            # kept to initialize the workers that join later, see update_workers
+            self.network_interface = network_interface
+            self.worker_init_args = {
+                "allocator": allocator,
+                "pool": pool,
+                "initial_pool_size": initial_pool_size,
+                "maximum_pool_size": maximum_pool_size,
+                "enable_logging": enable_logging,
+                "logging_dir_path": logging_dir_path,
+            }
+            self.next_ral_id = len(workers)
+
             i = 0
             dask_futures = []
             for worker in workers:
@@ -1594,6 +2903,8 @@ class BlazingContext(object):
                 )
                 i = i + 1
 
+            # the workers don't need the JVM, so it starts while they initialize
+            start_jvm()
             for connection in dask_futures:
                 ralPort, ralIp, log_path = connection.result()
                 self.node_log_paths.add(log_path)
@@ -1616,8 +2927,10 @@ class BlazingContext(object):
             initialize_server_directory(logging_dir_path, False)
 
             # remove if exists older orc tmp files
-            remove_orc_files_from_disk(self.cache_dir_path)
-            initialize_server_directory(self.cache_dir_path, False)
+            all_cache_dir_paths = set([self.cache_dir_path] + self.cache_dir_paths)
+            for cache_dir_path in all_cache_dir_paths:
+                remove_orc_files_from_disk(cache_dir_path)
+                initialize_server_directory(cache_dir_path, False)
 
             node = {}
             node["worker"] = ""
@@ -1639,6 +2952,7 @@ class BlazingContext(object):
                 is_dask=False,
             )
             self.node_log_paths.add(log_path)
+            start_jvm()
 
         self.fs = FileSystem()
 
@@ -1649,6 +2963,10 @@ class BlazingContext(object):
         self.logs_initialized = False
         self.enable_progress_bar = enable_progress_bar
         self.graphs = OrderedDict()  # token -> graph
+        # (query, optimizer, parameter kinds) -> template of its plan, or None
+        self.plan_templates = OrderedDict()
+        self.plan_templates_max_entries = 256
+        self.workload_recorder = None
 
         # waitForPingSuccess(self.client)
         print("BlazingContext ready")
@@ -1812,7 +3130,7 @@ class BlazingContext(object):
 
     # BEGIN SQL interface
 
-    def explain(self, sql, optimizer="RBO", detail=False):
+    def explain(self, sql, optimizer="RBO", detail=False, analyze=False):
         """
         Returns break down of a given query's Logical Relational Algebra plan.
 
@@ -1821,6 +3139,8 @@ class BlazingContext(object):
 
         sql : string SQL query.
         detail : bool to print physical plan
+        analyze : bool to run the query and return what each kernel of its
+                physical plan did, see explain_analyze.
 
         Examples
         --------
@@ -1862,28 +3182,50 @@ class BlazingContext(object):
 
         Docs: https://docs.blazingdb.com/docs/explain
         """
+        if analyze is True:
+            return self.explain_analyze(sql, optimizer=optimizer)
+
+        algebra, json_plan = self._get_algebra(sql, optimizer)
+        if detail is not True:
+            return algebra
+
         self.lock.acquire()
         try:
-            if optimizer == "RBO":
-                algebra = self.generator.getRelationalAlgebraString(sql)
+            masterIndex = 0
+            ctxToken = random.randint(0, np.iinfo(np.int32).max)
+            if json_plan is None:
+                json_plan = get_json_plan(algebra)
+
+            if self.dask_client is None:
+                physical_plan = cio.runGeneratePhysicalGraphCaller(
+                    masterIndex, ["self"], ctxToken, json_plan
+                )
             else:
-                algebra = self.generator.getRelationalAlgebraCBOString(sql)
-
-            if detail is True:
-                masterIndex = 0
-                ctxToken = random.randint(0, np.iinfo(np.int32).max)
-                algebra = get_json_plan(str(algebra))
+                dummy_nodes = [str(i) for i in range(len(self.nodes))]
+                physical_plan = cio.runGeneratePhysicalGraphCaller(
+                    masterIndex, dummy_nodes, ctxToken, json_plan
+                )
+        finally:
+            self.lock.release()
 
-                if self.dask_client is None:
-                    physical_plan = cio.runGeneratePhysicalGraphCaller(
-                        masterIndex, ["self"], ctxToken, str(algebra)
-                    )
-                else:
-                    dummy_nodes = [str(i) for i in range(len(self.nodes))]
-                    physical_plan = cio.runGeneratePhysicalGraphCaller(
-                        masterIndex, dummy_nodes, ctxToken, str(algebra)
-                    )
+        return format_json_plan(str(physical_plan))
 
+    def _get_algebra(self, sql, optimizer="RBO"):
+        """
+        Returns the relational algebra of a query and the JSON of its plan,
+        the tree that the engine reads. Both come from a single plan of
+        the query: the generator writes the tree, and the relational algebra
+        is the expression of every node of it indented by its depth. The JSON
+        is None when the query could not be planned, and the relational
+        algebra is the message of the error then.
+        """
+        self.lock.acquire()
+        try:
+            json_plan = str(
+                self.generator.getRelationalAlgebraJsonString(
+                    sql, optimizer != "RBO"
+                )
+            )
         except SqlValidationExceptionClass as exception:
             raise Exception(exception.message())
         except SqlSyntaxExceptionClass as exception:
@@ -1893,45 +3235,188 @@ class BlazingContext(object):
         finally:
             self.lock.release()
 
-        if detail is True:
-            return format_json_plan(str(physical_plan))
+        if not json_plan.startswith("{"):
+            return json_plan, None
+        return format_json_plan(json_plan), json_plan
 
-        return str(algebra)
+    def explain_analyze(self, sql, optimizer="RBO"):
+        """
+        Runs a query and returns the tree of the kernels of its physical
+        plan, with what each one of them did. The tree starts at the
+        OutputKernel and every kernel has its inputs in children, with:
+
+        kernel_id, kernel : the id and the name of the kernel.
+        wall_time_ms : how long the kernel ran, from when it started until
+                it finished, waiting for its inputs included.
+        task_time_ms : how long its tasks spent processing their batches,
+                which is the time the kernel used the GPU.
+        input_rows, input_bytes : the ones its tasks processed.
+        output_rows, output_bytes, output_batches : the ones it output.
+        spill_bytes : the ones of its output that were put in host memory
+                or on disk because they did not fit in the GPU.
+        retries : the tasks that failed, like for running out of memory,
+                and were run again.
+        shuffle_bytes : the ones it sent to the other nodes.
+
+        On a cluster the counters are summed over the workers, and the wall
+        time is the longest one of them.
 
-    def add_remove_table(self, tableName, addTable, table=None):
-        need_to_prime = False
-        self.lock.acquire()
-        try:
-            if addTable:
-                need_to_prime = not self.calcite_primed
-                self.db.removeTable(tableName)
-                self.tables[tableName] = table
+        Parameters
+        ----------
 
-                arr = ArrayClass()
-                for order, column in enumerate(table.column_names):
-                    type_id = table.column_types[order]
-                    dataType = ColumnTypeClass.fromTypeId(type_id)
-                    column = ColumnClass(column, dataType, order)
-                    arr.add(column)
-                print("Calling optimizer for table: " + tableName + ", row_count: " + str(table.args["row_count"]))
-                tableJava = TableClass(tableName, self.db, arr, table.args["row_count"])
-                self.db.addTable(tableJava)
-                self.schema = BlazingSchemaClass(self.db)
-                self.generator = RelationalAlgebraGeneratorClass(self.schema)
-            else:
-                self.db.removeTable(tableName)
-                self.schema = BlazingSchemaClass(self.db)
-                self.generator = RelationalAlgebraGeneratorClass(self.schema)
-                del self.tables[tableName]
-        finally:
-            self.lock.release()
+        sql : string SQL query.
+        optimizer (optional) : the optimizer of BlazingContext.explain.
 
-        # this is because if you do multithreaded explains without it ever being called before, it will crash. Dont know why.
-        if need_to_prime:
-            self.explain("select * from " + tableName)
-            self.lock.acquire()
-            self.calcite_primed = True
-            self.lock.release()
+        Examples
+        --------
+
+        >>> tree = bc.explain_analyze(
+        >>>     'SELECT passenger_count, count(*) FROM taxi GROUP BY passenger_count')
+        >>> print(tree["kernel"], tree["wall_time_ms"])
+        >>> for child in tree["children"]:
+        >>>     print(child["kernel"], child["output_rows"], child["spill_bytes"])
+        """
+        ctxToken = self.sql(sql, optimizer=optimizer, return_token=True)
+        if self.dask_client is None:
+            graph = self.graphs[ctxToken]
+            self.fetch(ctxToken)
+            stats = decode_kernel_stats(graph.get_kernel_stats())
+        else:
+            workers = [node["worker"] for node in self.nodes]
+            self.dask_client.gather(
+                [
+                    self.dask_client.submit(
+                        keepQueryKernelStats, ctxToken, workers=[worker], pure=False
+                    )
+                    for worker in workers
+                ]
+            )
+            self.fetch(ctxToken)
+            stats = merge_kernel_stats(
+                self.dask_client.gather(
+                    [
+                        self.dask_client.submit(
+                            popQueryKernelStats, ctxToken, workers=[worker], pure=False
+                        )
+                        for worker in workers
+                    ]
+                )
+            )
+        return kernel_stats_tree(stats)
+
+    def prepare(self, query, optimizer="RBO"):
+        """
+        Prepares a query with ? placeholders for its literals, to run it many
+        times with different values for them.
+
+        The query is planned by Calcite the first time it runs with each
+        kind of parameters, integers or strings, and then the values are only
+        put in its optimized plan. The statements whose plans depend on
+        their values, like the ones of booleans, floats or dates, or the ones
+        whose parameters are folded by the optimizer, are planned every time
+        they run. The plans are dropped when a table is created or dropped.
+
+        Parameters
+        ----------
+
+        query : string SQL query, with a ? in place of every parameter.
+        optimizer (optional) : the optimizer of BlazingContext.explain.
+
+        Examples
+        --------
+
+        >>> statement = bc.prepare(
+        >>>     'SELECT count(*) FROM taxi WHERE passenger_count = ?')
+        >>> for count in range(1, 5):
+        >>>     print(statement.sql(count))
+        """
+        return PreparedStatement(self, query, optimizer)
+
+    def _get_prepared_algebra(self, statement, parameters, literals):
+        kinds = tuple(parameter_kind(parameter) for parameter in parameters)
+        if None in kinds:
+            return self.explain(
+                bind_query(statement.parts, literals), statement.optimizer
+            )
+
+        key = (statement.query, statement.optimizer, kinds)
+        self.lock.acquire()
+        try:
+            planned = key in self.plan_templates
+            template = self.plan_templates.get(key)
+            if planned:
+                self.plan_templates.move_to_end(key)
+        finally:
+            self.lock.release()
+
+        if not planned:
+            try:
+                algebra = self.explain(
+                    sentinel_query(statement.parts, kinds), statement.optimizer
+                )
+                template = make_plan_template(str(algebra), kinds)
+            except Exception:
+                # the placeholder values don't fit where the parameters are,
+                # like strings compared with dates
+                template = None
+            self.lock.acquire()
+            try:
+                self.plan_templates[key] = template
+                while len(self.plan_templates) > self.plan_templates_max_entries:
+                    self.plan_templates.popitem(last=False)
+            finally:
+                self.lock.release()
+
+        if template is None:
+            return self.explain(
+                bind_query(statement.parts, literals), statement.optimizer
+            )
+        return bind_plan(template, literals)
+
+    def add_remove_table(self, tableName, addTable, table=None):
+        need_to_prime = False
+        self.lock.acquire()
+        try:
+            # the plans of the prepared statements depend on the tables
+            self.plan_templates.clear()
+            if addTable:
+                need_to_prime = not self.calcite_primed
+                self.db.removeTable(tableName)
+                self.tables[tableName] = table
+
+                statistics = get_column_statistics(
+                    table.metadata, table.column_names
+                )
+                arr = ArrayClass()
+                for order, column in enumerate(table.column_names):
+                    type_id = table.column_types[order]
+                    dataType = ColumnTypeClass.fromTypeId(type_id)
+                    column = ColumnClass(column, dataType, order)
+                    distinct_count, null_count = statistics[order]
+                    if distinct_count is not None:
+                        column.setDistinctCount(distinct_count)
+                    if null_count is not None:
+                        column.setNullCount(null_count)
+                    arr.add(column)
+                print("Calling optimizer for table: " + tableName + ", row_count: " + str(table.args["row_count"]))
+                tableJava = TableClass(tableName, self.db, arr, table.args["row_count"])
+                self.db.addTable(tableJava)
+                self.schema = BlazingSchemaClass(self.db)
+                self.generator = RelationalAlgebraGeneratorClass(self.schema)
+            else:
+                self.db.removeTable(tableName)
+                self.schema = BlazingSchemaClass(self.db)
+                self.generator = RelationalAlgebraGeneratorClass(self.schema)
+                del self.tables[tableName]
+        finally:
+            self.lock.release()
+
+        # this is because if you do multithreaded explains without it ever being called before, it will crash. Dont know why.
+        if need_to_prime:
+            self.explain("select * from " + tableName)
+            self.lock.acquire()
+            self.calcite_primed = True
+            self.lock.release()
 
     def get_free_memory(self):
         """
@@ -2053,6 +3538,235 @@ class BlazingContext(object):
         else:
             cio.resetMaxMemoryUsedCaller()
 
+    def get_query_memory_usage(self, token, by_kernel=False):
+        """
+        This function returns a dictionary which contains as
+        key the gpuID and as value the current and peak GPU memory
+        used by a query, in bytes.
+        The memory used by every query is only tracked when the
+        BlazingContext was created with ``allocator="async"``.
+
+        Parameters
+        ----------
+        token : the token of the query, as returned by ``sql`` when
+            ``return_token=True``.
+        by_kernel : if ``True``, the value is a dictionary with the
+            memory used by every kernel of the query, by kernel id.
+
+        Example
+        --------
+        >>> from blazingsql import BlazingContext
+        >>> bc = BlazingContext(allocator="async")
+        >>> token = bc.sql("SELECT * FROM my_table", return_token=True)
+        >>> result = bc.fetch(token)
+        >>> print(bc.get_query_memory_usage(token))
+                {0: {'current': 0, 'peak': 1596219712}}
+        """
+        caller = (
+            cio.getKernelMemoryUsageCaller
+            if by_kernel
+            else cio.getQueryMemoryUsageCaller
+        )
+        if self.dask_client:
+            dask_futures = []
+            workers_id = []
+            workers = tuple(self.dask_client.scheduler_info()["workers"])
+            for worker_id, worker in enumerate(workers):
+                memory_usage = self.dask_client.submit(
+                    caller, token, workers=[worker], pure=False
+                )
+                dask_futures.append(memory_usage)
+                workers_id.append(worker_id)
+            aslist = self.dask_client.gather(dask_futures)
+            return dict(zip(workers_id, aslist))
+        else:
+            return {0: caller(token)}
+
+    def get_transport_metrics(self):
+        """
+        This function returns a dictionary which contains as
+        key the gpuID and as value the metrics of the messages that
+        it exchanged with every other node, by worker id, since the
+        BlazingContext was created: the bytes and messages sent and
+        received, the messages that are waiting to be sent, and a
+        histogram of how long the sends took. Bucket ``i`` of
+        ``send_latency_histogram`` counts the sends that took less
+        than ``2**i`` microseconds, and the last one all the slower
+        ones. They are always collected, so they can be used to find
+        slow links and imbalanced shuffles.
+
+        Example
+        --------
+        >>> from blazingsql import BlazingContext
+        >>> bc = BlazingContext(dask_client=client, network_interface="ib0")
+        >>> result = bc.sql("SELECT * FROM a JOIN b ON a.id = b.id")
+        >>> print(bc.get_transport_metrics()[0]["1"]["bytes_sent"])
+                1596219712
+        """
+        if self.dask_client:
+            dask_futures = []
+            workers_id = []
+            workers = tuple(self.dask_client.scheduler_info()["workers"])
+            for worker_id, worker in enumerate(workers):
+                metrics = self.dask_client.submit(
+                    cio.getTransportMetricsCaller, workers=[worker], pure=False
+                )
+                dask_futures.append(metrics)
+                workers_id.append(worker_id)
+            aslist = self.dask_client.gather(dask_futures)
+            return dict(zip(workers_id, aslist))
+        else:
+            return {0: cio.getTransportMetricsCaller()}
+
+    def get_allocation_pool_stats(self):
+        """
+        This function returns a dictionary which contains as
+        key the gpuID and as value the usage of the host memory pools
+        of that worker, by pool: ``host``, ``pinned`` and, when the
+        object store uploads are enabled, ``upload``. For every pool
+        it has the bytes that are allocated, the ones of the chunks
+        in use and free, the most bytes that were in use at once
+        (``high_water_bytes``), and how many times the pool grew and
+        gave memory back. They help to size HOST_MEMORY_BUFFERS_SIZE,
+        HOST_POOL_SIZE_CLASSES and HOST_POOL_SHRINK_IDLE_MS.
+
+        Example
+        --------
+        >>> from blazingsql import BlazingContext
+        >>> bc = BlazingContext()
+        >>> result = bc.sql("SELECT * FROM a JOIN b ON a.id = b.id")
+        >>> print(bc.get_allocation_pool_stats()[0]["pinned"]["high_water_bytes"])
+                104857600
+        """
+        if self.dask_client:
+            dask_futures = []
+            workers_id = []
+            workers = tuple(self.dask_client.scheduler_info()["workers"])
+            for worker_id, worker in enumerate(workers):
+                stats = self.dask_client.submit(
+                    cio.getAllocationPoolStatsCaller, workers=[worker], pure=False
+                )
+                dask_futures.append(stats)
+                workers_id.append(worker_id)
+            aslist = self.dask_client.gather(dask_futures)
+            return dict(zip(workers_id, aslist))
+        else:
+            return {0: cio.getAllocationPoolStatsCaller()}
+
+    def get_runtime_metrics(self):
+        """
+        This function returns a dictionary which contains as
+        key the gpuID and as value the runtime metrics of that worker
+        in the OpenMetrics text format: the tasks queued and running
+        in its executor, a histogram of how long its tasks took, the
+        OOM retries, the memory used in the GPU, host and disk tiers,
+        the tables and bytes spilled to the host and the disk and
+        moved back into the GPU, the bytes and messages exchanged with
+        every other node, and the progress of the kernels of the
+        queries that are running. The counters are totals since the
+        worker started, so the rates are computed by the scraper.
+
+        Example
+        --------
+        >>> from blazingsql import BlazingContext
+        >>> bc = BlazingContext()
+        >>> print(bc.get_runtime_metrics()[0])
+                # TYPE blazingsql_executor_queued_tasks gauge
+                ...
+        """
+        if self.dask_client:
+            dask_futures = []
+            workers_id = []
+            workers = tuple(self.dask_client.scheduler_info()["workers"])
+            for worker_id, worker in enumerate(workers):
+                metrics = self.dask_client.submit(
+                    cio.getRuntimeMetricsCaller, workers=[worker], pure=False
+                )
+                dask_futures.append(metrics)
+                workers_id.append(worker_id)
+            aslist = self.dask_client.gather(dask_futures)
+            return dict(zip(workers_id, aslist))
+        else:
+            return {0: cio.getRuntimeMetricsCaller()}
+
+    def start_metrics_server(self, port=9400, host=""):
+        """
+        Serves the runtime metrics of all the workers on
+        ``http://<host>:<port>/metrics`` from a thread of this process,
+        for Prometheus to scrape. Every sample has the gpuID of its
+        worker as its ``worker`` label, see get_runtime_metrics. The
+        metrics are collected from the workers on every scrape.
+        Returns the server, ``shutdown()`` stops it.
+
+        Example
+        --------
+        >>> from blazingsql import BlazingContext
+        >>> bc = BlazingContext(dask_client=client, network_interface="ib0")
+        >>> server = bc.start_metrics_server(9400)
+        """
+        return start_metrics_server(
+            lambda: merge_openmetrics(self.get_runtime_metrics()), port, host
+        )
+
+    def start_workload_capture(self, bundle_dir):
+        """
+        Starts recording the tables that are created and dropped and the
+        queries that are run, with their SQL, algebra, config_options and
+        when they started and how long they took, into a bundle directory.
+        The bundle can then be replayed, on another cluster or build, with
+        the same concurrency and timing, see replay_workload. The tables
+        created from DataFrames are recorded without their data.
+
+        Example
+        --------
+        >>> bc.start_workload_capture("/tmp/workload")
+        >>> bc.sql("SELECT COUNT(*) FROM taxi")
+        >>> bc.stop_workload_capture()
+        """
+        self.stop_workload_capture()
+        self.workload_recorder = WorkloadRecorder(
+            bundle_dir, self.config_options, len(self.nodes)
+        )
+
+    def stop_workload_capture(self):
+        """
+        Stops recording the workload, see start_workload_capture.
+        """
+        if self.workload_recorder is not None:
+            self.workload_recorder.close()
+            self.workload_recorder = None
+
+    def replay_workload(
+        self, bundle_dir, speed=1.0, tables={}, use_algebra=True, timing=True
+    ):
+        """
+        Replays a bundle recorded by start_workload_capture on this
+        BlazingContext: every thread that made events in the capture gets a
+        thread that makes them again in the same order, and each one when
+        the same time passed since the replay started (divided by speed).
+        The results are discarded, and the queries that wrote their results
+        to output_path return them instead. The tables that were created
+        from DataFrames have to be given in tables, by table name.
+
+        Returns a list with the event, duration in the capture, duration in
+        the replay and error of every event.
+        ``python -m pyblazing.apiv2.workload replay <bundle>`` replays a
+        bundle on a new BlazingContext with the config_options of the
+        capture and prints the queries that got slower.
+
+        Example
+        --------
+        >>> results = bc.replay_workload("/tmp/workload", speed=2.0)
+        """
+        return replay_workload(
+            self,
+            bundle_dir,
+            speed=speed,
+            tables=tables,
+            use_algebra=use_algebra,
+            timing=timing,
+        )
+
     def create_table(self, table_name, input, **kwargs):
         """
         Create a BlazingSQL table.
@@ -2074,6 +3788,25 @@ class BlazingContext(object):
         get_metadata (optional) : boolean, to use parquet and orc metadata,
                       defaults to True. When set to False it will skip
                       the process of getting metadata.
+        from_flight (optional) : string with the command of the Arrow Flight
+                      to read, in which case input is the location of the
+                      flight service. The endpoints of the flight are split
+                      between the workers.
+        flight_batch_bytes (optional) : the record batches of a flight are
+                      concatenated into tables of about this many bytes
+                      before they are copied to the GPU, defaults to 256 MB.
+        bucket_by (optional) : string with the name of the column the files
+                      are bucketed by, when the rows were split into
+                      num_buckets files by the hash of that column, as
+                      Spark and Hive do with bucketBy and CLUSTERED BY.
+                      The files of the same bucket of all the tables
+                      bucketed the same way are read by the same worker,
+                      so that the joins and the group bys on their bucket
+                      columns don't shuffle their inputs.
+        num_buckets (optional) : the number of buckets of bucket_by.
+        bucket_hash (optional) : string with the name of the hash function
+                      of the buckets, defaults to "murmur3". The tables are
+                      only co-bucketed when they use the same one.
 
         Examples
         --------
@@ -2105,10 +3838,17 @@ class BlazingContext(object):
         <pyblazing.apiv2.context.BlazingTable at 0x7f09264c0310>
 
 
+        Create table from the flight of an Arrow Flight service:
+
+        >>> bc.create_table('taxi', 'grpc://localhost:8815',
+        >>>     from_flight='yellow_taxi')
+
+
         Docs: https://docs.blazingdb.com/docs/create_table
         """
 
         kwargs_validation(kwargs, "create_table")
+        captured_kwargs = dict(kwargs)
 
         get_blazing_logger(is_dask=False).info("create_table start for " + table_name)
 
@@ -2320,7 +4060,11 @@ class BlazingContext(object):
                 )
             else:
                 table = BlazingTable(table_name, input, DataType.CUDF)
-        elif isinstance(input, list) and "from_sql" not in kwargs:
+        elif (
+            isinstance(input, list)
+            and "from_sql" not in kwargs
+            and "from_flight" not in kwargs
+        ):
             input = resolve_relative_path(input)
 
             # if we are using user defined partitions without hive,
@@ -2453,6 +4197,33 @@ class BlazingContext(object):
                     dtypes_list.append(dtype_str)
             table.args["dtype"] = dtypes_list
 
+            if "bucket_by" in kwargs:
+                if table.local_files is not False:
+                    raise ValueError(
+                        "ERROR: the bucketed tables can not have local_files"
+                    )
+                if "num_buckets" not in kwargs:
+                    raise ValueError("ERROR: bucket_by needs num_buckets")
+                table.set_bucketing(
+                    kwargs["bucket_by"],
+                    kwargs["num_buckets"],
+                    kwargs.get("bucket_hash", "murmur3"),
+                    len(self.nodes),
+                )
+
+            if (
+                table.local_files is False
+                and table.bucket_ids is None
+                and len(self.nodes) > 1
+                and any(file.startswith("hdfs://") for file in table.files)
+            ):
+                self._assign_files_by_locality(table)
+
+            if table.local_files is False and table.bucket_ids is None:
+                # every worker can read the files, so the scans can give them
+                # to each other, see ENABLE_SCAN_WORK_STEALING
+                table.args["shareable_files"] = True
+
             if table.local_files is False:
                 table.slices = table.getSlices(len(self.nodes))
             else:
@@ -2541,8 +4312,26 @@ class BlazingContext(object):
             print(parsedSchema["row_count"])
             table.row_count = parsedSchema["row_count"]
             table.args["row_count"] = parsedSchema["row_count"]
+        if "from_flight" in kwargs:
+            kwargs["flight_location"] = input[0]
+            parsedSchema, _ = self._parseSchema(
+                input, "flight", kwargs, extra_columns, False, False
+            )
+            table = BlazingTable(
+                table_name,
+                input,
+                DataType.ARROW_FLIGHT,
+                args=kwargs,
+                client=self.dask_client,
+            )
+            table.column_names = parsedSchema["names"]
+            table.column_types = parsedSchema["types"]
         if table is not None:
             self.add_remove_table(table_name, True, table)
+            if self.workload_recorder is not None:
+                self.workload_recorder.record_table(
+                    table_name, input, captured_kwargs, table
+                )
 
     def drop_table(self, table_name):
         """
@@ -2564,7 +4353,124 @@ class BlazingContext(object):
         Docs:
         https://docs.blazingdb.com/docs/using-blazingsql#section-drop-tables
         """
+        if table_name in self.tables and "cache_columns" in self.tables[table_name].args:
+            self.uncache_table(table_name)
         self.add_remove_table(table_name, False)
+        if self.workload_recorder is not None:
+            self.workload_recorder.record_drop_table(table_name)
+
+    def cache_table(self, table_name, columns=None, index_columns=None):
+        """
+        Keeps the columns of a table in GPU memory across queries, so that
+        the scans of the next queries read them without decoding the files
+        again. The columns are decoded once, by a query run here, and by any
+        query whose scan reads all of them when they are not cached yet.
+        When the GPU memory is needed they are moved to host memory and then
+        to disk after the data of the running queries, and moved back into
+        the GPU when a scan reads them. They are dropped when the files of
+        the table change. Only tables of files are cached.
+
+        Parameters
+        ----------
+
+        table_name : string of the table name to cache.
+        columns : list of the names of the columns to cache, by default all of
+            them. Queries that read other columns read the files.
+        index_columns : list of the names of cached columns to index. The
+            rows of a filter that compares an indexed column with literals,
+            as in equalities, IN lists or ranges, are found with a binary
+            search of the sorted keys of the column, and only those rows are
+            filtered. The index takes the size of the column and of a row id
+            for every row.
+
+        Examples
+        --------
+
+        >>> bc.create_table('taxi', '/home/user/taxi/*.parquet')
+        >>> bc.cache_table('taxi', columns=['passenger_count', 'fare_amount'])
+        >>> result = bc.sql(
+        >>>     'SELECT passenger_count, avg(fare_amount) FROM taxi GROUP BY passenger_count')
+
+        >>> bc.cache_table('orders', index_columns=['o_orderkey'])
+        >>> result = bc.sql('SELECT * FROM orders WHERE o_orderkey = 1234')
+        """
+        if table_name not in self.tables:
+            raise ValueError("ERROR: Not found table: " + str(table_name))
+        table = self.tables[table_name]
+        if table.fileType in (DataType.CUDF, DataType.DASK_CUDF, DataType.ARROW):
+            raise ValueError(
+                "ERROR: cache_table only caches tables created from files"
+            )
+        column_names = list(table.column_names)
+        if columns is None:
+            columns = column_names
+        column_indices = []
+        for column in columns:
+            if column not in column_names:
+                raise ValueError(
+                    "ERROR: Not found column: "
+                    + str(column)
+                    + " in table: "
+                    + str(table_name)
+                )
+            column_indices.append(column_names.index(column))
+        index_column_indices = []
+        for column in index_columns or []:
+            if column not in columns:
+                raise ValueError(
+                    "ERROR: The index column: " + str(column) + " is not cached"
+                )
+            index_column_indices.append(column_names.index(column))
+        # the args can be shared with other tables
+        table.args = dict(table.args)
+        table.args["cache_columns"] = ",".join(str(i) for i in column_indices)
+        table.args["index_columns"] = ",".join(str(i) for i in index_column_indices)
+
+        # the scan of this query decodes the columns and puts them in the cache
+        self.sql(
+            "SELECT "
+            + ", ".join('"' + column_names[i] + '"' for i in column_indices)
+            + " FROM "
+            + table_name
+        )
+
+    def uncache_table(self, table_name):
+        """
+        Drops the columns of a table that were kept in GPU memory by
+        cache_table, and returns the table to be read from its files.
+
+        Parameters
+        ----------
+
+        table_name : string of the table name to uncache.
+
+        Examples
+        --------
+
+        >>> bc.uncache_table('taxi')
+        """
+        if table_name in self.tables:
+            table = self.tables[table_name]
+            table.args = {
+                key: value
+                for key, value in table.args.items()
+                if key not in ("cache_columns", "index_columns")
+            }
+        if self.dask_client:
+            dask_futures = []
+            workers = tuple(self.dask_client.scheduler_info()["workers"])
+            for worker in workers:
+                dask_futures.append(
+                    self.dask_client.submit(
+                        cio.uncacheTableCaller,
+                        table_name.encode(),
+                        workers=[worker],
+                        pure=False,
+                    )
+                )
+            self.dask_client.gather(dask_futures)
+        else:
+            cio.uncacheTableCaller(table_name.encode())
 
     def list_tables(self):
         """
@@ -2619,6 +4525,98 @@ class BlazingContext(object):
         else:
             raise ValueError("ERROR: Not found table: " + str(table_name))
 
+    def _get_locality_options(self):
+        enabled = self.config_options.get(
+            "ENABLE_LOCALITY_AWARE_SCAN".encode(), b"True"
+        ).decode()
+        slack = self.config_options.get(
+            "LOCALITY_BALANCE_SLACK".encode(), b"0.1"
+        ).decode()
+        return enabled != "False", float(slack)
+
+    def _assign_files_by_locality(self, table):
+        """
+        Assigns the files of a table of HDFS to the workers on the datanodes
+        that have their blocks, see locality.assign_files. The files are left
+        in the ranges of getSlices when their locations can't be got, or none
+        of their data is on the hosts of the workers.
+        """
+        enabled, slack = self._get_locality_options()
+        if not enabled:
+            return
+
+        worker = tuple(self.dask_client.scheduler_info()["workers"])[0]
+        try:
+            locations = self.dask_client.submit(
+                cio.getFileLocationsCaller, table.files, workers=[worker], pure=False
+            ).result()
+        except Exception as e:
+            get_blazing_logger(is_dask=False).warning(
+                "could not get the block locations of the table "
+                + table.name
+                + ": "
+                + str(e)
+            )
+            return
+
+        candidates = [
+            get_slice_candidates(location["host_bytes"], self.nodes)
+            for location in locations
+        ]
+        if not any(candidates):
+            return
+        sizes = [location["size"] for location in locations]
+        file_slices = assign_files(sizes, candidates, len(self.nodes), slack=slack)
+        table.set_locality(file_slices, len(self.nodes))
+
+    def _assign_local_files(self, worker_files):
+        """
+        Get the files that every worker reads, of the ones that each worker
+        can see (the tables of local_files). A file that several workers can
+        see, as the ones on the disks of a host with more than one GPU, goes
+        to the one of them with the fewest bytes to read.
+        """
+        enabled, slack = self._get_locality_options()
+        workers = list(worker_files)
+        file_workers = {}
+        for i, worker in enumerate(workers):
+            for file in worker_files[worker]:
+                file_workers.setdefault(file, []).append(i)
+
+        if not enabled or all(len(w) == 1 for w in file_workers.values()):
+            # every file goes to the first worker that can see it
+            all_files = {worker: [] for worker in workers}
+            for file, file_worker_indices in file_workers.items():
+                all_files[workers[file_worker_indices[0]]].append(file)
+            return all_files
+
+        dask_futures = [
+            self.dask_client.submit(
+                cio.getFileLocationsCaller,
+                worker_files[worker],
+                workers=[worker],
+                pure=False,
+            )
+            for worker in workers
+        ]
+        file_sizes = {}
+        for worker, future in zip(workers, dask_futures):
+            for file, location in zip(worker_files[worker], future.result()):
+                file_sizes[file] = location["size"]
+
+        files = list(file_workers)
+        sizes = [file_sizes[file] for file in files]
+        candidates = [
+            {i: file_sizes[file] for i in file_workers[file]} for file in files
+        ]
+        file_slices = assign_files(
+            sizes, candidates, len(workers), strict=True, slack=slack
+        )
+        all_files = {worker: [] for worker in workers}
+        for file, slice_index in zip(files, file_slices):
+            all_files[workers[slice_index]].append(file)
+        return all_files
+
     def _parseSchema(
         self,
         input,
@@ -2647,6 +4645,7 @@ class BlazingContext(object):
                     "mysql",
                     "postgresql",
                     "sqlite",
+                    "flight",
                 ]:
                     raise Exception(
                         "ERROR: The file pattern specified did not match any files"
@@ -2676,34 +4675,17 @@ class BlazingContext(object):
                 # After listing the files accessible by each worker, it could
                 # happen that several workers that were started from the same
                 # node have more than one shared file.
-                # So, to avoid duplicate reads, we will group the files by node
-                # as long as the current file does not already exist in another
-                # group.
+                # So, to avoid duplicate reads, every file is read by only
+                # one of the workers that can see it, see _assign_local_files.
                 return_object = {}
-                all_files = {}
+                worker_files = {}
                 for future, worker in dask_futures:
                     result = future.result()
 
                     for key in result:
                         if key == "files":
-                            # Remove possible duplicated files
-                            # TODO: This duplicate removal mechanism must
-                            # be revisited, consider scenarios of very
-                            # varied topologies.
-                            # A possible improvement is that if it is detected
-                            # that several workers are effectively inside a node
-                            # and have access to the same files, the files
-                            # should be distributed evenly among all of them.
-                            if key in return_object:
-                                all_files[worker] = []
-
-                                for file_item in result[key]:
-                                    if file_item not in return_object[key]:
-                                        all_files[worker].append(file_item)
-                            else:
-                                all_files[worker] = result[key]
-                                return_object[key] = {}
-
+                            worker_files[worker] = result[key]
+                            return_object.setdefault(key, {})
                             return_object[key].update(dict.fromkeys(result[key], None))
                         else:
                             if key not in return_object or (
@@ -2715,7 +4697,7 @@ class BlazingContext(object):
                         "ERROR: The file pattern specified did not match any files"
                     )
                 return_object["files"] = list(return_object["files"])
-                return return_object, all_files
+                return return_object, self._assign_local_files(worker_files)
         else:
             parsed_schema = cio.parseSchemaCaller(
                 input, file_format_hint, kwargs, extra_columns, ignore_missing_paths
@@ -2830,6 +4812,26 @@ class BlazingContext(object):
 
         return (all_sliced_files, all_sliced_uri_values, all_sliced_row_groups_ids)
 
+    def _sliceFilesByBucket(
+        self, numSlices, files, uri_values, row_groups_ids, bucket_ids
+    ):
+        # the files of a bucketed table are not split by their row groups,
+        # every bucket goes to the same slice as in BlazingTable.getSlices.
+        # It also keeps the files of set_locality in their slices, since
+        # their slices are their own buckets
+        all_sliced_files = [[] for i in range(numSlices)]
+        all_sliced_uri_values = [[] for i in range(numSlices)]
+        all_sliced_row_groups_ids = [[] for i in range(numSlices)]
+
+        for i in range(len(files)):
+            slice_index = bucket_ids[i] % numSlices
+            all_sliced_files[slice_index].append(files[i])
+            if uri_values is not None and i < len(uri_values):
+                all_sliced_uri_values[slice_index].append(uri_values[i])
+            all_sliced_row_groups_ids[slice_index].append(row_groups_ids[i])
+
+        return (all_sliced_files, all_sliced_uri_values, all_sliced_row_groups_ids)
+
     def _optimize_skip_data_getSlices(self, current_table, scan_table_query):
         nodeFilesList = []
 
@@ -2856,6 +4858,8 @@ class BlazingContext(object):
             actual_files = []
             uri_values = []
             row_groups_ids = []
+            bucket_ids = []
+            locality_slices = []
 
             if (
                 not file_indices_and_rowgroup_indices.empty
@@ -2868,6 +4872,10 @@ class BlazingContext(object):
                 for group_id in grouped.groups:
                     row_indices = grouped.groups[group_id].values.tolist()
                     actual_files.append(current_table.files[group_id])
+                    if current_table.bucket_ids is not None:
+                        bucket_ids.append(current_table.bucket_ids[group_id])
+                    if current_table.locality_slices is not None:
+                        locality_slices.append(current_table.locality_slices[group_id])
                     if group_id < len(current_table.uri_values):
                         uri_values.append(current_table.uri_values[group_id])
                     row_groups_col = file_and_rowgroup_indices[
@@ -2880,6 +4888,8 @@ class BlazingContext(object):
             actual_files = current_table.files
             uri_values = current_table.uri_values
             row_groups_ids = current_table.row_groups_ids
+            bucket_ids = current_table.bucket_ids
+            locality_slices = current_table.locality_slices
 
         if self.dask_client is None:
             curr_calcite = current_table.calcite_to_file_indices
@@ -2900,7 +4910,28 @@ class BlazingContext(object):
             nodeFilesList.append(bt)
 
         else:
-            if current_table.local_files is False:
+            if current_table.bucket_ids is not None:
+                (
+                    all_sliced_files,
+                    all_sliced_uri_values,
+                    all_sliced_row_groups_ids,
+                ) = self._sliceFilesByBucket(
+                    len(self.nodes), actual_files, uri_values, row_groups_ids, bucket_ids
+                )
+            elif current_table.has_locality(len(self.nodes)):
+                # the files stay in the slices of the workers that have their data
+                (
+                    all_sliced_files,
+                    all_sliced_uri_values,
+                    all_sliced_row_groups_ids,
+                ) = self._sliceFilesByBucket(
+                    len(self.nodes),
+                    actual_files,
+                    uri_values,
+                    row_groups_ids,
+                    locality_slices,
+                )
+            elif current_table.local_files is False:
                 (
                     all_sliced_files,
                     all_sliced_uri_values,
@@ -2951,7 +4982,7 @@ class BlazingContext(object):
             "This function has been Deprecated. It is recommended to use ddf.shuffle(on=[colnames])"
         )
 
-    def _get_results_distributed(self, ctxToken):
+    def _get_results_distributed(self, ctxToken, to_client=False):
         self.do_progress_bar(
             ctxToken,
             self._run_progress_bar_distributed,
@@ -2970,11 +5001,16 @@ class BlazingContext(object):
         try:
             meta_results = self.dask_client.gather(dask_futures)
         except Exception as e:
-            distributed_remove_orc_files_from_disk(
-                self.dask_client, self.cache_dir_path, ctxToken
-            )
+            for cache_dir_path in self.cache_dir_paths:
+                distributed_remove_orc_files_from_disk(
+                    self.dask_client, cache_dir_path, ctxToken
+                )
             raise e
 
+        if to_client:
+            self.graphs[ctxToken] = None  # NOTE we need to invalidate the graph
+            return self._receive_results_on_client(meta_results)
+
         futures = []
         for query_partids, meta, worker_id in meta_results:
             for query_partid in query_partids:
@@ -2986,6 +5022,86 @@ class BlazingContext(object):
         self.graphs[ctxToken] = None  # NOTE we need to invalidate the graph
         return dask.dataframe.from_delayed(futures, meta=meta)
 
+    def _receive_results_on_client(self, meta_results):
+        """Has the workers send the parts of the result that they keep
+        straight to the client over UCX, into device memory, or into host
+        memory when the client does not have a GPU"""
+        from numba import cuda
+
+        to_host_memory = not cuda.is_available()
+        worker_ids = [worker_id for _, _, worker_id in meta_results]
+        query_partids_by_worker = {
+            worker_id: query_partids for query_partids, _, worker_id in meta_results
+        }
+        receiver = self.dask_client.sync(
+            start_result_receiver, len(worker_ids), to_host_memory
+        )
+        try:
+            self.dask_client.run(
+                send_query_parts_to_client,
+                query_partids_by_worker,
+                get_client_address(self.dask_client.scheduler.address),
+                receiver.port,
+                to_host_memory,
+                workers=[node["worker"] for node in self.nodes],
+                wait=True,
+            )
+            parts_by_worker = self.dask_client.sync(receiver.wait)
+        finally:
+            # the listener belongs to the event loop of the client
+            self.dask_client.loop.add_callback(receiver.close)
+
+        parts = [part for worker_id in worker_ids for part in parts_by_worker[worker_id]]
+        if to_host_memory:
+            return pyarrow.concat_tables(parts).to_pandas()
+        return cudf.concat(parts, ignore_index=True)
+
+    def _get_incremental_aggregation_state(self, state_dir, algebra, query_tables):
+        """Returns the table of the files of an incremental query that were not
+        aggregated yet, and the files of its state"""
+        if len(query_tables) != 1 or not query_tables[0].files:
+            raise ValueError("Incremental queries need a single table of files")
+        check_incremental_aggregation_plan(algebra)
+
+        table = query_tables[0]
+        fingerprint = hashlib.sha256((table.name + algebra).encode()).hexdigest()
+        manifest_path = os.path.join(state_dir, fingerprint + ".json")
+        manifest = read_incremental_aggregation_manifest(manifest_path)
+
+        def file_name(file):
+            return file.decode() if isinstance(file, bytes) else file
+
+        processed_files = set(manifest["files"])
+        new_indices = [
+            i
+            for i, file in enumerate(table.files)
+            if file_name(file) not in processed_files
+        ]
+
+        new_table = copy.copy(table)
+        new_table.files = [table.files[i] for i in new_indices]
+        if table.uri_values is not None and len(table.uri_values) == len(table.files):
+            new_table.uri_values = [table.uri_values[i] for i in new_indices]
+        if table.row_groups_ids is not None and len(table.row_groups_ids) == len(
+            table.files
+        ):
+            new_table.row_groups_ids = [table.row_groups_ids[i] for i in new_indices]
+        # the metadata of the files is made for all of them
+        new_table.metadata = None
+        new_table.local_files = False
+
+        os.makedirs(state_dir, exist_ok=True)
+        return {
+            "table": new_table,
+            "manifest": manifest_path,
+            "files": manifest["files"]
+            + [file_name(table.files[i]) for i in new_indices],
+            "input": manifest["state"],
+            "output": os.path.join(
+                state_dir, fingerprint + "." + uuid.uuid4().hex + ".parquet"
+            ),
+        }
+
     def _get_results_single_node(self, ctxToken):
         graph = self.graphs[ctxToken]
         self.do_progress_bar(
@@ -2994,13 +5110,119 @@ class BlazingContext(object):
         self.graphs[ctxToken] = None  # NOTE we need to invalidate the graph
         return cio.getExecuteGraphResultCaller(graph, ctxToken, is_single_node=True)
 
+    def _iterate_results_single_node(self, ctxToken):
+        # the query is not waited for, since it holds its batches back until
+        # they are taken
+        graph = self.graphs[ctxToken]
+        self.graphs[ctxToken] = None  # NOTE we need to invalidate the graph
+        finished = False
+        try:
+            while True:
+                df = cio.getExecuteGraphResultBatchCaller(graph, ctxToken)
+                if df is None:
+                    finished = True
+                    return
+                yield df
+        except cio.RunExecuteGraphError as e:
+            finished = True
+            for cache_dir_path in self.cache_dir_paths:
+                remove_orc_files_from_disk(cache_dir_path, ctxToken)
+            raise e
+        finally:
+            if not finished:
+                # the iterator was closed before its end, so the rest of the
+                # result is not needed
+                cio.cancelQueryCaller(ctxToken)
+                try:
+                    while (
+                        cio.getExecuteGraphResultBatchCaller(graph, ctxToken)
+                        is not None
+                    ):
+                        pass
+                except cio.RunExecuteGraphError:
+                    pass
+                for cache_dir_path in self.cache_dir_paths:
+                    remove_orc_files_from_disk(cache_dir_path, ctxToken)
+
+    def _open_result_cursor_single_node(self, ctxToken, ttl_ms):
+        graph = self.graphs[ctxToken]
+        self.do_progress_bar(
+            graph, self._run_progress_bar_single_node, self._wait_completed_single_node,
+        )
+        self.graphs[ctxToken] = None  # NOTE we need to invalidate the graph
+        num_rows = cio.openResultCursorCaller(graph, ctxToken, ttl_ms)
+        return ResultCursor(self, ctxToken, [(None, num_rows)])
+
+    def _open_result_cursor_distributed(self, ctxToken, ttl_ms):
+        self.do_progress_bar(
+            ctxToken,
+            self._run_progress_bar_distributed,
+            self._wait_completed_distributed,
+        )
+
+        workers = [node["worker"] for node in self.nodes]
+        dask_futures = [
+            self.dask_client.submit(
+                openResultCursor, ctxToken, ttl_ms, workers=[worker], pure=False
+            )
+            for worker in workers
+        ]
+        self.graphs[ctxToken] = None  # NOTE we need to invalidate the graph
+        try:
+            num_rows = self.dask_client.gather(dask_futures)
+        except Exception as e:
+            for cache_dir_path in self.cache_dir_paths:
+                distributed_remove_orc_files_from_disk(
+                    self.dask_client, cache_dir_path, ctxToken
+                )
+            raise e
+        # the range partitions of a sort are in the order of the nodes
+        return ResultCursor(self, ctxToken, list(zip(workers, num_rows)))
+
+    def _iterate_results_distributed(self, ctxToken):
+        dask_futures = []
+        for node in self.nodes:
+            worker = node["worker"]
+            dask_futures.append(
+                self.dask_client.submit(
+                    getExecuteGraphResult, ctxToken, workers=[worker], pure=False
+                )
+            )
+        self.graphs[ctxToken] = None  # NOTE we need to invalidate the graph
+
+        try:
+            for future in dask.distributed.as_completed(dask_futures):
+                query_partids, meta, worker_id = future.result()
+                for query_partid in query_partids:
+                    yield self.dask_client.submit(
+                        get_element, query_partid, workers=[worker_id], pure=False,
+                    ).result()
+        except Exception as e:
+            for cache_dir_path in self.cache_dir_paths:
+                distributed_remove_orc_files_from_disk(
+                    self.dask_client, cache_dir_path, ctxToken
+                )
+            raise e
+
     def fetch(self, token):
         if self.dask_client is None:
             return self._get_results_single_node(token)
         return self._get_results_distributed(token)
 
     def sql(
-        self, query, optimizer="RBO", algebra=None, config_options={}, return_token: bool = False,
+        self,
+        query,
+        optimizer="RBO",
+        algebra=None,
+        config_options={},
+        return_token: bool = False,
+        incremental_state_dir=None,
+        output_path=None,
+        output_format="parquet",
+        return_iterator: bool = False,
+        to_client: bool = False,
+        cursor: bool = False,
+        checkpoint_path=None,
     ):
         """
         Query a BlazingSQL table.
@@ -3017,6 +5239,61 @@ class BlazingContext(object):
                     set a specific set of config_options for this query
                     instead of the ones set in BlazingContext.
                     See BlazingContext for more info on this parameter
+        incremental_state_dir (optional) : a directory where the result of
+                    the aggregation of the query is kept, along with the
+                    files of the table it was computed from. A later run of
+                    the same query with the same directory only scans the
+                    files that were added to the table since then, and
+                    merges them with the kept result. It needs a single
+                    GROUP BY of SUM, MIN, MAX and COUNT over the projections
+                    and filters of one table of files that are only
+                    appended to. It is only supported on a single node.
+        output_path (optional) : a folder of any registered filesystem
+                    (like s3://bucket/folder) where every node writes its part
+                    of the result, as the files part-<node>-<n> of about
+                    OUTPUT_FILE_MAX_BYTES each, instead of returning it. The
+                    query then returns the paths of the files that were
+                    written with their number of rows.
+        output_format (optional) : parquet, orc or arrow, the format of the
+                    files written to output_path. The arrow files are Arrow
+                    IPC files for the processes of the same host that read
+                    the result on the CPU: written to a folder of shared
+                    memory, like /dev/shm/result, they are read without
+                    copies with
+                    pyarrow.ipc.open_file(pyarrow.memory_map(file_path)).
+        return_iterator (optional) : when True, the query returns an iterator
+                    of cudf.DataFrame, with the batches of the result as the
+                    engine produces them instead of all of it at the end. The
+                    query waits while RESULT_ITERATOR_MAX_BATCHES batches were
+                    not taken, and it is cancelled if the iterator is closed
+                    before its end. When distributed, it yields the parts of
+                    the result of each worker once that worker is done.
+        to_client (optional) : when True and distributed, the workers send
+                    the parts of the result straight to the client over UCX,
+                    from their GPU to the GPU of the client, and the query
+                    returns a cudf.DataFrame instead of a dask_cudf.DataFrame.
+                    A client without a GPU gets a pandas.DataFrame, which the
+                    workers send from host memory. It can not be used with
+                    return_iterator.
+        cursor (optional) : when True, the query returns a ResultCursor
+                    instead of the result. The nodes keep their parts of the
+                    result after the query finished, so the pages of a sorted
+                    result are fetched with ResultCursor.fetch(offset,
+                    num_rows) from the nodes whose parts they span, instead
+                    of running the query again with LIMIT and OFFSET for every
+                    page. It can not be used with return_token, output_path,
+                    return_iterator or to_client.
+        checkpoint_path (optional) : a folder of any registered filesystem
+                    that all the nodes see, like s3://bucket/checkpoints, where
+                    the nodes keep the partitions that they shuffle. When the
+                    query fails, as when a worker died, running it again with
+                    the same checkpoint_path, on the same tables and the same
+                    number of workers, starts it from the last shuffle that
+                    all the nodes finished instead of from the scans. It is
+                    not restored if the query or its files changed, or if
+                    any of its tables is in memory. The checkpoint is
+                    removed once the query succeeded. It can not be used
+                    with return_token, return_iterator or cursor.
 
         Examples
         --------
@@ -3061,14 +5338,61 @@ class BlazingContext(object):
 
         Docs: https://docs.blazingdb.com/docs/single-gpu
         """
+        if self.workload_recorder is not None:
+            return self.workload_recorder.capture_query(
+                self._sql,
+                query,
+                optimizer,
+                algebra,
+                config_options,
+                self.explain,
+                return_token=return_token,
+                incremental_state_dir=incremental_state_dir,
+                output_path=output_path,
+                output_format=output_format,
+                return_iterator=return_iterator,
+                to_client=to_client,
+                cursor=cursor,
+                checkpoint_path=checkpoint_path,
+            )
+        return self._sql(
+            query,
+            optimizer=optimizer,
+            algebra=algebra,
+            config_options=config_options,
+            return_token=return_token,
+            incremental_state_dir=incremental_state_dir,
+            output_path=output_path,
+            output_format=output_format,
+            return_iterator=return_iterator,
+            to_client=to_client,
+            cursor=cursor,
+            checkpoint_path=checkpoint_path,
+        )
 
+    def _sql(
+        self,
+        query,
+        optimizer="RBO",
+        algebra=None,
+        config_options={},
+        return_token: bool = False,
+        incremental_state_dir=None,
+        output_path=None,
+        output_format="parquet",
+        return_iterator: bool = False,
+        to_client: bool = False,
+        cursor: bool = False,
+        checkpoint_path=None,
+    ):
         # TODO: remove hardcoding
         masterIndex = 0
         nodeTableList = [[] for _ in range(len(self.nodes))]
         fileTypes = []
 
+        json_plan = None
         if algebra is None:
-            algebra = self.explain(query, optimizer)
+            algebra, json_plan = self._get_algebra(query, optimizer)
 
         # when an empty `LogicalValues` appears on the optimized plan
         # there aren't neither BindableTableScan nor TableScan nor Project
@@ -3078,6 +5402,8 @@ class BlazingContext(object):
                 Please double check your query."""
             )
             result = cudf.DataFrame()  # it will return an empty DataFrame
+            if return_iterator:
+                return iter([result])
             return result
 
         if ") OVER (" in algebra:
@@ -3114,6 +5440,81 @@ class BlazingContext(object):
 
         query_tables = [self.tables[table_name] for table_name in table_names]
 
+        incremental_state = None
+        if incremental_state_dir is not None:
+            if self.dask_client is not None or return_token:
+                raise ValueError(
+                    "Incremental queries are only supported on a single node, "
+                    "without return_token"
+                )
+            query_config_options = dict(query_config_options)
+            incremental_state = self._get_incremental_aggregation_state(
+                incremental_state_dir, algebra, query_tables
+            )
+            query_tables = [incremental_state["table"]]
+            query_config_options[
+                "INCREMENTAL_AGGREGATION_STATE_INPUT".encode()
+            ] = incremental_state["input"].encode()
+            query_config_options[
+                "INCREMENTAL_AGGREGATION_STATE_OUTPUT".encode()
+            ] = incremental_state["output"].encode()
+
+        if to_client and return_iterator:
+            raise ValueError("to_client can not be used with return_iterator")
+
+        if return_iterator:
+            if return_token or output_path is not None or incremental_state_dir:
+                raise ValueError(
+                    "return_iterator can not be used with return_token, "
+                    "output_path or incremental_state_dir"
+                )
+            if self.dask_client is None:
+                query_config_options = dict(query_config_options)
+                query_config_options["RETURN_ITERATOR".encode()] = "True".encode()
+
+        if cursor:
+            if (
+                return_token
+                or output_path is not None
+                or incremental_state_dir
+                or return_iterator
+                or to_client
+            ):
+                raise ValueError(
+                    "cursor can not be used with return_token, output_path, "
+                    "incremental_state_dir, return_iterator or to_client"
+                )
+            cursor_ttl_ms = int(
+                query_config_options.get(
+                    "RESULT_CURSOR_TTL_MS".encode(), b"600000"
+                ).decode()
+            )
+
+        query_checkpoint_path = None
+        if checkpoint_path is not None:
+            if return_token or return_iterator or cursor:
+                raise ValueError(
+                    "checkpoint_path can not be used with return_token, "
+                    "return_iterator or cursor"
+                )
+            # every query has its own folder, which its later attempts find again
+            query_checkpoint_path = (
+                checkpoint_path.rstrip("/")
+                + "/"
+                + hashlib.sha1(algebra.encode()).hexdigest()[:16]
+            )
+            query_config_options = dict(query_config_options)
+            query_config_options[
+                "SHUFFLE_CHECKPOINT_PATH".encode()
+            ] = query_checkpoint_path.encode()
+
+        if output_path is not None:
+            if output_format not in ("parquet", "orc", "arrow"):
+                raise ValueError("output_format must be parquet, orc or arrow")
+            query_config_options = dict(query_config_options)
+            query_config_options["OUTPUT_PATH".encode()] = output_path.encode()
+            query_config_options["OUTPUT_FORMAT".encode()] = output_format.encode()
+
         # this was for ARROW tables which are currently deprecated
         # algebra = modifyAlgebraForDataframesWithOnlyWantedColumns(algebra, relational_algebra_steps,self.tables)
 
@@ -3160,6 +5561,7 @@ class BlazingContext(object):
                 query_table.fileType == DataType.MYSQL
                 or query_table.fileType == DataType.SQLITE
                 or query_table.fileType == DataType.POSTGRESQL
+                or query_table.fileType == DataType.ARROW_FLIGHT
             ):
                 if query_table.has_metadata():
                     currentTableNodes = self._optimize_skip_data_getSlices(
@@ -3182,7 +5584,8 @@ class BlazingContext(object):
 
         ctxToken = random.randint(0, np.iinfo(np.int32).max)
 
-        algebra = get_json_plan(algebra)
+        # the plan of the algebra that was given has to be parsed from its indentation
+        algebra = json_plan if json_plan is not None else get_json_plan(algebra)
 
         if self.dask_client is None:
             try:
@@ -3201,16 +5604,32 @@ class BlazingContext(object):
                 cio.startExecuteGraphCaller(graph, ctxToken)
                 self.graphs[ctxToken] = graph
 
+                if return_iterator:
+                    return self._iterate_results_single_node(ctxToken)
+                if cursor:
+                    return self._open_result_cursor_single_node(
+                        ctxToken, cursor_ttl_ms
+                    )
                 if not return_token:
-                    return self._get_results_single_node(ctxToken)
+                    result = self._get_results_single_node(ctxToken)
+                    if incremental_state is not None:
+                        commit_incremental_aggregation_state(incremental_state)
+                    if query_checkpoint_path is not None:
+                        cio.removeShuffleCheckpointCaller(query_checkpoint_path)
+                    return result
                 else:
                     return ctxToken
             except cio.RunExecuteGraphError as e:
-                remove_orc_files_from_disk(self.cache_dir_path, ctxToken)
+                for cache_dir_path in self.cache_dir_paths:
+                    remove_orc_files_from_disk(cache_dir_path, ctxToken)
+                if incremental_state is not None:
+                    discard_incremental_aggregation_state(incremental_state)
                 raise e
             except cio.RunGenerateGraphError as e:
                 raise e
             except Exception as e:
+                if incremental_state is not None:
+                    discard_incremental_aggregation_state(incremental_state)
                 raise e
         else:
             worker_ids = []
@@ -3251,8 +5670,22 @@ class BlazingContext(object):
                 )
 
             self.dask_client.gather(dask_futures)
+            if return_iterator:
+                return self._iterate_results_distributed(ctxToken)
+            if cursor:
+                return self._open_result_cursor_distributed(ctxToken, cursor_ttl_ms)
             if not return_token:
-                return self._get_results_distributed(ctxToken)
+                result = self._get_results_distributed(ctxToken, to_client=to_client)
+                if query_checkpoint_path is not None:
+                    # the folder is shared, so one of the workers removes all of it
+                    worker = tuple(self.dask_client.scheduler_info()["workers"])[0]
+                    self.dask_client.submit(
+                        removeShuffleCheckpoint,
+                        query_checkpoint_path,
+                        workers=[worker],
+                        pure=False,
+                    ).result()
+                return result
             else:
                 return ctxToken
 
@@ -3271,6 +5704,189 @@ class BlazingContext(object):
             return self.graphs[token].query_is_complete()
         return self._is_query_completed_distributed(token)
 
+    def cancel_query(self, token):
+        """
+        Cancels a query that was run with return_token=True, in all the
+        nodes. Its queued tasks are dropped and its caches are emptied, which
+        frees their GPU memory and removes their spill files, and then its
+        kernels stop. Only its tasks that are already running go on until
+        they finish. Fetching its results raises an error.
+
+        Parameters
+        ----------
+
+        token : the token of the query, given by BlazingContext.sql.
+
+        Examples
+        --------
+
+        >>> token = bc.sql('SELECT * FROM big_table ORDER BY a', return_token=True)
+        >>> bc.cancel_query(token)
+        """
+        if token not in self.graphs:
+            raise Exception(
+                "ERROR: The graph associated with the token '"
+                + str(token)
+                + "' does not exists. Please make sure you have a valid token."
+            )
+        if self.graphs[token] is None:  # then the executution was done
+            return
+
+        if self.dask_client is None:
+            cio.cancelQueryCaller(token)
+            try:
+                self._get_results_single_node(token)
+            except cio.RunExecuteGraphError:
+                pass
+            for cache_dir_path in self.cache_dir_paths:
+                remove_orc_files_from_disk(cache_dir_path, token)
+        else:
+            self.dask_client.gather(
+                [
+                    self.dask_client.submit(
+                        cancelQuery, token, workers=[node["worker"]], pure=False
+                    )
+                    for node in self.nodes
+                ]
+            )
+            try:
+                self._get_results_distributed(token)
+            except cio.RunExecuteGraphError:
+                pass
+            except Exception as e:
+                # the error of a worker is raised by dask as its own
+                if "was cancelled because" not in str(e):
+                    raise e
+        self.graphs[token] = None
+
+    def update_workers(self):
+        """
+        Makes the workers that joined the dask cluster since this context was
+        created, or since it was last updated, part of it, and forgets the
+        ones that left. Only the new workers are initialized, and the others
+        add them to the nodes they send to and receive from. The queries that
+        start after this one returns are partitioned over the current
+        workers, and the ones that are running keep their own.
+        It is only supported with the 'tcp' protocol.
+
+        Returns the names of the workers that were added and removed.
+
+        Examples
+        --------
+
+        >>> cluster.scale(8)
+        >>> added, removed = bc.update_workers()
+        """
+        if self.dask_client is None:
+            raise ValueError("update_workers needs a dask client")
+        if self.config_options["PROTOCOL".encode()] != "tcp".encode():
+            raise ValueError(
+                "The workers can only be updated with the 'tcp' protocol"
+            )
+
+        with self.lock:
+            current = list(self.dask_client.scheduler_info()["workers"])
+            known = [node["worker"] for node in self.nodes]
+            added = [worker for worker in current if worker not in known]
+            removed = [worker for worker in known if worker not in current]
+            if len(added) == 0 and len(removed) == 0:
+                return [], []
+
+            remaining = [worker for worker in known if worker not in removed]
+            if len(removed) > 0 and len(remaining) > 0:
+                self.dask_client.gather(
+                    [
+                        self.dask_client.submit(
+                            removeNodeOnWorker,
+                            removed,
+                            workers=[worker],
+                            pure=False,
+                        )
+                        for worker in remaining
+                    ]
+                )
+            self.nodes = [node for node in self.nodes if node["worker"] in remaining]
+
+            worker_maps = {
+                node["worker"]: {"ip": node["ip"], "port": node["communication_port"]}
+                for node in self.nodes
+            }
+            if len(added) > 0:
+                worker_maps.update(
+                    self.dask_client.run(
+                        get_communication_port,
+                        self.network_interface,
+                        workers=added,
+                        wait=True,
+                    )
+                )
+            # the workers plan their queries with the nodes of this mapping
+            self.dask_client.run(
+                set_id_mappings_on_worker,
+                worker_maps,
+                workers=remaining + added,
+                wait=True,
+            )
+
+            distributed_initialize_server_directory(
+                self.dask_client, self.worker_init_args["logging_dir_path"]
+            )
+            ral_ids = {}
+            for worker in added:
+                ral_ids[worker] = self.next_ral_id
+                self.next_ral_id = self.next_ral_id + 1
+                for cache_dir_path in set([self.cache_dir_path] + self.cache_dir_paths):
+                    self.dask_client.submit(
+                        initialize_server_directory,
+                        os.path.join(cache_dir_path, str(ral_ids[worker])),
+                        True,
+                        workers=[worker],
+                        pure=False,
+                    ).result()
+
+            peers = [
+                (ral_ids[worker], worker, worker_maps[worker]) for worker in added
+            ]
+            if len(remaining) > 0 and len(peers) > 0:
+                self.dask_client.gather(
+                    [
+                        self.dask_client.submit(
+                            addNodesOnWorker, peers, workers=[worker], pure=False,
+                        )
+                        for worker in remaining
+                    ]
+                )
+
+            dask_futures = []
+            for worker in added:
+                self.nodes.append(
+                    {
+                        "worker": worker,
+                        "ip": worker_maps[worker]["ip"],
+                        "communication_port": worker_maps[worker]["port"],
+                    }
+                )
+                dask_futures.append(
+                    self.dask_client.submit(
+                        initializeBlazing,
+                        ralId=ral_ids[worker],
+                        worker_id=worker,
+                        networkInterface=self.network_interface,
+                        singleNode=False,
+                        nodes=self.nodes,
+                        config_options=self.config_options,
+                        workers=[worker],
+                        is_dask=True,
+                        pure=False,
+                        **self.worker_init_args,
+                    )
+                )
+            for connection in dask_futures:
+                ralPort, ralIp, log_path = connection.result()
+                self.node_log_paths.add(log_path)
+
+        return added, removed
+
     # END SQL interface
 
     # BEGIN LOG interface
@@ -3373,6 +5989,28 @@ class BlazingContext(object):
                     ["ral_id", "query_id", "source", "sink"],
                     ["int32", "int32", "int32", "int32"],
                 ),
+                "bsql_memory_timeline": (
+                    [
+                        "timestamp",
+                        "event",
+                        "address",
+                        "bytes",
+                        "query_id",
+                        "kernel_id",
+                        "used_memory",
+                        "description",
+                    ],
+                    [
+                        "int64",
+                        "str",
+                        "int64",
+                        "int64",
+                        "int32",
+                        "int32",
+                        "int64",
+                        "str",
+                    ],
+                ),
                 "bsql_kernel_tasks": (
                     [
                         "time_started",
@@ -3383,6 +6021,8 @@ class BlazingContext(object):
                         "duration_execution",
                         "input_num_rows",
                         "input_num_bytes",
+                        "kernel_type",
+                        "max_memory_used",
                     ],
                     [
                         "date64",
@@ -3393,6 +6033,8 @@ class BlazingContext(object):
                         "int64",
                         "int64",
                         "int64",
+                        "str",
+                        "int64",
                     ],
                 ),
                 "bsql_cache_events": (
@@ -3483,6 +6125,7 @@ class BlazingContext(object):
                     ],
                     "ENABLE_GENERAL_ENGINE_LOGS": ["bsql_logs"],
                     "ENABLE_COMMS_LOGS": ["input_comms", "output_comms"],
+                    "ENABLE_MEMORY_TIMELINE_LOGS": ["bsql_memory_timeline"],
                 }
 
                 if log_table_name in options["ENABLE_TASK_LOGS"]:
@@ -3517,6 +6160,15 @@ class BlazingContext(object):
                     ):
                         continue
 
+                if log_table_name in options["ENABLE_MEMORY_TIMELINE_LOGS"]:
+                    if (
+                        self.config_options[
+                            "ENABLE_MEMORY_TIMELINE_LOGS".encode()
+                        ].decode()
+                        == "False"
+                    ):
+                        continue
+
                 log_files = [
                     os.path.join(log_path, log_table_name + ".*.log")
                     for log_path in self.node_log_paths
@@ -0,0 +1,84 @@
+"""
+Assignment of the files of a table to the workers that have their data, so
+that the scans read from the local disks instead of over the network, while
+every worker still gets about the same bytes to read.
+
+The locations are the bytes of every file that each host has (the replicas of
+its HDFS blocks), or the workers that can see a file, for the tables of
+local_files.
+"""
+
+import socket
+
+_resolved_hosts = {}
+
+
+def resolve_host(host):
+    """
+    Get the ip of a host name, or the name itself if it does not resolve.
+    """
+    if host not in _resolved_hosts:
+        try:
+            _resolved_hosts[host] = socket.gethostbyname(host)
+        except (socket.error, UnicodeError):
+            _resolved_hosts[host] = host
+    return _resolved_hosts[host]
+
+
+def get_slice_candidates(host_bytes, nodes):
+    """
+    Get the slices (the indices of nodes) that run on the hosts of a file,
+    with the bytes of the file that each one has.
+    """
+    slices_by_ip = {}
+    for i, node in enumerate(nodes):
+        slices_by_ip.setdefault(node.get("ip"), []).append(i)
+
+    candidates = {}
+    for host, bytes in host_bytes.items():
+        for i in slices_by_ip.get(resolve_host(host), []):
+            candidates[i] = candidates.get(i, 0) + bytes
+    return candidates
+
+
+def assign_files(sizes, candidates, num_slices, strict=False, slack=0.1):
+    """
+    Get the slice of every file. First the largest files are assigned, each
+    one to the slice that has the most of its data, among the ones that would
+    not end up with more than (1 + slack) times the average bytes. Then the
+    files that did not fit in any of them go, the largest first, to the slice
+    with the fewest bytes, or if strict (the file can only be read where it
+    is) to the one of its candidates with the fewest bytes.
+
+    Parameters
+    ----------
+    sizes : The bytes of every file.
+    candidates : For every file, a dictionary from the slices that have its
+        data to the bytes of it that they have.
+    num_slices : The number of slices.
+    """
+    loads = [0] * num_slices
+    assigned = [None] * len(sizes)
+    capacity = (1.0 + slack) * sum(sizes) / num_slices
+
+    order = sorted(range(len(sizes)), key=lambda i: sizes[i], reverse=True)
+    for i in order:
+        local = sorted(
+            candidates[i].items(), key=lambda item: (-item[1], loads[item[0]])
+        )
+        for slice_index, _ in local:
+            if loads[slice_index] + sizes[i] <= capacity:
+                assigned[i] = slice_index
+                loads[slice_index] += sizes[i]
+                break
+
+    for i in order:
+        if assigned[i] is not None:
+            continue
+        if strict and len(candidates[i]) > 0:
+            slice_index = min(candidates[i], key=lambda s: loads[s])
+        else:
+            slice_index = min(range(num_slices), key=lambda s: loads[s])
+        assigned[i] = slice_index
+        loads[slice_index] += sizes[i]
+    return assigned
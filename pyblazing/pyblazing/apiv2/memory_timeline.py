@@ -0,0 +1,234 @@
+"""
+Turns the bsql_memory_timeline.<ral_id>.log files, that the engine writes when
+ENABLE_MEMORY_TIMELINE_LOGS is on, into a timeline of the GPU memory held by
+every query and kernel, with the contributors at the peak, the spills of the
+memory monitor and the out of memory errors.
+
+    python -m pyblazing.apiv2.memory_timeline bsql_memory_timeline.0.log \\
+        --chrome-trace memory.json
+
+The Chrome trace has a counter per query with the bytes of each of its kernels,
+and can be opened in chrome://tracing or https://ui.perfetto.dev next to the
+trace of the query, since both use the timestamps of the tracer.
+"""
+
+import argparse
+import json
+import sys
+
+_FIELDS = [
+    "timestamp",
+    "event",
+    "address",
+    "bytes",
+    "query_id",
+    "kernel_id",
+    "used_memory",
+    "description",
+]
+_INTEGER_FIELDS = {
+    "timestamp",
+    "address",
+    "bytes",
+    "query_id",
+    "kernel_id",
+    "used_memory",
+}
+
+
+def read_memory_timeline(paths):
+    """
+    Reads the events of some memory timeline logs, ordered by their timestamp.
+    """
+    events = []
+    for path in paths:
+        with open(path) as log:
+            for line in log:
+                values = line.rstrip("\n").split("|", len(_FIELDS) - 1)
+                if len(values) != len(_FIELDS) or values[0] == "timestamp":
+                    continue
+                event = dict(zip(_FIELDS, values))
+                try:
+                    for field in _INTEGER_FIELDS:
+                        event[field] = int(event[field])
+                except ValueError:
+                    continue
+                events.append(event)
+    events.sort(key=lambda event: event["timestamp"])
+    return events
+
+
+def _owner_name(owner):
+    query_id, kernel_id = owner
+    if query_id < 0:
+        return "unowned"
+    if kernel_id < 0:
+        return "query %d" % query_id
+    return "query %d kernel %d" % (query_id, kernel_id)
+
+
+class MemoryTimeline:
+    """
+    Replays the events of a memory timeline. A deallocation is attributed to
+    the owner of the allocation with the same address, and the deallocations
+    of memory allocated before the recording started are left out.
+    """
+
+    def __init__(self, events):
+        self.events = events
+        self.peak_bytes = 0
+        self.peak_timestamp = None
+        self.peak_contributors = {}
+        self.owner_peaks = {}
+        self.spills = []
+        self.out_of_memory = []
+        self.samples = []  # (timestamp, query_id, {kernel_id: bytes})
+
+        allocations = {}
+        held = {}
+        total = 0
+        for event in events:
+            owner = (event["query_id"], event["kernel_id"])
+            if event["event"] == "allocate":
+                allocations[event["address"]] = (owner, event["bytes"])
+            elif event["event"] == "free":
+                allocation = allocations.pop(event["address"], None)
+                if allocation is None:
+                    continue
+                owner = allocation[0]
+            elif event["event"] == "spill":
+                self.spills.append(event)
+                continue
+            elif event["event"] == "oom":
+                self.out_of_memory.append(dict(event, held=dict(held)))
+                continue
+            else:
+                continue
+
+            delta = event["bytes"] if event["event"] == "allocate" else -event["bytes"]
+            held[owner] = held.get(owner, 0) + delta
+            total += delta
+            if held[owner] > self.owner_peaks.get(owner, 0):
+                self.owner_peaks[owner] = held[owner]
+            if total > self.peak_bytes:
+                self.peak_bytes = total
+                self.peak_timestamp = event["timestamp"]
+                self.peak_contributors = {o: b for o, b in held.items() if b > 0}
+            query_id = owner[0]
+            self.samples.append(
+                (
+                    event["timestamp"],
+                    query_id,
+                    {
+                        kernel_id: b
+                        for (q, kernel_id), b in held.items()
+                        if q == query_id
+                    },
+                )
+            )
+
+    def top_contributors(self, top=10):
+        """
+        Get the owners that held the most memory at the peak, with their bytes.
+        """
+        contributors = sorted(
+            self.peak_contributors.items(), key=lambda item: item[1], reverse=True
+        )
+        return [(_owner_name(owner), bytes) for owner, bytes in contributors[:top]]
+
+    def to_chrome_trace(self, process_id=0):
+        """
+        Get the timeline as a Chrome trace: a counter per query with the bytes
+        of every kernel, and instant events for the spills and the out of
+        memory errors.
+        """
+        trace_events = []
+        for timestamp, query_id, kernels in self.samples:
+            name = "gpu memory" if query_id < 0 else "gpu memory query %d" % query_id
+            trace_events.append(
+                {
+                    "name": name,
+                    "ph": "C",
+                    "ts": timestamp,
+                    "pid": process_id,
+                    "args": {
+                        ("kernel %d" % kernel_id if kernel_id >= 0 else "query"): b
+                        for kernel_id, b in kernels.items()
+                    },
+                }
+            )
+        for event in self.spills + self.out_of_memory:
+            trace_events.append(
+                {
+                    "name": event["event"],
+                    "ph": "i",
+                    "s": "p",
+                    "ts": event["timestamp"],
+                    "pid": process_id,
+                    "args": {
+                        "bytes": event["bytes"],
+                        "query_id": event["query_id"],
+                        "kernel_id": event["kernel_id"],
+                        "used_memory": event["used_memory"],
+                        "description": event["description"],
+                    },
+                }
+            )
+        return {"traceEvents": trace_events, "displayTimeUnit": "ms"}
+
+    def summary(self, top=10):
+        lines = [
+            "peak: %d bytes at %s" % (self.peak_bytes, self.peak_timestamp),
+            "contributors at the peak:",
+        ]
+        for name, bytes in self.top_contributors(top):
+            lines.append("    %s: %d bytes" % (name, bytes))
+        lines.append("spills: %d" % len(self.spills))
+        for spill in self.spills:
+            lines.append(
+                "    %d: %d bytes of query %d (%s)"
+                % (
+                    spill["timestamp"],
+                    spill["bytes"],
+                    spill["query_id"],
+                    spill["description"],
+                )
+            )
+        lines.append("out of memory errors: %d" % len(self.out_of_memory))
+        for oom in self.out_of_memory:
+            holders = sorted(oom["held"].items(), key=lambda item: item[1], reverse=True)
+            lines.append(
+                "    %d: %s could not allocate %d bytes, the most was held by %s"
+                % (
+                    oom["timestamp"],
+                    _owner_name((oom["query_id"], oom["kernel_id"])),
+                    oom["bytes"],
+                    ", ".join(
+                        "%s (%d bytes)" % (_owner_name(owner), b)
+                        for owner, b in holders[:3]
+                        if b > 0
+                    ),
+                )
+            )
+        return "\n".join(lines)
+
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(
+        description="Summarizes BlazingSQL memory timeline logs."
+    )
+    parser.add_argument("logs", nargs="+", help="bsql_memory_timeline.*.log files")
+    parser.add_argument("--chrome-trace", help="writes the timeline as a Chrome trace")
+    parser.add_argument("--top", type=int, default=10, help="contributors to list")
+    args = parser.parse_args(argv)
+
+    timeline = MemoryTimeline(read_memory_timeline(args.logs))
+    print(timeline.summary(args.top))
+    if args.chrome_trace:
+        with open(args.chrome_trace, "w") as trace:
+            json.dump(timeline.to_chrome_trace(), trace)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
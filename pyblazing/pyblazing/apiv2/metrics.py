@@ -0,0 +1,74 @@
+import re
+import threading
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+_SAMPLE = re.compile(r"^([a-zA-Z_:][a-zA-Z0-9_:]*)(\{(.*)\})? (.*)$")
+_CONTENT_TYPE = "application/openmetrics-text; version=1.0.0; charset=utf-8"
+
+
+def merge_openmetrics(worker_metrics):
+    """
+    Merges the OpenMetrics text of the workers, a dictionary by worker id,
+    into a single exposition where every sample has a worker label. The
+    metric families keep the order in which the engine writes them.
+    """
+    families = {}
+    for worker_id, text in worker_metrics.items():
+        family = None
+        for line in text.splitlines():
+            if line == "# EOF" or not line:
+                continue
+            if line.startswith("# TYPE ") or line.startswith("# HELP "):
+                name = line.split(" ")[2]
+                family = families.setdefault(name, {"headers": [], "samples": []})
+                if line not in family["headers"]:
+                    family["headers"].append(line)
+                continue
+            match = _SAMPLE.match(line)
+            if match is None or family is None:
+                continue
+            labels = 'worker="%s"' % worker_id
+            if match.group(3):
+                labels += "," + match.group(3)
+            family["samples"].append(
+                "%s{%s} %s" % (match.group(1), labels, match.group(4))
+            )
+
+    lines = []
+    for family in families.values():
+        lines.extend(family["headers"])
+        lines.extend(family["samples"])
+    lines.append("# EOF")
+    return "\n".join(lines) + "\n"
+
+
+def start_metrics_server(get_metrics, port, host=""):
+    """
+    Serves the OpenMetrics text that get_metrics returns on /metrics, from a
+    daemon thread, so that Prometheus can scrape it. Returns the server,
+    whose shutdown() stops it.
+    """
+
+    class MetricsHandler(BaseHTTPRequestHandler):
+        def do_GET(self):
+            if self.path.split("?")[0] != "/metrics":
+                self.send_error(404)
+                return
+            try:
+                body = get_metrics().encode("utf-8")
+            except Exception as e:
+                self.send_error(500, str(e))
+                return
+            self.send_response(200)
+            self.send_header("Content-Type", _CONTENT_TYPE)
+            self.send_header("Content-Length", str(len(body)))
+            self.end_headers()
+            self.wfile.write(body)
+
+        def log_message(self, format, *args):
+            pass
+
+    server = ThreadingHTTPServer((host, port), MetricsHandler)
+    thread = threading.Thread(target=server.serve_forever, daemon=True)
+    thread.start()
+    return server
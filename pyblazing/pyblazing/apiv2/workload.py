@@ -0,0 +1,373 @@
+"""
+Capture and replay of the workload of a BlazingContext, to reproduce on
+another cluster or build how a production workload performs.
+
+A bundle is a directory with a ``workload.json`` manifest, with the config
+options and the number of nodes of the context that captured it, and an
+``events.jsonl`` file with a line per table registration, table drop and
+query, in the order they happened. Every event has the time it started since
+the capture started, and the thread that made it, so that a replay can issue
+them with the same concurrency and timing.
+
+    python -m pyblazing.apiv2.workload replay <bundle> --scheduler <address>
+"""
+
+import argparse
+import json
+import os
+import sys
+import threading
+import time
+import traceback
+from datetime import datetime
+
+BUNDLE_VERSION = 1
+MANIFEST_FILE = "workload.json"
+EVENTS_FILE = "events.jsonl"
+
+
+class _Unrecordable(Exception):
+    pass
+
+
+def _to_json(value):
+    if isinstance(value, bytes):
+        return value.decode()
+    if value is None or isinstance(value, (bool, int, float, str)):
+        return value
+    if isinstance(value, (list, tuple)):
+        return [_to_json(v) for v in value]
+    if isinstance(value, dict):
+        return {str(_to_json(k)): _to_json(v) for k, v in value.items()}
+    raise _Unrecordable()
+
+
+def _to_json_value(value):
+    """
+    Get a value that json can write, or None if it can't be recorded (like a
+    DataFrame or a cursor).
+    """
+    try:
+        return _to_json(value)
+    except _Unrecordable:
+        return None
+
+
+def _decode_options(config_options):
+    return {
+        (k.decode() if isinstance(k, bytes) else k): (
+            v.decode() if isinstance(v, bytes) else str(v)
+        )
+        for k, v in config_options.items()
+    }
+
+
+class WorkloadRecorder(object):
+    """
+    Writes the events of a BlazingContext to a bundle, see
+    BlazingContext.start_workload_capture.
+    """
+
+    def __init__(self, bundle_dir, config_options, num_nodes):
+        os.makedirs(bundle_dir, exist_ok=True)
+        self.bundle_dir = bundle_dir
+        self.lock = threading.Lock()
+        self.start = time.monotonic()
+        self.threads = {}
+        self.num_events = 0
+        manifest = {
+            "version": BUNDLE_VERSION,
+            "captured_at": datetime.now().isoformat(),
+            "num_nodes": num_nodes,
+            "config_options": _decode_options(config_options),
+        }
+        with open(os.path.join(bundle_dir, MANIFEST_FILE), "w") as file:
+            json.dump(manifest, file, indent=2)
+        self.events = open(os.path.join(bundle_dir, EVENTS_FILE), "w")
+
+    def _thread_index(self):
+        # the threads are numbered in the order they made their first event
+        ident = threading.get_ident()
+        if ident not in self.threads:
+            self.threads[ident] = len(self.threads)
+        return self.threads[ident]
+
+    def _write(self, event):
+        with self.lock:
+            if self.events is None:
+                return
+            event["index"] = self.num_events
+            event.setdefault("thread", self._thread_index())
+            self.num_events += 1
+            self.events.write(json.dumps(event) + "\n")
+            self.events.flush()
+
+    def now(self):
+        return time.monotonic() - self.start
+
+    def record_table(self, table_name, input, kwargs, table):
+        event = {
+            "event": "create_table",
+            "time": self.now(),
+            "table_name": table_name,
+            "input": _to_json_value(input),
+            "kwargs": {k: _to_json_value(v) for k, v in kwargs.items()},
+            "file_type": str(getattr(table, "fileType", "")),
+            "column_names": _to_json_value(getattr(table, "column_names", None)),
+            "column_types": _to_json_value(getattr(table, "column_types", None)),
+        }
+        files = getattr(table, "files", None)
+        if files is not None:
+            event["files"] = _to_json_value(files)
+        if event["input"] is None:
+            # DataFrames, cursors and the like are not kept, the replay has to be given them
+            event["input_type"] = type(input).__name__
+        self._write(event)
+
+    def record_drop_table(self, table_name):
+        self._write({"event": "drop_table", "time": self.now(), "table_name": table_name})
+
+    def capture_query(self, run_query, query, optimizer, algebra, config_options, explain, **kwargs):
+        """
+        Runs a query with run_query and records it, with its algebra and how
+        long it took.
+        """
+        with self.lock:
+            thread = self._thread_index()
+        event = {
+            "event": "query",
+            "time": self.now(),
+            "thread": thread,
+            "sql": query,
+            "optimizer": optimizer,
+            "config_options": _decode_options(config_options),
+            "options": {k: _to_json_value(v) for k, v in kwargs.items()},
+        }
+        try:
+            if algebra is None and query is not None:
+                algebra = explain(query, optimizer)
+            event["algebra"] = algebra
+            result = run_query(
+                query,
+                optimizer=optimizer,
+                algebra=algebra,
+                config_options=config_options,
+                **kwargs
+            )
+            event["duration"] = self.now() - event["time"]
+            return result
+        except Exception as e:
+            event["duration"] = self.now() - event["time"]
+            event["error"] = str(e)
+            raise
+        finally:
+            self._write(event)
+
+    def close(self):
+        with self.lock:
+            if self.events is not None:
+                self.events.close()
+                self.events = None
+
+
+def read_workload(bundle_dir):
+    """
+    Reads the manifest and the events of a bundle.
+    """
+    with open(os.path.join(bundle_dir, MANIFEST_FILE)) as file:
+        manifest = json.load(file)
+    if manifest.get("version") != BUNDLE_VERSION:
+        raise ValueError(
+            "ERROR: workload bundle version "
+            + str(manifest.get("version"))
+            + " is not supported"
+        )
+    events = []
+    with open(os.path.join(bundle_dir, EVENTS_FILE)) as file:
+        for line in file:
+            if line.strip():
+                events.append(json.loads(line))
+    events.sort(key=lambda event: event["index"])
+    return manifest, events
+
+
+def _replay_event(bc, event, tables, use_algebra):
+    if event["event"] == "create_table":
+        table_name = event["table_name"]
+        if table_name in tables:
+            input = tables[table_name]
+        elif event["input"] is not None:
+            input = event["input"]
+        else:
+            raise ValueError(
+                "ERROR: table "
+                + table_name
+                + " was created from a "
+                + event.get("input_type", "")
+                + ", it has to be passed to the replay in tables"
+            )
+        kwargs = {k: v for k, v in event["kwargs"].items() if v is not None}
+        bc.create_table(table_name, input, **kwargs)
+    elif event["event"] == "drop_table":
+        bc.drop_table(event["table_name"])
+    elif event["event"] == "query":
+        options = dict(event["options"])
+        # the results are never written over the ones of the captured queries
+        options.pop("output_path", None)
+        options.pop("incremental_state_dir", None)
+        return_token = options.pop("return_token", False)
+        return_iterator = options.pop("return_iterator", False)
+        result = bc.sql(
+            event["sql"],
+            optimizer=event["optimizer"],
+            algebra=event.get("algebra") if use_algebra else None,
+            config_options=event["config_options"],
+            return_token=return_token,
+            return_iterator=return_iterator,
+        )
+        if return_token:
+            bc.fetch(result)
+        elif return_iterator:
+            for _ in result:
+                pass
+
+
+def replay_workload(bc, bundle_dir, speed=1.0, tables={}, use_algebra=True, timing=True):
+    """
+    Replays a bundle on a BlazingContext. Every thread of the capture gets a
+    thread that issues its events in order, each one when the same time has
+    passed since the replay started as it had in the capture (divided by
+    speed), so that the queries overlap the way they did. The results of the
+    queries are discarded, and the queries that wrote their results to
+    output_path return them instead.
+
+    Parameters
+    ----------
+    bundle_dir : The directory of the bundle.
+    speed (optional) : How much faster than in the capture the events are
+        issued.
+    tables (optional) : The inputs of the tables that were created from
+        DataFrames, by table name. The tables of files are created from the
+        same files, unless they are given here too.
+    use_algebra (optional) : Whether the queries run the algebra that was
+        captured, or are planned again.
+    timing (optional) : If False the events are issued as soon as the ones
+        before them in their thread finish.
+
+    Returns a list with a dictionary per event: its index, event, thread, sql,
+    the duration in the capture and in the replay, and the error, if any.
+    """
+    manifest, events = read_workload(bundle_dir)
+    threads = {}
+    for event in events:
+        threads.setdefault(event["thread"], []).append(event)
+
+    results = []
+    results_lock = threading.Lock()
+    start = time.monotonic()
+
+    def replay_thread(thread_events):
+        for event in thread_events:
+            if timing:
+                delay = start + event["time"] / speed - time.monotonic()
+                if delay > 0:
+                    time.sleep(delay)
+            result = {
+                "index": event["index"],
+                "event": event["event"],
+                "thread": event["thread"],
+                "sql": event.get("sql"),
+                "captured_duration": event.get("duration"),
+                "captured_error": event.get("error"),
+                "error": None,
+            }
+            event_start = time.monotonic()
+            try:
+                _replay_event(bc, event, tables, use_algebra)
+            except Exception as e:
+                result["error"] = str(e)
+                result["traceback"] = traceback.format_exc()
+            result["duration"] = time.monotonic() - event_start
+            with results_lock:
+                results.append(result)
+
+    replay_threads = [
+        threading.Thread(target=replay_thread, args=(thread_events,))
+        for thread_events in threads.values()
+    ]
+    for thread in replay_threads:
+        thread.start()
+    for thread in replay_threads:
+        thread.join()
+    results.sort(key=lambda result: result["index"])
+    return results
+
+
+def format_replay_report(results, threshold=1.2):
+    """
+    Get a report of a replay, with the queries that took more than threshold
+    times as long as in the capture, and the ones that failed.
+    """
+    queries = [r for r in results if r["event"] == "query"]
+    captured = sum(r["captured_duration"] or 0 for r in queries)
+    replayed = sum(r["duration"] for r in queries)
+    lines = [
+        "queries: %d, captured %.3f s, replayed %.3f s" % (len(queries), captured, replayed)
+    ]
+    for r in queries:
+        if r["error"] is not None:
+            lines.append("    #%d failed: %s" % (r["index"], r["error"]))
+        elif r["captured_duration"] and r["duration"] > threshold * r["captured_duration"]:
+            lines.append(
+                "    #%d took %.3f s instead of %.3f s: %s"
+                % (r["index"], r["duration"], r["captured_duration"], r["sql"])
+            )
+    return "\n".join(lines)
+
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(description="Replays a BlazingSQL workload bundle.")
+    subparsers = parser.add_subparsers(dest="command")
+    replay = subparsers.add_parser("replay")
+    replay.add_argument("bundle")
+    replay.add_argument("--scheduler", help="address of the dask scheduler, single GPU if not given")
+    replay.add_argument("--network-interface", default=None)
+    replay.add_argument("--speed", type=float, default=1.0)
+    replay.add_argument("--replan", action="store_true", help="plan the queries again instead of running the captured algebra")
+    replay.add_argument("--no-timing", action="store_true", help="issue the events as soon as possible")
+    replay.add_argument("--output", help="writes the results of every event as json")
+    args = parser.parse_args(argv)
+    if args.command != "replay":
+        parser.print_help()
+        return 1
+
+    from blazingsql import BlazingContext
+
+    manifest, _ = read_workload(args.bundle)
+    if args.scheduler:
+        from dask.distributed import Client
+
+        bc = BlazingContext(
+            dask_client=Client(args.scheduler),
+            network_interface=args.network_interface,
+            config_options=manifest["config_options"],
+        )
+    else:
+        bc = BlazingContext(dask_client=None, config_options=manifest["config_options"])
+
+    results = replay_workload(
+        bc,
+        args.bundle,
+        speed=args.speed,
+        use_algebra=not args.replan,
+        timing=not args.no_timing,
+    )
+    print(format_replay_report(results))
+    if args.output:
+        with open(args.output, "w") as file:
+            json.dump(results, file, indent=2)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
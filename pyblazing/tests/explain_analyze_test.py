@@ -0,0 +1,64 @@
+from pyblazing.apiv2.algebra.analyze import (
+    decode_kernel_stats,
+    merge_kernel_stats,
+    kernel_stats_tree,
+)
+
+
+def make_stats(kernel_id, name, inputs, rows, wall_time_us=1000):
+    return {
+        "kernel_id": kernel_id,
+        "kernel_name": name.encode(),
+        "input_kernel_ids": inputs,
+        "wall_time_us": wall_time_us,
+        "task_time_us": 500,
+        "input_rows": rows,
+        "input_bytes": rows * 8,
+        "output_rows": rows,
+        "output_bytes": rows * 8,
+        "output_batches": 1,
+        "spill_bytes": 0,
+        "retries": 0,
+        "shuffle_bytes": 0,
+        "finished": True,
+    }
+
+
+def test_kernel_stats_tree():
+    # a self join of a spooled scan
+    stats = decode_kernel_stats(
+        [
+            make_stats(3, "TableScan", [], 10),
+            make_stats(4, "SpoolKernel", [3], 10),
+            make_stats(5, "PartwiseJoin", [4], 20),
+            make_stats(6, "OutputKernel", [5], 20),
+        ]
+    )
+    stats[2]["input_kernel_ids"] = [4, 4]
+    tree = kernel_stats_tree(stats)
+    assert tree["kernel"] == "OutputKernel"
+    assert tree["wall_time_ms"] == 1.0
+    join = tree["children"][0]
+    assert join["kernel"] == "PartwiseJoin"
+    assert [child["kernel"] for child in join["children"]] == ["SpoolKernel"] * 2
+    assert join["children"][0]["children"][0]["kernel"] == "TableScan"
+    assert join["children"][0]["children"][0]["children"] == []
+    assert kernel_stats_tree([]) is None
+
+
+def test_merge_kernel_stats():
+    first = decode_kernel_stats(
+        [make_stats(1, "TableScan", [], 10), make_stats(2, "OutputKernel", [1], 10)]
+    )
+    second = decode_kernel_stats(
+        [
+            make_stats(7, "TableScan", [], 5, wall_time_us=3000),
+            make_stats(8, "OutputKernel", [7], 5),
+        ]
+    )
+    merged = merge_kernel_stats([first, [], second])
+    assert [kernel["kernel_id"] for kernel in merged] == [1, 2]
+    assert merged[0]["input_rows"] == 15
+    assert merged[0]["wall_time_ms"] == 3.0
+    assert merged[0]["task_time_ms"] == 1.0
+    assert kernel_stats_tree(merged)["children"][0]["output_bytes"] == 120
@@ -1,6 +1,6 @@
 import pytest
 
-from pyblazing.apiv2.algebra import get_json_plan
+from pyblazing.apiv2.algebra import get_json_plan, format_json_plan
 
 
 @pytest.mark.parametrize(
@@ -128,3 +128,33 @@ def test_get_json_plan_throw_exception_case4():
 
     except Exception:
         pass
+
+
+def test_format_json_plan():
+    # the plan that the generator writes as JSON is the same plan string
+    json_plan = (
+        "{"
+        '"expr": "LogicalJoin(condition=[=($3, $1)], joinType=[inner])", '
+        '"children": ['
+        "{"
+        '"expr": "LogicalTableScan(table=[[main, product]])", '
+        '"children": []'
+        "}, "
+        "{"
+        '"expr": "BindableTableScan(table=[[main, client]], '
+        'filters=[[<>($1, \'a \\"b\\"\')]])", '
+        '"children": []'
+        "}"
+        "]"
+        "}"
+    )
+
+    algebra = format_json_plan(json_plan)
+
+    assert algebra == (
+        "LogicalJoin(condition=[=($3, $1)], joinType=[inner])\n"
+        "  LogicalTableScan(table=[[main, product]])\n"
+        "  BindableTableScan(table=[[main, client]], "
+        "filters=[[<>($1, 'a \"b\"')]])\n"
+    )
+    assert get_json_plan(algebra) == json_plan
@@ -0,0 +1,56 @@
+from pyblazing.apiv2.algebra.prepared import (
+    split_placeholders,
+    parameter_kind,
+    to_sql_literal,
+    bind_query,
+    sentinel_query,
+    make_plan_template,
+    bind_plan,
+)
+
+
+def test_split_placeholders():
+    query = "SELECT '?', \"a?\" FROM t -- ?\nWHERE a = ? /* ? */ AND b = ?"
+    parts = split_placeholders(query)
+    assert parts == [
+        "SELECT '?', \"a?\" FROM t -- ?\nWHERE a = ",
+        " /* ? */ AND b = ",
+        "",
+    ]
+    assert split_placeholders("SELECT 'it''s?' FROM t") == ["SELECT 'it''s?' FROM t"]
+
+
+def test_bind_plan():
+    parts = split_placeholders("SELECT a FROM t WHERE a > ? AND b = ?")
+    kinds = (parameter_kind(5), parameter_kind("x"))
+    assert kinds == ("int32", "string")
+
+    query = sentinel_query(parts, kinds)
+    assert query == "SELECT a FROM t WHERE a > 2024061700 AND b = 'blazing_parameter_1'"
+
+    algebra = (
+        "BindableTableScan(table=[[main, t]], "
+        "filters=[[AND(>($0, 2024061700), =($1, 'blazing_parameter_1'))]], "
+        "projects=[[0, 1]], aliases=[[a, b]])"
+    )
+    template = make_plan_template(algebra, kinds)
+    literals = [to_sql_literal(-3), to_sql_literal("y")]
+    assert bind_plan(template, literals) == (
+        "BindableTableScan(table=[[main, t]], "
+        "filters=[[AND(>($0, -3), =($1, 'y'))]], "
+        "projects=[[0, 1]], aliases=[[a, b]])"
+    )
+    assert bind_query(parts, literals) == "SELECT a FROM t WHERE a > -3 AND b = 'y'"
+
+
+def test_uncacheable_plan():
+    kinds = ("int32", "int32")
+    # the optimizer folded the second parameter away
+    assert make_plan_template("LogicalFilter(condition=[>($0, 2024061700)])", kinds) is None
+    # the optimizer gave the literal a type
+    assert make_plan_template(
+        "LogicalFilter(condition=[AND(>($0, 2024061700:BIGINT), <($0, 2024061701))])",
+        kinds,
+    ) is None
+    assert parameter_kind(True) is None
+    assert parameter_kind(1.5) is None
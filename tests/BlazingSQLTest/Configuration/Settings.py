@@ -77,6 +77,23 @@ def create_json():
         "BLAZINGSQL_E2E_TARGET_TEST_GROUPS", ""
     )  # comma separated values, if empty will run all the e2e tests
 
+    # BenchmarkSettings
+    benchmarkDataDirectory = os.getenv(
+        "BLAZINGSQL_E2E_BENCHMARK_DATA_DIRECTORY", dataDirectory + "benchmarks/"
+    )
+    benchmarks = os.getenv("BLAZINGSQL_E2E_BENCHMARKS", "tpch")
+    benchmarkScaleFactors = os.getenv("BLAZINGSQL_E2E_BENCHMARK_SCALE_FACTORS", "1")
+    benchmarkFileFormat = os.getenv("BLAZINGSQL_E2E_BENCHMARK_FILE_FORMAT", "parquet")
+    benchmarkQueryIds = os.getenv("BLAZINGSQL_E2E_BENCHMARK_QUERY_IDS", "")
+    benchmarkRepetitions = os.getenv("BLAZINGSQL_E2E_BENCHMARK_REPETITIONS", 3)
+    benchmarkResultsDirectory = os.getenv(
+        "BLAZINGSQL_E2E_BENCHMARK_RESULTS_DIRECTORY", logDirectory
+    )
+    benchmarkBaselineDirectory = os.getenv(
+        "BLAZINGSQL_E2E_BENCHMARK_BASELINE_DIRECTORY", ""
+    )
+    benchmarkThreshold = os.getenv("BLAZINGSQL_E2E_BENCHMARK_THRESHOLD", 0.1)
+
     # trim all white spaces
     targetTestGroups = "".join(targetTestGroups.split())
     targetTestGroups = targetTestGroups.split(",")
@@ -122,6 +139,20 @@ def create_json():
         "targetTestGroups": targetTestGroups,
     }
 
+    data["BenchmarkSettings"] = {
+        "dataDirectory": benchmarkDataDirectory,
+        "benchmarks": [b for b in "".join(benchmarks.split()).split(",") if b],
+        "scaleFactors": [
+            sf for sf in "".join(benchmarkScaleFactors.split()).split(",") if sf
+        ],
+        "fileFormat": benchmarkFileFormat,
+        "queryIds": [q for q in "".join(benchmarkQueryIds.split()).split(",") if q],
+        "repetitions": int(benchmarkRepetitions),
+        "resultsDirectory": benchmarkResultsDirectory,
+        "baselineDirectory": benchmarkBaselineDirectory,
+        "threshold": float(benchmarkThreshold),
+    }
+
     data["ComparissonTest"] = {
         "compareByPercentaje": compareByPercentaje,
         "acceptableDifference": acceptableDifference,
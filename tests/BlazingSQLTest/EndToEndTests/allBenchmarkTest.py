@@ -0,0 +1,70 @@
+import os
+import sys
+
+from Configuration import Settings as Settings
+from Runner import benchmark
+from Utils import Execution, init_context
+
+
+def get_results_file_name(directory, results):
+    return os.path.join(
+        directory,
+        "benchmark_%s_sf%s_%s_%sRals.json"
+        % (
+            results["benchmark"],
+            results["scale_factor"],
+            results["file_format"],
+            results["nRals"],
+        ),
+    )
+
+
+def main():
+    print("**init benchmark**")
+    Execution.getArgs()
+
+    benchmarkSettings = Settings.data["BenchmarkSettings"]
+    fileSchemaType = benchmark.fileSchemaTypes[benchmarkSettings["fileFormat"]]
+
+    # without the engine logs, which would slow the queries down
+    bc, dask_client = init_context(config_options={})
+
+    total_regressions = 0
+    for benchmark_name in benchmarkSettings["benchmarks"]:
+        for scale_factor in benchmarkSettings["scaleFactors"]:
+            print("==============================")
+            print("%s SF%s" % (benchmark_name.upper(), scale_factor))
+            print("==============================")
+            results = benchmark.run_benchmark(
+                bc, dask_client, benchmark_name, scale_factor, fileSchemaType
+            )
+            results_file = get_results_file_name(
+                benchmarkSettings["resultsDirectory"], results
+            )
+            benchmark.save_results(results, results_file)
+            print("Results saved in " + results_file)
+
+            if benchmarkSettings["baselineDirectory"]:
+                baseline_file = get_results_file_name(
+                    benchmarkSettings["baselineDirectory"], results
+                )
+                if not os.path.exists(baseline_file):
+                    print("There is no baseline " + baseline_file)
+                    continue
+                comparisons, regressions = benchmark.compare_results(
+                    results,
+                    benchmark.load_results(baseline_file),
+                    benchmarkSettings["threshold"],
+                )
+                benchmark.print_comparison(comparisons, regressions)
+                total_regressions += regressions
+
+    if dask_client is not None:
+        dask_client.close()
+
+    # the regressions fail the run, to gate the releases on them
+    return 1 if total_regressions > 0 else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
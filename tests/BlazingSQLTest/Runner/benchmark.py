@@ -0,0 +1,282 @@
+import glob
+import json
+import os
+import statistics
+import sys
+import time
+from datetime import datetime
+
+from blazingsql import DataType
+
+from Configuration import Settings as Settings
+from DataBase.createSchema import get_extension
+from Runner import runTest
+
+tpcdsTables = [
+    "call_center",
+    "catalog_page",
+    "catalog_returns",
+    "catalog_sales",
+    "customer",
+    "customer_address",
+    "customer_demographics",
+    "date_dim",
+    "household_demographics",
+    "income_band",
+    "inventory",
+    "item",
+    "promotion",
+    "reason",
+    "ship_mode",
+    "store",
+    "store_returns",
+    "store_sales",
+    "time_dim",
+    "warehouse",
+    "web_page",
+    "web_returns",
+    "web_sales",
+    "web_site",
+]
+
+tpchTables = [
+    "nation",
+    "region",
+    "customer",
+    "lineitem",
+    "orders",
+    "supplier",
+    "part",
+    "partsupp",
+]
+
+fileSchemaTypes = {
+    "parquet": DataType.PARQUET,
+    "orc": DataType.ORC,
+    "csv": DataType.CSV,
+}
+
+
+def get_data_directory(benchmark, scale_factor):
+    data_directory = Settings.data["BenchmarkSettings"]["dataDirectory"]
+    return os.path.join(data_directory, benchmark, "sf" + str(scale_factor))
+
+
+def create_benchmark_tables(bc, benchmark, scale_factor, fileSchemaType):
+    """
+    Creates the tables of a benchmark from the files of its scale factor,
+    named like <table>_<n>.<extension> in
+    <dataDirectory>/<benchmark>/sf<scale factor>/
+    """
+    ext = get_extension(fileSchemaType)
+    data_directory = get_data_directory(benchmark, scale_factor)
+    tables = tpchTables if benchmark == "tpch" else tpcdsTables
+    for table in tables:
+        table_files = "%s/%s_[0-9]*.%s" % (data_directory, table, ext)
+        if not glob.glob(table_files):
+            raise RuntimeError("There are no files for the table " + table_files)
+        if fileSchemaType == DataType.CSV:
+            bc.create_table(table, table_files, delimiter="|")
+        else:
+            bc.create_table(table, table_files)
+
+
+def get_benchmark_queries(benchmark):
+    """
+    Returns the queries of a benchmark by query id. The TPC-H queries are the
+    ones of the end to end tests, the TPC-DS ones are read from the .sql files
+    of the <dataDirectory>/tpcds/queries/ folder, as dsqgen makes them
+    """
+    if benchmark == "tpch":
+        from EndToEndTests import tpchQueries as tpch
+
+        return {
+            queryId: tpch.get_tpch_query(queryId)
+            for queryId in sorted(tpch.query_templates)
+        }
+
+    queries_directory = os.path.join(
+        Settings.data["BenchmarkSettings"]["dataDirectory"], benchmark, "queries"
+    )
+    queries = {}
+    for query_file in sorted(glob.glob(queries_directory + "/*.sql")):
+        with open(query_file) as file:
+            # dsqgen ends every query with a ;
+            query = file.read().strip().rstrip(";")
+        queries[os.path.splitext(os.path.basename(query_file))[0]] = query
+    return queries
+
+
+def sum_kernel_stats(tree, counter):
+    return tree.get(counter, 0) + sum(
+        sum_kernel_stats(child, counter) for child in tree.get("children", [])
+    )
+
+
+def run_query_benchmark(bc, query, queryId, repetitions):
+    """
+    Runs a query the given times, after a first run that is not measured, and
+    returns its wall time in milliseconds of every run and the median, with
+    the peak GPU memory of the workers and the bytes that its kernels spilled
+    and sent to the other nodes, which are the same in every run
+    """
+    result = {"query_id": queryId, "error": ""}
+    try:
+        bc.sql(query)
+
+        wall_times_ms = []
+        peak_gpu_memory = 0
+        for _ in range(repetitions):
+            bc.reset_max_memory_used()
+            start = time.time()
+            tree = bc.explain_analyze(query)
+            wall_times_ms.append((time.time() - start) * 1000)
+            peak_gpu_memory = max(
+                peak_gpu_memory, max(bc.get_max_memory_used().values())
+            )
+
+        result["wall_times_ms"] = wall_times_ms
+        result["wall_time_ms"] = statistics.median(wall_times_ms)
+        result["peak_gpu_memory_bytes"] = peak_gpu_memory
+        result["spill_bytes"] = sum_kernel_stats(tree, "spill_bytes")
+        result["shuffle_bytes"] = sum_kernel_stats(tree, "shuffle_bytes")
+    except Exception as e:
+        result["error"] = str(e)
+    print(
+        "%s: %s"
+        % (
+            queryId,
+            result["error"] or "%.1f ms" % result["wall_time_ms"],
+        )
+    )
+    return result
+
+
+def run_benchmark(bc, dask_client, benchmark, scale_factor, fileSchemaType):
+    benchmarkSettings = Settings.data["BenchmarkSettings"]
+    create_benchmark_tables(bc, benchmark, scale_factor, fileSchemaType)
+
+    query_ids = benchmarkSettings["queryIds"]
+    queries = get_benchmark_queries(benchmark)
+    results = [
+        run_query_benchmark(
+            bc, query, queryId, benchmarkSettings["repetitions"]
+        )
+        for queryId, query in queries.items()
+        if not query_ids or queryId in query_ids
+    ]
+
+    return {
+        "benchmark": benchmark,
+        "scale_factor": scale_factor,
+        "file_format": get_extension(fileSchemaType),
+        "nRals": Settings.data["RunSettings"]["nRals"],
+        "nGPUs": Settings.data["RunSettings"]["nGPUs"],
+        "multi_node": dask_client is not None,
+        "branch": runTest.get_Branch(),
+        "commit": runTest.get_CommitHash(),
+        "date": datetime.now().isoformat(),
+        "queries": results,
+    }
+
+
+def save_results(results, results_file):
+    with open(results_file, "w") as file:
+        json.dump(results, file, indent=2)
+
+
+def load_results(results_file):
+    with open(results_file) as file:
+        return json.load(file)
+
+
+def compare_results(results, baseline, threshold, min_time_ms=100):
+    """
+    Compares the results of a benchmark with the ones of a baseline of the same
+    benchmark and scale factor. A query regresses when its wall time, or its
+    peak GPU memory, spill bytes or shuffle bytes grow by more than threshold
+    (i.e. 0.1 for a 10%), or when it fails and it did not in the baseline. The
+    wall times shorter than min_time_ms are too noisy to be compared.
+
+    Returns the comparison of every query and how many of them regressed
+    """
+    baseline_queries = {
+        query["query_id"]: query for query in baseline.get("queries", [])
+    }
+    comparisons = []
+    regressions = 0
+    for query in results["queries"]:
+        base = baseline_queries.get(query["query_id"])
+        comparison = {"query_id": query["query_id"], "regressions": []}
+        if base is None:
+            comparison["status"] = "New"
+        elif query["error"]:
+            comparison["status"] = "Fail"
+            if not base["error"]:
+                comparison["regressions"].append("error")
+        elif base["error"]:
+            comparison["status"] = "Fixed"
+        else:
+            for counter in [
+                "wall_time_ms",
+                "peak_gpu_memory_bytes",
+                "spill_bytes",
+                "shuffle_bytes",
+            ]:
+                value = query[counter]
+                base_value = base[counter]
+                comparison[counter] = value
+                comparison["baseline_" + counter] = base_value
+                if counter == "wall_time_ms" and max(value, base_value) < min_time_ms:
+                    continue
+                if value > base_value * (1 + threshold):
+                    comparison["regressions"].append(counter)
+            comparison["status"] = (
+                "Regression" if comparison["regressions"] else "Success"
+            )
+        if comparison["regressions"]:
+            regressions += 1
+        comparisons.append(comparison)
+    return comparisons, regressions
+
+
+def print_comparison(comparisons, regressions):
+    print("==============================")
+    print("Benchmark comparison")
+    print("==============================")
+    for comparison in comparisons:
+        line = "%s: %s" % (comparison["query_id"], comparison["status"])
+        if "wall_time_ms" in comparison:
+            base = comparison["baseline_wall_time_ms"]
+            change = (comparison["wall_time_ms"] - base) / base * 100 if base else 0
+            line += "   %.1f ms (baseline %.1f ms, %+.1f%%)" % (
+                comparison["wall_time_ms"],
+                base,
+                change,
+            )
+        if comparison["regressions"]:
+            line += "   regressed: " + ", ".join(comparison["regressions"])
+        print(line)
+    print("%d queries regressed" % regressions)
+
+
+def main(argv):
+    """
+    Compares two results files of the benchmark runner, and exits with 1 when
+    any query regressed:
+
+    python -m Runner.benchmark results.json baseline.json [threshold]
+    """
+    if len(argv) < 3:
+        print(main.__doc__)
+        return 2
+    threshold = float(argv[3]) if len(argv) > 3 else 0.1
+    comparisons, regressions = compare_results(
+        load_results(argv[1]), load_results(argv[2]), threshold
+    )
+    print_comparison(comparisons, regressions)
+    return 1 if regressions > 0 else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))